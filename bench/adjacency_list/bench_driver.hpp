@@ -7,6 +7,7 @@
 #define METALL_BENCH_ADJACENCY_LIST_BENCH_DRIVER_HPP
 
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -14,7 +15,8 @@
 #include <boost/algorithm/string.hpp>
 #include <metall/detail/utilities.hpp>
 #include <metall/utility/open_mp.hpp>
-#include "edge_generator/rmat_edge_generator.hpp"
+#include "edge_generator/parallel_rmat_edge_generator.hpp"
+#include "../utility/binary_edge_list.hpp"
 #include "../utility/pair_reader.hpp"
 #include "kernel.hpp"
 
@@ -186,56 +188,134 @@ inline auto parse_options(int argc, char **argv, bench_options *option) {
 // ---------------------------------------- //
 // Benchmark drivers
 // ---------------------------------------- //
+template <typename input_storage_type>
+inline void save_input_edges(const input_storage_type &input_storage,
+                             std::ofstream *const ofs_save_edge) {
+  if (!ofs_save_edge || !ofs_save_edge->is_open()) return;
+  for (const auto &list : input_storage) {
+    for (const auto &elem : list) {
+      *ofs_save_edge << elem.first << "\t" << elem.second << "\n";
+    }
+  }
+}
+
+/// \brief Run benchmark reading binary edge-list files.
+/// The files are mapped and each thread inserts its span of the edges
+/// without copying them.
 template <typename adjacency_list_type>
-inline auto run_bench_kv_file(
+inline auto run_bench_binary_edge_file(
     const std::vector<std::string> &input_file_name_list,
     const std::size_t chunk_size, const std::function<void()> &preprocess,
     const std::function<void()> &postprocess, adjacency_list_type *adj_list,
-    std::ofstream *const ofs_save_edge, const bool verbose = false) {
-  using reader_type =
-      bench_utility::pair_reader<typename adjacency_list_type::key_type,
-                                 typename adjacency_list_type::value_type>;
-  reader_type reader(input_file_name_list.begin(), input_file_name_list.end());
-
-  auto input_storage = allocate_key_value_input_storage<adjacency_list_type>();
+    std::ofstream *const ofs_save_edge, const bool verbose) {
+  namespace bel = bench_utility::binary_edge_list;
+  std::vector<bel::edge_span> input_storage(
+      allocate_key_value_input_storage<adjacency_list_type>().size());
 
   std::size_t count_loop = 0;
   double total_elapsed_time = 0;
-  for (auto itr = reader.begin(), end = reader.end(); itr != end;) {
-    if (verbose) std::cout << "\n[ " << count_loop << " ]" << std::endl;
-
-    for (auto &input_list : input_storage) input_list.clear();
-
-    std::size_t count_read = 0;
-    while (itr != end && count_read < chunk_size) {
-      input_storage[count_read % omp::get_num_threads()].emplace_back(*itr);
-      ++itr;
-      ++count_read;
+  for (const auto &file_name : input_file_name_list) {
+    bel::mapped_reader reader;
+    if (!reader.open(file_name)) std::abort();
+    for (std::size_t first = 0; first < reader.num_edges();
+         first += chunk_size) {
+      if (verbose) std::cout << "\n[ " << count_loop << " ]" << std::endl;
+      for (std::size_t i = 0; i < input_storage.size(); ++i) {
+        input_storage[i] =
+            reader.span(first, first + chunk_size, i, input_storage.size());
+      }
+      total_elapsed_time += ingest_key_values(input_storage, preprocess,
+                                              postprocess, adj_list, verbose);
+      save_input_edges(input_storage, ofs_save_edge);
+      ++count_loop;
     }
+  }
+  ofs_save_edge->close();
 
-    if (count_read == 0) break;
+  return total_elapsed_time;
+}
 
-    total_elapsed_time += ingest_key_values(input_storage, preprocess,
-                                            postprocess, adj_list, verbose);
+/// \brief Run benchmark reading text key-value files.
+/// The files are mapped and parsed by the threads in parallel, about
+/// 'chunk_size' lines at a time.
+template <typename adjacency_list_type>
+inline auto run_bench_text_kv_file(
+    const std::vector<std::string> &input_file_name_list,
+    const std::size_t chunk_size, const std::function<void()> &preprocess,
+    const std::function<void()> &postprocess, adjacency_list_type *adj_list,
+    std::ofstream *const ofs_save_edge, const bool verbose) {
+  using parser_type = bench_utility::parallel_pair_parser<
+      typename adjacency_list_type::key_type,
+      typename adjacency_list_type::value_type>;
+  auto input_storage = allocate_key_value_input_storage<adjacency_list_type>();
 
-    if (ofs_save_edge) {
-      for (const auto &list : input_storage) {
-        for (const auto &elem : list) {
-          *ofs_save_edge << elem.first << "\t" << elem.second << "\n";
-        }
+  // The chunk size in bytes is estimated from the lines parsed so far
+  constexpr double k_initial_bytes_per_line = 16;
+  double bytes_per_line = k_initial_bytes_per_line;
+  std::size_t count_loop = 0;
+  double total_elapsed_time = 0;
+  for (const auto &file_name : input_file_name_list) {
+    const parser_type parser(file_name);
+    std::size_t first = 0;
+    while (first < parser.size()) {
+      if (verbose) std::cout << "\n[ " << count_loop << " ]" << std::endl;
+      const std::size_t last = std::max(
+          parser.line_boundary(first + std::size_t(chunk_size *
+                                                   bytes_per_line)),
+          first + 1);
+
+      for (auto &input_list : input_storage) input_list.clear();
+      parser.parse(first, last, [&input_storage](const int thread_no,
+                                                 const auto &key,
+                                                 const auto &value) {
+        input_storage[thread_no].emplace_back(key, value);
+      });
+
+      std::size_t count_read = 0;
+      for (const auto &input_list : input_storage) {
+        count_read += input_list.size();
       }
+      if (count_read > 0) {
+        bytes_per_line = double(last - first) / count_read;
+        total_elapsed_time += ingest_key_values(
+            input_storage, preprocess, postprocess, adj_list, verbose);
+        save_input_edges(input_storage, ofs_save_edge);
+        ++count_loop;
+      }
+      first = last;
     }
-
-    ++count_loop;
   }
   ofs_save_edge->close();
 
   return total_elapsed_time;
 }
 
+/// \brief Run benchmark reading key-value files.
+/// The files are read as binary edge lists (binary_edge_list.hpp) if all of
+/// them are; otherwise, as text files.
+template <typename adjacency_list_type>
+inline auto run_bench_kv_file(
+    const std::vector<std::string> &input_file_name_list,
+    const std::size_t chunk_size, const std::function<void()> &preprocess,
+    const std::function<void()> &postprocess, adjacency_list_type *adj_list,
+    std::ofstream *const ofs_save_edge, const bool verbose = false) {
+  const bool binary =
+      std::all_of(input_file_name_list.begin(), input_file_name_list.end(),
+                  bench_utility::binary_edge_list::is_binary_edge_list);
+  if (binary) {
+    std::cout << "Read binary edge lists" << std::endl;
+    return run_bench_binary_edge_file(input_file_name_list, chunk_size,
+                                      preprocess, postprocess, adj_list,
+                                      ofs_save_edge, verbose);
+  }
+  return run_bench_text_kv_file(input_file_name_list, chunk_size, preprocess,
+                                postprocess, adj_list, ofs_save_edge, verbose);
+}
+
 /// \brief Run benchmark generating an rmat graph
-/// If directed_graph is false, the total number of edges to be generated is
-/// num_edges x 2
+/// The edges are generated by the OpenMP threads directly into the input
+/// storage, chunk by chunk. If undirected is true, the reverse of each edge
+/// is also inserted, i.e., the total number of edges is edge_count x 2.
 template <typename adjacency_list_type>
 inline auto run_bench_rmat_edge(const bench_options::rmat_option &rmat_option,
                                 const std::size_t chunk_size,
@@ -244,58 +324,33 @@ inline auto run_bench_rmat_edge(const bench_options::rmat_option &rmat_option,
                                 adjacency_list_type *adj_list,
                                 std::ofstream *const ofs_save_edge,
                                 const bool verbose = false) {
-  // -- Initialize rmat edge generators -- //
-  using rmat_generator = edge_generator::rmat_edge_generator;
-  std::vector<std::unique_ptr<rmat_generator>> generator_list;
-  std::vector<typename rmat_generator::iterator> generator_itr_list;
-  OMP_DIRECTIVE(parallel) {
-    OMP_DIRECTIVE(single)
-    for (int i = 0; i < omp::get_num_threads(); ++i) {
-      // Note: each generator generates roughly rmat_option.edge_count /
-      // num_threads
-      generator_list.push_back(std::make_unique<rmat_generator>(
-          rmat_option.seed + i, rmat_option.vertex_scale,
-          rmat_option.edge_count, rmat_option.a, rmat_option.b, rmat_option.c,
-          rmat_option.scramble_id, false));
-      generator_itr_list.push_back(generator_list.at(i)->begin());
-    }
-  }
+  const edge_generator::parallel_rmat_edge_generator generator(
+      rmat_option.seed, rmat_option.vertex_scale, rmat_option.edge_count,
+      rmat_option.a, rmat_option.b, rmat_option.c, rmat_option.scramble_id,
+      rmat_option.undirected);
+  // The number of edges to generate per chunk, not including the reverse
+  const std::size_t num_generate_per_chunk =
+      std::max<std::size_t>(chunk_size / (rmat_option.undirected ? 2 : 1), 1);
 
   auto input_storage = allocate_key_value_input_storage<adjacency_list_type>();
-  const std::size_t total_edges =
-      rmat_option.edge_count * (rmat_option.undirected ? 2 : 1);
   std::size_t count_loop = 0;
   double total_elapsed_time = 0;
-  while (true) {
-    const ssize_t num_generate = std::min(
-        (ssize_t)chunk_size, (ssize_t)(total_edges - count_loop * chunk_size));
-    if (num_generate <= 0) break;
+  for (std::size_t first = 0; first < generator.num_edges();
+       first += num_generate_per_chunk) {
     if (verbose) std::cout << "\n[ " << count_loop << " ]" << std::endl;
 
     // -- Generate rmat edges -- //
-    OMP_DIRECTIVE(parallel) {
-      assert((int)input_storage.size() == (int)omp::get_num_threads());
-      auto &local_list = input_storage.at(omp::get_thread_num());
-      local_list.clear();
-      const auto range = metall::mtlldetail::partial_range(
-          num_generate, omp::get_thread_num(), omp::get_num_threads());
-      auto &itr = generator_itr_list.at(omp::get_thread_num());
-      for (std::size_t i = range.first; i < range.second; ++i) {
-        local_list.emplace_back(*itr);
-        ++itr;
-      }
-    }
+    for (auto &local_list : input_storage) local_list.clear();
+    generator.generate_parallel(
+        first, first + num_generate_per_chunk,
+        [&input_storage](const int thread_no, const uint64_t source,
+                         const uint64_t destination) {
+          input_storage[thread_no].emplace_back(source, destination);
+        });
 
     total_elapsed_time += ingest_key_values(input_storage, preprocess,
                                             postprocess, adj_list, verbose);
-
-    if (ofs_save_edge) {
-      for (const auto &list : input_storage) {
-        for (const auto &elem : list) {
-          *ofs_save_edge << elem.first << "\t" << elem.second << "\n";
-        }
-      }
-    }
+    save_input_edges(input_storage, ofs_save_edge);
 
     ++count_loop;
   }
@@ -3,13 +3,19 @@
 //
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
+/// \brief Generates an R-MAT edge list into one file per thread
+/// (<file name>-<thread number>), in text ('source destination' per line) or
+/// in the binary edge-list format (bench/utility/binary_edge_list.hpp, -B).
+/// The generated edges do not depend on the number of threads.
+
 #include <iostream>
 #include <fstream>
 #include <string>
 
 #include <metall/utility/open_mp.hpp>
 #include <metall/detail/utilities.hpp>
-#include "rmat_edge_generator.hpp"
+#include "parallel_rmat_edge_generator.hpp"
+#include "../../utility/binary_edge_list.hpp"
 
 // ---------------------------------------- //
 // Option
@@ -23,12 +29,13 @@ struct rmat_option_t {
   double c{0.19};
   bool scramble_id{false};
   bool undirected{false};
+  bool binary{false};
 };
 
 bool parse_options(int argc, char **argv, rmat_option_t *option,
                    std::string *edge_list_file_name, int *num_threads) {
   int p;
-  while ((p = getopt(argc, argv, "o:s:v:e:a:b:c:r:u:t:")) != -1) {
+  while ((p = getopt(argc, argv, "o:s:v:e:a:b:c:r:u:t:B")) != -1) {
     switch (p) {
       case 'o':
         *edge_list_file_name = optarg;
@@ -70,6 +77,10 @@ bool parse_options(int argc, char **argv, rmat_option_t *option,
         *num_threads = static_cast<int>(std::stoull(optarg));
         break;
 
+      case 'B':
+        option->binary = true;
+        break;
+
       default:
         std::cerr << "Invalid option" << std::endl;
         return false;
@@ -82,6 +93,7 @@ bool parse_options(int argc, char **argv, rmat_option_t *option,
             << "\nb: " << option->b << "\nc: " << option->c
             << "\nscramble_id: " << static_cast<int>(option->scramble_id)
             << "\nundirected: " << static_cast<int>(option->undirected)
+            << "\nbinary: " << static_cast<int>(option->binary)
             << "\nedge_list_file_name: " << *edge_list_file_name
             << "\nnum_threads: " << *num_threads << std::endl;
 
@@ -96,29 +108,43 @@ int main(int argc, char **argv) {
 
   metall::utility::omp::set_num_threads(num_threads);
 
+  const edge_generator::parallel_rmat_edge_generator rmat(
+      rmat_option.seed, rmat_option.vertex_scale, rmat_option.edge_count,
+      rmat_option.a, rmat_option.b, rmat_option.c, rmat_option.scramble_id,
+      rmat_option.undirected);
+
+  // Each thread writes the edges of its blocks into its own file
+  const std::size_t num_blocks =
+      (rmat.num_edges() + rmat.k_block_size - 1) / rmat.k_block_size;
   OMP_DIRECTIVE(parallel) {
+    const int thread_no = metall::utility::omp::get_thread_num();
     const auto range = metall::mtlldetail::partial_range(
-        rmat_option.edge_count, metall::utility::omp::get_thread_num(),
-        metall::utility::omp::get_num_threads());
-    const std::size_t num_edges = range.second - range.first;
-    edge_generator::rmat_edge_generator rmat(
-        rmat_option.seed + metall::utility::omp::get_thread_num(),
-        rmat_option.vertex_scale, num_edges, rmat_option.a, rmat_option.b,
-        rmat_option.c, rmat_option.scramble_id, rmat_option.undirected);
-
-    std::ofstream edge_list_file(
-        edge_list_file_name + "-" +
-        std::to_string(metall::utility::omp::get_thread_num()));
-    if (!edge_list_file.is_open()) {
-      std::cerr << "Cannot open " << edge_list_file_name << std::endl;
-      std::abort();
-    }
-
-    for (auto edge : rmat) {
-      // std::cout << edge.first << " " << edge.second << "\n"; // DB
-      edge_list_file << edge.first << " " << edge.second << "\n";
+        num_blocks, thread_no, metall::utility::omp::get_num_threads());
+    const std::string file_name =
+        edge_list_file_name + "-" + std::to_string(thread_no);
+
+    if (rmat_option.binary) {
+      bench_utility::binary_edge_list::writer writer(file_name);
+      if (!writer.is_open()) std::abort();
+      rmat.generate(range.first * rmat.k_block_size,
+                    range.second * rmat.k_block_size,
+                    [&writer](const uint64_t s, const uint64_t d) {
+                      writer.write(s, d);
+                    });
+      if (!writer.close()) std::abort();
+    } else {
+      std::ofstream edge_list_file(file_name);
+      if (!edge_list_file.is_open()) {
+        std::cerr << "Cannot open " << file_name << std::endl;
+        std::abort();
+      }
+      rmat.generate(range.first * rmat.k_block_size,
+                    range.second * rmat.k_block_size,
+                    [&edge_list_file](const uint64_t s, const uint64_t d) {
+                      edge_list_file << s << " " << d << "\n";
+                    });
+      edge_list_file.close();
     }
-    edge_list_file.close();
   }
   std::cout << "Generation done" << std::endl;
 
@@ -0,0 +1,148 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_ADJACENCY_LIST_PARALLEL_RMAT_EDGE_GENERATOR_HPP
+#define METALL_BENCH_ADJACENCY_LIST_PARALLEL_RMAT_EDGE_GENERATOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+#include <boost/graph/rmat_graph_generator.hpp>
+#include <metall/detail/utilities.hpp>
+#include <metall/utility/hash.hpp>
+#include <metall/utility/open_mp.hpp>
+#include <metall/utility/random.hpp>
+
+namespace edge_generator {
+
+/// \brief Splittable R-MAT edge generator.
+/// The edges are generated in blocks of k_block_size edges. Each block has
+/// its own rand_1024 stream seeded from the seed and the block number, so
+/// any range of edges can be generated independently and the generated edges
+/// do not depend on the number of threads.
+class parallel_rmat_edge_generator {
+ public:
+  using edge_type = std::pair<uint64_t, uint64_t>;
+  static constexpr std::size_t k_block_size = 1ULL << 16ULL;
+
+  /// \brief Constructor.
+  /// \param num_edges The number of edges to generate, not including the
+  /// reverse edges of an undirected graph.
+  /// \param undirected If true, also generates the reverse of each edge.
+  parallel_rmat_edge_generator(const uint64_t seed,
+                               const uint64_t vertex_scale,
+                               const uint64_t num_edges, const double a,
+                               const double b, const double c,
+                               const bool scramble_id, const bool undirected)
+      : m_seed(seed),
+        m_vertex_scale(vertex_scale),
+        m_num_edges(num_edges),
+        m_a(a),
+        m_b(b),
+        m_c(c),
+        m_d(1.0 - (m_a + m_b + m_c)),
+        m_scramble_id(scramble_id),
+        m_undirected(undirected) {
+    if ((m_a <= m_b || m_a <= m_c || m_a <= m_d) ||
+        (m_a + m_b + m_c + m_d != 1.0)) {
+      std::cerr << "Unexpected parameter(s)" << std::endl;
+      std::abort();
+    }
+  }
+
+  /// \brief Returns the number of edges to generate, not including the
+  /// reverse edges.
+  std::size_t num_edges() const { return m_num_edges; }
+
+  /// \brief Returns the number of edges given to the callbacks, including
+  /// the reverse edges.
+  std::size_t num_output_edges() const {
+    return m_num_edges * (m_undirected ? 2 : 1);
+  }
+
+  bool undirected() const { return m_undirected; }
+
+  /// \brief Generates the edges [first, last) and calls 'func(source,
+  /// destination)' for each of them, and for its reverse if undirected.
+  template <typename function_type>
+  void generate(const std::size_t first, std::size_t last,
+                function_type &&func) const {
+    last = std::min<std::size_t>(last, m_num_edges);
+    const uint64_t num_vertices = 1ULL << m_vertex_scale;
+    const uint64_t mask = num_vertices - 1;
+    for (std::size_t block_begin = first - first % k_block_size;
+         block_begin < last; block_begin += k_block_size) {
+      const boost::shared_ptr<boost::uniform_01<rnd_type>> rnd(
+          new boost::uniform_01<rnd_type>(
+              rnd_type(priv_block_seed(block_begin / k_block_size))));
+      const std::size_t end = std::min(block_begin + k_block_size, last);
+      for (std::size_t i = block_begin; i < end; ++i) {
+        auto edge =
+            generate_edge(rnd, num_vertices, (unsigned int)m_vertex_scale,
+                          m_a, m_b, m_c, m_d);
+        if (i < first) continue;  // Skips to the first edge in the block
+        if (m_scramble_id) {
+          edge.first = metall::utility::hash<>()(edge.first) & mask;
+          edge.second = metall::utility::hash<>()(edge.second) & mask;
+        }
+        func(edge.first, edge.second);
+        if (m_undirected) func(edge.second, edge.first);
+      }
+    }
+  }
+
+  /// \brief Generates the edges [first, last) using the OpenMP threads and
+  /// calls 'func(thread_no, source, destination)' for each of them, and for
+  /// its reverse if undirected. The range is split at block boundaries.
+  template <typename function_type>
+  void generate_parallel(const std::size_t first, std::size_t last,
+                         function_type &&func) const {
+    last = std::min<std::size_t>(last, m_num_edges);
+    if (first >= last) return;
+    const std::size_t first_block = first / k_block_size;
+    const std::size_t num_blocks =
+        (last + k_block_size - 1) / k_block_size - first_block;
+    OMP_DIRECTIVE(parallel) {
+      const int thread_no = metall::utility::omp::get_thread_num();
+      const auto range = metall::mtlldetail::partial_range(
+          num_blocks, thread_no, metall::utility::omp::get_num_threads());
+      const std::size_t begin =
+          std::max(first, (first_block + range.first) * k_block_size);
+      const std::size_t end =
+          std::min(last, (first_block + range.second) * k_block_size);
+      if (begin < end) {
+        generate(begin, end, [&func, thread_no](const uint64_t s,
+                                                const uint64_t d) {
+          func(thread_no, s, d);
+        });
+      }
+    }
+  }
+
+ private:
+  using rnd_type = metall::utility::rand_1024;
+
+  uint64_t priv_block_seed(const std::size_t block_no) const {
+    return metall::utility::hash<>()(m_seed ^
+                                     metall::utility::hash<>()(block_no));
+  }
+
+  const uint64_t m_seed;
+  const uint64_t m_vertex_scale;
+  const uint64_t m_num_edges;
+  const double m_a;
+  const double m_b;
+  const double m_c;
+  const double m_d;
+  const bool m_scramble_id;
+  const bool m_undirected;
+};
+
+}  // namespace edge_generator
+
+#endif  // METALL_BENCH_ADJACENCY_LIST_PARALLEL_RMAT_EDGE_GENERATOR_HPP
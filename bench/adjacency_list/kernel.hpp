@@ -52,9 +52,12 @@ inline auto allocate_key_value_input_storage() {
   return key_value_input_storage_t<adjacency_list_type>(num_threads);
 }
 
-template <typename adjacency_list_type>
+/// \brief Inserts the key-value pairs of each thread into 'adj_list'.
+/// \param input The input of each thread, e.g.,
+/// key_value_input_storage_t or spans of key-value pairs.
+template <typename adjacency_list_type, typename input_storage_type>
 inline auto ingest_key_values(
-    const key_value_input_storage_t<adjacency_list_type> &input,
+    const input_storage_type &input,
     const std::function<void()> &preprocess,
     const std::function<void()> &postprocess,
     adjacency_list_type *const adj_list, const bool verbose = false) {
@@ -76,10 +79,8 @@ inline auto ingest_key_values(
   OMP_DIRECTIVE(parallel reduction(+ : num_inserted)) {
     assert((int)input.size() == (int)omp::get_num_threads());
     const auto &key_value_list = input.at(omp::get_thread_num());
-    for (std::size_t i = 0; i < key_value_list.size(); ++i) {
-      adj_list->add(key_value_list[i].first, key_value_list[i].second);
-    }
-    num_inserted += key_value_list.size();
+    num_inserted +=
+        adj_list->add_batch(key_value_list.begin(), key_value_list.end());
   }
   const auto ingest_elapsed_time = mdtl::elapsed_time_sec(ingest_start);
 
@@ -20,10 +20,11 @@ darwin*) DATASTORE_DIR_ROOT="/tmp" ;;
 linux*) DATASTORE_DIR_ROOT="/dev/shm" ;;
 esac
 NO_CLEANING_FILES_AT_END=false
-UMAP_PAGESIZE=""
+UMAP_PAGESIZE=""     # UMap page size
+UMAP_PAGE_FILLERS="" # #of UMap fill workers
 EXEC_NAME="metall" # "run_adj_list_bench_${EXEC_NAME}" is the execution file
 
-while getopts "v:f:l:t:s:d:n:cp:E:" OPT; do
+while getopts "v:f:l:t:s:d:n:cp:F:E:" OPT; do
   case $OPT in
   v) VERTEX_SCALE=$OPTARG ;;
   f) FILE_SIZE=$OPTARG ;;
@@ -34,6 +35,7 @@ while getopts "v:f:l:t:s:d:n:cp:E:" OPT; do
   n) CHUNK_SIZE=$OPTARG ;;
   c) NO_CLEANING_FILES_AT_END=true ;;
   p) UMAP_PAGESIZE="env UMAP_PAGESIZE=${OPTARG}" ;;
+  F) UMAP_PAGE_FILLERS="env UMAP_PAGE_FILLERS=${OPTARG}" ;;
   E) EXEC_NAME=$OPTARG ;;
   :) echo "[ERROR] Option argument is undefined." ;; #
   \?) echo "[ERROR] Undefined options." ;;
@@ -148,7 +150,7 @@ main() {
   log_header "Start benchmark"
   local datastore_path=${datastore_dir}/${DATASTORE_NAME}
   local num_edges=$((2 ** $((${VERTEX_SCALE} + 4))))
-  execute ${NUM_THREADS} ${OMP_SCHEDULE} ${UMAP_PAGESIZE} ${exec_file_name} -o ${datastore_path} -f ${FILE_SIZE} -s ${RND_SEED} -v ${VERTEX_SCALE} -e ${num_edges} -a ${A} -b ${B} -c ${C} -r 1 -u 1 -n ${CHUNK_SIZE} -V
+  execute ${NUM_THREADS} ${OMP_SCHEDULE} ${UMAP_PAGESIZE} ${UMAP_PAGE_FILLERS} ${exec_file_name} -o ${datastore_path} -f ${FILE_SIZE} -s ${RND_SEED} -v ${VERTEX_SCALE} -e ${num_edges} -a ${A} -b ${B} -c ${C} -r 1 -u 1 -n ${CHUNK_SIZE} -V
 
   log_header "Datastore information"
   execute_simple ls -Rlsth ${datastore_dir}"/"
@@ -0,0 +1,227 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Derives a size class table for basic_manager from the allocation
+/// sizes in an allocation trace recorded by
+/// metall::manager::start_allocation_trace().
+/// The table minimizes the internal fragmentation of the traced allocations
+/// equal to or smaller than the largest size (the number of allocations of
+/// each size is the weight), keeping the powers of two the aligned
+/// allocations need. The sizes beyond the largest one are spaced as in the
+/// default table.
+/// Usage:
+/// ./derive_size_class_table [-n max #of sizes] [-l largest size]
+///   [-a alignment] trace_file
+/// -n: the maximum number of sizes in the table (default: the same as the
+///   default table).
+/// -l: the largest size in the table; must be a power of two (default: 256).
+/// -a: every size is a multiple of this value (default: 8).
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <metall/kernel/allocation_trace.hpp>
+#include <metall/kernel/object_size_manager.hpp>
+
+namespace {
+namespace mk = metall::kernel;
+
+constexpr std::size_t k_min_size = 8;
+
+/// \brief Number of allocations of each size.
+using histogram = std::map<std::size_t, std::size_t>;
+
+bool power_of_2(const std::size_t n) { return n > 0 && (n & (n - 1)) == 0; }
+
+std::size_t round_up(const std::size_t n, const std::size_t unit) {
+  return (n + unit - 1) / unit * unit;
+}
+
+/// \brief Returns the number of bytes the allocations in the histogram take
+/// with the sizes given by 'to_class_size'.
+template <typename function_type>
+std::size_t allocated_bytes(const histogram &hist,
+                            function_type to_class_size) {
+  std::size_t bytes = 0;
+  for (const auto &[size, count] : hist) bytes += to_class_size(size) * count;
+  return bytes;
+}
+
+/// \brief Chooses up to 'max_num_sizes' sizes from the candidates, which must
+/// include every mandatory size, by a dynamic programming.
+/// \return The chosen sizes in the ascending order; empty if not possible.
+std::vector<std::size_t> choose_sizes(const histogram &hist,
+                                      const std::vector<std::size_t> &cands,
+                                      const std::vector<bool> &mandatory,
+                                      const std::size_t max_num_sizes) {
+  const std::size_t n = cands.size();
+  // The number and the total size of the allocations up to each candidate
+  std::vector<double> counts(n, 0), sums(n, 0);
+  {
+    auto itr = hist.begin();
+    double count = 0, sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      for (; itr != hist.end() && itr->first <= cands[i]; ++itr) {
+        count += itr->second;
+        sum += double(itr->first) * itr->second;
+      }
+      counts[i] = count;
+      sums[i] = sum;
+    }
+  }
+  // The waste of the allocations in (cands[i], cands[j]] given cands[j]
+  const auto cost = [&](const std::size_t i, const std::size_t j) {
+    return double(cands[j]) * (counts[j] - counts[i]) - (sums[j] - sums[i]);
+  };
+
+  constexpr double k_inf = std::numeric_limits<double>::infinity();
+  // dp[k][j]: the least waste covering up to cands[j] with k + 1 sizes that
+  // end with cands[j]
+  std::vector<std::vector<double>> dp(max_num_sizes,
+                                      std::vector<double>(n, k_inf));
+  std::vector<std::vector<std::size_t>> parent(
+      max_num_sizes, std::vector<std::size_t>(n, 0));
+  dp[0][0] = 0;  // The first candidate is always chosen
+  for (std::size_t k = 1; k < max_num_sizes; ++k) {
+    for (std::size_t j = 1; j < n; ++j) {
+      // A mandatory size cannot be skipped
+      for (std::size_t i = j; i-- > 0;) {
+        if (dp[k - 1][i] < k_inf && dp[k - 1][i] + cost(i, j) < dp[k][j]) {
+          dp[k][j] = dp[k - 1][i] + cost(i, j);
+          parent[k][j] = i;
+        }
+        if (mandatory[i]) break;
+      }
+    }
+  }
+
+  std::size_t best_k = 0;
+  for (std::size_t k = 0; k < max_num_sizes; ++k) {
+    if (dp[k][n - 1] < dp[best_k][n - 1]) best_k = k;
+  }
+  if (dp[best_k][n - 1] == k_inf) return {};
+
+  std::vector<std::size_t> sizes(best_k + 1);
+  for (std::size_t k = best_k + 1, j = n - 1; k-- > 0;) {
+    sizes[k] = cands[j];
+    j = parent[k][j];
+  }
+  return sizes;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t max_num_sizes = mk::default_size_class_table::k_num_sizes;
+  std::size_t largest_size = 256;
+  std::size_t alignment = 8;
+  int p;
+  while ((p = ::getopt(argc, argv, "n:l:a:")) != -1) {
+    switch (p) {
+      case 'n':
+        max_num_sizes = std::stoull(optarg);
+        break;
+      case 'l':
+        largest_size = std::stoull(optarg);
+        break;
+      case 'a':
+        alignment = std::stoull(optarg);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  if (optind >= argc || !power_of_2(largest_size) ||
+      largest_size < k_min_size || alignment == 0 ||
+      largest_size % alignment != 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-n max #of sizes] [-l largest size (a power of 2)]"
+                 " [-a alignment] trace_file"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  mk::allocation_trace_header header;
+  std::vector<mk::allocation_trace_record> records;
+  if (!mk::read_allocation_trace(argv[optind], &header, &records)) {
+    return EXIT_FAILURE;
+  }
+
+  histogram hist;
+  std::size_t num_allocations = 0;
+  std::size_t num_small_allocations = 0;
+  for (const auto &r : records) {
+    if (r.op != mk::allocation_trace_op::allocate) continue;
+    ++num_allocations;
+    if (r.size <= largest_size) {
+      ++hist[std::max<std::size_t>(r.size, 1)];
+      ++num_small_allocations;
+    }
+  }
+
+  // The candidates are the allocation sizes and the powers of two
+  std::map<std::size_t, bool> cand_map;
+  for (std::size_t s = k_min_size; s <= largest_size; s *= 2) {
+    cand_map[s] = true;
+  }
+  for (const auto &entry : hist) {
+    const auto size = round_up(entry.first, alignment);
+    if (size > k_min_size) cand_map.emplace(size, false);
+  }
+  std::vector<std::size_t> cands;
+  std::vector<bool> mandatory;
+  for (const auto &[size, m] : cand_map) {
+    cands.push_back(size);
+    mandatory.push_back(m);
+  }
+
+  const auto sizes = choose_sizes(hist, cands, mandatory, max_num_sizes);
+  if (sizes.empty()) {
+    std::cerr << "Too few sizes to include all powers of two up to "
+              << largest_size << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  using default_object_size_manager =
+      mk::object_size_manager<(1ULL << 21ULL), (1ULL << 48ULL)>;
+  const auto default_bytes = allocated_bytes(hist, [](const std::size_t s) {
+    return default_object_size_manager::at(
+        default_object_size_manager::index(s));
+  });
+  const auto derived_bytes =
+      allocated_bytes(hist, [&sizes](const std::size_t s) {
+        for (const auto size : sizes) {
+          if (s <= size) return size;
+        }
+        return s;  // Never happens
+      });
+  const auto requested_bytes =
+      allocated_bytes(hist, [](const std::size_t s) { return s; });
+
+  std::cout << "#of allocations: " << num_allocations << " ("
+            << num_small_allocations << " with sizes <= " << largest_size
+            << ")" << std::endl;
+  if (requested_bytes > 0) {
+    std::cout << "Allocated bytes per requested byte (sizes <= "
+              << largest_size << ")" << std::endl;
+    std::cout << "  default table: " << double(default_bytes) / requested_bytes
+              << std::endl;
+    std::cout << "  derived table: " << double(derived_bytes) / requested_bytes
+              << std::endl;
+  }
+  std::cout << "metall::kernel::size_class_table<";
+  for (std::size_t i = 0; i < sizes.size(); ++i) {
+    std::cout << (i > 0 ? ", " : "") << sizes[i];
+  }
+  std::cout << ">" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Replays an allocation trace recorded by
+/// metall::manager::start_allocation_trace() to compare build configurations
+/// of the allocator, e.g., METALL_MAX_PER_CPU_CACHE_SIZE,
+/// METALL_USE_SORTED_BIN, the chunk size (METALL_BENCH_REPLAY_CHUNK_SIZE), or
+/// the size class table (METALL_BENCH_REPLAY_SIZE_CLASS_TABLE, a list of
+/// sizes, e.g., one made by derive_size_class_table).
+/// The utilization (the requested bytes per allocated byte) of the objects
+/// live at the end of the trace shows the internal fragmentation.
+/// Usage:
+/// ./replay_allocation_trace [-o datastore path] [-m sequential|threads]
+///   [--bench-* harness options] trace_file
+/// sequential (default): replays all records in the recorded order with one
+///   thread.
+/// threads: replays the records of each recorded thread with a thread;
+///   an object deallocated by another thread is waited for until it is
+///   allocated.
+/// The objects allocated before the trace started are not replayed.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/kernel/allocation_trace.hpp>
+#include <metall/detail/time.hpp>
+
+#include "../utility/bench_harness.hpp"
+#include "../simple_alloc/size_mix_kernel.hpp"
+
+#ifndef METALL_BENCH_REPLAY_CHUNK_SIZE
+#define METALL_BENCH_REPLAY_CHUNK_SIZE (1ULL << 21ULL)
+#endif
+
+namespace {
+namespace mk = metall::kernel;
+using mk::allocation_trace_op;
+using mk::allocation_trace_record;
+
+#ifdef METALL_BENCH_REPLAY_SIZE_CLASS_TABLE
+using size_class_table_type =
+    mk::size_class_table<METALL_BENCH_REPLAY_SIZE_CLASS_TABLE>;
+#else
+using size_class_table_type = mk::default_size_class_table;
+#endif
+
+using manager_type =
+    metall::basic_manager<mk::storage, mk::segment_storage, uint32_t,
+                          METALL_BENCH_REPLAY_CHUNK_SIZE,
+                          size_class_table_type>;
+
+constexpr std::size_t k_no_object = std::numeric_limits<std::size_t>::max();
+
+/// \brief A record with the index of the object it operates on.
+struct replay_op {
+  allocation_trace_op op;
+  uint32_t alignment;
+  std::size_t size;
+  std::size_t object;
+};
+
+struct replay_plan {
+  /// \brief The operations of each thread (all in [0] if sequential).
+  std::vector<std::vector<replay_op>> ops;
+  std::size_t num_objects{0};
+  std::size_t num_skipped{0};
+  std::size_t peak_live_bytes{0};
+  /// \brief The requested bytes of the objects live at the end.
+  std::size_t live_bytes{0};
+};
+
+/// \brief Assigns an object index to each allocation and resolves the
+/// objects of deallocations and resizes by the offsets.
+replay_plan make_plan(const std::vector<allocation_trace_record> &records,
+                      const bool sequential) {
+  replay_plan plan;
+  std::unordered_map<int64_t, std::pair<std::size_t, std::size_t>> live;
+  std::size_t live_bytes = 0;
+  for (const auto &r : records) {
+    const std::size_t t = sequential ? 0 : r.thread;
+    if (plan.ops.size() <= t) plan.ops.resize(t + 1);
+
+    replay_op op{r.op, r.alignment, r.size, k_no_object};
+    if (r.op == allocation_trace_op::allocate) {
+      op.object = plan.num_objects++;
+      live[r.offset] = {op.object, r.size};
+      live_bytes += r.size;
+      plan.peak_live_bytes = std::max(plan.peak_live_bytes, live_bytes);
+    } else {
+      const auto itr = live.find(r.offset);
+      if (itr == live.end()) {
+        ++plan.num_skipped;
+        continue;
+      }
+      op.object = itr->second.first;
+      if (r.op == allocation_trace_op::deallocate) {
+        live_bytes -= itr->second.second;
+        live.erase(itr);
+      } else {
+        live_bytes = live_bytes - itr->second.second + r.size;
+        itr->second.second = r.size;
+        plan.peak_live_bytes = std::max(plan.peak_live_bytes, live_bytes);
+      }
+    }
+    plan.ops[t].push_back(op);
+  }
+  plan.live_bytes = live_bytes;
+  return plan;
+}
+
+void replay(manager_type &manager, const std::vector<replay_op> &ops,
+            std::vector<std::atomic<void *>> &objects) {
+  for (const auto &op : ops) {
+    if (op.op == allocation_trace_op::allocate) {
+      void *const addr = (op.alignment > 0)
+                             ? manager.allocate_aligned(op.size, op.alignment)
+                             : manager.allocate(op.size);
+      if (!addr) {
+        std::cerr << "Failed to allocate " << op.size << " bytes" << std::endl;
+        std::abort();
+      }
+      objects[op.object].store(addr, std::memory_order_release);
+      continue;
+    }
+
+    void *addr;
+    // Waits for the allocation made by another thread
+    while (!(addr = objects[op.object].load(std::memory_order_acquire))) {
+      std::this_thread::yield();
+    }
+    if (op.op == allocation_trace_op::deallocate) {
+      if (op.size > 0) {
+        manager.deallocate(addr, op.size);
+      } else {
+        manager.deallocate(addr);
+      }
+    } else {
+      manager.resize_in_place(addr, op.size);
+    }
+  }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("allocation_trace_replay", argc, argv);
+
+  std::string datastore_path{"/tmp/datastore"};
+  std::string mode{"sequential"};
+  int p;
+  while ((p = ::getopt(argc, argv, "o:m:")) != -1) {
+    switch (p) {
+      case 'o':
+        datastore_path = optarg;
+        break;
+      case 'm':
+        mode = optarg;
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  if (optind >= argc || (mode != "sequential" && mode != "threads")) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-o datastore path] [-m sequential|threads] trace_file"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string trace_path = argv[optind];
+  harness.set_backend("metall");
+  harness.set_datastore_path(datastore_path);
+
+  mk::allocation_trace_header header;
+  std::vector<allocation_trace_record> records;
+  if (!mk::read_allocation_trace(trace_path, &header, &records)) {
+    return EXIT_FAILURE;
+  }
+  const auto plan = make_plan(records, mode == "sequential");
+  std::cerr << "#of records: " << records.size()
+            << ", #of threads: " << plan.ops.size()
+            << ", #of skipped records: " << plan.num_skipped << std::endl;
+
+  const bench_utility::bench_harness::param_list params{
+      {"trace", trace_path},
+      {"mode", mode},
+      {"traced_chunk_size", std::to_string(header.chunk_size)},
+      {"chunk_size", std::to_string(manager_type::chunk_size())}};
+  manager_type::memory_statistics_type stats;
+  std::size_t file_space = 0;
+  for (int r = 0; r < harness.num_runs(); ++r) {
+    manager_type::remove(datastore_path.c_str());
+    manager_type manager(metall::create_only, datastore_path.c_str());
+    std::vector<std::atomic<void *>> objects(plan.num_objects);
+
+    const auto start = metall::mtlldetail::elapsed_time_sec();
+    if (plan.ops.size() == 1) {
+      replay(manager, plan.ops[0], objects);
+    } else {
+      std::vector<std::thread> threads;
+      for (const auto &ops : plan.ops) {
+        threads.emplace_back(
+            [&manager, &ops, &objects]() { replay(manager, ops, objects); });
+      }
+      for (auto &th : threads) th.join();
+    }
+    harness.add_sample("replay", params,
+                       metall::mtlldetail::elapsed_time_sec(start));
+
+    manager.get_memory_statistics(&stats);
+    manager.flush();
+    file_space = size_mix_bench::get_file_space(datastore_path);
+  }
+  manager_type::remove(datastore_path.c_str());
+
+  const auto times = harness.statistics("replay", params);
+  const auto set = [&](const std::string &key, const double value) {
+    harness.set_metric("replay", params, key, value);
+  };
+  if (times.p50 > 0) {
+    set("throughput_mops",
+        double(records.size() - plan.num_skipped) / times.p50 / 1e6);
+  }
+  set("peak_live_bytes", double(plan.peak_live_bytes));
+  set("live_bytes", double(plan.live_bytes));
+  set("allocated_bytes", double(stats.allocated_bytes));
+  if (stats.allocated_bytes > 0) {
+    set("utilization", double(plan.live_bytes) / stats.allocated_bytes);
+  }
+  set("cached_bytes", double(stats.cached_bytes));
+  set("num_used_chunks", double(stats.num_used_chunks));
+  set("segment_size", double(stats.segment_size));
+  set("file_space_bytes", double(file_space));
+  set("num_skipped_records", double(plan.num_skipped));
+
+  return 0;
+}
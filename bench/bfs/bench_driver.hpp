@@ -16,6 +16,7 @@
 
 #include "kernel.hpp"
 #include <metall/utility/open_mp.hpp>
+#include <metall/utility/breadth_first_search.hpp>
 
 namespace bfs_bench {
 
@@ -35,13 +36,15 @@ struct bench_options {
   std::string graph_key_name{"adj_list"};
   vertex_id_type root_vertex_id{0};
   vertex_id_type max_vertex_id{0};
+  // Runs metall::utility::breadth_first_search instead of the kernel here
+  bool direction_optimizing{false};
 };
 
 template <typename vertex_id_type>
 bool parse_options(int argc, char **argv,
                    bench_options<vertex_id_type> *option) {
   int p;
-  while ((p = ::getopt(argc, argv, "g:k:r:m:")) != -1) {
+  while ((p = ::getopt(argc, argv, "g:k:r:m:d")) != -1) {
     switch (p) {
       case 'g': {
         option->graph_file_name_list.clear();
@@ -63,6 +66,10 @@ bool parse_options(int argc, char **argv,
         option->max_vertex_id = static_cast<vertex_id_type>(std::stoll(optarg));
         break;
 
+      case 'd':
+        option->direction_optimizing = true;
+        break;
+
       default:
         std::cerr << "Invalid option" << std::endl;
         return false;
@@ -81,7 +88,9 @@ bool parse_options(int argc, char **argv,
 
   std::cout << "graph_key_name: " << option->graph_key_name
             << "\nroot_vertex_id: " << option->root_vertex_id
-            << "\nmax_vertex_id: " << option->max_vertex_id << std::endl;
+            << "\nmax_vertex_id: " << option->max_vertex_id
+            << "\ndirection_optimizing: " << option->direction_optimizing
+            << std::endl;
   std::cout << "graph_file_name: " << std::endl;
   for (const auto &name : option->graph_file_name_list) {
     std::cout << " " << name << std::endl;
@@ -188,7 +197,19 @@ void run_bench(const graph_type &graph,
     print_omp_configuration();
     print_current_num_page_faults();
     const auto start = mdtl::elapsed_time_sec();
-    kernel(graph, &data);
+    if (option.direction_optimizing) {
+      const auto result = metall::utility::breadth_first_search(
+          graph, std::size_t(max_id) + 1, new_root);
+      OMP_DIRECTIVE(parallel for schedule(static))
+      for (std::size_t v = 0; v < result.level.size(); ++v) {
+        const auto level = result.level[v];
+        data.level[v] = (level == result.k_infinite_level)
+                            ? bfs_data::k_infinite_level
+                            : static_cast<bfs_data::level_type>(level);
+      }
+    } else {
+      kernel(graph, &data);
+    }
     const auto elapsed_time = mdtl::elapsed_time_sec(start);
     std::cout << "Finished BFS (s)\t" << elapsed_time << std::endl;
     print_current_num_page_faults();
@@ -17,8 +17,10 @@ case "$OSTYPE" in
 esac
 CHUNK_SIZE=$((2**20))
 NO_CLEANING_FILES_AT_END=false
+UMAP_PAGESIZE=""     # UMap page size
+UMAP_PAGE_FILLERS="" # #of UMap fill workers
 
-while getopts "v:f:r:l:m:t:s:g:n:c" OPT
+while getopts "v:f:r:l:m:t:s:g:n:cp:F:" OPT
 do
   case $OPT in
     v) V=$OPTARG;;
@@ -30,6 +32,8 @@ do
     g) GRAPH_DIR_ROOT=$OPTARG;;
     n) CHUNK_SIZE=$OPTARG;;
     c) NO_CLEANING_FILES_AT_END=true;;
+    p) UMAP_PAGESIZE="env UMAP_PAGESIZE=${OPTARG}";;
+    F) UMAP_PAGE_FILLERS="env UMAP_PAGE_FILLERS=${OPTARG}";;
     :) echo  "[ERROR] Option argument is undefined.";;   #
     \?) echo "[ERROR] Undefined options.";;
   esac
@@ -107,6 +111,8 @@ run() {
     # Configure
     # ------------------------- #
     EXEC_NAME=$1
+    # The program to construct the graph; defaults to EXEC_NAME
+    CONSTRUCTION_EXEC_NAME=${2:-$1}
     LOG_FILE=${LOG_FILE_PREFIX}"_"${EXEC_NAME}".log"
     echo "" > ${LOG_FILE}
 
@@ -130,9 +136,9 @@ run() {
         free -g  | tee -a ${LOG_FILE}
     fi
 
-    exec_file_name="../adjacency_list/run_adj_list_bench_${EXEC_NAME}"
+    exec_file_name="../adjacency_list/run_adj_list_bench_${CONSTRUCTION_EXEC_NAME}"
     try_to_get_compiler_ver ${exec_file_name}
-    execute ${NUM_THREADS} ${SCHEDULE} ${exec_file_name} -o "${GRAPH_DIR}/${GRAPH_NAME}" -f ${FILE_SIZE} -s ${SEED} -v ${V} -e ${E} -a ${A} -b ${B} -c ${C} -r 1 -u 1
+    execute ${NUM_THREADS} ${SCHEDULE} ${UMAP_PAGESIZE} ${UMAP_PAGE_FILLERS} ${exec_file_name} -o "${GRAPH_DIR}/${GRAPH_NAME}" -f ${FILE_SIZE} -s ${SEED} -v ${V} -e ${E} -a ${A} -b ${B} -c ${C} -r 1 -u 1
 
     ls -Rlsth ${GRAPH_DIR}"/" | tee -a ${LOG_FILE}
 
@@ -151,7 +157,7 @@ run() {
     fi
     exec_file_name="./run_bfs_bench_${EXEC_NAME}"
     try_to_get_compiler_ver ${exec_file_name}
-    execute ${NUM_THREADS} ${SCHEDULE} ${exec_file_name} -g "${GRAPH_DIR}/${GRAPH_NAME}" -k ${ADJ_LIST_KEY_NAME} -r ${BFS_ROOT} -m ${MAX_VERTEX_ID}
+    execute ${NUM_THREADS} ${SCHEDULE} ${UMAP_PAGESIZE} ${UMAP_PAGE_FILLERS} ${exec_file_name} -g "${GRAPH_DIR}/${GRAPH_NAME}" -k ${ADJ_LIST_KEY_NAME} -r ${BFS_ROOT} -m ${MAX_VERTEX_ID}
 
 
     if ${NO_CLEANING_FILES_AT_END}; then
@@ -165,6 +171,8 @@ run() {
 main() {
     run bip
     run metall
+    # Traverses a graph constructed by the normal Metall with huge pages
+    run metall_huge_page metall
     #run metall_numa
 }
 
@@ -0,0 +1,57 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+// Builds a CSR graph in DRAM from edge list files (-g) and runs BFS on it.
+// Each file is read by a thread.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <metall/container/csr_graph.hpp>
+#include "../utility/pair_reader.hpp"
+#include "bench_driver.hpp"
+
+using namespace bfs_bench;
+
+using vertex_id_type = uint64_t;
+
+#ifdef METALL_BENCH_BFS_COMPRESSED_CSR
+constexpr bool k_compressed = true;
+#else
+constexpr bool k_compressed = false;
+#endif
+
+using graph_type =
+    metall::container::csr_graph<vertex_id_type, uint64_t, k_compressed,
+                                 std::allocator<std::byte>>;
+
+int main(int argc, char *argv[]) {
+  bench_options<vertex_id_type> option;
+  if (!parse_options(argc, argv, &option)) {
+    std::abort();
+  }
+
+  graph_type graph;
+  {
+    using reader_type =
+        bench_utility::pair_reader<vertex_id_type, vertex_id_type>;
+    std::vector<reader_type> readers;
+    for (const auto &file_name : option.graph_file_name_list) {
+      readers.emplace_back(&file_name, &file_name + 1);
+    }
+
+    std::cout << "\nBuild CSR graph" << std::endl;
+    const auto start = mdtl::elapsed_time_sec();
+    graph.build(readers, option.max_vertex_id + 1);
+    const auto elapsed_time = mdtl::elapsed_time_sec(start);
+    std::cout << "Finished building (s)\t" << elapsed_time << std::endl;
+    std::cout << "#of edges\t" << graph.num_edges() << std::endl;
+  }
+
+  run_bench(graph, option);
+
+  return 0;
+}
@@ -30,10 +30,19 @@ int main(int argc, char *argv[]) {
   }
 
   {
+    // Opens the datastores in parallel
+    const std::vector<metall::manager::path_type> paths(
+        option.graph_file_name_list.begin(),
+        option.graph_file_name_list.end());
+    auto opened_managers =
+        metall::manager::open_many(metall::open_read_only, paths);
     std::vector<metall::manager *> managers;
-    for (const auto &file_name : option.graph_file_name_list) {
-      managers.emplace_back(
-          new metall::manager(metall::open_read_only, file_name));
+    for (auto &manager : opened_managers) {
+      if (!manager) {
+        std::cerr << "Failed to open a datastore" << std::endl;
+        std::abort();
+      }
+      managers.emplace_back(manager.get());
     }
 
     auto adj_list = adjacency_list_type(option.graph_key_name, managers.begin(),
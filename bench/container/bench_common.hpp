@@ -31,11 +31,14 @@ void gen_edges(const std::size_t vertex_scale, const std::size_t num_edges,
 
 void gen_random_values(const std::size_t num_values,
                        std::vector<std::pair<uint64_t, uint64_t>> &buf) {
-  metall::utility::rand_1024 rnd_generator(std::random_device{}());
+  const metall::utility::rand_512x4 rnd_generator(std::random_device{}());
+
+  std::vector<uint64_t> values(num_values * 2);
+  metall::utility::fill_parallel(rnd_generator, values.data(), values.size());
 
   buf.reserve(num_values);
   for (std::size_t i = 0; i < num_values; ++i) {
-    buf.emplace_back(rnd_generator(), rnd_generator());
+    buf.emplace_back(values[i * 2], values[i * 2 + 1]);
   }
 }
 
@@ -0,0 +1,617 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Measures the throughput of the containers with different
+/// allocators: std::allocator (std), Metall (metall), and Boost.Interprocess
+/// (bip). Each container is measured by the following operations:
+/// insert, lookup_hit, lookup_miss, iterate, reopen_lookup (close, reopen,
+/// find the container, then look up all keys; metall and bip only), and
+/// erase.
+/// Usage:
+/// ./run_container_bench [-o datastore path] [-n #of keys]
+///   [-c containers (comma separated)] [-b backends (comma separated)]
+///   [-s Boost.Interprocess file size] [--bench-* harness options]
+/// Containers: map, unordered_map, vector, unordered_flat_map (Boost 1.81 or
+/// later), unordered_node_map (Boost 1.82 or later), concurrent_map,
+/// string_key_store, json_object (Boost 1.75 or later).
+/// All available containers and all backends are measured by default.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/container/map.hpp>
+#include <boost/container/vector.hpp>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <metall/metall.hpp>
+#include <metall/container/concurrent_map.hpp>
+#include <metall/container/string_key_store.hpp>
+#include <metall/detail/time.hpp>
+#include <metall/utility/random.hpp>
+
+#if BOOST_VERSION >= 108100
+#include <boost/unordered/unordered_flat_map.hpp>
+#endif
+#if BOOST_VERSION >= 108200
+#include <boost/unordered/unordered_node_map.hpp>
+#endif
+#if BOOST_VERSION >= 107500
+#include <metall/json/json.hpp>
+#endif
+
+#include "../utility/bench_harness.hpp"
+
+namespace {
+namespace bip = boost::interprocess;
+namespace mdtl = metall::mtlldetail;
+
+constexpr const char *k_container_name = "container";
+
+// Takes the results so that the measured work is not optimized away
+volatile uint64_t g_sink = 0;
+
+struct option_type {
+  std::string datastore_path{"/tmp/datastore"};
+  std::size_t num_keys{1ULL << 20ULL};
+  std::vector<std::string> containers;
+  std::vector<std::string> backends{"std", "metall", "bip"};
+  std::size_t bip_file_size{1ULL << 34ULL};
+};
+
+std::vector<std::string> split(const std::string &str) {
+  std::vector<std::string> list;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) list.push_back(item);
+  return list;
+}
+
+option_type parse_option(int argc, char **argv) {
+  option_type option;
+  int p;
+  while ((p = ::getopt(argc, argv, "o:n:c:b:s:")) != -1) {
+    switch (p) {
+      case 'o':
+        option.datastore_path = optarg;
+        break;
+      case 'n':
+        option.num_keys = std::stoull(optarg);
+        break;
+      case 'c':
+        option.containers = split(optarg);
+        break;
+      case 'b':
+        option.backends = split(optarg);
+        break;
+      case 's':
+        option.bip_file_size = std::stoull(optarg);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  return option;
+}
+
+/// \brief The keys to insert and the keys that are never inserted.
+/// The keys are random; the miss keys have the lowest bit set.
+struct key_set {
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> miss_keys;
+  std::vector<std::string> key_strings;
+  std::vector<std::string> miss_key_strings;
+
+  explicit key_set(const std::size_t n) {
+    metall::utility::rand_1024 rand(123);
+    keys.reserve(n);
+    miss_keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      keys.push_back(rand() & ~uint64_t(1));
+      miss_keys.push_back(rand() | uint64_t(1));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(456));
+    for (const auto k : keys) {
+      key_strings.push_back("key_" + std::to_string(k));
+    }
+    for (const auto k : miss_keys) {
+      miss_key_strings.push_back("key_" + std::to_string(k));
+    }
+  }
+};
+
+// -------------------- //
+// Backends
+// -------------------- //
+
+/// \brief Allocates containers with std::allocator; cannot be reopened.
+struct std_backend {
+  static constexpr const char *name = "std";
+  static constexpr bool persistent = false;
+  using allocator_type = std::allocator<std::byte>;
+
+  explicit std_backend(const option_type &) {}
+
+  void create() {}
+  void close() {}
+  void open() {}
+  void remove() {}
+  allocator_type get_allocator() { return allocator_type(); }
+
+  template <typename container_type>
+  container_type *construct() {
+    return new container_type(get_allocator());
+  }
+  template <typename container_type>
+  container_type *find() {
+    return nullptr;
+  }
+  template <typename container_type>
+  void destroy(container_type *container) {
+    delete container;
+  }
+};
+
+/// \brief Allocates containers in a Metall datastore.
+struct metall_backend {
+  static constexpr const char *name = "metall";
+  static constexpr bool persistent = true;
+  using allocator_type = metall::manager::allocator_type<std::byte>;
+
+  explicit metall_backend(const option_type &option)
+      : m_path(option.datastore_path) {}
+
+  void create() {
+    remove();
+    m_manager = std::make_unique<metall::manager>(metall::create_only,
+                                                  m_path.c_str());
+  }
+  void close() { m_manager.reset(); }
+  void open() {
+    m_manager =
+        std::make_unique<metall::manager>(metall::open_only, m_path.c_str());
+  }
+  void remove() { metall::manager::remove(m_path.c_str()); }
+  allocator_type get_allocator() { return m_manager->get_allocator(); }
+
+  template <typename container_type>
+  container_type *construct() {
+    return m_manager->construct<container_type>(k_container_name)(
+        get_allocator());
+  }
+  template <typename container_type>
+  container_type *find() {
+    return m_manager->find<container_type>(k_container_name).first;
+  }
+  template <typename container_type>
+  void destroy(container_type *container) {
+    m_manager->destroy_ptr(container);
+  }
+
+ private:
+  std::string m_path;
+  std::unique_ptr<metall::manager> m_manager;
+};
+
+/// \brief Allocates containers in a Boost.Interprocess managed mapped file,
+/// at the datastore path + "_bip".
+struct bip_backend {
+  static constexpr const char *name = "bip";
+  static constexpr bool persistent = true;
+  using allocator_type =
+      bip::allocator<std::byte, bip::managed_mapped_file::segment_manager>;
+
+  explicit bip_backend(const option_type &option)
+      : m_path(option.datastore_path + "_bip"),
+        m_file_size(option.bip_file_size) {}
+
+  void create() {
+    remove();
+    m_file = std::make_unique<bip::managed_mapped_file>(
+        bip::create_only, m_path.c_str(), m_file_size);
+  }
+  void close() { m_file.reset(); }
+  void open() {
+    m_file = std::make_unique<bip::managed_mapped_file>(bip::open_only,
+                                                        m_path.c_str());
+  }
+  void remove() { bip::file_mapping::remove(m_path.c_str()); }
+  allocator_type get_allocator() {
+    return m_file->get_allocator<std::byte>();
+  }
+
+  template <typename container_type>
+  container_type *construct() {
+    return m_file->construct<container_type>(k_container_name)(
+        get_allocator());
+  }
+  template <typename container_type>
+  container_type *find() {
+    return m_file->find<container_type>(k_container_name).first;
+  }
+  template <typename container_type>
+  void destroy(container_type *container) {
+    m_file->destroy_ptr(container);
+  }
+
+ private:
+  std::string m_path;
+  std::size_t m_file_size;
+  std::unique_ptr<bip::managed_mapped_file> m_file;
+};
+
+// -------------------- //
+// Containers
+// -------------------- //
+// Each kind defines the container type with an allocator and the operations.
+// contains() returns 0 or 1 so that the results can be summed.
+
+template <typename alloc_type, typename T>
+using rebind_alloc =
+    typename std::allocator_traits<alloc_type>::template rebind_alloc<T>;
+
+template <typename alloc_type>
+using kv_alloc = rebind_alloc<alloc_type, std::pair<const uint64_t, uint64_t>>;
+
+/// \brief The operations shared by the maps that have uint64_t keys.
+struct uint64_map_operations {
+  template <typename container_type>
+  static void insert(container_type &c, const key_set &ks,
+                     const std::size_t i) {
+    c.emplace(ks.keys[i], ks.keys[i]);
+  }
+  template <typename container_type>
+  static std::size_t contains(const container_type &c,
+                              const std::vector<uint64_t> &keys,
+                              const std::vector<std::string> &,
+                              const std::size_t i) {
+    return c.find(keys[i]) != c.end();
+  }
+  template <typename container_type>
+  static uint64_t iterate(const container_type &c) {
+    uint64_t sum = 0;
+    for (const auto &kv : c) sum += kv.second;
+    return sum;
+  }
+  template <typename container_type>
+  static void erase(container_type &c, const key_set &ks,
+                    const std::size_t i) {
+    c.erase(ks.keys[i]);
+  }
+};
+
+struct map_kind : uint64_map_operations {
+  static constexpr const char *name = "map";
+  template <typename alloc_type>
+  using container = boost::container::map<uint64_t, uint64_t,
+                                          std::less<uint64_t>,
+                                          kv_alloc<alloc_type>>;
+};
+
+struct unordered_map_kind : uint64_map_operations {
+  static constexpr const char *name = "unordered_map";
+  template <typename alloc_type>
+  using container =
+      boost::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>,
+                           std::equal_to<uint64_t>, kv_alloc<alloc_type>>;
+};
+
+#if BOOST_VERSION >= 108100
+struct unordered_flat_map_kind : uint64_map_operations {
+  static constexpr const char *name = "unordered_flat_map";
+  template <typename alloc_type>
+  using container =
+      boost::unordered_flat_map<uint64_t, uint64_t, std::hash<uint64_t>,
+                                std::equal_to<uint64_t>, kv_alloc<alloc_type>>;
+};
+#endif
+
+#if BOOST_VERSION >= 108200
+struct unordered_node_map_kind : uint64_map_operations {
+  static constexpr const char *name = "unordered_node_map";
+  template <typename alloc_type>
+  using container =
+      boost::unordered_node_map<uint64_t, uint64_t, std::hash<uint64_t>,
+                                std::equal_to<uint64_t>, kv_alloc<alloc_type>>;
+};
+#endif
+
+struct concurrent_map_kind : uint64_map_operations {
+  static constexpr const char *name = "concurrent_map";
+  template <typename alloc_type>
+  using container = metall::container::concurrent_map<
+      uint64_t, uint64_t, std::less<uint64_t>, std::hash<uint64_t>,
+      kv_alloc<alloc_type>>;
+
+  template <typename container_type>
+  static void insert(container_type &c, const key_set &ks,
+                     const std::size_t i) {
+    c.insert(std::make_pair(ks.keys[i], ks.keys[i]));
+  }
+  template <typename container_type>
+  static std::size_t contains(const container_type &c,
+                              const std::vector<uint64_t> &keys,
+                              const std::vector<std::string> &,
+                              const std::size_t i) {
+    return c.count(keys[i]);
+  }
+  template <typename container_type>
+  static uint64_t iterate(const container_type &c) {
+    uint64_t sum = 0;
+    for (auto itr = c.cbegin(); itr != c.cend(); ++itr) sum += itr->second;
+    return sum;
+  }
+};
+
+/// \brief A vector is looked up by index; a miss is an index out of range.
+struct vector_kind {
+  static constexpr const char *name = "vector";
+  template <typename alloc_type>
+  using container =
+      boost::container::vector<uint64_t, rebind_alloc<alloc_type, uint64_t>>;
+
+  template <typename container_type>
+  static void insert(container_type &c, const key_set &ks,
+                     const std::size_t i) {
+    c.push_back(ks.keys[i]);
+  }
+  template <typename container_type>
+  static std::size_t contains(const container_type &c,
+                              const std::vector<uint64_t> &keys,
+                              const std::vector<std::string> &,
+                              const std::size_t i) {
+    const auto index = keys[i] % (2 * c.size());
+    return index < c.size() && c[index] != 1;
+  }
+  template <typename container_type>
+  static uint64_t iterate(const container_type &c) {
+    uint64_t sum = 0;
+    for (const auto v : c) sum += v;
+    return sum;
+  }
+  template <typename container_type>
+  static void erase(container_type &c, const key_set &, const std::size_t) {
+    c.pop_back();
+  }
+};
+
+struct string_key_store_kind {
+  static constexpr const char *name = "string_key_store";
+  template <typename alloc_type>
+  using container = metall::container::string_key_store<uint64_t, alloc_type>;
+
+  template <typename container_type>
+  static void insert(container_type &c, const key_set &ks,
+                     const std::size_t i) {
+    c.insert(ks.key_strings[i], ks.keys[i]);
+  }
+  template <typename container_type>
+  static std::size_t contains(const container_type &c,
+                              const std::vector<uint64_t> &,
+                              const std::vector<std::string> &keys,
+                              const std::size_t i) {
+    return c.find(keys[i]) != c.end();
+  }
+  template <typename container_type>
+  static uint64_t iterate(const container_type &c) {
+    uint64_t sum = 0;
+    for (auto loc = c.begin(); loc != c.end(); ++loc) sum += c.value(loc);
+    return sum;
+  }
+  template <typename container_type>
+  static void erase(container_type &c, const key_set &ks,
+                    const std::size_t i) {
+    c.erase(ks.key_strings[i]);
+  }
+};
+
+#if BOOST_VERSION >= 107500
+struct json_object_kind {
+  static constexpr const char *name = "json_object";
+  template <typename alloc_type>
+  using container = metall::json::object<alloc_type>;
+
+  template <typename container_type>
+  static void insert(container_type &c, const key_set &ks,
+                     const std::size_t i) {
+    c[ks.key_strings[i]] = ks.keys[i];
+  }
+  template <typename container_type>
+  static std::size_t contains(const container_type &c,
+                              const std::vector<uint64_t> &,
+                              const std::vector<std::string> &keys,
+                              const std::size_t i) {
+    return c.contains(keys[i]);
+  }
+  template <typename container_type>
+  static uint64_t iterate(const container_type &c) {
+    uint64_t sum = 0;
+    for (const auto &kv : c) sum += kv.value().as_uint64();
+    return sum;
+  }
+  template <typename container_type>
+  static void erase(container_type &c, const key_set &ks,
+                    const std::size_t i) {
+    c.erase(ks.key_strings[i]);
+  }
+};
+#endif
+
+// -------------------- //
+// Measurement
+// -------------------- //
+
+/// \brief Measures all operations of a container kind with a backend.
+template <typename kind, typename backend_type>
+void measure(const option_type &option, const key_set &ks,
+             bench_utility::bench_harness &harness) {
+  using container_type =
+      typename kind::template container<typename backend_type::allocator_type>;
+  std::cerr << kind::name << " with " << backend_type::name << std::endl;
+
+  const bench_utility::bench_harness::param_list params{
+      {"container", kind::name},
+      {"backend", backend_type::name},
+      {"num_keys", std::to_string(ks.keys.size())}};
+  const std::size_t n = ks.keys.size();
+  const auto time = [&](const std::string &op, const auto &func) {
+    const auto start = mdtl::elapsed_time_sec();
+    func();
+    harness.add_sample(op, params, mdtl::elapsed_time_sec(start));
+  };
+  const auto lookup = [&](const container_type &c,
+                          const std::vector<uint64_t> &keys,
+                          const std::vector<std::string> &key_strings) {
+    std::size_t num_found = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      num_found += kind::contains(c, keys, key_strings, i);
+    }
+    g_sink = g_sink + num_found;
+    return num_found;
+  };
+  const auto check = [](const bool ok, const char *const what) {
+    if (!ok) {
+      std::cerr << "Unexpected result of " << what << std::endl;
+      std::abort();
+    }
+  };
+
+  backend_type backend(option);
+  std::vector<std::string> ops{"insert", "lookup_hit", "lookup_miss",
+                               "iterate", "erase"};
+  for (int r = 0; r < harness.num_runs(); ++r) {
+    backend.create();
+    auto *container = backend.template construct<container_type>();
+
+    time("insert", [&]() {
+      for (std::size_t i = 0; i < n; ++i) kind::insert(*container, ks, i);
+    });
+    // A vector finds about a half of the keys (the indices in range)
+    constexpr bool exact = !std::is_same_v<kind, vector_kind>;
+    time("lookup_hit", [&]() {
+      const auto num_found = lookup(*container, ks.keys, ks.key_strings);
+      check(!exact || num_found == n, "lookup_hit");
+    });
+    time("lookup_miss", [&]() {
+      const auto num_found =
+          lookup(*container, ks.miss_keys, ks.miss_key_strings);
+      check(!exact || num_found == 0, "lookup_miss");
+    });
+    time("iterate", [&]() { g_sink = g_sink + kind::iterate(*container); });
+
+    if constexpr (backend_type::persistent) {
+      backend.close();
+      time("reopen_lookup", [&]() {
+        backend.open();
+        container = backend.template find<container_type>();
+        check(container != nullptr, "find");
+        const auto num_found = lookup(*container, ks.keys, ks.key_strings);
+        check(!exact || num_found == n, "reopen_lookup");
+      });
+    }
+
+    time("erase", [&]() {
+      for (std::size_t i = 0; i < n; ++i) kind::erase(*container, ks, i);
+    });
+    backend.destroy(container);
+    backend.close();
+    backend.remove();
+  }
+
+  if constexpr (backend_type::persistent) ops.push_back("reopen_lookup");
+  for (const auto &op : ops) {
+    const auto stats = harness.statistics(op, params);
+    if (stats.p50 > 0) {
+      harness.set_metric(op, params, "throughput_mops",
+                         double(n) / stats.p50 / 1e6);
+    }
+  }
+}
+
+template <typename kind>
+void measure_backends(const option_type &option, const key_set &ks,
+                      bench_utility::bench_harness &harness) {
+  for (const auto &backend : option.backends) {
+    if (backend == std_backend::name) {
+      measure<kind, std_backend>(option, ks, harness);
+    } else if (backend == metall_backend::name) {
+      measure<kind, metall_backend>(option, ks, harness);
+    } else if (backend == bip_backend::name) {
+      measure<kind, bip_backend>(option, ks, harness);
+    } else {
+      std::cerr << "Unknown backend: " << backend << std::endl;
+      std::abort();
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("container", argc, argv);
+  const auto option = parse_option(argc, argv);
+  harness.set_backend("std,metall,bip");
+  harness.set_datastore_path(option.datastore_path);
+
+  const key_set ks(option.num_keys);
+  std::vector<std::pair<std::string, void (*)(const option_type &,
+                                              const key_set &,
+                                              bench_utility::bench_harness &)>>
+      all_kinds = {
+          {map_kind::name, measure_backends<map_kind>},
+          {unordered_map_kind::name, measure_backends<unordered_map_kind>},
+          {vector_kind::name, measure_backends<vector_kind>},
+#if BOOST_VERSION >= 108100
+          {unordered_flat_map_kind::name,
+           measure_backends<unordered_flat_map_kind>},
+#endif
+#if BOOST_VERSION >= 108200
+          {unordered_node_map_kind::name,
+           measure_backends<unordered_node_map_kind>},
+#endif
+          {concurrent_map_kind::name, measure_backends<concurrent_map_kind>},
+          {string_key_store_kind::name,
+           measure_backends<string_key_store_kind>},
+#if BOOST_VERSION >= 107500
+          {json_object_kind::name, measure_backends<json_object_kind>},
+#endif
+      };
+
+  for (const auto &container : option.containers) {
+    if (std::none_of(all_kinds.begin(), all_kinds.end(),
+                     [&container](const auto &k) {
+                       return k.first == container;
+                     })) {
+      std::cerr << "Unknown or unavailable container: " << container
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  for (const auto &[name, func] : all_kinds) {
+    if (!option.containers.empty() &&
+        std::find(option.containers.begin(), option.containers.end(), name) ==
+            option.containers.end()) {
+      continue;
+    }
+    func(option, ks, harness);
+  }
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Measures the overhead of fallback_allocator_adaptor over the
+/// allocators it dispatches to, with the policies: dynamic (decides at each
+/// operation), stateful, and heap (resolved at compile time).
+/// The allocators are measured by the following operations:
+/// alloc_free (allocates and deallocates single objects) and
+/// small_vectors (builds many small vectors).
+/// Usage:
+/// ./run_fallback_allocator_bench [-o datastore path] [-n #of operations]
+///   [--bench-* harness options]
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/container/vector.hpp>
+
+#include <metall/metall.hpp>
+#include <metall/container/fallback_allocator.hpp>
+
+#include "../utility/bench_harness.hpp"
+
+namespace {
+namespace mc = metall::container;
+
+// Takes the results so that the measured work is not optimized away
+volatile uint64_t g_sink = 0;
+
+struct option_type {
+  std::string datastore_path{"/tmp/datastore"};
+  std::size_t num_operations{1ULL << 22ULL};
+};
+
+option_type parse_option(int argc, char **argv) {
+  option_type option;
+  int p;
+  while ((p = ::getopt(argc, argv, "o:n:")) != -1) {
+    switch (p) {
+      case 'o':
+        option.datastore_path = optarg;
+        break;
+      case 'n':
+        option.num_operations = std::stoull(optarg);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  return option;
+}
+
+/// \brief Measures all operations of an allocator.
+template <typename allocator_type>
+void measure(const std::string &name, const allocator_type &allocator,
+             const std::size_t n, bench_utility::bench_harness &harness) {
+  std::cerr << name << std::endl;
+  using traits = std::allocator_traits<allocator_type>;
+  const bench_utility::bench_harness::param_list params{
+      {"allocator", name}, {"num_operations", std::to_string(n)}};
+
+  // Keeps some objects alive so that the free lists are not trivially
+  // reused
+  constexpr std::size_t k_window = 64;
+  std::vector<typename traits::pointer> window(k_window, nullptr);
+  harness.run("alloc_free", params, [&]() {
+    auto a = allocator;
+    for (std::size_t i = 0; i < n; ++i) {
+      auto &slot = window[i % k_window];
+      if (slot) traits::deallocate(a, slot, 1);
+      slot = traits::allocate(a, 1);
+    }
+    for (auto &slot : window) {
+      if (slot) traits::deallocate(a, slot, 1);
+      slot = nullptr;
+    }
+  });
+
+  using vector_type = boost::container::vector<uint64_t, allocator_type>;
+  constexpr std::size_t k_vector_length = 16;
+  harness.run("small_vectors", params, [&]() {
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < n / k_vector_length; ++i) {
+      vector_type vec(allocator);
+      for (std::size_t j = 0; j < k_vector_length; ++j) vec.push_back(j);
+      sum += vec.back();
+    }
+    g_sink = g_sink + sum;
+  });
+
+  for (const auto &op : {"alloc_free", "small_vectors"}) {
+    const auto stats = harness.statistics(op, params);
+    if (stats.p50 > 0) {
+      harness.set_metric(op, params, "throughput_mops",
+                         double(n) / stats.p50 / 1e6);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("fallback_allocator", argc, argv);
+  const auto option = parse_option(argc, argv);
+  harness.set_backend("std,metall");
+  harness.set_datastore_path(option.datastore_path);
+  const auto n = option.num_operations;
+
+  using value_type = uint64_t;
+  using stl_allocator_type = metall::manager::allocator_type<value_type>;
+  {
+    metall::manager manager(metall::create_only,
+                            option.datastore_path.c_str());
+    const stl_allocator_type allocator = manager.get_allocator<value_type>();
+    measure("stl_allocator", allocator, n, harness);
+    measure("fallback_dynamic_metall",
+            mc::fallback_allocator_adaptor<stl_allocator_type>(allocator), n,
+            harness);
+    measure("fallback_stateful",
+            mc::static_fallback_allocator_adaptor<stl_allocator_type, true>(
+                allocator),
+            n, harness);
+  }
+  metall::manager::remove(option.datastore_path.c_str());
+
+  measure("std_allocator", std::allocator<value_type>(), n, harness);
+  measure("fallback_dynamic_heap",
+          mc::fallback_allocator_adaptor<stl_allocator_type>(), n, harness);
+  measure("fallback_heap",
+          mc::static_fallback_allocator_adaptor<stl_allocator_type, false>(),
+          n, harness);
+
+  return 0;
+}
@@ -3,20 +3,33 @@
 //
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
-/// \brief Benchmarks the STL map container using different allocators.
+/// \brief Benchmarks the STL map container using different allocators and
+/// compares it with btree_map.
 /// Usage:
 /// ./run_map_bench
 /// # modify the values in the main(), if needed.
 
 #include <iostream>
 #include <map>
+#include <string>
 #include <boost/container/map.hpp>
 #include <metall/container/map.hpp>
+#include <metall/container/btree_map.hpp>
 #include <metall/metall.hpp>
 #include <metall/detail/time.hpp>
 
 #include "bench_common.hpp"
 
+template <typename map_type>
+void run_scan(const std::string &name, const map_type &map) {
+  const auto start = mdtl::elapsed_time_sec();
+  uint64_t sum = 0;
+  for (const auto &kv : map) sum += kv.first;
+  const auto elapsed_time = mdtl::elapsed_time_sec(start);
+  std::cout << name << " scan took (s)\t" << elapsed_time << " (" << sum
+            << ")" << std::endl;
+}
+
 int main() {
   std::size_t scale = 17;
   std::size_t num_inputs = (1ULL << scale) * 16;
@@ -62,6 +75,37 @@ int main() {
     const auto elapsed_time = mdtl::elapsed_time_sec(start);
     std::cout << "Boost map with Metall took (s)\t" << elapsed_time
               << std::endl;
+    run_scan("Boost map with Metall", map);
+  }
+
+  {
+    metall::container::btree_map<uint64_t, uint64_t> map;
+
+    const auto start = mdtl::elapsed_time_sec();
+    for (const auto &kv : inputs) {
+      map[kv.first];
+      map[kv.second];
+    }
+    const auto elapsed_time = mdtl::elapsed_time_sec(start);
+    std::cout << "B+tree map took (s)\t" << elapsed_time << std::endl;
+  }
+
+  {
+    metall::manager mngr(metall::create_only, "/tmp/metall");
+    metall::container::btree_map<
+        uint64_t, uint64_t, std::less<uint64_t>,
+        metall::manager::allocator_type<std::pair<const uint64_t, uint64_t>>>
+        map(mngr.get_allocator());
+
+    const auto start = mdtl::elapsed_time_sec();
+    for (const auto &kv : inputs) {
+      map[kv.first];
+      map[kv.second];
+    }
+    const auto elapsed_time = mdtl::elapsed_time_sec(start);
+    std::cout << "B+tree map with Metall took (s)\t" << elapsed_time
+              << std::endl;
+    run_scan("B+tree map with Metall", map);
   }
 
   return 0;
@@ -9,14 +9,35 @@
 /// # modify the values in the main(), if needed.
 
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <boost/unordered_map.hpp>
 #include <metall/container/unordered_map.hpp>
+#include <metall/container/concurrent_map.hpp>
+#include <metall/container/concurrent_unordered_map.hpp>
 #include <metall/metall.hpp>
 #include <metall/detail/time.hpp>
 
 #include "bench_common.hpp"
 
+/// \brief Inserts the inputs using multiple threads.
+template <typename inserter_func>
+double run_parallel(const std::vector<std::pair<uint64_t, uint64_t>> &inputs,
+                    const std::size_t num_threads,
+                    const inserter_func &inserter) {
+  const auto start = mdtl::elapsed_time_sec();
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&inputs, &inserter, t, num_threads]() {
+      for (std::size_t i = t; i < inputs.size(); i += num_threads) {
+        inserter(inputs[i]);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  return mdtl::elapsed_time_sec(start);
+}
+
 int main() {
   std::size_t scale = 17;
   std::size_t num_inputs = (1ULL << scale) * 16;
@@ -65,5 +86,43 @@ int main() {
               << std::endl;
   }
 
+  std::vector<std::size_t> num_threads_list{1};
+  if (std::thread::hardware_concurrency() > 1) {
+    num_threads_list.push_back(std::thread::hardware_concurrency());
+  }
+  for (const std::size_t n : num_threads_list) {
+    {
+      metall::manager mngr(metall::create_only, "/tmp/metall");
+      using allocator_type =
+          metall::manager::allocator_type<std::pair<const uint64_t, uint64_t>>;
+      metall::container::concurrent_map<
+          uint64_t, uint64_t, std::less<uint64_t>, std::hash<uint64_t>,
+          allocator_type>
+          map(mngr.get_allocator());
+      const auto elapsed_time = run_parallel(inputs, n, [&map](const auto &kv) {
+        map.insert(std::make_pair(kv.first, uint64_t(0)));
+        map.insert(std::make_pair(kv.second, uint64_t(0)));
+      });
+      std::cout << "concurrent_map with Metall (" << n << " threads) took (s)\t"
+                << elapsed_time << std::endl;
+    }
+
+    {
+      metall::manager mngr(metall::create_only, "/tmp/metall");
+      using allocator_type =
+          metall::manager::allocator_type<std::pair<const uint64_t, uint64_t>>;
+      metall::container::concurrent_unordered_map<
+          uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+          allocator_type>
+          map(mngr.get_allocator());
+      const auto elapsed_time = run_parallel(inputs, n, [&map](const auto &kv) {
+        map.try_emplace(kv.first);
+        map.try_emplace(kv.second);
+      });
+      std::cout << "concurrent_unordered_map with Metall (" << n
+                << " threads) took (s)\t" << elapsed_time << std::endl;
+    }
+  }
+
   return 0;
 }
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include <algorithm>
 #include <cstddef>
 #include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 #define METALL_USE_STL_CONTAINERS_IN_ADJLIST 0
 #if METALL_USE_STL_CONTAINERS_IN_ADJLIST
@@ -94,6 +97,63 @@ class multithread_adjacency_list {
     return true;
   }
 
+  /// \brief Adds key-value pairs in a batch. This function is thread-safe.
+  /// The pairs are partitioned by bank with a counting sort and sorted by key
+  /// within each bank in a buffer in the process memory first. Then, each
+  /// bank is locked once and the value list of each key grows at most once.
+  /// \param first The beginning of the pairs of a key and a value to add.
+  /// \param last The end of the pairs to add.
+  /// \return The number of pairs added.
+  template <typename input_iterator>
+  std::size_t add_batch(input_iterator first, input_iterator last) {
+    using pair_type = std::pair<key_type, value_type>;
+    const std::size_t n = std::distance(first, last);
+    if (n == 0) return 0;
+
+    // Counting sort by bank
+    std::vector<std::size_t> offsets(k_num_banks + 1, 0);
+    for (auto itr = first; itr != last; ++itr) {
+      ++offsets[bank_index(itr->first) + 1];
+    }
+    for (std::size_t b = 0; b < k_num_banks; ++b) {
+      offsets[b + 1] += offsets[b];
+    }
+    std::vector<pair_type> buf(n);
+    {
+      std::vector<std::size_t> pos(offsets.begin(), offsets.end() - 1);
+      for (auto itr = first; itr != last; ++itr) {
+        buf[pos[bank_index(itr->first)]++] =
+            pair_type(itr->first, itr->second);
+      }
+    }
+
+    for (std::size_t b = 0; b < k_num_banks; ++b) {
+      const auto bank_begin = buf.begin() + offsets[b];
+      const auto bank_end = buf.begin() + offsets[b + 1];
+      if (bank_begin == bank_end) continue;
+      std::stable_sort(bank_begin, bank_end,
+                       [](const auto &lhs, const auto &rhs) {
+                         return lhs.first < rhs.first;
+                       });
+
+      auto guard = metall::utility::mutex::mutex_lock<k_num_banks>(b);
+      auto &bank = m_bank_table[b];
+      for (auto itr = bank_begin; itr != bank_end;) {
+        auto end = itr;
+        while (end != bank_end && end->first == itr->first) ++end;
+        auto &list = bank[itr->first];
+        // Grow geometrically so that small batches to the same key do not
+        // reallocate the list every time
+        const std::size_t required = list.size() + std::distance(itr, end);
+        if (list.capacity() < required) {
+          list.reserve(std::max(required, list.capacity() * 2));
+        }
+        for (; itr != end; ++itr) list.emplace_back(std::move(itr->second));
+      }
+    }
+    return n;
+  }
+
   std::size_t num_keys() const {
     std::size_t count = 0;
     for (auto &table : m_bank_table) {
@@ -0,0 +1,169 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_GRAPH_ANALYTICS_KERNEL_HPP
+#define METALL_BENCH_GRAPH_ANALYTICS_KERNEL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <metall/utility/open_mp.hpp>
+
+/// \brief Graph analytics kernels that take any graph that has the adjacency
+/// list interface, i.e., num_values(), values_begin(), and values_end(),
+/// such as the adjacency lists built by bench/adjacency_list and
+/// metall::container::csr_graph.
+/// The kernels expect an undirected graph, i.e., each edge is stored in both
+/// directions (the default of bench/adjacency_list).
+/// The vertex IDs must be smaller than 'num_vertices'.
+namespace graph_analytics_bench {
+
+/// \brief Calls 'func(neighbor)' for each neighbor of 'vertex'.
+template <typename graph_type, typename function_type>
+inline void for_each_neighbor(const graph_type &graph,
+                              const typename graph_type::key_type vertex,
+                              const function_type &func) {
+  if (graph.num_values(vertex) == 0) return;
+  for (auto itr = graph.values_begin(vertex), end = graph.values_end(vertex);
+       itr != end; ++itr) {
+    func(*itr);
+  }
+}
+
+/// \brief Runs PageRank in the push style for 'num_iterations' iterations.
+/// The rank of a vertex without an edge is distributed to all vertices.
+/// \return The rank of each vertex. The ranks sum to 1.
+template <typename graph_type>
+std::vector<double> pagerank(const graph_type &graph,
+                             const std::size_t num_vertices,
+                             const std::size_t num_iterations,
+                             const double damping = 0.85) {
+  using vertex_type = typename graph_type::key_type;
+  std::vector<double> rank(num_vertices, 1.0 / num_vertices);
+  std::vector<double> next(num_vertices);
+  std::vector<std::size_t> degree(num_vertices);
+
+  OMP_DIRECTIVE(parallel for schedule (runtime))
+  for (vertex_type v = 0; v < num_vertices; ++v) {
+    degree[v] = graph.num_values(v);
+  }
+
+  for (std::size_t i = 0; i < num_iterations; ++i) {
+    double dangling_sum = 0;
+    OMP_DIRECTIVE(parallel for schedule (runtime) reduction(+:dangling_sum))
+    for (vertex_type v = 0; v < num_vertices; ++v) {
+      next[v] = 0;
+      if (degree[v] == 0) dangling_sum += rank[v];
+    }
+
+    OMP_DIRECTIVE(parallel for schedule (runtime))
+    for (vertex_type v = 0; v < num_vertices; ++v) {
+      if (degree[v] == 0) continue;
+      const double contribution = rank[v] / degree[v];
+      for_each_neighbor(graph, v, [&next, contribution](const auto neighbor) {
+        OMP_DIRECTIVE(atomic)
+        next[neighbor] += contribution;
+      });
+    }
+
+    const double base =
+        (1.0 - damping) / num_vertices + damping * dangling_sum / num_vertices;
+    OMP_DIRECTIVE(parallel for schedule (runtime))
+    for (vertex_type v = 0; v < num_vertices; ++v) {
+      rank[v] = base + damping * next[v];
+    }
+  }
+  return rank;
+}
+
+/// \brief Finds the connected components by label propagation: each vertex
+/// takes the smallest label of its neighbors until no label changes.
+/// \return The label of each vertex, i.e., the smallest vertex ID in its
+/// component.
+template <typename graph_type>
+std::vector<uint64_t> connected_components(const graph_type &graph,
+                                           const std::size_t num_vertices) {
+  using vertex_type = typename graph_type::key_type;
+  std::vector<uint64_t> label(num_vertices);
+  for (std::size_t v = 0; v < num_vertices; ++v) label[v] = v;
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    OMP_DIRECTIVE(parallel for schedule (runtime) reduction(||:changed))
+    for (vertex_type v = 0; v < num_vertices; ++v) {
+      const auto my_label = __atomic_load_n(&label[v], __ATOMIC_RELAXED);
+      for_each_neighbor(graph, v, [&](const auto neighbor) {
+        // Lowers the label of the neighbor to mine
+        auto old = __atomic_load_n(&label[neighbor], __ATOMIC_RELAXED);
+        while (my_label < old) {
+          if (__atomic_compare_exchange_n(&label[neighbor], &old, my_label,
+                                          true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED)) {
+            changed = true;
+            break;
+          }
+        }
+      });
+    }
+  }
+  return label;
+}
+
+/// \brief Returns the number of distinct labels.
+inline std::size_t count_components(const std::vector<uint64_t> &label) {
+  std::size_t count = 0;
+  for (std::size_t v = 0; v < label.size(); ++v) count += (label[v] == v);
+  return count;
+}
+
+/// \brief Counts the triangles, each once as u < v < w.
+/// The neighbor lists do not have to be sorted; duplicate edges and
+/// self-loops are ignored. Each thread holds three arrays of 'num_vertices'
+/// elements to mark the neighbors.
+template <typename graph_type>
+uint64_t count_triangles(const graph_type &graph,
+                         const std::size_t num_vertices) {
+  using vertex_type = typename graph_type::key_type;
+  constexpr uint64_t k_none = std::numeric_limits<uint64_t>::max();
+  uint64_t num_triangles = 0;
+
+  OMP_DIRECTIVE(parallel reduction(+:num_triangles)) {
+    // neighbor_of[x] == u if x is a neighbor of u
+    std::vector<uint64_t> neighbor_of(num_vertices, k_none);
+    // visited_v[v] == u if the edge (u, v) has been processed
+    std::vector<uint64_t> visited_v(num_vertices, k_none);
+    // visited_w[w] == n if w has been counted at the n-th (u, v) edge
+    std::vector<uint64_t> visited_w(num_vertices, k_none);
+    uint64_t num_edges_visited = 0;
+
+    OMP_DIRECTIVE(for schedule (runtime))
+    for (vertex_type u = 0; u < num_vertices; ++u) {
+      for_each_neighbor(graph, u,
+                        [&](const auto x) { neighbor_of[x] = uint64_t(u); });
+
+      for_each_neighbor(graph, u, [&](const auto v) {
+        if (v <= u || visited_v[v] == u) return;
+        visited_v[v] = u;
+        const uint64_t edge_no = num_edges_visited++;
+        for_each_neighbor(graph, v, [&](const auto w) {
+          if (w <= v || neighbor_of[w] != u || visited_w[w] == edge_no) {
+            return;
+          }
+          visited_w[w] = edge_no;
+          ++num_triangles;
+        });
+      });
+    }
+  }
+  return num_triangles;
+}
+
+}  // namespace graph_analytics_bench
+
+#endif  // METALL_BENCH_GRAPH_ANALYTICS_KERNEL_HPP
@@ -0,0 +1,343 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Runs PageRank, connected components, and triangle counting on a
+/// persistent graph to measure the reopen-and-analyze step of the
+/// create-persist-reopen-analyze workflow.
+/// The graph is an adjacency list built by bench/adjacency_list
+/// (run_adj_list_bench_metall) or a CSR graph converted from it; the CSR
+/// graph is built into the same datastore on the first run and reused.
+/// Each kernel is measured in two modes:
+///  cold: evicts the datastore files from the page cache
+///        (posix_fadvise(POSIX_FADV_DONTNEED)), reopens the datastore, and
+///        runs the kernel; the reopen time is reported as open_sec.
+///  warm: runs the kernel on the datastore kept open.
+/// Usage:
+/// ./run_graph_analytics_bench -g datastore path [-k adjacency list name]
+///   [-m max vertex ID (found if 0)] [-K kernels (pagerank,cc,tc)]
+///   [-f formats (adj_list,csr)] [-t #of OpenMP threads (e.g., 1,2,4)]
+///   [-i #of PageRank iterations] [--bench-* harness options]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/csr_graph.hpp>
+#include <metall/detail/time.hpp>
+#include <metall/utility/open_mp.hpp>
+
+#include "../data_structure/multithread_adjacency_list.hpp"
+#include "../utility/bench_harness.hpp"
+#include "kernel.hpp"
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+namespace omp = metall::utility::omp;
+namespace gab = graph_analytics_bench;
+
+using vertex_id_type = uint64_t;
+using adjacency_list_type = data_structure::multithread_adjacency_list<
+    vertex_id_type, vertex_id_type, metall::manager::allocator_type<std::byte>>;
+using csr_graph_type =
+    metall::container::csr_graph<vertex_id_type, uint64_t, false,
+                                 metall::manager::allocator_type<std::byte>>;
+
+struct option_type {
+  std::string datastore_path;
+  std::string graph_key_name{"adj_list"};
+  std::size_t max_vertex_id{0};
+  std::vector<std::string> kernels{"pagerank", "cc", "tc"};
+  std::vector<std::string> formats{"adj_list", "csr"};
+  std::vector<int> num_threads_list;
+  std::size_t num_pagerank_iterations{20};
+};
+
+std::vector<std::string> split(const std::string &str) {
+  std::vector<std::string> list;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) list.push_back(item);
+  return list;
+}
+
+bool parse_option(int argc, char **argv, option_type *option) {
+  int p;
+  while ((p = ::getopt(argc, argv, "g:k:m:K:f:t:i:")) != -1) {
+    switch (p) {
+      case 'g':
+        option->datastore_path = optarg;
+        break;
+      case 'k':
+        option->graph_key_name = optarg;
+        break;
+      case 'm':
+        option->max_vertex_id = std::stoull(optarg);
+        break;
+      case 'K':
+        option->kernels = split(optarg);
+        break;
+      case 'f':
+        option->formats = split(optarg);
+        break;
+      case 't':
+        option->num_threads_list.clear();
+        for (const auto &n : split(optarg)) {
+          option->num_threads_list.push_back(std::stoi(n));
+        }
+        break;
+      case 'i':
+        option->num_pagerank_iterations = std::stoull(optarg);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        return false;
+    }
+  }
+  if (option->datastore_path.empty()) {
+    std::cerr << "Datastore path is required" << std::endl;
+    return false;
+  }
+  if (option->num_threads_list.empty()) {
+    option->num_threads_list.push_back(1);
+    const int n = std::thread::hardware_concurrency();
+    if (n > 1) option->num_threads_list.push_back(n);
+  }
+  return true;
+}
+
+/// \brief The edges of an adjacency list as a range of (source, destination)
+/// pairs, to build a CSR graph from it.
+class adjacency_list_edges {
+ public:
+  class iterator {
+   public:
+    using key_iterator = adjacency_list_type::const_key_iterator;
+    using value_iterator = adjacency_list_type::const_value_iterator;
+
+    iterator(const adjacency_list_type *graph, key_iterator key,
+             key_iterator key_end)
+        : m_graph(graph), m_key(key), m_key_end(key_end) {
+      priv_skip_empty_keys();
+    }
+
+    // Not const as the key iterator of the adjacency list is not
+    std::pair<vertex_id_type, vertex_id_type> operator*() {
+      return {m_key->first, *m_value};
+    }
+
+    iterator &operator++() {
+      if (++m_value == m_value_end) {
+        ++m_key;
+        priv_skip_empty_keys();
+      }
+      return *this;
+    }
+
+    bool operator!=(iterator &other) {
+      return m_key != other.m_key ||
+             (m_key != m_key_end && m_value != other.m_value);
+    }
+
+   private:
+    void priv_skip_empty_keys() {
+      for (; m_key != m_key_end; ++m_key) {
+        if (m_graph->num_values(m_key->first) == 0) continue;
+        m_value = m_graph->values_begin(m_key->first);
+        m_value_end = m_graph->values_end(m_key->first);
+        return;
+      }
+    }
+
+    const adjacency_list_type *m_graph;
+    key_iterator m_key;
+    key_iterator m_key_end;
+    value_iterator m_value{};
+    value_iterator m_value_end{};
+  };
+
+  explicit adjacency_list_edges(const adjacency_list_type *graph)
+      : m_graph(graph) {}
+
+  iterator begin() const {
+    return iterator(m_graph, m_graph->keys_begin(), m_graph->keys_end());
+  }
+  iterator end() const {
+    return iterator(m_graph, m_graph->keys_end(), m_graph->keys_end());
+  }
+
+ private:
+  const adjacency_list_type *m_graph;
+};
+
+/// \brief Evicts the (clean) pages of the datastore files from the page
+/// cache. This is a best effort; the pages mapped by other processes stay.
+void evict_page_cache(const fs::path &path) {
+  std::error_code ec;
+  for (const auto &entry : fs::recursive_directory_iterator(path, ec)) {
+    if (!entry.is_regular_file()) continue;
+    const int fd = ::open(entry.path().c_str(), O_RDONLY);
+    if (fd < 0) continue;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+template <typename graph_type>
+std::size_t find_max_id(const graph_type &graph) {
+  std::size_t max_id = 0;
+  for (auto itr = graph.keys_begin(), end = graph.keys_end(); itr != end;
+       ++itr) {
+    max_id = std::max<std::size_t>(max_id, itr->first);
+    gab::for_each_neighbor(graph, itr->first, [&max_id](const auto v) {
+      max_id = std::max<std::size_t>(max_id, v);
+    });
+  }
+  return max_id;
+}
+
+/// \brief Runs a kernel and returns its result as a number to report.
+template <typename graph_type>
+double run_kernel(const std::string &kernel, const graph_type &graph,
+                  const std::size_t num_vertices, const option_type &option) {
+  if (kernel == "pagerank") {
+    const auto rank =
+        gab::pagerank(graph, num_vertices, option.num_pagerank_iterations);
+    return *std::max_element(rank.begin(), rank.end());
+  } else if (kernel == "cc") {
+    return double(gab::count_components(
+        gab::connected_components(graph, num_vertices)));
+  } else if (kernel == "tc") {
+    return double(gab::count_triangles(graph, num_vertices));
+  }
+  std::cerr << "Unknown kernel: " << kernel << std::endl;
+  std::abort();
+}
+
+/// \brief Builds the CSR graph from the adjacency list if it does not exist
+/// in the datastore.
+void prepare_csr_graph(const option_type &option,
+                       bench_utility::bench_harness &harness) {
+  metall::manager manager(metall::open_only, option.datastore_path.c_str());
+  const auto csr_name = option.graph_key_name + "_csr";
+  if (manager.find<csr_graph_type>(csr_name.c_str()).first) return;
+
+  const auto *const adj_list =
+      manager.find<adjacency_list_type>(option.graph_key_name.c_str()).first;
+  if (!adj_list) {
+    std::cerr << "Cannot find " << option.graph_key_name << std::endl;
+    std::abort();
+  }
+  std::cerr << "Building a CSR graph" << std::endl;
+  const auto start = mdtl::elapsed_time_sec();
+  auto *const csr = manager.construct<csr_graph_type>(csr_name.c_str())(
+      manager.get_allocator());
+  std::vector<adjacency_list_edges> edge_lists{adjacency_list_edges(adj_list)};
+  // build() finds the max ID if 0 is given
+  csr->build(edge_lists,
+             option.max_vertex_id > 0 ? option.max_vertex_id + 1 : 0);
+  manager.flush();
+  harness.set_metric("build_csr", {}, "sec", mdtl::elapsed_time_sec(start));
+  harness.set_metric("build_csr", {}, "num_edges", double(csr->num_edges()));
+}
+
+template <typename graph_type>
+void measure(const std::string &format, const std::string &graph_name,
+             option_type option, bench_utility::bench_harness &harness) {
+  std::unique_ptr<metall::manager> manager;
+  const graph_type *graph = nullptr;
+  const auto open = [&]() {
+    manager.reset();
+    manager = std::make_unique<metall::manager>(metall::open_read_only,
+                                                option.datastore_path.c_str());
+    graph = manager->find<graph_type>(graph_name.c_str()).first;
+    if (!graph) {
+      std::cerr << "Cannot find " << graph_name << std::endl;
+      std::abort();
+    }
+  };
+
+  open();
+  if (option.max_vertex_id == 0) {
+    option.max_vertex_id = find_max_id(*graph);
+    std::cerr << "Max vertex ID: " << option.max_vertex_id << std::endl;
+  }
+  const std::size_t num_vertices = option.max_vertex_id + 1;
+
+  for (const auto &kernel : option.kernels) {
+    for (const int num_threads : option.num_threads_list) {
+      omp::set_num_threads(num_threads);
+      std::cerr << kernel << " on " << format << " with " << num_threads
+                << " threads" << std::endl;
+      bench_utility::bench_harness::param_list params{
+          {"format", format},
+          {"num_vertices", std::to_string(num_vertices)},
+          {"num_threads", std::to_string(num_threads)}};
+      double result = 0;
+
+      params.emplace_back("mode", "cold");
+      double open_sec_sum = 0;
+      for (int r = 0; r < harness.num_runs(); ++r) {
+        manager.reset();
+        evict_page_cache(option.datastore_path);
+        const auto open_start = mdtl::elapsed_time_sec();
+        open();
+        const auto open_sec = mdtl::elapsed_time_sec(open_start);
+        if (r >= harness.num_warmups()) open_sec_sum += open_sec;
+
+        const auto start = mdtl::elapsed_time_sec();
+        result = run_kernel(kernel, *graph, num_vertices, option);
+        harness.add_sample(kernel, params, mdtl::elapsed_time_sec(start));
+      }
+      harness.set_metric(kernel, params, "open_sec",
+                         open_sec_sum / harness.num_repetitions());
+      harness.set_metric(kernel, params, "result", result);
+
+      params.back().second = "warm";
+      harness.run(kernel, params, [&]() {
+        result = run_kernel(kernel, *graph, num_vertices, option);
+      });
+      harness.set_metric(kernel, params, "result", result);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("graph_analytics", argc, argv);
+  option_type option;
+  if (!parse_option(argc, argv, &option)) {
+    return EXIT_FAILURE;
+  }
+  harness.set_backend("metall");
+  harness.set_datastore_path(option.datastore_path);
+
+  for (const auto &format : option.formats) {
+    if (format == "adj_list") {
+      measure<adjacency_list_type>(format, option.graph_key_name, option,
+                                   harness);
+    } else if (format == "csr") {
+      prepare_csr_graph(option, harness);
+      measure<csr_graph_type>(format, option.graph_key_name + "_csr", option,
+                              harness);
+    } else {
+      std::cerr << "Unknown format: " << format << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,325 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Measures the costs of the datastore lifecycle: open_only,
+/// open_read_only, flush, close, snapshot (clone and copy), and copy (clone
+/// and copy), for datastores of the given sizes.
+/// Each result has the time spent in each phase as the metrics:
+/// serializing and deserializing the management data, mapping the segment,
+/// syncing (msync) the segment, and copying the segment files.
+/// The phases are taken from the tracepoints (METALL_USE_TRACEPOINTS);
+/// they can overlap, e.g., the management data is deserialized while the
+/// segment is mapped, and a snapshot syncs the segment before copying it.
+/// Usage:
+/// ./run_lifecycle_bench [-o datastore path] [-s sizes (e.g., 1g,16g,2t)]
+///   [-b bulk object size] [-n #of named objects] [-a #of anonymous objects]
+///   [-f fraction of the bulk objects freed to fragment the chunks]
+///   [-w fraction of the bulk objects rewritten before flush and close]
+///   [--bench-* harness options]
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/time.hpp>
+
+#include "../utility/bench_harness.hpp"
+#include "../simple_alloc/size_mix_kernel.hpp"
+
+namespace {
+
+using bulk_object_list =
+    metall::container::vector<metall::offset_ptr<std::byte>>;
+constexpr const char *k_bulk_object_list_name = "bulk_objects";
+
+struct option_type {
+  std::string datastore_path{"/tmp/datastore"};
+  std::vector<std::size_t> sizes{1ULL << 30ULL};
+  std::size_t bulk_object_size = 1ULL << 16ULL;
+  std::size_t num_named_objects = 10000;
+  std::size_t num_anonymous_objects = 10000;
+  double fragmentation = 0.25;
+  double write_ratio = 0.1;
+};
+
+/// \brief Parses a size with an optional suffix, k, m, g, or t.
+std::size_t parse_size(const std::string &str) {
+  std::size_t pos = 0;
+  const auto value = std::stold(str, &pos);
+  const char suffix = (pos < str.size()) ? std::tolower(str[pos]) : 0;
+  const std::string units = "kmgt";
+  const auto u = units.find(suffix);
+  return value * ((u == std::string::npos) ? 1 : 1ULL << (10 * (u + 1)));
+}
+
+option_type parse_option(int argc, char **argv) {
+  option_type option;
+  int p;
+  while ((p = ::getopt(argc, argv, "o:s:b:n:a:f:w:")) != -1) {
+    switch (p) {
+      case 'o':
+        option.datastore_path = optarg;
+        break;
+      case 's': {
+        option.sizes.clear();
+        std::stringstream ss(optarg);
+        std::string size;
+        while (std::getline(ss, size, ',')) {
+          option.sizes.push_back(parse_size(size));
+        }
+        break;
+      }
+      case 'b':
+        option.bulk_object_size = parse_size(optarg);
+        break;
+      case 'n':
+        option.num_named_objects = std::stoll(optarg);
+        break;
+      case 'a':
+        option.num_anonymous_objects = std::stoll(optarg);
+        break;
+      case 'f':
+        option.fragmentation = std::stod(optarg);
+        break;
+      case 'w':
+        option.write_ratio = std::stod(optarg);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  return option;
+}
+
+/// \brief Accumulates the time spent between the begin and end tracepoints
+/// of each phase.
+class phase_timer {
+ public:
+  enum phase : int { serialize, deserialize, map, sync, copy, num_phases };
+  static constexpr const char *k_names[] = {
+      "serialize_sec", "deserialize_sec", "map_sec", "sync_sec",
+      "segment_copy_sec"};
+
+  static void callback(const metall::tracing::event e, uint64_t, uint64_t) {
+    using event = metall::tracing::event;
+    switch (e) {
+      case event::management_data_serialize_begin:
+        return priv_begin(serialize);
+      case event::management_data_serialize_end:
+        return priv_end(serialize);
+      case event::management_data_deserialize_begin:
+        return priv_begin(deserialize);
+      case event::management_data_deserialize_end:
+        return priv_end(deserialize);
+      case event::segment_map_begin:
+        return priv_begin(map);
+      case event::segment_map_end:
+        return priv_end(map);
+      case event::sync_begin:
+        return priv_begin(sync);
+      case event::sync_end:
+        return priv_end(sync);
+      case event::segment_copy_begin:
+        return priv_begin(copy);
+      case event::segment_copy_end:
+        return priv_end(copy);
+      default:
+        return;
+    }
+  }
+
+  static void reset() {
+    for (auto &t : s_total_ns) t.store(0);
+  }
+
+  static double total_sec(const phase p) {
+    return double(s_total_ns[p].load()) / 1e9;
+  }
+
+ private:
+  static uint64_t priv_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  static void priv_begin(const phase p) { s_begin_ns[p].store(priv_now_ns()); }
+  static void priv_end(const phase p) {
+    s_total_ns[p].fetch_add(priv_now_ns() - s_begin_ns[p].load());
+  }
+
+  static inline std::atomic<uint64_t> s_begin_ns[num_phases]{};
+  static inline std::atomic<uint64_t> s_total_ns[num_phases]{};
+};
+
+/// \brief Builds a datastore that has about 'size' bytes of bulk objects,
+/// frees a fraction of them, and adds named and anonymous objects.
+void build_datastore(const option_type &option, const std::size_t size) {
+  metall::manager::remove(option.datastore_path.c_str());
+  metall::manager manager(metall::create_only, option.datastore_path.c_str());
+
+  auto *const objects = manager.construct<bulk_object_list>(
+      k_bulk_object_list_name)(manager.get_allocator());
+  const std::size_t num_objects =
+      std::max<std::size_t>(size / option.bulk_object_size, 1);
+  objects->reserve(num_objects);
+  for (std::size_t i = 0; i < num_objects; ++i) {
+    auto *const addr =
+        static_cast<std::byte *>(manager.allocate(option.bulk_object_size));
+    if (!addr) {
+      std::cerr << "Failed to allocate bulk objects" << std::endl;
+      std::abort();
+    }
+    std::memset(addr, int(i), option.bulk_object_size);
+    objects->emplace_back(addr);
+  }
+
+  // Frees random objects, leaving holes in the chunks
+  std::mt19937_64 rand(123);
+  std::shuffle(objects->begin(), objects->end(), rand);
+  const auto num_freed = std::size_t(num_objects * option.fragmentation);
+  for (std::size_t i = 0; i < num_freed; ++i) {
+    manager.deallocate(metall::to_raw_pointer(objects->back()));
+    objects->pop_back();
+  }
+
+  for (std::size_t i = 0; i < option.num_named_objects; ++i) {
+    manager.construct<uint64_t>(("named_" + std::to_string(i)).c_str())(i);
+  }
+  for (std::size_t i = 0; i < option.num_anonymous_objects; ++i) {
+    manager.construct<uint64_t>(metall::anonymous_instance)(i);
+  }
+}
+
+/// \brief Rewrites a fraction of the bulk objects to make dirty pages.
+void write_objects(metall::manager &manager, const option_type &option) {
+  auto *const objects =
+      manager.find<bulk_object_list>(k_bulk_object_list_name).first;
+  const auto n = std::size_t(objects->size() * option.write_ratio);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::memset(metall::to_raw_pointer((*objects)[i]), int(i + 1),
+                option.bulk_object_size);
+  }
+}
+
+/// \brief Measures 'op' harness.num_runs() times and sets the mean time of
+/// each phase (excluding the warmup runs) as the metrics.
+template <typename prepare_function, typename op_function,
+          typename cleanup_function>
+void measure(bench_utility::bench_harness &harness, const std::string &name,
+             const bench_utility::bench_harness::param_list &params,
+             prepare_function prepare, op_function op,
+             cleanup_function cleanup) {
+  std::cerr << name << std::endl;
+  double phase_sums[phase_timer::num_phases]{};
+  int num_measured = 0;
+  for (int r = 0; r < harness.num_runs(); ++r) {
+    prepare();
+    phase_timer::reset();
+    const auto start = metall::mtlldetail::elapsed_time_sec();
+    op();
+    harness.add_sample(name, params,
+                       metall::mtlldetail::elapsed_time_sec(start));
+    if (r >= harness.num_warmups()) {
+      for (int p = 0; p < phase_timer::num_phases; ++p) {
+        phase_sums[p] += phase_timer::total_sec(phase_timer::phase(p));
+      }
+      ++num_measured;
+    }
+    cleanup();
+  }
+  for (int p = 0; p < phase_timer::num_phases; ++p) {
+    harness.set_metric(name, params, phase_timer::k_names[p],
+                       num_measured ? phase_sums[p] / num_measured : 0.0);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("lifecycle", argc, argv);
+  const auto option = parse_option(argc, argv);
+  harness.set_backend("metall");
+  harness.set_datastore_path(option.datastore_path);
+  metall::tracing::set_callback(phase_timer::callback);
+
+  const auto &path = option.datastore_path;
+  const auto copy_path = path + "_copy";
+  std::unique_ptr<metall::manager> manager;
+  const auto nop = []() {};
+  const auto open = [&]() {
+    manager = std::make_unique<metall::manager>(metall::open_only,
+                                                path.c_str());
+  };
+  const auto close = [&]() { manager.reset(); };
+  const auto open_and_write = [&]() {
+    open();
+    write_objects(*manager, option);
+  };
+  const auto remove_copy = [&]() {
+    close();
+    metall::manager::remove(copy_path.c_str());
+  };
+
+  for (const auto size : option.sizes) {
+    std::cerr << "Building a datastore of " << size << " bytes" << std::endl;
+    build_datastore(option, size);
+    const bench_utility::bench_harness::param_list params{
+        {"size", std::to_string(size)},
+        {"bulk_object_size", std::to_string(option.bulk_object_size)},
+        {"num_named_objects", std::to_string(option.num_named_objects)},
+        {"num_anonymous_objects", std::to_string(option.num_anonymous_objects)},
+        {"fragmentation", std::to_string(option.fragmentation)},
+        {"write_ratio", std::to_string(option.write_ratio)}};
+
+    measure(harness, "open_only", params, nop, open, close);
+    measure(
+        harness, "open_read_only", params, nop,
+        [&]() {
+          manager = std::make_unique<metall::manager>(metall::open_read_only,
+                                                      path.c_str());
+        },
+        close);
+    measure(
+        harness, "flush", params, open_and_write, [&]() { manager->flush(); },
+        close);
+    measure(harness, "close", params, open_and_write, close, nop);
+    measure(
+        harness, "snapshot_clone", params, open,
+        [&]() { manager->snapshot(copy_path.c_str(), true); }, remove_copy);
+    measure(
+        harness, "snapshot_copy", params, open,
+        [&]() { manager->snapshot(copy_path.c_str(), false); }, remove_copy);
+    measure(
+        harness, "copy_clone", params, nop,
+        [&]() { metall::manager::copy(path.c_str(), copy_path.c_str(), true); },
+        remove_copy);
+    measure(
+        harness, "copy", params, nop,
+        [&]() {
+          metall::manager::copy(path.c_str(), copy_path.c_str(), false);
+        },
+        remove_copy);
+
+    for (const auto &name : {"open_only", "close"}) {
+      harness.set_metric(name, params, "file_space_bytes",
+                         double(size_mix_bench::get_file_space(path)));
+    }
+    metall::manager::remove(path.c_str());
+  }
+
+  return 0;
+}
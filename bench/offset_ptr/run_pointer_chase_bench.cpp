@@ -0,0 +1,84 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Benchmarks pointer chasing with the raw pointer, offset_ptr, and
+/// segment_relative_ptr stored in a datastore opened with the read-only mode.
+/// Usage:
+/// ./run_pointer_chase_bench [datastore path]
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/segment_relative_ptr.hpp>
+#include <metall/detail/time.hpp>
+
+namespace mdtl = metall::mtlldetail;
+
+struct node {
+  uint64_t value;
+  node *raw_next;
+  metall::offset_ptr<node> offset_next;
+  metall::segment_relative_ptr<node> relative_next;
+};
+
+template <typename next_ptr_getter>
+void chase(const char *const name, const node *const head,
+           next_ptr_getter get_next) {
+  const auto start = mdtl::elapsed_time_sec();
+  uint64_t sum = 0;
+  for (const node *n = head; n; n = get_next(n)) sum += n->value;
+  const auto elapsed_time = mdtl::elapsed_time_sec(start);
+  std::cout << name << " took (s)\t" << elapsed_time << "\t(sum " << sum
+            << ")" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  const char *const path = (argc > 1) ? argv[1] : "/tmp/pointer_chase_bench";
+  const std::size_t length = 1ULL << 22;
+
+  {
+    metall::manager manager(metall::create_only, path);
+    metall::set_segment_relative_ptr_base(manager.get_address());
+    auto *const nodes = manager.construct<node>("nodes")[length]();
+
+    // Links the nodes in a random order to defeat the hardware prefetcher
+    std::vector<std::size_t> order(length);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin() + 1, order.end(), std::mt19937_64(123));
+    for (std::size_t i = 0; i < length; ++i) {
+      auto &n = nodes[order[i]];
+      n.value = i;
+      node *const next = (i + 1 < length) ? &nodes[order[i + 1]] : nullptr;
+      n.offset_next = next;
+      n.relative_next = next;
+    }
+  }
+  std::cout << "Initialized list, length = " << length << std::endl;
+
+  metall::manager manager(metall::open_read_only, path);
+  metall::set_segment_relative_ptr_base(manager.get_address());
+  const node *const head = manager.find<node>("nodes").first;
+
+  // Raw pointers are valid only in this mapping; uses a copy in DRAM
+  const auto *const nodes = head;
+  std::vector<node> raw_nodes(nodes, nodes + length);
+  for (std::size_t i = 0; i < length; ++i) {
+    const node *const next = nodes[i].offset_next.get();
+    raw_nodes[i].raw_next = next ? &raw_nodes[next - nodes] : nullptr;
+  }
+
+  chase("Raw pointer", raw_nodes.data(),
+        [](const node *n) { return n->raw_next; });
+  chase("Offset pointer", head,
+        [](const node *n) { return n->offset_next.get(); });
+  chase("Segment relative pointer", head,
+        [](const node *n) { return n->relative_next.get(); });
+
+  return 0;
+}
@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <random>
+#include <vector>
 #include <boost/random/mersenne_twister.hpp>
 #include <metall/utility/random.hpp>
 #include <metall/detail/time.hpp>
@@ -20,6 +21,28 @@ auto run_bench(const uint64_t num_generate) {
   return t;
 }
 
+template <typename rand_engine_type>
+auto run_fill_bench(const uint64_t num_generate) {
+  rand_engine_type rand_engine(123);
+  std::vector<uint64_t> buf(num_generate);
+  const auto s = metall::mtlldetail::elapsed_time_sec();
+  rand_engine.fill(buf.data(), buf.size());
+  const auto t = metall::mtlldetail::elapsed_time_sec(s);
+  [[maybe_unused]] volatile const uint64_t x = buf.back();
+  return t;
+}
+
+template <typename rand_engine_type>
+auto run_fill_parallel_bench(const uint64_t num_generate) {
+  const rand_engine_type rand_engine(123);
+  std::vector<uint64_t> buf(num_generate);
+  const auto s = metall::mtlldetail::elapsed_time_sec();
+  metall::utility::fill_parallel(rand_engine, buf.data(), buf.size());
+  const auto t = metall::mtlldetail::elapsed_time_sec(s);
+  [[maybe_unused]] volatile const uint64_t x = buf.back();
+  return t;
+}
+
 int main() {
   const uint64_t num_generate = (1ULL << 20ULL);
   std::cout << "Generate " << num_generate << " values" << std::endl;
@@ -33,5 +56,26 @@ int main() {
   std::cout << "xoshiro1024++    \t"
             << run_bench<metall::utility::rand_1024>(num_generate) << std::endl;
 
+  std::cout << "\nGenerate by fill()" << std::endl;
+  std::cout << "xoshiro512++     \t"
+            << run_fill_bench<metall::utility::rand_512>(num_generate)
+            << std::endl;
+  std::cout << "xoshiro1024++    \t"
+            << run_fill_bench<metall::utility::rand_1024>(num_generate)
+            << std::endl;
+  std::cout << "xoshiro512++ x4  \t"
+            << run_fill_bench<metall::utility::rand_512x4>(num_generate)
+            << std::endl;
+  std::cout << "xoshiro512++ x8  \t"
+            << run_fill_bench<metall::utility::rand_512x8>(num_generate)
+            << std::endl;
+
+  std::cout << "\nGenerate " << num_generate * 16
+            << " values by fill_parallel()" << std::endl;
+  std::cout << "xoshiro512++ x4  \t"
+            << run_fill_parallel_bench<metall::utility::rand_512x4>(
+                   num_generate * 16)
+            << std::endl;
+
   return 0;
 }
@@ -17,9 +17,12 @@
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <metall/detail/time.hpp>
 #include <metall/detail/utilities.hpp>
 
+#include "../utility/bench_harness.hpp"
+
 namespace simple_alloc_bench {
 
 namespace {
@@ -31,12 +34,15 @@ struct option_type {
   std::vector<std::size_t> size_list{8, 4096};
   std::string datastore_path{"/tmp/datastore"};
   bool run_parallel_bench = false;
+  // If not zero, measures the allocation throughput with 1, 2, 4, ...,
+  // max_num_threads threads
+  std::size_t max_num_threads = 0;
 };
 
 option_type parse_option(int argc, char **argv) {
   int p;
   option_type option;
-  while ((p = ::getopt(argc, argv, "o:n:p")) != -1) {
+  while ((p = ::getopt(argc, argv, "o:n:pt:")) != -1) {
     switch (p) {
       case 'o':
         option.datastore_path = optarg;
@@ -50,6 +56,10 @@ option_type parse_option(int argc, char **argv) {
         option.run_parallel_bench = true;
         break;
 
+      case 't':
+        option.max_num_threads = std::stoll(optarg);
+        break;
+
       default:
         std::cerr << "Invalid option" << std::endl;
         std::abort();
@@ -105,15 +115,15 @@ template <typename byte_allocator_type>
 void allocate_parallel(
     byte_allocator_type byte_allocator,
     const std::vector<std::size_t> &size_list,
-    std::vector<typename byte_allocator_type::pointer> *allocated_addr_list) {
+    std::vector<typename byte_allocator_type::pointer> *allocated_addr_list,
+    const std::size_t num_threads = std::thread::hardware_concurrency()) {
   static_assert(
       std::is_same<
           typename std::allocator_traits<byte_allocator_type>::value_type,
           std::byte>::value,
       "The value_type of byte_allocator_type must be std::byte");
 
-  std::vector<std::thread *> threads(std::thread::hardware_concurrency(),
-                                     nullptr);
+  std::vector<std::thread *> threads(num_threads, nullptr);
   for (std::size_t t = 0; t < threads.size(); ++t) {
     const auto range =
         metall::mtlldetail::partial_range(size_list.size(), t, threads.size());
@@ -136,6 +146,7 @@ void allocate_parallel(
 
   for (auto thread : threads) {
     thread->join();
+    delete thread;
   }
 }
 
@@ -144,15 +155,15 @@ void deallocate_parallel(
     byte_allocator_type byte_allocator,
     const std::vector<std::size_t> &size_list,
     const std::vector<typename byte_allocator_type::pointer>
-        &allocated_addr_list) {
+        &allocated_addr_list,
+    const std::size_t num_threads = std::thread::hardware_concurrency()) {
   static_assert(
       std::is_same<
           typename std::allocator_traits<byte_allocator_type>::value_type,
           std::byte>::value,
       "The value_type of byte_allocator_type must be std::byte");
 
-  std::vector<std::thread *> threads(std::thread::hardware_concurrency(),
-                                     nullptr);
+  std::vector<std::thread *> threads(num_threads, nullptr);
   for (std::size_t t = 0; t < threads.size(); ++t) {
     const auto range =
         metall::mtlldetail::partial_range(size_list.size(), t, threads.size());
@@ -171,48 +182,77 @@ void deallocate_parallel(
 
   for (auto thread : threads) {
     thread->join();
+    delete thread;
   }
 }
 
+/// \brief Measures allocation and deallocation in turn harness.num_runs()
+/// times and records them as '<name>/allocation' and '<name>/deallocation'.
 template <typename alloc_function, typename dealloc_function>
-void measure_time(const int num_runs, alloc_function alloc_func,
-                  dealloc_function dealloc_func) {
-  std::vector<double> alloc_times(num_runs, 0.0);
-  std::vector<double> dealloc_times(num_runs, 0.0);
-  for (int i = 0; i < num_runs; ++i) {
+void measure_time(bench_utility::bench_harness &harness,
+                  const std::string &name,
+                  const bench_utility::bench_harness::param_list &params,
+                  alloc_function alloc_func, dealloc_function dealloc_func) {
+  for (int i = 0; i < harness.num_runs(); ++i) {
     {
       const auto start = mdtl::elapsed_time_sec();
       alloc_func();
-      const auto elapsed_time = mdtl::elapsed_time_sec(start);
-      alloc_times[i] = elapsed_time;
+      harness.add_sample(name + "/allocation", params,
+                         mdtl::elapsed_time_sec(start));
     }
     {
       const auto start = mdtl::elapsed_time_sec();
       dealloc_func();
-      const auto elapsed_time = mdtl::elapsed_time_sec(start);
-      dealloc_times[i] = elapsed_time;
+      harness.add_sample(name + "/deallocation", params,
+                         mdtl::elapsed_time_sec(start));
     }
   }
+}
+
+/// \brief Measures the allocation and deallocation throughput changing the
+/// number of threads to show the scaling curve.
+template <typename allocator_type>
+void run_scaling_bench(const option_type &option,
+                       const allocator_type allocator,
+                       bench_utility::bench_harness &harness) {
+  using byte_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<std::byte>;
+  byte_allocator_type byte_allocator(allocator);
 
-  auto print_results = [](std::vector<double> &times) {
-    std::sort(times.begin(), times.end());
-    std::cout << "Min\t" << times[0] << std::endl;
-    const double median =
-        (times.size() % 2)
-            ? (times[times.size() / 2 - 1] + times[times.size() / 2])
-            : times[times.size() / 2];
-    std::cout << "Median\t" << median << std::endl;
-    std::cout << "Max\t" << times[times.size() - 1] << std::endl;
-  };
-
-  std::cout << "Allocation time (s)" << std::endl;
-  print_results(alloc_times);
-  std::cout << "\nDeallocation time (s)" << std::endl;
-  print_results(dealloc_times);
+  std::vector<typename byte_allocator_type::pointer> allocated_addr_list(
+      option.num_allocations);
+
+  std::vector<std::size_t> num_threads_list;
+  for (std::size_t n = 1; n < option.max_num_threads; n *= 2) {
+    num_threads_list.push_back(n);
+  }
+  num_threads_list.push_back(option.max_num_threads);
+
+  for (const auto size : option.size_list) {
+    std::cerr << "Throughput scaling with " << size << " byte" << std::endl;
+    const std::vector<std::size_t> allocation_request_list(
+        option.num_allocations, size);
+    for (const auto num_threads : num_threads_list) {
+      measure_time(
+          harness, "scaling",
+          {{"size", std::to_string(size)},
+           {"num_allocations", std::to_string(option.num_allocations)},
+           {"num_threads", std::to_string(num_threads)}},
+          [&]() {
+            allocate_parallel(byte_allocator, allocation_request_list,
+                              &allocated_addr_list, num_threads);
+          },
+          [&]() {
+            deallocate_parallel(byte_allocator, allocation_request_list,
+                                allocated_addr_list, num_threads);
+          });
+    }
+  }
 }
 
 template <typename allocator_type>
-void run_bench(const option_type &option, const allocator_type allocator) {
+void run_bench(const option_type &option, const allocator_type allocator,
+               bench_utility::bench_harness &harness) {
   using byte_allocator_type = typename std::allocator_traits<
       allocator_type>::template rebind_alloc<std::byte>;
   byte_allocator_type byte_allocator(allocator);
@@ -221,20 +261,19 @@ void run_bench(const option_type &option, const allocator_type allocator) {
   std::vector<typename byte_allocator_type::pointer> allocated_addr_list(
       option.num_allocations);
 
-  std::cout << std::fixed;
-  std::cout << std::setprecision(2);
-
   for (std::size_t i = 0; i < option.size_list.size() + 1; ++i) {
+    std::string size_name;
     if (i < option.size_list.size()) {
-      std::cout << "\n----- Allocation/deallocation with "
-                << option.size_list[i] << " byte -----" << std::endl;
+      size_name = std::to_string(option.size_list[i]);
+      std::cerr << "Allocation/deallocation with " << size_name << " byte"
+                << std::endl;
       std::fill(allocation_request_list.begin(), allocation_request_list.end(),
                 option.size_list[i]);
       std::fill(allocated_addr_list.begin(), allocated_addr_list.end(),
                 nullptr);
     } else {
-      std::cout << "\n----- Allocation/deallocation with mixed sizes -----"
-                << std::endl;
+      size_name = "mixed";
+      std::cerr << "Allocation/deallocation with mixed sizes" << std::endl;
       std::mt19937_64 rand(
           std::chrono::system_clock::now().time_since_epoch().count());
       std::uniform_int_distribution<> dist(0, option.size_list.size() - 1);
@@ -243,9 +282,11 @@ void run_bench(const option_type &option, const allocator_type allocator) {
       }
     }
 
-    std::cout << "[Sequential]" << std::endl;
+    const bench_utility::bench_harness::param_list params{
+        {"size", size_name},
+        {"num_allocations", std::to_string(option.num_allocations)}};
     measure_time(
-        10,
+        harness, "sequential", params,
         [byte_allocator, &allocation_request_list, &allocated_addr_list]() {
           allocate_sequential(byte_allocator, allocation_request_list,
                               &allocated_addr_list);
@@ -257,10 +298,11 @@ void run_bench(const option_type &option, const allocator_type allocator) {
 
     if (!option.run_parallel_bench) continue;
 
-    std::cout << "\n[Parallel with " << std::thread::hardware_concurrency()
-              << " threads ]" << std::endl;
+    auto parallel_params = params;
+    parallel_params.emplace_back(
+        "num_threads", std::to_string(std::thread::hardware_concurrency()));
     measure_time(
-        10,
+        harness, "parallel", parallel_params,
         [byte_allocator, &allocation_request_list, &allocated_addr_list]() {
           allocate_parallel(byte_allocator, allocation_request_list,
                             &allocated_addr_list);
@@ -270,6 +312,10 @@ void run_bench(const option_type &option, const allocator_type allocator) {
                               allocated_addr_list);
         });
   }
+
+  if (option.max_num_threads > 0) {
+    run_scaling_bench(option, allocator, harness);
+  }
 }
 
 }  // namespace simple_alloc_bench
@@ -1,14 +1,27 @@
 #!/usr/bin/env bash
 
 NUM_ALLOCS=1000000
+MAX_NUM_THREADS=$(nproc)
 FILE="/tmp/segment"
 LOG_FILE_PREFIX="out_simple_allocation_bench_"
+# text, csv, or json
+FORMAT=${FORMAT:-text}
+HARNESS_OPTS="--bench-format=${FORMAT} --bench-repetitions=10"
 
 rm -rf ${FILE}*
-./run_simple_allocation_bench_stl -n ${NUM_ALLOCS} | tee ${LOG_FILE_PREFIX}"stl.log"
+./run_simple_allocation_bench_stl ${HARNESS_OPTS} -n ${NUM_ALLOCS} | tee ${LOG_FILE_PREFIX}"stl.log"
 
 rm -rf ${FILE}*
-./run_simple_allocation_bench_bip -n ${NUM_ALLOCS} -o ${FILE} | tee ${LOG_FILE_PREFIX}"bip.log"
+./run_simple_allocation_bench_bip ${HARNESS_OPTS} -n ${NUM_ALLOCS} -o ${FILE} | tee ${LOG_FILE_PREFIX}"bip.log"
 
 rm -rf ${FILE}*
-./run_simple_allocation_bench_metall -n ${NUM_ALLOCS} -o ${FILE} | tee ${LOG_FILE_PREFIX}"metall.log"
\ No newline at end of file
+./run_simple_allocation_bench_metall ${HARNESS_OPTS} -n ${NUM_ALLOCS} -o ${FILE} | tee ${LOG_FILE_PREFIX}"metall.log"
+
+rm -rf ${FILE}*
+./run_simple_allocation_bench_metall ${HARNESS_OPTS} -n ${NUM_ALLOCS} -o ${FILE} -t ${MAX_NUM_THREADS} 8 16 | tee ${LOG_FILE_PREFIX}"metall_scaling.log"
+
+rm -rf ${FILE}*
+./run_simple_allocation_bench_metall_concurrent_slot_claim ${HARNESS_OPTS} -n ${NUM_ALLOCS} -o ${FILE} -t ${MAX_NUM_THREADS} 8 16 | tee ${LOG_FILE_PREFIX}"metall_concurrent_slot_claim_scaling.log"
+
+rm -rf ${FILE}*
+./run_simple_allocation_bench_metall_lock_free_object_cache ${HARNESS_OPTS} -n ${NUM_ALLOCS} -o ${FILE} -t ${MAX_NUM_THREADS} 8 16 | tee ${LOG_FILE_PREFIX}"metall_lock_free_object_cache_scaling.log"
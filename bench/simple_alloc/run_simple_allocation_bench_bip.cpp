@@ -10,18 +10,23 @@
 namespace bip = boost::interprocess;
 
 int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("simple_alloc", argc, argv);
   const auto option = simple_alloc_bench::parse_option(argc, argv);
+  harness.set_backend("bip");
+  harness.set_datastore_path(option.datastore_path);
 
   bip::file_mapping::remove(option.datastore_path.c_str());
 
+  // Reserves space for the per-allocation header of Boost.Interprocess too
   const std::size_t max_alloc_size =
-      *(std::max_element(option.size_list.begin(), option.size_list.end())) *
+      (*(std::max_element(option.size_list.begin(), option.size_list.end())) +
+       64) *
       option.num_allocations;
   bip::managed_mapped_file mfile(
       bip::create_only, option.datastore_path.c_str(), max_alloc_size * 2);
 
-  simple_alloc_bench::run_bench(simple_alloc_bench::option_type{},
-                                mfile.get_allocator<std::byte>());
+  simple_alloc_bench::run_bench(option, mfile.get_allocator<std::byte>(),
+                                harness);
 
   bip::file_mapping::remove(option.datastore_path.c_str());
 
@@ -11,10 +11,14 @@
 #include "kernel.hpp"
 
 int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("simple_alloc", argc, argv);
   const auto option = simple_alloc_bench::parse_option(argc, argv);
+  harness.set_backend("metall");
+  harness.set_datastore_path(option.datastore_path);
   {
     metall::manager manager(metall::create_only, option.datastore_path);
-    simple_alloc_bench::run_bench(option, manager.get_allocator<std::byte>());
+    simple_alloc_bench::run_bench(option, manager.get_allocator<std::byte>(),
+                                  harness);
   }
   metall::manager::remove(option.datastore_path.c_str());
 
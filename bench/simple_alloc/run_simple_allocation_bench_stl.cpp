@@ -9,9 +9,11 @@
 #include "kernel.hpp"
 
 int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("simple_alloc", argc, argv);
   const auto option = simple_alloc_bench::parse_option(argc, argv);
+  harness.set_backend("stl");
 
-  simple_alloc_bench::run_bench(option, std::allocator<std::byte>());
+  simple_alloc_bench::run_bench(option, std::allocator<std::byte>(), harness);
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Benchmarks Metall with realistic mixes of allocation sizes.
+/// Usage:
+/// ./run_size_mix_bench_metall [-o datastore path] [-n #of ops per thread]
+///   [-l #of live objects per thread] [-t max #of threads]
+///   [-d distributions (power_law,json,mixed)] [-s seed]
+///   [-i latency sampling interval] [--bench-* harness options]
+
+#include <metall/metall.hpp>
+#include "size_mix_kernel.hpp"
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("size_mix", argc, argv);
+  const auto option = size_mix_bench::parse_option(argc, argv);
+  harness.set_backend("metall");
+  harness.set_datastore_path(option.datastore_path);
+  {
+    metall::manager manager(metall::create_only, option.datastore_path);
+    size_mix_bench::run_bench(option, manager.get_allocator<std::byte>(),
+                              harness, [&manager]() { manager.flush(); });
+  }
+  metall::manager::remove(option.datastore_path.c_str());
+
+  return 0;
+}
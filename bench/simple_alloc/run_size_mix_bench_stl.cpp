@@ -0,0 +1,21 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Benchmarks the heap allocator with realistic mixes of allocation
+/// sizes, as the baseline of run_size_mix_bench_metall.
+/// Usage: see run_size_mix_bench_metall.cpp.
+
+#include <memory>
+#include "size_mix_kernel.hpp"
+
+int main(int argc, char *argv[]) {
+  bench_utility::bench_harness harness("size_mix", argc, argv);
+  const auto option = size_mix_bench::parse_option(argc, argv);
+  harness.set_backend("stl");
+  size_mix_bench::run_bench(option, std::allocator<std::byte>(), harness,
+                            []() {});
+
+  return 0;
+}
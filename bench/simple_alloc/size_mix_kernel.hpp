@@ -0,0 +1,284 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_SIMPLE_ALLOC_SIZE_MIX_KERNEL_HPP
+#define METALL_BENCH_SIMPLE_ALLOC_SIZE_MIX_KERNEL_HPP
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/detail/time.hpp>
+
+#include "../utility/bench_harness.hpp"
+
+/// \brief Replays realistic mixes of allocation sizes with multiple threads
+/// to judge changes to the allocator, e.g., the object cache and the segment
+/// allocator.
+namespace size_mix_bench {
+
+struct option_type {
+  std::string datastore_path{"/tmp/datastore"};
+  /// \brief The number of allocations and deallocations per thread.
+  std::size_t num_ops = 1ULL << 20ULL;
+  /// \brief The max number of live objects per thread.
+  std::size_t num_live_objects = 1ULL << 14ULL;
+  std::size_t max_num_threads = std::thread::hardware_concurrency();
+  std::vector<std::string> distributions{"power_law", "json", "mixed"};
+  /// \brief Measures the latency of every this many operations.
+  std::size_t latency_sampling_interval = 16;
+  uint64_t seed = 123;
+};
+
+inline option_type parse_option(int argc, char **argv) {
+  option_type option;
+  int p;
+  while ((p = ::getopt(argc, argv, "o:n:l:t:d:s:i:")) != -1) {
+    switch (p) {
+      case 'o':
+        option.datastore_path = optarg;
+        break;
+      case 'n':
+        option.num_ops = std::stold(optarg);
+        break;
+      case 'l':
+        option.num_live_objects = std::stold(optarg);
+        break;
+      case 't':
+        option.max_num_threads = std::stoll(optarg);
+        break;
+      case 'd': {
+        option.distributions.clear();
+        std::stringstream ss(optarg);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+          option.distributions.push_back(name);
+        }
+        break;
+      }
+      case 's':
+        option.seed = std::stoull(optarg);
+        break;
+      case 'i':
+        option.latency_sampling_interval =
+            std::max<std::size_t>(std::stoll(optarg), 1);
+        break;
+      default:
+        std::cerr << "Invalid option" << std::endl;
+        std::abort();
+    }
+  }
+  return option;
+}
+
+/// \brief Generates allocation sizes following a distribution.
+class size_generator {
+ public:
+  /// \param name One of:
+  /// power_law: 8 x 2^k bytes (k = 0..20) with the probability of 2^-k,
+  ///  as the arrays of an adjacency list growing by doubling.
+  /// json: small objects of 8-128 bytes, mostly 16-48 bytes, as the nodes
+  ///  and short strings of JSON documents.
+  /// mixed: 90% small (8 B-256 B), 9% medium (1 KiB-64 KiB), and 1% large
+  ///  (256 KiB-4 MiB) objects.
+  size_generator(const std::string &name, const uint64_t seed)
+      : m_rand(seed) {
+    if (name == "power_law") {
+      std::vector<double> weights;
+      for (int k = 0; k <= 20; ++k) weights.push_back(std::pow(2.0, -k));
+      m_generator = [this, dist = std::discrete_distribution<int>(
+                               weights.begin(), weights.end())]() mutable {
+        return std::size_t(8) << dist(m_rand);
+      };
+    } else if (name == "json") {
+      m_generator = [this,
+                     dist = std::discrete_distribution<int>(
+                         {5, 30, 30, 20, 8, 4, 3})]() mutable {
+        static constexpr std::size_t k_sizes[] = {8, 16, 32, 48, 64, 96, 128};
+        return k_sizes[dist(m_rand)];
+      };
+    } else if (name == "mixed") {
+      m_generator = [this]() {
+        const auto r = std::uniform_int_distribution<int>(0, 99)(m_rand);
+        const auto log_uniform = [this](const int min_exp, const int max_exp) {
+          const auto e =
+              std::uniform_int_distribution<int>(min_exp, max_exp)(m_rand);
+          return std::size_t(1) << e;
+        };
+        if (r < 90) return log_uniform(3, 8);
+        if (r < 99) return log_uniform(10, 16);
+        return log_uniform(18, 22);
+      };
+    } else {
+      std::cerr << "Unknown distribution: " << name << std::endl;
+      std::abort();
+    }
+  }
+
+  std::size_t operator()() { return m_generator(); }
+
+ private:
+  std::mt19937_64 m_rand;
+  std::function<std::size_t()> m_generator;
+};
+
+/// \brief Returns the resident set size of this process in bytes.
+inline std::size_t get_rss() {
+  std::ifstream ifs("/proc/self/statm");
+  std::size_t total = 0, resident = 0;
+  if (!(ifs >> total >> resident)) return 0;
+  return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+/// \brief Returns the number of bytes of the storage used by the files under
+/// 'path'.
+inline std::size_t get_file_space(const std::string &path) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  if (!fs::exists(path, ec)) return 0;
+  std::size_t bytes = 0;
+  for (const auto &e : fs::recursive_directory_iterator(path, ec)) {
+    struct stat st {};
+    if (e.is_regular_file(ec) && ::stat(e.path().c_str(), &st) == 0) {
+      bytes += std::size_t(st.st_blocks) * 512;
+    }
+  }
+  return bytes;
+}
+
+/// \brief Runs the allocations and deallocations of a thread.
+/// Allocates while the number of live objects is below the limit and
+/// otherwise allocates or frees a random live object with equal
+/// probability; frees the other objects at the end.
+template <typename byte_allocator_type>
+void run_thread(byte_allocator_type allocator, const option_type &option,
+                const std::string &distribution, const uint64_t seed,
+                std::vector<double> *latencies) {
+  using pointer = typename std::allocator_traits<byte_allocator_type>::pointer;
+  size_generator gen_size(distribution, seed);
+  std::mt19937_64 rand(seed + 1);
+  std::vector<std::pair<pointer, std::size_t>> live;
+  live.reserve(option.num_live_objects);
+
+  for (std::size_t i = 0; i < option.num_ops; ++i) {
+    const bool sample = (i % option.latency_sampling_interval == 0);
+    const auto start =
+        sample ? std::chrono::steady_clock::now()
+               : std::chrono::steady_clock::time_point{};
+    if (live.size() < option.num_live_objects && (live.empty() || rand() & 1)) {
+      const auto size = gen_size();
+      live.emplace_back(allocator.allocate(size), size);
+    } else {
+      const auto pos = rand() % live.size();
+      allocator.deallocate(live[pos].first, live[pos].second);
+      live[pos] = live.back();
+      live.pop_back();
+    }
+    if (sample) {
+      latencies->push_back(std::chrono::duration<double, std::nano>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+    }
+  }
+  for (auto &[ptr, size] : live) allocator.deallocate(ptr, size);
+}
+
+/// \brief Runs the benchmark with 1, 2, 4, ..., max_num_threads threads for
+/// each distribution.
+/// Reports the elapsed times and, as the metrics, the throughput in million
+/// operations per second (of the median run), the latency percentiles in
+/// nanoseconds, the peak RSS, and the file space of the datastore.
+/// \param flush A function called after each run to write back the data,
+/// e.g., metall::manager::flush().
+template <typename allocator_type, typename flush_function>
+void run_bench(const option_type &option, const allocator_type allocator,
+               bench_utility::bench_harness &harness, flush_function flush) {
+  using byte_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<std::byte>;
+  const byte_allocator_type byte_allocator(allocator);
+
+  std::vector<std::size_t> num_threads_list;
+  for (std::size_t n = 1; n < option.max_num_threads; n *= 2) {
+    num_threads_list.push_back(n);
+  }
+  num_threads_list.push_back(std::max<std::size_t>(option.max_num_threads, 1));
+
+  for (const auto &distribution : option.distributions) {
+    for (const auto num_threads : num_threads_list) {
+      std::cerr << distribution << " with " << num_threads << " threads"
+                << std::endl;
+      const bench_utility::bench_harness::param_list params{
+          {"distribution", distribution},
+          {"num_threads", std::to_string(num_threads)},
+          {"num_ops_per_thread", std::to_string(option.num_ops)},
+          {"num_live_objects_per_thread",
+           std::to_string(option.num_live_objects)}};
+
+      std::vector<double> all_latencies;
+      std::size_t peak_rss = 0;
+      for (int r = 0; r < harness.num_runs(); ++r) {
+        std::vector<std::vector<double>> latencies(num_threads);
+        std::vector<std::thread> threads;
+        const auto start = metall::mtlldetail::elapsed_time_sec();
+        for (std::size_t t = 0; t < num_threads; ++t) {
+          threads.emplace_back([&, t]() {
+            run_thread(byte_allocator, option, distribution,
+                       option.seed + t * 7919 + r, &latencies[t]);
+          });
+        }
+        for (auto &th : threads) th.join();
+        harness.add_sample(distribution, params,
+                           metall::mtlldetail::elapsed_time_sec(start));
+        peak_rss = std::max(peak_rss, get_rss());
+        flush();
+
+        if (r >= harness.num_warmups()) {
+          for (const auto &l : latencies) {
+            all_latencies.insert(all_latencies.end(), l.begin(), l.end());
+          }
+        }
+      }
+
+      const auto times = harness.statistics(distribution, params);
+      const auto latency = bench_utility::compute_statistics(all_latencies);
+      std::sort(all_latencies.begin(), all_latencies.end());
+      const double p999 =
+          all_latencies.empty()
+              ? 0.0
+              : all_latencies[std::min(all_latencies.size() - 1,
+                                       all_latencies.size() * 999 / 1000)];
+      const auto set = [&](const std::string &key, const double value) {
+        harness.set_metric(distribution, params, key, value);
+      };
+      if (times.p50 > 0) {
+        set("throughput_mops",
+            double(option.num_ops * num_threads) / times.p50 / 1e6);
+      }
+      set("latency_p50_ns", latency.p50);
+      set("latency_p99_ns", latency.p99);
+      set("latency_p999_ns", p999);
+      set("latency_max_ns", latency.max);
+      set("peak_rss_bytes", double(peak_rss));
+      set("file_space_bytes", double(get_file_space(option.datastore_path)));
+    }
+  }
+}
+
+}  // namespace size_mix_bench
+
+#endif  // METALL_BENCH_SIMPLE_ALLOC_SIZE_MIX_KERNEL_HPP
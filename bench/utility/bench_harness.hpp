@@ -0,0 +1,531 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_UTILITY_BENCH_HARNESS_HPP
+#define METALL_BENCH_UTILITY_BENCH_HARNESS_HPP
+
+#include <sys/statfs.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/version.hpp>
+#include <metall/detail/time.hpp>
+
+#define METALL_BENCH_HARNESS_STR_IMPL(x) #x
+#define METALL_BENCH_HARNESS_STR(x) METALL_BENCH_HARNESS_STR_IMPL(x)
+
+namespace bench_utility {
+
+/// \brief Statistics of the samples of a measurement, in seconds.
+struct sample_statistics {
+  std::size_t count{0};
+  double min{0};
+  double max{0};
+  double mean{0};
+  double stddev{0};
+  double p50{0};
+  double p90{0};
+  double p99{0};
+};
+
+/// \brief Computes the statistics of 'samples'.
+/// The percentiles are interpolated linearly between the closest ranks.
+inline sample_statistics compute_statistics(std::vector<double> samples) {
+  sample_statistics stats;
+  stats.count = samples.size();
+  if (samples.empty()) return stats;
+
+  std::sort(samples.begin(), samples.end());
+  stats.min = samples.front();
+  stats.max = samples.back();
+  double sum = 0;
+  for (const auto s : samples) sum += s;
+  stats.mean = sum / samples.size();
+  double var = 0;
+  for (const auto s : samples) var += (s - stats.mean) * (s - stats.mean);
+  stats.stddev = std::sqrt(var / samples.size());
+
+  const auto percentile = [&samples](const double p) {
+    const double rank = p * (samples.size() - 1);
+    const auto lo = static_cast<std::size_t>(std::floor(rank));
+    const auto hi = std::min(lo + 1, samples.size() - 1);
+    return samples[lo] + (samples[hi] - samples[lo]) * (rank - lo);
+  };
+  stats.p50 = percentile(0.5);
+  stats.p90 = percentile(0.9);
+  stats.p99 = percentile(0.99);
+  return stats;
+}
+
+/// \brief A common harness for the benchmark programs.
+/// Runs a measurement several times after warmup runs, computes percentiles,
+/// and reports them with the environment (CPU, NUMA, file system, build
+/// flags) as text, CSV, or JSON.
+///
+/// The harness consumes the following options from the command line before
+/// the program parses its own, so that they can be given to any benchmark:
+///  --bench-warmup=N       The number of warmup runs to discard (default 1).
+///  --bench-repetitions=N  The number of measured runs (default 5).
+///  --bench-format=F       text, csv, or json (default text).
+///  --bench-output=PATH    Writes the report to PATH instead of stdout.
+///  --bench-label=LABEL    A label to tell runs apart, e.g., a commit ID.
+///
+/// \code
+/// int main(int argc, char *argv[]) {
+///   bench_utility::bench_harness harness("simple_alloc", argc, argv);
+///   ... // parse the other options
+///   harness.set_backend("metall");
+///   harness.set_datastore_path(path);
+///   harness.run("alloc", {{"size", "8"}}, [&]() { ... });
+/// }  // The report is written here
+/// \endcode
+class bench_harness {
+ public:
+  using param_list = std::vector<std::pair<std::string, std::string>>;
+
+  /// \brief Constructor.
+  /// \param suite The name of the benchmark suite.
+  /// \param argc The number of arguments; updated to exclude the harness
+  /// options.
+  /// \param argv The arguments; the harness options are removed.
+  bench_harness(std::string suite, int &argc, char **argv)
+      : m_suite(std::move(suite)) {
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+      if (!priv_parse_option(argv[i])) argv[out++] = argv[i];
+    }
+    argc = out;
+    argv[argc] = nullptr;
+  }
+
+  bench_harness(const bench_harness &) = delete;
+  bench_harness &operator=(const bench_harness &) = delete;
+
+  /// \brief Destructor that writes the report if not yet.
+  ~bench_harness() {
+    if (!m_reported) report();
+  }
+
+  /// \brief Sets the name of the allocator or storage backend measured,
+  /// e.g., metall, bip, jemalloc, or pmem.
+  void set_backend(std::string backend) { m_backend = std::move(backend); }
+
+  /// \brief Sets the datastore path to record its file system.
+  void set_datastore_path(std::string path) {
+    m_datastore_path = std::move(path);
+  }
+
+  /// \brief Returns the number of warmup runs.
+  int num_warmups() const { return m_num_warmups; }
+
+  /// \brief Returns the number of measured runs.
+  int num_repetitions() const { return m_num_repetitions; }
+
+  /// \brief Returns warmup + repetitions, the number of times a caller that
+  /// uses add_sample() should run each measurement.
+  int num_runs() const { return m_num_warmups + m_num_repetitions; }
+
+  /// \brief Runs 'func' num_runs() times and records the elapsed times of
+  /// the runs after the warmup ones.
+  /// \return The statistics of the measurement.
+  template <typename function_type>
+  sample_statistics run(const std::string &name, const param_list &params,
+                        function_type &&func) {
+    for (int i = 0; i < num_runs(); ++i) {
+      const auto start = metall::mtlldetail::elapsed_time_sec();
+      func();
+      add_sample(name, params, metall::mtlldetail::elapsed_time_sec(start));
+    }
+    return statistics(name, params);
+  }
+
+  /// \brief Adds a sample measured by the caller, for measurements that
+  /// cannot be a single function call, e.g., allocation and deallocation
+  /// timed in turn. The first num_warmups() samples of each measurement are
+  /// discarded.
+  void add_sample(const std::string &name, const param_list &params,
+                  const double seconds) {
+    auto &m = priv_find_or_add(name, params);
+    if (m.num_discarded < m_num_warmups) {
+      ++m.num_discarded;
+      return;
+    }
+    m.samples.push_back(seconds);
+  }
+
+  /// \brief Sets a value reported with a measurement other than its
+  /// elapsed times, e.g., throughput, tail latency, or memory footprint.
+  /// Overwrites the value set with the same key before.
+  void set_metric(const std::string &name, const param_list &params,
+                  const std::string &key, const double value) {
+    auto &metrics = priv_find_or_add(name, params).metrics;
+    for (auto &[k, v] : metrics) {
+      if (k == key) {
+        v = value;
+        return;
+      }
+    }
+    metrics.emplace_back(key, value);
+  }
+
+  /// \brief Returns the statistics of a measurement.
+  sample_statistics statistics(const std::string &name,
+                               const param_list &params) {
+    return compute_statistics(priv_find_or_add(name, params).samples);
+  }
+
+  /// \brief Writes the report in the format given by --bench-format.
+  void report() {
+    m_reported = true;
+    std::ofstream ofs;
+    if (!m_output_path.empty()) {
+      ofs.open(m_output_path);
+      if (!ofs.is_open()) {
+        std::cerr << "Failed to open " << m_output_path << std::endl;
+        return;
+      }
+    }
+    std::ostream &os = ofs.is_open() ? ofs : std::cout;
+    const auto env = capture_environment();
+    if (m_format == "json") {
+      priv_report_json(env, os);
+    } else if (m_format == "csv") {
+      priv_report_csv(env, os);
+    } else {
+      priv_report_text(env, os);
+    }
+  }
+
+  /// \brief Captures the environment the benchmark runs on.
+  param_list capture_environment() const {
+    param_list env;
+    env.emplace_back("suite", m_suite);
+    env.emplace_back("backend", m_backend);
+    env.emplace_back("label", m_label);
+    env.emplace_back("timestamp", priv_timestamp());
+    env.emplace_back("hostname", priv_hostname());
+    struct utsname uts {};
+    if (::uname(&uts) == 0) {
+      env.emplace_back("kernel",
+                       std::string(uts.sysname) + " " + uts.release);
+      env.emplace_back("machine", uts.machine);
+    }
+    env.emplace_back("cpu_model", priv_cpu_model());
+    env.emplace_back("num_cpus",
+                     std::to_string(std::thread::hardware_concurrency()));
+    env.emplace_back("num_numa_nodes", std::to_string(priv_num_numa_nodes()));
+    if (!m_datastore_path.empty()) {
+      env.emplace_back("datastore_path", m_datastore_path);
+      env.emplace_back("file_system", priv_file_system(m_datastore_path));
+    }
+    env.emplace_back("metall_version", std::to_string(METALL_VERSION));
+#ifdef __VERSION__
+    env.emplace_back("compiler", __VERSION__);
+#endif
+#ifdef NDEBUG
+    env.emplace_back("assertions", "off");
+#else
+    env.emplace_back("assertions", "on");
+#endif
+    env.emplace_back("metall_flags", priv_build_flags());
+    env.emplace_back("warmup", std::to_string(m_num_warmups));
+    env.emplace_back("repetitions", std::to_string(m_num_repetitions));
+    return env;
+  }
+
+ private:
+  struct measurement {
+    std::string name;
+    param_list params;
+    int num_discarded{0};
+    std::vector<double> samples;
+    std::vector<std::pair<std::string, double>> metrics{};
+  };
+
+  bool priv_parse_option(const std::string_view arg) {
+    const auto value_of = [&arg](const std::string_view key, auto *value) {
+      if (arg.substr(0, key.size()) != key) return false;
+      const std::string v(arg.substr(key.size()));
+      if constexpr (std::is_same_v<std::decay_t<decltype(*value)>, int>) {
+        *value = std::stoi(v);
+      } else {
+        *value = v;
+      }
+      return true;
+    };
+    return value_of("--bench-warmup=", &m_num_warmups) ||
+           value_of("--bench-repetitions=", &m_num_repetitions) ||
+           value_of("--bench-format=", &m_format) ||
+           value_of("--bench-output=", &m_output_path) ||
+           value_of("--bench-label=", &m_label);
+  }
+
+  measurement &priv_find_or_add(const std::string &name,
+                                const param_list &params) {
+    for (auto &m : m_measurements) {
+      if (m.name == name && m.params == params) return m;
+    }
+    m_measurements.push_back(measurement{name, params, 0, {}});
+    return m_measurements.back();
+  }
+
+  static std::string priv_params_string(const param_list &params) {
+    std::string s;
+    for (const auto &[k, v] : params) {
+      if (!s.empty()) s += ";";
+      s += k + "=" + v;
+    }
+    return s;
+  }
+
+  static std::string priv_metrics_string(
+      const std::vector<std::pair<std::string, double>> &metrics) {
+    std::ostringstream ss;
+    ss << std::setprecision(9);
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+      if (i > 0) ss << ";";
+      ss << metrics[i].first << "=" << metrics[i].second;
+    }
+    return ss.str();
+  }
+
+  void priv_report_text(const param_list &env, std::ostream &os) const {
+    os << "----- Environment -----" << std::endl;
+    for (const auto &[k, v] : env) os << k << "\t" << v << std::endl;
+    os << "----- Results (s) -----" << std::endl;
+    os << "[name]\t[params]\t[count]\t[min]\t[p50]\t[p90]\t[p99]\t[max]\t"
+          "[mean]\t[stddev]\t[metrics]"
+       << std::endl;
+    os << std::setprecision(6);
+    for (const auto &m : m_measurements) {
+      const auto s = compute_statistics(m.samples);
+      os << m.name << "\t" << priv_params_string(m.params) << "\t" << s.count
+         << "\t" << s.min << "\t" << s.p50 << "\t" << s.p90 << "\t" << s.p99
+         << "\t" << s.max << "\t" << s.mean << "\t" << s.stddev << "\t"
+         << priv_metrics_string(m.metrics) << std::endl;
+    }
+  }
+
+  void priv_report_csv(const param_list &env, std::ostream &os) const {
+    for (const auto &[k, v] : env) os << "# " << k << "=" << v << std::endl;
+    os << "suite,backend,label,name,params,count,min,p50,p90,p99,max,mean,"
+          "stddev,metrics"
+       << std::endl;
+    os << std::setprecision(9);
+    for (const auto &m : m_measurements) {
+      const auto s = compute_statistics(m.samples);
+      os << priv_csv_field(m_suite) << "," << priv_csv_field(m_backend) << ","
+         << priv_csv_field(m_label) << "," << priv_csv_field(m.name) << ","
+         << priv_csv_field(priv_params_string(m.params)) << "," << s.count
+         << "," << s.min << "," << s.p50 << "," << s.p90 << "," << s.p99
+         << "," << s.max << "," << s.mean << "," << s.stddev << ","
+         << priv_csv_field(priv_metrics_string(m.metrics)) << std::endl;
+    }
+  }
+
+  void priv_report_json(const param_list &env, std::ostream &os) const {
+    os << std::setprecision(9);
+    os << "{\"environment\":{";
+    for (std::size_t i = 0; i < env.size(); ++i) {
+      if (i > 0) os << ",";
+      os << priv_json_string(env[i].first) << ":"
+         << priv_json_string(env[i].second);
+    }
+    os << "},\"results\":[";
+    for (std::size_t i = 0; i < m_measurements.size(); ++i) {
+      const auto &m = m_measurements[i];
+      const auto s = compute_statistics(m.samples);
+      if (i > 0) os << ",";
+      os << "{\"name\":" << priv_json_string(m.name) << ",\"params\":{";
+      for (std::size_t p = 0; p < m.params.size(); ++p) {
+        if (p > 0) os << ",";
+        os << priv_json_string(m.params[p].first) << ":"
+           << priv_json_string(m.params[p].second);
+      }
+      os << "},\"count\":" << s.count << ",\"min\":" << s.min
+         << ",\"p50\":" << s.p50 << ",\"p90\":" << s.p90
+         << ",\"p99\":" << s.p99 << ",\"max\":" << s.max
+         << ",\"mean\":" << s.mean << ",\"stddev\":" << s.stddev
+         << ",\"metrics\":{";
+      for (std::size_t j = 0; j < m.metrics.size(); ++j) {
+        if (j > 0) os << ",";
+        os << priv_json_string(m.metrics[j].first) << ":"
+           << m.metrics[j].second;
+      }
+      os << "},\"samples\":[";
+      for (std::size_t j = 0; j < m.samples.size(); ++j) {
+        if (j > 0) os << ",";
+        os << m.samples[j];
+      }
+      os << "]}";
+    }
+    os << "]}" << std::endl;
+  }
+
+  static std::string priv_csv_field(const std::string &s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string out("\"");
+    for (const char c : s) {
+      if (c == '"') out += '"';
+      out += c;
+    }
+    return out + "\"";
+  }
+
+  static std::string priv_json_string(const std::string &s) {
+    std::ostringstream out;
+    out << '"';
+    for (const char c : s) {
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+            << static_cast<int>(c) << std::dec;
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+    return out.str();
+  }
+
+  static std::string priv_timestamp() {
+    const std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    ::gmtime_r(&now, &tm);
+    std::ostringstream ss;
+    ss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+    return ss.str();
+  }
+
+  static std::string priv_hostname() {
+    char buf[256] = {};
+    if (::gethostname(buf, sizeof(buf) - 1) != 0) return "";
+    return buf;
+  }
+
+  static std::string priv_cpu_model() {
+    std::ifstream ifs("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(ifs, line)) {
+      if (line.rfind("model name", 0) == 0) {
+        const auto pos = line.find(':');
+        if (pos != std::string::npos && pos + 2 <= line.size()) {
+          return line.substr(pos + 2);
+        }
+      }
+    }
+    return "unknown";
+  }
+
+  static int priv_num_numa_nodes() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    int n = 0;
+    for (const auto &e :
+         fs::directory_iterator("/sys/devices/system/node", ec)) {
+      const auto name = e.path().filename().string();
+      if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+          std::isdigit(static_cast<unsigned char>(name[4]))) {
+        ++n;
+      }
+    }
+    return std::max(n, 1);
+  }
+
+  /// \brief Returns the file system type of the closest existing ancestor
+  /// of 'path'.
+  static std::string priv_file_system(const std::string &path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path p = fs::absolute(path, ec);
+    while (!p.empty() && !fs::exists(p, ec)) p = p.parent_path();
+
+    struct statfs buf {};
+    if (p.empty() || ::statfs(p.c_str(), &buf) != 0) return "unknown";
+    static const std::map<long, std::string> k_names = {
+        {0xEF53, "ext4"},        {0x58465342, "xfs"},
+        {0x01021994, "tmpfs"},   {0x9123683E, "btrfs"},
+        {0x6969, "nfs"},         {0x0BD00BD0, "lustre"},
+        {0x47504653, "gpfs"},    {0x2FC12FC1, "zfs"},
+        {0x65735546, "fuse"},    {0x794C7630, "overlayfs"}};
+    const auto itr = k_names.find(static_cast<long>(buf.f_type));
+    if (itr != k_names.end()) return itr->second;
+    std::ostringstream ss;
+    ss << "0x" << std::hex << buf.f_type;
+    return ss.str();
+  }
+
+  /// \brief Returns the Metall macros defined at build time.
+  static std::string priv_build_flags() {
+    std::string flags;
+    const auto add = [&flags](const char *const name, const char *const value) {
+      // An undefined macro is stringified to its own name
+      if (std::string_view(name) == value) return;
+      if (!flags.empty()) flags += " ";
+      flags += name;
+      if (value[0] != '\0') flags += std::string("=") + value;
+    };
+#define METALL_BENCH_HARNESS_ADD_FLAG(x) add(#x, METALL_BENCH_HARNESS_STR(x))
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_DISABLE_CONCURRENCY);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_DISABLE_OBJECT_CACHE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_SORTED_BIN);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_ANONYMOUS_NEW_MAP);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_NUMA_LIB);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_UMAP);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_PRIVATEER);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_IO_URING);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_ZSTD);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_INCREMENTAL_SYNC);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_ALLOCATION_SAMPLING);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_GEOMETRIC_BLOCK_GROWTH);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_LOCK_FREE_OBJECT_CACHE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_CONCURRENT_SLOT_CLAIM);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_USE_TRACEPOINTS);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_SEGMENT_BLOCK_SIZE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_SEGMENT_HUGE_PAGE_SIZE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_SEGMENT_NUMA_INTERLEAVE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_MAX_PER_CPU_CACHE_SIZE);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_DEFAULT_CAPACITY);
+    METALL_BENCH_HARNESS_ADD_FLAG(METALL_MAX_CAPACITY);
+#undef METALL_BENCH_HARNESS_ADD_FLAG
+    return flags;
+  }
+
+  std::string m_suite;
+  std::string m_backend{};
+  std::string m_label{};
+  std::string m_datastore_path{};
+  int m_num_warmups{1};
+  int m_num_repetitions{5};
+  std::string m_format{"text"};
+  std::string m_output_path{};
+  bool m_reported{false};
+  std::vector<measurement> m_measurements;
+};
+
+}  // namespace bench_utility
+
+#undef METALL_BENCH_HARNESS_STR
+#undef METALL_BENCH_HARNESS_STR_IMPL
+
+#endif  // METALL_BENCH_UTILITY_BENCH_HARNESS_HPP
@@ -0,0 +1,304 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_UTILITY_BINARY_EDGE_LIST_HPP
+#define METALL_BENCH_UTILITY_BINARY_EDGE_LIST_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metall/utility/open_mp.hpp>
+#include <metall/detail/utilities.hpp>
+#include "mapped_file.hpp"
+
+/// \brief A binary edge-list format for the benchmarks.
+/// A file consists of a 16-byte header, i.e., the magic (8 bytes) and the
+/// number of edges (uint64_t), followed by the edges as pairs of uint64_t
+/// (source, destination) in the native byte order.
+namespace bench_utility::binary_edge_list {
+
+constexpr char k_magic[8] = {'M', 'T', 'L', 'L', 'E', 'D', 'G', '1'};
+constexpr std::size_t k_header_size = 16;
+using edge_type = std::pair<uint64_t, uint64_t>;
+
+/// \brief Returns true if 'file_name' is a binary edge-list file.
+inline bool is_binary_edge_list(const std::string &file_name) {
+  std::ifstream ifs(file_name, std::ios::binary);
+  char magic[sizeof(k_magic)];
+  if (!ifs.read(magic, sizeof(magic))) return false;
+  return std::memcmp(magic, k_magic, sizeof(k_magic)) == 0;
+}
+
+/// \brief Writes a binary edge-list file with a buffer.
+class writer {
+ public:
+  writer() = default;
+  explicit writer(const std::string &file_name) { open(file_name); }
+  writer(const writer &) = delete;
+  writer &operator=(const writer &) = delete;
+  ~writer() { close(); }
+
+  /// \brief Opens 'file_name' and writes the header.
+  /// \return Returns true on success; otherwise, false.
+  bool open(const std::string &file_name) {
+    close();
+    m_ofs.open(file_name, std::ios::binary | std::ios::trunc);
+    if (!m_ofs.is_open()) {
+      std::cerr << "Cannot open " << file_name << std::endl;
+      return false;
+    }
+    m_num_edges = 0;
+    return priv_write_header();
+  }
+
+  bool is_open() const { return m_ofs.is_open(); }
+
+  void write(const uint64_t source, const uint64_t destination) {
+    m_buffer.emplace_back(source, destination);
+    if (m_buffer.size() >= k_buffer_size) priv_flush();
+  }
+
+  /// \brief Writes the buffered edges, updates the number of edges in the
+  /// header, and closes the file.
+  /// \return Returns true on success; otherwise, false.
+  bool close() {
+    if (!m_ofs.is_open()) return true;
+    priv_flush();
+    m_ofs.seekp(0);
+    priv_write_header();
+    m_ofs.close();
+    if (!m_ofs) {
+      std::cerr << "Failed to write a binary edge list" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  std::size_t num_edges() const { return m_num_edges + m_buffer.size(); }
+
+ private:
+  static constexpr std::size_t k_buffer_size = 1ULL << 16ULL;
+
+  bool priv_write_header() {
+    const uint64_t num_edges = m_num_edges;
+    m_ofs.write(k_magic, sizeof(k_magic));
+    m_ofs.write(reinterpret_cast<const char *>(&num_edges), sizeof(num_edges));
+    return !!m_ofs;
+  }
+
+  void priv_flush() {
+    static_assert(sizeof(edge_type) == sizeof(uint64_t) * 2);
+    m_ofs.write(reinterpret_cast<const char *>(m_buffer.data()),
+                m_buffer.size() * sizeof(edge_type));
+    m_num_edges += m_buffer.size();
+    m_buffer.clear();
+  }
+
+  std::ofstream m_ofs;
+  std::size_t m_num_edges{0};
+  std::vector<edge_type> m_buffer;
+};
+
+/// \brief Reads binary edge-list files in order, with the same interface as
+/// pair_reader.
+template <typename first_type, typename second_type>
+class reader {
+ public:
+  template <typename input_itr>
+  reader(input_itr first, input_itr last) : m_file_name_list(first, last) {}
+
+  class iterator;
+
+  iterator begin() const { return iterator(&m_file_name_list); }
+
+  iterator end() const { return iterator(); }
+
+ private:
+  std::vector<std::string> m_file_name_list;
+};
+
+template <typename first_type, typename second_type>
+class reader<first_type, second_type>::iterator {
+ public:
+  using value_type = std::pair<first_type, second_type>;
+  using difference_type = int64_t;
+  using iterator_category = std::input_iterator_tag;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+
+  iterator() = default;
+
+  explicit iterator(const std::vector<std::string> *file_name_list)
+      : m_file_name_list(file_name_list) {
+    priv_next();
+  }
+
+  // Copying an iterator does not copy the file position
+  iterator(const iterator &) = delete;
+  iterator(iterator &&) = default;
+  iterator &operator=(iterator &&) = default;
+
+  reference operator*() const { return m_value; }
+
+  pointer operator->() const { return &m_value; }
+
+  iterator &operator++() {
+    priv_next();
+    return *this;
+  }
+
+  bool operator==(const iterator &other) const {
+    return is_end() && other.is_end();
+  }
+
+  bool operator!=(const iterator &other) const { return !(*this == other); }
+
+  bool is_end() const { return !m_file_name_list; }
+
+ private:
+  static constexpr std::size_t k_buffer_size = 1ULL << 16ULL;
+
+  void priv_next() {
+    while (m_buffer_pos == m_buffer.size()) {
+      if (!priv_fill_buffer()) {
+        m_file_name_list = nullptr;
+        return;
+      }
+    }
+    const auto &edge = m_buffer[m_buffer_pos++];
+    m_value = value_type(first_type(edge.first), second_type(edge.second));
+  }
+
+  /// \brief Reads the next edges, opening the next file if needed.
+  /// \return Returns false at the end of the last file.
+  bool priv_fill_buffer() {
+    m_buffer.clear();
+    m_buffer_pos = 0;
+    while (m_num_remaining_edges == 0) {
+      if (m_ifs.is_open()) m_ifs.close();
+      if (m_file_no >= m_file_name_list->size()) return false;
+      priv_open((*m_file_name_list)[m_file_no++]);
+    }
+    m_buffer.resize(std::min(k_buffer_size, m_num_remaining_edges));
+    if (!m_ifs.read(reinterpret_cast<char *>(m_buffer.data()),
+                    m_buffer.size() * sizeof(edge_type))) {
+      std::cerr << "Failed to read a binary edge list" << std::endl;
+      std::abort();
+    }
+    m_num_remaining_edges -= m_buffer.size();
+    return true;
+  }
+
+  void priv_open(const std::string &file_name) {
+    m_ifs.open(file_name, std::ios::binary);
+    char magic[sizeof(k_magic)];
+    uint64_t num_edges = 0;
+    if (!m_ifs.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, k_magic, sizeof(k_magic)) != 0 ||
+        !m_ifs.read(reinterpret_cast<char *>(&num_edges), sizeof(num_edges))) {
+      std::cerr << "Not a binary edge list: " << file_name << std::endl;
+      std::abort();
+    }
+    m_num_remaining_edges = num_edges;
+  }
+
+  const std::vector<std::string> *m_file_name_list{nullptr};
+  std::size_t m_file_no{0};
+  std::ifstream m_ifs;
+  std::size_t m_num_remaining_edges{0};
+  std::vector<edge_type> m_buffer;
+  std::size_t m_buffer_pos{0};
+  value_type m_value{};
+};
+
+/// \brief A contiguous range of edges.
+struct edge_span {
+  const edge_type *first{nullptr};
+  const edge_type *last{nullptr};
+
+  const edge_type *begin() const { return first; }
+  const edge_type *end() const { return last; }
+  std::size_t size() const { return last - first; }
+  const edge_type &operator[](const std::size_t i) const { return first[i]; }
+};
+
+/// \brief Maps a binary edge-list file and gives the edges without copying
+/// them, e.g., as a span per OpenMP thread.
+class mapped_reader {
+ public:
+  mapped_reader() = default;
+  explicit mapped_reader(const std::string &file_name) { open(file_name); }
+
+  /// \brief Maps 'file_name' and checks its header.
+  /// \return Returns true on success; otherwise, false.
+  bool open(const std::string &file_name) {
+    m_edges = edge_span{};
+    if (!m_file.open(file_name)) return false;
+    uint64_t num_edges = 0;
+    if (m_file.size() < k_header_size ||
+        std::memcmp(m_file.data(), k_magic, sizeof(k_magic)) != 0) {
+      std::cerr << "Not a binary edge list: " << file_name << std::endl;
+      m_file.close();
+      return false;
+    }
+    std::memcpy(&num_edges, m_file.data() + sizeof(k_magic),
+                sizeof(num_edges));
+    if (k_header_size + num_edges * sizeof(edge_type) > m_file.size()) {
+      std::cerr << "Truncated binary edge list: " << file_name << std::endl;
+      m_file.close();
+      return false;
+    }
+    // The header keeps the edges 8-byte aligned in the page-aligned map
+    m_edges.first =
+        reinterpret_cast<const edge_type *>(m_file.data() + k_header_size);
+    m_edges.last = m_edges.first + num_edges;
+    return true;
+  }
+
+  std::size_t num_edges() const { return m_edges.size(); }
+
+  /// \brief Returns all edges.
+  edge_span edges() const { return m_edges; }
+
+  /// \brief Returns the part of the edges [first, last) for 'part_no' of
+  /// 'num_parts' parts.
+  edge_span span(const std::size_t first, const std::size_t last,
+                 const std::size_t part_no,
+                 const std::size_t num_parts) const {
+    const std::size_t begin = std::min(first, num_edges());
+    const std::size_t end = std::max(begin, std::min(last, num_edges()));
+    const auto range =
+        metall::mtlldetail::partial_range(end - begin, part_no, num_parts);
+    return edge_span{m_edges.first + begin + range.first,
+                     m_edges.first + begin + range.second};
+  }
+
+  /// \brief Calls 'func(thread_no, span)' in each OpenMP thread with its
+  /// part of the edges [first, last).
+  template <typename function_type>
+  void for_each_span(const std::size_t first, const std::size_t last,
+                     function_type &&func) const {
+    OMP_DIRECTIVE(parallel) {
+      const int thread_no = metall::utility::omp::get_thread_num();
+      func(thread_no, span(first, last, thread_no,
+                           metall::utility::omp::get_num_threads()));
+    }
+  }
+
+ private:
+  mapped_file m_file;
+  edge_span m_edges;
+};
+
+}  // namespace bench_utility::binary_edge_list
+
+#endif  // METALL_BENCH_UTILITY_BINARY_EDGE_LIST_HPP
@@ -0,0 +1,92 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_BENCH_UTILITY_MAPPED_FILE_HPP
+#define METALL_BENCH_UTILITY_MAPPED_FILE_HPP
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/mmap.hpp>
+
+namespace bench_utility {
+
+/// \brief Maps a whole file read-only to read input data without copying.
+class mapped_file {
+ public:
+  mapped_file() = default;
+  explicit mapped_file(const std::string &file_name) { open(file_name); }
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+  mapped_file(mapped_file &&other) noexcept { priv_move(std::move(other)); }
+  mapped_file &operator=(mapped_file &&other) noexcept {
+    if (this != &other) {
+      close();
+      priv_move(std::move(other));
+    }
+    return *this;
+  }
+  ~mapped_file() { close(); }
+
+  /// \brief Maps 'file_name' and advises the kernel to read it
+  /// sequentially.
+  /// \return Returns true on success; otherwise, false.
+  bool open(const std::string &file_name) {
+    close();
+    const auto size = metall::mtlldetail::get_file_size(file_name);
+    if (size < 0) {
+      std::cerr << "Cannot get the size of " << file_name << std::endl;
+      return false;
+    }
+    m_size = size;
+    if (m_size == 0) return true;  // Nothing to map
+
+    const auto ret =
+        metall::mtlldetail::map_file_read_mode(file_name, nullptr, m_size, 0);
+    if (ret.first == -1 || !ret.second) {
+      std::cerr << "Cannot map " << file_name << std::endl;
+      m_size = 0;
+      return false;
+    }
+    m_fd = ret.first;
+    m_addr = static_cast<const char *>(ret.second);
+    ::madvise(const_cast<char *>(m_addr), m_size, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  void close() {
+    if (m_addr) {
+      metall::mtlldetail::munmap(m_fd, const_cast<char *>(m_addr), m_size,
+                                 false);
+    }
+    m_fd = -1;
+    m_addr = nullptr;
+    m_size = 0;
+  }
+
+  const char *data() const { return m_addr; }
+
+  std::size_t size() const { return m_size; }
+
+ private:
+  void priv_move(mapped_file &&other) {
+    m_fd = std::exchange(other.m_fd, -1);
+    m_addr = std::exchange(other.m_addr, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+  }
+
+  int m_fd{-1};
+  const char *m_addr{nullptr};
+  std::size_t m_size{0};
+};
+
+}  // namespace bench_utility
+
+#endif  // METALL_BENCH_UTILITY_MAPPED_FILE_HPP
@@ -15,6 +15,12 @@
 #include <iterator>
 #include <limits>
 #include <cassert>
+#include <charconv>
+#include <cstring>
+
+#include <metall/utility/open_mp.hpp>
+#include <metall/detail/utilities.hpp>
+#include "mapped_file.hpp"
 
 namespace bench_utility {
 
@@ -178,5 +184,87 @@ class pair_reader<first_type, second_type>::iterator {
 //   return !(rhd == lhd);
 // }
 
+/// \brief Parses a text file of pairs, i.e., 'first second' in each line,
+/// with the OpenMP threads.
+/// The file is mapped and split at newline boundaries, and each thread
+/// parses its part in place with std::from_chars.
+/// Lines that do not start with two values are skipped.
+template <typename first_type, typename second_type>
+class parallel_pair_parser {
+ public:
+  explicit parallel_pair_parser(const std::string &file_name)
+      : m_file(file_name) {}
+
+  /// \brief Returns the size of the file in bytes.
+  std::size_t size() const { return m_file.size(); }
+
+  /// \brief Returns the first line boundary at or after byte 'offset', or
+  /// size() if there is none.
+  std::size_t line_boundary(const std::size_t offset) const {
+    if (offset == 0) return 0;
+    if (offset >= size()) return size();
+    const char *const data = m_file.data();
+    const void *const newline =
+        std::memchr(data + offset - 1, '\n', size() - offset + 1);
+    if (!newline) return size();
+    return static_cast<const char *>(newline) - data + 1;
+  }
+
+  /// \brief Parses the bytes [first, last), which must be at line
+  /// boundaries, with the OpenMP threads and calls 'func(thread_no, first
+  /// value, second value)' for each line.
+  template <typename function_type>
+  void parse(const std::size_t first, const std::size_t last,
+             function_type &&func) const {
+    OMP_DIRECTIVE(parallel) {
+      const int thread_no = metall::utility::omp::get_thread_num();
+      const auto range = metall::mtlldetail::partial_range(
+          last - first, thread_no, metall::utility::omp::get_num_threads());
+      const std::size_t begin = line_boundary(first + range.first);
+      const std::size_t end = line_boundary(first + range.second);
+      priv_parse(m_file.data() + begin, m_file.data() + end,
+                 [&func, thread_no](const first_type &a,
+                                    const second_type &b) {
+                   func(thread_no, a, b);
+                 });
+    }
+  }
+
+  /// \brief Parses the whole file.
+  template <typename function_type>
+  void parse(function_type &&func) const {
+    parse(0, size(), std::forward<function_type>(func));
+  }
+
+ private:
+  static bool is_blank(const char c) { return c == ' ' || c == '\t'; }
+
+  template <typename function_type>
+  static void priv_parse(const char *p, const char *const end,
+                         const function_type &func) {
+    while (p < end) {
+      while (p < end && is_blank(*p)) ++p;
+      first_type a;
+      const auto r1 = std::from_chars(p, end, a);
+      if (r1.ec == std::errc()) {
+        p = r1.ptr;
+        while (p < end && is_blank(*p)) ++p;
+        second_type b;
+        const auto r2 = std::from_chars(p, end, b);
+        if (r2.ec == std::errc()) {
+          p = r2.ptr;
+          func(a, b);
+        }
+      }
+      // Moves to the next line
+      const void *const newline = std::memchr(p, '\n', end - p);
+      if (!newline) break;
+      p = static_cast<const char *>(newline) + 1;
+    }
+  }
+
+  mapped_file m_file;
+};
+
 }  // namespace bench_utility
 #endif  // METALL_BENCH_UTILITY_PAIR_READER_HPP
@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <metall/c_api/metall.h>
 
 int main(void) {
@@ -51,6 +52,66 @@ int main(void) {
     metall_remove("/tmp/metall2");
   }
 
+  // Batch operations
+  {
+    metall_manager* manager = metall_create("/tmp/metall3");
+
+    void* ptrs[4];
+    const size_t num_allocated =
+        metall_malloc_many(manager, sizeof(uint64_t), 4, ptrs);
+    assert(num_allocated == 4);
+    metall_free_many(manager, ptrs, 4);
+
+    metall_named_malloc(manager, "a", sizeof(uint64_t));
+    metall_named_malloc(manager, "b", sizeof(uint64_t));
+    const char* names[3] = {"a", "b", "c"};
+    const size_t num_found = metall_find_many(manager, names, 3, ptrs);
+    assert(num_found == 2);
+    assert(ptrs[2] == NULL);
+    metall_prefetch(manager, ptrs[0], sizeof(uint64_t));
+
+    metall_async_handle* flush = metall_flush_async(manager);
+    *(uint64_t*)ptrs[1] = 1;  // Can write while flushing
+    const bool flushed = metall_wait(flush);
+    assert(flushed);
+
+    // SIMD-friendly buffer
+    double* buf = metall_malloc_aligned(manager, sizeof(double) * 64, 64);
+    assert(((uintptr_t)buf % 64) == 0);
+
+    metall_memory_statistics stats;
+    const bool has_stats = metall_get_memory_statistics(manager, &stats, false);
+    assert(has_stats && stats.num_named_objects == 2);
+    char* json = metall_memory_statistics_json(manager);
+    assert(json != NULL);
+    free(json);
+    metall_free(manager, buf);
+
+    // Zero-copy export, e.g., to NumPy or Apache Arrow
+    double* values = metall_named_malloc(manager, "values", sizeof(double) * 8);
+    values[7] = 7.0;
+    metall_array_interface array;
+    const bool has_array = metall_find_array(manager, "values", "<f8", &array);
+    assert(has_array && array.data == values && array.length == 8);
+    struct ArrowArray arrow_array;
+    struct ArrowSchema arrow_schema;
+    const bool exported = metall_export_arrow_array(
+        manager, "values", "g", &arrow_array, &arrow_schema);
+    assert(exported && ((const double*)arrow_array.buffers[1])[7] == 7.0);
+    arrow_array.release(&arrow_array);
+    arrow_schema.release(&arrow_schema);
+    metall_named_free(manager, "values");
+
+    metall_close(manager);
+
+    metall_async_handle* copy = metall_copy_async("/tmp/metall3",
+                                                  "/tmp/metall3-copy");
+    const bool copied = metall_wait(copy);
+    assert(copied);
+    metall_remove("/tmp/metall3");
+    metall_remove("/tmp/metall3-copy");
+  }
+
   // Retrieve object snapshot
   {
     metall_manager* manager = metall_open("/tmp/metall2-snap");
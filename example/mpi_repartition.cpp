@@ -0,0 +1,65 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+// This example redistributes the datastore created by mpi_create, which can
+// have been created by a different number of MPI processes.
+
+#include <cstring>
+#include <iostream>
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/utility/metall_mpi_adaptor.hpp>
+#include <metall/utility/metall_mpi_repartition.hpp>
+
+using vector_type = metall::container::vector<int>;
+
+int main(int argc, char **argv) {
+  ::MPI_Init(&argc, &argv);
+  {
+    // Emits the value stored by each process of mpi_create
+    auto reader = [](const metall::manager &source,
+                     const metall::utility::repartition_emit_type &emit) {
+      const int *value = source.find<int>("my-rank").first;
+      if (!value) return;
+      emit(*value, std::string_view(reinterpret_cast<const char *>(value),
+                                    sizeof(int)));
+    };
+
+    // Inserts a received value into a vector in the new datastore
+    auto writer = [](metall::manager &destination,
+                     const std::string_view item) {
+      auto *vec = destination.find_or_construct<vector_type>("ranks")(
+          destination.get_allocator());
+      int value;
+      std::memcpy(&value, item.data(), sizeof(int));
+      vec->push_back(value);
+    };
+
+    const bool overwrite = true;
+    if (!metall::utility::repartition("/tmp/metall_mpi",
+                                      "/tmp/metall_mpi_repartitioned", reader,
+                                      writer, MPI_COMM_WORLD, overwrite)) {
+      std::cerr << "Failed to repartition" << std::endl;
+      ::MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+  }
+
+  {
+    metall::utility::metall_mpi_adaptor mpi_adaptor(
+        metall::open_read_only, "/tmp/metall_mpi_repartitioned");
+    const auto &metall_manager = mpi_adaptor.get_local_manager();
+
+    int rank;
+    ::MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::cout << "Rank " << rank << " received";
+    if (auto *vec = metall_manager.find<vector_type>("ranks").first) {
+      for (const auto value : *vec) std::cout << " " << value;
+    }
+    std::cout << std::endl;
+  }
+  ::MPI_Finalize();
+
+  return 0;
+}
@@ -13,7 +13,10 @@ static constexpr std::size_t k_num_mutexes = 2;
 void mutex_work(const int key, const int value, int* array) {
   {  // A mutex block
     const int index = key % k_num_mutexes;
-    auto guard = metall::utility::mutex::mutex_lock<k_num_mutexes>(index);
+    // spin_mutex suits short critical sections like this one;
+    // the default is std::mutex
+    auto guard = metall::utility::mutex::mutex_lock<
+        k_num_mutexes, metall::utility::mutex::spin_mutex>(index);
     array[index] = array[index] + value;  // do some mutex work
   }                                       // The mutex is released here
 }
@@ -7,13 +7,24 @@
 #define METALL_BASIC_MANAGER_HPP
 
 #include <cstddef>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include <metall/tags.hpp>
+#include <metall/manager_options.hpp>
+#include <metall/placement_hint.hpp>
 #include <metall/stl_allocator.hpp>
+#include <metall/global_stl_allocator.hpp>
 #include <metall/container/scoped_allocator.hpp>
 #include <metall/container/fallback_allocator.hpp>
+#include <metall/container/arena_allocator.hpp>
+#include <metall/container/node_pool_allocator.hpp>
 #include <metall/kernel/manager_kernel.hpp>
+#include <metall/kernel/concurrency_policy.hpp>
+#include <metall/detail/io_executor.hpp>
 #include <metall/detail/named_proxy.hpp>
 #include <metall/kernel/segment_storage.hpp>
 #include <metall/kernel/storage.hpp>
@@ -24,7 +35,8 @@ namespace metall {
 #if !defined(DOXYGEN_SKIP)
 // Forward declaration
 template <typename storage, typename segment_storage, typename chunk_no_type,
-          std::size_t k_chunk_size>
+          std::size_t k_chunk_size, typename size_class_table,
+          typename concurrency_policy>
 class basic_manager;
 #endif  // DOXYGEN_SKIP
 
@@ -33,10 +45,20 @@ class basic_manager;
 /// \tparam segment_storage Segment storage manager.
 /// \tparam chunk_no_type Type of chunk number.
 /// \tparam k_chunk_size Size of single chunk in byte.
+/// \tparam size_class_table Table of the small object sizes (size classes),
+/// e.g., kernel::size_class_table<8, 16, 24, 32, 40, 48, 56, 64, 72, 128>.
+/// A data store must be opened with the table it was created with.
+/// \tparam concurrency_policy kernel::multi_threaded or
+/// kernel::single_threaded. A single-threaded manager must be used by one
+/// thread at a time and skips the locks and the per-CPU object caches.
+/// Both kinds of managers can be used in the same program and open the same
+/// data stores (one at a time).
 template <typename storage = kernel::storage,
           typename segment_storage = kernel::segment_storage,
           typename chunk_no_type = uint32_t,
-          std::size_t k_chunk_size = (1ULL << 21ULL)>
+          std::size_t k_chunk_size = (1ULL << 21ULL),
+          typename size_class_table = kernel::default_size_class_table,
+          typename concurrency_policy = kernel::default_concurrency_policy>
 class basic_manager {
  public:
   // -------------------- //
@@ -46,7 +68,8 @@ class basic_manager {
   /// \brief Manager kernel type
   using manager_kernel_type =
       kernel::manager_kernel<storage, segment_storage, chunk_no_type,
-                             k_chunk_size>;
+                             k_chunk_size, size_class_table,
+                             concurrency_policy>;
 
   /// \brief Void pointer type
   using void_pointer = typename manager_kernel_type::void_pointer;
@@ -64,6 +87,24 @@ class basic_manager {
   template <typename T>
   using allocator_type = stl_allocator<T, manager_kernel_type>;
 
+  /// \brief Allocator type whose pointer type is compact_ptr, the 4-byte
+  /// pointer relative to the application data segment.
+  /// Can be constructed from get_allocator().
+  /// \warning set_segment_relative_ptr_base(get_address()) must be called
+  /// before using containers allocated by this allocator, and only one
+  /// datastore can hold such containers at a time in a process.
+  template <typename T>
+  using compact_allocator_type =
+      stl_allocator<T, manager_kernel_type, compact_ptr<void>>;
+
+  /// \brief Allocator type that holds no state and allocates from the
+  /// manager bound by bind_global_allocator(); thus, it adds no bytes to
+  /// containers, e.g., the inner containers of nested containers.
+  /// \warning Only one datastore can hold containers allocated by this
+  /// allocator at a time in a process.
+  template <typename T>
+  using global_allocator_type = global_stl_allocator<T, manager_kernel_type>;
+
   /// \brief Allocator type wrapped by scoped_allocator_adaptor
   template <typename OuterT, typename... InnerT>
   using scoped_allocator_type =
@@ -97,6 +138,34 @@ class basic_manager {
   using fallback_allocator =
       container::fallback_allocator_adaptor<allocator_type<T>>;
 
+  /// \brief A monotonic memory resource that takes large chunks from this
+  /// manager, for arena_allocator.
+  using arena_resource_type =
+      container::arena_resource<allocator_type<std::byte>>;
+
+  /// \brief A STL compatible allocator that bump-allocates from an
+  /// arena_resource_type instance and frees everything at once when the
+  /// resource is released or destroyed.
+  /// \code
+  /// auto *arena = manager.construct<arena_resource_type>("arena")(
+  ///     manager.get_allocator());
+  /// vector<int, arena_allocator<int>> vec(arena);
+  /// \endcode
+  template <typename T>
+  using arena_allocator =
+      container::arena_allocator_adaptor<allocator_type<T>>;
+
+  /// \brief Persistent free lists of small objects, for node_pool_allocator.
+  using node_pool_resource_type =
+      container::node_pool_resource<allocator_type<std::byte>>;
+
+  /// \brief A STL compatible allocator that allocates single objects, e.g.,
+  /// the nodes of node-based containers, from the free lists of a
+  /// node_pool_resource_type instance.
+  template <typename T>
+  using node_pool_allocator =
+      container::node_pool_allocator_adaptor<allocator_type<T>>;
+
   /// \brief Fallback allocator type wrapped by scoped_allocator_adaptor.
   template <typename T>
   using scoped_fallback_allocator_type =
@@ -140,12 +209,53 @@ class basic_manager {
   using anonymous_object_attribute_accessor_type =
       typename manager_kernel_type::anonymous_object_attr_accessor_type;
 
+  /// \brief The attributes of an object read by read_object_attributes()
+  using object_attribute_type =
+      typename manager_kernel_type::object_attribute_type;
+
   /// \brief Chunk number type (= chunk_no_type)
   using chunk_number_type = chunk_no_type;
 
   /// \brief Path type
   using path_type = typename manager_kernel_type::path_type;
 
+  /// \brief A handle to a named or unique object (see find_handle())
+  template <typename T>
+  using object_handle =
+      typename manager_kernel_type::template object_handle<T>;
+
+  /// \brief Memory usage statistics (see get_memory_statistics())
+  using memory_statistics_type = kernel::memory_statistics;
+
+  /// \brief Allocation counters (see get_memory_counters())
+  using memory_counters_type = kernel::memory_counters;
+
+  /// \brief Page statistics (see get_page_statistics())
+  using page_statistics_type = kernel::page_statistics;
+
+  /// \brief Phase timings type
+  using phase_timings_type = kernel::phase_timings;
+
+  /// \brief Memory tiering policy (see migrate_cold_chunks())
+  using memory_tiering_policy_type = kernel::memory_tiering_policy;
+
+  /// \brief Memory tiering result (see migrate_cold_chunks())
+  using memory_tiering_result_type = kernel::memory_tiering_result;
+
+  /// \brief Chunk heat statistics (see sample_chunk_heat())
+  using chunk_heat_statistics_type = kernel::chunk_heat_statistics;
+
+  /// \brief Background checkpointing options (see start_checkpointing())
+  using checkpoint_options_type = kernel::checkpoint_options;
+
+  /// \brief Background checkpoint report (see start_checkpointing())
+  using checkpoint_report_type = kernel::checkpoint_report;
+
+  /// \brief Access pattern type (see set_access_pattern())
+  using access_pattern_type = kernel::access_pattern;
+
+  class placement_hint_scope;
+
  private:
   // -------------------- //
   // Private types and static values
@@ -153,7 +263,8 @@ class basic_manager {
   using char_ptr_holder_type =
       typename manager_kernel_type::char_ptr_holder_type;
   using self_type =
-      basic_manager<storage, segment_storage, chunk_no_type, k_chunk_size>;
+      basic_manager<storage, segment_storage, chunk_no_type, k_chunk_size,
+                    size_class_table, concurrency_policy>;
 
  public:
   // -------------------- //
@@ -161,10 +272,14 @@ class basic_manager {
   // -------------------- //
 
   /// \brief Opens an existing data store.
+  /// The allocator management data is loaded at the first allocation or
+  /// deallocation; opening a data store only to find objects is cheap.
   /// \param base_path Path to a data store.
-  basic_manager(open_only_t, const path_type &base_path) noexcept {
+  /// \param options Runtime options.
+  basic_manager(open_only_t, const path_type &base_path,
+                const manager_options &options = manager_options()) noexcept {
     try {
-      m_kernel = std::make_unique<manager_kernel_type>();
+      m_kernel = std::make_unique<manager_kernel_type>(options);
       m_kernel->open(base_path);
     } catch (...) {
       m_kernel.reset(nullptr);
@@ -175,10 +290,14 @@ class basic_manager {
 
   /// \brief Opens an existing data store with the read only mode.
   /// Write accesses will cause segmentation fault.
+  /// The pages can be loaded and pinned when it is opened, e.g., for a server
+  /// that needs fault-free accesses (see manager_options::prefault_on_open).
   /// \param base_path Path to a data store.
-  basic_manager(open_read_only_t, const path_type &base_path) noexcept {
+  /// \param options Runtime options.
+  basic_manager(open_read_only_t, const path_type &base_path,
+                const manager_options &options = manager_options()) noexcept {
     try {
-      m_kernel = std::make_unique<manager_kernel_type>();
+      m_kernel = std::make_unique<manager_kernel_type>(options);
       m_kernel->open_read_only(base_path);
     } catch (...) {
       m_kernel.reset(nullptr);
@@ -187,11 +306,55 @@ class basic_manager {
     }
   }
 
+  /// \brief Opens an existing data store with the read only mode while a
+  /// writer process keeps it open with open_only (the live read-only mode).
+  /// This manager sees the version the writer published last by publish()
+  /// and moves to a newer version by refresh(). Opening and refreshing do not
+  /// copy the data store: the segment is shared with the writer through the
+  /// page cache.
+  /// Objects are found by find(); the other functions that use the object
+  /// directories, e.g., iterating objects, see no object.
+  /// Write accesses will cause segmentation fault.
+  /// \param base_path Path to a data store.
+  basic_manager(open_live_read_only_t, const path_type &base_path) noexcept {
+    try {
+      m_kernel = std::make_unique<manager_kernel_type>();
+      m_kernel->open_live_read_only(base_path);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
+  /// \brief Opens an existing data store with the copy-on-write mode.
+  /// The data store is mapped privately: objects can be allocated and
+  /// modified as usual, but nothing is written back to the data store, which
+  /// can be read only. The changes are discarded when the manager is
+  /// destroyed. Multiple processes can open the same data store in this mode,
+  /// sharing the unmodified pages through the page cache.
+  /// Taking a snapshot is not supported in this mode.
+  /// \param base_path Path to a data store.
+  /// \param options Runtime options.
+  basic_manager(open_copy_on_write_t, const path_type &base_path,
+                const manager_options &options = manager_options()) noexcept {
+    try {
+      m_kernel = std::make_unique<manager_kernel_type>(options);
+      m_kernel->open_copy_on_write(base_path);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
   /// \brief Creates a new data store (an existing data store will be
   /// overwritten). \param base_path Path to create a data store.
-  basic_manager(create_only_t, const path_type &base_path) noexcept {
+  /// \param options Runtime options.
+  basic_manager(create_only_t, const path_type &base_path,
+                const manager_options &options = manager_options()) noexcept {
     try {
-      m_kernel = std::make_unique<manager_kernel_type>();
+      m_kernel = std::make_unique<manager_kernel_type>(options);
       m_kernel->create(base_path);
     } catch (...) {
       m_kernel.reset(nullptr);
@@ -207,10 +370,12 @@ class basic_manager {
   // The actual limit could be smaller or larger than this value, depending on
   // the internal implementation. The gap between the hint and the actual limit
   // will be reasonable (e.g., less than a few chunk sizes).
+  /// \param options Runtime options.
   basic_manager(create_only_t, const path_type &base_path,
-                const size_type capacity) noexcept {
+                const size_type capacity,
+                const manager_options &options = manager_options()) noexcept {
     try {
-      m_kernel = std::make_unique<manager_kernel_type>();
+      m_kernel = std::make_unique<manager_kernel_type>(options);
       m_kernel->create(base_path, capacity);
     } catch (...) {
       m_kernel.reset(nullptr);
@@ -223,7 +388,9 @@ class basic_manager {
   basic_manager() = delete;
 
   /// \brief Destructor.
-  ~basic_manager() noexcept = default;
+  /// Releases the binding made by bind_global_allocator() if this manager is
+  /// bound.
+  ~basic_manager() noexcept { unbind_global_allocator(); }
 
   /// \brief Deleted.
   basic_manager(const basic_manager &) = delete;
@@ -236,8 +403,16 @@ class basic_manager {
   basic_manager &operator=(const basic_manager &) = delete;
 
   /// \brief Move assignment operator.
+  /// Releases the binding made by bind_global_allocator() if this manager is
+  /// bound before taking the other one's data store.
   /// \return An reference to the object.
-  basic_manager &operator=(basic_manager &&) noexcept = default;
+  basic_manager &operator=(basic_manager &&other) noexcept {
+    if (this != &other) {
+      unbind_global_allocator();
+      m_kernel = std::move(other.m_kernel);
+    }
+    return *this;
+  }
 
   // -------------------- //
   // Public methods
@@ -429,6 +604,181 @@ class basic_manager {
     return std::make_pair(nullptr, 0);
   }
 
+  /// \brief Constructs named objects of the same type at once, e.g., many
+  /// small per-key objects. Cheaper than calling construct() for each name,
+  /// as the objects are allocated in a batch and are registered under a
+  /// single lock.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Fails without constructing any object if any of the names already
+  /// exists or is duplicated. Every object is constructed with a copy of the
+  /// same arguments. If a constructor throws, the objects constructed so far
+  /// are destroyed and the exception is rethrown. Each object is destroyed
+  /// individually, e.g., by destroy().
+  /// \code
+  /// auto objects = manager.construct_many<int>({"a", "b", "c"}, 10);
+  /// \endcode
+  ///
+  /// \tparam T The type of the objects.
+  /// \param names The names of the objects.
+  /// \param args The arguments passed to the constructor of each object.
+  /// \return Returns the pointers to the objects in the order of the names.
+  /// Returns an empty vector on failure.
+  template <typename T, typename... Args>
+  std::vector<T *> construct_many(const std::vector<std::string> &names,
+                                  const Args &...args) {
+    std::vector<T *> objects;
+    if (!check_sanity()) {
+      return objects;
+    }
+    m_kernel->template construct_many<T>(names, &objects, args...);
+    return objects;
+  }
+
+  /// \brief Constructs an array of objects of type T with multiple threads,
+  /// e.g., a large array whose construction is bound by page faults.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Same as construct<T>(name)[length](args...), except that the objects
+  /// are constructed by the threads in parallel.
+  /// If 'args' is empty and T is trivially default constructible, the
+  /// objects are not written at all when the allocated memory is known to be
+  /// zero-filled, i.e., it has never been used since the datastore was
+  /// created or opened, as they are value-initialized already.
+  /// If a constructor throws, the constructed objects are destroyed, the
+  /// memory is freed, and one of the exceptions is rethrown.
+  /// \code
+  /// auto *array = manager.construct_parallel<double>("array", 1 << 30, 0);
+  /// \endcode
+  ///
+  /// \tparam T The type of the objects.
+  /// \param name The name of the array.
+  /// \param length The number of objects.
+  /// \param num_threads The maximum number of threads to use. If <= 0 is
+  /// given, it is automatically determined.
+  /// \param args The arguments passed to the constructor of each object.
+  /// \return Returns a pointer to the array. Returns nullptr on error or if
+  /// the name already exists.
+  template <typename T, typename... Args>
+  T *construct_parallel(char_ptr_holder_type name, const size_type length,
+                        const int num_threads, const Args &...args) {
+    if (!check_sanity()) {
+      return nullptr;
+    }
+    return m_kernel->template construct_parallel<T>(name, length, false,
+                                                    num_threads, args...);
+  }
+
+  /// \brief Finds an array or constructs it with multiple threads.
+  /// See construct_parallel() for the details.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe_alloc
+  template <typename T, typename... Args>
+  T *find_or_construct_parallel(char_ptr_holder_type name,
+                                const size_type length, const int num_threads,
+                                const Args &...args) {
+    if (!check_sanity()) {
+      return nullptr;
+    }
+    return m_kernel->template construct_parallel<T>(name, length, true,
+                                                    num_threads, args...);
+  }
+
+  /// \brief Constructs an array of objects of type T with multiple threads,
+  /// receiving arguments from iterators.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Same as construct_it<T>(name)[length](it1, it2...), except that the
+  /// objects are constructed by the threads in parallel; thus, the iterators
+  /// must be random access iterators. The i-th object receives (it1[i],
+  /// it2[i],...). See construct_parallel() for the other details.
+  /// \code
+  /// auto *array = manager.construct_it_parallel<int>("array", vec.size(), 0,
+  ///                                                  vec.begin());
+  /// \endcode
+  ///
+  /// \tparam T The type of the objects.
+  /// \param name The name of the array.
+  /// \param length The number of objects.
+  /// \param num_threads The maximum number of threads to use. If <= 0 is
+  /// given, it is automatically determined.
+  /// \param iterators The iterators to take the arguments from.
+  /// \return Returns a pointer to the array. Returns nullptr on error or if
+  /// the name already exists.
+  template <typename T, typename... Iterators>
+  T *construct_it_parallel(char_ptr_holder_type name, const size_type length,
+                           const int num_threads, Iterators... iterators) {
+    static_assert(
+        (std::is_base_of_v<std::random_access_iterator_tag,
+                           typename std::iterator_traits<
+                               Iterators>::iterator_category> &&
+         ...),
+        "construct_it_parallel requires random access iterators");
+    if (!check_sanity()) {
+      return nullptr;
+    }
+    return m_kernel->template construct_it_parallel<T>(
+        name, length, false, num_threads, iterators...);
+  }
+
+  /// \brief Finds an object and returns a handle to it, which finds the
+  /// object again without hashing and comparing the name, e.g., for looking
+  /// up the same objects repeatedly.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe
+  ///
+  /// \details
+  /// A handle becomes stale when any named or unique object is destroyed;
+  /// find() with a stale handle returns nullptr, and find_handle() has to be
+  /// called again. A handle must be used only with the manager that made
+  /// it. Anonymous objects cannot be found.
+  /// \code
+  /// auto handle = manager.find_handle<int>("obj");
+  /// int *p = manager.find(handle).first;
+  /// \endcode
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object or unique_instance.
+  /// \return Returns a handle. It is not valid (see object_handle::valid())
+  /// if the object is not found.
+  template <typename T>
+  object_handle<T> find_handle(char_ptr_holder_type name) const noexcept {
+    if (!check_sanity()) {
+      return object_handle<T>();
+    }
+
+    try {
+      return m_kernel->template find_handle<T>(name);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+
+    return object_handle<T>();
+  }
+
+  /// \brief Finds an object by a handle returned by find_handle().
+  /// \copydoc doc_thread_safe
+  ///
+  /// \tparam T The type of the object.
+  /// \param handle A handle.
+  /// \return Returns a pointer to the object and the count (if it is not an
+  /// array, returns 1). If the handle is not valid or stale, nullptr is
+  /// returned.
+  template <typename T>
+  std::pair<T *, size_type> find(
+      const object_handle<T> &handle) const noexcept {
+    if (!check_sanity()) {
+      return std::make_pair(nullptr, 0);
+    }
+    return m_kernel->template find<T>(handle);
+  }
+
   /// \brief Destroys a previously created object.
   /// Calls the destructor and frees the memory.
   /// \copydoc doc_object_attrb_obj_family
@@ -490,6 +840,63 @@ class basic_manager {
     return m_kernel->template destroy<T>(metall::unique_instance);
   }
 
+  /// \brief Destroys a previously created array with multiple threads.
+  /// Calls the destructors and frees the memory.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Same as destroy(), except that the destructors of the objects are
+  /// called by the threads in parallel, e.g., to destroy a large array of
+  /// containers. The destructors must be safe to call concurrently, i.e.,
+  /// the objects must not share data they modify.
+  /// The destructors must not throw.
+  /// \code
+  /// using vec_type = metall::container::vector<int>;
+  /// bool destroyed = manager.destroy_parallel<vec_type>("vectors", 0);
+  /// \endcode
+  ///
+  /// \tparam T The type of the objects.
+  /// \param name The name of the array or unique_instance.
+  /// \param num_threads The maximum number of threads to use. If <= 0 is
+  /// given, it is automatically determined.
+  /// \return Returns false if the array was not destroyed.
+  template <typename T>
+  bool destroy_parallel(char_ptr_holder_type name, const int num_threads) {
+    if (!check_sanity()) {
+      return false;
+    }
+    return m_kernel->template destroy_parallel<T>(name, num_threads);
+  }
+
+  /// \brief Removes a previously created object and frees its memory without
+  /// calling the destructors, e.g., to discard a large data structure
+  /// quickly.
+  /// \copydoc doc_object_attrb_obj_family
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// The memory the object owns is not freed. Thus, this function suits
+  /// self-contained objects, e.g., a container that allocates its memory
+  /// from a dedicated arena (see container::arena_resource); destroying or
+  /// releasing the arena frees that memory in bulk, a chunk at a time,
+  /// instead of freeing each element.
+  /// \code
+  /// manager.drop<map_type>("map");
+  /// manager.destroy<arena_resource_type>("map_arena");
+  /// \endcode
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object or unique_instance.
+  /// \return Returns false if the object was not removed.
+  template <typename T>
+  bool drop(char_ptr_holder_type name) {
+    if (!check_sanity()) {
+      return false;
+    }
+    return m_kernel->template drop<T>(name);
+  }
+
   /// \brief Destroys a object (named, unique, or anonymous) by its address.
   /// Calls the destructor and frees the memory.
   /// Cannot destroy an object not allocated by construct/find_or_construct
@@ -701,6 +1108,65 @@ class basic_manager {
     return false;
   }
 
+  /// \brief Sets the access pattern of an object created with
+  /// construct/find_or_construct, which is given to the kernel as a memory
+  /// advice on its pages now and every time the datastore is opened until
+  /// the object is destroyed, e.g., not to read ahead a hash table or to
+  /// read ahead a vector that is scanned.
+  /// The pattern is recorded only if the datastore is opened with the write
+  /// mode; otherwise, it is applied only to this process.
+  /// \copydoc doc_object_attrb_obj_const_thread_safe
+  ///
+  /// \details
+  /// Example:
+  /// \code
+  /// auto *table = manager.construct<table_type>("table")(...);
+  /// manager.set_access_pattern(table->data(),
+  ///                            manager_type::access_pattern_type::random);
+  /// \endcode
+  ///
+  /// \tparam T The type of the object.
+  /// \param ptr A pointer to the object.
+  /// \param pattern The access pattern. access_pattern_type::normal clears
+  /// the pattern set before.
+  /// \return Returns false if the object is not found or on error.
+  template <class T>
+  bool set_access_pattern(const T *ptr,
+                          const access_pattern_type pattern) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->set_access_pattern(ptr, pattern);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns the access pattern set to an object by
+  /// set_access_pattern().
+  /// \copydoc doc_object_attrb_obj_const_thread_safe
+  ///
+  /// \tparam T The type of the object.
+  /// \param ptr A pointer to the object.
+  /// \return The access pattern; access_pattern_type::normal if none is set
+  /// or on error.
+  template <class T>
+  access_pattern_type get_access_pattern(const T *ptr) const noexcept {
+    if (!check_sanity()) {
+      return access_pattern_type::normal;
+    }
+    try {
+      return m_kernel->get_access_pattern(ptr);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return access_pattern_type::normal;
+  }
+
   /// \brief Returns Returns the number of named objects stored in the managed
   /// segment.
   /// \copydoc doc_object_attrb_obj_family
@@ -897,14 +1363,40 @@ class basic_manager {
     return nullptr;
   }
 
+  /// \brief Allocates nbytes bytes filled with zeros, like calloc().
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Large memory that is known to be zero-filled, i.e., memory in chunks
+  /// that have never been used since the datastore was created or opened or
+  /// whose file space has been freed, is not written; thus, its pages are
+  /// not touched until they are used.
+  /// \param nbytes Number of bytes to allocate.
+  /// \return Returns a pointer to the allocated memory.
+  void *allocate_zeroed(size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return nullptr;
+    }
+    try {
+      return m_kernel->allocate_zeroed(nbytes);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return nullptr;
+  }
+
   /// \brief Allocates nbytes bytes. The address of the allocated memory will be
   /// a multiple of alignment.
   /// \copydoc doc_thread_safe_alloc
   ///
   /// \param nbytes Number of bytes to allocate. Must
-  /// be a multiple alignment.
+  /// be a multiple alignment if alignment is not larger than the chunk size.
   /// \param alignment Alignment size. Alignment must be a power of two and
-  /// satisfy [min allocation size, system page size].
+  /// equal to or larger than the min allocation size.
+  /// An alignment larger than the chunk size, up to 1 GB with the default
+  /// segment storage, places the allocation at an aligned run of chunks.
   /// \return Returns a pointer to the allocated memory.
   void *allocate_aligned(size_type nbytes, size_type alignment) noexcept {
     if (!check_sanity()) {
@@ -920,77 +1412,946 @@ class basic_manager {
     return nullptr;
   }
 
-  // void allocate_many(const std::nothrow_t &tag, size_type elem_bytes,
-  // size_type n_elements, multiallocation_chain &chain);
-
-  /// \brief Deallocates the allocated memory.
+  /// \brief Allocates nbytes bytes with a placement hint.
+  /// Small objects allocated with the same hint share chunks.
   /// \copydoc doc_thread_safe_alloc
   ///
-  /// \param addr A pointer to the allocated memory to be deallocated.
-  void deallocate(void *addr) noexcept {
+  /// \param nbytes Number of bytes to allocate.
+  /// \param hint A placement hint. See placement_hint_scope.
+  /// \return Returns a pointer to the allocated memory.
+  /// Returns nullptr if the hint is out of range.
+  void *allocate(size_type nbytes, const placement_hint hint) noexcept {
+    if (hint.id >= num_placement_hints()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Placement hint is out of range");
+      return nullptr;
+    }
+    placement_hint_scope scope(hint);
+    return allocate(nbytes);
+  }
+
+  /// \brief Sets the segment size limits, replacing the ones given by
+  /// manager_options. Must not be called concurrently with allocations.
+  /// \param soft_limit A soft limit in bytes; 0 disables it.
+  /// \param hard_limit A hard limit in bytes; 0 disables it.
+  /// An allocation that needs the segment to grow beyond the hard limit
+  /// fails, returning nullptr, and the manager stays usable.
+  /// \return Returns false on error.
+  bool set_segment_size_limits(const size_type soft_limit,
+                               const size_type hard_limit) noexcept {
     if (!check_sanity()) {
-      return;
+      return false;
     }
     try {
-      return m_kernel->deallocate(addr);
+      m_kernel->set_segment_size_limits(soft_limit, hard_limit);
+      return true;
     } catch (...) {
       m_kernel.reset(nullptr);
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "An exception has been thrown");
     }
+    return false;
   }
 
-  // void deallocate_many(multiallocation_chain &chain);
-
-  /// \brief Check if all allocated memory has been deallocated.
-  /// \copydoc doc_no_alloc_thread_safe
-  ///
-  /// \details
-  /// This function is not cheap if many objects has not been deallocated.
-  /// \return Returns
-  /// true if all allocated memory has been deallocated; otherwise, false.
-  bool all_memory_deallocated() const noexcept {
+  /// \brief Sets a function called when the segment reaches a size limit,
+  /// e.g., to trigger eviction, flush, or compaction.
+  /// Must not be called concurrently with allocations.
+  /// \param handler A function that takes the limit reached and the segment
+  /// size the allocation needed. It is called by the allocating thread and
+  /// can call this manager, e.g., compact() or deallocate().
+  /// \return Returns false on error.
+  bool set_segment_limit_handler(segment_limit_handler handler) noexcept {
     if (!check_sanity()) {
       return false;
     }
-
     try {
-      return m_kernel->all_memory_deallocated();
+      m_kernel->set_segment_limit_handler(std::move(handler));
+      return true;
     } catch (...) {
+      m_kernel.reset(nullptr);
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "An exception has been thrown");
     }
     return false;
   }
 
-  // ---------- Flush ---------- //
-  /// \brief Flush data to persistent memory.
-  /// \copydoc doc_single_thread
+  /// \brief Returns the number of placement hints
+  /// (METALL_NUM_PLACEMENT_HINTS).
+  /// \return The number of placement hints.
+  static constexpr size_type num_placement_hints() noexcept {
+    return manager_kernel_type::num_placement_hints();
+  }
+
+  /// \brief Changes the size of allocated memory, as realloc() does.
+  /// \copydoc doc_thread_safe_alloc
   ///
-  /// \param synchronous If true, performs synchronous operation;
-  /// otherwise, performs asynchronous operation.
-  void flush(const bool synchronous = true) noexcept {
+  /// \details
+  /// A large allocation is grown in place if the memory space right after it
+  /// is unused and shrunk in place by releasing its tail; otherwise, new
+  /// memory is allocated, the data is copied, and the old memory is
+  /// deallocated.
+  /// \param addr A pointer to the allocated memory. If nullptr, this function
+  /// works as allocate(nbytes).
+  /// \param nbytes The new size in bytes. If 0, deallocates 'addr' and returns
+  /// nullptr.
+  /// \return Returns a pointer to the resized memory.
+  /// On error, returns nullptr and the original memory is not changed.
+  /// \warning Use 'nbytes' as the size of the memory afterwards, e.g., when
+  /// calling deallocate(addr, nbytes).
+  void *reallocate(void *addr, size_type nbytes) noexcept {
     if (!check_sanity()) {
-      return;
+      return nullptr;
     }
     try {
-      m_kernel->flush(synchronous);
+      return m_kernel->reallocate(addr, nbytes);
     } catch (...) {
       m_kernel.reset(nullptr);
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "An exception has been thrown");
     }
+    return nullptr;
   }
 
-  // -------- Snapshot, copy, data store management -------- //
-  /// \brief Takes a snapshot of the current data. The snapshot has a new UUID.
-  /// \copydoc doc_single_thread
+  /// \brief Tries to change the size of allocated memory without moving it.
+  /// \copydoc doc_thread_safe_alloc
   ///
-  /// \param destination_path Path to store a snapshot.
-  /// \param clone Use the file clone mechanism (reflink) instead of normal copy
-  /// if it is available. \param num_max_copy_threads The maximum number of copy
-  /// threads to use. If <= 0 is given, the value is automatically determined.
-  /// \return Returns true on success; other false.
+  /// \param addr A pointer to the allocated memory.
+  /// \param nbytes The new size in bytes.
+  /// \return Returns true if the memory now has the size of 'nbytes' bytes.
+  /// Returns false if the memory has to be moved; then, the memory is not
+  /// changed.
+  bool resize_in_place(void *addr, size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->resize_in_place(addr, nbytes);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Allocates 'n' objects of 'nbytes' bytes at once.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Small objects are allocated taking the internal lock only once instead of
+  /// 'n' times. This function is useful to allocate many objects of the same
+  /// size in a burst.
+  /// \param nbytes Number of bytes of each object.
+  /// \param n Number of objects to allocate.
+  /// \param addrs A buffer to store the addresses of the allocated objects.
+  /// Must be able to hold 'n' elements.
+  /// \return Returns the number of allocated objects.
+  /// Allocated addresses are stored from the front of 'addrs' and the rest of
+  /// the elements are set to nullptr.
+  size_type allocate_many(size_type nbytes, size_type n,
+                          void **addrs) noexcept {
+    if (!check_sanity()) {
+      return 0;
+    }
+    try {
+      return m_kernel->allocate_many(nbytes, n, addrs);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return 0;
+  }
+
+  /// \brief Deallocates the allocated memory.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \param addr A pointer to the allocated memory to be deallocated.
+  void deallocate(void *addr) noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    try {
+      return m_kernel->deallocate(addr);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
+  /// \brief Deallocates the allocated memory whose size is known.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// This function is faster than deallocate(addr) as it does not look up the
+  /// size of the memory.
+  /// \param addr A pointer to the allocated memory to be deallocated.
+  /// \param nbytes The size given to allocate() when the memory was allocated.
+  /// Passing a different size results in undefined behavior.
+  void deallocate(void *addr, size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    try {
+      return m_kernel->deallocate(addr, nbytes);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
+  /// \brief Deallocates multiple objects at once.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Consecutive small objects of the same size are deallocated taking the
+  /// internal lock only once.
+  /// \param addrs Pointers to the allocated memory to be deallocated.
+  /// nullptr elements are ignored.
+  /// \param n Number of elements in 'addrs'.
+  void deallocate_many(void *const *addrs, size_type n) noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    try {
+      return m_kernel->deallocate_many(addrs, n);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
+  /// \brief Check if all allocated memory has been deallocated.
+  /// \copydoc doc_no_alloc_thread_safe
+  ///
+  /// \details
+  /// This function is not cheap if many objects has not been deallocated.
+  /// \return Returns
+  /// true if all allocated memory has been deallocated; otherwise, false.
+  bool all_memory_deallocated() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+
+    try {
+      return m_kernel->all_memory_deallocated();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  // ---------- Flush ---------- //
+  /// \brief Flush data to persistent memory.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param synchronous If true, performs synchronous operation;
+  /// otherwise, performs asynchronous operation.
+  void flush(const bool synchronous = true) noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    try {
+      m_kernel->flush(synchronous);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+  }
+
+  /// \brief Moves the segment of a volatile datastore
+  /// (manager_options::volatile_segment) from anonymous memory to files in
+  /// the datastore directory, from the oldest blocks, until the resident
+  /// anonymous memory is at most 'memory_budget' bytes. The spilled blocks
+  /// are then paged by the kernel as usual.
+  /// \copydoc doc_single_thread
+  /// \warning No other threads may access the segment during this call.
+  ///
+  /// \param memory_budget The max number of bytes to keep in memory.
+  /// \param num_spilled_bytes If not nullptr, the number of bytes spilled is
+  /// stored.
+  /// \return Returns false if the datastore is not volatile or on error.
+  bool spill(const size_type memory_budget,
+             size_type *const num_spilled_bytes = nullptr) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->spill(memory_budget, num_spilled_bytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Flushes data to persistent memory asynchronously.
+  /// Stores the management data and writes back the application data in
+  /// background. Unlike flush(), the application can keep using this manager,
+  /// including writing data, while the data is written back; the data written
+  /// after this call may or may not be flushed by this operation.
+  /// \copydoc doc_single_thread
+  /// \details Only this call must not run concurrently with other operations;
+  /// the background work does not block them.
+  /// The next flush(), flush_async(), snapshot(), or closing the manager waits
+  /// for the running flush.
+  ///
+  /// \param num_max_threads The maximum number of threads to write back
+  /// data. If <= 0 is given, the value is automatically determined.
+  /// \return Returns an object of std::future. If succeeded, its get() returns
+  /// true; otherwise, false.
+  std::future<bool> flush_async(const int num_max_threads = 0) noexcept {
+    if (!check_sanity()) {
+      return std::future<bool>();
+    }
+    try {
+      return m_kernel->flush_async(num_max_threads);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return std::future<bool>();
+  }
+
+  /// \brief Starts writing back the application data periodically in a
+  /// background thread, so that the application does not call flush() on
+  /// timers. Every options.interval, the dirty bytes of the segment are
+  /// found in /proc/self/smaps; if there are at least
+  /// options.dirty_bytes_threshold bytes, only the mappings that have dirty
+  /// pages are written back, in slices, through the I/O thread pool, at most
+  /// options.max_bytes_per_second dirty bytes per second (token bucket).
+  /// options.on_checkpoint receives the latency of each checkpoint.
+  /// Unlike flush(), the segment is not protected while written back, i.e.,
+  /// the application keeps writing data; the data written during a
+  /// checkpoint may or may not be written back by it. As flush() does, the
+  /// checkpoints do not store the management data.
+  /// Restarts the checkpointing with the new options if it is running.
+  /// Closing the manager stops it.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param options The options.
+  /// \return Returns true on success; false if the datastore is not writable
+  /// to its files (e.g., read-only, copy-on-write, volatile, or the
+  /// write-back cache mode) or on error.
+  bool start_checkpointing(
+      const checkpoint_options_type &options =
+          checkpoint_options_type()) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->start_checkpointing(options);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Stops the checkpointing started by start_checkpointing().
+  /// A running checkpoint stops after the slices being written back.
+  /// \copydoc doc_single_thread
+  void stop_checkpointing() noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    m_kernel->stop_checkpointing();
+  }
+
+  /// \brief Returns true if the background checkpointing is running.
+  /// \copydoc doc_single_thread
+  bool checkpointing() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    return m_kernel->checkpointing();
+  }
+
+  // ---------- Live sharing ---------- //
+  /// \brief Publishes the named and unique objects and the segment size as a
+  /// new version to the readers that opened the data store with
+  /// open_live_read_only.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \details The data written before this call is visible to the readers
+  /// that see the version; object data is not copied, i.e., the readers
+  /// also see the later changes to the objects. Objects must not be
+  /// destroyed while the readers can use them through a version; a reader
+  /// cannot use a version after the next two are published.
+  /// \return Returns true on success; false if this manager is not opened
+  /// with open_only or create_only, or on error.
+  bool publish() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->publish();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Moves a manager opened with open_live_read_only to the latest
+  /// published version.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \details Objects found before this call stay accessible.
+  /// \return Returns true on success, including when there is no new
+  /// version; false if this manager is not opened with open_live_read_only,
+  /// or on error.
+  bool refresh() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->refresh();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns the version this manager published last, or the version
+  /// it sees if opened with open_live_read_only.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return The version number; 0 if there is no such version.
+  std::uint64_t published_version() const noexcept {
+    if (!check_sanity()) {
+      return 0;
+    }
+    try {
+      return m_kernel->published_version();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return 0;
+  }
+
+  // ---------- Compaction ---------- //
+  /// \brief Compacts the memory space used by small objects.
+  /// \copydoc doc_thread_safe_alloc
+  ///
+  /// \details
+  /// Gives back the memory pages (and the file space, if available) of
+  /// partially occupied chunks that hold no objects, and makes the following
+  /// small allocations reuse the fullest chunks first so that sparsely
+  /// occupied chunks can become empty and be freed as a whole.
+  /// Objects are not moved, i.e., pointers to them stay valid.
+  /// Objects held by the internal object cache are not freed; to compact an
+  /// aged datastore thoroughly, open it, call this function, and close it
+  /// before using it.
+  /// \return Returns true on success; false on error, e.g., the manager was
+  /// opened as read-only.
+  bool compact() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->compact();
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  // -------- Snapshot, copy, data store management -------- //
+  /// \brief Loads the pages of a region into memory in parallel so that the
+  /// following accesses to the region, e.g., traversing a graph right after
+  /// opening a datastore, do not take a page fault per page.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment.
+  bool prefetch(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->prefetch(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Loads the whole application data segment into memory in
+  /// parallel. See METALL_PREFETCH_ON_OPEN to do it when opening a datastore.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true on success; false on error.
+  bool prefetch() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->prefetch(m_kernel->get_segment(),
+                                m_kernel->get_segment_size());
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Loads the memory of a named object into memory in parallel.
+  /// Only the object(s) itself is loaded, e.g., the elements of a vector
+  /// that are allocated separately are not.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool warm_up(char_ptr_holder_type name) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return prefetch(ptr, sizeof(T) * length);
+  }
+
+  /// \brief Pins the pages of a region in memory so that they stay cached
+  /// while other data, e.g., a large array scanned once, goes through the
+  /// page cache. The region is rounded to the page boundaries.
+  /// The pinned pages count against METALL_SEGMENT_MAX_PINNED_SIZE and
+  /// RLIMIT_MEMLOCK. Pinned pages are not freed by deallocation.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment or exceeds the limits.
+  bool pin(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->pin(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Pins the memory of a named object in memory.
+  /// Only the object(s) itself is pinned, e.g., the elements of a vector
+  /// that are allocated separately are not.
+  /// \copydoc doc_single_thread
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool pin(char_ptr_holder_type name) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return pin(ptr, sizeof(T) * length);
+  }
+
+  /// \brief Unpins the pages of a region.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error.
+  bool unpin(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->unpin(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Unpins the memory of a named object.
+  /// \copydoc doc_single_thread
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool unpin(char_ptr_holder_type name) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return unpin(ptr, sizeof(T) * length);
+  }
+
+  /// \brief Returns the number of the bytes pinned in memory.
+  /// \copydoc doc_single_thread
+  ///
+  /// \return The number of the bytes pinned in memory.
+  size_type pinned_size() const noexcept {
+    if (!check_sanity()) {
+      return 0;
+    }
+    try {
+      return m_kernel->pinned_size();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return 0;
+  }
+
+  /// \brief Registers the pages of a region to CUDA as pinned (page-locked)
+  /// host memory, so that GPU kernels read it directly, e.g., as mapped
+  /// memory, and copies from it are not staged. The region is rounded to the
+  /// page boundaries and must not overlap a registered region.
+  /// The region is unregistered when the manager is closed.
+  /// Requires METALL_USE_CUDA.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment or Metall is built without CUDA.
+  bool gpu_register(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->gpu_register(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Registers the memory of a named object to CUDA.
+  /// Only the object(s) itself is registered, e.g., the elements of a vector
+  /// that are allocated separately are not.
+  /// \copydoc doc_single_thread
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool gpu_register(char_ptr_holder_type name) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return gpu_register(ptr, sizeof(T) * length);
+  }
+
+  /// \brief Unregisters a region registered by gpu_register().
+  /// \copydoc doc_single_thread
+  ///
+  /// \param addr The address given to gpu_register().
+  /// \param nbytes The size given to gpu_register().
+  /// \return Returns true on success; false on error.
+  bool gpu_unregister(const void *const addr,
+                      const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->gpu_unregister(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Unregisters the memory of a named object from CUDA.
+  /// \copydoc doc_single_thread
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool gpu_unregister(char_ptr_holder_type name) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return gpu_unregister(ptr, sizeof(T) * length);
+  }
+
+  /// \brief Loads a region into a device buffer.
+  /// If Metall is built with METALL_USE_CUFILE, the pieces of the region
+  /// backed by block files are read with cuFile (GPUDirect Storage), i.e.,
+  /// straight from storage into device memory, skipping the page faults and
+  /// the copy through host memory; their dirty pages are written back first.
+  /// The other pieces are copied from the mapped segment.
+  /// Requires METALL_USE_CUDA.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param device_buffer A device buffer of at least nbytes bytes.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment or Metall is built without CUDA.
+  bool load_to_device(const void *const addr, const size_type nbytes,
+                      void *const device_buffer) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->load_to_device(addr, nbytes, device_buffer);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Loads the memory of a named object into a device buffer.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \tparam T The type of the object.
+  /// \param name The name of the object.
+  /// \param device_buffer A device buffer of at least sizeof(T) * length
+  /// bytes, where length is the number of the objects.
+  /// \return Returns true on success; false if the object is not found or
+  /// on error.
+  template <typename T>
+  bool load_to_device(char_ptr_holder_type name,
+                      void *const device_buffer) noexcept {
+    const auto [ptr, length] = find<T>(name);
+    if (!ptr) {
+      return false;
+    }
+    return load_to_device(ptr, sizeof(T) * length, device_buffer);
+  }
+
+  /// \brief Makes the data in a region durable, e.g., after updating a few
+  /// objects, without flushing the whole datastore.
+  /// If the datastore is on a file system mounted with DAX (e.g., on
+  /// persistent or CXL memory) and METALL_USE_DAX is defined, only writes
+  /// back the CPU cache lines of the region, which takes microseconds;
+  /// otherwise, msyncs the pages of the region.
+  /// Does not persist the management data; see flush().
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment.
+  bool persist(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->persist(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns true if the datastore is mapped with MAP_SYNC, i.e.,
+  /// persist() only writes back CPU cache lines; see persist().
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true if the datastore is mapped with MAP_SYNC.
+  bool dax_mapped() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->dax_mapped();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Begins a transaction that updates regions of objects all or
+  /// nothing, even across a crash.
+  /// Call add_to_transaction() on a region before modifying it; the old
+  /// contents are saved in an undo log and written back by
+  /// abort_transaction() or, after a crash, when the datastore is opened
+  /// next time.
+  /// Allocations and deallocations are not part of a transaction.
+  /// Only one transaction is active at a time.
+  /// A transaction not committed when the manager is closed is rolled back.
+  /// Not available for read-only, copy-on-write, or volatile data stores.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true on success; false on error or if a transaction is
+  /// already active.
+  bool begin_transaction() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->begin_transaction();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Adds a region to the active transaction, saving its current
+  /// contents in the undo log before returning.
+  /// The region is tracked at the granularity of 64-byte cache lines;
+  /// adding a region that is already in the transaction costs little.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error or if no transaction is
+  /// active.
+  bool add_to_transaction(const void *const addr,
+                          const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->add_to_transaction(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Commits the active transaction.
+  /// The regions added to the transaction are made durable, as by persist(),
+  /// before the undo log is discarded.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true on success; false on error or if no transaction is
+  /// active.
+  bool commit_transaction() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->commit_transaction();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Aborts the active transaction, writing back the contents the
+  /// regions added to it had before.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true on success; false on error or if no transaction is
+  /// active.
+  bool abort_transaction() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->abort_transaction();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns true if a transaction is active.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return Returns true if a transaction is active.
+  bool in_transaction() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->in_transaction();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Tells that the pages of a region will not be accessed soon, so
+  /// that the kernel evicts them before other pages, e.g., after scanning the
+  /// region once. The data is not lost.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns true on success; false on error or if the system does
+  /// not support it.
+  bool advise_cold(const void *const addr, const size_type nbytes) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->advise_cold(addr, nbytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Gives the kernel the access pattern of a region, e.g., an
+  /// allocation not constructed by construct(), as a memory advice.
+  /// Unlike set_access_pattern(), the pattern is not recorded.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param pattern The access pattern.
+  /// \return Returns true on success; false on error or if the system does
+  /// not support it.
+  bool advise_access_pattern(const void *const addr, const size_type nbytes,
+                             const access_pattern_type pattern) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->advise_access_pattern(addr, nbytes, pattern);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Takes a snapshot of the current data. The snapshot has a new UUID.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param destination_path Path to store a snapshot.
+  /// \param clone Use the file clone mechanism (reflink) instead of normal copy
+  /// if it is available. \param num_max_copy_threads The maximum number of copy
+  /// threads to use. If <= 0 is given, the value is automatically determined.
+  /// \return Returns true on success; other false.
   bool snapshot(const path_type &destination_path, const bool clone = true,
                 const int num_max_copy_threads = 0) noexcept {
     if (!check_sanity()) {
@@ -1006,6 +2367,93 @@ class basic_manager {
     return false;
   }
 
+  /// \brief Takes an incremental snapshot of the current data.
+  /// The snapshot has a new UUID.
+  /// The first incremental snapshot taken by this manager is a full snapshot.
+  /// The following ones save only the pages written since the previous one,
+  /// tracking them with the soft-dirty bits, and keep a link to the previous
+  /// one; thus, taking a snapshot does not depend on reflink.
+  /// An incremental snapshot is built from its parents when it is opened
+  /// first time. The snapshots in a chain must not be moved or removed while
+  /// they have descendants, and the first one (full snapshot) can be opened
+  /// only with the read-only or copy-on-write mode.
+  /// If the written pages cannot be tracked, takes a full snapshot.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param destination_path Path to store a snapshot.
+  /// \param num_max_copy_threads The maximum number of copy threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Returns true on success; other false.
+  bool snapshot_incremental(const path_type &destination_path,
+                            const int num_max_copy_threads = 0) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->snapshot_incremental(destination_path,
+                                            num_max_copy_threads);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Writes the changes made since the previous call to a replication
+  /// stream, which apply_replication() applies to a replica of the data
+  /// store, e.g., a standby on another node.
+  /// The first stream written by this manager (and the first one after a
+  /// failure) has the whole data store. The following ones have only the
+  /// pages of the segment written since the previous one, tracking them with
+  /// the soft-dirty bits, and the management data; thus, a replica is
+  /// updated without copying the whole data store.
+  /// The stream can be sent with any transport, e.g., a std::ostream whose
+  /// buffer writes to a socket, and applied asynchronously.
+  /// \copydoc doc_single_thread
+  ///
+  /// \param stream An output stream.
+  /// \param full If true, writes the whole data store, e.g., for a new
+  /// replica or a replica that failed to apply a stream.
+  /// \return Returns true on success; other false.
+  bool replicate(std::ostream &stream, const bool full = false) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->replicate(stream, full);
+    } catch (...) {
+      m_kernel.reset(nullptr);
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Applies a stream written by replicate() to a replica.
+  /// A stream that has the whole data store creates or replaces the replica;
+  /// the other ones require the replica to have applied the previous stream
+  /// of the same manager.
+  /// The replica can be opened as a normal data store after a stream is
+  /// applied. Once it is opened with the write mode, e.g., at failover, it
+  /// does not apply the streams anymore but a full one.
+  /// \copydoc doc_thread_safe
+  /// \details The replica must not be open.
+  ///
+  /// \param replica_path Path to a replica.
+  /// \param stream An input stream.
+  /// \return Returns true on success; other false.
+  static bool apply_replication(const path_type &replica_path,
+                                std::istream &stream) noexcept {
+    try {
+      return manager_kernel_type::apply_replication(replica_path, stream);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
   /// \brief Copies data store synchronously.
   /// The behavior of copying a data store that is open without the read-only
   /// mode is undefined.
@@ -1022,8 +2470,36 @@ class basic_manager {
                    const path_type &destination_path, const bool clone = true,
                    const int num_max_copy_threads = 0) noexcept {
     try {
-      return manager_kernel_type::copy(source_path, destination_path, clone,
-                                       num_max_copy_threads);
+      return manager_kernel_type::copy(source_path, destination_path, clone,
+                                       num_max_copy_threads);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Copies a data store copying only the chunks in use.
+  /// Unlike copy(), the free chunks of the segment are not copied but left
+  /// as holes, and the trailing part of the segment without objects is
+  /// dropped; thus, the copy can take less storage space than the source.
+  /// The objects stay at the same offsets in the copy.
+  /// The behavior of copying a data store that is open without the read-only
+  /// mode is undefined.
+  /// \copydoc doc_thread_safe
+  /// \details Copying to the same path simultaneously is prohibited.
+  ///
+  /// \param source_path Source data store path.
+  /// \param destination_path Destination data store path.
+  /// \param num_max_copy_threads The maximum number of copy threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns true; other false.
+  static bool repack_copy(const path_type &source_path,
+                          const path_type &destination_path,
+                          const int num_max_copy_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::repack_copy(source_path, destination_path,
+                                              num_max_copy_threads);
     } catch (...) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "An exception has been thrown");
@@ -1059,6 +2535,197 @@ class basic_manager {
     return std::future<bool>();
   }
 
+  /// \brief Opens existing data stores in parallel, e.g., the per-shard data
+  /// stores of a multi-graph workload, so that opening them takes about as
+  /// long as opening the slowest one.
+  /// The data stores are opened by the shared I/O threads, and the file space
+  /// freeing test is done once per file system.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param paths Paths to data stores.
+  /// \param options Runtime options given to all managers.
+  /// \return Returns the managers in the order of 'paths'. The manager of a
+  /// data store that could not be opened is nullptr.
+  static std::vector<std::unique_ptr<self_type>> open_many(
+      open_only_t, const std::vector<path_type> &paths,
+      const manager_options &options = manager_options()) noexcept {
+    return priv_open_many(paths, [&options](const path_type &path) {
+      return std::make_unique<self_type>(open_only, path, options);
+    });
+  }
+
+  /// \brief Opens existing data stores with the read only mode in parallel.
+  /// See open_many() above.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param paths Paths to data stores.
+  /// \param options Runtime options given to all managers.
+  /// \return Returns the managers in the order of 'paths'. The manager of a
+  /// data store that could not be opened is nullptr.
+  static std::vector<std::unique_ptr<self_type>> open_many(
+      open_read_only_t, const std::vector<path_type> &paths,
+      const manager_options &options = manager_options()) noexcept {
+    return priv_open_many(paths, [&options](const path_type &path) {
+      return std::make_unique<self_type>(open_read_only, path, options);
+    });
+  }
+
+  /// \brief Compresses the segment of a data store with Zstandard, e.g., to
+  /// archive a snapshot. The data store is decompressed when it is opened
+  /// next time. Requires METALL_USE_ZSTD; otherwise, always fails.
+  /// \copydoc doc_thread_safe
+  /// \details The data store must be closed properly and must not be open.
+  ///
+  /// \param path Path to a data store to compress.
+  /// \param level The compression level of Zstandard.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, it is automatically determined.
+  /// \return If succeeded, returns true; other false.
+  static bool compress(const path_type &path, const int level = 3,
+                       const int num_max_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::compress(path, level, num_max_threads);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Decompresses a data store compressed by compress() without
+  /// opening it.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param path Path to a data store to decompress.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, it is automatically determined.
+  /// \return If succeeded, returns true; other false.
+  static bool decompress(const path_type &path,
+                         const int num_max_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::decompress(path, num_max_threads);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Compares two data stores without opening them, e.g., snapshots
+  /// taken by snapshot(), and finds the ranges of the segment whose data
+  /// differ, e.g., to see what an ingest phase wrote or to back up only the
+  /// changed ranges.
+  /// The data stores are compared chunk by chunk, and only the chunks used in
+  /// either data store are compared. The data the block files share by
+  /// reflink are not read.
+  /// \copydoc doc_thread_safe
+  /// \details The data stores must be closed properly and must not be open.
+  /// Compressed data stores have to be decompressed first.
+  ///
+  /// \param path0 Path to a data store, e.g., an older snapshot.
+  /// \param path1 Path to another data store.
+  /// \param changed_ranges A pointer to store the (offset, length) of the
+  /// changed ranges in the segment in ascending order.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, it is automatically determined.
+  /// \return If succeeded, returns true; other false.
+  static bool diff(
+      const path_type &path0, const path_type &path1,
+      std::vector<std::pair<size_type, size_type>> *const changed_ranges,
+      const int num_max_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::diff(path0, path1, changed_ranges,
+                                       num_max_threads);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Reads the attributes (the name, offset, length, type ID, and
+  /// description) of all objects of a kind in a data store without opening
+  /// it, e.g., to list the objects of a data store with millions of objects.
+  /// The directory file is decoded in parallel.
+  /// \copydoc doc_thread_safe
+  /// \details The data store must not be open in write mode.
+  ///
+  /// \param path Path to a data store.
+  /// \param kind The kind of the objects to read.
+  /// \param attributes A pointer to store the attributes in the order of the
+  /// construction.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, it is automatically determined.
+  /// \return If succeeded, returns true; other false.
+  static bool read_object_attributes(
+      const path_type &path, const instance_kind kind,
+      std::vector<object_attribute_type> *const attributes,
+      const int num_max_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::read_object_attributes(
+          path, kind, num_max_threads, attributes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Checks the integrity of a data store without opening it, e.g.,
+  /// when consistent() returns false or the data store could be corrupted.
+  /// Cross-validates the slot tables of the chunks, the bin directory (the
+  /// chunks that have free slots), and the offsets of the objects in the
+  /// object directories against the chunk table, and checks that the block
+  /// files are not missing or truncated. The chunks and the objects are
+  /// checked in parallel.
+  /// \copydoc doc_thread_safe
+  /// \details The data store must not be open in write mode.
+  /// Nothing is repaired; see recover() for a data store that was not closed
+  /// properly.
+  ///
+  /// \param path Path to a data store.
+  /// \param problems A pointer to append the descriptions of the problems
+  /// found.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, it is automatically determined.
+  /// \return Returns true if no problem is found; otherwise, false.
+  static bool check_integrity(const path_type &path,
+                              std::vector<std::string> *const problems,
+                              const int num_max_threads = 0) noexcept {
+    try {
+      return manager_kernel_type::check_integrity(path, num_max_threads,
+                                                  problems);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+      problems->push_back("An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Recovers a data store that was not closed properly because the
+  /// process crashed so that it can be opened again.
+  /// The object directories become the state at the last flush_async(),
+  /// snapshot(), or open; the objects constructed after that are not found.
+  /// The memory allocated after that is kept allocated; small objects
+  /// deallocated after that are leaked.
+  /// Does nothing if the data store was closed properly.
+  /// Recovers from a process crash, but not from an OS crash or a power
+  /// failure.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param path Path to a data store to recover.
+  /// \return If succeeded, returns true; other false.
+  static bool recover(const path_type &path) noexcept {
+    try {
+      return manager_kernel_type::recover(path);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
   /// \brief Removes data store synchronously.
   /// \copydoc doc_thread_safe
   /// \details Must not remove the same data store simultaneously.
@@ -1337,6 +3004,30 @@ class basic_manager {
     return allocator_type<T>(nullptr);
   }
 
+  /// \brief Makes global_allocator_type allocate from this manager, e.g.,
+  /// right after opening a datastore.
+  /// The binding is released by unbind_global_allocator() or when this
+  /// manager is destroyed. Must not be called while other threads allocate
+  /// with global_allocator_type.
+  /// \return Returns true on success; otherwise, false.
+  bool bind_global_allocator() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    set_global_stl_allocator_kernel(m_kernel.get());
+    return true;
+  }
+
+  /// \brief Releases the binding made by bind_global_allocator() if this
+  /// manager is bound.
+  void unbind_global_allocator() noexcept {
+    if (m_kernel &&
+        get_global_stl_allocator_kernel<manager_kernel_type>() ==
+            m_kernel.get()) {
+      set_global_stl_allocator_kernel<manager_kernel_type>(nullptr);
+    }
+  }
+
   /// \brief Returns the internal chunk size.
   /// \copydoc doc_thread_safe
   ///
@@ -1396,6 +3087,42 @@ class basic_manager {
     return true;
   }
 
+  /// \brief Returns if this manager was opened with the copy-on-write mode
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return whether or not this manager was opened with the copy-on-write
+  /// mode
+  bool copy_on_write() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->copy_on_write();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns if this manager was created with
+  /// manager_options::volatile_segment.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \return whether or not the datastore is volatile
+  bool volatile_segment() const noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->volatile_segment();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
   // bool belongs_to_segment (const void *ptr) const
 
   /// \brief Checks the sanity.
@@ -1404,6 +3131,289 @@ class basic_manager {
   /// \return Returns true if there is no issue; otherwise, returns false.
   bool check_sanity() const noexcept { return !!m_kernel && m_kernel->good(); }
 
+  /// \brief Collects the memory usage of the data store: the chunks, objects,
+  /// free space, and cached objects of each bin (size class), and the segment
+  /// size. Unlike profile(), does not drain the object cache, i.e., the
+  /// allocation performance is not affected afterward.
+  /// This function is not thread-safe with allocations and deallocations.
+  /// \param stats A pointer to an object to store the statistics.
+  /// The statistics can be serialized by memory_statistics_type::to_json().
+  /// \param include_named_objects If true, also collects the number of bytes
+  /// allocated to each named object.
+  /// \param include_resident_bytes If true, also collects the number of bytes
+  /// of the segment resident in memory. This examines the page table of the
+  /// whole segment and can take time for a large segment.
+  /// \return Returns true on success; otherwise, false.
+  bool get_memory_statistics(
+      memory_statistics_type *stats, const bool include_named_objects = false,
+      const bool include_resident_bytes = false) noexcept {
+    if (!check_sanity() || !stats) {
+      return false;
+    }
+    try {
+      return m_kernel->get_memory_statistics(stats, include_named_objects,
+                                             include_resident_bytes);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Reads the numbers of allocated objects, allocated bytes, and used
+  /// chunks of each bin (size class) and the number of bytes given back to
+  /// the system. The counters are maintained on allocations and
+  /// deallocations; unlike get_memory_statistics(), this function does not
+  /// scan the data store and is cheap enough to poll, e.g., for monitoring.
+  /// \copydoc doc_thread_safe
+  /// While other threads allocate or deallocate objects, the counters are
+  /// read at slightly different points in time.
+  /// \param counters A pointer to an object to store the counters.
+  /// The counters can be serialized by memory_counters_type::to_json().
+  /// \return Returns true on success; otherwise, false.
+  bool get_memory_counters(memory_counters_type *counters) noexcept {
+    if (!check_sanity() || !counters) {
+      return false;
+    }
+    try {
+      return m_kernel->get_memory_counters(counters);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Attributes the pages of the segment to the chunks, bins (size
+  /// classes), and optionally the named and unique objects: the pages
+  /// resident in memory (mincore(2)), the dirty pages (the soft-dirty bits
+  /// of /proc/self/pagemap, if available), and the pages faulted in since the
+  /// previous call, i.e., the pages that became resident. Calling this
+  /// function periodically samples the page faults of each region.
+  /// The soft-dirty bits are only read; they are cleared by incremental
+  /// snapshots and not by this function.
+  /// This function examines the page table of the whole segment and is not
+  /// thread-safe with allocations and deallocations.
+  /// \param stats A pointer to an object to store the statistics.
+  /// The statistics can be serialized by page_statistics_type::to_json().
+  /// \param include_named_objects If true, also attributes the pages to the
+  /// named and unique objects.
+  /// \return Returns true on success; otherwise, false.
+  bool get_page_statistics(page_statistics_type *stats,
+                           const bool include_named_objects = false) noexcept {
+    if (!check_sanity() || !stats) {
+      return false;
+    }
+    try {
+      return m_kernel->get_page_statistics(stats, include_named_objects);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Binds the pages of a region to a NUMA node and moves the pages
+  /// already allocated on other nodes, e.g., to place data on a memory tier
+  /// such as CXL-attached memory, which appears as a NUMA node without CPUs.
+  /// The region is rounded to the page boundaries. For a file-backed
+  /// datastore, only the pages already in the page cache follow the node
+  /// unless the files are on tmpfs; see metall::mtlldetail::numa.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param node A NUMA node.
+  /// \return Returns true on success; false on error, e.g., the region is not
+  /// in the application data segment or the system does not support it.
+  bool bind_to_numa_node(const void *const addr, const size_type nbytes,
+                         const int node) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->bind_to_numa_node(addr, nbytes, node);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Samples the accesses to the chunks since the previous call and
+  /// moves the chunks not accessed in policy.num_cold_samples consecutive
+  /// calls to the far memory tier, e.g., CXL-attached memory; if
+  /// policy.near_node is not negative, also moves the chunks accessed on the
+  /// far tier back. Call this function periodically; the first call only
+  /// starts sampling.
+  /// The accesses are found by the idle page tracking of Linux if available
+  /// (requires CAP_SYS_ADMIN); otherwise, only writes are found by the
+  /// soft-dirty bits. The same limitation as bind_to_numa_node() applies.
+  /// Must not be called while other threads allocate or deallocate objects.
+  ///
+  /// \param policy A policy.
+  /// \param result If not nullptr, the numbers of the chunks sampled and
+  /// moved are stored.
+  /// \return Returns true on success; false on error, e.g., accesses cannot
+  /// be sampled or no far tier is found.
+  bool migrate_cold_chunks(
+      const memory_tiering_policy_type &policy = memory_tiering_policy_type(),
+      memory_tiering_result_type *const result = nullptr) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->migrate_cold_chunks(policy, result);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Samples the accesses to the chunks since the previous sample and
+  /// records them in the heat of the chunks: the history of the last 8
+  /// samples of each chunk, stored with the chunk directory.
+  /// Call this function periodically; the first call only starts sampling.
+  /// migrate_cold_chunks() records a sample too, and profile() shows the
+  /// fraction of the hot chunks.
+  /// The accesses are sampled in the same way as migrate_cold_chunks().
+  /// Must not be called concurrently with migrate_cold_chunks().
+  ///
+  /// \param stats If not nullptr, the numbers of the hot, warm, and cold
+  /// chunks after the sample are stored.
+  /// \return Returns true on success; false on error, e.g., accesses cannot
+  /// be sampled.
+  bool sample_chunk_heat(
+      chunk_heat_statistics_type *const stats = nullptr) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->sample_chunk_heat(stats);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Gets the numbers of the hot, warm, and cold chunks recorded by
+  /// the samples (see sample_chunk_heat()), without sampling.
+  /// \copydoc doc_thread_safe
+  ///
+  /// \param stats A pointer to store the statistics.
+  /// \return Returns true on success; otherwise, false.
+  bool get_chunk_heat_statistics(
+      chunk_heat_statistics_type *const stats) noexcept {
+    if (!check_sanity() || !stats) {
+      return false;
+    }
+    try {
+      return m_kernel->get_chunk_heat_statistics(stats);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Writes the allocations sampled by the allocator in the legacy heap
+  /// profile format of gperftools, which pprof reads, e.g.,
+  /// 'pprof --alloc_space ./a.out profile.heap'.
+  /// Each sample has the call stack of the allocation. Only the allocations
+  /// made by this process are recorded, i.e., the samples are not stored in
+  /// the data store. Deallocations are not tracked.
+  /// Available only if METALL_USE_ALLOCATION_SAMPLING is defined; the
+  /// sampling interval is METALL_ALLOCATION_SAMPLING_INTERVAL bytes.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool write_allocation_profile(const path_type &path) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->write_allocation_profile(path);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Starts recording every allocation, deallocation, and in-place
+  /// resize (operation, size, alignment, segment offset, thread, and
+  /// timestamp) to a binary file, replacing the current trace if any.
+  /// The trace can be replayed offline against other configurations, e.g.,
+  /// with bench/allocation_trace/replay_allocation_trace.
+  /// Available only if METALL_USE_ALLOCATION_TRACE is defined.
+  /// Must not be called while other threads allocate or deallocate objects.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool start_allocation_trace(const path_type &path) noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->start_allocation_trace(path);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  /// \brief Returns the time spent in each phase of create, open, flush,
+  /// close, and snapshot in this process, e.g., serializing each management
+  /// data file, syncing the segment, and mapping the segment files.
+  /// The phases of open and create are included as they are run by the
+  /// constructor. Always available; each phase costs a few atomic operations.
+  /// The timings can be serialized by phase_timings_type::to_json().
+  /// \param timings A pointer to an object to store the timings.
+  /// \return Returns true on success; otherwise, false.
+  bool get_phase_timings(phase_timings_type *timings) const noexcept {
+    if (!check_sanity() || !timings) {
+      return false;
+    }
+    *timings = m_kernel->get_phase_timings();
+    return true;
+  }
+
+  /// \brief Resets the phase timings to 0.
+  void reset_phase_timings() noexcept {
+    if (!check_sanity()) {
+      return;
+    }
+    m_kernel->reset_phase_timings();
+  }
+
+  /// \brief Logs the time of each phase through the logger at 'lvl' when it
+  /// finishes, in all managers of this process. Call it before constructing
+  /// a manager to log the phases of open and create.
+  /// \param lvl The log level. If std::nullopt, disables the logging
+  /// (default).
+  static void set_phase_timing_log_level(
+      const std::optional<logger::level> lvl) noexcept {
+    kernel::phase_timer::set_log_level(lvl);
+  }
+
+  /// \brief Stops the allocation trace started by start_allocation_trace()
+  /// and writes the rest of the records to the file.
+  /// Must not be called while other threads allocate or deallocate objects.
+  /// \return Returns true on success; otherwise, false.
+  bool stop_allocation_trace() noexcept {
+    if (!check_sanity()) {
+      return false;
+    }
+    try {
+      return m_kernel->stop_allocation_trace();
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
   // ---------- For profiling and debug ---------- //
 #if !defined(DOXYGEN_SKIP)
   /// \brief Prints out profiling information.
@@ -1425,11 +3435,73 @@ class basic_manager {
 #endif
 
  private:
+  // -------------------- //
+  // Private methods
+  // -------------------- //
+  template <typename open_function_type>
+  static std::vector<std::unique_ptr<self_type>> priv_open_many(
+      const std::vector<path_type> &paths,
+      const open_function_type &open_function) noexcept {
+    std::vector<std::unique_ptr<self_type>> managers(paths.size());
+    try {
+      mtlldetail::io_executor::instance().parallel_for(
+          paths.size(), 0, [&](const std::size_t i) {
+            auto manager = open_function(paths[i]);
+            if (!manager->check_sanity()) return false;
+            managers[i] = std::move(manager);
+            return true;
+          });
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return managers;
+  }
+
   // -------------------- //
   // Private fields
   // -------------------- //
   std::unique_ptr<manager_kernel_type> m_kernel{nullptr};
 };
+
+/// \brief Sets a placement hint of the calling thread while an instance is
+/// alive. The small objects the thread allocates in the meantime, including
+/// the ones by construct() and the STL allocators, are grouped into the
+/// chunks of the hint. The previous hint is restored by the destructor.
+/// The hint applies to all managers of the same type in the thread.
+/// Large objects (larger than half of the chunk size) take their own chunks
+/// regardless of hints.
+template <typename storage, typename segment_storage, typename chunk_no_type,
+          std::size_t k_chunk_size, typename size_class_table,
+          typename concurrency_policy>
+class basic_manager<storage, segment_storage, chunk_no_type, k_chunk_size,
+                    size_class_table, concurrency_policy>::
+    placement_hint_scope {
+ public:
+  /// \brief Sets 'hint'. Logs an error and sets no hint if 'hint' is out of
+  /// range.
+  explicit placement_hint_scope(const placement_hint hint) noexcept
+      : m_has_previous(manager_kernel_type::get_placement_hint(&m_previous)) {
+    if (!manager_kernel_type::set_placement_hint(hint.id)) {
+      manager_kernel_type::clear_placement_hint();
+    }
+  }
+
+  ~placement_hint_scope() noexcept {
+    if (m_has_previous) {
+      manager_kernel_type::set_placement_hint(m_previous);
+    } else {
+      manager_kernel_type::clear_placement_hint();
+    }
+  }
+
+  placement_hint_scope(const placement_hint_scope &) = delete;
+  placement_hint_scope &operator=(const placement_hint_scope &) = delete;
+
+ private:
+  size_type m_previous{0};
+  bool m_has_previous{false};
+};
 }  // namespace metall
 
 #endif  // METALL_BASIC_MANAGER_HPP
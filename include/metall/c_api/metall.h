@@ -9,6 +9,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include <metall/c_api/arrow_c_data_interface.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,6 +22,56 @@ extern "C" {
  */
 typedef struct metall_manager metall_manager;
 
+/**
+ * \brief Opaque struct representing an operation running in background, e.g., a flush or copy
+ */
+typedef struct metall_async_handle metall_async_handle;
+
+/**
+ * \brief Memory usage of a metall datastore
+ */
+typedef struct metall_memory_statistics {
+  /** \brief chunk size in bytes */
+  size_t chunk_size;
+  /** \brief number of chunks in use */
+  size_t num_used_chunks;
+  /** \brief number of bytes allocated to objects, excluding cached objects */
+  size_t allocated_bytes;
+  /** \brief number of bytes of the objects in the object cache */
+  size_t cached_bytes;
+  /** \brief number of bytes in the used chunks not allocated to objects */
+  size_t free_bytes;
+  /** \brief number of bytes of the application data segment backed by files */
+  size_t segment_size;
+  /** \brief number of bytes of the segment resident in memory, 0 if not requested */
+  size_t resident_bytes;
+  /** \brief max number of bytes the application data segment can grow to */
+  size_t capacity;
+  /** \brief number of named objects */
+  size_t num_named_objects;
+  /** \brief number of unique objects */
+  size_t num_unique_objects;
+  /** \brief number of anonymous objects */
+  size_t num_anonymous_objects;
+} metall_memory_statistics;
+
+/**
+ * \brief Array of memory allocated by metall_named_malloc, described as a NumPy __array_interface__
+ * \note the array points into the datastore; it is valid until the memory is freed or the manager is closed
+ */
+typedef struct metall_array_interface {
+  /** \brief address of the first element */
+  void* data;
+  /** \brief number of elements */
+  size_t length;
+  /** \brief number of bytes of an element */
+  size_t item_size;
+  /** \brief NUL-terminated NumPy typestr of the elements, e.g., "<f8" */
+  char typestr[4];
+  /** \brief true if the array must not be written, i.e., the manager is read only */
+  bool read_only;
+} metall_array_interface;
+
 /**
  * \brief Attempts to open the metall datastore at path
  * \param path path to datastore
@@ -45,6 +97,16 @@ metall_manager* metall_open_read_only(const char* path);
  */
 metall_manager* metall_create(const char* path);
 
+/**
+ * \brief Attempts to create a metall datastore at path with the given capacity
+ * \param path path at which to create a datastore
+ * \param capacity total allocation size, which is used as a hint; the actual limit could be slightly smaller or larger
+ * \return true on success, false on failure. On failure, sets errno to one of the following values:
+ *      - EEXIST if the given path already exists
+ *      - ENOTRECOVERABLE if the datastore could not be created for some other reason
+ */
+metall_manager* metall_create_with_capacity(const char* path, size_t capacity);
+
 /**
  * \brief Creates a snapshot of the metall datastore of manager and places it at dst_path
  * \param manager manager to perform snapshot
@@ -53,12 +115,69 @@ metall_manager* metall_create(const char* path);
  */
 bool metall_snapshot(metall_manager* manager, const char* dst_path);
 
+/**
+ * \brief Creates a snapshot of the metall datastore of manager with options
+ * \param manager manager to perform snapshot
+ * \param dst_path path where to place the snapshot
+ * \param clone if true, uses the file clone mechanism (reflink) if it is available
+ * \param num_max_copy_threads maximum number of copy threads to use, or 0 to determine automatically
+ * \param incremental if true, takes an incremental snapshot that saves only the pages written since the previous incremental snapshot taken by manager
+ * \return true if the snapshot was successfully created otherwise false.
+ */
+bool metall_snapshot_with_options(metall_manager* manager,
+                                  const char* dst_path, bool clone,
+                                  int num_max_copy_threads, bool incremental);
+
+/**
+ * \brief Copies the metall datastore at src_path to dst_path
+ * \param src_path path to the datastore to copy, which must not be open except in read only mode
+ * \param dst_path path where to place the copy
+ * \return true if the copy was successfully created otherwise false.
+ */
+bool metall_copy(const char* src_path, const char* dst_path);
+
+/**
+ * \brief Starts copying the metall datastore at src_path to dst_path in background
+ * \param src_path path to the datastore to copy, which must not be open except in read only mode
+ * \param dst_path path where to place the copy
+ * \return handle of the copy, which must be passed to metall_wait, if successful. Otherwise, returns NULL and sets errno to one of the following values
+ *      - ENOTRECOVERABLE if the copy could not be started
+ */
+metall_async_handle* metall_copy_async(const char* src_path,
+                                       const char* dst_path);
+
 /**
  * \brief Flushes the given manager
  * \param manager manager to flush
  */
 void metall_flush(metall_manager* manager);
 
+/**
+ * \brief Starts flushing the given manager in background
+ * \param manager manager to flush
+ * \return handle of the flush, which must be passed to metall_wait, if successful. Otherwise, returns NULL and sets errno to one of the following values
+ *      - ENOTRECOVERABLE if the flush could not be started
+ * \note the manager can be used while the flush runs; the data written after this call may or may not be flushed by it
+ */
+metall_async_handle* metall_flush_async(metall_manager* manager);
+
+/**
+ * \brief Waits for an operation started by metall_flush_async or metall_copy_async and releases the handle
+ * \param handle handle returned by metall_flush_async or metall_copy_async
+ * \return true if the operation succeeded, otherwise false
+ */
+bool metall_wait(metall_async_handle* handle);
+
+/**
+ * \brief Loads the pages of a region into memory in parallel so that the following accesses to it do not take a page fault per page
+ * \param manager manager the region belongs to
+ * \param addr beginning address of the region, or NULL to load the whole application data segment
+ * \param size number of bytes of the region, ignored if addr is NULL
+ * \return true on success, otherwise false and sets errno to one of the following values
+ *      - EINVAL if the region is not in the application data segment
+ */
+bool metall_prefetch(metall_manager* manager, const void* addr, size_t size);
+
 /**
  * \brief Closes a metall manager
  */
@@ -83,6 +202,17 @@ bool metall_remove(const char* path);
  */
 void* metall_malloc(metall_manager* manager, size_t size);
 
+/**
+ * \brief Allocates size bytes whose address is a multiple of alignment
+ * \param manager manager to allocate with
+ * \param size number of bytes to allocate, which must be a multiple of alignment
+ * \param alignment alignment in bytes, which must be a power of two between the min allocation size and the system page size
+ * \return pointer to allocated memory if successful otherwise returns NULL and sets errno to one of the following values
+ *    - ENOMEM
+ */
+void* metall_malloc_aligned(metall_manager* manager, size_t size,
+                            size_t alignment);
+
 /**
  * \brief Frees memory previously allocated by metall_malloc
  * \param manager manager from which to free
@@ -90,6 +220,26 @@ void* metall_malloc(metall_manager* manager, size_t size);
  */
 void metall_free(metall_manager* manager, void* ptr);
 
+/**
+ * \brief Allocates n objects of size bytes at once
+ * \param manager manager to allocate with
+ * \param size number of bytes of each object
+ * \param n number of objects to allocate
+ * \param ptrs array that can hold n pointers, the allocated pointers are stored from its front
+ * \return number of allocated objects. If it is less than n, the remaining elements of ptrs are set to NULL and sets errno to one of the following values
+ *    - ENOMEM
+ */
+size_t metall_malloc_many(metall_manager* manager, size_t size, size_t n,
+                          void** ptrs);
+
+/**
+ * \brief Frees multiple memory blocks previously allocated by metall_malloc or metall_malloc_many
+ * \param manager manager from which to free
+ * \param ptrs array of memory to free, NULL elements are ignored
+ * \param n number of elements in ptrs
+ */
+void metall_free_many(metall_manager* manager, void* const* ptrs, size_t n);
+
 /**
  * \brief Allocates size bytes and associates the allocated memory with a name
  * \param manager manager to allocate with
@@ -112,6 +262,18 @@ void* metall_named_malloc(metall_manager* manager, const char* name,
  */
 void* metall_find(metall_manager* manager, const char* name);
 
+/**
+ * \brief Finds multiple memory blocks that were previously allocated using metall_named_malloc at once
+ * \param manager manager to find the objects in
+ * \param names array of n names of the allocated memory to find
+ * \param n number of elements in names
+ * \param ptrs array that can hold n pointers, the i-th element is set to the memory of names[i], or NULL if not found
+ * \return number of objects found. If it is less than n, sets errno to one of the following values
+ *      - ENOENT if some of the objects could not be found
+ */
+size_t metall_find_many(metall_manager* manager, const char* const* names,
+                        size_t n, void** ptrs);
+
 /**
  * \brief Frees memory previously allocated by metall_named_malloc
  * \param manager manager from which to free
@@ -122,6 +284,59 @@ void* metall_find(metall_manager* manager, const char* name);
  */
 bool metall_named_free(metall_manager* manager, const char* name);
 
+/**
+ * \brief Collects the memory usage of the datastore of manager
+ * \param manager manager to collect the memory usage of
+ * \param stats pointer to store the statistics
+ * \param include_resident_bytes if true, also collects the number of bytes resident in memory, which can take time for a large datastore
+ * \return true on success, otherwise false and sets errno to one of the following values
+ *      - EINVAL if the statistics could not be collected
+ * \warning not thread-safe with allocations and deallocations
+ */
+bool metall_get_memory_statistics(metall_manager* manager,
+                                  metall_memory_statistics* stats,
+                                  bool include_resident_bytes);
+
+/**
+ * \brief Returns the memory usage of the datastore of manager as a JSON string, including the usage of each bin (size class) and of each named object
+ * \param manager manager to collect the memory usage of
+ * \return NUL-terminated string allocated by malloc, which must be released by free, if successful. Otherwise, returns NULL and sets errno to one of the following values
+ *      - EINVAL if the statistics could not be collected
+ *      - ENOMEM if the string could not be allocated
+ * \warning not thread-safe with allocations and deallocations
+ */
+char* metall_memory_statistics_json(metall_manager* manager);
+
+/**
+ * \brief Describes memory allocated by metall_named_malloc as an array without copying it, e.g., to build a NumPy array through __array_interface__
+ * \param manager manager to find the memory in
+ * \param name name of the allocated memory
+ * \param typestr NumPy typestr of the elements, which must be an integer or floating-point type in the native byte order, e.g., "<f8" or "|u1"
+ * \param array pointer to store the description
+ * \return true on success, otherwise false and sets errno to one of the following values
+ *      - ENOENT if the memory could not be found
+ *      - EINVAL if typestr is not supported or the size of the memory is not a multiple of the element size
+ */
+bool metall_find_array(metall_manager* manager, const char* name,
+                       const char* typestr, metall_array_interface* array);
+
+/**
+ * \brief Exports memory allocated by metall_named_malloc as an Apache Arrow array (C data interface) whose data buffer points into the datastore
+ * \param manager manager to find the memory in
+ * \param name name of the allocated memory
+ * \param format Arrow format string of the elements, which must be a fixed-width primitive type, e.g., "g" (float64) or "l" (int64)
+ * \param out_array array to fill, which must be released by its release callback
+ * \param out_schema schema to fill, which must be released by its release callback. Can be NULL
+ * \return true on success, otherwise false and sets errno to one of the following values
+ *      - ENOENT if the memory could not be found
+ *      - EINVAL if format is not supported or the size of the memory is not a multiple of the element size
+ *      - ENOMEM if the descriptors could not be allocated
+ * \note releasing the array does not free the memory; the array is valid until the memory is freed or the manager is closed
+ */
+bool metall_export_arrow_array(metall_manager* manager, const char* name,
+                               const char* format, struct ArrowArray* out_array,
+                               struct ArrowSchema* out_schema);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,215 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_COMPACT_PTR_HPP
+#define METALL_COMPACT_PTR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include <metall/segment_relative_ptr.hpp>
+
+namespace metall {
+
+namespace cptrdtl {
+/// \brief The unit of the offset of compact_ptr<T>, i.e., the alignment of
+/// T up to 8 bytes. Pointers to void are assumed to point to allocated
+/// objects, which are 8-byte aligned.
+template <typename T>
+constexpr std::size_t scale() {
+  if constexpr (std::is_void_v<T>) {
+    return 8;
+  } else {
+    return std::min<std::size_t>(alignof(T), 8);
+  }
+}
+}  // namespace cptrdtl
+
+/// \brief A 4-byte fancy pointer that holds the offset from the beginning of
+/// the application data segment in units of the alignment of T (up to 8
+/// bytes). It can point to objects within the first 4 GiB x the unit,
+/// e.g., 32 GiB for 8-byte aligned objects.
+/// As segment_relative_ptr, the base address is shared by all pointers and
+/// must be set by set_segment_relative_ptr_base() before dereferencing them.
+/// Use it through metall::manager::compact_allocator_type to halve the
+/// pointer overhead of node-based containers, e.g., list and map.
+/// \tparam T The type of the object pointed to.
+template <typename T>
+class compact_ptr {
+ public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using pointer = T *;
+  using reference = std::add_lvalue_reference_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::random_access_iterator_tag;
+  using offset_type = std::uint32_t;
+
+  template <typename U>
+  using rebind = compact_ptr<U>;
+
+  /// \brief The unit of the offset in bytes.
+  static constexpr std::size_t scale = cptrdtl::scale<T>();
+
+  /// \brief The max number of bytes from the base address this pointer can
+  /// point to.
+  static constexpr std::size_t max_offset =
+      std::size_t(std::numeric_limits<offset_type>::max() - 1) * scale;
+
+  compact_ptr() noexcept = default;
+
+  compact_ptr(T *const ptr) noexcept : m_value(priv_encode(ptr)) {}
+
+  template <typename U,
+            std::enable_if_t<std::is_convertible_v<U *, T *>, int> = 0>
+  compact_ptr(const compact_ptr<U> &other) noexcept
+      : compact_ptr(static_cast<T *>(other.get())) {}
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  static compact_ptr pointer_to(U &ref) noexcept {
+    return compact_ptr(&ref);
+  }
+
+  /// \brief Returns the raw pointer. Returns nullptr if this is null.
+  T *get() const noexcept { return m_value ? priv_address() : nullptr; }
+
+  /// \brief Dereferences without checking if this is null.
+  T *operator->() const noexcept { return priv_address(); }
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  U &operator*() const noexcept {
+    return *priv_address();
+  }
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  U &operator[](const difference_type n) const noexcept {
+    return priv_address()[n];
+  }
+
+  explicit operator bool() const noexcept { return m_value != 0; }
+
+  bool operator!() const noexcept { return m_value == 0; }
+
+  compact_ptr &operator+=(const difference_type n) noexcept {
+    m_value += offset_type(n * difference_type(k_units_per_element));
+    return *this;
+  }
+
+  compact_ptr &operator-=(const difference_type n) noexcept {
+    m_value -= offset_type(n * difference_type(k_units_per_element));
+    return *this;
+  }
+
+  compact_ptr &operator++() noexcept { return *this += 1; }
+
+  compact_ptr operator++(int) noexcept {
+    auto tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  compact_ptr &operator--() noexcept { return *this -= 1; }
+
+  compact_ptr operator--(int) noexcept {
+    auto tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  friend compact_ptr operator+(compact_ptr ptr,
+                               const difference_type n) noexcept {
+    return ptr += n;
+  }
+
+  friend compact_ptr operator+(const difference_type n,
+                               compact_ptr ptr) noexcept {
+    return ptr += n;
+  }
+
+  friend compact_ptr operator-(compact_ptr ptr,
+                               const difference_type n) noexcept {
+    return ptr -= n;
+  }
+
+  friend difference_type operator-(const compact_ptr &lhs,
+                                   const compact_ptr &rhs) noexcept {
+    return (difference_type(lhs.m_value) - difference_type(rhs.m_value)) /
+           difference_type(k_units_per_element);
+  }
+
+  friend bool operator==(const compact_ptr &lhs,
+                         const compact_ptr &rhs) noexcept {
+    return lhs.m_value == rhs.m_value;
+  }
+
+  friend bool operator!=(const compact_ptr &lhs,
+                         const compact_ptr &rhs) noexcept {
+    return lhs.m_value != rhs.m_value;
+  }
+
+  friend bool operator<(const compact_ptr &lhs,
+                        const compact_ptr &rhs) noexcept {
+    return lhs.m_value < rhs.m_value;
+  }
+
+  friend bool operator>(const compact_ptr &lhs,
+                        const compact_ptr &rhs) noexcept {
+    return rhs < lhs;
+  }
+
+  friend bool operator<=(const compact_ptr &lhs,
+                         const compact_ptr &rhs) noexcept {
+    return !(rhs < lhs);
+  }
+
+  friend bool operator>=(const compact_ptr &lhs,
+                         const compact_ptr &rhs) noexcept {
+    return !(lhs < rhs);
+  }
+
+ private:
+  static constexpr std::size_t k_units_per_element = [] {
+    if constexpr (std::is_void_v<T>) {
+      return std::size_t(1);
+    } else {
+      return sizeof(T) / scale;
+    }
+  }();
+
+  /// \brief Returns 0 for nullptr; otherwise, the offset in units + 1.
+  static offset_type priv_encode(T *const ptr) noexcept {
+    if (!ptr) return 0;
+    const auto offset =
+        reinterpret_cast<const std::byte *>(ptr) - srpdtl::g_base;
+    assert(offset >= 0 && std::size_t(offset) <= max_offset &&
+           std::size_t(offset) % scale == 0);
+    return offset_type(std::size_t(offset) / scale + 1);
+  }
+
+  T *priv_address() const noexcept {
+    return reinterpret_cast<T *>(const_cast<std::byte *>(
+        srpdtl::g_base + (std::size_t(m_value) - 1) * scale));
+  }
+
+  offset_type m_value{0};
+};
+
+static_assert(sizeof(compact_ptr<int>) == 4);
+static_assert(std::is_trivially_copyable_v<compact_ptr<int>>);
+
+/// \brief Converts a compact_ptr to the corresponding raw pointer.
+template <typename T>
+inline T *to_raw_pointer(const compact_ptr<T> &ptr) noexcept {
+  return ptr.get();
+}
+
+}  // namespace metall
+
+#endif  // METALL_COMPACT_PTR_HPP
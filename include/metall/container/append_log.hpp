@@ -0,0 +1,368 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_APPEND_LOG_HPP
+#define METALL_CONTAINER_APPEND_LOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/atomic_relative_ptr.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief The default function to get the time of a record in append_log,
+/// which returns its 'timestamp' member.
+struct append_log_timestamp {
+  template <typename record_type>
+  uint64_t operator()(const record_type &record) const {
+    return record.timestamp;
+  }
+};
+
+/// \brief An append-only log of records which can be stored in persistent
+/// memory, e.g., an event stream that is appended to by many threads and
+/// scanned by time later.
+/// An appender reserves the positions of its records with an atomic
+/// increment and copies them in without a lock; the records become visible
+/// to the readers in the order of the positions once all the records before
+/// them are written, i.e., size() is the number of the records that can be
+/// read.
+/// The records are stored in segments of 'k_segment_bytes' bytes, which are
+/// allocated in whole chunks by Metall and are never moved; references to
+/// the records stay valid. Each segment keeps the minimum and maximum times
+/// of its records (a sparse time index) so that a scan by time skips the
+/// segments out of the range; the records need not be in the time order.
+/// persist_tail() makes only the records appended since its last call
+/// durable, instead of flushing the whole datastore.
+/// \tparam _record_type A record type. Must be trivially copyable.
+/// \tparam _timestamp_function A function object type that returns the time
+/// (uint64_t) of a record.
+/// \tparam _allocator_type An allocator type.
+/// \tparam k_segment_bytes The size of a segment in bytes.
+template <typename _record_type,
+          typename _timestamp_function = append_log_timestamp,
+          typename _allocator_type = std::allocator<_record_type>,
+          std::size_t k_segment_bytes = (1ULL << 21ULL)>
+class append_log {
+  static_assert(std::is_trivially_copyable_v<_record_type>,
+                "The record type must be trivially copyable");
+  static_assert(k_segment_bytes >= sizeof(_record_type),
+                "A segment must hold a record at least");
+
+ public:
+  using record_type = _record_type;
+  using value_type = _record_type;
+  using timestamp_function = _timestamp_function;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+
+  /// \brief The number of records in a segment.
+  static constexpr size_type k_segment_size =
+      k_segment_bytes / sizeof(record_type);
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+  using record_allocator_type = other_allocator_type<record_type>;
+  using record_allocator_traits = std::allocator_traits<record_allocator_type>;
+  using record_pointer = typename record_allocator_traits::pointer;
+
+  struct segment_entry {
+    mdtl::atomic_relative_ptr<record_type> records;
+    std::atomic<uint64_t> min_time{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> max_time{0};
+  };
+  using entry_allocator_type = other_allocator_type<segment_entry>;
+  using entry_allocator_traits = std::allocator_traits<entry_allocator_type>;
+  using entry_pointer = typename entry_allocator_traits::pointer;
+
+  static constexpr int k_num_spins = 64;
+
+ public:
+  /// \brief Constructor.
+  /// \param max_num_segments The maximum number of segments, which bounds
+  /// the number of records, capacity().
+  /// \param allocator An allocator object.
+  explicit append_log(const size_type max_num_segments = 1ULL << 14ULL,
+                      const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator), m_max_num_segments(max_num_segments) {
+    entry_allocator_type alloc(m_allocator);
+    m_directory = entry_allocator_traits::allocate(alloc, m_max_num_segments);
+    for (size_type i = 0; i < m_max_num_segments; ++i) {
+      new (priv_entry(i)) segment_entry();
+    }
+  }
+
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit append_log(const allocator_type &allocator)
+      : append_log(1ULL << 14ULL, allocator) {}
+
+  /// \brief Destructor. Must not be called concurrently with others.
+  ~append_log() noexcept { priv_destroy(); }
+
+  append_log(const append_log &) = delete;
+  append_log(append_log &&) = delete;
+  append_log &operator=(const append_log &) = delete;
+  append_log &operator=(append_log &&) = delete;
+
+  // -------------------- //
+  // Append
+  // -------------------- //
+  /// \brief Appends a record. This function is thread-safe.
+  /// \param record A record to append.
+  /// \return The position of the record.
+  /// \throw std::length_error if the log is full.
+  size_type append(const record_type &record) { return append(&record, 1); }
+
+  /// \brief Appends records, which get consecutive positions.
+  /// This function is thread-safe.
+  /// \param records A pointer to the records to append.
+  /// \param n The number of records.
+  /// \return The position of the first record.
+  /// \throw std::length_error if the log is full.
+  size_type append(const record_type *const records, const size_type n) {
+    const auto begin = m_reserved.fetch_add(n, std::memory_order_relaxed);
+    if (begin + n > capacity()) {
+      throw std::length_error("append_log is full");
+    }
+
+    for (size_type i = 0; i < n;) {
+      const auto segment_no = (begin + i) / k_segment_size;
+      const auto offset = (begin + i) % k_segment_size;
+      const auto count = std::min(n - i, k_segment_size - offset);
+      // The appender of the first record of a segment allocates it
+      auto *const segment = (offset == 0) ? priv_allocate_segment(segment_no)
+                                          : priv_wait_segment(segment_no);
+      std::memcpy(static_cast<void *>(segment + offset), records + i,
+                  count * sizeof(record_type));
+      priv_update_time_range(segment_no, records + i, count);
+      i += count;
+    }
+
+    // Publishes the records after the ones before them
+    for (int i = 0; m_committed.load(std::memory_order_acquire) != begin;
+         ++i) {
+      priv_check_broken();
+      if (i >= k_num_spins) std::this_thread::yield();
+    }
+    m_committed.store(begin + n, std::memory_order_release);
+    return begin;
+  }
+
+  // -------------------- //
+  // Read
+  // -------------------- //
+  /// \brief Returns the number of the records that can be read.
+  size_type size() const {
+    return m_committed.load(std::memory_order_acquire);
+  }
+
+  /// \brief Returns true if no record can be read.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns the maximum number of records.
+  size_type capacity() const { return m_max_num_segments * k_segment_size; }
+
+  /// \brief Returns a record. 'position' must be less than size().
+  const record_type &operator[](const size_type position) const {
+    return priv_entry(position / k_segment_size)
+        ->records.load()[position % k_segment_size];
+  }
+
+  /// \brief Calls a function with the records in [first, last) in the order
+  /// of the positions; 'last' is clipped to size().
+  /// \param func A function object that takes 'const record_type &'.
+  template <typename function_type>
+  void for_each(const size_type first, size_type last,
+                function_type &&func) const {
+    last = std::min(last, size());
+    for (auto position = first; position < last;) {
+      const auto segment_no = position / k_segment_size;
+      const auto *const segment = priv_entry(segment_no)->records.load();
+      const auto end = std::min(last, (segment_no + 1) * k_segment_size);
+      for (; position < end; ++position) {
+        func(segment[position % k_segment_size]);
+      }
+    }
+  }
+
+  /// \brief Calls a function with every record in the order of the
+  /// positions.
+  /// \param func A function object that takes 'const record_type &'.
+  template <typename function_type>
+  void for_each(function_type &&func) const {
+    for_each(0, size(), func);
+  }
+
+  /// \brief Calls a function with the records whose times are in
+  /// [first_time, last_time) in the order of the positions, skipping the
+  /// segments without such a record.
+  /// \param func A function object that takes 'const record_type &'.
+  template <typename function_type>
+  void for_each_in_time_range(const uint64_t first_time,
+                              const uint64_t last_time,
+                              function_type &&func) const {
+    const auto last = size();
+    for (size_type segment_no = 0; segment_no * k_segment_size < last;
+         ++segment_no) {
+      const auto *const entry = priv_entry(segment_no);
+      if (entry->max_time.load(std::memory_order_relaxed) < first_time ||
+          entry->min_time.load(std::memory_order_relaxed) >= last_time) {
+        continue;
+      }
+      for_each(segment_no * k_segment_size,
+               std::min(last, (segment_no + 1) * k_segment_size),
+               [&](const record_type &record) {
+                 const auto time = m_timestamp_function(record);
+                 if (first_time <= time && time < last_time) func(record);
+               });
+    }
+  }
+
+  // -------------------- //
+  // Persistence
+  // -------------------- //
+  /// \brief Makes the records appended since the last call durable, with
+  /// the segment directory and the counters, without flushing the whole
+  /// datastore. This function is thread-safe.
+  /// \param manager A manager that allocated this log, e.g., metall::manager.
+  /// \return Returns false on error.
+  template <typename manager_type>
+  bool persist_tail(manager_type &manager) {
+    const auto end = size();
+    auto begin = m_persisted.load();
+    if (begin >= end) return true;
+
+    bool succeeded = true;
+    const auto first_segment = begin / k_segment_size;
+    const auto last_segment = (end - 1) / k_segment_size;
+    for (auto segment_no = first_segment; segment_no <= last_segment;
+         ++segment_no) {
+      const auto first = std::max(begin, segment_no * k_segment_size);
+      const auto last = std::min(end, (segment_no + 1) * k_segment_size);
+      const auto *const segment = priv_entry(segment_no)->records.load();
+      succeeded &= manager.persist(segment + first % k_segment_size,
+                                   (last - first) * sizeof(record_type));
+    }
+    succeeded &= manager.persist(
+        priv_entry(first_segment),
+        (last_segment - first_segment + 1) * sizeof(segment_entry));
+    succeeded &= manager.persist(this, sizeof(*this));
+    if (!succeeded) return false;
+
+    while (begin < end && !m_persisted.compare_exchange_weak(begin, end)) {
+    }
+    return true;
+  }
+
+  /// \brief Returns the allocator associated with the container.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  segment_entry *priv_entry(const size_type segment_no) const {
+    return metall::to_raw_pointer(m_directory) + segment_no;
+  }
+
+  void priv_check_broken() const {
+    if (m_broken.load(std::memory_order_relaxed)) {
+      throw std::runtime_error("append_log failed to allocate a segment");
+    }
+  }
+
+  record_type *priv_allocate_segment(const size_type segment_no) {
+    record_allocator_type alloc(m_allocator);
+    try {
+      auto segment = record_allocator_traits::allocate(alloc, k_segment_size);
+      auto *const records = metall::to_raw_pointer(segment);
+      priv_entry(segment_no)->records.store(records);
+      return records;
+    } catch (...) {
+      // Lets the appenders waiting for this segment fail
+      m_broken.store(true);
+      throw;
+    }
+  }
+
+  record_type *priv_wait_segment(const size_type segment_no) const {
+    auto &entry = *priv_entry(segment_no);
+    for (int i = 0;; ++i) {
+      if (auto *const records = entry.records.load()) return records;
+      priv_check_broken();
+      if (i >= k_num_spins) std::this_thread::yield();
+    }
+  }
+
+  void priv_update_time_range(const size_type segment_no,
+                              const record_type *const records,
+                              const size_type n) {
+    if (n == 0) return;
+    uint64_t min_time = std::numeric_limits<uint64_t>::max();
+    uint64_t max_time = 0;
+    for (size_type i = 0; i < n; ++i) {
+      const auto time = m_timestamp_function(records[i]);
+      min_time = std::min(min_time, time);
+      max_time = std::max(max_time, time);
+    }
+    auto &entry = *priv_entry(segment_no);
+    auto current = entry.min_time.load(std::memory_order_relaxed);
+    while (min_time < current &&
+           !entry.min_time.compare_exchange_weak(current, min_time)) {
+    }
+    current = entry.max_time.load(std::memory_order_relaxed);
+    while (max_time > current &&
+           !entry.max_time.compare_exchange_weak(current, max_time)) {
+    }
+  }
+
+  void priv_destroy() noexcept {
+    if (!m_directory) return;
+    record_allocator_type record_alloc(m_allocator);
+    for (size_type i = 0; i < m_max_num_segments; ++i) {
+      auto *const records = priv_entry(i)->records.load();
+      if (!records) continue;
+      record_allocator_traits::deallocate(
+          record_alloc,
+          std::pointer_traits<record_pointer>::pointer_to(*records),
+          k_segment_size);
+    }
+    for (size_type i = 0; i < m_max_num_segments; ++i) {
+      priv_entry(i)->~segment_entry();
+    }
+    entry_allocator_type entry_alloc(m_allocator);
+    entry_allocator_traits::deallocate(entry_alloc, m_directory,
+                                       m_max_num_segments);
+    m_directory = nullptr;
+  }
+
+  allocator_type m_allocator;
+  size_type m_max_num_segments;
+  entry_pointer m_directory{nullptr};
+  timestamp_function m_timestamp_function{};
+  std::atomic<size_type> m_reserved{0};
+  std::atomic<size_type> m_committed{0};
+  std::atomic<size_type> m_persisted{0};
+  std::atomic<bool> m_broken{false};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_APPEND_LOG_HPP
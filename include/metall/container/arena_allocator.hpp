@@ -0,0 +1,304 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_ARENA_ALLOCATOR_HPP
+#define METALL_CONTAINER_ARENA_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include <metall/offset_ptr.hpp>
+
+namespace metall::container {
+
+/// \brief A monotonic memory resource that takes large chunks from a Metall
+/// STL compatible allocator and bump-allocates from them.
+/// Deallocations are no-ops; all memory is freed at once by release() or the
+/// destructor. Thus, it suits data structures built and then discarded, or
+/// built once and only read after.
+/// An instance can be constructed in a Metall datastore and reused after
+/// reopening it.
+/// This class is not thread-safe.
+/// \tparam StatefulAllocator The allocator to take chunks from.
+template <typename StatefulAllocator>
+class arena_resource {
+ public:
+  using allocator_type = typename std::allocator_traits<
+      StatefulAllocator>::template rebind_alloc<std::byte>;
+  using size_type = typename std::allocator_traits<allocator_type>::size_type;
+
+  /// \brief The default size of a chunk in bytes.
+  static constexpr size_type default_chunk_size = 1ULL << 20ULL;
+
+ private:
+  struct chunk_header;
+  using chunk_pointer = typename std::pointer_traits<
+      typename std::allocator_traits<allocator_type>::pointer>::
+      template rebind<chunk_header>;
+
+  struct chunk_header {
+    chunk_pointer next;
+    size_type size;
+  };
+
+  static constexpr size_type k_header_size =
+      (sizeof(chunk_header) + alignof(std::max_align_t) - 1) /
+      alignof(std::max_align_t) * alignof(std::max_align_t);
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator The allocator to take chunks from.
+  /// \param chunk_size The size of each chunk in bytes. Allocations larger
+  /// than a quarter of it take their own chunks.
+  explicit arena_resource(const StatefulAllocator &allocator,
+                          const size_type chunk_size = default_chunk_size)
+      : m_allocator(allocator),
+        m_chunk_size(std::max(chunk_size, k_header_size * 2)) {}
+
+  arena_resource(const arena_resource &) = delete;
+  arena_resource &operator=(const arena_resource &) = delete;
+
+  /// \brief Destructor that frees all chunks.
+  ~arena_resource() noexcept { release(); }
+
+  /// \brief Allocates storage from the current chunk, taking a new one if
+  /// it does not fit.
+  /// \param nbytes The size to allocate in bytes.
+  /// \param alignment The alignment of the storage. Must be a power of 2.
+  /// \return Returns a pointer to the storage.
+  /// Throws std::bad_alloc if it fails to take a chunk.
+  void *allocate(const size_type nbytes, const size_type alignment) {
+    if (m_head) {
+      const auto begin = priv_aligned_offset(m_head, m_used, alignment);
+      if (begin + nbytes <= m_head->size) {
+        m_used = begin + nbytes;
+        m_allocated_size += nbytes;
+        return priv_data(m_head) + begin;
+      }
+    }
+
+    // Reserves the space to align the storage
+    const auto size = nbytes + alignment - 1;
+    if (size > (m_chunk_size - k_header_size) / 4) {
+      // Takes a dedicated chunk not to waste the rest of the current one
+      auto chunk = priv_take_chunk(size);
+      if (m_head) {
+        chunk->next = m_head->next;
+        m_head->next = chunk;
+      } else {
+        m_head = chunk;
+        m_used = size;
+      }
+      m_allocated_size += nbytes;
+      return priv_data(chunk) + priv_aligned_offset(chunk, 0, alignment);
+    }
+
+    auto chunk = priv_take_chunk(m_chunk_size - k_header_size);
+    chunk->next = m_head;
+    m_head = chunk;
+    const auto begin = priv_aligned_offset(m_head, 0, alignment);
+    m_used = begin + nbytes;
+    m_allocated_size += nbytes;
+    return priv_data(chunk) + begin;
+  }
+
+  /// \brief Frees all chunks. All storage allocated from this object becomes
+  /// invalid.
+  void release() noexcept {
+    while (m_head) {
+      auto next = m_head->next;
+      const auto size = m_head->size + k_header_size;
+      m_head->~chunk_header();
+      m_allocator.deallocate(
+          typename std::allocator_traits<allocator_type>::pointer(
+              reinterpret_cast<std::byte *>(to_raw_pointer(m_head))),
+          size);
+      m_head = next;
+    }
+    m_used = 0;
+    m_allocated_size = 0;
+    m_num_chunks = 0;
+  }
+
+  /// \brief Returns the number of chunks taken.
+  size_type num_chunks() const noexcept { return m_num_chunks; }
+
+  /// \brief Returns the total number of bytes allocated from this object.
+  size_type allocated_size() const noexcept { return m_allocated_size; }
+
+  /// \brief Returns the allocator chunks are taken from.
+  const allocator_type &get_allocator() const noexcept { return m_allocator; }
+
+ private:
+  chunk_pointer priv_take_chunk(const size_type data_size) {
+    auto addr = m_allocator.allocate(k_header_size + data_size);
+    auto *const header =
+        ::new (static_cast<void *>(to_raw_pointer(addr))) chunk_header();
+    header->size = data_size;
+    ++m_num_chunks;
+    return chunk_pointer(header);
+  }
+
+  /// \brief Returns the offset in the data of 'chunk', not smaller than
+  /// 'offset', whose address is aligned to 'alignment'.
+  static size_type priv_aligned_offset(const chunk_pointer &chunk,
+                                       const size_type offset,
+                                       const size_type alignment) noexcept {
+    const auto addr =
+        reinterpret_cast<std::uintptr_t>(priv_data(chunk)) + offset;
+    return offset + ((addr + alignment - 1) / alignment * alignment - addr);
+  }
+
+  static std::byte *priv_data(const chunk_pointer &chunk) noexcept {
+    return reinterpret_cast<std::byte *>(to_raw_pointer(chunk)) +
+           k_header_size;
+  }
+
+  allocator_type m_allocator;
+  size_type m_chunk_size;
+  chunk_pointer m_head{nullptr};
+  /// \brief The number of bytes used in the head chunk.
+  size_type m_used{0};
+  size_type m_allocated_size{0};
+  size_type m_num_chunks{0};
+};
+
+/// \brief A Metall STL compatible allocator that allocates from an
+/// arena_resource, i.e., bump-allocates and frees nothing until the
+/// resource is released. Copies and rebound instances share the resource.
+/// \tparam StatefulAllocator The allocator the resource takes chunks from.
+template <typename StatefulAllocator>
+class arena_allocator_adaptor {
+ private:
+  using traits =
+      std::allocator_traits<std::remove_const_t<std::remove_reference_t<
+          StatefulAllocator>>>;
+
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  using stateful_allocator_type = typename std::remove_const<
+      typename std::remove_reference<StatefulAllocator>::type>::type;
+  /// \brief The resource type, which is the same for all value types.
+  using resource_type =
+      arena_resource<typename std::allocator_traits<stateful_allocator_type>::
+                         template rebind_alloc<std::byte>>;
+
+  using value_type = typename traits::value_type;
+  using pointer = typename traits::pointer;
+  using const_pointer = typename traits::const_pointer;
+  using void_pointer = typename traits::void_pointer;
+  using const_void_pointer = typename traits::const_void_pointer;
+  using difference_type = typename traits::difference_type;
+  using size_type = typename traits::size_type;
+
+  /// \brief Makes another allocator type for type T2
+  template <typename T2>
+  struct rebind {
+    using other = arena_allocator_adaptor<
+        typename traits::template rebind_alloc<T2>>;
+  };
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+
+  /// \brief Constructor.
+  /// \param resource The resource to allocate from.
+  /// Must outlive this object and its copies.
+  arena_allocator_adaptor(resource_type *const resource) noexcept
+      : m_resource(resource) {}
+
+  /// \brief Construct a new instance using an instance that has a different
+  /// value type.
+  template <typename stateful_allocator_type2,
+            std::enable_if_t<
+                std::is_same_v<typename arena_allocator_adaptor<
+                                   stateful_allocator_type2>::resource_type,
+                               resource_type>,
+                int> = 0>
+  arena_allocator_adaptor(
+      const arena_allocator_adaptor<stateful_allocator_type2>
+          &allocator_instance) noexcept
+      : m_resource(allocator_instance.get_resource()) {}
+
+  arena_allocator_adaptor(const arena_allocator_adaptor &) noexcept = default;
+  arena_allocator_adaptor(arena_allocator_adaptor &&) noexcept = default;
+  arena_allocator_adaptor &operator=(const arena_allocator_adaptor &) noexcept =
+      default;
+  arena_allocator_adaptor &operator=(arena_allocator_adaptor &&) noexcept =
+      default;
+
+  /// \brief Allocates n * sizeof(T) bytes of storage
+  /// \param n The size to allocation
+  /// \return Returns a pointer
+  pointer allocate(const size_type n) const {
+    if (max_size() < n) {
+      throw std::bad_array_new_length();
+    }
+    return pointer(static_cast<value_type *>(
+        get_resource()->allocate(n * sizeof(value_type), alignof(value_type))));
+  }
+
+  /// \brief Does nothing; the storage is freed when the resource is
+  /// released.
+  void deallocate(pointer, const size_type) const noexcept {}
+
+  /// \brief The size of the theoretical maximum allocation size
+  /// \return The size of the theoretical maximum allocation size
+  size_type max_size() const noexcept {
+    return std::numeric_limits<size_type>::max() / sizeof(value_type);
+  }
+
+  /// \brief Constructs an object of T
+  /// \tparam Args The types of the constructor arguments
+  /// \param ptr A pointer to allocated storage
+  /// \param args The constructor arguments to use
+  template <class... Args>
+  void construct(const pointer &ptr, Args &&...args) const {
+    ::new ((void *)to_raw_pointer(ptr)) value_type(std::forward<Args>(args)...);
+  }
+
+  /// \brief Deconstruct an object of T
+  /// \param ptr A pointer to the object
+  void destroy(const pointer &ptr) const { (*ptr).~value_type(); }
+
+  // ---------- This class's unique public functions ---------- //
+
+  /// \brief Returns the resource this allocator allocates from.
+  resource_type *get_resource() const noexcept {
+    return to_raw_pointer(m_resource);
+  }
+
+ private:
+  typename std::pointer_traits<void_pointer>::template rebind<resource_type>
+      m_resource;
+};
+
+template <typename stateful_allocator_type>
+inline bool operator==(
+    const arena_allocator_adaptor<stateful_allocator_type> &rhd,
+    const arena_allocator_adaptor<stateful_allocator_type> &lhd) {
+  // Return true if they allocate from the same resource
+  return rhd.get_resource() == lhd.get_resource();
+}
+
+template <typename stateful_allocator_type>
+inline bool operator!=(
+    const arena_allocator_adaptor<stateful_allocator_type> &rhd,
+    const arena_allocator_adaptor<stateful_allocator_type> &lhd) {
+  return !(rhd == lhd);
+}
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_ARENA_ALLOCATOR_HPP
@@ -0,0 +1,246 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_BLOOM_FILTER_HPP
+#define METALL_CONTAINER_BLOOM_FILTER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <metall/container/vector.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/hash.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+namespace bfdtl {
+template <typename key_type>
+using default_hash =
+    std::conditional_t<std::is_convertible_v<const key_type &,
+                                             std::string_view>,
+                       mdtl::wy_str_hash<>, mdtl::wy_hash<>>;
+}  // namespace bfdtl
+
+/// \brief A blocked Bloom filter, which can be stored in persistent memory,
+/// e.g., to skip the lookups of a large container for the keys that are not
+/// in it; a miss in a container on storage reads its pages anyway.
+/// contains() never returns false for a key inserted; it returns true for a
+/// key not inserted at the false positive rate, e.g., about 1% with 10 bits
+/// per key.
+/// This is a split block Bloom filter: a key sets one bit in each of the 8
+/// 32-bit words of one 256-bit block; thus, a lookup accesses one cache line
+/// and is done with a few AVX2 instructions if available.
+/// Keys cannot be removed. To keep a filter in sync with a container, insert
+/// the keys into the filter when inserting them into the container, and
+/// rebuild the filter (clear() and insert()) after many removals.
+/// The filter is much smaller than the container; it can be kept in memory,
+/// e.g., by basic_manager::pin().
+/// \tparam Key A key type.
+/// \tparam Hash A hash function type that returns 64 bits. The default is
+/// wy_str_hash for the keys convertible to std::string_view and wy_hash for
+/// the others.
+/// \tparam Allocator An allocator type.
+template <typename Key, typename Hash = bfdtl::default_hash<Key>,
+          typename Allocator = manager::allocator_type<std::byte>>
+class blocked_bloom_filter {
+ public:
+  using key_type = Key;
+  using hasher = Hash;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+
+ private:
+  using word_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<uint32_t>;
+
+  static constexpr std::size_t k_num_block_words = 8;
+  static constexpr std::size_t k_block_bits = 32 * k_num_block_words;
+
+ public:
+  /// \brief Constructor.
+  /// \param num_keys The expected number of keys.
+  /// \param bits_per_key The number of bits per expected key, which
+  /// determines the false positive rate: about 2% with 8 and 0.1% with 16.
+  /// \param allocator An allocator object.
+  explicit blocked_bloom_filter(
+      const size_type num_keys, const double bits_per_key = 10,
+      const allocator_type &allocator = allocator_type())
+      : m_words(priv_num_blocks(num_keys, bits_per_key) * k_num_block_words,
+                0, allocator),
+        m_num_blocks(m_words.size() / k_num_block_words) {}
+
+  /// \brief Constructor.
+  /// \param num_keys The expected number of keys.
+  /// \param allocator An allocator object.
+  blocked_bloom_filter(const size_type num_keys,
+                       const allocator_type &allocator)
+      : blocked_bloom_filter(num_keys, 10, allocator) {}
+
+  /// \brief Inserts a key. This function is thread-safe.
+  template <typename key_type2>
+  void insert(const key_type2 &key) {
+    insert_hash(m_hash(key));
+  }
+
+  /// \brief Inserts the keys in [first, last). This function is thread-safe.
+  template <typename input_iterator>
+  void insert(input_iterator first, input_iterator last) {
+    for (; first != last; ++first) insert(*first);
+  }
+
+  /// \brief Inserts a key by its hash value, computed by hasher.
+  /// This function is thread-safe.
+  void insert_hash(const uint64_t hash) {
+    uint32_t mask[k_num_block_words];
+    priv_make_mask(hash, mask);
+    auto *const block = priv_block(hash);
+    for (std::size_t i = 0; i < k_num_block_words; ++i) {
+      // Do not write the cache line if the bit is set, e.g., for duplicates
+      if ((block[i] & mask[i]) != mask[i]) {
+        mdtl::atomic_fetch_or(&block[i], mask[i]);
+      }
+    }
+  }
+
+  /// \brief Checks if a key may be inserted.
+  /// Can be called while other threads insert keys; a key being inserted may
+  /// not be found yet.
+  /// \return False if the key has not been inserted; true if the key has
+  /// been inserted or at the false positive rate.
+  template <typename key_type2>
+  bool contains(const key_type2 &key) const {
+    return contains_hash(m_hash(key));
+  }
+
+  /// \brief Same as contains() but takes the hash value of a key.
+  bool contains_hash(const uint64_t hash) const {
+    const auto *const block = priv_block(hash);
+#ifdef __AVX2__
+    const __m256i mask = priv_make_mask_avx2(hash);
+    const __m256i words =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    // True if all bits of 'mask' are set in 'words'
+    return _mm256_testc_si256(words, mask);
+#else
+    uint32_t mask[k_num_block_words];
+    priv_make_mask(hash, mask);
+    bool found = true;
+    for (std::size_t i = 0; i < k_num_block_words; ++i) {
+      found &= ((block[i] & mask[i]) == mask[i]);
+    }
+    return found;
+#endif
+  }
+
+  /// \brief Checks n keys at once, e.g., to remove the keys not in a
+  /// container before looking up the others. Faster than calling contains()
+  /// n times for a large filter: the blocks of the keys are prefetched
+  /// before any key is checked.
+  /// \param first The beginning of the keys.
+  /// \param n The number of keys.
+  /// \param out The beginning of the results to store, convertible from
+  /// bool.
+  template <typename input_iterator, typename output_iterator>
+  void contains_batch(input_iterator first, const size_type n,
+                      output_iterator out) const {
+    constexpr std::size_t k_batch_size = 16;
+    uint64_t hashes[k_batch_size];
+    for (size_type i = 0; i < n; i += k_batch_size) {
+      const auto batch_size = std::min<size_type>(k_batch_size, n - i);
+      for (std::size_t j = 0; j < batch_size; ++j, ++first) {
+        hashes[j] = m_hash(*first);
+        __builtin_prefetch(priv_block(hashes[j]));
+      }
+      for (std::size_t j = 0; j < batch_size; ++j, ++out) {
+        *out = contains_hash(hashes[j]);
+      }
+    }
+  }
+
+  /// \brief Removes all keys.
+  /// Must not be called while the other threads access the filter.
+  void clear() { std::fill(m_words.begin(), m_words.end(), 0); }
+
+  /// \brief Returns the number of bits.
+  size_type num_bits() const { return m_num_blocks * k_block_bits; }
+
+  /// \brief Returns the fraction of the bits set, which increases with the
+  /// false positive rate; e.g., a filter with 10 bits per key has about a
+  /// half of its bits set when it has the keys expected.
+  double fill_ratio() const {
+    size_type num_set = 0;
+    for (const auto w : m_words) num_set += __builtin_popcount(w);
+    return double(num_set) / double(num_bits());
+  }
+
+  /// \brief Returns the hash function object.
+  hasher hash_function() const { return m_hash; }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_words.get_allocator());
+  }
+
+ private:
+  static size_type priv_num_blocks(const size_type num_keys,
+                                   const double bits_per_key) {
+    const auto num_bits =
+        double(std::max<size_type>(num_keys, 1)) * std::max(bits_per_key, 1.0);
+    return std::max<size_type>(
+        1, size_type(num_bits + k_block_bits - 1) / k_block_bits);
+  }
+
+  /// \brief Returns the block of a hash value, selected by the upper 32 bits
+  /// (multiply-shift instead of modulo).
+  uint32_t *priv_block(const uint64_t hash) const {
+    const auto index = ((hash >> 32U) * uint64_t(m_num_blocks)) >> 32U;
+    return const_cast<uint32_t *>(&m_words[index * k_num_block_words]);
+  }
+
+  // Odd constants to pick a bit in each word from the lower 32 bits of a
+  // hash value (the ones of Apache Parquet)
+  static constexpr uint32_t k_salts[k_num_block_words] = {
+      0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+      0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+  static void priv_make_mask(const uint64_t hash,
+                             uint32_t (&mask)[k_num_block_words]) {
+    const auto key = uint32_t(hash);
+    for (std::size_t i = 0; i < k_num_block_words; ++i) {
+      mask[i] = uint32_t(1) << ((key * k_salts[i]) >> 27U);
+    }
+  }
+
+#ifdef __AVX2__
+  static __m256i priv_make_mask_avx2(const uint64_t hash) {
+    const __m256i salts =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(k_salts));
+    const __m256i products =
+        _mm256_mullo_epi32(_mm256_set1_epi32(int(uint32_t(hash))), salts);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1),
+                             _mm256_srli_epi32(products, 27));
+  }
+#endif
+
+  vector<uint32_t, word_allocator_type> m_words;
+  size_type m_num_blocks;
+  hasher m_hash{};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_BLOOM_FILTER_HPP
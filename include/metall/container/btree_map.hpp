@@ -0,0 +1,1034 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_BTREE_MAP_HPP
+#define METALL_CONTAINER_BTREE_MAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+
+namespace metall::container {
+
+/// \brief An ordered map container implemented as a B+tree, which can be
+/// stored in persistent memory.
+/// Unlike a red-black tree map, each node holds many elements in sorted
+/// arrays, and the leaves are linked; thus, searches touch a few cache lines
+/// per level and range scans read memory (and pages) sequentially.
+/// All nodes are the same size so that they are allocated from one size
+/// class of the allocator.
+/// Like boost::container::flat_map, the value type is std::pair<key_type,
+/// mapped_type>; keys must not be modified through iterators.
+/// Inserting or erasing an element invalidates all iterators and references.
+/// \tparam _key_type A key type.
+/// \tparam _mapped_type A mapped type.
+/// \tparam _compare A key compare.
+/// \tparam _allocator_type An allocator type.
+/// \tparam k_node_size The size of a node in bytes. Should be a multiple of
+/// the cache line size.
+template <typename _key_type, typename _mapped_type,
+          typename _compare = std::less<_key_type>,
+          typename _allocator_type =
+              std::allocator<std::pair<const _key_type, _mapped_type>>,
+          std::size_t k_node_size = 512>
+class btree_map {
+ public:
+  using key_type = _key_type;
+  using mapped_type = _mapped_type;
+  using value_type = std::pair<key_type, mapped_type>;
+  using key_compare = _compare;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+
+  struct node_header;
+  struct leaf_node;
+  struct internal_node;
+
+  using node_pointer = typename std::allocator_traits<
+      other_allocator_type<node_header>>::pointer;
+  using leaf_allocator_type = other_allocator_type<leaf_node>;
+  using leaf_pointer =
+      typename std::allocator_traits<leaf_allocator_type>::pointer;
+  using internal_allocator_type = other_allocator_type<internal_node>;
+  using internal_pointer =
+      typename std::allocator_traits<internal_allocator_type>::pointer;
+
+  static constexpr std::size_t k_cache_line_size = 64;
+  static constexpr std::size_t k_header_size = 8;
+
+  static constexpr std::size_t priv_num_slots(const std::size_t space,
+                                              const std::size_t slot_size) {
+    return std::max(std::size_t(4), space / slot_size);
+  }
+
+  /// Number of elements in a leaf
+  static constexpr std::size_t k_leaf_slots = priv_num_slots(
+      k_node_size - k_header_size - 2 * sizeof(leaf_pointer),
+      sizeof(value_type));
+  /// Number of keys in an internal node
+  static constexpr std::size_t k_internal_slots = priv_num_slots(
+      k_node_size - k_header_size - sizeof(node_pointer),
+      sizeof(key_type) + sizeof(node_pointer));
+  static constexpr std::size_t k_min_leaf_slots = k_leaf_slots / 2;
+  static constexpr std::size_t k_min_internal_slots = k_internal_slots / 2;
+  static constexpr std::size_t k_max_depth = 64;
+
+  /// \brief Uninitialized storage of objects.
+  template <typename T, std::size_t N>
+  struct slot_array {
+    T *data() { return std::launder(reinterpret_cast<T *>(buf)); }
+    const T *data() const {
+      return std::launder(reinterpret_cast<const T *>(buf));
+    }
+    alignas(T) unsigned char buf[sizeof(T) * N];
+  };
+
+  struct alignas(k_cache_line_size) node_header {
+    uint32_t level{0};  // 0 for leaves
+    uint32_t size{0};   // The number of elements or keys
+  };
+
+  struct leaf_node : node_header {
+    leaf_pointer prev{nullptr};
+    leaf_pointer next{nullptr};
+    slot_array<value_type, k_leaf_slots> slots;
+  };
+
+  /// children[i] holds keys less than keys[i];
+  /// children[i + 1] holds keys equal to or greater than keys[i]
+  struct internal_node : node_header {
+    slot_array<key_type, k_internal_slots> keys;
+    node_pointer children[k_internal_slots + 1];
+  };
+
+  template <bool is_const>
+  class iterator_impl;
+
+  struct path_type {
+    internal_node *nodes[k_max_depth];
+    size_type indices[k_max_depth];
+    size_type depth{0};
+
+    void push(internal_node *const node, const size_type index) {
+      assert(depth < k_max_depth);
+      nodes[depth] = node;
+      indices[depth] = index;
+      ++depth;
+    }
+  };
+
+ public:
+  using iterator = iterator_impl<false>;
+  using const_iterator = iterator_impl<true>;
+
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit btree_map(const allocator_type &allocator = allocator_type())
+      : m_compare(), m_leaf_allocator(allocator),
+        m_internal_allocator(allocator) {}
+
+  /// \brief Constructor.
+  /// \param compare A key compare object.
+  /// \param allocator An allocator object.
+  btree_map(const key_compare &compare,
+            const allocator_type &allocator = allocator_type())
+      : m_compare(compare), m_leaf_allocator(allocator),
+        m_internal_allocator(allocator) {}
+
+  /// \brief Copy constructor.
+  btree_map(const btree_map &other)
+      : m_compare(other.m_compare),
+        m_leaf_allocator(other.m_leaf_allocator),
+        m_internal_allocator(other.m_internal_allocator) {
+    for (const auto &value : other) emplace_hint(end(), value);
+  }
+
+  /// \brief Move constructor.
+  btree_map(btree_map &&other) noexcept
+      : m_compare(other.m_compare),
+        m_leaf_allocator(other.m_leaf_allocator),
+        m_internal_allocator(other.m_internal_allocator) {
+    priv_steal(other);
+  }
+
+  /// \brief Destructor.
+  ~btree_map() noexcept { clear(); }
+
+  /// \brief Copy assignment operator.
+  btree_map &operator=(const btree_map &other) {
+    if (this == &other) return *this;
+    clear();
+    m_compare = other.m_compare;
+    for (const auto &value : other) emplace_hint(end(), value);
+    return *this;
+  }
+
+  /// \brief Move assignment operator.
+  /// The allocators of both containers must be equal.
+  btree_map &operator=(btree_map &&other) noexcept {
+    if (this == &other) return *this;
+    clear();
+    m_compare = other.m_compare;
+    priv_steal(other);
+    return *this;
+  }
+
+  // -------------------- //
+  // Capacity
+  // -------------------- //
+  /// \brief Returns the number of elements.
+  size_type size() const { return m_size; }
+
+  /// \brief Checks if the container is empty.
+  bool empty() const { return m_size == 0; }
+
+  // -------------------- //
+  // Iterators
+  // -------------------- //
+  iterator begin() {
+    return iterator(this, metall::to_raw_pointer(m_first_leaf), 0);
+  }
+  const_iterator begin() const {
+    return const_iterator(this, metall::to_raw_pointer(m_first_leaf), 0);
+  }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(this, nullptr, 0); }
+  const_iterator end() const { return const_iterator(this, nullptr, 0); }
+  const_iterator cend() const { return end(); }
+
+  // -------------------- //
+  // Lookup
+  // -------------------- //
+  /// \brief Finds an element with a key.
+  /// \return An iterator to the element if found; otherwise, end().
+  iterator find(const key_type &key) {
+    const auto [leaf, pos] = priv_find(key);
+    return leaf ? iterator(this, leaf, pos) : end();
+  }
+
+  /// \brief Finds an element with a key.
+  const_iterator find(const key_type &key) const {
+    const auto [leaf, pos] = priv_find(key);
+    return leaf ? const_iterator(this, leaf, pos) : end();
+  }
+
+  /// \brief Returns the number of elements with a key, which is 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with a key.
+  bool contains(const key_type &key) const {
+    return priv_find(key).first != nullptr;
+  }
+
+  /// \brief Returns an iterator to the first element not less than a key.
+  iterator lower_bound(const key_type &key) {
+    return priv_to_iterator(priv_bound<false>(key));
+  }
+  const_iterator lower_bound(const key_type &key) const {
+    return priv_to_iterator(priv_bound<false>(key));
+  }
+
+  /// \brief Returns an iterator to the first element greater than a key.
+  iterator upper_bound(const key_type &key) {
+    return priv_to_iterator(priv_bound<true>(key));
+  }
+  const_iterator upper_bound(const key_type &key) const {
+    return priv_to_iterator(priv_bound<true>(key));
+  }
+
+  /// \brief Returns the range of the elements with a key.
+  std::pair<iterator, iterator> equal_range(const key_type &key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      const key_type &key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  // -------------------- //
+  // Element access
+  // -------------------- //
+  /// \brief Returns a reference to the mapped value of a key.
+  /// Throws std::out_of_range if the key does not exist.
+  mapped_type &at(const key_type &key) {
+    const auto [leaf, pos] = priv_find(key);
+    if (!leaf) throw std::out_of_range("btree_map::at");
+    return leaf->slots.data()[pos].second;
+  }
+
+  /// \brief Returns a reference to the mapped value of a key.
+  const mapped_type &at(const key_type &key) const {
+    const auto [leaf, pos] = priv_find(key);
+    if (!leaf) throw std::out_of_range("btree_map::at");
+    return leaf->slots.data()[pos].second;
+  }
+
+  /// \brief Returns a reference to the mapped value of a key, inserting a
+  /// default constructed value if the key does not exist.
+  mapped_type &operator[](const key_type &key) {
+    return try_emplace(key).first->second;
+  }
+
+  // -------------------- //
+  // Modifiers
+  // -------------------- //
+  /// \brief Inserts an element if the key does not exist.
+  /// \return A pair of an iterator to the element with the key and a bool
+  /// denoting whether the insertion took place.
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  /// \brief Inserts an element if the key does not exist.
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+
+  /// \brief Inserts elements in a range.
+  template <typename input_iterator>
+  void insert(input_iterator first, input_iterator last) {
+    for (; first != last; ++first) emplace_hint(end(), *first);
+  }
+
+  /// \brief Inserts an element constructed from arguments if the key does
+  /// not exist.
+  template <typename... args_type>
+  std::pair<iterator, bool> emplace(args_type &&...args) {
+    value_type value(std::forward<args_type>(args)...);
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+
+  /// \brief Inserts an element constructed from arguments.
+  /// If 'hint' is end() and the key is greater than all existing keys, the
+  /// element is appended to the last leaf without searching; this makes
+  /// inserting sorted elements fast.
+  template <typename... args_type>
+  iterator emplace_hint(const_iterator hint, args_type &&...args) {
+    value_type value(std::forward<args_type>(args)...);
+    if (hint == cend() && m_last_leaf) {
+      auto *const leaf = metall::to_raw_pointer(m_last_leaf);
+      auto *const slots = leaf->slots.data();
+      if (leaf->size < k_leaf_slots &&
+          m_compare(slots[leaf->size - 1].first, value.first)) {
+        new (slots + leaf->size) value_type(std::move(value));
+        ++leaf->size;
+        ++m_size;
+        return iterator(this, leaf, leaf->size - 1);
+      }
+    }
+    return try_emplace(std::move(value.first), std::move(value.second))
+        .first;
+  }
+
+  /// \brief Inserts an element with a key and a mapped value constructed
+  /// from arguments if the key does not exist.
+  template <typename key_arg_type, typename... args_type>
+  std::pair<iterator, bool> try_emplace(key_arg_type &&key,
+                                        args_type &&...args) {
+    if (!m_root) {
+      auto *const leaf = priv_new_leaf();
+      m_root = leaf;
+      m_first_leaf = m_last_leaf = leaf;
+    }
+
+    path_type path;
+    auto *const leaf = priv_descend(key, &path);
+    auto *const slots = leaf->slots.data();
+    const size_type pos = priv_leaf_lower_bound(leaf, key);
+    if (pos < leaf->size && !m_compare(key, slots[pos].first)) {
+      return {iterator(this, leaf, pos), false};
+    }
+
+    ++m_size;
+    if (leaf->size < k_leaf_slots) {
+      priv_insert_at(slots, leaf->size, pos, std::piecewise_construct,
+                     std::forward_as_tuple(std::forward<key_arg_type>(key)),
+                     std::forward_as_tuple(std::forward<args_type>(args)...));
+      ++leaf->size;
+      return {iterator(this, leaf, pos), true};
+    }
+
+    // Split the leaf
+    auto *const new_leaf = priv_new_leaf();
+    const size_type num_left = (k_leaf_slots + 1) / 2;
+    const bool to_left = pos < num_left;
+    const size_type num_moves =
+        k_leaf_slots - (to_left ? num_left - 1 : num_left);
+    priv_move_construct(slots + leaf->size - num_moves, num_moves,
+                        new_leaf->slots.data());
+    leaf->size -= num_moves;
+    new_leaf->size = num_moves;
+    new_leaf->prev = leaf;
+    new_leaf->next = leaf->next;
+    if (leaf->next) {
+      metall::to_raw_pointer(leaf->next)->prev = new_leaf;
+    } else {
+      m_last_leaf = new_leaf;
+    }
+    leaf->next = new_leaf;
+
+    auto *const target = to_left ? leaf : new_leaf;
+    const size_type target_pos = to_left ? pos : pos - leaf->size;
+    priv_insert_at(target->slots.data(), target->size, target_pos,
+                   std::piecewise_construct,
+                   std::forward_as_tuple(std::forward<key_arg_type>(key)),
+                   std::forward_as_tuple(std::forward<args_type>(args)...));
+    ++target->size;
+
+    priv_insert_into_parent(&path, leaf, new_leaf->slots.data()[0].first,
+                            new_leaf);
+    return {iterator(this, target, target_pos), true};
+  }
+
+  /// \brief Inserts an element or assigns to the mapped value if the key
+  /// already exists.
+  /// \return A pair of an iterator to the element and a bool denoting
+  /// whether the insertion took place.
+  template <typename mapped_arg_type>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key,
+                                             mapped_arg_type &&mapped) {
+    auto ret = try_emplace(key, std::forward<mapped_arg_type>(mapped));
+    if (!ret.second) {
+      ret.first->second = std::forward<mapped_arg_type>(mapped);
+    }
+    return ret;
+  }
+
+  /// \brief Erases the element with a key.
+  /// \return The number of elements erased, which is 1 or 0.
+  size_type erase(const key_type &key) {
+    if (!m_root) return 0;
+    path_type path;
+    auto *const leaf = priv_descend(key, &path);
+    auto *const slots = leaf->slots.data();
+    const size_type pos = priv_leaf_lower_bound(leaf, key);
+    if (pos == leaf->size || m_compare(key, slots[pos].first)) return 0;
+
+    priv_erase_at(slots, leaf->size, pos);
+    --leaf->size;
+    --m_size;
+    priv_rebalance_leaf(&path, leaf);
+    return 1;
+  }
+
+  /// \brief Erases the element pointed by an iterator.
+  /// \return An iterator to the element following the erased one.
+  iterator erase(const_iterator position) {
+    assert(position != cend());
+    const key_type key = position->first;
+    erase(key);
+    return lower_bound(key);
+  }
+
+  /// \brief Erases the elements in a range.
+  /// \return An iterator to the element following the erased ones.
+  iterator erase(const_iterator first, const_iterator last) {
+    if (last == cend()) {
+      while (first != cend()) first = erase(first);
+      return end();
+    }
+    const key_type last_key = last->first;
+    while (m_compare(first->first, last_key)) first = erase(first);
+    return priv_to_iterator(priv_bound<false>(last_key));
+  }
+
+  /// \brief Removes all elements.
+  void clear() noexcept {
+    if (m_root) priv_destroy_subtree(metall::to_raw_pointer(m_root));
+    m_root = nullptr;
+    m_first_leaf = m_last_leaf = nullptr;
+    m_size = 0;
+  }
+
+  /// \brief Swaps the contents.
+  /// The allocators of both containers must be equal.
+  void swap(btree_map &other) noexcept {
+    std::swap(m_compare, other.m_compare);
+    node_pointer root = m_root;
+    leaf_pointer first = m_first_leaf;
+    leaf_pointer last = m_last_leaf;
+    m_root = other.m_root;
+    m_first_leaf = other.m_first_leaf;
+    m_last_leaf = other.m_last_leaf;
+    other.m_root = root;
+    other.m_first_leaf = first;
+    other.m_last_leaf = last;
+    std::swap(m_size, other.m_size);
+  }
+
+  // -------------------- //
+  // Observers
+  // -------------------- //
+  /// \brief Returns the key compare object.
+  key_compare key_comp() const { return m_compare; }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_leaf_allocator);
+  }
+
+ private:
+  // -------------------- //
+  // Array operations
+  // -------------------- //
+  /// \brief Inserts an element into an array that has 'size' elements.
+  template <typename T, typename... args_type>
+  static void priv_insert_at(T *const array, const size_type size,
+                             const size_type pos, args_type &&...args) {
+    if (pos == size) {
+      new (array + size) T(std::forward<args_type>(args)...);
+      return;
+    }
+    T value(std::forward<args_type>(args)...);
+    new (array + size) T(std::move(array[size - 1]));
+    std::move_backward(array + pos, array + size - 1, array + size);
+    array[pos] = std::move(value);
+  }
+
+  /// \brief Erases an element from an array that has 'size' elements.
+  template <typename T>
+  static void priv_erase_at(T *const array, const size_type size,
+                            const size_type pos) {
+    std::move(array + pos + 1, array + size, array + pos);
+    array[size - 1].~T();
+  }
+
+  /// \brief Moves elements to uninitialized storage.
+  template <typename T>
+  static void priv_move_construct(T *const src, const size_type count,
+                                  T *const dst) {
+    for (size_type i = 0; i < count; ++i) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+
+  // -------------------- //
+  // Node management
+  // -------------------- //
+  leaf_node *priv_new_leaf() {
+    auto ptr = std::allocator_traits<leaf_allocator_type>::allocate(
+        m_leaf_allocator, 1);
+    return new (metall::to_raw_pointer(ptr)) leaf_node();
+  }
+
+  internal_node *priv_new_internal(const uint32_t level) {
+    auto ptr = std::allocator_traits<internal_allocator_type>::allocate(
+        m_internal_allocator, 1);
+    auto *const node = new (metall::to_raw_pointer(ptr)) internal_node();
+    node->level = level;
+    return node;
+  }
+
+  void priv_delete_leaf(leaf_node *const leaf) noexcept {
+    auto *const slots = leaf->slots.data();
+    for (size_type i = 0; i < leaf->size; ++i) slots[i].~value_type();
+    leaf->~leaf_node();
+    std::allocator_traits<leaf_allocator_type>::deallocate(
+        m_leaf_allocator, leaf_pointer(leaf), 1);
+  }
+
+  void priv_delete_internal(internal_node *const node) noexcept {
+    auto *const keys = node->keys.data();
+    for (size_type i = 0; i < node->size; ++i) keys[i].~key_type();
+    node->~internal_node();
+    std::allocator_traits<internal_allocator_type>::deallocate(
+        m_internal_allocator, internal_pointer(node), 1);
+  }
+
+  void priv_destroy_subtree(node_header *const node) noexcept {
+    if (node->level == 0) {
+      priv_delete_leaf(static_cast<leaf_node *>(node));
+      return;
+    }
+    auto *const internal = static_cast<internal_node *>(node);
+    for (size_type i = 0; i <= internal->size; ++i) {
+      priv_destroy_subtree(metall::to_raw_pointer(internal->children[i]));
+    }
+    priv_delete_internal(internal);
+  }
+
+  void priv_steal(btree_map &other) noexcept {
+    m_root = other.m_root;
+    m_first_leaf = other.m_first_leaf;
+    m_last_leaf = other.m_last_leaf;
+    m_size = other.m_size;
+    other.m_root = nullptr;
+    other.m_first_leaf = other.m_last_leaf = nullptr;
+    other.m_size = 0;
+  }
+
+  static node_header *priv_child(const internal_node *const node,
+                                 const size_type index) {
+    assert(index <= k_internal_slots);
+    // Bounded explicitly as compilers cannot tell that the index of the
+    // combined sequence in a split stays in the array
+    return metall::to_raw_pointer(
+        node->children[std::min(index, size_type(k_internal_slots))]);
+  }
+
+  // -------------------- //
+  // Search
+  // -------------------- //
+  /// \brief Returns the child index to descend into.
+  size_type priv_child_index(const internal_node *const node,
+                             const key_type &key) const {
+    const auto *const keys = node->keys.data();
+    return std::upper_bound(keys, keys + node->size, key, m_compare) - keys;
+  }
+
+  size_type priv_leaf_lower_bound(const leaf_node *const leaf,
+                                  const key_type &key) const {
+    const auto *const slots = leaf->slots.data();
+    return std::lower_bound(slots, slots + leaf->size, key,
+                            [this](const value_type &lhs, const key_type &rhs) {
+                              return m_compare(lhs.first, rhs);
+                            }) -
+           slots;
+  }
+
+  /// \brief Goes down to the leaf that may contain a key.
+  /// Records the internal nodes and child indices on the way if 'path' is
+  /// given.
+  leaf_node *priv_descend(const key_type &key, path_type *const path) const {
+    node_header *node = metall::to_raw_pointer(m_root);
+    while (node->level > 0) {
+      auto *const internal = static_cast<internal_node *>(node);
+      const auto index = priv_child_index(internal, key);
+      if (path) path->push(internal, index);
+      node = priv_child(internal, index);
+      // Nodes are visited in order; prefetch the array of the next level
+      __builtin_prefetch(reinterpret_cast<const char *>(node) +
+                         k_cache_line_size);
+    }
+    return static_cast<leaf_node *>(node);
+  }
+
+  std::pair<leaf_node *, size_type> priv_find(const key_type &key) const {
+    if (!m_root) return {nullptr, 0};
+    auto *const leaf = priv_descend(key, nullptr);
+    const auto pos = priv_leaf_lower_bound(leaf, key);
+    if (pos == leaf->size || m_compare(key, leaf->slots.data()[pos].first)) {
+      return {nullptr, 0};
+    }
+    return {leaf, pos};
+  }
+
+  /// \brief Returns the position of lower_bound (or upper_bound when
+  /// 'upper' is true) of a key.
+  template <bool upper>
+  std::pair<leaf_node *, size_type> priv_bound(const key_type &key) const {
+    if (!m_root) return {nullptr, 0};
+    leaf_node *leaf = priv_descend(key, nullptr);
+    const auto *const slots = leaf->slots.data();
+    size_type pos;
+    if constexpr (upper) {
+      pos = std::upper_bound(slots, slots + leaf->size, key,
+                             [this](const key_type &lhs,
+                                    const value_type &rhs) {
+                               return m_compare(lhs, rhs.first);
+                             }) -
+            slots;
+    } else {
+      pos = priv_leaf_lower_bound(leaf, key);
+    }
+    if (pos == leaf->size) {
+      // The bound is the first element of the next leaf
+      leaf = metall::to_raw_pointer(leaf->next);
+      pos = 0;
+    }
+    return {leaf, pos};
+  }
+
+  iterator priv_to_iterator(const std::pair<leaf_node *, size_type> &pos) {
+    return iterator(this, pos.first, pos.second);
+  }
+
+  const_iterator priv_to_iterator(
+      const std::pair<leaf_node *, size_type> &pos) const {
+    return const_iterator(this, pos.first, pos.second);
+  }
+
+  // -------------------- //
+  // Insertion
+  // -------------------- //
+  /// \brief Inserts a separator key and a new right node next to 'left'.
+  void priv_insert_into_parent(path_type *const path, node_header *left,
+                               key_type key, node_header *right) {
+    while (true) {
+      if (path->depth == 0) {
+        // Grow the tree
+        auto *const root = priv_new_internal(left->level + 1);
+        new (root->keys.data()) key_type(std::move(key));
+        root->children[0] = left;
+        root->children[1] = right;
+        root->size = 1;
+        m_root = root;
+        return;
+      }
+
+      --path->depth;
+      auto *const parent = path->nodes[path->depth];
+      const auto index = path->indices[path->depth];
+      auto *const keys = parent->keys.data();
+      if (parent->size < k_internal_slots) {
+        priv_insert_at(keys, parent->size, index, std::move(key));
+        priv_insert_child_at(parent, index + 1, right);
+        ++parent->size;
+        return;
+      }
+
+      // Split the parent; the middle key goes up
+      auto *const new_node = priv_new_internal(parent->level);
+      // Split the combined sequence of k_internal_slots + 1 keys
+      const size_type total = k_internal_slots + 1;
+      const size_type mid = total / 2;
+      const auto key_at = [&](const size_type i) -> key_type & {
+        if (i < index) return keys[i];
+        if (i == index) return key;
+        return keys[i - 1];
+      };
+      const auto child_at = [&](const size_type i) -> node_header * {
+        if (i <= index) return priv_child(parent, i);
+        if (i == index + 1) return right;
+        return priv_child(parent, i - 1);
+      };
+
+      // Fill the new (right) node
+      auto *const new_keys = new_node->keys.data();
+      for (size_type i = mid + 1; i < total; ++i) {
+        new (new_keys + (i - mid - 1)) key_type(std::move(key_at(i)));
+      }
+      for (size_type i = mid + 1; i <= total; ++i) {
+        new_node->children[i - mid - 1] = child_at(i);
+      }
+      new_node->size = total - mid - 1;
+      key_type mid_key(std::move(key_at(mid)));
+
+      // Rebuild the left part in place
+      if (index < mid) {
+        for (size_type i = mid - 1; i > index; --i) {
+          keys[i] = std::move(keys[i - 1]);
+        }
+        keys[index] = std::move(key);
+        for (size_type i = mid; i > index + 1; --i) {
+          parent->children[i] = parent->children[i - 1];
+        }
+        parent->children[index + 1] = right;
+      }
+      for (size_type i = mid; i < k_internal_slots; ++i) keys[i].~key_type();
+      for (size_type i = mid + 1; i <= k_internal_slots; ++i) {
+        parent->children[i] = nullptr;
+      }
+      parent->size = mid;
+
+      left = parent;
+      right = new_node;
+      key = std::move(mid_key);
+    }
+  }
+
+  static void priv_insert_child_at(internal_node *const node,
+                                   const size_type index,
+                                   node_header *const child) {
+    for (size_type i = node->size + 1; i > index; --i) {
+      node->children[i] = node->children[i - 1];
+    }
+    node->children[index] = child;
+  }
+
+  static void priv_erase_child_at(internal_node *const node,
+                                  const size_type index) {
+    for (size_type i = index; i < node->size; ++i) {
+      node->children[i] = node->children[i + 1];
+    }
+    node->children[node->size] = nullptr;
+  }
+
+  // -------------------- //
+  // Erase
+  // -------------------- //
+  void priv_rebalance_leaf(path_type *const path, leaf_node *const leaf) {
+    if (path->depth == 0) {
+      // The root is a leaf
+      if (leaf->size == 0) clear();
+      return;
+    }
+    if (leaf->size >= k_min_leaf_slots) return;
+
+    auto *const parent = path->nodes[path->depth - 1];
+    const auto index = path->indices[path->depth - 1];
+    auto *const parent_keys = parent->keys.data();
+    auto *const slots = leaf->slots.data();
+
+    if (index > 0) {
+      auto *const left =
+          static_cast<leaf_node *>(priv_child(parent, index - 1));
+      auto *const left_slots = left->slots.data();
+      if (left->size > k_min_leaf_slots) {
+        // Borrow the last element of the left sibling
+        priv_insert_at(slots, leaf->size, 0,
+                       std::move(left_slots[left->size - 1]));
+        left_slots[left->size - 1].~value_type();
+        --left->size;
+        ++leaf->size;
+        parent_keys[index - 1] = slots[0].first;
+        return;
+      }
+    }
+    if (index < parent->size) {
+      auto *const right =
+          static_cast<leaf_node *>(priv_child(parent, index + 1));
+      auto *const right_slots = right->slots.data();
+      if (right->size > k_min_leaf_slots) {
+        // Borrow the first element of the right sibling
+        new (slots + leaf->size) value_type(std::move(right_slots[0]));
+        priv_erase_at(right_slots, right->size, 0);
+        --right->size;
+        ++leaf->size;
+        parent_keys[index] = right_slots[0].first;
+        return;
+      }
+    }
+
+    // Merge with a sibling; the right one of the two is removed
+    leaf_node *left;
+    leaf_node *right;
+    size_type key_index;
+    if (index > 0) {
+      left = static_cast<leaf_node *>(priv_child(parent, index - 1));
+      right = leaf;
+      key_index = index - 1;
+    } else {
+      left = leaf;
+      right = static_cast<leaf_node *>(priv_child(parent, index + 1));
+      key_index = index;
+    }
+    priv_move_construct(right->slots.data(), right->size,
+                        left->slots.data() + left->size);
+    left->size += right->size;
+    right->size = 0;
+    left->next = right->next;
+    if (right->next) {
+      metall::to_raw_pointer(right->next)->prev = left;
+    } else {
+      m_last_leaf = left;
+    }
+    priv_delete_leaf(right);
+
+    priv_erase_at(parent_keys, parent->size, key_index);
+    priv_erase_child_at(parent, key_index + 1);
+    --parent->size;
+    --path->depth;
+    priv_rebalance_internal(path, parent);
+  }
+
+  void priv_rebalance_internal(path_type *const path, internal_node *node) {
+    while (true) {
+      if (path->depth == 0) {
+        // Shrink the tree if the root has only one child
+        if (node->size == 0) {
+          m_root = priv_child(node, 0);
+          node->children[0] = nullptr;
+          priv_delete_internal(node);
+        }
+        return;
+      }
+      if (node->size >= k_min_internal_slots) return;
+
+      auto *const parent = path->nodes[path->depth - 1];
+      const auto index = path->indices[path->depth - 1];
+      auto *const parent_keys = parent->keys.data();
+      auto *const keys = node->keys.data();
+
+      if (index > 0) {
+        auto *const left =
+            static_cast<internal_node *>(priv_child(parent, index - 1));
+        if (left->size > k_min_internal_slots) {
+          // Rotate right through the parent
+          auto *const left_keys = left->keys.data();
+          priv_insert_at(keys, node->size, 0,
+                         std::move(parent_keys[index - 1]));
+          priv_insert_child_at(node, 0, priv_child(left, left->size));
+          ++node->size;
+          parent_keys[index - 1] = std::move(left_keys[left->size - 1]);
+          left_keys[left->size - 1].~key_type();
+          left->children[left->size] = nullptr;
+          --left->size;
+          return;
+        }
+      }
+      if (index < parent->size) {
+        auto *const right =
+            static_cast<internal_node *>(priv_child(parent, index + 1));
+        if (right->size > k_min_internal_slots) {
+          // Rotate left through the parent
+          auto *const right_keys = right->keys.data();
+          new (keys + node->size) key_type(std::move(parent_keys[index]));
+          node->children[node->size + 1] = right->children[0];
+          ++node->size;
+          parent_keys[index] = std::move(right_keys[0]);
+          priv_erase_at(right_keys, right->size, 0);
+          priv_erase_child_at(right, 0);
+          --right->size;
+          return;
+        }
+      }
+
+      // Merge with a sibling, pulling down the separator key
+      internal_node *left;
+      internal_node *right;
+      size_type key_index;
+      if (index > 0) {
+        left = static_cast<internal_node *>(priv_child(parent, index - 1));
+        right = node;
+        key_index = index - 1;
+      } else {
+        left = node;
+        right = static_cast<internal_node *>(priv_child(parent, index + 1));
+        key_index = index;
+      }
+      auto *const left_keys = left->keys.data();
+      new (left_keys + left->size)
+          key_type(std::move(parent_keys[key_index]));
+      priv_move_construct(right->keys.data(), right->size,
+                          left_keys + left->size + 1);
+      for (size_type i = 0; i <= right->size; ++i) {
+        left->children[left->size + 1 + i] = right->children[i];
+        right->children[i] = nullptr;
+      }
+      left->size += right->size + 1;
+      right->size = 0;
+      priv_delete_internal(right);
+
+      priv_erase_at(parent_keys, parent->size, key_index);
+      priv_erase_child_at(parent, key_index + 1);
+      --parent->size;
+      --path->depth;
+      // Continue with the parent
+      node = parent;
+    }
+  }
+
+  key_compare m_compare;
+  leaf_allocator_type m_leaf_allocator;
+  internal_allocator_type m_internal_allocator;
+  node_pointer m_root{nullptr};
+  leaf_pointer m_first_leaf{nullptr};
+  leaf_pointer m_last_leaf{nullptr};
+  size_type m_size{0};
+};
+
+template <typename _key_type, typename _mapped_type, typename _compare,
+          typename _allocator_type, std::size_t k_node_size>
+template <bool is_const>
+class btree_map<_key_type, _mapped_type, _compare, _allocator_type,
+                k_node_size>::iterator_impl {
+ private:
+  using map_type = btree_map<_key_type, _mapped_type, _compare,
+                             _allocator_type, k_node_size>;
+  using map_pointer = std::conditional_t<is_const, const map_type *,
+                                         map_type *>;
+  friend class btree_map;
+  friend class iterator_impl<!is_const>;
+
+ public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename map_type::value_type;
+  using pointer =
+      std::conditional_t<is_const, const value_type *, value_type *>;
+  using reference =
+      std::conditional_t<is_const, const value_type &, value_type &>;
+  using iterator_category = std::bidirectional_iterator_tag;
+
+  iterator_impl() = default;
+
+  /// \brief Converts an iterator to a const iterator.
+  template <bool other_is_const,
+            typename = std::enable_if_t<is_const && !other_is_const>>
+  iterator_impl(const iterator_impl<other_is_const> &other)
+      : m_map(other.m_map), m_leaf(other.m_leaf), m_pos(other.m_pos) {}
+
+  reference operator*() const { return m_leaf->slots.data()[m_pos]; }
+  pointer operator->() const { return &m_leaf->slots.data()[m_pos]; }
+
+  iterator_impl &operator++() {
+    ++m_pos;
+    if (m_pos == m_leaf->size) {
+      m_leaf = metall::to_raw_pointer(m_leaf->next);
+      m_pos = 0;
+    }
+    return *this;
+  }
+
+  iterator_impl operator++(int) {
+    auto tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  iterator_impl &operator--() {
+    if (!m_leaf) {
+      m_leaf = metall::to_raw_pointer(m_map->m_last_leaf);
+      m_pos = m_leaf->size - 1;
+    } else if (m_pos == 0) {
+      m_leaf = metall::to_raw_pointer(m_leaf->prev);
+      m_pos = m_leaf->size - 1;
+    } else {
+      --m_pos;
+    }
+    return *this;
+  }
+
+  iterator_impl operator--(int) {
+    auto tmp(*this);
+    --(*this);
+    return tmp;
+  }
+
+  template <bool other_is_const>
+  bool operator==(const iterator_impl<other_is_const> &other) const {
+    return m_leaf == other.m_leaf && m_pos == other.m_pos;
+  }
+
+  template <bool other_is_const>
+  bool operator!=(const iterator_impl<other_is_const> &other) const {
+    return !(*this == other);
+  }
+
+ private:
+  iterator_impl(map_pointer map, leaf_node *const leaf, const size_type pos)
+      : m_map(map), m_leaf(leaf), m_pos(pos) {}
+
+  map_pointer m_map{nullptr};
+  leaf_node *m_leaf{nullptr};
+  size_type m_pos{0};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_BTREE_MAP_HPP
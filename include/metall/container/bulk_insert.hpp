@@ -0,0 +1,109 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_BULK_INSERT_HPP
+#define METALL_CONTAINER_BULK_INSERT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/container/container_fwd.hpp>
+#include <boost/container/map.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace metall::container {
+
+/// \brief Tag to tell bulk_insert() that the input range is sorted by key
+/// and has no duplicate keys.
+using boost::container::ordered_unique_range;
+using boost::container::ordered_unique_range_t;
+
+/// \brief Inserts elements sorted by key into a map in linear time.
+/// Each element is inserted right after the previously inserted one;
+/// thus, unlike inserting elements one by one, no search is performed as
+/// long as the existing elements do not interleave with the input.
+/// \param map A map to insert elements into.
+/// \param first The beginning of the elements to insert.
+/// Must be sorted by key and must not contain duplicate keys.
+/// \param last The end of the elements to insert.
+/// \return The number of elements inserted.
+/// Elements whose key already exists in the map are not inserted.
+template <typename key_type, typename mapped_type, typename... params,
+          typename input_iterator>
+std::size_t bulk_insert(
+    boost::container::map<key_type, mapped_type, params...> &map,
+    ordered_unique_range_t, input_iterator first, input_iterator last) {
+  const auto old_size = map.size();
+  auto hint = map.end();
+  for (; first != last; ++first) {
+    hint = map.emplace_hint(hint, *first);
+    ++hint;
+  }
+  return map.size() - old_size;
+}
+
+/// \brief Inserts elements into a map.
+/// The elements are copied into a temporary buffer in the process memory
+/// and sorted by key first; then, inserted in linear time.
+/// If the input contains duplicate keys, only the first one is inserted.
+/// \param map A map to insert elements into.
+/// \param first The beginning of the elements to insert.
+/// \param last The end of the elements to insert.
+/// \return The number of elements inserted.
+template <typename key_type, typename mapped_type, typename... params,
+          typename input_iterator>
+std::size_t bulk_insert(
+    boost::container::map<key_type, mapped_type, params...> &map,
+    input_iterator first, input_iterator last) {
+  std::vector<std::pair<key_type, mapped_type>> buf(first, last);
+  const auto comp = map.key_comp();
+  std::stable_sort(buf.begin(), buf.end(),
+                   [&comp](const auto &lhs, const auto &rhs) {
+                     return comp(lhs.first, rhs.first);
+                   });
+  buf.erase(std::unique(buf.begin(), buf.end(),
+                        [&comp](const auto &lhs, const auto &rhs) {
+                          return !comp(lhs.first, rhs.first) &&
+                                 !comp(rhs.first, lhs.first);
+                        }),
+            buf.end());
+  return bulk_insert(map, ordered_unique_range,
+                     std::make_move_iterator(buf.begin()),
+                     std::make_move_iterator(buf.end()));
+}
+
+/// \brief Inserts elements into an unordered map.
+/// Reserves the buckets for all elements first so that the table is not
+/// rehashed during the insertion.
+/// \param map A map to insert elements into.
+/// \param first The beginning of the elements to insert.
+/// \param last The end of the elements to insert.
+/// \param size_hint The number of elements to insert.
+/// If 0 is given and the input is a forward range, the number is calculated
+/// from the range.
+/// \return The number of elements inserted.
+template <typename key_type, typename mapped_type, typename... params,
+          typename input_iterator>
+std::size_t bulk_insert(
+    boost::unordered_map<key_type, mapped_type, params...> &map,
+    input_iterator first, input_iterator last, std::size_t size_hint = 0) {
+  using category =
+      typename std::iterator_traits<input_iterator>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    if (size_hint == 0) size_hint = std::distance(first, last);
+  }
+  const auto old_size = map.size();
+  map.reserve(old_size + size_hint);
+  map.insert(first, last);
+  return map.size() - old_size;
+}
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_BULK_INSERT_HPP
@@ -0,0 +1,311 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_CONCURRENT_ADJACENCY_LIST_HPP
+#define METALL_CONTAINER_CONCURRENT_ADJACENCY_LIST_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/container/vector.hpp>
+#include <boost/container/scoped_allocator.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/detail/numa.hpp>
+#include <metall/utility/hash.hpp>
+#include <metall/utility/mutex.hpp>
+#include <metall/utility/container_of_containers_iterator_adaptor.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A concurrent adjacency list container which can be stored in
+/// persistent memory.
+/// Keys (source vertices) are distributed to partitions; each partition is a
+/// hash table of keys to value (e.g., neighbor vertex) lists and has its own
+/// copy of the allocator. The partitions are protected by static mutex
+/// objects, as concurrent_map does.
+/// \tparam _key_type A key type.
+/// \tparam _value_type A value type.
+/// \tparam _allocator_type An allocator type.
+template <typename _key_type, typename _value_type,
+          typename _allocator_type = std::allocator<std::byte>>
+class concurrent_adjacency_list {
+ public:
+  using key_type = _key_type;
+  using value_type = _value_type;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+
+  /// \brief The default number of partitions.
+  static constexpr size_type k_default_num_partitions = 256;
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+
+  using list_type =
+      boost::container::vector<value_type, other_allocator_type<value_type>>;
+  using partition_type = boost::unordered_map<
+      key_type, list_type, metall::utility::hash<>, std::equal_to<key_type>,
+      boost::container::scoped_allocator_adaptor<
+          other_allocator_type<std::pair<const key_type, list_type>>>>;
+  using partition_table_type = boost::container::vector<
+      partition_type, boost::container::scoped_allocator_adaptor<
+                          other_allocator_type<partition_type>>>;
+
+  // Partitions share static mutexes when there are more than this number
+  static constexpr size_type k_num_locks = 1024;
+  // Must be different from the one of the hash tables in partitions
+  static constexpr unsigned int k_partition_hash_seed = 8191;
+
+ public:
+  using value_iterator = typename list_type::iterator;
+  using const_value_iterator = typename list_type::const_iterator;
+  using const_local_key_iterator = typename partition_type::const_iterator;
+  /// \brief Visits all pairs of a key and its value list.
+  using const_key_iterator =
+      metall::utility::container_of_containers_iterator_adaptor<
+          typename partition_table_type::const_iterator,
+          const_local_key_iterator>;
+
+  /// \brief Constructor.
+  /// \param num_partitions The number of partitions.
+  /// Should be larger than the number of threads that add edges
+  /// concurrently.
+  /// \param allocator An allocator object.
+  explicit concurrent_adjacency_list(
+      const size_type num_partitions = k_default_num_partitions,
+      const allocator_type &allocator = allocator_type())
+      : m_partitions(std::max(num_partitions, size_type(1)), allocator),
+        m_num_edges(0) {}
+
+  /// \brief Adds an edge. This function is thread-safe.
+  /// \param key A key (source vertex).
+  /// \param value A value (e.g., destination vertex).
+  /// \return Always true.
+  bool add_edge(const key_type &key, value_type value) {
+    const auto partition_no = partition_index(key);
+    auto lock = priv_lock(partition_no);
+    m_partitions[partition_no][key].emplace_back(std::move(value));
+    mdtl::atomic_fetch_add_relaxed(&m_num_edges, size_type(1));
+    return true;
+  }
+
+  /// \brief Adds edges in bulk, e.g., to ingest a large graph.
+  /// The edges are distributed to the partitions in a buffer in the process
+  /// memory first. Then, the partitions are filled by multiple threads in
+  /// parallel; no two threads contend for the same partition.
+  /// \param first The beginning of the edges, i.e., pairs of a key and a
+  /// value, to add.
+  /// \param last The end of the edges to add.
+  /// \param num_threads The number of threads to use. If <= 0 is given, the
+  /// number of the hardware threads is used.
+  /// \param numa_local If true, partitions are assigned to the NUMA nodes the
+  /// process can use in a round-robin manner; each thread fills only the
+  /// partitions of one node, preferentially allocating pages on that node.
+  /// \return The number of edges added.
+  template <typename input_iterator>
+  size_type add_edges(input_iterator first, input_iterator last,
+                      int num_threads = 0, const bool numa_local = false) {
+    std::vector<std::vector<std::pair<key_type, value_type>>> buf(
+        num_partitions());
+    for (; first != last; ++first) {
+      buf[partition_index(first->first)].emplace_back(first->first,
+                                                      first->second);
+    }
+
+    std::atomic<size_type> num_added{0};
+    priv_parallel_for_partitions(
+        num_threads, numa_local,
+        [this, &buf, &num_added](const size_type partition_no) {
+          auto &partition_buf = buf[partition_no];
+          if (partition_buf.empty()) return;
+
+          // Improve locality and allocate each value list once
+          std::stable_sort(partition_buf.begin(), partition_buf.end(),
+                           [](const auto &lhs, const auto &rhs) {
+                             return lhs.first < rhs.first;
+                           });
+          auto lock = priv_lock(partition_no);
+          auto &partition = m_partitions[partition_no];
+          for (auto itr = partition_buf.begin(); itr != partition_buf.end();) {
+            auto end = itr;
+            while (end != partition_buf.end() && end->first == itr->first) {
+              ++end;
+            }
+            auto &list = partition[itr->first];
+            // Grow geometrically so that repeated small batches to the same
+            // key do not reallocate the list every time
+            const size_type required = list.size() + std::distance(itr, end);
+            if (list.capacity() < required) {
+              list.reserve(std::max(required, list.capacity() * 2));
+            }
+            for (; itr != end; ++itr) list.emplace_back(std::move(itr->second));
+          }
+          mdtl::atomic_fetch_add_relaxed(&m_num_edges,
+                                         size_type(partition_buf.size()));
+          num_added += partition_buf.size();
+          std::vector<std::pair<key_type, value_type>>().swap(partition_buf);
+        });
+    return num_added.load();
+  }
+
+  /// \brief Returns the number of keys.
+  /// This function is not thread-safe against adding edges.
+  /// \return The number of keys.
+  size_type num_keys() const {
+    size_type count = 0;
+    for (const auto &partition : m_partitions) count += partition.size();
+    return count;
+  }
+
+  /// \brief Returns the total number of edges.
+  /// \return The number of edges.
+  size_type num_edges() const { return mdtl::atomic_load(&m_num_edges); }
+
+  /// \brief Returns the number of values of a key.
+  /// \param key A key.
+  /// \return The number of values associated with 'key'.
+  size_type num_values(const key_type &key) const {
+    const auto &partition = m_partitions[partition_index(key)];
+    const auto itr = partition.find(key);
+    return (itr == partition.end()) ? 0 : itr->second.size();
+  }
+
+  /// \brief Returns an iterator to the first value of a key.
+  /// 'key' must exist.
+  value_iterator values_begin(const key_type &key) {
+    return m_partitions[partition_index(key)].at(key).begin();
+  }
+
+  /// \brief Returns an iterator to the end of the values of a key.
+  /// 'key' must exist.
+  value_iterator values_end(const key_type &key) {
+    return m_partitions[partition_index(key)].at(key).end();
+  }
+
+  /// \brief Returns an iterator to the first value of a key.
+  /// 'key' must exist.
+  const_value_iterator values_begin(const key_type &key) const {
+    return m_partitions[partition_index(key)].at(key).begin();
+  }
+
+  /// \brief Returns an iterator to the end of the values of a key.
+  /// 'key' must exist.
+  const_value_iterator values_end(const key_type &key) const {
+    return m_partitions[partition_index(key)].at(key).end();
+  }
+
+  /// \brief Returns an iterator to the first pair of a key and its values.
+  const_key_iterator keys_begin() const {
+    return const_key_iterator(m_partitions.begin(), m_partitions.end());
+  }
+
+  /// \brief Returns an iterator to the end of the pairs of the keys and
+  /// values.
+  const_key_iterator keys_end() const {
+    return const_key_iterator(m_partitions.end(), m_partitions.end());
+  }
+
+  /// \brief Returns an iterator to the first key in a partition.
+  /// Each partition can be visited by a different thread.
+  const_local_key_iterator keys_begin(const size_type partition_no) const {
+    assert(partition_no < num_partitions());
+    return m_partitions[partition_no].begin();
+  }
+
+  /// \brief Returns an iterator to the end of the keys in a partition.
+  const_local_key_iterator keys_end(const size_type partition_no) const {
+    assert(partition_no < num_partitions());
+    return m_partitions[partition_no].end();
+  }
+
+  /// \brief Returns the number of partitions.
+  size_type num_partitions() const { return m_partitions.size(); }
+
+  /// \brief Returns the partition number of a key.
+  size_type partition_index(const key_type &key) const {
+    return mdtl::hash<k_partition_hash_seed>{}(key) % num_partitions();
+  }
+
+  /// \brief Returns the NUMA node that a partition is assigned to when edges
+  /// are added with 'numa_local' enabled.
+  static int numa_node_of(const size_type partition_no) {
+    const auto &nodes = mdtl::numa::allowed_nodes();
+    return nodes[partition_no % nodes.size()];
+  }
+
+  /// \brief Removes all edges.
+  /// This function is not thread-safe.
+  void clear() {
+    for (auto &partition : m_partitions) partition.clear();
+    m_num_edges = 0;
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return m_partitions.get_allocator(); }
+
+ private:
+  static auto priv_lock(const size_type partition_no) {
+    return metall::utility::mutex::mutex_lock<k_num_locks>(partition_no %
+                                                           k_num_locks);
+  }
+
+  template <typename function_type>
+  void priv_parallel_for_partitions(int num_threads, const bool numa_local,
+                                    function_type &&func) {
+    if (num_threads <= 0) {
+      num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    const auto &nodes = mdtl::numa::allowed_nodes();
+    const size_type num_nodes = numa_local ? nodes.size() : 1;
+    // Every node needs at least one thread
+    num_threads = std::max(num_threads, (int)num_nodes);
+    num_threads =
+        std::min(num_threads, (int)std::max(num_nodes, num_partitions()));
+
+    // Thread 't' processes the partitions of node 't % num_nodes'
+    const auto process = [this, &func, &nodes, num_nodes, num_threads,
+                          numa_local](const size_type thread_no) {
+      const size_type node_no = thread_no % num_nodes;
+      const size_type num_local_threads =
+          (num_threads - node_no + num_nodes - 1) / num_nodes;
+      if (numa_local) mdtl::numa::prefer_node_for_thread(nodes[node_no]);
+      for (size_type p = node_no + (thread_no / num_nodes) * num_nodes;
+           p < num_partitions(); p += num_local_threads * num_nodes) {
+        func(p);
+      }
+      if (numa_local) mdtl::numa::prefer_node_for_thread(-1);
+    };
+    if (num_threads == 1) {
+      process(0);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) threads.emplace_back(process, t);
+    for (auto &th : threads) th.join();
+  }
+
+  partition_table_type m_partitions;
+  size_type m_num_edges;
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_CONCURRENT_ADJACENCY_LIST_HPP
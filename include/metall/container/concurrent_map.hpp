@@ -6,11 +6,17 @@
 #ifndef METALL_CONTAINER_CONCURRENT_MAP_HPP
 #define METALL_CONTAINER_CONCURRENT_MAP_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <boost/container/vector.hpp>
 #include <boost/container/map.hpp>
 #include <boost/container/scoped_allocator.hpp>
+#include <metall/container/bulk_insert.hpp>
 #include <metall/utility/mutex.hpp>
 #include <metall/utility/container_of_containers_iterator_adaptor.hpp>
 
@@ -26,12 +32,15 @@ namespace metall::container {
 /// mapped type. \tparam _compare A key compare. \tparam _bank_no_hasher A key
 /// hasher. \tparam _allocator An allocator. \tparam k_num_banks The number of
 /// banks to be allocated.
+/// \tparam _mutex_type The type of the bank mutexes, e.g.,
+/// metall::utility::mutex::spin_mutex for short critical sections. If it is
+/// a shared mutex, e.g., std::shared_mutex, visit() takes shared locks.
 template <typename _key_type, typename _mapped_type,
           typename _compare = std::less<_key_type>,
           typename _bank_no_hasher = std::hash<_key_type>,
           typename _allocator =
               std::allocator<std::pair<const _key_type, _mapped_type>>,
-          int k_num_banks = 1024>
+          int k_num_banks = 1024, typename _mutex_type = std::mutex>
 class concurrent_map {
  private:
   template <typename T>
@@ -59,6 +68,8 @@ class concurrent_map {
   using size_type = typename internal_map_type::size_type;
   /// \brief An allocator type.
   using allocator_type = _allocator;
+  /// \brief The type of the bank mutexes.
+  using mutex_type = _mutex_type;
 
   /// \brief A const iterator type.
   using const_iterator =
@@ -86,7 +97,9 @@ class concurrent_map {
 
   /// \brief Returns the number of elements in the container.
   /// \return The number of elements in the container.
-  size_type size() const { return m_num_items; }
+  size_type size() const {
+    return __atomic_load_n(&m_num_items, __ATOMIC_RELAXED);
+  }
 
   // ---------- Modifier ---------- //
   /// \brief Inserts element into the container
@@ -95,25 +108,167 @@ class concurrent_map {
   /// whether the insertion took place.
   bool insert(value_type &&value) {
     const auto bank_no = calc_bank_no(value.first);
-    auto lock = metall::utility::mutex::mutex_lock<k_num_banks>(bank_no);
+    auto lock = priv_lock(bank_no);
     const bool ret =
         m_banked_map[bank_no].insert(std::forward<value_type>(value)).second;
-    m_num_items += (ret) ? 1 : 0;
+    if (ret) priv_add_num_items(1);
+    return ret;
+  }
+
+  /// \brief Inserts an element constructed in-place if the container doesn't
+  /// already contain an element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param args Arguments to construct the mapped value.
+  /// \return A bool denoting whether the insertion took place.
+  template <typename... args_type>
+  bool emplace(const key_type &key, args_type &&...args) {
+    const auto bank_no = calc_bank_no(key);
+    auto lock = priv_lock(bank_no);
+    const bool ret =
+        m_banked_map[bank_no]
+            .try_emplace(key, std::forward<args_type>(args)...)
+            .second;
+    if (ret) priv_add_num_items(1);
+    return ret;
+  }
+
+  /// \brief Inserts an element or assigns a value to the existing element.
+  /// \param key A key of the element.
+  /// \param mapped A value to insert or assign.
+  /// \return True if the insertion took place; false if the assignment took
+  /// place.
+  template <typename mapped_arg_type>
+  bool insert_or_assign(const key_type &key, mapped_arg_type &&mapped) {
+    const auto bank_no = calc_bank_no(key);
+    auto lock = priv_lock(bank_no);
+    const bool ret = m_banked_map[bank_no]
+                         .insert_or_assign(
+                             key, std::forward<mapped_arg_type>(mapped))
+                         .second;
+    if (ret) priv_add_num_items(1);
     return ret;
   }
 
+  /// \brief Removes the element with an equivalent key.
+  /// \param key A key of the element to remove.
+  /// \return The number of elements removed (0 or 1).
+  size_type erase(const key_type &key) {
+    const auto bank_no = calc_bank_no(key);
+    auto lock = priv_lock(bank_no);
+    const auto num_erased = m_banked_map[bank_no].erase(key);
+    if (num_erased > 0) priv_add_num_items(-1);
+    return num_erased;
+  }
+
+  /// \brief Updates an existing element exclusively, e.g., for a
+  /// read-modify-write operation.
+  /// Unlike edit(), this function does not create a new element.
+  /// 'updater' must not access this container.
+  /// \param key A key of the element to update.
+  /// \param updater A function object which takes 'mapped_type &'.
+  /// \return True if the element was found.
+  template <typename updater_type>
+  bool update(const key_type &key, updater_type &&updater) {
+    const auto bank_no = calc_bank_no(key);
+    auto lock = priv_lock(bank_no);
+    auto itr = m_banked_map[bank_no].find(key);
+    if (itr == m_banked_map[bank_no].end()) return false;
+    updater(itr->second);
+    return true;
+  }
+
+  /// \brief Calls a function with an element exclusively, or with other
+  /// visitors if the mutex type is a shared mutex.
+  /// 'visitor' must not access this container.
+  /// \param key A key of the element to visit.
+  /// \param visitor A function object which takes 'const mapped_type &'.
+  /// \return True if the element was found.
+  template <typename visitor_type>
+  bool visit(const key_type &key, visitor_type &&visitor) const {
+    const auto bank_no = calc_bank_no(key);
+    auto lock = priv_shared_lock(bank_no);
+    const auto itr = m_banked_map[bank_no].find(key);
+    if (itr == m_banked_map[bank_no].end()) return false;
+    visitor(std::as_const(itr->second));
+    return true;
+  }
+
+  /// \brief Calls a function with every element, locking one bank at a time.
+  /// The banks are processed by multiple threads in parallel; thus, 'func'
+  /// must be thread-safe. 'func' must not access this container.
+  /// \param func A function object which takes 'const key_type &' and
+  /// 'mapped_type &'.
+  /// \param num_threads The number of threads to use. If <= 0 is given, the
+  /// number of the hardware threads is used.
+  template <typename function_type>
+  void for_each(function_type &&func, int num_threads = 1) {
+    priv_parallel_for_banks(num_threads, [this, &func](const int bank_no) {
+      auto lock = priv_lock(bank_no);
+      for (auto &item : m_banked_map[bank_no]) {
+        func(std::as_const(item.first), item.second);
+      }
+    });
+  }
+
+  /// \brief Inserts elements in bulk, e.g., to load a large data set.
+  /// The elements are distributed to the banks in a buffer in the process
+  /// memory first. Then, the banks are sorted and filled by multiple threads
+  /// in parallel; each bank is filled in linear time.
+  /// If the input contains duplicate keys, only the first one is inserted.
+  /// \param first The beginning of the elements to insert.
+  /// \param last The end of the elements to insert.
+  /// \param num_threads The number of threads to use. If <= 0 is given, the
+  /// number of the hardware threads is used.
+  /// \return The number of elements inserted.
+  template <typename input_iterator>
+  size_type bulk_insert(input_iterator first, input_iterator last,
+                        int num_threads = 0) {
+    std::vector<std::vector<std::pair<key_type, mapped_type>>> buf(
+        k_num_banks);
+    for (; first != last; ++first) {
+      buf[calc_bank_no(first->first)].emplace_back(*first);
+    }
+
+    std::atomic<size_type> num_inserted{0};
+    priv_parallel_for_banks(num_threads, [this, &buf,
+                                          &num_inserted](const int bank_no) {
+      auto &bank_buf = buf[bank_no];
+      const auto comp = m_banked_map[bank_no].key_comp();
+      std::stable_sort(bank_buf.begin(), bank_buf.end(),
+                       [&comp](const auto &lhs, const auto &rhs) {
+                         return comp(lhs.first, rhs.first);
+                       });
+      bank_buf.erase(std::unique(bank_buf.begin(), bank_buf.end(),
+                                 [&comp](const auto &lhs, const auto &rhs) {
+                                   return !comp(lhs.first, rhs.first) &&
+                                          !comp(rhs.first, lhs.first);
+                                 }),
+                     bank_buf.end());
+
+      auto lock = priv_lock(bank_no);
+      const auto n = metall::container::bulk_insert(
+          m_banked_map[bank_no], ordered_unique_range,
+          std::make_move_iterator(bank_buf.begin()),
+          std::make_move_iterator(bank_buf.end()));
+      priv_add_num_items(n);
+      num_inserted += n;
+      std::vector<std::pair<key_type, mapped_type>>().swap(bank_buf);
+    });
+    return num_inserted.load();
+  }
+
   /// \brief Provides a way to edit an element exclusively.
   /// If no element exists with an equivalent key, this container creates a new
   /// element with key. \param key A key of the element to edit. \return A pair
   /// of a reference to the element and a mutex ownership wrapper.
-  std::pair<mapped_type &, std::unique_lock<std::mutex>> scoped_edit(
+  std::pair<mapped_type &, std::unique_lock<mutex_type>> scoped_edit(
       const key_type &key) {
     const auto bank_no = calc_bank_no(key);
-    auto lock = metall::utility::mutex::mutex_lock<k_num_banks>(bank_no);
+    auto lock = priv_lock(bank_no);
     if (!count(key)) {
       [[maybe_unused]] const bool ret = register_key_no_lock(key);
       assert(ret);
-      ++m_num_items;
+      priv_add_num_items(1);
     }
     return std::make_pair(std::ref(m_banked_map[bank_no].at(key)),
                           std::move(lock));
@@ -126,11 +281,11 @@ class concurrent_map {
   void edit(const key_type &key,
             const std::function<void(mapped_type &mapped_value)> &editor) {
     const auto bank_no = calc_bank_no(key);
-    auto lock = metall::utility::mutex::mutex_lock<k_num_banks>(bank_no);
+    auto lock = priv_lock(bank_no);
     if (!count(key)) {
       [[maybe_unused]] const bool ret = register_key_no_lock(key);
       assert(ret);
-      ++m_num_items;
+      priv_add_num_items(1);
     }
     editor(m_banked_map[bank_no].at(key));
   }
@@ -177,6 +332,52 @@ class concurrent_map {
     return _bank_no_hasher()(key) % k_num_banks;
   }
 
+  static std::unique_lock<mutex_type> priv_lock(const uint64_t bank_no) {
+    return metall::utility::mutex::mutex_lock<k_num_banks, mutex_type>(
+        bank_no);
+  }
+
+  /// \brief Locks a bank in the shared mode if the mutex type supports it;
+  /// otherwise, exclusively.
+  static auto priv_shared_lock(const uint64_t bank_no) {
+    if constexpr (metall::utility::mutex::is_shared_lockable_v<mutex_type>) {
+      return metall::utility::mutex::shared_mutex_lock<k_num_banks,
+                                                       mutex_type>(bank_no);
+    } else {
+      return priv_lock(bank_no);
+    }
+  }
+
+  /// \brief Calls 'func' with each bank number using multiple threads.
+  template <typename function_type>
+  void priv_parallel_for_banks(int num_threads, function_type &&func) {
+    if (num_threads <= 0) {
+      num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, k_num_banks);
+
+    const auto process = [&func](const int first_bank_no, const int step) {
+      for (int bank_no = first_bank_no; bank_no < k_num_banks;
+           bank_no += step) {
+        func(bank_no);
+      }
+    };
+    if (num_threads == 1) {
+      process(0, 1);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back(process, t, num_threads);
+    }
+    for (auto &th : threads) th.join();
+  }
+
+  // The number of items is updated by multiple banks at the same time
+  void priv_add_num_items(const std::ptrdiff_t n) {
+    __atomic_fetch_add(&m_num_items, n, __ATOMIC_RELAXED);
+  }
+
   bool register_key_no_lock(const key_type &key) {
     const auto bank_no = calc_bank_no(key);
     return m_banked_map[bank_no].try_emplace(key).second;
@@ -0,0 +1,669 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_CONCURRENT_SKIP_LIST_MAP_HPP
+#define METALL_CONTAINER_CONCURRENT_SKIP_LIST_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/atomic_relative_ptr.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/epoch_reclaimer.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A concurrent ordered map which can be stored in persistent memory.
+/// The map is a lazy skip list (Herlihy et al., 2007): a lookup and a scan
+/// take no lock but the one of the element visited, and an insertion or a
+/// removal locks only the nodes next to the element; thus, operations on
+/// different parts of the map do not block each other.
+/// The links are relative offsets like offset_ptr's, and the nodes are
+/// allocated by the allocator given.
+/// A removed node is freed once no operation that may still read it is
+/// running (epoch-based reclamation), i.e., by a later erase(), clear(), or
+/// the destructor.
+/// Like concurrent_unordered_map, the locks and the epoch counters are kept
+/// in the container; a data store must not be closed while an operation is
+/// running.
+/// Elements are accessed through functions rather than iterators, which
+/// could point to a removed element.
+/// \tparam _key_type A key type.
+/// \tparam _mapped_type A mapped type.
+/// \tparam _compare A function that compares two keys.
+/// \tparam _allocator An allocator.
+template <typename _key_type, typename _mapped_type,
+          typename _compare = std::less<_key_type>,
+          typename _allocator =
+              std::allocator<std::pair<const _key_type, _mapped_type>>>
+class concurrent_skip_list_map {
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  /// \brief A key type.
+  using key_type = _key_type;
+  /// \brief A mapped type.
+  using mapped_type = _mapped_type;
+  /// \brief A value type (i.e., std::pair<const key_type, mapped_type>).
+  using value_type = std::pair<const key_type, mapped_type>;
+  /// \brief A unsigned integer type (usually std::size_t).
+  using size_type = std::size_t;
+  /// \brief A key comparison function type.
+  using key_compare = _compare;
+  /// \brief An allocator type.
+  using allocator_type = _allocator;
+
+ private:
+  template <typename T>
+  using other_allocator_type =
+      typename std::allocator_traits<_allocator>::template rebind_alloc<T>;
+
+  using value_allocator_type = other_allocator_type<value_type>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+
+  // The height of the head; each level is kept with the probability of 1/2
+  static constexpr int k_max_height = 32;
+  static constexpr uint8_t k_fully_linked = 1;
+  static constexpr uint8_t k_marked = 2;
+  static constexpr int k_num_spins = 64;
+
+  struct node_type;
+  using link_type = mdtl::atomic_relative_ptr<node_type>;
+
+  /// A node is followed by its element and its links, one per level.
+  struct node_type {
+    std::atomic<uint32_t> lock{0};
+    std::atomic<uint8_t> flags{0};
+    uint8_t height{0};
+    // The next node in a list of the removed nodes
+    link_type retired_next;
+  };
+
+  static constexpr std::size_t k_node_alignment =
+      std::max({alignof(node_type), alignof(value_type), alignof(link_type)});
+  struct alignas(k_node_alignment) node_unit {
+    unsigned char bytes[k_node_alignment];
+  };
+  using unit_allocator_type = other_allocator_type<node_unit>;
+  using unit_allocator_traits = std::allocator_traits<unit_allocator_type>;
+  using unit_pointer = typename unit_allocator_traits::pointer;
+
+  static constexpr std::size_t priv_round_up(const std::size_t n,
+                                             const std::size_t unit) {
+    return (n + unit - 1) / unit * unit;
+  }
+  static constexpr std::size_t k_value_offset =
+      priv_round_up(sizeof(node_type), alignof(value_type));
+  static constexpr std::size_t k_links_offset =
+      priv_round_up(k_value_offset + sizeof(value_type), alignof(link_type));
+
+  class node_lock_guard {
+   public:
+    explicit node_lock_guard(node_type *const node) noexcept : m_node(node) {
+      priv_lock(m_node);
+    }
+    ~node_lock_guard() noexcept { priv_unlock(m_node); }
+    node_lock_guard(const node_lock_guard &) = delete;
+    node_lock_guard &operator=(const node_lock_guard &) = delete;
+
+   private:
+    node_type *m_node;
+  };
+
+  using reclaimer_type = mdtl::epoch_reclaimer<node_type>;
+  using epoch_guard = typename reclaimer_type::guard;
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit concurrent_skip_list_map(
+      const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {
+    m_head = priv_allocate_node(k_max_height);
+  }
+
+  /// \brief Destructor. Must not be called concurrently with others.
+  ~concurrent_skip_list_map() noexcept { priv_destroy(); }
+
+  concurrent_skip_list_map(const concurrent_skip_list_map &) = delete;
+  concurrent_skip_list_map &operator=(const concurrent_skip_list_map &) =
+      delete;
+
+  /// \brief Move constructor. Must not be called concurrently with others.
+  concurrent_skip_list_map(concurrent_skip_list_map &&other) noexcept
+      : m_allocator(other.m_allocator),
+        m_head(std::exchange(other.m_head, nullptr)),
+        m_compare(std::move(other.m_compare)),
+        m_size(other.m_size.exchange(0)) {
+    m_reclaimer.take(other.m_reclaimer);
+  }
+
+  /// \brief Move assignment operator.
+  /// Must not be called concurrently with others.
+  concurrent_skip_list_map &operator=(
+      concurrent_skip_list_map &&other) noexcept {
+    if (this != &other) {
+      priv_destroy();
+      m_allocator = other.m_allocator;
+      m_head = std::exchange(other.m_head, nullptr);
+      m_compare = std::move(other.m_compare);
+      m_size = other.m_size.exchange(0);
+      m_reclaimer.take(other.m_reclaimer);
+    }
+    return *this;
+  }
+
+  // -------------------- //
+  // Public methods
+  // -------------------- //
+  // ---------- Capacity ---------- //
+  /// \brief Returns the number of elements in the container.
+  /// The value can be stale if other threads modify the container.
+  size_type size() const { return m_size.load(std::memory_order_relaxed); }
+
+  /// \brief Returns true if the container has no element.
+  bool empty() const { return size() == 0; }
+
+  // ---------- Modifier ---------- //
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  /// \brief Inserts an element constructed in-place with 'args' if the
+  /// container does not already contain an element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param args Arguments to construct the mapped value.
+  /// \return Returns true if the element was inserted.
+  template <typename... args_type>
+  bool try_emplace(const key_type &key, args_type &&...args) {
+    epoch_guard guard(m_reclaimer);
+    return priv_emplace(key, std::forward<args_type>(args)...).second;
+  }
+
+  /// \brief Inserts an element or assigns a value to the existing element.
+  /// \param key A key of the element.
+  /// \param mapped A value to insert or assign.
+  /// \return Returns true if the element was inserted, false if assigned.
+  template <typename mapped_arg_type>
+  bool insert_or_assign(const key_type &key, mapped_arg_type &&mapped) {
+    epoch_guard guard(m_reclaimer);
+    while (true) {
+      const auto [node, inserted] = priv_emplace(key, mapped);
+      if (inserted) return true;
+      node_lock_guard lock(node);
+      // The element could have been removed since it was found
+      if (priv_has_flag(node, k_marked)) continue;
+      priv_value(node)->second = std::forward<mapped_arg_type>(mapped);
+      return false;
+    }
+  }
+
+  /// \brief Edits an element exclusively.
+  /// If no element exists with an equivalent key, a new element with a
+  /// default-constructed mapped value is inserted first.
+  /// 'editor' must not access this container.
+  /// \param key A key of the element to edit.
+  /// \param editor A function object that takes 'mapped_type &'.
+  template <typename editor_type>
+  void edit(const key_type &key, editor_type &&editor) {
+    epoch_guard guard(m_reclaimer);
+    while (true) {
+      auto *const node = priv_emplace(key).first;
+      node_lock_guard lock(node);
+      if (priv_has_flag(node, k_marked)) continue;
+      editor(priv_value(node)->second);
+      return;
+    }
+  }
+
+  /// \brief Edits an existing element exclusively.
+  /// 'editor' must not access this container.
+  /// \param key A key of the element to edit.
+  /// \param editor A function object that takes 'mapped_type &'.
+  /// \return Returns true if an element was found.
+  template <typename editor_type>
+  bool update(const key_type &key, editor_type &&editor) {
+    epoch_guard guard(m_reclaimer);
+    auto *const node = priv_find_node(key);
+    if (!node) return false;
+    node_lock_guard lock(node);
+    if (priv_has_flag(node, k_marked)) return false;
+    editor(priv_value(node)->second);
+    return true;
+  }
+
+  /// \brief Removes the element with an equivalent key.
+  /// \param key A key of the element to remove.
+  /// \return The number of removed elements (0 or 1).
+  size_type erase(const key_type &key) {
+    {
+      epoch_guard guard(m_reclaimer);
+      if (!priv_erase(key)) return 0;
+    }
+    // Frees the nodes removed earlier if no operation can read them
+    priv_try_reclaim();
+    return 1;
+  }
+
+  /// \brief Removes all elements.
+  /// Must not be called concurrently with others.
+  void clear() {
+    auto *const head = priv_head();
+    for (auto *node = priv_links(head)[0].load(); node;) {
+      auto *const next = priv_links(node)[0].load();
+      priv_deallocate_node(node, true);
+      node = next;
+    }
+    for (int l = 0; l < k_max_height; ++l) priv_links(head)[l].store(nullptr);
+    m_reclaimer.free_all(
+        [this](node_type *const node) { priv_deallocate_node(node, true); });
+    m_size = 0;
+  }
+
+  // ---------- Look up ---------- //
+  /// \brief Returns the number of elements with an equivalent key.
+  /// \param key A key of the elements to count.
+  /// \return Either 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with an equivalent key.
+  bool contains(const key_type &key) const {
+    epoch_guard guard(m_reclaimer);
+    return priv_find_node(key) != nullptr;
+  }
+
+  /// \brief Copies the mapped value of the element with an equivalent key.
+  /// \param key A key of the element to find.
+  /// \param mapped A pointer to store the mapped value.
+  /// \return Returns true if an element was found.
+  bool find(const key_type &key, mapped_type *const mapped) const {
+    return visit(key, [mapped](const mapped_type &value) { *mapped = value; });
+  }
+
+  /// \brief Calls a function with the element with an equivalent key while
+  /// holding the lock of the element.
+  /// 'visitor' must not access this container.
+  /// \param key A key of the element to find.
+  /// \param visitor A function object that takes 'const mapped_type &'.
+  /// \return Returns true if an element was found.
+  template <typename visitor_type>
+  bool visit(const key_type &key, visitor_type &&visitor) const {
+    epoch_guard guard(m_reclaimer);
+    auto *const node = priv_find_node(key);
+    if (!node) return false;
+    node_lock_guard lock(node);
+    if (priv_has_flag(node, k_marked)) return false;
+    visitor(std::as_const(priv_value(node)->second));
+    return true;
+  }
+
+  /// \brief Calls a function with every element in the key order, holding
+  /// the lock of one element at a time.
+  /// Elements inserted or removed during the call may or may not be visited;
+  /// the others are visited once.
+  /// 'func' must not access this container.
+  /// \param func A function object that takes 'const value_type &'.
+  template <typename function_type>
+  void for_each(function_type &&func) const {
+    epoch_guard guard(m_reclaimer);
+    priv_scan(priv_links(priv_head())[0].load(), nullptr, func);
+  }
+
+  /// \brief Calls a function with every element whose key is in
+  /// [first, last) in the key order, e.g., the events in a time range.
+  /// Elements inserted or removed during the call may or may not be visited;
+  /// the others are visited once.
+  /// 'func' must not access this container.
+  /// \param first The first key of the range.
+  /// \param last The key after the range.
+  /// \param func A function object that takes 'const value_type &'.
+  template <typename function_type>
+  void for_each(const key_type &first, const key_type &last,
+                function_type &&func) const {
+    epoch_guard guard(m_reclaimer);
+    priv_scan(priv_lower_bound(first), &last, func);
+  }
+
+  // ---------- Allocator ---------- //
+  /// \brief Returns the allocator associated with the container.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  // ---------- Nodes ---------- //
+  static constexpr std::size_t priv_num_units(const int height) {
+    return (k_links_offset + height * sizeof(link_type) + sizeof(node_unit) -
+            1) /
+           sizeof(node_unit);
+  }
+
+  static value_type *priv_value(node_type *const node) noexcept {
+    return std::launder(reinterpret_cast<value_type *>(
+        reinterpret_cast<unsigned char *>(node) + k_value_offset));
+  }
+
+  static const key_type &priv_key(node_type *const node) noexcept {
+    return priv_value(node)->first;
+  }
+
+  static link_type *priv_links(node_type *const node) noexcept {
+    return std::launder(reinterpret_cast<link_type *>(
+        reinterpret_cast<unsigned char *>(node) + k_links_offset));
+  }
+
+  static bool priv_has_flag(node_type *const node, const uint8_t flag) {
+    return node->flags.load(std::memory_order_acquire) & flag;
+  }
+
+  static void priv_lock(node_type *const node) noexcept {
+    while (true) {
+      if (node->lock.exchange(1, std::memory_order_acquire) == 0) return;
+      for (int i = 0; node->lock.load(std::memory_order_relaxed) != 0; ++i) {
+        if (i >= k_num_spins) std::this_thread::yield();
+      }
+    }
+  }
+
+  static void priv_unlock(node_type *const node) noexcept {
+    node->lock.store(0, std::memory_order_release);
+  }
+
+  node_type *priv_head() const { return priv_to_node(m_head); }
+
+  static node_type *priv_to_node(const unit_pointer &units) noexcept {
+    return reinterpret_cast<node_type *>(metall::to_raw_pointer(units));
+  }
+
+  /// \brief Allocates a node without the element.
+  unit_pointer priv_allocate_node(const int height) {
+    unit_allocator_type alloc(m_allocator);
+    auto units = unit_allocator_traits::allocate(alloc, priv_num_units(height));
+    auto *const node = new (metall::to_raw_pointer(units)) node_type();
+    node->height = height;
+    for (int l = 0; l < height; ++l) new (&priv_links(node)[l]) link_type();
+    return units;
+  }
+
+  template <typename... args_type>
+  node_type *priv_new_node(const key_type &key, args_type &&...args) {
+    auto units = priv_allocate_node(priv_random_height());
+    auto *const node = priv_to_node(units);
+    try {
+      value_allocator_type alloc(m_allocator);
+      value_allocator_traits::construct(
+          alloc, priv_value(node), std::piecewise_construct,
+          std::forward_as_tuple(key),
+          std::forward_as_tuple(std::forward<args_type>(args)...));
+    } catch (...) {
+      priv_deallocate_node(node, false);
+      throw;
+    }
+    return node;
+  }
+
+  void priv_deallocate_node(node_type *const node,
+                            const bool has_value) noexcept {
+    if (has_value) {
+      value_allocator_type alloc(m_allocator);
+      value_allocator_traits::destroy(alloc, priv_value(node));
+    }
+    const auto num_units = priv_num_units(node->height);
+    node->~node_type();
+    unit_allocator_type alloc(m_allocator);
+    unit_allocator_traits::deallocate(
+        alloc,
+        std::pointer_traits<unit_pointer>::pointer_to(
+            *reinterpret_cast<node_unit *>(node)),
+        num_units);
+  }
+
+  static int priv_random_height() noexcept {
+    thread_local uint64_t state =
+        priv_mix(std::hash<std::thread::id>{}(std::this_thread::get_id()) +
+                 0x9e3779b97f4a7c15ULL);
+    // xorshift64
+    state ^= state << 13ULL;
+    state ^= state >> 7ULL;
+    state ^= state << 17ULL;
+    return 1 + mdtl::ctzll(state | (1ULL << (k_max_height - 1)));
+  }
+
+  static uint64_t priv_mix(uint64_t hash) noexcept {
+    // The finalizer of MurmurHash3
+    hash ^= hash >> 33ULL;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33ULL;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33ULL;
+    return hash | 1ULL;  // Must not be 0
+  }
+
+  // ---------- Skip list ---------- //
+  bool priv_equal(const key_type &lhs, const key_type &rhs) const {
+    return !m_compare(lhs, rhs) && !m_compare(rhs, lhs);
+  }
+
+  /// \brief Finds the nodes before and at or after 'key' at each level.
+  /// \return The highest level the key was found at, or -1.
+  int priv_find(const key_type &key, node_type **const preds,
+                node_type **const succs) const {
+    int found = -1;
+    auto *pred = priv_head();
+    for (int l = k_max_height - 1; l >= 0; --l) {
+      auto *curr = priv_links(pred)[l].load();
+      while (curr && m_compare(priv_key(curr), key)) {
+        pred = curr;
+        curr = priv_links(pred)[l].load();
+      }
+      if (found == -1 && curr && !m_compare(key, priv_key(curr))) found = l;
+      preds[l] = pred;
+      succs[l] = curr;
+    }
+    return found;
+  }
+
+  /// \brief Returns the node of an element or nullptr, without locking.
+  node_type *priv_find_node(const key_type &key) const {
+    auto *pred = priv_head();
+    for (int l = k_max_height - 1; l >= 0; --l) {
+      auto *curr = priv_links(pred)[l].load();
+      while (curr && m_compare(priv_key(curr), key)) {
+        pred = curr;
+        curr = priv_links(pred)[l].load();
+      }
+      if (curr && !m_compare(key, priv_key(curr))) {
+        return (priv_has_flag(curr, k_fully_linked) &&
+                !priv_has_flag(curr, k_marked))
+                   ? curr
+                   : nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  /// \brief Returns the first node whose key is not less than 'key'.
+  node_type *priv_lower_bound(const key_type &key) const {
+    auto *pred = priv_head();
+    for (int l = k_max_height - 1; l >= 0; --l) {
+      auto *curr = priv_links(pred)[l].load();
+      while (curr && m_compare(priv_key(curr), key)) {
+        pred = curr;
+        curr = priv_links(pred)[l].load();
+      }
+    }
+    return priv_links(pred)[0].load();
+  }
+
+  template <typename function_type>
+  void priv_scan(node_type *node, const key_type *const last,
+                 function_type &func) const {
+    // A removed node still links to the node after it when it was removed
+    for (; node && (!last || m_compare(priv_key(node), *last));
+         node = priv_links(node)[0].load()) {
+      if (!priv_has_flag(node, k_fully_linked)) continue;
+      node_lock_guard lock(node);
+      if (priv_has_flag(node, k_marked)) continue;
+      func(std::as_const(*priv_value(node)));
+    }
+  }
+
+  /// \brief Unlocks the nodes locked at the levels [0, highest_level].
+  static void priv_unlock_preds(node_type *const *const preds,
+                                const int highest_level) noexcept {
+    for (int l = 0; l <= highest_level; ++l) {
+      // A node before the key at several levels is locked once
+      if (l == 0 || preds[l] != preds[l - 1]) priv_unlock(preds[l]);
+    }
+  }
+
+  /// \brief Inserts an element unless there is one with an equivalent key.
+  /// \return The node of the inserted or existing element, and true if
+  /// inserted.
+  template <typename... args_type>
+  std::pair<node_type *, bool> priv_emplace(const key_type &key,
+                                            args_type &&...args) {
+    node_type *preds[k_max_height];
+    node_type *succs[k_max_height];
+    node_type *new_node = nullptr;
+    while (true) {
+      const int found = priv_find(key, preds, succs);
+      if (found != -1) {
+        auto *const node = succs[found];
+        if (priv_has_flag(node, k_marked)) continue;  // Being removed
+        // Waits for the inserting thread to link the node at every level
+        while (!priv_has_flag(node, k_fully_linked)) std::this_thread::yield();
+        if (new_node) priv_deallocate_node(new_node, true);
+        return {node, false};
+      }
+
+      if (!new_node) {
+        new_node = priv_new_node(key, std::forward<args_type>(args)...);
+      }
+      const int height = new_node->height;
+      int highest_locked = -1;
+      bool valid = true;
+      for (int l = 0; valid && l < height; ++l) {
+        auto *const pred = preds[l];
+        auto *const succ = succs[l];
+        if (l == 0 || pred != preds[l - 1]) priv_lock(pred);
+        highest_locked = l;
+        valid = !priv_has_flag(pred, k_marked) &&
+                (!succ || !priv_has_flag(succ, k_marked)) &&
+                priv_links(pred)[l].load() == succ;
+      }
+      if (valid) {
+        for (int l = 0; l < height; ++l) {
+          priv_links(new_node)[l].store(succs[l], std::memory_order_relaxed);
+        }
+        for (int l = 0; l < height; ++l) {
+          priv_links(preds[l])[l].store(new_node);
+        }
+        new_node->flags.fetch_or(k_fully_linked, std::memory_order_release);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+      }
+      priv_unlock_preds(preds, highest_locked);
+      if (valid) return {new_node, true};
+    }
+  }
+
+  /// \brief Removes an element. Must be called in an epoch.
+  bool priv_erase(const key_type &key) {
+    node_type *preds[k_max_height];
+    node_type *succs[k_max_height];
+    node_type *victim = nullptr;
+    while (true) {
+      const int found = priv_find(key, preds, succs);
+      if (!victim) {
+        if (found == -1) return false;
+        auto *const node = succs[found];
+        // A node being inserted is not in the map yet
+        if (!priv_has_flag(node, k_fully_linked) ||
+            node->height - 1 != found || priv_has_flag(node, k_marked)) {
+          return false;
+        }
+        priv_lock(node);
+        if (priv_has_flag(node, k_marked)) {
+          priv_unlock(node);
+          return false;  // Removed by another thread
+        }
+        node->flags.fetch_or(k_marked, std::memory_order_release);
+        victim = node;
+      }
+
+      const int height = victim->height;
+      int highest_locked = -1;
+      bool valid = true;
+      for (int l = 0; valid && l < height; ++l) {
+        auto *const pred = preds[l];
+        if (l == 0 || pred != preds[l - 1]) priv_lock(pred);
+        highest_locked = l;
+        valid = !priv_has_flag(pred, k_marked) &&
+                priv_links(pred)[l].load() == victim;
+      }
+      if (valid) {
+        for (int l = height - 1; l >= 0; --l) {
+          priv_links(preds[l])[l].store(priv_links(victim)[l].load());
+        }
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+      }
+      priv_unlock_preds(preds, highest_locked);
+      if (valid) {
+        priv_unlock(victim);
+        m_reclaimer.retire(victim);
+        return true;
+      }
+    }
+  }
+
+  void priv_try_reclaim() noexcept {
+    m_reclaimer.try_advance(
+        [this](node_type *const node) { priv_deallocate_node(node, true); });
+  }
+
+  void priv_destroy() noexcept {
+    if (!m_head) return;
+    clear();
+    priv_deallocate_node(priv_head(), false);
+    m_head = nullptr;
+  }
+
+  allocator_type m_allocator;
+  unit_pointer m_head{nullptr};
+  key_compare m_compare{};
+  std::atomic<size_type> m_size{0};
+  reclaimer_type m_reclaimer;
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_CONCURRENT_SKIP_LIST_MAP_HPP
@@ -0,0 +1,619 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_CONCURRENT_UNORDERED_MAP_HPP
+#define METALL_CONTAINER_CONCURRENT_UNORDERED_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <metall/offset_ptr.hpp>
+
+namespace metall::container {
+
+/// \brief A concurrent hash map which can be stored in persistent memory.
+/// The map consists of a fixed number of segments; each segment is an
+/// open-addressing hash table (linear probing) with its own spin lock and
+/// grows independently. Thus, operations on keys in different segments do not
+/// block each other, and resizing a segment blocks only the operations on it.
+/// The tables hold the elements and 1-byte control words directly, i.e., no
+/// node or pointer per element is allocated.
+/// Unlike concurrent_map, the locks are kept in the container; a data store
+/// must not be closed while an operation is running.
+/// Elements are accessed through functions rather than iterators, as an
+/// element can be moved by an insertion into the same segment.
+/// \tparam _key_type A key type.
+/// \tparam _mapped_type A mapped type.
+/// \tparam _hash A hash function of the keys.
+/// \tparam _key_equal A function that compares two keys.
+/// \tparam _allocator An allocator.
+/// \tparam k_num_segments The number of segments. Must be a power of two.
+template <typename _key_type, typename _mapped_type,
+          typename _hash = std::hash<_key_type>,
+          typename _key_equal = std::equal_to<_key_type>,
+          typename _allocator =
+              std::allocator<std::pair<const _key_type, _mapped_type>>,
+          std::size_t k_num_segments = 128>
+class concurrent_unordered_map {
+  static_assert(k_num_segments > 0 &&
+                    (k_num_segments & (k_num_segments - 1)) == 0,
+                "The number of segments must be a power of two");
+
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  /// \brief A key type.
+  using key_type = _key_type;
+  /// \brief A mapped type.
+  using mapped_type = _mapped_type;
+  /// \brief A value type (i.e., std::pair<const key_type, mapped_type>).
+  using value_type = std::pair<const key_type, mapped_type>;
+  /// \brief A unsigned integer type (usually std::size_t).
+  using size_type = std::size_t;
+  /// \brief A hash function type.
+  using hasher = _hash;
+  /// \brief A key comparison function type.
+  using key_equal = _key_equal;
+  /// \brief An allocator type.
+  using allocator_type = _allocator;
+
+ private:
+  template <typename T>
+  using other_allocator_type =
+      typename std::allocator_traits<_allocator>::template rebind_alloc<T>;
+  template <typename T>
+  using other_pointer_type =
+      typename std::allocator_traits<other_allocator_type<T>>::pointer;
+
+  using value_allocator_type = other_allocator_type<value_type>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+  using control_allocator_type = other_allocator_type<uint8_t>;
+
+  // Control words
+  static constexpr uint8_t k_empty = 0;
+  static constexpr uint8_t k_deleted = 1;
+  static constexpr uint8_t k_full_flag = 0x80;
+
+  static constexpr size_type k_min_capacity = 16;
+
+  struct segment_type {
+    std::atomic<uint32_t> lock{0};
+    size_type capacity{0};
+    size_type size{0};
+    size_type num_deleted{0};
+    other_pointer_type<uint8_t> controls{nullptr};
+    other_pointer_type<value_type> slots{nullptr};
+  };
+  using segment_allocator_type = other_allocator_type<segment_type>;
+  using segment_allocator_traits =
+      std::allocator_traits<segment_allocator_type>;
+
+  class segment_lock_guard {
+   public:
+    explicit segment_lock_guard(const segment_type &segment) noexcept
+        : m_lock(const_cast<std::atomic<uint32_t> &>(segment.lock)) {
+      while (true) {
+        if (m_lock.exchange(1, std::memory_order_acquire) == 0) return;
+        for (int i = 0; m_lock.load(std::memory_order_relaxed) != 0; ++i) {
+          if (i >= k_num_spins) std::this_thread::yield();
+        }
+      }
+    }
+    ~segment_lock_guard() noexcept {
+      m_lock.store(0, std::memory_order_release);
+    }
+    segment_lock_guard(const segment_lock_guard &) = delete;
+    segment_lock_guard &operator=(const segment_lock_guard &) = delete;
+
+   private:
+    static constexpr int k_num_spins = 64;
+    std::atomic<uint32_t> &m_lock;
+  };
+
+  static constexpr size_type k_npos = std::numeric_limits<size_type>::max();
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit concurrent_unordered_map(const allocator_type &allocator =
+                                        allocator_type())
+      : m_allocator(allocator) {
+    segment_allocator_type alloc(m_allocator);
+    m_segments = segment_allocator_traits::allocate(alloc, k_num_segments);
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      segment_allocator_traits::construct(alloc, priv_segment(i));
+    }
+  }
+
+  /// \brief Destructor. Must not be called concurrently with others.
+  ~concurrent_unordered_map() noexcept { priv_destroy(); }
+
+  concurrent_unordered_map(const concurrent_unordered_map &) = delete;
+  concurrent_unordered_map &operator=(const concurrent_unordered_map &) =
+      delete;
+
+  /// \brief Move constructor. Must not be called concurrently with others.
+  concurrent_unordered_map(concurrent_unordered_map &&other) noexcept
+      : m_allocator(other.m_allocator),
+        m_segments(std::exchange(other.m_segments, nullptr)),
+        m_hasher(std::move(other.m_hasher)),
+        m_key_equal(std::move(other.m_key_equal)) {}
+
+  /// \brief Move assignment operator.
+  /// Must not be called concurrently with others.
+  concurrent_unordered_map &operator=(
+      concurrent_unordered_map &&other) noexcept {
+    if (this != &other) {
+      priv_destroy();
+      m_allocator = other.m_allocator;
+      m_segments = std::exchange(other.m_segments, nullptr);
+      m_hasher = std::move(other.m_hasher);
+      m_key_equal = std::move(other.m_key_equal);
+    }
+    return *this;
+  }
+
+  // -------------------- //
+  // Public methods
+  // -------------------- //
+  // ---------- Capacity ---------- //
+  /// \brief Returns the number of elements in the container.
+  /// The value can be stale if other threads modify the container.
+  size_type size() const {
+    size_type total = 0;
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      segment_lock_guard guard(*priv_segment(i));
+      total += priv_segment(i)->size;
+    }
+    return total;
+  }
+
+  /// \brief Returns true if the container has no element.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Reserves space for at least the specified number of elements,
+  /// assuming that the keys are distributed over the segments evenly.
+  /// \param num_elements The number of elements.
+  void reserve(const size_type num_elements) {
+    const size_type per_segment =
+        (num_elements + k_num_segments - 1) / k_num_segments;
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      auto &segment = *priv_segment(i);
+      segment_lock_guard guard(segment);
+      if (priv_capacity_for(per_segment) > segment.capacity) {
+        priv_rehash(segment, priv_capacity_for(per_segment));
+      }
+    }
+  }
+
+  // ---------- Modifier ---------- //
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  /// \brief Inserts elements in bulk using multiple threads, e.g., to load a
+  /// large data set. Reserves space for all elements first so that no
+  /// segment is rehashed during the insertion.
+  /// \param first The beginning of the elements to insert.
+  /// \param last The end of the elements to insert.
+  /// \param num_threads The number of threads to use. If 0 is given, the
+  /// number of the hardware threads is used.
+  /// \return Returns the number of elements inserted.
+  template <typename random_access_iterator>
+  size_type bulk_insert(const random_access_iterator first,
+                        const random_access_iterator last,
+                        std::size_t num_threads = 0) {
+    const auto n = (size_type)std::distance(first, last);
+    reserve(size() + n);
+
+    if (num_threads == 0) {
+      num_threads = std::max(std::size_t(1),
+                             (std::size_t)std::thread::hardware_concurrency());
+    }
+    num_threads = std::max(std::size_t(1), std::min(num_threads, n));
+    std::atomic<size_type> num_inserted{0};
+    const auto process = [&](const size_type begin, const size_type end) {
+      // Hashes a batch of keys ahead of probing
+      constexpr size_type k_batch_size = 64;
+      uint64_t hashes[k_batch_size];
+      size_type count = 0;
+      for (auto i = begin; i < end; i += k_batch_size) {
+        const auto batch_size = std::min(k_batch_size, end - i);
+        for (size_type j = 0; j < batch_size; ++j) {
+          hashes[j] = priv_hash(first[i + j].first);
+        }
+        for (size_type j = 0; j < batch_size; ++j) {
+          const auto &value = first[i + j];
+          count += priv_try_emplace(hashes[j], value.first, value.second);
+        }
+      }
+      num_inserted += count;
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < num_threads; ++t) {
+      threads.emplace_back(process, n * t / num_threads,
+                           n * (t + 1) / num_threads);
+    }
+    process(0, n / num_threads);
+    for (auto &th : threads) th.join();
+    return num_inserted.load();
+  }
+
+  /// \brief Inserts an element constructed in-place with 'args' if the
+  /// container does not already contain an element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param args Arguments to construct the mapped value.
+  /// \return Returns true if the element was inserted.
+  template <typename... args_type>
+  bool try_emplace(const key_type &key, args_type &&...args) {
+    return priv_try_emplace(priv_hash(key), key,
+                            std::forward<args_type>(args)...);
+  }
+
+  /// \brief Inserts an element or assigns a value to the existing element.
+  /// \param key A key of the element.
+  /// \param mapped A value to insert or assign.
+  /// \return Returns true if the element was inserted, false if assigned.
+  template <typename mapped_arg_type>
+  bool insert_or_assign(const key_type &key, mapped_arg_type &&mapped) {
+    const auto hash = priv_hash(key);
+    auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    const auto slot_no = priv_find_slot(segment, key, hash);
+    if (slot_no != k_npos) {
+      priv_slots(segment)[slot_no].second =
+          std::forward<mapped_arg_type>(mapped);
+      return false;
+    }
+    priv_emplace_new(segment, hash, key,
+                     std::forward<mapped_arg_type>(mapped));
+    return true;
+  }
+
+  /// \brief Edits an element exclusively.
+  /// If no element exists with an equivalent key, a new element with a
+  /// default-constructed mapped value is inserted first.
+  /// 'editor' must not access this container.
+  /// \param key A key of the element to edit.
+  /// \param editor A function object that takes 'mapped_type &'.
+  template <typename editor_type>
+  void edit(const key_type &key, editor_type &&editor) {
+    const auto hash = priv_hash(key);
+    auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    auto slot_no = priv_find_slot(segment, key, hash);
+    if (slot_no == k_npos) slot_no = priv_emplace_new(segment, hash, key);
+    editor(priv_slots(segment)[slot_no].second);
+  }
+
+  /// \brief Edits an existing element exclusively.
+  /// 'editor' must not access this container.
+  /// \param key A key of the element to edit.
+  /// \param editor A function object that takes 'mapped_type &'.
+  /// \return Returns true if an element was found.
+  template <typename editor_type>
+  bool update(const key_type &key, editor_type &&editor) {
+    const auto hash = priv_hash(key);
+    auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    const auto slot_no = priv_find_slot(segment, key, hash);
+    if (slot_no == k_npos) return false;
+    editor(priv_slots(segment)[slot_no].second);
+    return true;
+  }
+
+  /// \brief Removes the element with an equivalent key.
+  /// \param key A key of the element to remove.
+  /// \return The number of removed elements (0 or 1).
+  size_type erase(const key_type &key) {
+    const auto hash = priv_hash(key);
+    auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    const auto slot_no = priv_find_slot(segment, key, hash);
+    if (slot_no == k_npos) return 0;
+
+    value_allocator_type alloc(m_allocator);
+    value_allocator_traits::destroy(alloc, &priv_slots(segment)[slot_no]);
+    auto *const controls = priv_controls(segment);
+    // A slot followed by an empty slot ends no probe sequence
+    if (controls[(slot_no + 1) & (segment.capacity - 1)] == k_empty) {
+      controls[slot_no] = k_empty;
+    } else {
+      controls[slot_no] = k_deleted;
+      ++segment.num_deleted;
+    }
+    --segment.size;
+    return 1;
+  }
+
+  /// \brief Removes all elements. The memory of the tables is released.
+  void clear() {
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      auto &segment = *priv_segment(i);
+      segment_lock_guard guard(segment);
+      priv_release_table(segment);
+    }
+  }
+
+  // ---------- Look up ---------- //
+  /// \brief Returns the number of elements with an equivalent key.
+  /// \param key A key of the elements to count.
+  /// \return Either 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with an equivalent key.
+  bool contains(const key_type &key) const {
+    const auto hash = priv_hash(key);
+    const auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    return priv_find_slot(segment, key, hash) != k_npos;
+  }
+
+  /// \brief Copies the mapped value of the element with an equivalent key.
+  /// \param key A key of the element to find.
+  /// \param mapped A pointer to store the mapped value.
+  /// \return Returns true if an element was found.
+  bool find(const key_type &key, mapped_type *const mapped) const {
+    return visit(key, [mapped](const mapped_type &value) { *mapped = value; });
+  }
+
+  /// \brief Calls a function with the element with an equivalent key while
+  /// holding the lock of its segment.
+  /// 'visitor' must not access this container.
+  /// \param key A key of the element to find.
+  /// \param visitor A function object that takes 'const mapped_type &'.
+  /// \return Returns true if an element was found.
+  template <typename visitor_type>
+  bool visit(const key_type &key, visitor_type &&visitor) const {
+    const auto hash = priv_hash(key);
+    const auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    const auto slot_no = priv_find_slot(segment, key, hash);
+    if (slot_no == k_npos) return false;
+    visitor(std::as_const(priv_slots(segment)[slot_no].second));
+    return true;
+  }
+
+  /// \brief Calls a function with every element, holding the lock of one
+  /// segment at a time.
+  /// 'func' must not access this container.
+  /// \param func A function object that takes 'const value_type &'.
+  template <typename function_type>
+  void for_each(function_type &&func) const {
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      const auto &segment = *priv_segment(i);
+      segment_lock_guard guard(segment);
+      const auto *const controls = priv_controls(segment);
+      const auto *const slots = priv_slots(segment);
+      for (size_type s = 0; s < segment.capacity; ++s) {
+        if (controls[s] & k_full_flag) func(std::as_const(slots[s]));
+      }
+    }
+  }
+
+  // ---------- Allocator ---------- //
+  /// \brief Returns the allocator associated with the container.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  static uint64_t priv_mix(uint64_t hash) noexcept {
+    // The finalizer of MurmurHash3 spreads identity hashes, e.g., integers
+    hash ^= hash >> 33ULL;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33ULL;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33ULL;
+    return hash;
+  }
+
+  uint64_t priv_hash(const key_type &key) const {
+    return priv_mix(m_hasher(key));
+  }
+
+  template <typename... args_type>
+  bool priv_try_emplace(const uint64_t hash, const key_type &key,
+                        args_type &&...args) {
+    auto &segment = priv_segment_of(hash);
+    segment_lock_guard guard(segment);
+    if (priv_find_slot(segment, key, hash) != k_npos) return false;
+    priv_emplace_new(segment, hash, key, std::forward<args_type>(args)...);
+    return true;
+  }
+
+  static uint8_t priv_control_word(const uint64_t hash) noexcept {
+    return k_full_flag | static_cast<uint8_t>(hash >> 57ULL);
+  }
+
+  segment_type *priv_segment(const size_type i) const {
+    return metall::to_raw_pointer(m_segments) + i;
+  }
+
+  segment_type &priv_segment_of(const uint64_t hash) const {
+    return *priv_segment((hash >> 32ULL) & (k_num_segments - 1));
+  }
+
+  static uint8_t *priv_controls(const segment_type &segment) {
+    return metall::to_raw_pointer(segment.controls);
+  }
+
+  static value_type *priv_slots(const segment_type &segment) {
+    return metall::to_raw_pointer(segment.slots);
+  }
+
+  /// \brief Returns the capacity to hold 'num_elements' elements keeping the
+  /// load factor at most 7/8.
+  static size_type priv_capacity_for(const size_type num_elements) {
+    size_type capacity = k_min_capacity;
+    while (capacity / 8 * 7 < num_elements) capacity *= 2;
+    return capacity;
+  }
+
+  size_type priv_find_slot(const segment_type &segment, const key_type &key,
+                           const uint64_t hash) const {
+    if (segment.capacity == 0) return k_npos;
+    const auto *const controls = priv_controls(segment);
+    const auto *const slots = priv_slots(segment);
+    const auto control_word = priv_control_word(hash);
+    const size_type mask = segment.capacity - 1;
+    for (size_type i = hash & mask, n = 0; n < segment.capacity;
+         i = (i + 1) & mask, ++n) {
+      if (controls[i] == k_empty) return k_npos;
+      if (controls[i] == control_word && m_key_equal(slots[i].first, key)) {
+        return i;
+      }
+    }
+    return k_npos;
+  }
+
+  /// \brief Inserts a new element; the key must not exist in the segment.
+  /// \return The slot number of the inserted element.
+  template <typename... args_type>
+  size_type priv_emplace_new(segment_type &segment, const uint64_t hash,
+                             const key_type &key, args_type &&...args) {
+    if ((segment.size + segment.num_deleted + 1) > segment.capacity / 8 * 7) {
+      // Reuses the capacity if the deleted slots are the majority
+      const auto new_capacity = (segment.num_deleted > segment.size)
+                                    ? segment.capacity
+                                    : priv_capacity_for(segment.size + 1);
+      priv_rehash(segment, new_capacity);
+    }
+
+    const auto slot_no = priv_find_free_slot(segment, hash);
+    value_allocator_type alloc(m_allocator);
+    value_allocator_traits::construct(
+        alloc, &priv_slots(segment)[slot_no], std::piecewise_construct,
+        std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<args_type>(args)...));
+
+    auto &control = priv_controls(segment)[slot_no];
+    if (control == k_deleted) --segment.num_deleted;
+    control = priv_control_word(hash);
+    ++segment.size;
+    return slot_no;
+  }
+
+  static size_type priv_find_free_slot(const segment_type &segment,
+                                       const uint64_t hash) {
+    const auto *const controls = priv_controls(segment);
+    const size_type mask = segment.capacity - 1;
+    size_type i = hash & mask;
+    while (controls[i] & k_full_flag) i = (i + 1) & mask;
+    return i;
+  }
+
+  /// \brief Moves all elements to a new table with 'new_capacity' slots,
+  /// which also drops the deleted slots.
+  void priv_rehash(segment_type &segment, const size_type new_capacity) {
+    control_allocator_type control_alloc(m_allocator);
+    value_allocator_type value_alloc(m_allocator);
+
+    segment_type new_table;
+    new_table.capacity = new_capacity;
+    new_table.controls = std::allocator_traits<
+        control_allocator_type>::allocate(control_alloc, new_capacity);
+    try {
+      new_table.slots =
+          value_allocator_traits::allocate(value_alloc, new_capacity);
+    } catch (...) {
+      std::allocator_traits<control_allocator_type>::deallocate(
+          control_alloc, new_table.controls, new_capacity);
+      throw;
+    }
+    std::fill_n(priv_controls(new_table), new_capacity, k_empty);
+
+    auto *const old_controls = priv_controls(segment);
+    auto *const old_slots = priv_slots(segment);
+    auto *const new_controls = priv_controls(new_table);
+    auto *const new_slots = priv_slots(new_table);
+    for (size_type i = 0; i < segment.capacity; ++i) {
+      if (!(old_controls[i] & k_full_flag)) continue;
+      const auto hash = priv_hash(old_slots[i].first);
+      const auto slot_no = priv_find_free_slot(new_table, hash);
+      value_allocator_traits::construct(value_alloc, &new_slots[slot_no],
+                                        std::move(old_slots[i]));
+      value_allocator_traits::destroy(value_alloc, &old_slots[i]);
+      new_controls[slot_no] = old_controls[i];
+    }
+    new_table.size = segment.size;
+
+    priv_deallocate_table(segment);
+    segment.capacity = new_table.capacity;
+    segment.num_deleted = 0;
+    segment.controls = new_table.controls;
+    segment.slots = new_table.slots;
+  }
+
+  void priv_release_table(segment_type &segment) {
+    value_allocator_type alloc(m_allocator);
+    auto *const controls = priv_controls(segment);
+    auto *const slots = priv_slots(segment);
+    for (size_type i = 0; i < segment.capacity; ++i) {
+      if (controls[i] & k_full_flag) {
+        value_allocator_traits::destroy(alloc, &slots[i]);
+      }
+    }
+    priv_deallocate_table(segment);
+    segment.capacity = 0;
+    segment.size = 0;
+    segment.num_deleted = 0;
+    segment.controls = nullptr;
+    segment.slots = nullptr;
+  }
+
+  void priv_deallocate_table(segment_type &segment) {
+    if (segment.capacity == 0) return;
+    control_allocator_type control_alloc(m_allocator);
+    value_allocator_type value_alloc(m_allocator);
+    std::allocator_traits<control_allocator_type>::deallocate(
+        control_alloc, segment.controls, segment.capacity);
+    value_allocator_traits::deallocate(value_alloc, segment.slots,
+                                       segment.capacity);
+  }
+
+  void priv_destroy() noexcept {
+    if (!m_segments) return;
+    segment_allocator_type alloc(m_allocator);
+    for (size_type i = 0; i < k_num_segments; ++i) {
+      priv_release_table(*priv_segment(i));
+      segment_allocator_traits::destroy(alloc, priv_segment(i));
+    }
+    segment_allocator_traits::deallocate(alloc, m_segments, k_num_segments);
+    m_segments = nullptr;
+  }
+
+  allocator_type m_allocator;
+  other_pointer_type<segment_type> m_segments{nullptr};
+  hasher m_hasher{};
+  key_equal m_key_equal{};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_CONCURRENT_UNORDERED_MAP_HPP
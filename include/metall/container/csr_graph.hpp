@@ -0,0 +1,486 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_CSR_GRAPH_HPP
+#define METALL_CONTAINER_CSR_GRAPH_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A graph in the compressed sparse row (CSR) format that can be
+/// stored in persistent memory.
+/// The neighbors of each vertex are sorted in ascending order.
+/// The graph is immutable once it is built by build().
+/// It provides the same traversal interface as the adjacency lists in the
+/// benchmarks, i.e., num_values(), values_begin(), and values_end().
+/// \tparam _vertex_id_type An unsigned integer type for vertex IDs.
+/// \tparam _index_type An unsigned integer type for edge offsets.
+/// \tparam k_compressed If true, each neighbor list is stored as the
+/// differences between adjacent neighbors in the variable-length (LEB128)
+/// encoding.
+/// \tparam _allocator_type An allocator type.
+template <typename _vertex_id_type = uint64_t, typename _index_type = uint64_t,
+          bool k_compressed = false,
+          typename _allocator_type = metall::manager::allocator_type<std::byte>>
+class csr_graph {
+  static_assert(std::is_unsigned_v<_vertex_id_type>,
+                "Vertex ID type must be unsigned");
+  static_assert(std::is_unsigned_v<_index_type>,
+                "Index type must be unsigned");
+
+ public:
+  using vertex_id_type = _vertex_id_type;
+  /// \brief Same as vertex_id_type. For the adjacency list interface.
+  using key_type = vertex_id_type;
+  /// \brief Same as vertex_id_type. For the adjacency list interface.
+  using value_type = vertex_id_type;
+  using index_type = _index_type;
+  using size_type = std::size_t;
+  using allocator_type = _allocator_type;
+
+  class compressed_neighbor_iterator;
+  class key_iterator;
+
+  /// \brief An iterator over the neighbors of a vertex.
+  using value_iterator =
+      std::conditional_t<k_compressed, compressed_neighbor_iterator,
+                         const vertex_id_type *>;
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+  template <typename T>
+  using vector_type =
+      metall::container::vector<T, other_allocator_type<T>>;
+  using neighbor_storage_type =
+      std::conditional_t<k_compressed, uint8_t, vertex_id_type>;
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit csr_graph(const allocator_type &allocator = allocator_type())
+      : m_offsets(allocator), m_neighbors(allocator) {}
+
+  /// \brief Builds the graph from edge lists, discarding the current graph.
+  /// Each edge list is read by a thread twice: first to count the degrees
+  /// and then to place the edges.
+  /// \tparam edge_list_type A range of (source, destination) pairs whose
+  /// begin() can be called multiple times, e.g., a list of pairs or
+  /// bench_utility::pair_reader.
+  /// \param edge_lists Edge lists to read in parallel.
+  /// \param num_vertices The number of vertices, i.e., the max vertex ID + 1.
+  /// All vertex IDs in the edge lists must be smaller than this value.
+  /// If 0 is given, the edge lists are read once more to find the max ID.
+  template <typename edge_list_type>
+  void build(std::vector<edge_list_type> &edge_lists,
+             size_type num_vertices = 0) {
+    clear();
+    if (num_vertices == 0) {
+      num_vertices = priv_find_max_vertex_id(edge_lists) + 1;
+    }
+
+    // Count the degrees into the offset array
+    m_offsets.resize(num_vertices + 1, 0);
+    auto *const offsets = metall::to_raw_pointer(m_offsets.data());
+    priv_for_each_edge(edge_lists,
+                       [=](const vertex_id_type src,
+                           [[maybe_unused]] const vertex_id_type dst) {
+                         assert(src < num_vertices && dst < num_vertices);
+                         mdtl::atomic_fetch_add_relaxed(&offsets[src + 1],
+                                                        index_type(1));
+                       });
+    for (size_type v = 0; v < num_vertices; ++v) {
+      offsets[v + 1] += offsets[v];
+    }
+
+    // Place the edges
+    std::vector<vertex_id_type> plain_neighbors;
+    vertex_id_type *neighbors = nullptr;
+    if constexpr (k_compressed) {
+      plain_neighbors.resize(offsets[num_vertices]);
+      neighbors = plain_neighbors.data();
+    } else {
+      m_neighbors.resize(offsets[num_vertices]);
+      neighbors = metall::to_raw_pointer(m_neighbors.data());
+    }
+    {
+      std::vector<index_type> cursors(offsets, offsets + num_vertices);
+      priv_for_each_edge(
+          edge_lists, [&cursors, neighbors](const vertex_id_type src,
+                                            const vertex_id_type dst) {
+            neighbors[mdtl::atomic_fetch_add_relaxed(&cursors[src],
+                                                     index_type(1))] = dst;
+          });
+    }
+    priv_parallel_for(num_vertices, [offsets, neighbors](const size_type v) {
+      std::sort(neighbors + offsets[v], neighbors + offsets[v + 1]);
+    });
+
+    if constexpr (k_compressed) {
+      priv_compress(plain_neighbors);
+    }
+  }
+
+  /// \brief Removes all vertices and edges.
+  void clear() {
+    m_offsets.clear();
+    m_neighbors.clear();
+    m_num_edges = 0;
+  }
+
+  /// \brief Returns the number of vertices.
+  /// \return The number of vertices, i.e., the max vertex ID + 1.
+  size_type num_vertices() const {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+
+  /// \brief Returns the number of edges.
+  /// \return The number of edges.
+  size_type num_edges() const { return m_num_edges; }
+
+  /// \brief Returns the number of neighbors of a vertex.
+  /// \param vertex A vertex ID.
+  /// \return The number of neighbors of 'vertex'.
+  size_type num_values(const key_type vertex) const {
+    if (vertex >= num_vertices()) return 0;
+    if constexpr (k_compressed) {
+      // Each list starts with its length
+      vertex_id_type degree;
+      priv_decode(priv_neighbor_data() + m_offsets[vertex], &degree);
+      return degree;
+    } else {
+      return m_offsets[vertex + 1] - m_offsets[vertex];
+    }
+  }
+
+  /// \brief Returns an iterator to the first neighbor of a vertex.
+  /// \param vertex A vertex ID.
+  /// \return An iterator to the first neighbor of 'vertex'.
+  value_iterator values_begin(const key_type vertex) const {
+    if (vertex >= num_vertices()) return values_end(vertex);
+    const auto *const first = priv_neighbor_data() + m_offsets[vertex];
+    if constexpr (k_compressed) {
+      vertex_id_type degree;
+      return compressed_neighbor_iterator(priv_decode(first, &degree),
+                                          priv_list_end(vertex));
+    } else {
+      return first;
+    }
+  }
+
+  /// \brief Returns an iterator to the element following the last neighbor
+  /// of a vertex.
+  /// \param vertex A vertex ID.
+  /// \return An iterator to the end of the neighbors of 'vertex'.
+  value_iterator values_end(const key_type vertex) const {
+    if constexpr (k_compressed) {
+      const auto *const end = (vertex >= num_vertices())
+                                  ? priv_neighbor_data()
+                                  : priv_list_end(vertex);
+      return compressed_neighbor_iterator(end, end);
+    } else {
+      return priv_neighbor_data() +
+             ((vertex >= num_vertices()) ? 0 : m_offsets[vertex + 1]);
+    }
+  }
+
+  /// \brief Returns an iterator to the first vertex.
+  /// Each element is a pair of a vertex ID and its number of neighbors.
+  /// \return An iterator to the first vertex.
+  key_iterator keys_begin() const { return key_iterator(this, 0); }
+
+  /// \brief Returns an iterator to the element following the last vertex.
+  /// \return An iterator to the element following the last vertex.
+  key_iterator keys_end() const { return key_iterator(this, num_vertices()); }
+
+  /// \brief Returns an instance of the allocator.
+  /// \return An allocator object.
+  allocator_type get_allocator() const { return m_offsets.get_allocator(); }
+
+ private:
+  const neighbor_storage_type *priv_neighbor_data() const {
+    return metall::to_raw_pointer(m_neighbors.data());
+  }
+
+  const uint8_t *priv_list_end(const key_type vertex) const {
+    return priv_neighbor_data() + m_offsets[vertex + 1];
+  }
+
+  /// \brief Decodes a LEB128 value and returns the position of the next one.
+  static const uint8_t *priv_decode(const uint8_t *pos,
+                                    vertex_id_type *const value) {
+    vertex_id_type v = 0;
+    for (int shift = 0;; shift += 7) {
+      const auto byte = *pos++;
+      v |= vertex_id_type(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    *value = v;
+    return pos;
+  }
+
+  static uint8_t *priv_encode(vertex_id_type value, uint8_t *pos) {
+    while (value >= 0x80) {
+      *pos++ = uint8_t(value | 0x80);
+      value >>= 7;
+    }
+    *pos++ = uint8_t(value);
+    return pos;
+  }
+
+  static size_type priv_encoded_size(vertex_id_type value) {
+    size_type size = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      ++size;
+    }
+    return size;
+  }
+
+  /// \brief Replaces the offsets to the neighbors with the offsets to the
+  /// encoded neighbor lists and encodes the lists.
+  void priv_compress(const std::vector<vertex_id_type> &plain_neighbors) {
+    const auto n = num_vertices();
+    auto *const offsets = metall::to_raw_pointer(m_offsets.data());
+    std::vector<index_type> list_bytes(n);
+    priv_parallel_for(n, [&](const size_type v) {
+      const auto degree = vertex_id_type(offsets[v + 1] - offsets[v]);
+      auto size = priv_encoded_size(degree);
+      vertex_id_type prev = 0;
+      for (auto i = offsets[v]; i < offsets[v + 1]; ++i) {
+        size += priv_encoded_size(plain_neighbors[i] - prev);
+        prev = plain_neighbors[i];
+      }
+      list_bytes[v] = size;
+    });
+
+    // Keep the offsets to the neighbors
+    std::vector<index_type> plain_offsets(offsets, offsets + n + 1);
+    offsets[0] = 0;
+    for (size_type v = 0; v < n; ++v) {
+      offsets[v + 1] = offsets[v] + list_bytes[v];
+    }
+
+    m_neighbors.resize(offsets[n]);
+    auto *const bytes = metall::to_raw_pointer(m_neighbors.data());
+    priv_parallel_for(n, [&](const size_type v) {
+      auto *pos = bytes + offsets[v];
+      pos = priv_encode(
+          vertex_id_type(plain_offsets[v + 1] - plain_offsets[v]), pos);
+      vertex_id_type prev = 0;
+      for (auto i = plain_offsets[v]; i < plain_offsets[v + 1]; ++i) {
+        pos = priv_encode(plain_neighbors[i] - prev, pos);
+        prev = plain_neighbors[i];
+      }
+      assert(pos == bytes + offsets[v + 1]);
+    });
+    m_num_edges = plain_neighbors.size();
+  }
+
+  template <typename edge_list_type>
+  static vertex_id_type priv_find_max_vertex_id(
+      std::vector<edge_list_type> &edge_lists) {
+    std::vector<vertex_id_type> max_ids(edge_lists.size(), 0);
+    priv_parallel_for_edge_lists(edge_lists, [&max_ids](const size_type i,
+                                                        auto &edge_list) {
+      for (auto itr = edge_list.begin(), end = edge_list.end(); itr != end;
+           ++itr) {
+        const auto &edge = *itr;
+        max_ids[i] = std::max(
+            {max_ids[i], vertex_id_type(edge.first),
+             vertex_id_type(edge.second)});
+      }
+    });
+    return max_ids.empty() ? 0
+                           : *std::max_element(max_ids.begin(), max_ids.end());
+  }
+
+  template <typename edge_list_type, typename function_type>
+  void priv_for_each_edge(std::vector<edge_list_type> &edge_lists,
+                          const function_type &func) {
+    std::vector<size_type> num_edges(edge_lists.size(), 0);
+    priv_parallel_for_edge_lists(
+        edge_lists, [&func, &num_edges](const size_type i, auto &edge_list) {
+          for (auto itr = edge_list.begin(), end = edge_list.end();
+               itr != end; ++itr) {
+            const auto &edge = *itr;
+            func(vertex_id_type(edge.first), vertex_id_type(edge.second));
+            ++num_edges[i];
+          }
+        });
+    m_num_edges = 0;
+    for (const auto n : num_edges) m_num_edges += n;
+  }
+
+  /// \brief Calls 'func' with each edge list, using a thread per list.
+  template <typename edge_list_type, typename function_type>
+  static void priv_parallel_for_edge_lists(
+      std::vector<edge_list_type> &edge_lists, const function_type &func) {
+    if (edge_lists.size() == 1) {
+      func(0, edge_lists[0]);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (size_type i = 0; i < edge_lists.size(); ++i) {
+      threads.emplace_back([&func, &edge_lists, i]() {
+        func(i, edge_lists[i]);
+      });
+    }
+    for (auto &th : threads) th.join();
+  }
+
+  /// \brief Calls 'func' with each of [0, n) using the hardware threads.
+  template <typename function_type>
+  static void priv_parallel_for(const size_type n,
+                                const function_type &func) {
+    const size_type num_threads = std::min(
+        n, std::max(size_type(1),
+                    (size_type)std::thread::hardware_concurrency()));
+    const auto process = [&func, n, num_threads](const size_type t) {
+      for (size_type i = n * t / num_threads; i < n * (t + 1) / num_threads;
+           ++i) {
+        func(i);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_type t = 1; t < num_threads; ++t) {
+      threads.emplace_back(process, t);
+    }
+    if (num_threads > 0) process(0);
+    for (auto &th : threads) th.join();
+  }
+
+  /// For the compressed format, the offsets are in bytes.
+  vector_type<index_type> m_offsets;
+  vector_type<neighbor_storage_type> m_neighbors;
+  size_type m_num_edges{0};
+};
+
+/// \brief An iterator over a neighbor list in the compressed format.
+template <typename vertex_id_type, typename index_type, bool k_compressed,
+          typename allocator_type>
+class csr_graph<vertex_id_type, index_type, k_compressed,
+                allocator_type>::compressed_neighbor_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = vertex_id_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const vertex_id_type *;
+  using reference = const vertex_id_type &;
+
+  compressed_neighbor_iterator() = default;
+
+  compressed_neighbor_iterator(const uint8_t *const pos,
+                               const uint8_t *const end)
+      : m_pos(pos), m_end(end) {
+    if (m_pos != m_end) m_next = priv_decode(m_pos, &m_value);
+  }
+
+  reference operator*() const { return m_value; }
+  pointer operator->() const { return &m_value; }
+
+  compressed_neighbor_iterator &operator++() {
+    m_pos = m_next;
+    if (m_pos != m_end) {
+      vertex_id_type delta;
+      m_next = priv_decode(m_pos, &delta);
+      m_value += delta;
+    }
+    return *this;
+  }
+
+  compressed_neighbor_iterator operator++(int) {
+    auto tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  bool operator==(const compressed_neighbor_iterator &other) const {
+    return m_pos == other.m_pos;
+  }
+
+  bool operator!=(const compressed_neighbor_iterator &other) const {
+    return m_pos != other.m_pos;
+  }
+
+ private:
+  const uint8_t *m_pos{nullptr};
+  const uint8_t *m_next{nullptr};
+  const uint8_t *m_end{nullptr};
+  vertex_id_type m_value{0};
+};
+
+/// \brief An iterator over the vertices.
+/// Each element is a pair of a vertex ID and its number of neighbors.
+template <typename vertex_id_type, typename index_type, bool k_compressed,
+          typename allocator_type>
+class csr_graph<vertex_id_type, index_type, k_compressed,
+                allocator_type>::key_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<vertex_id_type, std::size_t>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+
+  key_iterator(const csr_graph *const graph, const vertex_id_type vertex)
+      : m_graph(graph), m_value(vertex, 0) {
+    priv_update_degree();
+  }
+
+  reference operator*() const { return m_value; }
+  pointer operator->() const { return &m_value; }
+
+  key_iterator &operator++() {
+    ++m_value.first;
+    priv_update_degree();
+    return *this;
+  }
+
+  key_iterator operator++(int) {
+    auto tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  bool operator==(const key_iterator &other) const {
+    return m_value.first == other.m_value.first;
+  }
+
+  bool operator!=(const key_iterator &other) const {
+    return m_value.first != other.m_value.first;
+  }
+
+ private:
+  void priv_update_degree() {
+    m_value.second = m_graph->num_values(m_value.first);
+  }
+
+  const csr_graph *m_graph;
+  value_type m_value;
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_CSR_GRAPH_HPP
@@ -0,0 +1,509 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_EXPERIMENT_JGRAPH_BULK_LOAD_HPP
+#define METALL_CONTAINER_EXPERIMENT_JGRAPH_BULK_LOAD_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <metall/container/experimental/jgraph/jgraph.hpp>
+
+namespace metall::container::experimental::jgraph {
+
+/// \brief Options of bulk_load().
+struct bulk_load_options {
+  /// \brief The key of the vertex ID in a vertex object.
+  std::string vertex_id_key{"id"};
+
+  /// \brief The key of the source vertex ID in an edge object.
+  std::string source_id_key{"start"};
+
+  /// \brief The key of the destination vertex ID in an edge object.
+  std::string destination_id_key{"end"};
+
+  /// \brief If true, registers edges as undirected ones.
+  bool undirected{false};
+
+  /// \brief The number of threads to use.
+  /// If 0, uses std::thread::hardware_concurrency().
+  std::size_t num_threads{0};
+
+  /// \brief The number of lines to load at once.
+  /// Bounds the DRAM used while loading.
+  std::size_t batch_size{1ULL << 20U};
+};
+
+namespace jgdtl {
+
+/// \brief Loads JSON Lines files into a jgraph in parallel.
+/// Lines are processed in batches. In each batch,
+/// 1) the lines are parsed directly into values allocated by the graph's
+/// allocator and vertex IDs are hashed in parallel, then
+/// 2) the vertex IDs are partitioned into shards by the high bits of their
+/// hash values, and the shards are resolved to internal IDs in parallel,
+/// and finally 3) the vertex and edge tables and the adjacency lists are
+/// filled in batch.
+/// The allocator of the graph must be thread-safe if more than one thread
+/// is used.
+template <typename graph_type>
+class bulk_loader {
+ public:
+  using allocator_type = typename graph_type::allocator_type;
+  using value_type = typename graph_type::value_type;
+
+  bulk_loader(graph_type &graph, const bulk_load_options &options)
+      : m_graph(graph),
+        m_options(options),
+        m_num_threads(options.num_threads > 0
+                          ? options.num_threads
+                          : std::max(std::thread::hardware_concurrency(), 1U)) {
+  }
+
+  /// \brief Loads vertices. Each line must be a JSON object that has a
+  /// string vertex ID. If an ID appears more than once, the last value is
+  /// kept.
+  /// \return Returns the number of lines loaded.
+  std::size_t load_vertices(const std::vector<std::string> &file_paths) {
+    return priv_load(file_paths, [this]() { return priv_load_vertex_batch(); });
+  }
+
+  /// \brief Loads edges. Each line must be a JSON object that has string
+  /// source and destination vertex IDs. Unknown vertices are registered.
+  /// \return Returns the number of lines loaded.
+  std::size_t load_edges(const std::vector<std::string> &file_paths) {
+    return priv_load(file_paths, [this]() { return priv_load_edge_batch(); });
+  }
+
+ private:
+  using internal_id_type = typename graph_type::internal_id_type;
+  static constexpr internal_id_type k_max_internal_id =
+      graph_type::k_max_internal_id;
+  static constexpr std::size_t k_shard_bits = 8;
+  static constexpr std::size_t k_num_shards = 1ULL << k_shard_bits;
+
+  enum line_status : char { k_line_ok, k_parse_error, k_no_id };
+
+  struct line_info {
+    std::size_t file_index;
+    std::size_t line_no;
+    std::size_t offset;
+    std::size_t length;
+  };
+
+  template <typename batch_loader_type>
+  std::size_t priv_load(const std::vector<std::string> &file_paths,
+                        batch_loader_type load_batch) {
+    m_file_paths = &file_paths;
+    std::size_t num_loaded = 0;
+    for (std::size_t f = 0; f < file_paths.size(); ++f) {
+      std::ifstream ifs(file_paths[f]);
+      if (!ifs.is_open()) {
+        std::cerr << "Failed to open " << file_paths[f] << std::endl;
+        continue;
+      }
+      std::string line;
+      std::size_t line_no = 0;
+      while (std::getline(ifs, line)) {
+        ++line_no;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        m_lines.push_back(line_info{f, line_no, m_text.size(), line.size()});
+        m_text.append(line);
+        if (m_lines.size() >= m_options.batch_size) {
+          num_loaded += load_batch();
+          priv_clear_batch();
+        }
+      }
+    }
+    if (!m_lines.empty()) {
+      num_loaded += load_batch();
+      priv_clear_batch();
+    }
+    return num_loaded;
+  }
+
+  std::size_t priv_load_vertex_batch() {
+    priv_parse({&m_options.vertex_id_key});
+    priv_resolve_vertex_ids();
+
+    // A thread handles the lines of the vertices it owns in line order so
+    // that the last value of a vertex is kept.
+    priv_run(m_num_threads, [this](const std::size_t t) {
+      for (std::size_t i = 0; i < m_lines.size(); ++i) {
+        if (m_status[i] != k_line_ok) continue;
+        const auto internal_id = m_internal_ids[i];
+        if (internal_id % m_num_threads != t) continue;
+        m_graph.m_vertex_storage.at(internal_id).value() =
+            std::move(m_values[i]);
+      }
+    });
+
+    return priv_report_errors();
+  }
+
+  std::size_t priv_load_edge_batch() {
+    priv_parse({&m_options.source_id_key, &m_options.destination_id_key});
+    priv_resolve_vertex_ids();
+
+    // Edge IDs are assigned in line order
+    m_edge_ids.assign(m_lines.size(), 0);
+    std::size_t num_edges = 0;
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+      if (m_status[i] != k_line_ok) continue;
+      m_edge_ids[i] = m_graph.priv_generate_edge_id();
+      ++num_edges;
+    }
+
+    // The edge table is filled by one thread while the others fill the
+    // adjacency lists of the source vertices they own.
+    priv_run(m_num_threads + 1, [this, num_edges](const std::size_t t) {
+      if (t == m_num_threads) {
+        priv_fill_edge_storage(num_edges);
+      } else {
+        priv_fill_adj_list(t);
+      }
+    });
+
+    return priv_report_errors();
+  }
+
+  /// \brief Parses the lines in parallel and extracts and hashes the vertex
+  /// IDs associated with 'keys'.
+  void priv_parse(const std::vector<const std::string *> &keys) {
+    const auto num_lines = m_lines.size();
+    m_num_keys = keys.size();
+    m_values.clear();
+    m_values.resize(num_lines, value_type(m_graph.get_allocator()));
+    m_status.assign(num_lines, k_line_ok);
+    m_ids.assign(num_lines * m_num_keys, std::string_view());
+    m_hashes.assign(num_lines * m_num_keys, 0);
+    m_buckets.resize(m_num_threads);
+    for (auto &buckets : m_buckets) buckets.resize(k_num_shards);
+
+    // Lines are split into contiguous blocks so that the buckets keep the
+    // line order when they are visited in thread order.
+    priv_run(m_num_threads, [this, &keys, num_lines](const std::size_t t) {
+      const auto begin = num_lines * t / m_num_threads;
+      const auto end = num_lines * (t + 1) / m_num_threads;
+      mj::jsndtl::bulk_parser<allocator_type> parser;
+      for (std::size_t i = begin; i < end; ++i) {
+        const auto &line = m_lines[i];
+        if (!parser.parse(
+                std::string_view(m_text.data() + line.offset, line.length),
+                m_values[i])) {
+          m_status[i] = k_parse_error;
+          continue;
+        }
+        if (!priv_extract_ids(i, keys)) {
+          m_status[i] = k_no_id;
+          continue;
+        }
+        for (std::size_t k = 0; k < m_num_keys; ++k) {
+          const auto request = i * m_num_keys + k;
+          m_hashes[request] = graph_type::priv_hash_id(m_ids[request]);
+          m_buckets[t][priv_shard(m_hashes[request])].push_back(request);
+        }
+      }
+    });
+  }
+
+  bool priv_extract_ids(const std::size_t line_index,
+                        const std::vector<const std::string *> &keys) {
+    const auto &val = m_values[line_index];
+    if (!val.is_object()) return false;
+    const auto &obj = val.as_object();
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+      const auto itr = obj.find(*keys[k]);
+      if (itr == obj.end() || !itr->value().is_string()) return false;
+      // Points to the string in the parsed value; valid until the value is
+      // moved to the graph
+      const auto &id = itr->value().as_string();
+      m_ids[line_index * m_num_keys + k] =
+          std::string_view(id.data(), id.size());
+    }
+    return true;
+  }
+
+  /// \brief Resolves the internal IDs of all vertex IDs in the batch,
+  /// registering the vertices that do not exist yet.
+  void priv_resolve_vertex_ids() {
+    m_internal_ids.assign(m_ids.size(), k_max_internal_id);
+    m_new_requests.resize(k_num_shards);
+    m_deferred_requests.resize(k_num_shards);
+
+    std::atomic<std::size_t> next_shard{0};
+    std::vector<std::size_t> max_distances(m_num_threads, 0);
+    priv_run(m_num_threads, [this, &next_shard,
+                             &max_distances](const std::size_t t) {
+      for (auto s = next_shard.fetch_add(1); s < k_num_shards;
+           s = next_shard.fetch_add(1)) {
+        priv_resolve_shard(s, max_distances[t]);
+      }
+    });
+
+    m_graph.m_max_vid_distance =
+        std::max(m_graph.m_max_vid_distance,
+                 *std::max_element(max_distances.begin(), max_distances.end()));
+    priv_register_new_vertices();
+
+    // IDs that probed into the next shard are registered one by one
+    for (const auto &requests : m_deferred_requests) {
+      for (const auto request : requests) {
+        const auto &id = m_ids[request];
+        m_graph.register_vertex(id);
+        m_internal_ids[request] = m_graph.priv_get_vertex_internal_id(id);
+      }
+    }
+  }
+
+  /// \brief Resolves the vertex IDs in a shard.
+  /// Only reads the graph; new internal IDs are chosen with the same linear
+  /// probing as jgraph::register_vertex(), looking at both the ID table in
+  /// the graph and the IDs taken in this shard.
+  void priv_resolve_shard(const std::size_t shard, std::size_t &max_distance) {
+    std::unordered_map<std::string_view, internal_id_type> resolved;
+    std::unordered_set<internal_id_type> taken;
+    for (const auto &buckets : m_buckets) {
+      for (const auto request : buckets[shard]) {
+        const auto &id = m_ids[request];
+        auto itr = resolved.find(id);
+        if (itr == resolved.end()) {
+          auto internal_id = m_graph.priv_get_vertex_internal_id(id);
+          if (internal_id == k_max_internal_id) {
+            internal_id = m_hashes[request];
+            std::size_t distance = 0;
+            while (m_graph.m_vertex_id_table.count(internal_id) > 0 ||
+                   taken.count(internal_id) > 0) {
+              internal_id = (internal_id + 1) % k_max_internal_id;
+              ++distance;
+            }
+            if (priv_shard(internal_id) == shard) {
+              taken.insert(internal_id);
+              m_new_requests[shard].push_back(request);
+              max_distance = std::max(distance, max_distance);
+            } else {
+              internal_id = k_max_internal_id;
+            }
+          }
+          itr = resolved.emplace(id, internal_id).first;
+        }
+        m_internal_ids[request] = itr->second;
+        if (itr->second == k_max_internal_id) {
+          m_deferred_requests[shard].push_back(request);
+        }
+      }
+    }
+  }
+
+  /// \brief Registers the new vertices found by priv_resolve_shard().
+  /// The ID table, the adjacency list, and the vertex table are filled by
+  /// different threads.
+  void priv_register_new_vertices() {
+    std::size_t num_new_vertices = 0;
+    for (const auto &requests : m_new_requests) {
+      num_new_vertices += requests.size();
+    }
+    if (num_new_vertices == 0) return;
+
+    priv_run(3, [this, num_new_vertices](const std::size_t t) {
+      auto &graph = m_graph;
+      if (t == 0) {
+        auto &table = graph.m_vertex_id_table;
+        table.reserve(table.size() + num_new_vertices);
+        for (const auto &requests : m_new_requests) {
+          for (const auto request : requests) {
+            const auto &id = m_ids[request];
+            table[m_internal_ids[request]].assign(id.data(), id.size());
+          }
+        }
+      } else if (t == 1) {
+        auto &adj_list = graph.m_adj_list;
+        adj_list.reserve(adj_list.size() + num_new_vertices);
+        for (const auto &requests : m_new_requests) {
+          for (const auto request : requests) {
+            adj_list.emplace(m_internal_ids[request],
+                             typename graph_type::adj_list_edge_list_type{
+                                 adj_list.get_allocator()});
+          }
+        }
+      } else {
+        auto &storage = graph.m_vertex_storage;
+        storage.reserve(storage.size() + num_new_vertices);
+        for (const auto &requests : m_new_requests) {
+          for (const auto request : requests) {
+            storage.emplace(m_internal_ids[request],
+                            typename graph_type::vertex_data_type{
+                                m_ids[request], storage.get_allocator()});
+          }
+        }
+      }
+    });
+  }
+
+  void priv_fill_edge_storage(const std::size_t num_edges) {
+    auto &storage = m_graph.m_edge_storage;
+    storage.reserve(storage.size() + num_edges);
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+      if (m_status[i] != k_line_ok) continue;
+      const auto edge_id = m_edge_ids[i];
+      auto itr = storage
+                     .emplace(edge_id, typename graph_type::edge_data_type{
+                                           m_ids[i * 2], m_ids[i * 2 + 1],
+                                           edge_id, storage.get_allocator()})
+                     .first;
+      itr->second.value() = std::move(m_values[i]);
+    }
+  }
+
+  /// \brief Adds the edges of the vertices owned by thread 't' to the
+  /// adjacency list. The adjacency list itself is only read; each edge list
+  /// is modified by only one thread.
+  void priv_fill_adj_list(const std::size_t t) {
+    const bool undirected = m_options.undirected;
+    std::unordered_map<internal_id_type, std::size_t> degrees;
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+      if (m_status[i] != k_line_ok) continue;
+      const auto src = m_internal_ids[i * 2];
+      const auto dst = m_internal_ids[i * 2 + 1];
+      if (src % m_num_threads == t) ++degrees[src];
+      if (undirected && dst % m_num_threads == t) ++degrees[dst];
+    }
+    for (const auto &[vertex, degree] : degrees) {
+      auto &edge_list = m_graph.m_adj_list.at(vertex);
+      edge_list.reserve(edge_list.size() + degree);
+    }
+
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+      if (m_status[i] != k_line_ok) continue;
+      const auto src = m_internal_ids[i * 2];
+      const auto dst = m_internal_ids[i * 2 + 1];
+      if (src % m_num_threads == t) {
+        m_graph.m_adj_list.at(src).emplace(dst, m_edge_ids[i]);
+      }
+      if (undirected && dst % m_num_threads == t) {
+        m_graph.m_adj_list.at(dst).emplace(src, m_edge_ids[i]);
+      }
+    }
+  }
+
+  /// \brief Reports the lines that were not loaded.
+  /// \return Returns the number of lines loaded.
+  std::size_t priv_report_errors() const {
+    std::size_t num_loaded = 0;
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+      const auto &line = m_lines[i];
+      if (m_status[i] == k_line_ok) {
+        ++num_loaded;
+      } else if (m_status[i] == k_parse_error) {
+        std::cerr << "Failed to parse line " << line.line_no << " of "
+                  << (*m_file_paths)[line.file_index] << std::endl;
+      } else {
+        std::cerr << "No vertex ID in line " << line.line_no << " of "
+                  << (*m_file_paths)[line.file_index] << std::endl;
+      }
+    }
+    return num_loaded;
+  }
+
+  void priv_clear_batch() {
+    m_text.clear();
+    m_lines.clear();
+    m_values.clear();
+    for (auto &buckets : m_buckets) {
+      for (auto &bucket : buckets) bucket.clear();
+    }
+    for (auto &requests : m_new_requests) requests.clear();
+    for (auto &requests : m_deferred_requests) requests.clear();
+  }
+
+  static std::size_t priv_shard(const internal_id_type hash) {
+    return hash >> (sizeof(internal_id_type) * 8 - k_shard_bits);
+  }
+
+  /// \brief Runs 'task' with task indices [0, num_tasks), each on its own
+  /// thread. Runs them on the calling thread if only one thread is used.
+  template <typename task_type>
+  void priv_run(const std::size_t num_tasks, const task_type &task) const {
+    if (m_num_threads == 1) {
+      for (std::size_t t = 0; t < num_tasks; ++t) task(t);
+      return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(num_tasks);
+    for (std::size_t t = 0; t < num_tasks; ++t) {
+      threads.emplace_back([&task, t]() { task(t); });
+    }
+    for (auto &th : threads) th.join();
+  }
+
+  graph_type &m_graph;
+  const bulk_load_options &m_options;
+  const std::size_t m_num_threads;
+  const std::vector<std::string> *m_file_paths{nullptr};
+
+  // Batch
+  std::string m_text;
+  std::vector<line_info> m_lines;
+  std::vector<value_type> m_values;
+  std::vector<line_status> m_status;
+  std::vector<internal_id_type> m_edge_ids;
+
+  // Vertex ID requests; line i has requests [i * m_num_keys, (i + 1) *
+  // m_num_keys)
+  std::size_t m_num_keys{0};
+  std::vector<std::string_view> m_ids;
+  std::vector<internal_id_type> m_hashes;
+  std::vector<internal_id_type> m_internal_ids;
+  // [thread][shard] -> requests
+  std::vector<std::vector<std::vector<std::size_t>>> m_buckets;
+  // [shard] -> requests
+  std::vector<std::vector<std::size_t>> m_new_requests;
+  std::vector<std::vector<std::size_t>> m_deferred_requests;
+};
+
+}  // namespace jgdtl
+
+/// \brief Loads vertices and edges from JSON Lines files using multiple
+/// threads. All vertex files are loaded before the edge files.
+/// The lines are parsed directly into values allocated by the graph's
+/// allocator, which must be thread-safe if more than one thread is used.
+/// Empty lines are skipped; lines that fail to parse or do not have the
+/// required IDs are reported and skipped.
+/// The result is the same as calling jgraph::register_vertex() and
+/// jgraph::register_edge() for each line in order, except the ordering of
+/// the edges in an adjacency list.
+/// A frozen graph is thawed first.
+/// \tparam allocator_type An allocator type.
+/// \param graph A graph to load into.
+/// \param vertex_file_paths Paths to vertex files.
+/// \param edge_file_paths Paths to edge files.
+/// \param options Options.
+/// \return Returns the numbers of vertex and edge lines loaded.
+template <typename allocator_type>
+inline std::pair<std::size_t, std::size_t> bulk_load(
+    jgraph<allocator_type> &graph,
+    const std::vector<std::string> &vertex_file_paths,
+    const std::vector<std::string> &edge_file_paths,
+    const bulk_load_options &options = bulk_load_options()) {
+  graph.thaw();
+  jgdtl::bulk_loader<jgraph<allocator_type>> loader(graph, options);
+  const auto num_vertices = loader.load_vertices(vertex_file_paths);
+  const auto num_edges = loader.load_edges(edge_file_paths);
+  return std::make_pair(num_vertices, num_edges);
+}
+
+}  // namespace metall::container::experimental::jgraph
+
+#endif  // METALL_CONTAINER_EXPERIMENT_JGRAPH_BULK_LOAD_HPP
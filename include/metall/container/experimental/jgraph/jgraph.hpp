@@ -6,9 +6,11 @@
 #ifndef METALL_CONTAINER_EXPERIMENT_JGRAPH_JGRAPH_HPP
 #define METALL_CONTAINER_EXPERIMENT_JGRAPH_JGRAPH_HPP
 
+#include <algorithm>
 #include <iostream>
 #include <string_view>
 #include <functional>
+#include <thread>
 #include <utility>
 #include <optional>
 
@@ -41,8 +43,11 @@ template <typename storage_iterator_type>
 class vertex_iterator_impl;
 
 template <typename adj_list_edge_list_iterator_type,
-          typename storage_pointer_type>
+          typename storage_pointer_type, typename frozen_edge_type>
 class edge_iterator_impl;
+
+template <typename graph_type>
+class bulk_loader;
 }  // namespace jgdtl
 
 template <typename _allocator_type = std::allocator<std::byte>>
@@ -56,6 +61,12 @@ class jgraph {
   /// \brief JSON value type every vertex and edge has,
   using value_type = mj::value<allocator_type>;
 
+  /// \brief The type of internal vertex IDs.
+  /// An internal ID is obtained once by internal_id() and can be used
+  /// to access the vertex and its edges repeatedly without hashing the
+  /// vertex ID string. It stays valid as long as the graph exists.
+  using internal_id_type = uint64_t;
+
  private:
   template <typename T>
   using other_allocator =
@@ -70,7 +81,6 @@ class jgraph {
                        typename std::allocator_traits<
                            allocator_type>::template rebind_alloc<char>>;
 
-  using internal_id_type = uint64_t;
   static constexpr internal_id_type k_max_internal_id =
       std::numeric_limits<internal_id_type>::max();
 
@@ -176,6 +186,8 @@ class jgraph {
     const value_type &value() const { return m_value; }
 
    private:
+    friend class jgraph;
+
     string_type m_source_id;
     string_type m_destination_id;
     internal_id_type m_edge_id;
@@ -208,6 +220,19 @@ class jgraph {
       std::equal_to<>,
       other_scoped_allocator<std::pair<const internal_id_type, string_type>>>;
 
+  // CSR used while frozen
+  using edge_data_pointer = typename std::pointer_traits<
+      typename std::allocator_traits<allocator_type>::pointer>::
+      template rebind<edge_data_type>;
+
+  struct frozen_edge_type {
+    internal_id_type neighbor;  // hashed neighbor vid
+    edge_data_pointer edge;     // points to an item in the edge storage
+  };
+
+  template <typename T>
+  using frozen_vector_type = mc::vector<T, other_allocator<T>>;
+
  public:
   /// \brief Vertex iterator over a container of vertex data,
   /// which is metall::container::experimental::json::key_value_pair_type.
@@ -223,12 +248,14 @@ class jgraph {
   using edge_iterator = jgdtl::edge_iterator_impl<
       typename adj_list_edge_list_type::iterator,
       typename std::pointer_traits<typename std::allocator_traits<
-          allocator_type>::pointer>::template rebind<edge_storage_type>>;
+          allocator_type>::pointer>::template rebind<edge_storage_type>,
+      frozen_edge_type>;
   /// \brief Const edge iterator.
   using const_edge_iterator = jgdtl::edge_iterator_impl<
       typename adj_list_edge_list_type::const_iterator,
       typename std::pointer_traits<typename std::allocator_traits<
-          allocator_type>::pointer>::template rebind<const edge_storage_type>>;
+          allocator_type>::pointer>::template rebind<const edge_storage_type>,
+      frozen_edge_type>;
 
   /// \brief Constructor
   /// \param alloc An allocator object
@@ -236,7 +263,10 @@ class jgraph {
       : m_vertex_storage(alloc),
         m_edge_storage(alloc),
         m_adj_list(alloc),
-        m_vertex_id_table(alloc) {}
+        m_vertex_id_table(alloc),
+        m_frozen_vertex_ids(alloc),
+        m_frozen_offsets(alloc),
+        m_frozen_edges(alloc) {}
 
   /// \brief Checks if a vertex exists.
   /// \param vertex_id A vertex ID to check.
@@ -245,16 +275,47 @@ class jgraph {
     return priv_get_vertex_internal_id(vertex_id) != k_max_internal_id;
   }
 
+  /// \brief Checks if a vertex exists.
+  /// \param internal_id An internal ID of a vertex.
+  /// \return Returns true if the vertex exists; otherwise, returns false.
+  bool has_vertex(const internal_id_type internal_id) const {
+    return m_vertex_storage.count(internal_id) > 0;
+  }
+
+  /// \brief Returns the internal ID of a vertex.
+  /// \param vertex_id A vertex ID.
+  /// \return Returns the internal ID of the vertex.
+  /// If the vertex does not exist, returns invalid_internal_id().
+  internal_id_type internal_id(const id_type &vertex_id) const {
+    return priv_get_vertex_internal_id(vertex_id);
+  }
+
+  /// \brief Returns the internal ID that is not associated with any vertex.
+  static constexpr internal_id_type invalid_internal_id() noexcept {
+    return k_max_internal_id;
+  }
+
   std::size_t has_edges(const id_type &source_vertex_id,
                         const id_type &destination_vertex_id) const {
-    const auto src = priv_get_vertex_internal_id(source_vertex_id);
-    if (src == k_max_internal_id) return 0;
+    return has_edges(priv_get_vertex_internal_id(source_vertex_id),
+                     priv_get_vertex_internal_id(destination_vertex_id));
+  }
 
-    const auto dst = priv_get_vertex_internal_id(destination_vertex_id);
-    if (dst == k_max_internal_id) return 0;
+  /// \brief Returns the number of edges between two vertices.
+  /// \param source_internal_id An internal ID of the source vertex.
+  /// \param destination_internal_id An internal ID of the destination vertex.
+  /// \return Returns the number of edges.
+  std::size_t has_edges(const internal_id_type source_internal_id,
+                        const internal_id_type destination_internal_id) const {
+    if (m_frozen) {
+      const auto range =
+          priv_frozen_equal_range(source_internal_id, destination_internal_id);
+      return range.second - range.first;
+    }
 
-    const auto &edge_list = m_adj_list.at(src);
-    return edge_list.count(dst);
+    const auto itr = m_adj_list.find(source_internal_id);
+    if (itr == m_adj_list.end()) return 0;
+    return itr->second.count(destination_internal_id);
   }
 
   vertex_iterator register_vertex(const id_type &vertex_id) {
@@ -263,6 +324,7 @@ class jgraph {
       return vertex_iterator(m_vertex_storage.find(internal_id));
     }
 
+    thaw();
     internal_id = priv_generate_vertex_internal_id(vertex_id);
 
     m_adj_list.emplace(internal_id,
@@ -277,6 +339,7 @@ class jgraph {
   edge_iterator register_edge(const id_type &source_vertex_id,
                               const id_type &destination_vertex_id,
                               const bool undirected = false) {
+    thaw();
     register_vertex(source_vertex_id);
     register_vertex(destination_vertex_id);
 
@@ -299,32 +362,72 @@ class jgraph {
   }
 
   vertex_iterator find_vertex(const id_type &vertex_id) {
-    return vertex_iterator(
-        m_vertex_storage.find(priv_get_vertex_internal_id(vertex_id)));
+    return find_vertex(priv_get_vertex_internal_id(vertex_id));
   }
 
   const_vertex_iterator find_vertex(const id_type &vertex_id) const {
-    return const_vertex_iterator(
-        m_vertex_storage.find(priv_get_vertex_internal_id(vertex_id)));
+    return find_vertex(priv_get_vertex_internal_id(vertex_id));
+  }
+
+  vertex_iterator find_vertex(const internal_id_type internal_id) {
+    return vertex_iterator(m_vertex_storage.find(internal_id));
+  }
+
+  const_vertex_iterator find_vertex(const internal_id_type internal_id) const {
+    return const_vertex_iterator(m_vertex_storage.find(internal_id));
   }
 
   std::pair<edge_iterator, edge_iterator> find_edges(
       const id_type &source_vertex_id, const id_type &destination_vertex_id) {
-    const auto src_internal_id = priv_get_vertex_internal_id(source_vertex_id);
-    const auto dst_internal_id =
-        priv_get_vertex_internal_id(destination_vertex_id);
+    return find_edges(priv_get_vertex_internal_id(source_vertex_id),
+                      priv_get_vertex_internal_id(destination_vertex_id));
+  }
 
-    if (src_internal_id == k_max_internal_id ||
-        dst_internal_id == k_max_internal_id) {
-      return std::make_pair(edge_iterator{}, edge_iterator{});
+  std::pair<edge_iterator, edge_iterator> find_edges(
+      const internal_id_type source_internal_id,
+      const internal_id_type destination_internal_id) {
+    if (m_frozen) {
+      const auto range =
+          priv_frozen_equal_range(source_internal_id, destination_internal_id);
+      return std::make_pair(edge_iterator{range.first, &m_edge_storage},
+                            edge_iterator{range.second, &m_edge_storage});
     }
 
-    auto &edge_list = m_adj_list.at(src_internal_id);
-    auto range = edge_list.equal_range(dst_internal_id);
+    const auto itr = m_adj_list.find(source_internal_id);
+    if (itr == m_adj_list.end()) {
+      return std::make_pair(edge_iterator{}, edge_iterator{});
+    }
+    auto range = itr->second.equal_range(destination_internal_id);
     return std::make_pair(edge_iterator{range.first, &m_edge_storage},
                           edge_iterator{range.second, &m_edge_storage});
   }
 
+  std::pair<const_edge_iterator, const_edge_iterator> find_edges(
+      const id_type &source_vertex_id,
+      const id_type &destination_vertex_id) const {
+    return find_edges(priv_get_vertex_internal_id(source_vertex_id),
+                      priv_get_vertex_internal_id(destination_vertex_id));
+  }
+
+  std::pair<const_edge_iterator, const_edge_iterator> find_edges(
+      const internal_id_type source_internal_id,
+      const internal_id_type destination_internal_id) const {
+    if (m_frozen) {
+      const auto range =
+          priv_frozen_equal_range(source_internal_id, destination_internal_id);
+      return std::make_pair(const_edge_iterator{range.first, &m_edge_storage},
+                            const_edge_iterator{range.second, &m_edge_storage});
+    }
+
+    const auto itr = m_adj_list.find(source_internal_id);
+    if (itr == m_adj_list.end()) {
+      return std::make_pair(const_edge_iterator{}, const_edge_iterator{});
+    }
+    const auto range = itr->second.equal_range(destination_internal_id);
+    return std::make_pair(const_edge_iterator{range.first, &m_edge_storage},
+                          const_edge_iterator{range.second, &m_edge_storage});
+  }
+
   /// \brief Returns the number of vertices.
   /// \return The number of vertices.
   std::size_t num_vertices() const { return m_vertex_storage.size(); }
@@ -338,12 +441,23 @@ class jgraph {
   /// \return Returns the degree of the vertex corresponds to 'vid'.
   /// If no vertex is associated with 'vid', returns 0.
   std::size_t degree(const id_type &vertex_id) const {
-    const auto internal_id = priv_get_vertex_internal_id(vertex_id);
-    if (internal_id == k_max_internal_id) {
-      return 0;
+    return degree(priv_get_vertex_internal_id(vertex_id));
+  }
+
+  /// \brief Returns the degree of a vertex.
+  /// \param internal_id An internal ID of a vertex.
+  /// \return Returns the degree of the vertex.
+  /// If the vertex does not exist, returns 0.
+  std::size_t degree(const internal_id_type internal_id) const {
+    if (m_frozen) {
+      const auto index = priv_frozen_vertex_index(internal_id);
+      if (index == k_max_internal_id) return 0;
+      return m_frozen_offsets[index + 1] - m_frozen_offsets[index];
     }
 
-    return m_adj_list.at(internal_id).size();
+    const auto itr = m_adj_list.find(internal_id);
+    if (itr == m_adj_list.end()) return 0;
+    return itr->second.size();
   }
 
   vertex_iterator vertices_begin() {
@@ -363,47 +477,159 @@ class jgraph {
   }
 
   edge_iterator edges_begin(const id_type &vid) {
-    const auto internal_id = priv_get_vertex_internal_id(vid);
-    if (internal_id == k_max_internal_id) {
-      return edge_iterator();
-    }
-    return edge_iterator{m_adj_list.at(internal_id).begin(), &m_edge_storage};
+    return edges_begin(priv_get_vertex_internal_id(vid));
   }
 
   const_edge_iterator edges_begin(const id_type &vid) const {
-    const auto internal_id = priv_get_vertex_internal_id(vid);
-    if (internal_id == k_max_internal_id) {
-      return const_edge_iterator();
-    }
-    return const_edge_iterator{m_adj_list.at(internal_id).begin(),
-                               &m_edge_storage};
+    return edges_begin(priv_get_vertex_internal_id(vid));
   }
 
   edge_iterator edges_end(const id_type &vid) {
-    const auto internal_id = priv_get_vertex_internal_id(vid);
-    if (internal_id == k_max_internal_id) {
-      return edge_iterator();
-    }
-    return edge_iterator{m_adj_list.at(internal_id).end(), &m_edge_storage};
+    return edges_end(priv_get_vertex_internal_id(vid));
   }
 
   const_edge_iterator edges_end(const id_type &vid) const {
-    const auto internal_id = priv_get_vertex_internal_id(vid);
-    if (internal_id == k_max_internal_id) {
-      return const_edge_iterator();
+    return edges_end(priv_get_vertex_internal_id(vid));
+  }
+
+  /// \brief Returns an iterator to the first edge of a vertex.
+  /// \param internal_id An internal ID of a vertex.
+  /// \return Returns an iterator to the first edge of the vertex.
+  edge_iterator edges_begin(const internal_id_type internal_id) {
+    if (m_frozen) {
+      return edge_iterator{priv_frozen_edges_begin(internal_id),
+                           &m_edge_storage};
+    }
+    const auto itr = m_adj_list.find(internal_id);
+    if (itr == m_adj_list.end()) return edge_iterator();
+    return edge_iterator{itr->second.begin(), &m_edge_storage};
+  }
+
+  const_edge_iterator edges_begin(const internal_id_type internal_id) const {
+    if (m_frozen) {
+      return const_edge_iterator{priv_frozen_edges_begin(internal_id),
+                                 &m_edge_storage};
     }
-    return const_edge_iterator{m_adj_list.at(internal_id).end(),
-                               &m_edge_storage};
+    const auto itr = m_adj_list.find(internal_id);
+    if (itr == m_adj_list.end()) return const_edge_iterator();
+    return const_edge_iterator{itr->second.begin(), &m_edge_storage};
   }
 
+  /// \brief Returns an iterator to the element following the last edge of a
+  /// vertex.
+  /// \param internal_id An internal ID of a vertex.
+  /// \return Returns an iterator to the end of the edges of the vertex.
+  edge_iterator edges_end(const internal_id_type internal_id) {
+    if (m_frozen) {
+      return edge_iterator{priv_frozen_edges_end(internal_id),
+                           &m_edge_storage};
+    }
+    const auto itr = m_adj_list.find(internal_id);
+    if (itr == m_adj_list.end()) return edge_iterator();
+    return edge_iterator{itr->second.end(), &m_edge_storage};
+  }
+
+  const_edge_iterator edges_end(const internal_id_type internal_id) const {
+    if (m_frozen) {
+      return const_edge_iterator{priv_frozen_edges_end(internal_id),
+                                 &m_edge_storage};
+    }
+    const auto itr = m_adj_list.find(internal_id);
+    if (itr == m_adj_list.end()) return const_edge_iterator();
+    return const_edge_iterator{itr->second.end(), &m_edge_storage};
+  }
+
+  /// \brief Converts the topology into a read-optimized compressed sparse
+  /// row (CSR) layout.
+  /// The edges of each vertex are placed contiguously, sorted by the
+  /// destination, and point to their edge data directly; thus, iterating
+  /// over edges does not look up the edge storage.
+  /// Vertex and edge values stay where they are and can still be modified.
+  /// Registering a new vertex or edge calls thaw() automatically.
+  /// The adjacency list is released while the graph is frozen.
+  void freeze() {
+    if (m_frozen) return;
+
+    m_frozen_vertex_ids.clear();
+    m_frozen_vertex_ids.reserve(m_adj_list.size());
+    for (const auto &item : m_adj_list) {
+      m_frozen_vertex_ids.push_back(item.first);
+    }
+    std::sort(m_frozen_vertex_ids.begin(), m_frozen_vertex_ids.end());
+
+    const auto num_vertices = m_frozen_vertex_ids.size();
+    m_frozen_offsets.assign(num_vertices + 1, 0);
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+      m_frozen_offsets[i + 1] =
+          m_frozen_offsets[i] + m_adj_list.at(m_frozen_vertex_ids[i]).size();
+    }
+
+    // Each vertex's edges are placed by one thread; the hash tables are
+    // only read
+    m_frozen_edges.resize(m_frozen_offsets[num_vertices]);
+    priv_parallel_for(num_vertices, [this](const std::size_t i) {
+      auto *const first =
+          metall::to_raw_pointer(m_frozen_edges.data()) + m_frozen_offsets[i];
+      auto *pos = first;
+      for (const auto &item : m_adj_list.at(m_frozen_vertex_ids[i])) {
+        pos->neighbor = item.first;
+        pos->edge = &m_edge_storage.at(item.second);
+        ++pos;
+      }
+      std::stable_sort(first, pos,
+                       [](const frozen_edge_type &lhs,
+                          const frozen_edge_type &rhs) {
+                         return lhs.neighbor < rhs.neighbor;
+                       });
+    });
+
+    adj_list_type(m_adj_list.get_allocator()).swap(m_adj_list);
+    m_frozen = true;
+  }
+
+  /// \brief Converts the topology back into the modifiable layout.
+  /// Does nothing if the graph is not frozen.
+  void thaw() {
+    if (!m_frozen) return;
+
+    m_adj_list.reserve(m_frozen_vertex_ids.size());
+    for (std::size_t i = 0; i < m_frozen_vertex_ids.size(); ++i) {
+      auto &edge_list =
+          m_adj_list
+              .emplace(m_frozen_vertex_ids[i],
+                       adj_list_edge_list_type{m_adj_list.get_allocator()})
+              .first->second;
+      edge_list.reserve(m_frozen_offsets[i + 1] - m_frozen_offsets[i]);
+      for (auto j = m_frozen_offsets[i]; j < m_frozen_offsets[i + 1]; ++j) {
+        const auto &edge = m_frozen_edges[j];
+        edge_list.emplace(edge.neighbor, edge.edge->m_edge_id);
+      }
+    }
+
+    frozen_vector_type<internal_id_type>(m_frozen_vertex_ids.get_allocator())
+        .swap(m_frozen_vertex_ids);
+    frozen_vector_type<std::size_t>(m_frozen_offsets.get_allocator())
+        .swap(m_frozen_offsets);
+    frozen_vector_type<frozen_edge_type>(m_frozen_edges.get_allocator())
+        .swap(m_frozen_edges);
+    m_frozen = false;
+  }
+
+  /// \brief Checks if the graph is frozen by freeze().
+  /// \return Returns true if the graph is frozen; otherwise, false.
+  bool frozen() const { return m_frozen; }
+
   allocator_type get_allocator() const {
     return m_vertex_storage.get_allocator();
   }
 
  private:
+  template <typename graph_type>
+  friend class jgdtl::bulk_loader;
+
   internal_id_type priv_get_vertex_internal_id(
       const std::string_view &vid) const {
-    auto hash = priv_hash_id(vid.data());
+    auto hash = priv_hash_id(vid);
 
     for (std::size_t d = 0; d <= m_max_vid_distance; ++d) {
       const auto vitr = m_vertex_id_table.find(hash);
@@ -422,7 +648,7 @@ class jgraph {
 
   internal_id_type priv_generate_vertex_internal_id(
       const std::string_view &vid) {
-    auto hash = priv_hash_id(vid.data());
+    auto hash = priv_hash_id(vid);
 
     std::size_t distance = 0;
     while (m_vertex_id_table.count(hash) > 0) {
@@ -431,13 +657,74 @@ class jgraph {
     }
     m_max_vid_distance = std::max(distance, m_max_vid_distance);
 
-    m_vertex_id_table[hash] = vid.data();
+    m_vertex_id_table[hash].assign(vid.data(), vid.size());
 
     return hash;
   }
 
   internal_id_type priv_generate_edge_id() { return ++m_max_edge_id; }
 
+  /// \brief Returns the index of a vertex in the CSR.
+  /// Returns k_max_internal_id if the vertex does not exist.
+  std::size_t priv_frozen_vertex_index(const internal_id_type vid) const {
+    const auto itr = std::lower_bound(m_frozen_vertex_ids.begin(),
+                                      m_frozen_vertex_ids.end(), vid);
+    if (itr == m_frozen_vertex_ids.end() || *itr != vid) {
+      return k_max_internal_id;
+    }
+    return itr - m_frozen_vertex_ids.begin();
+  }
+
+  /// \brief Returns nullptr if the vertex does not exist, which is the same
+  /// as the default-constructed edge iterator.
+  const frozen_edge_type *priv_frozen_edges_begin(
+      const internal_id_type vid) const {
+    const auto index = priv_frozen_vertex_index(vid);
+    if (index == k_max_internal_id) return nullptr;
+    return metall::to_raw_pointer(m_frozen_edges.data()) +
+           m_frozen_offsets[index];
+  }
+
+  const frozen_edge_type *priv_frozen_edges_end(
+      const internal_id_type vid) const {
+    const auto index = priv_frozen_vertex_index(vid);
+    if (index == k_max_internal_id) return nullptr;
+    return metall::to_raw_pointer(m_frozen_edges.data()) +
+           m_frozen_offsets[index + 1];
+  }
+
+  std::pair<const frozen_edge_type *, const frozen_edge_type *>
+  priv_frozen_equal_range(const internal_id_type src,
+                          const internal_id_type dst) const {
+    return std::equal_range(
+        priv_frozen_edges_begin(src), priv_frozen_edges_end(src),
+        frozen_edge_type{dst, nullptr},
+        [](const frozen_edge_type &lhs, const frozen_edge_type &rhs) {
+          return lhs.neighbor < rhs.neighbor;
+        });
+  }
+
+  /// \brief Calls 'func' with each of [0, n) using the hardware threads.
+  template <typename function_type>
+  static void priv_parallel_for(const std::size_t n,
+                                const function_type &func) {
+    const std::size_t num_threads = std::min(
+        n, std::max(std::size_t(1),
+                    (std::size_t)std::thread::hardware_concurrency()));
+    const auto process = [&func, n, num_threads](const std::size_t t) {
+      for (std::size_t i = n * t / num_threads;
+           i < n * (t + 1) / num_threads; ++i) {
+        func(i);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < num_threads; ++t) {
+      threads.emplace_back(process, t);
+    }
+    if (num_threads > 0) process(0);
+    for (auto &th : threads) th.join();
+  }
+
   static internal_id_type priv_hash_id(const std::string_view &id) {
     return metall::mtlldetail::murmur_hash_64a(id.data(), id.length(), 1234);
   }
@@ -448,6 +735,11 @@ class jgraph {
   id_table_type m_vertex_id_table;
   internal_id_type m_max_edge_id{0};
   std::size_t m_max_vid_distance{0};
+  // Sorted hashed vids, their offsets to the edges, and the edges
+  frozen_vector_type<internal_id_type> m_frozen_vertex_ids;
+  frozen_vector_type<std::size_t> m_frozen_offsets;
+  frozen_vector_type<frozen_edge_type> m_frozen_edges;
+  bool m_frozen{false};
 };
 
 namespace jgdtl {
@@ -471,6 +763,7 @@ class vertex_iterator_impl {
   using reference = value_type &;
   using difference_type =
       typename std::iterator_traits<storage_iterator_type>::difference_type;
+  using iterator_category = std::forward_iterator_tag;
 
   explicit vertex_iterator_impl(storage_iterator_type begin_pos)
       : m_current_pos(begin_pos) {}
@@ -496,6 +789,9 @@ class vertex_iterator_impl {
     return m_current_pos == other.m_current_pos;
   }
 
+  /// \brief Returns the internal ID of the vertex.
+  auto internal_id() const { return m_current_pos->first; }
+
   pointer operator->() { return const_cast<pointer>(&(m_current_pos->second)); }
 
   const pointer operator->() const { return &(m_current_pos->second); }
@@ -520,8 +816,10 @@ inline bool operator!=(const vertex_iterator_impl<storage_iterator_type> &lhs,
   return !(lhs == rhs);
 }
 
+/// \brief Edge iterator over an adjacency list or, if the graph is frozen,
+/// over the CSR edges.
 template <typename adj_list_edge_list_iterator_type,
-          typename storage_pointer_type>
+          typename storage_pointer_type, typename frozen_edge_type>
 class edge_iterator_impl {
  private:
   static constexpr bool is_const_value = std::is_const_v<
@@ -540,6 +838,7 @@ class edge_iterator_impl {
   using reference = value_type &;
   using difference_type = typename std::iterator_traits<
       adj_list_edge_list_iterator_type>::difference_type;
+  using iterator_category = std::forward_iterator_tag;
 
   edge_iterator_impl() : m_current_pos(), m_storage_pointer(nullptr) {}
 
@@ -547,6 +846,12 @@ class edge_iterator_impl {
                      storage_pointer_type storage)
       : m_current_pos(begin_pos), m_storage_pointer(storage) {}
 
+  edge_iterator_impl(const frozen_edge_type *begin_pos,
+                     storage_pointer_type storage)
+      : m_current_pos(),
+        m_frozen_pos(begin_pos),
+        m_storage_pointer(storage) {}
+
   edge_iterator_impl(const edge_iterator_impl &) = default;
   edge_iterator_impl(edge_iterator_impl &&) noexcept = default;
 
@@ -554,7 +859,11 @@ class edge_iterator_impl {
   edge_iterator_impl &operator=(edge_iterator_impl &&) noexcept = default;
 
   edge_iterator_impl &operator++() {
-    ++m_current_pos;
+    if (m_frozen_pos) {
+      ++m_frozen_pos;
+    } else {
+      ++m_current_pos;
+    }
     return *this;
   }
 
@@ -565,51 +874,54 @@ class edge_iterator_impl {
   }
 
   bool equal(const edge_iterator_impl &other) const {
-    return m_current_pos == other.m_current_pos;
+    return m_current_pos == other.m_current_pos &&
+           m_frozen_pos == other.m_frozen_pos;
   }
 
-  pointer operator->() {
-    const auto &edge_id = m_current_pos->second;
-    return &(m_storage_pointer->at(edge_id));
+  /// \brief Returns the internal ID of the vertex at the other end of the
+  /// edge, i.e., the destination vertex or, for an undirected edge found
+  /// from the destination vertex, the source vertex.
+  auto neighbor_internal_id() const {
+    return m_frozen_pos ? m_frozen_pos->neighbor : m_current_pos->first;
   }
 
-  const pointer operator->() const {
-    const auto &edge_id = m_current_pos->second;
-    return &(m_storage_pointer->at(edge_id));
-  }
+  pointer operator->() { return &(priv_edge()); }
 
-  reference operator*() {
-    const auto &edge_id = m_current_pos->second;
-    return (m_storage_pointer->at(edge_id));
-  }
+  const pointer operator->() const { return &(priv_edge()); }
+
+  reference operator*() { return priv_edge(); }
 
-  const reference operator*() const {
+  const reference operator*() const { return priv_edge(); }
+
+ private:
+  reference priv_edge() const {
+    if (m_frozen_pos) return *(m_frozen_pos->edge);
     const auto &edge_id = m_current_pos->second;
     return (m_storage_pointer->at(edge_id));
   }
 
- private:
   adj_list_edge_list_iterator_type m_current_pos;
+  const frozen_edge_type *m_frozen_pos{nullptr};
   storage_pointer_type m_storage_pointer;
 };
 
 template <typename adj_list_edge_list_iterator_type,
-          typename storage_pointer_type>
+          typename storage_pointer_type, typename frozen_edge_type>
 inline bool operator==(
     const edge_iterator_impl<adj_list_edge_list_iterator_type,
-                             storage_pointer_type> &lhs,
+                             storage_pointer_type, frozen_edge_type> &lhs,
     const edge_iterator_impl<adj_list_edge_list_iterator_type,
-                             storage_pointer_type> &rhs) {
+                             storage_pointer_type, frozen_edge_type> &rhs) {
   return lhs.equal(rhs);
 }
 
 template <typename adj_list_edge_list_iterator_type,
-          typename storage_pointer_type>
+          typename storage_pointer_type, typename frozen_edge_type>
 inline bool operator!=(
     const edge_iterator_impl<adj_list_edge_list_iterator_type,
-                             storage_pointer_type> &lhs,
+                             storage_pointer_type, frozen_edge_type> &lhs,
     const edge_iterator_impl<adj_list_edge_list_iterator_type,
-                             storage_pointer_type> &rhs) {
+                             storage_pointer_type, frozen_edge_type> &rhs) {
   return !(lhs == rhs);
 }
 
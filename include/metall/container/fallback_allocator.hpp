@@ -8,26 +8,90 @@
 
 #include <memory>
 #include <cstdlib>
+#include <limits>
 #include <type_traits>
 
 namespace metall::container {
 
+/// \namespace metall::container::fallback_policy
+/// \brief Policies of fallback_allocator_adaptor, which determine when an
+/// allocator uses the stateful allocator or the heap allocator.
+namespace fallback_policy {
+/// \brief Decides at each operation: uses the stateful allocator if the
+/// allocator was constructed with one; otherwise, the heap allocator.
+struct dynamic {};
+
+/// \brief Always uses the stateful allocator, without the check.
+/// The allocator is not default constructible.
+struct stateful {};
+
+/// \brief Always uses the heap allocator, without the check.
+/// The allocator is only default constructible and holds no state.
+struct heap {};
+}  // namespace fallback_policy
+
+namespace fbadtl {
+struct no_state {};
+
+template <typename stateful_allocator_type, bool has_state>
+struct stateful_allocator_holder {
+  template <typename allocator_type>
+  explicit stateful_allocator_holder(allocator_type &&allocator) noexcept
+      : m_stateful_allocator(std::forward<allocator_type>(allocator)) {}
+
+  stateful_allocator_type m_stateful_allocator;
+};
+
+/// \brief An empty holder so that an allocator that always uses the heap
+/// allocator is empty.
+template <typename stateful_allocator_type>
+struct stateful_allocator_holder<stateful_allocator_type, false> {
+  explicit stateful_allocator_holder(no_state) noexcept {}
+};
+}  // namespace fbadtl
+
 /// \brief A Metall STL compatible allocator which fallbacks to a heap allocator
 /// (e.g., malloc()) if its constructor receives no argument to construct the
 /// stateful allocator (Metall's normal STL compatible allocator) instance.
+/// With fallback_policy::dynamic (the default), the allocator checks which
+/// allocator to use at each operation. The other policies resolve the choice
+/// at compile time, e.g., for the same container code used for persistent
+/// data and temporary data in tight loops; see
+/// static_fallback_allocator_adaptor.
 /// \tparam StatefulAllocator The stateful allocator type. It must not be
 /// default constructible.
-template <typename StatefulAllocator>
-class fallback_allocator_adaptor {
+/// \tparam Policy One of the types in fallback_policy.
+template <typename StatefulAllocator,
+          typename Policy = fallback_policy::dynamic>
+class fallback_allocator_adaptor
+    : private fbadtl::stateful_allocator_holder<
+          std::remove_const_t<std::remove_reference_t<StatefulAllocator>>,
+          !std::is_same_v<Policy, fallback_policy::heap>> {
   // Check if the StatefulAllocator takes arguments in its constructor
   static_assert(!std::is_constructible<StatefulAllocator>::value,
                 "The stateful allocator must not be default constructible");
+  static_assert(std::is_same_v<Policy, fallback_policy::dynamic> ||
+                    std::is_same_v<Policy, fallback_policy::stateful> ||
+                    std::is_same_v<Policy, fallback_policy::heap>,
+                "Unknown fallback policy");
 
  private:
   template <typename T>
   using other_stateful_allocator_type = typename std::allocator_traits<
       StatefulAllocator>::template rebind_alloc<T>;
 
+  static constexpr bool k_dynamic =
+      std::is_same_v<Policy, fallback_policy::dynamic>;
+  static constexpr bool k_has_state =
+      !std::is_same_v<Policy, fallback_policy::heap>;
+
+  using holder_type = fbadtl::stateful_allocator_holder<
+      std::remove_const_t<std::remove_reference_t<StatefulAllocator>>,
+      k_has_state>;
+
+  template <typename, typename>
+  friend class fallback_allocator_adaptor;
+
  public:
   // -------------------- //
   // Public types and static values
@@ -43,11 +107,13 @@ class fallback_allocator_adaptor {
       typename stateful_allocator_type::const_void_pointer;
   using difference_type = typename stateful_allocator_type::difference_type;
   using size_type = typename stateful_allocator_type::size_type;
+  using policy_type = Policy;
 
   /// \brief Makes another allocator type for type T2
   template <typename T2>
   struct rebind {
-    using other = fallback_allocator_adaptor<other_stateful_allocator_type<T2>>;
+    using other =
+        fallback_allocator_adaptor<other_stateful_allocator_type<T2>, Policy>;
   };
 
  public:
@@ -56,8 +122,12 @@ class fallback_allocator_adaptor {
   // -------------------- //
 
   /// \brief Default constructor which falls back on the regular allocator
-  /// (i.e., malloc()).
-  fallback_allocator_adaptor() noexcept : m_stateful_allocator(nullptr) {}
+  /// (i.e., malloc()). Not available with fallback_policy::stateful.
+  template <typename policy_type2 = Policy,
+            std::enable_if_t<
+                !std::is_same_v<policy_type2, fallback_policy::stateful>,
+                int> = 0>
+  fallback_allocator_adaptor() noexcept : holder_type(priv_null_state()) {}
 
   /// \brief Construct a new instance using an instance of
   /// fallback_allocator_adaptor with any stateful_allocator type.
@@ -67,20 +137,21 @@ class fallback_allocator_adaptor {
                                              stateful_allocator_type2>::value,
                        int> = 0>
   fallback_allocator_adaptor(
-      fallback_allocator_adaptor<stateful_allocator_type2>
+      fallback_allocator_adaptor<stateful_allocator_type2, Policy>
           allocator_instance) noexcept
-      : m_stateful_allocator(allocator_instance.get_stateful_allocator()) {}
+      : holder_type(priv_state_of(allocator_instance)) {}
 
   /// \brief Construct a new instance using an instance of any
-  /// stateful_allocator.
+  /// stateful_allocator. Not available with fallback_policy::heap.
   template <
       typename stateful_allocator_type2,
       std::enable_if_t<std::is_constructible<stateful_allocator_type,
-                                             stateful_allocator_type2>::value,
+                                             stateful_allocator_type2>::value &&
+                           k_has_state,
                        int> = 0>
   fallback_allocator_adaptor(
       stateful_allocator_type2 allocator_instance) noexcept
-      : m_stateful_allocator(allocator_instance) {}
+      : holder_type(stateful_allocator_type(allocator_instance)) {}
 
   /// \brief Copy constructor
   fallback_allocator_adaptor(const fallback_allocator_adaptor &other) noexcept =
@@ -102,9 +173,11 @@ class fallback_allocator_adaptor {
                                              stateful_allocator_type2>::value,
                        int> = 0>
   fallback_allocator_adaptor &operator=(
-      const fallback_allocator_adaptor<stateful_allocator_type2>
+      const fallback_allocator_adaptor<stateful_allocator_type2, Policy>
           &other) noexcept {
-    m_stateful_allocator = other.stateful_allocator();
+    if constexpr (k_has_state) {
+      this->m_stateful_allocator = other.m_stateful_allocator;
+    }
     return *this;
   }
 
@@ -112,11 +185,12 @@ class fallback_allocator_adaptor {
   template <
       typename stateful_allocator_type2,
       std::enable_if_t<std::is_constructible<stateful_allocator_type,
-                                             stateful_allocator_type2>::value,
+                                             stateful_allocator_type2>::value &&
+                           k_has_state,
                        int> = 0>
   fallback_allocator_adaptor &operator=(
       const stateful_allocator_type2 &allocator_instance) noexcept {
-    m_stateful_allocator = allocator_instance;
+    this->m_stateful_allocator = allocator_instance;
     return *this;
   }
 
@@ -132,8 +206,11 @@ class fallback_allocator_adaptor {
                                              stateful_allocator_type2>::value,
                        int> = 0>
   fallback_allocator_adaptor &operator=(
-      fallback_allocator_adaptor<stateful_allocator_type2> &&other) noexcept {
-    m_stateful_allocator = std::move(other.stateful_allocator());
+      fallback_allocator_adaptor<stateful_allocator_type2, Policy>
+          &&other) noexcept {
+    if constexpr (k_has_state) {
+      this->m_stateful_allocator = std::move(other.m_stateful_allocator);
+    }
     return *this;
   }
 
@@ -141,11 +218,12 @@ class fallback_allocator_adaptor {
   template <
       typename stateful_allocator_type2,
       std::enable_if_t<std::is_constructible<stateful_allocator_type,
-                                             stateful_allocator_type2>::value,
+                                             stateful_allocator_type2>::value &&
+                           k_has_state,
                        int> = 0>
   fallback_allocator_adaptor &operator=(
       stateful_allocator_type2 &&allocator_instance) noexcept {
-    m_stateful_allocator = std::move(allocator_instance);
+    this->m_stateful_allocator = std::move(allocator_instance);
     return *this;
   }
 
@@ -153,8 +231,10 @@ class fallback_allocator_adaptor {
   /// \param n The size to allocation
   /// \return Returns a pointer
   pointer allocate(const size_type n) const {
-    if (priv_stateful_allocator_available()) {
-      return m_stateful_allocator.allocate(n);
+    if constexpr (k_has_state) {
+      if (priv_use_stateful_allocator()) {
+        return this->m_stateful_allocator.allocate(n);
+      }
     }
     return priv_fallback_allocate(n);
   }
@@ -163,17 +243,23 @@ class fallback_allocator_adaptor {
   /// \param ptr A pointer to the storage
   /// \param size The size of the storage
   void deallocate(pointer ptr, const size_type size) const {
-    if (priv_stateful_allocator_available()) {
-      m_stateful_allocator.deallocate(ptr, size);
-    } else {
-      priv_fallback_deallocate(ptr);
+    if constexpr (k_has_state) {
+      if (priv_use_stateful_allocator()) {
+        this->m_stateful_allocator.deallocate(ptr, size);
+        return;
+      }
     }
+    priv_fallback_deallocate(ptr);
   }
 
   /// \brief The size of the theoretical maximum allocation size
   /// \return The size of the theoretical maximum allocation size
   size_type max_size() const noexcept {
-    return m_stateful_allocator.max_size();
+    if constexpr (k_has_state) {
+      return this->m_stateful_allocator.max_size();
+    } else {
+      return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    }
   }
 
   /// \brief Constructs an object of T
@@ -182,31 +268,41 @@ class fallback_allocator_adaptor {
   /// \param args The constructor arguments to use
   template <class... Args>
   void construct(const pointer &ptr, Args &&...args) const {
-    if (priv_stateful_allocator_available()) {
-      m_stateful_allocator.construct(ptr, std::forward<Args>(args)...);
-    } else {
-      priv_fallback_construct(ptr, std::forward<Args>(args)...);
+    if constexpr (k_has_state) {
+      if (priv_use_stateful_allocator()) {
+        this->m_stateful_allocator.construct(ptr, std::forward<Args>(args)...);
+        return;
+      }
     }
+    priv_fallback_construct(ptr, std::forward<Args>(args)...);
   }
 
   /// \brief Deconstruct an object of T
   /// \param ptr A pointer to the object
   void destroy(const pointer &ptr) const {
-    if (priv_stateful_allocator_available()) {
-      m_stateful_allocator.destroy(ptr);
-    } else {
-      priv_fallback_destroy(ptr);
+    if constexpr (k_has_state) {
+      if (priv_use_stateful_allocator()) {
+        this->m_stateful_allocator.destroy(ptr);
+        return;
+      }
     }
+    priv_fallback_destroy(ptr);
   }
 
   // ---------- This class's unique public functions ---------- //
 
   /// \brief Returns a reference to the stateful allocator.
-  stateful_allocator_type &get_stateful_allocator() { return m_stateful_allocator; }
+  /// Not available with fallback_policy::heap.
+  stateful_allocator_type &get_stateful_allocator() {
+    static_assert(k_has_state, "This allocator has no stateful allocator");
+    return this->m_stateful_allocator;
+  }
 
   /// \brief Returns a const reference to the stateful allocator.
+  /// Not available with fallback_policy::heap.
   const stateful_allocator_type &get_stateful_allocator() const {
-    return m_stateful_allocator;
+    static_assert(k_has_state, "This allocator has no stateful allocator");
+    return this->m_stateful_allocator;
   }
 
   /// \brief Returns true if the stateful allocator is available.
@@ -219,8 +315,39 @@ class fallback_allocator_adaptor {
   // -------------------- //
   // Private methods
   // -------------------- //
-  auto priv_stateful_allocator_available() const {
-    return !!(m_stateful_allocator.get_pointer_to_manager_kernel());
+  static auto priv_null_state() {
+    if constexpr (k_has_state) {
+      return stateful_allocator_type(nullptr);
+    } else {
+      return fbadtl::no_state{};
+    }
+  }
+
+  template <typename allocator_type2>
+  static auto priv_state_of(const allocator_type2 &allocator) {
+    if constexpr (k_has_state) {
+      return stateful_allocator_type(allocator.m_stateful_allocator);
+    } else {
+      return fbadtl::no_state{};
+    }
+  }
+
+  bool priv_stateful_allocator_available() const {
+    if constexpr (k_has_state) {
+      return !!(this->m_stateful_allocator.get_pointer_to_manager_kernel());
+    } else {
+      return false;
+    }
+  }
+
+  /// \brief Returns true if the operations go to the stateful allocator;
+  /// a constant except for fallback_policy::dynamic.
+  bool priv_use_stateful_allocator() const {
+    if constexpr (k_dynamic) {
+      return priv_stateful_allocator_available();
+    } else {
+      return k_has_state;
+    }
   }
 
   pointer priv_fallback_allocate(const size_type n) const {
@@ -248,27 +375,44 @@ class fallback_allocator_adaptor {
         value_type(std::forward<arg_types>(args)...);
   }
 
-  // -------------------- //
-  // Private fields
-  // -------------------- //
-  stateful_allocator_type m_stateful_allocator;
 };
 
-template <typename stateful_allocator_type>
+template <typename stateful_allocator_type, typename policy_type>
 inline bool operator==(
-    const fallback_allocator_adaptor<stateful_allocator_type> &rhd,
-    const fallback_allocator_adaptor<stateful_allocator_type> &lhd) {
-  // Return true if they point to the same manager kernel
-  return rhd.get_stateful_allocator() == lhd.get_stateful_allocator();
+    const fallback_allocator_adaptor<stateful_allocator_type, policy_type> &rhd,
+    const fallback_allocator_adaptor<stateful_allocator_type, policy_type>
+        &lhd) {
+  if constexpr (std::is_same_v<policy_type, fallback_policy::heap>) {
+    return true;
+  } else {
+    // Return true if they point to the same manager kernel
+    return rhd.get_stateful_allocator() == lhd.get_stateful_allocator();
+  }
 }
 
-template <typename stateful_allocator_type>
+template <typename stateful_allocator_type, typename policy_type>
 inline bool operator!=(
-    const fallback_allocator_adaptor<stateful_allocator_type> &rhd,
-    const fallback_allocator_adaptor<stateful_allocator_type> &lhd) {
+    const fallback_allocator_adaptor<stateful_allocator_type, policy_type> &rhd,
+    const fallback_allocator_adaptor<stateful_allocator_type, policy_type>
+        &lhd) {
   return !(rhd == lhd);
 }
 
+/// \brief A fallback_allocator_adaptor that uses the stateful allocator if
+/// 'use_stateful' is true; otherwise, the heap allocator, resolved at compile
+/// time, e.g., for a container template instantiated for persistent data
+/// and for temporary data.
+/// \code
+/// template <bool persistent>
+/// using vec_type = vector<int, static_fallback_allocator_adaptor<
+///                                  manager::allocator_type<int>, persistent>>;
+/// \endcode
+template <typename StatefulAllocator, bool use_stateful>
+using static_fallback_allocator_adaptor = fallback_allocator_adaptor<
+    StatefulAllocator,
+    std::conditional_t<use_stateful, fallback_policy::stateful,
+                       fallback_policy::heap>>;
+
 }  // namespace metall::container
 
 /// \example fallback_allocator.cpp
@@ -0,0 +1,544 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_FROZEN_MAP_HPP
+#define METALL_CONTAINER_FROZEN_MAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <metall/container/string_key_store.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/offset_ptr.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+namespace frzdtl {
+
+/// \brief A minimal perfect hash function of a fixed set of keys in the
+/// manner of PTHash: the keys are hashed into buckets, and the pilot of a
+/// bucket, the number found at construction, places all keys of the bucket
+/// into distinct free slots. A lookup reads a pilot; a slot beyond the
+/// number of keys is remapped to a free slot below it, which happens for a
+/// few keys.
+/// About 1.5 bytes per key with the default parameters.
+template <typename allocator_type>
+class mphf {
+ private:
+  template <typename T>
+  using vector_type = metall::container::vector<
+      T, typename std::allocator_traits<allocator_type>::template rebind_alloc<
+             T>>;
+
+  // The average number of keys in a bucket is k_bucket_factor / log2(n)
+  static constexpr double k_bucket_factor = 5.0;
+  // The number of keys per slot
+  static constexpr double k_load_factor = 0.97;
+  // 60% of the keys are hashed into 30% of the buckets
+  static constexpr uint64_t k_dense_key_ratio = (uint64_t(6) << 32ULL) / 10;
+  static constexpr double k_dense_bucket_ratio = 0.3;
+  static constexpr uint32_t k_max_pilot = 1U << 24U;
+  static constexpr int k_max_num_seeds = 16;
+
+ public:
+  explicit mphf(const allocator_type &allocator)
+      : m_pilots(allocator), m_remap(allocator) {}
+
+  mphf(const mphf &other, const allocator_type &allocator)
+      : m_seed(other.m_seed),
+        m_num_keys(other.m_num_keys),
+        m_table_size(other.m_table_size),
+        m_num_dense_buckets(other.m_num_dense_buckets),
+        m_pilots(other.m_pilots, allocator),
+        m_remap(other.m_remap, allocator) {}
+
+  /// \brief Builds a function of 'n' keys.
+  /// \param hash_keys Called as hash_keys(seed, &hashes) to store the
+  /// 64-bit hashes of the keys with a seed.
+  /// \param same_keys Called as same_keys(i, j) to check if the i-th and j-th
+  /// keys, whose hashes collide, are equal.
+  /// \param positions A pointer to store the position of each key.
+  /// \return Returns false if there are equal keys, or on the rare failure
+  /// to find the pilots with all seeds tried.
+  template <typename hash_function, typename equal_function>
+  bool build(const std::size_t n, hash_function &&hash_keys,
+             equal_function &&same_keys,
+             std::vector<uint64_t> *const positions) {
+    m_num_keys = n;
+    m_pilots.clear();
+    m_remap.clear();
+    positions->assign(n, 0);
+    if (n == 0) return true;
+
+    m_table_size = std::max(
+        n, static_cast<std::size_t>(std::ceil(double(n) / k_load_factor)));
+    const auto num_buckets = std::max<std::size_t>(
+        1, std::ceil(k_bucket_factor * double(n) / std::log2(double(n) + 1)));
+    m_num_dense_buckets = std::max<std::size_t>(
+        1, std::size_t(k_dense_bucket_ratio * double(num_buckets)));
+    m_num_dense_buckets = std::min(m_num_dense_buckets, num_buckets);
+
+    std::vector<uint64_t> hashes;
+    for (int s = 0; s < k_max_num_seeds; ++s) {
+      m_seed = priv_mix(uint64_t(s) + 0x9e3779b97f4a7c15ULL);
+      hashes.clear();
+      hash_keys(m_seed, &hashes);
+      bool duplicate = false;
+      if (priv_find_pilots(hashes, num_buckets, same_keys, &duplicate)) {
+        for (std::size_t i = 0; i < n; ++i) {
+          (*positions)[i] = position_of(hashes[i]);
+        }
+        return true;
+      }
+      if (duplicate) return false;
+    }
+    return false;
+  }
+
+  /// \brief Returns the seed to hash the keys with.
+  uint64_t seed() const { return m_seed; }
+
+  std::size_t size() const { return m_num_keys; }
+
+  /// \brief Returns the position of a key from its hash, which is less than
+  /// size(). Any position is returned for a key not in the set.
+  std::size_t position_of(const uint64_t hash) const {
+    const auto pilot = m_pilots[priv_bucket(hash, m_pilots.size())];
+    const auto slot = priv_slot(hash, pilot);
+    return (slot < m_num_keys) ? slot : m_remap[slot - m_num_keys];
+  }
+
+  /// \brief Returns the number of bytes of the function.
+  std::size_t memory_bytes() const {
+    return m_pilots.size() * sizeof(uint32_t) +
+           m_remap.size() * sizeof(uint64_t);
+  }
+
+ private:
+  std::size_t priv_bucket(const uint64_t hash,
+                          const std::size_t num_buckets) const {
+    const auto upper = hash >> 32U;
+    const auto fast_range = [upper](const std::size_t range) {
+      return std::size_t((upper * range) >> 32U);
+    };
+    if (m_num_dense_buckets == num_buckets) return fast_range(num_buckets);
+    if ((hash & 0xFFFFFFFFULL) < k_dense_key_ratio) {
+      return fast_range(m_num_dense_buckets);
+    }
+    return m_num_dense_buckets + fast_range(num_buckets - m_num_dense_buckets);
+  }
+
+  std::size_t priv_slot(const uint64_t hash, const uint32_t pilot) const {
+    return priv_mix(hash ^ priv_mix(uint64_t(pilot) + m_seed)) % m_table_size;
+  }
+
+  static uint64_t priv_mix(uint64_t hash) noexcept {
+    // The finalizer of MurmurHash3
+    hash ^= hash >> 33ULL;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33ULL;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33ULL;
+    return hash;
+  }
+
+  template <typename equal_function>
+  bool priv_find_pilots(const std::vector<uint64_t> &hashes,
+                        const std::size_t num_buckets,
+                        equal_function &same_keys, bool *const duplicate) {
+    // (bucket, hash, key index), grouped by bucket
+    std::vector<std::tuple<uint64_t, uint64_t, uint64_t>> keys(hashes.size());
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+      keys[i] = {priv_bucket(hashes[i], num_buckets), hashes[i], i};
+    }
+    std::sort(keys.begin(), keys.end());
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+      if (std::get<1>(keys[i - 1]) != std::get<1>(keys[i])) continue;
+      // The keys with the same hash cannot be placed apart
+      *duplicate = same_keys(std::get<2>(keys[i - 1]), std::get<2>(keys[i]));
+      return false;
+    }
+
+    // The buckets with more keys are placed first
+    std::vector<std::pair<std::size_t, std::size_t>> buckets;  // (begin, end)
+    for (std::size_t i = 0; i < keys.size();) {
+      auto j = i + 1;
+      while (j < keys.size() && std::get<0>(keys[j]) == std::get<0>(keys[i])) {
+        ++j;
+      }
+      buckets.emplace_back(i, j);
+      i = j;
+    }
+    std::stable_sort(buckets.begin(), buckets.end(),
+                     [](const auto &a, const auto &b) {
+                       return a.second - a.first > b.second - b.first;
+                     });
+
+    std::vector<uint32_t> pilots(num_buckets, 0);
+    std::vector<bool> taken(m_table_size, false);
+    std::vector<std::size_t> slots;
+    for (const auto &[begin, end] : buckets) {
+      bool placed = false;
+      for (uint32_t pilot = 0; pilot < k_max_pilot && !placed; ++pilot) {
+        slots.clear();
+        placed = true;
+        for (auto i = begin; i < end; ++i) {
+          const auto slot = priv_slot(std::get<1>(keys[i]), pilot);
+          if (taken[slot] ||
+              std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+            placed = false;
+            break;
+          }
+          slots.push_back(slot);
+        }
+        if (placed) {
+          for (const auto slot : slots) taken[slot] = true;
+          pilots[std::get<0>(keys[begin])] = pilot;
+        }
+      }
+      if (!placed) return false;
+    }
+
+    m_pilots.assign(pilots.begin(), pilots.end());
+    // The slots beyond the number of keys are remapped to the free ones
+    m_remap.assign(m_table_size - m_num_keys, 0);
+    std::size_t free_slot = 0;
+    for (auto slot = m_num_keys; slot < m_table_size; ++slot) {
+      if (!taken[slot]) continue;
+      while (taken[free_slot]) ++free_slot;
+      m_remap[slot - m_num_keys] = free_slot++;
+    }
+    return true;
+  }
+
+  uint64_t m_seed{0};
+  std::size_t m_num_keys{0};
+  std::size_t m_table_size{0};
+  std::size_t m_num_dense_buckets{0};
+  vector_type<uint32_t> m_pilots;
+  vector_type<uint64_t> m_remap;
+};
+
+}  // namespace frzdtl
+
+/// \brief An immutable map of trivially copyable keys, built at once from
+/// the items of another map (freeze()), e.g., a std::unordered_map or
+/// metall::container::unordered_map.
+/// The items are stored contiguously in a vector, without empty slots, at
+/// the positions given by a minimal perfect hash function; a lookup reads
+/// the pilot of the key's bucket and then the item, i.e., costs about two
+/// cache misses. As lookups do not write, a map in a datastore opened in
+/// the read-only mode can be read by many threads.
+/// \tparam _key_type A trivially copyable key type without padding bytes,
+/// which are hashed.
+/// \tparam _mapped_type A mapped type.
+/// \tparam allocator_type An allocator type.
+template <typename _key_type, typename _mapped_type,
+          typename allocator_type = std::allocator<std::byte>>
+class frozen_map {
+  static_assert(std::is_trivially_copyable_v<_key_type>,
+                "The key type must be trivially copyable");
+
+ public:
+  using key_type = _key_type;
+  using mapped_type = _mapped_type;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_iterator = const value_type *;
+
+ private:
+  using item_vector_type = metall::container::vector<
+      value_type, typename std::allocator_traits<
+                      allocator_type>::template rebind_alloc<value_type>>;
+
+ public:
+  /// \brief Constructor. Constructs an empty map.
+  explicit frozen_map(const allocator_type &allocator = allocator_type())
+      : m_mphf(allocator), m_items(allocator) {}
+
+  /// \brief Constructs a map of the items in [first, last).
+  /// \throw std::invalid_argument if there are equal keys.
+  template <typename input_iterator>
+  frozen_map(const input_iterator first, const input_iterator last,
+             const allocator_type &allocator = allocator_type())
+      : frozen_map(allocator) {
+    if (!freeze(first, last)) {
+      throw std::invalid_argument("Failed to freeze items");
+    }
+  }
+
+  /// \brief Allocator-extended copy constructor.
+  frozen_map(const frozen_map &other, const allocator_type &allocator)
+      : m_mphf(other.m_mphf, allocator), m_items(other.m_items, allocator) {}
+
+  /// \brief Replaces the items with the (key, value) pairs in [first, last),
+  /// e.g., the items of a map.
+  /// \return Returns false if there are equal keys; the map is empty then.
+  template <typename input_iterator>
+  bool freeze(const input_iterator first, const input_iterator last) {
+    std::vector<value_type> items;
+    for (auto itr = first; itr != last; ++itr) {
+      items.emplace_back(itr->first, itr->second);
+    }
+
+    m_items.clear();
+    std::vector<uint64_t> positions;
+    const bool built = m_mphf.build(
+        items.size(),
+        [&items](const uint64_t seed, std::vector<uint64_t> *const hashes) {
+          for (const auto &item : items) {
+            hashes->push_back(priv_hash(item.first, seed));
+          }
+        },
+        [&items](const std::size_t i, const std::size_t j) {
+          return items[i].first == items[j].first;
+        },
+        &positions);
+    if (!built) {
+      m_mphf.build(
+          0, [](auto, auto) {}, [](auto, auto) { return false; }, &positions);
+      return false;
+    }
+
+    std::vector<std::size_t> order(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) order[positions[i]] = i;
+    m_items.reserve(items.size());
+    for (const auto i : order) m_items.push_back(std::move(items[i]));
+    return true;
+  }
+
+  /// \brief Finds an item.
+  /// \return Returns a pointer to the item or nullptr if not found.
+  const value_type *find(const key_type &key) const {
+    if (m_items.empty()) return nullptr;
+    const auto &item =
+        m_items[m_mphf.position_of(priv_hash(key, m_mphf.seed()))];
+    return (item.first == key) ? &item : nullptr;
+  }
+
+  bool contains(const key_type &key) const { return find(key) != nullptr; }
+
+  size_type count(const key_type &key) const { return contains(key); }
+
+  /// \brief Returns the value of a key.
+  /// \throw std::out_of_range if not found.
+  const mapped_type &at(const key_type &key) const {
+    const auto *const item = find(key);
+    if (!item) throw std::out_of_range("frozen_map::at");
+    return item->second;
+  }
+
+  size_type size() const { return m_items.size(); }
+  bool empty() const { return m_items.empty(); }
+
+  /// \brief Iterates the items, in no particular order.
+  const_iterator begin() const {
+    return metall::to_raw_pointer(m_items.data());
+  }
+  const_iterator end() const { return begin() + m_items.size(); }
+
+  /// \brief Returns the number of bytes of the items and the hash function.
+  size_type memory_bytes() const {
+    return m_items.size() * sizeof(value_type) + m_mphf.memory_bytes();
+  }
+
+ private:
+  static uint64_t priv_hash(const key_type &key, const uint64_t seed) {
+    return mdtl::wyhash_64(&key, sizeof(key_type), seed);
+  }
+
+  frzdtl::mphf<allocator_type> m_mphf;
+  item_vector_type m_items;
+};
+
+/// \brief An immutable map of string keys, built at once from the items of
+/// another map (freeze()), e.g., a string_key_store or a std::map of
+/// std::string keys.
+/// The items are stored contiguously, at the positions given by a minimal
+/// perfect hash function, with the keys of up to 12 bytes in them and the
+/// longer keys in a key arena; thus, a lookup of a short key costs about two
+/// cache misses. As lookups do not write, a map in a datastore opened in the
+/// read-only mode can be read by many threads.
+/// \tparam _mapped_type A mapped type.
+/// \tparam allocator_type An allocator type.
+template <typename _mapped_type,
+          typename allocator_type = std::allocator<std::byte>>
+class frozen_string_map {
+ public:
+  using key_type = std::string_view;
+  using mapped_type = _mapped_type;
+  using size_type = std::size_t;
+
+ private:
+  template <typename T>
+  using vector_type = metall::container::vector<
+      T, typename std::allocator_traits<allocator_type>::template rebind_alloc<
+             T>>;
+
+  /// Holds a key in place or the position of a key in the key arena.
+  struct internal_key_type {
+    uint32_t length{0};
+    char data[12];
+  };
+  static constexpr std::size_t k_max_inline_key_length =
+      sizeof(internal_key_type::data);
+
+  struct item_type {
+    internal_key_type key;
+    mapped_type value;
+  };
+
+ public:
+  /// \brief Constructor. Constructs an empty map.
+  explicit frozen_string_map(const allocator_type &allocator = allocator_type())
+      : m_mphf(allocator), m_items(allocator), m_key_arena(allocator) {}
+
+  /// \brief Allocator-extended copy constructor.
+  frozen_string_map(const frozen_string_map &other,
+                    const allocator_type &allocator)
+      : m_mphf(other.m_mphf, allocator),
+        m_items(other.m_items, allocator),
+        m_key_arena(other.m_key_arena, allocator) {}
+
+  /// \brief Replaces the items with the (key, value) pairs in [first, last),
+  /// whose keys are convertible to std::string_view.
+  /// \return Returns false if there are equal keys; the map is empty then.
+  template <typename input_iterator>
+  bool freeze(const input_iterator first, const input_iterator last) {
+    std::vector<std::pair<key_type, mapped_type>> items;
+    for (auto itr = first; itr != last; ++itr) {
+      items.emplace_back(key_type(itr->first), itr->second);
+    }
+    return priv_freeze(items);
+  }
+
+  /// \brief Replaces the items with the ones of a string_key_store.
+  /// \return Returns false if the store has equal keys; the map is empty
+  /// then.
+  template <typename store_allocator_type>
+  bool freeze(
+      const string_key_store<mapped_type, store_allocator_type> &store) {
+    std::vector<std::pair<key_type, mapped_type>> items;
+    for (auto loc = store.begin(); loc != store.end(); ++loc) {
+      items.emplace_back(store.key(loc), store.value(loc));
+    }
+    return priv_freeze(items);
+  }
+
+  /// \brief Finds the value of a key.
+  /// \return Returns a pointer to the value or nullptr if not found.
+  const mapped_type *find(const key_type &key) const {
+    if (m_items.empty()) return nullptr;
+    const auto &item =
+        m_items[m_mphf.position_of(priv_hash(key, m_mphf.seed()))];
+    return (priv_key(item.key) == key) ? &item.value : nullptr;
+  }
+
+  bool contains(const key_type &key) const { return find(key) != nullptr; }
+
+  size_type count(const key_type &key) const { return contains(key); }
+
+  /// \brief Returns the value of a key.
+  /// \throw std::out_of_range if not found.
+  const mapped_type &at(const key_type &key) const {
+    const auto *const value = find(key);
+    if (!value) throw std::out_of_range("frozen_string_map::at");
+    return *value;
+  }
+
+  size_type size() const { return m_items.size(); }
+  bool empty() const { return m_items.empty(); }
+
+  /// \brief Calls f(key, value) for each item, in no particular order.
+  template <typename function_type>
+  void for_each(function_type &&f) const {
+    for (const auto &item : m_items) f(priv_key(item.key), item.value);
+  }
+
+  /// \brief Returns the number of bytes of the items, the keys, and the hash
+  /// function.
+  size_type memory_bytes() const {
+    return m_items.size() * sizeof(item_type) + m_key_arena.size() +
+           m_mphf.memory_bytes();
+  }
+
+ private:
+  static uint64_t priv_hash(const key_type &key, const uint64_t seed) {
+    return mdtl::wyhash_64(key.data(), key.length(), seed);
+  }
+
+  key_type priv_key(const internal_key_type &key) const {
+    if (key.length <= k_max_inline_key_length) {
+      return key_type(key.data, key.length);
+    }
+    uint64_t offset;
+    std::memcpy(&offset, key.data, sizeof(offset));
+    return key_type(metall::to_raw_pointer(m_key_arena.data()) + offset,
+                    key.length);
+  }
+
+  bool priv_freeze(const std::vector<std::pair<key_type, mapped_type>> &items) {
+    m_items.clear();
+    m_key_arena.clear();
+    std::vector<uint64_t> positions;
+    const bool built = m_mphf.build(
+        items.size(),
+        [&items](const uint64_t seed, std::vector<uint64_t> *const hashes) {
+          for (const auto &item : items) {
+            hashes->push_back(priv_hash(item.first, seed));
+          }
+        },
+        [&items](const std::size_t i, const std::size_t j) {
+          return items[i].first == items[j].first;
+        },
+        &positions);
+    if (!built) {
+      m_mphf.build(
+          0, [](auto, auto) {}, [](auto, auto) { return false; }, &positions);
+      return false;
+    }
+
+    std::vector<std::size_t> order(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) order[positions[i]] = i;
+    m_items.reserve(items.size());
+    for (const auto i : order) {
+      const auto &[key, value] = items[i];
+      internal_key_type internal_key;
+      internal_key.length = key.length();
+      if (key.length() <= k_max_inline_key_length) {
+        std::memcpy(internal_key.data, key.data(), key.length());
+      } else {
+        const uint64_t offset = m_key_arena.size();
+        std::memcpy(internal_key.data, &offset, sizeof(offset));
+        m_key_arena.insert(m_key_arena.end(), key.begin(), key.end());
+      }
+      m_items.push_back(item_type{internal_key, value});
+    }
+    return true;
+  }
+
+  frzdtl::mphf<allocator_type> m_mphf;
+  vector_type<item_type> m_items;
+  vector_type<char> m_key_arena;
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_FROZEN_MAP_HPP
@@ -0,0 +1,443 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_JAGGED_VECTOR_HPP
+#define METALL_CONTAINER_JAGGED_VECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <boost/container/vector.hpp>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/utility/container_of_containers_iterator_adaptor.hpp>
+
+namespace metall::container {
+
+/// \brief A compact vector of vectors (jagged array) which can be stored in
+/// persistent memory.
+/// Unlike vector<vector<T>>, all rows share one pool of elements; a row is a
+/// range in the pool and costs only an entry in the flat row index.
+/// A row that runs out of its capacity is moved to the end of the pool with
+/// doubled capacity. The space left behind is reclaimed by compacting the
+/// pool, which happens automatically when it exceeds the live capacity.
+/// Adding elements to a row may invalidate pointers and references to
+/// the elements of all rows.
+/// \tparam _value_type An element type. Must be default constructible.
+/// \tparam _allocator_type An allocator type.
+/// \tparam _row_size_type An unsigned integer type for the size of a row.
+template <typename _value_type,
+          typename _allocator_type = std::allocator<_value_type>,
+          typename _row_size_type = uint32_t>
+class jagged_vector {
+  static_assert(std::is_unsigned_v<_row_size_type>,
+                "Row size type must be unsigned");
+
+ public:
+  using value_type = _value_type;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+  using row_size_type = _row_size_type;
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+
+  struct row_type {
+    uint64_t offset{0};
+    row_size_type size{0};
+    row_size_type capacity{0};
+  };
+
+  using pool_type =
+      boost::container::vector<value_type, other_allocator_type<value_type>>;
+  using row_table_type =
+      boost::container::vector<row_type, other_allocator_type<row_type>>;
+
+  // Does not compact the pool while it is small
+  static constexpr size_type k_min_compaction_size = 1024;
+
+  template <typename pointer_type>
+  class basic_row_view;
+
+  template <typename jagged_vector_pointer, typename row_view_type>
+  class row_iterator;
+
+ public:
+  /// \brief A view of a row. Works like a span.
+  using row_view = basic_row_view<value_type *>;
+  /// \brief A const view of a row.
+  using const_row_view = basic_row_view<const value_type *>;
+
+  /// \brief A random access iterator over the rows; dereferences to a row
+  /// view.
+  using iterator = row_iterator<jagged_vector *, row_view>;
+  /// \brief A const random access iterator over the rows.
+  using const_iterator = row_iterator<const jagged_vector *, const_row_view>;
+
+  /// \brief An iterator that visits all elements of all rows in order.
+  using flat_iterator =
+      metall::utility::container_of_containers_iterator_adaptor<iterator,
+                                                                value_type *>;
+  /// \brief A const iterator that visits all elements of all rows in order.
+  using const_flat_iterator =
+      metall::utility::container_of_containers_iterator_adaptor<
+          const_iterator, const value_type *>;
+
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit jagged_vector(const allocator_type &allocator = allocator_type())
+      : m_pool(allocator), m_rows(allocator), m_garbage_size(0) {}
+
+  /// \brief Constructor.
+  /// \param num_rows The number of empty rows to create.
+  /// \param allocator An allocator object.
+  explicit jagged_vector(const size_type num_rows,
+                         const allocator_type &allocator = allocator_type())
+      : m_pool(allocator), m_rows(num_rows, allocator), m_garbage_size(0) {}
+
+  // ---------- Rows ---------- //
+  /// \brief Returns the number of rows.
+  size_type size() const { return m_rows.size(); }
+
+  /// \brief Checks if there is no row.
+  bool empty() const { return m_rows.empty(); }
+
+  /// \brief Changes the number of rows.
+  /// New rows are empty. The elements of removed rows are left in the pool
+  /// until compaction.
+  void resize(const size_type num_rows) {
+    for (size_type i = num_rows; i < m_rows.size(); ++i) {
+      m_garbage_size += m_rows[i].capacity;
+    }
+    m_rows.resize(num_rows);
+    priv_compact_if_needed();
+  }
+
+  /// \brief Reserves the row index.
+  void reserve(const size_type num_rows) { m_rows.reserve(num_rows); }
+
+  /// \brief Reserves the pool for a total number of elements.
+  void reserve_elements(const size_type num_elements) {
+    m_pool.reserve(num_elements);
+  }
+
+  /// \brief Appends an empty row.
+  /// \return The index of the new row.
+  size_type add_row() {
+    m_rows.emplace_back();
+    return m_rows.size() - 1;
+  }
+
+  /// \brief Appends a row that has the elements in a range.
+  /// The new row is stored without extra capacity.
+  /// \return The index of the new row.
+  template <typename input_iterator>
+  size_type add_row(input_iterator first, input_iterator last) {
+    row_type row;
+    row.offset = m_pool.size();
+    for (; first != last; ++first) m_pool.emplace_back(*first);
+    assert(m_pool.size() - row.offset <=
+           std::numeric_limits<row_size_type>::max());
+    row.size = row.capacity = row_size_type(m_pool.size() - row.offset);
+    m_rows.push_back(row);
+    return m_rows.size() - 1;
+  }
+
+  /// \brief Returns a view of a row.
+  row_view operator[](const size_type row_no) {
+    const auto &row = m_rows[row_no];
+    return row_view(priv_data() + row.offset, row.size);
+  }
+
+  /// \brief Returns a const view of a row.
+  const_row_view operator[](const size_type row_no) const {
+    const auto &row = m_rows[row_no];
+    return const_row_view(priv_data() + row.offset, row.size);
+  }
+
+  /// \brief Returns the number of elements in a row.
+  size_type row_size(const size_type row_no) const {
+    return m_rows[row_no].size;
+  }
+
+  // ---------- Elements ---------- //
+  /// \brief Appends an element to a row.
+  void push_back(const size_type row_no, const value_type &value) {
+    emplace_back(row_no, value);
+  }
+
+  /// \brief Appends an element to a row.
+  void push_back(const size_type row_no, value_type &&value) {
+    emplace_back(row_no, std::move(value));
+  }
+
+  /// \brief Appends an element constructed from arguments to a row.
+  /// \return A reference to the new element.
+  template <typename... args_type>
+  value_type &emplace_back(const size_type row_no, args_type &&...args) {
+    // Construct first as the arguments may refer to an element in the pool
+    value_type value(std::forward<args_type>(args)...);
+    auto &row = m_rows[row_no];
+    assert(row.size < std::numeric_limits<row_size_type>::max());
+    if (row.size == row.capacity) {
+      if (row.offset + row.capacity == m_pool.size()) {
+        // The row is the last one in the pool; grows in place
+        m_pool.emplace_back(std::move(value));
+        ++row.size;
+        ++row.capacity;
+        return m_pool.back();
+      }
+      priv_relocate(row, std::max(size_type(4), size_type(row.size) * 2));
+    }
+    auto &slot = priv_data()[row.offset + row.size];
+    slot = std::move(value);
+    ++row.size;
+    return slot;
+  }
+
+  /// \brief Reserves the capacity of a row.
+  void reserve_row(const size_type row_no, const size_type capacity) {
+    auto &row = m_rows[row_no];
+    if (capacity > row.capacity) priv_relocate(row, capacity);
+  }
+
+  /// \brief Removes the last element of a row.
+  void pop_back(const size_type row_no) {
+    auto &row = m_rows[row_no];
+    assert(row.size > 0);
+    --row.size;
+    priv_data()[row.offset + row.size] = value_type();
+  }
+
+  /// \brief Removes all elements of a row. Keeps the capacity of the row.
+  void clear_row(const size_type row_no) {
+    auto &row = m_rows[row_no];
+    std::fill_n(priv_data() + row.offset, row.size, value_type());
+    row.size = 0;
+  }
+
+  /// \brief Returns the total number of elements.
+  size_type num_elements() const {
+    size_type count = 0;
+    for (const auto &row : m_rows) count += row.size;
+    return count;
+  }
+
+  /// \brief Returns the number of element slots in the pool, including the
+  /// unused capacity of rows and the space that compaction can reclaim.
+  size_type pool_size() const { return m_pool.size(); }
+
+  /// \brief Removes all rows and elements.
+  void clear() {
+    m_rows.clear();
+    m_pool.clear();
+    m_garbage_size = 0;
+  }
+
+  /// \brief Moves the rows next to each other in the row order to reclaim
+  /// the space left by relocated rows. Keeps the capacity of each row.
+  void compact() { priv_compact(false); }
+
+  /// \brief Compacts the pool dropping the unused capacity of all rows.
+  void shrink_to_fit() {
+    priv_compact(true);
+    m_pool.shrink_to_fit();
+    m_rows.shrink_to_fit();
+  }
+
+  // ---------- Iterator ---------- //
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  flat_iterator flat_begin() { return flat_iterator(begin(), end()); }
+  flat_iterator flat_end() { return flat_iterator(end(), end()); }
+  const_flat_iterator flat_begin() const {
+    return const_flat_iterator(begin(), end());
+  }
+  const_flat_iterator flat_end() const {
+    return const_flat_iterator(end(), end());
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return m_pool.get_allocator(); }
+
+ private:
+  value_type *priv_data() { return metall::to_raw_pointer(m_pool.data()); }
+
+  const value_type *priv_data() const {
+    return metall::to_raw_pointer(m_pool.data());
+  }
+
+  /// \brief Moves a row to the end of the pool with a new capacity.
+  void priv_relocate(row_type &row, const size_type new_capacity) {
+    assert(new_capacity >= row.size);
+    assert(new_capacity <= std::numeric_limits<row_size_type>::max());
+    const auto new_offset = m_pool.size();
+    m_pool.resize(new_offset + new_capacity);
+    auto *const data = priv_data();
+    std::move(data + row.offset, data + row.offset + row.size,
+              data + new_offset);
+    std::fill_n(data + row.offset, row.size, value_type());
+    m_garbage_size += row.capacity;
+    row.offset = new_offset;
+    row.capacity = row_size_type(new_capacity);
+    priv_compact_if_needed();
+  }
+
+  void priv_compact_if_needed() {
+    if (m_pool.size() >= k_min_compaction_size &&
+        m_garbage_size * 2 > m_pool.size()) {
+      priv_compact(false);
+    }
+  }
+
+  void priv_compact(const bool drop_capacity) {
+    size_type new_size = 0;
+    for (const auto &row : m_rows) {
+      new_size += drop_capacity ? row.size : row.capacity;
+    }
+    pool_type new_pool(m_pool.get_allocator());
+    new_pool.reserve(new_size);
+    auto *const data = priv_data();
+    for (auto &row : m_rows) {
+      const auto new_offset = new_pool.size();
+      new_pool.insert(new_pool.end(),
+                      std::make_move_iterator(data + row.offset),
+                      std::make_move_iterator(data + row.offset + row.size));
+      if (drop_capacity) row.capacity = row.size;
+      new_pool.resize(new_offset + row.capacity);
+      row.offset = new_offset;
+    }
+    m_pool.swap(new_pool);
+    m_garbage_size = 0;
+  }
+
+  pool_type m_pool;
+  row_table_type m_rows;
+  size_type m_garbage_size;
+};
+
+template <typename _value_type, typename _allocator_type,
+          typename _row_size_type>
+template <typename pointer_type>
+class jagged_vector<_value_type, _allocator_type,
+                    _row_size_type>::basic_row_view {
+ public:
+  using value_type = _value_type;
+  using size_type = std::size_t;
+  using iterator = pointer_type;
+  using const_iterator = pointer_type;
+  using reference = decltype(*std::declval<pointer_type>());
+
+  basic_row_view(pointer_type data, const size_type size)
+      : m_data(data), m_size(size) {}
+
+  iterator begin() const { return m_data; }
+  iterator end() const { return m_data + m_size; }
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  pointer_type data() const { return m_data; }
+  reference operator[](const size_type i) const { return m_data[i]; }
+
+ private:
+  pointer_type m_data;
+  size_type m_size;
+};
+
+template <typename _value_type, typename _allocator_type,
+          typename _row_size_type>
+template <typename jagged_vector_pointer, typename row_view_type>
+class jagged_vector<_value_type, _allocator_type,
+                    _row_size_type>::row_iterator {
+ public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = row_view_type;
+  using pointer = void;
+  using reference = row_view_type;
+  using iterator_category = std::random_access_iterator_tag;
+
+  row_iterator() = default;
+  row_iterator(jagged_vector_pointer container, const std::size_t row_no)
+      : m_container(container), m_row_no(row_no) {}
+
+  reference operator*() const { return (*m_container)[m_row_no]; }
+  reference operator[](const difference_type n) const {
+    return (*m_container)[m_row_no + n];
+  }
+
+  row_iterator &operator++() {
+    ++m_row_no;
+    return *this;
+  }
+  row_iterator operator++(int) {
+    auto tmp(*this);
+    ++m_row_no;
+    return tmp;
+  }
+  row_iterator &operator--() {
+    --m_row_no;
+    return *this;
+  }
+  row_iterator operator--(int) {
+    auto tmp(*this);
+    --m_row_no;
+    return tmp;
+  }
+  row_iterator &operator+=(const difference_type n) {
+    m_row_no += n;
+    return *this;
+  }
+  row_iterator &operator-=(const difference_type n) {
+    m_row_no -= n;
+    return *this;
+  }
+  row_iterator operator+(const difference_type n) const {
+    return row_iterator(m_container, m_row_no + n);
+  }
+  row_iterator operator-(const difference_type n) const {
+    return row_iterator(m_container, m_row_no - n);
+  }
+  difference_type operator-(const row_iterator &other) const {
+    return difference_type(m_row_no) - difference_type(other.m_row_no);
+  }
+
+  bool operator==(const row_iterator &other) const {
+    return m_row_no == other.m_row_no;
+  }
+  bool operator!=(const row_iterator &other) const {
+    return m_row_no != other.m_row_no;
+  }
+  bool operator<(const row_iterator &other) const {
+    return m_row_no < other.m_row_no;
+  }
+  bool operator>(const row_iterator &other) const { return other < *this; }
+  bool operator<=(const row_iterator &other) const {
+    return !(other < *this);
+  }
+  bool operator>=(const row_iterator &other) const {
+    return !(*this < other);
+  }
+
+ private:
+  jagged_vector_pointer m_container{nullptr};
+  std::size_t m_row_no{0};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_JAGGED_VECTOR_HPP
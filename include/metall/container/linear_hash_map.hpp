@@ -0,0 +1,659 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_LINEAR_HASH_MAP_HPP
+#define METALL_CONTAINER_LINEAR_HASH_MAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A hash map which can be stored in persistent memory and grows
+/// incrementally (linear hashing).
+/// Unlike std::unordered_map or boost::unordered_map, which rehash all
+/// elements when the load factor is exceeded, this map splits a few buckets
+/// per insertion; thus, an insertion never touches the whole table, e.g., no
+/// multi-second pause and no burst of page faults in a large file-backed map.
+/// The buckets are held in a directory of segments that double in size; a
+/// new segment is allocated without being initialized, and its buckets are
+/// initialized one by one as they are split into.
+/// Each element is held in its own node with its hash value; the nodes are
+/// not moved by a split. References and pointers to elements stay valid until
+/// the elements are erased; iterators also stay valid but the iteration order
+/// changes by insertions.
+/// The hash values must be the same across program runs, e.g.,
+/// std::hash of integers, to use the map after reopening a data store.
+/// Not thread-safe.
+/// \tparam _key_type A key type.
+/// \tparam _mapped_type A mapped type.
+/// \tparam _hash A hash function of the keys.
+/// \tparam _key_equal A function that compares two keys.
+/// \tparam _allocator An allocator.
+template <typename _key_type, typename _mapped_type,
+          typename _hash = std::hash<_key_type>,
+          typename _key_equal = std::equal_to<_key_type>,
+          typename _allocator =
+              std::allocator<std::pair<const _key_type, _mapped_type>>>
+class linear_hash_map {
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  /// \brief A key type.
+  using key_type = _key_type;
+  /// \brief A mapped type.
+  using mapped_type = _mapped_type;
+  /// \brief A value type (i.e., std::pair<const key_type, mapped_type>).
+  using value_type = std::pair<const key_type, mapped_type>;
+  /// \brief A unsigned integer type (usually std::size_t).
+  using size_type = std::size_t;
+  /// \brief A hash function type.
+  using hasher = _hash;
+  /// \brief A key comparison function type.
+  using key_equal = _key_equal;
+  /// \brief An allocator type.
+  using allocator_type = _allocator;
+
+ private:
+  template <typename T>
+  using other_allocator_type =
+      typename std::allocator_traits<_allocator>::template rebind_alloc<T>;
+  template <typename T>
+  using other_pointer_type =
+      typename std::allocator_traits<other_allocator_type<T>>::pointer;
+
+  struct node_type {
+    other_pointer_type<node_type> next;
+    uint64_t hash;
+    alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+    value_type &value() noexcept {
+      return *reinterpret_cast<value_type *>(storage);
+    }
+  };
+  using node_allocator_type = other_allocator_type<node_type>;
+  using node_allocator_traits = std::allocator_traits<node_allocator_type>;
+  using value_allocator_type = other_allocator_type<value_type>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+
+  using bucket_type = other_pointer_type<node_type>;
+  using bucket_allocator_type = other_allocator_type<bucket_type>;
+  using bucket_allocator_traits = std::allocator_traits<bucket_allocator_type>;
+  using directory_segment_pointer = other_pointer_type<bucket_type>;
+
+  /// \brief The number of buckets in the first directory segment, which is
+  /// also the number of buckets of an empty map. Segment s (s > 0) has
+  /// k_num_first_buckets << (s - 1) buckets.
+  static constexpr size_type k_num_first_buckets = 16;
+  static constexpr size_type k_log2_num_first_buckets = 4;
+  static_assert((1ULL << k_log2_num_first_buckets) == k_num_first_buckets);
+  static constexpr size_type k_max_num_directory_segments =
+      64 - k_log2_num_first_buckets;
+
+  /// \brief The max number of buckets split by an insertion.
+  /// More than one so that the table catches up after reserve() is skipped.
+  static constexpr size_type k_max_splits_per_insertion = 2;
+
+  template <bool is_const>
+  class basic_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = linear_hash_map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+        std::conditional_t<is_const, const value_type *, value_type *>;
+    using reference =
+        std::conditional_t<is_const, const value_type &, value_type &>;
+
+    basic_iterator() = default;
+    basic_iterator(const linear_hash_map *const map, const size_type bucket_no,
+                   node_type *const node)
+        : m_map(map), m_bucket_no(bucket_no), m_node(node) {}
+
+    /// \brief Converts an iterator to a const iterator.
+    template <bool other_is_const,
+              typename = std::enable_if_t<is_const && !other_is_const>>
+    basic_iterator(const basic_iterator<other_is_const> &other)
+        : m_map(other.m_map),
+          m_bucket_no(other.m_bucket_no),
+          m_node(other.m_node) {}
+
+    reference operator*() const { return m_node->value(); }
+    pointer operator->() const { return &m_node->value(); }
+
+    basic_iterator &operator++() {
+      m_node = metall::to_raw_pointer(m_node->next);
+      if (!m_node) {
+        std::tie(m_bucket_no, m_node) =
+            m_map->priv_first_node_from(m_bucket_no + 1);
+      }
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    template <bool other_is_const>
+    bool operator==(const basic_iterator<other_is_const> &other) const {
+      return m_node == other.m_node;
+    }
+
+    template <bool other_is_const>
+    bool operator!=(const basic_iterator<other_is_const> &other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class linear_hash_map;
+    template <bool>
+    friend class basic_iterator;
+
+    const linear_hash_map *m_map{nullptr};
+    size_type m_bucket_no{0};
+    node_type *m_node{nullptr};
+  };
+
+ public:
+  /// \brief An iterator type.
+  using iterator = basic_iterator<false>;
+  /// \brief A const iterator type.
+  using const_iterator = basic_iterator<true>;
+
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit linear_hash_map(const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {}
+
+  /// \brief Destructor.
+  ~linear_hash_map() noexcept { priv_destroy(); }
+
+  linear_hash_map(const linear_hash_map &) = delete;
+  linear_hash_map &operator=(const linear_hash_map &) = delete;
+
+  /// \brief Move constructor.
+  linear_hash_map(linear_hash_map &&other) noexcept
+      : m_allocator(other.m_allocator),
+        m_size(std::exchange(other.m_size, 0)),
+        m_level_size(std::exchange(other.m_level_size, k_num_first_buckets)),
+        m_split_no(std::exchange(other.m_split_no, 0)),
+        m_max_load_factor(other.m_max_load_factor),
+        m_hasher(std::move(other.m_hasher)),
+        m_key_equal(std::move(other.m_key_equal)) {
+    for (size_type s = 0; s < k_max_num_directory_segments; ++s) {
+      m_directory[s] = std::exchange(other.m_directory[s], nullptr);
+    }
+  }
+
+  /// \brief Move assignment operator.
+  linear_hash_map &operator=(linear_hash_map &&other) noexcept {
+    if (this != &other) {
+      priv_destroy();
+      m_allocator = other.m_allocator;
+      m_size = std::exchange(other.m_size, 0);
+      m_level_size = std::exchange(other.m_level_size, k_num_first_buckets);
+      m_split_no = std::exchange(other.m_split_no, 0);
+      m_max_load_factor = other.m_max_load_factor;
+      m_hasher = std::move(other.m_hasher);
+      m_key_equal = std::move(other.m_key_equal);
+      for (size_type s = 0; s < k_max_num_directory_segments; ++s) {
+        m_directory[s] = std::exchange(other.m_directory[s], nullptr);
+      }
+    }
+    return *this;
+  }
+
+  // -------------------- //
+  // Public methods
+  // -------------------- //
+  // ---------- Iterator ---------- //
+  /// \brief Returns an iterator to the first element.
+  iterator begin() {
+    const auto [bucket_no, node] = priv_first_node_from(0);
+    return iterator(this, bucket_no, node);
+  }
+
+  /// \brief Returns an iterator to the first element.
+  const_iterator begin() const {
+    const auto [bucket_no, node] = priv_first_node_from(0);
+    return const_iterator(this, bucket_no, node);
+  }
+
+  /// \brief Returns an iterator to the element following the last element.
+  iterator end() { return iterator(this, bucket_count(), nullptr); }
+
+  /// \brief Returns an iterator to the element following the last element.
+  const_iterator end() const {
+    return const_iterator(this, bucket_count(), nullptr);
+  }
+
+  // ---------- Capacity ---------- //
+  /// \brief Returns the number of elements in the container.
+  size_type size() const noexcept { return m_size; }
+
+  /// \brief Returns true if the container has no element.
+  bool empty() const noexcept { return m_size == 0; }
+
+  // ---------- Bucket interface ---------- //
+  /// \brief Returns the number of buckets, which grows by one bucket at a
+  /// time.
+  size_type bucket_count() const noexcept { return m_level_size + m_split_no; }
+
+  // ---------- Hash policy ---------- //
+  /// \brief Returns the average number of elements per bucket.
+  float load_factor() const noexcept {
+    return static_cast<float>(m_size) / static_cast<float>(bucket_count());
+  }
+
+  /// \brief Returns the max load factor. The default is 1.0.
+  float max_load_factor() const noexcept { return m_max_load_factor; }
+
+  /// \brief Sets the max load factor.
+  /// A lower value makes the buckets split earlier; no bucket is split by
+  /// this function.
+  /// \param max_load_factor The max load factor. Must be > 0.
+  void max_load_factor(const float max_load_factor) {
+    if (max_load_factor <= 0.0f) {
+      throw std::invalid_argument("The max load factor must be > 0");
+    }
+    m_max_load_factor = max_load_factor;
+  }
+
+  /// \brief Splits buckets so that 'num_elements' elements can be held
+  /// without exceeding the max load factor, e.g., before loading a large
+  /// data set. Unlike insertions, this function can split many buckets at
+  /// once.
+  /// \param num_elements The number of elements.
+  void reserve(const size_type num_elements) {
+    priv_init_directory();
+    while (priv_overloaded(num_elements)) priv_split();
+  }
+
+  // ---------- Modifier ---------- //
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns a pair of an iterator to the element with the key and
+  /// a bool value that is true if the element was inserted.
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns a pair of an iterator to the element with the key and
+  /// a bool value that is true if the element was inserted.
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  /// \brief Inserts an element constructed in-place with 'args' if the
+  /// container does not already contain an element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param args Arguments to construct the mapped value.
+  /// \return Returns a pair of an iterator to the element with the key and
+  /// a bool value that is true if the element was inserted.
+  template <typename... args_type>
+  std::pair<iterator, bool> try_emplace(const key_type &key,
+                                        args_type &&...args) {
+    const auto hash = priv_hash(key);
+    const auto bucket_no = priv_bucket_no(hash);
+    if (auto *const node = priv_find_node(bucket_no, key, hash)) {
+      return {iterator(this, bucket_no, node), false};
+    }
+    return {priv_emplace_new(hash, key, std::forward<args_type>(args)...),
+            true};
+  }
+
+  /// \brief Inserts an element or assigns a value to the existing element.
+  /// \param key A key of the element.
+  /// \param mapped A value to insert or assign.
+  /// \return Returns a pair of an iterator to the element and a bool value
+  /// that is true if the element was inserted, false if assigned.
+  template <typename mapped_arg_type>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key,
+                                             mapped_arg_type &&mapped) {
+    auto ret = try_emplace(key, std::forward<mapped_arg_type>(mapped));
+    if (!ret.second) {
+      ret.first->second = std::forward<mapped_arg_type>(mapped);
+    }
+    return ret;
+  }
+
+  /// \brief Removes the element with an equivalent key.
+  /// Buckets are not merged.
+  /// \param key A key of the element to remove.
+  /// \return The number of removed elements (0 or 1).
+  size_type erase(const key_type &key) {
+    if (!m_directory[0]) return 0;
+    const auto hash = priv_hash(key);
+    auto *link = &priv_bucket(priv_bucket_no(hash));
+    while (auto *const node = metall::to_raw_pointer(*link)) {
+      if (node->hash == hash && m_key_equal(node->value().first, key)) {
+        *link = node->next;
+        priv_deallocate_node(node);
+        --m_size;
+        return 1;
+      }
+      link = &node->next;
+    }
+    return 0;
+  }
+
+  /// \brief Removes the element at 'position'.
+  /// \param position An iterator to the element to remove.
+  /// \return Returns an iterator to the element following the removed one.
+  iterator erase(const_iterator position) {
+    assert(position.m_node);
+    iterator next(this, position.m_bucket_no, position.m_node);
+    ++next;
+    erase(position->first);
+    return next;
+  }
+
+  /// \brief Removes all elements. The memory of the buckets is also
+  /// released.
+  void clear() { priv_destroy(); }
+
+  // ---------- Look up ---------- //
+  /// \brief Finds an element with an equivalent key.
+  /// \param key A key of the element to find.
+  /// \return Returns an iterator to the element if found; otherwise, end().
+  iterator find(const key_type &key) {
+    const auto hash = priv_hash(key);
+    const auto bucket_no = priv_bucket_no(hash);
+    auto *const node = priv_find_node(bucket_no, key, hash);
+    return node ? iterator(this, bucket_no, node) : end();
+  }
+
+  /// \brief Finds an element with an equivalent key.
+  /// \param key A key of the element to find.
+  /// \return Returns an iterator to the element if found; otherwise, end().
+  const_iterator find(const key_type &key) const {
+    const auto hash = priv_hash(key);
+    const auto bucket_no = priv_bucket_no(hash);
+    auto *const node = priv_find_node(bucket_no, key, hash);
+    return node ? const_iterator(this, bucket_no, node) : end();
+  }
+
+  /// \brief Returns the number of elements with an equivalent key.
+  /// \param key A key of the elements to count.
+  /// \return Either 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with an equivalent key.
+  bool contains(const key_type &key) const {
+    const auto hash = priv_hash(key);
+    return priv_find_node(priv_bucket_no(hash), key, hash) != nullptr;
+  }
+
+  /// \brief Returns a reference to the mapped value of the element with an
+  /// equivalent key. Throws std::out_of_range if there is no such element.
+  mapped_type &at(const key_type &key) {
+    const auto itr = find(key);
+    if (itr == end()) throw std::out_of_range("No such key");
+    return itr->second;
+  }
+
+  /// \brief Returns a reference to the mapped value of the element with an
+  /// equivalent key. Throws std::out_of_range if there is no such element.
+  const mapped_type &at(const key_type &key) const {
+    const auto itr = find(key);
+    if (itr == end()) throw std::out_of_range("No such key");
+    return itr->second;
+  }
+
+  /// \brief Returns a reference to the mapped value of the element with an
+  /// equivalent key, inserting a default-constructed one if there is no such
+  /// element.
+  mapped_type &operator[](const key_type &key) {
+    return try_emplace(key).first->second;
+  }
+
+  // ---------- Allocator ---------- //
+  /// \brief Returns the allocator associated with the container.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  static uint64_t priv_mix(uint64_t hash) noexcept {
+    // The finalizer of MurmurHash3 spreads identity hashes, e.g., integers
+    hash ^= hash >> 33ULL;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33ULL;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33ULL;
+    return hash;
+  }
+
+  uint64_t priv_hash(const key_type &key) const {
+    return priv_mix(m_hasher(key));
+  }
+
+  /// \brief Linear hashing: the buckets before the split pointer have been
+  /// split in this round and are addressed with one more bit.
+  size_type priv_bucket_no(const uint64_t hash) const noexcept {
+    const size_type bucket_no = hash & (m_level_size - 1);
+    if (bucket_no >= m_split_no) return bucket_no;
+    return hash & (m_level_size * 2 - 1);
+  }
+
+  static size_type priv_directory_segment_no(
+      const size_type bucket_no) noexcept {
+    if (bucket_no < k_num_first_buckets) return 0;
+    return (63 - mdtl::clzll(bucket_no)) - k_log2_num_first_buckets + 1;
+  }
+
+  static size_type priv_directory_segment_size(
+      const size_type segment_no) noexcept {
+    return (segment_no == 0) ? k_num_first_buckets
+                             : k_num_first_buckets << (segment_no - 1);
+  }
+
+  static size_type priv_directory_segment_begin(
+      const size_type segment_no) noexcept {
+    return (segment_no == 0) ? 0 : k_num_first_buckets << (segment_no - 1);
+  }
+
+  bucket_type &priv_bucket(const size_type bucket_no) const {
+    const auto segment_no = priv_directory_segment_no(bucket_no);
+    assert(m_directory[segment_no]);
+    return metall::to_raw_pointer(m_directory[segment_no])
+        [bucket_no - priv_directory_segment_begin(segment_no)];
+  }
+
+  node_type *priv_find_node(const size_type bucket_no, const key_type &key,
+                            const uint64_t hash) const {
+    if (!m_directory[0]) return nullptr;
+    for (auto *node = metall::to_raw_pointer(priv_bucket(bucket_no)); node;
+         node = metall::to_raw_pointer(node->next)) {
+      if (node->hash == hash && m_key_equal(node->value().first, key)) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  /// \brief Returns the first node in the buckets from 'bucket_no'.
+  std::pair<size_type, node_type *> priv_first_node_from(
+      size_type bucket_no) const {
+    if (m_size == 0) return {bucket_count(), nullptr};
+    for (; bucket_no < bucket_count(); ++bucket_no) {
+      if (auto *const node = metall::to_raw_pointer(priv_bucket(bucket_no))) {
+        return {bucket_no, node};
+      }
+    }
+    return {bucket_count(), nullptr};
+  }
+
+  bool priv_overloaded(const size_type num_elements) const noexcept {
+    return static_cast<float>(num_elements) >
+           m_max_load_factor * static_cast<float>(bucket_count());
+  }
+
+  /// \brief Inserts a new element; the key must not exist.
+  template <typename... args_type>
+  iterator priv_emplace_new(const uint64_t hash, const key_type &key,
+                            args_type &&...args) {
+    priv_init_directory();
+    for (size_type i = 0;
+         i < k_max_splits_per_insertion && priv_overloaded(m_size + 1); ++i) {
+      priv_split();
+    }
+
+    auto *const node = priv_allocate_node(hash, key,
+                                          std::forward<args_type>(args)...);
+    const auto bucket_no = priv_bucket_no(hash);
+    auto &bucket = priv_bucket(bucket_no);
+    node->next = bucket;
+    bucket = node;
+    ++m_size;
+    return iterator(this, bucket_no, node);
+  }
+
+  void priv_init_directory() {
+    if (m_directory[0]) return;
+    priv_allocate_directory_segment(0);
+    for (size_type i = 0; i < k_num_first_buckets; ++i) {
+      priv_construct_bucket(i);
+    }
+  }
+
+  /// \brief Splits the bucket at the split pointer into itself and a new
+  /// bucket at the end.
+  void priv_split() {
+    const size_type new_bucket_no = m_level_size + m_split_no;
+    const auto segment_no = priv_directory_segment_no(new_bucket_no);
+    if (segment_no >= k_max_num_directory_segments) return;
+    if (!m_directory[segment_no]) priv_allocate_directory_segment(segment_no);
+    priv_construct_bucket(new_bucket_no);
+
+    auto *link = &priv_bucket(m_split_no);
+    auto *new_link = &priv_bucket(new_bucket_no);
+    while (auto *const node = metall::to_raw_pointer(*link)) {
+      if (node->hash & m_level_size) {
+        *link = node->next;
+        *new_link = node;
+        new_link = &node->next;
+        *new_link = nullptr;
+      } else {
+        link = &node->next;
+      }
+    }
+
+    if (++m_split_no == m_level_size) {
+      m_level_size *= 2;
+      m_split_no = 0;
+    }
+  }
+
+  /// \brief Allocates a directory segment without initializing its buckets.
+  void priv_allocate_directory_segment(const size_type segment_no) {
+    bucket_allocator_type alloc(m_allocator);
+    m_directory[segment_no] = bucket_allocator_traits::allocate(
+        alloc, priv_directory_segment_size(segment_no));
+  }
+
+  void priv_construct_bucket(const size_type bucket_no) {
+    const auto segment_no = priv_directory_segment_no(bucket_no);
+    bucket_allocator_type alloc(m_allocator);
+    bucket_allocator_traits::construct(
+        alloc,
+        metall::to_raw_pointer(m_directory[segment_no]) +
+            (bucket_no - priv_directory_segment_begin(segment_no)),
+        nullptr);
+  }
+
+  template <typename... args_type>
+  node_type *priv_allocate_node(const uint64_t hash, const key_type &key,
+                                args_type &&...args) {
+    node_allocator_type node_alloc(m_allocator);
+    auto *const node =
+        metall::to_raw_pointer(node_allocator_traits::allocate(node_alloc, 1));
+    try {
+      value_allocator_type value_alloc(m_allocator);
+      value_allocator_traits::construct(
+          value_alloc, &node->value(), std::piecewise_construct,
+          std::forward_as_tuple(key),
+          std::forward_as_tuple(std::forward<args_type>(args)...));
+    } catch (...) {
+      node_allocator_traits::deallocate(node_alloc, node, 1);
+      throw;
+    }
+    ::new (static_cast<void *>(&node->next)) bucket_type(nullptr);
+    node->hash = hash;
+    return node;
+  }
+
+  void priv_deallocate_node(node_type *const node) {
+    value_allocator_type value_alloc(m_allocator);
+    value_allocator_traits::destroy(value_alloc, &node->value());
+    node->next.~bucket_type();
+    node_allocator_type node_alloc(m_allocator);
+    node_allocator_traits::deallocate(node_alloc, node, 1);
+  }
+
+  void priv_destroy() noexcept {
+    bucket_allocator_type alloc(m_allocator);
+    const auto num_buckets = bucket_count();
+    for (size_type s = 0; s < k_max_num_directory_segments; ++s) {
+      if (!m_directory[s]) break;
+      auto *const buckets = metall::to_raw_pointer(m_directory[s]);
+      const auto begin = priv_directory_segment_begin(s);
+      const auto end = std::min(begin + priv_directory_segment_size(s),
+                                num_buckets);
+      for (size_type b = begin; b < end; ++b) {
+        auto *node = metall::to_raw_pointer(buckets[b - begin]);
+        while (node) {
+          auto *const next = metall::to_raw_pointer(node->next);
+          priv_deallocate_node(node);
+          node = next;
+        }
+        bucket_allocator_traits::destroy(alloc, &buckets[b - begin]);
+      }
+      bucket_allocator_traits::deallocate(alloc, m_directory[s],
+                                          priv_directory_segment_size(s));
+      m_directory[s] = nullptr;
+    }
+    m_size = 0;
+    m_level_size = k_num_first_buckets;
+    m_split_no = 0;
+  }
+
+  allocator_type m_allocator;
+  size_type m_size{0};
+  // The number of buckets at the beginning of the current round
+  size_type m_level_size{k_num_first_buckets};
+  // The next bucket to split
+  size_type m_split_no{0};
+  float m_max_load_factor{1.0f};
+  directory_segment_pointer m_directory[k_max_num_directory_segments]{};
+  hasher m_hasher{};
+  key_equal m_key_equal{};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_LINEAR_HASH_MAP_HPP
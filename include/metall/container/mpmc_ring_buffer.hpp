@@ -0,0 +1,190 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_MPMC_RING_BUFFER_HPP
+#define METALL_CONTAINER_MPMC_RING_BUFFER_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A lock-free bounded multi-producer multi-consumer queue which can
+/// be stored in persistent memory.
+/// Each slot has a sequence number that tells producers and consumers
+/// whether it is free or filled in the current round; thus, a producer and a
+/// consumer synchronize only through the slot they use.
+/// Items in the buffer survive closing and reopening the datastore.
+/// If a process terminates during push() or pop(), the slot being used may
+/// be left unusable.
+/// \tparam _value_type A value type.
+/// \tparam _allocator_type An allocator type.
+template <typename _value_type,
+          typename _allocator_type = std::allocator<_value_type>>
+class mpmc_ring_buffer {
+ public:
+  using value_type = _value_type;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+
+ private:
+  struct cell_type {
+    uint64_t sequence;
+    alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+    value_type *value() {
+      return std::launder(reinterpret_cast<value_type *>(storage));
+    }
+  };
+
+  using cell_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<cell_type>;
+  using cell_pointer =
+      typename std::allocator_traits<cell_allocator_type>::pointer;
+
+  static constexpr std::size_t k_cache_line_size = 64;
+
+ public:
+  /// \brief Constructor.
+  /// \param capacity The maximum number of items.
+  /// Rounded up to a power of two.
+  /// \param allocator An allocator object.
+  explicit mpmc_ring_buffer(const size_type capacity,
+                            const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator),
+        m_mask(priv_round_up(capacity) - 1),
+        m_cells(std::allocator_traits<cell_allocator_type>::allocate(
+            m_allocator, m_mask + 1)) {
+    auto *const cells = metall::to_raw_pointer(m_cells);
+    for (uint64_t i = 0; i <= m_mask; ++i) cells[i].sequence = i;
+  }
+
+  /// \brief Destructor. Destroys the remaining items.
+  ~mpmc_ring_buffer() noexcept {
+    auto *const cells = metall::to_raw_pointer(m_cells);
+    for (auto pos = m_dequeue_pos; pos < m_enqueue_pos; ++pos) {
+      auto &cell = cells[pos & m_mask];
+      if (cell.sequence == pos + 1) cell.value()->~value_type();
+    }
+    std::allocator_traits<cell_allocator_type>::deallocate(
+        m_allocator, m_cells, m_mask + 1);
+  }
+
+  mpmc_ring_buffer(const mpmc_ring_buffer &) = delete;
+  mpmc_ring_buffer(mpmc_ring_buffer &&) = delete;
+  mpmc_ring_buffer &operator=(const mpmc_ring_buffer &) = delete;
+  mpmc_ring_buffer &operator=(mpmc_ring_buffer &&) = delete;
+
+  /// \brief Adds an item if the buffer is not full. This function is
+  /// thread-safe and lock-free.
+  /// \return True on success; false if the buffer is full.
+  bool push(const value_type &value) { return emplace(value); }
+
+  /// \brief Adds an item if the buffer is not full.
+  bool push(value_type &&value) { return emplace(std::move(value)); }
+
+  /// \brief Adds an item constructed from arguments if the buffer is not
+  /// full.
+  /// \return True on success; false if the buffer is full.
+  template <typename... args_type>
+  bool emplace(args_type &&...args) {
+    auto *const cells = metall::to_raw_pointer(m_cells);
+    uint64_t pos = __atomic_load_n(&m_enqueue_pos, __ATOMIC_RELAXED);
+    while (true) {
+      auto &cell = cells[pos & m_mask];
+      const auto seq = mdtl::atomic_load(&cell.sequence);
+      const auto diff = static_cast<int64_t>(seq - pos);
+      if (diff == 0) {
+        // The slot is free in this round; try to take it
+        if (mdtl::atomic_compare_exchange(&m_enqueue_pos, &pos, pos + 1)) {
+          new (cell.storage) value_type(std::forward<args_type>(args)...);
+          mdtl::atomic_store(&cell.sequence, pos + 1);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // Full
+      } else {
+        pos = __atomic_load_n(&m_enqueue_pos, __ATOMIC_RELAXED);
+      }
+    }
+  }
+
+  /// \brief Takes the oldest item if the buffer is not empty. This function
+  /// is thread-safe and lock-free.
+  /// \param value A reference to store the item.
+  /// \return True on success; false if the buffer is empty.
+  bool pop(value_type &value) {
+    auto *const cells = metall::to_raw_pointer(m_cells);
+    uint64_t pos = __atomic_load_n(&m_dequeue_pos, __ATOMIC_RELAXED);
+    while (true) {
+      auto &cell = cells[pos & m_mask];
+      const auto seq = mdtl::atomic_load(&cell.sequence);
+      const auto diff = static_cast<int64_t>(seq - (pos + 1));
+      if (diff == 0) {
+        if (mdtl::atomic_compare_exchange(&m_dequeue_pos, &pos, pos + 1)) {
+          value = std::move(*cell.value());
+          cell.value()->~value_type();
+          // Frees the slot for the next round
+          mdtl::atomic_store(&cell.sequence, pos + m_mask + 1);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // Empty
+      } else {
+        pos = __atomic_load_n(&m_dequeue_pos, __ATOMIC_RELAXED);
+      }
+    }
+  }
+
+  /// \brief Returns the number of items.
+  /// The value is approximate while other threads push or pop items.
+  size_type size() const {
+    const auto deq = mdtl::atomic_load(&m_dequeue_pos);
+    const auto enq = mdtl::atomic_load(&m_enqueue_pos);
+    return (enq > deq) ? enq - deq : 0;
+  }
+
+  /// \brief Checks if the buffer is empty.
+  /// The value is approximate while other threads push or pop items.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns the maximum number of items.
+  size_type capacity() const { return m_mask + 1; }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return allocator_type(m_allocator); }
+
+ private:
+  static uint64_t priv_round_up(const size_type n) {
+    uint64_t capacity = 2;
+    while (capacity < n) capacity *= 2;
+    return capacity;
+  }
+
+  cell_allocator_type m_allocator;
+  const uint64_t m_mask;
+  const cell_pointer m_cells;
+  // Keep producers and consumers on different cache lines
+  char m_padding0[k_cache_line_size];
+  uint64_t m_enqueue_pos{0};
+  char m_padding1[k_cache_line_size - sizeof(uint64_t)];
+  uint64_t m_dequeue_pos{0};
+  char m_padding2[k_cache_line_size - sizeof(uint64_t)];
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_MPMC_RING_BUFFER_HPP
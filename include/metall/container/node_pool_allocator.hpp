@@ -0,0 +1,325 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_NODE_POOL_ALLOCATOR_HPP
+#define METALL_CONTAINER_NODE_POOL_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <metall/offset_ptr.hpp>
+
+namespace metall::container {
+
+/// \brief A set of persistent free lists, one for each small size class of
+/// Metall, for node_pool_allocator_adaptor.
+/// An empty free list is refilled by taking many objects from the allocator
+/// at once; freed objects are kept in the free lists until release() is
+/// called or this object is destructed.
+/// An instance can be constructed in a Metall datastore and reused after
+/// reopening it.
+/// This class is not thread-safe.
+/// \tparam StatefulAllocator The allocator to take objects from, e.g.,
+/// metall::manager::allocator_type.
+template <typename StatefulAllocator>
+class node_pool_resource {
+ public:
+  using allocator_type = typename std::allocator_traits<
+      StatefulAllocator>::template rebind_alloc<std::byte>;
+  using size_type = typename std::allocator_traits<allocator_type>::size_type;
+  using bin_number_manager_type =
+      typename allocator_type::manager_kernel_type::bin_number_manager_type;
+  using bin_no_type = typename bin_number_manager_type::bin_no_type;
+
+  /// \brief The number of bytes taken from the allocator at once to refill a
+  /// free list.
+  static constexpr size_type refill_size = 1ULL << 16ULL;
+
+ private:
+  static constexpr size_type k_num_bins =
+      bin_number_manager_type::num_small_bins();
+
+  struct free_node;
+  using free_node_pointer = typename std::pointer_traits<
+      typename std::allocator_traits<allocator_type>::pointer>::
+      template rebind<free_node>;
+
+  struct free_node {
+    free_node_pointer next;
+  };
+
+  template <size_type k_size>
+  struct block {
+    alignas(free_node) std::byte data[k_size];
+  };
+
+ public:
+  /// \brief Returns true if objects of 'size' bytes are pooled, i.e., they
+  /// are small objects in Metall.
+  static constexpr bool pooled(const size_type size) noexcept {
+    return size > 0 &&
+           size <= bin_number_manager_type::to_object_size(k_num_bins - 1) &&
+           bin_number_manager_type::to_object_size(
+               bin_number_manager_type::to_bin_no(size)) >= sizeof(free_node);
+  }
+
+  /// \brief Constructor.
+  /// \param allocator The allocator to take objects from.
+  explicit node_pool_resource(const StatefulAllocator &allocator)
+      : m_allocator(allocator) {}
+
+  node_pool_resource(const node_pool_resource &) = delete;
+  node_pool_resource &operator=(const node_pool_resource &) = delete;
+
+  /// \brief Destructor that returns all pooled objects to the allocator.
+  ~node_pool_resource() noexcept { release(); }
+
+  /// \brief Allocates an object of 'k_size' bytes.
+  /// The size class is computed at compile time.
+  /// \tparam k_size The size of the object; pooled(k_size) must be true.
+  /// \return Returns a pointer to the storage.
+  /// Throws std::bad_alloc if it fails to refill the free list.
+  template <size_type k_size>
+  void *allocate() {
+    constexpr bin_no_type k_bin_no = bin_number_manager_type::to_bin_no(k_size);
+    auto &head = m_free_lists[k_bin_no];
+    if (!head) priv_refill<k_bin_no>();
+    free_node *const node = to_raw_pointer(head);
+    head = node->next;
+    node->~free_node();
+    return node;
+  }
+
+  /// \brief Returns an object allocated by allocate() to the free list.
+  /// \tparam k_size The size given to allocate().
+  template <size_type k_size>
+  void deallocate(void *const addr) noexcept {
+    constexpr bin_no_type k_bin_no = bin_number_manager_type::to_bin_no(k_size);
+    auto *const node = ::new (addr) free_node();
+    node->next = m_free_lists[k_bin_no];
+    m_free_lists[k_bin_no] = free_node_pointer(node);
+  }
+
+  /// \brief Returns all objects in the free lists to the allocator.
+  /// The objects allocated from this object and not deallocated yet are not
+  /// affected.
+  void release() noexcept {
+    using byte_pointer =
+        typename std::allocator_traits<allocator_type>::pointer;
+    constexpr size_type k_batch_size = 256;
+
+    std::array<byte_pointer, k_batch_size> addrs;
+    for (auto &head : m_free_lists) {
+      while (head) {
+        size_type n = 0;
+        for (; head && n < k_batch_size; ++n) {
+          free_node *const node = to_raw_pointer(head);
+          head = node->next;
+          node->~free_node();
+          addrs[n] = byte_pointer(reinterpret_cast<std::byte *>(node));
+        }
+        m_allocator.deallocate_many(addrs.data(), n);
+      }
+    }
+  }
+
+  /// \brief Returns the number of objects in the free lists.
+  size_type num_pooled_objects() const noexcept {
+    size_type n = 0;
+    for (const auto &head : m_free_lists) {
+      for (auto node = head; node; node = node->next) ++n;
+    }
+    return n;
+  }
+
+  /// \brief Returns the allocator objects are taken from.
+  const allocator_type &get_allocator() const noexcept { return m_allocator; }
+
+ private:
+  template <bin_no_type k_bin_no>
+  using block_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<
+          block<bin_number_manager_type::to_object_size(k_bin_no)>>;
+
+  template <bin_no_type k_bin_no>
+  void priv_refill() {
+    constexpr size_type k_object_size =
+        bin_number_manager_type::to_object_size(k_bin_no);
+    constexpr size_type k_num =
+        std::max<size_type>(refill_size / k_object_size, 1);
+    using block_pointer =
+        typename std::allocator_traits<block_allocator_type<k_bin_no>>::pointer;
+
+    std::vector<block_pointer> blocks(k_num);
+    block_allocator_type<k_bin_no>(m_allocator)
+        .allocate_many(k_num, blocks.data());
+    for (const auto &b : blocks) {
+      deallocate<k_object_size>(to_raw_pointer(b));
+    }
+  }
+
+  allocator_type m_allocator;
+  std::array<free_node_pointer, k_num_bins> m_free_lists{};
+};
+
+/// \brief A Metall STL compatible allocator that allocates single objects,
+/// e.g., the nodes of list, map, and unordered_node_map, from the free list
+/// of a node_pool_resource, taking a handful of instructions.
+/// Other allocations go to the allocator of the resource.
+/// Copies and rebound instances share the resource.
+/// \tparam StatefulAllocator The allocator type of the resource.
+template <typename StatefulAllocator>
+class node_pool_allocator_adaptor {
+ private:
+  using traits = std::allocator_traits<
+      std::remove_const_t<std::remove_reference_t<StatefulAllocator>>>;
+
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  using stateful_allocator_type = typename std::remove_const<
+      typename std::remove_reference<StatefulAllocator>::type>::type;
+  /// \brief The resource type, which is the same for all value types.
+  using resource_type = node_pool_resource<typename std::allocator_traits<
+      stateful_allocator_type>::template rebind_alloc<std::byte>>;
+
+  using value_type = typename traits::value_type;
+  using pointer = typename traits::pointer;
+  using const_pointer = typename traits::const_pointer;
+  using void_pointer = typename traits::void_pointer;
+  using const_void_pointer = typename traits::const_void_pointer;
+  using difference_type = typename traits::difference_type;
+  using size_type = typename traits::size_type;
+
+  /// \brief Makes another allocator type for type T2
+  template <typename T2>
+  struct rebind {
+    using other =
+        node_pool_allocator_adaptor<typename traits::template rebind_alloc<T2>>;
+  };
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+
+  /// \brief Constructor.
+  /// \param resource The resource to allocate from.
+  /// Must outlive this object and its copies.
+  node_pool_allocator_adaptor(resource_type *const resource) noexcept
+      : m_resource(resource) {}
+
+  /// \brief Construct a new instance using an instance that has a different
+  /// value type.
+  template <typename stateful_allocator_type2,
+            std::enable_if_t<
+                std::is_same_v<typename node_pool_allocator_adaptor<
+                                   stateful_allocator_type2>::resource_type,
+                               resource_type>,
+                int> = 0>
+  node_pool_allocator_adaptor(
+      const node_pool_allocator_adaptor<stateful_allocator_type2>
+          &allocator_instance) noexcept
+      : m_resource(allocator_instance.get_resource()) {}
+
+  node_pool_allocator_adaptor(const node_pool_allocator_adaptor &) noexcept =
+      default;
+  node_pool_allocator_adaptor(node_pool_allocator_adaptor &&) noexcept =
+      default;
+  node_pool_allocator_adaptor &operator=(
+      const node_pool_allocator_adaptor &) noexcept = default;
+  node_pool_allocator_adaptor &operator=(
+      node_pool_allocator_adaptor &&) noexcept = default;
+
+  /// \brief Allocates n * sizeof(T) bytes of storage
+  /// \param n The size to allocation
+  /// \return Returns a pointer
+  pointer allocate(const size_type n) const {
+    if constexpr (k_pooled) {
+      if (n == 1) {
+        return pointer(static_cast<value_type *>(
+            get_resource()->template allocate<sizeof(value_type)>()));
+      }
+    }
+    return priv_stateful_allocator().allocate(n);
+  }
+
+  /// \brief Deallocates the storage reference by the pointer ptr
+  /// \param ptr A pointer to the storage
+  /// \param size The size of the storage
+  void deallocate(pointer ptr, const size_type size) const {
+    if constexpr (k_pooled) {
+      if (size == 1) {
+        get_resource()->template deallocate<sizeof(value_type)>(
+            to_raw_pointer(ptr));
+        return;
+      }
+    }
+    priv_stateful_allocator().deallocate(ptr, size);
+  }
+
+  /// \brief The size of the theoretical maximum allocation size
+  /// \return The size of the theoretical maximum allocation size
+  size_type max_size() const noexcept {
+    return std::numeric_limits<size_type>::max() / sizeof(value_type);
+  }
+
+  /// \brief Constructs an object of T
+  /// \tparam Args The types of the constructor arguments
+  /// \param ptr A pointer to allocated storage
+  /// \param args The constructor arguments to use
+  template <class... Args>
+  void construct(const pointer &ptr, Args &&...args) const {
+    ::new ((void *)to_raw_pointer(ptr)) value_type(std::forward<Args>(args)...);
+  }
+
+  /// \brief Deconstruct an object of T
+  /// \param ptr A pointer to the object
+  void destroy(const pointer &ptr) const { (*ptr).~value_type(); }
+
+  // ---------- This class's unique public functions ---------- //
+
+  /// \brief Returns the resource this allocator allocates from.
+  resource_type *get_resource() const noexcept {
+    return to_raw_pointer(m_resource);
+  }
+
+ private:
+  static constexpr bool k_pooled =
+      resource_type::pooled(sizeof(value_type));
+
+  stateful_allocator_type priv_stateful_allocator() const {
+    return stateful_allocator_type(get_resource()->get_allocator());
+  }
+
+  typename std::pointer_traits<void_pointer>::template rebind<resource_type>
+      m_resource;
+};
+
+template <typename stateful_allocator_type>
+inline bool operator==(
+    const node_pool_allocator_adaptor<stateful_allocator_type> &rhd,
+    const node_pool_allocator_adaptor<stateful_allocator_type> &lhd) {
+  // Return true if they allocate from the same resource
+  return rhd.get_resource() == lhd.get_resource();
+}
+
+template <typename stateful_allocator_type>
+inline bool operator!=(
+    const node_pool_allocator_adaptor<stateful_allocator_type> &rhd,
+    const node_pool_allocator_adaptor<stateful_allocator_type> &lhd) {
+  return !(rhd == lhd);
+}
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_NODE_POOL_ALLOCATOR_HPP
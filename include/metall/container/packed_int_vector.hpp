@@ -0,0 +1,220 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_PACKED_INT_VECTOR_HPP
+#define METALL_CONTAINER_PACKED_INT_VECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A vector of unsigned integers of a fixed number of bits each, e.g.,
+/// vertex IDs or small-range properties, which can be stored in persistent
+/// memory.
+/// The integers are packed without gaps; thus, a vector of 20-bit integers
+/// takes less than a third of the memory, and the bandwidth, of a vector of
+/// uint64_t.
+/// decode() extracts many integers at once, with AVX2 gathers if available.
+/// \tparam _allocator_type An allocator type.
+template <typename _allocator_type = metall::manager::allocator_type<std::byte>>
+class packed_int_vector {
+ public:
+  using value_type = uint64_t;
+  using size_type = std::size_t;
+  using allocator_type = _allocator_type;
+
+ private:
+  using word_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<uint64_t>;
+
+  static constexpr unsigned int k_word_bits = 64;
+  // An integer of up to this width is in the 8 bytes from its first byte
+  static constexpr unsigned int k_max_byte_load_width = 56;
+
+ public:
+  /// \brief Returns the number of bits to store 'max_value', at least 1.
+  static constexpr unsigned int bits_needed(const value_type max_value) {
+    return max_value == 0 ? 1 : k_word_bits - mdtl::clzll(max_value);
+  }
+
+  /// \brief Constructor.
+  /// \param width The number of bits of each integer, in [1, 64].
+  /// \param allocator An allocator object.
+  explicit packed_int_vector(const unsigned int width,
+                             const allocator_type &allocator = allocator_type())
+      : m_words(allocator),
+        m_width(std::clamp(width, 1U, k_word_bits)),
+        m_mask(priv_mask(m_width)) {
+    priv_resize_words(0);
+  }
+
+  /// \brief Constructor.
+  /// \param width The number of bits of each integer, in [1, 64].
+  /// \param n The number of integers, which are 0.
+  /// \param allocator An allocator object.
+  packed_int_vector(const unsigned int width, const size_type n,
+                    const allocator_type &allocator = allocator_type())
+      : packed_int_vector(width, allocator) {
+    resize(n);
+  }
+
+  /// \brief Returns the integer at 'index'.
+  value_type operator[](const size_type index) const {
+    assert(index < m_size);
+    return priv_get(index);
+  }
+
+  /// \brief Returns the integer at 'index'.
+  value_type get(const size_type index) const { return (*this)[index]; }
+
+  /// \brief Sets the integer at 'index'. The bits of 'value' beyond the width
+  /// are ignored.
+  void set(const size_type index, const value_type value) {
+    assert(index < m_size);
+    const auto bit = uint64_t(index) * m_width;
+    const auto word = bit / k_word_bits;
+    const auto offset = bit % k_word_bits;
+    const auto v = value & m_mask;
+    m_words[word] = (m_words[word] & ~(m_mask << offset)) | (v << offset);
+    if (offset + m_width > k_word_bits) {
+      const auto shift = k_word_bits - offset;
+      m_words[word + 1] =
+          (m_words[word + 1] & ~(m_mask >> shift)) | (v >> shift);
+    }
+  }
+
+  /// \brief Appends an integer.
+  void push_back(const value_type value) {
+    resize(m_size + 1);
+    set(m_size - 1, value);
+  }
+
+  /// \brief Extracts the integers in [first, first + n) to 'out'.
+  /// Faster than calling get() n times.
+  void decode(const size_type first, const size_type n,
+              value_type *const out) const {
+    assert(first + n <= m_size);
+    size_type i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (m_width <= k_max_byte_load_width) {
+      const auto *const bytes =
+          reinterpret_cast<const unsigned char *>(m_words.data());
+#ifdef __AVX2__
+      // Gathers 8 bytes from the first byte of each integer and shifts it
+      const auto mask = _mm256_set1_epi64x(m_mask);
+      const auto seven = _mm256_set1_epi64x(7);
+      const auto bit = int64_t(first) * m_width;
+      auto bits = _mm256_set_epi64x(bit + 3 * m_width, bit + 2 * m_width,
+                                    bit + m_width, bit);
+      const auto step = _mm256_set1_epi64x(4 * m_width);
+      for (; i + 4 <= n; i += 4) {
+        const auto words = _mm256_i64gather_epi64(
+            reinterpret_cast<const long long *>(bytes),
+            _mm256_srli_epi64(bits, 3), 1);
+        const auto values = _mm256_and_si256(
+            _mm256_srlv_epi64(words, _mm256_and_si256(bits, seven)), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), values);
+        bits = _mm256_add_epi64(bits, step);
+      }
+#endif
+      for (; i < n; ++i) {
+        const auto bit = uint64_t(first + i) * m_width;
+        uint64_t word;
+        std::memcpy(&word, bytes + bit / 8, sizeof(word));
+        out[i] = (word >> (bit % 8)) & m_mask;
+      }
+    }
+#endif
+    for (; i < n; ++i) out[i] = priv_get(first + i);
+  }
+
+  /// \brief Changes the number of integers; new integers are 0.
+  void resize(const size_type n) {
+    if (n < m_size) {
+      // Clears the bits beyond the new size so that they are 0 if it grows
+      const auto bit = uint64_t(n) * m_width;
+      const auto word = bit / k_word_bits;
+      m_words[word] &= priv_mask(bit % k_word_bits);
+      std::fill(m_words.begin() + word + 1, m_words.end(), 0);
+    }
+    m_size = n;
+    priv_resize_words(n);
+  }
+
+  /// \brief Reserves memory for 'n' integers.
+  void reserve(const size_type n) {
+    m_words.reserve(priv_num_words(n));
+  }
+
+  /// \brief Removes all integers.
+  void clear() { resize(0); }
+
+  size_type size() const { return m_size; }
+
+  bool empty() const { return m_size == 0; }
+
+  /// \brief Returns the number of bits of each integer.
+  unsigned int width() const { return m_width; }
+
+  /// \brief Returns the memory used by the integers in bytes.
+  size_type memory_bytes() const { return m_words.size() * sizeof(uint64_t); }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_words.get_allocator());
+  }
+
+ private:
+  static constexpr uint64_t priv_mask(const unsigned int width) {
+    return width == k_word_bits ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+  }
+
+  /// \brief Returns the number of words for 'n' integers, plus a word so that
+  /// a load of 8 bytes from any integer stays in the storage.
+  size_type priv_num_words(const size_type n) const {
+    return (uint64_t(n) * m_width + k_word_bits - 1) / k_word_bits + 1;
+  }
+
+  void priv_resize_words(const size_type n) {
+    m_words.resize(priv_num_words(n), 0);
+  }
+
+  value_type priv_get(const size_type index) const {
+    const auto bit = uint64_t(index) * m_width;
+    const auto word = bit / k_word_bits;
+    const auto offset = bit % k_word_bits;
+    auto value = m_words[word] >> offset;
+    if (offset + m_width > k_word_bits) {
+      value |= m_words[word + 1] << (k_word_bits - offset);
+    }
+    return value & m_mask;
+  }
+
+  vector<uint64_t, word_allocator_type> m_words;
+  unsigned int m_width;
+  uint64_t m_mask;
+  size_type m_size{0};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_PACKED_INT_VECTOR_HPP
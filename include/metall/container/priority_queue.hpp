@@ -6,17 +6,601 @@
 #ifndef METALL_CONTAINER_PRIORITY_QUEUE_HPP
 #define METALL_CONTAINER_PRIORITY_QUEUE_HPP
 
-#include <queue>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <utility>
 
 #include <metall/container/vector.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/utility/mutex.hpp>
 
 namespace metall::container {
 
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
 /// \brief A priority_queue container that uses Metall as its default allocator.
 template <typename T, typename Container = vector<T>,
           typename Compare = std::less<typename Container::value_type>>
-using priority_queue = std::priority_queue<T, Container>;
+using priority_queue = std::priority_queue<T, Container, Compare>;
+
+/// \brief A priority queue implemented as a d-ary heap, which can be stored
+/// in persistent memory.
+/// A node has 'D' children, which are adjacent in memory; thus, a sift-down
+/// takes fewer levels, i.e., cache misses, than the binary heap of
+/// std::priority_queue, e.g., for large queues of small items.
+/// As std::priority_queue, top() is the item that is not less than any other
+/// item in terms of 'Compare', i.e., the largest item with std::less.
+/// \tparam T A value type.
+/// \tparam Compare A comparison function type.
+/// \tparam D The number of children of a node.
+/// \tparam Allocator An allocator type.
+template <typename T, typename Compare = std::less<T>, std::size_t D = 4,
+          typename Allocator = manager::allocator_type<T>>
+class d_ary_heap {
+  static_assert(D >= 2, "A node must have at least two children");
+
+ public:
+  using value_type = T;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit d_ary_heap(const allocator_type &allocator = allocator_type())
+      : m_values(allocator) {}
+
+  /// \brief Constructor.
+  /// \param comp A comparison function object.
+  /// \param allocator An allocator object.
+  d_ary_heap(const value_compare &comp, const allocator_type &allocator)
+      : m_values(allocator), m_comp(comp) {}
+
+  /// \brief Returns the top item. The queue must not be empty.
+  const value_type &top() const {
+    assert(!empty());
+    return m_values.front();
+  }
+
+  /// \brief Adds an item.
+  void push(const value_type &value) { emplace(value); }
+
+  /// \brief Adds an item.
+  void push(value_type &&value) { emplace(std::move(value)); }
+
+  /// \brief Adds an item constructed from arguments.
+  template <typename... args_type>
+  void emplace(args_type &&...args) {
+    m_values.emplace_back(std::forward<args_type>(args)...);
+    priv_sift_up(m_values.size() - 1);
+  }
+
+  /// \brief Adds the items in [first, last).
+  /// If as many items as the queue has or more are added, the heap is rebuilt
+  /// in linear time instead of adding the items one by one.
+  template <typename input_iterator>
+  void push_bulk(input_iterator first, input_iterator last) {
+    const auto old_size = m_values.size();
+    m_values.insert(m_values.end(), first, last);
+    const auto num_added = m_values.size() - old_size;
+    if (num_added >= old_size) {
+      priv_make_heap();
+    } else {
+      for (auto i = old_size; i < m_values.size(); ++i) priv_sift_up(i);
+    }
+  }
+
+  /// \brief Removes the top item. The queue must not be empty.
+  void pop() {
+    assert(!empty());
+    if (m_values.size() > 1) {
+      m_values.front() = std::move(m_values.back());
+      m_values.pop_back();
+      priv_sift_down(0);
+    } else {
+      m_values.pop_back();
+    }
+  }
+
+  /// \brief Takes up to 'n' items from the top, in the order pop() removes
+  /// them.
+  /// \param out An output iterator to store the items.
+  /// \param n The maximum number of items to take.
+  /// \return The number of items taken.
+  template <typename output_iterator>
+  size_type pop_bulk(output_iterator out, const size_type n) {
+    size_type num_popped = 0;
+    for (; num_popped < n && !empty(); ++num_popped, ++out) {
+      *out = std::move(m_values.front());
+      pop();
+    }
+    return num_popped;
+  }
+
+  /// \brief Returns the number of items.
+  size_type size() const { return m_values.size(); }
+
+  /// \brief Checks if the queue is empty.
+  bool empty() const { return m_values.empty(); }
+
+  /// \brief Removes all items.
+  void clear() { m_values.clear(); }
+
+  /// \brief Reserves memory for 'n' items.
+  void reserve(const size_type n) { m_values.reserve(n); }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return m_values.get_allocator(); }
+
+ private:
+  void priv_sift_up(size_type index) {
+    value_type value = std::move(m_values[index]);
+    while (index > 0) {
+      const auto parent = (index - 1) / D;
+      if (!m_comp(m_values[parent], value)) break;
+      m_values[index] = std::move(m_values[parent]);
+      index = parent;
+    }
+    m_values[index] = std::move(value);
+  }
+
+  void priv_sift_down(size_type index) {
+    const auto size = m_values.size();
+    value_type value = std::move(m_values[index]);
+    while (true) {
+      const auto first_child = index * D + 1;
+      if (first_child >= size) break;
+      const auto last_child = std::min(first_child + D, size);
+      auto best = first_child;
+      for (auto c = first_child + 1; c < last_child; ++c) {
+        if (m_comp(m_values[best], m_values[c])) best = c;
+      }
+      if (!m_comp(value, m_values[best])) break;
+      m_values[index] = std::move(m_values[best]);
+      index = best;
+    }
+    m_values[index] = std::move(value);
+  }
+
+  void priv_make_heap() {
+    if (m_values.size() < 2) return;
+    for (auto i = (m_values.size() - 2) / D + 1; i > 0; --i) {
+      priv_sift_down(i - 1);
+    }
+  }
+
+  vector<value_type, allocator_type> m_values;
+  value_compare m_comp;
+};
+
+/// \brief A d-ary heap of IDs, i.e., integers in [0, n), with priorities,
+/// which can be stored in persistent memory.
+/// Keeps the position of each ID in the heap; thus, the priority of an ID
+/// can be changed in place, e.g., the decrease-key operation of Dijkstra's
+/// algorithm.
+/// The position index grows to the largest ID pushed; thus, IDs should be
+/// dense, e.g., vertex IDs.
+/// \tparam Priority A priority type.
+/// \tparam Compare A comparison function type of priorities. With std::less,
+/// the top ID has the largest priority; use std::greater for the smallest.
+/// \tparam D The number of children of a node.
+/// \tparam Allocator An allocator type.
+template <typename Priority, typename Compare = std::less<Priority>,
+          std::size_t D = 4,
+          typename Allocator = manager::allocator_type<std::byte>>
+class indexed_d_ary_heap {
+  static_assert(D >= 2, "A node must have at least two children");
+
+ public:
+  using id_type = std::size_t;
+  using priority_type = Priority;
+  using priority_compare = Compare;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+
+ private:
+  struct entry_type {
+    id_type id;
+    priority_type priority;
+  };
+  using entry_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<entry_type>;
+  using position_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<size_type>;
+
+  static constexpr size_type k_npos = std::numeric_limits<size_type>::max();
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit indexed_d_ary_heap(
+      const allocator_type &allocator = allocator_type())
+      : m_entries(allocator), m_positions(allocator) {}
+
+  /// \brief Constructor.
+  /// \param comp A comparison function object.
+  /// \param allocator An allocator object.
+  indexed_d_ary_heap(const priority_compare &comp,
+                     const allocator_type &allocator)
+      : m_entries(allocator), m_positions(allocator), m_comp(comp) {}
+
+  /// \brief Adds an ID.
+  /// \return False if the ID is already in the heap; nothing is changed.
+  bool push(const id_type id, const priority_type &priority) {
+    if (contains(id)) return false;
+    if (id >= m_positions.size()) m_positions.resize(id + 1, k_npos);
+    m_entries.push_back(entry_type{id, priority});
+    m_positions[id] = m_entries.size() - 1;
+    priv_sift_up(m_entries.size() - 1);
+    return true;
+  }
+
+  /// \brief Changes the priority of an ID, moving it toward the top or the
+  /// bottom; adds the ID if it is not in the heap.
+  void update(const id_type id, const priority_type &priority) {
+    if (!contains(id)) {
+      push(id, priority);
+      return;
+    }
+    const auto index = m_positions[id];
+    const bool up = m_comp(m_entries[index].priority, priority);
+    m_entries[index].priority = priority;
+    if (up) {
+      priv_sift_up(index);
+    } else {
+      priv_sift_down(index);
+    }
+  }
+
+  /// \brief Checks if an ID is in the heap.
+  bool contains(const id_type id) const {
+    return id < m_positions.size() && m_positions[id] != k_npos;
+  }
+
+  /// \brief Returns the priority of an ID in the heap.
+  const priority_type &priority(const id_type id) const {
+    assert(contains(id));
+    return m_entries[m_positions[id]].priority;
+  }
+
+  /// \brief Returns the top ID. The heap must not be empty.
+  id_type top() const {
+    assert(!empty());
+    return m_entries.front().id;
+  }
+
+  /// \brief Returns the priority of the top ID. The heap must not be empty.
+  const priority_type &top_priority() const {
+    assert(!empty());
+    return m_entries.front().priority;
+  }
+
+  /// \brief Removes the top ID. The heap must not be empty.
+  void pop() {
+    assert(!empty());
+    priv_erase_at(0);
+  }
+
+  /// \brief Removes an ID.
+  /// \return False if the ID is not in the heap.
+  bool erase(const id_type id) {
+    if (!contains(id)) return false;
+    priv_erase_at(m_positions[id]);
+    return true;
+  }
+
+  /// \brief Returns the number of IDs.
+  size_type size() const { return m_entries.size(); }
+
+  /// \brief Checks if the heap is empty.
+  bool empty() const { return m_entries.empty(); }
+
+  /// \brief Removes all IDs. Keeps the memory of the position index.
+  void clear() {
+    for (const auto &entry : m_entries) m_positions[entry.id] = k_npos;
+    m_entries.clear();
+  }
+
+  /// \brief Reserves memory for the IDs in [0, n).
+  void reserve(const size_type n) {
+    m_entries.reserve(n);
+    if (n > m_positions.size()) m_positions.resize(n, k_npos);
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_entries.get_allocator());
+  }
+
+ private:
+  void priv_erase_at(const size_type index) {
+    m_positions[m_entries[index].id] = k_npos;
+    if (index + 1 == m_entries.size()) {
+      m_entries.pop_back();
+      return;
+    }
+    m_entries[index] = std::move(m_entries.back());
+    m_entries.pop_back();
+    m_positions[m_entries[index].id] = index;
+    if (index > 0 && m_comp(m_entries[(index - 1) / D].priority,
+                            m_entries[index].priority)) {
+      priv_sift_up(index);
+    } else {
+      priv_sift_down(index);
+    }
+  }
+
+  void priv_sift_up(size_type index) {
+    entry_type entry = std::move(m_entries[index]);
+    while (index > 0) {
+      const auto parent = (index - 1) / D;
+      if (!m_comp(m_entries[parent].priority, entry.priority)) break;
+      priv_move_entry(parent, index);
+      index = parent;
+    }
+    m_positions[entry.id] = index;
+    m_entries[index] = std::move(entry);
+  }
+
+  void priv_sift_down(size_type index) {
+    const auto size = m_entries.size();
+    entry_type entry = std::move(m_entries[index]);
+    while (true) {
+      const auto first_child = index * D + 1;
+      if (first_child >= size) break;
+      const auto last_child = std::min(first_child + D, size);
+      auto best = first_child;
+      for (auto c = first_child + 1; c < last_child; ++c) {
+        if (m_comp(m_entries[best].priority, m_entries[c].priority)) best = c;
+      }
+      if (!m_comp(entry.priority, m_entries[best].priority)) break;
+      priv_move_entry(best, index);
+      index = best;
+    }
+    m_positions[entry.id] = index;
+    m_entries[index] = std::move(entry);
+  }
+
+  void priv_move_entry(const size_type from, const size_type to) {
+    m_entries[to] = std::move(m_entries[from]);
+    m_positions[m_entries[to].id] = to;
+  }
+
+  vector<entry_type, entry_allocator_type> m_entries;
+  vector<size_type, position_allocator_type> m_positions;
+  priority_compare m_comp;
+};
+
+/// \brief A concurrent priority queue for parallel consumers, which can be
+/// stored in persistent memory.
+/// This is a MultiQueue: the items are in multiple d-ary heaps, each locked
+/// on its own. push() adds an item to a random heap that is not locked;
+/// pop() takes the better top item of two random heaps. Thus, the threads
+/// seldom wait for each other, but the priority order is relaxed: pop() may
+/// return an item that is not the top of all items, although it is usually
+/// close to the top, e.g., for task schedulers and parallel SSSP, which
+/// tolerate it.
+/// Like concurrent_map, this container does not allocate mutex objects
+/// internally but uses static ones; thus, no mutex is left locked in a
+/// datastore. Items in the queue survive closing and reopening the
+/// datastore.
+/// \tparam T A value type.
+/// \tparam Compare A comparison function type.
+/// \tparam D The number of children of a node of the heaps.
+/// \tparam Allocator An allocator type.
+template <typename T, typename Compare = std::less<T>, std::size_t D = 4,
+          typename Allocator = manager::allocator_type<T>>
+class multi_queue {
+ public:
+  using value_type = T;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using heap_type = d_ary_heap<value_type, value_compare, D, allocator_type>;
+
+ private:
+  using heap_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<heap_type>;
+  using mutex_type = metall::utility::mutex::spin_mutex;
+
+  static constexpr std::size_t k_num_locks = 1024;
+  static constexpr std::size_t k_cache_line_size = 64;
+  // The number of rounds of try-locks before pop() locks the heaps in turn
+  static constexpr int k_num_pop_attempts = 8;
+
+ public:
+  /// \brief Constructor.
+  /// \param num_heaps The number of heaps. Twice the number of threads or
+  /// more is recommended; more heaps mean less waiting and looser order.
+  /// \param comp A comparison function object.
+  /// \param allocator An allocator object.
+  explicit multi_queue(
+      const size_type num_heaps = 2 * std::thread::hardware_concurrency(),
+      const value_compare &comp = value_compare(),
+      const allocator_type &allocator = allocator_type())
+      : m_heaps(allocator), m_comp(comp) {
+    const auto n = std::max(num_heaps, size_type(1));
+    m_heaps.reserve(n);
+    for (size_type i = 0; i < n; ++i) m_heaps.emplace_back(comp, allocator);
+  }
+
+  /// \brief Constructor.
+  /// \param num_heaps The number of heaps.
+  /// \param allocator An allocator object.
+  multi_queue(const size_type num_heaps, const allocator_type &allocator)
+      : multi_queue(num_heaps, value_compare(), allocator) {}
+
+  multi_queue(const multi_queue &) = delete;
+  multi_queue(multi_queue &&) = delete;
+  multi_queue &operator=(const multi_queue &) = delete;
+  multi_queue &operator=(multi_queue &&) = delete;
+
+  /// \brief Adds an item. This function is thread-safe.
+  void push(const value_type &value) { emplace(value); }
+
+  /// \brief Adds an item. This function is thread-safe.
+  void push(value_type &&value) { emplace(std::move(value)); }
+
+  /// \brief Adds an item constructed from arguments.
+  /// This function is thread-safe.
+  template <typename... args_type>
+  void emplace(args_type &&...args) {
+    while (true) {
+      const auto index = priv_random_heap();
+      auto lock = priv_try_lock(index);
+      if (!lock.owns_lock()) continue;
+      m_heaps[index].emplace(std::forward<args_type>(args)...);
+      mdtl::atomic_fetch_add_relaxed(&m_size, size_type(1));
+      return;
+    }
+  }
+
+  /// \brief Adds the items in [first, last) to one heap.
+  /// This function is thread-safe.
+  template <typename input_iterator>
+  void push_bulk(input_iterator first, input_iterator last) {
+    const auto index = priv_random_heap();
+    auto lock = priv_lock(index);
+    auto &heap = m_heaps[index];
+    const auto old_size = heap.size();
+    heap.push_bulk(first, last);
+    mdtl::atomic_fetch_add_relaxed(&m_size, heap.size() - old_size);
+  }
+
+  /// \brief Takes an item close to the top if the queue is not empty.
+  /// This function is thread-safe.
+  /// \param value A reference to store the item.
+  /// \return True on success; false if all heaps were empty when this
+  /// function looked at them.
+  bool pop(value_type &value) {
+    for (int i = 0; i < k_num_pop_attempts; ++i) {
+      if (empty()) return false;
+      const auto index0 = priv_random_heap();
+      const auto index1 = priv_random_heap();
+      auto lock0 = priv_try_lock(index0);
+      // The two heaps may share a mutex, which this thread must not lock
+      // twice
+      auto lock1 = (priv_lock_index(index0) == priv_lock_index(index1))
+                       ? decltype(lock0)()
+                       : priv_try_lock(index1);
+      auto *const heap0 = lock0.owns_lock() ? &m_heaps[index0] : nullptr;
+      auto *const heap1 = lock1.owns_lock() ? &m_heaps[index1] : nullptr;
+      heap_type *heap = (heap0 && !heap0->empty()) ? heap0 : nullptr;
+      if (heap1 && !heap1->empty() &&
+          (!heap || m_comp(heap->top(), heap1->top()))) {
+        heap = heap1;
+      }
+      if (heap) {
+        priv_take_top(*heap, &value, 1);
+        return true;
+      }
+    }
+
+    // Many heaps are empty or locked
+    for (size_type index = 0; index < m_heaps.size(); ++index) {
+      auto lock = priv_lock(index);
+      if (!m_heaps[index].empty()) {
+        priv_take_top(m_heaps[index], &value, 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Takes up to 'n' items from the top of a random heap, in the
+  /// order of the heap, e.g., for a consumer that processes batches.
+  /// This function is thread-safe.
+  /// \param out An output iterator to store the items.
+  /// \param n The maximum number of items to take.
+  /// \return The number of items taken; 0 if all heaps were empty when this
+  /// function looked at them.
+  template <typename output_iterator>
+  size_type pop_bulk(output_iterator out, const size_type n) {
+    if (n == 0) return 0;
+    for (int i = 0; i < k_num_pop_attempts; ++i) {
+      if (empty()) return 0;
+      const auto index = priv_random_heap();
+      auto lock = priv_try_lock(index);
+      if (lock.owns_lock() && !m_heaps[index].empty()) {
+        return priv_take_top(m_heaps[index], out, n);
+      }
+    }
+
+    for (size_type index = 0; index < m_heaps.size(); ++index) {
+      auto lock = priv_lock(index);
+      if (!m_heaps[index].empty()) {
+        return priv_take_top(m_heaps[index], out, n);
+      }
+    }
+    return 0;
+  }
+
+  /// \brief Returns the number of items.
+  /// The value is approximate while other threads push or pop items.
+  size_type size() const { return mdtl::atomic_load(&m_size); }
+
+  /// \brief Checks if the queue is empty.
+  /// The value is approximate while other threads push or pop items.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns the number of heaps.
+  size_type num_heaps() const { return m_heaps.size(); }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_heaps.get_allocator());
+  }
+
+ private:
+  template <typename output_iterator>
+  size_type priv_take_top(heap_type &heap, output_iterator out,
+                          const size_type n) {
+    const auto num_popped = heap.pop_bulk(out, n);
+    mdtl::atomic_fetch_add_relaxed(&m_size, size_type(0) - num_popped);
+    return num_popped;
+  }
+
+  /// \brief Returns a random heap index, from a generator per thread.
+  size_type priv_random_heap() const {
+    // SplitMix64
+    thread_local uint64_t state =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return (z ^ (z >> 31U)) % m_heaps.size();
+  }
+
+  std::size_t priv_lock_index(const size_type heap_index) const {
+    const auto hash = (reinterpret_cast<uintptr_t>(this) / k_cache_line_size) *
+                      0x9E3779B97F4A7C15ULL;
+    return ((hash >> 32U) + heap_index) % k_num_locks;
+  }
+
+  auto priv_lock(const size_type heap_index) const {
+    return metall::utility::mutex::mutex_lock<k_num_locks, mutex_type>(
+        priv_lock_index(heap_index));
+  }
+
+  auto priv_try_lock(const size_type heap_index) const {
+    return metall::utility::mutex::mutex_try_lock<k_num_locks, mutex_type>(
+        priv_lock_index(heap_index));
+  }
+
+  vector<heap_type, heap_allocator_type> m_heaps;
+  value_compare m_comp;
+  size_type m_size{0};
+};
 
 }  // namespace metall::container
 
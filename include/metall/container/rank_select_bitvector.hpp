@@ -0,0 +1,235 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_RANK_SELECT_BITVECTOR_HPP
+#define METALL_CONTAINER_RANK_SELECT_BITVECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/bitset.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A bit vector with rank and select queries, which can be stored in
+/// persistent memory, e.g., to map sparse vertex IDs to dense ones (rank) and
+/// back (select), or to mark the vertices that have a property.
+/// The bits are stored as in mtlldetail::bitset. build() computes the
+/// number of ones before every 512 bits, which takes 1/8 more memory; a
+/// rank query then reads the count and at most eight words, and a select
+/// query searches the counts.
+/// \tparam _allocator_type An allocator type.
+template <typename _allocator_type = metall::manager::allocator_type<std::byte>>
+class rank_select_bitvector {
+ public:
+  using size_type = std::size_t;
+  using allocator_type = _allocator_type;
+
+ private:
+  using word_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<uint64_t>;
+
+  static constexpr size_type k_word_bits = 64;
+  static constexpr size_type k_superblock_words = 8;
+  static constexpr size_type k_superblock_bits =
+      k_word_bits * k_superblock_words;
+
+ public:
+  /// \brief Constructor.
+  /// \param n The number of bits, which are 0.
+  /// \param allocator An allocator object.
+  explicit rank_select_bitvector(
+      const size_type n = 0, const allocator_type &allocator = allocator_type())
+      : m_words(allocator), m_ranks(allocator) {
+    resize(n);
+  }
+
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit rank_select_bitvector(const allocator_type &allocator)
+      : rank_select_bitvector(0, allocator) {}
+
+  /// \brief Returns the bit at 'index'.
+  bool operator[](const size_type index) const {
+    assert(index < m_size);
+    return mdtl::bitset_detail::get(m_words.data(), index);
+  }
+
+  /// \brief Returns the bit at 'index'.
+  bool get(const size_type index) const { return (*this)[index]; }
+
+  /// \brief Sets the bit at 'index'. Call build() before rank or select
+  /// queries after modifications.
+  void set(const size_type index, const bool value = true) {
+    assert(index < m_size);
+    if (value) {
+      mdtl::bitset_detail::set(m_words.data(), index);
+    } else {
+      mdtl::bitset_detail::reset(m_words.data(), index);
+    }
+  }
+
+  /// \brief Appends a bit. Call build() before rank or select queries after
+  /// modifications.
+  void push_back(const bool value) {
+    resize(m_size + 1);
+    set(m_size - 1, value);
+  }
+
+  /// \brief Changes the number of bits; new bits are 0. Call build() before
+  /// rank or select queries after modifications.
+  void resize(const size_type n) {
+    const auto num_tail_bits = m_words.size() * k_word_bits - n;
+    if (n < m_size && num_tail_bits > 0) {
+      // Clears the bits beyond the new size so that they are 0 if it grows
+      mdtl::bitset_detail::update_n_bits(m_words.data(), n, num_tail_bits,
+                                        false);
+    }
+    m_size = n;
+    m_words.resize(mdtl::bitset_detail::num_blocks<uint64_t>(n), 0);
+  }
+
+  /// \brief Computes the directory for rank and select queries.
+  void build() {
+    const auto num_superblocks =
+        (m_words.size() + k_superblock_words - 1) / k_superblock_words;
+    m_ranks.assign(num_superblocks + 1, 0);
+    uint64_t count = 0;
+    for (size_type i = 0; i < m_words.size(); ++i) {
+      if (i % k_superblock_words == 0) m_ranks[i / k_superblock_words] = count;
+      count += mdtl::popcountll(m_words[i]);
+    }
+    m_ranks[num_superblocks] = count;
+  }
+
+  /// \brief Returns the number of ones in [0, index). Requires build().
+  size_type rank1(const size_type index) const {
+    assert(index <= m_size);
+    assert(!m_ranks.empty());
+    const auto word = index / k_word_bits;
+    const auto superblock = word / k_superblock_words;
+    size_type count = m_ranks[superblock];
+    for (auto w = superblock * k_superblock_words; w < word; ++w) {
+      count += mdtl::popcountll(m_words[w]);
+    }
+    const auto local = index % k_word_bits;
+    // The bits are stored from the most significant one in each word
+    if (local > 0) {
+      count += mdtl::popcountll(m_words[word] >> (k_word_bits - local));
+    }
+    return count;
+  }
+
+  /// \brief Returns the number of zeros in [0, index). Requires build().
+  size_type rank0(const size_type index) const {
+    return index - rank1(index);
+  }
+
+  /// \brief Returns the position of the k-th one (0-based).
+  /// k must be less than num_ones(). Requires build().
+  size_type select1(const size_type k) const {
+    assert(k < num_ones());
+    return priv_select<true>(k);
+  }
+
+  /// \brief Returns the position of the k-th zero (0-based).
+  /// k must be less than num_zeros(). Requires build().
+  size_type select0(const size_type k) const {
+    assert(k < num_zeros());
+    return priv_select<false>(k);
+  }
+
+  /// \brief Returns the number of ones. Requires build().
+  size_type num_ones() const { return m_ranks.empty() ? 0 : m_ranks.back(); }
+
+  /// \brief Returns the number of zeros. Requires build().
+  size_type num_zeros() const { return m_size - num_ones(); }
+
+  size_type size() const { return m_size; }
+
+  bool empty() const { return m_size == 0; }
+
+  /// \brief Returns the memory used by the bits and the directory in bytes.
+  size_type memory_bytes() const {
+    return (m_words.size() + m_ranks.size()) * sizeof(uint64_t);
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_words.get_allocator());
+  }
+
+ private:
+  /// \brief Returns the number of bits equal to 'bit' before a superblock.
+  template <bool bit>
+  size_type priv_superblock_rank(const size_type superblock) const {
+    if constexpr (bit) {
+      return m_ranks[superblock];
+    } else {
+      return superblock * k_superblock_bits - m_ranks[superblock];
+    }
+  }
+
+  template <bool bit>
+  size_type priv_select(size_type k) const {
+    // The last superblock whose rank is <= k
+    size_type lo = 0;
+    size_type hi = m_ranks.size() - 1;
+    while (hi - lo > 1) {
+      const auto mid = lo + (hi - lo) / 2;
+      if (priv_superblock_rank<bit>(mid) <= k) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    k -= priv_superblock_rank<bit>(lo);
+
+    for (auto w = lo * k_superblock_words;; ++w) {
+      assert(w < m_words.size());
+      const auto word = bit ? m_words[w] : ~m_words[w];
+      const auto count = size_type(mdtl::popcountll(word));
+      if (k < count) return w * k_word_bits + priv_select_in_word(word, k);
+      k -= count;
+    }
+  }
+
+  /// \brief Returns the position of the k-th set bit from the most
+  /// significant one.
+  static size_type priv_select_in_word(const uint64_t word, const size_type k) {
+    // The same bit as the j-th set bit from the least significant one
+    const auto j = mdtl::popcountll(word) - 1 - k;
+#ifdef __BMI2__
+    const auto bit = _pdep_u64(uint64_t(1) << j, word);
+#else
+    auto w = word;
+    for (size_type i = 0; i < j; ++i) w &= w - 1;
+    const auto bit = w & (~w + 1);
+#endif
+    return k_word_bits - 1 - mdtl::ctzll(bit);
+  }
+
+  vector<uint64_t, word_allocator_type> m_words;
+  vector<uint64_t, word_allocator_type> m_ranks;
+  size_type m_size{0};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_RANK_SELECT_BITVECTOR_HPP
@@ -0,0 +1,695 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_ROARING_BITMAP_HPP
+#define METALL_CONTAINER_ROARING_BITMAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A compressed set of 32-bit integers (a Roaring bitmap) which can be
+/// stored in persistent memory, e.g., the sets of vertex IDs visited by BFS.
+/// The integers are split by their upper 16 bits into containers; a
+/// container of up to 4096 integers is a sorted array of their lower 16 bits,
+/// and a larger one is a bitmap of 2^16 bits (8 KB). Thus, a sparse set
+/// takes about 2 bytes per integer and a dense one 1 bit per integer.
+/// Set operations combine the containers with the same upper bits; the
+/// bitmaps are combined by words, with AVX2 if available.
+/// \tparam _allocator_type An allocator type.
+template <typename _allocator_type = metall::manager::allocator_type<std::byte>>
+class roaring_bitmap {
+ public:
+  using value_type = uint32_t;
+  using size_type = std::size_t;
+  using allocator_type = _allocator_type;
+
+ private:
+  using word_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<uint64_t>;
+  using word_allocator_traits = std::allocator_traits<word_allocator_type>;
+  using word_pointer = typename word_allocator_traits::pointer;
+
+  static constexpr uint8_t k_array = 0;
+  static constexpr uint8_t k_bitmap = 1;
+  static constexpr uint32_t k_max_array_size = 4096;
+  static constexpr uint32_t k_bitmap_words = 1024;
+  static constexpr uint32_t k_min_array_capacity = 4;
+
+  struct container_type {
+    uint16_t key{0};
+    uint8_t kind{k_array};
+    uint32_t cardinality{0};
+    // The number of values of an array, or k_bitmap_words
+    uint32_t capacity{0};
+    word_pointer data{nullptr};
+  };
+  using container_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<container_type>;
+  using container_vector = vector<container_type, container_allocator_type>;
+
+  enum class word_operation { k_or, k_and, k_andnot };
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit roaring_bitmap(const allocator_type &allocator = allocator_type())
+      : m_containers(allocator) {}
+
+  /// \brief Copy constructor.
+  roaring_bitmap(const roaring_bitmap &other)
+      : roaring_bitmap(other, other.get_allocator()) {}
+
+  /// \brief Allocator-extended copy constructor.
+  roaring_bitmap(const roaring_bitmap &other, const allocator_type &allocator)
+      : m_containers(allocator), m_cardinality(other.m_cardinality) {
+    m_containers.reserve(other.m_containers.size());
+    for (const auto &container : other.m_containers) {
+      m_containers.push_back(priv_clone(container));
+    }
+  }
+
+  /// \brief Move constructor.
+  roaring_bitmap(roaring_bitmap &&other) noexcept
+      : m_containers(std::move(other.m_containers)),
+        m_cardinality(std::exchange(other.m_cardinality, 0)) {}
+
+  /// \brief Copy assignment operator.
+  roaring_bitmap &operator=(const roaring_bitmap &other) {
+    if (this != &other) {
+      roaring_bitmap copy(other, get_allocator());
+      swap(copy);
+    }
+    return *this;
+  }
+
+  /// \brief Move assignment operator.
+  roaring_bitmap &operator=(roaring_bitmap &&other) noexcept {
+    if (this != &other) {
+      clear();
+      m_containers = std::move(other.m_containers);
+      m_cardinality = std::exchange(other.m_cardinality, 0);
+    }
+    return *this;
+  }
+
+  ~roaring_bitmap() noexcept { clear(); }
+
+  void swap(roaring_bitmap &other) noexcept {
+    using std::swap;
+    swap(m_containers, other.m_containers);
+    swap(m_cardinality, other.m_cardinality);
+  }
+
+  // -------------------- //
+  // Modifiers
+  // -------------------- //
+  /// \brief Adds an integer.
+  /// \return Returns true if it was not in the set.
+  bool add(const value_type value) {
+    const auto index = priv_find_or_insert(priv_high(value));
+    return priv_add(m_containers[index], priv_low(value));
+  }
+
+  /// \brief Adds the integers in [first, last), which are added fastest in
+  /// sorted order.
+  template <typename input_iterator>
+  void add(input_iterator first, const input_iterator last) {
+    size_type index = 0;
+    bool has_index = false;
+    for (; first != last; ++first) {
+      const auto value = value_type(*first);
+      if (!has_index || m_containers[index].key != priv_high(value)) {
+        index = priv_find_or_insert(priv_high(value));
+        has_index = true;
+      }
+      priv_add(m_containers[index], priv_low(value));
+    }
+  }
+
+  /// \brief Removes an integer.
+  /// \return Returns true if it was in the set.
+  bool remove(const value_type value) {
+    const auto index = priv_find(priv_high(value));
+    if (index == m_containers.size()) return false;
+    auto &container = m_containers[index];
+    if (!priv_remove(container, priv_low(value))) return false;
+    if (container.cardinality == 0) {
+      priv_free(container);
+      m_containers.erase(m_containers.begin() + index);
+    }
+    return true;
+  }
+
+  /// \brief Removes all integers.
+  void clear() noexcept {
+    for (auto &container : m_containers) priv_free(container);
+    m_containers.clear();
+    m_cardinality = 0;
+  }
+
+  // -------------------- //
+  // Look up
+  // -------------------- //
+  /// \brief Checks if the set contains an integer.
+  bool contains(const value_type value) const {
+    const auto index = priv_find(priv_high(value));
+    if (index == m_containers.size()) return false;
+    const auto &container = m_containers[index];
+    const auto low = priv_low(value);
+    if (container.kind == k_bitmap) {
+      return (priv_bitmap(container)[low / 64] >> (low % 64)) & 1ULL;
+    }
+    const auto *const array = priv_array(container);
+    return std::binary_search(array, array + container.cardinality, low);
+  }
+
+  /// \brief Returns the number of integers.
+  size_type size() const { return m_cardinality; }
+
+  bool empty() const { return m_cardinality == 0; }
+
+  /// \brief Calls a function with every integer in ascending order.
+  /// \param func A function object that takes 'value_type'.
+  template <typename function_type>
+  void for_each(function_type &&func) const {
+    for (const auto &container : m_containers) {
+      const value_type base = value_type(container.key) << 16U;
+      if (container.kind == k_array) {
+        const auto *const array = priv_array(container);
+        for (uint32_t i = 0; i < container.cardinality; ++i) {
+          func(base | array[i]);
+        }
+        continue;
+      }
+      const auto *const words = priv_bitmap(container);
+      for (uint32_t w = 0; w < k_bitmap_words; ++w) {
+        for (auto word = words[w]; word != 0; word &= word - 1) {
+          func(base | (w * 64 + mdtl::ctzll(word)));
+        }
+      }
+    }
+  }
+
+  /// \brief Writes the integers to 'out' in ascending order.
+  template <typename output_iterator>
+  output_iterator copy_to(output_iterator out) const {
+    for_each([&out](const value_type value) { *out++ = value; });
+    return out;
+  }
+
+  // -------------------- //
+  // Set operations
+  // -------------------- //
+  /// \brief Adds the integers in 'other' (union).
+  roaring_bitmap &operator|=(const roaring_bitmap &other) {
+    priv_combine(other, word_operation::k_or);
+    return *this;
+  }
+
+  /// \brief Removes the integers not in 'other' (intersection).
+  roaring_bitmap &operator&=(const roaring_bitmap &other) {
+    priv_combine(other, word_operation::k_and);
+    return *this;
+  }
+
+  /// \brief Removes the integers in 'other' (difference, and-not).
+  roaring_bitmap &operator-=(const roaring_bitmap &other) {
+    priv_combine(other, word_operation::k_andnot);
+    return *this;
+  }
+
+  /// \brief Returns the number of integers in both sets, without making
+  /// their intersection.
+  size_type intersection_size(const roaring_bitmap &other) const {
+    size_type count = 0;
+    size_type i = 0;
+    size_type j = 0;
+    while (i < m_containers.size() && j < other.m_containers.size()) {
+      const auto &a = m_containers[i];
+      const auto &b = other.m_containers[j];
+      if (a.key < b.key) {
+        ++i;
+      } else if (b.key < a.key) {
+        ++j;
+      } else {
+        count += priv_intersection_size(a, b);
+        ++i;
+        ++j;
+      }
+    }
+    return count;
+  }
+
+  // -------------------- //
+  // Misc
+  // -------------------- //
+  /// \brief Returns the memory used by the containers in bytes.
+  size_type memory_bytes() const {
+    size_type bytes = m_containers.capacity() * sizeof(container_type);
+    for (const auto &container : m_containers) {
+      bytes += priv_num_words(container) * sizeof(uint64_t);
+    }
+    return bytes;
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const {
+    return allocator_type(m_containers.get_allocator());
+  }
+
+ private:
+  static uint16_t priv_high(const value_type value) { return value >> 16U; }
+  static uint16_t priv_low(const value_type value) { return value & 0xFFFFU; }
+
+  static uint16_t *priv_array(const container_type &container) {
+    return reinterpret_cast<uint16_t *>(
+        metall::to_raw_pointer(container.data));
+  }
+
+  static uint64_t *priv_bitmap(const container_type &container) {
+    return metall::to_raw_pointer(container.data);
+  }
+
+  static size_type priv_num_words(const container_type &container) {
+    return (container.kind == k_bitmap) ? k_bitmap_words
+                                        : (container.capacity + 3) / 4;
+  }
+
+  // ---------- Container memory ---------- //
+  container_type priv_new_array(const uint16_t key, const uint32_t capacity) {
+    container_type container;
+    container.key = key;
+    container.kind = k_array;
+    container.capacity = std::max(capacity, k_min_array_capacity);
+    word_allocator_type alloc(get_allocator());
+    container.data =
+        word_allocator_traits::allocate(alloc, priv_num_words(container));
+    return container;
+  }
+
+  /// \brief Returns an empty bitmap container.
+  container_type priv_new_bitmap(const uint16_t key) {
+    container_type container;
+    container.key = key;
+    container.kind = k_bitmap;
+    container.capacity = k_bitmap_words;
+    word_allocator_type alloc(get_allocator());
+    container.data = word_allocator_traits::allocate(alloc, k_bitmap_words);
+    std::fill_n(priv_bitmap(container), k_bitmap_words, 0ULL);
+    return container;
+  }
+
+  void priv_free(container_type &container) noexcept {
+    if (!container.data) return;
+    word_allocator_type alloc(get_allocator());
+    word_allocator_traits::deallocate(alloc, container.data,
+                                      priv_num_words(container));
+    container.data = nullptr;
+  }
+
+  container_type priv_clone(const container_type &source) {
+    auto container = (source.kind == k_bitmap)
+                         ? priv_new_bitmap(source.key)
+                         : priv_new_array(source.key, source.cardinality);
+    container.cardinality = source.cardinality;
+    if (source.kind == k_bitmap) {
+      std::copy_n(priv_bitmap(source), k_bitmap_words, priv_bitmap(container));
+    } else {
+      std::copy_n(priv_array(source), source.cardinality,
+                  priv_array(container));
+    }
+    return container;
+  }
+
+  /// \brief Converts an array container to a bitmap one.
+  void priv_to_bitmap(container_type &container) {
+    auto bitmap = priv_new_bitmap(container.key);
+    auto *const words = priv_bitmap(bitmap);
+    const auto *const array = priv_array(container);
+    for (uint32_t i = 0; i < container.cardinality; ++i) {
+      words[array[i] / 64] |= 1ULL << (array[i] % 64);
+    }
+    bitmap.cardinality = container.cardinality;
+    priv_free(container);
+    container = bitmap;
+  }
+
+  /// \brief Converts a bitmap container to an array one.
+  void priv_to_array(container_type &container) {
+    auto array = priv_new_array(container.key, container.cardinality);
+    auto *out = priv_array(array);
+    const auto *const words = priv_bitmap(container);
+    for (uint32_t w = 0; w < k_bitmap_words; ++w) {
+      for (auto word = words[w]; word != 0; word &= word - 1) {
+        *out++ = uint16_t(w * 64 + mdtl::ctzll(word));
+      }
+    }
+    array.cardinality = container.cardinality;
+    priv_free(container);
+    container = array;
+  }
+
+  // ---------- Single values ---------- //
+  size_type priv_find(const uint16_t key) const {
+    const auto itr = std::lower_bound(
+        m_containers.begin(), m_containers.end(), key,
+        [](const container_type &c, const uint16_t k) { return c.key < k; });
+    if (itr == m_containers.end() || itr->key != key) {
+      return m_containers.size();
+    }
+    return std::distance(m_containers.begin(), itr);
+  }
+
+  size_type priv_find_or_insert(const uint16_t key) {
+    const auto itr = std::lower_bound(
+        m_containers.begin(), m_containers.end(), key,
+        [](const container_type &c, const uint16_t k) { return c.key < k; });
+    const size_type index = std::distance(m_containers.begin(), itr);
+    if (itr == m_containers.end() || itr->key != key) {
+      m_containers.insert(itr, priv_new_array(key, k_min_array_capacity));
+    }
+    return index;
+  }
+
+  bool priv_add(container_type &container, const uint16_t low) {
+    if (container.kind == k_bitmap) {
+      auto &word = priv_bitmap(container)[low / 64];
+      const auto bit = 1ULL << (low % 64);
+      if (word & bit) return false;
+      word |= bit;
+      ++container.cardinality;
+      ++m_cardinality;
+      return true;
+    }
+
+    auto *array = priv_array(container);
+    auto *const end = array + container.cardinality;
+    auto *const pos = std::lower_bound(array, end, low);
+    if (pos != end && *pos == low) return false;
+    if (container.cardinality == k_max_array_size) {
+      priv_to_bitmap(container);
+      return priv_add(container, low);
+    }
+    const auto offset = pos - array;
+    if (container.cardinality == container.capacity) {
+      auto grown = priv_new_array(
+          container.key, std::min(container.capacity * 2, k_max_array_size));
+      std::copy_n(array, container.cardinality, priv_array(grown));
+      grown.cardinality = container.cardinality;
+      priv_free(container);
+      container = grown;
+      array = priv_array(container);
+    }
+    std::copy_backward(array + offset, array + container.cardinality,
+                       array + container.cardinality + 1);
+    array[offset] = low;
+    ++container.cardinality;
+    ++m_cardinality;
+    return true;
+  }
+
+  bool priv_remove(container_type &container, const uint16_t low) {
+    if (container.kind == k_bitmap) {
+      auto &word = priv_bitmap(container)[low / 64];
+      const auto bit = 1ULL << (low % 64);
+      if (!(word & bit)) return false;
+      word &= ~bit;
+      --container.cardinality;
+      --m_cardinality;
+      if (container.cardinality == k_max_array_size) priv_to_array(container);
+      return true;
+    }
+
+    auto *const array = priv_array(container);
+    auto *const end = array + container.cardinality;
+    auto *const pos = std::lower_bound(array, end, low);
+    if (pos == end || *pos != low) return false;
+    std::copy(pos + 1, end, pos);
+    --container.cardinality;
+    --m_cardinality;
+    return true;
+  }
+
+  // ---------- Set operations ---------- //
+  void priv_combine(const roaring_bitmap &other, const word_operation op) {
+    if (&other == this) {
+      if (op == word_operation::k_andnot) clear();
+      return;
+    }
+
+    container_vector result(get_allocator());
+    result.reserve(op == word_operation::k_or
+                       ? m_containers.size() + other.m_containers.size()
+                       : m_containers.size());
+    size_type i = 0;
+    size_type j = 0;
+    while (i < m_containers.size() || j < other.m_containers.size()) {
+      auto *const a = (i < m_containers.size()) ? &m_containers[i] : nullptr;
+      const auto *const b =
+          (j < other.m_containers.size()) ? &other.m_containers[j] : nullptr;
+      if (a && (!b || a->key < b->key)) {
+        // Only in this set
+        if (op == word_operation::k_and) {
+          priv_free(*a);
+        } else {
+          result.push_back(*a);
+        }
+        ++i;
+      } else if (!a || b->key < a->key) {
+        // Only in the other set
+        if (op == word_operation::k_or) result.push_back(priv_clone(*b));
+        ++j;
+      } else {
+        auto combined = priv_combine(*a, *b, op);
+        priv_free(*a);
+        if (combined.cardinality > 0) {
+          result.push_back(combined);
+        } else {
+          priv_free(combined);
+        }
+        ++i;
+        ++j;
+      }
+    }
+
+    m_containers.swap(result);
+    m_cardinality = 0;
+    for (const auto &container : m_containers) {
+      m_cardinality += container.cardinality;
+    }
+  }
+
+  /// \brief Returns a new container of two containers with the same key.
+  container_type priv_combine(const container_type &a,
+                              const container_type &b,
+                              const word_operation op) {
+    if (a.kind == k_bitmap && b.kind == k_bitmap) {
+      auto bitmap = priv_new_bitmap(a.key);
+      bitmap.cardinality = priv_combine_words(
+          priv_bitmap(a), priv_bitmap(b), priv_bitmap(bitmap), op);
+      if (bitmap.cardinality <= k_max_array_size) priv_to_array(bitmap);
+      return bitmap;
+    }
+
+    if (a.kind == k_array && b.kind == k_array) {
+      const auto *const x = priv_array(a);
+      const auto *const y = priv_array(b);
+      const auto x_end = x + a.cardinality;
+      const auto y_end = y + b.cardinality;
+      if (op == word_operation::k_or &&
+          a.cardinality + b.cardinality > k_max_array_size) {
+        auto bitmap = priv_new_bitmap(a.key);
+        priv_set_bits(x, a.cardinality, priv_bitmap(bitmap));
+        priv_set_bits(y, b.cardinality, priv_bitmap(bitmap));
+        bitmap.cardinality = priv_count_bits(priv_bitmap(bitmap));
+        if (bitmap.cardinality <= k_max_array_size) priv_to_array(bitmap);
+        return bitmap;
+      }
+      const auto capacity = (op == word_operation::k_or)
+                                ? a.cardinality + b.cardinality
+                                : a.cardinality;
+      auto array = priv_new_array(a.key, capacity);
+      auto *const out = priv_array(array);
+      uint16_t *end = nullptr;
+      if (op == word_operation::k_or) {
+        end = std::set_union(x, x_end, y, y_end, out);
+      } else if (op == word_operation::k_and) {
+        end = std::set_intersection(x, x_end, y, y_end, out);
+      } else {
+        end = std::set_difference(x, x_end, y, y_end, out);
+      }
+      array.cardinality = end - out;
+      return array;
+    }
+
+    if (op == word_operation::k_or) {
+      // A bitmap plus the values of an array
+      const auto &bitmap = (a.kind == k_bitmap) ? a : b;
+      const auto &array = (a.kind == k_bitmap) ? b : a;
+      auto result = priv_clone(bitmap);
+      priv_set_bits(priv_array(array), array.cardinality, priv_bitmap(result));
+      result.cardinality = priv_count_bits(priv_bitmap(result));
+      return result;
+    }
+
+    if (a.kind == k_array) {
+      // The values of the array in (and) or not in (andnot) the bitmap
+      auto result = priv_new_array(a.key, a.cardinality);
+      const auto *const words = priv_bitmap(b);
+      const auto *const values = priv_array(a);
+      auto *out = priv_array(result);
+      const bool keep_found = (op == word_operation::k_and);
+      for (uint32_t i = 0; i < a.cardinality; ++i) {
+        const bool found = (words[values[i] / 64] >> (values[i] % 64)) & 1ULL;
+        if (found == keep_found) *out++ = values[i];
+      }
+      result.cardinality = out - priv_array(result);
+      return result;
+    }
+
+    // A bitmap and an array
+    if (op == word_operation::k_and) {
+      auto result = priv_new_array(a.key, b.cardinality);
+      const auto *const words = priv_bitmap(a);
+      const auto *const values = priv_array(b);
+      auto *out = priv_array(result);
+      for (uint32_t i = 0; i < b.cardinality; ++i) {
+        if ((words[values[i] / 64] >> (values[i] % 64)) & 1ULL) {
+          *out++ = values[i];
+        }
+      }
+      result.cardinality = out - priv_array(result);
+      return result;
+    }
+    auto result = priv_clone(a);
+    auto *const words = priv_bitmap(result);
+    const auto *const values = priv_array(b);
+    for (uint32_t i = 0; i < b.cardinality; ++i) {
+      words[values[i] / 64] &= ~(1ULL << (values[i] % 64));
+    }
+    result.cardinality = priv_count_bits(words);
+    if (result.cardinality <= k_max_array_size) priv_to_array(result);
+    return result;
+  }
+
+  size_type priv_intersection_size(const container_type &a,
+                                   const container_type &b) const {
+    if (a.kind == k_bitmap && b.kind == k_bitmap) {
+      const auto *const x = priv_bitmap(a);
+      const auto *const y = priv_bitmap(b);
+      size_type count = 0;
+      for (uint32_t w = 0; w < k_bitmap_words; ++w) {
+        count += mdtl::popcountll(x[w] & y[w]);
+      }
+      return count;
+    }
+    if (a.kind == k_array && b.kind == k_array) {
+      const auto *x = priv_array(a);
+      const auto *y = priv_array(b);
+      const auto *const x_end = x + a.cardinality;
+      const auto *const y_end = y + b.cardinality;
+      size_type count = 0;
+      while (x != x_end && y != y_end) {
+        if (*x < *y) {
+          ++x;
+        } else if (*y < *x) {
+          ++y;
+        } else {
+          ++count;
+          ++x;
+          ++y;
+        }
+      }
+      return count;
+    }
+    const auto &bitmap = (a.kind == k_bitmap) ? a : b;
+    const auto &array = (a.kind == k_bitmap) ? b : a;
+    const auto *const words = priv_bitmap(bitmap);
+    const auto *const values = priv_array(array);
+    size_type count = 0;
+    for (uint32_t i = 0; i < array.cardinality; ++i) {
+      count += (words[values[i] / 64] >> (values[i] % 64)) & 1ULL;
+    }
+    return count;
+  }
+
+  static void priv_set_bits(const uint16_t *const values, const uint32_t n,
+                            uint64_t *const words) {
+    for (uint32_t i = 0; i < n; ++i) {
+      words[values[i] / 64] |= 1ULL << (values[i] % 64);
+    }
+  }
+
+  static uint32_t priv_count_bits(const uint64_t *const words) {
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < k_bitmap_words; ++w) {
+      count += mdtl::popcountll(words[w]);
+    }
+    return count;
+  }
+
+  /// \brief Combines two bitmaps into 'out'.
+  /// \return The number of bits set in 'out'.
+  static uint32_t priv_combine_words(const uint64_t *const a,
+                                     const uint64_t *const b,
+                                     uint64_t *const out,
+                                     const word_operation op) {
+#ifdef __AVX2__
+    for (uint32_t w = 0; w < k_bitmap_words; w += 4) {
+      const __m256i x =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + w));
+      const __m256i y =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + w));
+      __m256i z;
+      if (op == word_operation::k_or) {
+        z = _mm256_or_si256(x, y);
+      } else if (op == word_operation::k_and) {
+        z = _mm256_and_si256(x, y);
+      } else {
+        z = _mm256_andnot_si256(y, x);
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w), z);
+    }
+#else
+    for (uint32_t w = 0; w < k_bitmap_words; ++w) {
+      if (op == word_operation::k_or) {
+        out[w] = a[w] | b[w];
+      } else if (op == word_operation::k_and) {
+        out[w] = a[w] & b[w];
+      } else {
+        out[w] = a[w] & ~b[w];
+      }
+    }
+#endif
+    return priv_count_bits(out);
+  }
+
+  container_vector m_containers;
+  size_type m_cardinality{0};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_ROARING_BITMAP_HPP
@@ -0,0 +1,199 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_SEGMENTED_QUEUE_HPP
+#define METALL_CONTAINER_SEGMENTED_QUEUE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/utility/mutex.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief An unbounded multi-producer multi-consumer FIFO queue which can be
+/// stored in persistent memory.
+/// Items are stored in a linked list of fixed-size segments. Producers
+/// serialize only with producers and consumers only with consumers; a
+/// producer and a consumer synchronize through the per-segment write index.
+/// A segment is freed as soon as it has been consumed.
+/// Like concurrent_map, this container does not allocate mutex objects
+/// internally but uses static ones; thus, no mutex is left locked in a
+/// datastore. Items in the queue survive closing and reopening the
+/// datastore.
+/// \tparam _value_type A value type.
+/// \tparam _allocator_type An allocator type.
+/// \tparam k_segment_capacity The number of items in a segment.
+template <typename _value_type,
+          typename _allocator_type = std::allocator<_value_type>,
+          std::size_t k_segment_capacity = 1024>
+class segmented_queue {
+  static_assert(k_segment_capacity > 0, "Segment capacity must be positive");
+
+ public:
+  using value_type = _value_type;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+
+ private:
+  struct segment_type;
+  using segment_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<segment_type>;
+  using segment_pointer =
+      typename std::allocator_traits<segment_allocator_type>::pointer;
+
+  struct segment_type {
+    segment_pointer next{nullptr};
+    // Set after 'next' is set; the producers do not touch this segment
+    // afterward
+    uint32_t has_next{0};
+    uint64_t write_index{0};
+    uint64_t read_index{0};
+    alignas(value_type) unsigned char
+        storage[sizeof(value_type) * k_segment_capacity];
+
+    value_type *items() {
+      return std::launder(reinterpret_cast<value_type *>(storage));
+    }
+  };
+
+  // Must be even; a queue uses two consecutive mutexes
+  static constexpr std::size_t k_num_locks = 256;
+  static constexpr std::size_t k_cache_line_size = 64;
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit segmented_queue(const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {
+    auto *const segment = priv_new_segment();
+    m_head = segment;
+    m_tail = segment;
+  }
+
+  /// \brief Destructor. Destroys the remaining items.
+  ~segmented_queue() noexcept {
+    auto *segment = metall::to_raw_pointer(m_head);
+    while (segment) {
+      auto *const next = metall::to_raw_pointer(segment->next);
+      for (auto i = segment->read_index; i < segment->write_index; ++i) {
+        segment->items()[i].~value_type();
+      }
+      priv_delete_segment(segment);
+      segment = next;
+    }
+  }
+
+  segmented_queue(const segmented_queue &) = delete;
+  segmented_queue(segmented_queue &&) = delete;
+  segmented_queue &operator=(const segmented_queue &) = delete;
+  segmented_queue &operator=(segmented_queue &&) = delete;
+
+  /// \brief Adds an item. This function is thread-safe.
+  void push(const value_type &value) { emplace(value); }
+
+  /// \brief Adds an item. This function is thread-safe.
+  void push(value_type &&value) { emplace(std::move(value)); }
+
+  /// \brief Adds an item constructed from arguments.
+  /// This function is thread-safe.
+  template <typename... args_type>
+  void emplace(args_type &&...args) {
+    auto lock = priv_lock(0);
+    auto *segment = metall::to_raw_pointer(m_tail);
+    if (segment->write_index == k_segment_capacity) {
+      auto *const new_segment = priv_new_segment();
+      segment->next = new_segment;
+      mdtl::atomic_store(&segment->has_next, uint32_t(1));
+      m_tail = new_segment;
+      segment = new_segment;
+    }
+    const auto index = segment->write_index;
+    new (segment->items() + index) value_type(std::forward<args_type>(args)...);
+    // Count first so that size() does not underflow
+    mdtl::atomic_fetch_add_relaxed(&m_size, size_type(1));
+    mdtl::atomic_store(&segment->write_index, index + 1);
+  }
+
+  /// \brief Takes the oldest item if the queue is not empty.
+  /// This function is thread-safe.
+  /// \param value A reference to store the item.
+  /// \return True on success; false if the queue is empty.
+  bool pop(value_type &value) {
+    auto lock = priv_lock(1);
+    while (true) {
+      auto *const segment = metall::to_raw_pointer(m_head);
+      const auto index = segment->read_index;
+      if (index < mdtl::atomic_load(&segment->write_index)) {
+        auto &item = segment->items()[index];
+        value = std::move(item);
+        item.~value_type();
+        segment->read_index = index + 1;
+        mdtl::atomic_fetch_add_relaxed(&m_size, size_type(-1));
+        return true;
+      }
+      if (index < k_segment_capacity ||
+          mdtl::atomic_load(&segment->has_next) == 0) {
+        return false;  // Empty
+      }
+      m_head = segment->next;
+      priv_delete_segment(segment);
+    }
+  }
+
+  /// \brief Returns the number of items.
+  /// The value is approximate while other threads push or pop items.
+  size_type size() const { return mdtl::atomic_load(&m_size); }
+
+  /// \brief Checks if the queue is empty.
+  /// The value is approximate while other threads push or pop items.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return allocator_type(m_allocator); }
+
+ private:
+  /// \brief Locks the producer side (0) or the consumer side (1).
+  auto priv_lock(const std::size_t side) const {
+    const auto hash = (reinterpret_cast<uintptr_t>(this) / k_cache_line_size) *
+                      0x9E3779B97F4A7C15ULL;
+    const auto index = ((hash >> 32U) % (k_num_locks / 2)) * 2 + side;
+    return metall::utility::mutex::mutex_lock<k_num_locks>(index);
+  }
+
+  segment_type *priv_new_segment() {
+    auto ptr = std::allocator_traits<segment_allocator_type>::allocate(
+        m_allocator, 1);
+    return new (metall::to_raw_pointer(ptr)) segment_type();
+  }
+
+  void priv_delete_segment(segment_type *const segment) noexcept {
+    segment->~segment_type();
+    std::allocator_traits<segment_allocator_type>::deallocate(
+        m_allocator, segment_pointer(segment), 1);
+  }
+
+  segment_allocator_type m_allocator;
+  size_type m_size{0};
+  // Accessed only by consumers
+  segment_pointer m_head{nullptr};
+  char m_padding[k_cache_line_size];
+  // Accessed only by producers
+  segment_pointer m_tail{nullptr};
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_SEGMENTED_QUEUE_HPP
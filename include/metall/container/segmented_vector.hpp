@@ -0,0 +1,483 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_SEGMENTED_VECTOR_HPP
+#define METALL_CONTAINER_SEGMENTED_VECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/builtin_functions.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A vector which grows without moving its items and can be stored in
+/// persistent memory.
+/// Items are stored in segments whose sizes grow geometrically: the first
+/// segment holds k_first_segment_size items, and each of the following ones
+/// holds as many items as all the previous ones. Growing the vector only
+/// allocates a new segment; thus, the items are never copied and references
+/// to them stay valid until they are erased. The index of an item is mapped
+/// to its segment in O(1) time with a small directory of segments kept in
+/// the object.
+/// The items of a segment are contiguous; segment_data() and segment_size()
+/// give them, e.g., to vectorized loops.
+/// \tparam _value_type A value type.
+/// \tparam _allocator_type An allocator type.
+/// \tparam k_first_segment_size The number of items in the first segment.
+/// Must be a power of two.
+template <typename _value_type,
+          typename _allocator_type = std::allocator<_value_type>,
+          std::size_t k_first_segment_size = 1024>
+class segmented_vector {
+  static_assert(k_first_segment_size > 0 &&
+                    (k_first_segment_size & (k_first_segment_size - 1)) == 0,
+                "The first segment size must be a power of two");
+
+ public:
+  using value_type = _value_type;
+  using allocator_type = typename std::allocator_traits<
+      _allocator_type>::template rebind_alloc<value_type>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = typename std::allocator_traits<allocator_type>::pointer;
+  using const_pointer =
+      typename std::allocator_traits<allocator_type>::const_pointer;
+
+ private:
+  using alloc_traits = std::allocator_traits<allocator_type>;
+
+  // The capacity with all segments is k_first_segment_size << 47
+  static constexpr std::size_t k_max_num_segments = 48;
+
+  template <bool is_const>
+  class iterator_impl {
+    using container_type =
+        std::conditional_t<is_const, const segmented_vector, segmented_vector>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename segmented_vector::value_type;
+    using difference_type = typename segmented_vector::difference_type;
+    using pointer = std::conditional_t<is_const, const value_type *,
+                                       value_type *>;
+    using reference = std::conditional_t<is_const, const value_type &,
+                                         value_type &>;
+
+    iterator_impl() = default;
+    iterator_impl(container_type *const container, const size_type index)
+        : m_container(container), m_index(index) {}
+
+    /// \brief Converts an iterator into a const iterator.
+    template <bool other_const,
+              typename = std::enable_if_t<is_const && !other_const>>
+    iterator_impl(const iterator_impl<other_const> &other)
+        : m_container(other.m_container), m_index(other.m_index) {}
+
+    reference operator*() const { return (*m_container)[m_index]; }
+    pointer operator->() const { return &(*m_container)[m_index]; }
+    reference operator[](const difference_type n) const {
+      return (*m_container)[m_index + n];
+    }
+
+    iterator_impl &operator++() {
+      ++m_index;
+      return *this;
+    }
+    iterator_impl operator++(int) {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+    iterator_impl &operator--() {
+      --m_index;
+      return *this;
+    }
+    iterator_impl operator--(int) {
+      auto tmp = *this;
+      --m_index;
+      return tmp;
+    }
+    iterator_impl &operator+=(const difference_type n) {
+      m_index += n;
+      return *this;
+    }
+    iterator_impl &operator-=(const difference_type n) {
+      m_index -= n;
+      return *this;
+    }
+    iterator_impl operator+(const difference_type n) const {
+      return iterator_impl(m_container, m_index + n);
+    }
+    friend iterator_impl operator+(const difference_type n,
+                                   const iterator_impl &itr) {
+      return itr + n;
+    }
+    iterator_impl operator-(const difference_type n) const {
+      return iterator_impl(m_container, m_index - n);
+    }
+    difference_type operator-(const iterator_impl &other) const {
+      return difference_type(m_index) - difference_type(other.m_index);
+    }
+
+    bool operator==(const iterator_impl &other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const iterator_impl &other) const {
+      return m_index != other.m_index;
+    }
+    bool operator<(const iterator_impl &other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const iterator_impl &other) const {
+      return m_index > other.m_index;
+    }
+    bool operator<=(const iterator_impl &other) const {
+      return m_index <= other.m_index;
+    }
+    bool operator>=(const iterator_impl &other) const {
+      return m_index >= other.m_index;
+    }
+
+   private:
+    friend class iterator_impl<!is_const>;
+
+    container_type *m_container{nullptr};
+    size_type m_index{0};
+  };
+
+ public:
+  using iterator = iterator_impl<false>;
+  using const_iterator = iterator_impl<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit segmented_vector(const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {}
+
+  /// \brief Constructs a vector with 'n' copies of 'value'.
+  segmented_vector(const size_type n, const value_type &value,
+                   const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {
+    resize(n, value);
+  }
+
+  /// \brief Copy constructor.
+  segmented_vector(const segmented_vector &other)
+      : m_allocator(alloc_traits::select_on_container_copy_construction(
+            other.m_allocator)) {
+    priv_copy_from(other);
+  }
+
+  /// \brief Allocator-extended copy constructor.
+  segmented_vector(const segmented_vector &other,
+                   const allocator_type &allocator)
+      : m_allocator(allocator) {
+    priv_copy_from(other);
+  }
+
+  /// \brief Move constructor. Takes the segments of 'other'.
+  segmented_vector(segmented_vector &&other) noexcept
+      : m_allocator(std::move(other.m_allocator)) {
+    priv_take(other);
+  }
+
+  /// \brief Destructor.
+  ~segmented_vector() noexcept {
+    clear();
+    priv_deallocate_segments(0);
+  }
+
+  /// \brief Copy assignment operator.
+  segmented_vector &operator=(const segmented_vector &other) {
+    if (this == &other) return *this;
+    clear();
+    priv_copy_from(other);
+    return *this;
+  }
+
+  /// \brief Move assignment operator.
+  /// Moves the items one by one if the allocators are not equal.
+  segmented_vector &operator=(segmented_vector &&other) noexcept(
+      alloc_traits::is_always_equal::value) {
+    if (this == &other) return *this;
+    clear();
+    if (m_allocator == other.m_allocator) {
+      priv_deallocate_segments(0);
+      priv_take(other);
+    } else {
+      reserve(other.size());
+      for (auto &item : other) emplace_back(std::move(item));
+      other.clear();
+    }
+    return *this;
+  }
+
+  // -------------------- Element access -------------------- //
+  reference operator[](const size_type index) {
+    const auto [segment_no, offset] = priv_locate(index);
+    return metall::to_raw_pointer(m_segments[segment_no])[offset];
+  }
+
+  const_reference operator[](const size_type index) const {
+    const auto [segment_no, offset] = priv_locate(index);
+    return metall::to_raw_pointer(m_segments[segment_no])[offset];
+  }
+
+  reference at(const size_type index) {
+    if (index >= m_size) throw std::out_of_range("segmented_vector::at");
+    return (*this)[index];
+  }
+
+  const_reference at(const size_type index) const {
+    if (index >= m_size) throw std::out_of_range("segmented_vector::at");
+    return (*this)[index];
+  }
+
+  reference front() { return (*this)[0]; }
+  const_reference front() const { return (*this)[0]; }
+  reference back() { return (*this)[m_size - 1]; }
+  const_reference back() const { return (*this)[m_size - 1]; }
+
+  // -------------------- Segments -------------------- //
+  /// \brief Returns the number of segments holding items.
+  size_type num_segments() const {
+    return m_size == 0 ? 0 : priv_locate(m_size - 1).first + 1;
+  }
+
+  /// \brief Returns the items of a segment, which are contiguous.
+  /// \param segment_no A segment number less than num_segments().
+  value_type *segment_data(const size_type segment_no) {
+    return metall::to_raw_pointer(m_segments[segment_no]);
+  }
+
+  const value_type *segment_data(const size_type segment_no) const {
+    return metall::to_raw_pointer(m_segments[segment_no]);
+  }
+
+  /// \brief Returns the number of the items in a segment.
+  /// \param segment_no A segment number less than num_segments().
+  size_type segment_size(const size_type segment_no) const {
+    const auto begin = priv_segment_begin(segment_no);
+    if (m_size <= begin) return 0;
+    return std::min(m_size - begin, priv_segment_capacity(segment_no));
+  }
+
+  /// \brief Calls f(data, n) for the n contiguous items of each segment, in
+  /// order.
+  template <typename function_type>
+  void for_each_segment(function_type &&f) {
+    for (size_type s = 0, n = num_segments(); s < n; ++s) {
+      f(segment_data(s), segment_size(s));
+    }
+  }
+
+  /// \brief Calls f(data, n) for the n contiguous items of each segment, in
+  /// order.
+  template <typename function_type>
+  void for_each_segment(function_type &&f) const {
+    for (size_type s = 0, n = num_segments(); s < n; ++s) {
+      f(segment_data(s), segment_size(s));
+    }
+  }
+
+  // -------------------- Iterators -------------------- //
+  iterator begin() { return iterator(this, 0); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(this, m_size); }
+  const_iterator end() const { return const_iterator(this, m_size); }
+  const_iterator cend() const { return end(); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // -------------------- Capacity -------------------- //
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  /// \brief Returns the number of items the allocated segments can hold.
+  size_type capacity() const { return priv_segment_begin(m_num_allocated); }
+
+  size_type max_size() const {
+    return priv_segment_begin(k_max_num_segments);
+  }
+
+  /// \brief Allocates segments to hold at least 'n' items.
+  void reserve(const size_type n) {
+    if (n > max_size()) throw std::length_error("segmented_vector::reserve");
+    while (capacity() < n) priv_allocate_segment();
+  }
+
+  /// \brief Deallocates the segments without items.
+  void shrink_to_fit() { priv_deallocate_segments(num_segments()); }
+
+  // -------------------- Modifiers -------------------- //
+  void push_back(const value_type &value) { emplace_back(value); }
+  void push_back(value_type &&value) { emplace_back(std::move(value)); }
+
+  /// \brief Adds an item constructed from arguments at the end.
+  /// The other items are not moved.
+  template <typename... args_type>
+  reference emplace_back(args_type &&...args) {
+    if (m_size == capacity()) reserve(m_size + 1);
+    auto *const item = &(*this)[m_size];
+    alloc_traits::construct(m_allocator, item,
+                            std::forward<args_type>(args)...);
+    ++m_size;
+    return *item;
+  }
+
+  void pop_back() {
+    assert(m_size > 0);
+    --m_size;
+    alloc_traits::destroy(m_allocator, &(*this)[m_size]);
+  }
+
+  /// \brief Destroys all items. The segments are kept.
+  void clear() noexcept {
+    for (size_type s = 0, n = num_segments(); s < n; ++s) {
+      auto *const data = segment_data(s);
+      for (size_type i = 0, ni = segment_size(s); i < ni; ++i) {
+        alloc_traits::destroy(m_allocator, data + i);
+      }
+    }
+    m_size = 0;
+  }
+
+  void resize(const size_type n) {
+    priv_shrink(n);
+    reserve(n);
+    while (m_size < n) emplace_back();
+  }
+
+  void resize(const size_type n, const value_type &value) {
+    priv_shrink(n);
+    reserve(n);
+    while (m_size < n) emplace_back(value);
+  }
+
+  void swap(segmented_vector &other) noexcept {
+    using std::swap;
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      swap(m_allocator, other.m_allocator);
+    }
+    for (size_type s = 0; s < k_max_num_segments; ++s) {
+      swap(m_segments[s], other.m_segments[s]);
+    }
+    swap(m_num_allocated, other.m_num_allocated);
+    swap(m_size, other.m_size);
+  }
+
+  /// \brief Returns an instance of the allocator.
+  allocator_type get_allocator() const { return m_allocator; }
+
+  friend bool operator==(const segmented_vector &lhs,
+                         const segmented_vector &rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+  friend bool operator!=(const segmented_vector &lhs,
+                         const segmented_vector &rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  /// \brief Returns the first index of a segment.
+  static constexpr size_type priv_segment_begin(const size_type segment_no) {
+    return segment_no == 0 ? 0 : k_first_segment_size << (segment_no - 1);
+  }
+
+  static constexpr size_type priv_segment_capacity(
+      const size_type segment_no) {
+    return segment_no == 0 ? k_first_segment_size
+                           : k_first_segment_size << (segment_no - 1);
+  }
+
+  /// \brief Returns the (segment number, offset in the segment) of an index.
+  static std::pair<size_type, size_type> priv_locate(const size_type index) {
+    if (index < k_first_segment_size) return {0, index};
+    const auto k = 63 - mdtl::clzll(index / k_first_segment_size);
+    return {size_type(k) + 1, index - (k_first_segment_size << k)};
+  }
+
+  void priv_allocate_segment() {
+    assert(m_num_allocated < k_max_num_segments);
+    m_segments[m_num_allocated] = alloc_traits::allocate(
+        m_allocator, priv_segment_capacity(m_num_allocated));
+    ++m_num_allocated;
+  }
+
+  /// \brief Deallocates the segments from 'first_segment_no'; they must not
+  /// have items.
+  void priv_deallocate_segments(const size_type first_segment_no) noexcept {
+    while (m_num_allocated > first_segment_no) {
+      --m_num_allocated;
+      alloc_traits::deallocate(m_allocator, m_segments[m_num_allocated],
+                               priv_segment_capacity(m_num_allocated));
+      m_segments[m_num_allocated] = nullptr;
+    }
+  }
+
+  void priv_shrink(const size_type n) {
+    while (m_size > n) pop_back();
+  }
+
+  void priv_copy_from(const segmented_vector &other) {
+    reserve(other.size());
+    for (const auto &item : other) emplace_back(item);
+  }
+
+  void priv_take(segmented_vector &other) noexcept {
+    for (size_type s = 0; s < k_max_num_segments; ++s) {
+      m_segments[s] = other.m_segments[s];
+      other.m_segments[s] = nullptr;
+    }
+    m_num_allocated = other.m_num_allocated;
+    m_size = other.m_size;
+    other.m_num_allocated = 0;
+    other.m_size = 0;
+  }
+
+  allocator_type m_allocator;
+  pointer m_segments[k_max_num_segments]{};
+  size_type m_num_allocated{0};
+  size_type m_size{0};
+};
+
+template <typename value_type, typename allocator_type,
+          std::size_t k_first_segment_size>
+inline void swap(
+    segmented_vector<value_type, allocator_type, k_first_segment_size> &lhs,
+    segmented_vector<value_type, allocator_type, k_first_segment_size>
+        &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_SEGMENTED_VECTOR_HPP
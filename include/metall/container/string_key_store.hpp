@@ -6,23 +6,42 @@
 #ifndef METALL_CONTAINER_CONCURRENT_STRING_KEY_STORE_HPP
 #define METALL_CONTAINER_CONCURRENT_STRING_KEY_STORE_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string_view>
 #include <utility>
 #include <tuple>
-#include <metall/container/unordered_map.hpp>
-#include <metall/container/string.hpp>
-#include <metall/container/scoped_allocator.hpp>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <metall/container/vector.hpp>
 #include <metall/container/string_key_store_locator.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/detail/mmap.hpp>
 #include <metall/metall.hpp>
+#include <metall/utility/fault_aware_scheduler.hpp>
 
 namespace metall::container {
 
 namespace {
 namespace mc = metall::container;
-}
+namespace mdtl = metall::mtlldetail;
+}  // namespace
 
 /// \brief A ke-value store that uses string for its key.
+/// This container is an open-addressing hash table that probes 16 slots at
+/// once (with SSE2 if available), in the manner of Swiss tables.
+/// Elements are stored contiguously in insertion order (except after
+/// erasure). A key of up to 12 bytes is stored in its element; a longer key
+/// is stored in a key arena shared by all elements.
 /// \warning This container is designed to work as the top-level container,
 /// i.e., it does not work if used inside another container.
 /// \tparam _value_type A value type.
@@ -36,34 +55,43 @@ class string_key_store {
       typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
 
   template <typename T>
-  using other_scoped_allocator =
-      mc::scoped_allocator_adaptor<other_allocator<T>>;
-
-  using internal_id_type = uint64_t;
-  using internal_string_type =
-      mc::basic_string<char, std::char_traits<char>, other_allocator<char>>;
-  using internal_value_type = std::tuple<internal_string_type, _value_type>;
-
-  using map_type = mc::unordered_multimap<
-      internal_id_type, internal_value_type, std::hash<internal_id_type>,
-      std::equal_to<internal_id_type>,
-      other_scoped_allocator<
-          std::pair<const internal_id_type, internal_value_type>>>;
-
-  /// Used for representing 'invalid key'.
-  static constexpr internal_id_type k_max_internal_id =
-      std::numeric_limits<internal_id_type>::max();
+  using vector_type = mc::vector<T, other_allocator<T>>;
+
+  using index_type = uint64_t;
+  static constexpr index_type k_npos = std::numeric_limits<index_type>::max();
+
+  /// Holds a key in place or the position of a key in the key arena.
+  struct internal_key_type {
+    uint32_t length{0};
+    char data[12];
+  };
+  static constexpr std::size_t k_max_inline_key_length =
+      sizeof(internal_key_type::data);
+
+  /// Key, the index of the next element with the same key, and value.
+  using internal_value_type =
+      std::tuple<internal_key_type, index_type, _value_type>;
+  using entry_table_type = vector_type<internal_value_type>;
+
+  static constexpr std::size_t k_group_size = 16;
+  // The number of keys whose memory find_batch() prefetches at once
+  static constexpr std::size_t k_find_batch_size = 16;
+  static constexpr uint8_t k_empty = 0x80;
+  static constexpr uint8_t k_deleted = 0xFE;
+  // Other control bytes are the lower 7 bits of hash values
 
  public:
   using key_type = std::string_view;
   using value_type = _value_type;
-  using locator_type =
-      string_key_store_locator<typename map_type::const_iterator>;
+  using locator_type = string_key_store_locator<entry_table_type>;
 
   /// \brief Constructor.
   /// \param allocator An allocator object.
   explicit string_key_store(const allocator_type &allocator = allocator_type())
-      : m_map(allocator) {}
+      : m_entries(allocator),
+        m_key_arena(allocator),
+        m_controls(allocator),
+        m_slots(allocator) {}
 
   /// \brief Constructor.
   /// \param unique Accept duplicate keys if false is specified.
@@ -71,7 +99,12 @@ class string_key_store {
   /// \param allocator An allocator object.
   string_key_store(const bool unique, const uint64_t hash_seed,
                    const allocator_type &allocator = allocator_type())
-      : m_unique(unique), m_hash_seed(hash_seed), m_map(allocator) {}
+      : m_unique(unique),
+        m_hash_seed(hash_seed),
+        m_entries(allocator),
+        m_key_arena(allocator),
+        m_controls(allocator),
+        m_slots(allocator) {}
 
   /// \brief Copy constructor
   string_key_store(const string_key_store &) = default;
@@ -80,7 +113,14 @@ class string_key_store {
   string_key_store(const string_key_store &other, const allocator_type &alloc)
       : m_unique(other.m_unique),
         m_hash_seed(other.m_hash_seed),
-        m_map(other.m_map, alloc) {}
+        m_max_id_probe_distance(other.m_max_id_probe_distance),
+        m_num_keys(other.m_num_keys),
+        m_num_used_slots(other.m_num_used_slots),
+        m_num_garbage_key_bytes(other.m_num_garbage_key_bytes),
+        m_entries(other.m_entries, alloc),
+        m_key_arena(other.m_key_arena, alloc),
+        m_controls(other.m_controls, alloc),
+        m_slots(other.m_slots, alloc) {}
 
   /// \brief Move constructor
   string_key_store(string_key_store &&) noexcept = default;
@@ -90,7 +130,14 @@ class string_key_store {
                    const allocator_type &alloc) noexcept
       : m_unique(other.m_unique),
         m_hash_seed(other.m_hash_seed),
-        m_map(std::move(other.m_map), alloc) {}
+        m_max_id_probe_distance(other.m_max_id_probe_distance),
+        m_num_keys(other.m_num_keys),
+        m_num_used_slots(other.m_num_used_slots),
+        m_num_garbage_key_bytes(other.m_num_garbage_key_bytes),
+        m_entries(std::move(other.m_entries), alloc),
+        m_key_arena(std::move(other.m_key_arena), alloc),
+        m_controls(std::move(other.m_controls), alloc),
+        m_slots(std::move(other.m_slots), alloc) {}
 
   /// \brief Copy assignment operator
   string_key_store &operator=(const string_key_store &) = default;
@@ -104,8 +151,9 @@ class string_key_store {
   /// \param key A key to insert.
   /// \return True if an item is inserted; otherwise, false.
   bool insert(const key_type &key) {
-    const auto internal_id = priv_find_or_generate_internal_id(key);
-    if (m_unique && m_map.count(internal_id) == 1) {
+    const auto hash = priv_hash_key(key, m_hash_seed);
+    const auto slot = priv_find_slot(key, hash);
+    if (m_unique && slot != k_npos) {
       return false;
     }
 
@@ -114,10 +162,8 @@ class string_key_store {
     // of uses-allocator construction. This is why we use tuple for
     // internal_value_type.
     auto internal_value =
-        internal_value_type{std::allocator_arg, m_map.get_allocator()};
-    std::get<0>(internal_value) = key;
-
-    m_map.emplace(internal_id, std::move(internal_value));
+        internal_value_type{std::allocator_arg, m_entries.get_allocator()};
+    priv_emplace_entry(key, hash, slot, std::move(internal_value));
 
     return true;
   }
@@ -128,16 +174,15 @@ class string_key_store {
   /// value of the existing one. \param key A key to insert. \param value A
   /// value to insert. \return Always true.
   bool insert(const key_type &key, const value_type &value) {
-    const auto internal_id = priv_find_or_generate_internal_id(key);
-
-    assert(!m_unique || m_map.count(internal_id) <= 1);
-    if (m_unique && m_map.count(internal_id) == 1) {
-      assert(m_map.count(internal_id) == 1);
-      std::get<1>(m_map.find(internal_id)->second) = value;
+    const auto hash = priv_hash_key(key, m_hash_seed);
+    const auto slot = priv_find_slot(key, hash);
+    if (m_unique && slot != k_npos) {
+      std::get<2>(m_entries[m_slots[slot]]) = value;
     } else {
-      m_map.emplace(internal_id, internal_value_type{std::allocator_arg,
-                                                     m_map.get_allocator(),
-                                                     key.data(), value});
+      priv_emplace_entry(
+          key, hash, slot,
+          internal_value_type{std::allocator_arg, m_entries.get_allocator(),
+                              internal_key_type{}, k_npos, value});
     }
     return true;
   }
@@ -147,22 +192,27 @@ class string_key_store {
   /// \param value A value to insert.
   /// \return Always true.
   bool insert(const key_type &key, value_type &&value) {
-    const auto internal_id = priv_find_or_generate_internal_id(key);
-
-    assert(!m_unique || m_map.count(internal_id) <= 1);
-    if (m_unique && m_map.count(internal_id) == 1) {
-      std::get<1>(m_map.find(internal_id)->second) = std::move(value);
+    const auto hash = priv_hash_key(key, m_hash_seed);
+    const auto slot = priv_find_slot(key, hash);
+    if (m_unique && slot != k_npos) {
+      std::get<2>(m_entries[m_slots[slot]]) = std::move(value);
     } else {
-      m_map.emplace(internal_id, internal_value_type{
-                                     std::allocator_arg, m_map.get_allocator(),
-                                     key.data(), std::move(value)});
+      priv_emplace_entry(
+          key, hash, slot,
+          internal_value_type{std::allocator_arg, m_entries.get_allocator(),
+                              internal_key_type{}, k_npos, std::move(value)});
     }
     return true;
   }
 
   /// \brief Clear all contents. This call does not reduce the memory usage.
   void clear() {
-    m_map.clear();
+    m_entries.clear();
+    m_key_arena.clear();
+    std::fill(m_controls.begin(), m_controls.end(), k_empty);
+    m_num_keys = 0;
+    m_num_used_slots = 0;
+    m_num_garbage_key_bytes = 0;
     m_max_id_probe_distance = 0;
   }
 
@@ -170,45 +220,136 @@ class string_key_store {
   /// \param key A key to count.
   /// \return The number of items associated with the key.
   std::size_t count(const key_type &key) const {
-    const auto internal_id = priv_find_internal_id(key);
-    return m_map.count(internal_id);
+    const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+    if (slot == k_npos) return 0;
+    std::size_t num = 0;
+    for (auto i = m_slots[slot]; i != k_npos; i = std::get<1>(m_entries[i])) {
+      ++num;
+    }
+    return num;
   }
 
   /// \brief Returns the number of elements in this container.
   /// \return The number of elements in this container.
-  std::size_t size() const { return m_map.size(); }
+  std::size_t size() const { return m_entries.size(); }
 
   /// \brief Returns the key of the element at 'position'.
   /// \param position A locator object.
   /// \return The key of the element at 'position'.
   const key_type key(const locator_type &position) const {
-    const auto &key = std::get<0>(position.m_iterator->second);
-    return key_type(key.c_str());
+    return priv_key(std::get<0>(m_entries[position.m_index]));
   }
 
   /// \brief Returns the value of the element at 'position'.
   /// \param position A locator object.
   /// \return The value of the element at 'position'.
   value_type &value(const locator_type &position) {
-    // Convert to a non-const iterator
-    auto non_const_iterator =
-        m_map.erase(position.m_iterator, position.m_iterator);
-    return std::get<1>(non_const_iterator->second);
+    return std::get<2>(m_entries[position.m_index]);
   }
 
   /// \brief Returns the value of the element at 'position'.
   /// \param position A locator object.
   /// \return The value of the element at 'position' as const.
   const value_type &value(const locator_type &position) const {
-    return std::get<1>(position.m_iterator->second);
+    return std::get<2>(m_entries[position.m_index]);
   }
 
   /// \brief Finds an element with key equivalent to 'key'.
   /// \param key The key of an element to find.
   /// \return An locator object that points the found element.
   locator_type find(const key_type &key) const {
-    const auto internal_id = priv_find_internal_id(key);
-    return locator_type(m_map.find(internal_id));
+    const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+    if (slot == k_npos) return end();
+    return locator_type(&m_entries, m_slots[slot]);
+  }
+
+  /// \brief Finds the elements with keys equivalent to n keys at once.
+  /// Faster than calling find() n times if the table does not fit in the
+  /// caches: the keys are processed in groups, in which the hashes of all
+  /// keys are computed and the memory to probe is prefetched before any key
+  /// is resolved, so that the cache misses of the keys overlap.
+  /// \param first The beginning of the keys, convertible to key_type; the
+  /// keys must stay valid during the call, e.g., elements of a container.
+  /// \param n The number of keys.
+  /// \param out The beginning of the locators to store; end() is stored for
+  /// a key not found, as find() returns.
+  /// \param advise_pages If true, also asks the OS to read the pages to probe
+  /// in the background (madvise(MADV_WILLNEED)) so that the page faults of
+  /// the keys overlap, e.g., for a table on storage that does not fit in
+  /// memory. Costs system calls per key.
+  template <typename input_iterator, typename output_iterator>
+  void find_batch(input_iterator first, const std::size_t n,
+                  output_iterator out, const bool advise_pages = false) const {
+    if (m_controls.empty()) {
+      for (std::size_t i = 0; i < n; ++i, ++out) *out = end();
+      return;
+    }
+
+    key_type keys[k_find_batch_size];
+    uint64_t hashes[k_find_batch_size];
+    for (std::size_t i = 0; i < n; i += k_find_batch_size) {
+      const auto batch_size = std::min(k_find_batch_size, n - i);
+      for (std::size_t j = 0; j < batch_size; ++j, ++first) {
+        keys[j] = *first;
+        hashes[j] = priv_hash_key(keys[j], m_hash_seed);
+        priv_prefetch_group(hashes[j], advise_pages);
+      }
+      for (std::size_t j = 0; j < batch_size; ++j) {
+        priv_prefetch_candidate(hashes[j], advise_pages);
+      }
+      for (std::size_t j = 0; j < batch_size; ++j, ++out) {
+        const auto slot = priv_find_slot(keys[j], hashes[j]);
+        *out = (slot == k_npos) ? end()
+                                : locator_type(&m_entries, m_slots[slot]);
+      }
+    }
+  }
+
+  /// \brief Submits a lookup of 'key' to a scheduler, which runs it
+  /// together with the other lookups submitted, switching to another lookup
+  /// while the pages this lookup accesses are read in, e.g., for a table on
+  /// storage that does not fit in memory.
+  /// \param scheduler A scheduler to run the lookup.
+  /// \param key The key of an element to find; must stay valid until the
+  /// lookup is done.
+  /// \param callback A function called with the locator find() returns,
+  /// when the lookup is done in scheduler.run().
+  template <typename callback_type>
+  void find_async(metall::utility::fault_aware_scheduler &scheduler,
+                  const key_type &key, callback_type callback) const {
+    if (m_controls.empty()) {
+      callback(end());
+      return;
+    }
+
+    // The steps access the control bytes, the slots, and the candidate
+    // element of the first group, in this order, and then resolve the key
+    scheduler.submit([this, key, callback = std::move(callback), step = 0,
+                      hash = uint64_t(0),
+                      first_slot = std::size_t(0)]() mutable -> const void * {
+      switch (step++) {
+        case 0: {
+          hash = priv_hash_key(key, m_hash_seed);
+          const auto group_mask = m_controls.size() / k_group_size - 1;
+          first_slot = ((hash >> 7ULL) & group_mask) * k_group_size;
+          return &m_controls[first_slot];
+        }
+        case 1:
+          return &m_slots[first_slot];
+        case 2: {
+          const auto mask =
+              priv_match(&m_controls[first_slot], priv_hash_tag(hash));
+          if (mask) return &m_entries[m_slots[first_slot + mdtl::ctzll(mask)]];
+          [[fallthrough]];
+        }
+        default: {
+          const auto slot = priv_find_slot(key, hash);
+          callback((slot == k_npos) ? end()
+                                    : locator_type(&m_entries, m_slots[slot]));
+          return nullptr;
+        }
+      }
+    });
   }
 
   /// \brief Returns a range containing all elements with key key in the
@@ -217,26 +358,44 @@ class string_key_store {
   /// the first element of the range, and the second points to the element
   /// following the last element of the range.
   std::pair<locator_type, locator_type> equal_range(const key_type &key) const {
-    const auto internal_id = priv_find_internal_id(key);
-    const auto range = m_map.equal_range(internal_id);
-    return std::make_pair(locator_type(range.first),
-                          locator_type(range.second));
+    const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+    if (slot == k_npos) return std::make_pair(end(), end());
+    return std::make_pair(locator_type(&m_entries, m_slots[slot], true),
+                          end());
   }
 
   /// \brief Return an iterator that points the first element in the container.
   /// \return An iterator that points the first element in the container.
-  locator_type begin() const { return locator_type(m_map.begin()); }
+  locator_type begin() const {
+    return locator_type(&m_entries, m_entries.empty() ? k_npos : 0);
+  }
 
   /// \brief Returns an iterator to the element following the last element.
   /// \return An iterator to the element following the last element.
-  locator_type end() const { return locator_type(m_map.end()); }
+  locator_type end() const { return locator_type(&m_entries, k_npos); }
 
   /// \brief Removes all elements with the key equivalent to key.
   /// \param key The key of elements to remove.
   /// \return The number of elements removed.
   std::size_t erase(const key_type &key) {
-    const auto internal_id = priv_find_internal_id(key);
-    return m_map.erase(internal_id);
+    const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+    if (slot == k_npos) return 0;
+
+    std::vector<index_type> indices;
+    for (auto i = m_slots[slot]; i != k_npos; i = std::get<1>(m_entries[i])) {
+      indices.push_back(i);
+    }
+    priv_erase_slot(slot);
+
+    // Remove from the back so that an element moved by priv_remove_entry()
+    // is never one of the elements to remove
+    // The elements share the key
+    priv_release_key(std::get<0>(m_entries[indices.front()]));
+    std::sort(indices.begin(), indices.end(), std::greater<index_type>());
+    for (const auto i : indices) {
+      priv_remove_entry(i);
+    }
+    return indices.size();
   }
 
   /// \brief Removes the element at 'position'.
@@ -244,28 +403,55 @@ class string_key_store {
   /// \return A locator that points to the next element of the removed one.
   locator_type erase(const locator_type &position) {
     if (position == end()) return end();
-    return locator_type(m_map.erase(position.m_iterator));
+
+    const auto index = position.m_index;
+    const auto next = std::get<1>(m_entries[index]);
+    const auto key = priv_key(std::get<0>(m_entries[index]));
+    const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+    assert(slot != k_npos);
+    if (m_slots[slot] == index) {
+      if (next == k_npos) {
+        priv_release_key(std::get<0>(m_entries[index]));
+        priv_erase_slot(slot);
+      } else {
+        m_slots[slot] = next;
+      }
+    } else {
+      auto i = m_slots[slot];
+      while (std::get<1>(m_entries[i]) != index) i = std::get<1>(m_entries[i]);
+      std::get<1>(m_entries[i]) = next;
+    }
+    priv_remove_entry(index);
+
+    // The last element was moved to 'index'
+    return locator_type(&m_entries,
+                        (index < m_entries.size()) ? index : k_npos);
   }
 
   /// \brief Returns the maximum ID probe distance.
-  /// In other words, the maximum number of key pairs that have the same hash
-  /// value. \return The maximum ID probe distance.
+  /// In other words, the maximum number of slot groups probed beyond the
+  /// first one to find a key.
+  /// \return The maximum ID probe distance.
   std::size_t max_id_probe_distance() const { return m_max_id_probe_distance; }
 
   /// \brief Rehash elements.
+  /// Also releases the space of erased keys in the key arena.
   void rehash() {
-    auto old_map = map_type(get_allocator());
-    std::swap(old_map, m_map);
-    m_map.clear();
-    assert(m_map.empty());
-    for (auto &elem : old_map) {
-      insert(std::get<0>(elem.second), std::move(std::get<1>(elem.second)));
-    }
+    priv_compact_key_arena();
+    priv_rebuild_table(priv_calc_capacity(m_num_keys));
+  }
+
+  /// \brief Reserves space for at least 'n' distinct keys.
+  /// \param n The number of distinct keys.
+  void reserve(const std::size_t n) {
+    m_entries.reserve(n);
+    const auto capacity = priv_calc_capacity(n);
+    if (capacity > m_controls.size()) priv_rebuild_table(capacity);
   }
 
   /// \brief Returns an instance of the internal allocator.
   /// \return An instance of the internal allocator.
-  allocator_type get_allocator() { return m_map.get_allocator(); }
+  allocator_type get_allocator() { return m_entries.get_allocator(); }
 
   /// \brief Returns if this container inserts keys uniquely.
   /// \return True if this container inserts key avoiding duplicates; otherwise
@@ -277,79 +463,273 @@ class string_key_store {
   bool hash_seed() const { return m_hash_seed; }
 
  private:
-  /// \brief Generates a new internal ID for 'key'.
-  internal_id_type priv_generate_internal_id(const key_type &key) {
-    auto internal_id = priv_hash_key(key, m_hash_seed);
-
-    std::size_t distance = 0;
-    while (m_map.count(internal_id) > 0) {
-      internal_id = priv_increment_internal_id(internal_id);
-      ++distance;
+  /// \brief Returns a bitmask of the slots in the group that start at
+  /// 'controls' whose control byte is 'c'.
+  static uint32_t priv_match(const uint8_t *const controls, const uint8_t c) {
+#ifdef __SSE2__
+    const auto group =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(controls));
+    return (uint32_t)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+    uint32_t mask = 0;
+    for (std::size_t i = 0; i < k_group_size; ++i) {
+      mask |= uint32_t(controls[i] == c) << i;
     }
-    m_max_id_probe_distance = std::max(distance, m_max_id_probe_distance);
+    return mask;
+#endif
+  }
 
-    return internal_id;
+  static uint8_t priv_hash_tag(const uint64_t hash) { return hash & 0x7F; }
+
+  /// \brief Prefetches the control bytes and slots of the first group that
+  /// 'hash' probes.
+  void priv_prefetch_group(const uint64_t hash, const bool advise_pages) const {
+    const auto group_mask = m_controls.size() / k_group_size - 1;
+    const auto first_slot = ((hash >> 7ULL) & group_mask) * k_group_size;
+    const auto *const controls = &m_controls[first_slot];
+    const auto *const slots = &m_slots[first_slot];
+    if (advise_pages) {
+      mdtl::advise_will_need(controls, k_group_size);
+      mdtl::advise_will_need(slots, sizeof(index_type) * k_group_size);
+    }
+    __builtin_prefetch(controls);
+    __builtin_prefetch(slots);
   }
 
-  /// \brief Finds the internal ID that corresponds with 'key'.
-  /// If this container does not have an element with 'key',
-  /// returns k_max_internal_id.
-  internal_id_type priv_find_internal_id(const key_type &key) const {
-    auto internal_id = priv_hash_key(key, m_hash_seed);
+  /// \brief Prefetches the element of the first slot in the first group that
+  /// matches the tag of 'hash', which is the one to compare in most cases.
+  void priv_prefetch_candidate(const uint64_t hash,
+                               const bool advise_pages) const {
+    const auto group_mask = m_controls.size() / k_group_size - 1;
+    const auto first_slot = ((hash >> 7ULL) & group_mask) * k_group_size;
+    const auto mask =
+        priv_match(&m_controls[first_slot], priv_hash_tag(hash));
+    if (!mask) return;
+    const auto *const entry =
+        &m_entries[m_slots[first_slot + mdtl::ctzll(mask)]];
+    if (advise_pages) mdtl::advise_will_need(entry, sizeof(*entry));
+    __builtin_prefetch(entry);
+  }
 
+  /// \brief Returns the position of the slot that has 'key'; if not found,
+  /// returns k_npos.
+  index_type priv_find_slot(const key_type &key, const uint64_t hash) const {
+    if (m_controls.empty()) return k_npos;
+
+    const auto tag = priv_hash_tag(hash);
+    const auto group_mask = m_controls.size() / k_group_size - 1;
+    auto group = (hash >> 7ULL) & group_mask;
+    // Loads the slots in parallel with the control bytes
+    __builtin_prefetch(&m_slots[group * k_group_size]);
     for (std::size_t d = 0; d <= m_max_id_probe_distance; ++d) {
-      const auto itr = m_map.find(internal_id);
-      if (itr == m_map.end()) {
-        break;
+      const auto *const controls = &m_controls[group * k_group_size];
+      for (auto mask = priv_match(controls, tag); mask; mask &= mask - 1) {
+        const auto slot = group * k_group_size + mdtl::ctzll(mask);
+        if (priv_key(std::get<0>(m_entries[m_slots[slot]])) == key) {
+          return slot;
+        }
       }
+      if (priv_match(controls, k_empty)) break;
+      group = (group + 1) & group_mask;
+    }
+    return k_npos;  // Couldn't find
+  }
 
-      if (std::get<0>(itr->second) == key) {
-        return internal_id;
+  /// \brief Returns the position of the first available slot for 'hash'.
+  /// The table must have at least one available slot.
+  index_type priv_find_available_slot(const uint64_t hash) {
+    const auto group_mask = m_controls.size() / k_group_size - 1;
+    auto group = (hash >> 7ULL) & group_mask;
+    for (std::size_t distance = 0;; ++distance) {
+      const auto *const controls = &m_controls[group * k_group_size];
+      const auto mask =
+          priv_match(controls, k_empty) | priv_match(controls, k_deleted);
+      if (mask) {
+        m_max_id_probe_distance =
+            std::max(distance, m_max_id_probe_distance);
+        return group * k_group_size + mdtl::ctzll(mask);
       }
-      internal_id = priv_increment_internal_id(internal_id);
+      group = (group + 1) & group_mask;
+    }
+  }
+
+  /// \brief Sets up 'internal_value' for 'key' and appends it.
+  /// \param slot The position of the slot that has 'key' or k_npos.
+  void priv_emplace_entry(const key_type &key, const uint64_t hash,
+                          index_type slot,
+                          internal_value_type &&internal_value) {
+    const auto index = m_entries.size();
+    if (slot != k_npos) {
+      // Prepend to the elements that have the same key
+      std::get<0>(internal_value) = std::get<0>(m_entries[m_slots[slot]]);
+      std::get<1>(internal_value) = m_slots[slot];
+      m_entries.emplace_back(std::move(internal_value));
+      m_slots[slot] = index;
+      return;
     }
 
-    return k_max_internal_id;  // Couldn't find
+    std::get<0>(internal_value) = priv_make_internal_key(key);
+    std::get<1>(internal_value) = k_npos;
+    m_entries.emplace_back(std::move(internal_value));
+
+    if ((m_num_used_slots + 1) * 8 > m_controls.size() * 7) {
+      // Rebuild the table at the same size if the deleted slots are the
+      // majority of the used slots
+      priv_rebuild_table(m_num_keys * 2 < m_num_used_slots
+                             ? m_controls.size()
+                             : std::max(k_group_size, m_controls.size() * 2));
+    }
+    slot = priv_find_available_slot(hash);
+    if (m_controls[slot] == k_empty) ++m_num_used_slots;
+    m_controls[slot] = priv_hash_tag(hash);
+    m_slots[slot] = index;
+    ++m_num_keys;
   }
 
-  /// \brief Finds the internal ID that corresponds to 'key'.
-  /// If this container does not have an element with 'key',
-  /// Generate a new internal ID.
-  internal_id_type priv_find_or_generate_internal_id(const key_type &key) {
-    auto internal_id = priv_find_internal_id(key);
-    if (internal_id == k_max_internal_id) {  // Couldn't find
-      // Generate a new one.
-      internal_id = priv_generate_internal_id(key);
+  /// \brief Frees a slot.
+  void priv_erase_slot(const index_type slot) {
+    // A lookup that reaches a group with an empty slot stops there.
+    // Thus, if the group already has one, no key is located beyond the group
+    // because of it and the slot can be emptied.
+    const auto group = slot / k_group_size;
+    if (priv_match(&m_controls[group * k_group_size], k_empty)) {
+      m_controls[slot] = k_empty;
+      --m_num_used_slots;
+    } else {
+      m_controls[slot] = k_deleted;
     }
-    return internal_id;
+    --m_num_keys;
   }
 
-  static internal_id_type priv_hash_key(const key_type &key,
-                                        [[maybe_unused]] const uint64_t seed) {
-#ifdef METALL_CONTAINER_STRING_KEY_STORE_USE_SIMPLE_HASH
-    internal_id_type hash = key.empty() ? 0 : (uint8_t)key[0] % 2;
-#else
-    auto hash = (internal_id_type)metall::mtlldetail::murmur_hash_64a(
-        key.data(), (int)key.length(), seed);
-#endif
-    if (hash == k_max_internal_id) {
-      hash = priv_increment_internal_id(hash);
+  /// \brief Counts the space of a key in the key arena as garbage.
+  /// Must be called once for the elements that share the key.
+  void priv_release_key(const internal_key_type &internal_key) {
+    if (internal_key.length > k_max_inline_key_length) {
+      m_num_garbage_key_bytes += internal_key.length;
+    }
+  }
+
+  /// \brief Removes the element at 'index', which is not referenced from the
+  /// table anymore, by moving the last element there.
+  void priv_remove_entry(const index_type index) {
+    const auto last = m_entries.size() - 1;
+    if (index != last) {
+      m_entries[index] = std::move(m_entries[last]);
+
+      // Update the reference to the moved element
+      const auto key = priv_key(std::get<0>(m_entries[index]));
+      const auto slot = priv_find_slot(key, priv_hash_key(key, m_hash_seed));
+      assert(slot != k_npos);
+      if (m_slots[slot] == last) {
+        m_slots[slot] = index;
+      } else {
+        auto i = m_slots[slot];
+        while (std::get<1>(m_entries[i]) != last) i = std::get<1>(m_entries[i]);
+        std::get<1>(m_entries[i]) = index;
+      }
+    }
+    m_entries.pop_back();
+
+    if (m_num_garbage_key_bytes * 2 > m_key_arena.size()) {
+      priv_compact_key_arena();
     }
-    assert(hash != k_max_internal_id);
-    return hash;
   }
 
-  static internal_id_type priv_increment_internal_id(
-      const internal_id_type id) {
-    const auto new_id = (id + 1) % k_max_internal_id;
-    assert(new_id != k_max_internal_id);
-    return new_id;
+  /// \brief Allocates a new table and inserts the existing keys into it.
+  void priv_rebuild_table(const std::size_t capacity) {
+    assert(capacity % k_group_size == 0);
+    vector_type<uint8_t> old_controls(capacity, k_empty,
+                                      m_controls.get_allocator());
+    vector_type<index_type> old_slots(capacity, k_npos,
+                                      m_slots.get_allocator());
+    old_controls.swap(m_controls);
+    old_slots.swap(m_slots);
+    m_num_used_slots = 0;
+    m_max_id_probe_distance = 0;
+
+    for (std::size_t i = 0; i < old_controls.size(); ++i) {
+      if (old_controls[i] >= k_empty) continue;  // Empty or deleted
+      const auto key = priv_key(std::get<0>(m_entries[old_slots[i]]));
+      const auto hash = priv_hash_key(key, m_hash_seed);
+      const auto slot = priv_find_available_slot(hash);
+      ++m_num_used_slots;
+      m_controls[slot] = priv_hash_tag(hash);
+      m_slots[slot] = old_slots[i];
+    }
+  }
+
+  /// \brief Returns the table size (power of 2) to hold 'num_keys' keys.
+  static std::size_t priv_calc_capacity(const std::size_t num_keys) {
+    std::size_t capacity = k_group_size;
+    while (capacity * 7 < num_keys * 8) capacity *= 2;
+    return capacity;
+  }
+
+  /// \brief Removes the erased keys from the key arena.
+  void priv_compact_key_arena() {
+    if (m_num_garbage_key_bytes == 0) return;
+    vector_type<char> new_arena(m_key_arena.get_allocator());
+    new_arena.reserve(m_key_arena.size() - m_num_garbage_key_bytes);
+    for (std::size_t s = 0; s < m_controls.size(); ++s) {
+      if (m_controls[s] >= k_empty) continue;  // Empty or deleted
+      const auto &head_key = std::get<0>(m_entries[m_slots[s]]);
+      if (head_key.length <= k_max_inline_key_length) continue;
+      const auto key = priv_key(head_key);
+      const uint64_t offset = new_arena.size();
+      new_arena.insert(new_arena.end(), key.begin(), key.end());
+      // Update all elements that share the key
+      for (auto i = m_slots[s]; i != k_npos; i = std::get<1>(m_entries[i])) {
+        std::memcpy(std::get<0>(m_entries[i]).data, &offset, sizeof(offset));
+      }
+    }
+    m_key_arena.swap(new_arena);
+    m_num_garbage_key_bytes = 0;
+  }
+
+  internal_key_type priv_make_internal_key(const key_type &key) {
+    internal_key_type internal_key;
+    assert(key.length() <= std::numeric_limits<uint32_t>::max());
+    internal_key.length = (uint32_t)key.length();
+    if (key.length() <= k_max_inline_key_length) {
+      std::memcpy(internal_key.data, key.data(), key.length());
+    } else {
+      const uint64_t offset = m_key_arena.size();
+      m_key_arena.insert(m_key_arena.end(), key.begin(), key.end());
+      std::memcpy(internal_key.data, &offset, sizeof(offset));
+    }
+    return internal_key;
+  }
+
+  key_type priv_key(const internal_key_type &internal_key) const {
+    if (internal_key.length <= k_max_inline_key_length) {
+      return key_type(internal_key.data, internal_key.length);
+    }
+    uint64_t offset;
+    std::memcpy(&offset, internal_key.data, sizeof(offset));
+    return key_type(&m_key_arena[offset], internal_key.length);
+  }
+
+  static uint64_t priv_hash_key(const key_type &key,
+                                [[maybe_unused]] const uint64_t seed) {
+#ifdef METALL_CONTAINER_STRING_KEY_STORE_USE_SIMPLE_HASH
+    return key.empty() ? 0 : (uint8_t)key[0] % 2;
+#else
+    return metall::mtlldetail::murmur_hash_64a(key.data(), (int)key.length(),
+                                               seed);
+#endif
   }
 
   bool m_unique{false};
   uint64_t m_hash_seed{123};
-  map_type m_map{allocator_type{}};
   std::size_t m_max_id_probe_distance{0};
+  std::size_t m_num_keys{0};
+  std::size_t m_num_used_slots{0};
+  std::size_t m_num_garbage_key_bytes{0};
+  entry_table_type m_entries;
+  vector_type<char> m_key_arena;
+  vector_type<uint8_t> m_controls;
+  vector_type<index_type> m_slots;
 };
 
 }  // namespace metall::container
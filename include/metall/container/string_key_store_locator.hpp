@@ -6,38 +6,67 @@
 #ifndef METALL_CONTAINER_CONCURRENT__STRING_KEY_STORE_LOCATOR_HPP_
 #define METALL_CONTAINER_CONCURRENT__STRING_KEY_STORE_LOCATOR_HPP_
 
+#include <cstdint>
+#include <limits>
+#include <tuple>
+
 namespace metall::container {
 
-template <typename iterator_type>
+/// \brief Points to an element of string_key_store.
+/// A locator obtained by equal_range() visits only the elements that have
+/// the same key; otherwise, a locator visits all elements in the store.
+/// \tparam entry_table_type The type of the element array of the store.
+template <typename entry_table_type>
 class string_key_store_locator {
  private:
   template <typename value_type, typename allocator_type>
   friend class string_key_store;
 
- public:
-  string_key_store_locator(iterator_type iterator) : m_iterator(iterator) {}
+  using index_type = uint64_t;
+  static constexpr index_type k_npos = std::numeric_limits<index_type>::max();
+
+  string_key_store_locator(const entry_table_type *const entries,
+                           const index_type index,
+                           const bool follow_duplicates = false)
+      : m_entries(entries),
+        m_index(index),
+        m_follow_duplicates(follow_duplicates) {}
 
+ public:
   string_key_store_locator &operator++() {
-    ++m_iterator;
+    priv_increment();
     return *this;
   }
 
   string_key_store_locator operator++(int) {
     auto tmp(*this);
-    ++m_iterator;
+    priv_increment();
     return tmp;
   }
 
   bool operator==(const string_key_store_locator &other) const {
-    return m_iterator == other.m_iterator;
+    return m_index == other.m_index;
   }
 
   bool operator!=(const string_key_store_locator &other) const {
-    return m_iterator != other.m_iterator;
+    return m_index != other.m_index;
   }
 
  private:
-  iterator_type m_iterator;
+  void priv_increment() {
+    if (m_follow_duplicates) {
+      // The second element holds the index of the next element that has
+      // the same key
+      m_index = std::get<1>((*m_entries)[m_index]);
+    } else {
+      ++m_index;
+      if (m_index >= m_entries->size()) m_index = k_npos;
+    }
+  }
+
+  const entry_table_type *m_entries;
+  index_type m_index;
+  bool m_follow_duplicates;
 };
 
 }  // namespace metall::container
@@ -0,0 +1,303 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_STRING_POOL_HPP
+#define METALL_CONTAINER_STRING_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <metall/metall.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/utility/mutex.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A concurrent string intern pool that can be stored in persistent
+/// memory.
+/// Each distinct string is stored once and is given a dense integer ID
+/// (0, 1, 2, ...) in the order of insertion. Containers can store the IDs
+/// instead of strings; comparing two interned strings is comparing their
+/// IDs.
+/// Strings cannot be removed from a pool.
+/// Like concurrent_map, this container does not allocate mutex objects
+/// internally but uses static ones.
+/// \tparam _id_type An unsigned integer type for IDs.
+/// \tparam _allocator_type An allocator type.
+/// \tparam k_num_shards The number of shards of the hash index.
+/// Must be a power of two up to 256.
+template <typename _id_type = uint32_t,
+          typename _allocator_type = metall::manager::allocator_type<std::byte>,
+          std::size_t k_num_shards = 64>
+class string_pool {
+  static_assert(std::is_unsigned_v<_id_type>, "ID type must be unsigned");
+  static_assert(k_num_shards > 0 && k_num_shards <= 256 &&
+                    (k_num_shards & (k_num_shards - 1)) == 0,
+                "The number of shards must be a power of two up to 256");
+
+ public:
+  using id_type = _id_type;
+  using allocator_type = _allocator_type;
+  using size_type = std::size_t;
+
+  /// \brief An ID that does not correspond to any string.
+  static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+ private:
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<T>;
+  using char_allocator_type = other_allocator_type<char>;
+  using char_pointer =
+      typename std::allocator_traits<char_allocator_type>::pointer;
+  using char_pointer_allocator_type = other_allocator_type<char_pointer>;
+  using block_pointer =
+      typename std::allocator_traits<char_pointer_allocator_type>::pointer;
+  using id_allocator_type = other_allocator_type<id_type>;
+  using id_pointer = typename std::allocator_traits<id_allocator_type>::pointer;
+
+  // The ID-to-string table consists of blocks of doubling sizes so that the
+  // table grows without moving the existing entries
+  static constexpr size_type k_first_block_size = 1024;
+  static constexpr size_type k_num_blocks = 48;
+
+  /// A hash table of IDs. 0 denotes an empty slot; otherwise, ID + 1.
+  struct shard_type {
+    size_type size{0};
+    size_type capacity{0};
+    id_pointer slots{nullptr};
+  };
+
+ public:
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit string_pool(const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {
+    for (auto &block : m_blocks) block = nullptr;
+  }
+
+  /// \brief Destructor. Deallocates all strings.
+  ~string_pool() noexcept { priv_deallocate_all(); }
+
+  string_pool(const string_pool &) = delete;
+  string_pool(string_pool &&) = delete;
+  string_pool &operator=(const string_pool &) = delete;
+  string_pool &operator=(string_pool &&) = delete;
+
+  /// \brief Inserts a string if it does not exist and returns its ID.
+  /// This function is thread-safe.
+  /// \param str A string to intern.
+  /// \return The ID of 'str'.
+  id_type intern(const std::string_view &str) {
+    const auto hash = priv_hash(str);
+    const auto shard_no = hash & (k_num_shards - 1);
+    auto lock = priv_lock(shard_no);
+    auto &shard = m_shards[shard_no];
+
+    const auto found = priv_find(shard, str, hash);
+    if (found != npos) return found;
+
+    const auto id = priv_append(str);
+    if ((shard.size + 1) * 4 > shard.capacity * 3) {
+      priv_rehash(shard, std::max(size_type(16), shard.capacity * 2));
+    }
+    priv_insert_slot(shard, id, hash);
+    ++shard.size;
+    return id;
+  }
+
+  /// \brief Finds the ID of a string.
+  /// This function is thread-safe.
+  /// \param str A string to find.
+  /// \return The ID of 'str' if it exists; otherwise, npos.
+  id_type find(const std::string_view &str) const {
+    const auto hash = priv_hash(str);
+    const auto shard_no = hash & (k_num_shards - 1);
+    auto lock = priv_lock(shard_no);
+    return priv_find(m_shards[shard_no], str, hash);
+  }
+
+  /// \brief Returns the string of an ID.
+  /// This function does not take any lock; it can be called with an ID
+  /// returned by intern() or find() while other threads intern strings.
+  /// \param id A valid ID.
+  /// \return The string of 'id'.
+  /// The string is valid as long as this pool exists.
+  std::string_view operator[](const id_type id) const {
+    assert(id < size());
+    const auto [block_no, offset] = priv_locate(id);
+    return priv_record_string(
+        metall::to_raw_pointer(metall::to_raw_pointer(
+            m_blocks[block_no])[offset]));
+  }
+
+  /// \brief Returns the number of strings.
+  /// \return The number of strings.
+  size_type size() const { return m_num_strings.load(); }
+
+  /// \brief Checks if the pool is empty.
+  /// \return True if the pool is empty; otherwise, false.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns an instance of the allocator.
+  /// \return An allocator object.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  /// \brief Locks a shard or, if k_num_shards is given, the ID table.
+  static auto priv_lock(const size_type index) {
+    return metall::utility::mutex::mutex_lock<k_num_shards + 1>(index);
+  }
+
+  static uint64_t priv_hash(const std::string_view &str) {
+    return mdtl::murmur_hash_64a(str.data(), (int)str.length(), 123);
+  }
+
+  /// \brief Returns the block number and the offset in the block of 'id'.
+  static std::pair<size_type, size_type> priv_locate(const id_type id) {
+    const size_type v = size_type(id) / k_first_block_size + 1;
+    const size_type block_no = 63 - mdtl::clzll(v);
+    const size_type offset =
+        size_type(id) - k_first_block_size * ((size_type(1) << block_no) - 1);
+    return {block_no, offset};
+  }
+
+  /// \brief Each record is a 32-bit length followed by the characters.
+  static std::string_view priv_record_string(const char *const record) {
+    uint32_t length;
+    std::memcpy(&length, record, sizeof(length));
+    return std::string_view(record + sizeof(length), length);
+  }
+
+  /// \brief Stores a string and gives it a new ID.
+  id_type priv_append(const std::string_view &str) {
+    assert(str.length() <= std::numeric_limits<uint32_t>::max());
+    char_allocator_type char_alloc(m_allocator);
+    const auto length = (uint32_t)str.length();
+    auto record = std::allocator_traits<char_allocator_type>::allocate(
+        char_alloc, sizeof(length) + length);
+    auto *const raw_record = metall::to_raw_pointer(record);
+    std::memcpy(raw_record, &length, sizeof(length));
+    std::memcpy(raw_record + sizeof(length), str.data(), length);
+
+    // Only one thread appends at a time
+    auto lock = priv_lock(k_num_shards);
+    const auto id = m_num_strings.load(std::memory_order_relaxed);
+    assert(id < npos);
+    const auto [block_no, offset] = priv_locate(id);
+    assert(block_no < k_num_blocks);
+    if (offset == 0) {
+      char_pointer_allocator_type block_alloc(m_allocator);
+      const auto block_size = k_first_block_size << block_no;
+      m_blocks[block_no] =
+          std::allocator_traits<char_pointer_allocator_type>::allocate(
+              block_alloc, block_size);
+      for (size_type i = 0; i < block_size; ++i) {
+        new (metall::to_raw_pointer(m_blocks[block_no]) + i)
+            char_pointer(nullptr);
+      }
+    }
+    metall::to_raw_pointer(m_blocks[block_no])[offset] = record;
+    m_num_strings.store(id + 1, std::memory_order_release);
+    return id;
+  }
+
+  id_type priv_find(const shard_type &shard, const std::string_view &str,
+                    const uint64_t hash) const {
+    if (shard.capacity == 0) return npos;
+    const auto *const slots = metall::to_raw_pointer(shard.slots);
+    for (auto pos = priv_home_slot(shard, hash);;
+         pos = (pos + 1) & (shard.capacity - 1)) {
+      if (slots[pos] == 0) return npos;
+      if ((*this)[slots[pos] - 1] == str) return slots[pos] - 1;
+    }
+  }
+
+  static size_type priv_home_slot(const shard_type &shard,
+                                  const uint64_t hash) {
+    // The lower bits are used to choose the shard
+    return (hash >> 8ULL) & (shard.capacity - 1);
+  }
+
+  void priv_insert_slot(shard_type &shard, const id_type id,
+                        const uint64_t hash) {
+    auto *const slots = metall::to_raw_pointer(shard.slots);
+    auto pos = priv_home_slot(shard, hash);
+    while (slots[pos] != 0) pos = (pos + 1) & (shard.capacity - 1);
+    slots[pos] = id + 1;
+  }
+
+  void priv_rehash(shard_type &shard, const size_type new_capacity) {
+    id_allocator_type id_alloc(m_allocator);
+    const auto old_slots = shard.slots;
+    const auto old_capacity = shard.capacity;
+    shard.slots = std::allocator_traits<id_allocator_type>::allocate(
+        id_alloc, new_capacity);
+    shard.capacity = new_capacity;
+    std::fill_n(metall::to_raw_pointer(shard.slots), new_capacity, 0);
+
+    for (size_type i = 0; i < old_capacity; ++i) {
+      const auto id_plus_one = metall::to_raw_pointer(old_slots)[i];
+      if (id_plus_one == 0) continue;
+      priv_insert_slot(shard, id_plus_one - 1,
+                       priv_hash((*this)[id_plus_one - 1]));
+    }
+    if (old_slots) {
+      std::allocator_traits<id_allocator_type>::deallocate(id_alloc, old_slots,
+                                                           old_capacity);
+    }
+  }
+
+  void priv_deallocate_all() noexcept {
+    char_allocator_type char_alloc(m_allocator);
+    for (size_type id = 0; id < size(); ++id) {
+      const auto [block_no, offset] = priv_locate(id);
+      auto &record = metall::to_raw_pointer(m_blocks[block_no])[offset];
+      const auto str = (*this)[id];
+      std::allocator_traits<char_allocator_type>::deallocate(
+          char_alloc, record, sizeof(uint32_t) + str.length());
+    }
+
+    char_pointer_allocator_type block_alloc(m_allocator);
+    for (size_type b = 0; b < k_num_blocks; ++b) {
+      if (!m_blocks[b]) continue;
+      std::allocator_traits<char_pointer_allocator_type>::deallocate(
+          block_alloc, m_blocks[b], k_first_block_size << b);
+      m_blocks[b] = nullptr;
+    }
+
+    id_allocator_type id_alloc(m_allocator);
+    for (auto &shard : m_shards) {
+      if (!shard.slots) continue;
+      std::allocator_traits<id_allocator_type>::deallocate(
+          id_alloc, shard.slots, shard.capacity);
+      shard = shard_type{};
+    }
+    m_num_strings = 0;
+  }
+
+  allocator_type m_allocator;
+  std::atomic<size_type> m_num_strings{0};
+  block_pointer m_blocks[k_num_blocks];
+  shard_type m_shards[k_num_shards];
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_STRING_POOL_HPP
@@ -0,0 +1,974 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_CONTAINER_VERSIONED_MAP_HPP
+#define METALL_CONTAINER_VERSIONED_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/atomic_relative_ptr.hpp>
+#include <metall/detail/epoch_reclaimer.hpp>
+
+namespace metall::container {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A multi-version ordered map which can be stored in persistent
+/// memory.
+/// The map is a copy-on-write B+tree: nodes are never modified once they
+/// are reachable from the root. A modification copies the nodes on the path
+/// from the root to the leaf it changes, and publishes the new root
+/// atomically; the new version shares all the other nodes with the old one.
+/// A reader takes a snapshot, which holds the root at the time, and sees
+/// that version until it is destroyed; thus, reads take no lock and never
+/// block or are blocked by a writer. Writers are serialized by a spin lock.
+/// A node replaced by a modification is freed once no snapshot that may
+/// still read it is alive (epoch-based reclamation); a long-lived snapshot
+/// delays freeing the nodes replaced after it was taken.
+/// Like concurrent_skip_list_map, the write lock and the epoch counters are
+/// kept in the container; a data store must not be closed while a snapshot
+/// is alive or an operation is running.
+/// \tparam _key_type A key type.
+/// \tparam _mapped_type A mapped type. Must be copy constructible.
+/// \tparam _compare A function that compares two keys.
+/// \tparam _allocator An allocator.
+/// \tparam k_node_size The size of a node in bytes. Should be a multiple of
+/// the cache line size.
+template <typename _key_type, typename _mapped_type,
+          typename _compare = std::less<_key_type>,
+          typename _allocator =
+              std::allocator<std::pair<const _key_type, _mapped_type>>,
+          std::size_t k_node_size = 512>
+class versioned_map {
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  /// \brief A key type.
+  using key_type = _key_type;
+  /// \brief A mapped type.
+  using mapped_type = _mapped_type;
+  /// \brief A value type (i.e., std::pair<const key_type, mapped_type>).
+  using value_type = std::pair<const key_type, mapped_type>;
+  /// \brief A unsigned integer type (usually std::size_t).
+  using size_type = std::size_t;
+  /// \brief A key comparison function type.
+  using key_compare = _compare;
+  /// \brief An allocator type.
+  using allocator_type = _allocator;
+
+  class snapshot_type;
+
+ private:
+  template <typename T>
+  using other_allocator_type =
+      typename std::allocator_traits<_allocator>::template rebind_alloc<T>;
+
+  struct node_type;
+  struct leaf_node;
+  struct internal_node;
+
+  using node_pointer = typename std::allocator_traits<
+      other_allocator_type<node_type>>::pointer;
+  using leaf_allocator_type = other_allocator_type<leaf_node>;
+  using leaf_pointer =
+      typename std::allocator_traits<leaf_allocator_type>::pointer;
+  using internal_allocator_type = other_allocator_type<internal_node>;
+  using internal_pointer =
+      typename std::allocator_traits<internal_allocator_type>::pointer;
+  using value_allocator_type = other_allocator_type<value_type>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+  using link_type = mdtl::atomic_relative_ptr<node_type>;
+
+  static constexpr std::size_t k_cache_line_size = 64;
+  static constexpr std::size_t k_header_size = 24;
+
+  static constexpr std::size_t priv_num_slots(const std::size_t space,
+                                              const std::size_t slot_size) {
+    return std::max(std::size_t(4), space / slot_size);
+  }
+
+  /// Number of elements in a leaf
+  static constexpr std::size_t k_leaf_slots =
+      priv_num_slots(k_node_size - k_header_size, sizeof(value_type));
+  /// Number of keys in an internal node
+  static constexpr std::size_t k_internal_slots = priv_num_slots(
+      k_node_size - k_header_size - sizeof(node_pointer),
+      sizeof(key_type) + sizeof(node_pointer));
+  static constexpr std::size_t k_min_leaf_slots = k_leaf_slots / 2;
+  static constexpr std::size_t k_min_internal_slots = k_internal_slots / 2;
+  // A non-root internal node has 3 or more children
+  static constexpr std::size_t k_max_depth = 48;
+  static constexpr int k_num_spins = 64;
+
+  /// \brief Uninitialized storage of objects.
+  template <typename T, std::size_t N>
+  struct slot_array {
+    T *data() { return std::launder(reinterpret_cast<T *>(buf)); }
+    const T *data() const {
+      return std::launder(reinterpret_cast<const T *>(buf));
+    }
+    alignas(T) unsigned char buf[sizeof(T) * N];
+  };
+
+  struct alignas(k_cache_line_size) node_type {
+    // The next node in a list of the replaced nodes
+    link_type retired_next;
+    uint32_t level{0};  // 0 for leaves
+    uint32_t size{0};   // The number of elements or keys
+    size_type num_elements{0};  // In the subtree
+  };
+
+  struct leaf_node : node_type {
+    slot_array<value_type, k_leaf_slots> slots;
+  };
+
+  /// children[i] holds keys less than keys[i];
+  /// children[i + 1] holds keys equal to or greater than keys[i]
+  struct internal_node : node_type {
+    slot_array<key_type, k_internal_slots> keys;
+    node_pointer children[k_internal_slots + 1];
+  };
+
+  using reclaimer_type = mdtl::epoch_reclaimer<node_type>;
+  using epoch_guard = typename reclaimer_type::guard;
+
+  class write_lock_guard {
+   public:
+    explicit write_lock_guard(std::atomic<uint32_t> &lock) noexcept
+        : m_lock(lock) {
+      while (true) {
+        if (m_lock.exchange(1, std::memory_order_acquire) == 0) return;
+        for (int i = 0; m_lock.load(std::memory_order_relaxed) != 0; ++i) {
+          if (i >= k_num_spins) std::this_thread::yield();
+        }
+      }
+    }
+    ~write_lock_guard() noexcept { m_lock.store(0, std::memory_order_release); }
+    write_lock_guard(const write_lock_guard &) = delete;
+    write_lock_guard &operator=(const write_lock_guard &) = delete;
+
+   private:
+    std::atomic<uint32_t> &m_lock;
+  };
+
+  /// \brief The nodes created and replaced by a modification.
+  /// Nothing is freed until the modification finishes, so that keys in the
+  /// nodes can be referred to while building new ones.
+  struct write_context {
+    static constexpr std::size_t k_capacity = 4 * k_max_depth;
+
+    void add(node_type **const list, std::size_t *const count,
+             node_type *const node) {
+      assert(*count < k_capacity);
+      list[(*count)++] = node;
+    }
+
+    // Nodes allocated by this modification
+    node_type *created[k_capacity];
+    std::size_t num_created{0};
+    // Nodes created by this modification and replaced by it again
+    node_type *discarded[k_capacity];
+    std::size_t num_discarded{0};
+    // Nodes of the current version replaced by this modification
+    node_type *replaced[k_capacity];
+    std::size_t num_replaced{0};
+  };
+
+  enum class write_result { k_unchanged, k_inserted, k_assigned };
+
+  /// \brief The nodes that replace a node in its parent.
+  struct split_result {
+    node_type *left{nullptr};
+    // Not null if the node was split
+    node_type *right{nullptr};
+    // The smallest key in 'right'
+    const key_type *separator{nullptr};
+  };
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  /// \brief Constructor.
+  /// \param allocator An allocator object.
+  explicit versioned_map(const allocator_type &allocator = allocator_type())
+      : m_allocator(allocator) {}
+
+  /// \brief Destructor.
+  /// Must not be called while a snapshot is alive or concurrently with
+  /// others.
+  ~versioned_map() noexcept { priv_destroy(); }
+
+  versioned_map(const versioned_map &) = delete;
+  versioned_map &operator=(const versioned_map &) = delete;
+
+  /// \brief Move constructor. Must not be called concurrently with others.
+  versioned_map(versioned_map &&other) noexcept
+      : m_allocator(other.m_allocator), m_compare(std::move(other.m_compare)) {
+    m_root.store(other.m_root.exchange(nullptr));
+    m_reclaimer.take(other.m_reclaimer);
+  }
+
+  /// \brief Move assignment operator.
+  /// Must not be called concurrently with others.
+  versioned_map &operator=(versioned_map &&other) noexcept {
+    if (this != &other) {
+      priv_destroy();
+      m_allocator = other.m_allocator;
+      m_compare = std::move(other.m_compare);
+      m_root.store(other.m_root.exchange(nullptr));
+      m_reclaimer.take(other.m_reclaimer);
+    }
+    return *this;
+  }
+
+  // -------------------- //
+  // Public methods
+  // -------------------- //
+  // ---------- Snapshot ---------- //
+  /// \brief Takes a snapshot of the current version.
+  /// The snapshot sees the version regardless of later modifications, and
+  /// must be destroyed before the container is.
+  snapshot_type snapshot() const { return snapshot_type(*this); }
+
+  // ---------- Capacity ---------- //
+  /// \brief Returns the number of elements in the current version.
+  size_type size() const { return snapshot().size(); }
+
+  /// \brief Returns true if the current version has no element.
+  bool empty() const { return size() == 0; }
+
+  // ---------- Modifier ---------- //
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  /// \brief Inserts an element if the container does not already contain an
+  /// element with an equivalent key.
+  /// \param value An element to insert.
+  /// \return Returns true if the element was inserted.
+  bool insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  /// \brief Inserts an element constructed in-place with 'args' if the
+  /// container does not already contain an element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param args Arguments to construct the mapped value.
+  /// \return Returns true if the element was inserted.
+  template <typename... args_type>
+  bool try_emplace(const key_type &key, args_type &&...args) {
+    auto construct = [&key, &args...](value_allocator_type &alloc,
+                                      value_type *const slot,
+                                      const value_type *) {
+      value_allocator_traits::construct(
+          alloc, slot, std::piecewise_construct, std::forward_as_tuple(key),
+          std::forward_as_tuple(std::forward<args_type>(args)...));
+    };
+    return priv_write(key, false, construct) == write_result::k_inserted;
+  }
+
+  /// \brief Inserts an element or assigns to the mapped value of the
+  /// element with an equivalent key.
+  /// \param key A key of the element.
+  /// \param mapped A mapped value to insert or assign.
+  /// \return Returns true if the element was inserted, false if assigned.
+  template <typename mapped_arg_type>
+  bool insert_or_assign(const key_type &key, mapped_arg_type &&mapped) {
+    auto construct = [&key, &mapped](value_allocator_type &alloc,
+                                     value_type *const slot,
+                                     const value_type *) {
+      value_allocator_traits::construct(
+          alloc, slot, key, std::forward<mapped_arg_type>(mapped));
+    };
+    return priv_write(key, true, construct) == write_result::k_inserted;
+  }
+
+  /// \brief Modifies the mapped value of the element with an equivalent key
+  /// in a new version.
+  /// The element is copied and 'editor' modifies the copy, which snapshots
+  /// taken earlier do not see.
+  /// \param key A key of the element to update.
+  /// \param editor A function object that takes 'mapped_type &'.
+  /// \return Returns true if an element was found.
+  template <typename editor_type>
+  bool update(const key_type &key, editor_type &&editor) {
+    bool found = false;
+    auto construct = [&editor, &found](value_allocator_type &alloc,
+                                       value_type *const slot,
+                                       const value_type *const old_value) {
+      assert(old_value);
+      value_allocator_traits::construct(alloc, slot, *old_value);
+      found = true;
+      try {
+        editor(slot->second);
+      } catch (...) {
+        value_allocator_traits::destroy(alloc, slot);
+        throw;
+      }
+    };
+    priv_write(key, true, construct, true);
+    return found;
+  }
+
+  /// \brief Removes the element with an equivalent key.
+  /// \param key A key of the element to remove.
+  /// \return The number of removed elements (0 or 1).
+  size_type erase(const key_type &key) {
+    bool erased = false;
+    {
+      write_lock_guard lock(m_write_lock);
+      auto *const root = m_root.load();
+      if (!root) return 0;
+      write_context ctx;
+      node_type *new_root = nullptr;
+      try {
+        erased = priv_erase(&ctx, root, key, &new_root);
+        if (erased) new_root = priv_shrink_root(&ctx, new_root);
+      } catch (...) {
+        priv_abort(&ctx);
+        throw;
+      }
+      if (!erased) return 0;
+      priv_discard(&ctx, root);
+      priv_commit(&ctx, new_root);
+    }
+    priv_try_reclaim();
+    return 1;
+  }
+
+  /// \brief Removes all elements.
+  /// Snapshots taken earlier still see the elements.
+  void clear() {
+    {
+      write_lock_guard lock(m_write_lock);
+      auto *const root = m_root.load();
+      if (!root) return;
+      m_root.store(nullptr, std::memory_order_seq_cst);
+      priv_retire_subtree(root);
+    }
+    priv_try_reclaim();
+  }
+
+  // ---------- Look up ---------- //
+  /// \brief Returns the number of elements with an equivalent key in the
+  /// current version.
+  /// \param key A key of the elements to count.
+  /// \return Either 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with an equivalent key in the
+  /// current version.
+  bool contains(const key_type &key) const {
+    return snapshot().contains(key);
+  }
+
+  /// \brief Copies the mapped value of the element with an equivalent key
+  /// in the current version.
+  /// \param key A key of the element to find.
+  /// \param mapped A pointer to store the mapped value.
+  /// \return Returns true if an element was found.
+  bool find(const key_type &key, mapped_type *const mapped) const {
+    const auto snap = snapshot();
+    const auto *const value = snap.find(key);
+    if (!value) return false;
+    *mapped = value->second;
+    return true;
+  }
+
+  // ---------- Allocator ---------- //
+  /// \brief Returns the allocator associated with the container.
+  allocator_type get_allocator() const { return m_allocator; }
+
+ private:
+  // -------------------- //
+  // Nodes
+  // -------------------- //
+  static leaf_node *priv_leaf(node_type *const node) noexcept {
+    return static_cast<leaf_node *>(node);
+  }
+  static const leaf_node *priv_leaf(const node_type *const node) noexcept {
+    return static_cast<const leaf_node *>(node);
+  }
+  static internal_node *priv_internal(node_type *const node) noexcept {
+    return static_cast<internal_node *>(node);
+  }
+  static const internal_node *priv_internal(
+      const node_type *const node) noexcept {
+    return static_cast<const internal_node *>(node);
+  }
+
+  static node_type *priv_child(const internal_node *const node,
+                               const size_type index) noexcept {
+    return metall::to_raw_pointer(node->children[index]);
+  }
+
+  static bool priv_is_underfull(const node_type *const node) noexcept {
+    return node->size <
+           (node->level == 0 ? k_min_leaf_slots : k_min_internal_slots);
+  }
+
+  leaf_node *priv_new_leaf(write_context *const ctx) {
+    leaf_allocator_type alloc(m_allocator);
+    auto ptr = std::allocator_traits<leaf_allocator_type>::allocate(alloc, 1);
+    auto *const leaf = new (metall::to_raw_pointer(ptr)) leaf_node();
+    ctx->add(ctx->created, &ctx->num_created, leaf);
+    return leaf;
+  }
+
+  internal_node *priv_new_internal(write_context *const ctx,
+                                   const uint32_t level) {
+    internal_allocator_type alloc(m_allocator);
+    auto ptr =
+        std::allocator_traits<internal_allocator_type>::allocate(alloc, 1);
+    auto *const node = new (metall::to_raw_pointer(ptr)) internal_node();
+    node->level = level;
+    ctx->add(ctx->created, &ctx->num_created, node);
+    return node;
+  }
+
+  /// \brief Frees a node, but not its children.
+  void priv_free_node(node_type *const node) noexcept {
+    if (node->level == 0) {
+      auto *const leaf = priv_leaf(node);
+      value_allocator_type alloc(m_allocator);
+      for (size_type i = 0; i < leaf->size; ++i) {
+        value_allocator_traits::destroy(alloc, leaf->slots.data() + i);
+      }
+      leaf->~leaf_node();
+      leaf_allocator_type leaf_alloc(m_allocator);
+      std::allocator_traits<leaf_allocator_type>::deallocate(
+          leaf_alloc, leaf_pointer(leaf), 1);
+      return;
+    }
+    auto *const internal = priv_internal(node);
+    for (size_type i = 0; i < internal->size; ++i) {
+      internal->keys.data()[i].~key_type();
+    }
+    internal->~internal_node();
+    internal_allocator_type alloc(m_allocator);
+    std::allocator_traits<internal_allocator_type>::deallocate(
+        alloc, internal_pointer(internal), 1);
+  }
+
+  void priv_free_subtree(node_type *const node) noexcept {
+    if (node->level > 0) {
+      auto *const internal = priv_internal(node);
+      for (size_type i = 0; i <= internal->size; ++i) {
+        priv_free_subtree(priv_child(internal, i));
+      }
+    }
+    priv_free_node(node);
+  }
+
+  void priv_retire_subtree(node_type *const node) noexcept {
+    if (node->level > 0) {
+      auto *const internal = priv_internal(node);
+      for (size_type i = 0; i <= internal->size; ++i) {
+        priv_retire_subtree(priv_child(internal, i));
+      }
+    }
+    m_reclaimer.retire(node);
+  }
+
+  /// \brief Builds a leaf from elements.
+  /// A null source is constructed by 'construct' instead of copied.
+  template <typename constructor_type>
+  leaf_node *priv_build_leaf(write_context *const ctx,
+                             const value_type *const *const sources,
+                             const size_type count,
+                             constructor_type &construct) {
+    assert(count <= k_leaf_slots);
+    auto *const leaf = priv_new_leaf(ctx);
+    value_allocator_type alloc(m_allocator);
+    for (size_type i = 0; i < count; ++i) {
+      auto *const slot = leaf->slots.data() + i;
+      if (sources[i]) {
+        value_allocator_traits::construct(alloc, slot, *sources[i]);
+      } else {
+        construct(alloc, slot, nullptr);
+      }
+      // Counted only when constructed so that an exception frees it right
+      ++leaf->size;
+    }
+    leaf->num_elements = leaf->size;
+    return leaf;
+  }
+
+  /// \brief Builds an internal node from 'count' keys and 'count + 1'
+  /// children.
+  internal_node *priv_build_internal(write_context *const ctx,
+                                     const uint32_t level,
+                                     node_type *const *const children,
+                                     const key_type *const *const keys,
+                                     const size_type count) {
+    assert(count <= k_internal_slots);
+    auto *const node = priv_new_internal(ctx, level);
+    for (size_type i = 0; i < count; ++i) {
+      new (node->keys.data() + i) key_type(*keys[i]);
+      ++node->size;
+    }
+    for (size_type i = 0; i <= count; ++i) {
+      node->children[i] = node_pointer(children[i]);
+      node->num_elements += children[i]->num_elements;
+    }
+    return node;
+  }
+
+  /// \brief Builds one or two internal nodes from keys and children.
+  split_result priv_build_internals(write_context *const ctx,
+                                    const uint32_t level,
+                                    node_type *const *const children,
+                                    const key_type *const *const keys,
+                                    const size_type count) {
+    if (count <= k_internal_slots) {
+      return {priv_build_internal(ctx, level, children, keys, count), nullptr,
+              nullptr};
+    }
+    // The middle key moves up to the parent
+    const size_type half = count / 2;
+    auto *const left = priv_build_internal(ctx, level, children, keys, half);
+    auto *const right = priv_build_internal(
+        ctx, level, children + half + 1, keys + half + 1, count - half - 1);
+    return {left, right, keys[half]};
+  }
+
+  /// \brief Builds one or two leaves from elements.
+  template <typename constructor_type>
+  split_result priv_build_leaves(write_context *const ctx,
+                                 const value_type *const *const sources,
+                                 const size_type count,
+                                 constructor_type &construct) {
+    if (count <= k_leaf_slots) {
+      return {priv_build_leaf(ctx, sources, count, construct), nullptr,
+              nullptr};
+    }
+    const size_type half = count / 2;
+    auto *const left = priv_build_leaf(ctx, sources, half, construct);
+    auto *const right =
+        priv_build_leaf(ctx, sources + half, count - half, construct);
+    return {left, right, &priv_leaf(right)->slots.data()[0].first};
+  }
+
+  // -------------------- //
+  // Search
+  // -------------------- //
+  /// \brief Returns the child index to descend into.
+  size_type priv_child_index(const internal_node *const node,
+                             const key_type &key) const {
+    const auto *const keys = node->keys.data();
+    return std::upper_bound(keys, keys + node->size, key, m_compare) - keys;
+  }
+
+  size_type priv_leaf_lower_bound(const leaf_node *const leaf,
+                                  const key_type &key) const {
+    const auto *const slots = leaf->slots.data();
+    return std::lower_bound(slots, slots + leaf->size, key,
+                            [this](const value_type &lhs, const key_type &rhs) {
+                              return m_compare(lhs.first, rhs);
+                            }) -
+           slots;
+  }
+
+  const value_type *priv_find(const node_type *node,
+                              const key_type &key) const {
+    if (!node) return nullptr;
+    while (node->level > 0) {
+      const auto *const internal = priv_internal(node);
+      node = priv_child(internal, priv_child_index(internal, key));
+    }
+    const auto *const leaf = priv_leaf(node);
+    const auto pos = priv_leaf_lower_bound(leaf, key);
+    if (pos == leaf->size || m_compare(key, leaf->slots.data()[pos].first)) {
+      return nullptr;
+    }
+    return leaf->slots.data() + pos;
+  }
+
+  /// \brief Calls 'func' with the elements in [*first, *last) of a subtree.
+  /// A null bound means no bound.
+  /// \return Returns false if an element not less than *last was reached.
+  template <typename function_type>
+  bool priv_scan(const node_type *const node, const key_type *const first,
+                 const key_type *const last, function_type &func) const {
+    if (node->level == 0) {
+      const auto *const leaf = priv_leaf(node);
+      const auto *const slots = leaf->slots.data();
+      for (size_type i = first ? priv_leaf_lower_bound(leaf, *first) : 0;
+           i < leaf->size; ++i) {
+        if (last && !m_compare(slots[i].first, *last)) return false;
+        func(slots[i]);
+      }
+      return true;
+    }
+    const auto *const internal = priv_internal(node);
+    const auto *const keys = internal->keys.data();
+    const key_type *bound = first;
+    for (size_type i = first ? priv_child_index(internal, *first) : 0;
+         i <= internal->size; ++i) {
+      if (i > 0 && last && !m_compare(keys[i - 1], *last)) return false;
+      if (!priv_scan(priv_child(internal, i), bound, last, func)) return false;
+      // Only the first child visited can have elements less than *first
+      bound = nullptr;
+    }
+    return true;
+  }
+
+  // -------------------- //
+  // Modification
+  // -------------------- //
+  /// \brief Inserts or replaces an element in a new version.
+  /// 'construct' constructs the element given the old one (null if there is
+  /// no element with the key).
+  /// \param assign Replaces an existing element if true.
+  /// \param only_existing Does not insert a new element if true.
+  template <typename constructor_type>
+  write_result priv_write(const key_type &key, const bool assign,
+                          constructor_type &construct,
+                          const bool only_existing = false) {
+    write_result result = write_result::k_unchanged;
+    {
+      write_lock_guard lock(m_write_lock);
+      auto *const root = m_root.load();
+      write_context ctx;
+      split_result replacement;
+      try {
+        if (!root) {
+          if (only_existing) return write_result::k_unchanged;
+          const value_type *const source = nullptr;
+          replacement = priv_build_leaves(&ctx, &source, 1, construct);
+          result = write_result::k_inserted;
+        } else {
+          result = priv_insert(&ctx, root, key, assign, only_existing,
+                               construct, &replacement);
+        }
+        if (result == write_result::k_unchanged) return result;
+        if (replacement.right) {
+          // The root was split
+          node_type *const children[2] = {replacement.left, replacement.right};
+          replacement.left = priv_build_internal(
+              &ctx, replacement.left->level + 1, children,
+              &replacement.separator, 1);
+        }
+      } catch (...) {
+        priv_abort(&ctx);
+        throw;
+      }
+      if (root) priv_discard(&ctx, root);
+      priv_commit(&ctx, replacement.left);
+    }
+    priv_try_reclaim();
+    return result;
+  }
+
+  template <typename constructor_type>
+  write_result priv_insert(write_context *const ctx, node_type *const node,
+                           const key_type &key, const bool assign,
+                           const bool only_existing,
+                           constructor_type &construct,
+                           split_result *const out) {
+    if (node->level == 0) {
+      const auto *const leaf = priv_leaf(node);
+      const auto *const slots = leaf->slots.data();
+      const auto pos = priv_leaf_lower_bound(leaf, key);
+      const bool found = pos < leaf->size && !m_compare(key, slots[pos].first);
+      if ((found && !assign) || (!found && only_existing)) {
+        return write_result::k_unchanged;
+      }
+
+      const value_type *sources[k_leaf_slots + 1];
+      size_type count = 0;
+      for (size_type i = 0; i < pos; ++i) sources[count++] = slots + i;
+      sources[count++] = nullptr;
+      for (size_type i = pos + found; i < leaf->size; ++i) {
+        sources[count++] = slots + i;
+      }
+      const value_type *const old_value = found ? slots + pos : nullptr;
+      auto construct_at = [&construct, old_value](value_allocator_type &alloc,
+                                                  value_type *const slot,
+                                                  const value_type *) {
+        construct(alloc, slot, old_value);
+      };
+      *out = priv_build_leaves(ctx, sources, count, construct_at);
+      return found ? write_result::k_assigned : write_result::k_inserted;
+    }
+
+    const auto *const internal = priv_internal(node);
+    const auto index = priv_child_index(internal, key);
+    auto *const child = priv_child(internal, index);
+    split_result child_result;
+    const auto result = priv_insert(ctx, child, key, assign, only_existing,
+                                    construct, &child_result);
+    if (result == write_result::k_unchanged) return result;
+    priv_discard(ctx, child);
+
+    node_type *children[k_internal_slots + 2];
+    const key_type *keys[k_internal_slots + 1];
+    size_type count = 0;
+    for (size_type i = 0; i < index; ++i) {
+      children[i] = priv_child(internal, i);
+      keys[count++] = internal->keys.data() + i;
+    }
+    children[index] = child_result.left;
+    if (child_result.right) {
+      keys[count++] = child_result.separator;
+      children[count] = child_result.right;
+    }
+    for (size_type i = index; i < internal->size; ++i) {
+      keys[count++] = internal->keys.data() + i;
+      children[count] = priv_child(internal, i + 1);
+    }
+    *out = priv_build_internals(ctx, node->level, children, keys, count);
+    return result;
+  }
+
+  /// \brief Removes an element from a subtree in a new version.
+  /// \param out The node that replaces 'node', which can be underfull.
+  /// \return Returns false if there is no element with the key.
+  bool priv_erase(write_context *const ctx, node_type *const node,
+                  const key_type &key, node_type **const out) {
+    if (node->level == 0) {
+      const auto *const leaf = priv_leaf(node);
+      const auto *const slots = leaf->slots.data();
+      const auto pos = priv_leaf_lower_bound(leaf, key);
+      if (pos == leaf->size || m_compare(key, slots[pos].first)) return false;
+
+      const value_type *sources[k_leaf_slots];
+      size_type count = 0;
+      for (size_type i = 0; i < leaf->size; ++i) {
+        if (i != pos) sources[count++] = slots + i;
+      }
+      *out = priv_build_leaf(ctx, sources, count, k_no_construct);
+      return true;
+    }
+
+    const auto *const internal = priv_internal(node);
+    const auto index = priv_child_index(internal, key);
+    auto *const child = priv_child(internal, index);
+    node_type *new_child = nullptr;
+    if (!priv_erase(ctx, child, key, &new_child)) return false;
+    priv_discard(ctx, child);
+
+    node_type *children[k_internal_slots + 1];
+    const key_type *keys[k_internal_slots];
+    size_type count = internal->size;
+    for (size_type i = 0; i < count; ++i) {
+      keys[i] = internal->keys.data() + i;
+      children[i] = priv_child(internal, i);
+    }
+    children[count] = priv_child(internal, count);
+    children[index] = new_child;
+
+    if (priv_is_underfull(new_child)) {
+      // Merges the child with a sibling, or moves elements between them
+      const size_type left = (index > 0) ? index - 1 : index;
+      const auto merged =
+          priv_merge(ctx, children[left], children[left + 1], keys[left]);
+      priv_discard(ctx, children[left]);
+      priv_discard(ctx, children[left + 1]);
+      children[left] = merged.left;
+      if (merged.right) {
+        children[left + 1] = merged.right;
+        keys[left] = merged.separator;
+      } else {
+        for (size_type i = left; i + 1 < count; ++i) {
+          keys[i] = keys[i + 1];
+          children[i + 1] = children[i + 2];
+        }
+        --count;
+      }
+    }
+    *out = priv_build_internal(ctx, node->level, children, keys, count);
+    return true;
+  }
+
+  /// \brief Builds one node from two adjacent nodes at the same level, or
+  /// two nodes that share their elements evenly if one cannot hold them.
+  split_result priv_merge(write_context *const ctx, node_type *const left,
+                          node_type *const right,
+                          const key_type *const separator) {
+    if (left->level == 0) {
+      const value_type *sources[2 * k_leaf_slots];
+      size_type count = 0;
+      for (auto *const node : {left, right}) {
+        const auto *const slots = priv_leaf(node)->slots.data();
+        for (size_type i = 0; i < node->size; ++i) sources[count++] = slots + i;
+      }
+      return priv_build_leaves(ctx, sources, count, k_no_construct);
+    }
+
+    node_type *children[2 * k_internal_slots + 2];
+    const key_type *keys[2 * k_internal_slots + 1];
+    size_type count = 0;
+    for (auto *const node : {left, right}) {
+      const auto *const internal = priv_internal(node);
+      if (node == right) keys[count++] = separator;
+      for (size_type i = 0; i < node->size; ++i) {
+        children[count] = priv_child(internal, i);
+        keys[count++] = internal->keys.data() + i;
+      }
+      children[count] = priv_child(internal, node->size);
+    }
+    return priv_build_internals(ctx, left->level, children, keys, count);
+  }
+
+  /// \brief Removes the root if it is empty or has only one child.
+  node_type *priv_shrink_root(write_context *const ctx,
+                              node_type *const root) {
+    if (root->level == 0) {
+      if (root->size > 0) return root;
+      priv_discard(ctx, root);
+      return nullptr;
+    }
+    if (root->size > 0) return root;
+    auto *const child = priv_child(priv_internal(root), 0);
+    priv_discard(ctx, root);
+    return child;
+  }
+
+  /// \brief Records that a node is not in the new version.
+  void priv_discard(write_context *const ctx, node_type *const node) {
+    auto **const end = ctx->created + ctx->num_created;
+    if (std::find(ctx->created, end, node) != end) {
+      ctx->add(ctx->discarded, &ctx->num_discarded, node);
+    } else {
+      ctx->add(ctx->replaced, &ctx->num_replaced, node);
+    }
+  }
+
+  /// \brief Publishes a new version.
+  void priv_commit(write_context *const ctx, node_type *const root) noexcept {
+    // Sequentially consistent so that a snapshot that reads the old root
+    // has entered an epoch not later than the one the old nodes retire in
+    m_root.store(root, std::memory_order_seq_cst);
+    for (std::size_t i = 0; i < ctx->num_replaced; ++i) {
+      m_reclaimer.retire(ctx->replaced[i]);
+    }
+    // Nobody else has seen these
+    for (std::size_t i = 0; i < ctx->num_discarded; ++i) {
+      priv_free_node(ctx->discarded[i]);
+    }
+  }
+
+  /// \brief Frees the nodes created by a failed modification.
+  void priv_abort(write_context *const ctx) noexcept {
+    for (std::size_t i = 0; i < ctx->num_created; ++i) {
+      priv_free_node(ctx->created[i]);
+    }
+  }
+
+  void priv_try_reclaim() noexcept {
+    m_reclaimer.try_advance(
+        [this](node_type *const node) { priv_free_node(node); });
+  }
+
+  void priv_destroy() noexcept {
+    if (auto *const root = m_root.exchange(nullptr)) priv_free_subtree(root);
+    m_reclaimer.free_all(
+        [this](node_type *const node) { priv_free_node(node); });
+  }
+
+  /// A constructor given when all elements are copied
+  struct no_construct {
+    void operator()(value_allocator_type &, value_type *const,
+                    const value_type *) const {
+      assert(false);
+    }
+  };
+  static inline no_construct k_no_construct{};
+
+  allocator_type m_allocator;
+  key_compare m_compare{};
+  link_type m_root;
+  std::atomic<uint32_t> m_write_lock{0};
+  reclaimer_type m_reclaimer;
+};
+
+/// \brief A read-only view of a version of a versioned_map.
+/// The version does not change while the snapshot is alive. Operations take
+/// no lock and can run concurrently with modifications of the container.
+/// A snapshot must not be shared by threads without synchronization.
+template <typename _key_type, typename _mapped_type, typename _compare,
+          typename _allocator, std::size_t k_node_size>
+class versioned_map<_key_type, _mapped_type, _compare, _allocator,
+                    k_node_size>::snapshot_type {
+ public:
+  snapshot_type(snapshot_type &&) noexcept = default;
+  snapshot_type &operator=(snapshot_type &&) noexcept = default;
+  snapshot_type(const snapshot_type &) = delete;
+  snapshot_type &operator=(const snapshot_type &) = delete;
+
+  /// \brief Returns the number of elements.
+  size_type size() const { return m_root ? m_root->num_elements : 0; }
+
+  /// \brief Returns true if there is no element.
+  bool empty() const { return size() == 0; }
+
+  /// \brief Returns the number of elements with an equivalent key.
+  /// \return Either 1 or 0.
+  size_type count(const key_type &key) const { return contains(key) ? 1 : 0; }
+
+  /// \brief Checks if there is an element with an equivalent key.
+  bool contains(const key_type &key) const { return find(key) != nullptr; }
+
+  /// \brief Finds the element with an equivalent key.
+  /// \return A pointer to the element, which is valid while the snapshot
+  /// is alive, or nullptr if not found.
+  const value_type *find(const key_type &key) const {
+    return m_map->priv_find(m_root, key);
+  }
+
+  /// \brief Calls a function with every element in the key order.
+  /// \param func A function object that takes 'const value_type &'.
+  template <typename function_type>
+  void for_each(function_type &&func) const {
+    if (m_root) m_map->priv_scan(m_root, nullptr, nullptr, func);
+  }
+
+  /// \brief Calls a function with every element whose key is in
+  /// [first, last) in the key order.
+  /// \param first The first key of the range.
+  /// \param last The key after the range.
+  /// \param func A function object that takes 'const value_type &'.
+  template <typename function_type>
+  void for_each(const key_type &first, const key_type &last,
+                function_type &&func) const {
+    if (m_root) m_map->priv_scan(m_root, &first, &last, func);
+  }
+
+ private:
+  friend class versioned_map;
+
+  explicit snapshot_type(const versioned_map &map)
+      : m_map(&map),
+        m_guard(map.m_reclaimer),
+        m_root(map.m_root.load(std::memory_order_seq_cst)) {}
+
+  const versioned_map *m_map;
+  // Keeps the nodes of the version from being freed
+  epoch_guard m_guard;
+  const node_type *m_root;
+};
+
+}  // namespace metall::container
+
+#endif  // METALL_CONTAINER_VERSIONED_MAP_HPP
@@ -38,14 +38,25 @@
 #define METALL_VERBOSE_SYSTEM_SUPPORT_WARNING
 
 /// \brief If defined, Metall stores addresses in sorted order in the bin
-/// directory. This option enables Metall to use memory space more efficiently,
-/// but it increases the cost of the bin directory operations.
+/// directory. This option enables Metall to use memory space more efficiently.
+/// The chunk numbers are kept in a bitmap per bin; thus, the bin directory
+/// operations take O(log) time but the bitmaps grow with the number of chunks.
 #define METALL_USE_SORTED_BIN
 
 /// \brief If defined, Metall tries to free space when an object equal to or
 /// larger than the specified bytes is deallocated. Will be rounded up to a
 /// multiple of the page size internally.
 #define METALL_FREE_SMALL_OBJECT_SIZE_HINT
+
+/// \brief If defined, Metall traces internal events, e.g., chunk insertions,
+/// object cache refills, segment extensions, and syncs, as USDT probes (if
+/// <sys/sdt.h> is available) and by calling the function set by
+/// metall::tracing::set_callback(). See metall/tracing.hpp.
+#define METALL_USE_TRACEPOINTS
+
+/// \brief If defined, metall::basic_manager::start_allocation_trace() records
+/// the allocation and deallocation stream to a file to replay it offline.
+#define METALL_USE_ALLOCATION_TRACE
 #endif
 
 // --------------------
@@ -62,6 +73,157 @@
 /// \brief If defined, the default segment storage does not free file space even
 /// thought the corresponding segment becomes free.
 #define METALL_DISABLE_FREE_FILE_SPACE
+
+/// \brief If defined, the default segment storage backs the segment with huge
+/// pages of the specified size in bytes, e.g., (1ULL << 21ULL).
+/// Anonymous maps (see METALL_USE_ANONYMOUS_NEW_MAP) use MAP_HUGETLB, falling
+/// back to transparent huge pages if no huge page is available; file-backed
+/// maps are advised to use transparent huge pages (MADV_HUGEPAGE), which
+/// takes effect on file systems that support them, e.g., tmpfs mounted with
+/// huge=advise. The segment is aligned to the huge page size and only whole
+/// huge pages are freed. The chunk size must be a multiple of this value,
+/// and METALL_SEGMENT_BLOCK_SIZE must be a multiple of this value.
+#define METALL_SEGMENT_HUGE_PAGE_SIZE
+
+/// \brief If defined, the default segment storage syncs only the pages
+/// written since the previous sync, using the soft-dirty bits of Linux.
+/// If the soft-dirty bits are not available, the whole segment is synced.
+/// Other code in the same process must not reset the soft-dirty bits.
+#define METALL_USE_INCREMENTAL_SYNC
+
+/// \brief If defined, the default segment storage maps the block files with
+/// MAP_SYNC if they are on a file system mounted with DAX, e.g., on
+/// persistent or CXL memory; then, basic_manager::persist() writes back only
+/// the CPU cache lines of a region (CLWB with -mclwb, otherwise CLFLUSHOPT
+/// or CLFLUSH) instead of msyncing its pages. Other files are mapped as
+/// usual. flush() still uses msync, which writes back only the cache lines
+/// of the dirty pages on DAX.
+#define METALL_USE_DAX
+
+/// \brief If defined, the default segment storage loads the whole segment
+/// into memory in parallel when opening a datastore, so that the first
+/// traversal of the data does not take a page fault per page.
+/// See also basic_manager::prefetch().
+#define METALL_PREFETCH_ON_OPEN
+
+/// \brief If defined, the default segment storage allocates the disk space
+/// of a new block file (fallocate) when creating it, in background if
+/// METALL_SEGMENT_NUM_PREEXTENDED_BLOCKS > 0, and faults in the pages of a
+/// block mapped from a new file by the I/O threads after the segment is
+/// extended, so that concurrent writes into the new block do not serialize
+/// in the page fault handler of the file system.
+/// The prefaulted pages are dirty; thus, the next sync writes back the whole
+/// block. Blocks kept in anonymous memory are not prefaulted.
+#define METALL_PREFAULT_NEW_BLOCKS
+
+/// \brief If defined, Metall uses io_uring on Linux to sync segments, extend
+/// files, and copy files (e.g., making snapshots), batching the system calls.
+/// Falls back to the normal system calls if io_uring is not available at
+/// runtime, e.g., it is disabled by a seccomp filter.
+#define METALL_USE_IO_URING
+
+/// \brief If defined, Metall can compress the block files of a closed data
+/// store with Zstandard (see basic_manager::compress()) and decompresses them
+/// when opening the data store. Requires zstd.h and libzstd.
+#define METALL_USE_ZSTD
+
+/// \brief If defined, metall::json::parse_into() and
+/// metall::json::parse_lines() parse JSON with simdjson, which is much faster
+/// for bulk ingest, and construct the Metall JSON values from its result.
+/// Requires simdjson.h and libsimdjson.
+#define METALL_USE_SIMDJSON
+
+/// \brief If defined, the default segment storage adds a block as large as
+/// the current segment when it extends the segment, from
+/// METALL_SEGMENT_BLOCK_SIZE up to METALL_SEGMENT_MAX_BLOCK_SIZE, instead of
+/// adding blocks of METALL_SEGMENT_BLOCK_SIZE. As the number of the block
+/// files (and mapped regions) grows logarithmically, opening and syncing a
+/// large datastore become cheaper. Datastores created with and without this
+/// option can be opened in both ways.
+#define METALL_USE_GEOMETRIC_BLOCK_GROWTH
+
+/// \brief If defined, the default segment storage interleaves the pages of
+/// the segment over the NUMA nodes the process can use (MPOL_INTERLEAVE).
+/// By default, pages are placed on the node of the thread that touches them
+/// first. The policy applies to anonymous maps (see
+/// METALL_USE_ANONYMOUS_NEW_MAP), private maps, and files on tmpfs;
+/// Linux places the page cache of other file systems by the policy of the
+/// thread that faults the page.
+#define METALL_SEGMENT_NUMA_INTERLEAVE
+
+/// \brief If defined, the default segment storage divides the segment into
+/// ranges of the specified size in bytes and binds the ranges to the NUMA
+/// nodes the process can use in a round-robin manner (MPOL_BIND), e.g.,
+/// (1ULL << 30ULL). Must be a multiple of the page size (or
+/// METALL_SEGMENT_HUGE_PAGE_SIZE). The same limitation as
+/// METALL_SEGMENT_NUMA_INTERLEAVE applies.
+#define METALL_SEGMENT_NUMA_BIND_RANGE_SIZE
+#endif
+
+/// \def METALL_SEGMENT_MAX_PINNED_SIZE
+/// The maximum number of bytes the default segment storage pins in memory
+/// (see basic_manager::pin()). If 0, only RLIMIT_MEMLOCK limits it.
+#ifndef METALL_SEGMENT_MAX_PINNED_SIZE
+#define METALL_SEGMENT_MAX_PINNED_SIZE 0
+#endif
+
+/// \def METALL_SEGMENT_MAX_BLOCK_SIZE
+/// The maximum segment block size when METALL_USE_GEOMETRIC_BLOCK_GROWTH is
+/// defined. Must be a multiple of METALL_SEGMENT_BLOCK_SIZE.
+#ifndef METALL_SEGMENT_MAX_BLOCK_SIZE
+#define METALL_SEGMENT_MAX_BLOCK_SIZE (1ULL << 36ULL)
+#endif
+
+/// \def METALL_SEGMENT_NUM_PREEXTENDED_BLOCKS
+/// The number of the block files the default segment storage creates ahead
+/// in background, so that extending the segment does not wait on creating
+/// and extending a file. If 0, block files are created on demand.
+#ifndef METALL_SEGMENT_NUM_PREEXTENDED_BLOCKS
+#define METALL_SEGMENT_NUM_PREEXTENDED_BLOCKS 0
+#endif
+
+/// \def METALL_IO_EXECUTOR_NUM_THREADS
+/// The maximum number of the threads Metall uses to sync, copy, and snapshot
+/// datastores. The threads are shared by all datastores in a process.
+/// If 0, the number of the hardware threads is used.
+#ifndef METALL_IO_EXECUTOR_NUM_THREADS
+#define METALL_IO_EXECUTOR_NUM_THREADS 0
+#endif
+
+/// \def METALL_IO_EXECUTOR_QUEUE_DEPTH
+/// The maximum number of the I/O tasks, e.g., syncing a file, that access
+/// the same device at the same time. If 0, it is not bounded.
+#ifndef METALL_IO_EXECUTOR_QUEUE_DEPTH
+#define METALL_IO_EXECUTOR_QUEUE_DEPTH 0
+#endif
+
+// --------------------
+// Macros for the segment allocator
+// --------------------
+
+/// \def METALL_NUM_ARENAS
+/// The number of arenas for small objects. Each arena owns its own set of
+/// chunks per bin. A thread keeps allocating from the arena chosen by the CPU
+/// it first allocates on, and deallocated objects are returned to the arena
+/// that owns the chunk. Using as many arenas as CPUs removes most of the
+/// contention on the bins among threads at the cost of less sharing of
+/// partially used chunks. Must be in [1, 256].
+/// The chunk ownership is not stored in datastores; all chunks belong to the
+/// first arena after reopening a datastore.
+#ifndef METALL_NUM_ARENAS
+#define METALL_NUM_ARENAS 1
+#endif
+
+/// \def METALL_NUM_PLACEMENT_HINTS
+/// The number of placement hints, e.g., hot and cold, a thread can allocate
+/// small objects with (see basic_manager::placement_hint_scope). Each hint
+/// has its own arena in addition to the METALL_NUM_ARENAS arenas; thus, the
+/// objects allocated with the same hint are grouped into the same chunks.
+/// METALL_NUM_ARENAS + METALL_NUM_PLACEMENT_HINTS must be at most 256.
+/// As with the arenas, the grouping of the existing chunks is not stored in
+/// datastores.
+#ifndef METALL_NUM_PLACEMENT_HINTS
+#define METALL_NUM_PLACEMENT_HINTS 4
 #endif
 
 // --------------------
@@ -80,6 +242,44 @@
 #define METALL_NUM_CACHES_PER_CPU 2
 #endif
 
+#ifdef DOXYGEN_SKIP
+/// \brief If defined, each cache in the object cache has a few lock-free slots
+/// per bin in front of it. Objects are pushed to and popped from the slots
+/// using atomic operations without taking the cache lock; the lock is taken
+/// only when the slots are full (push) or empty (pop).
+/// This option is ignored if METALL_DISABLE_CONCURRENCY is defined.
+#define METALL_USE_LOCK_FREE_OBJECT_CACHE
+
+/// \brief If defined, every thread has a tiny cache (magazine) per bin in
+/// front of the per-CPU object cache. Deallocated objects are kept there and
+/// reused by the following allocations of the same thread without locking or
+/// looking up the per-CPU cache. The objects are returned when the thread
+/// exits or the manager is closed.
+/// This option is ignored if METALL_DISABLE_CONCURRENCY is defined.
+#define METALL_USE_THREAD_LOCAL_OBJECT_CACHE
+
+/// \brief If defined, a background thread returns the objects in idle object
+/// caches gradually. Also, snapshot, close, and profile do not drain the
+/// object cache; the cached objects are stored (counted) as free objects.
+/// This option is ignored if METALL_DISABLE_CONCURRENCY or
+/// METALL_DISABLE_OBJECT_CACHE is defined.
+#define METALL_USE_BACKGROUND_OBJECT_CACHE_TRIMMING
+#endif
+
+/// \def METALL_OBJECT_CACHE_TRIMMING_INTERVAL_MS
+/// The interval of the background object cache trimming in milliseconds.
+/// See METALL_USE_BACKGROUND_OBJECT_CACHE_TRIMMING.
+#ifndef METALL_OBJECT_CACHE_TRIMMING_INTERVAL_MS
+#define METALL_OBJECT_CACHE_TRIMMING_INTERVAL_MS 1000
+#endif
+
+/// \def METALL_THREAD_LOCAL_OBJECT_CACHE_DEPTH
+/// The maximum number of objects the thread-local object cache keeps per bin.
+/// See METALL_USE_THREAD_LOCAL_OBJECT_CACHE.
+#ifndef METALL_THREAD_LOCAL_OBJECT_CACHE_DEPTH
+#define METALL_THREAD_LOCAL_OBJECT_CACHE_DEPTH 4
+#endif
+
 #ifdef DOXYGEN_SKIP
 /// \brief A macro to disable concurrency support.
 /// \details
@@ -89,6 +289,76 @@
 /// hand, Metall still may use multi-threading for internal operations, such
 /// as synchronizing data with files.
 #define METALL_DISABLE_CONCURRENCY
+
+/// \brief If defined, threads claim slots from the non-full chunks of the
+/// small object bins using atomic operations while sharing the bin lock.
+/// The bin lock is taken exclusively only when a chunk has to be inserted into
+/// or removed from a bin, or when objects are deallocated.
+/// This option is ignored if METALL_DISABLE_CONCURRENCY is defined.
+#define METALL_USE_CONCURRENT_SLOT_CLAIM
+
+/// \brief If defined, the segment allocator samples allocations, about one
+/// per METALL_ALLOCATION_SAMPLING_INTERVAL bytes, and records the call stack
+/// of each sampled allocation in the process memory.
+/// See basic_manager::write_allocation_profile().
+#define METALL_USE_ALLOCATION_SAMPLING
+
+/// \brief If defined, the segment allocator does not free the memory pages
+/// (and the file space) of freed chunks immediately. The chunks are queued,
+/// merged with adjacent ones, and freed in batches of
+/// METALL_CHUNK_RELEASE_BATCH_SIZE bytes, and when the datastore is flushed
+/// or closed. Chunks reused before that are removed from the queue.
+/// How the pages are freed does not change, e.g., see
+/// METALL_DISABLE_FREE_FILE_SPACE.
+#define METALL_USE_DEFERRED_CHUNK_RELEASE
+
+/// \brief If defined, a small object freed by a thread whose arena does not
+/// own the chunk of the object is pushed onto a lock-free list of the owner
+/// arena instead of the object cache of the freeing thread. A thread of the
+/// owner arena takes the whole list when it allocates an object of the same
+/// size and puts the objects into its object cache, e.g., objects allocated
+/// by a producer thread and freed by a consumer thread go back to the
+/// producer. The objects in the lists are returned to their chunks when the
+/// datastore is flushed or closed.
+/// Has an effect only if METALL_NUM_ARENAS > 1. This option is ignored if
+/// METALL_DISABLE_CONCURRENCY or METALL_DISABLE_OBJECT_CACHE is defined.
+#define METALL_USE_REMOTE_FREE
+
+/// \brief If defined, objects larger than 1/32 of the chunk size and up to
+/// two chunks (64 KiB to 4 MiB with the default chunk size) are placed in
+/// slabs of eight chunks instead of small-object chunks that hold only a few
+/// slots or whole large objects. An object takes a multiple of 1/512 of the
+/// chunk size, is cut from the free space of the slabs by address-ordered
+/// best fit, and is merged with the free space next to it when freed; a slab
+/// is given back when all of its objects are freed.
+/// Medium objects are aligned only to 1/512 of the chunk size; larger
+/// alignments given to aligned allocations bypass the slabs.
+/// A data store that has medium objects cannot be opened without this option.
+#define METALL_USE_MEDIUM_OBJECT_SLABS
+
+/// \brief If defined, the number of the objects of each bin in the object
+/// caches is stored when the datastore is flushed or closed. When the
+/// datastore is opened for writing, the per-CPU caches of those bins are
+/// filled in parallel with free slots of the non-full chunks, i.e., no new
+/// chunk is taken, so that the first allocations after reopening the
+/// datastore do not go to the chunks under the bin locks.
+/// This option is ignored if METALL_DISABLE_OBJECT_CACHE is defined.
+#define METALL_USE_OBJECT_CACHE_PREFILL
+#endif
+
+/// \def METALL_CHUNK_RELEASE_BATCH_SIZE
+/// The number of bytes of the queued chunks that triggers freeing them.
+/// If 0, the chunks are freed only when the datastore is flushed or closed.
+/// See METALL_USE_DEFERRED_CHUNK_RELEASE.
+#ifndef METALL_CHUNK_RELEASE_BATCH_SIZE
+#define METALL_CHUNK_RELEASE_BATCH_SIZE (1ULL << 28ULL)
+#endif
+
+/// \def METALL_ALLOCATION_SAMPLING_INTERVAL
+/// The average number of bytes allocated between two sampled allocations.
+/// See METALL_USE_ALLOCATION_SAMPLING.
+#ifndef METALL_ALLOCATION_SAMPLING_INTERVAL
+#define METALL_ALLOCATION_SAMPLING_INTERVAL (1ULL << 19ULL)
 #endif
 
 // --------------------
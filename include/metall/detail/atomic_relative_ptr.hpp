@@ -0,0 +1,67 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_ATOMIC_RELATIVE_PTR_HPP
+#define METALL_DETAIL_ATOMIC_RELATIVE_PTR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace metall::mtlldetail {
+
+/// \brief An atomic pointer that holds the offset from itself to the target,
+/// like offset_ptr, so that it is valid wherever the memory is mapped.
+template <typename T>
+class atomic_relative_ptr {
+ public:
+  atomic_relative_ptr() noexcept = default;
+  atomic_relative_ptr(const atomic_relative_ptr &) = delete;
+  atomic_relative_ptr &operator=(const atomic_relative_ptr &) = delete;
+
+  T *load(const std::memory_order order = std::memory_order_acquire) const
+      noexcept {
+    return priv_to_pointer(m_offset.load(order));
+  }
+
+  void store(T *const ptr, const std::memory_order order =
+                               std::memory_order_release) noexcept {
+    m_offset.store(priv_to_offset(ptr), order);
+  }
+
+  T *exchange(T *const ptr) noexcept {
+    return priv_to_pointer(m_offset.exchange(priv_to_offset(ptr)));
+  }
+
+  bool compare_exchange_weak(T *&expected, T *const desired) noexcept {
+    auto expected_offset = priv_to_offset(expected);
+    if (m_offset.compare_exchange_weak(expected_offset,
+                                       priv_to_offset(desired))) {
+      return true;
+    }
+    expected = priv_to_pointer(expected_offset);
+    return false;
+  }
+
+ private:
+  // 0 is the null pointer, as nothing points to itself
+  std::ptrdiff_t priv_to_offset(T *const ptr) const noexcept {
+    if (!ptr) return 0;
+    return reinterpret_cast<std::intptr_t>(ptr) -
+           reinterpret_cast<std::intptr_t>(this);
+  }
+
+  T *priv_to_pointer(const std::ptrdiff_t offset) const noexcept {
+    if (offset == 0) return nullptr;
+    return reinterpret_cast<T *>(reinterpret_cast<std::intptr_t>(this) +
+                                 offset);
+  }
+
+  std::atomic<std::ptrdiff_t> m_offset{0};
+};
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_ATOMIC_RELATIVE_PTR_HPP
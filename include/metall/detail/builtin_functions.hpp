@@ -9,7 +9,7 @@
 namespace metall::mtlldetail {
 
 /// \brief Count Leading Zeros.
-inline int clzll(const unsigned long long x) noexcept {
+inline constexpr int clzll(const unsigned long long x) noexcept {
 #if defined(__GNUG__) || defined(__clang__)
   return __builtin_clzll(x);
 #else
@@ -18,7 +18,7 @@ inline int clzll(const unsigned long long x) noexcept {
 }
 
 /// \brief Count Trailing Zeros.
-inline int ctzll(const unsigned long long x) noexcept {
+inline constexpr int ctzll(const unsigned long long x) noexcept {
 #if defined(__GNUG__) || defined(__clang__)
   return __builtin_ctzll(x);
 #else
@@ -26,6 +26,70 @@ inline int ctzll(const unsigned long long x) noexcept {
 #endif
 }
 
+/// \brief Counts the number of set bits.
+inline constexpr int popcountll(const unsigned long long x) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+#error "GCC or Clang must be used to use __builtin_popcountll" << std::endl;
+#endif
+}
+
+/// \brief Atomically loads the value pointed by 'ptr' (acquire).
+template <typename T>
+inline T atomic_load(const T *const ptr) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#else
+#error "GCC or Clang must be used to use __atomic builtins" << std::endl;
+#endif
+}
+
+/// \brief Atomically stores 'value' to the object pointed by 'ptr' (release).
+template <typename T>
+inline void atomic_store(T *const ptr, const T value) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#else
+#error "GCC or Clang must be used to use __atomic builtins" << std::endl;
+#endif
+}
+
+/// \brief Atomically compares the value pointed by 'ptr' with 'expected'
+/// and replaces it with 'desired' if they are equal (acquire-release).
+/// On failure, the current value is written into 'expected'.
+template <typename T>
+inline bool atomic_compare_exchange(T *const ptr, T *const expected,
+                                    const T desired) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  return __atomic_compare_exchange_n(ptr, expected, desired, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+#error "GCC or Clang must be used to use __atomic builtins" << std::endl;
+#endif
+}
+
+/// \brief Atomically performs bitwise OR and returns the previous value
+/// (acquire-release).
+template <typename T>
+inline T atomic_fetch_or(T *const ptr, const T value) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  return __atomic_fetch_or(ptr, value, __ATOMIC_ACQ_REL);
+#else
+#error "GCC or Clang must be used to use __atomic builtins" << std::endl;
+#endif
+}
+
+/// \brief Atomically adds 'value' and returns the previous value (relaxed).
+template <typename T>
+inline T atomic_fetch_add_relaxed(T *const ptr, const T value) noexcept {
+#if defined(__GNUG__) || defined(__clang__)
+  return __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED);
+#else
+#error "GCC or Clang must be used to use __atomic builtins" << std::endl;
+#endif
+}
+
 }  // namespace metall::mtlldetail
 
 #endif  // METALL_DETAIL_UTILITY_BUILTIN_FUNCTIONS_HPP
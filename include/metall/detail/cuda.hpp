@@ -0,0 +1,201 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_CUDA_HPP
+#define METALL_DETAIL_CUDA_HPP
+
+#if defined(METALL_USE_CUDA) && __has_include(<cuda_runtime_api.h>)
+#define METALL_ENABLE_CUDA
+#endif
+
+#if defined(METALL_ENABLE_CUDA) && defined(METALL_USE_CUFILE) && \
+    defined(__linux__) && __has_include(<cufile.h>)
+#define METALL_ENABLE_CUFILE
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+#ifdef METALL_ENABLE_CUDA
+#include <cuda_runtime_api.h>
+#endif
+
+#ifdef METALL_ENABLE_CUFILE
+#include <cufile.h>
+#endif
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+
+/// \namespace metall::mtlldetail::cuda
+/// \brief Makes memory in the application data segment accessible to CUDA
+/// devices: registers host memory as pinned (page-locked) memory and reads
+/// block files into device buffers with cuFile (GPUDirect Storage).
+/// The functions return false if Metall is built without METALL_USE_CUDA
+/// (METALL_USE_CUFILE for cuFile) or the headers are not found.
+namespace metall::mtlldetail::cuda {
+
+/// \brief Returns true if the CUDA runtime is available.
+constexpr bool enabled() {
+#ifdef METALL_ENABLE_CUDA
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// \brief Returns true if cuFile (GPUDirect Storage) is available.
+constexpr bool cufile_enabled() {
+#ifdef METALL_ENABLE_CUFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+namespace cudadtl {
+#ifdef METALL_ENABLE_CUDA
+inline bool check(const cudaError_t error, const char *const what) {
+  if (error == cudaSuccess) return true;
+  logger::out(logger::level::error, __FILE__, __LINE__,
+              (std::string(what) + ": " + cudaGetErrorString(error)).c_str());
+  return false;
+}
+#endif
+
+inline bool log_disabled() {
+  logger::out(logger::level::error, __FILE__, __LINE__,
+              "Metall is built without CUDA (METALL_USE_CUDA)");
+  return false;
+}
+
+#ifdef METALL_ENABLE_CUFILE
+/// \brief Opens the cuFile driver once in the process.
+/// The driver is kept open until the process exits.
+inline bool open_cufile_driver() {
+  static const bool opened = [] {
+    const CUfileError_t status = cuFileDriverOpen();
+    if (status.err != CU_FILE_SUCCESS) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to open the cuFile driver");
+      return false;
+    }
+    return true;
+  }();
+  return opened;
+}
+#endif
+}  // namespace cudadtl
+
+/// \brief Registers host memory as pinned memory, so that devices access it
+/// directly and copies from it do not go through a staging buffer.
+/// \param addr The beginning address of the memory, e.g., page aligned.
+/// \param size The size of the memory.
+/// \return On success, returns true. On error, returns false.
+inline bool host_register([[maybe_unused]] void *const addr,
+                          [[maybe_unused]] const std::size_t size) {
+#ifdef METALL_ENABLE_CUDA
+  return cudadtl::check(cudaHostRegister(addr, size, cudaHostRegisterPortable),
+                        "cudaHostRegister");
+#else
+  return cudadtl::log_disabled();
+#endif
+}
+
+/// \brief Unregisters memory registered by host_register().
+/// \param addr The address given to host_register().
+/// \return On success, returns true. On error, returns false.
+inline bool host_unregister([[maybe_unused]] void *const addr) {
+#ifdef METALL_ENABLE_CUDA
+  return cudadtl::check(cudaHostUnregister(addr), "cudaHostUnregister");
+#else
+  return cudadtl::log_disabled();
+#endif
+}
+
+/// \brief Copies host memory to a device buffer.
+/// \param device_buffer The destination in device memory.
+/// \param host_addr The source in host memory.
+/// \param size The number of bytes to copy.
+/// \return On success, returns true. On error, returns false.
+inline bool copy_to_device([[maybe_unused]] void *const device_buffer,
+                           [[maybe_unused]] const void *const host_addr,
+                           [[maybe_unused]] const std::size_t size) {
+#ifdef METALL_ENABLE_CUDA
+  return cudadtl::check(
+      cudaMemcpy(device_buffer, host_addr, size, cudaMemcpyHostToDevice),
+      "cudaMemcpy");
+#else
+  return cudadtl::log_disabled();
+#endif
+}
+
+/// \brief Reads a range of a file straight into a device buffer with cuFile
+/// (GPUDirect Storage), i.e., without copying it through host memory.
+/// The file is opened with O_DIRECT if the file system supports it; cuFile
+/// falls back to its compatibility mode otherwise.
+/// \param file_path The path to the file.
+/// \param file_offset The offset to the range in the file.
+/// \param size The number of bytes to read.
+/// \param device_buffer The destination in device memory.
+/// \return On success, returns true. On error, or if cuFile is not
+/// available, returns false; the caller can copy the data from host memory
+/// instead.
+inline bool read_file_to_device(
+    [[maybe_unused]] const std::string &file_path,
+    [[maybe_unused]] const std::size_t file_offset,
+    [[maybe_unused]] const std::size_t size,
+    [[maybe_unused]] void *const device_buffer) {
+#ifdef METALL_ENABLE_CUFILE
+  if (!cudadtl::open_cufile_driver()) return false;
+
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_DIRECT);
+  if (fd == -1) fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+    return false;
+  }
+
+  CUfileDescr_t descr{};
+  descr.handle.fd = fd;
+  descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+  CUfileHandle_t handle;
+  if (cuFileHandleRegister(&handle, &descr).err != CU_FILE_SUCCESS) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to register a file to cuFile");
+    os_close(fd);
+    return false;
+  }
+
+  bool succeeded = true;
+  std::size_t num_read = 0;
+  while (num_read < size) {
+    const ssize_t ret =
+        cuFileRead(handle, device_buffer, size - num_read,
+                   static_cast<off_t>(file_offset + num_read),
+                   static_cast<off_t>(num_read));
+    if (ret <= 0) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "cuFileRead failed");
+      succeeded = false;
+      break;
+    }
+    num_read += ret;
+  }
+
+  cuFileHandleDeregister(handle);
+  succeeded &= os_close(fd);
+  return succeeded;
+#else
+  return false;
+#endif
+}
+
+}  // namespace metall::mtlldetail::cuda
+
+#endif  // METALL_DETAIL_CUDA_HPP
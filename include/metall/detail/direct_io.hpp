@@ -0,0 +1,153 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_DIRECT_IO_HPP
+#define METALL_DETAIL_DIRECT_IO_HPP
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/utilities.hpp>
+#include <metall/logger.hpp>
+
+namespace metall::mtlldetail {
+
+namespace {
+namespace fs = std::filesystem;
+}
+
+namespace diodtl {
+/// \brief The alignment of the offsets, lengths, and buffers of direct I/O,
+/// which covers the logical block sizes of common devices.
+constexpr std::size_t k_alignment = 4096;
+
+/// \brief The size of the pieces a file is copied by.
+constexpr std::size_t k_piece_size = 1ULL << 23ULL;
+
+struct free_deleter {
+  void operator()(void *const p) const noexcept { std::free(p); }
+};
+}  // namespace diodtl
+
+/// \brief Copies a file bypassing the page cache (O_DIRECT), e.g., to take a
+/// snapshot without evicting the working set of the application.
+/// The pieces of the source file resident in memory are written from
+/// 'source_addr' if given; the others are read with O_DIRECT. The holes of
+/// the source file are kept.
+/// \param source_path A path to a source file, which must not have dirty
+/// pages not synced if 'source_addr' is not given.
+/// \param destination_path A path to a destination file.
+/// \param source_addr If not nullptr, the beginning of a page-aligned map of
+/// the whole source file with the same content, e.g., a synced segment.
+/// \param supported Set to false if a file system does not support O_DIRECT,
+/// e.g., tmpfs, so that the caller can copy it normally.
+/// \return On success, returns true. On error, returns false.
+inline bool copy_file_direct(
+    [[maybe_unused]] const fs::path &source_path,
+    [[maybe_unused]] const fs::path &destination_path,
+    [[maybe_unused]] const void *const source_addr, bool *const supported) {
+  *supported = false;
+#if defined(__linux__) && defined(O_DIRECT)
+  const int src = ::open(source_path.c_str(), O_RDONLY | O_DIRECT);
+  if (src == -1) {
+    if (errno == EINVAL) return false;
+    logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+    return false;
+  }
+  struct stat st;
+  if (::fstat(src, &st) == -1) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "fstat");
+    os_close(src);
+    return false;
+  }
+  const int dst = ::open(destination_path.c_str(),
+                         O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, st.st_mode);
+  if (dst == -1) {
+    if (errno != EINVAL) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+    }
+    os_close(src);
+    return false;
+  }
+  *supported = true;
+
+  const auto close_all = [src, dst](const bool succeeded) {
+    return os_close(src) & os_close(dst) & succeeded;
+  };
+  const off_t file_size = st.st_size;
+  std::vector<std::pair<off_t, off_t>> extents;
+  if (!fcpdtl::get_data_extents_linux(src, file_size, &extents)) {
+    extents.assign(1, {0, file_size});
+  }
+  std::unique_ptr<char, diodtl::free_deleter> buf(static_cast<char *>(
+      std::aligned_alloc(diodtl::k_alignment, diodtl::k_piece_size)));
+  if (!buf || ::ftruncate(dst, file_size) != 0) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to prepare a direct I/O copy");
+    return close_all(false);
+  }
+
+  const std::size_t page_size = get_page_size();
+  for (const auto &[extent_begin, extent_length] : extents) {
+    // The extents are aligned to the file system blocks but the last one
+    const auto begin = round_down(extent_begin, diodtl::k_alignment);
+    const auto end = round_up(extent_begin + extent_length,
+                              off_t(diodtl::k_alignment));
+    for (off_t off = begin; off < end;) {
+      const auto length = std::min(off_t(diodtl::k_piece_size), end - off);
+      const char *data = nullptr;
+      if (source_addr && off + length <= file_size) {
+        auto *const addr = const_cast<char *>(
+                               static_cast<const char *>(source_addr)) +
+                           off;
+        const auto map_length = round_up(length, off_t(page_size));
+        if (get_num_resident_bytes(addr, map_length) == map_length) {
+          data = addr;
+        }
+      }
+      if (!data) {
+        // A read at the end of the file can be short; the rest is not used
+        if (::pread(src, buf.get(), length, off) < 0) {
+          logger::perror(logger::level::error, __FILE__, __LINE__, "pread");
+          return close_all(false);
+        }
+        data = buf.get();
+      }
+      if (::pwrite(dst, data, length, off) != length) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "pwrite");
+        return close_all(false);
+      }
+      off += length;
+    }
+  }
+
+  // Drops the padding written after the end of the file
+  if (::ftruncate(dst, file_size) != 0 || !os_fsync(dst)) {
+    logger::perror(logger::level::error, __FILE__, __LINE__,
+                   "Failed to finish a direct I/O copy");
+    return close_all(false);
+  }
+  return close_all(true);
+#else
+  return false;
+#endif
+}
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_DIRECT_IO_HPP
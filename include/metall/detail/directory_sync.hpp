@@ -0,0 +1,270 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_DIRECTORY_SYNC_HPP
+#define METALL_DETAIL_DIRECTORY_SYNC_HPP
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/detail/io_executor.hpp>
+
+/// \brief Functions to mirror the changes in a directory tree to another
+/// one, writing only the blocks of the files changed since the last time.
+/// The changes are detected by comparing the checksums of the blocks;
+/// thus, this works regardless of the file system, e.g., whether writes
+/// through mmap update the modification time or not.
+namespace metall::mtlldetail {
+
+namespace {
+namespace fs = std::filesystem;
+}
+
+/// \brief The checksums of the blocks of the regular files in a directory
+/// tree. The key is the path of a file relative to the top directory.
+using block_checksum_table = std::map<std::string, std::vector<uint64_t>>;
+
+namespace dirsyncdtl {
+
+constexpr std::size_t k_block_size = std::size_t(1) << 20;
+constexpr uint64_t k_hash_seed = 123;
+
+inline bool list_regular_files(const fs::path &top_dir,
+                               std::vector<std::string> *relative_paths) {
+  try {
+    relative_paths->clear();
+    for (const auto &entry : fs::recursive_directory_iterator(top_dir)) {
+      if (entry.is_regular_file()) {
+        relative_paths->push_back(
+            fs::relative(entry.path(), top_dir).string());
+      }
+    }
+  } catch (const fs::filesystem_error &e) {
+    logger::out(logger::level::error, __FILE__, __LINE__, e.what());
+    return false;
+  }
+  std::sort(relative_paths->begin(), relative_paths->end());
+  return true;
+}
+
+inline bool all_zero(const char *const buf, const std::size_t size) {
+  return std::all_of(buf, buf + size, [](const char c) { return c == 0; });
+}
+
+inline bool pread_all(const int fd, char *buf, std::size_t size,
+                      off_t offset) {
+  while (size > 0) {
+    const ssize_t ret = ::pread(fd, buf, size, offset);
+    if (ret <= 0) return false;
+    buf += ret;
+    size -= ret;
+    offset += ret;
+  }
+  return true;
+}
+
+inline bool pwrite_all(const int fd, const char *buf, std::size_t size,
+                       off_t offset) {
+  while (size > 0) {
+    const ssize_t ret = ::pwrite(fd, buf, size, offset);
+    if (ret <= 0) return false;
+    buf += ret;
+    size -= ret;
+    offset += ret;
+  }
+  return true;
+}
+
+/// \brief Computes the checksums of the blocks of a file.
+/// If 'destination_fd' is not -1, also writes the blocks whose checksums
+/// differ from 'base' to the file; new blocks that are all zero are not
+/// written to keep the destination file sparse.
+inline bool process_file(const fs::path &path,
+                         const std::vector<uint64_t> *const base,
+                         const int destination_fd,
+                         std::vector<uint64_t> *checksums) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, path.c_str());
+    return false;
+  }
+  const off_t file_size = ::lseek(fd, 0, SEEK_END);
+  if (file_size == -1) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, path.c_str());
+    os_close(fd);
+    return false;
+  }
+
+  if (destination_fd != -1 && ::ftruncate(destination_fd, file_size) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "ftruncate");
+    os_close(fd);
+    return false;
+  }
+
+  const std::size_t num_blocks = (file_size + k_block_size - 1) / k_block_size;
+  checksums->resize(num_blocks);
+  std::vector<char> buf(k_block_size);
+  bool ret = true;
+  for (std::size_t i = 0; i < num_blocks; ++i) {
+    const off_t offset = off_t(i * k_block_size);
+    const std::size_t size =
+        std::min(k_block_size, std::size_t(file_size - offset));
+    if (!pread_all(fd, buf.data(), size, offset)) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, path.c_str());
+      ret = false;
+      break;
+    }
+    (*checksums)[i] = murmur_hash_64a(buf.data(), int(size), k_hash_seed);
+
+    if (destination_fd == -1) continue;
+    const bool known = base && i < base->size();
+    if (known && (*base)[i] == (*checksums)[i]) continue;
+    if (!known && all_zero(buf.data(), size)) continue;
+    if (!pwrite_all(destination_fd, buf.data(), size, offset)) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "pwrite");
+      ret = false;
+      break;
+    }
+  }
+
+  os_close(fd);
+  return ret;
+}
+
+}  // namespace dirsyncdtl
+
+/// \brief Computes the checksums of the blocks of the regular files in a
+/// directory tree.
+/// \param top_dir A path to the top directory.
+/// \param max_num_threads The maximum number of threads to use.
+/// If <= 0 is given, the value is automatically determined.
+/// \param table A buffer to put the checksums.
+/// \return Returns true on success; otherwise, false.
+inline bool compute_block_checksums(const fs::path &top_dir,
+                                    const int max_num_threads,
+                                    block_checksum_table *table) {
+  std::vector<std::string> files;
+  if (!dirsyncdtl::list_regular_files(top_dir, &files)) return false;
+
+  std::vector<std::vector<uint64_t>> checksums(files.size());
+  const bool ret = io_executor::instance().parallel_for(
+      files.size(), max_num_threads,
+      [&](const std::size_t i) {
+        return dirsyncdtl::process_file(top_dir / files[i], nullptr, -1,
+                                        &checksums[i]);
+      },
+      io_executor::get_device_id(top_dir.c_str()));
+  if (!ret) return false;
+
+  table->clear();
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    table->emplace(files[i], std::move(checksums[i]));
+  }
+  return true;
+}
+
+/// \brief Makes a directory tree the same as another one, writing only the
+/// blocks that differ from the given checksums.
+/// The destination has to be the same as the state 'base' was computed
+/// from, e.g., the source of a copy 'base' was computed from.
+/// The files that do not exist in the source are removed first,
+/// the non-empty files are written next, and new empty files are created
+/// last. Thus, an empty mark file never appears before the data it marks.
+/// \param source_dir A path to the source top directory.
+/// \param destination_dir A path to the destination top directory.
+/// \param base The checksums of the blocks in the destination directory.
+/// \param max_num_threads The maximum number of threads to use.
+/// If <= 0 is given, the value is automatically determined.
+/// \param new_table A buffer to put the checksums of the source directory.
+/// Can be the same object as 'base'.
+/// \return Returns true on success; otherwise, false.
+inline bool sync_changed_blocks(const fs::path &source_dir,
+                                const fs::path &destination_dir,
+                                const block_checksum_table &base,
+                                const int max_num_threads,
+                                block_checksum_table *new_table) {
+  std::vector<std::string> files;
+  if (!dirsyncdtl::list_regular_files(source_dir, &files)) return false;
+
+  for (const auto &entry : base) {
+    if (!std::binary_search(files.begin(), files.end(), entry.first) &&
+        !mtlldetail::remove_file(destination_dir / entry.first)) {
+      std::string s("Failed to remove " +
+                    (destination_dir / entry.first).string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+  }
+
+  std::vector<std::size_t> empty_files;
+  std::vector<std::size_t> data_files;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::error_code ec;
+    const bool empty = fs::file_size(source_dir / files[i], ec) == 0 && !ec;
+    const bool known = base.count(files[i]) > 0;
+    if (empty && !known) {
+      empty_files.push_back(i);
+    } else {
+      data_files.push_back(i);
+    }
+  }
+
+  std::vector<std::vector<uint64_t>> checksums(files.size());
+  const bool ret = io_executor::instance().parallel_for(
+      data_files.size(), max_num_threads,
+      [&](const std::size_t n) {
+        const auto i = data_files[n];
+        const auto dst_path = destination_dir / files[i];
+        if (!mtlldetail::create_directory(dst_path.parent_path())) return false;
+        const int dst_fd = ::open(dst_path.c_str(), O_WRONLY | O_CREAT, 0666);
+        if (dst_fd == -1) {
+          logger::perror(logger::level::error, __FILE__, __LINE__,
+                         dst_path.c_str());
+          return false;
+        }
+        const auto itr = base.find(files[i]);
+        bool ok = dirsyncdtl::process_file(
+            source_dir / files[i], (itr != base.end()) ? &itr->second : nullptr,
+            dst_fd, &checksums[i]);
+        ok &= os_fsync(dst_fd);
+        ok &= os_close(dst_fd);
+        return ok;
+      },
+      io_executor::get_device_id(destination_dir.c_str()));
+  if (!ret) return false;
+
+  for (const auto i : empty_files) {
+    const auto dst_path = destination_dir / files[i];
+    if (!mtlldetail::create_directory(dst_path.parent_path()) ||
+        !mtlldetail::remove_file(dst_path) ||
+        !mtlldetail::create_file(dst_path)) {
+      std::string s("Failed to create " + dst_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+  }
+
+  block_checksum_table table;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    table.emplace(files[i], std::move(checksums[i]));
+  }
+  *new_table = std::move(table);
+  return true;
+}
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_DIRECTORY_SYNC_HPP
@@ -0,0 +1,147 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_EPOCH_RECLAIMER_HPP
+#define METALL_DETAIL_EPOCH_RECLAIMER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include <metall/detail/atomic_relative_ptr.hpp>
+
+namespace metall::mtlldetail {
+
+/// \brief Epoch-based reclamation of the nodes of a concurrent container,
+/// which is kept in the container.
+/// An operation that reads the nodes runs in the epoch it started in while
+/// it holds a guard. A node removed from the container (retire()) in epoch e
+/// can be read only by the operations started in epoch e or before, all of
+/// which have finished when the epoch advances to e + 2; the node is freed
+/// then.
+/// \tparam node_type A node type with a member
+/// 'atomic_relative_ptr<node_type> retired_next'.
+template <typename node_type>
+class epoch_reclaimer {
+ private:
+  static constexpr int k_num_epochs = 3;
+
+  struct epoch_counter {
+    std::atomic<uint64_t> count{0};
+    // Keeps the counters in different cache lines
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+ public:
+  /// \brief Marks an operation running in the current epoch while alive.
+  class guard {
+   public:
+    explicit guard(const epoch_reclaimer &reclaimer) noexcept
+        : m_reclaimer(&reclaimer), m_epoch(reclaimer.enter()) {}
+
+    ~guard() noexcept {
+      if (m_reclaimer) m_reclaimer->exit(m_epoch);
+    }
+
+    guard(const guard &) = delete;
+    guard &operator=(const guard &) = delete;
+
+    guard(guard &&other) noexcept
+        : m_reclaimer(other.m_reclaimer), m_epoch(other.m_epoch) {
+      other.m_reclaimer = nullptr;
+    }
+
+    guard &operator=(guard &&other) noexcept {
+      if (this != &other) {
+        if (m_reclaimer) m_reclaimer->exit(m_epoch);
+        m_reclaimer = other.m_reclaimer;
+        m_epoch = other.m_epoch;
+        other.m_reclaimer = nullptr;
+      }
+      return *this;
+    }
+
+   private:
+    const epoch_reclaimer *m_reclaimer;
+    uint64_t m_epoch;
+  };
+
+  epoch_reclaimer() noexcept = default;
+  epoch_reclaimer(const epoch_reclaimer &) = delete;
+  epoch_reclaimer &operator=(const epoch_reclaimer &) = delete;
+
+  /// \brief Starts an operation. Returns the epoch to give to exit().
+  uint64_t enter() const noexcept {
+    while (true) {
+      const auto epoch = m_epoch.load();
+      m_active[epoch % k_num_epochs].count.fetch_add(1);
+      // The epoch could have advanced before the operation was counted
+      if (m_epoch.load() == epoch) return epoch;
+      m_active[epoch % k_num_epochs].count.fetch_sub(1);
+    }
+  }
+
+  /// \brief Ends an operation started in 'epoch'.
+  void exit(const uint64_t epoch) const noexcept {
+    m_active[epoch % k_num_epochs].count.fetch_sub(1);
+  }
+
+  /// \brief Adds a node removed from the container, which must not be
+  /// reachable from it anymore. Must be called in an operation.
+  void retire(node_type *const node) noexcept {
+    auto &list = m_retired[m_epoch.load() % k_num_epochs];
+    auto *head = list.load();
+    do {
+      node->retired_next.store(head, std::memory_order_relaxed);
+    } while (!list.compare_exchange_weak(head, node));
+  }
+
+  /// \brief Advances the epoch from e to e + 1 if no operation started in
+  /// epoch e - 1 is running, and frees the nodes removed in epoch e - 1.
+  /// Must be called out of an operation.
+  /// \param free_node A function that frees a node.
+  template <typename function_type>
+  void try_advance(function_type &&free_node) noexcept {
+    auto epoch = m_epoch.load();
+    const auto previous = (epoch + k_num_epochs - 1) % k_num_epochs;
+    if (m_active[previous].count.load() != 0) return;
+    if (!m_epoch.compare_exchange_strong(epoch, epoch + 1)) return;
+    priv_free_list(m_retired[previous].exchange(nullptr), free_node);
+  }
+
+  /// \brief Frees all removed nodes.
+  /// Must not be called concurrently with others.
+  template <typename function_type>
+  void free_all(function_type &&free_node) noexcept {
+    for (auto &list : m_retired) {
+      priv_free_list(list.exchange(nullptr), free_node);
+    }
+  }
+
+  /// \brief Takes the removed nodes of another reclaimer.
+  /// Must not be called concurrently with others.
+  void take(epoch_reclaimer &other) noexcept {
+    for (int i = 0; i < k_num_epochs; ++i) {
+      m_retired[i].store(other.m_retired[i].exchange(nullptr));
+    }
+  }
+
+ private:
+  template <typename function_type>
+  static void priv_free_list(node_type *node, function_type &free_node) {
+    while (node) {
+      auto *const next = node->retired_next.load(std::memory_order_relaxed);
+      free_node(node);
+      node = next;
+    }
+  }
+
+  mutable std::atomic<uint64_t> m_epoch{0};
+  mutable epoch_counter m_active[k_num_epochs];
+  atomic_relative_ptr<node_type> m_retired[k_num_epochs];
+};
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_EPOCH_RECLAIMER_HPP
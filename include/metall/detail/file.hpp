@@ -15,9 +15,14 @@
 #include <libgen.h>
 
 #ifdef __linux__
+#include <sys/ioctl.h>
 #include <linux/falloc.h>  // For FALLOC_FL_PUNCH_HOLE and FALLOC_FL_KEEP_SIZE
+#include <linux/fs.h>      // For FS_IOC_FIEMAP
+#include <linux/fiemap.h>
 #endif
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -30,8 +35,12 @@
 #include <cstring>
 #include <functional>
 #include <filesystem>
+#include <memory>
+#include <utility>
 
 #include <metall/logger.hpp>
+#include <metall/detail/io_executor.hpp>
+#include <metall/detail/io_uring.hpp>
 
 namespace metall::mtlldetail {
 
@@ -55,6 +64,43 @@ inline bool os_fsync(const int fd) {
   return true;
 }
 
+#ifdef METALL_ENABLE_IO_URING
+/// \brief Syncs files using io_uring, keeping multiple requests in flight.
+/// The number of the requests in flight is also bounded by the queue depth of
+/// the I/O executor.
+/// \param fds File descriptors to sync.
+/// \param datasync If true, performs fdatasync instead.
+/// \return Returns false on error, including when io_uring is not available.
+inline bool fsync_files_io_uring(const std::vector<int> &fds,
+                                 const bool datasync) {
+  auto *const ring = get_thread_local_io_uring();
+  if (!ring) return false;
+
+  const std::size_t queue_depth = io_executor::instance().queue_depth();
+  const std::size_t max_in_flight =
+      (queue_depth > 0) ? std::min<std::size_t>(queue_depth, ring->capacity())
+                        : ring->capacity();
+  bool succeeded = true;
+  std::size_t num_queued = 0;
+  while (num_queued < fds.size() || ring->num_in_flight() > 0) {
+    while (num_queued < fds.size() && ring->num_in_flight() < max_in_flight) {
+      if (!ring->prep_fsync(fds[num_queued], datasync, num_queued)) break;
+      ++num_queued;
+    }
+    std::uint64_t file_no;
+    int result;
+    if (!ring->wait_completion(&file_no, &result)) return false;
+    if (result < 0) {
+      errno = -result;
+      logger::perror(logger::level::error, __FILE__, __LINE__,
+                     "io_uring fsync");
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+#endif
+
 inline bool fsync(const fs::path &path) {
   const int fd = ::open(path.c_str(), O_RDONLY);
   if (fd == -1) {
@@ -96,6 +142,24 @@ inline bool extend_file_size(const int fd, const std::size_t file_size,
       return false;
     }
 #else
+#ifdef METALL_ENABLE_IO_URING
+    if (auto *const ring = get_thread_local_io_uring()) {
+      // Allocate and sync the file in a single submission
+      int fallocate_ret = -1;
+      int fsync_ret = -1;
+      if (ring->prep_fallocate(fd, 0, 0, file_size, 0, true) &&
+          ring->prep_fsync(fd, false, 1)) {
+        for (int i = 0; i < 2; ++i) {
+          std::uint64_t user_data;
+          int result;
+          if (!ring->wait_completion(&user_data, &result)) break;
+          (user_data == 0 ? fallocate_ret : fsync_ret) = result;
+        }
+      }
+      if (fallocate_ret == 0 && fsync_ret == 0) return true;
+      // e.g., the file system does not support fallocate
+    }
+#endif
     if (::posix_fallocate(fd, 0, file_size) == -1) {
       logger::perror(logger::level::error, __FILE__, __LINE__, "fallocate");
       return false;
@@ -429,6 +493,208 @@ inline off_t prepare_file_copy_linux(
   return st.st_size;
 }
 
+/// \brief Gets the data regions of a file; the rest are holes.
+/// \param fd A file descriptor.
+/// \param file_size The size of the file.
+/// \param extents A pointer to store the pairs of (offset, length).
+/// \return On success, returns true. On error, returns false.
+inline bool get_data_extents_linux(
+    const int fd, const off_t file_size,
+    std::vector<std::pair<off_t, off_t>> *const extents) {
+  off_t off = 0;
+  while (off < file_size) {
+    const off_t data_start = ::lseek(fd, off, SEEK_DATA);
+    if (data_start < 0) {
+      if (errno == ENXIO) break;  // No data after off
+      logger::perror(logger::level::error, __FILE__, __LINE__,
+                     "lseek(SEEK_DATA)");
+      return false;
+    }
+    const off_t hole_start = ::lseek(fd, data_start, SEEK_HOLE);
+    if (hole_start < 0) {
+      logger::perror(logger::level::error, __FILE__, __LINE__,
+                     "lseek(SEEK_HOLE)");
+      return false;
+    }
+    extents->emplace_back(data_start, hole_start - data_start);
+    off = hole_start;
+  }
+  return true;
+}
+
+/// \brief The size of the pieces a file is split into for a parallel copy.
+constexpr off_t k_parallel_copy_piece_size = 1ULL << 26ULL;
+
+/// \brief Copies the given regions of src to the same offsets of dst with
+/// multiple threads, splitting the regions into pieces of
+/// k_parallel_copy_piece_size bytes. The other regions of dst are not
+/// touched.
+/// \param src Source file descriptor.
+/// \param dst Destination file descriptor.
+/// \param extents The pairs of (offset, length) to copy.
+/// \param max_num_threads The maximum number of threads to use.
+/// If <= 0 is given, the value is automatically determined.
+/// \return if the operation was successful
+inline bool copy_extents_in_parallel_linux(
+    const int src, const int dst,
+    const std::vector<std::pair<off_t, off_t>> &extents,
+    const int max_num_threads) {
+  std::vector<std::pair<off_t, off_t>> pieces;
+  for (const auto &extent : extents) {
+    for (off_t done = 0; done < extent.second;
+         done += k_parallel_copy_piece_size) {
+      pieces.emplace_back(extent.first + done,
+                          std::min(k_parallel_copy_piece_size,
+                                   extent.second - done));
+    }
+  }
+
+  // Does not bound the tasks by the device, as this function is called from
+  // the tasks that copy files, which already hold the device
+  return io_executor::instance().parallel_for(
+      pieces.size(), max_num_threads, [&](const std::size_t i) {
+        off_t in_off = pieces[i].first;
+        off_t out_off = pieces[i].first;
+        off_t remaining = pieces[i].second;
+        while (remaining > 0) {
+          const auto ret =
+              ::copy_file_range(src, &in_off, dst, &out_off, remaining, 0);
+          if (ret <= 0) {  // Unexpected EOF is also an error
+            logger::perror(logger::level::error, __FILE__, __LINE__,
+                           "copy_file_range");
+            return false;
+          }
+          remaining -= ret;
+        }
+        return true;
+      });
+}
+
+/// \brief Returns true if a file is large enough to be copied in parallel.
+inline bool parallel_copy_worthwhile(const off_t file_size,
+                                     const int max_num_threads) {
+  return max_num_threads != 1 && file_size >= 2 * k_parallel_copy_piece_size;
+}
+
+#ifdef METALL_ENABLE_IO_URING
+/// \brief Copies the given regions of src to the same offsets of dst
+/// using io_uring. Keeps multiple reads and writes in flight.
+/// The other regions of dst are not touched.
+/// \param ring An io_uring instance with no request in flight.
+/// \param src Source file descriptor.
+/// \param dst Destination file descriptor.
+/// \param extents The pairs of (offset, length) to copy.
+/// \return if the operation was successful
+inline bool copy_extents_io_uring(
+    io_uring_queue &ring, const int src, const int dst,
+    const std::vector<std::pair<off_t, off_t>> &extents) {
+  constexpr off_t k_chunk_size = 1ULL << 20ULL;
+  constexpr std::size_t k_max_num_buffers = 8;
+
+  struct buffer_state {
+    std::unique_ptr<char[]> data;
+    off_t offset{0};
+    off_t length{0};
+    off_t done{0};
+    bool writing{false};
+  };
+  std::vector<buffer_state> buffers(
+      std::min<std::size_t>(k_max_num_buffers, ring.capacity()));
+
+  std::size_t extent_no = 0;
+  off_t extent_pos = 0;
+  // Assigns the next chunk to a buffer and queues its read
+  const auto start_next_chunk = [&](const std::size_t buffer_no) {
+    while (extent_no < extents.size() &&
+           extent_pos >= extents[extent_no].second) {
+      ++extent_no;
+      extent_pos = 0;
+    }
+    if (extent_no >= extents.size()) return true;  // Nothing to copy
+
+    auto &buf = buffers[buffer_no];
+    // Not zero-initialize the buffer, which is costly
+    if (!buf.data) buf.data.reset(new char[k_chunk_size]);
+    buf.offset = extents[extent_no].first + extent_pos;
+    buf.length =
+        std::min(k_chunk_size, extents[extent_no].second - extent_pos);
+    buf.done = 0;
+    buf.writing = false;
+    extent_pos += buf.length;
+    return ring.prep_read(src, buf.data.get(), buf.length, buf.offset,
+                         buffer_no);
+  };
+
+  bool succeeded = true;
+  for (std::size_t i = 0; i < buffers.size() && succeeded; ++i) {
+    succeeded = start_next_chunk(i);
+  }
+
+  // Keep taking completions until all requests finish, even on error,
+  // as the kernel uses the buffers
+  std::uint64_t buffer_no;
+  int result;
+  while (ring.num_in_flight() > 0) {
+    if (!ring.wait_completion(&buffer_no, &result)) return false;
+    if (!succeeded) continue;
+
+    auto &buf = buffers[buffer_no];
+    if (result <= 0) {  // Unexpected EOF is also an error
+      errno = -result;
+      logger::perror(logger::level::error, __FILE__, __LINE__,
+                     buf.writing ? "io_uring write" : "io_uring read");
+      succeeded = false;
+      continue;
+    }
+    buf.done += result;
+    if (buf.done < buf.length) {  // Partial read or write
+      succeeded =
+          buf.writing
+              ? ring.prep_write(dst, buf.data.get() + buf.done,
+                                buf.length - buf.done, buf.offset + buf.done,
+                                buffer_no)
+              : ring.prep_read(src, buf.data.get() + buf.done,
+                               buf.length - buf.done, buf.offset + buf.done,
+                               buffer_no);
+    } else if (!buf.writing) {
+      buf.writing = true;
+      buf.done = 0;
+      succeeded = ring.prep_write(dst, buf.data.get(), buf.length, buf.offset,
+                                  buffer_no);
+    } else {
+      succeeded = start_next_chunk(buffer_no);
+    }
+  }
+
+  return succeeded;
+}
+
+/// \brief Copies the data regions of src to dst using io_uring, leaving
+/// the holes in src as holes in dst.
+/// \param src source file descriptor
+/// \param dst destination file descriptor, which must be empty
+/// \param src_size size of source file as obtained by ::fstat(src)
+/// \return if the operation was successful
+/// \note The dense copy does not use io_uring since copy_file_range copies
+/// data in the kernel without bouncing it through a user buffer.
+inline bool copy_file_sparse_io_uring(const int src, const int dst,
+                                      const off_t src_size) {
+  auto *const ring = get_thread_local_io_uring();
+  if (!ring) return false;
+
+  std::vector<std::pair<off_t, off_t>> extents;
+  if (!get_data_extents_linux(src, src_size, &extents)) return false;
+
+  // The rest of the file stays as holes
+  if (::ftruncate(dst, src_size) < 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "ftruncate");
+    return false;
+  }
+
+  return copy_extents_io_uring(*ring, src, dst, extents);
+}
+#endif
+
 /**
  * \brief Performs an accelerated, in-kernel copy from src to dst
  * \param src source file descriptor
@@ -440,7 +706,12 @@ inline off_t prepare_file_copy_linux(
  *    - https://www.man7.org/linux/man-pages/man2/copy_file_range.2.html
  */
 inline bool copy_file_dense_linux(const int src, const int dst,
-                                  const off_t src_size) {
+                                  const off_t src_size,
+                                  const int max_num_threads = 1) {
+  if (parallel_copy_worthwhile(src_size, max_num_threads)) {
+    return copy_extents_in_parallel_linux(src, dst, {{0, src_size}},
+                                          max_num_threads);
+  }
   if (::copy_file_range(src, nullptr, dst, nullptr, src_size, 0) < 0) {
     logger::perror(logger::level::error, __FILE__, __LINE__, "copy_file_range");
     return false;
@@ -453,17 +724,19 @@ inline bool copy_file_dense_linux(const int src, const int dst,
  * \brief performs a dense copy from source_path to destionation_path
  * \param source_path path to source file
  * \param destination_path path to destination file
+ * \param max_num_threads The maximum number of threads to copy a large file.
  * \return if the operation was successful
  */
 inline bool copy_file_dense_linux(
     const std::filesystem::path &source_path,
-    const std::filesystem::path &destination_path) {
+    const std::filesystem::path &destination_path,
+    const int max_num_threads = 1) {
   int src;
   int dst;
   const off_t src_size =
       prepare_file_copy_linux(source_path, destination_path, &src, &dst);
   if (src_size >= 0) {
-    if (copy_file_dense_linux(src, dst, src_size)) {
+    if (copy_file_dense_linux(src, dst, src_size, max_num_threads)) {
       os_fsync(dst);
       os_close(src);
       os_close(dst);
@@ -527,6 +800,7 @@ inline bool create_hole_linux(const int fd, const off_t size) {
  * \param src source file descriptor
  * \param dst destination file descriptor
  * \param src_size size of file behind src as obtained by ::fstat
+ * \param max_num_threads The maximum number of threads to copy a large file.
  * \return if copying was successful
  *
  * Relevant man pages:
@@ -535,7 +809,22 @@ inline bool create_hole_linux(const int fd, const off_t size) {
  *      https://www.man7.org/linux/man-pages/man3/ftruncate.3p.html
  */
 inline bool copy_file_sparse_linux(const int src, const int dst,
-                                   const off_t src_size) {
+                                   const off_t src_size,
+                                   const int max_num_threads = 1) {
+  if (parallel_copy_worthwhile(src_size, max_num_threads)) {
+    std::vector<std::pair<off_t, off_t>> extents;
+    // The rest of the file stays as holes
+    if (get_data_extents_linux(src, src_size, &extents) &&
+        ::ftruncate(dst, src_size) == 0 &&
+        copy_extents_in_parallel_linux(src, dst, extents, max_num_threads)) {
+      return true;
+    }
+    // Falls back to the code below, which overwrites the whole dst
+  }
+#ifdef METALL_ENABLE_IO_URING
+  // Falls back to the code below, which overwrites the whole dst
+  if (copy_file_sparse_io_uring(src, dst, src_size)) return true;
+#endif
   off_t old_off = 0;
   off_t off = 0;
 
@@ -596,7 +885,8 @@ inline bool copy_file_sparse_linux(const int src, const int dst,
  */
 inline bool copy_file_sparse_linux(
     const std::filesystem::path &source_path,
-    const std::filesystem::path &destination_path) {
+    const std::filesystem::path &destination_path,
+    const int max_num_threads = 1) {
   int src;
   int dst;
   const off_t src_size =
@@ -607,7 +897,7 @@ inline bool copy_file_sparse_linux(
     return false;
   }
 
-  if (copy_file_sparse_linux(src, dst, src_size)) {
+  if (copy_file_sparse_linux(src, dst, src_size, max_num_threads)) {
     os_fsync(dst);
     os_close(src);
     os_close(dst);
@@ -624,7 +914,7 @@ inline bool copy_file_sparse_linux(
   os_close(src);
   os_close(dst);
 
-  if (copy_file_dense_linux(source_path, destination_path)) {
+  if (copy_file_dense_linux(source_path, destination_path, max_num_threads)) {
     return true;
   }
 
@@ -639,17 +929,80 @@ inline bool copy_file_sparse_linux(
 
 }  // namespace fcpdtl
 
+/// \brief An extent of a file and its location on the device.
+struct physical_extent {
+  off_t offset;    // In the file
+  off_t physical;  // On the device
+  off_t length;
+};
+
+#ifdef __linux__
+/// \brief Gets the extents of a file whose locations on the device are known
+/// with FIEMAP, e.g., to find the data reflinked files share.
+/// The extents not allocated yet and the ones whose data are not stored as
+/// is, e.g., unwritten, inline, or compressed extents, are not included.
+/// \param fd A file descriptor.
+/// \param extents A pointer to store the extents in ascending order.
+/// \return Returns false if FIEMAP is not available, e.g., the file system
+/// does not support it.
+inline bool get_physical_extents_linux(
+    const int fd, std::vector<physical_extent> *const extents) {
+  constexpr std::size_t k_num_extents = 256;
+  // uint64_t for the alignment of struct fiemap
+  std::vector<uint64_t> buf(
+      (sizeof(struct fiemap) + k_num_extents * sizeof(struct fiemap_extent) +
+       sizeof(uint64_t) - 1) /
+      sizeof(uint64_t));
+  auto *const map = reinterpret_cast<struct fiemap *>(buf.data());
+  constexpr uint32_t k_unusable_flags =
+      FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DELALLOC | FIEMAP_EXTENT_ENCODED |
+      FIEMAP_EXTENT_DATA_ENCRYPTED | FIEMAP_EXTENT_NOT_ALIGNED |
+      FIEMAP_EXTENT_DATA_INLINE | FIEMAP_EXTENT_DATA_TAIL |
+      FIEMAP_EXTENT_UNWRITTEN;
+
+  uint64_t start = 0;
+  while (true) {
+    std::fill(buf.begin(), buf.end(), 0);
+    map->fm_start = start;
+    map->fm_length = FIEMAP_MAX_OFFSET - start;
+    map->fm_flags = FIEMAP_FLAG_SYNC;
+    map->fm_extent_count = k_num_extents;
+    if (::ioctl(fd, FS_IOC_FIEMAP, map) == -1) return false;
+    if (map->fm_mapped_extents == 0) break;
+
+    bool last = false;
+    for (uint32_t i = 0; i < map->fm_mapped_extents; ++i) {
+      const auto &extent = map->fm_extents[i];
+      if (!(extent.fe_flags & k_unusable_flags)) {
+        extents->push_back(physical_extent{off_t(extent.fe_logical),
+                                           off_t(extent.fe_physical),
+                                           off_t(extent.fe_length)});
+      }
+      start = extent.fe_logical + extent.fe_length;
+      last |= !!(extent.fe_flags & FIEMAP_EXTENT_LAST);
+    }
+    if (last) break;
+  }
+  return true;
+}
+#endif
+
 /// \brief Copy a file.
 /// \param source_path A source file path.
 /// \param destination_path A destination path.
 /// \param sparse_copy If true is specified, tries to perform sparse file copy.
+/// \param max_num_threads The maximum number of threads to use. A large file
+/// is split into pieces that are copied in parallel (Linux only).
+/// If <= 0 is given, the value is automatically determined.
 /// \return  On success, returns true. On error, returns false.
 inline bool copy_file(const fs::path &source_path,
                       const fs::path &destination_path,
-                      const bool sparse_copy = true) {
+                      const bool sparse_copy = true,
+                      [[maybe_unused]] const int max_num_threads = 1) {
   if (sparse_copy) {
 #ifdef __linux__
-    return fcpdtl::copy_file_sparse_linux(source_path, destination_path);
+    return fcpdtl::copy_file_sparse_linux(source_path, destination_path,
+                                          max_num_threads);
 #else
     logger::out(logger::level::warning, __FILE__, __LINE__,
                 "Sparse file copy is not available");
@@ -657,7 +1010,8 @@ inline bool copy_file(const fs::path &source_path,
   }
 
 #if __linux__
-  return fcpdtl::copy_file_dense_linux(source_path, destination_path);
+  return fcpdtl::copy_file_dense_linux(source_path, destination_path,
+                                       max_num_threads);
 #else
   return fcpdtl::copy_file_dense(source_path, destination_path);
 #endif
@@ -713,35 +1067,15 @@ inline bool copy_files_in_directory_in_parallel_helper(
     return false;
   }
 
-  std::atomic_uint_fast64_t num_successes = 0;
-  std::atomic_uint_fast64_t file_no_cnt = 0;
-  auto copy_lambda = [&file_no_cnt, &num_successes, &source_dir_path,
-                      &src_file_names, &destination_dir_path, &copy_func]() {
-    while (true) {
-      const auto file_no = file_no_cnt.fetch_add(1);
-      if (file_no >= src_file_names.size()) break;
-      const fs::path &src_file_path = source_dir_path / src_file_names[file_no];
-      const fs::path &dst_file_path =
-          destination_dir_path / src_file_names[file_no];
-      num_successes.fetch_add(copy_func(src_file_path, dst_file_path) ? 1 : 0);
-    }
-  };
-
-  const auto num_threads = std::min<std::size_t>(
-      src_file_names.size(), max_num_threads > 0
-                                 ? max_num_threads
-                                 : std::thread::hardware_concurrency());
-  std::vector<std::thread> threads;
-  threads.reserve(num_threads);
-  for (std::size_t ix = 0; ix < num_threads; ++ix) {
-    threads.emplace_back(copy_lambda);
-  }
-
-  for (auto &th : threads) {
-    th.join();
-  }
-
-  return num_successes == src_file_names.size();
+  // Bound the parallelism by the destination device
+  return io_executor::instance().parallel_for(
+      src_file_names.size(), max_num_threads,
+      [&source_dir_path, &src_file_names, &destination_dir_path,
+       &copy_func](const std::size_t file_no) {
+        return copy_func(source_dir_path / src_file_names[file_no],
+                         destination_dir_path / src_file_names[file_no]);
+      },
+      io_executor::get_device_id(destination_dir_path.c_str()));
 }
 
 /// \brief Copy files in a directory.
@@ -757,8 +1091,9 @@ inline bool copy_files_in_directory_in_parallel(
     const int max_num_threads, const bool sparse_copy = true) {
   return copy_files_in_directory_in_parallel_helper(
       source_dir_path, destination_dir_path, max_num_threads,
-      [&sparse_copy](const fs::path &src, const fs::path &dst) -> bool {
-        return copy_file(src, dst, sparse_copy);
+      [&sparse_copy, max_num_threads](const fs::path &src,
+                                      const fs::path &dst) -> bool {
+        return copy_file(src, dst, sparse_copy, max_num_threads);
       });
 }
 }  // namespace metall::mtlldetail
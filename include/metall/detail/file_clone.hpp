@@ -47,9 +47,12 @@ inline bool clone_file_linux(const int src, const int dst) {
  * Attempts to perform an O(1) clone of source_path to destionation_path
  * if cloning fails, falls back to sparse copying
  * if sparse copying fails, falls back to regular copying
+ * The copies split a large file into pieces copied by up to max_num_threads
+ * threads.
  */
 inline bool clone_file_linux(const std::filesystem::path &source_path,
-                             const std::filesystem::path &destination_path) {
+                             const std::filesystem::path &destination_path,
+                             const int max_num_threads = 1) {
   int src;
   int dst;
   const off_t src_size = fcpdtl::prepare_file_copy_linux(source_path, destination_path, &src, &dst);
@@ -75,7 +78,7 @@ inline bool clone_file_linux(const std::filesystem::path &source_path,
     logger::out(logger::level::warning, __FILE__, __LINE__, ss.str().c_str());
   }
 
-  if (fcpdtl::copy_file_sparse_linux(src, dst, src_size)) {
+  if (fcpdtl::copy_file_sparse_linux(src, dst, src_size, max_num_threads)) {
     close_fsync_all();
     return true;
   }
@@ -89,7 +92,8 @@ inline bool clone_file_linux(const std::filesystem::path &source_path,
   os_close(src);
   os_close(dst);
 
-  if (fcpdtl::copy_file_dense_linux(source_path, destination_path)) {
+  if (fcpdtl::copy_file_dense_linux(source_path, destination_path,
+                                    max_num_threads)) {
     return true;
   }
 
@@ -127,10 +131,14 @@ inline bool clone_file_macos(const fs::path &source_path,
 /// normally. \param source_path A path to the file to be cloned. \param
 /// destination_path A path to copy to. \return On success, returns true. On
 /// error, returns false.
+/// \param max_num_threads The maximum number of threads to use if the file is
+/// copied normally. If <= 0 is given, the value is automatically determined.
 inline bool clone_file(const fs::path &source_path,
-                       const fs::path &destination_path) {
+                       const fs::path &destination_path,
+                       [[maybe_unused]] const int max_num_threads = 1) {
 #if defined(__linux__)
-  return file_clone_detail::clone_file_linux(source_path, destination_path);
+  return file_clone_detail::clone_file_linux(source_path, destination_path,
+                                             max_num_threads);
 #elif defined(__APPLE__)
   return file_clone_detail::clone_file_macos(source_path, destination_path);
 #else
@@ -141,11 +149,53 @@ inline bool clone_file(const fs::path &source_path,
 
   logger::out(logger::level::warning, __FILE__, __LINE__,
               "Using normal copy instead of clone");
-  return copy_file(source_path, destination_path);
+  return copy_file(source_path, destination_path, true, max_num_threads);
 
 #endif
 }
 
+/// \brief Checks if the files under a directory can be cloned (reflink) to
+/// another directory, e.g., to choose between cloning and copying before
+/// copying many files. Clones the first non-empty regular file found under
+/// 'source_dir_path' to a temporary file in 'destination_dir_path', which is
+/// removed; the source files are not modified.
+/// \param source_dir_path A path to a source directory.
+/// \param destination_dir_path A path to an existing destination directory.
+/// \return Returns true if cloning is supported. Returns false if not or no
+/// file is found.
+inline bool clone_supported(
+    [[maybe_unused]] const fs::path &source_dir_path,
+    [[maybe_unused]] const fs::path &destination_dir_path) {
+#if defined(__linux__) && defined(FICLONE)
+  std::error_code ec;
+  fs::path source_file;
+  for (fs::recursive_directory_iterator itr(source_dir_path, ec), end;
+       !ec && itr != end; itr.increment(ec)) {
+    if (itr->is_regular_file(ec) && itr->file_size(ec) > 0) {
+      source_file = itr->path();
+      break;
+    }
+  }
+  if (source_file.empty()) return false;
+
+  const auto probe_path = destination_dir_path /
+                          (".metall_clone_probe-" + std::to_string(::getpid()));
+  int src;
+  int dst;
+  if (fcpdtl::prepare_file_copy_linux(source_file, probe_path, &src, &dst) <
+      0) {
+    return false;
+  }
+  const bool supported = file_clone_detail::clone_file_linux(src, dst);
+  os_close(src);
+  os_close(dst);
+  remove_file(probe_path);
+  return supported;
+#else
+  return false;
+#endif
+}
+
 /// \brief Clone files in a directory.
 /// This function does not clone files in subdirectories.
 /// \param source_dir_path A path to source directory.
@@ -157,7 +207,10 @@ inline bool clone_files_in_directory_in_parallel(
     const fs::path &source_dir_path, const fs::path &destination_dir_path,
     const int max_num_threads) {
   return copy_files_in_directory_in_parallel_helper(
-      source_dir_path, destination_dir_path, max_num_threads, clone_file);
+      source_dir_path, destination_dir_path, max_num_threads,
+      [max_num_threads](const fs::path &src, const fs::path &dst) {
+        return clone_file(src, dst, max_num_threads);
+      });
 }
 
 }  // namespace metall::mtlldetail
@@ -6,7 +6,11 @@
 #ifndef METALL_DETAIL_UTILITY_HASH_HPP
 #define METALL_DETAIL_UTILITY_HASH_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
 
 #include <metall/detail/utilities.hpp>
 
@@ -106,6 +110,121 @@ inline uint64_t MurmurHash64A(const void *key, int len,
   return murmur_hash_64a(key, len, seed);
 }
 
+// -----------------------------------------------------------------------------
+// This file also contains public domain code from wyhash (final version 4.2).
+// From the wyhash header:
+//
+// This is free and unencumbered software released into the public domain
+// under The Unlicense (http://unlicense.org/)
+// main repo: https://github.com/wangyi-fudan/wyhash
+// author: Wang Yi <godspeed_china@yeah.net>
+// -----------------------------------------------------------------------------
+
+namespace wyhdtl {
+inline void wymum(uint64_t *const a, uint64_t *const b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = *a;
+  r *= *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64U);
+#else
+  const uint64_t ha = *a >> 32U, hb = *b >> 32U;
+  const uint64_t la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32U);
+  uint64_t c = t < rl;
+  const uint64_t lo = t + (rm1 << 32U);
+  c += lo < t;
+  const uint64_t hi = rh + (rm0 >> 32U) + (rm1 >> 32U) + c;
+  *a = lo;
+  *b = hi;
+#endif
+}
+
+inline uint64_t wymix(uint64_t a, uint64_t b) noexcept {
+  wymum(&a, &b);
+  return a ^ b;
+}
+
+inline uint64_t wyr8(const uint8_t *const p) noexcept {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+inline uint64_t wyr4(const uint8_t *const p) noexcept {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+inline uint64_t wyr3(const uint8_t *const p, const std::size_t k) noexcept {
+  return (uint64_t(p[0]) << 16U) | (uint64_t(p[k >> 1U]) << 8U) | p[k - 1];
+}
+
+inline constexpr uint64_t k_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL};
+}  // namespace wyhdtl
+
+/// \brief wyhash 64-bit hash, which is faster than murmur_hash_64a,
+/// especially for short keys, on 64-bit platforms with a 64x64->128-bit
+/// multiplication.
+/// \param key The key to hash.
+/// \param len Length of the key in byte.
+/// \param seed A seed value used for hashing.
+/// \return A hash value.
+inline uint64_t wyhash_64(const void *const key, const std::size_t len,
+                          uint64_t seed) noexcept {
+  using namespace wyhdtl;
+  const auto *p = static_cast<const uint8_t *>(key);
+  seed ^= wymix(seed ^ k_secret[0], k_secret[1]);
+  uint64_t a;
+  uint64_t b;
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (wyr4(p) << 32U) | wyr4(p + ((len >> 3U) << 2U));
+      b = (wyr4(p + len - 4) << 32U) | wyr4(p + len - 4 - ((len >> 3U) << 2U));
+    } else if (len > 0) {
+      a = wyr3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    std::size_t i = len;
+    if (i >= 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = wymix(wyr8(p) ^ k_secret[1], wyr8(p + 8) ^ seed);
+        see1 = wymix(wyr8(p + 16) ^ k_secret[2], wyr8(p + 24) ^ see1);
+        see2 = wymix(wyr8(p + 32) ^ k_secret[3], wyr8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wymix(wyr8(p) ^ k_secret[1], wyr8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = wyr8(p + i - 16);
+    b = wyr8(p + i - 8);
+  }
+  a ^= k_secret[1];
+  b ^= seed;
+  wymum(&a, &b);
+  return wymix(a ^ k_secret[0] ^ len, b ^ k_secret[1]);
+}
+
 /// \brief Hash a value of type T. Provides the same interface as std::hash.
 /// \tparam seed A seed value used for hashing.
 template <unsigned int seed = 123>
@@ -135,6 +254,55 @@ struct str_hash {
   }
 };
 
+/// \brief Same as hash but uses wyhash_64.
+/// \tparam seed A seed value used for hashing.
+template <unsigned int seed = 123>
+struct wy_hash {
+  template <typename T>
+  inline std::size_t operator()(const T &key) const noexcept {
+    return wyhash_64(&key, sizeof(T), seed);
+  }
+};
+
+/// \brief Same as str_hash but uses wyhash_64.
+/// \tparam seed A seed value used for hashing.
+template <unsigned int seed = 123>
+struct wy_str_hash {
+  using is_transparent = void;
+
+  template <typename string_type>
+  inline std::size_t operator()(const string_type &str) const noexcept {
+    if constexpr (std::is_same_v<string_type, char *> ||
+                  std::is_same_v<string_type, const char *>) {
+      return wyhash_64(str, std::char_traits<char>::length(str), seed);
+    } else {
+      return wyhash_64(
+          str.data(), str.length() * sizeof(typename string_type::value_type),
+          seed);
+    }
+  }
+};
+
+/// \brief Hashes the n keys from 'first' and stores the hash values to
+/// 'out'. The keys are hashed in a loop without dependencies between the
+/// iterations; thus, the hashes of fixed-size keys in an array, e.g.,
+/// integers with hash or wy_hash, are computed with SIMD instructions if the
+/// compiler can vectorize the hash function, and the hashes of the other keys
+/// overlap in the pipeline. Computing the hashes of a batch ahead of probing a
+/// table also keeps the probing loop short.
+/// \param hasher A hash function object.
+/// \param first The beginning of the keys.
+/// \param n The number of keys.
+/// \param out The beginning of the hash values to store.
+template <typename hasher_type, typename input_iterator,
+          typename output_iterator>
+inline void hash_batch(const hasher_type &hasher, input_iterator first,
+                       const std::size_t n, output_iterator out) {
+  for (std::size_t i = 0; i < n; ++i, ++first, ++out) {
+    *out = hasher(*first);
+  }
+}
+
 }  // namespace metall::mtlldetail
 
 #endif  // METALL_DETAIL_UTILITY_HASH_HPP
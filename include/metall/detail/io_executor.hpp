@@ -0,0 +1,274 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_IO_EXECUTOR_HPP
+#define METALL_DETAIL_IO_EXECUTOR_HPP
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <metall/defs.hpp>
+#include <metall/logger.hpp>
+
+namespace metall::mtlldetail {
+
+/// \brief A process-wide thread pool that runs the I/O tasks of Metall,
+/// e.g., syncing segments and copying files.
+/// The number of the worker threads is bounded so that concurrent I/O
+/// operations share the threads instead of starting their own ones.
+/// In addition, the number of the tasks that access the same device at the
+/// same time can be bounded (queue depth).
+class io_executor {
+ public:
+  using device_id_type = dev_t;
+
+  /// \brief A device ID that does not belong to any device.
+  /// The tasks with this ID are not bounded by the queue depth.
+  static constexpr device_id_type k_no_device = static_cast<device_id_type>(-1);
+
+  /// \brief Returns the shared instance.
+  static io_executor &instance() {
+    // Intentionally leaked so that objects destroyed at exit can still use
+    // it; the idle worker threads do not hold any resource.
+    static io_executor *const executor = new io_executor(
+        METALL_IO_EXECUTOR_NUM_THREADS, METALL_IO_EXECUTOR_QUEUE_DEPTH);
+    return *executor;
+  }
+
+  /// \brief Returns the ID of the device that contains the given path.
+  /// Returns k_no_device on error.
+  static device_id_type get_device_id(const char *const path) {
+    struct stat st;
+    if (::stat(path, &st) != 0) return k_no_device;
+    return st.st_dev;
+  }
+
+  /// \brief Returns the ID of the device of an opened file.
+  /// Returns k_no_device on error.
+  static device_id_type get_device_id(const int fd) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) return k_no_device;
+    return st.st_dev;
+  }
+
+  io_executor(const io_executor &) = delete;
+  io_executor &operator=(const io_executor &) = delete;
+  io_executor(io_executor &&) = delete;
+  io_executor &operator=(io_executor &&) = delete;
+
+  /// \brief Changes the configuration.
+  /// The running tasks are not affected.
+  /// \param num_threads The maximum number of the worker threads.
+  /// If 0 is given, the number of the hardware threads is used.
+  /// \param queue_depth The maximum number of the tasks that access the same
+  /// device at the same time. If 0 is given, it is not bounded.
+  void configure(const std::size_t num_threads,
+                 const std::size_t queue_depth) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_max_num_threads = priv_resolve_num_threads(num_threads);
+    m_queue_depth = queue_depth;
+    m_cv.notify_all();  // Let the excess idle threads exit
+    for (auto &item : m_device_slots) item.second.cv.notify_all();
+  }
+
+  /// \brief Returns the maximum number of the worker threads.
+  std::size_t num_threads() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_max_num_threads;
+  }
+
+  /// \brief Returns the queue depth per device; 0 means not bounded.
+  std::size_t queue_depth() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_queue_depth;
+  }
+
+  /// \brief Runs task(0), ..., task(num_tasks - 1) in parallel and waits for
+  /// them. The calling thread also runs tasks so that this function can be
+  /// called from a task without a deadlock.
+  /// \param num_tasks The number of tasks.
+  /// \param max_parallelism The maximum number of threads, including the
+  /// calling thread, to use. If <= 0 is given, the number of the worker
+  /// threads is used.
+  /// \param task A task to run. Must return true on success.
+  /// \param device_id The ID of the device the tasks access.
+  /// \return Returns true if all tasks succeeded; otherwise, false.
+  bool parallel_for(const std::size_t num_tasks, const int max_parallelism,
+                    const std::function<bool(std::size_t)> &task,
+                    const device_id_type device_id = k_no_device) {
+    if (num_tasks == 0) return true;
+
+    auto state = std::make_shared<parallel_for_state>(num_tasks, task);
+    const auto num_helpers =
+        std::min(num_tasks, (max_parallelism > 0)
+                                ? static_cast<std::size_t>(max_parallelism)
+                                : num_threads()) -
+        1;
+    for (std::size_t i = 0; i < num_helpers; ++i) {
+      priv_enqueue([this, state, device_id]() {
+        {
+          std::lock_guard<std::mutex> guard(state->mutex);
+          if (state->closed) return;
+          ++state->num_active_helpers;
+        }
+        priv_run_tasks(*state, device_id);
+        {
+          std::lock_guard<std::mutex> guard(state->mutex);
+          --state->num_active_helpers;
+        }
+        state->cv.notify_all();
+      });
+    }
+
+    priv_run_tasks(*state, device_id);
+
+    // The helpers that have not started do not touch the task anymore
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->cv.wait(lock, [&state]() { return state->num_active_helpers == 0; });
+
+    return state->num_successes == num_tasks;
+  }
+
+  /// \brief Runs a task in a worker thread.
+  /// \param task A task to run.
+  /// \return Returns an object of std::future that becomes ready when the
+  /// task finishes.
+  std::future<void> submit(std::function<void()> task) {
+    auto packaged =
+        std::make_shared<std::packaged_task<void()>>(std::move(task));
+    auto future = packaged->get_future();
+    priv_enqueue([packaged]() { (*packaged)(); });
+    return future;
+  }
+
+ private:
+  struct parallel_for_state {
+    parallel_for_state(const std::size_t n,
+                       const std::function<bool(std::size_t)> &t)
+        : num_tasks(n), task(t) {}
+
+    const std::size_t num_tasks;
+    const std::function<bool(std::size_t)> &task;
+    std::atomic_uint_fast64_t next_task_no{0};
+    std::atomic_uint_fast64_t num_successes{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t num_active_helpers{0};
+    bool closed{false};
+  };
+
+  struct device_slots {
+    std::size_t num_in_use{0};
+    std::condition_variable cv;
+  };
+
+  io_executor(const std::size_t num_threads, const std::size_t queue_depth)
+      : m_max_num_threads(priv_resolve_num_threads(num_threads)),
+        m_queue_depth(queue_depth) {}
+
+  static std::size_t priv_resolve_num_threads(const std::size_t num_threads) {
+    if (num_threads > 0) return num_threads;
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  void priv_run_tasks(parallel_for_state &state,
+                      const device_id_type device_id) {
+    while (true) {
+      const std::size_t task_no = state.next_task_no.fetch_add(1);
+      if (task_no >= state.num_tasks) break;
+      priv_acquire_device(device_id);
+      bool ret = false;
+      try {
+        ret = state.task(task_no);
+      } catch (...) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "An exception has been thrown in an I/O task");
+      }
+      priv_release_device(device_id);
+      if (ret) state.num_successes.fetch_add(1);
+    }
+  }
+
+  void priv_acquire_device(const device_id_type device_id) {
+    if (device_id == k_no_device) return;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto &slots = m_device_slots[device_id];
+    slots.cv.wait(lock, [this, &slots]() {
+      return m_queue_depth == 0 || slots.num_in_use < m_queue_depth;
+    });
+    ++slots.num_in_use;
+  }
+
+  void priv_release_device(const device_id_type device_id) {
+    if (device_id == k_no_device) return;
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto &slots = m_device_slots[device_id];
+    --slots.num_in_use;
+    slots.cv.notify_one();
+  }
+
+  void priv_enqueue(std::function<void()> job) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_jobs.push_back(std::move(job));
+    if (m_jobs.size() > m_num_idle_threads &&
+        m_num_threads < m_max_num_threads) {
+      try {
+        std::thread(&io_executor::priv_work, this).detach();
+        ++m_num_threads;
+      } catch (const std::system_error &) {
+        logger::out(logger::level::warning, __FILE__, __LINE__,
+                    "Failed to start an I/O thread");
+      }
+    }
+    m_cv.notify_one();
+  }
+
+  void priv_work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      ++m_num_idle_threads;
+      m_cv.wait(lock, [this]() {
+        return !m_jobs.empty() || m_num_threads > m_max_num_threads;
+      });
+      --m_num_idle_threads;
+      if (m_jobs.empty()) {  // Too many threads
+        --m_num_threads;
+        return;
+      }
+      auto job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::function<void()>> m_jobs;
+  std::size_t m_max_num_threads;
+  std::size_t m_queue_depth;
+  std::size_t m_num_threads{0};
+  std::size_t m_num_idle_threads{0};
+  std::map<device_id_type, device_slots> m_device_slots;
+};
+
+}  // namespace metall::mtlldetail
+#endif  // METALL_DETAIL_IO_EXECUTOR_HPP
@@ -0,0 +1,312 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_IO_URING_HPP
+#define METALL_DETAIL_IO_URING_HPP
+
+#if defined(METALL_USE_IO_URING) && defined(__linux__) && \
+    __has_include(<linux/io_uring.h>)
+#define METALL_ENABLE_IO_URING
+#endif
+
+#ifdef METALL_ENABLE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <metall/logger.hpp>
+
+namespace metall::mtlldetail {
+
+/// \brief A minimal io_uring instance that uses the system calls directly,
+/// i.e., it does not depend on liburing.
+/// The number of the requests in flight never exceeds capacity(), so that
+/// the completion queue never overflows.
+/// This class is not thread-safe.
+class io_uring_queue {
+ public:
+  /// \brief Sets up an io_uring instance.
+  /// Check good() to see whether it succeeded.
+  /// \param num_entries The number of the submission queue entries.
+  explicit io_uring_queue(const unsigned int num_entries) {
+    priv_setup(num_entries);
+  }
+
+  ~io_uring_queue() noexcept { priv_teardown(); }
+
+  io_uring_queue(const io_uring_queue &) = delete;
+  io_uring_queue &operator=(const io_uring_queue &) = delete;
+  io_uring_queue(io_uring_queue &&) = delete;
+  io_uring_queue &operator=(io_uring_queue &&) = delete;
+
+  /// \brief Returns true if the instance is ready to use.
+  bool good() const { return m_ring_fd >= 0; }
+
+  /// \brief Returns the maximum number of the requests in flight.
+  unsigned int capacity() const { return m_sq_entries; }
+
+  /// \brief Returns the number of the requests whose completion has not
+  /// been taken.
+  unsigned int num_in_flight() const { return m_num_in_flight; }
+
+  /// \brief Queues a read request. Returns false if the queue is full.
+  bool prep_read(const int fd, void *const buf, const unsigned int length,
+                 const std::uint64_t offset, const std::uint64_t user_data) {
+    auto *const sqe = priv_get_sqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buf);
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    priv_push_sqe();
+    return true;
+  }
+
+  /// \brief Queues a write request. Returns false if the queue is full.
+  bool prep_write(const int fd, const void *const buf,
+                  const unsigned int length, const std::uint64_t offset,
+                  const std::uint64_t user_data) {
+    auto *const sqe = priv_get_sqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buf);
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    priv_push_sqe();
+    return true;
+  }
+
+  /// \brief Queues an fsync request. Returns false if the queue is full.
+  /// \param datasync If true, performs fdatasync instead.
+  bool prep_fsync(const int fd, const bool datasync,
+                  const std::uint64_t user_data) {
+    auto *const sqe = priv_get_sqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = fd;
+    sqe->fsync_flags = datasync ? IORING_FSYNC_DATASYNC : 0;
+    sqe->user_data = user_data;
+    priv_push_sqe();
+    return true;
+  }
+
+  /// \brief Queues a fallocate request. Returns false if the queue is full.
+  /// \param link If true, the next request starts after this one succeeds.
+  bool prep_fallocate(const int fd, const int mode, const std::uint64_t offset,
+                      const std::uint64_t length,
+                      const std::uint64_t user_data, const bool link = false) {
+    auto *const sqe = priv_get_sqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_FALLOCATE;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = length;
+    sqe->len = mode;
+    sqe->user_data = user_data;
+    if (link) sqe->flags |= IOSQE_IO_LINK;
+    priv_push_sqe();
+    return true;
+  }
+
+  /// \brief Submits the queued requests and takes a completion, waiting for
+  /// one if there is none.
+  /// \param user_data A pointer to store the user data of the request.
+  /// \param result A pointer to store the result of the request,
+  /// i.e., the return value of the corresponding system call or -errno.
+  /// \return Returns false on error, including when no request is in flight.
+  bool wait_completion(std::uint64_t *const user_data, int *const result) {
+    if (m_num_in_flight == 0) return false;
+    while (!priv_pop_cqe(user_data, result)) {
+      if (!priv_enter(1)) return false;
+    }
+    return true;
+  }
+
+ private:
+  static int priv_sys_setup(const unsigned int entries,
+                            io_uring_params *const params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+  }
+
+  static int priv_sys_enter(const int fd, const unsigned int to_submit,
+                            const unsigned int min_complete,
+                            const unsigned int flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit,
+                                      min_complete, flags, nullptr, 0));
+  }
+
+  void priv_setup(const unsigned int num_entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int fd = priv_sys_setup(num_entries, &params);
+    if (fd < 0) {
+      logger::perror(logger::level::verbose, __FILE__, __LINE__,
+                     "io_uring_setup");
+      return;
+    }
+
+    m_sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+    m_cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      m_sq_ring_size = m_cq_ring_size =
+          std::max(m_sq_ring_size, m_cq_ring_size);
+    }
+
+    m_sq_ring = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (m_sq_ring == MAP_FAILED) {
+      m_sq_ring = nullptr;
+      logger::perror(logger::level::error, __FILE__, __LINE__, "mmap");
+      ::close(fd);
+      return;
+    }
+    if (single_mmap) {
+      m_cq_ring = m_sq_ring;
+    } else {
+      m_cq_ring = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (m_cq_ring == MAP_FAILED) {
+        m_cq_ring = nullptr;
+        logger::perror(logger::level::error, __FILE__, __LINE__, "mmap");
+        priv_unmap_rings();
+        ::close(fd);
+        return;
+      }
+    }
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    auto *const sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "mmap");
+      priv_unmap_rings();
+      ::close(fd);
+      return;
+    }
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    auto *const sq = static_cast<char *>(m_sq_ring);
+    m_sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+    auto *const cq = static_cast<char *>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    m_sq_entries = params.sq_entries;
+    m_ring_fd = fd;
+  }
+
+  void priv_unmap_rings() {
+    if (m_cq_ring && m_cq_ring != m_sq_ring) {
+      ::munmap(m_cq_ring, m_cq_ring_size);
+    }
+    if (m_sq_ring) ::munmap(m_sq_ring, m_sq_ring_size);
+    m_sq_ring = m_cq_ring = nullptr;
+  }
+
+  void priv_teardown() noexcept {
+    if (!good()) return;
+    // Do not release the buffers the kernel may still use
+    std::uint64_t user_data;
+    int result;
+    while (m_num_in_flight > 0 && wait_completion(&user_data, &result)) {
+    }
+    ::munmap(m_sqes, m_sqes_size);
+    priv_unmap_rings();
+    ::close(m_ring_fd);
+    m_ring_fd = -1;
+  }
+
+  io_uring_sqe *priv_get_sqe() {
+    if (!good() || m_num_in_flight >= m_sq_entries) return nullptr;
+    auto *const sqe = &m_sqes[*m_sq_tail & m_sq_mask];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    return sqe;
+  }
+
+  void priv_push_sqe() {
+    const unsigned int tail = *m_sq_tail;
+    m_sq_array[tail & m_sq_mask] = tail & m_sq_mask;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++m_num_to_submit;
+    ++m_num_in_flight;
+  }
+
+  bool priv_pop_cqe(std::uint64_t *const user_data, int *const result) {
+    const unsigned int head = *m_cq_head;
+    if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) return false;
+    const auto &cqe = m_cqes[head & m_cq_mask];
+    *user_data = cqe.user_data;
+    *result = cqe.res;
+    __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+    --m_num_in_flight;
+    return true;
+  }
+
+  /// \brief Submits the queued requests and waits for completions.
+  bool priv_enter(const unsigned int min_complete) {
+    while (true) {
+      const int ret = priv_sys_enter(m_ring_fd, m_num_to_submit, min_complete,
+                                     IORING_ENTER_GETEVENTS);
+      if (ret >= 0) {
+        m_num_to_submit -= std::min<unsigned int>(ret, m_num_to_submit);
+        return true;
+      }
+      if (errno != EINTR) {
+        logger::perror(logger::level::error, __FILE__, __LINE__,
+                       "io_uring_enter");
+        return false;
+      }
+    }
+  }
+
+  int m_ring_fd{-1};
+  unsigned int m_sq_entries{0};
+  unsigned int m_num_to_submit{0};
+  unsigned int m_num_in_flight{0};
+  void *m_sq_ring{nullptr};
+  void *m_cq_ring{nullptr};
+  std::size_t m_sq_ring_size{0};
+  std::size_t m_cq_ring_size{0};
+  io_uring_sqe *m_sqes{nullptr};
+  std::size_t m_sqes_size{0};
+  unsigned int *m_sq_tail{nullptr};
+  unsigned int m_sq_mask{0};
+  unsigned int *m_sq_array{nullptr};
+  unsigned int *m_cq_head{nullptr};
+  unsigned int *m_cq_tail{nullptr};
+  unsigned int m_cq_mask{0};
+  io_uring_cqe *m_cqes{nullptr};
+};
+
+/// \brief Returns the io_uring instance of the calling thread.
+/// Returns nullptr if io_uring is not available on the running system.
+inline io_uring_queue *get_thread_local_io_uring() {
+  constexpr unsigned int k_num_entries = 64;
+  thread_local std::unique_ptr<io_uring_queue> queue =
+      std::make_unique<io_uring_queue>(k_num_entries);
+  return queue->good() ? queue.get() : nullptr;
+}
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_ENABLE_IO_URING
+#endif  // METALL_DETAIL_IO_URING_HPP
@@ -9,9 +9,12 @@
 #include <unistd.h>
 #include <iostream>
 #include <cstdio>
+#include <cstdint>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
 #include <metall/logger.hpp>
 
 namespace metall::mtlldetail {
@@ -111,6 +114,66 @@ inline ssize_t get_page_cache_size() {
   return static_cast<ssize_t>(cached_size);
 }
 
+/// \brief A mapping of this process and the bytes of its dirty pages.
+struct dirty_mapping {
+  std::uintptr_t begin{0};
+  std::uintptr_t end{0};
+  std::size_t dirty_size{0};
+};
+
+/// \brief Reads the dirty sizes (Shared_Dirty + Private_Dirty) of the
+/// mappings in [addr, addr + size) from /proc/self/smaps.
+/// The dirty pages of a shared file mapping are the ones not written back to
+/// the file yet; msync(2) makes them clean.
+/// The mappings are clipped to the region; a clipped mapping keeps the dirty
+/// size of the whole mapping.
+/// Reading smaps walks the page tables of all mappings of the process.
+/// \param addr The beginning address of the region.
+/// \param size The size of the region.
+/// \param mappings A pointer to store the mappings that have dirty pages.
+/// \return On success, returns true. On error, e.g., smaps is not available,
+/// returns false.
+inline bool read_dirty_mappings(const void *const addr, const std::size_t size,
+                                std::vector<dirty_mapping> *const mappings) {
+  mappings->clear();
+  std::ifstream fin("/proc/self/smaps");
+  if (!fin.is_open()) {
+    return false;
+  }
+
+  const auto region_begin = reinterpret_cast<std::uintptr_t>(addr);
+  const auto region_end = region_begin + size;
+  bool in_region = false;
+  dirty_mapping current;
+  const auto flush_current = [&]() {
+    if (in_region && current.dirty_size > 0) mappings->push_back(current);
+  };
+
+  std::string line;
+  while (std::getline(fin, line)) {
+    const auto key_end = line.find_first_of(" \t");
+    if (key_end == std::string::npos || key_end == 0) continue;
+    if (line[key_end - 1] != ':') {  // Header line: begin-end perms ...
+      flush_current();
+      unsigned long long begin = 0;
+      unsigned long long end = 0;
+      in_region = (std::sscanf(line.c_str(), "%llx-%llx", &begin, &end) ==
+                   2) &&
+                  begin < region_end && region_begin < end;
+      current = dirty_mapping{std::max<std::uintptr_t>(begin, region_begin),
+                              std::min<std::uintptr_t>(end, region_end), 0};
+      continue;
+    }
+    if (!in_region) continue;
+    if (line.compare(0, key_end, "Shared_Dirty:") == 0 ||
+        line.compare(0, key_end, "Private_Dirty:") == 0) {
+      current.dirty_size += std::stoull(line.substr(key_end)) * 1024;
+    }
+  }
+  flush_current();
+  return !fin.bad();
+}
+
 /// \brief Returns the number of page faults caused by the process
 /// \return A pair of #of minor and major page faults
 inline std::pair<std::size_t, std::size_t> get_num_page_faults() {
@@ -15,10 +15,13 @@
 #include <linux/falloc.h>  // For FALLOC_FL_PUNCH_HOLE and FALLOC_FL_KEEP_SIZE
 #endif
 
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <cstdio>
 #include <cerrno>
 #include <sstream>
+#include <cassert>
 
 #include <metall/detail/memory.hpp>
 #include <metall/detail/file.hpp>
@@ -89,6 +92,33 @@ inline void *map_anonymous_write_mode(void *const addr, const size_t length,
                  MAP_ANONYMOUS | MAP_PRIVATE | additional_flags, -1, 0);
 }
 
+/// \brief Map an anonymous region backed by huge pages (MAP_HUGETLB).
+/// Does not log message on failure because the system often has no huge pages
+/// reserved; the caller is expected to fall back to the normal pages.
+/// \param addr Same as map_anonymous_write_mode().
+/// \param length The length of the map. Must be a multiple of
+/// 'huge_page_size'.
+/// \param huge_page_size The huge page size to use (a power of two).
+/// \param additional_flags Additional map flags
+/// \return The starting address for the map. Returns nullptr on error.
+inline void *map_anonymous_huge_page_write_mode(
+    [[maybe_unused]] void *const addr, [[maybe_unused]] const size_t length,
+    [[maybe_unused]] const size_t huge_page_size,
+    [[maybe_unused]] const int additional_flags = 0) {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+  assert(length % huge_page_size == 0);
+  const int size_flag = int(log2_dynamic(huge_page_size)) << MAP_HUGE_SHIFT;
+  void *const mapped_addr =
+      ::mmap(addr, length, PROT_READ | PROT_WRITE,
+             MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | size_flag |
+                 additional_flags,
+             -1, 0);
+  return (mapped_addr == MAP_FAILED) ? nullptr : mapped_addr;
+#else
+  return nullptr;
+#endif
+}
+
 /// \brief Map a file with read mode
 /// \param file_name The name of file to be mapped
 /// \param addr Normally nullptr; if this is not nullptr the kernel takes it as
@@ -167,6 +197,68 @@ inline std::pair<int, void *> map_file_write_mode(
   return std::make_pair(fd, mapped_addr);
 }
 
+/// \brief Checks if a file can be mapped with MAP_SYNC, i.e., it is on a
+/// file system mounted with DAX, e.g., on persistent or CXL memory.
+/// With MAP_SYNC, the file system metadata is synced on page faults; thus,
+/// data stored through the map is durable once its CPU cache lines are
+/// written back, without msync.
+/// \param fd The file descriptor of a file opened with O_RDWR.
+/// \return Returns true if MAP_SYNC is supported for the file.
+inline bool map_sync_supported([[maybe_unused]] const int fd) {
+#if defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+  // Maps one page at an address of the kernel's choice, as a failed map with
+  // MAP_FIXED may unmap the region already there
+  const ssize_t page_size = get_page_size();
+  if (page_size <= 0) return false;
+  void *const addr = ::mmap(nullptr, page_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+  if (addr == MAP_FAILED) return false;
+  ::munmap(addr, page_size);
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// \brief Same as map_file_write_mode() but maps a file with MAP_SYNC if it
+/// is supported for the file; see map_sync_supported().
+/// \param file_name The name of file to be mapped.
+/// \param addr Same as map_file_write_mode().
+/// \param length The length of the map.
+/// \param offset The offset in the file.
+/// \param additional_flags Additional flags of mmap(2).
+/// \param sync_mapped Set to true if the file is mapped with MAP_SYNC.
+/// \return A pair of the file descriptor of the file and the starting address
+/// for the map.
+inline std::pair<int, void *> map_file_write_sync_mode(
+    const fs::path &file_name, void *const addr, const size_t length,
+    const off_t offset, const int additional_flags,
+    bool *const sync_mapped) {
+  *sync_mapped = false;
+  const int fd = ::open(file_name.c_str(), O_RDWR);
+  if (fd == -1) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+    return std::make_pair(-1, nullptr);
+  }
+
+  int flags = additional_flags;
+#if defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+  if (map_sync_supported(fd)) {
+    // MAP_SHARED_VALIDATE includes the bits of MAP_SHARED
+    flags |= MAP_SHARED_VALIDATE | MAP_SYNC;
+    *sync_mapped = true;
+  }
+#endif
+  void *mapped_addr = map_file_write_mode(fd, addr, length, offset, flags);
+  if (mapped_addr == nullptr) {
+    close(fd);
+    *sync_mapped = false;
+    return std::make_pair(-1, nullptr);
+  }
+
+  return std::make_pair(fd, mapped_addr);
+}
+
 /// \brief Map a file with write mode and MAP_PRIVATE.
 /// \param fd  The file descriptor to map.
 /// \param addr Normally nullptr; if this is not nullptr the kernel takes it as
@@ -200,7 +292,8 @@ inline std::pair<int, void *> map_file_write_private_mode(
     const fs::path &file_name, void *const addr, const size_t length,
     const off_t offset, const int additional_flags = 0) {
   // ----- Open the file ----- //
-  const int fd = ::open(file_name.c_str(), O_RDWR);
+  // Read permission is enough as a private map never writes to the file
+  const int fd = ::open(file_name.c_str(), O_RDONLY);
   if (fd == -1) {
     logger::perror(logger::level::error, __FILE__, __LINE__, "open");
     return std::make_pair(-1, nullptr);
@@ -284,6 +377,87 @@ inline bool os_madvise(void *const addr, const size_t length, const int advice,
   return (ret == 0);
 }
 
+/// \brief Asks the kernel to back a region with transparent huge pages
+/// (MADV_HUGEPAGE). For file-backed regions, this takes effect only on file
+/// systems that support huge pages, e.g., tmpfs mounted with huge=advise.
+/// \return Returns false if the advice is not supported or fails.
+inline bool advise_huge_page([[maybe_unused]] void *const addr,
+                             [[maybe_unused]] const size_t length) {
+#ifdef MADV_HUGEPAGE
+  return os_madvise(addr, length, MADV_HUGEPAGE);
+#else
+  return false;
+#endif
+}
+
+/// \brief Loads the pages of a mapped region into memory and maps them,
+/// so that the following reads do not take page faults (MADV_POPULATE_READ).
+/// If it is not available, asks the kernel to read the pages ahead
+/// asynchronously instead (MADV_WILLNEED).
+/// \return Returns false if both fail.
+inline bool populate_read(void *const addr, const size_t length) {
+#ifdef MADV_POPULATE_READ
+  if (os_madvise(addr, length, MADV_POPULATE_READ)) return true;
+#endif
+  return os_madvise(addr, length, MADV_WILLNEED);
+}
+
+/// \brief Faults in the pages of a mapped region writable
+/// (MADV_POPULATE_WRITE) without changing their contents, so that the
+/// following writes do not take page faults. For a shared file map, this
+/// allocates the file blocks of holes and marks the pages dirty.
+/// \return Returns false if the advice is not supported or fails.
+inline bool populate_write([[maybe_unused]] void *const addr,
+                           [[maybe_unused]] const size_t length) {
+#ifdef MADV_POPULATE_WRITE
+  return os_madvise(addr, length, MADV_POPULATE_WRITE);
+#else
+  return false;
+#endif
+}
+
+/// \brief Asks the kernel to read the pages of a region ahead
+/// asynchronously (MADV_WILLNEED), e.g., before accessing them at random.
+/// The region does not need to be page-aligned.
+/// \return Returns false if the advice fails.
+inline bool advise_will_need(const void *const addr, const size_t length) {
+  const auto page_size = static_cast<uintptr_t>(get_page_size());
+  const auto begin = reinterpret_cast<uintptr_t>(addr) / page_size * page_size;
+  const auto end = reinterpret_cast<uintptr_t>(addr) + length;
+  return os_madvise(reinterpret_cast<void *>(begin), end - begin,
+                    MADV_WILLNEED);
+}
+
+/// \brief Asks the kernel to deactivate the pages of a region, so that they
+/// are reclaimed before other pages (MADV_COLD), e.g., after a streaming scan.
+/// \return Returns false if the advice is not supported or fails.
+inline bool advise_cold([[maybe_unused]] void *const addr,
+                        [[maybe_unused]] const size_t length) {
+#ifdef MADV_COLD
+  return os_madvise(addr, length, MADV_COLD);
+#else
+  return false;
+#endif
+}
+
+/// \brief Locks the pages of a region in memory, loading them.
+inline bool os_mlock(const void *const addr, const size_t length) {
+  if (::mlock(addr, length) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "mlock");
+    return false;
+  }
+  return true;
+}
+
+/// \brief Unlocks the pages of a region.
+inline bool os_munlock(const void *const addr, const size_t length) {
+  if (::munlock(addr, length) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "munlock");
+    return false;
+  }
+  return true;
+}
+
 // NOTE: the MADV_FREE operation can be applied only to private anonymous pages.
 inline bool uncommit_private_anonymous_pages(void *const addr,
                                              const size_t length) {
@@ -326,20 +500,65 @@ inline bool uncommit_shared_pages(void *const addr, const size_t length) {
   return true;
 }
 
+/// \brief Frees the pages and the file space of a shared mapping.
+/// Falls back to uncommit_shared_pages() if the file space cannot be freed.
+/// \param zero_filled If not nullptr, set to true if the file space is freed,
+/// i.e., the region reads as zeros.
 inline bool uncommit_shared_pages_and_free_file_space(
-    [[maybe_unused]] void *const addr, [[maybe_unused]] const size_t length) {
+    [[maybe_unused]] void *const addr, [[maybe_unused]] const size_t length,
+    [[maybe_unused]] bool *const zero_filled = nullptr) {
+  if (zero_filled) *zero_filled = false;
 #ifdef MADV_REMOVE
   if (!os_madvise(addr, length, MADV_REMOVE)) {
     logger::perror(logger::level::verbose, __FILE__, __LINE__,
                    "madvise MADV_REMOVE");
     return uncommit_shared_pages(addr, length);
   }
+  if (zero_filled) *zero_filled = true;
   return true;
 #else
   return false;
 #endif
 }
 
+/// \brief Returns true if the page that contains an address is resident in
+/// memory (mincore(2)), i.e., accessing it does not read storage.
+/// Also returns true on error, e.g., for an address not mapped.
+inline bool is_page_resident(const void *const addr) {
+  const auto page_size = static_cast<uintptr_t>(get_page_size());
+  const auto page = reinterpret_cast<uintptr_t>(addr) / page_size * page_size;
+  unsigned char vec = 0;
+  if (::mincore(reinterpret_cast<void *>(page), 1, &vec) != 0) return true;
+  return vec & 1;
+}
+
+/// \brief Returns the number of bytes of a mapped region resident in memory
+/// (mincore(2)). The region is examined in windows so that the temporary
+/// buffer stays small.
+/// \param addr The page-aligned start address of the region.
+/// \param length The length of the region.
+/// \return The number of resident bytes. On error, returns -1.
+inline ssize_t get_num_resident_bytes(void *const addr, const size_t length) {
+  const ssize_t page_size = get_page_size();
+  if (page_size <= 0) return -1;
+
+  constexpr size_t k_window_size = 1ULL << 30ULL;
+  std::vector<unsigned char> vec(k_window_size / page_size);
+  size_t num_resident_pages = 0;
+  for (size_t offset = 0; offset < length; offset += k_window_size) {
+    const size_t size = std::min(k_window_size, length - offset);
+    if (::mincore(static_cast<char *>(addr) + offset, size, vec.data()) != 0) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "mincore");
+      return -1;
+    }
+    const size_t num_pages = (size + page_size - 1) / page_size;
+    for (size_t i = 0; i < num_pages; ++i) {
+      num_resident_pages += vec[i] & 1;
+    }
+  }
+  return num_resident_pages * page_size;
+}
+
 /// \brief Reserve a VM region
 /// \param length Length of the region to reserve
 /// \return The address of the reserved region
@@ -407,6 +626,30 @@ inline void *reserve_aligned_vm_region(const size_t alignment,
   return aligned_map_addr;
 }
 
+/// \brief Extends a reserved VM region in place, reserving the region right
+/// after it if nothing is mapped there.
+/// \param end_addr The end of the reserved region. Must be page aligned.
+/// \param length The number of bytes to add. Must be a multiple of the page
+/// size.
+/// \return Returns true on success. Returns false if the region after
+/// 'end_addr' is (partially) used or on error; nothing is changed then.
+inline bool extend_reserved_vm_region(void *const end_addr,
+                                      const size_t length) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#ifdef MAP_FIXED_NOREPLACE
+  flags |= MAP_FIXED_NOREPLACE;
+#endif
+  // Without MAP_FIXED_NOREPLACE, including old kernels that ignore it, the
+  // address is a hint
+  void *const addr = ::mmap(end_addr, length, PROT_NONE, flags, -1, 0);
+  if (addr == MAP_FAILED) return false;
+  if (addr != end_addr) {
+    os_munmap(addr, length);
+    return false;
+  }
+  return true;
+}
+
 class pagemap_reader {
  public:
   static constexpr uint64_t error_value = static_cast<uint64_t>(-1);
@@ -452,6 +695,27 @@ class pagemap_reader {
     return buf;
   }
 
+  /// \brief Reads the pagemap entries of consecutive pages.
+  /// \param page_no The first page number.
+  /// \param num_pages The number of pages to read.
+  /// \param buf A buffer to store 'num_pages' entries.
+  /// \return Returns true on success; otherwise, false.
+  bool read(const uint64_t page_no, const std::size_t num_pages,
+            uint64_t *const buf) {
+    if (m_fd < 0) {
+      return false;
+    }
+
+    const auto nbytes = num_pages * sizeof(uint64_t);
+    if (::pread(m_fd, buf, nbytes, page_no * sizeof(uint64_t)) !=
+        (ssize_t)nbytes) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "pread");
+      return false;
+    }
+
+    return true;
+  }
+
  private:
   int m_fd;
 };
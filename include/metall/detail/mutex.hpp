@@ -7,11 +7,27 @@
 #define METALL_DETAIL_UTILITY_MUTEX_HPP
 
 #include <mutex>
+#include <shared_mutex>
 
 namespace metall::mtlldetail {
 
 using mutex = std::mutex;
 using mutex_lock_guard = std::lock_guard<mutex>;
 
+using shared_mutex = std::shared_mutex;
+using shared_mutex_lock_guard = std::lock_guard<shared_mutex>;
+using shared_mutex_shared_lock_guard = std::shared_lock<shared_mutex>;
+
+/// \brief A mutex that does nothing, for the code that runs in a single
+/// thread. Meets the requirements of both Mutex and SharedMutex.
+struct null_mutex {
+  void lock() noexcept {}
+  bool try_lock() noexcept { return true; }
+  void unlock() noexcept {}
+  void lock_shared() noexcept {}
+  bool try_lock_shared() noexcept { return true; }
+  void unlock_shared() noexcept {}
+};
+
 }  // namespace metall::mtlldetail
 #endif  // METALL_DETAIL_UTILITY_MUTEX_HPP
@@ -0,0 +1,201 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_NUMA_HPP
+#define METALL_DETAIL_NUMA_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/mempolicy.h>)
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#define METALL_SUPPORT_NUMA_POLICY true
+#else
+#define METALL_SUPPORT_NUMA_POLICY false
+#endif
+
+#include <metall/logger.hpp>
+
+/// \namespace metall::mtlldetail::numa
+/// \brief Sets the NUMA memory policies of regions.
+/// Uses the system calls directly, i.e., does not depend on libnuma.
+namespace metall::mtlldetail::numa {
+
+#if METALL_SUPPORT_NUMA_POLICY
+namespace numadtl {
+constexpr std::size_t k_max_num_nodes = 1024;
+constexpr std::size_t k_bits_per_word = sizeof(unsigned long) * 8;
+using node_mask_type = unsigned long[k_max_num_nodes / k_bits_per_word];
+
+inline bool os_mbind(void *const addr, const std::size_t length,
+                     const int mode, const node_mask_type &mask,
+                     const unsigned int flags = 0) {
+  // The kernel drops the last bit of maxnode
+  if (::syscall(SYS_mbind, addr, length, mode, mask, k_max_num_nodes + 1,
+                flags) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "mbind");
+    return false;
+  }
+  return true;
+}
+}  // namespace numadtl
+#endif
+
+/// \brief Returns the NUMA nodes the calling process can allocate memory on.
+/// Returns {0} if they are not available.
+inline const std::vector<int> &allowed_nodes() {
+  static const std::vector<int> nodes = []() {
+    std::vector<int> list;
+#if METALL_SUPPORT_NUMA_POLICY
+    numadtl::node_mask_type mask = {};
+    if (::syscall(SYS_get_mempolicy, nullptr, mask, numadtl::k_max_num_nodes,
+                  nullptr, MPOL_F_MEMS_ALLOWED) == 0) {
+      for (std::size_t n = 0; n < numadtl::k_max_num_nodes; ++n) {
+        if (mask[n / numadtl::k_bits_per_word] &
+            (1UL << (n % numadtl::k_bits_per_word))) {
+          list.push_back(static_cast<int>(n));
+        }
+      }
+    }
+#endif
+    if (list.empty()) list.push_back(0);
+    return list;
+  }();
+  return nodes;
+}
+
+/// \brief Interleaves the pages of a region over the allowed NUMA nodes.
+/// \return Returns false on error.
+inline bool interleave([[maybe_unused]] void *const addr,
+                       [[maybe_unused]] const std::size_t length) {
+#if METALL_SUPPORT_NUMA_POLICY
+  numadtl::node_mask_type mask = {};
+  for (const auto node : allowed_nodes()) {
+    mask[node / numadtl::k_bits_per_word] |=
+        1UL << (node % numadtl::k_bits_per_word);
+  }
+  return numadtl::os_mbind(addr, length, MPOL_INTERLEAVE, mask);
+#else
+  return false;
+#endif
+}
+
+/// \brief Returns the allowed NUMA nodes without CPUs, e.g., CXL-attached
+/// or other far memory, in the node number order.
+inline const std::vector<int> &cpuless_nodes() {
+  static const std::vector<int> nodes = []() {
+    std::vector<int> list;
+    for (const auto node : allowed_nodes()) {
+      std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) +
+                        "/cpulist");
+      std::string cpus;
+      if (ifs.is_open() && (!std::getline(ifs, cpus) || cpus.empty())) {
+        list.push_back(node);
+      }
+    }
+    return list;
+  }();
+  return nodes;
+}
+
+/// \brief Binds the pages of a region to a NUMA node.
+/// \param move If true, also moves the pages already allocated on other
+/// nodes and mapped only by this process (MPOL_MF_MOVE), e.g., to demote
+/// cold data to a far memory node.
+/// \return Returns false on error.
+inline bool bind([[maybe_unused]] void *const addr,
+                 [[maybe_unused]] const std::size_t length,
+                 [[maybe_unused]] const int node,
+                 [[maybe_unused]] const bool move = false) {
+#if METALL_SUPPORT_NUMA_POLICY
+  if (node < 0 || static_cast<std::size_t>(node) >= numadtl::k_max_num_nodes)
+    return false;
+  numadtl::node_mask_type mask = {};
+  mask[node / numadtl::k_bits_per_word] =
+      1UL << (node % numadtl::k_bits_per_word);
+  return numadtl::os_mbind(addr, length, MPOL_BIND, mask,
+                           move ? MPOL_MF_MOVE : 0);
+#else
+  return false;
+#endif
+}
+
+/// \brief Makes the calling thread allocate new pages on a NUMA node
+/// preferentially. Falls back to other nodes if the node runs out of memory.
+/// If a negative value is given, restores the default policy.
+/// \return Returns false on error.
+inline bool prefer_node_for_thread([[maybe_unused]] const int node) {
+#if METALL_SUPPORT_NUMA_POLICY
+  if (node < 0) {
+    return ::syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0) == 0;
+  }
+  if (static_cast<std::size_t>(node) >= numadtl::k_max_num_nodes)
+    return false;
+  numadtl::node_mask_type mask = {};
+  mask[node / numadtl::k_bits_per_word] =
+      1UL << (node % numadtl::k_bits_per_word);
+  if (::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask,
+                numadtl::k_max_num_nodes + 1) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "set_mempolicy");
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// \brief Returns the memory policy mode (e.g., MPOL_INTERLEAVE) of the page
+/// that contains an address. Returns -1 on error.
+inline int get_policy([[maybe_unused]] void *const addr) {
+#if METALL_SUPPORT_NUMA_POLICY
+  int mode = -1;
+  if (::syscall(SYS_get_mempolicy, &mode, nullptr, 0, addr, MPOL_F_ADDR) !=
+      0) {
+    return -1;
+  }
+  return mode;
+#else
+  return -1;
+#endif
+}
+
+/// \brief Stores the NUMA node of each page of a region in 'nodes', or a
+/// negative value for a page not allocated (move_pages(2)).
+/// Does not allocate pages.
+/// \param addr The beginning of the region. Must be page aligned.
+/// \param num_pages The number of pages.
+/// \param page_size The system page size.
+/// \param nodes A pointer to a vector to store the nodes.
+/// \return Returns false on error.
+inline bool page_nodes([[maybe_unused]] const void *const addr,
+                       [[maybe_unused]] const std::size_t num_pages,
+                       [[maybe_unused]] const std::size_t page_size,
+                       std::vector<int> *const nodes) {
+  nodes->assign(num_pages, -1);
+#if METALL_SUPPORT_NUMA_POLICY && defined(SYS_move_pages)
+  std::vector<void *> pages(num_pages);
+  for (std::size_t i = 0; i < num_pages; ++i) {
+    pages[i] = const_cast<char *>(static_cast<const char *>(addr)) +
+               i * page_size;
+  }
+  // Only queries the nodes if the nodes to move to are not given
+  if (::syscall(SYS_move_pages, 0, num_pages, pages.data(), nullptr,
+                nodes->data(), 0) != 0) {
+    logger::perror(logger::level::error, __FILE__, __LINE__, "move_pages");
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace metall::mtlldetail::numa
+#endif  // METALL_DETAIL_NUMA_HPP
@@ -0,0 +1,137 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_PAGE_IDLE_HPP
+#define METALL_DETAIL_PAGE_IDLE_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/logger.hpp>
+
+namespace metall::mtlldetail {
+
+/// \brief Tracks the pages accessed (read or written) in a region using the
+/// idle page tracking of Linux (/sys/kernel/mm/page_idle/bitmap), which
+/// requires CONFIG_IDLE_PAGE_TRACKING and CAP_SYS_ADMIN to read the page
+/// frame numbers in /proc/self/pagemap.
+/// mark_idle() sets the idle flags of the present pages; the kernel clears
+/// the flag of a page when the page is accessed.
+class page_idle_tracker {
+ public:
+  page_idle_tracker() {
+    m_fd = ::open("/sys/kernel/mm/page_idle/bitmap", O_RDWR);
+  }
+
+  ~page_idle_tracker() noexcept {
+    if (m_fd != -1) os_close(m_fd);
+  }
+
+  page_idle_tracker(const page_idle_tracker &) = delete;
+  page_idle_tracker &operator=(const page_idle_tracker &) = delete;
+
+  /// \brief Returns true if the idle page tracking is available.
+  bool good() const { return m_fd != -1; }
+
+  /// \brief Sets the idle flags of the present pages of a region.
+  /// \param addr The beginning of the region. Must be page aligned.
+  /// \param num_pages The number of pages.
+  /// \param page_size The system page size.
+  /// \return Returns false on error, e.g., the page frame numbers are not
+  /// readable.
+  bool mark_idle(const void *const addr, const std::size_t num_pages,
+                 const std::size_t page_size) {
+    std::vector<std::pair<uint64_t, std::size_t>> frames;
+    if (!priv_read_frames(addr, num_pages, page_size, &frames)) return false;
+    for (std::size_t i = 0; i < frames.size();) {
+      // Writing ones sets the flags; zeros do not change them
+      const auto word_no = frames[i].first / 64;
+      uint64_t word = 0;
+      for (; i < frames.size() && frames[i].first / 64 == word_no; ++i) {
+        word |= 1ULL << (frames[i].first % 64);
+      }
+      if (::pwrite(m_fd, &word, sizeof(word), word_no * sizeof(word)) !=
+          sizeof(word)) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "pwrite");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// \brief Finds the pages accessed since mark_idle(), i.e., the present
+  /// pages whose idle flags are cleared. The pages allocated after
+  /// mark_idle() are also taken as accessed.
+  /// \param addr The beginning of the region. Must be page aligned.
+  /// \param num_pages The number of pages.
+  /// \param page_size The system page size.
+  /// \param accessed A pointer to a vector to store a flag per page.
+  /// \return Returns false on error.
+  bool read_accessed(const void *const addr, const std::size_t num_pages,
+                     const std::size_t page_size,
+                     std::vector<bool> *const accessed) {
+    accessed->assign(num_pages, false);
+    std::vector<std::pair<uint64_t, std::size_t>> frames;
+    if (!priv_read_frames(addr, num_pages, page_size, &frames)) return false;
+    for (std::size_t i = 0; i < frames.size();) {
+      const auto word_no = frames[i].first / 64;
+      uint64_t word = 0;
+      if (::pread(m_fd, &word, sizeof(word), word_no * sizeof(word)) !=
+          sizeof(word)) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "pread");
+        return false;
+      }
+      for (; i < frames.size() && frames[i].first / 64 == word_no; ++i) {
+        (*accessed)[frames[i].second] =
+            !(word & (1ULL << (frames[i].first % 64)));
+      }
+    }
+    return true;
+  }
+
+ private:
+  static constexpr std::size_t k_read_batch_size = 4096;
+  static constexpr uint64_t k_pfn_mask = (1ULL << 55ULL) - 1;
+  static constexpr uint64_t k_present_bit = 1ULL << 63ULL;
+
+  /// \brief Reads the (page frame number, page index) of the present pages,
+  /// sorted by the page frame numbers.
+  bool priv_read_frames(
+      const void *const addr, const std::size_t num_pages,
+      const std::size_t page_size,
+      std::vector<std::pair<uint64_t, std::size_t>> *const frames) const {
+    if (!good()) return false;
+    pagemap_reader reader;
+    const uint64_t first_page_no = reinterpret_cast<uint64_t>(addr) / page_size;
+    std::vector<uint64_t> buf(std::min(num_pages, k_read_batch_size));
+    for (std::size_t p = 0; p < num_pages; p += buf.size()) {
+      const auto n = std::min(buf.size(), num_pages - p);
+      if (!reader.read(first_page_no + p, n, buf.data())) return false;
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!(buf[i] & k_present_bit)) continue;
+        const auto pfn = buf[i] & k_pfn_mask;
+        // The page frame numbers read as 0 without CAP_SYS_ADMIN
+        if (pfn == 0) return false;
+        frames->emplace_back(pfn, p + i);
+      }
+    }
+    std::sort(frames->begin(), frames->end());
+    return true;
+  }
+
+  int m_fd{-1};
+};
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_PAGE_IDLE_HPP
@@ -0,0 +1,76 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_PMEM_HPP
+#define METALL_DETAIL_PMEM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace metall::mtlldetail {
+
+/// \brief True if persist_cache_lines() writes back cache lines on this
+/// architecture.
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+inline constexpr bool k_cache_line_write_back_supported = true;
+#else
+inline constexpr bool k_cache_line_write_back_supported = false;
+#endif
+
+/// \brief Returns the smallest data cache line size, by which cache lines
+/// are written back.
+inline std::size_t cache_line_write_back_size() {
+#if defined(__aarch64__)
+  // DminLine of CTR_EL0 is log2 of the number of 4-byte words
+  uint64_t ctr = 0;
+  asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+  return std::size_t(4) << ((ctr >> 16U) & 0xFU);
+#else
+  return 64;
+#endif
+}
+
+/// \brief Writes back the CPU cache lines of a region to memory and waits
+/// for them, e.g., to make stores to persistent memory mapped with MAP_SYNC
+/// (DAX) durable without msync.
+/// Uses CLWB if compiled for it (e.g., -mclwb or -march=native), which keeps
+/// the lines cached; otherwise, CLFLUSHOPT or CLFLUSH, which evict them.
+/// Does nothing if !k_cache_line_write_back_supported.
+/// \param addr The beginning address of the region.
+/// \param length The length of the region.
+inline void persist_cache_lines([[maybe_unused]] const void *const addr,
+                                [[maybe_unused]] const std::size_t length) {
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+  if (length == 0) return;
+  const auto line_size = cache_line_write_back_size();
+  const auto begin = reinterpret_cast<uintptr_t>(addr) / line_size * line_size;
+  const auto end = reinterpret_cast<uintptr_t>(addr) + length;
+  for (auto line = begin; line < end; line += line_size) {
+    [[maybe_unused]] auto *const p = reinterpret_cast<void *>(line);
+#if defined(__CLWB__)
+    _mm_clwb(p);
+#elif defined(__CLFLUSHOPT__)
+    _mm_clflushopt(p);
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_clflush(p);
+#else
+    asm volatile("dc cvac, %0" : : "r"(p) : "memory");
+#endif
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_sfence();
+#else
+  asm volatile("dsb ish" : : : "memory");
+#endif
+#endif
+}
+
+}  // namespace metall::mtlldetail
+
+#endif  // METALL_DETAIL_PMEM_HPP
@@ -17,6 +17,11 @@
 
 #include <thread>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace metall::mtlldetail {
 
 /// \brief Returns the number of the logical CPU core on which the calling
@@ -40,6 +45,21 @@ inline unsigned int get_cpu_no() {
 #endif
 }
 
+/// \brief Returns the number of the NUMA node of the CPU on which the calling
+/// thread is currently executing.
+inline unsigned int get_numa_node_no() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == -1) {
+    return 0;
+  }
+  return node;
+#else
+  return 0;
+#endif
+}
+
 /// \brief Returns the number of the logical CPU cores on the system.
 inline unsigned int get_num_cpus() {
 #if SUPPORT_GET_CPU_NO
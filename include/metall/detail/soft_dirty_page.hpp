@@ -9,7 +9,11 @@
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <mutex>
 #include <metall/detail/memory.hpp>
+#include <metall/detail/mmap.hpp>
 #include <metall/logger.hpp>
 
 namespace metall::mtlldetail {
@@ -46,6 +50,141 @@ inline constexpr bool check_present_page(const uint64_t pagemap_value) {
   return (pagemap_value >> 63ULL) & 1ULL;
 }
 
+/// \brief Checks if the system tracks the soft-dirty bits, i.e., the kernel
+/// is built with CONFIG_MEM_SOFT_DIRTY and /proc/self/pagemap is readable.
+/// The result is computed once per process.
+inline bool soft_dirty_bit_supported() {
+  static const bool supported = []() {
+    const auto page_size = get_page_size();
+    if (page_size <= 0) return false;
+    auto *const map =
+        static_cast<char *>(map_anonymous_write_mode(nullptr, page_size));
+    if (!map) return false;
+    map[0] = 1;  // A page written after mapping must be soft-dirty
+    pagemap_reader reader;
+    const auto pagemap = reader.at(reinterpret_cast<uint64_t>(map) / page_size);
+    munmap(map, page_size, false);
+    return pagemap != pagemap_reader::error_value &&
+           check_soft_dirty_page(pagemap);
+  }();
+  return supported;
+}
+
+/// \brief Tracks the pages written in a memory region using the soft-dirty
+/// bits. As the soft-dirty bits are reset for the whole process at once,
+/// collect() gathers the dirty pages of every tracker in the process before
+/// resetting the bits so that a tracker does not lose the dirty pages of the
+/// others. Resetting the soft-dirty bits out of this class breaks the
+/// tracking.
+class soft_dirty_page_tracker {
+ public:
+  soft_dirty_page_tracker() {
+    std::lock_guard<std::mutex> guard(priv_registry().mutex);
+    priv_registry().trackers.push_back(this);
+  }
+
+  ~soft_dirty_page_tracker() noexcept {
+    std::lock_guard<std::mutex> guard(priv_registry().mutex);
+    auto &trackers = priv_registry().trackers;
+    trackers.erase(std::remove(trackers.begin(), trackers.end(), this),
+                   trackers.end());
+  }
+
+  soft_dirty_page_tracker(const soft_dirty_page_tracker &) = delete;
+  soft_dirty_page_tracker &operator=(const soft_dirty_page_tracker &) = delete;
+  soft_dirty_page_tracker(soft_dirty_page_tracker &&) = delete;
+  soft_dirty_page_tracker &operator=(soft_dirty_page_tracker &&) = delete;
+
+  /// \brief Sets the region to track.
+  /// The pages that have been tracked keep their dirty states;
+  /// the new pages are treated as clean.
+  /// \param addr The beginning of the region. Must be page aligned.
+  /// \param size The size of the region. Must be a multiple of 'page_size'.
+  /// \param page_size The system page size.
+  void track(const void *const addr, const std::size_t size,
+             const std::size_t page_size) {
+    std::lock_guard<std::mutex> guard(priv_registry().mutex);
+    if (addr != m_addr || page_size != m_page_size) {
+      m_dirty.clear();
+    }
+    m_addr = addr;
+    m_page_size = page_size;
+    m_dirty.resize((page_size > 0) ? size / page_size : 0, false);
+  }
+
+  /// \brief Stops tracking the region.
+  void untrack() { track(nullptr, 0, 0); }
+
+  /// \brief Gathers the dirty pages of all trackers and resets the
+  /// soft-dirty bits.
+  /// \return Returns false if the soft-dirty bits are not available.
+  bool collect() {
+    if (!soft_dirty_bit_supported()) return false;
+
+    std::lock_guard<std::mutex> guard(priv_registry().mutex);
+    pagemap_reader reader;
+    for (auto *const tracker : priv_registry().trackers) {
+      tracker->priv_collect_without_lock(&reader);
+    }
+    return reset_soft_dirty_bit();
+  }
+
+  /// \brief Calls 'func(offset, length)' for every run of the dirty pages
+  /// found by collect() and marks the pages clean.
+  /// The offsets are relative to the beginning of the region.
+  template <typename function_type>
+  void take_dirty_ranges(function_type func) {
+    std::lock_guard<std::mutex> guard(priv_registry().mutex);
+    for (std::size_t p = 0; p < m_dirty.size();) {
+      if (!m_dirty[p]) {
+        ++p;
+        continue;
+      }
+      const auto begin = p;
+      for (; p < m_dirty.size() && m_dirty[p]; ++p) {
+        m_dirty[p] = false;
+      }
+      func(begin * m_page_size, (p - begin) * m_page_size);
+    }
+  }
+
+ private:
+  static constexpr std::size_t k_read_batch_size = 4096;
+
+  struct registry {
+    std::mutex mutex;
+    std::vector<soft_dirty_page_tracker *> trackers;
+  };
+
+  static registry &priv_registry() {
+    static registry instance;
+    return instance;
+  }
+
+  void priv_collect_without_lock(pagemap_reader *const reader) {
+    if (m_dirty.empty()) return;
+
+    const uint64_t first_page_no =
+        reinterpret_cast<uint64_t>(m_addr) / m_page_size;
+    std::vector<uint64_t> buf(std::min(m_dirty.size(), k_read_batch_size));
+    for (std::size_t p = 0; p < m_dirty.size(); p += buf.size()) {
+      const auto n = std::min(buf.size(), m_dirty.size() - p);
+      if (!reader->read(first_page_no + p, n, buf.data())) {
+        // Cannot tell which pages are dirty
+        std::fill(m_dirty.begin(), m_dirty.end(), true);
+        return;
+      }
+      for (std::size_t i = 0; i < n; ++i) {
+        if (check_soft_dirty_page(buf[i])) m_dirty[p + i] = true;
+      }
+    }
+  }
+
+  const void *m_addr{nullptr};
+  std::size_t m_page_size{0};
+  std::vector<bool> m_dirty;
+};
+
 }  // namespace metall::mtlldetail
 
 #endif  // METALL_DETAIL_UTILITY_SOFT_DIRTY_PAGE_HPP
@@ -0,0 +1,229 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_DETAIL_ZSTD_FILE_HPP
+#define METALL_DETAIL_ZSTD_FILE_HPP
+
+#if defined(METALL_USE_ZSTD) && __has_include(<zstd.h>)
+#define METALL_ENABLE_ZSTD
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef METALL_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+
+/// \namespace metall::mtlldetail::zstd
+/// \brief Compresses and decompresses files with Zstandard.
+/// A compressed file consists of a header (a magic number, the original file
+/// size, and the chunk size) followed by the chunks of the original file.
+/// Each chunk is compressed independently and is stored with its compressed
+/// size. A chunk filled with zeros is stored as size 0 and is restored as a
+/// hole, keeping sparse files sparse.
+namespace metall::mtlldetail::zstd {
+
+namespace {
+namespace fs = std::filesystem;
+}
+
+constexpr uint64_t k_magic = 0x3154535a4c4c544dULL;  // "MTLLZST1"
+constexpr std::size_t k_chunk_size = 1ULL << 22ULL;
+constexpr std::size_t k_max_chunk_size = 1ULL << 30ULL;
+
+/// \brief Returns true if compression is available, i.e., Metall is built
+/// with METALL_USE_ZSTD and zstd.h.
+constexpr bool enabled() {
+#ifdef METALL_ENABLE_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+namespace zstddtl {
+inline bool all_zero(const char *const buf, const std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (buf[i] != 0) return false;
+  }
+  return true;
+}
+
+inline bool write_u64(std::ofstream &out, const uint64_t value) {
+  return bool(out.write(reinterpret_cast<const char *>(&value), sizeof(value)));
+}
+
+inline bool read_u64(std::ifstream &in, uint64_t *const value) {
+  return bool(in.read(reinterpret_cast<char *>(value), sizeof(*value)));
+}
+
+inline void log_error(const std::string &message, const fs::path &path) {
+  std::stringstream ss;
+  ss << message << ": " << path;
+  logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+}
+}  // namespace zstddtl
+
+/// \brief Compresses a file.
+/// \param source_path A path to the file to compress.
+/// \param destination_path A path to the compressed file to create.
+/// \param level The compression level of Zstandard.
+/// \return Returns true on success; otherwise, false.
+inline bool compress_file([[maybe_unused]] const fs::path &source_path,
+                          [[maybe_unused]] const fs::path &destination_path,
+                          [[maybe_unused]] const int level) {
+#ifdef METALL_ENABLE_ZSTD
+  const auto file_size = get_file_size(source_path);
+  if (file_size < 0) return false;
+
+  std::ifstream in(source_path, std::ios::binary);
+  std::ofstream out(destination_path, std::ios::binary | std::ios::trunc);
+  if (!in.is_open() || !out.is_open()) {
+    zstddtl::log_error("Failed to open a file to compress", source_path);
+    return false;
+  }
+
+  if (!zstddtl::write_u64(out, k_magic) ||
+      !zstddtl::write_u64(out, uint64_t(file_size)) ||
+      !zstddtl::write_u64(out, uint64_t(k_chunk_size))) {
+    zstddtl::log_error("Failed to write", destination_path);
+    return false;
+  }
+
+  std::vector<char> chunk(k_chunk_size);
+  std::vector<char> compressed(ZSTD_compressBound(k_chunk_size));
+  for (std::size_t offset = 0; offset < std::size_t(file_size);
+       offset += k_chunk_size) {
+    const auto size = std::min(k_chunk_size, file_size - offset);
+    if (!in.read(chunk.data(), size)) {
+      zstddtl::log_error("Failed to read", source_path);
+      return false;
+    }
+    if (zstddtl::all_zero(chunk.data(), size)) {
+      if (!zstddtl::write_u64(out, 0)) {
+        zstddtl::log_error("Failed to write", destination_path);
+        return false;
+      }
+      continue;
+    }
+    const auto ret = ZSTD_compress(compressed.data(), compressed.size(),
+                                   chunk.data(), size, level);
+    if (ZSTD_isError(ret)) {
+      std::string s("ZSTD_compress: " + std::string(ZSTD_getErrorName(ret)));
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (!zstddtl::write_u64(out, ret) || !out.write(compressed.data(), ret)) {
+      zstddtl::log_error("Failed to write", destination_path);
+      return false;
+    }
+  }
+
+  out.close();
+  if (!out) {
+    zstddtl::log_error("Failed to write", destination_path);
+    return false;
+  }
+  return fsync(destination_path);
+#else
+  logger::out(logger::level::error, __FILE__, __LINE__,
+              "Compression is not enabled (define METALL_USE_ZSTD)");
+  return false;
+#endif
+}
+
+/// \brief Decompresses a file compressed by compress_file().
+/// \param source_path A path to the compressed file.
+/// \param destination_path A path to the file to create.
+/// \return Returns true on success; otherwise, false.
+inline bool decompress_file([[maybe_unused]] const fs::path &source_path,
+                            [[maybe_unused]] const fs::path &destination_path) {
+#ifdef METALL_ENABLE_ZSTD
+  std::ifstream in(source_path, std::ios::binary);
+  if (!in.is_open()) {
+    zstddtl::log_error("Failed to open a file to decompress", source_path);
+    return false;
+  }
+
+  uint64_t magic = 0;
+  uint64_t file_size = 0;
+  uint64_t chunk_size = 0;
+  if (!zstddtl::read_u64(in, &magic) || magic != k_magic ||
+      !zstddtl::read_u64(in, &file_size) ||
+      !zstddtl::read_u64(in, &chunk_size) || chunk_size == 0 ||
+      chunk_size > k_max_chunk_size) {
+    zstddtl::log_error("Not a compressed file", source_path);
+    return false;
+  }
+
+  // Makes the file of the original size first so that zero chunks are holes
+  if (file_exist(destination_path) && !remove_file(destination_path)) {
+    return false;
+  }
+  if (!create_file(destination_path) ||
+      !extend_file_size(destination_path, file_size, false)) {
+    return false;
+  }
+  std::fstream out(destination_path,
+                   std::ios::binary | std::ios::in | std::ios::out);
+  if (!out.is_open()) {
+    zstddtl::log_error("Failed to open", destination_path);
+    return false;
+  }
+
+  std::vector<char> chunk(chunk_size);
+  std::vector<char> compressed;
+  for (uint64_t offset = 0; offset < file_size; offset += chunk_size) {
+    const auto size = std::min(chunk_size, file_size - offset);
+    uint64_t compressed_size = 0;
+    if (!zstddtl::read_u64(in, &compressed_size)) {
+      zstddtl::log_error("Truncated compressed file", source_path);
+      return false;
+    }
+    if (compressed_size == 0) continue;
+
+    compressed.resize(compressed_size);
+    if (!in.read(compressed.data(), compressed_size)) {
+      zstddtl::log_error("Truncated compressed file", source_path);
+      return false;
+    }
+    const auto ret = ZSTD_decompress(chunk.data(), size, compressed.data(),
+                                     compressed_size);
+    if (ZSTD_isError(ret) || ret != size) {
+      zstddtl::log_error("Broken compressed chunk", source_path);
+      return false;
+    }
+    out.seekp(offset);
+    if (!out.write(chunk.data(), size)) {
+      zstddtl::log_error("Failed to write", destination_path);
+      return false;
+    }
+  }
+
+  out.close();
+  if (!out) {
+    zstddtl::log_error("Failed to write", destination_path);
+    return false;
+  }
+  return fsync(destination_path);
+#else
+  logger::out(logger::level::error, __FILE__, __LINE__,
+              "Compression is not enabled (define METALL_USE_ZSTD)");
+  return false;
+#endif
+}
+
+}  // namespace metall::mtlldetail::zstd
+#endif  // METALL_DETAIL_ZSTD_FILE_HPP
@@ -14,6 +14,7 @@
 #include <dirent.h>
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <cassert>
 #include <filesystem>
@@ -106,7 +107,9 @@ class privateer_segment_storage {
         m_base_path(other.m_base_path),
         m_read_only(other.m_read_only),
         m_privateer(other.m_privateer),
-        m_privateer_version_name(other.m_privateer_version_name) {
+        m_privateer_version_name(other.m_privateer_version_name),
+        m_privateer_base_path(other.m_privateer_base_path),
+        m_stash_path(other.m_stash_path) {
     other.priv_reset();
   }
 
@@ -122,6 +125,8 @@ class privateer_segment_storage {
     m_read_only = std::move(other.m_read_only);
     m_privateer = std::move(other.m_privateer);
     m_privateer_version_name = std::move(other.m_privateer_version_name);
+    m_privateer_base_path = std::move(other.m_privateer_base_path);
+    m_stash_path = std::move(other.m_stash_path);
 
     other.priv_reset();
 
@@ -141,16 +146,36 @@ class privateer_segment_storage {
     return true;
   }
 
-  bool snapshot(std::string destination_path, const bool clone,
-                const int max_num_threads) {
-    sync(true);
-    auto path = parse_path(destination_path).first;
-    std::pair<std::string, std::string> parsed_path = priv_parse_path(path);
-    std::string version_path = parsed_path.second;
-    if (!m_privateer->snapshot(version_path.c_str())) {
+  /// \brief Takes a snapshot of the segment as a new Privateer version.
+  /// Privateer stores the blocks by their content; thus, the new version
+  /// shares the unchanged blocks with the current one and only the blocks
+  /// modified since the last sync are written.
+  /// The snapshot must be in the same Privateer datastore (and stash) as the
+  /// current segment.
+  /// \param destination_path A path to a snapshot.
+  /// \param clone Not used.
+  /// \param max_num_threads Not used.
+  /// \return Return true if success; otherwise, false.
+  bool snapshot(const path_type &destination_path,
+                [[maybe_unused]] const bool clone,
+                [[maybe_unused]] const int max_num_threads) {
+    if (!is_open()) return false;
+    if (!sync(true)) return false;
+
+    const auto base_stash_pair = parse_path(destination_path.string());
+    const auto parsed_path = priv_parse_path(base_stash_pair.first);
+    if (parsed_path.first != m_privateer_base_path ||
+        base_stash_pair.second != m_stash_path) {
+      std::string s("A snapshot must be in the same Privateer datastore: " +
+                    destination_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       return false;
     }
-    if (!copy(m_base_path, path, clone, max_num_threads)) {
+
+    if (!m_privateer->snapshot(parsed_path.second.c_str())) {
+      std::string s("Failed to make a new Privateer version: " +
+                    parsed_path.second);
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       return false;
     }
     return true;
@@ -203,8 +228,21 @@ class privateer_segment_storage {
     return true;
   }
 
-  bool extend(const std::size_t) {
-    // TODO: check errors
+  /// \brief Checks if the segment is large enough.
+  /// The whole capacity is mapped when the segment is created; thus, the
+  /// segment is never extended.
+  /// \param request_size A segment size to extend to.
+  /// \return Returns true if the segment is already larger than the requested
+  /// size. Returns false on failure.
+  bool extend(const std::size_t request_size) {
+    if (!priv_inited() || m_read_only) return false;
+    if (request_size > m_current_segment_size) {
+      std::stringstream ss;
+      ss << "Cannot extend a Privateer segment to " << request_size
+         << " bytes";
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
     return true;
   }
 
@@ -217,6 +255,8 @@ class privateer_segment_storage {
     std::string privateer_base_path = parsed_path.first;
     std::string version_path = parsed_path.second;
     m_privateer_version_name = version_path;
+    m_privateer_base_path = privateer_base_path;
+    m_stash_path = stash_dir;
     /* int action =
         std::filesystem::exists(std::filesystem::path(privateer_base_path))
             ? Privateer::OPEN
@@ -249,13 +289,23 @@ class privateer_segment_storage {
     return std::pair<std::string, std::string>(base_dir, stash_dir);
   }
 
-  void release() { priv_release(); }
+  bool release() {
+    priv_release();
+    return true;
+  }
 
-  void sync(const bool sync) { priv_sync_segment(sync); }
+  bool sync(const bool sync) {
+    priv_sync_segment(sync);
+    return true;
+  }
 
-  void free_region(const std::ptrdiff_t, const std::size_t) {
-    // Do nothing
-    // Privateer does not free file region
+  /// \brief Privateer cannot free a region as its blocks can be shared by
+  /// multiple versions.
+  /// \return Returns true if the region is in the segment; otherwise, false.
+  bool free_region(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    if (!priv_inited() || m_read_only) return false;
+    return offset >= 0 &&
+           static_cast<std::size_t>(offset) + nbytes <= m_current_segment_size;
   }
 
   void *get_segment() const { return m_segment; }
@@ -274,6 +324,24 @@ class privateer_segment_storage {
 
   bool read_only() const { return m_read_only; }
 
+  bool open_copy_on_write(const std::string &, const std::size_t) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The copy-on-write mode is not supported");
+    return false;
+  }
+
+  bool copy_on_write() const { return false; }
+
+  /// \brief Incremental snapshots are not supported.
+  /// \return Always returns false.
+  static bool resolve_snapshot_delta(const path_type &,
+                                     const std::vector<path_type> &,
+                                     const int) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Incremental snapshots are not supported");
+    return false;
+  }
+
   bool is_open() const { return !!m_privateer; }
 
   bool check_sanity() const {
@@ -303,6 +371,8 @@ class privateer_segment_storage {
     m_base_path.clear();
     m_privateer = nullptr;
     m_privateer_version_name.clear();
+    m_privateer_base_path.clear();
+    m_stash_path.clear();
   }
 
   bool priv_inited() const {
@@ -447,6 +517,8 @@ class privateer_segment_storage {
   bool m_read_only{false};
   mutable Privateer *m_privateer{nullptr};
   std::string m_privateer_version_name{};
+  std::string m_privateer_base_path{};
+  std::string m_stash_path{};
   std::mutex m_create_mutex{};
 };
 
@@ -0,0 +1,238 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_GLOBAL_STL_ALLOCATOR_HPP
+#define METALL_GLOBAL_STL_ALLOCATOR_HPP
+
+#include <memory>
+#include <type_traits>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/logger.hpp>
+
+namespace metall {
+
+namespace gsadtl {
+/// \brief The manager kernel global_stl_allocator allocates from.
+/// One per manager kernel type.
+template <typename manager_kernel_type>
+inline manager_kernel_type *g_manager_kernel = nullptr;
+}  // namespace gsadtl
+
+/// \brief Sets the manager kernel all global_stl_allocator objects of the
+/// kernel type allocate from, e.g., basic_manager::bind_global_allocator().
+/// Must be called after opening a datastore and before allocating with
+/// global_stl_allocator; set nullptr before closing the datastore.
+/// Not thread-safe with the allocations.
+/// \param manager_kernel The manager kernel.
+template <typename manager_kernel_type>
+inline void set_global_stl_allocator_kernel(
+    manager_kernel_type *const manager_kernel) noexcept {
+  gsadtl::g_manager_kernel<manager_kernel_type> = manager_kernel;
+}
+
+/// \brief Returns the manager kernel set by set_global_stl_allocator_kernel().
+template <typename manager_kernel_type>
+inline manager_kernel_type *get_global_stl_allocator_kernel() noexcept {
+  return gsadtl::g_manager_kernel<manager_kernel_type>;
+}
+
+/// \brief A STL compatible allocator that holds no state and allocates from
+/// the manager kernel set by set_global_stl_allocator_kernel().
+/// Unlike stl_allocator, which holds an offset pointer to the address of the
+/// manager kernel, this allocator is empty; thus, it adds no bytes to
+/// allocator-aware objects, e.g., each inner container of a
+/// vector<vector<T>>, and an allocation loads the kernel address from a
+/// global variable instead of following two pointers.
+/// Only one datastore of a manager kernel type can hold containers using this
+/// allocator at a time in a process.
+/// As the allocators always compare equal, containers using this allocator
+/// can be moved and swapped with each other without copying.
+/// \tparam T A object type.
+/// \tparam metall_manager_kernel_type A manager kernel type.
+/// \tparam void_pointer_type The void pointer type to derive the pointer type
+/// from.
+template <typename T, typename metall_manager_kernel_type,
+          typename void_pointer_type =
+              typename metall_manager_kernel_type::void_pointer>
+class global_stl_allocator {
+ public:
+  // -------------------- //
+  // Public types and static values
+  // -------------------- //
+  using value_type = T;
+  using pointer = typename std::pointer_traits<
+      void_pointer_type>::template rebind<value_type>;
+  using const_pointer =
+      typename std::pointer_traits<pointer>::template rebind<const value_type>;
+  using void_pointer =
+      typename std::pointer_traits<pointer>::template rebind<void>;
+  using const_void_pointer =
+      typename std::pointer_traits<pointer>::template rebind<const void>;
+  using difference_type =
+      typename std::pointer_traits<pointer>::difference_type;
+  using size_type = typename std::make_unsigned<difference_type>::type;
+  using manager_kernel_type = metall_manager_kernel_type;
+  using is_always_equal = std::true_type;
+
+  /// \brief Makes another allocator type for type T2
+  /// \tparam T2 The type of the object
+  template <typename T2>
+  struct rebind {
+    using other =
+        global_stl_allocator<T2, manager_kernel_type, void_pointer_type>;
+  };
+
+ public:
+  // -------------------- //
+  // Constructor & assign operator
+  // -------------------- //
+  global_stl_allocator() noexcept = default;
+
+  /// \brief Construct a new instance from an instance that has a different T
+  /// or pointer type
+  template <typename T2, typename void_pointer_type2>
+  global_stl_allocator(const global_stl_allocator<T2, manager_kernel_type,
+                                                  void_pointer_type2> &) noexcept {}
+
+  /// \brief Allocates n * sizeof(T) bytes of storage
+  /// \param n The size to allocation
+  /// \return Returns a pointer
+  pointer allocate(const size_type n) const { return priv_allocate(n); }
+
+  /// \brief Allocates n * sizeof(T) bytes of storage filled with zeros.
+  /// See stl_allocator::allocate_zeroed().
+  pointer allocate_zeroed(const size_type n) const {
+    return priv_allocate(n, true);
+  }
+
+  /// \brief Deallocates the storage reference by the pointer ptr
+  /// \param ptr A pointer to the storage
+  /// \param size The size of the storage, i.e., the number of elements given
+  /// to allocate()
+  void deallocate(pointer ptr, const size_type size) const noexcept {
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) {
+      priv_log_leak(size * sizeof(T));
+      return;
+    }
+    manager_kernel->deallocate(to_raw_pointer(ptr), size * sizeof(T));
+  }
+
+  /// \brief Allocates storage for 'n' objects of T at once.
+  /// See stl_allocator::allocate_many().
+  void allocate_many(const size_type n, pointer *const ptrs) const {
+    if (n == 0) return;
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) {
+      throw std::bad_alloc();
+    }
+
+    std::vector<void *> addrs(n);
+    const auto num_allocated =
+        manager_kernel->allocate_many(sizeof(T), n, addrs.data());
+    if (num_allocated != n) {
+      manager_kernel->deallocate_many(addrs.data(), num_allocated);
+      throw std::bad_alloc();
+    }
+    for (size_type i = 0; i < n; ++i) {
+      ptrs[i] = pointer(static_cast<value_type *>(addrs[i]));
+    }
+  }
+
+  /// \brief Deallocates storage allocated by allocate_many() or allocate(1).
+  void deallocate_many(const pointer *const ptrs, const size_type n) const {
+    if (n == 0) return;
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) {
+      priv_log_leak(n * sizeof(T));
+      return;
+    }
+
+    std::vector<void *> addrs(n);
+    for (size_type i = 0; i < n; ++i) {
+      addrs[i] = to_raw_pointer(ptrs[i]);
+    }
+    manager_kernel->deallocate_many(addrs.data(), n);
+  }
+
+  /// \brief The size of the theoretical maximum allocation size
+  /// \return The size of the theoretical maximum allocation size
+  size_type max_size() const noexcept {
+    return std::numeric_limits<size_type>::max() / sizeof(value_type);
+  }
+
+  /// \brief Constructs an object of T
+  /// \tparam Args The types of the constructor arguments
+  /// \param ptr A pointer to allocated storage
+  /// \param args The constructor arguments to use
+  template <class... Args>
+  void construct(const pointer &ptr, Args &&...args) const {
+    ::new ((void *)to_raw_pointer(ptr)) value_type(std::forward<Args>(args)...);
+  }
+
+  /// \brief Deconstruct an object of T
+  /// \param ptr A pointer to the object
+  void destroy(const pointer &ptr) const { (*ptr).~value_type(); }
+
+ private:
+  // -------------------- //
+  // Private methods
+  // -------------------- //
+  pointer priv_allocate(const size_type n, const bool zeroed = false) const {
+    if (max_size() < n) {
+      throw std::bad_array_new_length();
+    }
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) {
+      throw std::bad_alloc();
+    }
+
+    auto addr = pointer(static_cast<value_type *>(
+        zeroed ? manager_kernel->allocate_zeroed(n * sizeof(T))
+               : manager_kernel->allocate(n * sizeof(T))));
+    if (!addr) {
+      throw std::bad_alloc();
+    }
+    return addr;
+  }
+
+  /// \brief Returns the manager kernel. Returns nullptr on error.
+  static manager_kernel_type *priv_manager_kernel() noexcept {
+    auto *const manager_kernel =
+        get_global_stl_allocator_kernel<manager_kernel_type>();
+    if (!manager_kernel) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "nullptr: no manager kernel is set to global_stl_allocator");
+    }
+    return manager_kernel;
+  }
+
+  /// \brief Logs the storage that cannot be deallocated as no manager kernel
+  /// is set, e.g., the manager was destroyed before the containers.
+  static void priv_log_leak(const size_type nbytes) noexcept {
+    METALL_LOG(logger::level::error,
+               "Cannot deallocate " << nbytes << " bytes; they leak");
+  }
+};
+
+template <typename T, typename T2, typename kernel, typename void_pointer>
+inline bool operator==(const global_stl_allocator<T, kernel, void_pointer> &,
+                       const global_stl_allocator<T2, kernel, void_pointer> &) {
+  return true;
+}
+
+template <typename T, typename T2, typename kernel, typename void_pointer>
+inline bool operator!=(const global_stl_allocator<T, kernel, void_pointer> &,
+                       const global_stl_allocator<T2, kernel, void_pointer> &) {
+  return false;
+}
+
+}  // namespace metall
+
+#endif  // METALL_GLOBAL_STL_ALLOCATOR_HPP
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <type_traits>
 
 #include <metall/container/vector.hpp>
 #include <metall/container/scoped_allocator.hpp>
@@ -27,6 +28,9 @@ namespace jsndtl {
 template <typename allocator_type, typename other_array_type>
 inline bool general_array_equal(const array<allocator_type> &array,
                                 const other_array_type &other_array) noexcept {
+  if constexpr (std::is_same_v<other_array_type, json::array<allocator_type>>) {
+    if (&array == &other_array) return true;
+  }
   if (array.size() != other_array.size()) return false;
   return std::equal(array.begin(), array.end(), other_array.begin());
 }
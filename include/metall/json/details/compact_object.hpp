@@ -7,14 +7,18 @@
 #define METALL_JSON_DETAILS_COMPACT_OBJECT_HPP
 
 #include <iostream>
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <string_view>
 #include <algorithm>
+#include <type_traits>
 
 #include <metall/json/json_fwd.hpp>
 #include <metall/container/scoped_allocator.hpp>
 #include <metall/container/vector.hpp>
+#include <metall/container/unordered_map.hpp>
+#include <metall/offset_ptr.hpp>
 #include <metall/utility/hash.hpp>
 
 namespace metall::json::jsndtl {
@@ -34,10 +38,17 @@ bool general_compact_object_equal(
 
 /// \brief JSON object implementation.
 /// This class is designed to use a small amount of memory even sacrificing the
-/// look-up performance.
+/// look-up performance. Key-value pairs are stored in a vector in insertion
+/// order and small objects are searched linearly.
+/// Once an object holds k_index_threshold or more pairs, a hash index of the
+/// keys is built so that look-ups of large objects take constant time; the
+/// index is released when the object becomes small again.
 template <typename Alloc>
 class compact_object {
  public:
+  /// \brief The number of key-value pairs at which the hash index is built.
+  static constexpr std::size_t k_index_threshold = 32;
+
   using allocator_type = Alloc;
   using value_type =
       key_value_pair<char, std::char_traits<char>, allocator_type>;
@@ -58,6 +69,20 @@ class compact_object {
   // Value: the position of the corresponding item in the value_storage
   using value_postion_type = typename value_storage_type::size_type;
 
+  // Key: the hash value of the corresponding key in the value_storage
+  using index_key_type = uint64_t;
+  using index_table_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<std::pair<const index_key_type,
+                                                       value_postion_type>>;
+  using index_table_type =
+      mc::unordered_multimap<index_key_type, value_postion_type,
+                             metall::utility::hash<>, std::equal_to<>,
+                             index_table_allocator_type>;
+  using index_table_object_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<index_table_type>;
+  using index_table_pointer = typename std::allocator_traits<
+      index_table_object_allocator_type>::pointer;
+
  public:
   using iterator = typename value_storage_type::iterator;
   using const_iterator = typename value_storage_type::const_iterator;
@@ -71,29 +96,55 @@ class compact_object {
       : m_value_storage(alloc) {}
 
   /// \brief Copy constructor
-  compact_object(const compact_object &) = default;
+  compact_object(const compact_object &other)
+      : m_value_storage(other.m_value_storage) {
+    priv_rebuild_index();
+  }
 
   /// \brief Allocator-extended copy constructor
   compact_object(const compact_object &other, const allocator_type &alloc)
-      : m_value_storage(other.m_value_storage, alloc) {}
+      : m_value_storage(other.m_value_storage, alloc) {
+    priv_rebuild_index();
+  }
 
   /// \brief Move constructor
-  compact_object(compact_object &&) noexcept = default;
+  compact_object(compact_object &&other) noexcept
+      : m_value_storage(std::move(other.m_value_storage)),
+        m_index_table(other.m_index_table) {
+    other.m_index_table = nullptr;
+  }
 
   /// \brief Allocator-extended move constructor
-  compact_object(compact_object &&other, const allocator_type &alloc) noexcept
-      : m_value_storage(std::move(other.m_value_storage), alloc) {}
+  compact_object(compact_object &&other, const allocator_type &alloc)
+      : m_value_storage(std::move(other.m_value_storage), alloc) {
+    priv_take_index(other);
+  }
+
+  /// \brief Destructor
+  ~compact_object() noexcept { priv_destroy_index(); }
 
   /// \brief Copy assignment operator
-  compact_object &operator=(const compact_object &) = default;
+  compact_object &operator=(const compact_object &other) {
+    if (this == &other) return *this;
+    m_value_storage = other.m_value_storage;
+    priv_rebuild_index();
+    return *this;
+  }
 
   /// \brief Move assignment operator
-  compact_object &operator=(compact_object &&) noexcept = default;
+  compact_object &operator=(compact_object &&other) {
+    if (this == &other) return *this;
+    m_value_storage = std::move(other.m_value_storage);
+    priv_destroy_index();
+    priv_take_index(other);
+    return *this;
+  }
 
   /// \brief Swap contents.
   void swap(compact_object &other) noexcept {
     using std::swap;
     swap(m_value_storage, other.m_value_storage);
+    swap(m_index_table, other.m_index_table);
   }
 
   /// \brief Access a mapped value with a key.
@@ -220,11 +271,21 @@ class compact_object {
 
   /// \brief Return an allocator object.
   allocator_type get_allocator() const noexcept {
-    return m_value_storage.get_allovator();
+    return allocator_type(m_value_storage.get_allocator());
   }
 
  private:
   value_postion_type priv_locate_value(const key_type &key) const {
+    if (m_index_table) {
+      auto range = m_index_table->equal_range(priv_hash_key(key));
+      for (auto itr = range.first, end = range.second; itr != end; ++itr) {
+        if (m_value_storage[itr->second].key() == key) {
+          return itr->second;  // Found the key
+        }
+      }
+      return m_value_storage.max_size();  // Couldn't find
+    }
+
     for (value_postion_type i = 0; i < m_value_storage.size(); ++i) {
       if (m_value_storage[i].key() == key) {
         return i;  // Found the key
@@ -236,7 +297,13 @@ class compact_object {
   value_postion_type priv_emplace_value(const key_type &key,
                                         mapped_type &&mapped_value) {
     m_value_storage.emplace_back(key, std::move(mapped_value));
-    return m_value_storage.size() - 1;
+    const auto pos = m_value_storage.size() - 1;
+    if (m_index_table) {
+      m_index_table->emplace(priv_hash_key(key), pos);
+    } else if (m_value_storage.size() >= k_index_threshold) {
+      priv_rebuild_index();
+    }
+    return pos;
   }
 
   auto priv_erase(const_iterator value_position) {
@@ -244,11 +311,85 @@ class compact_object {
       return m_value_storage.end();
     }
 
+    if (m_index_table) {
+      if (m_value_storage.size() <= k_index_threshold / 2) {
+        // Small enough again; a linear search is fast and uses no memory.
+        priv_destroy_index();
+      } else {
+        priv_erase_from_index(value_position);
+      }
+    }
+
     // Finally, erase the value.
     return m_value_storage.erase(value_position);
   }
 
+  void priv_erase_from_index(const_iterator value_position) {
+    const auto erased_pos = static_cast<value_postion_type>(
+        std::distance(m_value_storage.cbegin(), value_position));
+    auto range =
+        m_index_table->equal_range(priv_hash_key(value_position->key()));
+    for (auto itr = range.first, end = range.second; itr != end; ++itr) {
+      if (itr->second == erased_pos) {
+        m_index_table->erase(itr);
+        break;
+      }
+    }
+
+    // Update the positions of the values that will be moved forward.
+    for (auto &elem : *m_index_table) {
+      if (elem.second > erased_pos) --elem.second;
+    }
+  }
+
+  static index_key_type priv_hash_key(const key_type &key) {
+    return metall::mtlldetail::murmur_hash_64a(key.data(), key.length(), 123);
+  }
+
+  /// \brief Takes over the index of 'other' if both share the allocator;
+  /// otherwise, builds a new one, as the items have been copied.
+  void priv_take_index(compact_object &other) {
+    if (other.m_index_table &&
+        other.m_index_table->get_allocator() ==
+            index_table_allocator_type(get_allocator())) {
+      m_index_table = other.m_index_table;
+      other.m_index_table = nullptr;
+      return;
+    }
+    other.priv_destroy_index();
+    priv_rebuild_index();
+  }
+
+  void priv_rebuild_index() {
+    priv_destroy_index();
+    if (m_value_storage.size() < k_index_threshold) return;
+
+    index_table_object_allocator_type alloc(get_allocator());
+    auto ptr =
+        std::allocator_traits<index_table_object_allocator_type>::allocate(
+            alloc, 1);
+    new (metall::to_raw_pointer(ptr))
+        index_table_type(index_table_allocator_type(get_allocator()));
+    m_index_table = ptr;
+
+    m_index_table->reserve(m_value_storage.size());
+    for (value_postion_type i = 0; i < m_value_storage.size(); ++i) {
+      m_index_table->emplace(priv_hash_key(m_value_storage[i].key()), i);
+    }
+  }
+
+  void priv_destroy_index() noexcept {
+    if (!m_index_table) return;
+    index_table_object_allocator_type alloc(get_allocator());
+    metall::to_raw_pointer(m_index_table)->~index_table_type();
+    std::allocator_traits<index_table_object_allocator_type>::deallocate(
+        alloc, m_index_table, 1);
+    m_index_table = nullptr;
+  }
+
   value_storage_type m_value_storage{allocator_type{}};
+  // Null while the object is small
+  index_table_pointer m_index_table{nullptr};
 };
 
 /// \brief Swap value instances.
@@ -264,10 +405,31 @@ template <typename allocator_type, typename other_object_type>
 inline bool general_compact_object_equal(
     const compact_object<allocator_type> &object,
     const other_object_type &other_object) noexcept {
+  if constexpr (std::is_same_v<other_object_type,
+                               compact_object<allocator_type>>) {
+    if (&object == &other_object) return true;
+  }
   if (object.size() != other_object.size()) return false;
 
+  // Objects made from the same source usually have the keys in the same
+  // order; thus, the pairs are compared in order, without looking up the keys,
+  // until a key differs. As the keys are unique and the sizes are the same,
+  // each pair only needs a matching pair in the other object.
+  auto other_itr = other_object.begin();
+  bool in_order = true;
   for (const auto &key_value : object) {
-    auto itr = other_object.find(key_value.key_c_str());
+    const auto key = key_value.key();
+    if (in_order) {
+      const auto other_key = other_itr->key();
+      if (key.length() == other_key.length() &&
+          std::memcmp(key.data(), other_key.data(), key.length()) == 0) {
+        if (key_value.value() != other_itr->value()) return false;
+        ++other_itr;
+        continue;
+      }
+      in_order = false;
+    }
+    auto itr = other_object.find(key);
     if (itr == other_object.end()) return false;
     if (key_value.value() != itr->value()) return false;
   }
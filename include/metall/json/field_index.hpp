@@ -0,0 +1,500 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_JSON_FIELD_INDEX_HPP
+#define METALL_JSON_FIELD_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <boost/container/vector.hpp>
+#include <boost/container/string.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <metall/json/json_fwd.hpp>
+#include <metall/json/query.hpp>
+#include <metall/container/btree_map.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/utility/hash.hpp>
+
+namespace metall::json {
+
+/// \brief The ID of a document in a field index.
+/// Usually, the position of the document in a vector of values or the ID of
+/// a vertex or an edge.
+using document_id_type = uint64_t;
+
+namespace jsndtl {
+
+/// \brief Takes the value at 'pointer' in 'document' as 'key_type', which is
+/// an arithmetic type or std::string_view.
+/// \return Returns false if there is no value or it has another type.
+template <typename key_type, typename allocator_type>
+inline bool get_field_key(const json_pointer &pointer,
+                          const value<allocator_type> &document,
+                          key_type *const key) {
+  const auto *const field = pointer.find(document);
+  if (!field) return false;
+  if constexpr (std::is_same_v<key_type, std::string_view>) {
+    if (!field->is_string()) return false;
+    *key = std::string_view(field->as_string().data(),
+                            field->as_string().size());
+    return true;
+  } else {
+    static_assert(std::is_arithmetic_v<key_type>,
+                  "Key type must be an arithmetic type or std::string_view");
+    if (field->is_int64()) {
+      *key = static_cast<key_type>(field->as_int64());
+    } else if (field->is_uint64()) {
+      *key = static_cast<key_type>(field->as_uint64());
+    } else if (field->is_double()) {
+      *key = static_cast<key_type>(field->as_double());
+    } else if (field->is_bool()) {
+      *key = static_cast<key_type>(field->as_bool());
+    } else {
+      return false;
+    }
+    return true;
+  }
+}
+
+/// \brief Holds the JSON Pointer of an indexed field in persistent memory.
+template <typename allocator_type>
+class field_pointer_holder {
+ private:
+  using char_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<char>;
+  using string_type =
+      boost::container::basic_string<char, std::char_traits<char>,
+                                     char_allocator_type>;
+
+ public:
+  field_pointer_holder(std::string_view field_pointer,
+                       const allocator_type &allocator)
+      : m_pointer(field_pointer.data(), field_pointer.size(),
+                  char_allocator_type(allocator)) {}
+
+  /// \brief Returns the JSON Pointer string.
+  std::string_view str() const {
+    return std::string_view(m_pointer.data(), m_pointer.size());
+  }
+
+  /// \brief Compiles the JSON Pointer.
+  /// A compiled pointer uses heap memory; thus, it is not stored.
+  json_pointer compile() const { return json_pointer(str()); }
+
+ private:
+  string_type m_pointer;
+};
+
+}  // namespace jsndtl
+
+/// \brief A persistent sorted index of a numeric field of JSON documents,
+/// e.g., a vector of values or the vertices of jgraph.
+/// The index is maintained by the user alongside the documents; it supports
+/// point and range look-ups without walking the documents.
+/// \tparam key_type An arithmetic type to hold the field values.
+/// \tparam allocator_type An allocator type.
+template <typename key_type,
+          typename allocator_type = std::allocator<std::byte>>
+class sorted_field_index {
+  static_assert(std::is_arithmetic_v<key_type>,
+                "Key type must be an arithmetic type");
+
+ private:
+  using entry_type = std::pair<key_type, document_id_type>;
+  using map_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<std::pair<const entry_type,
+                                                       uint8_t>>;
+  using map_type = metall::container::btree_map<entry_type, uint8_t,
+                                                std::less<entry_type>,
+                                                map_allocator_type>;
+
+ public:
+  using size_type = std::size_t;
+
+  /// \brief Constructor.
+  /// \param field_pointer A JSON Pointer to the field to index, e.g.,
+  /// "/user/age".
+  /// \param allocator An allocator object.
+  explicit sorted_field_index(
+      std::string_view field_pointer,
+      const allocator_type &allocator = allocator_type())
+      : m_pointer(field_pointer, allocator),
+        m_map(map_allocator_type(allocator)) {}
+
+  /// \brief Indexes a document.
+  /// If the same document is indexed more than once, it has to be erased
+  /// first. Compiles the JSON Pointer every time; use build() to index many
+  /// documents.
+  /// \return Returns false if the document does not have the field.
+  template <typename value_allocator_type>
+  bool insert(const document_id_type id,
+              const value<value_allocator_type> &document) {
+    return priv_insert(m_pointer.compile(), id, document);
+  }
+
+  /// \brief Removes a document that was indexed.
+  /// The document must not have been modified since it was indexed.
+  /// \return Returns true if it was removed.
+  template <typename value_allocator_type>
+  bool erase(const document_id_type id,
+             const value<value_allocator_type> &document) {
+    key_type key;
+    if (!jsndtl::get_field_key(m_pointer.compile(), document, &key)) {
+      return false;
+    }
+    return m_map.erase(entry_type(key, id)) > 0;
+  }
+
+  /// \brief Indexes a range of documents.
+  /// The ID of a document is its position in the range plus 'first_id'.
+  template <typename input_iterator>
+  void build(input_iterator first, input_iterator last,
+             document_id_type first_id = 0) {
+    const auto pointer = m_pointer.compile();
+    for (auto id = first_id; first != last; ++first, ++id) {
+      priv_insert(pointer, id, *first);
+    }
+  }
+
+  /// \brief Calls 'handler' with the ID of each document whose field is
+  /// 'key', in ascending order of the IDs.
+  template <typename handler_type>
+  void find(const key_type &key, handler_type &&handler) const {
+    find_range(key, key, [&handler](const key_type &,
+                                    const document_id_type id) {
+      handler(id);
+    });
+  }
+
+  /// \brief Calls 'handler' with each pair of the field value and the ID of
+  /// a document whose field is in [lower, upper], in ascending order of the
+  /// values.
+  /// \param handler A function that takes (const key_type &,
+  /// document_id_type).
+  template <typename handler_type>
+  void find_range(const key_type &lower, const key_type &upper,
+                  handler_type &&handler) const {
+    for (auto itr = m_map.lower_bound(entry_type(lower, 0));
+         itr != m_map.end() && !(upper < itr->first.first); ++itr) {
+      handler(itr->first.first, itr->first.second);
+    }
+  }
+
+  /// \brief Returns the number of documents whose field is 'key'.
+  size_type count(const key_type &key) const {
+    size_type n = 0;
+    find(key, [&n](document_id_type) { ++n; });
+    return n;
+  }
+
+  /// \brief Returns the number of indexed documents.
+  size_type size() const { return m_map.size(); }
+
+  /// \brief Returns the JSON Pointer of the indexed field.
+  std::string_view field_pointer() const { return m_pointer.str(); }
+
+  /// \brief Removes all entries.
+  void clear() { m_map.clear(); }
+
+ private:
+  template <typename value_allocator_type>
+  bool priv_insert(const json_pointer &pointer, const document_id_type id,
+                   const value<value_allocator_type> &document) {
+    key_type key;
+    if (!jsndtl::get_field_key(pointer, document, &key)) return false;
+    if (key != key) return false;  // NaN cannot be ordered
+    m_map.emplace(entry_type(key, id), 0);
+    return true;
+  }
+
+  jsndtl::field_pointer_holder<allocator_type> m_pointer;
+  map_type m_map;
+};
+
+/// \brief A persistent hash index of a string or numeric field of JSON
+/// documents for equality look-ups.
+/// Only the hash values of the keys are stored; a look-up confirms the
+/// candidates with the documents.
+/// \tparam key_type An arithmetic type or std::string_view.
+/// \tparam allocator_type An allocator type.
+template <typename key_type,
+          typename allocator_type = std::allocator<std::byte>>
+class hash_field_index {
+ private:
+  using hash_type = uint64_t;
+  using map_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<std::pair<const hash_type,
+                                                       document_id_type>>;
+  using map_type =
+      boost::unordered_multimap<hash_type, document_id_type,
+                                metall::utility::hash<>, std::equal_to<>,
+                                map_allocator_type>;
+
+ public:
+  using size_type = std::size_t;
+
+  /// \brief Constructor.
+  /// \param field_pointer A JSON Pointer to the field to index.
+  /// \param allocator An allocator object.
+  explicit hash_field_index(std::string_view field_pointer,
+                            const allocator_type &allocator = allocator_type())
+      : m_pointer(field_pointer, allocator),
+        m_map(map_allocator_type(allocator)) {}
+
+  /// \brief Indexes a document.
+  /// Compiles the JSON Pointer every time; use build() to index many
+  /// documents.
+  /// \return Returns false if the document does not have the field.
+  template <typename value_allocator_type>
+  bool insert(const document_id_type id,
+              const value<value_allocator_type> &document) {
+    return priv_insert(m_pointer.compile(), id, document);
+  }
+
+  /// \brief Removes a document that was indexed.
+  /// The document must not have been modified since it was indexed.
+  /// \return Returns true if it was removed.
+  template <typename value_allocator_type>
+  bool erase(const document_id_type id,
+             const value<value_allocator_type> &document) {
+    key_type key;
+    if (!jsndtl::get_field_key(m_pointer.compile(), document, &key)) {
+      return false;
+    }
+    auto range = m_map.equal_range(priv_hash(key));
+    for (auto itr = range.first; itr != range.second; ++itr) {
+      if (itr->second == id) {
+        m_map.erase(itr);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Indexes a range of documents.
+  /// The ID of a document is its position in the range plus 'first_id'.
+  template <typename input_iterator>
+  void build(input_iterator first, input_iterator last,
+             document_id_type first_id = 0) {
+    const auto pointer = m_pointer.compile();
+    for (auto id = first_id; first != last; ++first, ++id) {
+      priv_insert(pointer, id, *first);
+    }
+  }
+
+  /// \brief Calls 'handler' with the ID of each document whose field is
+  /// 'key'. The order is unspecified.
+  /// \param key A key to find.
+  /// \param get_document A function that takes a document ID and returns
+  /// the document (const value<...> &), to confirm the candidates.
+  /// \param handler A function that takes document_id_type.
+  template <typename document_getter_type, typename handler_type>
+  void find(const key_type &key, document_getter_type &&get_document,
+            handler_type &&handler) const {
+    const auto pointer = m_pointer.compile();
+    auto range = m_map.equal_range(priv_hash(key));
+    for (auto itr = range.first; itr != range.second; ++itr) {
+      key_type stored;
+      if (jsndtl::get_field_key(pointer, get_document(itr->second),
+                                &stored) &&
+          stored == key) {
+        handler(itr->second);
+      }
+    }
+  }
+
+  /// \brief Returns the number of indexed documents.
+  size_type size() const { return m_map.size(); }
+
+  /// \brief Returns the JSON Pointer of the indexed field.
+  std::string_view field_pointer() const { return m_pointer.str(); }
+
+  /// \brief Removes all entries.
+  void clear() { m_map.clear(); }
+
+ private:
+  static hash_type priv_hash(const key_type &key) {
+    if constexpr (std::is_same_v<key_type, std::string_view>) {
+      return metall::mtlldetail::murmur_hash_64a(key.data(), key.length(),
+                                                 123);
+    } else {
+      // 0.0 and -0.0 are the same key
+      const key_type normalized = (key == key_type(0)) ? key_type(0) : key;
+      return metall::mtlldetail::murmur_hash_64a(&normalized,
+                                                 sizeof(normalized), 123);
+    }
+  }
+
+  template <typename value_allocator_type>
+  bool priv_insert(const json_pointer &pointer, const document_id_type id,
+                   const value<value_allocator_type> &document) {
+    key_type key;
+    if (!jsndtl::get_field_key(pointer, document, &key)) return false;
+    m_map.emplace(priv_hash(key), id);
+    return true;
+  }
+
+  jsndtl::field_pointer_holder<allocator_type> m_pointer;
+  map_type m_map;
+};
+
+/// \brief A persistent columnar projection of a numeric field of JSON
+/// documents. The values are stored in a contiguous array indexed by the
+/// document ID so that filters and aggregations do not walk the documents.
+/// \tparam T An arithmetic type to hold the field values.
+/// \tparam allocator_type An allocator type.
+template <typename T, typename allocator_type = std::allocator<std::byte>>
+class numeric_column {
+  static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type");
+
+ private:
+  template <typename U>
+  using vector_type = boost::container::vector<
+      U, typename std::allocator_traits<allocator_type>::template rebind_alloc<
+             U>>;
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  /// \brief Constructor.
+  /// \param field_pointer A JSON Pointer to the field to project.
+  /// \param allocator An allocator object.
+  explicit numeric_column(std::string_view field_pointer,
+                          const allocator_type &allocator = allocator_type())
+      : m_pointer(field_pointer, allocator),
+        m_values(allocator),
+        m_present(allocator) {}
+
+  /// \brief Sets the value of a document.
+  /// The column grows to hold 'id'. If the document does not have the
+  /// field, the entry becomes empty.
+  /// \return Returns true if the document has the field.
+  template <typename value_allocator_type>
+  bool set(const document_id_type id,
+           const value<value_allocator_type> &document) {
+    return priv_set(m_pointer.compile(), id, document);
+  }
+
+  /// \brief Projects a range of documents.
+  /// The ID of a document is its position in the range plus 'first_id'.
+  template <typename input_iterator>
+  void build(input_iterator first, input_iterator last,
+             document_id_type first_id = 0) {
+    const auto pointer = m_pointer.compile();
+    for (auto id = first_id; first != last; ++first, ++id) {
+      priv_set(pointer, id, *first);
+    }
+  }
+
+  /// \brief Returns the number of entries, including empty ones.
+  size_type size() const { return m_values.size(); }
+
+  /// \brief Returns true if the document has a value.
+  bool has_value(const document_id_type id) const {
+    return id < m_present.size() && m_present[id];
+  }
+
+  /// \brief Returns the value of a document; 0 if empty.
+  value_type operator[](const document_id_type id) const {
+    return m_values[id];
+  }
+
+  /// \brief Returns the contiguous array of the values. The value of an
+  /// empty entry is 0.
+  const value_type *data() const { return m_values.data(); }
+
+  /// \brief Returns the number of non-empty entries.
+  size_type count() const {
+    return std::count(m_present.begin(), m_present.end(), uint8_t(1));
+  }
+
+  /// \brief Returns the sum of the values.
+  template <typename sum_type = std::conditional_t<
+                std::is_floating_point_v<value_type>, double,
+                std::conditional_t<std::is_signed_v<value_type>, int64_t,
+                                   uint64_t>>>
+  sum_type sum() const {
+    // Empty entries hold 0
+    sum_type total = 0;
+    for (const auto v : m_values) total += v;
+    return total;
+  }
+
+  /// \brief Returns the minimum value of the non-empty entries; the maximum
+  /// value of the type if none.
+  value_type min() const {
+    auto result = std::numeric_limits<value_type>::max();
+    for_each([&result](document_id_type, const value_type v) {
+      result = std::min(result, v);
+    });
+    return result;
+  }
+
+  /// \brief Returns the maximum value of the non-empty entries; the lowest
+  /// value of the type if none.
+  value_type max() const {
+    auto result = std::numeric_limits<value_type>::lowest();
+    for_each([&result](document_id_type, const value_type v) {
+      result = std::max(result, v);
+    });
+    return result;
+  }
+
+  /// \brief Calls 'handler' with (document_id_type, value_type) for each
+  /// non-empty entry in ascending order of the IDs.
+  template <typename handler_type>
+  void for_each(handler_type &&handler) const {
+    for (size_type i = 0; i < m_values.size(); ++i) {
+      if (m_present[i]) handler(document_id_type(i), m_values[i]);
+    }
+  }
+
+  /// \brief Returns the JSON Pointer of the projected field.
+  std::string_view field_pointer() const { return m_pointer.str(); }
+
+  /// \brief Removes all entries.
+  void clear() {
+    m_values.clear();
+    m_present.clear();
+  }
+
+ private:
+  template <typename value_allocator_type>
+  bool priv_set(const json_pointer &pointer, const document_id_type id,
+                const value<value_allocator_type> &document) {
+    if (id >= m_values.size()) {
+      m_values.resize(id + 1, value_type(0));
+      m_present.resize(id + 1, 0);
+    }
+    value_type v;
+    if (!jsndtl::get_field_key(pointer, document, &v)) {
+      m_values[id] = 0;
+      m_present[id] = 0;
+      return false;
+    }
+    m_values[id] = v;
+    m_present[id] = 1;
+    return true;
+  }
+
+  jsndtl::field_pointer_holder<allocator_type> m_pointer;
+  vector_type<value_type> m_values;
+  vector_type<uint8_t> m_present;
+};
+
+}  // namespace metall::json
+
+#endif  // METALL_JSON_FIELD_INDEX_HPP
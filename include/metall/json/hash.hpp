@@ -0,0 +1,252 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_JSON_HASH_HPP
+#define METALL_JSON_HASH_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include <metall/json/json_fwd.hpp>
+#include <metall/detail/hash.hpp>
+
+namespace metall::json {
+
+namespace {
+namespace bj = boost::json;
+}
+
+namespace jsndtl {
+
+/// \brief Memoized hashes of arrays and objects, keyed by their addresses.
+using hash_memo_type = std::unordered_map<const void *, std::uint64_t>;
+
+// The seeds that distinguish the kinds of values
+inline constexpr std::uint64_t k_null_hash_seed = 0x9e3779b97f4a7c15ULL;
+inline constexpr std::uint64_t k_bool_hash_seed = 0xc2b2ae3d27d4eb4fULL;
+inline constexpr std::uint64_t k_int_hash_seed = 0x165667b19e3779f9ULL;
+inline constexpr std::uint64_t k_uint_hash_seed = 0x27d4eb2f165667c5ULL;
+inline constexpr std::uint64_t k_double_hash_seed = 0x94d049bb133111ebULL;
+inline constexpr std::uint64_t k_string_hash_seed = 0xbf58476d1ce4e5b9ULL;
+inline constexpr std::uint64_t k_array_hash_seed = 0xd6e8feb86659fd93ULL;
+inline constexpr std::uint64_t k_object_hash_seed = 0xa0761d6478bd642fULL;
+
+inline std::uint64_t hash_mix(const std::uint64_t a,
+                              const std::uint64_t b) noexcept {
+  using namespace metall::mtlldetail::wyhdtl;
+  return wymix(a ^ k_secret[0], b ^ k_secret[1]);
+}
+
+/// \brief Hashes the contiguous buffer of a string or a key with wyhash.
+template <typename other_string_type>
+inline std::uint64_t general_string_hash(const other_string_type &string) {
+  return metall::mtlldetail::wyhash_64(
+      string.data(), string.size() * sizeof(*string.data()),
+      k_string_hash_seed);
+}
+
+template <typename other_value_type>
+std::uint64_t general_value_hash(const other_value_type &, hash_memo_type *);
+
+/// \brief Provides the structural hash of an array for array types that have
+/// the same interface as the array class.
+/// \param memo If not nullptr, the hash is looked up in and stored to it.
+template <typename other_array_type>
+inline std::uint64_t general_array_hash(const other_array_type &array,
+                                        hash_memo_type *const memo) {
+  if (memo) {
+    if (const auto itr = memo->find(&array); itr != memo->end()) {
+      return itr->second;
+    }
+  }
+  std::uint64_t hash = hash_mix(k_array_hash_seed, array.size());
+  for (const auto &item : array) {
+    hash = hash_mix(hash, general_value_hash(item, memo));
+  }
+  if (memo) memo->emplace(&array, hash);
+  return hash;
+}
+
+/// \brief Provides the structural hash of an object for object types that
+/// have the same interface as the object class.
+/// As objects are equal regardless of the order of their keys, the hashes of
+/// the key-value pairs are combined by addition.
+/// \param memo If not nullptr, the hash is looked up in and stored to it.
+template <typename other_object_type>
+inline std::uint64_t general_object_hash(const other_object_type &object,
+                                         hash_memo_type *const memo) {
+  if (memo) {
+    if (const auto itr = memo->find(&object); itr != memo->end()) {
+      return itr->second;
+    }
+  }
+  std::uint64_t sum = 0;
+  for (const auto &key_value : object) {
+    sum += hash_mix(general_string_hash(key_value.key()),
+                    general_value_hash(key_value.value(), memo));
+  }
+  const auto hash = hash_mix(hash_mix(k_object_hash_seed, object.size()), sum);
+  if (memo) memo->emplace(&object, hash);
+  return hash;
+}
+
+/// \brief Provides the structural hash of a value for value types that have
+/// the same interface as the value class, e.g., boost::json::value.
+/// Values equal by general_value_equal() have the same hash.
+/// \param memo If not nullptr, the hashes of the arrays and objects are
+/// looked up in and stored to it.
+template <typename other_value_type>
+inline std::uint64_t general_value_hash(const other_value_type &value,
+                                        hash_memo_type *const memo) {
+  if (value.is_null()) {
+    return hash_mix(k_null_hash_seed, 0);
+  } else if (value.is_bool()) {
+    return hash_mix(k_bool_hash_seed, value.as_bool());
+  } else if (value.is_int64()) {
+    // Equal to the uint64 value of the same number
+    const auto n = value.as_int64();
+    return hash_mix((n < 0) ? k_int_hash_seed : k_uint_hash_seed,
+                    static_cast<std::uint64_t>(n));
+  } else if (value.is_uint64()) {
+    return hash_mix(k_uint_hash_seed, value.as_uint64());
+  } else if (value.is_double()) {
+    double d = value.as_double();
+    if (d == 0.0) d = 0.0;  // -0.0 == 0.0
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return hash_mix(k_double_hash_seed, bits);
+  } else if (value.is_string()) {
+    return general_string_hash(value.as_string());
+  } else if (value.is_array()) {
+    return general_array_hash(value.as_array(), memo);
+  } else if (value.is_object()) {
+    return general_object_hash(value.as_object(), memo);
+  }
+
+  assert(false);
+  return 0;
+}
+
+}  // namespace jsndtl
+
+/// \brief Returns the structural hash of a JSON value, e.g., to find
+/// duplicate documents. Values equal by operator== have the same hash,
+/// including the Boost.JSON values equal to them: the keys of objects are
+/// hashed regardless of their order, and an int64 and a uint64 of the same
+/// number have the same hash.
+/// Strings are hashed over their contiguous buffers.
+/// \param value A JSON value to hash.
+/// \return A hash value.
+template <typename allocator_type>
+inline std::uint64_t hash_value(const value<allocator_type> &value) {
+  return jsndtl::general_value_hash(value, nullptr);
+}
+
+/// \brief Returns the structural hash of a JSON array.
+/// Equal to the hash of a value that holds the array.
+template <typename allocator_type>
+inline std::uint64_t hash_value(const array<allocator_type> &array) {
+  return jsndtl::general_array_hash(array, nullptr);
+}
+
+/// \brief Returns the structural hash of a JSON object.
+/// Equal to the hash of a value that holds the object.
+template <typename allocator_type>
+inline std::uint64_t hash_value(const object<allocator_type> &object) {
+  return jsndtl::general_object_hash(object, nullptr);
+}
+
+/// \brief Returns the structural hash of a Boost.JSON value, which is equal
+/// to the hash of the Metall JSON values equal to it.
+inline std::uint64_t hash_value(const bj::value &value) {
+  return jsndtl::general_value_hash(value, nullptr);
+}
+
+/// \brief Hashes JSON values, memoizing the hashes of the arrays and objects
+/// by their addresses. The arrays and objects hashed before are not
+/// traversed again, e.g., when documents and then their members are hashed
+/// to find duplicates at multiple levels, or when unchanged documents are
+/// hashed again to detect changes.
+/// The memoized hashes are not updated when the values are modified;
+/// call forget() with the modified arrays and objects and their ancestors, or
+/// clear().
+/// \tparam allocator_type An allocator type of the JSON values.
+template <typename allocator_type = std::allocator<std::byte>>
+class value_hasher {
+ public:
+  /// \brief Returns the hash of a value, which is equal to hash_value().
+  std::uint64_t operator()(const value<allocator_type> &value) {
+    return jsndtl::general_value_hash(value, &m_memo);
+  }
+
+  /// \brief Returns the hash of an array, which is equal to hash_value().
+  std::uint64_t operator()(const array<allocator_type> &array) {
+    return jsndtl::general_array_hash(array, &m_memo);
+  }
+
+  /// \brief Returns the hash of an object, which is equal to hash_value().
+  std::uint64_t operator()(const object<allocator_type> &object) {
+    return jsndtl::general_object_hash(object, &m_memo);
+  }
+
+  /// \brief Forgets the memoized hash of the array or object held by a
+  /// value. Does nothing for the other kinds of values.
+  void forget(const value<allocator_type> &value) {
+    if (value.is_array()) {
+      m_memo.erase(&value.as_array());
+    } else if (value.is_object()) {
+      m_memo.erase(&value.as_object());
+    }
+  }
+
+  /// \brief Forgets all memoized hashes.
+  void clear() { m_memo.clear(); }
+
+  /// \brief Returns the number of the memoized hashes.
+  std::size_t size() const { return m_memo.size(); }
+
+ private:
+  jsndtl::hash_memo_type m_memo;
+};
+
+}  // namespace metall::json
+
+namespace std {
+
+/// \brief Hashes a JSON value with metall::json::hash_value(), e.g., to put
+/// values in std::unordered_set to find duplicates.
+template <typename allocator_type>
+struct hash<metall::json::value<allocator_type>> {
+  std::size_t operator()(
+      const metall::json::value<allocator_type> &value) const {
+    return metall::json::hash_value(value);
+  }
+};
+
+/// \brief Hashes a JSON array with metall::json::hash_value().
+template <typename allocator_type>
+struct hash<metall::json::array<allocator_type>> {
+  std::size_t operator()(
+      const metall::json::array<allocator_type> &array) const {
+    return metall::json::hash_value(array);
+  }
+};
+
+/// \brief Hashes a JSON object with metall::json::hash_value().
+template <typename allocator_type>
+struct hash<metall::json::object<allocator_type>> {
+  std::size_t operator()(
+      const metall::json::object<allocator_type> &object) const {
+    return metall::json::hash_value(object);
+  }
+};
+
+}  // namespace std
+
+#endif  // METALL_JSON_HASH_HPP
@@ -19,6 +19,9 @@
 #include <metall/json/value_to.hpp>
 #include <metall/json/object.hpp>
 #include <metall/json/equal.hpp>
+#include <metall/json/hash.hpp>
+#include <metall/json/query.hpp>
+#include <metall/json/field_index.hpp>
 
 /// \example json_create.cpp
 /// This is an example of how to create a JSON object with Metall.
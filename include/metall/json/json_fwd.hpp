@@ -166,6 +166,17 @@ std::string serialize(const array<allocator_type> &);
 template <typename char_type, typename traits, typename allocator_type>
 std::string serialize(const basic_string<char_type, traits, allocator_type> &);
 
+template <typename json_type>
+std::ostream &serialize_to(std::ostream &, const json_type &,
+                           int indent_size = 0);
+
+template <typename json_type>
+std::size_t serialize_to(char *, std::size_t, const json_type &,
+                         int indent_size = 0);
+
+template <typename json_type>
+bool serialize_to_fd(int, const json_type &, int indent_size = 0);
+
 template <typename allocator_type>
 std::ostream &operator<<(std::ostream &, const value<allocator_type> &);
 
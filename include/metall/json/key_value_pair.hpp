@@ -11,6 +11,11 @@
 #include <string>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 
 #include <metall/offset_ptr.hpp>
 #include <metall/detail/utilities.hpp>
@@ -26,9 +31,12 @@ template <typename char_type, typename char_traits, typename allocator_type,
 inline bool general_key_value_pair_equal(
     const key_value_pair<char_type, char_traits, allocator_type> &key_value,
     const other_key_value_pair_type &other_key_value) noexcept {
-  if (key_value.key().length() != other_key_value.key().length())
-    return false;
-  if (std::strcmp(key_value.key_c_str(), other_key_value.key_c_str()) != 0)
+  const auto key = key_value.key();
+  const auto other_key = other_key_value.key();
+  if (key.length() != other_key.length()) return false;
+  if (!key.empty() &&
+      std::memcmp(key.data(), other_key.data(),
+                  key.length() * sizeof(char_type)) != 0)
     return false;
   return key_value.value() == other_key_value.value();
 }
@@ -84,44 +92,31 @@ class key_value_pair {
 
   /// \brief Copy constructor
   key_value_pair(const key_value_pair &other) : m_value(other.m_value) {
-    priv_allocate_key(other.key_c_str(), other.m_key_length,
+    priv_allocate_key(other.key_c_str(), other.priv_key_length(),
                       m_value.get_allocator());
   }
 
   /// \brief Allocator-extended copy constructor
   key_value_pair(const key_value_pair &other, const allocator_type &alloc)
       : m_value(other.m_value, alloc) {
-    priv_allocate_key(other.key_c_str(), other.m_key_length,
+    priv_allocate_key(other.key_c_str(), other.priv_key_length(),
                       m_value.get_allocator());
   }
 
   /// \brief Move constructor
   key_value_pair(key_value_pair &&other) noexcept
       : m_value(std::move(other.m_value)) {
-    if (other.priv_short_key()) {
-      m_short_key_buf = other.m_short_key_buf;
-    } else {
-      m_long_key = std::move(other.m_long_key);
-      other.m_long_key = nullptr;
-    }
-    m_key_length = other.m_key_length;
-    other.m_key_length = 0;
+    priv_take_key(other);
   }
 
   /// \brief Allocator-extended move constructor
   key_value_pair(key_value_pair &&other, const allocator_type &alloc) noexcept
       : m_value(alloc) {
     if (alloc == other.get_allocator()) {
-      if (other.priv_short_key()) {
-        m_short_key_buf = other.m_short_key_buf;
-      } else {
-        m_long_key = std::move(other.m_long_key);
-        other.m_long_key = nullptr;
-      }
-      m_key_length = other.m_key_length;
-      other.m_key_length = 0;
+      priv_take_key(other);
     } else {
-      priv_allocate_key(other.key_c_str(), other.m_key_length, get_allocator());
+      priv_allocate_key(other.key_c_str(), other.priv_key_length(),
+                        get_allocator());
       other.priv_deallocate_key(other.get_allocator());
     }
     m_value = std::move(other.m_value);
@@ -136,7 +131,8 @@ class key_value_pair {
     m_value = other.m_value;
     // This line has to come after copying m_value because m_value decides if
     // allocator is needed to be propagated.
-    priv_allocate_key(other.key_c_str(), other.m_key_length, get_allocator());
+    priv_allocate_key(other.key_c_str(), other.priv_key_length(),
+                      get_allocator());
 
     return *this;
   }
@@ -152,16 +148,10 @@ class key_value_pair {
     m_value = std::move(other.m_value);
 
     if (get_allocator() == other.get_allocator()) {
-      if (other.priv_short_key()) {
-        m_short_key_buf = other.m_short_key_buf;
-      } else {
-        m_long_key = std::move(other.m_long_key);
-        other.m_long_key = nullptr;
-      }
-      m_key_length = other.m_key_length;
-      other.m_key_length = 0;
+      priv_take_key(other);
     } else {
-      priv_allocate_key(other.key_c_str(), other.m_key_length, get_allocator());
+      priv_allocate_key(other.key_c_str(), other.priv_key_length(),
+                        get_allocator());
       other.priv_deallocate_key(other_allocator);
     }
 
@@ -180,12 +170,26 @@ class key_value_pair {
 
     using std::swap;
 
-    if (priv_short_key()) {
-      swap(m_short_key, other.m_short_key);
+    if (priv_short_key() && other.priv_short_key()) {
+      std::swap_ranges(m_short_key, m_short_key + k_key_buf_length,
+                       other.m_short_key);
+    } else if (priv_long_key() && other.priv_long_key()) {
+      char_type *const pointer = metall::to_raw_pointer(m_long_key);
+      const auto length = priv_long_key_length();
+      priv_set_long_key(metall::to_raw_pointer(other.m_long_key),
+                        other.priv_long_key_length());
+      other.priv_set_long_key(pointer, length);
     } else {
-      swap(m_long_key, other.m_long_key);
+      auto &short_one = priv_short_key() ? *this : other;
+      auto &long_one = priv_short_key() ? other : *this;
+      char_type *const pointer =
+          metall::to_raw_pointer(long_one.m_long_key);
+      const auto length = long_one.priv_long_key_length();
+      std::char_traits<char_type>::copy(long_one.m_short_key,
+                                        short_one.m_short_key,
+                                        k_key_buf_length);
+      short_one.priv_set_long_key(pointer, length);
     }
-    swap(m_key_length, other.m_key_length);
 
     swap(m_value, other.m_value);
   }
@@ -196,7 +200,7 @@ class key_value_pair {
   /// \brief Returns the stored key.
   /// \return Returns the stored key.
   const key_type key() const noexcept {
-    return key_type(key_c_str(), m_key_length);
+    return key_type(key_c_str(), priv_key_length());
   }
 
   /// \brief Returns the stored key as const char*.
@@ -235,8 +239,22 @@ class key_value_pair {
   }
 
  private:
-  static constexpr uint32_t k_short_key_max_length =
-      sizeof(char_pointer) - 1;  // -1 for '0'
+  // Keys are stored in a 16-byte buffer.
+  // A key shorter than the buffer is stored in it directly; its last element
+  // holds the number of unused elements, which becomes the terminating '\0'
+  // when the buffer is full. Otherwise, the buffer holds a pointer to the
+  // key and its length, and the last element is k_long_key_tag.
+  static constexpr std::size_t k_key_buf_length = 16 / sizeof(char_type);
+  static constexpr std::size_t k_short_key_max_length =
+      k_key_buf_length - 1;  // -1 for '\0'
+  static constexpr char_type k_long_key_tag = static_cast<char_type>(
+      std::numeric_limits<std::make_unsigned_t<char_type>>::max());
+
+  // The length of a long key is stored after the pointer
+  static constexpr std::size_t k_long_key_length_offset = sizeof(char_pointer);
+  static_assert(k_long_key_length_offset + sizeof(uint32_t) <=
+                    sizeof(char_type) * k_short_key_max_length,
+                "A long key overlaps the last element of the key buffer");
 
   const char_type *priv_key_c_str() const noexcept {
     if (priv_short_key()) {
@@ -246,56 +264,104 @@ class key_value_pair {
   }
 
   bool priv_short_key() const noexcept {
-    return (m_key_length <= k_short_key_max_length);
+    return m_short_key[k_short_key_max_length] != k_long_key_tag;
   }
 
   bool priv_long_key() const noexcept { return !priv_short_key(); }
 
+  size_type priv_key_length() const noexcept {
+    if (priv_short_key()) {
+      return k_short_key_max_length -
+             static_cast<size_type>(m_short_key[k_short_key_max_length]);
+    }
+    return priv_long_key_length();
+  }
+
+  uint32_t priv_long_key_length() const noexcept {
+    uint32_t length;
+    std::memcpy(&length,
+                reinterpret_cast<const char *>(m_short_key) +
+                    k_long_key_length_offset,
+                sizeof(length));
+    return length;
+  }
+
+  void priv_set_empty_key() noexcept {
+    std::char_traits<char_type>::assign(m_short_key[0], '\0');
+    m_short_key[k_short_key_max_length] =
+        static_cast<char_type>(k_short_key_max_length);
+  }
+
+  void priv_set_long_key(char_type *const pointer,
+                         const size_type length) noexcept {
+    m_long_key = pointer;
+    const auto length32 = static_cast<uint32_t>(length);
+    std::memcpy(reinterpret_cast<char *>(m_short_key) +
+                    k_long_key_length_offset,
+                &length32, sizeof(length32));
+    m_short_key[k_short_key_max_length] = k_long_key_tag;
+  }
+
+  /// \brief Takes the key of 'other' without allocating memory.
+  /// Other's key becomes empty.
+  void priv_take_key(key_value_pair &other) noexcept {
+    if (other.priv_short_key()) {
+      std::char_traits<char_type>::copy(m_short_key, other.m_short_key,
+                                        k_key_buf_length);
+    } else {
+      priv_set_long_key(metall::to_raw_pointer(other.m_long_key),
+                        other.priv_long_key_length());
+    }
+    other.priv_set_empty_key();
+  }
+
+  /// \brief Allocates a copy of 'key'.
+  /// \throw std::length_error if 'key' is longer than a long key can hold.
+  /// The key is left empty then. Keys copied from another key_value_pair
+  /// always fit.
   bool priv_allocate_key(const char_type *const key, const size_type length,
                          char_allocator_type alloc) {
-    assert(m_key_length == 0);
-    m_key_length = length;
-
-    if (priv_short_key()) {
-      std::char_traits<char_type>::copy(m_short_key, key, m_key_length);
-      std::char_traits<char_type>::assign(m_short_key[m_key_length], '\0');
+    if (length <= k_short_key_max_length) {
+      std::char_traits<char_type>::copy(m_short_key, key, length);
+      std::char_traits<char_type>::assign(m_short_key[length], '\0');
+      // Becomes '\0' if length == k_short_key_max_length
+      m_short_key[k_short_key_max_length] =
+          static_cast<char_type>(k_short_key_max_length - length);
     } else {
-      m_long_key = std::allocator_traits<char_allocator_type>::allocate(
-          alloc, m_key_length + 1);
-      if (!m_long_key) {
-        m_key_length = 0;
+      if (length > std::numeric_limits<uint32_t>::max()) {
+        priv_set_empty_key();
+        throw std::length_error("A JSON key is too long");
+      }
+      auto pointer = std::allocator_traits<char_allocator_type>::allocate(
+          alloc, length + 1);
+      if (!pointer) {
         std::abort();  // TODO: change
         return false;
       }
 
-      std::char_traits<char_type>::copy(metall::to_raw_pointer(m_long_key), key,
-                                        m_key_length);
-      std::char_traits<char_type>::assign(m_long_key[m_key_length], '\0');
+      std::char_traits<char_type>::copy(metall::to_raw_pointer(pointer), key,
+                                        length);
+      std::char_traits<char_type>::assign(pointer[length], '\0');
+      priv_set_long_key(metall::to_raw_pointer(pointer), length);
     }
 
     return true;
   }
 
   bool priv_deallocate_key(char_allocator_type alloc) {
-    if (m_key_length > k_short_key_max_length) {
-      std::allocator_traits<char_allocator_type>::deallocate(alloc, m_long_key,
-                                                             m_key_length + 1);
-      m_long_key = nullptr;
+    if (priv_long_key()) {
+      std::allocator_traits<char_allocator_type>::deallocate(
+          alloc, m_long_key, priv_long_key_length() + 1);
     }
-    m_key_length = 0;
+    priv_set_empty_key();
     return true;
   }
 
   union {
-    char_type m_short_key[k_short_key_max_length + 1];  // + 1 for '\0'
-    static_assert(sizeof(char_type) * (k_short_key_max_length + 1) <=
-                      sizeof(uint64_t),
-                  "sizeof(m_short_key) is bigger than sizeof(uint64_t)");
-    uint64_t m_short_key_buf;
-
-    char_pointer m_long_key{nullptr};
+    // Every constructor sets a key
+    char_type m_short_key[k_key_buf_length]{};
+    char_pointer m_long_key;
   };
-  size_type m_key_length{0};
 
   value_type m_value;
 };
@@ -6,18 +6,321 @@
 #ifndef METALL_JSON_PARSE_HPP
 #define METALL_JSON_PARSE_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <istream>
+#include <limits>
+#include <string>
 #include <string_view>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <metall/json/json_fwd.hpp>
 
+#include <boost/json/basic_parser.hpp>
+#if __has_include(<boost/json/basic_parser_impl.hpp>)
+// Required to instantiate basic_parser with a custom handler (Boost >= 1.76)
+#include <boost/json/basic_parser_impl.hpp>
+#endif
+
+#if defined(METALL_USE_SIMDJSON) && __has_include(<simdjson.h>)
+#define METALL_ENABLE_SIMDJSON
+#include <simdjson.h>
+#endif
+
 namespace metall::json {
 
 namespace {
 namespace bj = boost::json;
 }
 
+namespace jsndtl {
+
+/// \brief A handler of boost::json::basic_parser that constructs a value
+/// in place using the value's allocator, i.e., without building a
+/// boost::json::value first.
+/// String values are appended to their final location part by part.
+template <typename allocator_type>
+class value_builder {
+ public:
+  using value_type = value<allocator_type>;
+
+  static constexpr std::size_t max_object_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_array_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_key_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_string_size =
+      std::numeric_limits<std::size_t>::max();
+
+  /// \brief Sets the value to construct the next document into.
+  void reset(value_type *const root) {
+    m_root = root;
+    m_stack.clear();
+    m_key.clear();
+    m_string = nullptr;
+  }
+
+  bool on_document_begin(bj::error_code &) { return true; }
+  bool on_document_end(bj::error_code &) { return true; }
+
+  bool on_array_begin(bj::error_code &) {
+    auto &val = priv_next_value();
+    val.emplace_array();
+    m_stack.push_back(&val);
+    return true;
+  }
+
+  bool on_array_end(std::size_t, bj::error_code &) {
+    m_stack.pop_back();
+    return true;
+  }
+
+  bool on_object_begin(bj::error_code &) {
+    auto &val = priv_next_value();
+    val.emplace_object();
+    m_stack.push_back(&val);
+    return true;
+  }
+
+  bool on_object_end(std::size_t, bj::error_code &) {
+    m_stack.pop_back();
+    return true;
+  }
+
+  bool on_string_part(bj::string_view s, std::size_t, bj::error_code &) {
+    priv_string().append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_string(bj::string_view s, std::size_t, bj::error_code &) {
+    priv_string().append(s.data(), s.size());
+    m_string = nullptr;
+    return true;
+  }
+
+  bool on_key_part(bj::string_view s, std::size_t, bj::error_code &) {
+    m_key.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_key(bj::string_view s, std::size_t, bj::error_code &) {
+    m_key.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_number_part(bj::string_view, bj::error_code &) { return true; }
+
+  bool on_int64(std::int64_t i, bj::string_view, bj::error_code &) {
+    priv_next_value().emplace_int64() = i;
+    return true;
+  }
+
+  bool on_uint64(std::uint64_t u, bj::string_view, bj::error_code &) {
+    priv_next_value().emplace_uint64() = u;
+    return true;
+  }
+
+  bool on_double(double d, bj::string_view, bj::error_code &) {
+    priv_next_value().emplace_double() = d;
+    return true;
+  }
+
+  bool on_bool(bool b, bj::error_code &) {
+    priv_next_value().emplace_bool() = b;
+    return true;
+  }
+
+  bool on_null(bj::error_code &) {
+    priv_next_value().emplace_null();
+    return true;
+  }
+
+  bool on_comment_part(bj::string_view, bj::error_code &) { return true; }
+  bool on_comment(bj::string_view, bj::error_code &) { return true; }
+
+ private:
+  /// \brief Returns the value to store the next item.
+  /// Only the innermost container grows while its items are constructed;
+  /// thus, the pointers in the stack stay valid.
+  value_type &priv_next_value() {
+    if (m_stack.empty()) return *m_root;
+    auto &parent = *m_stack.back();
+    if (parent.is_array()) {
+      auto &arr = parent.as_array();
+      arr.resize(arr.size() + 1);
+      return arr[arr.size() - 1];
+    }
+    auto &val = parent.as_object()[m_key];
+    m_key.clear();
+    return val;
+  }
+
+  auto &priv_string() {
+    if (!m_string) m_string = &priv_next_value().emplace_string();
+    return *m_string;
+  }
+
+  value_type *m_root{nullptr};
+  std::vector<value_type *> m_stack;
+  std::string m_key;
+  typename value_type::string_type *m_string{nullptr};
+};
+
+/// \brief A streaming parser that constructs values with their allocators.
+template <typename allocator_type>
+class direct_parser {
+ public:
+  direct_parser() : m_parser(bj::parse_options{}) {}
+
+  /// \brief Parses a JSON document into 'out'.
+  /// \return Returns false on error; 'out' becomes null.
+  bool parse(std::string_view input, value<allocator_type> &out) {
+    m_parser.reset();
+    m_parser.handler().reset(&out);
+    const auto n =
+        m_parser.write_some(false, input.data(), input.size(), m_error);
+    if (!m_error && n < input.size()) m_error = bj::error::extra_data;
+    if (m_error) {
+      out.emplace_null();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Returns the error of the last parse.
+  const bj::error_code &error() const { return m_error; }
+
+  /// \brief Returns the error message of the last parse.
+  std::string error_message() const { return m_error.message(); }
+
+ private:
+  bj::basic_parser<value_builder<allocator_type>> m_parser;
+  bj::error_code m_error;
+};
+
+#ifdef METALL_ENABLE_SIMDJSON
+/// \brief A parser that parses JSON with simdjson and constructs values
+/// with their allocators from the parsed DOM.
+/// Provides the same interface as direct_parser.
+template <typename allocator_type>
+class simdjson_parser {
+ public:
+  using value_type = value<allocator_type>;
+
+  /// \brief Parses a JSON document into 'out'.
+  /// \return Returns false on error; 'out' becomes null.
+  bool parse(std::string_view input, value_type &out) {
+    // simdjson reads beyond the end of the input; as the input is usually a
+    // line of JSON Lines, copying it to a padded buffer is cheaper than
+    // allocating a padded copy every time.
+    if (m_buffer.capacity() < input.size() + simdjson::SIMDJSON_PADDING) {
+      m_buffer.reserve(input.size() + simdjson::SIMDJSON_PADDING);
+    }
+    m_buffer.assign(input.data(), input.size());
+
+    simdjson::dom::element root;
+    m_error = m_parser.parse(m_buffer.data(), m_buffer.size(), false).get(root);
+    if (m_error) {
+      out.emplace_null();
+      return false;
+    }
+    priv_build(root, out);
+    return true;
+  }
+
+  /// \brief Returns the error message of the last parse.
+  std::string error_message() const { return simdjson::error_message(m_error); }
+
+ private:
+  static void priv_build(const simdjson::dom::element &element,
+                         value_type &out) {
+    using simdjson::dom::element_type;
+    switch (element.type()) {
+      // value_unsafe() returns a reference into the temporary result; thus,
+      // the array and the object are copied (they are views of the DOM)
+      case element_type::ARRAY: {
+        const simdjson::dom::array source = element.get_array().value_unsafe();
+        auto &arr = out.emplace_array();
+        arr.resize(source.size());
+        std::size_t i = 0;
+        for (const auto child : source) {
+          priv_build(child, arr[i]);
+          ++i;
+        }
+        break;
+      }
+      case element_type::OBJECT: {
+        const simdjson::dom::object source =
+            element.get_object().value_unsafe();
+        auto &obj = out.emplace_object();
+        for (const auto field : source) {
+          priv_build(field.value, obj[field.key]);
+        }
+        break;
+      }
+      case element_type::INT64:
+        out.emplace_int64() = element.get_int64().value_unsafe();
+        break;
+      case element_type::UINT64:
+        out.emplace_uint64() = element.get_uint64().value_unsafe();
+        break;
+      case element_type::DOUBLE:
+        out.emplace_double() = element.get_double().value_unsafe();
+        break;
+      case element_type::STRING: {
+        const std::string_view str = element.get_string().value_unsafe();
+        out.emplace_string().assign(str.data(), str.size());
+        break;
+      }
+      case element_type::BOOL:
+        out.emplace_bool() = element.get_bool().value_unsafe();
+        break;
+      case element_type::NULL_VALUE:
+        out.emplace_null();
+        break;
+    }
+  }
+
+  simdjson::dom::parser m_parser;
+  std::string m_buffer;
+  simdjson::error_code m_error{simdjson::SUCCESS};
+};
+
+/// \brief The parser used by parse_into() and parse_lines().
+template <typename allocator_type>
+using bulk_parser = simdjson_parser<allocator_type>;
+#else
+/// \brief The parser used by parse_into() and parse_lines().
+template <typename allocator_type>
+using bulk_parser = direct_parser<allocator_type>;
+#endif
+
+}  // namespace jsndtl
+
+/// \brief Parses a JSON represented as a string into an existing value.
+/// The value is constructed directly with its allocator; no intermediate
+/// JSON value is built on the heap.
+/// Uses simdjson if METALL_USE_SIMDJSON is defined and simdjson.h is
+/// available.
+/// \tparam allocator_type An allocator type.
+/// \param input_json_string An input JSON string.
+/// \param out A value to store the result.
+/// \return Returns false on error; 'out' becomes null.
+template <typename allocator_type>
+inline bool parse_into(std::string_view input_json_string,
+                       value<allocator_type> &out) {
+  jsndtl::bulk_parser<allocator_type> parser;
+  if (!parser.parse(input_json_string, out)) {
+    std::cerr << "Failed to parse: " << parser.error_message() << std::endl;
+    return false;
+  }
+  return true;
+}
+
 /// \brief Parses a JSON represented as a string.
 /// \tparam allocator_type An allocator type.
 /// \param input_json_string An input JSON string.
@@ -34,14 +337,47 @@ inline value<allocator_type> parse(std::string_view input_json_string,
                                    const allocator_type &allocator)
 #endif
 {
-  bj::error_code ec;
-  auto bj_value = bj::parse(input_json_string.data(), ec);
-  if (ec) {
-    std::cerr << "Failed to parse: " << ec.message() << std::endl;
-    return value<allocator_type>{allocator};
-  }
+  value<allocator_type> out_value(allocator);
+  parse_into(input_json_string, out_value);
+  return out_value;
+}
 
-  return metall::json::value_from(std::move(bj_value), allocator);
+/// \brief Parses newline-delimited JSON (JSON Lines) from a stream.
+/// Each line is parsed directly into a value that uses 'allocator', which
+/// is then passed to 'line_handler'; e.g., the handler can move it into a
+/// container allocated with the same allocator without copying it.
+/// Empty lines are skipped. Lines that fail to parse are reported and
+/// skipped.
+/// Uses simdjson if METALL_USE_SIMDJSON is defined and simdjson.h is
+/// available.
+/// \tparam allocator_type An allocator type.
+/// \tparam line_handler_type A function type that takes value<allocator_type>
+/// &&.
+/// \param input An input stream.
+/// \param allocator An allocator object.
+/// \param line_handler A function called for each parsed line.
+/// \return Returns the number of lines parsed successfully.
+template <typename allocator_type, typename line_handler_type>
+inline std::size_t parse_lines(std::istream &input,
+                               const allocator_type &allocator,
+                               line_handler_type &&line_handler) {
+  jsndtl::bulk_parser<allocator_type> parser;
+  std::string line;
+  std::size_t line_no = 0;
+  std::size_t num_parsed = 0;
+  while (std::getline(input, line)) {
+    ++line_no;
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    value<allocator_type> out_value(allocator);
+    if (!parser.parse(line, out_value)) {
+      std::cerr << "Failed to parse line " << line_no << ": "
+                << parser.error_message() << std::endl;
+      continue;
+    }
+    line_handler(std::move(out_value));
+    ++num_parsed;
+  }
+  return num_parsed;
 }
 
 }  // namespace metall::json
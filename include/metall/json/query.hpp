@@ -0,0 +1,440 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_JSON_QUERY_HPP
+#define METALL_JSON_QUERY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <metall/json/json_fwd.hpp>
+
+namespace metall::json {
+
+/// \brief A compiled JSON Pointer (RFC 6901), e.g., "/store/book/0/title".
+/// A pointer is parsed once and can be evaluated against many values.
+class json_pointer {
+ public:
+  /// \brief Constructor. Constructs a pointer that refers to the root.
+  json_pointer() = default;
+
+  /// \brief Constructor. Compiles 'pointer'.
+  /// \param pointer A JSON Pointer string.
+  explicit json_pointer(std::string_view pointer) { compile(pointer); }
+
+  /// \brief Compiles a JSON Pointer.
+  /// \param pointer A JSON Pointer string. "" refers to the root.
+  /// \return Returns false if 'pointer' is invalid.
+  bool compile(std::string_view pointer) {
+    m_tokens.clear();
+    m_good = false;
+    if (pointer.empty()) {
+      m_good = true;
+      return true;
+    }
+    if (pointer.front() != '/') {
+      std::cerr << "JSON Pointer must start with '/': " << pointer
+                << std::endl;
+      return false;
+    }
+
+    std::size_t pos = 1;
+    while (true) {
+      const auto end = std::min(pointer.find('/', pos), pointer.size());
+      token_type token;
+      for (std::size_t i = pos; i < end; ++i) {
+        if (pointer[i] != '~') {
+          token.key.push_back(pointer[i]);
+          continue;
+        }
+        // "~0" is '~' and "~1" is '/'
+        if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+          token.key.push_back(pointer[i + 1] == '0' ? '~' : '/');
+          ++i;
+        } else {
+          std::cerr << "Invalid escape in JSON Pointer: " << pointer
+                    << std::endl;
+          return false;
+        }
+      }
+      token.is_index = priv_parse_index(token.key, &token.index);
+      m_tokens.push_back(std::move(token));
+      if (end == pointer.size()) break;
+      pos = end + 1;
+    }
+
+    m_good = true;
+    return true;
+  }
+
+  /// \brief Returns true if the pointer was compiled successfully.
+  bool good() const noexcept { return m_good; }
+
+  /// \brief Finds the value the pointer refers to.
+  /// \param root A JSON value to search.
+  /// \return A pointer to the value; nullptr if not found.
+  template <typename allocator_type>
+  const value<allocator_type> *find(const value<allocator_type> &root) const {
+    if (!m_good) return nullptr;
+    const value<allocator_type> *current = &root;
+    for (const auto &token : m_tokens) {
+      if (current->is_object()) {
+        const auto &obj = current->as_object();
+        const auto itr = obj.find(token.key);
+        if (itr == obj.end()) return nullptr;
+        current = &itr->value();
+      } else if (current->is_array()) {
+        const auto &arr = current->as_array();
+        if (!token.is_index || token.index >= arr.size()) return nullptr;
+        current = &arr[token.index];
+      } else {
+        return nullptr;
+      }
+    }
+    return current;
+  }
+
+  /// \brief Finds the value the pointer refers to.
+  /// \param root A JSON value to search.
+  /// \return A pointer to the value; nullptr if not found.
+  template <typename allocator_type>
+  value<allocator_type> *find(value<allocator_type> &root) const {
+    return const_cast<value<allocator_type> *>(
+        find(static_cast<const value<allocator_type> &>(root)));
+  }
+
+  /// \brief Calls 'handler' with the value the pointer refers to, if any.
+  /// Provides the same interface as json_path::for_each().
+  /// \param root A JSON value to search.
+  /// \param handler A function that takes const value<allocator_type> &.
+  template <typename allocator_type, typename handler_type>
+  void for_each(const value<allocator_type> &root,
+                handler_type &&handler) const {
+    if (const auto *const found = find(root)) handler(*found);
+  }
+
+ private:
+  struct token_type {
+    std::string key;
+    std::size_t index{0};
+    bool is_index{false};
+  };
+
+  /// \brief Array indices are "0" or digits without a leading zero.
+  static bool priv_parse_index(const std::string &key,
+                               std::size_t *const index) {
+    if (key.empty() || (key.size() > 1 && key[0] == '0')) return false;
+    std::size_t n = 0;
+    for (const char c : key) {
+      if (c < '0' || c > '9') return false;
+      n = n * 10 + (c - '0');
+    }
+    *index = n;
+    return true;
+  }
+
+  std::vector<token_type> m_tokens;
+  bool m_good{true};
+};
+
+/// \brief A compiled JSONPath expression, which supports a subset of
+/// JSONPath:
+/// the root '$', child names ('.name', ['name'], and ["name"]), array
+/// indices ([0] and [-1] for the last item), wildcards ('.*' and [*]), and
+/// the recursive descent ('..name' and '..*').
+/// Unlike json_pointer, a path can match multiple values.
+/// An expression is parsed once and can be evaluated against many values.
+class json_path {
+ public:
+  /// \brief Constructor. Constructs an expression that matches the root.
+  json_path() = default;
+
+  /// \brief Constructor. Compiles 'path'.
+  /// \param path A JSONPath expression.
+  explicit json_path(std::string_view path) { compile(path); }
+
+  /// \brief Compiles a JSONPath expression.
+  /// \param path A JSONPath expression, e.g., "$.store.book[*].title".
+  /// \return Returns false if 'path' is invalid or not supported.
+  bool compile(std::string_view path) {
+    m_steps.clear();
+    m_good = false;
+    if (path.empty() || path.front() != '$') {
+      return priv_report_error("Missing '$'", path);
+    }
+
+    std::size_t pos = 1;
+    while (pos < path.size()) {
+      if (path[pos] == '.') {
+        bool descendant = false;
+        ++pos;
+        if (pos < path.size() && path[pos] == '.') {
+          descendant = true;
+          ++pos;
+        }
+        if (pos < path.size() && path[pos] == '*') {
+          m_steps.push_back(step_type{
+              descendant ? step_kind::descendant_wildcard : step_kind::wildcard,
+              {},
+              0});
+          ++pos;
+          continue;
+        }
+        const auto end = std::min(path.find_first_of(".[", pos), path.size());
+        if (end == pos) return priv_report_error("Empty name", path);
+        m_steps.push_back(step_type{
+            descendant ? step_kind::descendant_key : step_kind::key,
+            std::string(path.substr(pos, end - pos)), 0});
+        pos = end;
+      } else if (path[pos] == '[') {
+        if (!priv_compile_bracket(path, &pos)) return false;
+      } else {
+        return priv_report_error("Unexpected character", path);
+      }
+    }
+
+    m_good = true;
+    return true;
+  }
+
+  /// \brief Returns true if the expression was compiled successfully.
+  bool good() const noexcept { return m_good; }
+
+  /// \brief Calls 'handler' with each value that matches the expression, in
+  /// document order.
+  /// \param root A JSON value to search.
+  /// \param handler A function that takes const value<allocator_type> &.
+  template <typename allocator_type, typename handler_type>
+  void for_each(const value<allocator_type> &root,
+                handler_type &&handler) const {
+    if (!m_good) return;
+    priv_evaluate(0, root, handler);
+  }
+
+  /// \brief Returns all values that match the expression.
+  /// \param root A JSON value to search.
+  /// \return Pointers to the matched values.
+  template <typename allocator_type>
+  std::vector<const value<allocator_type> *> find_all(
+      const value<allocator_type> &root) const {
+    std::vector<const value<allocator_type> *> matches;
+    for_each(root, [&matches](const value<allocator_type> &match) {
+      matches.push_back(&match);
+    });
+    return matches;
+  }
+
+ private:
+  enum class step_kind {
+    key,
+    index,
+    wildcard,
+    descendant_key,
+    descendant_wildcard
+  };
+
+  struct step_type {
+    step_kind kind;
+    std::string key;
+    int64_t index;
+  };
+
+  static bool priv_report_error(const char *const message,
+                                std::string_view path) {
+    std::cerr << message << " in JSONPath: " << path << std::endl;
+    return false;
+  }
+
+  /// \brief Compiles [N], [*], ['name'], or ["name"] at '*pos'.
+  bool priv_compile_bracket(std::string_view path, std::size_t *const pos) {
+    std::size_t p = *pos + 1;
+    if (p < path.size() && (path[p] == '\'' || path[p] == '"')) {
+      const char quote = path[p++];
+      std::string key;
+      for (; p < path.size() && path[p] != quote; ++p) {
+        if (path[p] == '\\' && p + 1 < path.size()) ++p;
+        key.push_back(path[p]);
+      }
+      if (p + 1 >= path.size() || path[p + 1] != ']') {
+        return priv_report_error("Unterminated name", path);
+      }
+      m_steps.push_back(step_type{step_kind::key, std::move(key), 0});
+      *pos = p + 2;
+      return true;
+    }
+
+    const auto end = path.find(']', p);
+    if (end == std::string_view::npos) {
+      return priv_report_error("Missing ']'", path);
+    }
+    const auto inside = path.substr(p, end - p);
+    if (inside == "*") {
+      m_steps.push_back(step_type{step_kind::wildcard, {}, 0});
+    } else {
+      std::size_t i = 0;
+      const bool negative = !inside.empty() && inside[0] == '-';
+      if (negative) ++i;
+      if (i == inside.size()) return priv_report_error("Empty index", path);
+      int64_t index = 0;
+      for (; i < inside.size(); ++i) {
+        if (inside[i] < '0' || inside[i] > '9') {
+          return priv_report_error("Unsupported selector", path);
+        }
+        index = index * 10 + (inside[i] - '0');
+      }
+      m_steps.push_back(
+          step_type{step_kind::index, {}, negative ? -index : index});
+    }
+    *pos = end + 1;
+    return true;
+  }
+
+  template <typename allocator_type, typename handler_type>
+  void priv_evaluate(const std::size_t step_no,
+                     const value<allocator_type> &current,
+                     handler_type &handler) const {
+    if (step_no == m_steps.size()) {
+      handler(current);
+      return;
+    }
+
+    const auto &step = m_steps[step_no];
+    switch (step.kind) {
+      case step_kind::key:
+        if (current.is_object()) {
+          const auto &obj = current.as_object();
+          const auto itr = obj.find(step.key);
+          if (itr != obj.end()) {
+            priv_evaluate(step_no + 1, itr->value(), handler);
+          }
+        }
+        break;
+      case step_kind::index:
+        if (current.is_array()) {
+          const auto &arr = current.as_array();
+          const auto size = static_cast<int64_t>(arr.size());
+          const auto index = (step.index < 0) ? size + step.index : step.index;
+          if (0 <= index && index < size) {
+            priv_evaluate(step_no + 1, arr[index], handler);
+          }
+        }
+        break;
+      case step_kind::wildcard:
+        priv_for_each_child(current, [&](const value<allocator_type> &child) {
+          priv_evaluate(step_no + 1, child, handler);
+        });
+        break;
+      case step_kind::descendant_key:
+      case step_kind::descendant_wildcard:
+        priv_evaluate_descendant(step_no, current, handler);
+        break;
+    }
+  }
+
+  /// \brief Applies a recursive descent step to 'current' and all values
+  /// under it.
+  template <typename allocator_type, typename handler_type>
+  void priv_evaluate_descendant(const std::size_t step_no,
+                                const value<allocator_type> &current,
+                                handler_type &handler) const {
+    const auto &step = m_steps[step_no];
+    if (step.kind == step_kind::descendant_key) {
+      if (current.is_object()) {
+        const auto &obj = current.as_object();
+        const auto itr = obj.find(step.key);
+        if (itr != obj.end()) {
+          priv_evaluate(step_no + 1, itr->value(), handler);
+        }
+      }
+    } else {
+      priv_for_each_child(current, [&](const value<allocator_type> &child) {
+        priv_evaluate(step_no + 1, child, handler);
+      });
+    }
+
+    priv_for_each_child(current, [&](const value<allocator_type> &child) {
+      priv_evaluate_descendant(step_no, child, handler);
+    });
+  }
+
+  template <typename allocator_type, typename function_type>
+  static void priv_for_each_child(const value<allocator_type> &current,
+                                  function_type &&function) {
+    if (current.is_object()) {
+      for (const auto &elem : current.as_object()) function(elem.value());
+    } else if (current.is_array()) {
+      for (const auto &elem : current.as_array()) function(elem);
+    }
+  }
+
+  std::vector<step_type> m_steps;
+  bool m_good{true};
+};
+
+/// \brief Evaluates a query against each value in a range in parallel.
+/// The values are read in place; e.g., the range can be a container of
+/// values stored in a Metall datastore.
+/// \tparam random_access_iterator A random access iterator type whose value
+/// type is metall::json::value.
+/// \tparam query_type json_pointer or json_path.
+/// \tparam handler_type A function type.
+/// \param first The beginning of the values.
+/// \param last The end of the values.
+/// \param query A compiled query.
+/// \param handler A function called for each match with the position of
+/// the value in the range and the matched value, i.e., (std::size_t,
+/// const value<allocator_type> &). Called from multiple threads
+/// concurrently; matches of the same value are passed by the same thread in
+/// document order.
+/// \param num_threads The number of threads to use. If <= 0 is given, the
+/// number of the hardware threads is used.
+template <typename random_access_iterator, typename query_type,
+          typename handler_type>
+inline void evaluate_batch(random_access_iterator first,
+                           random_access_iterator last,
+                           const query_type &query, handler_type &&handler,
+                           int num_threads = 0) {
+  const auto size = static_cast<std::size_t>(std::distance(first, last));
+  if (size == 0) return;
+  if (num_threads <= 0) {
+    num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+
+  // Distribute small chunks dynamically as document sizes vary
+  constexpr std::size_t k_chunk_size = 256;
+  std::atomic<std::size_t> next_chunk{0};
+  auto worker = [&]() {
+    while (true) {
+      const auto begin = next_chunk.fetch_add(k_chunk_size);
+      if (begin >= size) break;
+      const auto end = std::min(begin + k_chunk_size, size);
+      for (auto i = begin; i < end; ++i) {
+        const auto &root = *(first + i);
+        query.for_each(root, [&handler, i](const auto &match) {
+          handler(i, match);
+        });
+      }
+    }
+  };
+
+  num_threads = (int)std::min<std::size_t>(
+      num_threads, (size + k_chunk_size - 1) / k_chunk_size);
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) threads.emplace_back(worker);
+  worker();
+  for (auto &th : threads) th.join();
+}
+
+}  // namespace metall::json
+
+#endif  // METALL_JSON_QUERY_HPP
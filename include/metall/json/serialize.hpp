@@ -6,7 +6,17 @@
 #ifndef METALL_JSON_SERIALIZE_HPP
 #define METALL_JSON_SERIALIZE_HPP
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 #include <metall/container/string.hpp>
 #include <metall/json/json_fwd.hpp>
@@ -18,27 +28,346 @@ namespace mc = metall::container;
 namespace bj = boost::json;
 }  // namespace
 
+namespace jsndtl {
+
+/// \brief Writes JSON text directly from Metall JSON containers.
+/// The text is accumulated in a small fixed-size buffer and passed to 'sink'
+/// part by part; thus, the memory usage does not depend on the size of the
+/// document. The compact format is the same as boost::json::serialize().
+/// \tparam sink_type A function type that takes (const char *, std::size_t).
+template <typename sink_type>
+class json_writer {
+ public:
+  /// \brief Constructor.
+  /// \param sink A function that receives the written text.
+  /// \param indent_size The size of the indent when going to a lower layer.
+  /// If 0 or less, no whitespace is written.
+  json_writer(sink_type &sink, const int indent_size)
+      : m_sink(sink), m_indent_size(indent_size) {}
+
+  json_writer(const json_writer &) = delete;
+  json_writer &operator=(const json_writer &) = delete;
+
+  template <typename allocator_type>
+  void write(const value<allocator_type> &jv) {
+    if (jv.is_null()) {
+      priv_put("null", 4);
+    } else if (jv.is_bool()) {
+      jv.as_bool() ? priv_put("true", 4) : priv_put("false", 5);
+    } else if (jv.is_int64()) {
+      priv_write_integer(jv.as_int64());
+    } else if (jv.is_uint64()) {
+      priv_write_integer(jv.as_uint64());
+    } else if (jv.is_double()) {
+      priv_write_double(jv.as_double());
+    } else if (jv.is_string()) {
+      write(jv.as_string());
+    } else if (jv.is_array()) {
+      write(jv.as_array());
+    } else if (jv.is_object()) {
+      write(jv.as_object());
+    }
+  }
+
+  template <typename allocator_type>
+  void write(const object<allocator_type> &obj) {
+    priv_put('{');
+    if (obj.size() > 0) {
+      ++m_depth;
+      bool first = true;
+      for (const auto &elem : obj) {
+        if (!first) priv_put(',');
+        first = false;
+        priv_write_new_line();
+        priv_write_string(elem.key().data(), elem.key().length());
+        priv_put(':');
+        if (m_indent_size > 0) priv_put(' ');
+        write(elem.value());
+      }
+      --m_depth;
+      priv_write_new_line();
+    }
+    priv_put('}');
+  }
+
+  template <typename allocator_type>
+  void write(const array<allocator_type> &arr) {
+    priv_put('[');
+    if (arr.size() > 0) {
+      ++m_depth;
+      for (std::size_t i = 0; i < arr.size(); ++i) {
+        if (i > 0) priv_put(',');
+        priv_write_new_line();
+        write(arr[i]);
+      }
+      --m_depth;
+      priv_write_new_line();
+    }
+    priv_put(']');
+  }
+
+  template <typename char_type, typename traits, typename allocator_type>
+  void write(const basic_string<char_type, traits, allocator_type> &str) {
+    priv_write_string(str.data(), str.size());
+  }
+
+  /// \brief Passes the buffered text to the sink.
+  /// Must be called after the last write().
+  void flush() {
+    if (m_length == 0) return;
+    m_sink(m_buffer, m_length);
+    m_length = 0;
+  }
+
+ private:
+  static constexpr std::size_t k_buffer_size = 4096;
+
+  void priv_put(const char c) {
+    if (m_length == k_buffer_size) flush();
+    m_buffer[m_length++] = c;
+  }
+
+  void priv_put(const char *data, std::size_t length) {
+    while (length > 0) {
+      if (m_length == k_buffer_size) flush();
+      const auto n = std::min(length, k_buffer_size - m_length);
+      std::memcpy(m_buffer + m_length, data, n);
+      m_length += n;
+      data += n;
+      length -= n;
+    }
+  }
+
+  void priv_write_new_line() {
+    if (m_indent_size <= 0) return;
+    priv_put('\n');
+    for (std::size_t i = 0; i < m_depth * m_indent_size; ++i) priv_put(' ');
+  }
+
+  void priv_write_string(const char *const data, const std::size_t length) {
+    static constexpr char k_hex[] = "0123456789abcdef";
+    priv_put('"');
+    std::size_t begin = 0;  // The beginning of the chars to copy as is
+    for (std::size_t i = 0; i < length; ++i) {
+      const auto c = static_cast<unsigned char>(data[i]);
+      if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+      priv_put(data + begin, i - begin);
+      begin = i + 1;
+      priv_put('\\');
+      switch (c) {
+        case '"':
+          priv_put('"');
+          break;
+        case '\\':
+          priv_put('\\');
+          break;
+        case '\b':
+          priv_put('b');
+          break;
+        case '\f':
+          priv_put('f');
+          break;
+        case '\n':
+          priv_put('n');
+          break;
+        case '\r':
+          priv_put('r');
+          break;
+        case '\t':
+          priv_put('t');
+          break;
+        default:
+          const char code[] = {'u', '0', '0', k_hex[c >> 4U], k_hex[c & 0xFU]};
+          priv_put(code, sizeof(code));
+      }
+    }
+    priv_put(data + begin, length - begin);
+    priv_put('"');
+  }
+
+  template <typename integer_type>
+  void priv_write_integer(const integer_type n) {
+    char buf[24];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), n);
+    priv_put(buf, result.ptr - buf);
+  }
+
+  /// \brief Writes a double value in the same format as Boost.JSON, e.g.,
+  /// 1.5E2. Writes 1e99999 for an infinity and null for NaN, as JSON has
+  /// no representation for them.
+  void priv_write_double(const double d) {
+    if (std::isnan(d)) {
+      priv_put("null", 4);
+      return;
+    }
+    if (std::isinf(d)) {
+      (d < 0) ? priv_put("-1e99999", 8) : priv_put("1e99999", 7);
+      return;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Shortest representation that round-trips, e.g., 1.5e+02
+    char buf[32];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), d,
+                                      std::chars_format::scientific);
+    const char *const end = result.ptr;
+    const char *const e = std::find(static_cast<const char *>(buf), end, 'e');
+    priv_put(buf, e - buf);
+    priv_put('E');
+    const char *exp = e + 1;
+    if (*exp == '+') {
+      ++exp;
+    } else if (*exp == '-') {
+      priv_put('-');
+      ++exp;
+    }
+    while (exp < end - 1 && *exp == '0') ++exp;
+    priv_put(exp, end - exp);
+#else
+    char buf[32];
+    const int n = std::snprintf(buf, sizeof(buf), "%.17g", d);
+    priv_put(buf, n);
+#endif
+  }
+
+  sink_type &m_sink;
+  const int m_indent_size;
+  std::size_t m_depth{0};
+  std::size_t m_length{0};
+  char m_buffer[k_buffer_size];
+};
+
+template <typename json_type>
+inline std::string serialize_to_string(const json_type &input) {
+  std::string out;
+  auto sink = [&out](const char *data, const std::size_t length) {
+    out.append(data, length);
+  };
+  json_writer<decltype(sink)> writer(sink, 0);
+  writer.write(input);
+  writer.flush();
+  return out;
+}
+
+}  // namespace jsndtl
+
+/// \brief Writes a JSON value, object, array, or string to an output stream
+/// without constructing an intermediate object or string.
+/// \tparam json_type A JSON type.
+/// \param os An output stream object.
+/// \param input A JSON data to write.
+/// \param indent_size If greater than 0, pretty-prints the JSON with the
+/// indent size.
+/// \return Returns 'os'.
+#ifdef DOXYGEN_SKIP
+template <typename json_type>
+inline std::ostream &serialize_to(std::ostream &os, const json_type &input,
+                                  const int indent_size = 0)
+#else
+template <typename json_type>
+inline std::ostream &serialize_to(std::ostream &os, const json_type &input,
+                                  const int indent_size)
+#endif
+{
+  auto sink = [&os](const char *data, const std::size_t length) {
+    os.write(data, length);
+  };
+  jsndtl::json_writer<decltype(sink)> writer(sink, indent_size);
+  writer.write(input);
+  writer.flush();
+  return os;
+}
+
+/// \brief Writes a JSON value, object, array, or string to a buffer, like
+/// snprintf(); no terminating null character is written.
+/// \tparam json_type A JSON type.
+/// \param buffer A buffer to write.
+/// \param size The size of 'buffer'. The text after 'size' characters is
+/// discarded.
+/// \param input A JSON data to write.
+/// \param indent_size If greater than 0, pretty-prints the JSON with the
+/// indent size.
+/// \return Returns the length of the whole text.
+/// If it is greater than 'size', the text in 'buffer' is truncated.
+#ifdef DOXYGEN_SKIP
+template <typename json_type>
+inline std::size_t serialize_to(char *buffer, std::size_t size,
+                                const json_type &input,
+                                const int indent_size = 0)
+#else
+template <typename json_type>
+inline std::size_t serialize_to(char *buffer, const std::size_t size,
+                                const json_type &input, const int indent_size)
+#endif
+{
+  std::size_t total_length = 0;
+  auto sink = [buffer, size, &total_length](const char *data,
+                                            const std::size_t length) {
+    if (total_length < size) {
+      std::memcpy(buffer + total_length, data,
+                  std::min(length, size - total_length));
+    }
+    total_length += length;
+  };
+  jsndtl::json_writer<decltype(sink)> writer(sink, indent_size);
+  writer.write(input);
+  writer.flush();
+  return total_length;
+}
+
+/// \brief Writes a JSON value, object, array, or string to a file
+/// descriptor, e.g., an opened file or a pipe.
+/// \tparam json_type A JSON type.
+/// \param fd A file descriptor to write.
+/// \param input A JSON data to write.
+/// \param indent_size If greater than 0, pretty-prints the JSON with the
+/// indent size.
+/// \return Returns true on success; otherwise, false.
+#ifdef DOXYGEN_SKIP
+template <typename json_type>
+inline bool serialize_to_fd(int fd, const json_type &input,
+                            const int indent_size = 0)
+#else
+template <typename json_type>
+inline bool serialize_to_fd(const int fd, const json_type &input,
+                            const int indent_size)
+#endif
+{
+  bool good = true;
+  auto sink = [fd, &good](const char *data, std::size_t length) {
+    while (good && length > 0) {
+      const auto ret = ::write(fd, data, length);
+      if (ret == -1) {
+        if (errno == EINTR) continue;
+        std::cerr << "Failed to write JSON: " << std::strerror(errno)
+                  << std::endl;
+        good = false;
+        break;
+      }
+      data += ret;
+      length -= ret;
+    }
+  };
+  jsndtl::json_writer<decltype(sink)> writer(sink, indent_size);
+  writer.write(input);
+  writer.flush();
+  return good;
+}
+
 template <typename allocator_type>
 std::string serialize(const value<allocator_type> &input) {
-  return bj::serialize(value_to<bj::value>(input));
+  return jsndtl::serialize_to_string(input);
 }
 
 template <typename allocator_type>
 std::string serialize(const object<allocator_type> &input) {
-  bj::object object;
-  for (const auto &elem : input) {
-    object[elem.key().data()] = value_to<bj::value>(elem.value());
-  }
-  return bj::serialize(object);
+  return jsndtl::serialize_to_string(input);
 }
 
 template <typename allocator_type>
 std::string serialize(const array<allocator_type> &input) {
-  bj::array array;
-  for (const auto &elem : input) {
-    array.emplace_back(value_to<bj::value>(elem));
-  }
-  return bj::serialize(array);
+  return jsndtl::serialize_to_string(input);
 }
 
 template <typename char_type, typename traits, typename allocator_type>
@@ -49,20 +378,17 @@ std::string serialize(
 
 template <typename allocator_type>
 std::ostream &operator<<(std::ostream &os, const value<allocator_type> &val) {
-  os << serialize(val);
-  return os;
+  return serialize_to(os, val, 0);
 }
 
 template <typename allocator_type>
 std::ostream &operator<<(std::ostream &os, const object<allocator_type> &obj) {
-  os << serialize(obj);
-  return os;
+  return serialize_to(os, obj, 0);
 }
 
 template <typename allocator_type>
 std::ostream &operator<<(std::ostream &os, const array<allocator_type> &arr) {
-  os << serialize(arr);
-  return os;
+  return serialize_to(os, arr, 0);
 }
 
 }  // namespace metall::json
@@ -12,12 +12,19 @@
 
 namespace metall::json::jsndtl {
 
+/// \brief Compares the lengths and then the contiguous buffers with memcmp,
+/// which compares multiple bytes at a time, e.g., with SIMD instructions.
+/// Strings that contain null characters are also compared correctly.
 template <typename char_t, typename traits, typename allocator,
           typename other_string_type>
 inline bool general_string_equal(
     const basic_string<char_t, traits, allocator> &string,
     const other_string_type &other_string) noexcept {
-  return std::strcmp(string.c_str(), other_string.c_str()) == 0;
+  const std::size_t length = string.size();
+  if (length != std::size_t(other_string.size())) return false;
+  if (length == 0) return true;
+  return std::memcmp(string.data(), other_string.data(),
+                     length * sizeof(char_t)) == 0;
 }
 
 }  // namespace metall::json::jsndtl
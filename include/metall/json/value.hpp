@@ -27,6 +27,9 @@ namespace jsndtl {
 template <typename allocator_type, typename other_value_type>
 inline bool general_value_equal(const value<allocator_type> &value,
                                 const other_value_type &other_value) noexcept {
+  if constexpr (std::is_same_v<other_value_type, json::value<allocator_type>>) {
+    if (&value == &other_value) return true;
+  }
   if (other_value.is_null()) {
     return value.is_null();
   } else if (other_value.is_bool()) {
@@ -60,10 +63,8 @@ inline bool general_value_equal(const value<allocator_type> &value,
   } else if (other_value.is_array()) {
     return value.is_array() && (value.as_array() == other_value.as_array());
   } else if (other_value.is_string()) {
-    if (!value.is_string()) return false;
-    const auto &str = value.as_string();
-    const auto &other_srt = other_value.as_string();
-    return str.compare(other_srt.c_str()) == 0;
+    return value.is_string() &&
+           general_string_equal(value.as_string(), other_value.as_string());
   }
 
   assert(false);
@@ -0,0 +1,143 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_ACCESS_PATTERN_HPP
+#define METALL_KERNEL_ACCESS_PATTERN_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <metall/detail/file.hpp>
+#include <metall/logger.hpp>
+
+namespace metall::kernel {
+
+/// \brief How the pages of a region are expected to be accessed, which is
+/// given to the kernel as a memory advice so that it reads ahead or reclaims
+/// them accordingly.
+enum class access_pattern : unsigned int {
+  /// \brief The default readahead (MADV_NORMAL).
+  normal = 0,
+  /// \brief Read ahead aggressively and free the pages soon after they are
+  /// accessed (MADV_SEQUENTIAL), e.g., vectors and CSR arrays that are
+  /// scanned.
+  sequential = 1,
+  /// \brief Do not read ahead (MADV_RANDOM), e.g., hash tables.
+  random = 2,
+  /// \brief Read the pages ahead now (MADV_WILLNEED).
+  will_need = 3,
+  /// \brief The pages are not needed soon and can be reclaimed first.
+  dont_need = 4
+};
+
+/// \brief A table of the access patterns set to objects, which are applied
+/// again when a datastore is opened.
+/// This class is not thread-safe.
+class access_pattern_table {
+ public:
+  using offset_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  /// \brief Sets the pattern of the object at 'offset'. access_pattern::normal
+  /// removes the object from the table.
+  void set(const offset_type offset, const size_type length,
+           const access_pattern pattern) {
+    if (pattern == access_pattern::normal) {
+      m_table.erase(offset);
+      return;
+    }
+    m_table[offset] = {length, pattern};
+  }
+
+  /// \brief Removes the object at 'offset', if any.
+  void erase(const offset_type offset) { m_table.erase(offset); }
+
+  /// \brief Returns the pattern of the object at 'offset'.
+  access_pattern get(const offset_type offset) const {
+    const auto itr = m_table.find(offset);
+    return itr == m_table.end() ? access_pattern::normal : itr->second.second;
+  }
+
+  size_type size() const { return m_table.size(); }
+
+  void clear() { m_table.clear(); }
+
+  /// \brief Calls f(offset, length, pattern) for each object.
+  template <typename F>
+  void for_each(F &&f) const {
+    for (const auto &[offset, value] : m_table) {
+      f(offset, value.first, value.second);
+    }
+  }
+
+  /// \brief Writes the table to a file as text, one object per line.
+  /// Removes the file if the table is empty.
+  bool serialize(const std::filesystem::path &path) const {
+    if (m_table.empty()) {
+      return !mtlldetail::file_exist(path) || mtlldetail::remove_file(path);
+    }
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+      std::string s("Failed to open: " + path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    for (const auto &[offset, value] : m_table) {
+      ofs << offset << " " << value.first << " "
+          << static_cast<unsigned int>(value.second) << "\n";
+    }
+    ofs.close();
+    if (!ofs) {
+      std::string s("Failed to write data: " + path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Reads a table written by serialize(). A missing file is an empty
+  /// table.
+  bool deserialize(const std::filesystem::path &path) {
+    m_table.clear();
+    if (!mtlldetail::file_exist(path)) return true;
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+      std::string s("Failed to open: " + path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    offset_type offset;
+    size_type length;
+    unsigned int pattern;
+    while (ifs >> offset >> length >> pattern) {
+      if (pattern > static_cast<unsigned int>(access_pattern::dont_need)) {
+        std::string s("Invalid access pattern in " + path.string());
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        m_table.clear();
+        return false;
+      }
+      set(offset, length, static_cast<access_pattern>(pattern));
+    }
+    if (!ifs.eof()) {
+      std::string s("Failed to read data: " + path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      m_table.clear();
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  // offset -> (length in bytes, pattern)
+  std::map<offset_type, std::pair<size_type, access_pattern>> m_table;
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_ACCESS_PATTERN_HPP
@@ -0,0 +1,151 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_ALLOCATION_COUNTERS_HPP
+#define METALL_KERNEL_ALLOCATION_COUNTERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <metall/detail/proc.hpp>
+
+namespace metall {
+namespace kernel {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}
+
+/// \brief Counters of the objects and chunks of each bin, the medium objects,
+/// and the bytes given back to the system, maintained on allocations and
+/// deallocations so that the totals are read without scanning the chunk
+/// directory.
+/// Each CPU has its own set of counters on its own cache lines; an update
+/// is a relaxed atomic addition to the set of the CPU the thread runs on, and
+/// a read sums up all sets. A read running concurrently with updates sees
+/// each counter at some point during the read.
+class allocation_counters {
+ public:
+  using value_type = int64_t;
+
+  /// \brief Constructor.
+  /// \param num_bins The number of bins.
+  explicit allocation_counters(const std::size_t num_bins)
+      : m_num_bins(num_bins),
+        m_num_sets(std::max(mdtl::get_num_cpus(), 1U)),
+        m_num_lines_per_set((priv_num_counters(num_bins) + k_line_size - 1) /
+                            k_line_size),
+        m_lines(std::make_unique<line_type[]>(m_num_sets *
+                                              m_num_lines_per_set)) {}
+
+  ~allocation_counters() noexcept = default;
+  allocation_counters(const allocation_counters &) = delete;
+  allocation_counters &operator=(const allocation_counters &) = delete;
+  allocation_counters(allocation_counters &&) noexcept = default;
+  allocation_counters &operator=(allocation_counters &&) noexcept = default;
+
+  void add_objects(const std::size_t bin_no, const value_type n) {
+    assert(bin_no < m_num_bins);
+    priv_add(k_num_global_counters + bin_no * 2, n);
+  }
+
+  void add_chunks(const std::size_t bin_no, const value_type n) {
+    assert(bin_no < m_num_bins);
+    priv_add(k_num_global_counters + bin_no * 2 + 1, n);
+  }
+
+  void add_medium_objects(const value_type n, const value_type bytes) {
+    priv_add(k_medium_objects, n);
+    priv_add(k_medium_bytes, bytes);
+  }
+
+  void add_freed_bytes(const value_type bytes) {
+    priv_add(k_freed_bytes, bytes);
+  }
+
+  value_type objects(const std::size_t bin_no) const {
+    assert(bin_no < m_num_bins);
+    return priv_sum(k_num_global_counters + bin_no * 2);
+  }
+
+  value_type chunks(const std::size_t bin_no) const {
+    assert(bin_no < m_num_bins);
+    return priv_sum(k_num_global_counters + bin_no * 2 + 1);
+  }
+
+  value_type medium_objects() const { return priv_sum(k_medium_objects); }
+
+  value_type medium_bytes() const { return priv_sum(k_medium_bytes); }
+
+  value_type freed_bytes() const { return priv_sum(k_freed_bytes); }
+
+  /// \brief Returns the number of objects of all bins and medium objects.
+  value_type total_objects() const {
+    value_type total = medium_objects();
+    for (std::size_t bin_no = 0; bin_no < m_num_bins; ++bin_no) {
+      total += objects(bin_no);
+    }
+    return total;
+  }
+
+  /// \brief Sets all counters to 0. Must not be called concurrently.
+  void clear() {
+    for (std::size_t i = 0; i < m_num_sets * m_num_lines_per_set; ++i) {
+      for (auto &value : m_lines[i].values) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t num_bins() const { return m_num_bins; }
+
+ private:
+  static constexpr std::size_t k_line_size = 8;  // 64 bytes
+  static constexpr std::size_t k_medium_objects = 0;
+  static constexpr std::size_t k_medium_bytes = 1;
+  static constexpr std::size_t k_freed_bytes = 2;
+  static constexpr std::size_t k_num_global_counters = 3;
+
+  struct alignas(64) line_type {
+    std::atomic<value_type> values[k_line_size]{};
+  };
+
+  static constexpr std::size_t priv_num_counters(const std::size_t num_bins) {
+    return k_num_global_counters + num_bins * 2;
+  }
+
+  std::atomic<value_type> &priv_counter(const std::size_t set_no,
+                                        const std::size_t index) const {
+    return m_lines[set_no * m_num_lines_per_set + index / k_line_size]
+        .values[index % k_line_size];
+  }
+
+  void priv_add(const std::size_t index, const value_type n) {
+    const std::size_t set_no = mdtl::get_cpu_no() % m_num_sets;
+    priv_counter(set_no, index).fetch_add(n, std::memory_order_relaxed);
+  }
+
+  value_type priv_sum(const std::size_t index) const {
+    value_type sum = 0;
+    for (std::size_t set_no = 0; set_no < m_num_sets; ++set_no) {
+      sum += priv_counter(set_no, index).load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  std::size_t m_num_bins;
+  std::size_t m_num_sets;
+  std::size_t m_num_lines_per_set;
+  std::unique_ptr<line_type[]> m_lines;
+};
+
+}  // namespace kernel
+}  // namespace metall
+
+#endif  // METALL_KERNEL_ALLOCATION_COUNTERS_HPP
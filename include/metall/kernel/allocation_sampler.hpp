@@ -0,0 +1,195 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_ALLOCATION_SAMPLER_HPP
+#define METALL_KERNEL_ALLOCATION_SAMPLER_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define METALL_ALLOCATION_SAMPLER_HAS_BACKTRACE
+#endif
+
+#include <metall/logger.hpp>
+#include <metall/detail/mutex.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief Samples allocations and records the call stack of each sampled
+/// allocation, in the manner of tcmalloc's heap profiler.
+/// An allocation is sampled when the number of bytes a thread has allocated
+/// reaches a random threshold, which follows an exponential distribution
+/// whose mean is the sampling interval.
+/// The samples are kept in the process memory, not in the segment.
+class allocation_sampler {
+ public:
+  /// \brief Constructor.
+  /// \param interval The average number of bytes between two samples.
+  explicit allocation_sampler(const std::size_t interval)
+      : m_interval(interval), m_mutex(std::make_unique<mdtl::mutex>()) {}
+
+  /// \brief Counts an allocation and returns true if it is sampled.
+  /// Only touches a thread-local counter unless the allocation is sampled.
+  bool sample(const std::size_t nbytes) noexcept {
+    auto &remaining = priv_bytes_until_next_sample();
+    if (remaining > nbytes) {
+      remaining -= nbytes;
+      return false;
+    }
+    remaining = priv_draw_next_sample_distance();
+    return true;
+  }
+
+  /// \brief Records a sampled allocation with the current call stack.
+  /// Does nothing on error, e.g., if memory cannot be allocated.
+  /// \param nbytes The size of each allocated object.
+  /// \param num_objects The number of objects allocated at once.
+  /// \param bin_no The bin number of the objects.
+  void record(const std::size_t nbytes, const std::size_t num_objects,
+              const uint32_t bin_no) noexcept {
+    try {
+      key_type key;
+      key.bin_no = bin_no;
+#ifdef METALL_ALLOCATION_SAMPLER_HAS_BACKTRACE
+      void *frames[k_max_stack_depth];
+      const int depth = ::backtrace(frames, k_max_stack_depth);
+      // Skips this function
+      if (depth > 1) key.stack.assign(frames + 1, frames + depth);
+#endif
+      mdtl::mutex_lock_guard guard(*m_mutex);
+      auto &counts = m_samples[key];
+      counts.num_objects += num_objects;
+      counts.num_bytes += nbytes * num_objects;
+    } catch (...) {
+    }
+  }
+
+  /// \brief Removes all samples.
+  void clear() {
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    m_samples.clear();
+  }
+
+  /// \brief Returns the number of distinct call stacks (and bins) sampled.
+  std::size_t num_samples() const {
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    return m_samples.size();
+  }
+
+  /// \brief Writes the samples in the legacy heap profile format of
+  /// gperftools, which pprof reads, e.g., 'pprof --alloc_space <binary>
+  /// <file>'. As deallocations are not tracked, the in-use counts are 0;
+  /// the samples are reported as allocations.
+  /// The mapping of the process (/proc/self/maps) is appended so that pprof
+  /// can symbolize the addresses.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool write_profile(const fs::path &path) const {
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Failed to open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    std::size_t total_objects = 0;
+    std::size_t total_bytes = 0;
+    for (const auto &item : m_samples) {
+      total_objects += item.second.num_objects;
+      total_bytes += item.second.num_bytes;
+    }
+    ofs << "heap profile: 0: 0 [" << total_objects << ": " << total_bytes
+        << "] @ heap_v2/" << m_interval << "\n";
+    for (const auto &item : m_samples) {
+      ofs << "0: 0 [" << item.second.num_objects << ": "
+          << item.second.num_bytes << "] @";
+      for (const auto *frame : item.first.stack) ofs << " " << frame;
+      ofs << "\n";
+    }
+
+    std::ifstream maps("/proc/self/maps");
+    if (maps.is_open()) {
+      ofs << "\nMAPPED_LIBRARIES:\n" << maps.rdbuf();
+    }
+
+    ofs.close();
+    if (!ofs) {
+      std::stringstream ss;
+      ss << "Failed to write: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int k_max_stack_depth = 64;
+
+  struct key_type {
+    uint32_t bin_no{0};
+    std::vector<void *> stack;
+
+    bool operator==(const key_type &other) const {
+      return bin_no == other.bin_no && stack == other.stack;
+    }
+  };
+
+  struct key_hash {
+    std::size_t operator()(const key_type &key) const noexcept {
+      std::size_t hash = std::hash<uint32_t>{}(key.bin_no);
+      for (const auto *frame : key.stack) {
+        hash ^= std::hash<const void *>{}(frame) + 0x9e3779b97f4a7c15ULL +
+                (hash << 6ULL) + (hash >> 2ULL);
+      }
+      return hash;
+    }
+  };
+
+  struct counts_type {
+    std::size_t num_objects{0};
+    std::size_t num_bytes{0};
+  };
+
+  std::size_t &priv_bytes_until_next_sample() noexcept {
+    thread_local std::size_t remaining = priv_draw_next_sample_distance();
+    return remaining;
+  }
+
+  std::size_t priv_draw_next_sample_distance() noexcept {
+    thread_local std::minstd_rand engine(
+        std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    std::uniform_real_distribution<double> dist(
+        std::numeric_limits<double>::min(), 1.0);
+    return static_cast<std::size_t>(-std::log(dist(engine)) * m_interval) + 1;
+  }
+
+  std::size_t m_interval;
+  std::unique_ptr<mdtl::mutex> m_mutex;
+  std::unordered_map<key_type, counts_type, key_hash> m_samples;
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_ALLOCATION_SAMPLER_HPP
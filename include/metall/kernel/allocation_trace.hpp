@@ -0,0 +1,237 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_ALLOCATION_TRACE_HPP
+#define METALL_KERNEL_ALLOCATION_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/mutex.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief An operation recorded in an allocation trace.
+enum struct allocation_trace_op : uint8_t {
+  /// \brief An object was allocated.
+  allocate = 0,
+  /// \brief An object was deallocated. The size is 0 if it was not given.
+  deallocate = 1,
+  /// \brief A large object was resized in place to the size.
+  resize = 2
+};
+
+/// \brief A record of an allocation trace.
+/// The records of a trace are in the order the operations were made; a
+/// deallocation is recorded before the memory is given back, so that an
+/// offset is never reused before it is freed in the trace.
+struct allocation_trace_record {
+  /// \brief Nanoseconds since the trace started.
+  uint64_t time_ns;
+  /// \brief The offset of the object in the application data segment.
+  int64_t offset;
+  /// \brief The size of the object in bytes.
+  uint64_t size;
+  /// \brief The alignment given to an aligned allocation; otherwise, 0.
+  uint32_t alignment;
+  /// \brief The index of the thread, in the order threads first appear in
+  /// the process.
+  uint16_t thread;
+  allocation_trace_op op;
+  uint8_t reserved;
+};
+static_assert(sizeof(allocation_trace_record) == 32);
+static_assert(std::is_trivially_copyable_v<allocation_trace_record>);
+
+/// \brief The header of an allocation trace file, followed by the records.
+struct allocation_trace_header {
+  static constexpr char k_magic[8] = {'M', 'T', 'L', 'L', 'T', 'R', 'C', 0};
+  static constexpr uint32_t k_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  /// \brief The chunk size of the traced data store.
+  uint64_t chunk_size;
+  /// \brief The time the trace started in nanoseconds since the epoch.
+  uint64_t start_time_ns;
+};
+static_assert(sizeof(allocation_trace_header) == 32);
+
+/// \brief Writes the allocation and deallocation stream of a manager to a
+/// file to replay it offline, e.g., with bench/allocation_trace.
+/// Records are buffered in the process memory and appended to the file by
+/// batch. This class is thread-safe.
+class allocation_trace_writer {
+ public:
+  /// \brief Constructor. Call good() to check if the file has been opened.
+  /// \param path A path to the file to write; overwritten if it exists.
+  /// \param chunk_size The chunk size of the data store.
+  allocation_trace_writer(const fs::path &path, const uint64_t chunk_size)
+      : m_start(std::chrono::steady_clock::now()),
+        m_mutex(std::make_unique<mdtl::mutex>()) {
+    m_ofs.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Failed to open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return;
+    }
+    allocation_trace_header header{};
+    std::memcpy(header.magic, allocation_trace_header::k_magic,
+                sizeof(header.magic));
+    header.version = allocation_trace_header::k_version;
+    header.record_size = sizeof(allocation_trace_record);
+    header.chunk_size = chunk_size;
+    header.start_time_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    m_ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_buffer.reserve(k_buffer_capacity);
+  }
+
+  allocation_trace_writer(const allocation_trace_writer &) = delete;
+  allocation_trace_writer &operator=(const allocation_trace_writer &) = delete;
+
+  ~allocation_trace_writer() noexcept { close(); }
+
+  /// \brief Returns true if the file is open and no error has occurred.
+  bool good() const { return m_ofs.is_open() && m_ofs.good(); }
+
+  /// \brief Records an operation.
+  /// Does nothing on error, e.g., if the file is not open.
+  void record(const allocation_trace_op op, const int64_t offset,
+              const uint64_t size, const uint32_t alignment = 0) noexcept {
+    allocation_trace_record r{};
+    r.op = op;
+    r.offset = offset;
+    r.size = size;
+    r.alignment = alignment;
+    r.thread = priv_thread_index();
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    // Takes the time in the lock so that the times are in the record order
+    r.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_start)
+                    .count();
+    m_buffer.push_back(r);
+    ++m_num_records;
+    if (m_buffer.size() >= k_buffer_capacity) priv_write_buffer();
+  }
+
+  /// \brief Writes the buffered records to the file.
+  /// \return Returns true on success; otherwise, false.
+  bool flush() {
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    priv_write_buffer();
+    m_ofs.flush();
+    return good();
+  }
+
+  /// \brief Writes the buffered records and closes the file.
+  /// \return Returns true on success; otherwise, false.
+  bool close() noexcept {
+    if (!m_ofs.is_open()) return true;
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    priv_write_buffer();
+    m_ofs.close();
+    if (m_ofs.fail()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to write an allocation trace");
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Returns the number of records made.
+  uint64_t num_records() const {
+    mdtl::mutex_lock_guard guard(*m_mutex);
+    return m_num_records;
+  }
+
+ private:
+  static constexpr std::size_t k_buffer_capacity = 1ULL << 14ULL;
+
+  /// \brief Returns a small number unique to the calling thread.
+  static uint16_t priv_thread_index() noexcept {
+    static std::atomic<uint16_t> num_threads{0};
+    thread_local const uint16_t index =
+        num_threads.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+
+  void priv_write_buffer() noexcept {
+    if (m_buffer.empty() || !m_ofs.is_open()) return;
+    m_ofs.write(reinterpret_cast<const char *>(m_buffer.data()),
+                m_buffer.size() * sizeof(allocation_trace_record));
+    m_buffer.clear();
+  }
+
+  std::chrono::steady_clock::time_point m_start;
+  std::unique_ptr<mdtl::mutex> m_mutex;
+  std::ofstream m_ofs;
+  std::vector<allocation_trace_record> m_buffer;
+  uint64_t m_num_records{0};
+};
+
+/// \brief Reads an allocation trace file written by allocation_trace_writer.
+/// \param path A path to the file.
+/// \param header A pointer to store the header.
+/// \param records A pointer to store the records.
+/// \return Returns true on success; otherwise, false.
+inline bool read_allocation_trace(
+    const fs::path &path, allocation_trace_header *const header,
+    std::vector<allocation_trace_record> *const records) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    std::stringstream ss;
+    ss << "Failed to open: " << path;
+    logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    return false;
+  }
+
+  if (!ifs.read(reinterpret_cast<char *>(header), sizeof(*header)) ||
+      std::memcmp(header->magic, allocation_trace_header::k_magic,
+                  sizeof(header->magic)) != 0 ||
+      header->version != allocation_trace_header::k_version ||
+      header->record_size != sizeof(allocation_trace_record)) {
+    std::stringstream ss;
+    ss << "Not an allocation trace or an unsupported version: " << path;
+    logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    return false;
+  }
+
+  std::error_code ec;
+  const auto file_size = fs::file_size(path, ec);
+  if (ec) return false;
+  const auto num_records =
+      (file_size - sizeof(*header)) / sizeof(allocation_trace_record);
+  records->resize(num_records);
+  if (!ifs.read(reinterpret_cast<char *>(records->data()),
+                num_records * sizeof(allocation_trace_record))) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to read the records of an allocation trace");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_ALLOCATION_TRACE_HPP
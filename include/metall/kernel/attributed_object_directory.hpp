@@ -16,6 +16,11 @@
 #include <sstream>
 #include <memory>
 #include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
 
 #include <boost/container/string.hpp>
 #include <boost/unordered_map.hpp>
@@ -24,6 +29,9 @@
 #include <metall/logger.hpp>
 #include <metall/detail/ptree.hpp>
 #include <metall/detail/hash.hpp>
+#include <metall/detail/file.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/io_executor.hpp>
 
 namespace metall {
 namespace kernel {
@@ -197,6 +205,8 @@ class attributed_object_directory {
                   "Exception was thrown when inserting entry");
       return false;
     }
+    priv_journal(journal_record_kind::insert, offset, length, type_id, name,
+                 description);
 
     return true;
   }
@@ -219,6 +229,8 @@ class attributed_object_directory {
     } catch (...) {
       return false;
     }
+    priv_journal(journal_record_kind::set_description, position->offset(), 0,
+                 0, name_type(), description);
 
     return true;
   }
@@ -345,6 +357,7 @@ class attributed_object_directory {
     }
 
     try {
+      priv_journal(journal_record_kind::erase, position->offset());
       m_offset_index_table->erase(position->offset());
       if (!position->name().empty())
         m_name_index_table->erase(position->name());
@@ -372,6 +385,7 @@ class attributed_object_directory {
 
     try {
       auto itr = find(name);
+      priv_journal(journal_record_kind::erase, itr->offset());
       m_offset_index_table->erase(itr->offset());
       m_entry_table->erase(itr);
       if (!name.empty()) m_name_index_table->erase(name);
@@ -398,6 +412,7 @@ class attributed_object_directory {
 
     try {
       auto itr = find(offset);
+      priv_journal(journal_record_kind::erase, offset);
       m_offset_index_table->erase(itr->offset());
       if (!itr->name().empty()) m_name_index_table->erase(itr->name());
       m_entry_table->erase(itr);
@@ -410,6 +425,24 @@ class attributed_object_directory {
     return 1;
   }
 
+  /// \brief Reserves the index tables for inserting entries.
+  /// \param num_entries The number of the entries to be inserted.
+  /// \return Returns true on success; otherwise, false.
+  bool reserve(const size_type num_entries) noexcept {
+    if (!good()) return false;
+
+    try {
+      m_offset_index_table->reserve(m_offset_index_table->size() +
+                                    num_entries);
+      m_name_index_table->reserve(m_name_index_table->size() + num_entries);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Exception was thrown when reserving tables");
+      return false;
+    }
+    return true;
+  }
+
   /// \brief Clears tables
   /// \return
   bool clear() noexcept {
@@ -421,6 +454,7 @@ class attributed_object_directory {
       m_offset_index_table->clear();
       m_name_index_table->clear();
       m_entry_table->clear();
+      priv_reset_journal(fs::path());
     } catch (...) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Exception was thrown when clearing entries");
@@ -429,10 +463,71 @@ class attributed_object_directory {
     return true;
   }
 
-  /// \brief
-  /// \param path
-  bool serialize(const fs::path &path) const noexcept {
+  /// \brief Serializes the directory into a file in the binary format.
+  /// Also removes the journal file of the file, i.e., compacts the journal.
+  /// \param path A file path to write.
+  /// \return Returns true on success; otherwise, false.
+  bool serialize(const fs::path &path) noexcept {
+    try {
+      priv_reset_journal(fs::path());
+      // Removes the journal first as it must not be replayed on the new file
+      if (mdtl::file_exist(journal_path(path)) &&
+          !mdtl::remove_file(journal_path(path))) {
+        return false;
+      }
+      if (!priv_serialize_binary_throw(path)) return false;
+    } catch (...) {
+      return false;
+    }
+    priv_reset_journal(path);
+    return true;
+  }
+
+  /// \brief Writes the changes made since the last serialize(), deserialize(),
+  /// or flush() with the same file path to the journal file of the path.
+  /// Unlike serialize(), the cost is proportional to the number of the
+  /// changes, not to the number of the entries.
+  /// Falls back to serialize() if the file is not the one the directory was
+  /// serialized to or deserialized from in the binary format.
+  /// \param path A file path given to serialize() or deserialize().
+  /// \return Returns true on success; otherwise, false.
+  bool flush(const fs::path &path) noexcept {
+    if (!m_journal_active || m_journal_file_path != path) {
+      return serialize(path);
+    }
+    if (m_journal.empty()) return true;
+
+    try {
+      if (!priv_append_journal_throw(journal_path(path))) {
+        priv_reset_journal(fs::path());
+        return false;
+      }
+      m_journal.clear();
+    } catch (...) {
+      priv_reset_journal(fs::path());
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Returns the path of the journal file of a directory file.
+  /// \param path A file path of a directory.
+  /// \return Returns the path of the journal file.
+  static fs::path journal_path(const fs::path &path) {
+    return fs::path(path.string() + k_journal_file_suffix);
+  }
+
+  /// \brief Serializes the directory into a file in the JSON format, which
+  /// older versions of Metall read.
+  /// \param path A file path to write.
+  /// \return Returns true on success; otherwise, false.
+  bool serialize_json(const fs::path &path) noexcept {
+    priv_reset_journal(fs::path());
     try {
+      if (mdtl::file_exist(journal_path(path)) &&
+          !mdtl::remove_file(journal_path(path))) {
+        return false;
+      }
       return priv_serialize_throw(path);
     } catch (...) {
       return false;
@@ -440,17 +535,58 @@ class attributed_object_directory {
     return true;
   }
 
-  /// \brief
-  /// \param path
+  /// \brief Deserializes the directory from a file.
+  /// Both the binary format and the older JSON format are accepted.
+  /// The journal file of the file, if exists, is replayed.
+  /// \param path A file path to read.
+  /// \return Returns true on success; otherwise, false.
   bool deserialize(const fs::path &path) noexcept {
+    priv_reset_journal(fs::path());
     try {
-      return priv_deserialize_throw(path);
+      const bool binary = priv_binary_format_file(path);
+      if (binary ? !priv_deserialize_binary_throw(path)
+                 : !priv_deserialize_throw(path)) {
+        return false;
+      }
+      if (mdtl::file_exist(journal_path(path)) &&
+          !priv_replay_journal_throw(journal_path(path))) {
+        return false;
+      }
+      // Changes to a JSON file are written by a full serialization
+      if (binary) priv_reset_journal(path);
     } catch (...) {
       return false;
     }
     return true;
   }
 
+  /// \brief Reads the entries in a file written by serialize() without
+  /// building a directory, e.g., to list the objects of a large data store.
+  /// The entries in a binary file are decoded in parallel.
+  /// A JSON file and a file with a journal are read by deserialize().
+  /// \param path A file path to read.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param entries A pointer to store the entries.
+  /// \return Returns true on success; otherwise, false.
+  static bool read_entries(const fs::path &path, const int max_num_threads,
+                           std::vector<entry_type> *const entries) noexcept {
+    try {
+      if (!priv_binary_format_file(path) ||
+          mdtl::file_exist(journal_path(path))) {
+        attributed_object_directory directory;
+        if (!directory.deserialize(path)) return false;
+        entries->assign(directory.begin(), directory.end());
+        return true;
+      }
+      return priv_read_binary_entries_throw(path, max_num_threads, entries);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
  private:
   // -------------------- //
   // Private types and static values
@@ -474,6 +610,62 @@ class attributed_object_directory {
     static constexpr const char *description = "description";
   };
 
+  // Binary format: a header, the fixed-size entries, and the names and
+  // descriptions of the entries back to back, in the entry order.
+  // Parsing JSON dominates opening a data store with millions of entries.
+  static constexpr char k_binary_format_magic[8] = {'M', 'T', 'L', 'L',
+                                                    'A', 'O', 'D', 'R'};
+  static constexpr uint64_t k_binary_format_version = 1;
+
+  struct binary_file_header {
+    char magic[8];
+    uint64_t format_version;
+    uint64_t num_entries;
+    uint64_t num_string_bytes;
+  };
+
+  struct binary_entry_type {
+    int64_t offset;
+    uint64_t length;
+    uint64_t type_id;
+    uint64_t name_size;
+    uint64_t description_size;
+  };
+  static_assert(sizeof(binary_file_header) % sizeof(uint64_t) == 0,
+                "The header size must be a multiple of 8 bytes");
+  static_assert(sizeof(binary_entry_type) == 40,
+                "Unexpected binary entry size");
+
+  // Journal file: a header followed by the records of the changes, each of
+  // which is a fixed-size part and the name and description of the entry.
+  // A journal is valid only with the binary file it was written for.
+  static constexpr const char *k_journal_file_suffix = "-journal";
+  static constexpr char k_journal_magic[8] = {'M', 'T', 'L', 'L',
+                                              'A', 'O', 'D', 'J'};
+  static constexpr uint64_t k_journal_version = 1;
+
+  enum class journal_record_kind : uint64_t {
+    insert = 1,
+    erase = 2,
+    set_description = 3
+  };
+
+  struct journal_file_header {
+    char magic[8];
+    uint64_t format_version;
+  };
+
+  struct journal_record_type {
+    journal_record_kind kind;
+    int64_t offset;
+    uint64_t length;
+    uint64_t type_id;
+    uint64_t name_size;
+    uint64_t description_size;
+  };
+  static_assert(sizeof(journal_record_type) == 48,
+                "Unexpected journal record size");
+
   // -------------------- //
   // Private methods
   // -------------------- //
@@ -494,6 +686,8 @@ class attributed_object_directory {
   }
 
   bool priv_deep_copy(const attributed_object_directory &other) noexcept {
+    // A copy has not been serialized to any file
+    priv_reset_journal(fs::path());
     try {
       *m_entry_table = *(other.m_entry_table);
       *m_offset_index_table = *(other.m_offset_index_table);
@@ -509,6 +703,132 @@ class attributed_object_directory {
     return true;
   }
 
+  // Starts recording changes for the file at 'path', i.e., the directory
+  // is the same as the file, or stops recording if 'path' is empty.
+  void priv_reset_journal(const fs::path &path) noexcept {
+    m_journal.clear();
+    try {
+      m_journal_file_path = path;
+      m_journal_active = !path.empty();
+    } catch (...) {
+      m_journal_active = false;
+    }
+  }
+
+  void priv_journal(const journal_record_kind kind, const offset_type offset,
+                    const length_type length = 0,
+                    const type_id_type type_id = 0,
+                    const name_type &name = name_type(),
+                    const description_type &description =
+                        description_type()) noexcept {
+    if (!m_journal_active) return;
+
+    const journal_record_type record{
+        kind,        static_cast<int64_t>(offset),
+        length,      static_cast<uint64_t>(type_id),
+        name.size(), description.size()};
+    try {
+      m_journal.append(reinterpret_cast<const char *>(&record),
+                       sizeof(record));
+      m_journal.append(name.data(), name.size());
+      m_journal.append(description.data(), description.size());
+    } catch (...) {
+      // The next flush() writes the whole directory instead
+      priv_reset_journal(fs::path());
+    }
+  }
+
+  bool priv_append_journal_throw(const fs::path &journal_file_path) const {
+    const bool new_file = !mdtl::file_exist(journal_file_path) ||
+                          mdtl::get_file_size(journal_file_path) == 0;
+    std::ofstream ofs(journal_file_path, std::ios::binary | std::ios::app);
+    if (!ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << journal_file_path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    if (new_file) {
+      journal_file_header header;
+      std::copy_n(k_journal_magic, sizeof(header.magic), header.magic);
+      header.format_version = k_journal_version;
+      ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    ofs.write(m_journal.data(), m_journal.size());
+    ofs.close();
+    if (!ofs) {
+      std::stringstream ss;
+      ss << "Something happened in the ofstream: " << journal_file_path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    return true;
+  }
+
+  bool priv_replay_journal_throw(const fs::path &journal_file_path) {
+    std::ifstream ifs(journal_file_path, std::ios::binary);
+    const std::string image((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+    const auto broken = [&journal_file_path]() {
+      std::stringstream ss;
+      ss << "Broken journal file: " << journal_file_path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    };
+    if (!ifs.eof() && !ifs) return broken();
+
+    journal_file_header header;
+    if (image.size() < sizeof(header)) return broken();
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (!std::equal(header.magic, header.magic + sizeof(header.magic),
+                    k_journal_magic) ||
+        header.format_version != k_journal_version) {
+      return broken();
+    }
+
+    std::size_t pos = sizeof(header);
+    while (pos < image.size()) {
+      journal_record_type record;
+      if (image.size() - pos < sizeof(record)) break;
+      std::memcpy(&record, image.data() + pos, sizeof(record));
+      const std::size_t remains = image.size() - pos - sizeof(record);
+      if (record.name_size > remains ||
+          record.description_size > remains - record.name_size) {
+        break;
+      }
+      pos += sizeof(record);
+      name_type name(image.data() + pos, record.name_size);
+      pos += record.name_size;
+      description_type description(image.data() + pos,
+                                   record.description_size);
+      pos += record.description_size;
+
+      const auto offset = static_cast<offset_type>(record.offset);
+      bool applied = false;
+      if (record.kind == journal_record_kind::insert) {
+        applied = (name.empty() || count(name) == 0) &&
+                  insert(name, offset, static_cast<length_type>(record.length),
+                         static_cast<type_id_type>(record.type_id),
+                         description);
+      } else if (record.kind == journal_record_kind::erase) {
+        applied = erase(offset) == 1;
+      } else if (record.kind == journal_record_kind::set_description) {
+        applied = count(offset) > 0 &&
+                  set_description(find(offset), description);
+      }
+      if (!applied) return broken();
+    }
+    // A record can be partially written if the process crashed while flushing
+    if (pos < image.size()) {
+      std::stringstream ss;
+      ss << "Ignored a truncated record in " << journal_file_path;
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  ss.str().c_str());
+    }
+
+    return true;
+  }
+
   bool priv_serialize_throw(const fs::path &path) const {
     if (!good()) {
       return false;
@@ -548,6 +868,255 @@ class attributed_object_directory {
     return true;
   }
 
+  bool priv_serialize_binary_throw(const fs::path &path) const {
+    if (!good()) {
+      return false;
+    }
+
+    binary_file_header header;
+    std::copy_n(k_binary_format_magic, sizeof(header.magic), header.magic);
+    header.format_version = k_binary_format_version;
+    header.num_entries = m_entry_table->size();
+    header.num_string_bytes = 0;
+
+    std::vector<binary_entry_type> entries;
+    entries.reserve(header.num_entries);
+    for (const auto &item : *m_entry_table) {
+      entries.push_back(binary_entry_type{
+          static_cast<int64_t>(item.offset()),
+          static_cast<uint64_t>(item.length()),
+          static_cast<uint64_t>(item.type_id()), item.name().size(),
+          item.description().size()});
+      header.num_string_bytes += item.name().size() + item.description().size();
+    }
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(entries.data()),
+              entries.size() * sizeof(binary_entry_type));
+    for (const auto &item : *m_entry_table) {
+      ofs.write(item.name().data(), item.name().size());
+      ofs.write(item.description().data(), item.description().size());
+    }
+    if (!ofs) {
+      std::stringstream ss;
+      ss << "Something happened in the ofstream: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    ofs.close();
+
+    return true;
+  }
+
+  static bool priv_binary_format_file(const fs::path &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    char magic[sizeof(k_binary_format_magic)];
+    if (!ifs.read(magic, sizeof(magic))) return false;
+    return std::equal(magic, magic + sizeof(magic), k_binary_format_magic);
+  }
+
+  bool priv_deserialize_binary_throw(const fs::path &path) {
+    if (!good()) {
+      return false;
+    }
+
+    const ssize_t file_size = mdtl::get_file_size(path);
+    if (file_size < (ssize_t)sizeof(binary_file_header)) {
+      std::stringstream ss;
+      ss << "Invalid file size: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    const auto [fd, addr] =
+        mdtl::map_file_read_mode(path, nullptr, file_size, 0);
+    if (!addr) {
+      std::stringstream ss;
+      ss << "Cannot map: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    bool ret = false;
+    try {
+      ret = priv_deserialize_binary_image(static_cast<const char *>(addr),
+                                          file_size, path);
+    } catch (...) {
+      mdtl::munmap(fd, addr, file_size, false);
+      throw;
+    }
+    mdtl::munmap(fd, addr, file_size, false);
+
+    return ret;
+  }
+
+  static bool priv_read_binary_entries_throw(
+      const fs::path &path, const int max_num_threads,
+      std::vector<entry_type> *const entries) {
+    const ssize_t file_size = mdtl::get_file_size(path);
+    if (file_size < (ssize_t)sizeof(binary_file_header)) {
+      std::stringstream ss;
+      ss << "Invalid file size: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    const auto [fd, addr] =
+        mdtl::map_file_read_mode(path, nullptr, file_size, 0);
+    if (!addr) {
+      std::stringstream ss;
+      ss << "Cannot map: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    bool ret = false;
+    try {
+      ret = priv_read_binary_image_entries(static_cast<const char *>(addr),
+                                           file_size, max_num_threads,
+                                           entries);
+    } catch (...) {
+      mdtl::munmap(fd, addr, file_size, false);
+      throw;
+    }
+    mdtl::munmap(fd, addr, file_size, false);
+    if (!ret) {
+      std::stringstream ss;
+      ss << "Broken file: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    }
+    return ret;
+  }
+
+  static bool priv_read_binary_image_entries(
+      const char *const image, const std::size_t image_size,
+      const int max_num_threads, std::vector<entry_type> *const entries) {
+    binary_file_header header;
+    std::memcpy(&header, image, sizeof(header));
+    if (header.format_version != k_binary_format_version ||
+        header.num_entries >
+            (image_size - sizeof(header)) / sizeof(binary_entry_type) ||
+        image_size != sizeof(header) +
+                          header.num_entries * sizeof(binary_entry_type) +
+                          header.num_string_bytes) {
+      return false;
+    }
+    const char *const entry_image = image + sizeof(header);
+    const char *const strings =
+        entry_image + header.num_entries * sizeof(binary_entry_type);
+
+    // The position of the strings of each entry; the entries are decoded in
+    // parallel after this pass
+    std::vector<uint64_t> string_positions(header.num_entries);
+    uint64_t position = 0;
+    for (uint64_t i = 0; i < header.num_entries; ++i) {
+      binary_entry_type entry;
+      std::memcpy(&entry, entry_image + i * sizeof(binary_entry_type),
+                  sizeof(entry));
+      if (entry.name_size > header.num_string_bytes - position ||
+          entry.description_size >
+              header.num_string_bytes - position - entry.name_size) {
+        return false;
+      }
+      string_positions[i] = position;
+      position += entry.name_size + entry.description_size;
+    }
+
+    entries->clear();
+    entries->resize(header.num_entries);
+    constexpr uint64_t k_num_entries_per_task = 1ULL << 16ULL;
+    return mdtl::io_executor::instance().parallel_for(
+        (header.num_entries + k_num_entries_per_task - 1) /
+            k_num_entries_per_task,
+        max_num_threads, [&](const std::size_t t) {
+          const auto end = std::min<uint64_t>((t + 1) * k_num_entries_per_task,
+                                              header.num_entries);
+          for (uint64_t i = t * k_num_entries_per_task; i < end; ++i) {
+            binary_entry_type entry;
+            std::memcpy(&entry, entry_image + i * sizeof(binary_entry_type),
+                        sizeof(entry));
+            const char *const name = strings + string_positions[i];
+            (*entries)[i] = entry_type(
+                name_type(name, entry.name_size),
+                static_cast<offset_type>(entry.offset),
+                static_cast<length_type>(entry.length),
+                static_cast<type_id_type>(entry.type_id),
+                description_type(name + entry.name_size,
+                                 entry.description_size));
+          }
+          return true;
+        });
+  }
+
+  bool priv_deserialize_binary_image(const char *const image,
+                                     const std::size_t image_size,
+                                     const fs::path &path) {
+    binary_file_header header;
+    std::memcpy(&header, image, sizeof(header));
+    if (header.format_version != k_binary_format_version) {
+      std::stringstream ss;
+      ss << "Unsupported format version " << header.format_version << ": "
+         << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    const auto broken = [&path]() {
+      std::stringstream ss;
+      ss << "Broken file: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    };
+    if (header.num_entries >
+            (image_size - sizeof(header)) / sizeof(binary_entry_type) ||
+        image_size != sizeof(header) +
+                          header.num_entries * sizeof(binary_entry_type) +
+                          header.num_string_bytes) {
+      return broken();
+    }
+
+    // Sizes the index tables once instead of rehashing while inserting
+    m_offset_index_table->reserve(m_offset_index_table->size() +
+                                  header.num_entries);
+    const char *strings = image + sizeof(header) +
+                          header.num_entries * sizeof(binary_entry_type);
+    const char *const strings_end = image + image_size;
+    for (uint64_t i = 0; i < header.num_entries; ++i) {
+      binary_entry_type entry;
+      std::memcpy(&entry,
+                  image + sizeof(header) + i * sizeof(binary_entry_type),
+                  sizeof(entry));
+      if (entry.name_size > std::size_t(strings_end - strings) ||
+          entry.description_size >
+              std::size_t(strings_end - strings) - entry.name_size) {
+        return broken();
+      }
+      name_type name(strings, entry.name_size);
+      strings += entry.name_size;
+      description_type description(strings, entry.description_size);
+      strings += entry.description_size;
+
+      if (!name.empty() && count(name) > 0) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to reconstruct object table");
+        return false;
+      }
+      if (!insert(name, static_cast<offset_type>(entry.offset),
+                  static_cast<length_type>(entry.length),
+                  static_cast<type_id_type>(entry.type_id), description)) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to reconstruct object table");
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   bool priv_deserialize_throw(const fs::path &path) {
     if (!good()) {
       return false;
@@ -602,6 +1171,10 @@ class attributed_object_directory {
   std::unique_ptr<entry_table_type> m_entry_table;
   std::unique_ptr<offset_index_table_type> m_offset_index_table;
   std::unique_ptr<name_index_table_type> m_name_index_table;
+  // Changes not written to the journal file of m_journal_file_path yet
+  std::string m_journal;
+  fs::path m_journal_file_path;
+  bool m_journal_active{false};
 };
 }  // namespace kernel
 }  // namespace metall
@@ -15,12 +15,13 @@
 #include <functional>
 #include <memory>
 #include <filesystem>
+#include <algorithm>
 
 #include <boost/container/vector.hpp>
 #include <boost/container/scoped_allocator.hpp>
 
 #ifdef METALL_USE_SORTED_BIN
-#include <boost/container/flat_set.hpp>
+#include <metall/kernel/bitmap_bin.hpp>
 #else
 #include <boost/container/deque.hpp>
 #endif
@@ -38,10 +39,11 @@ namespace mdtl = metall::mtlldetail;
 
 /// \brief A simple key-value store designed to store values related to memory
 /// address, such as free chunk numbers or free objects. Values are sorted with
-/// ascending order if METALL_USE_SORTED_BIN is defined; otherwise, values are
-/// stored in the LIFO order. \tparam _k_num_bins The number of bins \tparam
-/// _value_type The value type to store \tparam _allocator_type The allocator
-/// type to allocate internal data
+/// ascending order if METALL_USE_SORTED_BIN is defined (kept in a bitmap, see
+/// bitmap_bin); otherwise, values are stored in the LIFO order.
+/// \tparam _k_num_bins The number of bins \tparam _value_type The value type
+/// to store \tparam _allocator_type The allocator type to allocate internal
+/// data
 template <std::size_t _k_num_bins, typename _value_type,
           typename _allocator_type = std::allocator<std::byte>>
 class bin_directory {
@@ -62,11 +64,7 @@ class bin_directory {
   using other_allocator_type =
       typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
 #ifdef METALL_USE_SORTED_BIN
-  using bin_allocator_type = other_allocator_type<value_type>;
-  // Sort values with descending order internally to simplify implementation
-  using bin_type =
-      boost::container::flat_set<value_type, std::greater<value_type>,
-                                 bin_allocator_type>;
+  using bin_type = bitmap_bin<value_type, allocator_type>;
 #else
   using bin_allocator_type = other_allocator_type<value_type>;
   using bin_type = boost::container::deque<value_type, bin_allocator_type>;
@@ -118,11 +116,7 @@ class bin_directory {
   value_type front(const bin_no_type bin_no) const {
     assert(bin_no < k_num_bins);
     assert(!empty(bin_no));
-#ifdef METALL_USE_SORTED_BIN
-    return *(m_table[bin_no].end() - 1);
-#else
     return m_table[bin_no].front();
-#endif
   }
 
   /// \brief
@@ -141,11 +135,7 @@ class bin_directory {
   /// \param bin_no
   void pop(const bin_no_type bin_no) {
     assert(bin_no < k_num_bins);
-#ifdef METALL_USE_SORTED_BIN
-    m_table[bin_no].erase(m_table[bin_no].end() - 1);
-#else
     m_table[bin_no].pop_front();
-#endif
   }
 
   /// \brief
@@ -155,11 +145,7 @@ class bin_directory {
   bool erase(const bin_no_type bin_no, const value_type value) {
     assert(bin_no < k_num_bins);
 #ifdef METALL_USE_SORTED_BIN
-    const auto itr = m_table[bin_no].find(value);
-    if (itr != m_table[bin_no].end()) {
-      m_table[bin_no].erase(itr);
-      return true;
-    }
+    return m_table[bin_no].erase(value);
 #else
     for (auto itr = m_table[bin_no].begin(), end = m_table[bin_no].end();
          itr != end; ++itr) {
@@ -168,8 +154,22 @@ class bin_directory {
         return true;
       }
     }
-#endif
     return false;
+#endif
+  }
+
+  /// \brief Reorders the values in a bin so that front() returns the
+  /// smallest value in terms of 'comp'.
+  /// Does nothing if METALL_USE_SORTED_BIN is defined, as the values are kept
+  /// sorted in their own order.
+  /// \param bin_no A bin number.
+  /// \param comp A comparison function object.
+  template <typename compare_type>
+  void sort(const bin_no_type bin_no, [[maybe_unused]] compare_type comp) {
+    assert(bin_no < k_num_bins);
+#ifndef METALL_USE_SORTED_BIN
+    std::sort(m_table[bin_no].begin(), m_table[bin_no].end(), comp);
+#endif
   }
 
   /// \brief
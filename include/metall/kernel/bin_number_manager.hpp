@@ -16,13 +16,17 @@ namespace metall {
 namespace kernel {
 
 /// \brief Bin number manager
-template <std::size_t k_chunk_size, std::size_t k_max_object_size>
+/// \tparam size_class_table_type The table of the small object sizes, e.g.,
+/// size_class_table.
+template <std::size_t k_chunk_size, std::size_t k_max_object_size,
+          typename size_class_table_type = default_size_class_table>
 class bin_number_manager {
  public:
   using size_type = std::size_t;
 
  private:
-  using object_size_mngr = object_size_manager<k_chunk_size, k_max_object_size>;
+  using object_size_mngr = object_size_manager<k_chunk_size, k_max_object_size,
+                                               size_class_table_type>;
   static constexpr size_type k_num_small_bins =
       object_size_mngr::num_small_sizes();
   static constexpr size_type k_num_large_bins =
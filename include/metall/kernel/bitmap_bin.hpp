@@ -0,0 +1,254 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_BITMAP_BIN_HPP
+#define METALL_KERNEL_BITMAP_BIN_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+
+#include <boost/container/vector.hpp>
+
+namespace metall::kernel {
+
+/// \brief A set of unsigned integers, e.g., chunk numbers, that gives the
+/// smallest value quickly. Values are kept in a hierarchical bitmap that
+/// grows with the largest value stored; the bit of a word in an upper layer is
+/// set if the corresponding word in the layer below is not zero.
+/// insert(), erase(), and front() take O(log_64 max value) time, and the
+/// values are iterated in ascending order.
+/// \tparam _value_type An unsigned integer type to store.
+/// \tparam _allocator_type An allocator type to allocate internal data.
+template <typename _value_type,
+          typename _allocator_type = std::allocator<std::byte>>
+class bitmap_bin {
+ private:
+  using word_type = uint64_t;
+  static constexpr std::size_t k_word_bits = 64;
+
+  template <typename T>
+  using other_allocator_type = typename std::allocator_traits<
+      _allocator_type>::template rebind_alloc<T>;
+  using layer_type =
+      boost::container::vector<word_type, other_allocator_type<word_type>>;
+  using layer_list_type =
+      boost::container::vector<layer_type, other_allocator_type<layer_type>>;
+
+ public:
+  using value_type = _value_type;
+  using allocator_type = _allocator_type;
+  static_assert(std::numeric_limits<value_type>::is_integer &&
+                    !std::numeric_limits<value_type>::is_signed,
+                "bitmap_bin supports only unsigned integers");
+
+  class const_iterator;
+
+  explicit bitmap_bin(const allocator_type &allocator = allocator_type())
+      : m_layers(allocator) {}
+
+  bitmap_bin(const bitmap_bin &) = default;
+  bitmap_bin(bitmap_bin &&) noexcept = default;
+  bitmap_bin &operator=(const bitmap_bin &) = default;
+  bitmap_bin &operator=(bitmap_bin &&) noexcept = default;
+
+  // Allocator-extended constructors for scoped allocators
+  bitmap_bin(const bitmap_bin &other, const allocator_type &allocator)
+      : m_layers(other.m_layers, allocator), m_size(other.m_size) {}
+
+  bitmap_bin(bitmap_bin &&other, const allocator_type &allocator)
+      : m_layers(std::move(other.m_layers), allocator),
+        m_size(other.m_size) {
+    other.m_size = 0;
+  }
+
+  bool empty() const { return m_size == 0; }
+
+  std::size_t size() const { return m_size; }
+
+  /// \brief Returns the smallest value. The bin must not be empty.
+  value_type front() const {
+    assert(!empty());
+    std::size_t pos = 0;
+    for (std::size_t l = m_layers.size(); l-- > 0;) {
+      assert(m_layers[l][pos] != 0);
+      pos = pos * k_word_bits + priv_lowest_bit(m_layers[l][pos]);
+    }
+    return static_cast<value_type>(pos);
+  }
+
+  /// \brief Inserts 'value'. Does nothing if the value is already in the bin.
+  /// \return Returns true if the value is inserted.
+  bool insert(const value_type value) {
+    priv_reserve(value);
+    std::size_t pos = value;
+    for (auto &layer : m_layers) {
+      word_type &word = layer[pos / k_word_bits];
+      const word_type bit = word_type(1) << (pos % k_word_bits);
+      if (&layer == &m_layers.front() && (word & bit)) return false;
+      const bool was_zero = (word == 0);
+      word |= bit;
+      if (!was_zero) break;  // The upper bits are set already
+      pos /= k_word_bits;
+    }
+    ++m_size;
+    return true;
+  }
+
+  /// \brief Erases 'value'.
+  /// \return Returns true if the value was in the bin.
+  bool erase(const value_type value) {
+    if (!contains(value)) return false;
+    std::size_t pos = value;
+    for (auto &layer : m_layers) {
+      word_type &word = layer[pos / k_word_bits];
+      word &= ~(word_type(1) << (pos % k_word_bits));
+      if (word != 0) break;  // The upper bits stay set
+      pos /= k_word_bits;
+    }
+    --m_size;
+    return true;
+  }
+
+  /// \brief Erases the smallest value. The bin must not be empty.
+  void pop_front() { erase(front()); }
+
+  bool contains(const value_type value) const {
+    if (m_layers.empty()) return false;
+    const std::size_t word_no = std::size_t(value) / k_word_bits;
+    if (word_no >= m_layers.front().size()) return false;
+    return (m_layers.front()[word_no] >> (value % k_word_bits)) & 1;
+  }
+
+  /// \brief Erases all values. Keeps the allocated bitmap.
+  void clear() {
+    for (auto &layer : m_layers) {
+      std::fill(layer.begin(), layer.end(), word_type(0));
+    }
+    m_size = 0;
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, priv_find_next(0));
+  }
+
+  const_iterator end() const { return const_iterator(this, k_npos); }
+
+ private:
+  static constexpr std::size_t k_npos =
+      std::numeric_limits<std::size_t>::max();
+
+  static std::size_t priv_lowest_bit(const word_type word) {
+    assert(word != 0);
+    return __builtin_ctzll(word);
+  }
+
+  /// \brief Returns the smallest value equal to or larger than 'first';
+  /// returns k_npos if there is no such value.
+  std::size_t priv_find_next(const std::size_t first) const {
+    // 'pos' is the bit number to search from in layer 'l'
+    std::size_t pos = first;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+      const std::size_t word_no = pos / k_word_bits;
+      if (word_no >= m_layers[l].size()) return k_npos;
+      const word_type word =
+          m_layers[l][word_no] & (~word_type(0) << (pos % k_word_bits));
+      if (word != 0) {
+        pos = word_no * k_word_bits + priv_lowest_bit(word);
+        for (std::size_t k = l; k-- > 0;) {
+          pos = pos * k_word_bits + priv_lowest_bit(m_layers[k][pos]);
+        }
+        return pos;
+      }
+      pos = word_no + 1;
+    }
+    return k_npos;
+  }
+
+  /// \brief Makes the bitmap large enough to store 'value'.
+  /// The bitmap is doubled to amortize rebuilding the upper layers.
+  void priv_reserve(const value_type value) {
+    const std::size_t num_words = std::size_t(value) / k_word_bits + 1;
+    if (!m_layers.empty() && m_layers.front().size() >= num_words) return;
+
+    const std::size_t new_num_words = std::max(
+        num_words, m_layers.empty() ? 1 : m_layers.front().size() * 2);
+    if (m_layers.empty()) {
+      m_layers.emplace_back(m_layers.get_allocator());
+    }
+    m_layers.front().resize(new_num_words, word_type(0));
+
+    // Rebuild the upper layers until a layer consists of a single word
+    m_layers.erase(m_layers.begin() + 1, m_layers.end());
+    while (m_layers.back().size() > 1) {
+      const std::size_t lower_size = m_layers.back().size();
+      layer_type upper((lower_size + k_word_bits - 1) / k_word_bits,
+                       word_type(0), m_layers.get_allocator());
+      for (std::size_t i = 0; i < lower_size; ++i) {
+        if (m_layers.back()[i] != 0) {
+          upper[i / k_word_bits] |= word_type(1) << (i % k_word_bits);
+        }
+      }
+      m_layers.emplace_back(std::move(upper));
+    }
+  }
+
+  // The lowest layer has one bit per value
+  layer_list_type m_layers;
+  std::size_t m_size{0};
+};
+
+/// \brief An iterator over the values in ascending order.
+template <typename _value_type, typename _allocator_type>
+class bitmap_bin<_value_type, _allocator_type>::const_iterator {
+ public:
+  using value_type = bitmap_bin::value_type;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+  using pointer = const value_type *;
+  using reference = value_type;
+
+  const_iterator() = default;
+
+  const_iterator(const bitmap_bin *const bin, const std::size_t pos)
+      : m_bin(bin), m_pos(pos) {}
+
+  value_type operator*() const {
+    assert(m_pos != k_npos);
+    return static_cast<value_type>(m_pos);
+  }
+
+  const_iterator &operator++() {
+    assert(m_pos != k_npos);
+    m_pos = m_bin->priv_find_next(m_pos + 1);
+    return *this;
+  }
+
+  const_iterator operator++(int) {
+    const_iterator tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  bool operator==(const const_iterator &other) const {
+    return m_pos == other.m_pos;
+  }
+
+  bool operator!=(const const_iterator &other) const {
+    return !(*this == other);
+  }
+
+ private:
+  const bitmap_bin *m_bin{nullptr};
+  std::size_t m_pos{k_npos};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_BITMAP_BIN_HPP
@@ -0,0 +1,268 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_CHECKPOINT_SERVICE_HPP
+#define METALL_KERNEL_CHECKPOINT_SERVICE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/io_executor.hpp>
+#include <metall/detail/memory.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief The result of a checkpoint, given to
+/// checkpoint_options::on_checkpoint.
+struct checkpoint_report {
+  /// \brief The number of the dirty bytes found in the segment.
+  std::size_t num_dirty_bytes{0};
+  /// \brief The number of the bytes of the ranges written back, including
+  /// the clean pages in the ranges.
+  std::size_t num_written_bytes{0};
+  /// \brief The time from finding the dirty bytes to the end of the write
+  /// back, including throttled_time.
+  std::chrono::nanoseconds latency{0};
+  /// \brief The time spent waiting for the bandwidth cap.
+  std::chrono::nanoseconds throttled_time{0};
+  /// \brief False if writing back failed or the checkpoint was stopped
+  /// before it finished.
+  bool succeeded{true};
+};
+
+/// \brief Options of the background checkpointing.
+struct checkpoint_options {
+  /// \brief The interval between two checks of the dirty bytes.
+  std::chrono::milliseconds interval{1000};
+  /// \brief A checkpoint runs when the segment has at least this number of
+  /// dirty bytes. If 0, runs whenever the segment has dirty bytes.
+  std::size_t dirty_bytes_threshold{0};
+  /// \brief The maximum number of the dirty bytes written back per second,
+  /// enforced by a token bucket that holds one second of writes. If 0,
+  /// unlimited.
+  std::size_t max_bytes_per_second{0};
+  /// \brief The size of a range written back at once.
+  std::size_t slice_size{std::size_t(1) << 22};
+  /// \brief The maximum number of the I/O threads to write back ranges.
+  /// If <= 0 is given, the value is automatically determined.
+  int num_max_threads{1};
+  /// \brief Called with the report of each checkpoint in the background
+  /// thread, e.g., to record the checkpoint latency. Exceptions thrown by it
+  /// are ignored.
+  std::function<void(const checkpoint_report &)> on_checkpoint{};
+};
+
+/// \brief Writes back the dirty pages of a segment periodically in a
+/// background thread. Only the mappings that have dirty pages, found in
+/// /proc/self/smaps, are written back, in slices, through the I/O executor
+/// so that the writes share the per-device queue depth with the other I/O
+/// of Metall. A token bucket caps the dirty bytes written back per second.
+/// If smaps is not available, the whole segment is taken as dirty.
+class checkpoint_service {
+ public:
+  /// \brief Returns the address and the size of the segment.
+  using region_function_type = std::function<std::pair<void *, std::size_t>()>;
+  /// \brief Writes back a range of the segment; must be thread-safe.
+  using write_back_function_type =
+      std::function<bool(void *addr, std::size_t nbytes)>;
+
+  /// \brief Starts the background thread.
+  /// \param options The options.
+  /// \param region A function that returns the segment.
+  /// \param write_back A function that writes back a range.
+  /// \param device_id The ID of the device the segment is stored in.
+  checkpoint_service(checkpoint_options options, region_function_type region,
+                     write_back_function_type write_back,
+                     const mdtl::io_executor::device_id_type device_id =
+                         mdtl::io_executor::k_no_device)
+      : m_options(std::move(options)),
+        m_region(std::move(region)),
+        m_write_back(std::move(write_back)),
+        m_device_id(device_id),
+        m_tokens(double(m_options.max_bytes_per_second)),
+        m_last_refill(clock_type::now()) {
+    m_options.slice_size = std::max(m_options.slice_size, std::size_t(1));
+    try {
+      m_thread = std::make_unique<std::thread>([this]() { priv_run(); });
+    } catch (const std::system_error &) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to start the checkpoint thread");
+      m_thread.reset();
+    }
+  }
+
+  ~checkpoint_service() noexcept { stop(); }
+
+  checkpoint_service(const checkpoint_service &) = delete;
+  checkpoint_service &operator=(const checkpoint_service &) = delete;
+  checkpoint_service(checkpoint_service &&) = delete;
+  checkpoint_service &operator=(checkpoint_service &&) = delete;
+
+  /// \brief Stops the background thread.
+  /// A running checkpoint stops after the ranges being written back.
+  void stop() noexcept {
+    if (!m_thread) return;
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread->join();
+    m_thread.reset();
+  }
+
+  /// \brief Returns true if the background thread is running.
+  bool running() const noexcept { return !!m_thread; }
+
+  /// \brief Returns the number of the checkpoints run.
+  std::size_t num_checkpoints() const noexcept {
+    return m_num_checkpoints.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  struct slice {
+    char *addr;
+    std::size_t size;
+    std::size_t cost;
+  };
+
+  void priv_run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      m_cv.wait_for(lock, m_options.interval, [this]() { return m_stop; });
+      if (m_stop) break;
+      lock.unlock();
+      priv_checkpoint();
+      lock.lock();
+    }
+  }
+
+  void priv_checkpoint() {
+    const auto start = clock_type::now();
+    const auto [segment, size] = m_region();
+    if (!segment || size == 0) return;
+
+    std::vector<mdtl::dirty_mapping> mappings;
+    if (!mdtl::read_dirty_mappings(segment, size, &mappings)) {
+      const auto begin = reinterpret_cast<std::uintptr_t>(segment);
+      mappings.assign(1, mdtl::dirty_mapping{begin, begin + size, size});
+    }
+    checkpoint_report report;
+    for (const auto &mapping : mappings) {
+      report.num_dirty_bytes += mapping.dirty_size;
+    }
+    if (report.num_dirty_bytes == 0 ||
+        report.num_dirty_bytes < m_options.dirty_bytes_threshold) {
+      return;
+    }
+
+    // A slice costs the dirty bytes of its mapping in proportion to its size
+    std::vector<slice> slices;
+    for (const auto &mapping : mappings) {
+      const std::size_t length = mapping.end - mapping.begin;
+      for (std::size_t pos = 0; pos < length; pos += m_options.slice_size) {
+        const auto n = std::min(m_options.slice_size, length - pos);
+        slices.push_back(slice{reinterpret_cast<char *>(mapping.begin + pos), n,
+                               (mapping.dirty_size * n + length - 1) / length});
+      }
+    }
+
+    std::size_t next = 0;
+    while (next < slices.size()) {
+      const auto throttle_start = clock_type::now();
+      if (!priv_wait_for_tokens()) break;  // Stopped
+      report.throttled_time += clock_type::now() - throttle_start;
+
+      // Takes the slices the tokens cover; the tokens may go negative so that
+      // a slice larger than the bucket still proceeds
+      const auto first = next;
+      do {
+        m_tokens -= double(slices[next].cost);
+        report.num_written_bytes += slices[next].size;
+        ++next;
+      } while (next < slices.size() &&
+               (m_options.max_bytes_per_second == 0 || m_tokens > 0));
+
+      report.succeeded &= mdtl::io_executor::instance().parallel_for(
+          next - first, m_options.num_max_threads,
+          [this, &slices, first](const std::size_t i) {
+            const auto &s = slices[first + i];
+            return m_write_back(s.addr, s.size);
+          },
+          m_device_id);
+    }
+    report.succeeded &= (next == slices.size());
+    report.latency = clock_type::now() - start;
+    m_num_checkpoints.fetch_add(1, std::memory_order_relaxed);
+
+    if (!report.succeeded) {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "A checkpoint did not finish");
+    }
+    if (m_options.on_checkpoint) {
+      try {
+        m_options.on_checkpoint(report);
+      } catch (...) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "An exception has been thrown by the checkpoint hook");
+      }
+    }
+  }
+
+  /// \brief Refills the token bucket and waits until it has tokens.
+  /// \return Returns false if stopped while waiting.
+  bool priv_wait_for_tokens() {
+    const double rate = double(m_options.max_bytes_per_second);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      if (rate == 0) return true;
+      const auto now = clock_type::now();
+      const std::chrono::duration<double> elapsed = now - m_last_refill;
+      m_tokens = std::min(rate, m_tokens + elapsed.count() * rate);
+      m_last_refill = now;
+      if (m_tokens > 0) return true;
+      const std::chrono::duration<double> wait((1.0 - m_tokens) / rate);
+      m_cv.wait_for(lock,
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        wait) + std::chrono::microseconds(1),
+                    [this]() { return m_stop; });
+    }
+    return false;
+  }
+
+  checkpoint_options m_options;
+  region_function_type m_region;
+  write_back_function_type m_write_back;
+  const mdtl::io_executor::device_id_type m_device_id;
+  // Token bucket; only the background thread touches them
+  double m_tokens;
+  clock_type::time_point m_last_refill;
+  std::atomic<std::size_t> m_num_checkpoints{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+  std::unique_ptr<std::thread> m_thread{nullptr};
+};
+
+}  // namespace metall::kernel
+#endif  // METALL_KERNEL_CHECKPOINT_SERVICE_HPP
@@ -11,11 +11,24 @@
 #include <cassert>
 #include <type_traits>
 #include <vector>
+#include <map>
+#include <set>
+#include <utility>
+#include <iterator>
 #include <filesystem>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <string>
 
 #include <metall/detail/utilities.hpp>
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/detail/file.hpp>
 #include <metall/detail/mmap.hpp>
+#include <metall/detail/io_executor.hpp>
 #include <metall/kernel/multilayer_bitset.hpp>
+#include <metall/kernel/slot_bitmap_pool.hpp>
 #include <metall/kernel/bin_number_manager.hpp>
 #include <metall/kernel/object_size_manager.hpp>
 #include <metall/logger.hpp>
@@ -29,9 +42,14 @@ namespace mdtl = metall::mtlldetail;
 
 /// \brief Chunk directory class.
 /// Chunk directory is a table that stores information about chunks.
+/// Runs of unused chunks below the last used chunk are kept in a free extent
+/// index so that finding space for a new chunk does not scan the table.
+/// The slot bitsets of small chunks that do not fit in an entry are taken
+/// from a pool that keeps the bitsets of each bin in contiguous slabs.
 /// This class assumes that race condition is handled by the caller.
 template <typename _chunk_no_type, std::size_t _k_chunk_size,
-          std::size_t _k_max_size>
+          std::size_t _k_max_size,
+          typename _size_class_table = default_size_class_table>
 class chunk_directory {
  private:
   // -------------------- //
@@ -39,7 +57,8 @@ class chunk_directory {
   // -------------------- //
   static constexpr std::size_t k_chunk_size = _k_chunk_size;
   static constexpr std::size_t k_max_size = _k_max_size;
-  using bin_no_mngr = bin_number_manager<k_chunk_size, k_max_size>;
+  using bin_no_mngr =
+      bin_number_manager<k_chunk_size, k_max_size, _size_class_table>;
   static constexpr std::size_t k_num_max_slots =
       k_chunk_size / bin_no_mngr::to_object_size(0);
   using multilayer_bitset_type = multilayer_bitset;
@@ -53,6 +72,9 @@ class chunk_directory {
   using slot_no_type = multilayer_bitset_type::bit_position_type;
   using slot_count_type =
       typename mdtl::unsigned_variable_type<k_num_max_slots>::type;
+  using arena_no_type = uint8_t;
+  /// Chunk number -> slot numbers.
+  using slot_list_type = std::map<chunk_no_type, std::vector<slot_no_type>>;
 
  private:
   // -------------------- //
@@ -69,16 +91,57 @@ class chunk_directory {
   struct entry_type {
     void init() {
       type = chunk_type::unused;
+      arena_no = 0;
+      heat = 0;
       num_occupied_slots = 0;
       slot_occupancy.reset();
     }
 
     bin_no_type bin_no;                     // 1 byte
     chunk_type type;                        // 1 byte
+    arena_no_type arena_no;                 // 1 byte, just for small chunk
+    uint8_t heat;                           // 1 byte, see record_access()
     slot_count_type num_occupied_slots;     // 4 bytes, just for small chunk
     multilayer_bitset_type slot_occupancy;  // 8 bytes, just for small chunk
   };
 
+  // Binary file format:
+  // [header][entry x num_entries][bitset block x num_bitset_blocks]
+  // Entries are stored for all chunks in [0, size()).
+  // The arena numbers of small chunks are not stored.
+  // The heat of each used chunk is stored in a byte that version 2 files
+  // written before it was added have as 0, i.e., cold.
+  // The bitset blocks of small chunks are stored in the chunk number order.
+  // Version 1 and the text format used the power-of-two large sizes; their
+  // large bin numbers are converted when they are read.
+  static constexpr char k_binary_format_magic[8] = {'M', 'T', 'L', 'L',
+                                                    'C', 'D', 'I', 'R'};
+  static constexpr uint64_t k_binary_format_version = 2;
+  static constexpr uint64_t k_power_of_two_large_sizes_format_version = 1;
+
+  struct binary_file_header {
+    char magic[8];
+    uint64_t format_version;
+    uint64_t num_entries;
+    uint64_t num_bitset_blocks;
+  };
+
+  struct binary_entry_type {
+    uint16_t bin_no;
+    uint8_t type;
+    uint8_t heat{0};
+    uint32_t num_occupied_slots;
+  };
+  static_assert(sizeof(binary_file_header) % sizeof(uint64_t) == 0,
+                "The header size must be a multiple of 8 bytes");
+  static_assert(sizeof(binary_entry_type) == 8,
+                "Unexpected binary entry size");
+  static_assert(k_num_max_slots <= std::numeric_limits<uint32_t>::max(),
+                "Too many slots for the binary format");
+
+  // The number of the entries each thread parses at a time
+  static constexpr std::size_t k_deserialization_range_size = 1ULL << 16ULL;
+
  public:
   // -------------------- //
   // Constructor & assign operator
@@ -89,7 +152,8 @@ class chunk_directory {
   explicit chunk_directory(const std::size_t max_num_chunks)
       : m_table(nullptr),
         m_max_num_chunks(max_num_chunks),
-        m_last_used_chunk_no(-1) {
+        m_last_used_chunk_no(-1),
+        m_slot_bitmap_pool(bin_no_mngr::num_small_bins()) {
     priv_allocate();
   }
 
@@ -107,12 +171,15 @@ class chunk_directory {
   /// \brief Registers a new chunk for a bin whose bin number is 'bin_no'.
   /// Requires a global lock to avoid race condition.
   /// \param bin_no Bin number.
+  /// \param arena_no The number of the arena that owns the chunk.
+  /// Used only for a small chunk.
   /// \return Returns the chunk number of the new chunk.
-  chunk_no_type insert(const bin_no_type bin_no) {
+  chunk_no_type insert(const bin_no_type bin_no,
+                       const arena_no_type arena_no = 0) {
     chunk_no_type inserted_chunk_no;
 
     if (bin_no < bin_no_mngr::num_small_bins()) {
-      inserted_chunk_no = priv_insert_small_chunk(bin_no);
+      inserted_chunk_no = priv_insert_small_chunk(bin_no, arena_no);
     } else {
       inserted_chunk_no = priv_insert_large_chunk(bin_no);
     }
@@ -121,6 +188,46 @@ class chunk_directory {
     return inserted_chunk_no;
   }
 
+  /// \brief Registers a new large chunk whose chunk number is a multiple of
+  /// 'chunk_alignment'. Free extents are searched for an aligned run of
+  /// chunks before the chunks after the last used chunk are taken.
+  /// Requires a global lock to avoid race condition.
+  /// \param bin_no A bin number for large objects.
+  /// \param chunk_alignment A power of two.
+  /// \return Returns the chunk number of the new chunk.
+  /// Returns the maximum number of chunks on failure.
+  chunk_no_type insert_aligned(const bin_no_type bin_no,
+                               const std::size_t chunk_alignment) {
+    assert(bin_no >= bin_no_mngr::num_small_bins());
+    assert(chunk_alignment > 0 &&
+           (chunk_alignment & (chunk_alignment - 1)) == 0);
+    const std::size_t num_chunks = priv_num_large_chunks(bin_no);
+    const chunk_no_type head_chunk_no =
+        priv_find_aligned_chunks(num_chunks, chunk_alignment);
+    if (head_chunk_no == m_max_num_chunks ||
+        !priv_claim_chunks_in(head_chunk_no, num_chunks)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No available space for aligned large allocation");
+      return m_max_num_chunks;
+    }
+    priv_set_large_chunk(head_chunk_no, bin_no, num_chunks);
+    return head_chunk_no;
+  }
+
+  /// \brief Registers a new large chunk at 'chunk_no', e.g., to replay
+  /// insert_aligned().
+  /// Requires a global lock to avoid race condition.
+  /// \param chunk_no The head chunk number of the new chunk.
+  /// \param bin_no A bin number for large objects.
+  /// \return Returns false if any of the chunks is used.
+  bool insert_at(const chunk_no_type chunk_no, const bin_no_type bin_no) {
+    assert(bin_no >= bin_no_mngr::num_small_bins());
+    const std::size_t num_chunks = priv_num_large_chunks(bin_no);
+    if (!priv_claim_chunks_in(chunk_no, num_chunks)) return false;
+    priv_set_large_chunk(chunk_no, bin_no, num_chunks);
+    return true;
+  }
+
   /// \brief Erases a chunk whose chunk number is 'chunk_no'.
   /// Requires a global lock to avoid race condition.
   /// \param chunk_no Chunk number to erase.
@@ -129,14 +236,9 @@ class chunk_directory {
     if (unused_chunk(chunk_no)) return;
 
     if (m_table[chunk_no].type == chunk_type::small_chunk) {
-      const slot_count_type num_slots = slots(chunk_no);
-      m_table[chunk_no].slot_occupancy.free(num_slots);
+      priv_free_slot_occupancy(chunk_no);
       m_table[chunk_no].init();
-
-      if (chunk_no == m_last_used_chunk_no) {
-        m_last_used_chunk_no = find_next_used_chunk_backward(chunk_no);
-      }
-
+      priv_release_chunks(chunk_no, 1);
     } else {
       m_table[chunk_no].init();
       chunk_no_type offset = 1;
@@ -145,12 +247,48 @@ class chunk_directory {
            ++offset) {
         m_table[chunk_no + offset].init();
       }
+      priv_release_chunks(chunk_no, offset);
+    }
+  }
 
-      const chunk_no_type last_chunk_no = chunk_no + offset - 1;
-      if (last_chunk_no == m_last_used_chunk_no) {
-        m_last_used_chunk_no = find_next_used_chunk_backward(last_chunk_no);
+  /// \brief Changes the bin of a large chunk without moving it.
+  /// If the new bin is larger, the chunks right after the current ones must be
+  /// unused; they are taken as the body of the chunk. If the new bin is
+  /// smaller, the tail chunks are released.
+  /// Requires a global lock to avoid race condition.
+  /// \param chunk_no The head chunk number of a large chunk.
+  /// \param new_bin_no A bin number for large objects.
+  /// \return Returns true on success. Returns false if the chunks to grow into
+  /// are used.
+  bool resize_large_chunk(const chunk_no_type chunk_no,
+                          const bin_no_type new_bin_no) {
+    assert(m_table[chunk_no].type == chunk_type::large_chunk_head);
+    assert(new_bin_no >= bin_no_mngr::num_small_bins());
+
+    const std::size_t old_num_chunks =
+        priv_num_large_chunks(m_table[chunk_no].bin_no);
+    const std::size_t new_num_chunks = priv_num_large_chunks(new_bin_no);
+
+    if (new_num_chunks > old_num_chunks) {
+      if (!priv_claim_chunks_at(chunk_no + old_num_chunks,
+                                new_num_chunks - old_num_chunks)) {
+        return false;
       }
+    } else if (new_num_chunks < old_num_chunks) {
+      for (std::size_t offset = new_num_chunks; offset < old_num_chunks;
+           ++offset) {
+        m_table[chunk_no + offset].init();
+      }
+      priv_release_chunks(chunk_no + new_num_chunks,
+                          old_num_chunks - new_num_chunks);
     }
+
+    m_table[chunk_no].bin_no = new_bin_no;
+    for (std::size_t offset = 1; offset < new_num_chunks; ++offset) {
+      m_table[chunk_no + offset].bin_no = new_bin_no;  // just in case
+      m_table[chunk_no + offset].type = chunk_type::large_chunk_body;
+    }
+    return true;
   }
 
   /// \brief Finds an available slot in the chunk whose chunk number is
@@ -201,6 +339,59 @@ class chunk_directory {
     return num_slots_to_find;
   }
 
+  /// \brief Reserves up to 'num_slots' slots in the chunk using an atomic
+  /// operation. Each reserved slot must be marked by
+  /// find_and_mark_reserved_slot_concurrently() afterwards.
+  /// Multiple threads can reserve and mark slots in the same chunk
+  /// concurrently as long as no thread unmarks slots in the chunk at the same
+  /// time.
+  /// \param chunk_no Chunk number of a small chunk.
+  /// \param num_slots Number of slots to reserve.
+  /// \return Number of reserved slots.
+  /// This number can be less than 'num_slots' (or zero) if there are not
+  /// enough available slots in the chunk.
+  std::size_t reserve_slots_concurrently(const chunk_no_type chunk_no,
+                                         const std::size_t num_slots) {
+    assert(m_table[chunk_no].type == chunk_type::small_chunk);
+
+    const slot_count_type num_holding_slots = slots(chunk_no);
+    slot_count_type *const num_occupied_slots =
+        &m_table[chunk_no].num_occupied_slots;
+    slot_count_type current = mdtl::atomic_load(num_occupied_slots);
+    while (true) {
+      assert(current <= num_holding_slots);
+      const auto num_to_reserve = static_cast<slot_count_type>(std::min(
+          num_slots, static_cast<std::size_t>(num_holding_slots - current)));
+      if (num_to_reserve == 0) return 0;
+      if (mdtl::atomic_compare_exchange(
+              num_occupied_slots, &current,
+              static_cast<slot_count_type>(current + num_to_reserve))) {
+        return num_to_reserve;
+      }
+    }
+  }
+
+  /// \brief Finds an available slot and marks it as occupied using atomic
+  /// operations. The slot must have been reserved by
+  /// reserve_slots_concurrently().
+  /// \param chunk_no Chunk number of a small chunk.
+  /// \return Returns the marked slot number.
+  slot_no_type find_and_mark_reserved_slot_concurrently(
+      const chunk_no_type chunk_no) {
+    assert(m_table[chunk_no].type == chunk_type::small_chunk);
+    return m_table[chunk_no].slot_occupancy.find_and_set_concurrently(
+        slots(chunk_no));
+  }
+
+  /// \brief Marks all slots in a small chunk as occupied.
+  /// \param chunk_no Chunk number of a small chunk.
+  void mark_all_slots(const chunk_no_type chunk_no) {
+    assert(m_table[chunk_no].type == chunk_type::small_chunk);
+    while (!all_slots_marked(chunk_no)) {
+      find_and_mark_slot(chunk_no);
+    }
+  }
+
   /// \brief
   /// \param chunk_no
   /// \param slot_no
@@ -276,6 +467,15 @@ class chunk_directory {
     return m_table[chunk_no].bin_no;
   }
 
+  /// \brief Returns the number of the arena that owns a small chunk.
+  /// Chunks loaded from a file belong to arena 0.
+  /// \param chunk_no Chunk number of a small chunk.
+  /// \return The arena number.
+  arena_no_type arena_no(const chunk_no_type chunk_no) const {
+    assert(m_table[chunk_no].type == chunk_type::small_chunk);
+    return m_table[chunk_no].arena_no;
+  }
+
   /// \brief
   /// \param chunk_no
   /// \return
@@ -294,163 +494,114 @@ class chunk_directory {
     return m_table[chunk_no].num_occupied_slots;
   }
 
-  /// \brief
-  /// \param path
-  bool serialize(const fs::path &path) const {
-    std::ofstream ofs(path);
-    if (!ofs.is_open()) {
-      std::stringstream ss;
-      ss << "Cannot open: " << path;
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
-      return false;
-    }
-
-    for (chunk_no_type chunk_no = 0; chunk_no < size(); ++chunk_no) {
-      if (unused_chunk(chunk_no)) {
-        continue;
-      }
+  /// \brief Returns the access heat of a used chunk: the history of the last
+  /// 8 samples recorded by record_access(), one bit per sample, the most
+  /// significant bit being the latest one. 0 means the chunk has not been
+  /// accessed in any of them, e.g., a chunk never sampled.
+  /// \param chunk_no Chunk number. Must be less than size().
+  uint8_t heat(const chunk_no_type chunk_no) const {
+    return m_table[chunk_no].heat;
+  }
 
-      ofs << static_cast<uint64_t>(chunk_no) << " "
-          << static_cast<uint64_t>(m_table[chunk_no].bin_no) << " "
-          << static_cast<uint64_t>(m_table[chunk_no].type);
-      if (!ofs) {
-        std::stringstream ss;
-        ss << "Something happened in the ofstream: " << path;
-        logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
-        return false;
-      }
+  /// \brief Records whether a used chunk has been accessed since the
+  /// previous sample, shifting out the oldest sample of its heat.
+  /// The heat is reset when the chunk is freed.
+  /// \param chunk_no Chunk number of a used chunk.
+  /// \param accessed True if the chunk has been accessed.
+  void record_access(const chunk_no_type chunk_no, const bool accessed) {
+    assert(m_table[chunk_no].type != chunk_type::unused);
+    auto &heat = m_table[chunk_no].heat;
+    heat = static_cast<uint8_t>((heat >> 1U) | (accessed ? 0x80U : 0U));
+  }
 
+  /// \brief Serializes the directory into a file using the binary format.
+  /// \param path A file path to write.
+  /// \param released_slots If not null, the listed slots are stored as free
+  /// slots, i.e., the file looks as if they were deallocated. Small chunks
+  /// that have no other occupied slots are stored as unused chunks.
+  /// The directory itself is not changed.
+  /// \return Returns true on success; otherwise, false.
+  bool serialize(const fs::path &path,
+                 const slot_list_type *const released_slots = nullptr) const {
+    binary_file_header header;
+    std::copy_n(k_binary_format_magic, sizeof(header.magic), header.magic);
+    header.format_version = k_binary_format_version;
+    header.num_entries = size();
+    header.num_bitset_blocks = 0;
+
+    std::vector<binary_entry_type> entries(header.num_entries);
+    for (chunk_no_type chunk_no = 0; chunk_no < size(); ++chunk_no) {
+      entries[chunk_no].bin_no = m_table[chunk_no].bin_no;
+      entries[chunk_no].type = m_table[chunk_no].type;
+      entries[chunk_no].heat = m_table[chunk_no].heat;
+      entries[chunk_no].num_occupied_slots = 0;
       if (m_table[chunk_no].type == chunk_type::small_chunk) {
-        const slot_count_type num_slots = slots(chunk_no);
-        ofs << " "
-            << static_cast<uint64_t>(m_table[chunk_no].num_occupied_slots)
-            << " " << m_table[chunk_no].slot_occupancy.serialize(num_slots)
-            << "\n";
-        if (!ofs) {
-          std::stringstream ss;
-          ss << "Something happened in the ofstream: " << path;
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
-        }
-
-      } else if (m_table[chunk_no].type == chunk_type::large_chunk_head ||
-                 m_table[chunk_no].type == chunk_type::large_chunk_body) {
-        ofs << "\n";
-        if (!ofs) {
-          std::stringstream ss;
-          ss << "Something happened in the ofstream: " << path;
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
+        const auto num_released_slots =
+            priv_num_released_slots(chunk_no, released_slots);
+        const auto num_occupied_slots =
+            m_table[chunk_no].num_occupied_slots - num_released_slots;
+        if (num_released_slots > 0 && num_occupied_slots == 0) {
+          entries[chunk_no].type = chunk_type::unused;
+          entries[chunk_no].heat = 0;
+          continue;
         }
+        entries[chunk_no].num_occupied_slots = num_occupied_slots;
+        header.num_bitset_blocks +=
+            multilayer_bitset_type::num_blocks(slots(chunk_no));
+      }
+    }
 
-      } else {
-        logger::out(logger::level::error, __FILE__, __LINE__,
-                    "Unexpected chunk status");
+    std::vector<uint64_t> blocks(header.num_bitset_blocks);
+    std::size_t pos = 0;
+    for (chunk_no_type chunk_no = 0; chunk_no < size(); ++chunk_no) {
+      if (entries[chunk_no].type != chunk_type::small_chunk) continue;
+      const slot_count_type num_slots = slots(chunk_no);
+      if (priv_num_released_slots(chunk_no, released_slots) == 0) {
+        m_table[chunk_no].slot_occupancy.serialize(num_slots, &blocks[pos]);
+      } else if (!priv_serialize_without_released_slots(
+                     chunk_no, released_slots->at(chunk_no), &blocks[pos])) {
         return false;
       }
+      pos += multilayer_bitset_type::num_blocks(num_slots);
     }
 
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+      METALL_LOG(logger::level::error, "Cannot open: " << path);
+      return false;
+    }
+
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(entries.data()),
+              entries.size() * sizeof(binary_entry_type));
+    ofs.write(reinterpret_cast<const char *>(blocks.data()),
+              blocks.size() * sizeof(uint64_t));
+    if (!ofs) {
+      METALL_LOG(logger::level::error, "Something happened in the ofstream: "
+                 << path);
+      return false;
+    }
     ofs.close();
 
     return true;
   }
 
-  /// \brief
-  /// \param path
-  /// \return
+  /// \brief Deserializes the directory from a file.
+  /// Both the binary format and the older text format are accepted.
+  /// \param path A file path to read.
+  /// \return Returns true on success; otherwise, false.
   bool deserialize(const fs::path &path) {
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
-      std::stringstream ss;
-      ss << "Cannot open: " << path;
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    if (!mdtl::file_exist(path)) {
+      METALL_LOG(logger::level::error, "Cannot open: " << path);
       return false;
     }
 
-    uint64_t buf1;
-    uint64_t buf2;
-    uint64_t buf3;
-    while (ifs >> buf1 >> buf2 >> buf3) {
-      const auto chunk_no = static_cast<chunk_no_type>(buf1);
-      const auto bin_no = static_cast<bin_no_type>(buf2);
-      m_table[chunk_no].bin_no = bin_no;
-
-      using status_underlying_type = std::underlying_type_t<chunk_type>;
-      const auto type = static_cast<status_underlying_type>(buf3);
-      if (type ==
-          static_cast<status_underlying_type>(chunk_type::small_chunk)) {
-        m_table[chunk_no].type = chunk_type::small_chunk;
-      } else if (type == static_cast<status_underlying_type>(
-                             chunk_type::large_chunk_head)) {
-        m_table[chunk_no].type = chunk_type::large_chunk_head;
-      } else if (type == static_cast<status_underlying_type>(
-                             chunk_type::large_chunk_body)) {
-        m_table[chunk_no].type = chunk_type::large_chunk_body;
-      } else {
-        logger::out(logger::level::error, __FILE__, __LINE__,
-                    "Invalid chunk type");
-        return false;
-      }
-
-      if (m_table[chunk_no].type == chunk_type::small_chunk) {
-        const slot_count_type num_slots =
-            calc_num_slots(bin_no_mngr::to_object_size(bin_no));
-        if (!(ifs >> buf1)) {
-          std::stringstream ss;
-          ss << "Cannot read a file: " << path;
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
-        }
-        if (num_slots < buf1) {
-          std::stringstream ss;
-          ss << "Invalid num_occupied_slots: " << std::to_string(buf1);
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
-        }
-        m_table[chunk_no].num_occupied_slots = buf1;
-
-        std::string bitset_buf;
-        std::getline(ifs, bitset_buf);
-        if (bitset_buf.empty() || bitset_buf[0] != ' ') {
-          std::stringstream ss;
-          ss << "Invalid input for slot_occupancy: " << bitset_buf;
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
-        }
-        bitset_buf.erase(0, 1);
-
-        if (!m_table[chunk_no].slot_occupancy.allocate(num_slots)) {
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      "Failed to allocate slot occupancy data");
-          return false;
-        }
-
-        if (!m_table[chunk_no].slot_occupancy.deserialize(num_slots,
-                                                          bitset_buf)) {
-          std::stringstream ss;
-          ss << "Invalid input for slot_occupancy: " << bitset_buf;
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      ss.str().c_str());
-          return false;
-        }
-      }
-
-      m_last_used_chunk_no = std::max((ssize_t)chunk_no, m_last_used_chunk_no);
-    }
-
-    if (!ifs.eof()) {
-      std::stringstream ss;
-      ss << "Something happened in the ifstream: " << path;
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
-      return false;
-    }
+    const bool ret = priv_binary_format_file(path)
+                         ? priv_deserialize_binary(path)
+                         : priv_deserialize_text(path);
+    if (!ret) return false;
 
-    ifs.close();
+    priv_rebuild_free_extent_index();
 
     return true;
   }
@@ -474,6 +625,14 @@ class chunk_directory {
     return buf;
   }
 
+  /// \brief Returns the number of runs of unused chunks below the last used
+  /// chunk, i.e., the number of holes in the directory.
+  /// \return The number of free extents.
+  std::size_t num_free_extents() const {
+    assert(m_free_extents_by_address.size() == m_free_extents_by_length.size());
+    return m_free_extents_by_address.size();
+  }
+
   std::size_t num_used_large_chunks() const {
     std::size_t count = 0;
     for (chunk_no_type chunk_no = 0; chunk_no < size(); ++chunk_no) {
@@ -486,6 +645,50 @@ class chunk_directory {
     return count;
   }
 
+  /// \brief Returns true if a chunk is the first chunk of a large object.
+  /// \param chunk_no Chunk number. Must be less than size().
+  bool large_head_chunk(const chunk_no_type chunk_no) const {
+    return m_table[chunk_no].type == chunk_type::large_chunk_head;
+  }
+
+  /// \brief Checks if the entries are consistent, e.g., after a directory is
+  /// read from a file that could be broken.
+  /// The number of occupied slots of each small chunk must be the number of
+  /// the marked slots; each large object must consist of a head chunk and the
+  /// body chunks its bin needs.
+  /// Disjoint ranges of the chunks are checked in parallel.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param problems A pointer to append the descriptions of the problems.
+  /// \return Returns true if no problem is found; otherwise, false.
+  bool check(const int max_num_threads,
+             std::vector<std::string> *const problems) const {
+    const std::size_t num_ranges =
+        (size() + k_deserialization_range_size - 1) /
+        k_deserialization_range_size;
+    std::vector<std::vector<std::string>> range_problems(num_ranges);
+    mdtl::io_executor::instance().parallel_for(
+        num_ranges, max_num_threads, [&](const std::size_t range_no) {
+          const chunk_no_type end = static_cast<chunk_no_type>(
+              std::min<std::size_t>((range_no + 1) *
+                                        k_deserialization_range_size,
+                                    size()));
+          for (auto chunk_no = static_cast<chunk_no_type>(
+                   range_no * k_deserialization_range_size);
+               chunk_no < end; ++chunk_no) {
+            priv_check_chunk(chunk_no, &range_problems[range_no]);
+          }
+          return true;
+        });
+
+    bool ok = true;
+    for (auto &list : range_problems) {
+      ok &= list.empty();
+      std::move(list.begin(), list.end(), std::back_inserter(*problems));
+    }
+    return ok;
+  }
+
  private:
   // -------------------- //
   // Private types and static values
@@ -522,6 +725,8 @@ class chunk_directory {
     }
 
     m_last_used_chunk_no = -1;
+    m_free_extents_by_address.clear();
+    m_free_extents_by_length.clear();
     return true;
   }
 
@@ -537,13 +742,16 @@ class chunk_directory {
     mdtl::os_munmap(m_table, m_max_num_chunks * sizeof(entry_type));
     m_table = nullptr;
     m_last_used_chunk_no = -1;
+    m_free_extents_by_address.clear();
+    m_free_extents_by_length.clear();
   }
 
   /// \brief
   /// \param bin_no
-  /// \param num_slots
+  /// \param arena_no
   /// \return
-  chunk_no_type priv_insert_small_chunk(const bin_no_type bin_no) {
+  chunk_no_type priv_insert_small_chunk(const bin_no_type bin_no,
+                                        const arena_no_type arena_no) {
     const slot_count_type num_slots =
         calc_num_slots(bin_no_mngr::to_object_size(bin_no));
     assert(num_slots > 1);
@@ -553,28 +761,26 @@ class chunk_directory {
       return m_max_num_chunks;
     }
 
-    for (chunk_no_type chunk_no = 0; chunk_no < m_max_num_chunks; ++chunk_no) {
-      if (chunk_no > m_last_used_chunk_no || unused_chunk(chunk_no)) {
-        m_table[chunk_no].init();  // init just in case
-
-        m_table[chunk_no].bin_no = bin_no;
-        m_table[chunk_no].type = chunk_type::small_chunk;
-        m_table[chunk_no].num_occupied_slots = 0;
-        if (!m_table[chunk_no].slot_occupancy.allocate(num_slots)) {
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      "Failed to allocates slot occupancy data");
-          return m_max_num_chunks;
-        }
-
-        m_last_used_chunk_no =
-            std::max((ssize_t)chunk_no, m_last_used_chunk_no);
+    const chunk_no_type chunk_no = priv_claim_chunks(1);
+    if (chunk_no == m_max_num_chunks) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No empty chunk for small allocation");
+      return m_max_num_chunks;
+    }
 
-        return chunk_no;
-      }
+    m_table[chunk_no].bin_no = bin_no;
+    m_table[chunk_no].type = chunk_type::small_chunk;
+    m_table[chunk_no].arena_no = arena_no;
+    m_table[chunk_no].num_occupied_slots = 0;
+    if (!priv_allocate_slot_occupancy(chunk_no)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to allocates slot occupancy data");
+      m_table[chunk_no].init();
+      priv_release_chunks(chunk_no, 1);
+      return m_max_num_chunks;
     }
-    logger::out(logger::level::error, __FILE__, __LINE__,
-                "No empty chunk for small allocation");
-    return m_max_num_chunks;
+
+    return chunk_no;
   }
 
   /// \brief
@@ -585,52 +791,637 @@ class chunk_directory {
         (bin_no_mngr::to_object_size(bin_no) + k_chunk_size - 1) / k_chunk_size;
     assert(num_chunks >= 1);
 
-    chunk_no_type count_continuous_empty_chunks = 0;
-    for (chunk_no_type chunk_no = 0; chunk_no < m_max_num_chunks; ++chunk_no) {
-      if (chunk_no > m_last_used_chunk_no) {
-        // Initialize (empty) it before just in case
-        m_table[chunk_no].init();
+    const chunk_no_type top_chunk_no = priv_claim_chunks(num_chunks);
+    if (top_chunk_no == m_max_num_chunks) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No available space for large allocation, which requires "
+                  "multiple contiguous chunks");
+      return m_max_num_chunks;
+    }
+
+    priv_set_large_chunk(top_chunk_no, bin_no, num_chunks);
+
+    return top_chunk_no;
+  }
+
+  void priv_set_large_chunk(const chunk_no_type head_chunk_no,
+                            const bin_no_type bin_no,
+                            const std::size_t num_chunks) {
+    m_table[head_chunk_no].bin_no = bin_no;
+    m_table[head_chunk_no].type = chunk_type::large_chunk_head;
+    for (chunk_no_type offset = 1; offset < num_chunks; ++offset) {
+      m_table[head_chunk_no + offset].bin_no = bin_no;  // just in case
+      m_table[head_chunk_no + offset].type = chunk_type::large_chunk_body;
+    }
+  }
+
+  /// \brief Finds 'num_chunks' contiguous unused chunks and reserves them.
+  /// Takes the shortest free extent that is long enough (the one with the
+  /// lowest address among equally long ones). If there is no such extent,
+  /// takes the chunks right after the last used chunk.
+  /// The reserved chunks are initialized but their types are not set.
+  /// \param num_chunks The number of contiguous chunks to reserve.
+  /// \return The first chunk number of the reserved chunks.
+  /// Returns m_max_num_chunks on failure.
+  chunk_no_type priv_claim_chunks(const std::size_t num_chunks) {
+    chunk_no_type head_chunk_no;
+    auto itr = m_free_extents_by_length.lower_bound(
+        std::make_pair(num_chunks, chunk_no_type(0)));
+    if (itr != m_free_extents_by_length.end()) {
+      const std::size_t extent_length = itr->first;
+      head_chunk_no = itr->second;
+      priv_erase_free_extent(head_chunk_no, extent_length);
+      if (extent_length > num_chunks) {
+        priv_insert_free_extent(head_chunk_no + num_chunks,
+                                extent_length - num_chunks);
+      }
+    } else {
+      head_chunk_no = m_last_used_chunk_no + 1;
+      if (head_chunk_no + num_chunks > m_max_num_chunks) {
+        return m_max_num_chunks;
       }
+      m_last_used_chunk_no = head_chunk_no + num_chunks - 1;
+    }
 
-      if (chunk_no <= m_last_used_chunk_no && !unused_chunk(chunk_no)) {
-        count_continuous_empty_chunks = 0;
-        continue;
+    for (std::size_t i = 0; i < num_chunks; ++i) {
+      m_table[head_chunk_no + i].init();
+    }
+
+    return head_chunk_no;
+  }
+
+  /// \brief Reserves 'num_chunks' contiguous unused chunks starting at
+  /// 'head_chunk_no', whose previous chunk is used.
+  /// The reserved chunks are initialized but their types are not set.
+  /// \return Returns false if any of the chunks is used.
+  bool priv_claim_chunks_at(const chunk_no_type head_chunk_no,
+                            const std::size_t num_chunks) {
+    assert(head_chunk_no > 0 && !unused_chunk(head_chunk_no - 1));
+
+    if ((ssize_t)head_chunk_no > m_last_used_chunk_no) {
+      assert((ssize_t)head_chunk_no == m_last_used_chunk_no + 1);
+      if (head_chunk_no + num_chunks > m_max_num_chunks) {
+        return false;
+      }
+      m_last_used_chunk_no = head_chunk_no + num_chunks - 1;
+    } else {
+      // As the previous chunk is used, a free extent that contains
+      // 'head_chunk_no' must start with it
+      const auto itr = m_free_extents_by_address.find(head_chunk_no);
+      if (itr == m_free_extents_by_address.end() || itr->second < num_chunks) {
+        return false;
+      }
+      const std::size_t extent_length = itr->second;
+      priv_erase_free_extent(head_chunk_no, extent_length);
+      if (extent_length > num_chunks) {
+        priv_insert_free_extent(head_chunk_no + num_chunks,
+                                extent_length - num_chunks);
+      }
+    }
+
+    for (std::size_t i = 0; i < num_chunks; ++i) {
+      m_table[head_chunk_no + i].init();
+    }
+    return true;
+  }
+
+  /// \brief Finds 'num_chunks' contiguous unused chunks whose first chunk
+  /// number is a multiple of 'chunk_alignment'. Takes the shortest free
+  /// extent that contains such chunks. If there is no such extent, takes the
+  /// aligned chunks after the last used chunk.
+  /// \return The first chunk number of the chunks found.
+  /// Returns m_max_num_chunks on failure.
+  chunk_no_type priv_find_aligned_chunks(
+      const std::size_t num_chunks, const std::size_t chunk_alignment) const {
+    for (auto itr = m_free_extents_by_length.lower_bound(
+             std::make_pair(num_chunks, chunk_no_type(0)));
+         itr != m_free_extents_by_length.end(); ++itr) {
+      const std::size_t head =
+          mdtl::round_up(int64_t(itr->second), int64_t(chunk_alignment));
+      if (head + num_chunks <= itr->second + itr->first) return head;
+    }
+
+    const std::size_t head =
+        mdtl::round_up(m_last_used_chunk_no + 1, int64_t(chunk_alignment));
+    if (head + num_chunks > m_max_num_chunks) return m_max_num_chunks;
+    return head;
+  }
+
+  /// \brief Reserves 'num_chunks' contiguous unused chunks starting at
+  /// 'head_chunk_no'. Unlike priv_claim_chunks_at(), the chunks can be in the
+  /// middle of a free extent or beyond the chunk after the last used chunk;
+  /// the unused chunks left before them become free extents.
+  /// The reserved chunks are initialized but their types are not set.
+  /// \return Returns false if any of the chunks is used.
+  bool priv_claim_chunks_in(const chunk_no_type head_chunk_no,
+                            const std::size_t num_chunks) {
+    if ((ssize_t)head_chunk_no > m_last_used_chunk_no) {
+      if (head_chunk_no + num_chunks > m_max_num_chunks) {
+        return false;
+      }
+      // The chunk before the gap is used; thus, no extent to merge with
+      const chunk_no_type gap_head = m_last_used_chunk_no + 1;
+      if (head_chunk_no > gap_head) {
+        priv_insert_free_extent(gap_head, head_chunk_no - gap_head);
       }
+      m_last_used_chunk_no = head_chunk_no + num_chunks - 1;
+    } else {
+      auto itr = m_free_extents_by_address.upper_bound(head_chunk_no);
+      if (itr == m_free_extents_by_address.begin()) return false;
+      --itr;
+      const chunk_no_type extent_head = itr->first;
+      const std::size_t extent_length = itr->second;
+      if (extent_head + extent_length < head_chunk_no + num_chunks) {
+        return false;
+      }
+      priv_erase_free_extent(extent_head, extent_length);
+      if (head_chunk_no > extent_head) {
+        priv_insert_free_extent(extent_head, head_chunk_no - extent_head);
+      }
+      const std::size_t tail = head_chunk_no + num_chunks;
+      if (extent_head + extent_length > tail) {
+        priv_insert_free_extent(tail, extent_head + extent_length - tail);
+      }
+    }
 
-      ++count_continuous_empty_chunks;
-      if (count_continuous_empty_chunks == num_chunks) {
-        const chunk_no_type top_chunk_no =
-            chunk_no - (count_continuous_empty_chunks - 1);
-        m_table[top_chunk_no].bin_no = bin_no;
-        m_table[top_chunk_no].type = chunk_type::large_chunk_head;
+    for (std::size_t i = 0; i < num_chunks; ++i) {
+      m_table[head_chunk_no + i].init();
+    }
+    return true;
+  }
+
+  /// \brief Gives the slot bitset of a small chunk its blocks.
+  /// Can be called for different chunks concurrently.
+  bool priv_allocate_slot_occupancy(const chunk_no_type chunk_no) {
+    const slot_count_type num_slots = slots(chunk_no);
+    auto &bitset = m_table[chunk_no].slot_occupancy;
+    if (num_slots <= multilayer_bitset_type::block_size()) {
+      bitset.assign(num_slots, nullptr);
+      return true;
+    }
+    const auto num_blocks = multilayer_bitset_type::num_blocks(num_slots);
+    auto *const blocks =
+        m_slot_bitmap_pool.allocate(m_table[chunk_no].bin_no, num_blocks);
+    if (!blocks) return false;
+    bitset.assign(num_slots, blocks);
+    return true;
+  }
+
+  void priv_free_slot_occupancy(const chunk_no_type chunk_no) {
+    m_slot_bitmap_pool.deallocate(
+        m_table[chunk_no].bin_no,
+        m_table[chunk_no].slot_occupancy.release(slots(chunk_no)));
+  }
+
+  static constexpr std::size_t priv_num_large_chunks(
+      const bin_no_type bin_no) {
+    return (bin_no_mngr::to_object_size(bin_no) + k_chunk_size - 1) /
+           k_chunk_size;
+  }
 
-        for (chunk_no_type offset = 1; offset < num_chunks; ++offset) {
-          m_table[top_chunk_no + offset].bin_no = bin_no;  // just in case
-          m_table[top_chunk_no + offset].type = chunk_type::large_chunk_body;
+  /// \brief Converts a large bin number of the older formats, in which the
+  /// large sizes were the chunk size times powers of two, to the bin number of
+  /// the same size. The new large sizes include all of them.
+  /// An invalid bin number is returned as it is, to be found by check().
+  static bin_no_type priv_from_power_of_two_large_bin_no(
+      const uint64_t bin_no) {
+    if (bin_no < bin_no_mngr::num_small_bins()) {
+      return static_cast<bin_no_type>(bin_no);
+    }
+    const uint64_t shift = bin_no - bin_no_mngr::num_small_bins();
+    if (shift >= 64 || (k_max_size / k_chunk_size) >> shift == 0) {
+      return static_cast<bin_no_type>(bin_no);
+    }
+    return bin_no_mngr::to_bin_no(k_chunk_size << shift);
+  }
+
+  void priv_check_chunk(const chunk_no_type chunk_no,
+                        std::vector<std::string> *const problems) const {
+    const entry_type &entry = m_table[chunk_no];
+    const auto add_problem = [chunk_no, problems](const std::string &what) {
+      problems->push_back("Chunk " + std::to_string(chunk_no) + ": " + what);
+    };
+    const bool small_bin = entry.bin_no < bin_no_mngr::num_small_bins();
+    const bool valid_bin = entry.bin_no < bin_no_mngr::num_bins();
+
+    switch (entry.type) {
+      case chunk_type::unused:
+        return;
+
+      case chunk_type::small_chunk: {
+        if (!small_bin) {
+          add_problem("A small chunk has a large bin number " +
+                      std::to_string(entry.bin_no));
+          return;
+        }
+        const auto num_marked = entry.slot_occupancy.count(slots(chunk_no));
+        if (num_marked != entry.num_occupied_slots) {
+          add_problem(std::to_string(entry.num_occupied_slots) +
+                      " occupied slots are recorded, but " +
+                      std::to_string(num_marked) + " slots are marked");
         }
+        return;
+      }
+
+      case chunk_type::large_chunk_head: {
+        if (small_bin || !valid_bin) {
+          add_problem("A large chunk has an invalid bin number " +
+                      std::to_string(entry.bin_no));
+          return;
+        }
+        const std::size_t num_chunks = priv_num_large_chunks(entry.bin_no);
+        for (std::size_t i = 1; i < num_chunks; ++i) {
+          if (chunk_no + i >= size() ||
+              m_table[chunk_no + i].type != chunk_type::large_chunk_body ||
+              m_table[chunk_no + i].bin_no != entry.bin_no) {
+            add_problem("A large object does not have " +
+                        std::to_string(num_chunks) + " chunks");
+            return;
+          }
+        }
+        if (chunk_no + num_chunks < size() &&
+            m_table[chunk_no + num_chunks].type ==
+                chunk_type::large_chunk_body) {
+          add_problem("A large object has more than " +
+                      std::to_string(num_chunks) + " chunks");
+        }
+        return;
+      }
+
+      case chunk_type::large_chunk_body: {
+        const bool has_front =
+            chunk_no > 0 &&
+            (m_table[chunk_no - 1].type == chunk_type::large_chunk_head ||
+             m_table[chunk_no - 1].type == chunk_type::large_chunk_body) &&
+            m_table[chunk_no - 1].bin_no == entry.bin_no;
+        if (!has_front) add_problem("A large chunk body has no head chunk");
+        return;
+      }
+
+      default:
+        add_problem("Invalid chunk type " + std::to_string(entry.type));
+    }
+  }
+
+  /// \brief Gives back 'num_chunks' contiguous chunks that have been
+  /// initialized as unused. Merges them with adjacent free extents. If the
+  /// merged extent reaches the last used chunk, the directory shrinks instead.
+  /// \param head_chunk_no The first chunk number to release.
+  /// \param num_chunks The number of chunks to release.
+  void priv_release_chunks(const chunk_no_type head_chunk_no,
+                           const std::size_t num_chunks) {
+    chunk_no_type extent_head = head_chunk_no;
+    std::size_t extent_length = num_chunks;
+
+    auto next = m_free_extents_by_address.lower_bound(head_chunk_no);
+    if (next != m_free_extents_by_address.begin()) {
+      const auto prev = std::prev(next);
+      if (prev->first + prev->second == head_chunk_no) {
+        extent_head = prev->first;
+        extent_length += prev->second;
+        priv_erase_free_extent(prev->first, prev->second);
+      }
+    }
+    next = m_free_extents_by_address.lower_bound(head_chunk_no);
+    if (next != m_free_extents_by_address.end() &&
+        next->first == head_chunk_no + num_chunks) {
+      extent_length += next->second;
+      priv_erase_free_extent(next->first, next->second);
+    }
+
+    if ((ssize_t)(extent_head + extent_length) > m_last_used_chunk_no) {
+      // The chunk before the extent is used (or the extent starts at 0)
+      m_last_used_chunk_no = (ssize_t)extent_head - 1;
+      return;
+    }
+    priv_insert_free_extent(extent_head, extent_length);
+  }
+
+  void priv_insert_free_extent(const chunk_no_type head_chunk_no,
+                               const std::size_t length) {
+    assert(length > 0);
+    m_free_extents_by_address.emplace(head_chunk_no, length);
+    m_free_extents_by_length.emplace(length, head_chunk_no);
+  }
+
+  void priv_erase_free_extent(const chunk_no_type head_chunk_no,
+                              const std::size_t length) {
+    m_free_extents_by_address.erase(head_chunk_no);
+    m_free_extents_by_length.erase(std::make_pair(length, head_chunk_no));
+  }
+
+  /// \brief Reconstructs the free extent index from the table.
+  void priv_rebuild_free_extent_index() {
+    m_free_extents_by_address.clear();
+    m_free_extents_by_length.clear();
+
+    std::size_t run_length = 0;
+    for (chunk_no_type chunk_no = 0; chunk_no < size(); ++chunk_no) {
+      if (unused_chunk(chunk_no)) {
+        ++run_length;
+        continue;
+      }
+      if (run_length > 0) {
+        priv_insert_free_extent(chunk_no - run_length, run_length);
+        run_length = 0;
+      }
+    }
+  }
+
+  /// \brief Checks if a file starts with the magic of the binary format.
+  static bool priv_binary_format_file(const fs::path &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    char magic[sizeof(k_binary_format_magic)];
+    if (!ifs.read(magic, sizeof(magic))) return false;
+    return std::equal(magic, magic + sizeof(magic), k_binary_format_magic);
+  }
+
+  /// \brief Deserializes the binary format.
+  /// The file is mapped and the entries are copied to the table in bulk.
+  static std::size_t priv_num_released_slots(
+      const chunk_no_type chunk_no,
+      const slot_list_type *const released_slots) {
+    if (!released_slots) return 0;
+    const auto itr = released_slots->find(chunk_no);
+    return (itr == released_slots->end()) ? 0 : itr->second.size();
+  }
+
+  /// \brief Serializes the slot occupancy of a small chunk, resetting the
+  /// given slots in a copy of it.
+  bool priv_serialize_without_released_slots(
+      const chunk_no_type chunk_no, const std::vector<slot_no_type> &slot_nos,
+      uint64_t *const buf) const {
+    const slot_count_type num_slots = slots(chunk_no);
+    m_table[chunk_no].slot_occupancy.serialize(num_slots, buf);
+
+    multilayer_bitset_type copy;
+    if (!copy.allocate(num_slots)) return false;
+    copy.deserialize(num_slots, buf);
+    for (const auto slot_no : slot_nos) {
+      assert(copy.get(num_slots, slot_no));
+      copy.reset(num_slots, slot_no);
+    }
+    copy.serialize(num_slots, buf);
+    copy.free(num_slots);
+    return true;
+  }
+
+  bool priv_deserialize_binary(const fs::path &path) {
+    const ssize_t file_size = mdtl::get_file_size(path);
+    if (file_size < (ssize_t)sizeof(binary_file_header)) {
+      METALL_LOG(logger::level::error, "Invalid file size: " << path);
+      return false;
+    }
+
+    const auto [fd, addr] =
+        mdtl::map_file_read_mode(path, nullptr, file_size, 0);
+    if (!addr) {
+      METALL_LOG(logger::level::error, "Cannot map: " << path);
+      return false;
+    }
+    const bool ret = priv_deserialize_binary_image(
+        static_cast<const char *>(addr), file_size, path);
+    mdtl::munmap(fd, addr, file_size, false);
+
+    return ret;
+  }
+
+  bool priv_deserialize_binary_image(const char *const image,
+                                     const std::size_t image_size,
+                                     const fs::path &path) {
+    binary_file_header header;
+    std::memcpy(&header, image, sizeof(header));
+    if (header.format_version != k_binary_format_version &&
+        header.format_version != k_power_of_two_large_sizes_format_version) {
+      METALL_LOG(logger::level::error, "Unsupported format version "
+                 << header.format_version << ": " << path);
+      return false;
+    }
+    const bool power_of_two_large_sizes =
+        header.format_version == k_power_of_two_large_sizes_format_version;
+    if (header.num_entries > m_max_num_chunks ||
+        image_size != sizeof(header) +
+                          header.num_entries * sizeof(binary_entry_type) +
+                          header.num_bitset_blocks * sizeof(uint64_t)) {
+      METALL_LOG(logger::level::error, "Broken file: " << path);
+      return false;
+    }
+
+    const auto *const entries =
+        reinterpret_cast<const binary_entry_type *>(image + sizeof(header));
+    const auto *const blocks = reinterpret_cast<const uint64_t *>(
+        image + sizeof(header) +
+        header.num_entries * sizeof(binary_entry_type));
+
+    // Parses disjoint ranges of the entries in parallel.
+    // The first pass counts the bitset blocks of each range so that the
+    // second pass knows where the blocks of each range start.
+    const std::size_t num_ranges =
+        (header.num_entries + k_deserialization_range_size - 1) /
+        k_deserialization_range_size;
+    const auto range_begin = [](const std::size_t range_no) {
+      return static_cast<chunk_no_type>(range_no *
+                                        k_deserialization_range_size);
+    };
+    const auto range_end = [&header](const std::size_t range_no) {
+      return static_cast<chunk_no_type>(
+          std::min<uint64_t>((range_no + 1) *
+                                 k_deserialization_range_size,
+                             header.num_entries));
+    };
+
+    std::vector<std::size_t> block_pos(num_ranges + 1, 0);
+    auto &executor = mdtl::io_executor::instance();
+    if (!executor.parallel_for(
+            num_ranges, 0, [&](const std::size_t range_no) {
+              return priv_count_bitset_blocks(
+                  entries, range_begin(range_no), range_end(range_no),
+                  &block_pos[range_no + 1], path);
+            })) {
+      return false;
+    }
+    std::partial_sum(block_pos.begin(), block_pos.end(), block_pos.begin());
+    if (block_pos.back() > header.num_bitset_blocks) {
+      METALL_LOG(logger::level::error, "Too few bitset blocks: " << path);
+      return false;
+    }
+
+    std::vector<ssize_t> last_used_chunk_no(num_ranges, -1);
+    if (!executor.parallel_for(
+            num_ranges, 0, [&](const std::size_t range_no) {
+              return priv_deserialize_binary_entries(
+                  entries, blocks + block_pos[range_no], range_begin(range_no),
+                  range_end(range_no), power_of_two_large_sizes,
+                  &last_used_chunk_no[range_no]);
+            })) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to allocate slot occupancy data");
+      return false;
+    }
+    for (const auto chunk_no : last_used_chunk_no) {
+      m_last_used_chunk_no = std::max(m_last_used_chunk_no, chunk_no);
+    }
+
+    return true;
+  }
 
-        m_last_used_chunk_no =
-            std::max((ssize_t)chunk_no, m_last_used_chunk_no);
+  /// \brief Validates the entries in [begin, end) and counts the bitset
+  /// blocks of them.
+  bool priv_count_bitset_blocks(const binary_entry_type *const entries,
+                                const chunk_no_type begin,
+                                const chunk_no_type end,
+                                std::size_t *const num_blocks,
+                                const fs::path &path) const {
+    *num_blocks = 0;
+    for (chunk_no_type chunk_no = begin; chunk_no < end; ++chunk_no) {
+      const binary_entry_type &entry = entries[chunk_no];
+      if (entry.type == chunk_type::unused) continue;
+
+      if (entry.type != chunk_type::small_chunk &&
+          entry.type != chunk_type::large_chunk_head &&
+          entry.type != chunk_type::large_chunk_body) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Invalid chunk type");
+        return false;
+      }
+      if (entry.type != chunk_type::small_chunk) continue;
 
-        return top_chunk_no;
+      if (entry.bin_no >= bin_no_mngr::num_small_bins() ||
+          calc_num_slots(bin_no_mngr::to_object_size(entry.bin_no)) <
+              entry.num_occupied_slots) {
+        METALL_LOG(logger::level::error, "Invalid small chunk entry at "
+                   << chunk_no << ": " << path);
+        return false;
       }
+      *num_blocks += multilayer_bitset_type::num_blocks(
+          calc_num_slots(bin_no_mngr::to_object_size(entry.bin_no)));
     }
+    return true;
+  }
+
+  /// \brief Restores the entries in [begin, end) validated by
+  /// priv_count_bitset_blocks().
+  /// \param blocks The bitset blocks of the first small chunk in the range.
+  /// \param power_of_two_large_sizes If true, the large bin numbers are
+  /// converted from the power-of-two large sizes.
+  bool priv_deserialize_binary_entries(const binary_entry_type *const entries,
+                                       const uint64_t *blocks,
+                                       const chunk_no_type begin,
+                                       const chunk_no_type end,
+                                       const bool power_of_two_large_sizes,
+                                       ssize_t *const last_used_chunk_no) {
+    for (chunk_no_type chunk_no = begin; chunk_no < end; ++chunk_no) {
+      const binary_entry_type &entry = entries[chunk_no];
+      m_table[chunk_no].init();
+      if (entry.type == chunk_type::unused) continue;
+
+      m_table[chunk_no].bin_no = static_cast<bin_no_type>(entry.bin_no);
+      m_table[chunk_no].type = static_cast<chunk_type>(entry.type);
+      m_table[chunk_no].heat = entry.heat;
+      *last_used_chunk_no = chunk_no;
+
+      if (entry.type != chunk_type::small_chunk) {
+        if (power_of_two_large_sizes) {
+          m_table[chunk_no].bin_no =
+              priv_from_power_of_two_large_bin_no(entry.bin_no);
+        }
+        continue;
+      }
 
-    logger::out(logger::level::error, __FILE__, __LINE__,
-                "No available space for large allocation, which requires "
-                "multiple contiguous chunks");
-    return m_max_num_chunks;
+      const slot_count_type num_slots = slots(chunk_no);
+      m_table[chunk_no].num_occupied_slots = entry.num_occupied_slots;
+      if (!priv_allocate_slot_occupancy(chunk_no)) return false;
+      m_table[chunk_no].slot_occupancy.deserialize(num_slots, blocks);
+      blocks += multilayer_bitset_type::num_blocks(num_slots);
+    }
+    return true;
   }
 
-  ssize_t find_next_used_chunk_backward(
-      const chunk_no_type start_chunk_no) const {
-    assert(start_chunk_no < size());
-    for (ssize_t chunk_no = start_chunk_no; chunk_no >= 0; --chunk_no) {
-      if (!unused_chunk(chunk_no)) {
-        return chunk_no;
+  /// \brief Deserializes the text format, which was used before the binary
+  /// format was introduced.
+  bool priv_deserialize_text(const fs::path &path) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+      METALL_LOG(logger::level::error, "Cannot open: " << path);
+      return false;
+    }
+
+    uint64_t buf1;
+    uint64_t buf2;
+    uint64_t buf3;
+    while (ifs >> buf1 >> buf2 >> buf3) {
+      const auto chunk_no = static_cast<chunk_no_type>(buf1);
+      const auto bin_no = static_cast<bin_no_type>(buf2);
+      m_table[chunk_no].bin_no = bin_no;
+
+      using status_underlying_type = std::underlying_type_t<chunk_type>;
+      const auto type = static_cast<status_underlying_type>(buf3);
+      if (type ==
+          static_cast<status_underlying_type>(chunk_type::small_chunk)) {
+        m_table[chunk_no].type = chunk_type::small_chunk;
+      } else if (type == static_cast<status_underlying_type>(
+                             chunk_type::large_chunk_head)) {
+        m_table[chunk_no].type = chunk_type::large_chunk_head;
+        m_table[chunk_no].bin_no = priv_from_power_of_two_large_bin_no(buf2);
+      } else if (type == static_cast<status_underlying_type>(
+                             chunk_type::large_chunk_body)) {
+        m_table[chunk_no].type = chunk_type::large_chunk_body;
+        m_table[chunk_no].bin_no = priv_from_power_of_two_large_bin_no(buf2);
+      } else {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Invalid chunk type");
+        return false;
+      }
+
+      if (m_table[chunk_no].type == chunk_type::small_chunk) {
+        const slot_count_type num_slots =
+            calc_num_slots(bin_no_mngr::to_object_size(bin_no));
+        if (!(ifs >> buf1)) {
+          METALL_LOG(logger::level::error, "Cannot read a file: " << path);
+          return false;
+        }
+        if (num_slots < buf1) {
+          METALL_LOG(logger::level::error, "Invalid num_occupied_slots: "
+                     << std::to_string(buf1));
+          return false;
+        }
+        m_table[chunk_no].num_occupied_slots = buf1;
+
+        std::string bitset_buf;
+        std::getline(ifs, bitset_buf);
+        if (bitset_buf.empty() || bitset_buf[0] != ' ') {
+          METALL_LOG(logger::level::error, "Invalid input for slot_occupancy: "
+                     << bitset_buf);
+          return false;
+        }
+        bitset_buf.erase(0, 1);
+
+        if (!priv_allocate_slot_occupancy(chunk_no)) {
+          logger::out(logger::level::error, __FILE__, __LINE__,
+                      "Failed to allocate slot occupancy data");
+          return false;
+        }
+
+        if (!m_table[chunk_no].slot_occupancy.deserialize(num_slots,
+                                                          bitset_buf)) {
+          METALL_LOG(logger::level::error, "Invalid input for slot_occupancy: "
+                     << bitset_buf);
+          return false;
+        }
       }
+
+      m_last_used_chunk_no = std::max((ssize_t)chunk_no, m_last_used_chunk_no);
+    }
+
+    if (!ifs.eof()) {
+      METALL_LOG(logger::level::error, "Something happened in the ifstream: "
+                 << path);
+      return false;
     }
-    return -1;
+
+    ifs.close();
+
+    return true;
   }
 
   // -------------------- //
@@ -640,6 +1431,11 @@ class chunk_directory {
   // Use const here to avoid race condition risks
   const std::size_t m_max_num_chunks;
   ssize_t m_last_used_chunk_no;
+  // Free extents below the last used chunk: head chunk no -> length
+  std::map<chunk_no_type, std::size_t> m_free_extents_by_address;
+  // The same extents ordered by (length, head chunk no)
+  std::set<std::pair<std::size_t, chunk_no_type>> m_free_extents_by_length;
+  slot_bitmap_pool m_slot_bitmap_pool;
 };
 
 }  // namespace kernel
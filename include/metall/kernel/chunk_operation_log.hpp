@@ -0,0 +1,212 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_CHUNK_OPERATION_LOG_HPP
+#define METALL_KERNEL_CHUNK_OPERATION_LOG_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <metall/logger.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+}  // namespace
+
+/// \brief Write-ahead log of the chunk-level operations of the segment
+/// allocator, i.e., the insertions, erasures, and resizes of chunks.
+/// The log starts from a state of the allocator written to files so that the
+/// chunk directory at the time of a crash can be reconstructed by replaying
+/// the log on the state.
+/// Each record is written by a single write(2) call without a user buffer,
+/// i.e., the records survive a process crash, but not an OS crash.
+class chunk_operation_log {
+ public:
+  /// \brief insert_at is an insertion at the recorded chunk number instead of
+  /// the one the chunk directory would choose, e.g., for an aligned
+  /// allocation.
+  enum class operation : uint32_t {
+    insert = 1,
+    erase = 2,
+    resize = 3,
+    insert_at = 4
+  };
+
+  /// \brief A function called for each record by replay().
+  /// Takes an operation, a chunk number, and a bin number.
+  using replay_function_type =
+      std::function<bool(operation, uint64_t, uint32_t)>;
+
+  chunk_operation_log() noexcept = default;
+  ~chunk_operation_log() noexcept { close(); }
+
+  chunk_operation_log(const chunk_operation_log &) = delete;
+  chunk_operation_log &operator=(const chunk_operation_log &) = delete;
+
+  chunk_operation_log(chunk_operation_log &&other) noexcept
+      : m_fd(std::exchange(other.m_fd, -1)), m_path(std::move(other.m_path)) {}
+
+  chunk_operation_log &operator=(chunk_operation_log &&other) noexcept {
+    if (this != &other) {
+      close();
+      m_fd = std::exchange(other.m_fd, -1);
+      m_path = std::move(other.m_path);
+    }
+    return *this;
+  }
+
+  /// \brief Creates a new log file. An existing file is truncated.
+  /// \param path A file path.
+  /// \return Returns true on success; otherwise, false.
+  bool create(const fs::path &path) {
+    close();
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (m_fd == -1) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+      return false;
+    }
+    m_path = path;
+
+    file_header header;
+    std::copy_n(k_magic, sizeof(header.magic), header.magic);
+    header.format_version = k_format_version;
+    if (!priv_write(&header, sizeof(header))) {
+      priv_abandon();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Closes the log file. The file is not removed.
+  void close() noexcept {
+    if (m_fd != -1) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  /// \brief Returns true if a log file is open.
+  bool is_open() const noexcept { return m_fd != -1; }
+
+  /// \brief Appends a record. Does nothing if no log file is open.
+  /// If fails, the log file is removed as it cannot be used for recovery
+  /// anymore.
+  /// \return Returns true on success; otherwise, false.
+  bool append(const operation op, const uint64_t chunk_no,
+              const uint32_t bin_no) noexcept {
+    if (m_fd == -1) return true;
+
+    const record_type record{op, bin_no, chunk_no};
+    if (!priv_write(&record, sizeof(record))) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to append a chunk operation; the data store cannot "
+                  "be recovered on a crash");
+      priv_abandon();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Calls a function for each record in a log file, in the order the
+  /// records were appended.
+  /// A partially written record at the end is ignored.
+  /// \param path A path to a log file.
+  /// \param fn A function to call. Must return true on success.
+  /// \return Returns true on success; otherwise, false.
+  static bool replay(const fs::path &path, const replay_function_type &fn) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    const std::string image((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+
+    file_header header{};
+    if (image.size() >= sizeof(header)) {
+      std::memcpy(&header, image.data(), sizeof(header));
+    }
+    if (image.size() < sizeof(header) ||
+        !std::equal(header.magic, header.magic + sizeof(header.magic),
+                    k_magic) ||
+        header.format_version != k_format_version) {
+      std::stringstream ss;
+      ss << "Not a chunk operation log: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    for (std::size_t pos = sizeof(header);
+         pos + sizeof(record_type) <= image.size();
+         pos += sizeof(record_type)) {
+      record_type record;
+      std::memcpy(&record, image.data() + pos, sizeof(record));
+      if (!fn(record.op, record.chunk_no, record.bin_no)) return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr char k_magic[8] = {'M', 'T', 'L', 'L', 'C', 'O', 'P', 'L'};
+  // Version 2 uses the large bin numbers of the quarter-step large sizes
+  static constexpr uint64_t k_format_version = 2;
+
+  struct file_header {
+    char magic[8];
+    uint64_t format_version;
+  };
+
+  struct record_type {
+    operation op;
+    uint32_t bin_no;
+    uint64_t chunk_no;
+  };
+  static_assert(sizeof(record_type) == 16, "Unexpected record size");
+
+  bool priv_write(const void *const buf, const std::size_t size) noexcept {
+    const auto *ptr = static_cast<const char *>(buf);
+    std::size_t written = 0;
+    while (written < size) {
+      const auto ret = ::write(m_fd, ptr + written, size - written);
+      if (ret == -1) {
+        if (errno == EINTR) continue;
+        logger::perror(logger::level::error, __FILE__, __LINE__, "write");
+        return false;
+      }
+      written += ret;
+    }
+    return true;
+  }
+
+  void priv_abandon() noexcept {
+    close();
+    std::error_code ec;
+    fs::remove(m_path, ec);
+  }
+
+  int m_fd{-1};
+  fs::path m_path;
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_CHUNK_OPERATION_LOG_HPP
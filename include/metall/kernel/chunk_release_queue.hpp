@@ -0,0 +1,109 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_CHUNK_RELEASE_QUEUE_HPP
+#define METALL_KERNEL_CHUNK_RELEASE_QUEUE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace metall::kernel {
+
+/// \brief Ranges of free chunks whose memory pages are to be released later.
+/// Adjacent ranges are merged so that many freed chunks are released by a
+/// few calls, e.g., when a large data structure is destroyed.
+/// Chunks must be removed from the queue when they are reused, as releasing
+/// their pages discards the data written to them.
+/// This class is not thread-safe.
+class chunk_release_queue {
+ public:
+  using chunk_no_type = uint64_t;
+  using size_type = std::size_t;
+
+  /// \brief Adds chunks [chunk_no, chunk_no + num_chunks).
+  /// The chunks must not be in the queue.
+  void push(const chunk_no_type chunk_no, const size_type num_chunks) {
+    if (num_chunks == 0) return;
+
+    auto next = m_ranges.lower_bound(chunk_no);
+    assert(next == m_ranges.end() || next->first >= chunk_no + num_chunks);
+
+    auto range = m_ranges.end();
+    if (next != m_ranges.begin()) {
+      auto prev = std::prev(next);
+      assert(prev->first + prev->second <= chunk_no);
+      if (prev->first + prev->second == chunk_no) {
+        prev->second += num_chunks;
+        range = prev;
+      }
+    }
+    if (range == m_ranges.end()) {
+      range = m_ranges.emplace_hint(next, chunk_no, num_chunks);
+    }
+    if (next != m_ranges.end() && range->first + range->second == next->first) {
+      range->second += next->second;
+      m_ranges.erase(next);
+    }
+    m_num_chunks += num_chunks;
+  }
+
+  /// \brief Removes chunks [chunk_no, chunk_no + num_chunks) from the queue.
+  /// The chunks do not have to be in the queue.
+  void erase(const chunk_no_type chunk_no, const size_type num_chunks) {
+    if (m_ranges.empty() || num_chunks == 0) return;
+
+    const chunk_no_type last = chunk_no + num_chunks;
+    auto itr = m_ranges.upper_bound(chunk_no);
+    if (itr != m_ranges.begin()) {
+      auto prev = std::prev(itr);
+      if (prev->first + prev->second > chunk_no) itr = prev;
+    }
+
+    while (itr != m_ranges.end() && itr->first < last) {
+      const chunk_no_type head = itr->first;
+      const chunk_no_type tail = head + itr->second;
+      m_num_chunks -= itr->second;
+      itr = m_ranges.erase(itr);
+      if (head < chunk_no) {
+        m_ranges.emplace_hint(itr, head, chunk_no - head);
+        m_num_chunks += chunk_no - head;
+      }
+      if (tail > last) {
+        m_ranges.emplace_hint(itr, last, tail - last);
+        m_num_chunks += tail - last;
+        break;
+      }
+    }
+  }
+
+  /// \brief Calls 'func(chunk_no, num_chunks)' for each range in the
+  /// ascending order of the chunk numbers and empties the queue.
+  template <typename function_type>
+  void release(function_type &&func) {
+    for (const auto &range : m_ranges) func(range.first, range.second);
+    m_ranges.clear();
+    m_num_chunks = 0;
+  }
+
+  /// \brief Returns the number of chunks in the queue.
+  size_type num_chunks() const { return m_num_chunks; }
+
+  /// \brief Returns the number of ranges the chunks are merged into.
+  size_type num_ranges() const { return m_ranges.size(); }
+
+  bool empty() const { return m_ranges.empty(); }
+
+ private:
+  // The first chunk number to the number of chunks
+  std::map<chunk_no_type, size_type> m_ranges;
+  size_type m_num_chunks{0};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_CHUNK_RELEASE_QUEUE_HPP
@@ -0,0 +1,57 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_CONCURRENCY_POLICY_HPP
+#define METALL_KERNEL_CONCURRENCY_POLICY_HPP
+
+#include <type_traits>
+
+#include <metall/defs.hpp>
+#include <metall/detail/mutex.hpp>
+
+namespace metall::kernel {
+
+/// \brief A concurrency policy of basic_manager: the manager can be used by
+/// multiple threads at the same time.
+/// If METALL_DISABLE_CONCURRENCY is defined, this policy is the same as
+/// single_threaded.
+struct multi_threaded {
+#ifdef METALL_DISABLE_CONCURRENCY
+  static constexpr bool k_thread_safe = false;
+#else
+  static constexpr bool k_thread_safe = true;
+#endif
+};
+
+/// \brief A concurrency policy of basic_manager: the manager is used by one
+/// thread at a time. The locks of the manager are compiled away and the
+/// allocations use a single object cache without looking up the CPU number,
+/// e.g., for a single-threaded loading tool built into the same binary as a
+/// multi-threaded server.
+/// No background thread is started to trim the object cache.
+struct single_threaded {
+  static constexpr bool k_thread_safe = false;
+};
+
+/// \brief The default concurrency policy.
+#ifdef METALL_DISABLE_CONCURRENCY
+using default_concurrency_policy = single_threaded;
+#else
+using default_concurrency_policy = multi_threaded;
+#endif
+
+namespace ccpdtl {
+template <typename policy>
+using mutex = std::conditional_t<policy::k_thread_safe, mtlldetail::mutex,
+                                 mtlldetail::null_mutex>;
+template <typename policy>
+using shared_mutex =
+    std::conditional_t<policy::k_thread_safe, mtlldetail::shared_mutex,
+                       mtlldetail::null_mutex>;
+}  // namespace ccpdtl
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_CONCURRENCY_POLICY_HPP
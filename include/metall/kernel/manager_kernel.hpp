@@ -18,18 +18,44 @@
 #include <map>
 #include <sstream>
 #include <typeinfo>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <random>
+#include <mutex>
+#include <exception>
+#include <iterator>
+#include <type_traits>
 
 #include <metall/logger.hpp>
 #include <metall/offset_ptr.hpp>
+#include <metall/tracing.hpp>
 #include <metall/version.hpp>
+#include <metall/manager_options.hpp>
 #include <metall/kernel/manager_kernel_fwd.hpp>
+#include <metall/kernel/concurrency_policy.hpp>
+#include <metall/kernel/access_pattern.hpp>
+#include <metall/kernel/checkpoint_service.hpp>
 #include <metall/kernel/segment_header.hpp>
 #include <metall/kernel/segment_allocator.hpp>
+#include <metall/kernel/segment_storage_concept.hpp>
 #include <metall/kernel/attributed_object_directory.hpp>
+#include <metall/kernel/named_object_index.hpp>
+#include <metall/kernel/publication.hpp>
+#include <metall/kernel/memory_statistics.hpp>
+#include <metall/kernel/memory_tiering.hpp>
+#include <metall/kernel/page_statistics.hpp>
+#include <metall/kernel/allocation_trace.hpp>
+#include <metall/kernel/phase_timer.hpp>
+#include <metall/kernel/undo_log.hpp>
 #include <metall/object_attribute_accessor.hpp>
 #include <metall/detail/utilities.hpp>
 #include <metall/detail/file.hpp>
 #include <metall/detail/file_clone.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/numa.hpp>
+#include <metall/detail/io_executor.hpp>
 #include <metall/detail/char_ptr_holder.hpp>
 #include <metall/detail/uuid.hpp>
 #include <metall/detail/ptree.hpp>
@@ -49,7 +75,8 @@ namespace mdtl = metall::mtlldetail;
 }
 
 template <typename _storage, typename _segment_storage, typename _chunk_no_type,
-          std::size_t _chunk_size>
+          std::size_t _chunk_size, typename _size_class_table,
+          typename _concurrency_policy>
 class manager_kernel {
  public:
   // -------------------- //
@@ -66,13 +93,16 @@ class manager_kernel {
 
   using chunk_no_type = _chunk_no_type;
   static constexpr size_type k_chunk_size = _chunk_size;
+  using size_class_table_type = _size_class_table;
+  using concurrency_policy = _concurrency_policy;
 
  private:
   // -------------------- //
   // Private types and static values
   // -------------------- //
   using self_type =
-      manager_kernel<_storage, _segment_storage, _chunk_no_type, _chunk_size>;
+      manager_kernel<_storage, _segment_storage, _chunk_no_type, _chunk_size,
+                     _size_class_table, _concurrency_policy>;
   static constexpr const char *k_management_dir_name = "management";
 
   // For segment
@@ -97,13 +127,16 @@ class manager_kernel {
 
   using storage = _storage;
   using segment_storage = _segment_storage;
+  static_assert(is_segment_storage_v<segment_storage>,
+                "The segment storage does not meet the requirements");
 
   // For actual memory allocation layer
   static constexpr const char *k_segment_memory_allocator_prefix =
       "segment_memory_allocator";
   using segment_memory_allocator =
       segment_allocator<chunk_no_type, size_type, difference_type, k_chunk_size,
-                        k_max_segment_size, segment_storage>;
+                        k_max_segment_size, segment_storage,
+                        size_class_table_type, concurrency_policy>;
 
   // For attributed object directory
   using attributed_object_directory_type =
@@ -114,23 +147,63 @@ class manager_kernel {
       "unique_object_directory";
   static constexpr const char *k_anonymous_object_directory_prefix =
       "anonymous_object_directory";
+  // Indices of the named and unique objects shared by read-only processes
+  static constexpr const char *k_named_object_index_file_name =
+      "named_object_index";
+  static constexpr const char *k_unique_object_index_file_name =
+      "unique_object_index";
+  // The versions published to live readers
+  static constexpr const char *k_publication_file_name = "publication";
+  // The replication stream and the last stream a replica has applied
+  static constexpr char k_replication_stream_magic[8] = {'M', 'T', 'L', 'L',
+                                                         'R', 'E', 'P', '1'};
+  static constexpr const char *k_replication_state_file_name =
+      "replication_state";
 
   static constexpr const char *k_properly_closed_mark_file_name =
       "properly_closed_mark";
 
+  // For recovering from a crash
+  static constexpr const char *k_chunk_operation_log_file_name =
+      "chunk_operation_log";
+  // The undo log of the active transaction
+  static constexpr const char *k_undo_log_file_name = "undo_log";
+
   // For manager metadata data
   static constexpr const char *k_manager_metadata_file_name =
       "manager_metadata";
   static constexpr const char *k_manager_metadata_key_for_version = "version";
   static constexpr const char *k_manager_metadata_key_for_uuid = "uuid";
+  static constexpr const char *k_manager_metadata_key_for_size_class_table =
+      "size_class_table";
+  static constexpr const char *k_manager_metadata_key_for_snapshot_parent =
+      "snapshot_parent";
+  static constexpr const char *k_manager_metadata_key_for_snapshot_base =
+      "snapshot_base";
+  // To detect a cycle of incremental snapshots
+  static constexpr std::size_t k_max_snapshot_chain_length = 1ULL << 16ULL;
 
   static constexpr const char *k_description_file_name = "description";
 
+  // The segment directory of a datastore whose segment is stored separately
+  static constexpr const char *k_segment_location_file_name =
+      "segment_location";
+
+  // The access patterns set to objects, applied again on open
+  static constexpr const char *k_access_pattern_table_file_name =
+      "access_pattern_table";
+
   using json_store = mdtl::ptree::node_type;
 
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-  using mutex_type = mdtl::mutex;
-  using lock_guard_type = mdtl::mutex_lock_guard;
+  // No-op mutexes if the concurrency policy is not thread-safe
+  using mutex_type = ccpdtl::mutex<concurrency_policy>;
+  using lock_guard_type = std::lock_guard<mutex_type>;
+  // The object directories are read far more often than modified
+  using directory_mutex_type = ccpdtl::shared_mutex<concurrency_policy>;
+  using directory_lock_guard_type = std::lock_guard<directory_mutex_type>;
+  using directory_shared_lock_guard_type =
+      std::shared_lock<directory_mutex_type>;
 #endif
 
  public:
@@ -151,12 +224,38 @@ class manager_kernel {
   using anonymous_object_attr_accessor_type = anonymous_object_attr_accessor<
       attributed_object_directory_type::offset_type,
       attributed_object_directory_type::size_type>;
+  using object_attribute_type = attributed_object_directory_type::entry_type;
   using path_type = typename storage::path_type;
+  /// \brief The size classes of the allocations, e.g., to find the actual
+  /// size of an allocation at compile time.
+  using bin_number_manager_type =
+      bin_number_manager<k_chunk_size, k_max_segment_size,
+                         size_class_table_type>;
+
+  /// \brief A handle to a named or unique object, returned by find_handle().
+  /// Finding an object by a handle skips hashing and comparing the name.
+  /// A handle becomes stale when any named or unique object is destroyed.
+  /// A handle must be used only with the manager that made it.
+  template <typename T>
+  class object_handle {
+   public:
+    object_handle() noexcept = default;
+
+    /// \brief Returns true if the handle refers to an object.
+    bool valid() const noexcept { return m_length > 0; }
+
+   private:
+    friend manager_kernel;
+
+    difference_type m_offset{0};
+    size_type m_length{0};
+    uint64_t m_generation{0};
+  };
 
   // -------------------- //
   // Constructor & assign operator
   // -------------------- //
-  manager_kernel();
+  explicit manager_kernel(const manager_options &options = manager_options());
   ~manager_kernel() noexcept;
 
   manager_kernel(const manager_kernel &) = delete;
@@ -178,7 +277,9 @@ class manager_kernel {
               size_type vm_reserve_size = k_default_vm_reserve_size);
 
   /// \brief Opens an existing datastore
-  /// Expect to be called by a single thread
+  /// Expect to be called by a single thread.
+  /// The allocator management data is loaded at the first allocation or
+  /// deallocation.
   /// \param base_path
   /// \param vm_reserve_size
   /// \return Returns true if success; otherwise, returns false
@@ -191,6 +292,30 @@ class manager_kernel {
   /// \return Returns true if success; otherwise, returns false
   bool open_read_only(const path_type &base_path);
 
+  /// \brief Opens an existing datastore read-only while a writer process
+  /// keeps it open with open(), seeing the version the writer published last
+  /// by publish(). refresh() moves to the latest version.
+  /// Finding objects by name is supported; the other functions that use the
+  /// object directories, e.g., iterating objects, see no object, and the
+  /// allocator statistics are not available.
+  /// Expect to be called by a single thread
+  /// \param base_path
+  /// \param vm_reserve_size The VM region to reserve for the segment to grow.
+  /// \return Returns true if success; otherwise, returns false
+  bool open_live_read_only(
+      const path_type &base_path,
+      size_type vm_reserve_size = k_default_vm_reserve_size);
+
+  /// \brief Opens an existing datastore with the copy-on-write mode.
+  /// The datastore can be modified, but nothing is written back to it.
+  /// Expect to be called by a single thread.
+  /// \param base_path
+  /// \param vm_reserve_size
+  /// \return Returns true if success; otherwise, returns false
+  bool open_copy_on_write(
+      const path_type &base_path,
+      size_type vm_reserve_size = k_default_vm_reserve_size);
+
   /// \brief Expect to be called by a single thread
   void close();
 
@@ -199,16 +324,198 @@ class manager_kernel {
   /// otherwise, performs asynchronous operation.
   void flush(bool synchronous);
 
+  /// \brief Serializes the management data and syncs the application data
+  /// in background. The application can keep using the datastore while the
+  /// data is written back.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Returns an object of std::future.
+  /// If succeeded, its get() returns true; otherwise, false.
+  std::future<bool> flush_async(int num_max_threads);
+
+  /// \brief Starts writing back the dirty pages of the application data
+  /// segment periodically in a background thread. Restarts it with the new
+  /// options if it is running.
+  /// \param options The options.
+  /// \return Returns false if the datastore is not writable to its files or
+  /// the thread cannot be started.
+  bool start_checkpointing(const checkpoint_options &options);
+
+  /// \brief Stops the background checkpointing, if running.
+  void stop_checkpointing();
+
+  /// \brief Returns true if the background checkpointing is running.
+  bool checkpointing() const;
+
+  /// \brief Publishes the current named and unique objects and the segment
+  /// size to the live readers as a new version.
+  /// The objects of a version must be kept until no reader uses the version.
+  /// \return Returns true on success. Fails if the datastore is not opened
+  /// with the write mode.
+  bool publish();
+
+  /// \brief Moves a live reader to the latest published version, mapping
+  /// the segment the writer has added.
+  /// \return Returns true on success, including when there is no new
+  /// version. Fails if the datastore is not opened with the live read-only
+  /// mode.
+  bool refresh();
+
+  /// \brief Returns the version this manager published last (writer) or the
+  /// version it sees (live reader). 0 if there is no such version.
+  publication::version_type published_version() const;
+
+  /// \brief Loads the pages of a region of the application data segment into
+  /// memory in parallel.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool prefetch(const void *addr, size_type nbytes);
+
+  /// \brief Pins the pages of a region of the application data segment in
+  /// memory.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool pin(const void *addr, size_type nbytes);
+
+  /// \brief Unpins the pages of a region of the application data segment.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool unpin(const void *addr, size_type nbytes);
+
+  /// \brief Returns the number of the bytes pinned in memory.
+  size_type pinned_size() const;
+
+  /// \brief Registers the pages of a region of the application data segment
+  /// to CUDA as pinned host memory.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool gpu_register(const void *addr, size_type nbytes);
+
+  /// \brief Unregisters a region registered by gpu_register().
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not registered or on error.
+  bool gpu_unregister(const void *addr, size_type nbytes);
+
+  /// \brief Loads a region of the application data segment into a device
+  /// buffer, with cuFile (GPUDirect Storage) if available.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param device_buffer A device buffer of at least nbytes bytes.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool load_to_device(const void *addr, size_type nbytes,
+                      void *device_buffer);
+
+  /// \brief Makes the data in a region of the application data segment
+  /// durable.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool persist(const void *addr, size_type nbytes);
+
+  /// \brief Starts a transaction.
+  /// \return Returns false if a transaction is already active, the data
+  /// store is not writable to its files, or on error.
+  bool begin_transaction();
+
+  /// \brief Logs the contents of a region of the application data segment
+  /// before it is modified in the active transaction.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if no transaction is active, the region is not in
+  /// the segment, or on error.
+  bool add_to_transaction(const void *addr, size_type nbytes);
+
+  /// \brief Persists the regions logged in the active transaction and ends
+  /// it.
+  /// \return Returns false if no transaction is active or on error.
+  bool commit_transaction();
+
+  /// \brief Writes back the contents of the regions logged in the active
+  /// transaction and ends it.
+  /// \return Returns false if no transaction is active or on error.
+  bool abort_transaction();
+
+  /// \brief Returns true if a transaction is active.
+  bool in_transaction() const;
+
+  /// \brief Returns true if the segment is mapped with MAP_SYNC (DAX).
+  bool dax_mapped() const;
+
+  /// \brief Tells that a region of the application data segment will not be
+  /// accessed soon.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool advise_cold(const void *addr, size_type nbytes);
+
+  /// \brief Gives the kernel the access pattern of a region, which is not
+  /// recorded.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param pattern The access pattern.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool advise_access_pattern(const void *addr, size_type nbytes,
+                             access_pattern pattern);
+
+  /// \brief Gives back the memory pages of small-object chunks that hold no
+  /// objects and reorders the chunks to reuse so that sparsely occupied ones
+  /// can become empty. Objects are not moved.
+  /// \return Returns false on error, e.g., the datastore is read-only.
+  bool compact();
+
   /// \brief Allocates memory space
   /// \param nbytes
   /// \return
   void *allocate(size_type nbytes);
 
+  /// \brief Allocates memory space filled with zeros.
+  /// Writes zeros only if the memory is not known to be zero-filled.
+  /// \param nbytes The number of bytes to allocate.
+  /// \return Returns a pointer to the memory; nullptr on error.
+  void *allocate_zeroed(size_type nbytes);
+
+  /// \brief Sets the segment size limits. See manager_options.
+  /// Must not be called concurrently with allocations.
+  /// \param soft_limit A soft limit in bytes; 0 disables it.
+  /// \param hard_limit A hard limit in bytes; 0 disables it.
+  void set_segment_size_limits(size_type soft_limit, size_type hard_limit);
+
+  /// \brief Sets a function called when the segment reaches a size limit.
+  /// Must not be called concurrently with allocations.
+  void set_segment_limit_handler(segment_limit_handler handler);
+
+  /// \brief Returns the number of placement hints.
+  static constexpr size_type num_placement_hints() {
+    return segment_memory_allocator::k_num_placement_hints;
+  }
+
+  /// \brief Sets the placement hint of the calling thread, which groups the
+  /// small objects allocated with the same hint into the same chunks.
+  /// The hint applies to all managers of this type in the thread.
+  /// \param hint A hint in [0, num_placement_hints()).
+  /// \return Returns false if the hint is out of range.
+  static bool set_placement_hint(size_type hint);
+
+  /// \brief Clears the placement hint of the calling thread.
+  static void clear_placement_hint();
+
+  /// \brief Gets the placement hint of the calling thread.
+  /// \param hint A pointer to store the hint.
+  /// \return Returns false if no hint is set.
+  static bool get_placement_hint(size_type *hint);
+
   /// \brief Allocate nbytes bytes of uninitialized storage whose alignment is
   /// specified by alignment. \param nbytes A size to allocate. Must be a
-  /// multiple of alignment. \param alignment An alignment requirement.
-  /// Alignment must be a power of two and satisfy [min allocation size, chunk
-  /// size]. \return On success, returns the pointer to the beginning of newly
+  /// multiple of alignment if alignment is not larger than the chunk size.
+  /// \param alignment An alignment requirement. Alignment must be a power of
+  /// two and equal to or larger than the min allocation size. An alignment
+  /// larger than the chunk size also requires the segment to be aligned to it.
+  /// \return On success, returns the pointer to the beginning of newly
   /// allocated memory. Returns nullptr, if the given arguments do not satisfy
   /// the requirements above.
   void *allocate_aligned(size_type nbytes, size_type alignment);
@@ -217,17 +524,115 @@ class manager_kernel {
   /// \param addr
   void deallocate(void *addr);
 
+  /// \brief Deallocates memory whose allocation size is known.
+  /// This function does not need to look up the size of the memory.
+  /// \param addr An address to deallocate.
+  /// \param nbytes The size passed to allocate() when the memory was
+  /// allocated.
+  void deallocate(void *addr, size_type nbytes);
+
+  /// \brief Changes the size of allocated memory.
+  /// The memory is resized in place if possible; otherwise, new memory is
+  /// allocated, the data is copied, and the old memory is deallocated.
+  /// \param addr An address of allocated memory. If nullptr, this function
+  /// works as allocate().
+  /// \param nbytes The new size. If 0, deallocates 'addr' and returns nullptr.
+  /// \return Returns the address of the resized memory.
+  /// On error, returns nullptr and the original memory is not changed.
+  void *reallocate(void *addr, size_type nbytes);
+
+  /// \brief Tries to change the size of allocated memory without moving it.
+  /// \param addr An address of allocated memory.
+  /// \param nbytes The new size.
+  /// \return Returns true on success. Returns false if the memory has to be
+  /// moved to change the size; then, the memory is not changed.
+  bool resize_in_place(void *addr, size_type nbytes);
+
+  /// \brief Allocates 'num' objects of 'nbytes' bytes at once.
+  /// \param nbytes The size of each object.
+  /// \param num The number of objects to allocate.
+  /// \param addrs A buffer to store the addresses of the allocated objects.
+  /// \return The number of allocated objects. Allocated addresses are stored
+  /// from the front of 'addrs' and the rest of the elements are set to
+  /// nullptr.
+  size_type allocate_many(size_type nbytes, size_type num, void **addrs);
+
+  /// \brief Deallocates multiple objects at once.
+  /// \param addrs The addresses of the objects to deallocate. nullptr elements
+  /// are ignored.
+  /// \param num The number of elements in 'addrs'.
+  void deallocate_many(void *const *addrs, size_type num);
+
   /// \brief Check if all allocated memory has been deallocated.
   /// Note that this function clears object cache.
   bool all_memory_deallocated() const;
 
   /// \brief Finds an already constructed object
+  /// Lookups from multiple threads do not block each other; they do not take
+  /// any lock if the data store is open read-only.
   /// \tparam T
   /// \param name
   /// \return
   template <typename T>
   std::pair<T *, size_type> find(char_ptr_holder_type name) const;
 
+  /// \brief Constructs named objects of the same type at once.
+  /// Allocates the objects in a batch, constructs them, and then registers
+  /// all of them under a single lock. Fails without constructing any object
+  /// if any of the names exists or is duplicated.
+  /// \tparam T The type of the objects.
+  /// \param names The names of the objects.
+  /// \param objects A buffer to store the addresses of the objects.
+  /// \param args The arguments to construct every object with.
+  /// \return Returns true on success; otherwise, false.
+  template <typename T, typename... Args>
+  bool construct_many(const std::vector<std::string> &names,
+                      std::vector<T *> *objects, const Args &...args);
+
+  /// \brief Constructs an array of objects with multiple threads.
+  /// If 'args' is empty and T is trivially default constructible, the
+  /// objects are not initialized when the allocated memory is known to be
+  /// zero-filled, as it already holds the value-initialized objects.
+  /// If a constructor throws, the constructed objects are destroyed, the
+  /// memory is freed, and the exception is rethrown.
+  /// \tparam T The type of the objects.
+  /// \param name The name of the array.
+  /// \param length The number of objects.
+  /// \param try2find If true, returns the array if it already exists.
+  /// \param num_threads The maximum number of threads to use. If <= 0 is
+  /// given, it is automatically determined.
+  /// \param args The arguments to construct every object with.
+  /// \return Returns a pointer to the array; nullptr on error.
+  template <typename T, typename... Args>
+  T *construct_parallel(char_ptr_holder_type name, size_type length,
+                        bool try2find, int num_threads, const Args &...args);
+
+  /// \brief Constructs an array of objects with multiple threads, taking the
+  /// arguments of the i-th object from the i-th elements of the iterators,
+  /// which must be random access iterators.
+  /// See construct_parallel() for the other details.
+  template <typename T, typename... Iterators>
+  T *construct_it_parallel(char_ptr_holder_type name, size_type length,
+                           bool try2find, int num_threads,
+                           Iterators... iterators);
+
+  /// \brief Finds an already constructed object and returns a handle to it,
+  /// which finds the object again without looking up the name.
+  /// \tparam T The type of the object.
+  /// \param name The name of the object or unique_instance.
+  /// \return Returns a handle; it is not valid if the object is not found.
+  template <typename T>
+  object_handle<T> find_handle(char_ptr_holder_type name) const;
+
+  /// \brief Finds an object by a handle returned by find_handle().
+  /// \tparam T The type of the object.
+  /// \param handle A handle.
+  /// \return Returns a pointer to the object and its length.
+  /// Returns (nullptr, 0) if the handle is not valid or stale; call
+  /// find_handle() again in that case.
+  template <typename T>
+  std::pair<T *, size_type> find(const object_handle<T> &handle) const;
+
   /// \brief Destroy an already constructed object (named or unique).
   /// Returns true if the object is destroyed.
   /// If name is anonymous, returns false.
@@ -237,6 +642,21 @@ class manager_kernel {
   template <typename T>
   bool destroy(char_ptr_holder_type name);
 
+  /// \brief Destroys an array (named or unique) with multiple threads, each
+  /// of which calls the destructors of a range of the objects.
+  /// \param name The name of the array.
+  /// \param num_threads The maximum number of threads to use. If <= 0 is
+  /// given, it is automatically determined.
+  /// \return Returns true if the array is destroyed.
+  template <typename T>
+  bool destroy_parallel(char_ptr_holder_type name, int num_threads);
+
+  /// \brief Removes an object (named or unique) and frees its memory without
+  /// calling the destructors.
+  /// \return Returns true if the object is removed.
+  template <typename T>
+  bool drop(char_ptr_holder_type name);
+
   /// \brief Destroy a constructed object (named, unique, or anonymous).
   /// Cannot destroy an object not allocated by construct/find_or_construct
   /// functions. \tparam T \param ptr \return
@@ -281,6 +701,20 @@ class manager_kernel {
   template <class T>
   bool set_instance_description(const T *ptr, const std::string &description);
 
+  /// \brief Sets the access pattern of an object created with
+  /// construct/find_or_construct, which is applied now and every time the
+  /// datastore is opened until the object is destroyed.
+  /// \tparam T The type of the object.
+  /// \param ptr A pointer to the object.
+  /// \param pattern The access pattern. access_pattern::normal clears it.
+  /// \return Returns false if the object is not found or on error.
+  template <class T>
+  bool set_access_pattern(const T *ptr, access_pattern pattern);
+
+  /// \brief Returns the access pattern set to an object.
+  template <class T>
+  access_pattern get_access_pattern(const T *ptr) const;
+
   /// \brief Returns Returns the number of named objects stored in the managed
   /// segment. \return
   size_type get_num_named_objects() const;
@@ -349,6 +783,14 @@ class manager_kernel {
   /// \return whether this kernel is read-only
   bool read_only() const;
 
+  /// \brief Returns if this kernel was opened with the copy-on-write mode
+  /// \return whether this kernel is copy-on-write
+  bool copy_on_write() const;
+
+  /// \brief Returns if this kernel was created with
+  /// manager_options::volatile_segment.
+  bool volatile_segment() const;
+
   /// \brief Takes a snapshot. The snapshot has a different UUID.
   /// \param destination_base_path Destination path
   /// \param clone Use clone (reflink) to copy data.
@@ -358,6 +800,37 @@ class manager_kernel {
   bool snapshot(const path_type &destination_base_path, bool clone,
                 int num_max_copy_threads);
 
+  /// \brief Takes an incremental snapshot that saves only the pages written
+  /// since the previous incremental snapshot taken by this kernel.
+  /// The first one is a full snapshot. The snapshots are linked to their
+  /// parents and are resolved when they are opened.
+  /// \param destination_base_path Destination path
+  /// \param num_max_copy_threads The maximum number of copy threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns True; other false
+  bool snapshot_incremental(const path_type &destination_base_path,
+                            int num_max_copy_threads);
+
+  /// \brief Writes the changes made since the previous call to 'stream' so
+  /// that apply_replication() updates a replica of the datastore.
+  /// The first call (and the first call after a failure) writes the whole
+  /// datastore. The following ones write only the pages of the segment
+  /// written since the previous call and the management data.
+  /// \param stream An output stream.
+  /// \param full If true, writes the whole datastore.
+  /// \return If succeeded, returns True; other false
+  bool replicate(std::ostream &stream, bool full);
+
+  /// \brief Applies a replication stream written by replicate() to a
+  /// replica, creating the replica if the stream has the whole datastore.
+  /// The replica has to have applied the previous stream, and must not be
+  /// open.
+  /// \param replica_base_path A path to the replica.
+  /// \param stream An input stream.
+  /// \return If succeeded, returns True; other false
+  static bool apply_replication(const path_type &replica_base_path,
+                                std::istream &stream);
+
   /// \brief Copies a data store synchronously, keeping the same UUID.
   /// \param source_base_path Source path.
   /// \param destination_base_path Destination path.
@@ -381,6 +854,85 @@ class manager_kernel {
                                       const path_type &destination_base_path,
                                       bool clone, int num_max_copy_threads);
 
+  /// \brief Copies a data store copying only the chunks in use, keeping the
+  /// same UUID. The free chunks of the copy are holes, and the trailing
+  /// blocks of the segment without chunks in use are not copied.
+  /// The objects stay at the same offsets.
+  /// \param source_base_path Source path.
+  /// \param destination_base_path Destination path.
+  /// \param num_max_copy_threads The maximum number of copy threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns True; other false.
+  static bool repack_copy(const path_type &source_base_path,
+                          const path_type &destination_base_path,
+                          int num_max_copy_threads);
+
+  /// \brief Compresses the segment of a data store that is not open.
+  /// \param base_path Path to a data store.
+  /// \param level The compression level of Zstandard.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns True; other false.
+  static bool compress(const path_type &base_path, int level,
+                       int num_max_threads);
+
+  /// \brief Decompresses the segment of a data store compressed by
+  /// compress().
+  /// \param base_path Path to a data store.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns True; other false.
+  static bool decompress(const path_type &base_path, int num_max_threads);
+
+  /// \brief Compares two data stores that are not open, e.g., snapshots, and
+  /// finds the ranges of the segment whose data differ.
+  /// Only the chunks used in either data store are compared.
+  /// \param base_path0 Path to a data store.
+  /// \param base_path1 Path to another data store.
+  /// \param changed_ranges A pointer to store the (offset, length) of the
+  /// changed ranges in ascending order, in units of the chunk size.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return If succeeded, returns True; other false.
+  static bool diff(
+      const path_type &base_path0, const path_type &base_path1,
+      std::vector<std::pair<size_type, size_type>> *changed_ranges,
+      int num_max_threads);
+
+  /// \brief Reads the attributes of the objects of a kind in a data store
+  /// that is not open, decoding the directory file in parallel.
+  /// \param base_path Path to a data store.
+  /// \param kind The kind of the objects to read.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param attributes A pointer to store the attributes.
+  /// \return If succeeded, returns True; other false.
+  static bool read_object_attributes(
+      const path_type &base_path, instance_kind kind, int num_max_threads,
+      std::vector<object_attribute_type> *attributes);
+
+  /// \brief Checks the integrity of a data store that is not open.
+  /// Cross-validates the chunk directory, the bin directory, and the objects
+  /// in the object directories, and checks the block files.
+  /// \param base_path Path to a data store.
+  /// \param num_max_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param problems A pointer to append the descriptions of the problems.
+  /// \return Returns true if no problem is found; otherwise, false.
+  static bool check_integrity(const path_type &base_path, int num_max_threads,
+                              std::vector<std::string> *problems);
+
+  /// \brief Recovers a data store that was not closed properly because the
+  /// process crashed, making it consistent.
+  /// The object directories are recovered to the state at the last
+  /// flush_async(), snapshot, or open. The chunks allocated after that are
+  /// kept allocated. Memory freed or objects constructed after that could
+  /// be leaked.
+  /// Does nothing if the data store is consistent.
+  /// \param base_path Path to a data store.
+  /// \return If succeeded, returns True; other false.
+  static bool recover(const path_type &base_path);
+
   /// \brief Remove a data store synchronously
   /// \param base_path
   /// \return If succeeded, returns True; other false
@@ -469,6 +1021,105 @@ class manager_kernel {
   template <typename out_stream_type>
   void profile(out_stream_type *log_out);
 
+  /// \brief Collects the memory usage of the data store.
+  /// Unlike profile(), the object cache is not drained.
+  /// Must not be called while other threads allocate or deallocate objects.
+  /// \param stats A pointer to an object to store the statistics.
+  /// \param include_named_objects If true, the size of each named object is
+  /// also collected.
+  /// \param include_resident_bytes If true, the number of bytes of the
+  /// segment resident in memory is also collected, which examines the page
+  /// table of the whole segment.
+  /// \return Returns true on success; otherwise, false.
+  bool get_memory_statistics(memory_statistics *stats,
+                             bool include_named_objects,
+                             bool include_resident_bytes);
+
+  /// \brief Reads the allocation counters, which are maintained on
+  /// allocations and deallocations. Can be called while other threads
+  /// allocate or deallocate objects.
+  /// \param counters A pointer to an object to store the counters.
+  /// \return Returns true on success; otherwise, false.
+  bool get_memory_counters(memory_counters *counters);
+
+  /// \brief Attributes the resident, dirty, and faulted pages of the
+  /// segment to the chunks, bins, and optionally the named and unique
+  /// objects. The faulted pages are the pages that became resident since the
+  /// previous call. Must not be called while other threads allocate or
+  /// deallocate objects.
+  /// \param stats A pointer to an object to store the statistics.
+  /// \param include_named_objects If true, also attributes the pages to the
+  /// named and unique objects.
+  /// \return Returns true on success; otherwise, false.
+  bool get_page_statistics(page_statistics *stats,
+                           bool include_named_objects);
+
+  /// \brief Binds the pages of a region of the application data segment to a
+  /// NUMA node and moves the pages already allocated.
+  /// \param addr The beginning address of the region.
+  /// \param nbytes The size of the region.
+  /// \param node A NUMA node.
+  /// \return Returns false if the region is not in the segment or on error.
+  bool bind_to_numa_node(const void *addr, size_type nbytes, int node);
+
+  /// \brief Spills the segment of a volatile datastore to the datastore
+  /// directory, from the oldest blocks, until the resident anonymous memory
+  /// is at most 'memory_budget' bytes.
+  /// Must not be called while other threads access the segment.
+  /// \param memory_budget The max number of bytes to keep in memory.
+  /// \param num_spilled_bytes If not nullptr, the number of bytes spilled.
+  /// \return Returns false if the datastore is not volatile or on error.
+  bool spill(size_type memory_budget, size_type *num_spilled_bytes);
+
+  /// \brief Samples the accesses to the used chunks since the previous call
+  /// and moves the cold chunks to the far memory tier, and optionally the
+  /// chunks accessed on the far tier back, by a policy.
+  /// Must not be called while other threads allocate or deallocate objects.
+  /// \param policy A policy.
+  /// \param result If not nullptr, the result is stored.
+  /// \return Returns true on success; otherwise, false.
+  bool migrate_cold_chunks(const memory_tiering_policy &policy,
+                           memory_tiering_result *result);
+
+  /// \brief Samples the accesses to the used chunks since the previous
+  /// sample and records them in the heat of the chunks, which is kept in the
+  /// chunk directory. migrate_cold_chunks() also records a sample.
+  /// Must not be called concurrently with migrate_cold_chunks().
+  /// \param stats If not nullptr, the heat of the chunks after the sample is
+  /// stored.
+  /// \return Returns true on success; otherwise, false.
+  bool sample_chunk_heat(chunk_heat_statistics *stats);
+
+  /// \brief Gets the heat of the chunks recorded by the samples, without
+  /// sampling.
+  /// \param stats A pointer to store the statistics.
+  /// \return Returns true on success; otherwise, false.
+  bool get_chunk_heat_statistics(chunk_heat_statistics *stats);
+
+  /// \brief Writes the sampled allocations in a heap profile format pprof
+  /// reads. Available only if METALL_USE_ALLOCATION_SAMPLING is defined.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool write_allocation_profile(const path_type &path);
+
+  /// \brief Starts recording the allocations and deallocations to a file.
+  /// Available only if METALL_USE_ALLOCATION_TRACE is defined.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool start_allocation_trace(const path_type &path);
+
+  /// \brief Stops recording and closes the trace file.
+  /// \return Returns true on success; otherwise, false.
+  bool stop_allocation_trace();
+
+  /// \brief Returns the time spent in each phase of create, open, flush,
+  /// close, and snapshot since this object was constructed or the timings
+  /// were reset.
+  phase_timings get_phase_timings() const;
+
+  /// \brief Resets the phase timings to 0.
+  void reset_phase_timings();
+
  private:
   // -------------------- //
   // Private methods
@@ -477,8 +1128,26 @@ class manager_kernel {
   void priv_check_sanity() const;
   bool priv_validate_runtime_configuration() const;
   difference_type priv_to_offset(const void *ptr) const;
+
+  /// \brief Converts a region to an offset in the application data segment.
+  /// Returns false if the region is not in the segment.
+  bool priv_to_segment_offset(const void *addr, size_type nbytes,
+                              difference_type *offset) const;
   void *priv_to_address(difference_type offset) const;
 
+  /// \brief Records an operation to the allocation trace if it is started.
+  void priv_trace_allocation(
+      [[maybe_unused]] const allocation_trace_op op,
+      [[maybe_unused]] const difference_type offset,
+      [[maybe_unused]] const size_type nbytes,
+      [[maybe_unused]] const size_type alignment = 0) noexcept {
+#ifdef METALL_USE_ALLOCATION_TRACE
+    if (m_allocation_trace) {
+      m_allocation_trace->record(op, offset, nbytes, alignment);
+    }
+#endif
+  }
+
   // ---------- For data store structure  ---------- //
   // Directory structure:
   // base_path/ <- this path is given by user
@@ -497,12 +1166,50 @@ class manager_kernel {
   static bool priv_properly_closed(const path_type &base_path);
   static bool priv_mark_properly_closed(const path_type &base_path);
   static bool priv_unmark_properly_closed(const path_type &base_path);
+  static path_type priv_chunk_operation_log_path(const path_type &base_path);
+  static path_type priv_undo_log_path(const path_type &base_path);
+  bool priv_abort_transaction_without_lock();
+  bool priv_roll_back_interrupted_transaction();
+  bool priv_start_chunk_operation_log();
+  bool priv_apply_access_patterns();
+
+  // Samples the accesses to the chunks with m_chunk_access_sampler and
+  // records them in the heat of the chunks
+  bool priv_sample_chunk_accesses();
 
   // ---------- For constructed objects  ---------- //
   template <typename T, typename proxy>
   T *priv_generic_construct(char_ptr_holder_type name, size_type length,
                             bool try2find, proxy &pr);
 
+  /// \brief Finds an object or allocates and registers memory for an array.
+  /// \return Returns the address and true if the object is found; returns
+  /// the allocated memory and false otherwise. Returns nullptr on error or
+  /// if the object exists but 'try2find' is false.
+  template <typename T>
+  std::pair<void *, bool> priv_find_or_allocate_attr_object(
+      char_ptr_holder_type name, size_type length, bool try2find,
+      bool *zero_filled);
+
+  /// \brief Allocates memory like allocate(), also telling whether the
+  /// memory is known to be zero-filled.
+  void *priv_allocate(size_type nbytes, bool *zero_filled);
+
+  /// \brief Unregisters and frees memory given by
+  /// priv_find_or_allocate_attr_object().
+  void priv_free_attr_object(void *ptr);
+
+  /// \brief Constructs an array with multiple threads.
+  /// 'construct' constructs the i-th object at the given address.
+  template <typename T, typename constructor_type>
+  T *priv_construct_parallel(char_ptr_holder_type name, size_type length,
+                             bool try2find, int num_threads,
+                             bool skip_if_zero_filled,
+                             const constructor_type &construct);
+
+  template <typename T>
+  std::pair<T *, size_type> priv_find_no_mutex(char_ptr_holder_type name) const;
+
   template <typename T>
   bool priv_register_attr_object_no_mutex(char_ptr_holder_type name,
                                           difference_type offset,
@@ -513,20 +1220,107 @@ class manager_kernel {
   template <typename T>
   void priv_destruct_and_free_memory(difference_type offset, size_type length);
 
+  /// \brief Finds an object (named or unique) and removes it from the object
+  /// directory.
+  /// \return Returns the address and length of the object; returns nullptr
+  /// if it is not found.
+  template <typename T>
+  std::pair<T *, size_type> priv_find_and_remove_attr_object(
+      char_ptr_holder_type name);
+
   // ---------- For segment  ---------- //
   bool priv_open(const path_type &base_path, bool read_only,
-                 size_type vm_reserve_size_request = 0);
+                 size_type vm_reserve_size_request = 0,
+                 bool copy_on_write = false, bool live = false);
+  /// \brief Opens the segment and the latest published version with the
+  /// live read-only mode. Called by priv_open().
+  bool priv_open_live_read_only(size_type vm_reserve_size);
+  /// \brief Loads (and pins) the pages given by the prefault options.
+  /// Called by priv_open().
+  bool priv_prefault_on_open();
   bool priv_create(const path_type &base_path, size_type vm_reserve_size);
 
   // ---------- For serializing/deserializing  ---------- //
-  bool priv_serialize_management_data();
-  bool priv_deserialize_management_data();
+  bool priv_serialize_management_data(bool compact = false);
+  bool priv_write_management_data(bool compact);
+  bool priv_deserialize_management_data(bool use_object_indices = false);
+  bool priv_read_management_data();
+
+  // ---------- For lazy loading of the management data  ---------- //
+  enum class lazy_data_state : uint8_t { unloaded, loaded, failed };
+
+  // The management data of the segment allocator is loaded when it is used
+  // first time after open(). Finding objects does not require the data.
+  bool priv_load_segment_memory_allocator();
+  bool priv_segment_memory_allocator_loaded() const;
+
+  // When a datastore is opened read-only, objects are found by the object
+  // indices and the object directories are loaded when other functions use
+  // them first time.
+  /// \brief Opens the object indices if the datastore has them.
+  bool priv_open_object_indices();
+  /// \brief Writes the object indices. Called when closing the datastore or
+  /// publishing a version (if 'version' is not 0).
+  bool priv_write_object_indices(publication::version_type version = 0) const;
+  /// \brief Removes the object indices as they become stale when the
+  /// datastore is modified.
+  static bool priv_remove_object_indices(const path_type &base_path);
+  /// \brief Returns the path of an object index file; the versions published
+  /// to live readers have their own files.
+  static path_type priv_object_index_path(const path_type &base_path,
+                                          const char *file_name,
+                                          publication::version_type version);
+  /// \brief Opens the object indices and the segment size of the latest
+  /// published version.
+  bool priv_open_published_object_indices(
+      named_object_index *named_index, named_object_index *unique_index,
+      publication::version_type *version, size_type *segment_size) const;
+  /// \brief Loads the object directories if they have not been loaded.
+  /// Loading them does not change the logical state; thus, const.
+  bool priv_load_object_directories() const;
 
   // ---------- snapshot  ---------- //
   /// \brief Takes a snapshot. The snapshot has a different UUID.
   bool priv_snapshot(const path_type &destination_base_path, bool clone,
                      int num_max_copy_threads);
 
+  /// \brief Takes an incremental snapshot.
+  bool priv_snapshot_incremental(const path_type &destination_base_path,
+                                 int num_max_copy_threads);
+
+  /// \brief Builds the segment of an incremental snapshot from its parents
+  /// if it has not been built.
+  static bool priv_resolve_incremental_snapshot(const path_type &base_path,
+                                                const json_store &metadata,
+                                                bool writable);
+
+  /// \brief Copies the management directory.
+  static bool priv_copy_management_directory(const path_type &src_base_path,
+                                             const path_type &dst_base_path,
+                                             int num_max_copy_threads);
+
+  // ---------- replication  ---------- //
+  /// \brief Writes the files in the management directory to a replication
+  /// stream. The files only a running process uses are excluded.
+  bool priv_write_replication_management_data(std::ostream &stream) const;
+
+  /// \brief Reads the files written by
+  /// priv_write_replication_management_data() into the management directory
+  /// of a replica, removing the other files in the directory.
+  static bool priv_read_replication_management_data(const path_type &base_path,
+                                                    std::istream &stream);
+
+  /// \brief Reads the session and the sequence number of the last
+  /// replication stream a replica has applied.
+  /// \return Returns false if the replica has no such state.
+  static bool priv_read_replication_state(const path_type &base_path,
+                                          uint64_t *session,
+                                          uint64_t *sequence);
+  static bool priv_write_replication_state(const path_type &base_path,
+                                           uint64_t session,
+                                           uint64_t sequence);
+  static bool priv_remove_replication_state(const path_type &base_path);
+
   // ---------- File operations  ---------- //
   /// \brief Copies all backing files using reflink if possible
   static bool priv_copy_data_store(const path_type &src_base_path,
@@ -535,6 +1329,17 @@ class manager_kernel {
 
   /// \brief Removes all backing files
   static bool priv_remove_data_store(const path_type &base_path);
+  static path_type priv_segment_base_path(const path_type &base_path);
+  static bool priv_write_segment_location(const path_type &base_path,
+                                          const path_type &segment_base_path);
+  static bool priv_remove_segment_location(const path_type &base_path);
+  /// \brief Marks the chunks in use by a data store that is not open.
+  static bool priv_read_used_chunks(const path_type &base_path,
+                                    std::vector<bool> *used_chunks);
+  /// \brief Returns the (offset, length) of the chunks marked, merging
+  /// adjacent ones.
+  static std::vector<std::pair<size_type, size_type>> priv_chunk_regions(
+      const std::vector<bool> &used_chunks);
 
   // ---------- Management metadata  ---------- //
   static bool priv_read_management_metadata(const path_type &base_path,
@@ -548,6 +1353,14 @@ class manager_kernel {
   static bool priv_set_uuid(json_store *metadata_json);
   static std::string priv_get_uuid(const json_store &metadata_json);
 
+  template <typename table>
+  static std::string priv_size_class_table_string();
+  static bool priv_set_size_class_table(json_store *metadata_json);
+  /// \brief Returns true if the data store was created with the same size
+  /// class table. A data store without the table information was created
+  /// with the default table.
+  static bool priv_check_size_class_table(const json_store &metadata_json);
+
   // ---------- Description  ---------- //
   static bool priv_read_description(const path_type &base_path,
                                     std::string *description);
@@ -563,11 +1376,51 @@ class manager_kernel {
   attributed_object_directory_type m_unique_object_directory{};
   attributed_object_directory_type m_anonymous_object_directory{};
   segment_memory_allocator m_segment_memory_allocator{nullptr};
+  manager_options m_options;
   std::unique_ptr<json_store> m_manager_metadata{nullptr};
   segment_storage m_segment_storage{};
+  // The last incremental snapshot, the parent of the next one
+  path_type m_last_snapshot_path{};
+  // The replication stream written by replicate(); the session is 0 if the
+  // next stream has to have the whole datastore
+  uint64_t m_replication_session{0};
+  uint64_t m_replication_sequence{0};
+
+  std::unique_ptr<std::atomic<lazy_data_state>>
+      m_segment_memory_allocator_state{nullptr};
+  named_object_index m_named_object_index{};
+  named_object_index m_unique_object_index{};
+  publication m_publication{};
+  // The version a live reader sees or a writer published last
+  publication::version_type m_published_version{0};
+  bool m_live_reader{false};
+  // True if created with manager_options::volatile_segment
+  bool m_volatile{false};
+  std::unique_ptr<std::atomic<lazy_data_state>> m_object_directories_state{
+      nullptr};
+  // Incremented when an object is removed from the object directories,
+  // which makes the object handles stale
+  std::unique_ptr<std::atomic_uint64_t> m_object_directory_generation{nullptr};
+  std::unique_ptr<phase_timer> m_phase_timer{nullptr};
+  // Stopped before the segment is released
+  std::unique_ptr<checkpoint_service> m_checkpoint_service{nullptr};
+  // Keeps the resident pages found by the previous get_page_statistics()
+  std::unique_ptr<page_state_scanner> m_page_state_scanner{nullptr};
+  // Keeps the accesses sampled by the previous migrate_cold_chunks()
+  std::unique_ptr<chunk_access_sampler> m_chunk_access_sampler{nullptr};
+  // Guarded by m_object_directories_mutex
+  access_pattern_table m_access_pattern_table{};
+  // Guarded by m_transaction_mutex
+  undo_log m_undo_log{};
 
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-  std::unique_ptr<mutex_type> m_object_directories_mutex{nullptr};
+  std::unique_ptr<directory_mutex_type> m_object_directories_mutex{nullptr};
+  std::unique_ptr<mutex_type> m_segment_memory_allocator_load_mutex{nullptr};
+  std::unique_ptr<mutex_type> m_object_directories_load_mutex{nullptr};
+  std::unique_ptr<mutex_type> m_transaction_mutex{nullptr};
+#endif
+#ifdef METALL_USE_ALLOCATION_TRACE
+  std::unique_ptr<allocation_trace_writer> m_allocation_trace{nullptr};
 #endif
 };
 
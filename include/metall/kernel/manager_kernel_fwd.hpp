@@ -14,8 +14,11 @@ namespace kernel {
 /// \tparam segment_storage Segment storage manager.
 /// \tparam chunk_no_type Type of chunk number
 /// \tparam chunk_size Size of single chunk in byte
+/// \tparam size_class_table Table of the small object sizes
+/// \tparam concurrency_policy multi_threaded or single_threaded
 template <typename _storage, typename _segment_storage, typename _chunk_no_type,
-          std::size_t _chunk_size>
+          std::size_t _chunk_size, typename _size_class_table,
+          typename _concurrency_policy>
 class manager_kernel;
 
 }  // namespace kernel
@@ -13,97 +13,622 @@ namespace metall::kernel {
 // -------------------- //
 // Constructor
 // -------------------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-manager_kernel<st, sst, cn, cs>::manager_kernel()
-    : m_segment_memory_allocator(&m_segment_storage) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+manager_kernel<st, sst, cn, cs, sct, ccp>::manager_kernel(
+    const manager_options &options)
+    : m_segment_memory_allocator(&m_segment_storage, options),
+      m_options(options) {
   m_manager_metadata = std::make_unique<json_store>();
   if (!m_manager_metadata) {
     return;
   }
+  m_segment_memory_allocator_state =
+      std::make_unique<std::atomic<lazy_data_state>>(
+          lazy_data_state::loaded);
+  if (!m_segment_memory_allocator_state) {
+    return;
+  }
+  m_object_directories_state =
+      std::make_unique<std::atomic<lazy_data_state>>(lazy_data_state::loaded);
+  if (!m_object_directories_state) {
+    return;
+  }
+  m_object_directory_generation = std::make_unique<std::atomic_uint64_t>(0);
+  if (!m_object_directory_generation) {
+    return;
+  }
+  m_phase_timer = std::make_unique<phase_timer>();
+  if (!m_phase_timer) {
+    return;
+  }
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-  m_object_directories_mutex = std::make_unique<mutex_type>();
+  m_object_directories_mutex = std::make_unique<directory_mutex_type>();
   if (!m_object_directories_mutex) {
     return;
   }
+  m_segment_memory_allocator_load_mutex = std::make_unique<mutex_type>();
+  if (!m_segment_memory_allocator_load_mutex) {
+    return;
+  }
+  m_object_directories_load_mutex = std::make_unique<mutex_type>();
+  if (!m_object_directories_load_mutex) {
+    return;
+  }
+  m_transaction_mutex = std::make_unique<mutex_type>();
+  if (!m_transaction_mutex) {
+    return;
+  }
 #endif
   m_good = priv_validate_runtime_configuration();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-manager_kernel<st, sst, cn, cs>::~manager_kernel() noexcept {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+manager_kernel<st, sst, cn, cs, sct, ccp>::~manager_kernel() noexcept {
   close();
 }
 
 // -------------------- //
 // Public methods
 // -------------------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::create(const path_type &base_path,
-                                             const size_type vm_reserve_size) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::create(
+    const path_type &base_path, const size_type vm_reserve_size) {
   return m_good = priv_create(base_path, vm_reserve_size);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::open_read_only(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::open_read_only(
     const path_type &base_path) {
   return m_good = priv_open(base_path, true, 0);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::open(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::open_live_read_only(
+    const path_type &base_path, const size_type vm_reserve_size) {
+  return m_good = priv_open(base_path, true, vm_reserve_size, false, true);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::open_copy_on_write(
+    const path_type &base_path, const size_type vm_reserve_size_request) {
+  return m_good = priv_open(base_path, false, vm_reserve_size_request, true);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::open(
     const path_type &base_path, const size_type vm_reserve_size_request) {
   return m_good = priv_open(base_path, false, vm_reserve_size_request);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void manager_kernel<st, sst, cn, cs>::close() {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::close() {
   if (m_segment_storage.is_open()) {
     priv_check_sanity();
-    if (!m_segment_storage.read_only()) {
-      priv_serialize_management_data();
+    stop_checkpointing();
+    m_segment_memory_allocator.stop_background_tasks();
+    const bool write_back = !m_segment_storage.read_only() &&
+                            !m_segment_storage.copy_on_write() &&
+                            !volatile_segment();
+    if (write_back) {
+      {
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+        lock_guard_type guard(*m_transaction_mutex);
+#endif
+        // A transaction not committed is rolled back
+        if (m_undo_log.active()) priv_abort_transaction_without_lock();
+      }
+      priv_serialize_management_data(true);
+      // Read-only opens work without the indices
+      priv_write_object_indices();
+      const auto timer = m_phase_timer->measure(phase::sync_segment);
       m_segment_storage.sync(true);
     }
 
     m_good = false;
     m_segment_storage.release();
-
-    if (!m_segment_storage.read_only()) {
+    m_named_object_index.close();
+    m_unique_object_index.close();
+    m_object_directories_state->store(lazy_data_state::loaded);
+    m_publication.close();
+    m_published_version = 0;
+    m_live_reader = false;
+    m_access_pattern_table.clear();
+
+    if (write_back) {
       // This function must be called at the end
       priv_mark_properly_closed(m_base_path);
+    } else if (m_volatile) {
+      // The segment is gone; the datastore cannot be opened
+      m_volatile = false;
+      if (!remove(m_base_path)) {
+        std::stringstream ss;
+        ss << "Failed to remove a volatile datastore " << m_base_path;
+        logger::out(logger::level::warning, __FILE__, __LINE__,
+                    ss.str().c_str());
+      }
     }
   }
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void manager_kernel<st, sst, cn, cs>::flush(const bool synchronous) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::flush(const bool synchronous) {
   priv_check_sanity();
+  const auto timer = m_phase_timer->measure(phase::sync_segment);
   m_segment_storage.sync(synchronous);
+  if (volatile_segment() && m_options.volatile_memory_budget > 0) {
+    spill(m_options.volatile_memory_budget, nullptr);
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::spill(
+    const size_type memory_budget, size_type *const num_spilled_bytes) {
+  priv_check_sanity();
+  if (num_spilled_bytes) *num_spilled_bytes = 0;
+  if constexpr (has_volatile_mode_v<segment_storage>) {
+    if (!volatile_segment()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Only a volatile datastore can be spilled");
+      return false;
+    }
+    std::size_t spilled = 0;
+    const bool ret = m_segment_storage.spill(memory_budget, &spilled);
+    if (num_spilled_bytes) *num_spilled_bytes = spilled;
+    return ret;
+  } else {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The segment storage does not support the volatile mode");
+    return false;
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::prefetch(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.prefetch(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::pin(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.pin(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::unpin(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.unpin(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::pinned_size() const {
+  priv_check_sanity();
+  return m_segment_storage.pinned_size();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::gpu_register(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.gpu_register(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::gpu_unregister(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.gpu_unregister(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::load_to_device(
+    const void *const addr, const size_type nbytes,
+    void *const device_buffer) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.load_to_device(offset, nbytes, device_buffer);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::persist(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.persist(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::begin_transaction() {
+  priv_check_sanity();
+  if (m_segment_storage.read_only() || m_segment_storage.copy_on_write() ||
+      volatile_segment()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Transactions need a data store writable to its files");
+    return false;
+  }
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_transaction_mutex);
+#endif
+  return m_undo_log.begin(priv_undo_log_path(m_base_path));
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::add_to_transaction(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_transaction_mutex);
+#endif
+  return m_undo_log.add(m_segment_storage.get_segment(), offset, nbytes,
+                        m_segment_storage.size());
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::commit_transaction() {
+  priv_check_sanity();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_transaction_mutex);
+#endif
+  return m_undo_log.commit([this](const uint64_t offset, const uint64_t size) {
+    return m_segment_storage.persist(offset, size);
+  });
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::abort_transaction() {
+  priv_check_sanity();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_transaction_mutex);
+#endif
+  return priv_abort_transaction_without_lock();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::in_transaction() const {
+  priv_check_sanity();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_transaction_mutex);
+#endif
+  return m_undo_log.active();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::dax_mapped() const {
+  priv_check_sanity();
+  return m_segment_storage.dax_mapped();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::advise_cold(
+    const void *const addr, const size_type nbytes) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.advise_cold(offset, nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::advise_access_pattern(
+    const void *const addr, const size_type nbytes,
+    const access_pattern pattern) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.advise_access_pattern(offset, nbytes, pattern);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::future<bool> manager_kernel<st, sst, cn, cs, sct, ccp>::flush_async(
+    const int num_max_threads) {
+  priv_check_sanity();
+  if (!priv_serialize_management_data()) {
+    std::promise<bool> promise;
+    promise.set_value(false);
+    return promise.get_future();
+  }
+  return m_segment_storage.sync_async(num_max_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::start_checkpointing(
+    const checkpoint_options &options) {
+  priv_check_sanity();
+  stop_checkpointing();
+  if (m_segment_storage.read_only() || m_segment_storage.copy_on_write() ||
+      m_volatile) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Checkpointing needs a data store writable to its files");
+    return false;
+  }
+  if constexpr (has_write_back_cache_v<segment_storage>) {
+    // The blocks cached in anonymous memory are always dirty
+    if (m_segment_storage.write_back_cache()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot checkpoint with the write-back cache mode");
+      return false;
+    }
+  }
+
+  m_checkpoint_service = std::make_unique<checkpoint_service>(
+      options,
+      [this]() {
+        return std::make_pair(
+            const_cast<void *>(m_segment_storage.get_segment()),
+            m_segment_storage.size());
+      },
+      [this](void *const addr, const std::size_t nbytes) {
+        return persist(addr, nbytes);
+      },
+      mdtl::io_executor::get_device_id(
+          priv_segment_base_path(m_base_path).c_str()));
+  if (!m_checkpoint_service->running()) {
+    m_checkpoint_service.reset();
+    return false;
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::stop_checkpointing() {
+  m_checkpoint_service.reset();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::checkpointing() const {
+  return m_checkpoint_service && m_checkpoint_service->running();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::publish() {
+  priv_check_sanity();
+  if (m_segment_storage.read_only() || m_segment_storage.copy_on_write() ||
+      m_volatile) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Only a datastore opened with the write mode can publish");
+    return false;
+  }
+  if constexpr (has_write_back_cache_v<segment_storage>) {
+    if (m_segment_storage.write_back_cache()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot publish versions with the write-back cache mode, "
+                  "which does not share new blocks with the readers");
+      return false;
+    }
+  }
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  directory_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+  if (!m_publication.is_open() &&
+      !m_publication.open(storage::get_path(m_base_path,
+                                            {k_management_dir_name,
+                                             k_publication_file_name}),
+                          true)) {
+    return false;
+  }
+
+  const auto version = m_publication.version() + 1;
+  if (!priv_write_object_indices(version)) return false;
+  m_publication.publish(version, m_segment_storage.size());
+  m_published_version = version;
+
+  // The readers move from the previous version to this one; the older
+  // versions are still usable by the readers that have opened them
+  if (version > 2) {
+    for (const auto *name :
+         {k_named_object_index_file_name, k_unique_object_index_file_name}) {
+      mdtl::remove_file(priv_object_index_path(m_base_path, name, version - 2));
+    }
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::refresh() {
+  priv_check_sanity();
+  if (!m_live_reader) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Only a datastore opened with the live read-only mode can "
+                "refresh");
+    return false;
+  }
+  if constexpr (has_live_read_only_mode_v<segment_storage>) {
+    publication::version_type version = 0;
+    size_type segment_size = 0;
+    if (m_publication.read(&version, &segment_size) &&
+        version == m_published_version) {
+      return true;
+    }
+
+    named_object_index named_index;
+    named_object_index unique_index;
+    if (!priv_open_published_object_indices(&named_index, &unique_index,
+                                            &version, &segment_size)) {
+      return false;
+    }
+
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+    directory_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+    if (!m_segment_storage.map_new_blocks(segment_size)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to map the segment of the published version");
+      return false;
+    }
+    m_named_object_index = std::move(named_index);
+    m_unique_object_index = std::move(unique_index);
+    m_published_version = version;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+publication::version_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::published_version() const {
+  return m_published_version;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void *manager_kernel<st, sst, cn, cs>::allocate(
-    const manager_kernel<st, sst, cn, cs>::size_type nbytes) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::compact() {
   priv_check_sanity();
+  if (m_segment_storage.read_only()) return false;
+  if (!priv_load_segment_memory_allocator()) return false;
+  m_segment_memory_allocator.compact();
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::allocate(
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes) {
+  return priv_allocate(nbytes, nullptr);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::allocate_zeroed(
+    const size_type nbytes) {
+  bool zero_filled = false;
+  void *const addr = priv_allocate(nbytes, &zero_filled);
+  if (addr && !zero_filled) std::memset(addr, 0, nbytes);
+  return addr;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::priv_allocate(
+    const size_type nbytes, bool *const zero_filled) {
+  priv_check_sanity();
+  if (zero_filled) *zero_filled = false;
   if (m_segment_storage.read_only()) return nullptr;
+  if (!priv_load_segment_memory_allocator()) return nullptr;
 
-  const auto offset = m_segment_memory_allocator.allocate(nbytes);
+  const auto offset = m_segment_memory_allocator.allocate(nbytes, zero_filled);
   if (offset == segment_memory_allocator::k_null_offset) {
     return nullptr;
   }
   assert(offset >= 0);
+  priv_trace_allocation(allocation_trace_op::allocate, offset, nbytes);
 
   return priv_to_address(offset);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void *manager_kernel<st, sst, cn, cs>::allocate_aligned(
-    const manager_kernel<st, sst, cn, cs>::size_type nbytes,
-    const manager_kernel<st, sst, cn, cs>::size_type alignment) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::set_segment_size_limits(
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type soft_limit,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type hard_limit) {
+  priv_check_sanity();
+  m_segment_memory_allocator.set_segment_size_limits(soft_limit, hard_limit);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::set_segment_limit_handler(
+    segment_limit_handler handler) {
+  priv_check_sanity();
+  m_segment_memory_allocator.set_segment_limit_handler(std::move(handler));
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::set_placement_hint(
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type hint) {
+  if (hint >= num_placement_hints()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Placement hint is out of range");
+    return false;
+  }
+  return segment_memory_allocator::set_placement_hint(hint);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::clear_placement_hint() {
+  segment_memory_allocator::set_placement_hint(
+      segment_memory_allocator::k_no_placement_hint);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_placement_hint(
+    manager_kernel<st, sst, cn, cs, sct, ccp>::size_type *const hint) {
+  const auto current = segment_memory_allocator::placement_hint();
+  if (current == segment_memory_allocator::k_no_placement_hint) return false;
+  if (hint) *hint = current;
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::allocate_aligned(
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type alignment) {
   priv_check_sanity();
   if (m_segment_storage.read_only()) return nullptr;
 
-  // This requirement could be removed, but it would need some work to do
-  if (alignment > k_chunk_size) return nullptr;
+  // The segment allocator aligns an allocation within the segment only
+  if (alignment > k_chunk_size &&
+      reinterpret_cast<uint64_t>(m_segment_storage.get_segment()) % alignment !=
+          0) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The segment is not aligned to the requested alignment");
+    return nullptr;
+  }
+  if (!priv_load_segment_memory_allocator()) return nullptr;
 
   const auto offset =
       m_segment_memory_allocator.allocate_aligned(nbytes, alignment);
@@ -111,6 +636,8 @@ void *manager_kernel<st, sst, cn, cs>::allocate_aligned(
     return nullptr;
   }
   assert(offset >= 0);
+  priv_trace_allocation(allocation_trace_op::allocate, offset, nbytes,
+                        alignment);
 
   assert((std::ptrdiff_t)m_segment_storage.get_segment() % alignment == 0);
   auto *addr = priv_to_address(offset);
@@ -118,30 +645,327 @@ void *manager_kernel<st, sst, cn, cs>::allocate_aligned(
   return addr;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void manager_kernel<st, sst, cn, cs>::deallocate(void *const addr) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::deallocate(void *const addr) {
   priv_check_sanity();
   if (m_segment_storage.read_only()) return;
   if (!addr) return;
+  if (!priv_load_segment_memory_allocator()) return;
+  priv_trace_allocation(allocation_trace_op::deallocate, priv_to_offset(addr),
+                        0);
   m_segment_memory_allocator.deallocate(priv_to_offset(addr));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::all_memory_deallocated() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::deallocate(
+    void *const addr,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only()) return;
+  if (!addr) return;
+  if (!priv_load_segment_memory_allocator()) return;
+  priv_trace_allocation(allocation_trace_op::deallocate, priv_to_offset(addr),
+                        nbytes);
+  m_segment_memory_allocator.deallocate(priv_to_offset(addr), nbytes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::reallocate(
+    void *const addr,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes) {
+  if (!addr) return allocate(nbytes);
+  if (nbytes == 0) {
+    deallocate(addr);
+    return nullptr;
+  }
+  if (resize_in_place(addr, nbytes)) return addr;
+
+  // resize_in_place() has already done the sanity checks
+  void *const new_addr = allocate(nbytes);
+  if (!new_addr) return nullptr;
+  const auto old_size =
+      m_segment_memory_allocator.allocated_size(priv_to_offset(addr));
+  std::memcpy(new_addr, addr, std::min(old_size, nbytes));
+  deallocate(addr);
+  return new_addr;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::resize_in_place(
+    void *const addr,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only()) return false;
+  if (!addr) return false;
+  if (!priv_load_segment_memory_allocator()) return false;
+  if (!m_segment_memory_allocator.resize_in_place(priv_to_offset(addr),
+                                                  nbytes)) {
+    return false;
+  }
+  priv_trace_allocation(allocation_trace_op::resize, priv_to_offset(addr),
+                        nbytes);
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::allocate_many(
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type nbytes,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type num,
+    void **const addrs) {
   priv_check_sanity();
+  if (!addrs || num == 0) return 0;
+  std::fill_n(addrs, num, nullptr);
+  if (m_segment_storage.read_only()) return 0;
+  if (!priv_load_segment_memory_allocator()) return 0;
+
+  std::vector<difference_type> offsets(num);
+  const auto num_allocated =
+      m_segment_memory_allocator.allocate_many(nbytes, num, offsets.data());
+  for (size_type i = 0; i < num_allocated; ++i) {
+    assert(offsets[i] >= 0);
+    priv_trace_allocation(allocation_trace_op::allocate, offsets[i], nbytes);
+    addrs[i] = priv_to_address(offsets[i]);
+  }
+  return num_allocated;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::deallocate_many(
+    void *const *const addrs,
+    const manager_kernel<st, sst, cn, cs, sct, ccp>::size_type num) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only()) return;
+  if (!addrs || num == 0) return;
+  if (!priv_load_segment_memory_allocator()) return;
+
+  std::vector<difference_type> offsets(num);
+  for (size_type i = 0; i < num; ++i) {
+    offsets[i] = (addrs[i]) ? priv_to_offset(addrs[i])
+                            : segment_memory_allocator::k_null_offset;
+    if (addrs[i]) {
+      priv_trace_allocation(allocation_trace_op::deallocate, offsets[i], 0);
+    }
+  }
+  m_segment_memory_allocator.deallocate_many(offsets.data(), num);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::all_memory_deallocated() const {
+  priv_check_sanity();
+  // Loading the allocator data does not change the logical state
+  if (!const_cast<self_type *>(this)->priv_load_segment_memory_allocator()) {
+    return false;
+  }
   return m_segment_memory_allocator.all_memory_deallocated();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-std::pair<T *, typename manager_kernel<st, sst, cn, cs>::size_type>
-manager_kernel<st, sst, cn, cs>::find(char_ptr_holder_type name) const {
+std::pair<T *, typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type>
+manager_kernel<st, sst, cn, cs, sct, ccp>::find(
+    char_ptr_holder_type name) const {
   priv_check_sanity();
 
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  // The directories never change while the data store is read-only; a live
+  // reader replaces the indices in refresh()
+  if (!m_segment_storage.read_only() || m_live_reader) {
+    directory_shared_lock_guard_type guard(*m_object_directories_mutex);
+    return priv_find_no_mutex<T>(name);
+  }
+#endif
+  return priv_find_no_mutex<T>(name);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T, typename... Args>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::construct_many(
+    const std::vector<std::string> &names, std::vector<T *> *const objects,
+    const Args &...args) {
+  priv_check_sanity();
+  objects->clear();
+  if (m_segment_storage.read_only() || names.empty()) return false;
+  {
+    std::vector<std::string> sorted(names);
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.front().empty() ||
+        std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Empty or duplicate names are given");
+      return false;
+    }
+  }
+
+  std::vector<void *> addrs(names.size(), nullptr);
+  if (allocate_many(sizeof(T), addrs.size(), addrs.data()) != addrs.size()) {
+    deallocate_many(addrs.data(), addrs.size());
+    return false;
+  }
+
+  // Constructs the objects before registering them so that other threads
+  // never find an object under construction
+  std::size_t num_constructed = 0;
+  const auto destroy_all = [&]() {
+    for (std::size_t i = 0; i < num_constructed; ++i) {
+      static_cast<T *>(addrs[i])->~T();
+    }
+    deallocate_many(addrs.data(), addrs.size());
+  };
+  try {
+    for (; num_constructed < addrs.size(); ++num_constructed) {
+      ::new (addrs[num_constructed]) T(args...);
+    }
+  } catch (...) {
+    destroy_all();
+    throw;
+  }
+
+  bool registered = false;
+  {
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+    directory_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+    const bool exist =
+        std::any_of(names.begin(), names.end(), [this](const auto &name) {
+          return m_named_object_directory.count(name) > 0;
+        });
+    if (!exist && m_named_object_directory.reserve(names.size())) {
+      std::size_t num_registered = 0;
+      for (; num_registered < names.size(); ++num_registered) {
+        if (!m_named_object_directory.insert(
+                names[num_registered], priv_to_offset(addrs[num_registered]),
+                1, gen_type_id<T>())) {
+          break;
+        }
+      }
+      registered = (num_registered == names.size());
+      for (std::size_t i = 0; !registered && i < num_registered; ++i) {
+        m_named_object_directory.erase(priv_to_offset(addrs[i]));
+      }
+    }
+  }
+  if (!registered) {
+    destroy_all();
+    return false;
+  }
+
+  objects->reserve(addrs.size());
+  for (auto *const addr : addrs) objects->push_back(static_cast<T *>(addr));
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T, typename... Args>
+T *manager_kernel<st, sst, cn, cs, sct, ccp>::construct_parallel(
+    char_ptr_holder_type name, const size_type length, const bool try2find,
+    const int num_threads, const Args &...args) {
+  // Zero bytes represent value-initialized objects of such types, except
+  // pointers to data members (-1 on common ABIs)
+  constexpr bool zero_bytes_are_value_initialized =
+      sizeof...(Args) == 0 && std::is_trivially_default_constructible_v<T> &&
+      !std::is_member_pointer_v<std::remove_all_extents_t<T>>;
+  return priv_construct_parallel<T>(
+      name, length, try2find, num_threads, zero_bytes_are_value_initialized,
+      [&args...](T *const addr, std::size_t) { ::new (addr) T(args...); });
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T, typename... Iterators>
+T *manager_kernel<st, sst, cn, cs, sct, ccp>::construct_it_parallel(
+    char_ptr_holder_type name, const size_type length, const bool try2find,
+    const int num_threads, Iterators... iterators) {
+  return priv_construct_parallel<T>(
+      name, length, try2find, num_threads, false,
+      [&iterators...](T *const addr, const std::size_t i) {
+        ::new (addr) T(*std::next(iterators, std::ptrdiff_t(i))...);
+      });
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::template object_handle<T>
+manager_kernel<st, sst, cn, cs, sct, ccp>::find_handle(
+    char_ptr_holder_type name) const {
+  priv_check_sanity();
+
+  object_handle<T> handle;
+  const auto make_handle = [this, &name, &handle]() {
+    // The generation is read before the lookup so that a removal between
+    // them makes the handle stale rather than dangling
+    handle.m_generation =
+        m_object_directory_generation->load(std::memory_order_acquire);
+    const auto found = priv_find_no_mutex<T>(name);
+    if (found.first) {
+      handle.m_offset = priv_to_offset(found.first);
+      handle.m_length = found.second;
+    }
+  };
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  if (!m_segment_storage.read_only() || m_live_reader) {
+    directory_shared_lock_guard_type guard(*m_object_directories_mutex);
+    make_handle();
+    return handle;
+  }
+#endif
+  make_handle();
+  return handle;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+std::pair<T *, typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type>
+manager_kernel<st, sst, cn, cs, sct, ccp>::find(
+    const object_handle<T> &handle) const {
+  if (!handle.valid() ||
+      handle.m_generation !=
+          m_object_directory_generation->load(std::memory_order_acquire)) {
+    return std::make_pair(nullptr, 0);
+  }
+  return std::make_pair(
+      reinterpret_cast<T *>(priv_to_address(handle.m_offset)),
+      handle.m_length);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+std::pair<T *, typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type>
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_find_no_mutex(
+    char_ptr_holder_type name) const {
   if (name.is_anonymous()) {
     return std::make_pair(nullptr, 0);
   }
 
+  // Finds the object by the shared index instead of loading the directories
+  if (m_live_reader ||
+      m_object_directories_state->load(std::memory_order_acquire) ==
+          lazy_data_state::unloaded) {
+    const auto &index =
+        name.is_unique() ? m_unique_object_index : m_named_object_index;
+    named_object_index::offset_type offset = 0;
+    size_type length = 0;
+    if (index.find(name.is_unique() ? gen_type_name<T>() : name.get(), &offset,
+                   &length)) {
+      return std::make_pair(reinterpret_cast<T *>(priv_to_address(offset)),
+                            length);
+    }
+    return std::make_pair(nullptr, 0);
+  }
+
   if (name.is_unique()) {
     auto itr = m_unique_object_directory.find(gen_type_name<T>());
     if (itr != m_unique_object_directory.end()) {
@@ -161,49 +985,114 @@ manager_kernel<st, sst, cn, cs>::find(char_ptr_holder_type name) const {
   return std::make_pair(nullptr, 0);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::destroy(
+    char_ptr_holder_type name) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only()) return false;
+
+  const auto [ptr, length] = priv_find_and_remove_attr_object<T>(name);
+  if (!ptr) return false;
+
+  priv_destruct_and_free_memory<T>(priv_to_offset(ptr), length);
+
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::destroy(char_ptr_holder_type name) {
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::destroy_parallel(
+    char_ptr_holder_type name, const int num_threads) {
   priv_check_sanity();
   if (m_segment_storage.read_only()) return false;
 
+  const auto [ptr, length] = priv_find_and_remove_attr_object<T>(name);
+  if (!ptr) return false;
+
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    // The destructors free memory, e.g., of container elements, from many
+    // threads; the frees go to the per-CPU object caches
+    const std::size_t max_threads =
+        (num_threads > 0) ? num_threads
+                          : mdtl::io_executor::instance().num_threads();
+    const std::size_t num_tasks =
+        std::min<std::size_t>(max_threads * 4, length);
+    const std::size_t objects_per_task = (length + num_tasks - 1) / num_tasks;
+    T *const array = ptr;
+    const std::size_t array_length = length;
+    mdtl::io_executor::instance().parallel_for(
+        num_tasks, max_threads, [&](const std::size_t task_no) {
+          const std::size_t first =
+              std::min(task_no * objects_per_task, array_length);
+          const std::size_t last =
+              std::min(first + objects_per_task, array_length);
+          std::destroy(array + first, array + last);
+          return true;
+        });
+  }
+
+  // Only frees the memory
+  priv_destruct_and_free_memory<T>(priv_to_offset(ptr), 0);
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::drop(
+    char_ptr_holder_type name) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only()) return false;
+
+  const auto ptr = priv_find_and_remove_attr_object<T>(name).first;
+  if (!ptr) return false;
+
+  // Destructs no object
+  priv_destruct_and_free_memory<T>(priv_to_offset(ptr), 0);
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+std::pair<T *, typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type>
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_find_and_remove_attr_object(
+    char_ptr_holder_type name) {
   if (name.is_anonymous()) {
-    return false;  // Cannot destroy anoymous object by name
+    // Cannot destroy anoymous object by name
+    return std::make_pair(nullptr, 0);
   }
 
-  T *ptr = nullptr;
-  size_type length = 0;
-
-  {
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-    lock_guard_type guard(*m_object_directories_mutex);
+  directory_lock_guard_type guard(*m_object_directories_mutex);
 #endif
 
-    std::tie(ptr, length) = find<T>(name);
-    if (!ptr) {
-      return false;  // This is not a critical error --- could have been
-                     // destroyed by another thread already.
-    }
-    if (!priv_remove_attr_object_no_mutex(priv_to_offset(ptr))) {
-      return false;
-    }
+  const auto found = priv_find_no_mutex<T>(name);
+  if (!found.first) {
+    // This is not a critical error --- could have been destroyed by another
+    // thread already.
+    return std::make_pair(nullptr, 0);
   }
-
-  priv_destruct_and_free_memory<T>(priv_to_offset(ptr), length);
-
-  return true;
+  if (!priv_remove_attr_object_no_mutex(priv_to_offset(found.first))) {
+    return std::make_pair(nullptr, 0);
+  }
+  return found;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::destroy_ptr(const T *ptr) {
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::destroy_ptr(const T *ptr) {
   priv_check_sanity();
   if (m_segment_storage.read_only()) return false;
 
   size_type length = 0;
   {
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-    lock_guard_type guard(*m_object_directories_mutex);
+    directory_lock_guard_type guard(*m_object_directories_mutex);
 #endif
 
     length = get_instance_length(ptr);
@@ -221,10 +1110,13 @@ bool manager_kernel<st, sst, cn, cs>::destroy_ptr(const T *ptr) {
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-const typename manager_kernel<st, sst, cn, cs>::char_type *
-manager_kernel<st, sst, cn, cs>::get_instance_name(const T *ptr) const {
+const typename manager_kernel<st, sst, cn, cs, sct, ccp>::char_type *
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_instance_name(
+    const T *ptr) const {
+  priv_load_object_directories();
   auto nitr = m_named_object_directory.find(priv_to_offset(ptr));
   if (nitr != m_named_object_directory.end()) {
     return nitr->name().c_str();
@@ -239,10 +1131,13 @@ manager_kernel<st, sst, cn, cs>::get_instance_name(const T *ptr) const {
                    // object
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-typename manager_kernel<st, sst, cn, cs>::instance_kind
-manager_kernel<st, sst, cn, cs>::get_instance_kind(const T *ptr) const {
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::instance_kind
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_instance_kind(
+    const T *ptr) const {
+  priv_load_object_directories();
   if (m_named_object_directory.count(priv_to_offset(ptr)) > 0) {
     return instance_kind::named_kind;
   }
@@ -259,10 +1154,13 @@ manager_kernel<st, sst, cn, cs>::get_instance_kind(const T *ptr) const {
   return instance_kind();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-typename manager_kernel<st, sst, cn, cs>::size_type
-manager_kernel<st, sst, cn, cs>::get_instance_length(const T *ptr) const {
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_instance_length(
+    const T *ptr) const {
+  priv_load_object_directories();
   {
     auto itr = m_named_object_directory.find(priv_to_offset(ptr));
     if (itr != m_named_object_directory.end()) {
@@ -290,10 +1188,12 @@ manager_kernel<st, sst, cn, cs>::get_instance_length(const T *ptr) const {
   return 0;  // Won't treat as an error
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::is_instance_type(
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::is_instance_type(
     const void *const ptr) const {
+  priv_load_object_directories();
   {
     auto itr = m_named_object_directory.find(priv_to_offset(ptr));
     if (itr != m_named_object_directory.end()) {
@@ -318,10 +1218,12 @@ bool manager_kernel<st, sst, cn, cs>::is_instance_type(
   return false;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::get_instance_description(
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_instance_description(
     const T *ptr, std::string *description) const {
+  priv_load_object_directories();
   {
     auto itr = m_named_object_directory.find(priv_to_offset(ptr));
     if (itr != m_named_object_directory.end()) {
@@ -349,9 +1251,10 @@ bool manager_kernel<st, sst, cn, cs>::get_instance_description(
   return false;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::set_instance_description(
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::set_instance_description(
     const T *ptr, const std::string &description) {
   if (m_segment_storage.read_only()) return false;
 
@@ -364,137 +1267,557 @@ bool manager_kernel<st, sst, cn, cs>::set_instance_description(
           m_anonymous_object_directory.find(priv_to_offset(ptr)), description));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::size_type
-manager_kernel<st, sst, cn, cs>::get_num_named_objects() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::set_access_pattern(
+    const T *ptr, const access_pattern pattern) {
+  priv_check_sanity();
+  priv_load_object_directories();
+  const auto offset = priv_to_offset(ptr);
+  size_type length = 0;
+  {
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+    directory_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+    const auto find_length = [offset, &length](const auto &directory) {
+      const auto itr = directory.find(offset);
+      if (itr == directory.end()) return false;
+      length = itr->length() * sizeof(T);
+      return true;
+    };
+    if (!find_length(m_named_object_directory) &&
+        !find_length(m_unique_object_directory) &&
+        !find_length(m_anonymous_object_directory)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Invalid pointer to set an access pattern");
+      return false;
+    }
+    // Recorded only if it is stored
+    if (!m_segment_storage.read_only() && !m_segment_storage.copy_on_write()) {
+      m_access_pattern_table.set(offset, length, pattern);
+    }
+  }
+  return m_segment_storage.advise_access_pattern(offset, length, pattern);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+access_pattern manager_kernel<st, sst, cn, cs, sct, ccp>::get_access_pattern(
+    const T *ptr) const {
+  priv_check_sanity();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  directory_shared_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+  return m_access_pattern_table.get(priv_to_offset(ptr));
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_num_named_objects() const {
+  priv_load_object_directories();
   return m_named_object_directory.size();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::size_type
-manager_kernel<st, sst, cn, cs>::get_num_unique_objects() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_num_unique_objects() const {
+  priv_load_object_directories();
   return m_unique_object_directory.size();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::size_type
-manager_kernel<st, sst, cn, cs>::get_num_anonymous_objects() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_num_anonymous_objects() const {
+  priv_load_object_directories();
   return m_anonymous_object_directory.size();
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_named_iterator
-manager_kernel<st, sst, cn, cs>::named_begin() const {
-  return m_named_object_directory.begin();
-}
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_named_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::named_begin() const {
+  priv_load_object_directories();
+  return m_named_object_directory.begin();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_named_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::named_end() const {
+  priv_load_object_directories();
+  return m_named_object_directory.end();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_unique_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::unique_begin() const {
+  priv_load_object_directories();
+  return m_unique_object_directory.begin();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_unique_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::unique_end() const {
+  priv_load_object_directories();
+  return m_unique_object_directory.end();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_anonymous_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::anonymous_begin() const {
+  priv_load_object_directories();
+  return m_anonymous_object_directory.begin();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::const_anonymous_iterator
+manager_kernel<st, sst, cn, cs, sct, ccp>::anonymous_end() const {
+  priv_load_object_directories();
+  return m_anonymous_object_directory.end();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T, typename proxy>
+T *manager_kernel<st, sst, cn, cs, sct, ccp>::generic_construct(
+    char_ptr_holder_type name, const size_type num, const bool try2find,
+    [[maybe_unused]] const bool do_throw, proxy &pr) {
+  priv_check_sanity();
+  return priv_generic_construct<T>(name, num, try2find, pr);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+const typename manager_kernel<st, sst, cn, cs, sct, ccp>::segment_header_type &
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_segment_header() const {
+  return m_segment_storage.get_segment_header();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+const void *manager_kernel<st, sst, cn, cs, sct, ccp>::get_segment() const {
+  return m_segment_storage.get_segment();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::get_segment_size() const {
+  return m_segment_storage.size();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::read_only() const {
+  return m_segment_storage.read_only();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::copy_on_write() const {
+  return m_segment_storage.copy_on_write();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::volatile_segment() const {
+  return m_volatile;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::snapshot(
+    const path_type &destination_base_path, const bool clone,
+    const int num_max_copy_threads) {
+  const auto timer = m_phase_timer->measure(phase::snapshot);
+  return priv_snapshot(destination_base_path, clone, num_max_copy_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::snapshot_incremental(
+    const path_type &destination_base_path, const int num_max_copy_threads) {
+  const auto timer = m_phase_timer->measure(phase::snapshot);
+  return priv_snapshot_incremental(destination_base_path,
+                                   num_max_copy_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::replicate(
+    std::ostream &stream, bool full) {
+  priv_check_sanity();
+  if (m_segment_storage.read_only() || m_segment_storage.copy_on_write() ||
+      m_volatile) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Only a datastore opened with the write mode can be "
+                "replicated");
+    return false;
+  }
+  if constexpr (!has_replication_v<segment_storage>) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The segment storage does not support replication");
+    return false;
+  } else {
+    full |= (m_replication_session == 0) ||
+            !m_segment_storage.replication_tracked();
+    uint64_t session = m_replication_session;
+    uint64_t sequence = m_replication_sequence + 1;
+    if (full) {
+      // A new session lets the replicas tell the streams of another writer
+      std::random_device rd;
+      do {
+        session = (uint64_t(rd()) << 32ULL) | uint64_t(rd());
+      } while (session == 0);
+      sequence = 0;
+    }
+    // Any failure below makes the next stream a full one
+    m_replication_session = 0;
+
+    if (!priv_serialize_management_data()) return false;
+
+    const uint64_t values[3] = {full, session, sequence};
+    stream.write(k_replication_stream_magic,
+                 sizeof(k_replication_stream_magic));
+    stream.write(reinterpret_cast<const char *>(values), sizeof(values));
+    bool segment_written;
+    {
+      const auto timer = m_phase_timer->measure(phase::copy_segment);
+      segment_written = m_segment_storage.replicate(stream, full);
+    }
+    if (!segment_written) return false;
+    {
+      const auto timer = m_phase_timer->measure(phase::copy_management_data);
+      if (!priv_write_replication_management_data(stream)) return false;
+    }
+    if (!stream.flush()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to write the replication stream");
+      return false;
+    }
+
+    m_replication_session = session;
+    m_replication_sequence = sequence;
+    return true;
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::apply_replication(
+    const path_type &replica_base_path, std::istream &stream) {
+  if constexpr (!has_replication_v<segment_storage>) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The segment storage does not support replication");
+    return false;
+  } else {
+    char magic[sizeof(k_replication_stream_magic)];
+    uint64_t values[3];
+    stream.read(magic, sizeof(magic));
+    stream.read(reinterpret_cast<char *>(values), sizeof(values));
+    if (!stream ||
+        !std::equal(magic, magic + sizeof(magic), k_replication_stream_magic)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Not a replication stream");
+      return false;
+    }
+    const bool full = values[0];
+    const uint64_t session = values[1];
+    const uint64_t sequence = values[2];
+
+    if (full) {
+      if (!priv_create_datastore_directory(replica_base_path)) return false;
+    } else {
+      uint64_t last_session = 0;
+      uint64_t last_sequence = 0;
+      if (!priv_read_replication_state(replica_base_path, &last_session,
+                                       &last_sequence) ||
+          last_session != session || last_sequence + 1 != sequence) {
+        std::stringstream ss;
+        ss << "The replica has not applied the previous replication stream; "
+              "a full one is needed: "
+           << replica_base_path;
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    ss.str().c_str());
+        return false;
+      }
+    }
+
+    // The replica is not consistent until the whole stream is applied.
+    // If this function fails, only a full stream can update the replica.
+    if (!priv_remove_replication_state(replica_base_path) ||
+        !priv_unmark_properly_closed(replica_base_path)) {
+      return false;
+    }
+    if (!segment_storage::apply_replication(
+            priv_segment_base_path(replica_base_path), stream, full) ||
+        !priv_read_replication_management_data(replica_base_path, stream)) {
+      std::stringstream ss;
+      ss << "Failed to apply a replication stream to " << replica_base_path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    return priv_write_replication_state(replica_base_path, session,
+                                        sequence) &&
+           priv_mark_properly_closed(replica_base_path);
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::copy(
+    const path_type &source_base_path, const path_type &destination_base_path,
+    const bool clone, const int num_max_copy_threads) {
+  return priv_copy_data_store(source_base_path, destination_base_path, clone,
+                              num_max_copy_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::repack_copy(
+    const path_type &source_base_path, const path_type &destination_base_path,
+    const int num_max_copy_threads) {
+  if (!consistent(source_base_path)) {
+    std::string s("Source directory is not consistent: " +
+                  source_base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+
+  // The objects cannot be moved as offset pointers are relative to their
+  // addresses; thus, the chunks in use are copied to the same offsets
+  std::vector<bool> used_chunks;
+  if (!priv_read_used_chunks(source_base_path, &used_chunks)) return false;
+  const auto regions = priv_chunk_regions(used_chunks);
+
+  if (!storage::create(destination_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to initialize the datastore directory");
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_named_iterator
-manager_kernel<st, sst, cn, cs>::named_end() const {
-  return m_named_object_directory.end();
-}
+  if (!segment_storage::copy_regions(priv_segment_base_path(source_base_path),
+                                     destination_base_path, regions,
+                                     num_max_copy_threads)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to copy the chunks in use");
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_unique_iterator
-manager_kernel<st, sst, cn, cs>::unique_begin() const {
-  return m_unique_object_directory.begin();
-}
+  if (!priv_copy_management_directory(source_base_path, destination_base_path,
+                                      num_max_copy_threads) ||
+      !priv_remove_segment_location(destination_base_path)) {
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_unique_iterator
-manager_kernel<st, sst, cn, cs>::unique_end() const {
-  return m_unique_object_directory.end();
-}
+  if (!priv_mark_properly_closed(destination_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to create a properly closed mark");
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_anonymous_iterator
-manager_kernel<st, sst, cn, cs>::anonymous_begin() const {
-  return m_anonymous_object_directory.begin();
+  return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::const_anonymous_iterator
-manager_kernel<st, sst, cn, cs>::anonymous_end() const {
-  return m_anonymous_object_directory.end();
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::future<bool> manager_kernel<st, sst, cn, cs, sct, ccp>::copy_async(
+    const path_type &source_base_path, const path_type &destination_base_path,
+    const bool clone, const int num_max_copy_threads) {
+  return std::async(std::launch::async, copy, source_base_path,
+                    destination_base_path, clone, num_max_copy_threads);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-template <typename T, typename proxy>
-T *manager_kernel<st, sst, cn, cs>::generic_construct(
-    char_ptr_holder_type name, const size_type num, const bool try2find,
-    [[maybe_unused]] const bool do_throw, proxy &pr) {
-  priv_check_sanity();
-  return priv_generic_construct<T>(name, num, try2find, pr);
-}
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::compress(
+    const path_type &base_path, const int level, const int num_max_threads) {
+  if (!priv_consistent(base_path)) {
+    std::string s("Cannot compress an inconsistent data store: " +
+                  base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+  return segment_storage::compress(priv_segment_base_path(base_path), level,
+                                   num_max_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::decompress(
+    const path_type &base_path, const int num_max_threads) {
+  return segment_storage::decompress(priv_segment_base_path(base_path),
+                                     num_max_threads);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::diff(
+    const path_type &base_path0, const path_type &base_path1,
+    std::vector<std::pair<size_type, size_type>> *const changed_ranges,
+    const int num_max_threads) {
+  // The free chunks of the data stores are not compared
+  std::vector<bool> used_chunks;
+  for (const auto &base_path : {base_path0, base_path1}) {
+    if (!priv_consistent(base_path)) {
+      std::string s("Cannot compare an inconsistent data store: " +
+                    base_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (!priv_read_used_chunks(base_path, &used_chunks)) return false;
+  }
+  const auto regions = priv_chunk_regions(used_chunks);
+
+  return segment_storage::diff(priv_segment_base_path(base_path0),
+                               priv_segment_base_path(base_path1), regions,
+                               k_chunk_size, num_max_threads, changed_ranges);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::read_object_attributes(
+    const path_type &base_path, const instance_kind kind,
+    const int num_max_threads,
+    std::vector<object_attribute_type> *const attributes) {
+  const char *prefix = k_anonymous_object_directory_prefix;
+  if (kind == instance_kind::named_kind) {
+    prefix = k_named_object_directory_prefix;
+  } else if (kind == instance_kind::unique_kind) {
+    prefix = k_unique_object_directory_prefix;
+  }
+  return attributed_object_directory_type::read_entries(
+      storage::get_path(base_path, {k_management_dir_name, prefix}),
+      num_max_threads, attributes);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::check_integrity(
+    const path_type &base_path, const int num_max_threads,
+    std::vector<std::string> *const problems) {
+  const auto num_problems = problems->size();
+  if (!priv_consistent(base_path)) {
+    // The files written at the last flush or snapshot are still checked
+    problems->push_back(
+        "The data store was not closed properly; recover() can fix it");
+  }
+
+  // The offsets of the objects of all kinds; no two objects share one
+  std::vector<difference_type> offsets;
+  for (const auto kind : {instance_kind::named_kind, instance_kind::unique_kind,
+                          instance_kind::anonymous_kind}) {
+    std::vector<object_attribute_type> attributes;
+    if (!read_object_attributes(base_path, kind, num_max_threads,
+                                &attributes)) {
+      problems->push_back("Cannot read an object directory");
+      continue;
+    }
+    for (const auto &attribute : attributes) {
+      offsets.push_back(attribute.offset());
+    }
+  }
+  std::vector<difference_type> sorted_offsets(offsets);
+  std::sort(sorted_offsets.begin(), sorted_offsets.end());
+  for (std::size_t i = 1; i < sorted_offsets.size(); ++i) {
+    if (sorted_offsets[i - 1] == sorted_offsets[i] &&
+        (i == 1 || sorted_offsets[i - 2] != sorted_offsets[i])) {
+      problems->push_back("More than one object is at offset " +
+                          std::to_string(sorted_offsets[i]));
+    }
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-const typename manager_kernel<st, sst, cn, cs>::segment_header_type &
-manager_kernel<st, sst, cn, cs>::get_segment_header() const {
-  return m_segment_storage.get_segment_header();
-}
+  size_type used_size = 0;
+  segment_memory_allocator::check(
+      storage::get_path(base_path, {k_management_dir_name,
+                                    k_segment_memory_allocator_prefix}),
+      offsets, num_max_threads, &used_size, problems);
+  segment_storage::check(priv_segment_base_path(base_path), used_size,
+                         problems);
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-const void *manager_kernel<st, sst, cn, cs>::get_segment() const {
-  return m_segment_storage.get_segment();
+  return problems->size() == num_problems;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::size_type
-manager_kernel<st, sst, cn, cs>::get_segment_size() const {
-  return m_segment_storage.size();
-}
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::recover(
+    const path_type &base_path) {
+  if (priv_properly_closed(base_path)) return true;
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::read_only() const {
-  return m_segment_storage.read_only();
-}
+  json_store metadata;
+  if (!priv_read_management_metadata(base_path, &metadata) ||
+      !priv_check_version(metadata)) {
+    std::string s("Cannot recover a data store of another version: " +
+                  base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+  if (!priv_check_size_class_table(metadata)) {
+    std::string s("Cannot recover a data store of another size class table: " +
+                  base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::snapshot(
-    const path_type &destination_base_path, const bool clone,
-    const int num_max_copy_threads) {
-  return priv_snapshot(destination_base_path, clone, num_max_copy_threads);
-}
+  const auto log_path = priv_chunk_operation_log_path(base_path);
+  if (!mdtl::file_exist(log_path)) {
+    std::string s("No chunk operation log to recover from: " +
+                  base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::copy(
-    const path_type &source_base_path, const path_type &destination_base_path,
-    const bool clone, const int num_max_copy_threads) {
-  return priv_copy_data_store(source_base_path, destination_base_path, clone,
-                              num_max_copy_threads);
-}
+  if (!segment_memory_allocator::recover(
+          storage::get_path(base_path, {k_management_dir_name,
+                                        k_segment_memory_allocator_prefix}),
+          log_path)) {
+    return false;
+  }
+  if (!mdtl::remove_file(log_path)) return false;
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-std::future<bool> manager_kernel<st, sst, cn, cs>::copy_async(
-    const path_type &source_base_path, const path_type &destination_base_path,
-    const bool clone, const int num_max_copy_threads) {
-  return std::async(std::launch::async, copy, source_base_path,
-                    destination_base_path, clone, num_max_copy_threads);
+  return priv_mark_properly_closed(base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::remove(const path_type &base_path) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::remove(
+    const path_type &base_path) {
   return priv_remove_data_store(base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-std::future<bool> manager_kernel<st, sst, cn, cs>::remove_async(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::future<bool> manager_kernel<st, sst, cn, cs, sct, ccp>::remove_async(
     const path_type &base_path) {
   return std::async(std::launch::async, remove, base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::consistent(const path_type &base_path) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::consistent(
+    const path_type &base_path) {
   return priv_consistent(base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-std::string manager_kernel<st, sst, cn, cs>::get_uuid() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::string manager_kernel<st, sst, cn, cs, sct, ccp>::get_uuid() const {
   return self_type::get_uuid(m_base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-std::string manager_kernel<st, sst, cn, cs>::get_uuid(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::string manager_kernel<st, sst, cn, cs, sct, ccp>::get_uuid(
     const path_type &base_path) {
   json_store meta_data;
   if (!priv_read_management_metadata(base_path, &meta_data)) {
@@ -506,13 +1829,15 @@ std::string manager_kernel<st, sst, cn, cs>::get_uuid(
   return priv_get_uuid(meta_data);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-version_type manager_kernel<st, sst, cn, cs>::get_version() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+version_type manager_kernel<st, sst, cn, cs, sct, ccp>::get_version() const {
   return self_type::get_version(m_base_path);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-version_type manager_kernel<st, sst, cn, cs>::get_version(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+version_type manager_kernel<st, sst, cn, cs, sct, ccp>::get_version(
     const path_type &base_path) {
   json_store meta_data;
   if (!priv_read_management_metadata(base_path, &meta_data)) {
@@ -525,77 +1850,109 @@ version_type manager_kernel<st, sst, cn, cs>::get_version(
   return (version == ver_detail::k_error_version) ? 0 : version;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::get_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_description(
     const path_type &base_path, std::string *description) {
   return priv_read_description(base_path, description);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::get_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_description(
     std::string *description) const {
   return priv_read_description(m_base_path, description);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::set_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::set_description(
     const path_type &base_path, const std::string &description) {
   return priv_write_description(base_path, description);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::set_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::set_description(
     const std::string &description) {
   return set_description(m_base_path, description);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::named_object_attr_accessor_type
-manager_kernel<st, sst, cn, cs>::access_named_object_attribute(
-    const path_type &base_path) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::
+    named_object_attr_accessor_type
+    manager_kernel<st, sst, cn, cs, sct, ccp>::access_named_object_attribute(
+        const path_type &base_path) {
   return named_object_attr_accessor_type(storage::get_path(
       base_path, {k_management_dir_name, k_named_object_directory_prefix}));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::unique_object_attr_accessor_type
-manager_kernel<st, sst, cn, cs>::access_unique_object_attribute(
-    const path_type &base_path) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::
+    unique_object_attr_accessor_type
+    manager_kernel<st, sst, cn, cs, sct, ccp>::access_unique_object_attribute(
+        const path_type &base_path) {
   return unique_object_attr_accessor_type(storage::get_path(
       base_path, {k_management_dir_name, k_unique_object_directory_prefix}));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::anonymous_object_attr_accessor_type
-manager_kernel<st, sst, cn, cs>::access_anonymous_object_attribute(
-    const path_type &base_path) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::
+    anonymous_object_attr_accessor_type
+    manager_kernel<st, sst, cn, cs, sct, ccp>::
+        access_anonymous_object_attribute(const path_type &base_path) {
   return anonymous_object_attr_accessor_type(storage::get_path(
       base_path, {k_management_dir_name, k_anonymous_object_directory_prefix}));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::good() const noexcept {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::good() const noexcept {
   return m_good;
 }
 
 // -------------------- //
 // Private methods
 // -------------------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-typename manager_kernel<st, sst, cn, cs>::difference_type
-manager_kernel<st, sst, cn, cs>::priv_to_offset(const void *const ptr) const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::difference_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_to_offset(
+    const void *const ptr) const {
   return static_cast<char *>(const_cast<void *>(ptr)) -
          static_cast<char *>(m_segment_storage.get_segment());
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void *manager_kernel<st, sst, cn, cs>::priv_to_address(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_to_segment_offset(
+    const void *const addr, const size_type nbytes,
+    difference_type *const offset) const {
+  const auto segment =
+      reinterpret_cast<std::uintptr_t>(m_segment_storage.get_segment());
+  const auto begin = reinterpret_cast<std::uintptr_t>(addr);
+  if (begin < segment || begin + nbytes > segment + m_segment_storage.size()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The region is not in the segment");
+    return false;
+  }
+  *offset = begin - segment;
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void *manager_kernel<st, sst, cn, cs, sct, ccp>::priv_to_address(
     const difference_type offset) const {
   return static_cast<char *>(m_segment_storage.get_segment()) + offset;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_create_datastore_directory(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_create_datastore_directory(
     const path_type &base_path) {
   if (!storage::create(base_path)) {
     logger::out(logger::level::error, __FILE__, __LINE__,
@@ -615,8 +1972,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_create_datastore_directory(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-void manager_kernel<st, sst, cn, cs>::priv_check_sanity() const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::priv_check_sanity() const {
   assert(m_good);
   assert(!m_base_path.empty());
   assert(m_segment_storage.check_sanity());
@@ -624,9 +1982,10 @@ void manager_kernel<st, sst, cn, cs>::priv_check_sanity() const {
   assert(m_manager_metadata);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_validate_runtime_configuration()
-    const {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_validate_runtime_configuration() const {
   const auto system_page_size = mdtl::get_page_size();
   if (system_page_size <= 0) {
     logger::out(logger::level::error, __FILE__, __LINE__,
@@ -657,8 +2016,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_validate_runtime_configuration()
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_consistent(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_consistent(
     const path_type &base_path) {
   json_store metadata;
   return priv_properly_closed(base_path) &&
@@ -666,112 +2026,289 @@ bool manager_kernel<st, sst, cn, cs>::priv_consistent(
           priv_check_version(metadata));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_check_version(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_check_version(
     const json_store &metadata_json) {
   return priv_get_version(metadata_json) == version_type(METALL_VERSION);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_properly_closed(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_properly_closed(
     const path_type &base_path) {
   return mdtl::file_exist(
       storage::get_path(base_path, k_properly_closed_mark_file_name));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_mark_properly_closed(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::path_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_chunk_operation_log_path(
+    const path_type &base_path) {
+  return storage::get_path(
+      base_path, {k_management_dir_name, k_chunk_operation_log_file_name});
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::path_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_undo_log_path(
+    const path_type &base_path) {
+  return storage::get_path(base_path,
+                           {k_management_dir_name, k_undo_log_file_name});
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_abort_transaction_without_lock() {
+  auto *const segment = static_cast<char *>(m_segment_storage.get_segment());
+  return m_undo_log.abort(
+      [segment](const uint64_t offset, const char *const data,
+                const uint64_t size) {
+        std::memcpy(segment + offset, data, size);
+        return true;
+      },
+      [this](const uint64_t offset, const uint64_t size) {
+        return m_segment_storage.persist(offset, size);
+      });
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_roll_back_interrupted_transaction() {
+  const auto log_path = priv_undo_log_path(m_base_path);
+  if (!mdtl::file_exist(log_path)) return true;
+
+  logger::out(logger::level::info, __FILE__, __LINE__,
+              "Rolling back a transaction interrupted by a crash");
+  auto *const segment = static_cast<char *>(m_segment_storage.get_segment());
+  const auto segment_size = m_segment_storage.size();
+  const bool rolled_back = undo_log::roll_back(
+      log_path, [this, segment, segment_size](const uint64_t offset,
+                                              const char *const data,
+                                              const uint64_t size) {
+        if (offset + size > segment_size) return false;
+        std::memcpy(segment + offset, data, size);
+        return m_segment_storage.persist(offset, size);
+      });
+  if (!rolled_back) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to roll back the interrupted transaction");
+    return false;
+  }
+  return mdtl::remove_file(log_path);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_start_chunk_operation_log() {
+  // Recovery is not available without the log, but the data store works
+  if (!m_segment_memory_allocator.start_chunk_operation_log(
+          priv_chunk_operation_log_path(m_base_path))) {
+    logger::out(logger::level::warning, __FILE__, __LINE__,
+                "Failed to start the chunk operation log; the data store "
+                "cannot be recovered on a crash");
+    return false;
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_mark_properly_closed(
     const path_type &base_path) {
   return mdtl::create_file(
       storage::get_path(base_path, k_properly_closed_mark_file_name));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_unmark_properly_closed(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_unmark_properly_closed(
     const path_type &base_path) {
   return mdtl::remove_file(
       storage::get_path(base_path, k_properly_closed_mark_file_name));
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T, typename proxy>
-T *manager_kernel<st, sst, cn, cs>::priv_generic_construct(
+T *manager_kernel<st, sst, cn, cs, sct, ccp>::priv_generic_construct(
     char_ptr_holder_type name, size_type length, bool try2find, proxy &pr) {
-  void *ptr = nullptr;
+  const auto [ptr, found] =
+      priv_find_or_allocate_attr_object<T>(name, length, try2find, nullptr);
+  if (!ptr || found) return static_cast<T *>(ptr);
+
+  // To prevent memory leak, deallocates the memory when the array construction
+  // below throws exception
+  std::unique_ptr<void, std::function<void(void *)>> ptr_holder(
+      ptr, [this](void *const ptr) { priv_free_attr_object(ptr); });
+
+#if BOOST_VERSION >= 108500
+  pr.construct_n(ptr, length);
+#else
+  // Constructs each object in the allocated memory
+  // When one of objects of T in the array throws exception,
+  // this function calls T's destructor for successfully constructed objects and
+  // rethrows the exception
+  std::size_t constructed = 0;
+  try {
+    pr.construct_n(ptr, length, constructed);
+  } catch (...) {
+    std::size_t destroyed = 0;
+    pr.destroy_n(ptr, constructed, destroyed);
+    throw;
+  }
+#endif
+  ptr_holder.release();  // release the pointer since the construction succeeded
+
+  return static_cast<T *>(ptr);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T>
+std::pair<void *, bool>
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_find_or_allocate_attr_object(
+    char_ptr_holder_type name, const size_type length, const bool try2find,
+    bool *const zero_filled) {
   try {
+    // Finds without blocking other lookups first, as find_or_construct()
+    // mostly finds an existing object
+    if (try2find && !name.is_anonymous()) {
+      auto *const found_addr = find<T>(name).first;
+      if (found_addr) return std::make_pair(found_addr, true);
+    }
+
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-    lock_guard_type guard(*m_object_directories_mutex);
+    directory_lock_guard_type guard(*m_object_directories_mutex);
 #endif
 
     if (!name.is_anonymous()) {
-      auto *const found_addr = find<T>(name).first;
+      auto *const found_addr = priv_find_no_mutex<T>(name).first;
       if (found_addr) {
         if (try2find) {
-          return found_addr;
+          return std::make_pair(found_addr, true);
         }
-        return nullptr;  // this is not a critical error always --- could have
-                         // been allocated by another thread.
+        // this is not a critical error always --- could have been allocated
+        // by another thread.
+        return std::make_pair(nullptr, false);
       }
     }
 
-    ptr = allocate(length * sizeof(T));
-    if (!ptr) return nullptr;
+    void *const ptr = priv_allocate(length * sizeof(T), zero_filled);
+    if (!ptr) return std::make_pair(nullptr, false);
 
     const auto offset = priv_to_offset(ptr);
     if (!priv_register_attr_object_no_mutex<T>(name, offset, length)) {
       deallocate(ptr);
-      return nullptr;
+      return std::make_pair(nullptr, false);
     }
+    return std::make_pair(ptr, false);
   } catch (...) {
     logger::out(
         logger::level::error, __FILE__, __LINE__,
         "Exception was thrown when finding or allocating an attribute object");
-    return nullptr;
   }
+  return std::make_pair(nullptr, false);
+}
 
-  // To prevent memory leak, deallocates the memory when the array construction
-  // below throws exception
-  std::unique_ptr<void, std::function<void(void *)>> ptr_holder(
-      ptr, [this](void *const ptr) {
-        try {
-          {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::priv_free_attr_object(
+    void *const ptr) {
+  try {
+    {
 #ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
-            lock_guard_type guard(*m_object_directories_mutex);
+      directory_lock_guard_type guard(*m_object_directories_mutex);
 #endif
-            priv_remove_attr_object_no_mutex(priv_to_offset(ptr));
-          }
-          deallocate(ptr);
+      priv_remove_attr_object_no_mutex(priv_to_offset(ptr));
+    }
+    deallocate(ptr);
+  } catch (...) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Exception was thrown when cleaning up an object");
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename T, typename constructor_type>
+T *manager_kernel<st, sst, cn, cs, sct, ccp>::priv_construct_parallel(
+    char_ptr_holder_type name, const size_type length, const bool try2find,
+    const int num_threads, const bool skip_if_zero_filled,
+    const constructor_type &construct) {
+  bool zero_filled = false;
+  const auto [ptr, found] = priv_find_or_allocate_attr_object<T>(
+      name, length, try2find, &zero_filled);
+  if (!ptr || found) return static_cast<T *>(ptr);
+  if (skip_if_zero_filled && zero_filled) return static_cast<T *>(ptr);
+
+  std::unique_ptr<void, std::function<void(void *)>> ptr_holder(
+      ptr, [this](void *const ptr) { priv_free_attr_object(ptr); });
+  T *const array = static_cast<T *>(ptr);
+
+  // Each task constructs at least a chunk worth of objects so that the
+  // threads do not write the same pages
+  const std::size_t max_threads =
+      (num_threads > 0) ? num_threads
+                        : mdtl::io_executor::instance().num_threads();
+  const std::size_t min_objects_per_task =
+      std::max(k_chunk_size / sizeof(T), std::size_t(1));
+  const std::size_t num_tasks = std::max(
+      std::min(max_threads * 4,
+               (length + min_objects_per_task - 1) / min_objects_per_task),
+      std::size_t(1));
+  const std::size_t objects_per_task = (length + num_tasks - 1) / num_tasks;
+  const auto task_range = [&](const std::size_t task_no) {
+    const std::size_t first = std::min(task_no * objects_per_task, length);
+    return std::make_pair(first, std::min(first + objects_per_task, length));
+  };
+
+  // A task that fails destroys the objects it has constructed; the objects
+  // of the succeeded tasks are destroyed after all tasks finish
+  std::vector<char> constructed(num_tasks, false);
+  std::exception_ptr exception;
+  std::mutex exception_mutex;
+  mdtl::io_executor::instance().parallel_for(
+      num_tasks, max_threads, [&](const std::size_t task_no) {
+        const auto [first, last] = task_range(task_no);
+        std::size_t i = first;
+        try {
+          for (; i < last; ++i) construct(array + i, i);
         } catch (...) {
-          logger::out(logger::level::error, __FILE__, __LINE__,
-                      "Exception was thrown when cleaning up an object");
+          for (; i > first; --i) array[i - 1].~T();
+          std::lock_guard<std::mutex> guard(exception_mutex);
+          if (!exception) exception = std::current_exception();
+          return false;
         }
+        constructed[task_no] = true;
+        return true;
       });
 
-#if BOOST_VERSION >= 108500
-  pr.construct_n(ptr, length);
-#else
-  // Constructs each object in the allocated memory
-  // When one of objects of T in the array throws exception,
-  // this function calls T's destructor for successfully constructed objects and
-  // rethrows the exception
-  std::size_t constructed = 0;
-  try {
-    pr.construct_n(ptr, length, constructed);
-  } catch (...) {
-    std::size_t destroyed = 0;
-    pr.destroy_n(ptr, constructed, destroyed);
-    throw;
+  if (exception) {
+    for (std::size_t t = 0; t < num_tasks; ++t) {
+      if (!constructed[t]) continue;
+      const auto [first, last] = task_range(t);
+      for (std::size_t i = first; i < last; ++i) array[i].~T();
+    }
+    std::rethrow_exception(exception);
   }
-#endif
-  ptr_holder.release();  // release the pointer since the construction succeeded
 
-  return static_cast<T *>(ptr);
+  ptr_holder.release();
+  return array;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-bool manager_kernel<st, sst, cn, cs>::priv_register_attr_object_no_mutex(
-    char_ptr_holder_type name, difference_type offset, size_type length) {
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_register_attr_object_no_mutex(char_ptr_holder_type name,
+                                       difference_type offset,
+                                       size_type length) {
   if (name.is_anonymous()) {
     if (!m_anonymous_object_directory.insert("", offset, length,
                                              gen_type_id<T>())) {
@@ -804,9 +2341,10 @@ bool manager_kernel<st, sst, cn, cs>::priv_register_attr_object_no_mutex(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_remove_attr_object_no_mutex(
-    difference_type offset) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_remove_attr_object_no_mutex(difference_type offset) {
   // As the instance kind of the object is not given,
   // just call the eranse functions in all tables to simplify implementation.
   if (!m_named_object_directory.erase(offset) &&
@@ -816,25 +2354,33 @@ bool manager_kernel<st, sst, cn, cs>::priv_remove_attr_object_no_mutex(
                 "Failed to erase an entry from object directories");
     return false;
   }
+  m_access_pattern_table.erase(offset);
+  m_object_directory_generation->fetch_add(1, std::memory_order_acq_rel);
 
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename T>
-void manager_kernel<st, sst, cn, cs>::priv_destruct_and_free_memory(
+void manager_kernel<st, sst, cn, cs, sct, ccp>::priv_destruct_and_free_memory(
     const difference_type offset, const size_type length) {
   auto *object = static_cast<T *>(priv_to_address(offset));
   // Destruct each object, can throw
   std::destroy(&object[0], &object[length]);
   // Finally, deallocate the memory
+  if (!priv_load_segment_memory_allocator()) return;
+  priv_trace_allocation(allocation_trace_op::deallocate, offset, 0);
   m_segment_memory_allocator.deallocate(offset);
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_open(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_open(
     const path_type &base_path, const bool read_only,
-    const size_type vm_reserve_size_request) {
+    const size_type vm_reserve_size_request, const bool copy_on_write,
+    const bool live) {
+  const auto timer = m_phase_timer->measure(phase::open);
   if (!priv_validate_runtime_configuration()) {
     return false;
   }
@@ -854,41 +2400,243 @@ bool manager_kernel<st, sst, cn, cs>::priv_open(
     return false;
   }
 
-  if (!priv_properly_closed(base_path)) {
+  if (!priv_check_size_class_table(*m_manager_metadata)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Invalid size class table — the data store was created with "
+                "another size class table");
+    return false;
+  }
+
+  // A live reader opens a datastore a writer keeps open
+  if (!live && !priv_properly_closed(base_path)) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Inconsistent data store — it was not closed properly and "
                 "might have been collapsed.");
     return false;
   }
 
+  if (!priv_resolve_incremental_snapshot(base_path, *m_manager_metadata,
+                                         !read_only && !copy_on_write)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to resolve the incremental snapshot");
+    return false;
+  }
+
   m_base_path = base_path;
 
   // Clear the consistent mark before opening with the write mode
-  if (!read_only && !priv_unmark_properly_closed(m_base_path)) {
+  if (!read_only && !copy_on_write &&
+      !priv_unmark_properly_closed(m_base_path)) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to erase the properly close mark before opening");
     return false;
   }
+  if (!read_only && !copy_on_write &&
+      !priv_remove_object_indices(m_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to remove the object indices before opening");
+    return false;
+  }
+  // A replica modified by this process cannot apply the streams anymore
+  if (!read_only && !copy_on_write &&
+      !priv_remove_replication_state(m_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to remove the replication state before opening");
+    return false;
+  }
 
-  if (!m_segment_storage.open(m_base_path, vm_reserve_size_request,
-                              read_only)) {
+  if (live) return priv_open_live_read_only(vm_reserve_size_request);
+
+  // Deserializes the management data while mapping the segment as both can
+  // take a long time on parallel file systems
+  bool deserialized = false;
+  // Read-only opens use the object indices if the datastore has them
+  auto deserialization = mdtl::io_executor::instance().submit(
+      [this, &deserialized, read_only]() {
+        const auto timer =
+            m_phase_timer->measure(phase::deserialize_management_data);
+        deserialized = priv_deserialize_management_data(read_only);
+      });
+  if constexpr (has_write_back_cache_v<segment_storage>) {
+    m_segment_storage.set_write_back_cache(m_options.write_back_cache,
+                                           m_options.write_back_cache_budget);
+  }
+  METALL_TRACE(segment_map_begin, read_only, copy_on_write);
+  bool opened;
+  {
+    const auto timer = m_phase_timer->measure(phase::map_segment);
+    const auto segment_base_path = priv_segment_base_path(m_base_path);
+    opened = copy_on_write
+                 ? m_segment_storage.open_copy_on_write(segment_base_path,
+                                                        vm_reserve_size_request)
+                 : m_segment_storage.open(segment_base_path,
+                                          vm_reserve_size_request, read_only);
+  }
+  METALL_TRACE(segment_map_end, m_segment_storage.size(), opened);
+  deserialization.get();
+
+  if (!opened) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to open the application data segment");
     return false;
   }
   m_segment_storage.get_segment_header().manager_kernel_address = this;
 
-  if (!priv_deserialize_management_data()) {
+  if (!deserialized) {
     m_segment_storage.release();
     return false;
   }
+  // The segment allocator data is loaded when it is used first time
+  m_segment_memory_allocator_state->store(lazy_data_state::unloaded);
 
+  if (!read_only && !copy_on_write) {
+    if (!priv_roll_back_interrupted_transaction()) {
+      m_segment_storage.release();
+      return false;
+    }
+    // The management data files are the state the log starts from
+    priv_start_chunk_operation_log();
+  }
+
+  if (!priv_apply_access_patterns()) {
+    m_segment_storage.release();
+    return false;
+  }
+
+  if (!priv_prefault_on_open()) {
+    m_segment_storage.release();
+    return false;
+  }
+
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_apply_access_patterns() {
+  if (!m_access_pattern_table.deserialize(storage::get_path(
+          m_base_path,
+          {k_management_dir_name, k_access_pattern_table_file_name}))) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to read the access pattern table");
+    return false;
+  }
+  // An advice failing, e.g., not supported, does not fail opening
+  m_access_pattern_table.for_each(
+      [this](const auto offset, const auto length, const auto pattern) {
+        m_segment_storage.advise_access_pattern(offset, length, pattern);
+      });
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_prefault_on_open() {
+  if (!m_options.prefault_on_open) return true;
+
+  // (offset, length) of the regions to load
+  std::vector<std::pair<difference_type, size_type>> regions;
+  if (m_options.prefault_object_names.empty()) {
+    regions.emplace_back(0, m_segment_storage.size());
+  } else {
+    if (!priv_load_segment_memory_allocator()) return false;
+    for (const auto &name : m_options.prefault_object_names) {
+      const auto *const addr = priv_find_no_mutex<char>(name.c_str()).first;
+      if (!addr) {
+        std::string s("Object to prefault is not found: " + name);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+      const auto offset = priv_to_offset(addr);
+      regions.emplace_back(offset,
+                           m_segment_memory_allocator.allocated_size(offset));
+    }
+  }
+
+  size_type total_size = 0;
+  for (const auto &region : regions) total_size += region.second;
+  size_type loaded_size = 0;
+  std::mutex progress_mutex;
+  const auto on_loaded = [this, total_size, &loaded_size,
+                          &progress_mutex](const std::size_t nbytes) {
+    if (!m_options.prefault_progress) return;
+    std::lock_guard<std::mutex> guard(progress_mutex);
+    loaded_size += nbytes;
+    m_options.prefault_progress(std::min(loaded_size, total_size), total_size);
+  };
+
+  for (const auto &[offset, length] : regions) {
+    if (!m_segment_storage.prefetch(offset, length,
+                                    m_options.prefault_num_threads,
+                                    on_loaded)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to prefault the segment");
+      return false;
+    }
+    if (m_options.lock_prefaulted_pages &&
+        !m_segment_storage.pin(offset, length)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to pin the prefaulted pages");
+      return false;
+    }
+  }
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_create(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_open_live_read_only(
+    const size_type vm_reserve_size) {
+  if constexpr (has_live_read_only_mode_v<segment_storage>) {
+    size_type segment_size = 0;
+    if (!m_publication.open(storage::get_path(m_base_path,
+                                              {k_management_dir_name,
+                                               k_publication_file_name}),
+                            false) ||
+        !priv_open_published_object_indices(
+            &m_named_object_index, &m_unique_object_index,
+            &m_published_version, &segment_size)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No version has been published to live readers");
+      m_publication.close();
+      return false;
+    }
+
+    bool opened;
+    {
+      const auto timer = m_phase_timer->measure(phase::map_segment);
+      opened = m_segment_storage.open_live_read_only(
+          priv_segment_base_path(m_base_path), vm_reserve_size, segment_size);
+    }
+    if (!opened) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to open the application data segment");
+      m_named_object_index.close();
+      m_unique_object_index.close();
+      m_publication.close();
+      return false;
+    }
+    m_segment_storage.get_segment_header().manager_kernel_address = this;
+    m_live_reader = true;
+
+    // The management data files are being updated by the writer; only the
+    // objects in the published indices are visible
+    m_object_directories_state->store(lazy_data_state::failed);
+    m_segment_memory_allocator_state->store(lazy_data_state::failed);
+    return true;
+  } else {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The segment storage does not support the live read-only "
+                "mode");
+    return false;
+  }
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_create(
     const path_type &base_path, const size_type vm_reserve_size) {
+  const auto timer = m_phase_timer->measure(phase::create);
   if (!priv_validate_runtime_configuration()) {
     return false;
   }
@@ -901,6 +2649,12 @@ bool manager_kernel<st, sst, cn, cs>::priv_create(
     return false;
   }
 
+  // The segment of the datastore replaced, if stored separately
+  if (const auto old_segment_base_path = priv_segment_base_path(base_path);
+      old_segment_base_path != base_path) {
+    storage::remove(old_segment_base_path);
+  }
+
   if (!priv_create_datastore_directory(base_path)) {
     std::stringstream ss;
     ss << "Failed to initialize datastore under " << base_path;
@@ -908,6 +2662,19 @@ bool manager_kernel<st, sst, cn, cs>::priv_create(
     return false;
   }
 
+  path_type segment_base_path = base_path;
+  if (!m_options.segment_path.empty()) {
+    segment_base_path = std::filesystem::absolute(m_options.segment_path);
+    if (!storage::create(segment_base_path) ||
+        !priv_write_segment_location(base_path, segment_base_path)) {
+      std::stringstream ss;
+      ss << "Failed to initialize the segment directory under "
+         << segment_base_path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+  }
+
   if (!priv_unmark_properly_closed(base_path)) {
     std::stringstream ss;
     ss << "Failed to remove a closed mark under " << base_path;
@@ -917,7 +2684,38 @@ bool manager_kernel<st, sst, cn, cs>::priv_create(
 
   m_base_path = base_path;
 
-  if (!m_segment_storage.create(m_base_path, vm_reserve_size)) {
+  if constexpr (has_write_back_cache_v<segment_storage>) {
+    m_segment_storage.set_write_back_cache(m_options.write_back_cache,
+                                           m_options.write_back_cache_budget);
+  }
+  if constexpr (has_block_size_option_v<segment_storage>) {
+    if (m_options.segment_block_size % k_chunk_size != 0 ||
+        !m_segment_storage.set_block_size(m_options.segment_block_size)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The segment block size must be a multiple of the chunk "
+                  "size and the page size");
+      return false;
+    }
+  }
+
+  bool created;
+  {
+    const auto timer = m_phase_timer->measure(phase::map_segment);
+    if (m_options.volatile_segment) {
+      if constexpr (has_volatile_mode_v<segment_storage>) {
+        created = m_segment_storage.create_volatile(segment_base_path,
+                                                    vm_reserve_size);
+        m_volatile = created;
+      } else {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "The segment storage does not support the volatile mode");
+        created = false;
+      }
+    } else {
+      created = m_segment_storage.create(segment_base_path, vm_reserve_size);
+    }
+  }
+  if (!created) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Cannot create an application data segment");
     return false;
@@ -926,101 +2724,332 @@ bool manager_kernel<st, sst, cn, cs>::priv_create(
 
   if (!priv_set_uuid(m_manager_metadata.get()) ||
       !priv_set_version(m_manager_metadata.get()) ||
+      !priv_set_size_class_table(m_manager_metadata.get()) ||
       !priv_write_management_metadata(m_base_path, *m_manager_metadata)) {
     m_segment_storage.release();
     return false;
   }
 
+  // Writes the initial management data for the chunk operation log
+  if (!priv_serialize_management_data()) {
+    m_segment_storage.release();
+    return false;
+  }
+
   return true;
 }
 
 // ---------- For serializing/deserializing ---------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_serialize_management_data() {
-  priv_check_sanity();
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_serialize_management_data(
+    const bool compact) {
+  // A volatile datastore is never opened again
+  if (m_segment_storage.read_only() || m_segment_storage.copy_on_write() ||
+      m_volatile) {
+    return true;
+  }
+
+  METALL_TRACE(management_data_serialize_begin, compact, 0);
+  const auto timer = m_phase_timer->measure(phase::serialize_management_data);
+  const bool succeeded = priv_write_management_data(compact);
+  METALL_TRACE(management_data_serialize_end, compact, succeeded);
+  return succeeded;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_management_data(
+    const bool compact) {
+  // The log is valid only with the allocator data it started from
+  m_segment_memory_allocator.stop_chunk_operation_log();
+  const auto log_path = priv_chunk_operation_log_path(m_base_path);
+  if (mdtl::file_exist(log_path) && !mdtl::remove_file(log_path)) {
+    return false;
+  }
 
-  if (m_segment_storage.read_only()) return true;
+  // Appends only the changes to the journals unless compacting them
+  const auto write = [this, compact](const phase p, auto &directory,
+                                     const path_type &path) {
+    const auto timer = m_phase_timer->measure(p);
+    return compact ? directory.serialize(path) : directory.flush(path);
+  };
 
-  if (!m_named_object_directory.serialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_named_object_directory_prefix})
-              .c_str())) {
+  if (!write(phase::serialize_named_object_directory,
+             m_named_object_directory,
+             storage::get_path(m_base_path,
+                               {k_management_dir_name,
+                                k_named_object_directory_prefix}))) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to serialize named object directory");
     return false;
   }
 
-  if (!m_unique_object_directory.serialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_unique_object_directory_prefix})
-              .c_str())) {
+  if (!write(phase::serialize_unique_object_directory,
+             m_unique_object_directory,
+             storage::get_path(m_base_path,
+                               {k_management_dir_name,
+                                k_unique_object_directory_prefix}))) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to serialize unique object directory");
     return false;
   }
 
-  if (!m_anonymous_object_directory.serialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_anonymous_object_directory_prefix})
-              .c_str())) {
+  if (!write(phase::serialize_anonymous_object_directory,
+             m_anonymous_object_directory,
+             storage::get_path(m_base_path,
+                               {k_management_dir_name,
+                                k_anonymous_object_directory_prefix}))) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to serialize anonymous object directory");
     return false;
   }
 
-  if (!m_segment_memory_allocator.serialize(storage::get_path(
+  if (!m_access_pattern_table.serialize(storage::get_path(
           m_base_path,
-          {k_management_dir_name, k_segment_memory_allocator_prefix}))) {
+          {k_management_dir_name, k_access_pattern_table_file_name}))) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to serialize the access pattern table");
     return false;
   }
 
+  // If the allocator data has not been loaded, the files are still up to date
+  if (priv_segment_memory_allocator_loaded()) {
+    const auto timer =
+        m_phase_timer->measure(phase::serialize_segment_allocator);
+    if (!m_segment_memory_allocator.serialize(storage::get_path(
+            m_base_path,
+            {k_management_dir_name, k_segment_memory_allocator_prefix}))) {
+      return false;
+    }
+  }
+
+  // Closing does not need the log
+  if (!compact) priv_start_chunk_operation_log();
+
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_deserialize_management_data() {
-  if (!m_named_object_directory.deserialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_named_object_directory_prefix})
-              .c_str())) {
-    logger::out(logger::level::error, __FILE__, __LINE__,
-                "Failed to deserialize named object directory");
-    return false;
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_deserialize_management_data(const bool use_object_indices) {
+  METALL_TRACE(management_data_deserialize_begin, 0, 0);
+  // Falls back to the management data if the object indices are not usable
+  const bool succeeded = (use_object_indices && priv_open_object_indices()) ||
+                         priv_read_management_data();
+  METALL_TRACE(management_data_deserialize_end, 0, succeeded);
+  return succeeded;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_read_management_data() {
+  // The directories are independent files; loads them concurrently
+  const auto load = [this](const std::size_t i) {
+    if (i == 0) {
+      if (!m_named_object_directory.deserialize(storage::get_path(
+              m_base_path,
+              {k_management_dir_name, k_named_object_directory_prefix}))) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to deserialize named object directory");
+        return false;
+      }
+    } else if (i == 1) {
+      if (!m_unique_object_directory.deserialize(storage::get_path(
+              m_base_path,
+              {k_management_dir_name, k_unique_object_directory_prefix}))) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to deserialize unique object directory");
+        return false;
+      }
+    } else {
+      if (!m_anonymous_object_directory.deserialize(storage::get_path(
+              m_base_path,
+              {k_management_dir_name, k_anonymous_object_directory_prefix}))) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to deserialize anonymous object directory");
+        return false;
+      }
+    }
+    return true;
+  };
+
+  return mdtl::io_executor::instance().parallel_for(3, 0, load);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_load_segment_memory_allocator() {
+  if (m_segment_memory_allocator_state->load(std::memory_order_acquire) ==
+      lazy_data_state::loaded) {
+    return true;
   }
 
-  if (!m_unique_object_directory.deserialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_unique_object_directory_prefix})
-              .c_str())) {
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_segment_memory_allocator_load_mutex);
+#endif
+  const auto state =
+      m_segment_memory_allocator_state->load(std::memory_order_relaxed);
+  if (state == lazy_data_state::loaded) return true;
+  if (state == lazy_data_state::failed) return false;
+
+  const auto timer = m_phase_timer->measure(phase::load_segment_allocator);
+  if (!m_segment_memory_allocator.deserialize(storage::get_path(
+          m_base_path,
+          {k_management_dir_name, k_segment_memory_allocator_prefix}))) {
     logger::out(logger::level::error, __FILE__, __LINE__,
-                "Failed to deserialize unique object directory");
+                "Failed to load the segment allocator data");
+    m_segment_memory_allocator_state->store(lazy_data_state::failed,
+                                            std::memory_order_release);
     return false;
   }
+  if (!m_segment_storage.read_only()) {
+    m_segment_memory_allocator.prefill_object_cache(storage::get_path(
+        m_base_path,
+        {k_management_dir_name, k_segment_memory_allocator_prefix}));
+  }
+  m_segment_memory_allocator_state->store(lazy_data_state::loaded,
+                                          std::memory_order_release);
+  return true;
+}
 
-  if (!m_anonymous_object_directory.deserialize(
-          storage::get_path(m_base_path, {k_management_dir_name,
-                                          k_anonymous_object_directory_prefix})
-              .c_str())) {
-    logger::out(logger::level::error, __FILE__, __LINE__,
-                "Failed to deserialize anonymous object directory");
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_segment_memory_allocator_loaded() const {
+  return m_segment_memory_allocator_state->load(std::memory_order_acquire) ==
+         lazy_data_state::loaded;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_open_object_indices() {
+  if (!m_named_object_index.open(priv_object_index_path(
+          m_base_path, k_named_object_index_file_name, 0)) ||
+      !m_unique_object_index.open(priv_object_index_path(
+          m_base_path, k_unique_object_index_file_name, 0))) {
+    m_named_object_index.close();
+    m_unique_object_index.close();
     return false;
   }
+  m_object_directories_state->store(lazy_data_state::unloaded,
+                                    std::memory_order_release);
+  return true;
+}
 
-  if (!m_segment_memory_allocator.deserialize(storage::get_path(
-          m_base_path,
-          {k_management_dir_name, k_segment_memory_allocator_prefix}))) {
-    return false;
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_object_indices(
+    const publication::version_type version) const {
+  return named_object_index::write(
+             priv_object_index_path(m_base_path,
+                                    k_named_object_index_file_name, version),
+             m_named_object_directory) &&
+         named_object_index::write(
+             priv_object_index_path(m_base_path,
+                                    k_unique_object_index_file_name, version),
+             m_unique_object_directory);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::path_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_object_index_path(
+    const path_type &base_path, const char *const file_name,
+    const publication::version_type version) {
+  if (version == 0) {
+    return storage::get_path(base_path, {k_management_dir_name, file_name});
+  }
+  return storage::get_path(
+      base_path, {k_management_dir_name,
+                  std::string(file_name) + "-" + std::to_string(version)});
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_open_published_object_indices(
+        named_object_index *const named_index,
+        named_object_index *const unique_index,
+        publication::version_type *const version,
+        size_type *const segment_size) const {
+  // Retries while the writer is updating the version or has removed the
+  // files of the version read
+  for (int i = 0; i < 1000; ++i) {
+    if (!m_publication.read(version, segment_size)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (*version == 0) return false;
+    if (named_index->open(priv_object_index_path(
+            m_base_path, k_named_object_index_file_name, *version)) &&
+        unique_index->open(priv_object_index_path(
+            m_base_path, k_unique_object_index_file_name, *version))) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_remove_object_indices(
+    const path_type &base_path) {
+  for (const auto *name :
+       {k_named_object_index_file_name, k_unique_object_index_file_name}) {
+    const auto path =
+        storage::get_path(base_path, {k_management_dir_name, name});
+    if (mdtl::file_exist(path) && !mdtl::remove_file(path)) return false;
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_load_object_directories() const {
+  if (m_object_directories_state->load(std::memory_order_acquire) ==
+      lazy_data_state::loaded) {
+    return true;
   }
 
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+  lock_guard_type guard(*m_object_directories_load_mutex);
+#endif
+  const auto state =
+      m_object_directories_state->load(std::memory_order_relaxed);
+  if (state == lazy_data_state::loaded) return true;
+  if (state == lazy_data_state::failed) return false;
+
+  const auto timer = m_phase_timer->measure(phase::deserialize_management_data);
+  if (!const_cast<manager_kernel *>(this)->priv_deserialize_management_data()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to load the object directories");
+    m_object_directories_state->store(lazy_data_state::failed,
+                                      std::memory_order_release);
+    return false;
+  }
+  m_object_directories_state->store(lazy_data_state::loaded,
+                                    std::memory_order_release);
   return true;
 }
 
 // ---------- snapshot ---------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_snapshot(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_snapshot(
     const path_type &destination_base_path, const bool clone,
     const int num_max_copy_threads) {
   priv_check_sanity();
+  if (m_segment_storage.copy_on_write()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Cannot take a snapshot of a datastore opened with the "
+                "copy-on-write mode");
+    return false;
+  }
   priv_serialize_management_data();
 
   if (!priv_create_datastore_directory(destination_base_path)) {
@@ -1031,75 +3060,227 @@ bool manager_kernel<st, sst, cn, cs>::priv_snapshot(
   }
 
   // Copy segment directory
-  if (!m_segment_storage.snapshot(destination_base_path, clone,
-                                  num_max_copy_threads)) {
+  METALL_TRACE(segment_copy_begin, clone, 0);
+  bool copied;
+  {
+    const auto timer = m_phase_timer->measure(phase::copy_segment);
+    if constexpr (has_direct_io_snapshot_v<segment_storage>) {
+      if (m_options.direct_io_snapshot && !clone) {
+        copied = m_segment_storage.snapshot_direct(destination_base_path,
+                                                   num_max_copy_threads);
+      } else {
+        copied = m_segment_storage.snapshot(destination_base_path, clone,
+                                            num_max_copy_threads);
+      }
+    } else {
+      copied = m_segment_storage.snapshot(destination_base_path, clone,
+                                          num_max_copy_threads);
+    }
+  }
+  METALL_TRACE(segment_copy_end, clone, copied);
+  if (!copied) {
     std::stringstream ss;
     ss << "Failed to copy " << m_base_path << " to " << destination_base_path;
     logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
     return false;
   }
 
-  // Copy management directory
-  const auto src_mng_dir =
-      storage::get_path(m_base_path, k_management_dir_name);
-  const auto dst_mng_dir =
-      storage::get_path(destination_base_path, k_management_dir_name);
-  if (!mdtl::create_directory(dst_mng_dir)) {
+  bool management_data_copied;
+  {
+    const auto timer = m_phase_timer->measure(phase::copy_management_data);
+    management_data_copied =
+        priv_copy_management_directory(m_base_path, destination_base_path,
+                                       num_max_copy_threads) &&
+        priv_remove_segment_location(destination_base_path);
+  }
+  if (!management_data_copied) {
+    return false;
+  }
+
+  // Make a new management metadata
+  json_store meta_data;
+  if (!priv_set_uuid(&meta_data)) return false;
+  if (!priv_set_version(&meta_data)) return false;
+  if (!priv_set_size_class_table(&meta_data)) return false;
+  if (!priv_write_management_metadata(destination_base_path, meta_data))
+    return false;
+
+  // Finally, mark it as properly-closed
+  if (!priv_mark_properly_closed(destination_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to create a properly closed mark");
+    return false;
+  }
+
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_snapshot_incremental(
+    const path_type &destination_base_path, const int num_max_copy_threads) {
+  priv_check_sanity();
+  if (m_segment_storage.copy_on_write()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Cannot take a snapshot of a datastore opened with the "
+                "copy-on-write mode");
+    return false;
+  }
+
+  const path_type parent_path = m_last_snapshot_path;
+  m_last_snapshot_path.clear();
+
+  // Takes a full snapshot if there is no parent to take a delta from
+  if (parent_path.empty() || !m_segment_storage.snapshot_delta_tracked() ||
+      !consistent(parent_path)) {
+    if (!priv_snapshot(destination_base_path, true, num_max_copy_threads)) {
+      return false;
+    }
+
+    json_store meta_data;
+    if (!priv_read_management_metadata(destination_base_path, &meta_data) ||
+        !mdtl::ptree::add_value(k_manager_metadata_key_for_snapshot_base, true,
+                                &meta_data) ||
+        !priv_write_management_metadata(destination_base_path, meta_data)) {
+      return false;
+    }
+
+    if (m_segment_storage.track_snapshot_delta()) {
+      m_last_snapshot_path = std::filesystem::absolute(destination_base_path);
+    } else {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "Cannot track the written pages; the next incremental "
+                  "snapshot will be a full snapshot");
+    }
+    return true;
+  }
+
+  priv_serialize_management_data();
+
+  if (!priv_create_datastore_directory(destination_base_path)) {
     std::stringstream ss;
-    ss << "Failed to create directory: " << dst_mng_dir;
+    ss << "Failed to init the destination: " << destination_base_path;
     logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
     return false;
   }
-  // Use a normal copy instead of reflink.
-  // reflink might slow down if there are many reflink copied files.
-  if (!mtlldetail::copy_files_in_directory_in_parallel(src_mng_dir, dst_mng_dir,
-                                                       num_max_copy_threads)) {
+
+  bool delta_saved;
+  {
+    const auto timer = m_phase_timer->measure(phase::copy_segment);
+    delta_saved = m_segment_storage.snapshot_delta(destination_base_path);
+  }
+  if (!delta_saved) {
     std::stringstream ss;
-    ss << "Failed to copy " << src_mng_dir << " to " << dst_mng_dir;
+    ss << "Failed to save the written pages to " << destination_base_path;
     logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
     return false;
   }
 
-  // Make a new management metadata
+  bool management_data_copied;
+  {
+    const auto timer = m_phase_timer->measure(phase::copy_management_data);
+    management_data_copied =
+        priv_copy_management_directory(m_base_path, destination_base_path,
+                                       num_max_copy_threads) &&
+        priv_remove_segment_location(destination_base_path);
+  }
+  if (!management_data_copied) {
+    return false;
+  }
+
+  // Make a new management metadata that links to the parent
   json_store meta_data;
   if (!priv_set_uuid(&meta_data)) return false;
   if (!priv_set_version(&meta_data)) return false;
+  if (!priv_set_size_class_table(&meta_data)) return false;
+  if (!mdtl::ptree::add_value(k_manager_metadata_key_for_snapshot_parent,
+                              parent_path.string(), &meta_data)) {
+    return false;
+  }
   if (!priv_write_management_metadata(destination_base_path, meta_data))
     return false;
 
-  // Finally, mark it as properly-closed
   if (!priv_mark_properly_closed(destination_base_path)) {
     logger::out(logger::level::error, __FILE__, __LINE__,
                 "Failed to create a properly closed mark");
     return false;
   }
 
+  m_last_snapshot_path = std::filesystem::absolute(destination_base_path);
   return true;
 }
 
-// ---------- File operations ---------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_copy_data_store(
-    const path_type &src_base_path, const path_type &dst_base_path,
-    const bool use_clone, const int num_max_copy_threads) {
-  if (!consistent(src_base_path)) {
-    std::string s("Source directory is not consistent: " +
-                  src_base_path.string());
-    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_resolve_incremental_snapshot(const path_type &base_path,
+                                      const json_store &metadata,
+                                      const bool writable) {
+  // The snapshot base is shared by its descendants and must not be modified
+  if (writable &&
+      mdtl::ptree::count(metadata, k_manager_metadata_key_for_snapshot_base) >
+          0) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The datastore is the base of incremental snapshots; open it "
+                "with the read-only or copy-on-write mode");
     return false;
   }
 
-  if (!storage::create(dst_base_path)) {
-    logger::out(logger::level::error, __FILE__, __LINE__,
-                "Failed to initialize the datastore directory");
+  if (mdtl::ptree::count(metadata,
+                         k_manager_metadata_key_for_snapshot_parent) == 0) {
+    return true;  // Not an incremental snapshot
+  }
+
+  // Follow the parents up to the snapshot base
+  std::vector<path_type> ancestor_paths;
+  std::string parent;
+  if (!mdtl::ptree::get_value(metadata,
+                              k_manager_metadata_key_for_snapshot_parent,
+                              &parent)) {
     return false;
   }
+  while (true) {
+    if (ancestor_paths.size() >= k_max_snapshot_chain_length) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Too many parents of an incremental snapshot");
+      return false;
+    }
+    ancestor_paths.emplace_back(parent);
+
+    json_store parent_metadata;
+    if (!priv_read_management_metadata(parent, &parent_metadata)) {
+      std::string s("Cannot read the parent snapshot: " + parent);
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (mdtl::ptree::count(parent_metadata,
+                           k_manager_metadata_key_for_snapshot_parent) == 0) {
+      if (mdtl::ptree::count(parent_metadata,
+                             k_manager_metadata_key_for_snapshot_base) == 0) {
+        std::string s("Not a base of incremental snapshots: " + parent);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+      break;
+    }
+    if (!mdtl::ptree::get_value(parent_metadata,
+                                k_manager_metadata_key_for_snapshot_parent,
+                                &parent)) {
+      return false;
+    }
+  }
+  std::reverse(ancestor_paths.begin(), ancestor_paths.end());
 
-  // Copy segment directory
-  segment_storage::copy(src_base_path, dst_base_path, use_clone,
-                        num_max_copy_threads);
+  for (auto &path : ancestor_paths) path = priv_segment_base_path(path);
+  return segment_storage::resolve_snapshot_delta(
+      priv_segment_base_path(base_path), ancestor_paths, 0);
+}
 
-  // Copy management directory
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_copy_management_directory(
+    const path_type &src_base_path, const path_type &dst_base_path,
+    const int num_max_copy_threads) {
   const auto src_mng_dir =
       storage::get_path(src_base_path, k_management_dir_name);
   const auto dst_mng_dir =
@@ -1118,6 +3299,192 @@ bool manager_kernel<st, sst, cn, cs>::priv_copy_data_store(
     logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
     return false;
   }
+  return true;
+}
+
+// ---------- Replication ---------- //
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_write_replication_management_data(std::ostream &stream) const {
+  const auto mng_dir = storage::get_path(m_base_path, k_management_dir_name);
+  std::vector<path_type> names;
+  if (!mdtl::get_regular_file_names(mng_dir, &names)) {
+    std::string s("Cannot list the files in " + mng_dir.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+  // The publication and the object indices are for the processes that open
+  // this datastore; the indices of a replica would be stale
+  names.erase(std::remove_if(names.begin(), names.end(),
+                             [](const path_type &name) {
+                               const auto s = name.string();
+                               return s == k_publication_file_name ||
+                                      s.rfind(k_named_object_index_file_name,
+                                              0) == 0 ||
+                                      s.rfind(k_unique_object_index_file_name,
+                                              0) == 0;
+                             }),
+              names.end());
+
+  const auto write = [&stream](const uint64_t value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  write(names.size());
+  for (const auto &name : names) {
+    std::ifstream ifs(mng_dir / name, std::ios::binary);
+    const auto size = mdtl::get_file_size(mng_dir / name);
+    if (!ifs || size < 0) {
+      std::string s("Cannot read " + (mng_dir / name).string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    const auto s = name.string();
+    write(s.size());
+    stream.write(s.data(), s.size());
+    write(size);
+    if (size > 0 && !(stream << ifs.rdbuf())) break;
+  }
+  if (!stream) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to write the management data to the replication "
+                "stream");
+    return false;
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::
+    priv_read_replication_management_data(const path_type &base_path,
+                                          std::istream &stream) {
+  const auto mng_dir = storage::get_path(base_path, k_management_dir_name);
+  const auto read = [&stream]() {
+    uint64_t value = 0;
+    stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+    return value;
+  };
+
+  std::vector<path_type> names;
+  const auto num_files = read();
+  std::vector<char> buf(1ULL << 20ULL);
+  for (std::size_t i = 0; stream && i < num_files; ++i) {
+    std::string name(read(), '\0');
+    stream.read(name.data(), name.size());
+    // Only a file name is accepted not to write outside the directory
+    if (!stream || name.empty() || name.find('/') != std::string::npos ||
+        name == "." || name == "..") {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Broken replication stream");
+      return false;
+    }
+    std::ofstream ofs(mng_dir / name, std::ios::binary | std::ios::trunc);
+    for (auto size = read(); stream && ofs && size > 0;) {
+      const auto n = std::min<uint64_t>(size, buf.size());
+      stream.read(buf.data(), n);
+      ofs.write(buf.data(), n);
+      size -= n;
+    }
+    ofs.close();
+    if (!ofs || !mdtl::fsync(mng_dir / name)) {
+      std::string s("Failed to write " + (mng_dir / name).string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    names.emplace_back(std::move(name));
+  }
+  if (!stream) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to read the management data from the replication "
+                "stream");
+    return false;
+  }
+
+  // Remove the files the datastore does not have anymore
+  std::vector<path_type> existing_names;
+  if (!mdtl::get_regular_file_names(mng_dir, &existing_names)) return false;
+  for (const auto &name : existing_names) {
+    if (std::find(names.begin(), names.end(), name) == names.end() &&
+        !mdtl::remove_file(mng_dir / name)) {
+      return false;
+    }
+  }
+  return mdtl::fsync(mng_dir);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_read_replication_state(
+    const path_type &base_path, uint64_t *const session,
+    uint64_t *const sequence) {
+  std::ifstream ifs(storage::get_path(base_path, k_replication_state_file_name),
+                    std::ios::binary);
+  ifs.read(reinterpret_cast<char *>(session), sizeof(*session));
+  ifs.read(reinterpret_cast<char *>(sequence), sizeof(*sequence));
+  return !!ifs;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_replication_state(
+    const path_type &base_path, const uint64_t session,
+    const uint64_t sequence) {
+  const auto path = storage::get_path(base_path, k_replication_state_file_name);
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&session), sizeof(session));
+    ofs.write(reinterpret_cast<const char *>(&sequence), sizeof(sequence));
+    ofs.close();
+    if (!ofs) {
+      std::string s("Failed to write " + path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+  }
+  return mdtl::fsync(path);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_remove_replication_state(
+    const path_type &base_path) {
+  return mdtl::remove_file(
+      storage::get_path(base_path, k_replication_state_file_name));
+}
+
+// ---------- File operations ---------- //
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_copy_data_store(
+    const path_type &src_base_path, const path_type &dst_base_path,
+    const bool use_clone, const int num_max_copy_threads) {
+  if (!consistent(src_base_path)) {
+    std::string s("Source directory is not consistent: " +
+                  src_base_path.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+
+  if (!storage::create(dst_base_path)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to initialize the datastore directory");
+    return false;
+  }
+
+  // Copy segment directory
+  METALL_TRACE(segment_copy_begin, use_clone, 0);
+  [[maybe_unused]] const bool copied =
+      segment_storage::copy(priv_segment_base_path(src_base_path),
+                            dst_base_path, use_clone, num_max_copy_threads);
+  METALL_TRACE(segment_copy_end, use_clone, copied);
+
+  // The copy stores its segment with its management data
+  if (!priv_copy_management_directory(src_base_path, dst_base_path,
+                                      num_max_copy_threads) ||
+      !priv_remove_segment_location(dst_base_path)) {
+    return false;
+  }
 
   // Finally, mark it as properly-closed
   if (!priv_mark_properly_closed(dst_base_path)) {
@@ -1129,15 +3496,99 @@ bool manager_kernel<st, sst, cn, cs>::priv_copy_data_store(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_remove_data_store(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_read_used_chunks(
+    const path_type &base_path, std::vector<bool> *const used_chunks) {
+  return segment_memory_allocator::for_each_used_chunk(
+      storage::get_path(base_path, {k_management_dir_name,
+                                    k_segment_memory_allocator_prefix}),
+      [used_chunks](const chunk_no_type chunk_no, auto, auto) {
+        if (used_chunks->size() <= chunk_no) {
+          used_chunks->resize(chunk_no + 1);
+        }
+        (*used_chunks)[chunk_no] = true;
+      });
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::vector<
+    std::pair<typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type,
+              typename manager_kernel<st, sst, cn, cs, sct, ccp>::size_type>>
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_chunk_regions(
+    const std::vector<bool> &used_chunks) {
+  std::vector<std::pair<size_type, size_type>> regions;
+  for (std::size_t chunk_no = 0; chunk_no < used_chunks.size(); ++chunk_no) {
+    if (!used_chunks[chunk_no]) continue;
+    const size_type offset = chunk_no * k_chunk_size;
+    if (!regions.empty() &&
+        regions.back().first + regions.back().second == offset) {
+      regions.back().second += k_chunk_size;
+    } else {
+      regions.emplace_back(offset, k_chunk_size);
+    }
+  }
+  return regions;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_remove_data_store(
+    const path_type &base_path) {
+  bool succeeded = true;
+  if (const auto segment_base_path = priv_segment_base_path(base_path);
+      segment_base_path != base_path) {
+    succeeded &= storage::remove(segment_base_path);
+  }
+  return storage::remove(base_path) && succeeded;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+typename manager_kernel<st, sst, cn, cs, sct, ccp>::path_type
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_segment_base_path(
+    const path_type &base_path) {
+  std::ifstream ifs(storage::get_path(
+      base_path, {k_management_dir_name, k_segment_location_file_name}));
+  std::string segment_base_path;
+  if (!ifs.is_open() || !std::getline(ifs, segment_base_path) ||
+      segment_base_path.empty()) {
+    return base_path;
+  }
+  return segment_base_path;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_segment_location(
+    const path_type &base_path, const path_type &segment_base_path) {
+  const auto file_name = storage::get_path(
+      base_path, {k_management_dir_name, k_segment_location_file_name});
+  std::ofstream ofs(file_name);
+  if (!ofs.is_open() || !(ofs << segment_base_path.string() << "\n")) {
+    std::string s("Failed to write the segment location: " +
+                  file_name.string());
+    logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    return false;
+  }
+  ofs.close();
+  return mdtl::fsync(file_name);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_remove_segment_location(
     const path_type &base_path) {
-  return storage::remove(base_path);
+  const auto file_name = storage::get_path(
+      base_path, {k_management_dir_name, k_segment_location_file_name});
+  return !mdtl::file_exist(file_name) || mdtl::remove_file(file_name);
 }
 
 // ---------- Management metadata ---------- //
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_write_management_metadata(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_management_metadata(
     const path_type &base_path, const json_store &json_root) {
   if (!mdtl::ptree::write_json(
           json_root,
@@ -1151,8 +3602,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_write_management_metadata(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_read_management_metadata(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_read_management_metadata(
     const path_type &base_path, json_store *json_root) {
   if (!mdtl::ptree::read_json(
           storage::get_path(
@@ -1165,8 +3617,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_read_management_metadata(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-version_type manager_kernel<st, sst, cn, cs>::priv_get_version(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+version_type manager_kernel<st, sst, cn, cs, sct, ccp>::priv_get_version(
     const json_store &metadata_json) {
   version_type version;
   if (!mdtl::ptree::get_value(metadata_json, k_manager_metadata_key_for_version,
@@ -1176,8 +3629,9 @@ version_type manager_kernel<st, sst, cn, cs>::priv_get_version(
   return version;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_set_version(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_set_version(
     json_store *metadata_json) {
   if (mdtl::ptree::count(*metadata_json, k_manager_metadata_key_for_version) >
       0) {
@@ -1194,8 +3648,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_set_version(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-std::string manager_kernel<st, sst, cn, cs>::priv_get_uuid(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+std::string manager_kernel<st, sst, cn, cs, sct, ccp>::priv_get_uuid(
     const json_store &metadata_json) {
   std::string uuid_string;
   if (!mdtl::ptree::get_value(metadata_json, k_manager_metadata_key_for_uuid,
@@ -1206,8 +3661,10 @@ std::string manager_kernel<st, sst, cn, cs>::priv_get_uuid(
   return uuid_string;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_set_uuid(json_store *metadata_json) {
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_set_uuid(
+    json_store *metadata_json) {
   std::stringstream uuid_ss;
   uuid_ss << mdtl::uuid(mdtl::uuid_random_generator{}());
   if (!uuid_ss) {
@@ -1229,10 +3686,56 @@ bool manager_kernel<st, sst, cn, cs>::priv_set_uuid(json_store *metadata_json) {
   return true;
 }
 
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+template <typename table>
+std::string
+manager_kernel<st, sst, cn, cs, sct, ccp>::priv_size_class_table_string() {
+  std::string str;
+  for (std::size_t i = 0; i < table::k_num_sizes; ++i) {
+    if (i > 0) str += ",";
+    str += std::to_string(table::k_sizes[i]);
+  }
+  return str;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_set_size_class_table(
+    json_store *metadata_json) {
+  if (mdtl::ptree::count(*metadata_json,
+                         k_manager_metadata_key_for_size_class_table) > 0) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Size class table information already exist");
+    return false;
+  }
+
+  return mdtl::ptree::add_value(
+      k_manager_metadata_key_for_size_class_table,
+      priv_size_class_table_string<size_class_table_type>(), metadata_json);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_check_size_class_table(
+    const json_store &metadata_json) {
+  std::string table =
+      priv_size_class_table_string<default_size_class_table>();
+  if (mdtl::ptree::count(metadata_json,
+                         k_manager_metadata_key_for_size_class_table) > 0 &&
+      !mdtl::ptree::get_value(metadata_json,
+                              k_manager_metadata_key_for_size_class_table,
+                              &table)) {
+    return false;
+  }
+  return table == priv_size_class_table_string<size_class_table_type>();
+}
+
 // ---------- Description ---------- //
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_read_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_read_description(
     const path_type &base_path, std::string *description) {
   const auto &file_name = storage::get_path(
       base_path, {k_management_dir_name, k_description_file_name});
@@ -1256,8 +3759,9 @@ bool manager_kernel<st, sst, cn, cs>::priv_read_description(
   return true;
 }
 
-template <typename st, typename sst, typename cn, std::size_t cs>
-bool manager_kernel<st, sst, cn, cs>::priv_write_description(
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_write_description(
     const path_type &base_path, const std::string &description) {
   const auto &file_name = storage::get_path(
       base_path, {k_management_dir_name, k_description_file_name});
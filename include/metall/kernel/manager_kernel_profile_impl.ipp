@@ -11,12 +11,282 @@
 namespace metall {
 namespace kernel {
 
-template <typename st, typename sst, typename cn, std::size_t cs>
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
 template <typename out_stream_type>
-void manager_kernel<st, sst, cn, cs>::profile(out_stream_type *log_out) {
+void manager_kernel<st, sst, cn, cs, sct, ccp>::profile(
+    out_stream_type *log_out) {
+  if (!priv_load_segment_memory_allocator()) return;
   m_segment_memory_allocator.profile(log_out);
 }
 
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_memory_statistics(
+    memory_statistics *const stats, const bool include_named_objects,
+    const bool include_resident_bytes) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  m_segment_memory_allocator.get_statistics(stats);
+
+  stats->segment_size = m_segment_storage.size();
+  stats->resident_bytes = 0;
+  if (include_resident_bytes) {
+    const auto resident_bytes = mdtl::get_num_resident_bytes(
+        const_cast<void *>(m_segment_storage.get_segment()),
+        m_segment_storage.size());
+    if (resident_bytes < 0) return false;
+    stats->resident_bytes = resident_bytes;
+  }
+
+  stats->named_objects.clear();
+  if (include_named_objects) {
+    priv_load_object_directories();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+    directory_shared_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+    stats->named_objects.reserve(m_named_object_directory.size());
+    for (const auto &entry : m_named_object_directory) {
+      stats->named_objects.push_back(
+          {entry.name(),
+           m_segment_memory_allocator.allocated_size(entry.offset())});
+    }
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_memory_counters(
+    memory_counters *const counters) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  m_segment_memory_allocator.get_counters(counters);
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_page_statistics(
+    page_statistics *const stats, const bool include_named_objects) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  if (!m_page_state_scanner) {
+    m_page_state_scanner = std::make_unique<page_state_scanner>();
+  }
+  auto &scanner = *m_page_state_scanner;
+  const auto segment_size = m_segment_storage.size();
+  if (!scanner.scan(m_segment_storage.get_segment(), segment_size)) {
+    return false;
+  }
+
+  *stats = page_statistics{};
+  stats->page_size = scanner.page_size();
+  stats->chunk_size = k_chunk_size;
+  stats->scanned_bytes = segment_size;
+  stats->dirty_pages_available = scanner.dirty_pages_available();
+  stats->total = scanner.count(0, segment_size);
+
+  std::vector<bin_page_statistics> bins;
+  m_segment_memory_allocator.for_each_used_chunk(
+      [&](const std::size_t chunk_no, const auto bin_no,
+          const std::size_t object_size) {
+        const auto counts =
+            scanner.count(chunk_no * k_chunk_size, k_chunk_size);
+        if (bins.size() <= bin_no) bins.resize(bin_no + 1);
+        auto &bin = bins[bin_no];
+        bin.bin_no = bin_no;
+        bin.object_size = object_size;
+        ++bin.num_chunks;
+        bin.pages += counts;
+        if (!counts.empty()) {
+          stats->chunks.push_back({chunk_no, uint32_t(bin_no), counts});
+        }
+      });
+  for (const auto &bin : bins) {
+    if (bin.num_chunks > 0) stats->bins.push_back(bin);
+  }
+
+  if (include_named_objects) {
+    priv_load_object_directories();
+#ifdef METALL_ENABLE_MUTEX_IN_MANAGER_KERNEL
+    directory_shared_lock_guard_type guard(*m_object_directories_mutex);
+#endif
+    const auto add = [&](const auto &directory) {
+      for (const auto &entry : directory) {
+        const auto bytes =
+            m_segment_memory_allocator.allocated_size(entry.offset());
+        stats->objects.push_back(
+            {entry.name(), bytes, scanner.count(entry.offset(), bytes)});
+      }
+    };
+    add(m_named_object_directory);
+    add(m_unique_object_directory);
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::bind_to_numa_node(
+    const void *const addr, const size_type nbytes, const int node) {
+  priv_check_sanity();
+  difference_type offset = 0;
+  if (!priv_to_segment_offset(addr, nbytes, &offset)) return false;
+  return m_segment_storage.bind_to_numa_node(offset, nbytes, node);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::migrate_cold_chunks(
+    const memory_tiering_policy &policy, memory_tiering_result *const result) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  int far_node = policy.far_node;
+  if (far_node < 0) {
+    const auto &nodes = mdtl::numa::cpuless_nodes();
+    if (nodes.empty()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No NUMA node without CPUs is found for the far tier");
+      return false;
+    }
+    far_node = nodes.front();
+  }
+
+  if (!priv_sample_chunk_accesses()) return false;
+  auto &sampler = *m_chunk_access_sampler;
+  auto *const segment = m_segment_storage.get_segment();
+  const auto num_chunks = m_segment_storage.size() / k_chunk_size;
+
+  memory_tiering_result tmp_result;
+  tmp_result.source = sampler.source();
+  std::size_t migrated_bytes = 0;
+  bool succeeded = true;
+  m_segment_memory_allocator.for_each_used_chunk(
+      [&](const std::size_t chunk_no, const auto, const std::size_t) {
+        if (chunk_no >= num_chunks) return;
+        ++tmp_result.num_sampled_chunks;
+        const bool can_move = policy.max_migration_bytes == 0 ||
+                              migrated_bytes < policy.max_migration_bytes;
+        const auto idle = sampler.num_idle_samples(chunk_no);
+        int node = -1;
+        if (!sampler.far(chunk_no) && idle >= policy.num_cold_samples) {
+          node = far_node;
+        } else if (sampler.far(chunk_no) && policy.near_node >= 0 &&
+                   idle == 0) {
+          node = policy.near_node;
+        }
+        if (can_move && node >= 0) {
+          if (m_segment_storage.bind_to_numa_node(chunk_no * k_chunk_size,
+                                                  k_chunk_size, node)) {
+            const bool demoted = (node == far_node);
+            sampler.set_far(chunk_no, demoted);
+            sampler.moved(segment, chunk_no);
+            ++(demoted ? tmp_result.num_demoted_chunks
+                       : tmp_result.num_promoted_chunks);
+            migrated_bytes += k_chunk_size;
+          } else {
+            succeeded = false;
+          }
+        }
+        if (sampler.far(chunk_no)) ++tmp_result.num_far_chunks;
+      });
+  if (result) *result = tmp_result;
+  return succeeded;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::sample_chunk_heat(
+    chunk_heat_statistics *const stats) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  if (!priv_sample_chunk_accesses()) return false;
+  return !stats || get_chunk_heat_statistics(stats);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::get_chunk_heat_statistics(
+    chunk_heat_statistics *const stats) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  m_segment_memory_allocator.get_chunk_heat(stats);
+  stats->num_samples =
+      m_chunk_access_sampler ? m_chunk_access_sampler->num_samples() : 0;
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::priv_sample_chunk_accesses() {
+  if (!m_chunk_access_sampler) {
+    m_chunk_access_sampler = std::make_unique<chunk_access_sampler>();
+  }
+  auto &sampler = *m_chunk_access_sampler;
+  const auto num_chunks = m_segment_storage.size() / k_chunk_size;
+  if (!sampler.sample(m_segment_storage.get_segment(), num_chunks,
+                      k_chunk_size)) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed to sample the accesses to the chunks");
+    return false;
+  }
+  // The first sample only starts sampling
+  if (sampler.num_samples() > 0) {
+    m_segment_memory_allocator.record_chunk_accesses(
+        [&sampler](const std::size_t chunk_no) {
+          return sampler.accessed(chunk_no);
+        });
+  }
+  return true;
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::write_allocation_profile(
+    const path_type &path) {
+  if (!priv_load_segment_memory_allocator()) return false;
+  return m_segment_memory_allocator.write_allocation_profile(path);
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::start_allocation_trace(
+    [[maybe_unused]] const path_type &path) {
+#ifdef METALL_USE_ALLOCATION_TRACE
+  if (m_allocation_trace && !stop_allocation_trace()) return false;
+  auto trace = std::make_unique<allocation_trace_writer>(path, k_chunk_size);
+  if (!trace->good()) return false;
+  m_allocation_trace = std::move(trace);
+  return true;
+#else
+  logger::out(logger::level::error, __FILE__, __LINE__,
+              "Allocation trace is not enabled (define "
+              "METALL_USE_ALLOCATION_TRACE)");
+  return false;
+#endif
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+bool manager_kernel<st, sst, cn, cs, sct, ccp>::stop_allocation_trace() {
+#ifdef METALL_USE_ALLOCATION_TRACE
+  if (!m_allocation_trace) return true;
+  const bool ret = m_allocation_trace->close();
+  m_allocation_trace.reset();
+  return ret;
+#else
+  return false;
+#endif
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+phase_timings manager_kernel<st, sst, cn, cs, sct, ccp>::
+    get_phase_timings() const {
+  return m_phase_timer->get();
+}
+
+template <typename st, typename sst, typename cn, std::size_t cs,
+          typename sct, typename ccp>
+void manager_kernel<st, sst, cn, cs, sct, ccp>::reset_phase_timings() {
+  m_phase_timer->reset();
+}
+
 }  // namespace kernel
 }  // namespace metall
 
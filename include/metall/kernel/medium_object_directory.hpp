@@ -0,0 +1,428 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_MEDIUM_OBJECT_DIRECTORY_HPP
+#define METALL_KERNEL_MEDIUM_OBJECT_DIRECTORY_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include <metall/logger.hpp>
+
+namespace metall {
+namespace kernel {
+
+namespace {
+namespace fs = std::filesystem;
+}
+
+/// \brief A directory of the medium objects placed in slabs, i.e., regions
+/// of several chunks allocated as large objects.
+/// Objects of any size that is a multiple of the granule are cut from the
+/// free extents of the slabs by address-ordered best fit: the smallest free
+/// extent that fits is used and the lowest one among the same size.
+/// Freed objects are merged with the free extents next to them in the same
+/// slab; a slab whose space is all free is removed from the directory and
+/// given back to the caller.
+/// This class does not touch the memory of the slabs and is not thread-safe.
+/// \tparam difference_type The offset type.
+/// \tparam size_type The size type.
+template <typename difference_type, typename size_type>
+class medium_object_directory {
+ public:
+  /// \brief Constructor.
+  /// \param granule The size objects are rounded up to.
+  /// \param null_offset The offset that means no object.
+  medium_object_directory(const size_type granule,
+                          const difference_type null_offset)
+      : m_granule(granule), m_null_offset(null_offset) {
+    assert(granule > 0);
+  }
+
+  ~medium_object_directory() noexcept = default;
+  medium_object_directory(const medium_object_directory &) = default;
+  medium_object_directory &operator=(const medium_object_directory &) =
+      default;
+  medium_object_directory(medium_object_directory &&) noexcept = default;
+  medium_object_directory &operator=(medium_object_directory &&) noexcept =
+      default;
+
+  /// \brief Returns the size an object of 'nbytes' bytes takes.
+  size_type round_up(const size_type nbytes) const {
+    return (nbytes + m_granule - 1) / m_granule * m_granule;
+  }
+
+  /// \brief Adds a slab whose space is all free.
+  /// \param offset The offset of the slab.
+  /// \param size The size of the slab. Must be a multiple of the granule.
+  void add_slab(const difference_type offset, const size_type size) {
+    assert(size > 0 && size % m_granule == 0);
+    assert(m_slabs.count(offset) == 0);
+    m_slabs.emplace(offset, slab_type{size, 0});
+    priv_insert_free_extent(offset, size);
+  }
+
+  /// \brief Allocates an object.
+  /// \param nbytes The size of the object.
+  /// \return The offset of the object; null_offset if no free extent fits.
+  difference_type allocate(const size_type nbytes) {
+    const size_type size = round_up(nbytes);
+    const auto itr = m_free_by_size.lower_bound({size, k_min_offset});
+    if (itr == m_free_by_size.end()) return m_null_offset;
+
+    const auto [extent_size, offset] = *itr;
+    priv_erase_free_extent(offset, extent_size);
+    if (extent_size > size) {
+      priv_insert_free_extent(offset + size, extent_size - size);
+    }
+    m_objects.emplace(offset, size);
+    priv_find_slab(offset)->second.used_bytes += size;
+    return offset;
+  }
+
+  /// \brief Deallocates an object.
+  /// \param offset The offset of the object.
+  /// \param empty_slab A pointer to store the offset of the slab if it
+  /// became empty and was removed; otherwise, null_offset is stored.
+  /// \return Returns false if 'offset' is not an object in this directory.
+  bool deallocate(const difference_type offset,
+                  difference_type *const empty_slab) {
+    *empty_slab = m_null_offset;
+    const auto obj = m_objects.find(offset);
+    if (obj == m_objects.end()) return false;
+    const size_type size = obj->second;
+    m_objects.erase(obj);
+
+    const auto slab = priv_find_slab(offset);
+    slab->second.used_bytes -= size;
+    if (slab->second.used_bytes == 0) {
+      // The rest of the slab is free; drops its free extents
+      const difference_type end = slab->first + slab->second.size;
+      for (auto itr = m_free_by_offset.lower_bound(slab->first);
+           itr != m_free_by_offset.end() && itr->first < end;) {
+        m_free_by_size.erase({itr->second, itr->first});
+        itr = m_free_by_offset.erase(itr);
+      }
+      *empty_slab = slab->first;
+      m_slabs.erase(slab);
+      return true;
+    }
+    priv_free_and_merge(offset, size, slab);
+    return true;
+  }
+
+  /// \brief Changes the size of an object without moving it.
+  /// The object shrinks by freeing its tail and grows into the free extent
+  /// right after it.
+  /// \return Returns true on success; otherwise, the object is not changed.
+  bool resize(const difference_type offset, const size_type nbytes) {
+    const auto obj = m_objects.find(offset);
+    if (obj == m_objects.end() || nbytes == 0) return false;
+    const size_type old_size = obj->second;
+    const size_type new_size = round_up(nbytes);
+    if (new_size == old_size) return true;
+
+    const auto slab = priv_find_slab(offset);
+    if (new_size < old_size) {
+      obj->second = new_size;
+      slab->second.used_bytes -= old_size - new_size;
+      priv_free_and_merge(offset + new_size, old_size - new_size, slab);
+      return true;
+    }
+
+    const size_type growth = new_size - old_size;
+    const auto next = m_free_by_offset.find(offset + old_size);
+    if (next == m_free_by_offset.end() || next->second < growth ||
+        !priv_in_slab(next->first, slab)) {
+      return false;
+    }
+    const size_type next_size = next->second;
+    priv_erase_free_extent(offset + old_size, next_size);
+    if (next_size > growth) {
+      priv_insert_free_extent(offset + new_size, next_size - growth);
+    }
+    obj->second = new_size;
+    slab->second.used_bytes += growth;
+    return true;
+  }
+
+  /// \brief Returns the size of an object; 0 if 'offset' is not an object.
+  size_type object_size(const difference_type offset) const {
+    const auto obj = m_objects.find(offset);
+    return (obj == m_objects.end()) ? 0 : obj->second;
+  }
+
+  /// \brief Returns true if 'offset' is in a slab.
+  bool in_slab(const difference_type offset) const {
+    if (m_slabs.empty()) return false;
+    const auto slab = priv_find_slab(offset);
+    return slab != m_slabs.end() && priv_in_slab(offset, slab);
+  }
+
+  /// \brief Marks the free space of all slabs as used without making
+  /// objects, e.g., after a crash, when objects could have been allocated
+  /// there. The space is never reused and the slabs are never removed.
+  void reserve_free_space() {
+    for (const auto &[offset, size] : m_free_by_offset) {
+      priv_find_slab(offset)->second.used_bytes += size;
+    }
+    m_free_by_offset.clear();
+    m_free_by_size.clear();
+  }
+
+  /// \brief Removes a slab and the objects in it.
+  void erase_slab(const difference_type offset) {
+    const auto slab = m_slabs.find(offset);
+    if (slab == m_slabs.end()) return;
+    const difference_type end = offset + slab->second.size;
+    for (auto itr = m_free_by_offset.lower_bound(offset);
+         itr != m_free_by_offset.end() && itr->first < end;) {
+      m_free_by_size.erase({itr->second, itr->first});
+      itr = m_free_by_offset.erase(itr);
+    }
+    for (auto itr = m_objects.begin(); itr != m_objects.end();) {
+      if (itr->first >= offset && itr->first < end) {
+        itr = m_objects.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+    m_slabs.erase(slab);
+  }
+
+  /// \brief Calls 'func(offset, size)' for each slab in the address order.
+  template <typename function_type>
+  void for_each_slab(function_type func) const {
+    for (const auto &[offset, slab] : m_slabs) func(offset, slab.size);
+  }
+
+  std::size_t num_slabs() const { return m_slabs.size(); }
+
+  std::size_t num_objects() const { return m_objects.size(); }
+
+  std::size_t num_free_extents() const { return m_free_by_offset.size(); }
+
+  /// \brief Returns the number of bytes of the slabs.
+  size_type slab_bytes() const {
+    size_type total = 0;
+    for (const auto &[offset, slab] : m_slabs) total += slab.size;
+    return total;
+  }
+
+  /// \brief Returns the number of bytes allocated to objects.
+  size_type allocated_bytes() const {
+    size_type total = 0;
+    for (const auto &[offset, size] : m_objects) total += size;
+    return total;
+  }
+
+  /// \brief Returns the number of free bytes in the slabs.
+  size_type free_bytes() const {
+    size_type total = 0;
+    for (const auto &[offset, size] : m_free_by_offset) total += size;
+    return total;
+  }
+
+  bool empty() const { return m_slabs.empty(); }
+
+  void clear() {
+    m_slabs.clear();
+    m_free_by_offset.clear();
+    m_free_by_size.clear();
+    m_objects.clear();
+  }
+
+  /// \brief Writes the slabs, the free extents, and the objects to a file.
+  bool serialize(const fs::path &path) const {
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    ofs << k_slab_tag << " " << m_granule << "\n";
+    for (const auto &[offset, slab] : m_slabs) {
+      ofs << k_slab_tag << " " << offset << " " << slab.size << "\n";
+    }
+    for (const auto &[offset, size] : m_free_by_offset) {
+      ofs << k_free_tag << " " << offset << " " << size << "\n";
+    }
+    for (const auto &[offset, size] : m_objects) {
+      ofs << k_object_tag << " " << offset << " " << size << "\n";
+    }
+    if (!ofs) {
+      std::stringstream ss;
+      ss << "Something happened in the ofstream: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    ofs.close();
+    return true;
+  }
+
+  /// \brief Reads a file written by serialize().
+  /// The space of a slab not in a free extent or an object is reserved.
+  bool deserialize(const fs::path &path) {
+    clear();
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+
+    const auto fail = [this, &path](const char *const what) {
+      std::stringstream ss;
+      ss << what << ": " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      clear();
+      return false;
+    };
+
+    char tag;
+    size_type granule = 0;
+    if (!(ifs >> tag >> granule) || tag != k_slab_tag) {
+      return fail("Invalid medium object directory");
+    }
+    if (granule != m_granule) {
+      return fail("The granule of the medium objects is different");
+    }
+
+    difference_type offset;
+    size_type size;
+    while (ifs >> tag >> offset >> size) {
+      if (tag == k_slab_tag) {
+        if (size == 0 || size % m_granule != 0 ||
+            !m_slabs.emplace(offset, slab_type{size, size}).second) {
+          return fail("Invalid medium object slab");
+        }
+        continue;
+      }
+      const auto slab = priv_find_slab(offset);
+      if (size == 0 || slab == m_slabs.end() ||
+          !priv_in_slab(offset + size - 1, slab)) {
+        return fail("A medium object is out of the slabs");
+      }
+      if (tag == k_free_tag) {
+        if (slab->second.used_bytes < size) {
+          return fail("Invalid medium object free extent");
+        }
+        priv_insert_free_extent(offset, size);
+        slab->second.used_bytes -= size;
+      } else if (tag == k_object_tag) {
+        if (!m_objects.emplace(offset, size).second) {
+          return fail("A medium object is listed more than once");
+        }
+      } else {
+        return fail("Invalid medium object directory entry");
+      }
+    }
+    if (!ifs.eof()) return fail("Something happened in the ifstream");
+
+    // Empty slabs would never be given back
+    for (const auto &[slab_offset, slab] : m_slabs) {
+      if (slab.used_bytes == 0) return fail("An empty medium object slab");
+    }
+    return true;
+  }
+
+ private:
+  static constexpr char k_slab_tag = 's';
+  static constexpr char k_free_tag = 'f';
+  static constexpr char k_object_tag = 'o';
+  static constexpr difference_type k_min_offset =
+      std::numeric_limits<difference_type>::min();
+
+  struct slab_type {
+    size_type size;
+    // The bytes of the objects and the reserved space
+    size_type used_bytes;
+  };
+  using slab_table_type = std::map<difference_type, slab_type>;
+
+  /// \brief Returns the slab at or before 'offset' or m_slabs.end().
+  typename slab_table_type::iterator priv_find_slab(
+      const difference_type offset) {
+    auto itr = m_slabs.upper_bound(offset);
+    return (itr == m_slabs.begin()) ? m_slabs.end() : std::prev(itr);
+  }
+
+  typename slab_table_type::const_iterator priv_find_slab(
+      const difference_type offset) const {
+    auto itr = m_slabs.upper_bound(offset);
+    return (itr == m_slabs.begin()) ? m_slabs.end() : std::prev(itr);
+  }
+
+  template <typename slab_iterator>
+  static bool priv_in_slab(const difference_type offset,
+                           const slab_iterator slab) {
+    return offset >= slab->first &&
+           offset < slab->first +
+                        static_cast<difference_type>(slab->second.size);
+  }
+
+  void priv_insert_free_extent(const difference_type offset,
+                               const size_type size) {
+    m_free_by_offset.emplace(offset, size);
+    m_free_by_size.emplace(size, offset);
+  }
+
+  void priv_erase_free_extent(const difference_type offset,
+                              const size_type size) {
+    m_free_by_offset.erase(offset);
+    m_free_by_size.erase({size, offset});
+  }
+
+  /// \brief Frees a range, merging it with the free extents next to it in
+  /// the same slab.
+  void priv_free_and_merge(difference_type offset, size_type size,
+                           const typename slab_table_type::iterator slab) {
+    const auto next = m_free_by_offset.find(offset + size);
+    if (next != m_free_by_offset.end() && priv_in_slab(next->first, slab)) {
+      const size_type next_size = next->second;
+      priv_erase_free_extent(next->first, next_size);
+      size += next_size;
+    }
+    const auto prev = m_free_by_offset.lower_bound(offset);
+    if (prev != m_free_by_offset.begin()) {
+      const auto itr = std::prev(prev);
+      if (itr->first + static_cast<difference_type>(itr->second) == offset &&
+          priv_in_slab(itr->first, slab)) {
+        const difference_type prev_offset = itr->first;
+        const size_type prev_size = itr->second;
+        priv_erase_free_extent(prev_offset, prev_size);
+        offset = prev_offset;
+        size += prev_size;
+      }
+    }
+    priv_insert_free_extent(offset, size);
+  }
+
+  size_type m_granule;
+  difference_type m_null_offset;
+  slab_table_type m_slabs;
+  std::map<difference_type, size_type> m_free_by_offset;
+  // (size, offset) pairs for the best fit; lower offsets first
+  std::set<std::pair<size_type, difference_type>> m_free_by_size;
+  std::unordered_map<difference_type, size_type> m_objects;
+};
+
+}  // namespace kernel
+}  // namespace metall
+
+#endif  // METALL_KERNEL_MEDIUM_OBJECT_DIRECTORY_HPP
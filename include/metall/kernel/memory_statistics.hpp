@@ -0,0 +1,255 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_MEMORY_STATISTICS_HPP
+#define METALL_KERNEL_MEMORY_STATISTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace metall::kernel {
+
+/// \brief Memory usage of a bin, i.e., of the objects of a size class.
+struct bin_statistics {
+  /// \brief The bin number.
+  std::size_t bin_no{0};
+  /// \brief The size of an object in the bin in byte.
+  std::size_t object_size{0};
+  /// \brief The number of chunks holding the objects of the bin.
+  std::size_t num_chunks{0};
+  /// \brief The number of the chunks that have free slots.
+  /// Always 0 for large objects.
+  std::size_t num_non_full_chunks{0};
+  /// \brief The number of allocated objects, excluding cached objects.
+  std::size_t num_objects{0};
+  /// \brief The number of objects kept in the object cache, i.e., deallocated
+  /// objects that have not been returned to the chunks.
+  std::size_t num_cached_objects{0};
+  /// \brief The number of bytes allocated to objects, i.e.,
+  /// num_objects * object_size.
+  std::size_t allocated_bytes{0};
+  /// \brief The number of bytes in the chunks of the bin not allocated to
+  /// objects, including the cached objects.
+  std::size_t free_bytes{0};
+
+  /// \brief Returns the ratio of the free bytes to the bytes of the chunks
+  /// of the bin. Returns 0 if the bin has no chunk.
+  double fragmentation() const noexcept {
+    const auto total = allocated_bytes + free_bytes;
+    return (total == 0) ? 0.0 : static_cast<double>(free_bytes) / total;
+  }
+};
+
+/// \brief Memory usage of the medium objects, which are placed in slabs.
+/// All zero if METALL_USE_MEDIUM_OBJECT_SLABS is not defined.
+struct medium_object_statistics {
+  /// \brief The number of slabs. The chunks of the slabs are not counted in
+  /// the bins.
+  std::size_t num_slabs{0};
+  /// \brief The number of chunks of the slabs.
+  std::size_t num_chunks{0};
+  /// \brief The number of allocated medium objects.
+  std::size_t num_objects{0};
+  /// \brief The number of bytes allocated to medium objects.
+  std::size_t allocated_bytes{0};
+  /// \brief The number of free bytes in the slabs.
+  std::size_t free_bytes{0};
+  /// \brief The number of free extents in the slabs.
+  std::size_t num_free_extents{0};
+};
+
+/// \brief The size of a named object.
+struct named_object_statistics {
+  std::string name;
+  /// \brief The number of bytes allocated to the object.
+  std::size_t bytes{0};
+};
+
+/// \brief Memory usage of a Metall data store.
+struct memory_statistics {
+  /// \brief The chunk size in byte.
+  std::size_t chunk_size{0};
+  /// \brief The number of chunks in use.
+  std::size_t num_used_chunks{0};
+  /// \brief The number of bytes allocated to objects, excluding cached
+  /// objects.
+  std::size_t allocated_bytes{0};
+  /// \brief The number of bytes of the objects in the object cache.
+  std::size_t cached_bytes{0};
+  /// \brief The number of bytes of the segment backed by files.
+  std::size_t segment_size{0};
+  /// \brief The number of bytes of the segment resident in memory.
+  /// 0 if it was not requested.
+  std::size_t resident_bytes{0};
+  /// \brief Statistics of the bins that have at least one chunk.
+  std::vector<bin_statistics> bins;
+  /// \brief Statistics of the medium objects.
+  medium_object_statistics medium_objects;
+  /// \brief Statistics of the named objects, if requested.
+  std::vector<named_object_statistics> named_objects;
+
+  /// \brief Returns the statistics as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{\"chunk_size\":" << chunk_size
+       << ",\"num_used_chunks\":" << num_used_chunks
+       << ",\"allocated_bytes\":" << allocated_bytes
+       << ",\"cached_bytes\":" << cached_bytes
+       << ",\"segment_size\":" << segment_size
+       << ",\"resident_bytes\":" << resident_bytes << ",\"bins\":[";
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+      const auto &bin = bins[i];
+      if (i > 0) ss << ",";
+      ss << "{\"bin_no\":" << bin.bin_no
+         << ",\"object_size\":" << bin.object_size
+         << ",\"num_chunks\":" << bin.num_chunks
+         << ",\"num_non_full_chunks\":" << bin.num_non_full_chunks
+         << ",\"num_objects\":" << bin.num_objects
+         << ",\"num_cached_objects\":" << bin.num_cached_objects
+         << ",\"allocated_bytes\":" << bin.allocated_bytes
+         << ",\"free_bytes\":" << bin.free_bytes
+         << ",\"fragmentation\":" << bin.fragmentation() << "}";
+    }
+    ss << "],\"medium_objects\":{\"num_slabs\":" << medium_objects.num_slabs
+       << ",\"num_chunks\":" << medium_objects.num_chunks
+       << ",\"num_objects\":" << medium_objects.num_objects
+       << ",\"allocated_bytes\":" << medium_objects.allocated_bytes
+       << ",\"free_bytes\":" << medium_objects.free_bytes
+       << ",\"num_free_extents\":" << medium_objects.num_free_extents << "}";
+    ss << ",\"named_objects\":[";
+    for (std::size_t i = 0; i < named_objects.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"name\":";
+      priv_write_json_string(named_objects[i].name, ss);
+      ss << ",\"bytes\":" << named_objects[i].bytes << "}";
+    }
+    ss << "]}";
+    return ss.str();
+  }
+
+ private:
+  static void priv_write_json_string(const std::string &str,
+                                     std::stringstream &ss) {
+    ss << '"';
+    for (const char c : str) {
+      if (c == '"' || c == '\\') {
+        ss << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        ss << buf;
+      } else {
+        ss << c;
+      }
+    }
+    ss << '"';
+  }
+};
+
+/// \brief Allocation counters of a bin.
+struct bin_counters {
+  /// \brief The bin number.
+  std::size_t bin_no{0};
+  /// \brief The size of an object in the bin in byte.
+  std::size_t object_size{0};
+  /// \brief The number of chunks holding the objects of the bin.
+  /// The chunks of the medium object slabs are counted in the bin of the
+  /// slab size.
+  std::size_t num_chunks{0};
+  /// \brief The number of allocated objects, excluding cached objects.
+  std::size_t num_objects{0};
+};
+
+/// \brief Allocation counters of a Metall data store.
+/// Unlike memory_statistics, the counters are maintained on allocations and
+/// deallocations; thus, they are read without scanning the data store.
+struct memory_counters {
+  /// \brief The chunk size in byte.
+  std::size_t chunk_size{0};
+  /// \brief The number of allocated objects, excluding cached objects,
+  /// including medium objects.
+  std::size_t num_objects{0};
+  /// \brief The number of bytes allocated to objects, excluding cached
+  /// objects, including medium objects.
+  std::size_t allocated_bytes{0};
+  /// \brief The number of chunks in use.
+  std::size_t num_used_chunks{0};
+  /// \brief The number of allocated medium objects.
+  std::size_t num_medium_objects{0};
+  /// \brief The number of bytes allocated to medium objects.
+  std::size_t medium_allocated_bytes{0};
+  /// \brief The number of bytes whose pages have been given back to the
+  /// system since the data store was created or opened.
+  std::size_t freed_bytes{0};
+  /// \brief Counters of the bins that have at least one chunk or object.
+  std::vector<bin_counters> bins;
+
+  /// \brief Returns the counters as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{\"chunk_size\":" << chunk_size << ",\"num_objects\":" << num_objects
+       << ",\"allocated_bytes\":" << allocated_bytes
+       << ",\"num_used_chunks\":" << num_used_chunks
+       << ",\"num_medium_objects\":" << num_medium_objects
+       << ",\"medium_allocated_bytes\":" << medium_allocated_bytes
+       << ",\"freed_bytes\":" << freed_bytes << ",\"bins\":[";
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"bin_no\":" << bins[i].bin_no
+         << ",\"object_size\":" << bins[i].object_size
+         << ",\"num_chunks\":" << bins[i].num_chunks
+         << ",\"num_objects\":" << bins[i].num_objects << "}";
+    }
+    ss << "]}";
+    return ss.str();
+  }
+};
+
+/// \brief The access heat of the used chunks, i.e., how many of them have
+/// been accessed in the recent access samples.
+struct chunk_heat_statistics {
+  /// \brief The chunk size in byte.
+  std::size_t chunk_size{0};
+  /// \brief The number of access samples recorded since the data store was
+  /// opened.
+  std::size_t num_samples{0};
+  /// \brief The number of chunks in use.
+  std::size_t num_used_chunks{0};
+  /// \brief The number of chunks accessed in the latest sample.
+  std::size_t num_hot_chunks{0};
+  /// \brief The number of chunks not accessed in the latest sample but in
+  /// one of the 7 samples before it.
+  std::size_t num_warm_chunks{0};
+  /// \brief The number of chunks not accessed in the last 8 samples.
+  std::size_t num_cold_chunks{0};
+
+  /// \brief Returns the fraction of the used chunks that are hot.
+  /// Returns 0 if no chunk is used.
+  double hot_fraction() const noexcept {
+    return (num_used_chunks == 0)
+               ? 0.0
+               : static_cast<double>(num_hot_chunks) / num_used_chunks;
+  }
+
+  /// \brief Returns the statistics as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{\"chunk_size\":" << chunk_size
+       << ",\"num_samples\":" << num_samples
+       << ",\"num_used_chunks\":" << num_used_chunks
+       << ",\"num_hot_chunks\":" << num_hot_chunks
+       << ",\"num_warm_chunks\":" << num_warm_chunks
+       << ",\"num_cold_chunks\":" << num_cold_chunks << "}";
+    return ss.str();
+  }
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_MEMORY_STATISTICS_HPP
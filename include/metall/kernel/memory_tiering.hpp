@@ -0,0 +1,200 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_MEMORY_TIERING_HPP
+#define METALL_KERNEL_MEMORY_TIERING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <metall/detail/memory.hpp>
+#include <metall/detail/page_idle.hpp>
+#include <metall/detail/soft_dirty_page.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A policy to move the cold chunks of a segment to a far memory
+/// tier, e.g., CXL-attached memory that appears as a NUMA node without CPUs.
+struct memory_tiering_policy {
+  /// \brief The NUMA node of the far memory tier. If negative, the first
+  /// allowed node without CPUs.
+  int far_node{-1};
+  /// \brief If not negative, the chunks on the far tier accessed since the
+  /// previous sample are moved back to this node.
+  int near_node{-1};
+  /// \brief A chunk is cold if it has not been accessed in this number of
+  /// consecutive samples.
+  std::size_t num_cold_samples{2};
+  /// \brief The maximum number of bytes to move per call. If 0, unlimited.
+  std::size_t max_migration_bytes{0};
+};
+
+/// \brief How the accesses to the chunks are sampled.
+enum class access_sampling_source {
+  /// \brief Not available.
+  none,
+  /// \brief The idle page tracking, which finds reads and writes.
+  page_idle,
+  /// \brief The soft-dirty bits, which find only writes; chunks only read
+  /// are taken as cold.
+  soft_dirty
+};
+
+/// \brief The result of a memory tiering pass.
+struct memory_tiering_result {
+  access_sampling_source source{access_sampling_source::none};
+  /// \brief The number of used chunks sampled.
+  std::size_t num_sampled_chunks{0};
+  /// \brief The number of the chunks moved to the far tier.
+  std::size_t num_demoted_chunks{0};
+  /// \brief The number of the chunks moved back from the far tier.
+  std::size_t num_promoted_chunks{0};
+  /// \brief The number of the used chunks on the far tier after the pass.
+  std::size_t num_far_chunks{0};
+};
+
+/// \brief Samples the chunks of a segment accessed between two calls of
+/// sample(), using the idle page tracking if available or the soft-dirty
+/// bits otherwise, and keeps the number of consecutive samples without
+/// accesses and the tier of each chunk.
+/// This class is not thread-safe.
+class chunk_access_sampler {
+ public:
+  /// \brief Samples the accesses since the previous call.
+  /// The first call only starts sampling.
+  /// \param segment The beginning of the segment. Must be page aligned.
+  /// \param num_chunks The number of chunks to sample.
+  /// \param chunk_size The chunk size, a multiple of the page size.
+  /// \return Returns false if no source is available or on error.
+  bool sample(const void *const segment, const std::size_t num_chunks,
+              const std::size_t chunk_size) {
+    const auto page_size = mdtl::get_page_size();
+    if (page_size <= 0) return false;
+    m_page_size = page_size;
+    m_chunk_size = chunk_size;
+    const auto num_pages = num_chunks * (chunk_size / m_page_size);
+
+    if (m_source == access_sampling_source::none) {
+      if (m_idle_tracker.good() &&
+          m_idle_tracker.mark_idle(segment, num_pages, m_page_size)) {
+        m_source = access_sampling_source::page_idle;
+      } else if (mdtl::soft_dirty_bit_supported()) {
+        m_source = access_sampling_source::soft_dirty;
+        m_dirty_tracker = std::make_unique<mdtl::soft_dirty_page_tracker>();
+        // Forgets the pages written before
+        m_dirty_tracker->track(segment, num_chunks * chunk_size, m_page_size);
+        if (!m_dirty_tracker->collect()) return false;
+        m_dirty_tracker->take_dirty_ranges([](auto, auto) {});
+      } else {
+        return false;
+      }
+      m_idle_samples.assign(num_chunks, 0);
+      m_far.assign(num_chunks, false);
+      m_accessed.clear();
+      return true;
+    }
+
+    // The chunks added to the segment are taken as accessed
+    const auto num_old_chunks = m_idle_samples.size();
+    m_idle_samples.resize(num_chunks, 0);
+    m_far.resize(num_chunks, false);
+    std::vector<bool> accessed(num_chunks, false);
+    if (m_source == access_sampling_source::page_idle) {
+      std::vector<bool> accessed_pages;
+      if (!m_idle_tracker.read_accessed(segment, num_pages, m_page_size,
+                                        &accessed_pages) ||
+          !m_idle_tracker.mark_idle(segment, num_pages, m_page_size)) {
+        return false;
+      }
+      const auto pages_per_chunk = chunk_size / m_page_size;
+      for (std::size_t p = 0; p < num_pages; ++p) {
+        if (accessed_pages[p]) accessed[p / pages_per_chunk] = true;
+      }
+    } else {
+      m_dirty_tracker->track(segment, num_chunks * chunk_size, m_page_size);
+      if (!m_dirty_tracker->collect()) return false;
+      m_dirty_tracker->take_dirty_ranges(
+          [&](const std::size_t offset, const std::size_t length) {
+            for (auto c = offset / chunk_size;
+                 c < num_chunks && c * chunk_size < offset + length; ++c) {
+              accessed[c] = true;
+            }
+          });
+    }
+
+    for (std::size_t c = num_old_chunks; c < num_chunks; ++c) {
+      accessed[c] = true;
+    }
+    for (std::size_t c = 0; c < num_chunks; ++c) {
+      if (accessed[c]) {
+        m_idle_samples[c] = 0;
+      } else if (m_idle_samples[c] < std::numeric_limits<uint16_t>::max()) {
+        ++m_idle_samples[c];
+      }
+    }
+    m_accessed = std::move(accessed);
+    ++m_num_samples;
+    return true;
+  }
+
+  /// \brief Tells that the pages of a chunk have been moved so that the new
+  /// pages are not taken as accessed at the next sample.
+  void moved(const void *const segment, const std::size_t chunk_no) {
+    if (m_source != access_sampling_source::page_idle) return;
+    m_idle_tracker.mark_idle(
+        static_cast<const char *>(segment) + chunk_no * m_chunk_size,
+        m_chunk_size / m_page_size, m_page_size);
+  }
+
+  /// \brief Returns the number of the consecutive samples in which a chunk
+  /// has not been accessed.
+  std::size_t num_idle_samples(const std::size_t chunk_no) const {
+    return chunk_no < m_idle_samples.size() ? m_idle_samples[chunk_no] : 0;
+  }
+
+  /// \brief Returns true if a chunk has been accessed between the latest
+  /// sample and the one before it.
+  bool accessed(const std::size_t chunk_no) const {
+    return chunk_no < m_accessed.size() && m_accessed[chunk_no];
+  }
+
+  /// \brief Returns the number of samples taken, excluding the first call of
+  /// sample(), which only starts sampling.
+  std::size_t num_samples() const { return m_num_samples; }
+
+  /// \brief Returns true if a chunk is on the far tier.
+  bool far(const std::size_t chunk_no) const {
+    return chunk_no < m_far.size() && m_far[chunk_no];
+  }
+
+  void set_far(const std::size_t chunk_no, const bool far) {
+    if (chunk_no < m_far.size()) m_far[chunk_no] = far;
+  }
+
+  access_sampling_source source() const { return m_source; }
+
+ private:
+  access_sampling_source m_source{access_sampling_source::none};
+  std::size_t m_page_size{0};
+  std::size_t m_chunk_size{0};
+  mdtl::page_idle_tracker m_idle_tracker;
+  std::unique_ptr<mdtl::soft_dirty_page_tracker> m_dirty_tracker{nullptr};
+  std::vector<uint16_t> m_idle_samples;
+  std::vector<bool> m_far;
+  std::vector<bool> m_accessed;
+  std::size_t m_num_samples{0};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_MEMORY_TIERING_HPP
@@ -153,6 +153,30 @@ class multilayer_bitset {
     return false;
   }
 
+  /// \brief Uses blocks given by the caller, e.g., taken from
+  /// slot_bitmap_pool, instead of allocating them.
+  /// \param size The number of bits this bitset holds.
+  /// \param blocks num_blocks(size) zero-filled blocks. Not used if 'size' is
+  /// not larger than block_size().
+  void assign(const std::size_t size, uint64_t *const blocks) {
+    if (size <= block_size()) {
+      bs::erase(&m_data.block);
+    } else {
+      assert(blocks);
+      m_data.array = blocks;
+    }
+  }
+
+  /// \brief Resets the bitset and returns the blocks given by assign().
+  /// \param size The number of bits this bitset holds.
+  /// \return The blocks given by assign(); nullptr if 'size' is not larger
+  /// than block_size().
+  uint64_t *release(const std::size_t size) {
+    uint64_t *const blocks = (block_size() < size) ? m_data.array : nullptr;
+    m_data.reset();
+    return blocks;
+  }
+
   /// \brief Users have to explicitly free bitset table
   /// \param size The number of bits this bitset holds.
   void free(const std::size_t size) {
@@ -171,6 +195,20 @@ class multilayer_bitset {
       return find_and_set_in_multilayers(size);
   }
 
+  /// \brief Finds a bit whose value is false and sets the bit to true using
+  /// atomic operations. Multiple threads can call this function concurrently
+  /// as long as no thread resets bits at the same time.
+  /// \param size The number of bits to this bitset holds.
+  /// \return The position of the found bit
+  /// \warning Users must make sure that each concurrent caller has an
+  /// available bit, e.g., by reserving bits using a counter in advance.
+  bit_position_type find_and_set_concurrently(const std::size_t size) {
+    if (size <= block_size())
+      return find_and_set_in_single_block_concurrently();
+    else
+      return find_and_set_in_multilayers_concurrently(size);
+  }
+
   /// \brief Find multiple number of false bits and set them to true.
   /// \param size The number of bits this bitset holds.
   /// \param num_bits_to_find The number of bits to find.
@@ -211,6 +249,29 @@ class multilayer_bitset {
     }
   }
 
+  /// \brief Counts the true bits.
+  /// \param size The number of bits this bitset holds.
+  /// \return The number of true bits.
+  std::size_t count(const std::size_t size) const {
+    const block_type *blocks = &m_data.block;
+    if (size > block_size()) {
+      const std::size_t idx = mdtl::log2_dynamic(mdtl::next_power_of_2(size));
+      assert(idx < mlbs::k_num_index_blocks_table.size());
+      blocks = &m_data.array[mlbs::k_num_index_blocks_table[idx]];
+    }
+    std::size_t num_bits = 0;
+    for (std::size_t i = 0; i * block_size() < size; ++i) {
+      block_type block = blocks[i];
+      // The bits are used from the most significant bit side
+      const std::size_t num_remains = size - i * block_size();
+      if (num_remains < block_size()) {
+        block &= ~(~block_type(0) >> num_remains);
+      }
+      num_bits += mdtl::popcountll(block);
+    }
+    return num_bits;
+  }
+
   /// \brief Serializes the internal data.
   /// \param size The number of bits this bitset holds.
   /// \return Serialized data as std::string.
@@ -256,6 +317,37 @@ class multilayer_bitset {
     return true;
   }
 
+  /// \brief Returns the number of 64-bit blocks the raw representation of
+  /// the bitset has.
+  /// \param size The number of bits this bitset holds.
+  /// \return The number of blocks.
+  static std::size_t num_blocks(const std::size_t size) {
+    return (size <= block_size()) ? 1 : num_all_blocks(size);
+  }
+
+  /// \brief Copies the raw representation of the bitset into a buffer.
+  /// \param size The number of bits this bitset holds.
+  /// \param buf A buffer that can hold at least num_blocks(size) elements.
+  void serialize(const std::size_t size, uint64_t *const buf) const {
+    if (size <= block_size()) {
+      buf[0] = m_data.block;
+    } else {
+      std::copy_n(m_data.array, num_all_blocks(size), buf);
+    }
+  }
+
+  /// \brief Restores the bitset from a raw representation.
+  /// The bitset must have been allocated with 'size'.
+  /// \param size The number of bits this bitset holds.
+  /// \param buf A buffer that holds num_blocks(size) elements.
+  void deserialize(const std::size_t size, const uint64_t *const buf) {
+    if (size <= block_size()) {
+      m_data.block = buf[0];
+    } else {
+      std::copy_n(buf, num_all_blocks(size), m_data.array);
+    }
+  }
+
  private:
   // -------------------- //
   // Private methods
@@ -293,11 +385,10 @@ class multilayer_bitset {
       const std::size_t num_bits_to_find,
       bit_position_type *const bit_positions) {
     assert(!bs::full_block(m_data.block));
-    for (std::size_t i = 0; i < num_bits_to_find; ++i) {
-      bit_positions[i] = find_first_false_bit_in_block(m_data.block);
-      assert(bit_positions[i] < block_size());
-      bs::set(&m_data.block, bit_positions[i]);
-    }
+    [[maybe_unused]] const auto n =
+        claim_false_bits_in_block(&m_data.block, 0, num_bits_to_find,
+                                  bit_positions);
+    assert(n == num_bits_to_find);
   }
 
   bit_position_type find_and_set_in_multilayers(const std::size_t size) {
@@ -316,8 +407,91 @@ class multilayer_bitset {
     return bit_pos_in_leaf_layer;
   }
 
-  /// \brief Finds a consecutive false bits and set them to full.
-  /// Return The first bit position of the found chunk and the number of bits.
+  bit_position_type find_and_set_in_single_block_concurrently() {
+    block_type block = mdtl::atomic_load(&m_data.block);
+    while (true) {
+      assert(!bs::full_block(block));
+      const auto pos = find_first_false_bit_in_block(block);
+      assert(pos < block_size());
+      if (mdtl::atomic_compare_exchange(&m_data.block, &block,
+                                        block | bit_mask(pos))) {
+        return pos;
+      }
+    }
+  }
+
+  /// \brief Lock-free version of find_and_set_in_multilayers().
+  /// As bits are never reset while this function runs, a set bit in an index
+  /// block always means that the child block is full. On the other hand,
+  /// an index bit can still be false for a moment after the child block
+  /// becomes full; in that case, this function just retries.
+  bit_position_type find_and_set_in_multilayers_concurrently(
+      const std::size_t size) {
+    const std::size_t idx = mdtl::log2_dynamic(mdtl::next_power_of_2(size));
+    assert(idx < mlbs::k_num_layers_table.size());
+    assert(idx < mlbs::k_num_blocks_table.size());
+    assert(idx < mlbs::k_num_index_blocks_table.size());
+    const std::size_t num_layers = mlbs::k_num_layers_table[idx];
+    const auto &num_blocks = mlbs::k_num_blocks_table[idx];
+
+    while (true) {
+      bit_position_type bit_pos = 0;
+      std::size_t block_pos = 0;
+      block_type block = 0;
+      std::size_t num_parent_blocks = 0;
+      bool index_not_updated = false;
+      for (int layer = 0; layer < static_cast<int>(num_layers); ++layer) {
+        num_parent_blocks += (layer == 0) ? 0 : num_blocks[layer - 1];
+        block_pos = num_parent_blocks + bit_pos;
+        block = mdtl::atomic_load(&m_data.array[block_pos]);
+        if (bs::full_block(block)) {
+          index_not_updated = true;
+          break;
+        }
+        bit_pos = find_first_false_bit_in_block(block) +
+                  block_size() * (block_pos - num_parent_blocks);
+      }
+      if (index_not_updated) continue;
+
+      const block_type new_block =
+          block | bit_mask(bs::local_index<block_type>(bit_pos));
+      if (!mdtl::atomic_compare_exchange(&m_data.array[block_pos], &block,
+                                         new_block)) {
+        continue;
+      }
+      if (bs::full_block(new_block)) {
+        set_full_in_index_concurrently(num_layers,
+                                       mlbs::k_num_index_blocks_table[idx],
+                                       num_blocks, bit_pos / block_size());
+      }
+      assert(bit_pos < size);
+      return bit_pos;
+    }
+  }
+
+  /// \brief Marks a full leaf block as full in the index blocks using atomic
+  /// operations.
+  template <std::size_t N>
+  void set_full_in_index_concurrently(
+      const std::size_t num_layers, const std::size_t num_index_blocks,
+      const std::array<std::size_t, N> &num_blocks_table,
+      const std::size_t block_pos_in_leaf) {
+    std::size_t num_parent_blocks = num_index_blocks;
+    bit_position_type bit_pos = block_pos_in_leaf;
+    for (int layer = static_cast<int>(num_layers) - 2; layer >= 0; --layer) {
+      num_parent_blocks -= num_blocks_table[layer];
+      const std::size_t block_pos = num_parent_blocks + bit_pos / block_size();
+      const block_type mask = bit_mask(bs::local_index<block_type>(bit_pos));
+      const block_type old =
+          mdtl::atomic_fetch_or(&m_data.array[block_pos], mask);
+      if (!bs::full_block(static_cast<block_type>(old | mask))) break;
+      bit_pos = bit_pos / block_size();
+    }
+  }
+
+  /// \brief Finds false bits and sets them to true, taking as many bits as
+  /// possible from each leaf block at once.
+  /// The index blocks are updated once per leaf block that becomes full.
   void find_and_set_many_in_multilayers(
       const std::size_t size, const std::size_t num_requested_bits,
       bit_position_type *const found_bit_positions) {
@@ -327,53 +501,22 @@ class multilayer_bitset {
     assert(idx < mlbs::k_num_blocks_table.size());
     assert(idx < mlbs::k_num_index_blocks_table.size());
 
-    auto bit_pos_in_leaf = find_in_multilayers(mlbs::k_num_layers_table[idx],
-                                               mlbs::k_num_blocks_table[idx]);
-    assert(bit_pos_in_leaf < size);
-
+    const std::size_t num_index_blocks = mlbs::k_num_index_blocks_table[idx];
     std::size_t count = 0;
-    while (true) {
+    while (count < num_requested_bits) {
+      const auto bit_pos_in_leaf = find_in_multilayers(
+          mlbs::k_num_layers_table[idx], mlbs::k_num_blocks_table[idx]);
+      assert(bit_pos_in_leaf < size);
       const auto block_pos_in_leaf = bit_pos_in_leaf / block_size();
-      const auto global_block_pos =
-          block_pos_in_leaf + mlbs::k_num_index_blocks_table[idx];
-
-      if (bs::empty_block(m_data.array[global_block_pos])) {
-        const auto n = std::min(num_requested_bits - count, block_size());
-        for (std::size_t i = 0; i < n; ++i, ++count, ++bit_pos_in_leaf) {
-          found_bit_positions[count] = bit_pos_in_leaf;
-        }
-        m_data.array[global_block_pos] |= bs::generate_mask<block_size()>(0, n);
-        ;
-        set_in_multilayers(mlbs::k_num_layers_table[idx],
-                           mlbs::k_num_index_blocks_table[idx],
-                           mlbs::k_num_blocks_table[idx], bit_pos_in_leaf - 1);
-        if (count == num_requested_bits) return;
-      } else {
-        for (auto i = bit_pos_in_leaf % block_size(); i < block_size();
-             ++i, ++bit_pos_in_leaf) {
-          assert(bit_pos_in_leaf < size);
-          if (bs::get(&m_data.array[global_block_pos], i)) continue;
-
-          found_bit_positions[count] = bit_pos_in_leaf;
-          ++count;
-          set_in_multilayers(mlbs::k_num_layers_table[idx],
-                             mlbs::k_num_index_blocks_table[idx],
-                             mlbs::k_num_blocks_table[idx], bit_pos_in_leaf);
-          if (count == num_requested_bits) return;
-        }
-      }
-
-      if (bs::full_block(
-              m_data.array[global_block_pos + 1])) {  // Is next block is full?
-        bit_pos_in_leaf = find_in_multilayers(mlbs::k_num_layers_table[idx],
-                                              mlbs::k_num_blocks_table[idx]);
-      } else {
-        // Find next available bit in the next block
-        const auto bit_pos_in_block =
-            find_first_false_bit_in_block(m_data.array[global_block_pos + 1]);
-        bit_pos_in_leaf =
-            (block_pos_in_leaf + 1) * block_size() + bit_pos_in_block;
-        assert(bit_pos_in_leaf < size);
+      auto *const block = &m_data.array[num_index_blocks + block_pos_in_leaf];
+
+      count += claim_false_bits_in_block(
+          block, block_pos_in_leaf * block_size(), num_requested_bits - count,
+          &found_bit_positions[count]);
+      if (bs::full_block(*block)) {
+        // Propagates the full leaf block to the index blocks
+        set_in_multilayers(mlbs::k_num_layers_table[idx], num_index_blocks,
+                           mlbs::k_num_blocks_table[idx], bit_pos_in_leaf);
       }
     }
   }
@@ -475,7 +618,39 @@ class multilayer_bitset {
     return bs::empty_block(block) ? 0 : mdtl::clzll(~block);
   }
 
-  std::size_t num_all_blocks(const std::size_t size) const {
+  /// \brief Sets up to 'max_num_bits' false bits in a block to true, from the
+  /// most significant bit side, with a single write to the block.
+  /// \param block A block to take bits from.
+  /// \param offset The bit position of the block, added to the positions
+  /// stored in 'bit_positions'.
+  /// \param max_num_bits The maximum number of bits to take.
+  /// \param bit_positions A buffer to store the positions of the taken bits.
+  /// \return The number of taken bits.
+  static std::size_t claim_false_bits_in_block(
+      block_type *const block, const bit_position_type offset,
+      const std::size_t max_num_bits,
+      bit_position_type *const bit_positions) noexcept {
+    block_type free_bits = ~*block;
+    const std::size_t n = std::min<std::size_t>(
+        mdtl::popcountll(free_bits), max_num_bits);
+    block_type claimed = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      // The first (most significant) false bit
+      const auto pos = static_cast<std::size_t>(mdtl::clzll(free_bits));
+      bit_positions[i] = offset + pos;
+      free_bits &= ~bit_mask(pos);
+      claimed |= bit_mask(pos);
+    }
+    *block |= claimed;
+    return n;
+  }
+
+  /// \brief Returns a mask to access a bit in a block.
+  static constexpr block_type bit_mask(const std::size_t pos) noexcept {
+    return static_cast<block_type>(1ULL << (block_size() - 1 - pos));
+  }
+
+  static std::size_t num_all_blocks(const std::size_t size) {
     const std::size_t idx = mdtl::log2_dynamic(mdtl::next_power_of_2(size));
     std::size_t num_blocks = 0;
     assert(idx < mlbs::k_num_layers_table.size());
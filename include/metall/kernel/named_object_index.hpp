@@ -0,0 +1,243 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_NAMED_OBJECT_INDEX_HPP
+#define METALL_KERNEL_NAMED_OBJECT_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/detail/mmap.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief A read-only name-to-object index stored in a file.
+/// The file is mapped with MAP_SHARED; thus, the processes that open the same
+/// datastore share one copy of the index in the page cache and can find
+/// objects without building the object directories in their own memory.
+/// The entries are sorted by the hash values of the names, which are searched
+/// by a binary search.
+class named_object_index {
+ public:
+  using offset_type = int64_t;
+  using size_type = std::size_t;
+
+  named_object_index() noexcept = default;
+  ~named_object_index() noexcept { close(); }
+
+  named_object_index(const named_object_index &) = delete;
+  named_object_index &operator=(const named_object_index &) = delete;
+
+  named_object_index(named_object_index &&other) noexcept
+      : m_fd(other.m_fd),
+        m_image(other.m_image),
+        m_image_size(other.m_image_size) {
+    other.m_fd = -1;
+    other.m_image = nullptr;
+    other.m_image_size = 0;
+  }
+
+  named_object_index &operator=(named_object_index &&other) noexcept {
+    if (this != &other) {
+      close();
+      std::swap(m_fd, other.m_fd);
+      std::swap(m_image, other.m_image);
+      std::swap(m_image_size, other.m_image_size);
+    }
+    return *this;
+  }
+
+  /// \brief Writes an index of the objects in 'directory', an
+  /// attributed_object_directory, to 'path'.
+  /// \return Returns true on success; otherwise, false and no file is left.
+  template <typename directory_type>
+  static bool write(const fs::path &path, const directory_type &directory) {
+    header_type header;
+    std::copy_n(k_magic, sizeof(header.magic), header.magic);
+    header.num_entries = directory.size();
+    header.num_string_bytes = 0;
+
+    std::vector<entry_type> entries;
+    entries.reserve(header.num_entries);
+    for (const auto &item : directory) {
+      entries.push_back(entry_type{
+          priv_hash(item.name()), static_cast<offset_type>(item.offset()),
+          static_cast<uint64_t>(item.length()), header.num_string_bytes,
+          item.name().size()});
+      header.num_string_bytes += item.name().size();
+    }
+
+    std::string strings;
+    strings.reserve(header.num_string_bytes);
+    for (const auto &item : directory) strings += item.name();
+
+    std::sort(entries.begin(), entries.end(),
+              [&strings](const entry_type &lhs, const entry_type &rhs) {
+                return std::make_tuple(lhs.hash, priv_name(strings, lhs)) <
+                       std::make_tuple(rhs.hash, priv_name(strings, rhs));
+              });
+
+    {
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      if (ofs.is_open()) {
+        ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char *>(entries.data()),
+                  entries.size() * sizeof(entry_type));
+        ofs.write(strings.data(), strings.size());
+        ofs.close();
+        if (ofs) return true;
+      }
+    }
+
+    std::stringstream ss;
+    ss << "Failed to write a named object index: " << path;
+    logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    mdtl::remove_file(path);
+    return false;
+  }
+
+  /// \brief Maps an index file written by write().
+  /// \return Returns true on success.
+  bool open(const fs::path &path) {
+    close();
+
+    const ssize_t file_size = mdtl::get_file_size(path);
+    if (file_size < (ssize_t)sizeof(header_type)) return false;
+
+    const auto [fd, addr] =
+        mdtl::map_file_read_mode(path, nullptr, file_size, 0);
+    if (!addr) return false;
+    m_fd = fd;
+    m_image = static_cast<const char *>(addr);
+    m_image_size = file_size;
+
+    const auto &header = priv_header();
+    if (!std::equal(header.magic, header.magic + sizeof(header.magic),
+                    k_magic) ||
+        header.num_entries >
+            (m_image_size - sizeof(header_type)) / sizeof(entry_type) ||
+        m_image_size != sizeof(header_type) +
+                            header.num_entries * sizeof(entry_type) +
+                            header.num_string_bytes) {
+      std::stringstream ss;
+      ss << "Broken named object index: " << path;
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  ss.str().c_str());
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Unmaps the index.
+  void close() noexcept {
+    if (!m_image) return;
+    mdtl::munmap(m_fd, const_cast<char *>(m_image), m_image_size, false);
+    m_fd = -1;
+    m_image = nullptr;
+    m_image_size = 0;
+  }
+
+  bool is_open() const noexcept { return m_image != nullptr; }
+
+  /// \brief Returns the number of objects in the index.
+  size_type size() const noexcept {
+    return is_open() ? priv_header().num_entries : 0;
+  }
+
+  /// \brief Finds the object named 'name'.
+  /// \return Returns true if the object is found, storing its offset and
+  /// length to 'offset' and 'length'.
+  bool find(const std::string_view name, offset_type *const offset,
+            size_type *const length) const noexcept {
+    if (!is_open()) return false;
+
+    const uint64_t hash = priv_hash(name);
+    const entry_type *const first = priv_entries();
+    const entry_type *const last = first + priv_header().num_entries;
+    const entry_type *itr = std::lower_bound(
+        first, last, hash,
+        [](const entry_type &e, const uint64_t h) { return e.hash < h; });
+    for (; itr != last && itr->hash == hash; ++itr) {
+      if (priv_name(priv_strings(), *itr) == name) {
+        *offset = itr->offset;
+        *length = itr->length;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static constexpr char k_magic[8] = {'M', 'T', 'L', 'L',
+                                      'N', 'I', 'D', '1'};
+
+  struct header_type {
+    char magic[8];
+    uint64_t num_entries;
+    uint64_t num_string_bytes;
+  };
+
+  struct entry_type {
+    uint64_t hash;
+    offset_type offset;
+    uint64_t length;
+    uint64_t name_pos;  // The position in the string area
+    uint64_t name_size;
+  };
+  static_assert(sizeof(entry_type) == 40,
+                "The index file layout depends on the entry size");
+
+  static uint64_t priv_hash(const std::string_view name) noexcept {
+    return mdtl::murmur_hash_64a(name.data(), name.size(), 123);
+  }
+
+  static std::string_view priv_name(const std::string_view strings,
+                                    const entry_type &entry) noexcept {
+    if (entry.name_pos > strings.size()) return {};  // Broken entry
+    return strings.substr(entry.name_pos, entry.name_size);
+  }
+
+  const header_type &priv_header() const noexcept {
+    return *reinterpret_cast<const header_type *>(m_image);
+  }
+
+  const entry_type *priv_entries() const noexcept {
+    return reinterpret_cast<const entry_type *>(m_image +
+                                                sizeof(header_type));
+  }
+
+  std::string_view priv_strings() const noexcept {
+    const auto &header = priv_header();
+    return std::string_view(m_image + sizeof(header_type) +
+                                header.num_entries * sizeof(entry_type),
+                            header.num_string_bytes);
+  }
+
+  int m_fd{-1};
+  const char *m_image{nullptr};
+  size_type m_image_size{0};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_NAMED_OBJECT_INDEX_HPP
@@ -14,9 +14,13 @@
 #include <memory>
 #include <sstream>
 #include <limits>
+#include <cstdlib>
+#include <string>
 
 #include <metall/detail/proc.hpp>
 #include <metall/detail/hash.hpp>
+#include <metall/tracing.hpp>
+#include <metall/kernel/concurrency_policy.hpp>
 
 #ifndef METALL_DISABLE_CONCURRENCY
 #define METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
@@ -25,6 +29,21 @@
 #include <metall/detail/mutex.hpp>
 #endif
 
+#if defined(METALL_ENABLE_MUTEX_IN_OBJECT_CACHE) && \
+    defined(METALL_USE_LOCK_FREE_OBJECT_CACHE)
+#define METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+#include <atomic>
+#endif
+
+#if defined(METALL_ENABLE_MUTEX_IN_OBJECT_CACHE) && \
+    defined(METALL_USE_THREAD_LOCAL_OBJECT_CACHE)
+#define METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#endif
+
 // #define METALL_OBJECT_CACHE_HEAVY_DEBUG
 #ifdef METALL_OBJECT_CACHE_HEAVY_DEBUG
 #warning "METALL_OBJECT_CACHE_HEAVY_DEBUG is defined"
@@ -98,6 +117,8 @@ struct cache_block {
 /// and the number of objects in the active block.
 /// Inserting and removing objects are done only to the active block. Non-active
 /// blocks are always full.
+/// It also holds the adaptive capacity of the bin, i.e., the maximum number of
+/// objects the bin can cache, which is adjusted by the cache at runtime.
 template <typename difference_type, typename bin_no_type>
 class bin_header {
  public:
@@ -134,10 +155,28 @@ class bin_header {
     return m_active_block;
   }
 
+  inline std::size_t &num_objects() noexcept { return m_num_objects; }
+
+  inline std::size_t num_objects() const noexcept { return m_num_objects; }
+
+  inline std::size_t &max_num_objects() noexcept { return m_max_num_objects; }
+
+  inline std::size_t max_num_objects() const noexcept {
+    return m_max_num_objects;
+  }
+
+  inline std::size_t &num_overflows() noexcept { return m_num_overflows; }
+
  private:
   // The number of objects in the active block
   std::size_t m_active_block_size{0};
   const cache_block_type *m_active_block{nullptr};
+  // The number of objects in all blocks of the bin
+  std::size_t m_num_objects{0};
+  // The capacity of the bin; 0 means that it has not been set yet
+  std::size_t m_max_num_objects{0};
+  // The number of overflows since the capacity is changed last time
+  std::size_t m_num_overflows{0};
 };
 
 /// A free blocks list contains a linked-list of free blocks.
@@ -196,6 +235,93 @@ class free_blocks_list {
   const cache_block_type *m_last_block;
 };
 
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+/// Lock-free slots of a bin in a cache.
+/// Each slot holds an object offset or 'k_empty'. Objects are put into and
+/// taken from the slots by CAS and exchange operations, i.e., the slots are
+/// accessed without any lock. As every slot is updated independently, there
+/// is no ABA problem. The slots of a bin fit in a cache line.
+template <typename difference_type>
+struct alignas(64) lock_free_slots {
+  static constexpr unsigned int k_num_slots = 64 / sizeof(difference_type);
+  static constexpr difference_type k_empty = -1;
+
+  lock_free_slots() noexcept {
+    for (auto &slot : slots) {
+      slot.store(k_empty, std::memory_order_relaxed);
+    }
+  }
+
+  /// Returns false if all slots are used.
+  bool push(const difference_type offset) noexcept {
+    assert(offset != k_empty);
+    for (auto &slot : slots) {
+      difference_type expected = k_empty;
+      if (slot.load(std::memory_order_relaxed) == k_empty &&
+          slot.compare_exchange_strong(expected, offset,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Returns 'k_empty' if there is no object.
+  difference_type pop() noexcept {
+    for (auto &slot : slots) {
+      if (slot.load(std::memory_order_relaxed) == k_empty) continue;
+      const auto offset = slot.exchange(k_empty, std::memory_order_acquire);
+      if (offset != k_empty) return offset;
+    }
+    return k_empty;
+  }
+
+  std::atomic<difference_type> slots[k_num_slots];
+};
+#endif
+
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+/// A thread-local magazine, i.e., tiny stacks of cached objects per bin, that
+/// a thread owns for an object cache.
+template <typename difference_type, std::size_t num_bins>
+struct thread_local_magazine {
+  static constexpr unsigned int k_depth =
+      METALL_THREAD_LOCAL_OBJECT_CACHE_DEPTH;
+
+  unsigned int num_objects[num_bins]{};
+  difference_type objects[num_bins][k_depth];
+};
+
+/// Tracks the magazines of the threads that use an object cache.
+/// This is shared by the object cache and those threads via shared_ptr so
+/// that either can go away first.
+template <typename magazine_type, typename bin_no_type,
+          typename difference_type>
+struct thread_local_magazine_registry {
+  mdtl::mutex mutex;
+  // False after the object cache is destroyed
+  bool cache_alive{true};
+  std::vector<magazine_type *> magazines;
+  // Objects left by exited threads
+  std::vector<std::pair<bin_no_type, difference_type>> orphans;
+};
+#endif
+
+/// Counters of the accesses to a cache.
+struct cache_access_counts {
+  /// The number of pop and push operations that took the cache lock, i.e.,
+  /// operations served by the lock-free slots are not counted.
+  std::size_t num_accesses{0};
+  /// The number of accesses made by threads that had migrated to another CPU
+  /// (or NUMA node) but had not noticed it yet, i.e., accesses that crossed
+  /// CPUs. This is an upper bound as a migration is detected only when a
+  /// thread refreshes its CPU number.
+  std::size_t num_cross_cpu_accesses{0};
+  /// The number of thread migrations detected.
+  std::size_t num_migrations{0};
+};
+
 /// A cache header contains some metadata of a single cache.
 /// Specifically, it contains the total size (byte) of objects in the cache,
 /// the pointers to the oldest and the newest blocks, and a free blocks list.
@@ -283,6 +409,7 @@ struct cache_container {
   // This data structure must be initialized first using this function.
   void init() {
     new (&header) cache_heaer_type(blocks, num_blocks_per_cache);
+    new (&access_counts) cache_access_counts();
     // Memo: The in-place an array construction may not be supported by some
     // compilers.
     for (std::size_t i = 0; i <= max_bin_no; ++i) {
@@ -292,15 +419,19 @@ struct cache_container {
   }
 
   // Reset data to the initial state
+  // The access counters are kept.
   void reset_headers() {
     std::destroy_at(&header);
     for (std::size_t i = 0; i <= max_bin_no; ++i) {
       std::destroy_at(&bin_headers[i]);
     }
+    const auto counts = access_counts;
     init();
+    access_counts = counts;
   }
 
   cache_heaer_type header;
+  cache_access_counts access_counts;
   bin_header_type bin_headers[max_bin_no + 1];
   cacbe_block_type blocks[num_blocks_per_cache];
 };
@@ -374,8 +505,19 @@ inline constexpr std::size_t comp_num_blocks_per_cache(
 /// cache push and pop objects using a LIFO policy. When the cache is full
 /// (exceeds a pre-defined threshold), it deallocates some oldest objects first
 /// before caching new ones.
+/// The capacity of each bin adapts to the workload in the same way as the
+/// per-thread free lists of TCMalloc: a bin starts with room for two refills,
+/// grows by one refill every time it runs out of objects (miss), and shrinks
+/// by one refill after it overflows several times without any miss. When a
+/// bin overflows, the newest objects of the bin—one refill worth—are
+/// deallocated. Thus, hot bins rarely go to the allocator, and cold bins do
+/// not pin memory. The total size is still capped by the per-CPU cache size.
+/// If METALL_USE_LOCK_FREE_OBJECT_CACHE is defined, each cache also has
+/// lock-free slots per bin, which are used before the LIFO part. The objects
+/// in the slots are not counted in the per-CPU cache size.
 template <typename _size_type, typename _difference_type,
-          typename _bin_no_manager, typename _object_allocator_type>
+          typename _bin_no_manager, typename _object_allocator_type,
+          typename _concurrency_policy = default_concurrency_policy>
 class object_cache {
  public:
   using size_type = _size_type;
@@ -387,14 +529,31 @@ class object_cache {
       const bin_no_type, const size_type, difference_type *const);
   using object_deallocate_func_type = void (object_allocator_type:: *const)(
       const bin_no_type, const size_type, const difference_type *const);
+  using access_counts_type = obcdetail::cache_access_counts;
+  using concurrency_policy = _concurrency_policy;
+
+  /// Policies to bind threads to caches.
+  /// The policy can be chosen at runtime using set_binding_policy() or the
+  /// environment variable METALL_OBJECT_CACHE_BINDING ("thread", "cpu", or
+  /// "numa"). If the CPU number is not available on the system, threads are
+  /// always bound by their thread IDs.
+  enum class binding_policy {
+    /// A thread keeps using the cache chosen by its thread ID.
+    per_thread,
+    /// A thread uses a cache of the CPU it runs on.
+    per_cpu,
+    /// Threads on the same NUMA node share the caches of the node.
+    per_numa_node
+  };
 
  private:
+  // If false, the cache is used by one thread at a time; thus, a single
+  // cache is used without the locks, lock-free slots, and thread-local
+  // magazines.
+  static constexpr bool k_thread_safe = concurrency_policy::k_thread_safe;
+
   static constexpr unsigned int k_num_caches_per_cpu =
-#ifdef METALL_DISABLE_CONCURRENCY
-      1;
-#else
-      METALL_NUM_CACHES_PER_CPU;
-#endif
+      k_thread_safe ? METALL_NUM_CACHES_PER_CPU : 1;
 
 #ifndef METALL_MAX_PER_CPU_CACHE_SIZE
 #error "METALL_MAX_PER_CPU_CACHE_SIZE=byte must be defined"
@@ -409,9 +568,16 @@ class object_cache {
   // such as the max per-CPU cache size.
   static constexpr size_type k_max_object_size = k_max_per_cpu_cache_size / 16;
 
-  // How long the CPU number is cached.
+  // How long the CPU number is cached, i.e., the CPU (NUMA node) number is
+  // refreshed every this number of cache accesses.
   static constexpr unsigned int k_cpu_no_cache_duration = 4;
 
+  // The number of overflows of a bin before its capacity is reduced.
+  static constexpr unsigned int k_max_num_overflows = 3;
+
+  static constexpr const char *k_binding_policy_env_name =
+      "METALL_OBJECT_CACHE_BINDING";
+
   static constexpr bin_no_type k_max_bin_no =
       obcdetail::comp_max_bin_no<difference_type, bin_no_manager>(
           k_max_per_cpu_cache_size, k_max_object_size);
@@ -423,34 +589,97 @@ class object_cache {
 #ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
   using mutex_type = mdtl::mutex;
   using lock_guard_type = mdtl::mutex_lock_guard;
+  // The lock of each cache
+  using cache_mutex_type = ccpdtl::mutex<concurrency_policy>;
+  using cache_lock_guard_type = std::lock_guard<cache_mutex_type>;
+#endif
+
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+  using lock_free_slots_type = obcdetail::lock_free_slots<difference_type>;
+#endif
+
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+  using magazine_type =
+      obcdetail::thread_local_magazine<difference_type, k_max_bin_no + 1>;
+  using magazine_registry_type =
+      obcdetail::thread_local_magazine_registry<magazine_type, bin_no_type,
+                                                difference_type>;
+  class magazine_registry_handle;
+  struct thread_local_magazine_holder;
 #endif
 
   using cache_storage_type =
       obcdetail::cache_container<difference_type, bin_no_type, k_max_bin_no,
                                  k_num_blocks_per_cache>;
   using cache_block_type = typename cache_storage_type::cacbe_block_type;
+  using bin_header_type = typename cache_storage_type::bin_header_type;
 
  public:
   class const_bin_iterator;
 
-  inline static constexpr size_type max_per_cpu_cache_size() noexcept {
-    return k_max_per_cpu_cache_size;
+  /// Returns the maximum size of a per-CPU cache given to the constructor.
+  size_type max_per_cpu_cache_size() const noexcept {
+    return m_max_per_cpu_cache_size;
   }
 
-  inline static constexpr size_type num_caches_per_cpu() noexcept {
-    return k_num_caches_per_cpu;
+  unsigned int num_caches_per_cpu() const noexcept {
+    return m_num_caches_per_cpu;
+  }
+
+  /// Returns the max bin number to cache, which depends on the maximum size
+  /// of a per-CPU cache.
+  bin_no_type max_bin_no() const noexcept { return m_max_bin_no; }
+
+  /// Returns the maximum number of objects a thread-local magazine keeps per
+  /// bin. Returns 0 if the thread-local magazines are disabled.
+  inline static constexpr size_type thread_local_cache_depth() noexcept {
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    return k_thread_safe ? magazine_type::k_depth : 0;
+#else
+    return 0;
+#endif
   }
 
-  inline static constexpr bin_no_type max_bin_no() noexcept {
-    return k_max_bin_no;
+  /// Returns the number of the lock-free slots per bin in a cache.
+  /// Returns 0 if the lock-free slots are disabled.
+  inline static constexpr size_type num_lock_free_slots() noexcept {
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+    return k_thread_safe ? lock_free_slots_type::k_num_slots : 0;
+#else
+    return 0;
+#endif
   }
 
-  explicit object_cache()
-      : m_num_caches(priv_get_num_cpus() * k_num_caches_per_cpu)
+  /// \param max_per_cpu_cache_size The maximum size of a per-CPU cache.
+  /// Capped at METALL_MAX_PER_CPU_CACHE_SIZE.
+  /// \param num_caches_per_cpu The number of caches per CPU.
+  /// Ignored if the concurrency policy is not thread-safe.
+  explicit object_cache(
+      const size_type max_per_cpu_cache_size = k_max_per_cpu_cache_size,
+      const unsigned int num_caches_per_cpu = k_num_caches_per_cpu)
+      : m_max_per_cpu_cache_size(
+            std::min(max_per_cpu_cache_size, k_max_per_cpu_cache_size)),
+        m_num_caches_per_cpu(k_thread_safe ? std::max(num_caches_per_cpu, 1U)
+                                           : 1U),
+        m_max_bin_no(std::min(
+            k_max_bin_no,
+            obcdetail::comp_max_bin_no<difference_type, bin_no_manager>(
+                m_max_per_cpu_cache_size, m_max_per_cpu_cache_size / 16))),
+        m_num_caches(k_thread_safe ? priv_get_num_cpus() * m_num_caches_per_cpu
+                                   : 1U),
+        m_binding_policy(priv_binding_policy_from_env())
 #ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
         ,
         m_mutex(m_num_caches)
 #endif
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+        ,
+        m_lock_free_slots(
+            std::make_unique<lock_free_slots_type[]>(m_num_caches *
+                                                     (k_max_bin_no + 1)))
+#endif
+        ,
+        m_num_accesses_at_trim(m_num_caches, 0)
   {
     priv_allocate_cache();
   }
@@ -485,9 +714,19 @@ class object_cache {
   /// Cached objects are going to be deallocated.
   void clear(object_allocator_type *const allocator_instance,
              object_deallocate_func_type deallocator_function) {
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    priv_clear_thread_local_magazines(allocator_instance, deallocator_function);
+#endif
     for (size_type c = 0; c < m_num_caches; ++c) {
       auto &cache = m_cache[c];
       for (bin_no_type b = 0; b <= k_max_bin_no; ++b) {
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+        auto &slots = priv_lock_free_slots(c, b);
+        for (auto offset = slots.pop(); offset != slots.k_empty;
+             offset = slots.pop()) {
+          (allocator_instance->*deallocator_function)(b, 1, &offset);
+        }
+#endif
         auto &bin_header = cache.bin_headers[b];
         cache_block_type *block = bin_header.active_block();
         size_type num_objects = bin_header.active_block_size();
@@ -495,6 +734,7 @@ class object_cache {
           if (num_objects > 0) {
             (allocator_instance->*deallocator_function)(b, num_objects,
                                                         block->cache);
+            METALL_TRACE(cache_flush, b, num_objects);
           }
           block = block->bin_older_block;
           num_objects = cache_block_type::k_capacity;
@@ -504,8 +744,151 @@ class object_cache {
     }
   }
 
+  /// Deallocates some of the objects in the caches that have not been
+  /// accessed since the previous call, at most one refill worth of objects
+  /// per bin. Calling this function periodically returns idle cached objects
+  /// gradually, without draining busy caches.
+  /// The objects in the lock-free slots and the objects in the thread-local
+  /// magazines of running threads are kept.
+  /// This function can be called while other threads access the cache if
+  /// METALL_ENABLE_MUTEX_IN_OBJECT_CACHE is defined.
+  /// \return The number of deallocated objects.
+  size_type trim(object_allocator_type *const allocator_instance,
+                 object_deallocate_func_type deallocator_function) {
+    size_type num_deallocated = 0;
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    num_deallocated +=
+        priv_release_orphans(allocator_instance, deallocator_function);
+#endif
+    for (size_type c = 0; c < m_num_caches; ++c) {
+#ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
+      cache_lock_guard_type guard(m_mutex[c]);
+#endif
+      const auto num_accesses = m_cache[c].access_counts.num_accesses;
+      if (num_accesses != m_num_accesses_at_trim[c]) {
+        // Used recently
+        m_num_accesses_at_trim[c] = num_accesses;
+        continue;
+      }
+      for (bin_no_type b = 0; b <= k_max_bin_no; ++b) {
+        num_deallocated += priv_deallocate_newest_objects(
+            c, b,
+            obcdetail::comp_chunk_size<difference_type, bin_no_manager>(b),
+            allocator_instance, deallocator_function);
+      }
+    }
+    return num_deallocated;
+  }
+
   inline size_type num_caches() const noexcept { return m_num_caches; }
 
+  /// Returns the current capacity of a bin in a cache, i.e., the maximum
+  /// number of objects the bin caches.
+  size_type bin_capacity(const size_type cache_no,
+                         const bin_no_type bin_no) const {
+    assert(cache_no < m_num_caches);
+    assert(bin_no <= k_max_bin_no);
+    const auto capacity =
+        m_cache[cache_no].bin_headers[bin_no].max_num_objects();
+    return (capacity > 0) ? capacity : priv_initial_bin_capacity(bin_no);
+  }
+
+  /// Returns the number of objects a bin of a cache allocates at a time when
+  /// it has no cached object.
+  static size_type refill_size(const bin_no_type bin_no) {
+    return obcdetail::comp_chunk_size<difference_type, bin_no_manager>(bin_no);
+  }
+
+  /// Returns the number of the objects of a bin in all caches.
+  /// The objects in the lock-free slots and the thread-local magazines are
+  /// not counted.
+  /// This function must not be called while other threads access the cache.
+  size_type num_cached_objects(const bin_no_type bin_no) const {
+    assert(bin_no <= k_max_bin_no);
+    size_type num_objects = 0;
+    for (size_type c = 0; c < m_num_caches; ++c) {
+      num_objects += m_cache[c].bin_headers[bin_no].num_objects();
+    }
+    return num_objects;
+  }
+
+  /// Caches objects of a bin in a cache in the same way as a refill on a
+  /// miss, e.g., to warm up the caches after the allocator state is loaded.
+  /// Nothing is cached if the bin already has cached objects or the cache
+  /// has no room for them without deallocating other objects.
+  /// This function can be called while other threads access the cache if
+  /// METALL_ENABLE_MUTEX_IN_OBJECT_CACHE is defined.
+  /// \param allocate A function that takes a number n and an array of n
+  /// offsets, allocates up to n objects of the bin into the array, and
+  /// returns the number of them.
+  /// \return The number of the cached objects.
+  template <typename function_type>
+  size_type prefill(const size_type cache_no, const bin_no_type bin_no,
+                    function_type allocate) {
+    assert(cache_no < m_num_caches);
+    if (bin_no > max_bin_no()) return 0;
+#ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
+    cache_lock_guard_type guard(m_mutex[cache_no]);
+#endif
+    auto &cache = m_cache[cache_no];
+    auto &cache_header = cache.header;
+    auto &bin_header = cache.bin_headers[bin_no];
+    if (bin_header.active_block()) return 0;
+
+    const auto object_size = bin_no_manager::to_object_size(bin_no);
+    const auto num_new_objects = refill_size(bin_no);
+    if (cache_header.total_size_byte() + num_new_objects * object_size >
+            m_max_per_cpu_cache_size ||
+        cache_header.free_blocks().empty()) {
+      return 0;
+    }
+
+    auto *new_block = cache_header.free_blocks().pop();
+    assert(new_block);
+    new_block->clear();
+    new_block->bin_no = bin_no;
+    const size_type num_allocated = allocate(num_new_objects, new_block->cache);
+    if (num_allocated == 0) {
+      cache_header.free_blocks().push(new_block);
+      return 0;
+    }
+    METALL_TRACE(cache_refill, bin_no, num_allocated);
+
+    new_block->link_to_older(cache_header.newest_block(),
+                             bin_header.active_block());
+    cache_header.register_new_block(new_block);
+    cache_header.total_size_byte() += num_allocated * object_size;
+    bin_header.update_active_block(new_block, num_allocated);
+    bin_header.num_objects() += num_allocated;
+    return num_allocated;
+  }
+
+  /// Returns the policy to bind threads to caches.
+  binding_policy get_binding_policy() const noexcept {
+    return m_binding_policy;
+  }
+
+  /// Sets the policy to bind threads to caches.
+  /// Cached objects stay in the caches they are in.
+  /// This function is not thread-safe.
+  void set_binding_policy(const binding_policy policy) noexcept {
+    m_binding_policy = policy;
+  }
+
+  /// Returns the sum of the access counters of all caches.
+  /// The returned values can be inaccurate if other threads access the cache
+  /// at the same time.
+  access_counts_type get_access_counts() const {
+    access_counts_type total;
+    for (size_type c = 0; c < m_num_caches; ++c) {
+      const auto &counts = m_cache[c].access_counts;
+      total.num_accesses += counts.num_accesses;
+      total.num_cross_cpu_accesses += counts.num_cross_cpu_accesses;
+      total.num_migrations += counts.num_migrations;
+    }
+    return total;
+  }
+
   const_bin_iterator begin(const size_type cache_no,
                            const bin_no_type bin_no) const {
     assert(cache_no < m_num_caches);
@@ -535,6 +918,49 @@ class object_cache {
     return const_bin_iterator();
   }
 
+  /// Calls 'func' with the offset of every object of a bin in the thread-local
+  /// magazines, including the ones left by exited threads; [begin(), end())
+  /// does not contain those objects.
+  /// This function must not be called while other threads access the cache.
+  template <typename function_type>
+  void for_each_in_thread_local_caches(
+      [[maybe_unused]] const bin_no_type bin_no,
+      [[maybe_unused]] function_type func) const {
+    assert(bin_no <= k_max_bin_no);
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    auto &registry = *m_magazine_registry.get();
+    lock_guard_type guard(registry.mutex);
+    for (const auto *magazine : registry.magazines) {
+      for (unsigned int i = 0; i < magazine->num_objects[bin_no]; ++i) {
+        func(magazine->objects[bin_no][i]);
+      }
+    }
+    for (const auto &orphan : registry.orphans) {
+      if (orphan.first == bin_no) func(orphan.second);
+    }
+#endif
+  }
+
+  /// Calls 'func' with the offset of every object in the lock-free slots of
+  /// a bin; [begin(), end()) does not contain those objects.
+  /// This function must not be called while other threads access the cache.
+  template <typename function_type>
+  void for_each_in_lock_free_slots(
+      [[maybe_unused]] const size_type cache_no,
+      [[maybe_unused]] const bin_no_type bin_no,
+      [[maybe_unused]] function_type func) const {
+    assert(cache_no < m_num_caches);
+    assert(bin_no <= k_max_bin_no);
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+    const auto &slots =
+        m_lock_free_slots[cache_no * (k_max_bin_no + 1) + bin_no];
+    for (const auto &slot : slots.slots) {
+      const auto offset = slot.load(std::memory_order_relaxed);
+      if (offset != slots.k_empty) func(offset);
+    }
+#endif
+  }
+
  private:
   struct free_deleter {
     void operator()(void *const p) const noexcept { std::free(p); }
@@ -544,36 +970,82 @@ class object_cache {
     return mdtl::get_num_cpus();
   }
 
-  inline size_type priv_cache_no() const {
-#ifdef METALL_DISABLE_CONCURRENCY
-    return 0;
-#endif
-#if SUPPORT_GET_CPU_NO
-    thread_local static const auto sub_cache_no =
-        std::hash<std::thread::id>{}(std::this_thread::get_id()) %
-        k_num_caches_per_cpu;
-    return (priv_get_cpu_no() * k_num_caches_per_cpu + sub_cache_no) %
-           m_num_caches;
-#else
+  static binding_policy priv_binding_policy_from_env() {
+    const char *const env = std::getenv(k_binding_policy_env_name);
+    if (env) {
+      const std::string value(env);
+      if (value == "thread") return binding_policy::per_thread;
+      if (value == "cpu") return binding_policy::per_cpu;
+      if (value == "numa") return binding_policy::per_numa_node;
+      std::string s("Unknown value of " +
+                    std::string(k_binding_policy_env_name) + ": " + value);
+      logger::out(logger::level::warning, __FILE__, __LINE__, s.c_str());
+    }
+    return binding_policy::per_cpu;
+  }
+
+  /// Returns the cache number the calling thread uses.
+  /// \param num_stale_accesses Set to the number of the previous accesses
+  /// made with a stale CPU (NUMA node) number if this call detects that the
+  /// thread has migrated; otherwise, set to 0.
+  inline size_type priv_cache_no(size_type *const num_stale_accesses) const {
+    *num_stale_accesses = 0;
+    if constexpr (!k_thread_safe) {
+      return 0;
+    }
     thread_local static const auto hashed_thread_id = mdtl::hash<>{}(
         std::hash<std::thread::id>{}(std::this_thread::get_id()));
-    return hashed_thread_id % m_num_caches;
+#if SUPPORT_GET_CPU_NO
+    if (m_binding_policy != binding_policy::per_thread) {
+      const auto sub_cache_no = hashed_thread_id % m_num_caches_per_cpu;
+      const size_type no =
+          (m_binding_policy == binding_policy::per_numa_node)
+              ? priv_get_cached_no<mdtl::get_numa_node_no>(num_stale_accesses)
+              : priv_get_cached_no<mdtl::get_cpu_no>(num_stale_accesses);
+      return (no * m_num_caches_per_cpu + sub_cache_no) % m_num_caches;
+    }
 #endif
+    return hashed_thread_id % m_num_caches;
   }
 
-  /// Get CPU number.
-  /// This function does not call the system call every time as it is slow.
-  inline static size_type priv_get_cpu_no() {
-#ifdef METALL_DISABLE_CONCURRENCY
-    return 0;
-#endif
-    thread_local static unsigned int cached_cpu_no = 0;
+  /// Get CPU (or NUMA node) number using 'get_no'.
+  /// This function does not call the system call every time as it is slow;
+  /// the number is refreshed every 'k_cpu_no_cache_duration' calls so that
+  /// the calling thread follows migrations.
+  /// \param num_stale_calls Set to the number of the calls since the previous
+  /// refresh if the number has changed; otherwise, set to 0.
+  template <unsigned int (*get_no)()>
+  inline static size_type priv_get_cached_no(size_type *const num_stale_calls) {
+    thread_local static unsigned int cached_no = get_no();
     thread_local static unsigned int cached_count = 0;
-    if (cached_cpu_no == 0) {
-      cached_cpu_no = mdtl::get_cpu_no();
-    }
     cached_count = (cached_count + 1) % k_cpu_no_cache_duration;
-    return cached_cpu_no;
+    if (cached_count == 0) {
+      const auto no = get_no();
+      if (no != cached_no) {
+        cached_no = no;
+        *num_stale_calls = k_cpu_no_cache_duration - 1;
+      }
+    }
+    return cached_no;
+  }
+
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+  lock_free_slots_type &priv_lock_free_slots(const size_type cache_no,
+                                             const bin_no_type bin_no) {
+    return m_lock_free_slots[cache_no * (k_max_bin_no + 1) + bin_no];
+  }
+#endif
+
+  /// Updates the access counters of a cache.
+  /// The caller must hold the lock of the cache.
+  void priv_count_access(const size_type cache_no,
+                         const size_type num_stale_accesses) {
+    auto &counts = m_cache[cache_no].access_counts;
+    ++counts.num_accesses;
+    if (num_stale_accesses > 0) {
+      counts.num_cross_cpu_accesses += num_stale_accesses;
+      ++counts.num_migrations;
+    }
   }
 
   bool priv_allocate_cache() {
@@ -598,10 +1070,26 @@ class object_cache {
                            object_deallocate_func_type deallocator_function) {
     assert(bin_no <= max_bin_no());
 
-    const auto cache_no = priv_cache_no();
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    if constexpr (k_thread_safe) {
+      auto &magazine = priv_thread_local_magazine();
+      auto &num_objects = magazine.num_objects[bin_no];
+      if (num_objects > 0) return magazine.objects[bin_no][--num_objects];
+    }
+#endif
+
+    size_type num_stale_accesses;
+    const auto cache_no = priv_cache_no(&num_stale_accesses);
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+    if constexpr (k_thread_safe) {
+      const auto offset = priv_lock_free_slots(cache_no, bin_no).pop();
+      if (offset != lock_free_slots_type::k_empty) return offset;
+    }
+#endif
 #ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
-    lock_guard_type guard(m_mutex[cache_no]);
+    cache_lock_guard_type guard(m_mutex[cache_no]);
 #endif
+    priv_count_access(cache_no, num_stale_accesses);
 
     auto &cache = m_cache[cache_no];
     auto &cache_header = cache.header;
@@ -609,14 +1097,15 @@ class object_cache {
     const auto object_size = bin_no_manager::to_object_size(bin_no);
 
     if (bin_header.active_block_size() == 0) {  // Active block is empty
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+      if constexpr (k_thread_safe) {
+        priv_release_orphans(allocator_instance, deallocator_function);
+      }
+#endif
 
       if (bin_header.active_block()) {
         // Move to next active block if that is available
-        auto *const empty_block = bin_header.active_block();
-        bin_header.move_to_next_active_block();
-        cache_header.unregister(empty_block);
-        empty_block->disconnect();
-        cache_header.free_blocks().push(empty_block);
+        priv_release_empty_active_block(cache_no, bin_no);
       }
 
       if (bin_header.active_block_size() == 0) {
@@ -640,6 +1129,7 @@ class object_cache {
         new_block->bin_no = bin_no;
         (allocator_instance->*allocator_function)(bin_no, num_new_objects,
                                                   new_block->cache);
+        METALL_TRACE(cache_refill, bin_no, num_new_objects);
 
         // Link the new block to the existing blocks
         new_block->link_to_older(cache_header.newest_block(),
@@ -648,14 +1138,22 @@ class object_cache {
         // Update headers
         cache_header.register_new_block(new_block);
         cache_header.total_size_byte() += new_objects_size;
-        assert(cache_header.total_size_byte() <= k_max_per_cpu_cache_size);
+        assert(cache_header.total_size_byte() <= m_max_per_cpu_cache_size);
         bin_header.update_active_block(new_block, num_new_objects);
+        bin_header.num_objects() += num_new_objects;
+
+        // Missed; give more room to the bin
+        auto &capacity = priv_bin_capacity(bin_header, bin_no);
+        capacity = std::min(capacity + num_new_objects,
+                            size_type(m_max_per_cpu_cache_size / object_size));
+        bin_header.num_overflows() = 0;
       }
     }
     assert(bin_header.active_block_size() > 0);
 
     // Pop an object from the active block
     --bin_header.active_block_size();
+    --bin_header.num_objects();
     const auto object_offset =
         bin_header.active_block()->cache[bin_header.active_block_size()];
     assert(cache_header.total_size_byte() >= object_size);
@@ -669,16 +1167,41 @@ class object_cache {
     assert(object_offset >= 0);
     assert(bin_no <= max_bin_no());
 
-    const auto cache_no = priv_cache_no();
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+    if constexpr (k_thread_safe) {
+      auto &magazine = priv_thread_local_magazine();
+      auto &num_objects = magazine.num_objects[bin_no];
+      if (num_objects < magazine_type::k_depth) {
+        magazine.objects[bin_no][num_objects++] = object_offset;
+        return true;
+      }
+    }
+#endif
+
+    size_type num_stale_accesses;
+    const auto cache_no = priv_cache_no(&num_stale_accesses);
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+    if constexpr (k_thread_safe) {
+      if (priv_lock_free_slots(cache_no, bin_no).push(object_offset)) {
+        return true;
+      }
+    }
+#endif
 #ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
-    lock_guard_type guard(m_mutex[cache_no]);
+    cache_lock_guard_type guard(m_mutex[cache_no]);
 #endif
+    priv_count_access(cache_no, num_stale_accesses);
 
     auto &cache = m_cache[cache_no];
     auto &cache_header = cache.header;
     auto &bin_header = cache.bin_headers[bin_no];
     const auto object_size = bin_no_manager::to_object_size(bin_no);
 
+    if (bin_header.num_objects() >= priv_bin_capacity(bin_header, bin_no)) {
+      priv_handle_bin_overflow(cache_no, bin_no, allocator_instance,
+                               deallocator_function);
+    }
+
     // Make sure that the cache has enough space to allocate objects.
     priv_make_room_for_new_blocks(cache_no, object_size, allocator_instance,
                                   deallocator_function);
@@ -703,12 +1226,147 @@ class object_cache {
     bin_header.active_block()->cache[bin_header.active_block_size()] =
         object_offset;
     ++bin_header.active_block_size();
+    ++bin_header.num_objects();
     cache_header.total_size_byte() += object_size;
-    assert(cache_header.total_size_byte() <= k_max_per_cpu_cache_size);
+    assert(cache_header.total_size_byte() <= m_max_per_cpu_cache_size);
 
     return true;
   }
 
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+  /// Returns the magazine the calling thread owns for this cache.
+  /// Creates and registers one if there is not.
+  magazine_type &priv_thread_local_magazine() {
+    thread_local static thread_local_magazine_holder holder;
+    if (holder.last_cache_id == m_magazine_registry.id()) {
+      return *holder.last_magazine;
+    }
+    auto *const magazine = holder.find_or_register(m_magazine_registry);
+    holder.last_cache_id = m_magazine_registry.id();
+    holder.last_magazine = magazine;
+    return *magazine;
+  }
+
+  /// Deallocates the objects in the magazines of all threads.
+  /// This function must not be called while other threads access the cache.
+  void priv_clear_thread_local_magazines(
+      object_allocator_type *const allocator_instance,
+      object_deallocate_func_type deallocator_function) {
+    {
+      auto &registry = *m_magazine_registry.get();
+      lock_guard_type guard(registry.mutex);
+      for (auto *magazine : registry.magazines) {
+        for (bin_no_type b = 0; b <= k_max_bin_no; ++b) {
+          if (magazine->num_objects[b] == 0) continue;
+          (allocator_instance->*deallocator_function)(
+              b, magazine->num_objects[b], magazine->objects[b]);
+          magazine->num_objects[b] = 0;
+        }
+      }
+    }
+    priv_release_orphans(allocator_instance, deallocator_function);
+  }
+
+  /// Deallocates the objects left by exited threads.
+  /// Returns the number of deallocated objects.
+  size_type priv_release_orphans(
+      object_allocator_type *const allocator_instance,
+      object_deallocate_func_type deallocator_function) {
+    auto &registry = *m_magazine_registry.get();
+    lock_guard_type guard(registry.mutex);
+    for (auto &orphan : registry.orphans) {
+      (allocator_instance->*deallocator_function)(orphan.first, 1,
+                                                  &orphan.second);
+    }
+    const size_type num_released = registry.orphans.size();
+    registry.orphans.clear();
+    return num_released;
+  }
+#endif
+
+  static size_type priv_initial_bin_capacity(const bin_no_type bin_no) {
+    return obcdetail::comp_chunk_size<difference_type, bin_no_manager>(
+               bin_no) *
+           2;
+  }
+
+  static size_type &priv_bin_capacity(bin_header_type &bin_header,
+                                      const bin_no_type bin_no) {
+    if (bin_header.max_num_objects() == 0) {
+      bin_header.max_num_objects() = priv_initial_bin_capacity(bin_no);
+    }
+    return bin_header.max_num_objects();
+  }
+
+  /// Removes the empty active block of a bin and makes the next (older) block
+  /// the active block.
+  void priv_release_empty_active_block(const size_type cache_no,
+                                       const bin_no_type bin_no) {
+    auto &cache = m_cache[cache_no];
+    auto &cache_header = cache.header;
+    auto &bin_header = cache.bin_headers[bin_no];
+    assert(bin_header.active_block());
+    assert(bin_header.active_block_size() == 0);
+
+    auto *const empty_block = bin_header.active_block();
+    bin_header.move_to_next_active_block();
+    cache_header.unregister(empty_block);
+    empty_block->disconnect();
+    cache_header.free_blocks().push(empty_block);
+  }
+
+  /// Deallocates the newest objects of a bin, one refill worth, and shrinks
+  /// the capacity of the bin if it overflows too often.
+  void priv_handle_bin_overflow(
+      const size_type cache_no, const bin_no_type bin_no,
+      object_allocator_type *const allocator_instance,
+      object_deallocate_func_type deallocator_function) {
+    auto &bin_header = m_cache[cache_no].bin_headers[bin_no];
+    const size_type batch_size =
+        obcdetail::comp_chunk_size<difference_type, bin_no_manager>(bin_no);
+
+    priv_deallocate_newest_objects(cache_no, bin_no, batch_size,
+                                   allocator_instance, deallocator_function);
+
+    auto &capacity = priv_bin_capacity(bin_header, bin_no);
+    if (++bin_header.num_overflows() > k_max_num_overflows) {
+      capacity = std::max(capacity - std::min(capacity, batch_size),
+                          size_type(batch_size));
+      bin_header.num_overflows() = 0;
+    }
+  }
+
+  /// Deallocates the newest 'max_num_objects' objects of a bin at most.
+  /// Returns the number of deallocated objects.
+  size_type priv_deallocate_newest_objects(
+      const size_type cache_no, const bin_no_type bin_no,
+      const size_type max_num_objects,
+      object_allocator_type *const allocator_instance,
+      object_deallocate_func_type deallocator_function) {
+    auto &cache = m_cache[cache_no];
+    auto &bin_header = cache.bin_headers[bin_no];
+    const auto object_size = bin_no_manager::to_object_size(bin_no);
+
+    size_type num_remains = max_num_objects;
+    while (num_remains > 0 && bin_header.num_objects() > 0) {
+      if (bin_header.active_block_size() == 0) {
+        priv_release_empty_active_block(cache_no, bin_no);
+        continue;
+      }
+      const auto n = std::min(num_remains, bin_header.active_block_size());
+      bin_header.active_block_size() -= n;
+      (allocator_instance->*deallocator_function)(
+          bin_no, n,
+          bin_header.active_block()->cache + bin_header.active_block_size());
+      METALL_TRACE(cache_flush, bin_no, n);
+      bin_header.num_objects() -= n;
+      assert(cache.header.total_size_byte() >= n * object_size);
+      cache.header.total_size_byte() -= n * object_size;
+      num_remains -= n;
+    }
+    return max_num_objects - num_remains;
+  }
+
   void priv_make_room_for_new_blocks(
       const size_type cache_no, const size_type new_objects_size,
       object_allocator_type *const allocator_instance,
@@ -720,7 +1378,7 @@ class object_cache {
     auto &total_size = cache_header.total_size_byte();
 
     // Make sure that the cache has enough space to allocate objects.
-    while (total_size + new_objects_size > k_max_per_cpu_cache_size ||
+    while (total_size + new_objects_size > m_max_per_cpu_cache_size ||
            free_blocks.empty()) {
       auto *const oldest_block = cache_header.oldest_block();
       assert(oldest_block);
@@ -735,8 +1393,11 @@ class object_cache {
                                    : cache_block_type::k_capacity;
       (allocator_instance->*deallocator_function)(bin_no, num_objects,
                                                   oldest_block->cache);
+      METALL_TRACE(cache_flush, bin_no, num_objects);
       assert(total_size >= num_objects * object_size);
       total_size -= num_objects * object_size;
+      assert(bin_header.num_objects() >= num_objects);
+      bin_header.num_objects() -= num_objects;
 
       cache_header.unregister(oldest_block);
       if (bin_header.active_block() == oldest_block) {
@@ -747,18 +1408,165 @@ class object_cache {
     }
   }
 
+  const size_type m_max_per_cpu_cache_size;
+  const unsigned int m_num_caches_per_cpu;
+  const bin_no_type m_max_bin_no;
   const unsigned int m_num_caches;
+  binding_policy m_binding_policy;
 #ifdef METALL_ENABLE_MUTEX_IN_OBJECT_CACHE
-  std::vector<mutex_type> m_mutex;
+  std::vector<cache_mutex_type> m_mutex;
 #endif
   std::unique_ptr<cache_storage_type[], free_deleter> m_cache{nullptr};
+#ifdef METALL_ENABLE_LOCK_FREE_SLOTS_IN_OBJECT_CACHE
+  std::unique_ptr<lock_free_slots_type[]> m_lock_free_slots;
+#endif
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+  magazine_registry_handle m_magazine_registry;
+#endif
+  // The access count of each cache at the previous trim() call
+  std::vector<size_type> m_num_accesses_at_trim;
 };
 
+#ifdef METALL_ENABLE_THREAD_LOCAL_CACHE_IN_OBJECT_CACHE
+/// Owns the magazine registry of an object cache and gives the cache a unique
+/// ID. Marks the registry as dead when the cache goes away.
+template <typename _size_type, typename _difference_type,
+          typename _bin_no_manager, typename _object_allocator_type,
+          typename _concurrency_policy>
+class object_cache<_size_type, _difference_type, _bin_no_manager,
+                   _object_allocator_type, _concurrency_policy>::
+    magazine_registry_handle {
+ public:
+  magazine_registry_handle()
+      : m_registry(std::make_shared<magazine_registry_type>()),
+        m_id(priv_new_id()) {}
+
+  ~magazine_registry_handle() noexcept { priv_release(); }
+
+  magazine_registry_handle(const magazine_registry_handle &) = delete;
+  magazine_registry_handle &operator=(const magazine_registry_handle &) =
+      delete;
+
+  magazine_registry_handle(magazine_registry_handle &&other) noexcept
+      : m_registry(std::move(other.m_registry)), m_id(other.m_id) {
+    other.m_id = 0;
+  }
+
+  magazine_registry_handle &operator=(
+      magazine_registry_handle &&other) noexcept {
+    priv_release();
+    m_registry = std::move(other.m_registry);
+    m_id = other.m_id;
+    other.m_id = 0;
+    return *this;
+  }
+
+  magazine_registry_type *get() const noexcept { return m_registry.get(); }
+
+  const std::shared_ptr<magazine_registry_type> &shared() const noexcept {
+    return m_registry;
+  }
+
+  /// Returns the ID of the cache. IDs are never reused; 0 is not used.
+  std::uint64_t id() const noexcept { return m_id; }
+
+ private:
+  static std::uint64_t priv_new_id() {
+    static std::atomic<std::uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void priv_release() noexcept {
+    if (!m_registry) return;
+    lock_guard_type guard(m_registry->mutex);
+    m_registry->cache_alive = false;
+    m_registry->magazines.clear();
+    m_registry->orphans.clear();
+  }
+
+  std::shared_ptr<magazine_registry_type> m_registry;
+  std::uint64_t m_id{0};
+};
+
+/// Holds the magazines a thread owns, one per object cache.
+/// The destructor, which runs when the thread exits, hands the objects in the
+/// magazines back to the caches that are still alive.
+template <typename _size_type, typename _difference_type,
+          typename _bin_no_manager, typename _object_allocator_type,
+          typename _concurrency_policy>
+struct object_cache<_size_type, _difference_type, _bin_no_manager,
+                    _object_allocator_type, _concurrency_policy>::
+    thread_local_magazine_holder {
+  struct entry {
+    std::uint64_t cache_id;
+    std::shared_ptr<magazine_registry_type> registry;
+    std::unique_ptr<magazine_type> magazine;
+  };
+
+  thread_local_magazine_holder() = default;
+  thread_local_magazine_holder(const thread_local_magazine_holder &) = delete;
+  thread_local_magazine_holder &operator=(
+      const thread_local_magazine_holder &) = delete;
+
+  ~thread_local_magazine_holder() noexcept {
+    for (auto &e : entries) {
+      priv_unregister(e);
+    }
+  }
+
+  magazine_type *find_or_register(const magazine_registry_handle &handle) {
+    for (auto &e : entries) {
+      if (e.cache_id == handle.id()) return e.magazine.get();
+    }
+
+    // Forget the magazines of the caches that have gone
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const entry &e) {
+                                   lock_guard_type guard(e.registry->mutex);
+                                   return !e.registry->cache_alive;
+                                 }),
+                  entries.end());
+
+    entries.push_back(
+        entry{handle.id(), handle.shared(), std::make_unique<magazine_type>()});
+    auto &registry = *handle.get();
+    lock_guard_type guard(registry.mutex);
+    registry.magazines.push_back(entries.back().magazine.get());
+    return entries.back().magazine.get();
+  }
+
+  std::uint64_t last_cache_id{0};
+  magazine_type *last_magazine{nullptr};
+  std::vector<entry> entries;
+
+ private:
+  static void priv_unregister(entry &e) noexcept {
+    auto &registry = *e.registry;
+    lock_guard_type guard(registry.mutex);
+    if (!registry.cache_alive) return;
+
+    auto &magazines = registry.magazines;
+    magazines.erase(
+        std::remove(magazines.begin(), magazines.end(), e.magazine.get()),
+        magazines.end());
+
+    const auto &magazine = *e.magazine;
+    for (bin_no_type b = 0; b <= k_max_bin_no; ++b) {
+      for (unsigned int i = 0; i < magazine.num_objects[b]; ++i) {
+        registry.orphans.emplace_back(b, magazine.objects[b][i]);
+      }
+    }
+  }
+};
+#endif
+
 /// An iterator to iterate over cached objects of the same bin.
 template <typename _size_type, typename _difference_type,
-          typename _bin_no_manager, typename _object_allocator_type>
+          typename _bin_no_manager, typename _object_allocator_type,
+          typename _concurrency_policy>
 class object_cache<_size_type, _difference_type, _bin_no_manager,
-                   _object_allocator_type>::const_bin_iterator {
+                   _object_allocator_type, _concurrency_policy>::
+    const_bin_iterator {
  public:
   using value_type = difference_type;
   using pointer = const value_type *;
@@ -0,0 +1,89 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_OBJECT_CACHE_TRIMMER_HPP
+#define METALL_KERNEL_OBJECT_CACHE_TRIMMER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <metall/logger.hpp>
+
+namespace metall::kernel {
+
+/// \brief Runs a task, which trims object caches, periodically in a
+/// background thread.
+class object_cache_trimmer {
+ public:
+  using task_type = std::function<void()>;
+  using pause_guard_type = std::unique_lock<std::mutex>;
+
+  /// \brief Starts the background thread.
+  /// \param interval The interval between two runs of the task.
+  /// \param task A task to run.
+  object_cache_trimmer(const std::chrono::milliseconds interval,
+                       task_type task)
+      : m_interval(interval), m_task(std::move(task)) {
+    try {
+      m_thread = std::make_unique<std::thread>([this]() { priv_run(); });
+    } catch (const std::system_error &) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to start the object cache trimmer thread");
+      m_thread.reset();
+    }
+  }
+
+  ~object_cache_trimmer() noexcept { stop(); }
+
+  object_cache_trimmer(const object_cache_trimmer &) = delete;
+  object_cache_trimmer &operator=(const object_cache_trimmer &) = delete;
+  object_cache_trimmer(object_cache_trimmer &&) = delete;
+  object_cache_trimmer &operator=(object_cache_trimmer &&) = delete;
+
+  /// \brief Stops the background thread.
+  /// Waits for the task if it is running.
+  void stop() noexcept {
+    if (!m_thread) return;
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread->join();
+    m_thread.reset();
+  }
+
+  /// \brief Returns true if the background thread is running.
+  bool running() const noexcept { return !!m_thread; }
+
+  /// \brief Keeps the task from running while the returned object is alive.
+  /// Waits for the task if it is running.
+  pause_guard_type pause() { return pause_guard_type(m_mutex); }
+
+ private:
+  void priv_run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      m_cv.wait_for(lock, m_interval, [this]() { return m_stop; });
+      if (m_stop) break;
+      m_task();
+    }
+  }
+
+  const std::chrono::milliseconds m_interval;
+  task_type m_task;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+  std::unique_ptr<std::thread> m_thread{nullptr};
+};
+
+}  // namespace metall::kernel
+#endif  // METALL_KERNEL_OBJECT_CACHE_TRIMMER_HPP
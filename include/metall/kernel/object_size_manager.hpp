@@ -20,26 +20,72 @@ namespace {
 namespace mdtl = metall::mtlldetail;
 }
 
-namespace object_size_manager_detail {
-
-// Sizes are coming from SuperMalloc
-constexpr std::size_t k_class1_small_size_table[] = {
-    8,  10, 12, 14, 16,  20,  24,  28,  32,  40,  48,
-    56, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+/// \brief A table of the small object sizes (size classes) given to
+/// basic_manager, e.g., to match the dominant object sizes of an application.
+/// The sizes from the last one up to half of the chunk size are spaced as in
+/// the default table, i.e., four sizes per power of two.
+/// The sizes must be in the ascending order, start with a power of two equal
+/// to or larger than 8, and end with a power of two; all powers of two in
+/// between must be included for aligned allocations.
+/// The table is a part of the data store format; a data store must be opened
+/// with the table it was created with.
+template <std::size_t... sizes>
+struct size_class_table {
+  static constexpr std::size_t k_num_sizes = sizeof...(sizes);
+  static_assert(k_num_sizes > 0, "A size class table must not be empty");
+  static constexpr std::size_t k_sizes[k_num_sizes] = {sizes...};
 };
 
+/// \brief The default size class table.
+/// Sizes are coming from SuperMalloc.
+using default_size_class_table =
+    size_class_table<8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96,
+                     112, 128, 160, 192, 224, 256>;
+
+namespace object_size_manager_detail {
+
+constexpr const auto &k_class1_small_size_table =
+    default_size_class_table::k_sizes;
 constexpr uint64_t k_num_class1_small_sizes =
-    (uint64_t)std::extent<decltype(k_class1_small_size_table)>::value;
+    default_size_class_table::k_num_sizes;
 constexpr std::size_t k_min_class2_offset = 64;
 template <std::size_t k_chunk_size>
 constexpr std::size_t k_max_small_size = k_chunk_size / 2;
 
+template <typename table>
+constexpr std::size_t k_last_class1_size =
+    table::k_sizes[table::k_num_sizes - 1];
+
+// The class-2 sizes start with the same spacing as the default table, i.e.,
+// k_min_class2_offset after 256.
+template <typename table>
+constexpr std::size_t k_class2_offset = k_last_class1_size<table> / 4;
+static_assert(k_class2_offset<default_size_class_table> == k_min_class2_offset);
+
+inline constexpr bool is_power_of_2(const std::size_t n) noexcept {
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+template <typename table>
+inline constexpr bool valid_size_class_table() noexcept {
+  const std::size_t first = table::k_sizes[0];
+  if (first < 8 || !is_power_of_2(first)) return false;
+  if (!is_power_of_2(k_last_class1_size<table>)) return false;
+  std::size_t next_power_of_2 = first;
+  for (std::size_t i = 0; i < table::k_num_sizes; ++i) {
+    if (i > 0 && table::k_sizes[i] <= table::k_sizes[i - 1]) return false;
+    if (table::k_sizes[i] > next_power_of_2) return false;
+    if (table::k_sizes[i] == next_power_of_2) next_power_of_2 *= 2;
+  }
+  return true;
+}
+
 // Sizes are coming from jemalloc
-template <std::size_t k_chunk_size>
+template <std::size_t k_chunk_size, typename table = default_size_class_table>
 inline constexpr uint64_t num_class2_small_sizes() noexcept {
-  std::size_t size = k_class1_small_size_table[k_num_class1_small_sizes - 1];
+  std::size_t size = k_last_class1_size<table>;
   uint64_t num_class2_small_sizes = 0;
-  uint64_t offset = k_min_class2_offset;
+  uint64_t offset = k_class2_offset<table>;
 
   while (size <= k_max_small_size<k_chunk_size>) {
     for (int i = 0; i < 4; ++i) {
@@ -53,41 +99,59 @@ inline constexpr uint64_t num_class2_small_sizes() noexcept {
   return num_class2_small_sizes;
 }
 
+/// \brief Returns the large size next to 'size'.
+/// The large sizes are multiples of the chunk size spaced as the class-2
+/// sizes, i.e., four sizes per power of two, (1, 2, 3, 4, 5, 6, 7, 8, 10, 12,
+/// 14, 16, 20, ...) x chunk size, so that a large object wastes at most 20% of
+/// its chunks instead of 50% with powers of two.
+template <std::size_t k_chunk_size>
+inline constexpr std::size_t next_large_size(const std::size_t size) noexcept {
+  const std::size_t num_chunks = size / k_chunk_size;
+  std::size_t step = 1;
+  while (step * 8 <= num_chunks) step *= 2;
+  return size + step * k_chunk_size;
+}
+
 template <std::size_t k_chunk_size, std::size_t k_max_size>
 inline constexpr uint64_t num_large_sizes() noexcept {
   uint64_t count = 0;
-  for (std::size_t size = k_chunk_size; size <= k_max_size; size *= 2) {
+  for (std::size_t size = k_chunk_size; size <= k_max_size;
+       size = next_large_size<k_chunk_size>(size)) {
     ++count;
   }
   return count;
 }
 
-template <std::size_t k_chunk_size, std::size_t k_max_size>
+template <std::size_t k_chunk_size, std::size_t k_max_size,
+          typename table = default_size_class_table>
 constexpr uint64_t k_num_sizes =
-    k_num_class1_small_sizes + num_class2_small_sizes<k_chunk_size>() +
+    table::k_num_sizes + num_class2_small_sizes<k_chunk_size, table>() +
     num_large_sizes<k_chunk_size, k_max_size>();
 
-template <std::size_t k_chunk_size, std::size_t k_max_size>
-inline constexpr std::array<std::size_t, k_num_sizes<k_chunk_size, k_max_size>>
+template <std::size_t k_chunk_size, std::size_t k_max_size,
+          typename table = default_size_class_table>
+inline constexpr std::array<std::size_t,
+                            k_num_sizes<k_chunk_size, k_max_size, table>>
 init_size_table() noexcept {
   // MEMO: {} is needed to prevent the uninitialized error in constexpr
   // contexts. This technique is not needed from C++20.
-  std::array<std::size_t, k_num_sizes<k_chunk_size, k_max_size>> table{};
+  std::array<std::size_t, k_num_sizes<k_chunk_size, k_max_size, table>>
+      table_out{};
 
   uint64_t index = 0;
 
-  for (; index < k_num_class1_small_sizes; ++index) {
-    table[index] = k_class1_small_size_table[index];
+  for (; index < table::k_num_sizes; ++index) {
+    table_out[index] = table::k_sizes[index];
   }
 
   {
-    std::size_t size = k_class1_small_size_table[k_num_class1_small_sizes - 1];
-    uint64_t offset = k_min_class2_offset;
+    std::size_t size = k_last_class1_size<table>;
+    uint64_t offset = k_class2_offset<table>;
     while (size <= k_max_small_size<k_chunk_size>) {
       for (int i = 0; i < 4; ++i) {
         size += offset;
         if (size > k_max_small_size<k_chunk_size>) break;
-        table[index] = size;
+        table_out[index] = size;
         ++index;
       }
       offset *= 2;
@@ -97,45 +161,69 @@ init_size_table() noexcept {
   {
     std::size_t size = k_chunk_size;
     for (uint64_t i = 0; i < num_large_sizes<k_chunk_size, k_max_size>(); ++i) {
-      table[index] = size;
-      size *= 2;
+      table_out[index] = size;
+      size = next_large_size<k_chunk_size>(size);
       ++index;
     }
   }
 
-  return table;
+  return table_out;
 }
 
-template <std::size_t k_chunk_size, std::size_t k_max_size>
-constexpr std::array<std::size_t, k_num_sizes<k_chunk_size, k_max_size>>
-    k_size_table = init_size_table<k_chunk_size, k_max_size>();
+template <std::size_t k_chunk_size, std::size_t k_max_size,
+          typename table = default_size_class_table>
+constexpr std::array<std::size_t, k_num_sizes<k_chunk_size, k_max_size, table>>
+    k_size_table = init_size_table<k_chunk_size, k_max_size, table>();
 
-template <std::size_t k_chunk_size, std::size_t k_max_size>
+template <std::size_t k_chunk_size, std::size_t k_max_size,
+          typename table = default_size_class_table>
 inline constexpr int64_t find_in_size_table(
     const std::size_t size, const uint64_t offset = 0) noexcept {
-  for (uint64_t i = offset; i < k_size_table<k_chunk_size, k_max_size>.size();
-       ++i) {
-    if (size <= k_size_table<k_chunk_size, k_max_size>[i])
-      return static_cast<int64_t>(i);
+  constexpr const auto &size_table =
+      k_size_table<k_chunk_size, k_max_size, table>;
+  for (uint64_t i = offset; i < size_table.size(); ++i) {
+    if (size <= size_table[i]) return static_cast<int64_t>(i);
   }
   return -1;  // Error
 }
 
-template <std::size_t k_chunk_size, std::size_t k_max_size>
+/// \brief Finds the first size in the class-1 table that is equal to or
+/// larger than 'size' by a binary search.
+template <typename table>
+inline constexpr int64_t find_in_class1_table(const std::size_t size) noexcept {
+  uint64_t first = 0;
+  uint64_t last = table::k_num_sizes - 1;
+  while (first < last) {
+    const uint64_t mid = (first + last) / 2;
+    if (table::k_sizes[mid] < size) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+  return static_cast<int64_t>(first);
+}
+
+template <std::size_t k_chunk_size, std::size_t k_max_size,
+          typename table = default_size_class_table>
 inline constexpr int64_t object_size_index(const std::size_t size) noexcept {
-  if (size <= k_size_table<k_chunk_size, k_max_size>[0]) return 0;
-
-  if (size <= k_class1_small_size_table[k_num_class1_small_sizes - 1]) {
-    const int z = mdtl::clzll(size);
-    const std::size_t r = size + (1ULL << (61ULL - z)) - 1;
-    const int y = mdtl::clzll(r);
-    const int index =
-        static_cast<int>(4 * (60 - y) + ((r >> (61ULL - y)) & 3ULL));
-    return static_cast<int64_t>(index);
+  if (size <= table::k_sizes[0]) return 0;
+
+  if (size <= k_last_class1_size<table>) {
+    if constexpr (std::is_same_v<table, default_size_class_table>) {
+      const int z = mdtl::clzll(size);
+      const std::size_t r = size + (1ULL << (61ULL - z)) - 1;
+      const int y = mdtl::clzll(r);
+      const int index =
+          static_cast<int>(4 * (60 - y) + ((r >> (61ULL - y)) & 3ULL));
+      return static_cast<int64_t>(index);
+    } else {
+      return find_in_class1_table<table>(size);
+    }
   }
 
-  return find_in_size_table<k_chunk_size, k_max_size>(size,
-                                                      k_num_class1_small_sizes);
+  return find_in_size_table<k_chunk_size, k_max_size, table>(
+      size, table::k_num_sizes);
 }
 
 }  // namespace object_size_manager_detail
@@ -145,11 +233,21 @@ namespace dtl = object_size_manager_detail;
 }
 
 /// \brief Object size manager
-template <std::size_t k_chunk_size, std::size_t k_max_object_size>
+/// \tparam size_class_table_type The table of the small object sizes, e.g.,
+/// size_class_table.
+template <std::size_t k_chunk_size, std::size_t k_max_object_size,
+          typename size_class_table_type = default_size_class_table>
 class object_size_manager {
  public:
   using size_type = std::size_t;
 
+ private:
+  static_assert(dtl::valid_size_class_table<size_class_table_type>(),
+                "Invalid size class table");
+  static_assert(dtl::k_last_class1_size<size_class_table_type> <=
+                    dtl::k_max_small_size<k_chunk_size>,
+                "The sizes in a size class table must be <= chunk size / 2");
+
  public:
   object_size_manager() = delete;
   ~object_size_manager() = delete;
@@ -159,16 +257,18 @@ class object_size_manager {
   object_size_manager &operator=(object_size_manager &&) noexcept = delete;
 
   static constexpr size_type at(const size_type i) noexcept {
-    return dtl::k_size_table<k_chunk_size, k_max_object_size>[i];
+    return dtl::k_size_table<k_chunk_size, k_max_object_size,
+                             size_class_table_type>[i];
   }
 
   static constexpr size_type num_sizes() noexcept {
-    return dtl::k_num_sizes<k_chunk_size, k_max_object_size>;
+    return dtl::k_num_sizes<k_chunk_size, k_max_object_size,
+                            size_class_table_type>;
   }
 
   static constexpr size_type num_small_sizes() noexcept {
-    return dtl::k_num_class1_small_sizes +
-           dtl::num_class2_small_sizes<k_chunk_size>();
+    return size_class_table_type::k_num_sizes +
+           dtl::num_class2_small_sizes<k_chunk_size, size_class_table_type>();
   }
 
   static constexpr size_type num_large_sizes() noexcept {
@@ -176,7 +276,8 @@ class object_size_manager {
   }
 
   static constexpr int64_t index(const size_type size) noexcept {
-    return dtl::object_size_index<k_chunk_size, k_max_object_size>(size);
+    return dtl::object_size_index<k_chunk_size, k_max_object_size,
+                                  size_class_table_type>(size);
   }
 };
 
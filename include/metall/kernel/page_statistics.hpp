@@ -0,0 +1,253 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_PAGE_STATISTICS_HPP
+#define METALL_KERNEL_PAGE_STATISTICS_HPP
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/memory.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/soft_dirty_page.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief The numbers of bytes of the pages of a region in each state.
+struct page_counts {
+  /// \brief The bytes resident in memory (mincore(2)), i.e., in the page
+  /// cache for file-backed pages.
+  std::size_t resident_bytes{0};
+  /// \brief The bytes of the pages written since the soft-dirty bits were
+  /// last cleared, e.g., by an incremental snapshot, or since the segment
+  /// was mapped. 0 if the soft-dirty bits are not available.
+  std::size_t dirty_bytes{0};
+  /// \brief The bytes that became resident since the previous scan, i.e.,
+  /// faulted (read in) pages. All resident pages at the first scan.
+  std::size_t faulted_bytes{0};
+
+  page_counts &operator+=(const page_counts &other) {
+    resident_bytes += other.resident_bytes;
+    dirty_bytes += other.dirty_bytes;
+    faulted_bytes += other.faulted_bytes;
+    return *this;
+  }
+
+  bool empty() const {
+    return resident_bytes == 0 && dirty_bytes == 0 && faulted_bytes == 0;
+  }
+};
+
+/// \brief The page counts of a chunk.
+struct chunk_page_statistics {
+  std::size_t chunk_no{0};
+  uint32_t bin_no{0};
+  page_counts pages;
+};
+
+/// \brief The page counts of all chunks of a bin.
+struct bin_page_statistics {
+  uint32_t bin_no{0};
+  std::size_t object_size{0};
+  std::size_t num_chunks{0};
+  page_counts pages;
+};
+
+/// \brief The page counts of a named or unique object.
+struct object_page_statistics {
+  std::string name;
+  std::size_t bytes{0};
+  page_counts pages;
+};
+
+/// \brief Attributes the resident, dirty, and faulted pages of a Metall
+/// segment to the chunks, bins, and named objects.
+struct page_statistics {
+  std::size_t page_size{0};
+  std::size_t chunk_size{0};
+  /// \brief The number of bytes of the segment scanned.
+  std::size_t scanned_bytes{0};
+  /// \brief True if the dirty pages are available (soft-dirty bits).
+  bool dirty_pages_available{false};
+  /// \brief The page counts of the whole segment.
+  page_counts total;
+  /// \brief The chunks that have any resident, dirty, or faulted page.
+  std::vector<chunk_page_statistics> chunks;
+  /// \brief The bins that have any chunk.
+  std::vector<bin_page_statistics> bins;
+  /// \brief The named and unique objects, if requested.
+  std::vector<object_page_statistics> objects;
+
+  /// \brief Returns the statistics as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{\"page_size\":" << page_size << ",\"chunk_size\":" << chunk_size
+       << ",\"scanned_bytes\":" << scanned_bytes
+       << ",\"dirty_pages_available\":"
+       << (dirty_pages_available ? "true" : "false") << ",\"total\":";
+    priv_write_counts(total, ss);
+    ss << ",\"chunks\":[";
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"chunk_no\":" << chunks[i].chunk_no
+         << ",\"bin_no\":" << chunks[i].bin_no << ",\"pages\":";
+      priv_write_counts(chunks[i].pages, ss);
+      ss << "}";
+    }
+    ss << "],\"bins\":[";
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"bin_no\":" << bins[i].bin_no
+         << ",\"object_size\":" << bins[i].object_size
+         << ",\"num_chunks\":" << bins[i].num_chunks << ",\"pages\":";
+      priv_write_counts(bins[i].pages, ss);
+      ss << "}";
+    }
+    ss << "],\"objects\":[";
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"name\":\"";
+      for (const char c : objects[i].name) {
+        if (c == '"' || c == '\\') ss << '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) ss << c;
+      }
+      ss << "\",\"bytes\":" << objects[i].bytes << ",\"pages\":";
+      priv_write_counts(objects[i].pages, ss);
+      ss << "}";
+    }
+    ss << "]}";
+    return ss.str();
+  }
+
+ private:
+  static void priv_write_counts(const page_counts &c, std::stringstream &ss) {
+    ss << "{\"resident_bytes\":" << c.resident_bytes
+       << ",\"dirty_bytes\":" << c.dirty_bytes
+       << ",\"faulted_bytes\":" << c.faulted_bytes << "}";
+  }
+};
+
+/// \brief Scans the page states of a region and keeps the resident pages
+/// to find the pages faulted between two scans.
+/// The states are kept in the process memory (two bits per page).
+/// This class is not thread-safe.
+class page_state_scanner {
+ public:
+  /// \brief Scans the pages of [addr, addr + size).
+  /// \param addr The beginning of the region. Must be page aligned.
+  /// \param size The size of the region.
+  /// \return Returns true on success; otherwise, false.
+  bool scan(const void *const addr, const std::size_t size) {
+    const auto page_size = mdtl::get_page_size();
+    if (page_size <= 0) return false;
+    m_page_size = page_size;
+    const std::size_t num_pages = (size + page_size - 1) / page_size;
+
+    // The pages out of the previous region were not resident
+    if (addr != m_addr || m_previously_resident.size() != num_pages) {
+      m_previously_resident.resize(num_pages, false);
+      if (addr != m_addr) {
+        std::fill(m_previously_resident.begin(), m_previously_resident.end(),
+                  false);
+      }
+    }
+    m_addr = addr;
+    m_resident.assign(num_pages, false);
+    m_dirty.assign(num_pages, false);
+
+    std::vector<unsigned char> vec(std::min(num_pages, k_window_pages));
+    for (std::size_t p = 0; p < num_pages; p += vec.size()) {
+      const auto n = std::min(vec.size(), num_pages - p);
+      if (::mincore(const_cast<char *>(static_cast<const char *>(addr)) +
+                        p * page_size,
+                    n * page_size, vec.data()) != 0) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "mincore");
+        return false;
+      }
+      for (std::size_t i = 0; i < n; ++i) m_resident[p + i] = vec[i] & 1;
+    }
+
+    m_dirty_available = mdtl::soft_dirty_bit_supported();
+    if (m_dirty_available) {
+      mdtl::pagemap_reader reader;
+      const uint64_t first_page_no =
+          reinterpret_cast<uint64_t>(addr) / page_size;
+      std::vector<uint64_t> buf(std::min(num_pages, k_window_pages));
+      for (std::size_t p = 0; p < num_pages; p += buf.size()) {
+        const auto n = std::min(buf.size(), num_pages - p);
+        if (!reader.read(first_page_no + p, n, buf.data())) {
+          m_dirty_available = false;
+          m_dirty.assign(num_pages, false);
+          break;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+          // Only the pages mapped in this process have the bits
+          m_dirty[p + i] = mdtl::check_present_page(buf[i]) &&
+                           mdtl::check_soft_dirty_page(buf[i]);
+        }
+      }
+    }
+
+    m_faulted.assign(num_pages, false);
+    for (std::size_t p = 0; p < num_pages; ++p) {
+      m_faulted[p] = m_resident[p] && !m_previously_resident[p];
+    }
+    m_previously_resident = m_resident;
+    return true;
+  }
+
+  /// \brief Returns the page counts of [offset, offset + size) of the
+  /// region scanned last. Partial pages at both ends are counted in full.
+  page_counts count(const std::size_t offset, const std::size_t size) const {
+    page_counts counts;
+    if (m_page_size == 0 || size == 0) return counts;
+    const std::size_t begin = offset / m_page_size;
+    const std::size_t end =
+        std::min((offset + size + m_page_size - 1) / m_page_size,
+                 m_resident.size());
+    for (std::size_t p = begin; p < end; ++p) {
+      counts.resident_bytes += m_resident[p] * m_page_size;
+      counts.dirty_bytes += m_dirty[p] * m_page_size;
+      counts.faulted_bytes += m_faulted[p] * m_page_size;
+    }
+    return counts;
+  }
+
+  std::size_t page_size() const { return m_page_size; }
+
+  bool dirty_pages_available() const { return m_dirty_available; }
+
+  /// \brief Forgets the resident pages found by the previous scan.
+  void reset() {
+    m_addr = nullptr;
+    m_previously_resident.clear();
+  }
+
+ private:
+  static constexpr std::size_t k_window_pages = 1ULL << 18ULL;
+
+  const void *m_addr{nullptr};
+  std::size_t m_page_size{0};
+  bool m_dirty_available{false};
+  std::vector<bool> m_previously_resident;
+  std::vector<bool> m_resident;
+  std::vector<bool> m_dirty;
+  std::vector<bool> m_faulted;
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_PAGE_STATISTICS_HPP
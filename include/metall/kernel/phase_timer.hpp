@@ -0,0 +1,216 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_PHASE_TIMER_HPP
+#define METALL_KERNEL_PHASE_TIMER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include <metall/logger.hpp>
+
+namespace metall::kernel {
+
+/// \brief Phases of the datastore operations timed by phase_timer.
+enum struct phase : uint32_t {
+  /// \brief A whole create call.
+  create,
+  /// \brief A whole open call (including the read-only and copy-on-write
+  /// modes).
+  open,
+  /// \brief Reading the management data files on open.
+  deserialize_management_data,
+  /// \brief Creating or mapping the segment files.
+  map_segment,
+  /// \brief Loading the segment allocator data (chunk and bin directories)
+  /// on the first allocation after open.
+  load_segment_allocator,
+  /// \brief Writing all management data files, e.g., on flush or close.
+  serialize_management_data,
+  /// \brief Writing the named object directory.
+  serialize_named_object_directory,
+  /// \brief Writing the unique object directory.
+  serialize_unique_object_directory,
+  /// \brief Writing the anonymous object directory.
+  serialize_anonymous_object_directory,
+  /// \brief Writing the segment allocator data.
+  serialize_segment_allocator,
+  /// \brief Syncing (msync) the segment.
+  sync_segment,
+  /// \brief A whole snapshot call.
+  snapshot,
+  /// \brief Copying the segment files, e.g., for a snapshot or copy.
+  /// Includes syncing the segment before taking a snapshot.
+  copy_segment,
+  /// \brief Copying the management data files for a snapshot.
+  copy_management_data,
+  num_phases
+};
+
+/// \brief The time spent in a phase.
+struct phase_timing {
+  /// \brief The number of times the phase was run.
+  uint64_t count{0};
+  /// \brief The total time in nanoseconds.
+  uint64_t total_ns{0};
+  /// \brief The longest time in nanoseconds.
+  uint64_t max_ns{0};
+  /// \brief The time the last run took in nanoseconds.
+  uint64_t last_ns{0};
+};
+
+/// \brief The time spent in each phase of a manager.
+struct phase_timings {
+  static constexpr std::size_t num_phases =
+      static_cast<std::size_t>(phase::num_phases);
+
+  std::array<phase_timing, num_phases> phases{};
+
+  /// \brief Returns the timing of phase 'p'.
+  const phase_timing &operator[](const phase p) const {
+    return phases[static_cast<std::size_t>(p)];
+  }
+
+  /// \brief Returns the name of phase 'p'.
+  static const char *name(const phase p) noexcept {
+    static constexpr const char *k_names[num_phases] = {
+        "create",
+        "open",
+        "deserialize_management_data",
+        "map_segment",
+        "load_segment_allocator",
+        "serialize_management_data",
+        "serialize_named_object_directory",
+        "serialize_unique_object_directory",
+        "serialize_anonymous_object_directory",
+        "serialize_segment_allocator",
+        "sync_segment",
+        "snapshot",
+        "copy_segment",
+        "copy_management_data"};
+    return k_names[static_cast<std::size_t>(p)];
+  }
+
+  /// \brief Returns the timings as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{";
+    for (std::size_t i = 0; i < num_phases; ++i) {
+      const auto &t = phases[i];
+      if (i > 0) ss << ",";
+      ss << "\"" << name(phase(i)) << "\":{\"count\":" << t.count
+         << ",\"total_ns\":" << t.total_ns << ",\"max_ns\":" << t.max_ns
+         << ",\"last_ns\":" << t.last_ns << "}";
+    }
+    ss << "}";
+    return ss.str();
+  }
+};
+
+/// \brief Counts the time spent in each phase with a few atomic operations
+/// per phase. Optionally logs each phase through the logger.
+/// This class is thread-safe.
+class phase_timer {
+ public:
+  /// \brief Adds the time from its construction to its destruction to a
+  /// phase.
+  class scope {
+   public:
+    scope(phase_timer *const timer, const phase p) noexcept
+        : m_timer(timer), m_phase(p), m_start(clock::now()) {}
+    scope(const scope &) = delete;
+    scope &operator=(const scope &) = delete;
+    ~scope() noexcept {
+      m_timer->add(m_phase,
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       clock::now() - m_start)
+                       .count());
+    }
+
+   private:
+    phase_timer *m_timer;
+    phase m_phase;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /// \brief Starts timing phase 'p'; the time is added when the returned
+  /// object is destructed.
+  scope measure(const phase p) noexcept { return scope(this, p); }
+
+  /// \brief Adds 'ns' nanoseconds to phase 'p'.
+  void add(const phase p, const uint64_t ns) noexcept {
+    auto &c = m_counters[static_cast<std::size_t>(p)];
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    c.last_ns.store(ns, std::memory_order_relaxed);
+    auto max = c.max_ns.load(std::memory_order_relaxed);
+    while (max < ns && !c.max_ns.compare_exchange_weak(
+                           max, ns, std::memory_order_relaxed)) {
+    }
+
+    const auto lvl = s_log_level.load(std::memory_order_relaxed);
+    if (lvl >= 0) {
+      std::stringstream ss;
+      ss << "Phase " << phase_timings::name(p) << " took " << ns / 1e6
+         << " ms";
+      logger::out(static_cast<logger::level>(lvl), __FILE__, __LINE__,
+                  ss.str().c_str());
+    }
+  }
+
+  /// \brief Returns the timings.
+  phase_timings get() const noexcept {
+    phase_timings timings;
+    for (std::size_t i = 0; i < phase_timings::num_phases; ++i) {
+      const auto &c = m_counters[i];
+      auto &t = timings.phases[i];
+      t.count = c.count.load(std::memory_order_relaxed);
+      t.total_ns = c.total_ns.load(std::memory_order_relaxed);
+      t.max_ns = c.max_ns.load(std::memory_order_relaxed);
+      t.last_ns = c.last_ns.load(std::memory_order_relaxed);
+    }
+    return timings;
+  }
+
+  /// \brief Resets the timings to 0.
+  void reset() noexcept {
+    for (auto &c : m_counters) {
+      c.count.store(0, std::memory_order_relaxed);
+      c.total_ns.store(0, std::memory_order_relaxed);
+      c.max_ns.store(0, std::memory_order_relaxed);
+      c.last_ns.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /// \brief Logs the time of each phase at 'lvl' when it finishes, in all
+  /// managers of the process. If std::nullopt, disables the logging
+  /// (default).
+  static void set_log_level(const std::optional<logger::level> lvl) noexcept {
+    s_log_level.store(lvl ? static_cast<int>(*lvl) : -1,
+                      std::memory_order_relaxed);
+  }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  struct counter {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> last_ns{0};
+  };
+
+  std::array<counter, phase_timings::num_phases> m_counters{};
+  static inline std::atomic<int> s_log_level{-1};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_PHASE_TIMER_HPP
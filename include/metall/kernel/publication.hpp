@@ -0,0 +1,130 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_PUBLICATION_HPP
+#define METALL_KERNEL_PUBLICATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+#include <metall/detail/memory.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/utilities.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief The versions of a datastore a writer process publishes to live
+/// reader processes.
+/// The state is kept in a small file mapped with MAP_SHARED by the writer and
+/// the readers, as the segment header is private to each process.
+/// A version is a pair of a version number and the segment size; the epoch
+/// counter is odd while the writer is updating the pair (a sequence lock).
+class publication {
+ public:
+  using version_type = uint64_t;
+
+  publication() noexcept = default;
+  ~publication() noexcept { close(); }
+
+  publication(const publication &) = delete;
+  publication &operator=(const publication &) = delete;
+
+  /// \brief Maps the publication file.
+  /// \param path The file path.
+  /// \param writable If true, the file is created if it does not exist and
+  /// mapped writable.
+  /// \return Returns true on success.
+  bool open(const fs::path &path, const bool writable) {
+    close();
+    const std::size_t size =
+        mdtl::round_up(sizeof(header_type), mdtl::get_page_size());
+    if (writable && !mdtl::file_exist(path) &&
+        (!mdtl::create_file(path) || !mdtl::extend_file_size(path, size))) {
+      std::stringstream ss;
+      ss << "Failed to create a publication file: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    if (mdtl::get_file_size(path) < ssize_t(size)) return false;
+
+    const auto [fd, addr] =
+        writable ? mdtl::map_file_write_mode(path, nullptr, size, 0)
+                 : mdtl::map_file_read_mode(path, nullptr, size, 0);
+    if (!addr) return false;
+    m_fd = fd;
+    m_header = static_cast<header_type *>(addr);
+    m_size = size;
+    return true;
+  }
+
+  /// \brief Unmaps the publication file.
+  void close() noexcept {
+    if (!m_header) return;
+    mdtl::munmap(m_fd, m_header, m_size, false);
+    m_fd = -1;
+    m_header = nullptr;
+    m_size = 0;
+  }
+
+  bool is_open() const noexcept { return m_header != nullptr; }
+
+  /// \brief Returns the latest version number; 0 if nothing is published.
+  version_type version() const noexcept {
+    return m_header->version.load(std::memory_order_acquire);
+  }
+
+  /// \brief Publishes a version. Only one process (thread) may call this.
+  /// The data written before this call is visible to the readers that read
+  /// the version.
+  void publish(const version_type version,
+               const std::size_t segment_size) noexcept {
+    const auto epoch = m_header->epoch.load(std::memory_order_relaxed);
+    m_header->epoch.store(epoch + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->version.store(version, std::memory_order_relaxed);
+    m_header->segment_size.store(segment_size, std::memory_order_relaxed);
+    m_header->epoch.store(epoch + 2, std::memory_order_release);
+  }
+
+  /// \brief Reads the latest version.
+  /// \return Returns false if the writer is updating the version; retry
+  /// later.
+  bool read(version_type *const version,
+            std::size_t *const segment_size) const noexcept {
+    const auto epoch = m_header->epoch.load(std::memory_order_acquire);
+    if (epoch % 2 == 1) return false;
+    *version = m_header->version.load(std::memory_order_relaxed);
+    *segment_size = m_header->segment_size.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_header->epoch.load(std::memory_order_relaxed) == epoch;
+  }
+
+ private:
+  struct header_type {
+    std::atomic<uint64_t> epoch;
+    std::atomic<version_type> version;
+    std::atomic<uint64_t> segment_size;
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "The counters are shared by processes");
+
+  int m_fd{-1};
+  header_type *m_header{nullptr};
+  std::size_t m_size{0};
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_PUBLICATION_HPP
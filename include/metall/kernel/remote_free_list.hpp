@@ -0,0 +1,121 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_REMOTE_FREE_LIST_HPP
+#define METALL_KERNEL_REMOTE_FREE_LIST_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace metall {
+namespace kernel {
+
+/// \brief Lock-free lists of the objects freed by threads that do not own
+/// the chunks of the objects, as the thread-free lists of mimalloc.
+/// Any thread pushes an object onto the list of the owner; the owner takes
+/// the whole list at once. As objects are only pushed one by one and taken
+/// all together, the lists do not suffer from the ABA problem.
+/// The link to the next object is stored in the freed object itself; thus,
+/// an object must be at least as large as an offset.
+/// \tparam difference_type The offset type.
+template <typename difference_type>
+class remote_free_list {
+ public:
+  /// \brief Constructor.
+  /// \param num_lists The number of lists.
+  /// \param null_offset The offset that means no object.
+  remote_free_list(const std::size_t num_lists,
+                   const difference_type null_offset)
+      : m_num_lists(num_lists),
+        m_null_offset(null_offset),
+        m_heads(std::make_unique<head_type[]>(num_lists)) {
+    for (std::size_t i = 0; i < m_num_lists; ++i) {
+      m_heads[i].offset.store(m_null_offset, std::memory_order_relaxed);
+    }
+  }
+
+  ~remote_free_list() noexcept = default;
+  remote_free_list(const remote_free_list &) = delete;
+  remote_free_list &operator=(const remote_free_list &) = delete;
+  remote_free_list(remote_free_list &&) noexcept = default;
+  remote_free_list &operator=(remote_free_list &&) noexcept = default;
+
+  /// \brief Pushes an object. Can be called concurrently.
+  /// \param list_no A list number.
+  /// \param offset The offset of the object.
+  /// \param base The address offsets are relative to.
+  void push(const std::size_t list_no, const difference_type offset,
+            void *const base) {
+    assert(list_no < m_num_lists);
+    auto &head = m_heads[list_no].offset;
+    difference_type next = head.load(std::memory_order_relaxed);
+    do {
+      priv_store_next(base, offset, next);
+    } while (!head.compare_exchange_weak(next, offset,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
+  }
+
+  /// \brief Returns true if a list looks empty. Does not synchronize.
+  bool empty(const std::size_t list_no) const {
+    assert(list_no < m_num_lists);
+    return m_heads[list_no].offset.load(std::memory_order_relaxed) ==
+           m_null_offset;
+  }
+
+  /// \brief Takes all objects in a list. Can be called concurrently.
+  /// \return The first object; the rest follow by next().
+  /// null_offset if the list is empty.
+  difference_type take_all(const std::size_t list_no) {
+    assert(list_no < m_num_lists);
+    if (empty(list_no)) return m_null_offset;
+    return m_heads[list_no].offset.exchange(m_null_offset,
+                                            std::memory_order_acquire);
+  }
+
+  /// \brief Returns the object after 'offset' in a list taken by take_all().
+  difference_type next(const difference_type offset,
+                       const void *const base) const {
+    difference_type next;
+    std::memcpy(&next, static_cast<const char *>(base) + offset, sizeof(next));
+    return next;
+  }
+
+  /// \brief Calls 'func(offset)' for each object in a list.
+  /// Must not be called while other threads push or take objects.
+  template <typename function_type>
+  void for_each(const std::size_t list_no, const void *const base,
+                function_type func) const {
+    assert(list_no < m_num_lists);
+    for (auto offset = m_heads[list_no].offset.load(std::memory_order_acquire);
+         offset != m_null_offset; offset = next(offset, base)) {
+      func(offset);
+    }
+  }
+
+  std::size_t num_lists() const { return m_num_lists; }
+
+ private:
+  struct alignas(64) head_type {
+    std::atomic<difference_type> offset;
+  };
+
+  static void priv_store_next(void *const base, const difference_type offset,
+                              const difference_type next) {
+    std::memcpy(static_cast<char *>(base) + offset, &next, sizeof(next));
+  }
+
+  std::size_t m_num_lists;
+  difference_type m_null_offset;
+  std::unique_ptr<head_type[]> m_heads;
+};
+
+}  // namespace kernel
+}  // namespace metall
+
+#endif  // METALL_KERNEL_REMOTE_FREE_LIST_HPP
@@ -7,7 +7,10 @@
 #define METALL_KERNEL_SEGMENT_ALLOCATOR_HPP
 
 #include <iostream>
+#include <atomic>
 #include <cassert>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <memory>
@@ -16,19 +19,66 @@
 #include <limits>
 #include <set>
 #include <filesystem>
+#include <thread>
 
+#include <metall/defs.hpp>
+#include <metall/manager_options.hpp>
+#include <metall/kernel/allocation_counters.hpp>
 #include <metall/kernel/bin_number_manager.hpp>
 #include <metall/kernel/bin_directory.hpp>
+#include <metall/kernel/bitmap_bin.hpp>
 #include <metall/kernel/chunk_directory.hpp>
+#include <metall/kernel/chunk_operation_log.hpp>
+#include <metall/kernel/concurrency_policy.hpp>
+#include <metall/kernel/medium_object_directory.hpp>
+#include <metall/kernel/memory_statistics.hpp>
 #include <metall/kernel/object_size_manager.hpp>
+#include <metall/kernel/segment_storage_concept.hpp>
 #include <metall/detail/char_ptr_holder.hpp>
 #include <metall/detail/utilities.hpp>
+#include <metall/detail/proc.hpp>
+#include <metall/detail/io_executor.hpp>
+#include <metall/detail/hash.hpp>
 #include <metall/logger.hpp>
+#include <metall/tracing.hpp>
 
 #ifndef METALL_DISABLE_CONCURRENCY
 #define METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
 #endif
 
+#if defined(METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR) && \
+    defined(METALL_USE_CONCURRENT_SLOT_CLAIM)
+#define METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+#endif
+
+#if defined(METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR) && \
+    !defined(METALL_DISABLE_OBJECT_CACHE) &&              \
+    defined(METALL_USE_BACKGROUND_OBJECT_CACHE_TRIMMING)
+#define METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+#endif
+
+#ifdef METALL_USE_ALLOCATION_SAMPLING
+#define METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+#endif
+
+#ifdef METALL_USE_DEFERRED_CHUNK_RELEASE
+#define METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+#endif
+
+#if defined(METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR) && \
+    !defined(METALL_DISABLE_OBJECT_CACHE) && defined(METALL_USE_REMOTE_FREE)
+#define METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+#endif
+
+#ifdef METALL_USE_MEDIUM_OBJECT_SLABS
+#define METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+#endif
+
+#if !defined(METALL_DISABLE_OBJECT_CACHE) && \
+    defined(METALL_USE_OBJECT_CACHE_PREFILL)
+#define METALL_ENABLE_OBJECT_CACHE_PREFILL_IN_SEGMENT_ALLOCATOR
+#endif
+
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
 #include <metall/detail/mutex.hpp>
 #endif
@@ -37,6 +87,23 @@
 #include <metall/kernel/object_cache.hpp>
 #endif
 
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+#include <chrono>
+#include <metall/kernel/object_cache_trimmer.hpp>
+#endif
+
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+#include <metall/kernel/allocation_sampler.hpp>
+#endif
+
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+#include <metall/kernel/chunk_release_queue.hpp>
+#endif
+
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+#include <metall/kernel/remote_free_list.hpp>
+#endif
+
 namespace metall {
 namespace kernel {
 
@@ -47,7 +114,9 @@ namespace mdtl = metall::mtlldetail;
 
 template <typename _chunk_no_type, typename _size_type,
           typename _difference_type, std::size_t _chunk_size,
-          std::size_t _max_size, typename _segment_storage_type>
+          std::size_t _max_size, typename _segment_storage_type,
+          typename _size_class_table = default_size_class_table,
+          typename _concurrency_policy = default_concurrency_policy>
 class segment_allocator {
  public:
   // -------------------- //
@@ -61,6 +130,11 @@ class segment_allocator {
   static constexpr difference_type k_null_offset =
       std::numeric_limits<difference_type>::max();
   using segment_storage_type = _segment_storage_type;
+  using concurrency_policy = _concurrency_policy;
+  static constexpr size_type k_num_placement_hints =
+      METALL_NUM_PLACEMENT_HINTS;
+  static constexpr size_type k_no_placement_hint =
+      std::numeric_limits<size_type>::max();
 
  private:
   // -------------------- //
@@ -71,10 +145,16 @@ class segment_allocator {
 
   using myself =
       segment_allocator<_chunk_no_type, size_type, difference_type, _chunk_size,
-                        _max_size, _segment_storage_type>;
+                        _max_size, _segment_storage_type, _size_class_table,
+                        _concurrency_policy>;
+
+  // If false, this allocator is used by one thread at a time; thus, the locks
+  // are compiled away, and the threads are not spread over arenas and caches
+  static constexpr bool k_thread_safe = concurrency_policy::k_thread_safe;
 
   // For bin
-  using bin_no_mngr = bin_number_manager<k_chunk_size, k_max_size>;
+  using bin_no_mngr =
+      bin_number_manager<k_chunk_size, k_max_size, _size_class_table>;
   using bin_no_type = typename bin_no_mngr::bin_no_type;
   static constexpr size_type k_num_small_bins = bin_no_mngr::num_small_bins();
 
@@ -87,20 +167,77 @@ class segment_allocator {
       "non_full_chunk_bin";
 
   // For chunk directory
-  using chunk_directory_type =
-      chunk_directory<chunk_no_type, k_chunk_size, k_max_size>;
+  using chunk_directory_type = chunk_directory<chunk_no_type, k_chunk_size,
+                                               k_max_size, _size_class_table>;
   using chunk_slot_no_type = typename chunk_directory_type::slot_no_type;
+  using chunk_slot_list_type = typename chunk_directory_type::slot_list_type;
   static constexpr const char *k_chunk_directory_file_name = "chunk_directory";
 
+  // For medium objects
+  // The objects larger than k_medium_object_min_size and up to
+  // k_medium_object_max_size are cut from slabs of k_medium_slab_size bytes,
+  // which are large objects, instead of taking a small-object chunk that
+  // holds only a few slots or a whole large object.
+  // The directory type is also used when the medium objects are not enabled
+  // to refuse a data store that has them.
+  using medium_object_directory_type =
+      medium_object_directory<difference_type, size_type>;
+  static constexpr const char *k_medium_object_directory_file_name =
+      "medium_object_directory";
+  // The number of the cached objects of each bin (see
+  // METALL_USE_OBJECT_CACHE_PREFILL)
+  static constexpr const char *k_object_cache_summary_file_name =
+      "object_cache_summary";
+  static constexpr size_type k_medium_object_min_size = k_chunk_size / 32;
+  static constexpr size_type k_medium_object_max_size = k_chunk_size * 2;
+  static constexpr size_type k_medium_object_granule = k_chunk_size / 512;
+  static constexpr size_type k_medium_slab_size = k_chunk_size * 8;
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+  static_assert(k_medium_slab_size <= k_max_size,
+                "A medium object slab must be a large object");
+#endif
+  using chunk_operation = chunk_operation_log::operation;
+
+  // For arenas
+  // Each arena has its own non-full chunk bins, i.e., a small object chunk is
+  // owned by a single arena.
+  // Each placement hint has its own arena after the thread arenas so that
+  // the small objects allocated with the same hint share chunks.
+  using arena_no_type = typename chunk_directory_type::arena_no_type;
+  static constexpr size_type k_num_thread_arenas = METALL_NUM_ARENAS;
+  static_assert(k_num_thread_arenas >= 1,
+                "METALL_NUM_ARENAS must be at least 1");
+  static constexpr size_type k_num_arenas =
+      k_num_thread_arenas + k_num_placement_hints;
+  static_assert(k_num_arenas - 1 <= std::numeric_limits<arena_no_type>::max(),
+                "METALL_NUM_ARENAS + METALL_NUM_PLACEMENT_HINTS is too large");
+
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+  // A list per (thread arena, small bin)
+  using remote_free_list_type = remote_free_list<difference_type>;
+  static_assert(sizeof(difference_type) <= 8,
+                "A small object must be able to hold an offset");
+#endif
+
   // For object cache
 #ifndef METALL_DISABLE_OBJECT_CACHE
   using small_object_cache_type =
-      object_cache<size_type, difference_type, bin_no_mngr, myself>;
+      object_cache<size_type, difference_type, bin_no_mngr, myself,
+                   concurrency_policy>;
 #endif
 
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-  using mutex_type = mdtl::mutex;
-  using lock_guard_type = mdtl::mutex_lock_guard;
+  using mutex_type = ccpdtl::mutex<concurrency_policy>;
+  using lock_guard_type = std::lock_guard<mutex_type>;
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+  // Slots are claimed while holding a bin lock in shared mode
+  using bin_mutex_type = ccpdtl::shared_mutex<concurrency_policy>;
+  using bin_lock_guard_type = std::lock_guard<bin_mutex_type>;
+  using bin_shared_lock_guard_type = std::shared_lock<bin_mutex_type>;
+#else
+  using bin_mutex_type = mutex_type;
+  using bin_lock_guard_type = lock_guard_type;
+#endif
 #endif
 
   // Threshold to enable the many allocation feature internally
@@ -110,23 +247,55 @@ class segment_allocator {
   // -------------------- //
   // Constructor & assign operator
   // -------------------- //
-  explicit segment_allocator(segment_storage_type *segment_storage)
+  explicit segment_allocator(segment_storage_type *segment_storage,
+                             const manager_options &options = {})
       : m_non_full_chunk_bin(),
         m_chunk_directory(k_max_size / k_chunk_size),
-        m_segment_storage(segment_storage)
+        m_segment_storage(segment_storage),
+        m_free_small_object_size_hint(options.free_small_object_size_hint),
+        m_segment_size_soft_limit(options.segment_size_soft_limit),
+        m_segment_size_hard_limit(options.segment_size_hard_limit),
+        m_counters(bin_no_mngr::num_bins())
 #ifndef METALL_DISABLE_OBJECT_CACHE
         ,
-        m_object_cache()
+        m_object_cache(options.max_per_cpu_cache_size,
+                       options.num_caches_per_cpu)
+#endif
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+        ,
+        m_remote_free_list(k_num_thread_arenas * k_num_small_bins,
+                           k_null_offset)
+#endif
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+        ,
+        m_medium_object_directory(k_medium_object_granule, k_null_offset)
 #endif
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
         ,
         m_chunk_mutex(nullptr),
+        m_segment_mutex(nullptr),
         m_bin_mutex(nullptr)
 #endif
   {
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
     m_chunk_mutex = std::make_unique<mutex_type>();
-    m_bin_mutex = std::make_unique<std::array<mutex_type, k_num_small_bins>>();
+    m_segment_mutex = std::make_unique<mutex_type>();
+    m_bin_mutex = std::make_unique<
+        std::array<bin_mutex_type, k_num_small_bins * k_num_arenas>>();
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    m_medium_object_mutex = std::make_unique<mutex_type>();
+#endif
+#endif
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    // The trimmer thread would access the cache without the locks
+    if constexpr (k_thread_safe) {
+      m_object_cache_trimmer = std::make_unique<object_cache_trimmer>(
+          std::chrono::milliseconds(METALL_OBJECT_CACHE_TRIMMING_INTERVAL_MS),
+          [this]() {
+            m_object_cache.trim(
+                this, &myself::priv_deallocate_small_objects_from_global);
+          });
+    }
 #endif
   }
 
@@ -135,8 +304,14 @@ class segment_allocator {
   segment_allocator(const segment_allocator &) = delete;
   segment_allocator &operator=(const segment_allocator &) = delete;
 
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+  // The trimmer thread refers to this object
+  segment_allocator(segment_allocator &&) = delete;
+  segment_allocator &operator=(segment_allocator &&) = delete;
+#else
   segment_allocator(segment_allocator &&) noexcept = default;
   segment_allocator &operator=(segment_allocator &&) noexcept = default;
+#endif
 
  public:
   // -------------------- //
@@ -145,26 +320,64 @@ class segment_allocator {
 
   /// \brief Allocates memory space
   /// \param nbytes
+  /// \param zero_filled If not nullptr, set to true if the allocated memory
+  /// is known to be filled with zeros, i.e., a large object placed in chunks
+  /// that have never been used since the datastore was created or opened or
+  /// whose file space has been freed. False does not mean the memory is not
+  /// zero-filled.
   /// \return The offset of an allocated memory.
   /// On error, k_null_offset is returned.
-  difference_type allocate(const size_type nbytes) {
-    if (nbytes == 0) return k_null_offset;
-    const bin_no_type bin_no = bin_no_mngr::to_bin_no(nbytes);
+  difference_type allocate(const size_type nbytes,
+                           bool *const zero_filled = nullptr) {
+    return priv_allocate(nbytes, zero_filled, true);
+  }
 
-    const auto offset = (priv_small_object_bin(bin_no))
-                            ? priv_allocate_small_object(bin_no)
-                            : priv_allocate_large_object(bin_no);
-    assert(offset >= 0 || offset == k_null_offset);
+  /// \brief Sets the segment size limits. See manager_options.
+  /// Must not be called concurrently with allocations.
+  /// \param soft_limit A soft limit in bytes; 0 disables it.
+  /// \param hard_limit A hard limit in bytes; 0 disables it.
+  void set_segment_size_limits(const size_type soft_limit,
+                               const size_type hard_limit) {
+    m_segment_size_soft_limit = soft_limit;
+    m_segment_size_hard_limit = hard_limit;
+  }
 
-    return offset;
+  /// \brief Sets a function called when the segment reaches a size limit.
+  /// Must not be called concurrently with allocations.
+  void set_segment_limit_handler(segment_limit_handler handler) {
+    m_segment_limit_handler = std::move(handler);
+  }
+
+  /// \brief Sets the placement hint of the calling thread.
+  /// While a hint is set, the small objects the thread allocates are taken
+  /// from the chunks of the arena of the hint, bypassing the object cache,
+  /// and the objects freed into such chunks are returned to the arena
+  /// directly. Large objects are not affected.
+  /// The hint is shared by all allocators of this type in the thread.
+  /// \param hint A hint in [0, k_num_placement_hints) or k_no_placement_hint
+  /// to clear the hint.
+  /// \return Returns false if the hint is out of range.
+  static bool set_placement_hint(const size_type hint) {
+    if (hint != k_no_placement_hint && hint >= k_num_placement_hints) {
+      return false;
+    }
+    priv_placement_hint() = hint;
+    return true;
   }
 
+  /// \brief Returns the placement hint of the calling thread.
+  /// Returns k_no_placement_hint if no hint is set.
+  static size_type placement_hint() { return priv_placement_hint(); }
+
   /// \brief Allocate nbytes bytes of uninitialized storage whose alignment is
   /// specified by alignment. Note that this function adjusts an alignment only
   /// within this segment, i.e., this function does not know the address this
   /// segment is mapped to. \param nbytes A size to allocate. Must be a multiple
-  /// of alignment. \param alignment An alignment requirement. Alignment must be
-  /// a power of two and satisfy [min allocation size, system page size].
+  /// of alignment if alignment is not larger than the chunk size.
+  /// \param alignment An alignment requirement. Alignment must be a power of
+  /// two and equal to or larger than the min allocation size. An alignment
+  /// larger than the chunk size is given by placing a large object at an
+  /// aligned chunk.
   /// \return On success, returns the pointer to the beginning of newly
   /// allocated memory. Returns k_null_offset, if the given arguments do not
   /// satisfy the requirements above.
@@ -184,9 +397,8 @@ class segment_allocator {
       return k_null_offset;
     }
 
-    // This requirement could be removed, but it would need some work to do
     if (alignment > k_chunk_size) {
-      return k_null_offset;
+      return priv_allocate_aligned_large_object(nbytes, alignment);
     }
 
     // nbytes must be a multiple of alignment
@@ -199,8 +411,10 @@ class segment_allocator {
                alignment == 0);
 
     // As long as the above requirements are satisfied, just calling the normal
-    // allocate function is enough
-    const auto offset = allocate(nbytes);
+    // allocate function is enough; medium objects are aligned only to their
+    // granule
+    const auto offset =
+        priv_allocate(nbytes, nullptr, alignment <= k_medium_object_granule);
     assert(offset % alignment == 0 || offset == k_null_offset);
 
     return offset;
@@ -216,32 +430,357 @@ class segment_allocator {
     const bin_no_type bin_no = m_chunk_directory.bin_no(chunk_no);
 
     if (priv_small_object_bin(bin_no)) {
+      m_counters.add_objects(bin_no, -1);
       priv_deallocate_small_object(offset, bin_no);
-    } else {
+    } else if (!priv_deallocate_medium_object(offset)) {
+      m_counters.add_objects(bin_no, -1);
       priv_deallocate_large_object(chunk_no, bin_no);
     }
   }
 
+  /// \brief Deallocates an object whose allocation size is known.
+  /// Unlike deallocate(offset), this function computes the bin number from
+  /// 'nbytes' instead of reading the chunk directory; thus, deallocations
+  /// served by the object cache do not touch the chunk directory.
+  /// \param offset The offset of the object to deallocate.
+  /// \param nbytes The size passed to allocate() when the object was
+  /// allocated.
+  void deallocate(const difference_type offset, const size_type nbytes) {
+    if (offset == k_null_offset) return;
+    assert(offset >= 0);
+    if (nbytes == 0) {
+      // An object cannot be allocated with 0 bytes
+      deallocate(offset);
+      return;
+    }
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    if (priv_medium_object_size(nbytes)) {
+      // Could have been allocated as a small object by allocate_aligned()
+      if (!priv_deallocate_medium_object(offset)) deallocate(offset);
+      return;
+    }
+#endif
+
+    const bin_no_type bin_no = bin_no_mngr::to_bin_no(nbytes);
+    assert(bin_no == m_chunk_directory.bin_no(offset / k_chunk_size));
+
+    m_counters.add_objects(bin_no, -1);
+    if (priv_small_object_bin(bin_no)) {
+      priv_deallocate_small_object(offset, bin_no);
+    } else {
+      priv_deallocate_large_object(offset / k_chunk_size, bin_no);
+    }
+  }
+
+  /// \brief Tries to change the size of an allocated object without moving
+  /// it. A large object grows if the chunks right after it are unused and
+  /// shrinks by releasing its tail chunks. A medium object grows into the
+  /// free space right after it in its slab and shrinks by freeing its tail.
+  /// \param offset The offset of an allocated object.
+  /// \param nbytes The new size of the object.
+  /// \return Returns true if the object now has the size of 'nbytes' bytes at
+  /// the same offset. Returns false if it has to be moved; in that case, the
+  /// object is not changed.
+  bool resize_in_place(const difference_type offset, const size_type nbytes) {
+    if (offset == k_null_offset || nbytes == 0) return false;
+    assert(offset >= 0);
+
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type medium_guard(*m_medium_object_mutex);
+#endif
+      const auto old_size = m_medium_object_directory.object_size(offset);
+      if (old_size > 0) {
+        if (!priv_medium_object_size(nbytes) ||
+            !m_medium_object_directory.resize(offset, nbytes)) {
+          return false;
+        }
+        m_counters.add_medium_objects(
+            0, difference_type(m_medium_object_directory.object_size(offset)) -
+                   difference_type(old_size));
+        return true;
+      }
+    }
+#endif
+
+    const chunk_no_type chunk_no = offset / k_chunk_size;
+    const bin_no_type old_bin_no = m_chunk_directory.bin_no(chunk_no);
+    const bin_no_type new_bin_no = bin_no_mngr::to_bin_no(nbytes);
+    if (old_bin_no == new_bin_no) return true;
+    if (priv_small_object_bin(old_bin_no) ||
+        priv_small_object_bin(new_bin_no)) {
+      return false;
+    }
+
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    if (!priv_resize_large_object_without_lock(chunk_no, old_bin_no,
+                                               new_bin_no)) {
+      return false;
+    }
+    m_counters.add_objects(old_bin_no, -1);
+    m_counters.add_objects(new_bin_no, 1);
+    return true;
+  }
+
+  /// \brief Returns the size of the memory space allocated for an object,
+  /// which can be larger than the size requested.
+  /// \param offset The offset of an allocated object.
+  /// \return The size of the memory space.
+  size_type allocated_size(const difference_type offset) const {
+    assert(offset >= 0 && offset != k_null_offset);
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type medium_guard(*m_medium_object_mutex);
+#endif
+      const auto size = m_medium_object_directory.object_size(offset);
+      if (size > 0) return size;
+    }
+#endif
+    return bin_no_mngr::to_object_size(
+        m_chunk_directory.bin_no(offset / k_chunk_size));
+  }
+
+  /// \brief Allocates 'num_allocates' objects of 'nbytes' bytes at once.
+  /// Small objects are allocated from the non-full chunks directly, taking
+  /// the bin lock only once, i.e., the object cache is not used.
+  /// \param nbytes The size of each object.
+  /// \param num_allocates The number of objects to allocate.
+  /// \param allocated_offsets A buffer to store the offsets of the allocated
+  /// objects. Must be able to hold 'num_allocates' elements.
+  /// \return The number of allocated objects. The offsets of allocated objects
+  /// are stored from the front of 'allocated_offsets' and the rest of the
+  /// elements are set to k_null_offset.
+  size_type allocate_many(const size_type nbytes, const size_type num_allocates,
+                          difference_type *const allocated_offsets) {
+    if (num_allocates == 0 || !allocated_offsets) return 0;
+    std::fill_n(allocated_offsets, num_allocates, k_null_offset);
+    if (nbytes == 0) return 0;
+
+    const bin_no_type bin_no = bin_no_mngr::to_bin_no(nbytes);
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    if (priv_medium_object_size(nbytes)) {
+      for (size_type i = 0; i < num_allocates; ++i) {
+        allocated_offsets[i] = priv_allocate_medium_object(nbytes);
+        if (allocated_offsets[i] == k_null_offset) break;
+      }
+    } else
+#endif
+    if (priv_small_object_bin(bin_no)) {
+      priv_allocate_small_objects_from_global(bin_no, num_allocates,
+                                              allocated_offsets);
+    } else {
+      for (size_type i = 0; i < num_allocates; ++i) {
+        allocated_offsets[i] = priv_allocate_large_object(bin_no);
+        if (allocated_offsets[i] == k_null_offset) break;
+      }
+    }
+
+    // Make sure that allocated offsets are stored from the front
+    size_type num_allocated = 0;
+    for (size_type i = 0; i < num_allocates; ++i) {
+      if (allocated_offsets[i] == k_null_offset) continue;
+      std::swap(allocated_offsets[num_allocated], allocated_offsets[i]);
+      ++num_allocated;
+    }
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    // Medium objects are counted as they are allocated
+    if (!priv_medium_object_size(nbytes))
+#endif
+      m_counters.add_objects(bin_no, num_allocated);
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+    if (num_allocated > 0 &&
+        m_allocation_sampler.sample(nbytes * num_allocated)) {
+      m_allocation_sampler.record(nbytes, num_allocated, bin_no);
+    }
+#endif
+    return num_allocated;
+  }
+
+  /// \brief Deallocates multiple objects at once.
+  /// Consecutive small objects of the same size are deallocated taking the bin
+  /// lock only once, i.e., the object cache is not used.
+  /// \param offsets The offsets of the objects to deallocate.
+  /// k_null_offset elements are ignored.
+  /// \param num_deallocates The number of elements in 'offsets'.
+  void deallocate_many(const difference_type *const offsets,
+                       const size_type num_deallocates) {
+    if (!offsets) return;
+
+    size_type i = 0;
+    while (i < num_deallocates) {
+      if (offsets[i] == k_null_offset) {
+        ++i;
+        continue;
+      }
+      assert(offsets[i] >= 0);
+      const bin_no_type bin_no =
+          m_chunk_directory.bin_no(offsets[i] / k_chunk_size);
+      if (!priv_small_object_bin(bin_no)) {
+        if (!priv_deallocate_medium_object(offsets[i])) {
+          m_counters.add_objects(bin_no, -1);
+          priv_deallocate_large_object(offsets[i] / k_chunk_size, bin_no);
+        }
+        ++i;
+        continue;
+      }
+
+      // Find the run of objects in the same bin
+      size_type end = i + 1;
+      difference_type num_objects = 1;
+      for (; end < num_deallocates; ++end) {
+        if (offsets[end] == k_null_offset) continue;
+        if (m_chunk_directory.bin_no(offsets[end] / k_chunk_size) != bin_no) {
+          break;
+        }
+        ++num_objects;
+      }
+      m_counters.add_objects(bin_no, -num_objects);
+      priv_deallocate_small_objects_from_global(bin_no, end - i, &offsets[i]);
+      i = end;
+    }
+  }
+
   /// \brief Checks if all memory is deallocated.
-  /// This function is not cheap if many objects are allocated.
+  /// Reads the allocation counters, i.e., does not scan the chunk directory.
   /// \return Returns true if all memory is deallocated.
   bool all_memory_deallocated() const {
+    if (m_counters.total_objects() != 0) return false;
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type medium_guard(*m_medium_object_mutex);
+#endif
+      // Space reserved by recover() is never deallocated
+      if (!m_medium_object_directory.empty()) return false;
+    }
+#endif
+    assert(priv_all_memory_deallocated_by_scan());
+    return true;
+  }
+
+  /// \brief Reads the allocation counters.
+  /// Unlike get_statistics(), this function does not scan the chunk
+  /// directory and can be called while other threads allocate or deallocate
+  /// objects, in which case each counter is read at some point during the
+  /// call. The objects in the object cache are not counted as allocated.
+  /// \param counters A pointer to an object to store the counters.
+  void get_counters(memory_counters *const counters) const {
+    counters->chunk_size = k_chunk_size;
+    counters->num_objects = 0;
+    counters->allocated_bytes = 0;
+    counters->num_used_chunks = 0;
+    counters->bins.clear();
+    for (bin_no_type bin_no = 0; bin_no < bin_no_mngr::num_bins(); ++bin_no) {
+      bin_counters bin;
+      bin.bin_no = bin_no;
+      bin.object_size = bin_no_mngr::to_object_size(bin_no);
+      bin.num_objects = priv_non_negative(m_counters.objects(bin_no));
+      bin.num_chunks = priv_non_negative(m_counters.chunks(bin_no));
+      if (bin.num_objects == 0 && bin.num_chunks == 0) continue;
+      counters->num_objects += bin.num_objects;
+      counters->allocated_bytes += bin.num_objects * bin.object_size;
+      counters->num_used_chunks += bin.num_chunks;
+      counters->bins.push_back(bin);
+    }
+    counters->num_medium_objects =
+        priv_non_negative(m_counters.medium_objects());
+    counters->medium_allocated_bytes =
+        priv_non_negative(m_counters.medium_bytes());
+    counters->num_objects += counters->num_medium_objects;
+    counters->allocated_bytes += counters->medium_allocated_bytes;
+    counters->freed_bytes = priv_non_negative(m_counters.freed_bytes());
+  }
+
+  /// \brief Records in the chunk directory whether each used chunk has been
+  /// accessed since the previous access sample (see
+  /// chunk_directory::record_access()).
+  /// \param accessed A function that takes a chunk number and returns true
+  /// if the chunk has been accessed.
+  template <typename function_type>
+  void record_chunk_accesses(function_type accessed) {
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
     lock_guard_type chunk_guard(*m_chunk_mutex);
 #endif
+    for (chunk_no_type chunk_no = 0; chunk_no < m_chunk_directory.size();
+         ++chunk_no) {
+      if (m_chunk_directory.unused_chunk(chunk_no)) continue;
+      m_chunk_directory.record_access(chunk_no, accessed(chunk_no));
+    }
+  }
 
-    if (m_chunk_directory.size() == 0) {
-      return true;
+  /// \brief Returns the access heat of a chunk (see chunk_directory::heat()).
+  /// Returns 0 for an unused chunk.
+  uint8_t chunk_heat(const chunk_no_type chunk_no) const {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    if (chunk_no >= m_chunk_directory.size() ||
+        m_chunk_directory.unused_chunk(chunk_no)) {
+      return 0;
     }
+    return m_chunk_directory.heat(chunk_no);
+  }
 
-#ifndef METALL_DISABLE_OBJECT_CACHE
-    if (priv_check_all_small_allocations_are_cached_without_lock() &&
-        m_chunk_directory.num_used_large_chunks() == 0) {
-      return true;
+  /// \brief Counts the hot, warm, and cold chunks.
+  /// \param stats A pointer to store the counts; the number of samples is
+  /// not set.
+  void get_chunk_heat(chunk_heat_statistics *const stats) const {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    stats->chunk_size = k_chunk_size;
+    stats->num_used_chunks = 0;
+    stats->num_hot_chunks = 0;
+    stats->num_warm_chunks = 0;
+    stats->num_cold_chunks = 0;
+    for (chunk_no_type chunk_no = 0; chunk_no < m_chunk_directory.size();
+         ++chunk_no) {
+      if (m_chunk_directory.unused_chunk(chunk_no)) continue;
+      ++stats->num_used_chunks;
+      const auto heat = m_chunk_directory.heat(chunk_no);
+      if (heat & 0x80U) {
+        ++stats->num_hot_chunks;
+      } else if (heat != 0) {
+        ++stats->num_warm_chunks;
+      } else {
+        ++stats->num_cold_chunks;
+      }
     }
+  }
+
+  /// \brief Compacts the memory space used by small objects.
+  /// Gives back the memory pages of small-object chunks that hold no objects
+  /// and reorders the non-full chunk bins so that new small objects go to the
+  /// fullest chunks first; sparsely occupied chunks are left to drain and
+  /// are freed as a whole once they become empty.
+  /// Objects do not move and objects in the object cache are kept.
+  /// This function takes one bin lock at a time, i.e., other threads can
+  /// allocate and deallocate objects during the compaction.
+  void compact() {
+    for (size_type arena_no = 0; arena_no < k_num_arenas; ++arena_no) {
+      for (bin_no_type bin_no = 0; bin_no < k_num_small_bins; ++bin_no) {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+        bin_lock_guard_type bin_guard(priv_bin_mutex(arena_no, bin_no));
+#endif
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+        priv_pop_full_front_chunks_without_bin_lock(arena_no, bin_no);
 #endif
+        priv_compact_bin_without_bin_lock(arena_no, bin_no);
+      }
+    }
+  }
 
-    return false;
+  /// \brief Stops the background tasks, e.g., trimming the object cache.
+  /// Must be called before the segment storage is released.
+  /// The tasks are not restarted.
+  void stop_background_tasks() noexcept {
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    if (m_object_cache_trimmer) m_object_cache_trimmer->stop();
+#endif
   }
 
   /// \brief Returns the size of the segment being used.
@@ -254,22 +793,55 @@ class segment_allocator {
   /// \param base_path
   /// \return
   bool serialize(const fs::path &base_path) {
-#ifndef METALL_DISABLE_OBJECT_CACHE
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+    priv_release_queued_chunks();
+#endif
+    const chunk_slot_list_type *released_slots = nullptr;
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    const auto trimmer_pause = priv_pause_object_cache_trimmer();
+#endif
+#ifdef METALL_ENABLE_OBJECT_CACHE_PREFILL_IN_SEGMENT_ALLOCATOR
+    // Must be taken before the cache is drained
+    if (!priv_serialize_object_cache_summary(
+            priv_make_file_name(base_path, k_object_cache_summary_file_name))) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to serialize object cache summary");
+      return false;
+    }
+#endif
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    // Store the cached objects as free objects, without draining the cache
+    const auto cached_slots = priv_get_cached_slots();
+    released_slots = &cached_slots;
+#elif !defined(METALL_DISABLE_OBJECT_CACHE)
     priv_clear_object_cache();
 #endif
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+    priv_pop_all_full_front_chunks();
+#endif
 
-    if (!m_non_full_chunk_bin.serialize(
-            priv_make_file_name(base_path, k_non_full_chunk_bin_file_name))) {
+    if (!priv_serialize_non_full_chunk_bins(
+            priv_make_file_name(base_path, k_non_full_chunk_bin_file_name),
+            released_slots)) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Failed to serialize bin directory");
       return false;
     }
     if (!m_chunk_directory.serialize(
-            priv_make_file_name(base_path, k_chunk_directory_file_name))) {
+            priv_make_file_name(base_path, k_chunk_directory_file_name),
+            released_slots)) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Failed to serialize chunk directory");
       return false;
     }
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    if (!m_medium_object_directory.serialize(priv_make_file_name(
+            base_path, k_medium_object_directory_file_name))) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to serialize medium object directory");
+      return false;
+    }
+#endif
     return true;
   }
 
@@ -277,16 +849,187 @@ class segment_allocator {
   /// \param base_path
   /// \return
   bool deserialize(const fs::path &base_path) {
-    if (!m_non_full_chunk_bin.deserialize(
+    // The space used before is not known; only the space the segment grows
+    // into is zero-filled
+    m_zero_filled_offset = m_segment_storage->size();
+    m_zero_filled_chunks.clear();
+
+    if (!priv_deserialize_medium_object_directory(base_path)) return false;
+
+    // The files are independent; loads them concurrently
+    const bool loaded = mdtl::io_executor::instance().parallel_for(
+        2, 0, [this, &base_path](const std::size_t i) {
+          if (i == 0) {
+            // All chunks loaded from the file belong to arena 0
+            if (!m_non_full_chunk_bin[0].deserialize(priv_make_file_name(
+                    base_path, k_non_full_chunk_bin_file_name))) {
+              logger::out(logger::level::error, __FILE__, __LINE__,
+                          "Failed to deserialize bin directory");
+              return false;
+            }
+            return true;
+          }
+          if (!m_chunk_directory.deserialize(priv_make_file_name(
+                  base_path, k_chunk_directory_file_name))) {
+            logger::out(logger::level::error, __FILE__, __LINE__,
+                        "Failed to deserialize chunk directory");
+            return false;
+          }
+          return true;
+        });
+    if (!loaded) return false;
+    priv_init_counters();
+    return true;
+  }
+
+  /// \brief Fills the object caches with free slots of the non-full chunks
+  /// of the bins that had cached objects when serialize() was called, about
+  /// as many objects as were cached then. The caches are filled in parallel.
+  /// No new chunk is taken. Does nothing if
+  /// METALL_USE_OBJECT_CACHE_PREFILL is not defined or no summary is found.
+  /// Must be called right after deserialize(), before other threads allocate
+  /// objects.
+  /// \param base_path The base path given to serialize().
+  /// \return The number of the objects put into the caches.
+  size_type prefill_object_cache([[maybe_unused]] const fs::path &base_path) {
+#ifdef METALL_ENABLE_OBJECT_CACHE_PREFILL_IN_SEGMENT_ALLOCATOR
+    std::vector<std::pair<bin_no_type, size_type>> summary;
+    if (!priv_deserialize_object_cache_summary(
+            priv_make_file_name(base_path, k_object_cache_summary_file_name),
+            &summary) ||
+        summary.empty()) {
+      return 0;
+    }
+
+    const size_type num_caches = m_object_cache.num_caches();
+    std::atomic<size_type> num_prefilled{0};
+    mdtl::io_executor::instance().parallel_for(
+        num_caches, 0, [&](const std::size_t cache_no) {
+          for (const auto &[bin_no, num_objects] : summary) {
+            // Spread the objects over the caches, a refill per cache
+            const auto refill_size = small_object_cache_type::refill_size(
+                bin_no);
+            const size_type num_filled_caches = std::min(
+                num_caches, (num_objects + refill_size - 1) / refill_size);
+            const size_type stride = num_caches / num_filled_caches;
+            if (cache_no % stride != 0 ||
+                cache_no / stride >= num_filled_caches) {
+              continue;
+            }
+            num_prefilled += m_object_cache.prefill(
+                cache_no, bin_no,
+                [this, bin_no = bin_no](const size_type n,
+                                        difference_type *const offsets) {
+                  return priv_allocate_small_objects_from_non_full_chunks(
+                      bin_no, n, offsets);
+                });
+          }
+          return true;
+        });
+    return num_prefilled.load();
+#else
+    return 0;
+#endif
+  }
+
+  /// \brief Starts logging the chunk-level operations to a file so that
+  /// the allocator state can be recovered by recover() after a crash.
+  /// Must be called right after the allocator state is written to files by
+  /// serialize() or read from them by deserialize(), or right after
+  /// creation, i.e., while the files reflect the in-memory state.
+  /// \param log_path A path to the log file to create.
+  /// \return Returns true on success; otherwise, false.
+  bool start_chunk_operation_log(const fs::path &log_path) {
+    return m_chunk_log.create(log_path);
+  }
+
+  /// \brief Stops logging the chunk-level operations.
+  /// The log file is not removed.
+  void stop_chunk_operation_log() { m_chunk_log.close(); }
+
+  /// \brief Recovers the allocator state written to files by replaying a log
+  /// written by start_chunk_operation_log().
+  /// The slot-level state of small chunks is not logged. Thus, all slots of
+  /// the small chunks that could have been used since the files were written
+  /// are marked as used. Small objects freed since then are leaked.
+  /// \param base_path The base path given to serialize().
+  /// \param log_path A path to the log file.
+  /// \return Returns true on success; otherwise, false.
+  static bool recover(const fs::path &base_path, const fs::path &log_path) {
+    chunk_directory_type directory(k_max_size / k_chunk_size);
+    if (!directory.deserialize(
+            priv_make_file_name(base_path, k_chunk_directory_file_name))) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to deserialize chunk directory");
+      return false;
+    }
+
+    // Objects could have been allocated from any non-full chunk
+    for (chunk_no_type chunk_no = 0; chunk_no < directory.size(); ++chunk_no) {
+      if (!directory.unused_chunk(chunk_no) &&
+          priv_small_object_bin(directory.bin_no(chunk_no))) {
+        directory.mark_all_slots(chunk_no);
+      }
+    }
+
+    // Replays the operations in the same order; as the chunk directory
+    // chooses chunks deterministically, the same chunks must be chosen
+    std::vector<chunk_no_type> inserted_large_chunks;
+    const bool replayed = chunk_operation_log::replay(
+        log_path, [&directory, &inserted_large_chunks](
+                      const chunk_operation op, const uint64_t chunk_no,
+                      const uint32_t bin) {
+          const auto bin_no = static_cast<bin_no_type>(bin);
+          if (op == chunk_operation::insert) {
+            if (directory.insert(bin_no) != chunk_no) return false;
+            if (!priv_small_object_bin(bin_no)) {
+              inserted_large_chunks.push_back(chunk_no);
+            }
+            if (priv_small_object_bin(bin_no)) {
+              directory.mark_all_slots(chunk_no);
+            }
+            return true;
+          }
+          if (op == chunk_operation::insert_at) {
+            return !priv_small_object_bin(bin_no) &&
+                   directory.insert_at(chunk_no, bin_no);
+          }
+          if (chunk_no >= directory.size() ||
+              directory.unused_chunk(chunk_no)) {
+            return false;
+          }
+          if (op == chunk_operation::erase) {
+            directory.erase(chunk_no);
+            return true;
+          }
+          return op == chunk_operation::resize &&
+                 !priv_small_object_bin(bin_no) &&
+                 directory.resize_large_chunk(chunk_no, bin_no);
+        });
+    if (!replayed) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to replay the chunk operation log");
+      return false;
+    }
+
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    if (!priv_recover_medium_object_directory(base_path, directory,
+                                              inserted_large_chunks)) {
+      return false;
+    }
+#endif
+
+    // No small chunk has free slots
+    if (!non_full_chunk_bin_type().serialize(
             priv_make_file_name(base_path, k_non_full_chunk_bin_file_name))) {
       logger::out(logger::level::error, __FILE__, __LINE__,
-                  "Failed to deserialize bin directory");
+                  "Failed to serialize bin directory");
       return false;
     }
-    if (!m_chunk_directory.deserialize(
+    if (!directory.serialize(
             priv_make_file_name(base_path, k_chunk_directory_file_name))) {
       logger::out(logger::level::error, __FILE__, __LINE__,
-                  "Failed to deserialize chunk directory");
+                  "Failed to serialize chunk directory");
       return false;
     }
     return true;
@@ -297,11 +1040,16 @@ class segment_allocator {
   /// \param log_out
   template <typename out_stream_type>
   void profile(out_stream_type *log_out) {
-#ifndef METALL_DISABLE_OBJECT_CACHE
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    // Count the cached objects as free objects, without draining the cache
+    const auto trimmer_pause = priv_pause_object_cache_trimmer();
+    const auto cached_slots = priv_get_cached_slots();
+#elif !defined(METALL_DISABLE_OBJECT_CACHE)
     priv_clear_object_cache();
 #endif
-
-    std::vector<size_type> num_used_chunks_per_bin(bin_no_mngr::num_bins(), 0);
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+    priv_pop_all_full_front_chunks();
+#endif
 
     (*log_out) << std::fixed;
     (*log_out) << std::setprecision(2);
@@ -316,14 +1064,15 @@ class segment_allocator {
         (*log_out) << chunk_no << "\t0\t0\n";
       } else {
         const bin_no_type bin_no = m_chunk_directory.bin_no(chunk_no);
-        ++num_used_chunks_per_bin[bin_no];
-
         const size_type object_size = bin_no_mngr::to_object_size(bin_no);
 
         if (bin_no < k_num_small_bins) {
           const size_type num_slots = m_chunk_directory.slots(chunk_no);
-          const size_type num_occupied_slots =
+          size_type num_occupied_slots =
               m_chunk_directory.occupied_slots(chunk_no);
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+          num_occupied_slots -= priv_num_slots_in(cached_slots, chunk_no);
+#endif
           (*log_out) << chunk_no << "\t" << object_size << "\t"
                      << static_cast<double>(num_occupied_slots) / num_slots *
                             100
@@ -337,11 +1086,33 @@ class segment_allocator {
     (*log_out) << "\nThe distribution of the sizes of being used chunks\n";
     (*log_out) << "(the number of used chunks at each object size)\n";
     (*log_out) << "[bin no]\t[obj size]\t[#of chunks (both full and non-full "
-                  "chunks)]\n";
-    for (size_type bin_no = 0; bin_no < num_used_chunks_per_bin.size();
-         ++bin_no) {
+                  "chunks)]\t[#of objects]\n";
+    for (bin_no_type bin_no = 0; bin_no < bin_no_mngr::num_bins(); ++bin_no) {
       (*log_out) << bin_no << "\t" << bin_no_mngr::to_object_size(bin_no)
-                 << "\t" << num_used_chunks_per_bin[bin_no] << "\n";
+                 << "\t" << priv_non_negative(m_counters.chunks(bin_no))
+                 << "\t" << priv_non_negative(m_counters.objects(bin_no))
+                 << "\n";
+    }
+
+    (*log_out) << "\nAllocation counters\n";
+    (*log_out) << "[#of objects]\t[#of medium objects]\t"
+                  "[medium object bytes]\t[freed bytes]\n";
+    (*log_out) << priv_non_negative(m_counters.total_objects()) << "\t"
+               << priv_non_negative(m_counters.medium_objects()) << "\t"
+               << priv_non_negative(m_counters.medium_bytes()) << "\t"
+               << priv_non_negative(m_counters.freed_bytes()) << "\n";
+
+    {
+      chunk_heat_statistics heat;
+      get_chunk_heat(&heat);
+      (*log_out) << "\nChunk access heat\n";
+      (*log_out) << "NOTE: all chunks are cold unless the accesses have been "
+                    "sampled\n";
+      (*log_out) << "[#of used chunks]\t[#of hot chunks]\t[#of warm chunks]"
+                    "\t[#of cold chunks]\t[hot fraction (%)]\n";
+      (*log_out) << heat.num_used_chunks << "\t" << heat.num_hot_chunks << "\t"
+                 << heat.num_warm_chunks << "\t" << heat.num_cold_chunks
+                 << "\t" << heat.hot_fraction() * 100 << "\n";
     }
 
     (*log_out) << "\nThe distribution of the sizes of non-full chunks\n";
@@ -351,78 +1122,733 @@ class segment_allocator {
                << "\n";
     for (size_type bin_no = 0; bin_no < bin_no_mngr::num_small_bins();
          ++bin_no) {
-      size_type num_non_full_chunks = std::distance(
-          m_non_full_chunk_bin.begin(bin_no), m_non_full_chunk_bin.end(bin_no));
+      size_type num_non_full_chunks = 0;
+      for (const auto &arena_bin : m_non_full_chunk_bin) {
+        num_non_full_chunks +=
+            std::distance(arena_bin.begin(bin_no), arena_bin.end(bin_no));
+      }
       (*log_out) << bin_no << "\t" << bin_no_mngr::to_object_size(bin_no)
                  << "\t" << num_non_full_chunks << "\n";
     }
-  }
-
- private:
-  // -------------------- //
-  // Private methods (not designed to be used by the base class)
-  // -------------------- //
-  bool priv_small_object_bin(const bin_no_type bin_no) const {
-    return bin_no < k_num_small_bins;
-  }
-
-  fs::path priv_make_file_name(const fs::path &base_name,
-                               const std::string &item_name) {
-    return base_name.string() + "_" + item_name;
-  }
 
-  // ---------- For allocation ---------- //
-  difference_type priv_allocate_small_object(const bin_no_type bin_no) {
 #ifndef METALL_DISABLE_OBJECT_CACHE
-    if (bin_no <= m_object_cache.max_bin_no()) {
-      const auto offset = m_object_cache.pop(
-          bin_no, this, &myself::priv_allocate_small_objects_from_global,
-          &myself::priv_deallocate_small_objects_from_global);
-      assert(offset >= 0 || offset == k_null_offset);
-      return offset;
-    }
+    const auto cache_counts = m_object_cache.get_access_counts();
+    (*log_out) << "\nObject cache accesses\n";
+    (*log_out) << "[#of accesses]\t[#of cross-CPU accesses (upper bound)]\t"
+                  "[#of detected thread migrations]\n";
+    (*log_out) << cache_counts.num_accesses << "\t"
+               << cache_counts.num_cross_cpu_accesses << "\t"
+               << cache_counts.num_migrations << "\n";
 #endif
-    difference_type offset;
-    priv_allocate_small_objects_from_global(bin_no, 1, &offset);
-    return offset;
-  }
 
-  void priv_allocate_small_objects_from_global(
-      const bin_no_type bin_no, const size_type num_allocates,
-      difference_type *const allocated_offsets) {
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    {
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-    lock_guard_type bin_guard(m_bin_mutex->at(bin_no));
+      lock_guard_type medium_guard(*m_medium_object_mutex);
 #endif
-
-    if (num_allocates >= k_many_allocations_threshold) {
-      priv_allocate_many_small_objects_from_global_without_bin_lock(
-          bin_no, num_allocates, allocated_offsets);
-    } else {
-      for (size_type i = 0; i < num_allocates; ++i) {
-        allocated_offsets[i] =
-            priv_allocate_small_object_from_global_without_bin_lock(bin_no);
-      }
+      (*log_out) << "\nMedium objects\n";
+      (*log_out) << "[#of slabs]\t[#of objects]\t[allocated bytes]\t"
+                    "[free bytes]\t[#of free extents]\n";
+      (*log_out) << m_medium_object_directory.num_slabs() << "\t"
+                 << m_medium_object_directory.num_objects() << "\t"
+                 << m_medium_object_directory.allocated_bytes() << "\t"
+                 << m_medium_object_directory.free_bytes() << "\t"
+                 << m_medium_object_directory.num_free_extents() << "\n";
     }
+#endif
   }
 
-  difference_type priv_allocate_small_object_from_global_without_bin_lock(
-      const bin_no_type bin_no) {
-    const size_type object_size = bin_no_mngr::to_object_size(bin_no);
-
-    if (m_non_full_chunk_bin.empty(bin_no) &&
-        !priv_insert_new_small_object_chunk(bin_no)) {
-      return k_null_offset;
+  /// \brief Collects the memory usage of each bin.
+  /// Unlike profile(), the object cache is not drained; the cached objects are
+  /// counted as free space of their chunks.
+  /// This function must not be called while other threads allocate or
+  /// deallocate objects.
+  /// \param stats A pointer to an object to store the statistics.
+  /// The fields about the chunks and the bins are overwritten.
+  void get_statistics(memory_statistics *const stats) const {
+    std::vector<bin_statistics> bins(bin_no_mngr::num_bins());
+    for (bin_no_type bin_no = 0; bin_no < bins.size(); ++bin_no) {
+      bins[bin_no].bin_no = bin_no;
+      bins[bin_no].object_size = bin_no_mngr::to_object_size(bin_no);
     }
 
-    assert(!m_non_full_chunk_bin.empty(bin_no));
-    const chunk_no_type chunk_no = m_non_full_chunk_bin.front(bin_no);
-
-    assert(!m_chunk_directory.all_slots_marked(chunk_no));
-    const chunk_slot_no_type chunk_slot_no =
+    size_type num_used_chunks = 0;
+    for (chunk_no_type chunk_no = 0; chunk_no < m_chunk_directory.size();
+         ++chunk_no) {
+      if (m_chunk_directory.unused_chunk(chunk_no)) continue;
+      ++num_used_chunks;
+      auto &bin = bins[m_chunk_directory.bin_no(chunk_no)];
+      ++bin.num_chunks;
+      if (priv_small_object_bin(bin.bin_no)) {
+        const size_type num_occupied_slots =
+            m_chunk_directory.occupied_slots(chunk_no);
+        if (num_occupied_slots < m_chunk_directory.slots(chunk_no)) {
+          ++bin.num_non_full_chunks;
+        }
+        bin.num_objects += num_occupied_slots;
+        bin.free_bytes += k_chunk_size - num_occupied_slots * bin.object_size;
+      }
+    }
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    // The slabs are counted as medium objects, not as large objects
+    bins[priv_medium_slab_bin()].num_chunks -=
+        m_medium_object_directory.slab_bytes() / k_chunk_size;
+#endif
+    // A large object spans object_size / k_chunk_size chunks
+    for (bin_no_type bin_no = k_num_small_bins; bin_no < bins.size();
+         ++bin_no) {
+      bins[bin_no].num_objects =
+          bins[bin_no].num_chunks * k_chunk_size / bins[bin_no].object_size;
+    }
+
+#ifndef METALL_DISABLE_OBJECT_CACHE
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    const auto trimmer_pause = priv_pause_object_cache_trimmer();
+#endif
+    priv_for_each_cached_object(
+        [&bins](const bin_no_type bin_no, const difference_type) {
+          ++bins[bin_no].num_cached_objects;
+        });
+#endif
+
+    stats->chunk_size = k_chunk_size;
+    stats->num_used_chunks = num_used_chunks;
+    stats->allocated_bytes = 0;
+    stats->cached_bytes = 0;
+    stats->bins.clear();
+    for (auto &bin : bins) {
+      if (bin.num_chunks == 0) continue;
+      // Cached objects are marked as occupied in the chunk directory
+      bin.num_objects -= bin.num_cached_objects;
+      bin.allocated_bytes = bin.num_objects * bin.object_size;
+      bin.free_bytes += bin.num_cached_objects * bin.object_size;
+      stats->allocated_bytes += bin.allocated_bytes;
+      stats->cached_bytes += bin.num_cached_objects * bin.object_size;
+      stats->bins.push_back(bin);
+    }
+
+    stats->medium_objects = medium_object_statistics{};
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    auto &medium = stats->medium_objects;
+    medium.num_slabs = m_medium_object_directory.num_slabs();
+    medium.num_chunks = m_medium_object_directory.slab_bytes() / k_chunk_size;
+    medium.num_objects = m_medium_object_directory.num_objects();
+    medium.allocated_bytes = m_medium_object_directory.allocated_bytes();
+    medium.free_bytes = m_medium_object_directory.free_bytes();
+    medium.num_free_extents = m_medium_object_directory.num_free_extents();
+    stats->allocated_bytes += medium.allocated_bytes;
+#endif
+  }
+
+  /// \brief Calls 'func(chunk_no, bin_no, object_size)' for each used chunk.
+  /// Every chunk of a large object is visited with the bin of the object.
+  /// This function must not be called while other threads allocate or
+  /// deallocate objects.
+  template <typename function_type>
+  void for_each_used_chunk(function_type func) const {
+    for (chunk_no_type chunk_no = 0; chunk_no < m_chunk_directory.size();
+         ++chunk_no) {
+      if (m_chunk_directory.unused_chunk(chunk_no)) continue;
+      const bin_no_type bin_no = m_chunk_directory.bin_no(chunk_no);
+      func(chunk_no, bin_no, bin_no_mngr::to_object_size(bin_no));
+    }
+  }
+
+  /// \brief Calls 'func(chunk_no, bin_no, object_size)' for each used chunk
+  /// in the chunk directory written by serialize(), without constructing an
+  /// allocator, e.g., to inspect a datastore that is not open.
+  /// \param base_path The base path given to serialize().
+  /// \return Returns true on success; otherwise, false.
+  template <typename function_type>
+  static bool for_each_used_chunk(const fs::path &base_path,
+                                  function_type func) {
+    chunk_directory_type directory(k_max_size / k_chunk_size);
+    if (!directory.deserialize(
+            priv_make_file_name(base_path, k_chunk_directory_file_name))) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to deserialize chunk directory");
+      return false;
+    }
+    for (chunk_no_type chunk_no = 0; chunk_no < directory.size(); ++chunk_no) {
+      if (directory.unused_chunk(chunk_no)) continue;
+      const bin_no_type bin_no = directory.bin_no(chunk_no);
+      func(chunk_no, bin_no, bin_no_mngr::to_object_size(bin_no));
+    }
+    return true;
+  }
+
+  /// \brief Checks the allocator state written by serialize() without
+  /// constructing an allocator, e.g., to find a broken datastore.
+  /// Checks the chunk directory (see chunk_directory::check()), that the bin
+  /// directory lists every small chunk that has free slots and only such
+  /// chunks, that the medium object slabs are large objects, and that each
+  /// object offset is the beginning of an allocated slot, medium object, or
+  /// large object. The chunks are checked in parallel.
+  /// \param base_path The base path given to serialize().
+  /// \param object_offsets The offsets of the allocated objects to check.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param used_size A pointer to store the size of the segment the chunks
+  /// use, i.e., the block files must be at least this size.
+  /// \param problems A pointer to append the descriptions of the problems.
+  /// \return Returns true if no problem is found; otherwise, false.
+  static bool check(const fs::path &base_path,
+                    const std::vector<difference_type> &object_offsets,
+                    const int max_num_threads, size_type *const used_size,
+                    std::vector<std::string> *const problems) {
+    *used_size = 0;
+    chunk_directory_type directory(k_max_size / k_chunk_size);
+    if (!directory.deserialize(
+            priv_make_file_name(base_path, k_chunk_directory_file_name))) {
+      problems->push_back("Cannot read the chunk directory");
+      return false;
+    }
+    *used_size = directory.size() * k_chunk_size;
+    bool ok = directory.check(max_num_threads, problems);
+
+    non_full_chunk_bin_type bin;
+    if (!bin.deserialize(
+            priv_make_file_name(base_path, k_non_full_chunk_bin_file_name))) {
+      problems->push_back("Cannot read the bin directory");
+      return false;
+    }
+    std::vector<bool> listed(directory.size(), false);
+    for (bin_no_type bin_no = 0; bin_no < k_num_small_bins; ++bin_no) {
+      for (auto itr = bin.begin(bin_no), end = bin.end(bin_no); itr != end;
+           ++itr) {
+        const chunk_no_type chunk_no = *itr;
+        const std::string name = "Chunk " + std::to_string(chunk_no) +
+                                 " in bin " + std::to_string(bin_no) + ": ";
+        if (chunk_no >= directory.size() || directory.unused_chunk(chunk_no)) {
+          problems->push_back(name + "An unused chunk is in the bin directory");
+        } else if (directory.bin_no(chunk_no) != bin_no) {
+          problems->push_back(name + "The chunk belongs to bin " +
+                              std::to_string(directory.bin_no(chunk_no)));
+        } else if (listed[chunk_no]) {
+          problems->push_back(name + "The chunk is listed more than once");
+        } else {
+          listed[chunk_no] = true;
+          continue;
+        }
+        ok = false;
+      }
+    }
+    medium_object_directory_type medium(k_medium_object_granule,
+                                        k_null_offset);
+    const auto medium_path =
+        priv_make_file_name(base_path, k_medium_object_directory_file_name);
+    if (fs::exists(medium_path) && !medium.deserialize(medium_path)) {
+      problems->push_back("Cannot read the medium object directory");
+      return false;
+    }
+    medium.for_each_slab([&](const difference_type offset, const size_type) {
+      const chunk_no_type chunk_no = offset / k_chunk_size;
+      if (offset % k_chunk_size != 0 || chunk_no >= directory.size() ||
+          !directory.large_head_chunk(chunk_no) ||
+          directory.bin_no(chunk_no) != priv_medium_slab_bin()) {
+        problems->push_back("Medium object slab at offset " +
+                            std::to_string(offset) +
+                            ": The slab is not a large object");
+        ok = false;
+      }
+    });
+
+    for (chunk_no_type chunk_no = 0; chunk_no < directory.size(); ++chunk_no) {
+      if (!listed[chunk_no] && !directory.unused_chunk(chunk_no) &&
+          priv_small_object_bin(directory.bin_no(chunk_no)) &&
+          !directory.all_slots_marked(chunk_no)) {
+        problems->push_back("Chunk " + std::to_string(chunk_no) +
+                            ": The free slots are not in the bin directory");
+        ok = false;
+      }
+    }
+
+    // The offsets are checked in parallel; the problems are kept in order
+    constexpr std::size_t k_num_objects_per_task = 1ULL << 16ULL;
+    const std::size_t num_tasks =
+        (object_offsets.size() + k_num_objects_per_task - 1) /
+        k_num_objects_per_task;
+    std::vector<std::vector<std::string>> task_problems(num_tasks);
+    mdtl::io_executor::instance().parallel_for(
+        num_tasks, max_num_threads, [&](const std::size_t t) {
+          const auto end = std::min((t + 1) * k_num_objects_per_task,
+                                    object_offsets.size());
+          for (std::size_t i = t * k_num_objects_per_task; i < end; ++i) {
+            priv_check_object_offset(directory, medium, object_offsets[i],
+                                     &task_problems[t]);
+          }
+          return true;
+        });
+    for (auto &list : task_problems) {
+      ok &= list.empty();
+      std::move(list.begin(), list.end(), std::back_inserter(*problems));
+    }
+    return ok;
+  }
+
+  /// \brief Writes the sampled allocations in a heap profile format pprof
+  /// reads. Available only if METALL_USE_ALLOCATION_SAMPLING is defined.
+  /// \param path A path to the file to write.
+  /// \return Returns true on success; otherwise, false.
+  bool write_allocation_profile([[maybe_unused]] const fs::path &path) const {
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+    return m_allocation_sampler.write_profile(path);
+#else
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Allocation sampling is not enabled (define "
+                "METALL_USE_ALLOCATION_SAMPLING)");
+    return false;
+#endif
+  }
+
+ private:
+  // -------------------- //
+  // Private methods (not designed to be used by the base class)
+  // -------------------- //
+  static bool priv_small_object_bin(const bin_no_type bin_no) {
+    return bin_no < k_num_small_bins;
+  }
+
+  /// \brief Appends a chunk operation to the chunk operation log (if it is
+  /// open) and traces it.
+  void priv_record_chunk_operation(const chunk_operation op,
+                                   const chunk_no_type chunk_no,
+                                   const bin_no_type bin_no) noexcept {
+    m_chunk_log.append(op, chunk_no, bin_no);
+    switch (op) {
+      case chunk_operation::insert:
+      case chunk_operation::insert_at:
+        METALL_TRACE(chunk_insert, chunk_no, bin_no);
+        break;
+      case chunk_operation::erase:
+        METALL_TRACE(chunk_erase, chunk_no, bin_no);
+        break;
+      case chunk_operation::resize:
+        METALL_TRACE(chunk_resize, chunk_no, bin_no);
+        break;
+    }
+  }
+
+  static fs::path priv_make_file_name(const fs::path &base_name,
+                                      const std::string &item_name) {
+    return base_name.string() + "_" + item_name;
+  }
+
+  /// \brief Serializes the non-full chunk bins of all arenas as a single bin
+  /// directory, i.e., the chunk ownership is not stored.
+  /// \param released_slots If not null, the bins are stored as if the listed
+  /// slots were deallocated, i.e., chunks that have only those slots occupied
+  /// are removed and full chunks that have any of them are added.
+  bool priv_serialize_non_full_chunk_bins(
+      const fs::path &path,
+      const chunk_slot_list_type *const released_slots = nullptr) const {
+    if (k_num_arenas == 1 && !released_slots) {
+      return m_non_full_chunk_bin[0].serialize(path);
+    }
+
+    non_full_chunk_bin_type merged_bin;
+    std::set<chunk_no_type> listed_chunks;
+    for (const auto &arena_bin : m_non_full_chunk_bin) {
+      for (bin_no_type bin_no = 0; bin_no < k_num_small_bins; ++bin_no) {
+        for (auto itr = arena_bin.begin(bin_no), end = arena_bin.end(bin_no);
+             itr != end; ++itr) {
+          if (released_slots) {
+            const auto num_released = priv_num_slots_in(*released_slots, *itr);
+            if (num_released > 0 &&
+                m_chunk_directory.occupied_slots(*itr) == num_released) {
+              continue;  // Will be an unused chunk
+            }
+            listed_chunks.insert(*itr);
+          }
+          merged_bin.insert(bin_no, *itr);
+        }
+      }
+    }
+
+    if (released_slots) {
+      for (const auto &[chunk_no, slot_nos] : *released_slots) {
+        if (listed_chunks.count(chunk_no) > 0 ||
+            m_chunk_directory.occupied_slots(chunk_no) == slot_nos.size()) {
+          continue;
+        }
+        merged_bin.insert(m_chunk_directory.bin_no(chunk_no), chunk_no);
+      }
+    }
+
+    return merged_bin.serialize(path);
+  }
+
+  static void priv_check_object_offset(
+      const chunk_directory_type &directory,
+      const medium_object_directory_type &medium,
+      const difference_type offset,
+      std::vector<std::string> *const problems) {
+    const auto add_problem = [offset, problems](const std::string &what) {
+      problems->push_back("Object at offset " + std::to_string(offset) + ": " +
+                          what);
+    };
+    if (offset < 0 ||
+        size_type(offset) >= directory.size() * k_chunk_size) {
+      add_problem("The offset is out of the used chunks");
+      return;
+    }
+    const chunk_no_type chunk_no = offset / k_chunk_size;
+    if (directory.unused_chunk(chunk_no)) {
+      add_problem("The chunk is unused");
+      return;
+    }
+    if (medium.in_slab(offset)) {
+      if (medium.object_size(offset) == 0) {
+        add_problem("The offset is not the beginning of a medium object");
+      }
+      return;
+    }
+    const bin_no_type bin_no = directory.bin_no(chunk_no);
+    if (!priv_small_object_bin(bin_no)) {
+      if (!directory.large_head_chunk(chunk_no) ||
+          offset % k_chunk_size != 0) {
+        add_problem("The offset is not the beginning of a large object");
+      }
+      return;
+    }
+    const size_type object_size = bin_no_mngr::to_object_size(bin_no);
+    const size_type slot_no = (offset % k_chunk_size) / object_size;
+    if ((offset % k_chunk_size) % object_size != 0 ||
+        slot_no >= directory.slots(chunk_no)) {
+      add_problem("The offset is not the beginning of a slot");
+    } else if (!directory.marked_slot(chunk_no, slot_no)) {
+      add_problem("The slot is not allocated");
+    }
+  }
+
+  static size_type priv_num_slots_in(const chunk_slot_list_type &slot_list,
+                                     const chunk_no_type chunk_no) {
+    const auto itr = slot_list.find(chunk_no);
+    return (itr == slot_list.end()) ? 0 : itr->second.size();
+  }
+
+  // ---------- For arena ---------- //
+  static size_type &priv_placement_hint() {
+    thread_local size_type hint = k_no_placement_hint;
+    return hint;
+  }
+
+  /// \brief Returns the arena number the calling thread allocates from.
+  /// A thread keeps using the same arena so that chunks are not shared among
+  /// threads, unless a placement hint is set.
+  static arena_no_type priv_arena_no() {
+    if constexpr (k_num_placement_hints > 0) {
+      const size_type hint = priv_placement_hint();
+      if (hint != k_no_placement_hint) {
+        return static_cast<arena_no_type>(k_num_thread_arenas + hint);
+      }
+    }
+    if constexpr (k_num_thread_arenas == 1 || !k_thread_safe) {
+      return 0;
+    } else {
+#if SUPPORT_GET_CPU_NO
+      thread_local static const auto arena_no = static_cast<arena_no_type>(
+          mdtl::get_cpu_no() % k_num_thread_arenas);
+#else
+      thread_local static const auto hashed_thread_id = mdtl::hash<>{}(
+          std::hash<std::thread::id>{}(std::this_thread::get_id()));
+      thread_local static const auto arena_no =
+          static_cast<arena_no_type>(hashed_thread_id % k_num_thread_arenas);
+#endif
+      return arena_no;
+    }
+  }
+
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+  bin_mutex_type &priv_bin_mutex(const arena_no_type arena_no,
+                                 const bin_no_type bin_no) {
+    return m_bin_mutex->at(arena_no * k_num_small_bins + bin_no);
+  }
+#endif
+
+  // ---------- For allocation counters ---------- //
+  /// \brief Sets the allocation counters by scanning the chunk directory and
+  /// the medium object directory. The object cache must be empty.
+  void priv_init_counters() {
+    m_counters.clear();
+    for (chunk_no_type chunk_no = 0; chunk_no < m_chunk_directory.size();
+         ++chunk_no) {
+      if (m_chunk_directory.unused_chunk(chunk_no)) continue;
+      const bin_no_type bin_no = m_chunk_directory.bin_no(chunk_no);
+      if (priv_small_object_bin(bin_no)) {
+        m_counters.add_objects(bin_no,
+                               m_chunk_directory.occupied_slots(chunk_no));
+        m_counters.add_chunks(bin_no, 1);
+      } else if (m_chunk_directory.large_head_chunk(chunk_no)) {
+        m_counters.add_objects(bin_no, 1);
+        m_counters.add_chunks(bin_no, priv_num_chunks(bin_no));
+      }
+    }
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    // The slabs are not objects
+    m_counters.add_objects(priv_medium_slab_bin(),
+                           -difference_type(
+                               m_medium_object_directory.num_slabs()));
+    m_counters.add_medium_objects(m_medium_object_directory.num_objects(),
+                                  m_medium_object_directory.allocated_bytes());
+#endif
+  }
+
+  /// \brief A counter can be read as negative while other threads move
+  /// objects between CPUs.
+  static size_type priv_non_negative(
+      const allocation_counters::value_type value) {
+    return (value < 0) ? 0 : static_cast<size_type>(value);
+  }
+
+  /// \brief Checks if all memory is deallocated by scanning the chunk
+  /// directory, i.e., without the allocation counters. Used to validate the
+  /// counters in debug builds.
+  bool priv_all_memory_deallocated_by_scan() const {
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+    const auto trimmer_pause = priv_pause_object_cache_trimmer();
+#endif
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    if (m_chunk_directory.num_used_large_chunks() != 0) return false;
+#ifndef METALL_DISABLE_OBJECT_CACHE
+    return priv_check_all_small_allocations_are_cached_without_lock();
+#else
+    return m_chunk_directory.get_all_marked_slots().empty();
+#endif
+  }
+
+  // ---------- For allocation ---------- //
+  /// \brief Allocates an object.
+  /// \param use_medium_slabs If false, a medium-size object is allocated as
+  /// a small or large object, e.g., to align it to its size class.
+  difference_type priv_allocate(const size_type nbytes,
+                                bool *const zero_filled,
+                                [[maybe_unused]] const bool use_medium_slabs) {
+    if (zero_filled) *zero_filled = false;
+    if (nbytes == 0) return k_null_offset;
+    const bin_no_type bin_no = bin_no_mngr::to_bin_no(nbytes);
+
+    difference_type offset = k_null_offset;
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    if (use_medium_slabs && priv_medium_object_size(nbytes)) {
+      offset = priv_allocate_medium_object(nbytes);
+    } else
+#endif
+    {
+      offset = (priv_small_object_bin(bin_no))
+                   ? priv_allocate_small_object(bin_no)
+                   : priv_allocate_large_object(bin_no, zero_filled);
+      if (offset != k_null_offset) m_counters.add_objects(bin_no, 1);
+    }
+    assert(offset >= 0 || offset == k_null_offset);
+
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+    if (offset != k_null_offset && m_allocation_sampler.sample(nbytes)) {
+      m_allocation_sampler.record(nbytes, 1, bin_no);
+    }
+#endif
+
+    return offset;
+  }
+
+  difference_type priv_allocate_small_object(const bin_no_type bin_no) {
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+    {
+      const auto offset = priv_take_remote_frees(bin_no);
+      if (offset != k_null_offset) return offset;
+    }
+#endif
+#ifndef METALL_DISABLE_OBJECT_CACHE
+    // The object cache mixes the objects of arenas
+    if (bin_no <= m_object_cache.max_bin_no() &&
+        (k_num_placement_hints == 0 ||
+         priv_placement_hint() == k_no_placement_hint)) {
+      const auto offset = m_object_cache.pop(
+          bin_no, this, &myself::priv_allocate_small_objects_from_global,
+          &myself::priv_deallocate_small_objects_from_global);
+      assert(offset >= 0 || offset == k_null_offset);
+      return offset;
+    }
+#endif
+    difference_type offset;
+    priv_allocate_small_objects_from_global(bin_no, 1, &offset);
+    return offset;
+  }
+
+  void priv_allocate_small_objects_from_global(
+      const bin_no_type bin_no, const size_type num_allocates,
+      difference_type *const allocated_offsets) {
+    const arena_no_type arena_no = priv_arena_no();
+    size_type num_claimed = 0;
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+    if constexpr (k_thread_safe) {
+      {
+        bin_shared_lock_guard_type bin_shared_guard(
+            priv_bin_mutex(arena_no, bin_no));
+        num_claimed = priv_claim_small_objects_concurrently(
+            arena_no, bin_no, num_allocates, allocated_offsets);
+      }
+      if (num_claimed == num_allocates) return;
+    }
+#endif
+
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    bin_lock_guard_type bin_guard(priv_bin_mutex(arena_no, bin_no));
+#endif
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+    priv_pop_full_front_chunks_without_bin_lock(arena_no, bin_no);
+#endif
+
+    const size_type num_remains = num_allocates - num_claimed;
+    difference_type *const remaining_offsets = allocated_offsets + num_claimed;
+    if (num_remains >= k_many_allocations_threshold) {
+      priv_allocate_many_small_objects_from_global_without_bin_lock(
+          arena_no, bin_no, num_remains, remaining_offsets);
+    } else {
+      for (size_type i = 0; i < num_remains; ++i) {
+        remaining_offsets[i] =
+            priv_allocate_small_object_from_global_without_bin_lock(arena_no,
+                                                                    bin_no);
+      }
+    }
+  }
+
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+  /// \brief Claims up to 'num_allocates' slots from the chunk at the front of
+  /// the bin using atomic operations.
+  /// The caller must hold the bin lock in shared mode. As the non-full chunk
+  /// bin is not modified in shared mode, a chunk filled by this function
+  /// stays at the front of the bin until a thread holding the bin lock
+  /// exclusively pops it.
+  /// \return The number of claimed slots.
+  size_type priv_claim_small_objects_concurrently(
+      const arena_no_type arena_no, const bin_no_type bin_no,
+      const size_type num_allocates, difference_type *const allocated_offsets) {
+    const auto &non_full_chunk_bin = m_non_full_chunk_bin[arena_no];
+    if (non_full_chunk_bin.empty(bin_no)) return 0;
+    const chunk_no_type chunk_no = non_full_chunk_bin.front(bin_no);
+
+    const size_type num_reserved =
+        m_chunk_directory.reserve_slots_concurrently(chunk_no, num_allocates);
+    const size_type object_size = bin_no_mngr::to_object_size(bin_no);
+    for (size_type i = 0; i < num_reserved; ++i) {
+      const chunk_slot_no_type chunk_slot_no =
+          m_chunk_directory.find_and_mark_reserved_slot_concurrently(chunk_no);
+      allocated_offsets[i] =
+          k_chunk_size * chunk_no + object_size * chunk_slot_no;
+    }
+    return num_reserved;
+  }
+
+  /// \brief Pops full chunks at the front of the bin, which are left by
+  /// priv_claim_small_objects_concurrently().
+  /// The caller must hold the bin lock exclusively.
+  void priv_pop_full_front_chunks_without_bin_lock(
+      const arena_no_type arena_no, const bin_no_type bin_no) {
+    auto &non_full_chunk_bin = m_non_full_chunk_bin[arena_no];
+    while (!non_full_chunk_bin.empty(bin_no) &&
+           m_chunk_directory.all_slots_marked(
+               non_full_chunk_bin.front(bin_no))) {
+      non_full_chunk_bin.pop(bin_no);
+    }
+  }
+
+  void priv_pop_all_full_front_chunks() {
+    for (size_type arena_no = 0; arena_no < k_num_arenas; ++arena_no) {
+      for (bin_no_type bin_no = 0; bin_no < k_num_small_bins; ++bin_no) {
+        bin_lock_guard_type bin_guard(priv_bin_mutex(arena_no, bin_no));
+        priv_pop_full_front_chunks_without_bin_lock(arena_no, bin_no);
+      }
+    }
+  }
+#endif
+
+#ifdef METALL_ENABLE_OBJECT_CACHE_PREFILL_IN_SEGMENT_ALLOCATOR
+  /// \brief Allocates up to 'num_allocates' objects from the non-full chunks
+  /// of arena 0, which has all chunks loaded from files, without inserting a
+  /// new chunk.
+  /// \return The number of allocated objects.
+  size_type priv_allocate_small_objects_from_non_full_chunks(
+      const bin_no_type bin_no, const size_type num_allocates,
+      difference_type *const allocated_offsets) {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    bin_lock_guard_type bin_guard(priv_bin_mutex(0, bin_no));
+#endif
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+    priv_pop_full_front_chunks_without_bin_lock(0, bin_no);
+#endif
+    size_type num_allocated = 0;
+    while (num_allocated < num_allocates &&
+           !m_non_full_chunk_bin[0].empty(bin_no)) {
+      allocated_offsets[num_allocated++] =
+          priv_allocate_small_object_from_global_without_bin_lock(0, bin_no);
+    }
+    return num_allocated;
+  }
+
+  bool priv_serialize_object_cache_summary(const fs::path &path) const {
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    for (bin_no_type bin_no = 0; bin_no <= m_object_cache.max_bin_no();
+         ++bin_no) {
+      const auto num_objects = m_object_cache.num_cached_objects(bin_no);
+      if (num_objects == 0) continue;
+      ofs << static_cast<uint64_t>(bin_no) << " "
+          << static_cast<uint64_t>(num_objects) << "\n";
+    }
+    ofs.close();
+    return !!ofs;
+  }
+
+  /// \brief Reads the summary written by
+  /// priv_serialize_object_cache_summary(). Returns false if the file does
+  /// not exist, e.g., the datastore was closed without the option, or is
+  /// broken.
+  bool priv_deserialize_object_cache_summary(
+      const fs::path &path,
+      std::vector<std::pair<bin_no_type, size_type>> *const summary) const {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) return false;
+    uint64_t bin_no;
+    uint64_t num_objects;
+    while (ifs >> bin_no >> num_objects) {
+      if (bin_no > m_object_cache.max_bin_no() || num_objects == 0) {
+        logger::out(logger::level::warning, __FILE__, __LINE__,
+                    "Invalid entry in object cache summary");
+        return false;
+      }
+      summary->emplace_back(static_cast<bin_no_type>(bin_no), num_objects);
+    }
+    return ifs.eof();
+  }
+#endif
+
+  difference_type priv_allocate_small_object_from_global_without_bin_lock(
+      const arena_no_type arena_no, const bin_no_type bin_no) {
+    const size_type object_size = bin_no_mngr::to_object_size(bin_no);
+    auto &non_full_chunk_bin = m_non_full_chunk_bin[arena_no];
+
+    if (non_full_chunk_bin.empty(bin_no) &&
+        !priv_insert_new_small_object_chunk(arena_no, bin_no)) {
+      return k_null_offset;
+    }
+
+    assert(!non_full_chunk_bin.empty(bin_no));
+    const chunk_no_type chunk_no = non_full_chunk_bin.front(bin_no);
+
+    assert(!m_chunk_directory.all_slots_marked(chunk_no));
+    const chunk_slot_no_type chunk_slot_no =
         m_chunk_directory.find_and_mark_slot(chunk_no);
 
     if (m_chunk_directory.all_slots_marked(chunk_no)) {
-      m_non_full_chunk_bin.pop(bin_no);
+      non_full_chunk_bin.pop(bin_no);
     }
     const difference_type offset =
         k_chunk_size * chunk_no + object_size * chunk_slot_no;
@@ -431,22 +1857,24 @@ class segment_allocator {
   }
 
   void priv_allocate_many_small_objects_from_global_without_bin_lock(
-      const bin_no_type bin_no, const size_type num_requested_allocates,
+      const arena_no_type arena_no, const bin_no_type bin_no,
+      const size_type num_requested_allocates,
       difference_type *const allocated_offsets) {
     if (num_requested_allocates == 0) return;  // Not error, just no work.
     if (!allocated_offsets) return;
+    auto &non_full_chunk_bin = m_non_full_chunk_bin[arena_no];
 
     std::fill_n(allocated_offsets, num_requested_allocates, k_null_offset);
 
     std::size_t cnt_allocations = 0;
     while (cnt_allocations < num_requested_allocates) {
-      if (m_non_full_chunk_bin.empty(bin_no) &&
-          !priv_insert_new_small_object_chunk(bin_no)) {
+      if (non_full_chunk_bin.empty(bin_no) &&
+          !priv_insert_new_small_object_chunk(arena_no, bin_no)) {
         return;
       }
 
-      assert(!m_non_full_chunk_bin.empty(bin_no));
-      const chunk_no_type chunk_no = m_non_full_chunk_bin.front(bin_no);
+      assert(!non_full_chunk_bin.empty(bin_no));
+      const chunk_no_type chunk_no = non_full_chunk_bin.front(bin_no);
       assert(!m_chunk_directory.all_slots_marked(chunk_no));
 
       const std::size_t num_to_allocate =
@@ -461,7 +1889,7 @@ class segment_allocator {
       }
 
       if (m_chunk_directory.all_slots_marked(chunk_no)) {
-        m_non_full_chunk_bin.pop(bin_no);
+        non_full_chunk_bin.pop(bin_no);
       }
 
       const size_type object_size = bin_no_mngr::to_object_size(bin_no);
@@ -474,60 +1902,253 @@ class segment_allocator {
     assert(cnt_allocations == num_requested_allocates);
   }
 
-  bool priv_insert_new_small_object_chunk(const bin_no_type bin_no) {
-    chunk_no_type new_chunk_no;
-#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-    lock_guard_type chunk_guard(*m_chunk_mutex);
-#endif
-    new_chunk_no = m_chunk_directory.insert(bin_no);
-    if (!priv_extend_segment_without_lock(new_chunk_no, 1)) {
+  // The chunk lock protects only the chunk directory and the chunk log.
+  // Extending the segment, which can create and map a file, is done after
+  // releasing it, so that other threads can allocate and free chunks in
+  // the meantime. A chunk is not visible to other threads until it is
+  // given to the caller or inserted into the non-full chunk bin.
+
+  bool priv_insert_new_small_object_chunk(const arena_no_type arena_no,
+                                          const bin_no_type bin_no) {
+    const chunk_no_type new_chunk_no = priv_insert_chunk(bin_no, arena_no);
+    if (!priv_extend_segment(new_chunk_no, 1)) {
+      priv_erase_chunk(new_chunk_no);
       return false;
     }
-    m_non_full_chunk_bin.insert(bin_no, new_chunk_no);
+    m_non_full_chunk_bin[arena_no].insert(bin_no, new_chunk_no);
     return true;
   }
 
-  difference_type priv_allocate_large_object(const bin_no_type bin_no) {
-#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-    lock_guard_type chunk_guard(*m_chunk_mutex);
-#endif
-    const chunk_no_type new_chunk_no = m_chunk_directory.insert(bin_no);
-    const size_type num_chunks =
-        (bin_no_mngr::to_object_size(bin_no) + k_chunk_size - 1) / k_chunk_size;
-    if (!priv_extend_segment_without_lock(new_chunk_no, num_chunks)) {
+  difference_type priv_allocate_large_object(
+      const bin_no_type bin_no, bool *const zero_filled = nullptr) {
+    const chunk_no_type new_chunk_no = priv_insert_chunk(bin_no);
+    const size_type num_chunks = priv_num_chunks(bin_no);
+    if (!priv_extend_segment(new_chunk_no, num_chunks, zero_filled)) {
       // Failed to extend the segment (fatal error)
       // Do clean up just in case and return k_null_offset
-      m_chunk_directory.erase(new_chunk_no);
+      priv_erase_chunk(new_chunk_no);
       return k_null_offset;
     }
     const difference_type offset = k_chunk_size * new_chunk_no;
     return offset;
   }
 
-  bool priv_extend_segment_without_lock(const chunk_no_type head_chunk_no,
-                                        const size_type num_chunks) {
-    const size_type required_segment_size =
-        (head_chunk_no + num_chunks) * k_chunk_size;
-    if (required_segment_size <= m_segment_storage->size()) {
-      return true;  // Has an enough segment size already
+  /// \brief Allocates a large object at a chunk whose offset is a multiple of
+  /// 'alignment', which is larger than the chunk size.
+  difference_type priv_allocate_aligned_large_object(
+      const size_type nbytes, const size_type alignment) {
+    assert(alignment > k_chunk_size && alignment % k_chunk_size == 0);
+    if (nbytes > k_max_size) return k_null_offset;
+    const bin_no_type bin_no =
+        bin_no_mngr::to_bin_no(std::max(nbytes, k_chunk_size));
+    assert(!priv_small_object_bin(bin_no));
+
+    chunk_no_type new_chunk_no;
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+      new_chunk_no =
+          m_chunk_directory.insert_aligned(bin_no, alignment / k_chunk_size);
+      if (new_chunk_no == k_max_size / k_chunk_size) {
+        return k_null_offset;
+      }
+      m_counters.add_chunks(bin_no, priv_num_chunks(bin_no));
+      priv_record_chunk_operation(chunk_operation::insert_at, new_chunk_no,
+                                  bin_no);
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+      m_chunk_release_queue.erase(new_chunk_no, priv_num_chunks(bin_no));
+#endif
     }
 
-    if (!m_segment_storage->extend(required_segment_size)) {
-      std::stringstream ss;
-      ss << "Failed to extend the segment to " << required_segment_size
-         << " bytes";
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+    if (!priv_extend_segment(new_chunk_no, priv_num_chunks(bin_no))) {
+      priv_erase_chunk(new_chunk_no);
+      return k_null_offset;
+    }
+
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+    if (m_allocation_sampler.sample(nbytes)) {
+      m_allocation_sampler.record(nbytes, 1, bin_no);
+    }
+#endif
+    m_counters.add_objects(bin_no, 1);
+    const difference_type offset = k_chunk_size * new_chunk_no;
+    assert(offset % alignment == 0);
+    return offset;
+  }
+
+  chunk_no_type priv_insert_chunk(const bin_no_type bin_no,
+                                  const arena_no_type arena_no = 0) {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    const chunk_no_type chunk_no = m_chunk_directory.insert(bin_no, arena_no);
+    priv_record_chunk_operation(chunk_operation::insert, chunk_no, bin_no);
+    m_counters.add_chunks(bin_no, priv_num_chunks(bin_no));
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+    // Must not release the pages of the reused chunks
+    m_chunk_release_queue.erase(chunk_no, priv_num_chunks(bin_no));
+#endif
+    return chunk_no;
+  }
+
+  /// \brief Erases a chunk from the chunk directory.
+  /// The pages of the chunk must be freed before calling this function, as
+  /// the chunk can be reused by another thread right after it.
+  void priv_erase_chunk(const chunk_no_type chunk_no) {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    priv_erase_chunk_without_lock(chunk_no);
+  }
+
+  void priv_erase_chunk_without_lock(const chunk_no_type chunk_no) {
+    const bin_no_type bin_no = m_chunk_directory.bin_no(chunk_no);
+    m_chunk_directory.erase(chunk_no);
+    priv_record_chunk_operation(chunk_operation::erase, chunk_no, bin_no);
+    m_counters.add_chunks(bin_no, -difference_type(priv_num_chunks(bin_no)));
+  }
+
+  /// \brief Erases a chunk and frees the pages of its 'num_chunks' chunks.
+  void priv_erase_and_free_chunk(const chunk_no_type chunk_no,
+                                 const size_type num_chunks) {
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type chunk_guard(*m_chunk_mutex);
+#endif
+    priv_erase_chunk_without_lock(chunk_no);
+    priv_release_chunk_without_lock(chunk_no, num_chunks);
+#else
+    // Free the pages before erasing the chunk, i.e., without the chunk lock
+    priv_free_chunk(chunk_no, num_chunks);
+    priv_erase_chunk(chunk_no);
+#endif
+  }
+
+  static size_type priv_num_chunks(const bin_no_type bin_no) {
+    return (bin_no_mngr::to_object_size(bin_no) + k_chunk_size - 1) /
+           k_chunk_size;
+  }
+
+  bool priv_resize_large_object_without_lock(const chunk_no_type chunk_no,
+                                             const bin_no_type old_bin_no,
+                                             const bin_no_type new_bin_no) {
+    const size_type old_num_chunks =
+        (bin_no_mngr::to_object_size(old_bin_no) + k_chunk_size - 1) /
+        k_chunk_size;
+    const size_type new_num_chunks =
+        (bin_no_mngr::to_object_size(new_bin_no) + k_chunk_size - 1) /
+        k_chunk_size;
+
+    if (!m_chunk_directory.resize_large_chunk(chunk_no, new_bin_no)) {
       return false;
     }
+    priv_move_chunk_counts(old_bin_no, new_bin_no);
 
+    if (new_num_chunks > old_num_chunks) {
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+      m_chunk_release_queue.erase(chunk_no + old_num_chunks,
+                                  new_num_chunks - old_num_chunks);
+#endif
+      if (!priv_extend_segment(chunk_no, new_num_chunks)) {
+        // Put it back (shrinking never fails)
+        [[maybe_unused]] const bool ret =
+            m_chunk_directory.resize_large_chunk(chunk_no, old_bin_no);
+        assert(ret);
+        priv_move_chunk_counts(new_bin_no, old_bin_no);
+        return false;
+      }
+    } else {
+      priv_release_chunk_without_lock(chunk_no + new_num_chunks,
+                                      old_num_chunks - new_num_chunks);
+    }
+    priv_record_chunk_operation(chunk_operation::resize, chunk_no, new_bin_no);
     return true;
   }
 
+  void priv_move_chunk_counts(const bin_no_type from_bin_no,
+                              const bin_no_type to_bin_no) {
+    m_counters.add_chunks(from_bin_no,
+                          -difference_type(priv_num_chunks(from_bin_no)));
+    m_counters.add_chunks(to_bin_no, priv_num_chunks(to_bin_no));
+  }
+
+  /// \brief Extends the segment to hold the chunks.
+  /// Can be called with or without the chunk lock.
+  /// \param zero_filled If not nullptr, set to true if all the chunks are
+  /// zero-filled, i.e., have never been used since the datastore was created
+  /// or opened or have been freed with their file space.
+  bool priv_extend_segment(const chunk_no_type head_chunk_no,
+                           const size_type num_chunks,
+                           bool *const zero_filled = nullptr) {
+    const size_type required_segment_size =
+        (head_chunk_no + num_chunks) * k_chunk_size;
+    bool crossed_soft_limit = false;
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type segment_guard(*m_segment_mutex);
+#endif
+      // Every new chunk comes here; thus, the chunks above the highest one
+      // given out so far have never been used
+      bool all_zero_filled = true;
+      for (size_type c = 0; c < num_chunks; ++c) {
+        const chunk_no_type chunk_no = head_chunk_no + c;
+        if (chunk_no * k_chunk_size >= m_zero_filled_offset) break;
+        // The chunks are in use from now on
+        all_zero_filled &= m_zero_filled_chunks.erase(chunk_no);
+      }
+      if (zero_filled) *zero_filled = all_zero_filled;
+      m_zero_filled_offset =
+          std::max(m_zero_filled_offset, required_segment_size);
+
+      const size_type current_size = m_segment_storage->size();
+      if (required_segment_size <= current_size) {
+        return true;  // Has an enough segment size already
+      }
+
+      if (m_segment_size_hard_limit == 0 ||
+          required_segment_size <= m_segment_size_hard_limit) {
+        if (!m_segment_storage->extend(required_segment_size)) {
+          METALL_LOG(logger::level::error, "Failed to extend the segment to "
+                     << required_segment_size << " bytes");
+          return false;
+        }
+        crossed_soft_limit = m_segment_size_soft_limit > 0 &&
+                             current_size <= m_segment_size_soft_limit &&
+                             required_segment_size > m_segment_size_soft_limit;
+        if (!crossed_soft_limit) return true;
+      }
+    }
+
+    // Called without the lock as the handler may call the allocator
+    if (crossed_soft_limit) {
+      if (m_segment_limit_handler) {
+        m_segment_limit_handler(segment_limit::soft, required_segment_size);
+      }
+      return true;
+    }
+    METALL_LOG(logger::level::warning,
+               "The segment size would exceed the hard limit: "
+                   << required_segment_size << " > "
+                   << m_segment_size_hard_limit);
+    if (m_segment_limit_handler) {
+      m_segment_limit_handler(segment_limit::hard, required_segment_size);
+    }
+    return false;
+  }
+
   // ---------- For deallocation ---------- //
   void priv_deallocate_small_object(const difference_type offset,
                                     const bin_no_type bin_no) {
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+    if (priv_push_remote_free(offset, bin_no)) return;
+#endif
 #ifndef METALL_DISABLE_OBJECT_CACHE
-    if (bin_no <= m_object_cache.max_bin_no()) {
+    // The objects of the placement hint arenas are not reused by others
+    if (bin_no <= m_object_cache.max_bin_no() &&
+        (k_num_placement_hints == 0 ||
+         m_chunk_directory.arena_no(offset / k_chunk_size) <
+             k_num_thread_arenas)) {
       [[maybe_unused]] const bool ret = m_object_cache.push(
           bin_no, offset, this,
           &myself::priv_deallocate_small_objects_from_global);
@@ -541,17 +2162,39 @@ class segment_allocator {
   void priv_deallocate_small_objects_from_global(
       const bin_no_type bin_no, const size_type num_deallocates,
       const difference_type offsets[]) {
+    // Objects are returned to the arenas that own their chunks.
+    // Consecutive objects usually belong to the same arena; thus, take the
+    // bin lock of an arena once for each run of such objects.
+    size_type i = 0;
+    while (i < num_deallocates) {
+      if (offsets[i] == k_null_offset) {
+        ++i;
+        continue;
+      }
+      const arena_no_type arena_no =
+          m_chunk_directory.arena_no(offsets[i] / k_chunk_size);
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-    lock_guard_type bin_guard(m_bin_mutex->at(bin_no));
+      bin_lock_guard_type bin_guard(priv_bin_mutex(arena_no, bin_no));
+#endif
+#ifdef METALL_ENABLE_CONCURRENT_SLOT_CLAIM_IN_SEGMENT_ALLOCATOR
+      // Must be done before checking if a chunk was full
+      priv_pop_full_front_chunks_without_bin_lock(arena_no, bin_no);
 #endif
-    for (size_type i = 0; i < num_deallocates; ++i) {
-      priv_deallocate_small_object_from_global_without_bin_lock(offsets[i],
-                                                                bin_no);
+      for (; i < num_deallocates; ++i) {
+        if (offsets[i] == k_null_offset) continue;
+        if (m_chunk_directory.arena_no(offsets[i] / k_chunk_size) !=
+            arena_no) {
+          break;
+        }
+        priv_deallocate_small_object_from_global_without_bin_lock(
+            arena_no, bin_no, offsets[i]);
+      }
     }
   }
 
   void priv_deallocate_small_object_from_global_without_bin_lock(
-      const difference_type offset, const bin_no_type bin_no) {
+      const arena_no_type arena_no, const bin_no_type bin_no,
+      const difference_type offset) {
     if (offset == k_null_offset) return;
 
     const size_type object_size = bin_no_mngr::to_object_size(bin_no);
@@ -561,25 +2204,20 @@ class segment_allocator {
     const bool was_full = m_chunk_directory.all_slots_marked(chunk_no);
     m_chunk_directory.unmark_slot(chunk_no, slot_no);
     if (was_full) {
-      m_non_full_chunk_bin.insert(bin_no, chunk_no);
+      m_non_full_chunk_bin[arena_no].insert(bin_no, chunk_no);
     } else if (m_chunk_directory.all_slots_unmarked(chunk_no)) {
-      // All slots in the chunk are not used, deallocate it
-      {
-#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
-        lock_guard_type chunk_guard(*m_chunk_mutex);
-#endif
-        m_chunk_directory.erase(chunk_no);
-        priv_free_chunk(chunk_no, 1);
-      }
-      m_non_full_chunk_bin.erase(bin_no, chunk_no);
+      // All slots in the chunk are not used, deallocate it.
+      // No thread allocates from the chunk as the bin lock is held.
+      priv_erase_and_free_chunk(chunk_no, 1);
+      m_non_full_chunk_bin[arena_no].erase(bin_no, chunk_no);
 
       return;
     }
 
-#ifdef METALL_FREE_SMALL_OBJECT_SIZE_HINT
-    priv_free_slot_without_bin_lock(object_size, chunk_no, slot_no,
-                                    METALL_FREE_SMALL_OBJECT_SIZE_HINT);
-#endif
+    if (m_free_small_object_size_hint > 0) {
+      priv_free_slot_without_bin_lock(object_size, chunk_no, slot_no,
+                                      m_free_small_object_size_hint);
+    }
   }
 
   void priv_free_slot_without_bin_lock(const size_type object_size,
@@ -641,25 +2279,258 @@ class segment_allocator {
     assert(free_size % m_segment_storage->page_size() == 0);
 
     m_segment_storage->free_region(range_begin, free_size);
+    m_counters.add_freed_bytes(free_size);
+    METALL_TRACE(free_slot_pages, range_begin, free_size);
   }
 
   void priv_deallocate_large_object(const chunk_no_type chunk_no,
                                     const bin_no_type bin_no) {
+    priv_erase_and_free_chunk(chunk_no, priv_num_chunks(bin_no));
+  }
+
+  /// \brief Frees the pages of chunks that are not used, or queues them to
+  /// free later if METALL_USE_DEFERRED_CHUNK_RELEASE is defined.
+  /// Must be called with the chunk lock.
+  void priv_release_chunk_without_lock(const chunk_no_type head_chunk_no,
+                                       const size_type num_chunks) {
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+    m_chunk_release_queue.push(head_chunk_no, num_chunks);
+    if (METALL_CHUNK_RELEASE_BATCH_SIZE > 0 &&
+        m_chunk_release_queue.num_chunks() * k_chunk_size >=
+            METALL_CHUNK_RELEASE_BATCH_SIZE) {
+      priv_release_queued_chunks_without_lock();
+    }
+#else
+    priv_free_chunk(head_chunk_no, num_chunks);
+#endif
+  }
+
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+  void priv_release_queued_chunks() {
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
     lock_guard_type chunk_guard(*m_chunk_mutex);
 #endif
-    m_chunk_directory.erase(chunk_no);
-    const size_type num_chunks =
-        (bin_no_mngr::to_object_size(bin_no) + k_chunk_size - 1) / k_chunk_size;
-    priv_free_chunk(chunk_no, num_chunks);
+    priv_release_queued_chunks_without_lock();
   }
 
+  /// \brief Frees the pages of the queued chunks.
+  /// The chunk lock must be held during it so that no chunk is reused.
+  void priv_release_queued_chunks_without_lock() {
+    m_chunk_release_queue.release(
+        [this](const chunk_no_type head_chunk_no, const size_type num_chunks) {
+          priv_free_chunk(head_chunk_no, num_chunks);
+        });
+  }
+#endif
+
+  /// \brief Frees the pages of chunks. Must be called before the chunks are
+  /// erased from the chunk directory or with the chunk lock.
   void priv_free_chunk(const chunk_no_type head_chunk_no,
                        const size_type num_chunks) {
     const off_t offset = head_chunk_no * k_chunk_size;
     const size_type length = num_chunks * k_chunk_size;
     assert(offset + length <= m_segment_storage->size());
-    m_segment_storage->free_region(offset, length);
+    m_counters.add_freed_bytes(length);
+    if constexpr (has_zero_filled_free_region_v<segment_storage_type>) {
+      bool zero_filled = false;
+      m_segment_storage->free_region(offset, length, &zero_filled);
+      if (!zero_filled) return;
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type segment_guard(*m_segment_mutex);
+#endif
+      for (size_type c = 0; c < num_chunks; ++c) {
+        m_zero_filled_chunks.insert(head_chunk_no + c);
+      }
+    } else {
+      m_segment_storage->free_region(offset, length);
+    }
+  }
+
+  // ---------- For medium objects ---------- //
+  static bin_no_type priv_medium_slab_bin() {
+    return bin_no_mngr::to_bin_no(k_medium_slab_size);
+  }
+
+  /// \brief Reads the medium object directory.
+  /// A data store that has no file has no medium object.
+  bool priv_deserialize_medium_object_directory(const fs::path &base_path) {
+    const auto path =
+        priv_make_file_name(base_path, k_medium_object_directory_file_name);
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    m_medium_object_directory.clear();
+    if (!fs::exists(path)) return true;
+    if (!m_medium_object_directory.deserialize(path)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to deserialize medium object directory");
+      return false;
+    }
+    return true;
+#else
+    if (!fs::exists(path)) return true;
+    medium_object_directory_type directory(k_medium_object_granule,
+                                           k_null_offset);
+    if (directory.deserialize(path) && directory.empty()) return true;
+    // The slabs would be taken as large objects
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The data store has medium objects; "
+                "define METALL_USE_MEDIUM_OBJECT_SLABS to open it");
+    return false;
+#endif
+  }
+
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+  static bool priv_medium_object_size(const size_type nbytes) {
+    return nbytes > k_medium_object_min_size &&
+           nbytes <= k_medium_object_max_size;
+  }
+
+  difference_type priv_allocate_medium_object(const size_type nbytes) {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+    lock_guard_type medium_guard(*m_medium_object_mutex);
+#endif
+    auto offset = m_medium_object_directory.allocate(nbytes);
+    if (offset == k_null_offset) {
+      const auto slab = priv_allocate_large_object(priv_medium_slab_bin());
+      if (slab == k_null_offset) return k_null_offset;
+      m_medium_object_directory.add_slab(slab, k_medium_slab_size);
+      offset = m_medium_object_directory.allocate(nbytes);
+    }
+    if (offset != k_null_offset) {
+      m_counters.add_medium_objects(
+          1, m_medium_object_directory.object_size(offset));
+    }
+    return offset;
+  }
+
+  /// \brief Rebuilds the medium object directory after replaying the chunk
+  /// operation log.
+  /// Objects could have been allocated in any free space of the slabs and in
+  /// the slabs made since the directory was written; thus, all such space is
+  /// reserved, i.e., leaked. The slabs that are no longer large objects are
+  /// dropped.
+  static bool priv_recover_medium_object_directory(
+      const fs::path &base_path, const chunk_directory_type &directory,
+      const std::vector<chunk_no_type> &inserted_large_chunks) {
+    const auto is_slab = [&directory](const chunk_no_type chunk_no) {
+      return chunk_no < directory.size() &&
+             directory.large_head_chunk(chunk_no) &&
+             directory.bin_no(chunk_no) == priv_medium_slab_bin();
+    };
+
+    const auto path =
+        priv_make_file_name(base_path, k_medium_object_directory_file_name);
+    medium_object_directory_type medium(k_medium_object_granule,
+                                        k_null_offset);
+    if (fs::exists(path) && !medium.deserialize(path)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to deserialize medium object directory");
+      return false;
+    }
+    std::vector<difference_type> dropped_slabs;
+    medium.for_each_slab([&](const difference_type offset, const size_type) {
+      if (!is_slab(offset / k_chunk_size)) dropped_slabs.push_back(offset);
+    });
+    for (const auto offset : dropped_slabs) medium.erase_slab(offset);
+    for (const auto chunk_no : inserted_large_chunks) {
+      const difference_type offset = chunk_no * k_chunk_size;
+      if (is_slab(chunk_no) && !medium.in_slab(offset)) {
+        medium.add_slab(offset, k_medium_slab_size);
+      }
+    }
+    medium.reserve_free_space();
+
+    if (!medium.serialize(path)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to serialize medium object directory");
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  /// \brief Deallocates a medium object.
+  /// \return Returns false if 'offset' is not in a medium object slab.
+  bool priv_deallocate_medium_object(
+      [[maybe_unused]] const difference_type offset) {
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+    difference_type empty_slab = k_null_offset;
+    {
+#ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
+      lock_guard_type medium_guard(*m_medium_object_mutex);
+#endif
+      if (!m_medium_object_directory.in_slab(offset)) return false;
+      // Deallocating reserved space does nothing, i.e., it stays leaked
+      const auto size = m_medium_object_directory.object_size(offset);
+      if (m_medium_object_directory.deallocate(offset, &empty_slab)) {
+        m_counters.add_medium_objects(-1, -difference_type(size));
+      }
+    }
+    if (empty_slab != k_null_offset) {
+      priv_deallocate_large_object(empty_slab / k_chunk_size,
+                                   priv_medium_slab_bin());
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // ---------- For compaction ---------- //
+  void priv_compact_bin_without_bin_lock(const arena_no_type arena_no,
+                                         const bin_no_type bin_no) {
+    auto &non_full_chunk_bin = m_non_full_chunk_bin[arena_no];
+    // Fuller chunks first; lower chunks first among the same occupancy
+    non_full_chunk_bin.sort(
+        bin_no, [this](const chunk_no_type lhs, const chunk_no_type rhs) {
+          const auto lhs_occupied = m_chunk_directory.occupied_slots(lhs);
+          const auto rhs_occupied = m_chunk_directory.occupied_slots(rhs);
+          return (lhs_occupied != rhs_occupied) ? lhs_occupied > rhs_occupied
+                                                : lhs < rhs;
+        });
+
+    for (auto itr = non_full_chunk_bin.begin(bin_no),
+              end = non_full_chunk_bin.end(bin_no);
+         itr != end; ++itr) {
+      priv_free_unused_pages_without_bin_lock(bin_no, *itr);
+    }
+  }
+
+  /// \brief Frees the pages in a small-object chunk that do not overlap with
+  /// any marked slot.
+  void priv_free_unused_pages_without_bin_lock(const bin_no_type bin_no,
+                                               const chunk_no_type chunk_no) {
+    const size_type object_size = bin_no_mngr::to_object_size(bin_no);
+    const size_type num_slots = m_chunk_directory.slots(chunk_no);
+    const size_type page_size = m_segment_storage->page_size();
+    assert(k_chunk_size % page_size == 0);
+
+    const auto used_page = [&](const size_type page_begin) {
+      const size_type first_slot = page_begin / object_size;
+      const size_type last_slot = std::min(
+          (page_begin + page_size - 1) / object_size, num_slots - 1);
+      for (size_type s = first_slot; s <= last_slot; ++s) {
+        if (m_chunk_directory.marked_slot(chunk_no, s)) return true;
+      }
+      return false;
+    };
+
+    const difference_type chunk_offset = chunk_no * k_chunk_size;
+    size_type range_begin = 0;  // The beginning of the unused pages
+    for (size_type page_begin = 0; page_begin < k_chunk_size;
+         page_begin += page_size) {
+      if (!used_page(page_begin)) continue;
+      if (range_begin < page_begin) {
+        m_segment_storage->free_region(chunk_offset + range_begin,
+                                       page_begin - range_begin);
+        m_counters.add_freed_bytes(page_begin - range_begin);
+      }
+      range_begin = page_begin + page_size;
+    }
+    if (range_begin < k_chunk_size) {
+      m_segment_storage->free_region(chunk_offset + range_begin,
+                                     k_chunk_size - range_begin);
+      m_counters.add_freed_bytes(k_chunk_size - range_begin);
+    }
   }
 
   // ---------- For object cache ---------- //
@@ -667,6 +2538,144 @@ class segment_allocator {
   void priv_clear_object_cache() {
     m_object_cache.clear(this,
                          &myself::priv_deallocate_small_objects_from_global);
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+    priv_clear_remote_free_lists();
+#endif
+  }
+#endif
+
+  // ---------- For remote free ---------- //
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+  static size_type priv_remote_free_list_no(const arena_no_type arena_no,
+                                            const bin_no_type bin_no) {
+    return arena_no * k_num_small_bins + bin_no;
+  }
+
+  /// \brief Pushes an object onto the remote free list of the arena that owns
+  /// its chunk if the arena is not the one of the calling thread.
+  /// \return Returns false if the object is not pushed.
+  bool priv_push_remote_free(const difference_type offset,
+                             const bin_no_type bin_no) {
+    if constexpr (k_num_thread_arenas == 1 || !k_thread_safe) {
+      return false;
+    } else {
+      const arena_no_type owner =
+          m_chunk_directory.arena_no(offset / k_chunk_size);
+      // The objects of the placement hint arenas go back to their chunks
+      if (owner >= k_num_thread_arenas || owner == priv_arena_no()) {
+        return false;
+      }
+      m_remote_free_list.push(priv_remote_free_list_no(owner, bin_no), offset,
+                              m_segment_storage->get_segment());
+      return true;
+    }
+  }
+
+  /// \brief Takes the objects other threads have freed into the chunks of the
+  /// arena of the calling thread.
+  /// One of them is returned and the rest go to the object cache of the
+  /// calling thread, so that they are reused while they are in the CPU cache.
+  /// \return An object or k_null_offset if there is none.
+  difference_type priv_take_remote_frees(const bin_no_type bin_no) {
+    if constexpr (k_num_thread_arenas == 1 || !k_thread_safe) {
+      return k_null_offset;
+    } else {
+      const arena_no_type arena_no = priv_arena_no();
+      if (arena_no >= k_num_thread_arenas) return k_null_offset;
+      const difference_type first = m_remote_free_list.take_all(
+          priv_remote_free_list_no(arena_no, bin_no));
+      if (first == k_null_offset) return k_null_offset;
+
+      const void *const base = m_segment_storage->get_segment();
+      for (auto offset = m_remote_free_list.next(first, base);
+           offset != k_null_offset;) {
+        const auto next = m_remote_free_list.next(offset, base);
+        if (bin_no <= m_object_cache.max_bin_no()) {
+          m_object_cache.push(
+              bin_no, offset, this,
+              &myself::priv_deallocate_small_objects_from_global);
+        } else {
+          priv_deallocate_small_objects_from_global(bin_no, 1, &offset);
+        }
+        offset = next;
+      }
+      return first;
+    }
+  }
+
+  /// \brief Returns all objects in the remote free lists to their chunks.
+  void priv_clear_remote_free_lists() {
+    const void *const base = m_segment_storage->get_segment();
+    std::vector<difference_type> offsets;
+    for (size_type arena_no = 0; arena_no < k_num_thread_arenas; ++arena_no) {
+      for (bin_no_type bin_no = 0; bin_no < k_num_small_bins; ++bin_no) {
+        offsets.clear();
+        for (auto offset = m_remote_free_list.take_all(
+                 priv_remote_free_list_no(arena_no, bin_no));
+             offset != k_null_offset;
+             offset = m_remote_free_list.next(offset, base)) {
+          offsets.push_back(offset);
+        }
+        priv_deallocate_small_objects_from_global(bin_no, offsets.size(),
+                                                  offsets.data());
+      }
+    }
+  }
+#endif
+
+#ifndef METALL_DISABLE_OBJECT_CACHE
+  /// \brief Calls 'func' with the bin number and offset of every cached
+  /// object. This function must not be called while other threads access the
+  /// object cache.
+  template <typename function_type>
+  void priv_for_each_cached_object(function_type func) const {
+    for (unsigned int c = 0; c < m_object_cache.num_caches(); ++c) {
+      for (bin_no_type b = 0; b <= m_object_cache.max_bin_no(); ++b) {
+        for (auto itr = m_object_cache.begin(c, b),
+                  end = m_object_cache.end(c, b);
+             itr != end; ++itr) {
+          func(b, *itr);
+        }
+        m_object_cache.for_each_in_lock_free_slots(
+            c, b,
+            [&func, b](const difference_type offset) { func(b, offset); });
+      }
+    }
+    for (bin_no_type b = 0; b <= m_object_cache.max_bin_no(); ++b) {
+      m_object_cache.for_each_in_thread_local_caches(
+          b, [&func, b](const difference_type offset) { func(b, offset); });
+    }
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+    // The objects in the remote free lists are counted as cached objects
+    for (size_type arena_no = 0; arena_no < k_num_thread_arenas; ++arena_no) {
+      for (bin_no_type b = 0; b < k_num_small_bins; ++b) {
+        m_remote_free_list.for_each(
+            priv_remote_free_list_no(arena_no, b),
+            m_segment_storage->get_segment(),
+            [&func, b](const difference_type offset) { func(b, offset); });
+      }
+    }
+#endif
+  }
+#endif
+
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+  /// \brief Returns the slots of all cached objects.
+  chunk_slot_list_type priv_get_cached_slots() const {
+    chunk_slot_list_type slots;
+    priv_for_each_cached_object(
+        [&slots](const bin_no_type bin_no, const difference_type offset) {
+          const size_type object_size = bin_no_mngr::to_object_size(bin_no);
+          const chunk_no_type chunk_no = offset / k_chunk_size;
+          slots[chunk_no].push_back((offset % k_chunk_size) / object_size);
+        });
+    return slots;
+  }
+
+  object_cache_trimmer::pause_guard_type priv_pause_object_cache_trimmer()
+      const {
+    if (!m_object_cache_trimmer) return {};
+    return m_object_cache_trimmer->pause();
   }
 #endif
 
@@ -685,39 +2694,74 @@ class segment_allocator {
       small_allocs.insert(k_chunk_size * chunk_no + object_size * slot_no);
     }
 
-    for (unsigned int c = 0; c < m_object_cache.num_caches(); ++c) {
-      for (bin_no_type b = 0; b <= m_object_cache.max_bin_no(); ++b) {
-        for (auto itr = m_object_cache.begin(c, b),
-                  end = m_object_cache.end(c, b);
-             itr != end; ++itr) {
-          const auto offset = *itr;
-          if (small_allocs.count(offset) == 0) {
-            return false;
-          }
-          small_allocs.erase(offset);
-        }
-      }
-    }
+    bool found_all = true;
+    priv_for_each_cached_object(
+        [&small_allocs, &found_all](const bin_no_type,
+                                    const difference_type offset) {
+          found_all &= (small_allocs.erase(offset) == 1);
+        });
 
-    return small_allocs.empty();
+    return found_all && small_allocs.empty();
   }
 #endif
 
   // -------------------- //
   // Private fields
   // -------------------- //
-  non_full_chunk_bin_type m_non_full_chunk_bin;
+  std::array<non_full_chunk_bin_type, k_num_arenas> m_non_full_chunk_bin;
   chunk_directory_type m_chunk_directory;
+  chunk_operation_log m_chunk_log;
   segment_storage_type *m_segment_storage{nullptr};
+  // See manager_options::free_small_object_size_hint
+  size_type m_free_small_object_size_hint{0};
+  // See manager_options::segment_size_soft_limit and segment_size_hard_limit
+  size_type m_segment_size_soft_limit{0};
+  size_type m_segment_size_hard_limit{0};
+  segment_limit_handler m_segment_limit_handler;
+  // The segment space at and above this offset has never been used since the
+  // datastore was created or opened; protected by the segment lock
+  size_type m_zero_filled_offset{0};
+  // The chunks below m_zero_filled_offset that are not in use and whose file
+  // space has been freed; protected by the segment lock
+  bitmap_bin<chunk_no_type> m_zero_filled_chunks;
+  allocation_counters m_counters;
 
 #ifndef METALL_DISABLE_OBJECT_CACHE
   small_object_cache_type m_object_cache;
 #endif
 
+#ifdef METALL_ENABLE_REMOTE_FREE_IN_SEGMENT_ALLOCATOR
+  remote_free_list_type m_remote_free_list;
+#endif
+
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+  medium_object_directory_type m_medium_object_directory;
+#endif
+
 #ifdef METALL_ENABLE_MUTEX_IN_SEGMENT_ALLOCATOR
   std::unique_ptr<mutex_type> m_chunk_mutex{nullptr};
-  std::unique_ptr<std::array<mutex_type, k_num_small_bins>> m_bin_mutex{
-      nullptr};
+  // Serializes extending the segment
+  std::unique_ptr<mutex_type> m_segment_mutex{nullptr};
+  std::unique_ptr<std::array<bin_mutex_type, k_num_small_bins * k_num_arenas>>
+      m_bin_mutex{nullptr};
+#ifdef METALL_ENABLE_MEDIUM_OBJECT_SLABS_IN_SEGMENT_ALLOCATOR
+  // Guards the medium object directory; taken before the chunk lock
+  std::unique_ptr<mutex_type> m_medium_object_mutex{nullptr};
+#endif
+#endif
+
+#ifdef METALL_ENABLE_DEFERRED_CHUNK_RELEASE_IN_SEGMENT_ALLOCATOR
+  // Guarded by the chunk lock
+  chunk_release_queue m_chunk_release_queue;
+#endif
+
+#ifdef METALL_ENABLE_ALLOCATION_SAMPLING_IN_SEGMENT_ALLOCATOR
+  allocation_sampler m_allocation_sampler{METALL_ALLOCATION_SAMPLING_INTERVAL};
+#endif
+
+#ifdef METALL_ENABLE_OBJECT_CACHE_TRIMMER_IN_SEGMENT_ALLOCATOR
+  // Declared last so that it stops before the other members are destroyed
+  std::unique_ptr<object_cache_trimmer> m_object_cache_trimmer{nullptr};
 #endif
 };
 
@@ -12,16 +12,44 @@
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <future>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <deque>
+#include <fstream>
+#include <cstring>
+#include <functional>
+#include <chrono>
 
 #include "metall/defs.hpp"
+#include "metall/detail/cuda.hpp"
+#include "metall/detail/direct_io.hpp"
 #include "metall/detail/file.hpp"
 #include "metall/detail/file_clone.hpp"
 #include "metall/detail/mmap.hpp"
+#include "metall/detail/io_executor.hpp"
+#include "metall/detail/numa.hpp"
+#include "metall/detail/pmem.hpp"
 #include "metall/detail/utilities.hpp"
+#include "metall/detail/zstd_file.hpp"
 #include "metall/logger.hpp"
+#include "metall/tracing.hpp"
+#include "metall/kernel/access_pattern.hpp"
 #include "metall/kernel/storage.hpp"
 #include "metall/kernel/segment_header.hpp"
 
+#if defined(METALL_USE_INCREMENTAL_SYNC) && defined(__linux__)
+#define METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+#endif
+
+#ifdef __linux__
+#define METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+#include "metall/detail/soft_dirty_page.hpp"
+#endif
+
 namespace metall::kernel {
 
 namespace {
@@ -31,22 +59,103 @@ namespace mdtl = metall::mtlldetail;
 class segment_storage {
  private:
   static constexpr const char *k_dir_name = "segment";
+  static constexpr const char *k_delta_index_file_name = "delta-index";
+  static constexpr const char *k_delta_data_file_name = "delta-data";
+  static constexpr const char *k_delta_resolving_mark_file_name =
+      "delta-resolving";
+  static constexpr std::size_t k_delta_buffer_size = 1ULL << 24ULL;
+  // The size of the regions diff() compares in a task
+  static constexpr std::size_t k_diff_task_size = 1ULL << 26ULL;
+  // The unit in which copy_regions() leaves zeros as holes
+  static constexpr std::size_t k_zero_check_unit = 4096;
+  static constexpr const char *k_compressed_file_extension = ".zst";
 
 #ifndef METALL_SEGMENT_BLOCK_SIZE
 #error "METALL_SEGMENT_BLOCK_SIZE is not defined."
 #endif
-  // TODO: check block size is a multiple of page size
+  // The default block size; see set_block_size()
   static constexpr std::size_t k_block_size = METALL_SEGMENT_BLOCK_SIZE;
 
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+  static constexpr std::size_t k_huge_page_size =
+      METALL_SEGMENT_HUGE_PAGE_SIZE;
+  static_assert(k_huge_page_size > 0 &&
+                    (k_huge_page_size & (k_huge_page_size - 1)) == 0,
+                "METALL_SEGMENT_HUGE_PAGE_SIZE must be a power of two");
+  static_assert(k_block_size % k_huge_page_size == 0,
+                "METALL_SEGMENT_BLOCK_SIZE must be a multiple of "
+                "METALL_SEGMENT_HUGE_PAGE_SIZE");
+#endif
+
+#if defined(METALL_SEGMENT_NUMA_INTERLEAVE) && \
+    defined(METALL_SEGMENT_NUMA_BIND_RANGE_SIZE)
+#error "Only one NUMA policy can be specified"
+#endif
+
+#ifdef METALL_SEGMENT_NUMA_BIND_RANGE_SIZE
+  static constexpr std::size_t k_numa_bind_range_size =
+      METALL_SEGMENT_NUMA_BIND_RANGE_SIZE;
+  static_assert(k_numa_bind_range_size > 0 &&
+                    k_numa_bind_range_size % (1ULL << 12ULL) == 0,
+                "METALL_SEGMENT_NUMA_BIND_RANGE_SIZE must be a multiple of "
+                "the page size");
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+  static_assert(k_numa_bind_range_size % k_huge_page_size == 0,
+                "METALL_SEGMENT_NUMA_BIND_RANGE_SIZE must be a multiple of "
+                "METALL_SEGMENT_HUGE_PAGE_SIZE");
+#endif
+#endif
+
+  static constexpr std::size_t k_num_preextended_blocks =
+      METALL_SEGMENT_NUM_PREEXTENDED_BLOCKS;
+
+#ifdef METALL_PREFAULT_NEW_BLOCKS
+  static constexpr bool k_prefault_new_blocks = true;
+#else
+  static constexpr bool k_prefault_new_blocks = false;
+#endif
+
+#ifdef METALL_USE_GEOMETRIC_BLOCK_GROWTH
+  static constexpr std::size_t k_max_block_size =
+      METALL_SEGMENT_MAX_BLOCK_SIZE;
+  static_assert(k_max_block_size >= k_block_size &&
+                    k_max_block_size % k_block_size == 0,
+                "METALL_SEGMENT_MAX_BLOCK_SIZE must be a multiple of "
+                "METALL_SEGMENT_BLOCK_SIZE");
+#endif
+
+  /// \brief The address of the segment is aligned to this value so that
+  /// the allocations aligned within the segment are also aligned in the
+  /// address space, e.g., for 1 GB huge pages.
+  /// Reserving the extra region for the alignment consumes only address space.
+  static constexpr std::size_t k_segment_alignment = 1ULL << 30ULL;
+
  public:
   using path_type = storage::path_type;
   using segment_header_type = segment_header;
 
+ private:
+  // (offset, length)
+  using sync_range_type = std::pair<std::size_t, std::size_t>;
+
+ public:
+
   segment_storage() {
 #ifdef METALL_USE_ANONYMOUS_NEW_MAP
     logger::out(logger::level::verbose, __FILE__, __LINE__,
                 "METALL_USE_ANONYMOUS_NEW_MAP is defined");
 #endif
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+    logger::out(logger::level::verbose, __FILE__, __LINE__,
+                "METALL_SEGMENT_HUGE_PAGE_SIZE is defined");
+#endif
+#ifdef METALL_USE_DAX
+    logger::out(logger::level::verbose, __FILE__, __LINE__,
+                "METALL_USE_DAX is defined");
+#endif
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    m_dirty_page_tracker = std::make_unique<mdtl::soft_dirty_page_tracker>();
+#endif
 
     if (!priv_set_system_page_size()) {
       priv_set_broken_status();
@@ -54,6 +163,9 @@ class segment_storage {
   }
 
   ~segment_storage() {
+    priv_wait_async_sync();
+    priv_discard_preextended_blocks();
+    priv_wait_prefaults();
     int ret = true;
     if (is_open()) {
       ret &= sync(true);
@@ -73,41 +185,85 @@ class segment_storage {
 
   segment_storage(segment_storage &&other) noexcept
       : m_system_page_size(other.m_system_page_size),
+        m_block_size(other.m_block_size),
         m_num_blocks(other.m_num_blocks),
         m_vm_region_size(other.m_vm_region_size),
         m_segment_capacity(other.m_segment_capacity),
-        m_current_segment_size(other.m_current_segment_size),
+        m_current_segment_size(other.m_current_segment_size.load()),
         m_vm_region(other.m_vm_region),
         m_segment(other.m_segment),
         m_segment_header(other.m_segment_header),
         m_top_path(other.m_top_path),
         m_read_only(other.m_read_only),
+        m_copy_on_write(other.m_copy_on_write),
+        m_volatile(other.m_volatile),
         m_free_file_space(other.m_free_file_space),
-        m_block_fd_list(std::move(other.m_block_fd_list))
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
+        m_block_fd_list(std::move(other.m_block_fd_list)),
+        m_block_offset_list(std::move(other.m_block_offset_list)),
+        m_pinned_ranges(std::move(other.m_pinned_ranges)),
+        m_pinned_size(other.m_pinned_size),
+        m_gpu_registered_ranges(std::move(other.m_gpu_registered_ranges)),
+        m_dax_mapped(other.m_dax_mapped),
+        m_write_back_cache(other.m_write_back_cache),
+        m_write_back_cache_budget(other.m_write_back_cache_budget),
+        m_anonymous_map_flag_list(std::move(other.m_anonymous_map_flag_list))
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
         ,
-        m_anonymous_map_flag_list(other.m_anonymous_map_flag_list)
+        m_dirty_page_tracker(std::move(other.m_dirty_page_tracker))
 #endif
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+        ,
+        m_snapshot_page_tracker(std::move(other.m_snapshot_page_tracker)),
+        m_replication_page_tracker(
+            std::move(other.m_replication_page_tracker))
+#endif
+        ,
+        m_async_sync(std::move(other.m_async_sync)),
+        m_preextended_blocks(std::move(other.m_preextended_blocks)),
+        m_directory_sync_pending(other.m_directory_sync_pending),
+        m_prefaults(std::move(other.m_prefaults))
   {
     other.priv_set_broken_status();
   }
 
   segment_storage &operator=(segment_storage &&other) noexcept {
+    priv_wait_async_sync();
+    priv_discard_preextended_blocks();
+    priv_wait_prefaults();
     m_system_page_size = other.m_system_page_size;
+    m_block_size = other.m_block_size;
     m_num_blocks = other.m_num_blocks;
     m_vm_region_size = other.m_vm_region_size;
     m_segment_capacity = other.m_segment_capacity;
-    m_current_segment_size = other.m_current_segment_size;
+    m_current_segment_size = other.m_current_segment_size.load();
     m_vm_region = other.m_vm_region;
     m_segment_header = other.m_segment_header;
     m_segment = other.m_segment;
     m_top_path = std::move(other.m_top_path);
     m_read_only = other.m_read_only;
+    m_copy_on_write = other.m_copy_on_write;
+    m_volatile = other.m_volatile;
     m_free_file_space = other.m_free_file_space;
     m_block_fd_list = std::move(other.m_block_fd_list);
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
+    m_block_offset_list = std::move(other.m_block_offset_list);
+    m_pinned_ranges = std::move(other.m_pinned_ranges);
+    m_pinned_size = other.m_pinned_size;
+    m_gpu_registered_ranges = std::move(other.m_gpu_registered_ranges);
+    m_dax_mapped = other.m_dax_mapped;
+    m_write_back_cache = other.m_write_back_cache;
+    m_write_back_cache_budget = other.m_write_back_cache_budget;
     m_anonymous_map_flag_list = std::move(other.m_anonymous_map_flag_list);
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    m_dirty_page_tracker = std::move(other.m_dirty_page_tracker);
 #endif
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    m_snapshot_page_tracker = std::move(other.m_snapshot_page_tracker);
+    m_replication_page_tracker = std::move(other.m_replication_page_tracker);
+#endif
+    m_async_sync = std::move(other.m_async_sync);
+    m_preextended_blocks = std::move(other.m_preextended_blocks);
+    m_directory_sync_pending = other.m_directory_sync_pending;
+    m_prefaults = std::move(other.m_prefaults);
     other.priv_set_broken_status();
     return (*this);
   }
@@ -137,6 +293,64 @@ class segment_storage {
     return priv_create(priv_top_dir_path(base_path), capacity);
   }
 
+  /// \brief Creates a new volatile segment, whose blocks are kept in
+  /// anonymous memory instead of the block files, e.g., for intermediate
+  /// data that does not have to outlive the process. sync() writes nothing
+  /// and the data is lost when the segment is released. spill() moves blocks
+  /// to their files when the memory runs short.
+  /// \param base_path A base directory path to create a segment, where the
+  /// spilled blocks are written.
+  /// \param capacity A segment capacity to reserve.
+  /// \return Return true if success; otherwise, false.
+  bool create_volatile(const path_type &base_path,
+                       const std::size_t capacity) {
+    return priv_create(priv_top_dir_path(base_path), capacity, true);
+  }
+
+  /// \brief Sets the size of the blocks of a segment created after this
+  /// call, instead of METALL_SEGMENT_BLOCK_SIZE. Opening a segment uses the
+  /// block size the segment was created with, i.e., the size of the first
+  /// block.
+  /// \param block_size A multiple of the page size (or
+  /// METALL_SEGMENT_HUGE_PAGE_SIZE). If METALL_USE_GEOMETRIC_BLOCK_GROWTH is
+  /// defined, METALL_SEGMENT_MAX_BLOCK_SIZE must be a multiple of it.
+  /// \return Returns false if the size is invalid or a segment is open.
+  bool set_block_size(const std::size_t block_size) {
+    if (is_open() || !priv_valid_block_size(block_size)) {
+      std::string s("Invalid segment block size: " +
+                    std::to_string(block_size));
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    m_block_size = block_size;
+    return true;
+  }
+
+  /// \brief Returns the size of the first block, which the following blocks
+  /// are sized by.
+  std::size_t block_size() const { return m_block_size; }
+
+  /// \brief Enables or disables the write-back cache mode, which maps the
+  /// new blocks anonymously instead of their files so that writing them does
+  /// not fault through the file system, e.g., to ingest data into a datastore
+  /// on a slow file system at memory speed. A block is written to its file at
+  /// the next sync, skipping the pages that are zero, and its file is mapped
+  /// instead; thus, a block is cached only until the next sync.
+  /// METALL_USE_ANONYMOUS_NEW_MAP enables it by default.
+  /// Applies to the blocks added after this call.
+  /// \param enabled If true, enables the mode.
+  /// \param memory_budget If not 0, the max bytes of the blocks mapped
+  /// anonymously at a time. The blocks added beyond it are mapped from their
+  /// files until a sync writes back the cached blocks.
+  void set_write_back_cache(const bool enabled,
+                            const std::size_t memory_budget = 0) {
+    m_write_back_cache = enabled;
+    m_write_back_cache_budget = memory_budget;
+  }
+
+  /// \brief Returns true if the write-back cache mode is enabled.
+  bool write_back_cache() const { return m_write_back_cache; }
+
   /// \brief Opens an existing segment.
   /// Calling this function fails if this class already manages an opened
   /// segment.
@@ -147,7 +361,45 @@ class segment_storage {
   /// \return Return true if success; otherwise, false.
   bool open(const path_type &base_path, const std::size_t capacity,
             const bool read_only) {
-    return priv_open(priv_top_dir_path(base_path), capacity, read_only);
+    return priv_open(priv_top_dir_path(base_path), capacity, read_only, false);
+  }
+
+  /// \brief Opens an existing segment with the copy-on-write mode.
+  /// The block files are mapped with MAP_PRIVATE and the segment is extended
+  /// with anonymous memory; the segment is writable, but nothing is written
+  /// back to the files, which can be read only.
+  /// Calling this function fails if this class already manages an opened
+  /// segment.
+  /// \param base_path A base directory path to open a segment.
+  /// \param capacity A segment capacity to reserve.
+  /// \return Return true if success; otherwise, false.
+  bool open_copy_on_write(const path_type &base_path,
+                          const std::size_t capacity) {
+    return priv_open(priv_top_dir_path(base_path), capacity, false, true);
+  }
+
+  /// \brief Opens an existing segment read-only while another process keeps
+  /// it open with the write mode and extends it.
+  /// Maps only the blocks that cover the first 'segment_size' bytes, as the
+  /// following blocks can be being created, and reserves a VM region of
+  /// 'capacity' bytes so that map_new_blocks() can map the blocks added later.
+  /// \param base_path A base directory path to open a segment.
+  /// \param capacity A segment capacity to reserve.
+  /// \param segment_size The segment size the writer has published.
+  /// \return Return true if success; otherwise, false.
+  bool open_live_read_only(const path_type &base_path,
+                           const std::size_t capacity,
+                           const std::size_t segment_size) {
+    return priv_open(priv_top_dir_path(base_path), capacity, true, false,
+                     segment_size);
+  }
+
+  /// \brief Maps the blocks added by the writer of a segment opened by
+  /// open_live_read_only() until the segment is equal to or larger than
+  /// 'segment_size'.
+  /// \return Returns true on success.
+  bool map_new_blocks(const std::size_t segment_size) {
+    return priv_map_new_blocks(segment_size);
   }
 
   /// \brief Extends the currently opened segment if necessary.
@@ -165,15 +417,213 @@ class segment_storage {
   /// \brief Syncs the segment with backing files.
   /// \param sync If false is specified, this function returns before finishing
   /// the sync operation.
-  bool sync(const bool sync) { return priv_sync(sync); }
+  bool sync(const bool sync) {
+    priv_wait_async_sync();
+    return priv_sync(sync);
+  }
+
+  /// \brief Syncs the segment with the backing files in the background.
+  /// Unlike sync(), the segment stays writable while the data is written
+  /// back; the data written after this call may or may not be synced by this
+  /// operation. Only one asynchronous sync runs at a time; sync(), release(),
+  /// and the next sync_async() wait for the running one.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Returns an object of std::future.
+  /// If succeeded, its get() returns true; otherwise, false.
+  std::future<bool> sync_async(const int max_num_threads) {
+    return priv_sync_async(max_num_threads);
+  }
+
+  /// \brief Makes the data in the specified region durable, e.g., after
+  /// updating a few objects, without syncing the whole segment.
+  /// If dax_mapped() is true, writes back only the CPU cache lines of the
+  /// region; otherwise, msyncs the pages of the region.
+  /// The region is clipped to the current segment.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error.
+  bool persist(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_persist(offset, nbytes);
+  }
+
+  /// \brief Returns true if all block files are mapped with MAP_SYNC, i.e.,
+  /// they are on a file system mounted with DAX and METALL_USE_DAX is
+  /// defined.
+  bool dax_mapped() const { return m_dax_mapped; }
 
   /// \brief Tries to free the specified region in DRAM and file(s).
   /// The actual behavior depends on the running system.
   /// \param offset An offset to the region from the beginning of the segment.
   /// \param nbytes The size of the region.
-  bool free_region(const std::ptrdiff_t offset, const std::size_t nbytes) {
+  /// \param zero_filled If not nullptr, set to true if the whole region reads
+  /// as zeros afterward, e.g., its file space is freed.
+  bool free_region(const std::ptrdiff_t offset, const std::size_t nbytes,
+                   bool *const zero_filled = nullptr) {
     return priv_free_region(
-        offset, nbytes);  // Failing this operation is not a critical error
+        offset, nbytes,
+        zero_filled);  // Failing this operation is not a critical error
+  }
+
+  /// \brief Loads the pages of the specified region into memory in parallel,
+  /// so that the following accesses do not take a page fault per page.
+  /// The region is clipped to the current segment.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error.
+  bool prefetch(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_prefetch(offset, nbytes);
+  }
+
+  /// \brief Loads the pages of the specified region into memory as
+  /// prefetch(offset, nbytes) does, with a bounded number of threads.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param on_loaded If not empty, called with the number of bytes each time
+  /// a piece of the region is loaded, by the loading threads concurrently.
+  /// \return Returns false on error.
+  bool prefetch(const std::ptrdiff_t offset, const std::size_t nbytes,
+                const int max_num_threads,
+                const std::function<void(std::size_t)> &on_loaded) {
+    return priv_prefetch(offset, nbytes, max_num_threads, on_loaded);
+  }
+
+  /// \brief Pins the pages of the specified region in memory (mlock), so
+  /// that the kernel does not evict them from the page cache, e.g., while
+  /// streaming through other data. The region is rounded to the page
+  /// boundaries and clipped to the current segment.
+  /// The pinned pages count against METALL_SEGMENT_MAX_PINNED_SIZE and
+  /// RLIMIT_MEMLOCK. This function is not thread-safe.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error, e.g., exceeding the limit.
+  bool pin(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_pin(offset, nbytes);
+  }
+
+  /// \brief Unpins the pages of the specified region.
+  /// This function is not thread-safe.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error.
+  bool unpin(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_unpin(offset, nbytes);
+  }
+
+  /// \brief Returns the number of the bytes pinned in memory.
+  std::size_t pinned_size() const { return m_pinned_size; }
+
+  /// \brief Registers the pages of the specified region to CUDA as pinned
+  /// host memory, so that GPU kernels access it directly and copies from it
+  /// do not go through a staging buffer. The region is rounded to the page
+  /// boundaries and clipped to the current segment; it must not overlap the
+  /// regions already registered.
+  /// Requires METALL_USE_CUDA. This function is not thread-safe.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error.
+  bool gpu_register(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_gpu_register(offset, nbytes);
+  }
+
+  /// \brief Unregisters a region registered by gpu_register().
+  /// This function is not thread-safe.
+  /// \param offset The offset given to gpu_register().
+  /// \param nbytes The size given to gpu_register().
+  /// \return Returns false on error.
+  bool gpu_unregister(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    return priv_gpu_unregister(offset, nbytes);
+  }
+
+  /// \brief Loads the specified region into a device buffer.
+  /// The pieces of the region in block files are read with cuFile
+  /// (GPUDirect Storage), i.e., straight from storage into device memory
+  /// without page faults and a host bounce buffer, after writing back their
+  /// dirty pages. The other pieces, or all pieces if cuFile is not
+  /// available, are copied from the mapped segment.
+  /// Requires METALL_USE_CUDA; METALL_USE_CUFILE enables cuFile.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \param device_buffer A device buffer of at least nbytes bytes.
+  /// \return Returns false on error, e.g., the region is not in the segment.
+  bool load_to_device(const std::ptrdiff_t offset, const std::size_t nbytes,
+                      void *const device_buffer) {
+    return priv_load_to_device(offset, nbytes, device_buffer);
+  }
+
+  /// \brief Tells the kernel that the pages of the specified region will not
+  /// be accessed soon, so that they are evicted before other pages, e.g.,
+  /// after scanning the region once.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns false on error or if it is not supported.
+  bool advise_cold(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+    return mdtl::advise_cold(static_cast<char *>(m_segment) + begin,
+                             end - begin);
+  }
+
+  /// \brief Gives the kernel the access pattern of a region (madvise), e.g.,
+  /// not to read ahead the pages of a hash table.
+  /// The region is rounded to the page boundaries and clipped to the current
+  /// segment. access_pattern::dont_need drops the pages from the page tables
+  /// (MADV_DONTNEED) if the region is mapped from the block files; otherwise,
+  /// it deactivates them (MADV_COLD), not to discard private pages.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \param pattern The access pattern.
+  /// \return Returns false on error or if the advice is not supported.
+  bool advise_access_pattern(const std::ptrdiff_t offset,
+                             const std::size_t nbytes,
+                             const access_pattern pattern) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+    auto *const addr = static_cast<char *>(m_segment) + begin;
+    const auto length = end - begin;
+    switch (pattern) {
+      case access_pattern::normal:
+        return mdtl::os_madvise(addr, length, MADV_NORMAL);
+      case access_pattern::sequential:
+        return mdtl::os_madvise(addr, length, MADV_SEQUENTIAL);
+      case access_pattern::random:
+        return mdtl::os_madvise(addr, length, MADV_RANDOM);
+      case access_pattern::will_need:
+        return mdtl::advise_will_need(addr, length);
+      case access_pattern::dont_need:
+        if (priv_file_mapped(begin, end)) {
+          return mdtl::os_madvise(addr, length, MADV_DONTNEED);
+        }
+        return mdtl::advise_cold(addr, length);
+    }
+    return false;
+  }
+
+  /// \brief Binds the pages of the specified region to a NUMA node (mbind),
+  /// e.g., to place cold data on a far memory tier such as CXL memory, and
+  /// moves the pages already allocated on other nodes.
+  /// The region is rounded to the page boundaries and clipped to the current
+  /// segment. On Linux, the page cache of a file on a file system other than
+  /// tmpfs is allocated by the policy of the faulting thread; only the pages
+  /// already in the page cache are moved.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \param node A NUMA node.
+  /// \return Returns false on error or if it is not supported.
+  bool bind_to_numa_node(const std::ptrdiff_t offset, const std::size_t nbytes,
+                         const int node) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+    return mdtl::numa::bind(static_cast<char *>(m_segment) + begin,
+                            end - begin, node, true);
   }
 
   /// \brief Takes a snapshot of the segment.
@@ -184,11 +634,216 @@ class segment_storage {
   /// \return Return true if success; otherwise, false.
   bool snapshot(const path_type &snapshot_path, const bool clone,
                 const int max_num_threads) {
+    if (m_copy_on_write || m_volatile) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot take a snapshot of a copy-on-write or volatile "
+                  "segment");
+      return false;
+    }
     sync(true);
+    // Not to copy files being created
+    priv_wait_preextended_blocks();
     return priv_copy(m_top_path, priv_top_dir_path(snapshot_path), clone,
                      max_num_threads);
   }
 
+  /// \brief Takes a snapshot of the segment writing the block files with
+  /// direct I/O (O_DIRECT) so that the snapshot does not fill the page cache
+  /// and evict the pages of the application.
+  /// The resident pages are written from the segment and the others are read
+  /// from the block files with direct I/O. Falls back to a normal copy on
+  /// file systems that do not support direct I/O, e.g., tmpfs.
+  /// \param snapshot_path A path to a snapshot.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  bool snapshot_direct(const path_type &snapshot_path,
+                       const int max_num_threads) {
+    if (m_copy_on_write || m_volatile) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot take a snapshot of a copy-on-write or volatile "
+                  "segment");
+      return false;
+    }
+    sync(true);
+    priv_wait_preextended_blocks();
+    return priv_copy_direct(priv_top_dir_path(snapshot_path),
+                            max_num_threads);
+  }
+
+  /// \brief Starts tracking the pages written in the segment so that the
+  /// next snapshot_delta() saves only them.
+  /// This function is expected to be called right after taking a full
+  /// snapshot; the pages written before calling this function are not
+  /// saved by snapshot_delta().
+  /// \return Returns false if the tracking is not available, e.g., the
+  /// kernel does not support the soft-dirty bits.
+  bool track_snapshot_delta() { return priv_track_snapshot_delta(); }
+
+  /// \brief Checks if the pages written since the last snapshot are tracked.
+  bool snapshot_delta_tracked() const {
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    return !!m_snapshot_page_tracker;
+#else
+    return false;
+#endif
+  }
+
+  /// \brief Takes an incremental snapshot that contains only the pages
+  /// written since the last snapshot (a delta).
+  /// The pages are read from the memory; thus, this function does not sync
+  /// the segment and does not depend on reflink.
+  /// The snapshot has to be resolved by resolve_snapshot_delta() with its
+  /// parent snapshots before being opened.
+  /// \param snapshot_path A path to a snapshot.
+  /// \return Return true if success; otherwise, false.
+  bool snapshot_delta(const path_type &snapshot_path) {
+    return priv_snapshot_delta(priv_top_dir_path(snapshot_path));
+  }
+
+  /// \brief Writes the segment to 'stream' so that apply_replication()
+  /// replicates it to another datastore, e.g., a standby on a remote node.
+  /// The pages are read from the memory as snapshot_delta() does.
+  /// \param stream An output stream.
+  /// \param full If true, writes the whole segment and starts tracking the
+  /// pages written afterward; otherwise, writes only the pages written since
+  /// the previous call.
+  /// \return Return true if success; otherwise, false.
+  /// If this function fails, the next call has to be a full one.
+  bool replicate(std::ostream &stream, const bool full) {
+    return priv_replicate(stream, full);
+  }
+
+  /// \brief Checks if the pages written since the last replicate() are
+  /// tracked, i.e., the next replicate() can write only them.
+  bool replication_tracked() const {
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    return !!m_replication_page_tracker;
+#else
+    return false;
+#endif
+  }
+
+  /// \brief Applies a segment written by replicate() to the segment of a
+  /// datastore that is not open, creating the segment if needed.
+  /// \param base_path A path to the datastore to update.
+  /// \param stream An input stream.
+  /// \param full Must be the same value given to replicate().
+  /// If true, the block files in the segment are replaced.
+  /// \return Return true if success; otherwise, false.
+  static bool apply_replication(const path_type &base_path,
+                                std::istream &stream, const bool full) {
+    return priv_apply_replication(priv_top_dir_path(base_path), stream, full);
+  }
+
+  /// \brief Builds the segment of an incremental snapshot, i.e., copies the
+  /// segment of the full snapshot the chain starts with and applies the
+  /// deltas of the snapshots in order.
+  /// Does nothing if the segment has already been built.
+  /// \param base_path A path to an incremental snapshot.
+  /// \param ancestor_paths The paths to the parent snapshots, starting with
+  /// the full snapshot and ending with the direct parent.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  static bool resolve_snapshot_delta(
+      const path_type &base_path, const std::vector<path_type> &ancestor_paths,
+      const int max_num_threads) {
+    std::vector<path_type> ancestor_top_paths;
+    for (const auto &path : ancestor_paths) {
+      ancestor_top_paths.push_back(priv_top_dir_path(path));
+    }
+    return priv_resolve_snapshot_delta(priv_top_dir_path(base_path),
+                                       ancestor_top_paths, max_num_threads);
+  }
+
+  /// \brief Compresses the block files of a segment that is not open with
+  /// Zstandard (requires METALL_USE_ZSTD), e.g., to archive a snapshot.
+  /// The block files are decompressed when the segment is opened next time.
+  /// \param base_path A path to a segment.
+  /// \param level The compression level of Zstandard.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  static bool compress(const path_type &base_path, const int level,
+                       const int max_num_threads) {
+    return priv_compress_block_files(priv_top_dir_path(base_path), level,
+                                     max_num_threads);
+  }
+
+  /// \brief Decompresses the block files compressed by compress().
+  /// Does nothing if there is no compressed block file.
+  /// \param base_path A path to a segment.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  static bool decompress(const path_type &base_path,
+                         const int max_num_threads) {
+    return priv_decompress_block_files(priv_top_dir_path(base_path),
+                                       max_num_threads);
+  }
+
+  /// \brief Compares the segments of two datastores that are not open, e.g.,
+  /// snapshots, and finds the parts of the given regions whose data differ.
+  /// The data the block files share, e.g., by reflink, are not read.
+  /// \param base_path0 A path to a segment.
+  /// \param base_path1 A path to another segment.
+  /// \param regions The (offset, length) regions of the segments to compare,
+  /// sorted by offset and not overlapping.
+  /// \param granularity The regions are compared in units of this size,
+  /// aligned to a multiple of the size.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param changed A pointer to store the (offset, length) of the changed
+  /// parts in ascending order. The parts only one segment has are changed.
+  /// \return Return true if success; otherwise, false.
+  static bool diff(
+      const path_type &base_path0, const path_type &base_path1,
+      const std::vector<std::pair<std::size_t, std::size_t>> &regions,
+      const std::size_t granularity, const int max_num_threads,
+      std::vector<std::pair<std::size_t, std::size_t>> *const changed) {
+    return priv_diff(priv_top_dir_path(base_path0),
+                     priv_top_dir_path(base_path1), regions, granularity,
+                     max_num_threads, changed);
+  }
+
+  /// \brief Copies only the given regions of a segment that is not open into
+  /// a new segment, e.g., the chunks in use. The other parts of the
+  /// destination block files are holes, and the blocks after the last region
+  /// but the first one are not created.
+  /// The regions are read and written by multiple threads, and the pages of
+  /// zeros are not written.
+  /// \param source_path A path to a source segment.
+  /// \param destination_path A path to a destination segment, which must not
+  /// have block files.
+  /// \param regions The (offset, length) regions to copy, sorted by offset
+  /// and not overlapping.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  static bool copy_regions(
+      const path_type &source_path, const path_type &destination_path,
+      const std::vector<std::pair<std::size_t, std::size_t>> &regions,
+      const int max_num_threads) {
+    return priv_copy_regions(priv_top_dir_path(source_path),
+                             priv_top_dir_path(destination_path), regions,
+                             max_num_threads);
+  }
+
+  /// \brief Checks the block files of a segment that is not open: the files
+  /// must be numbered consecutively from 0, the size of each file must be a
+  /// multiple of the size of the first one (the block size), and the files
+  /// must hold at least 'min_size' bytes.
+  /// The sizes of compressed block files are not checked.
+  /// \param base_path A path to a segment.
+  /// \param min_size The size of the segment the data use.
+  /// \param problems A pointer to append the descriptions of the problems.
+  /// \return Returns true if no problem is found; otherwise, false.
+  static bool check(const path_type &base_path, const std::size_t min_size,
+                    std::vector<std::string> *const problems) {
+    return priv_check(priv_top_dir_path(base_path), min_size, problems);
+  }
+
   /// \brief Returns the address of the segment.
   /// \return The address of the segment.
   void *get_segment() const { return m_segment; }
@@ -210,7 +865,8 @@ class segment_storage {
   std::size_t size() const { return m_current_segment_size; }
 
   /// \brief Returns the underlying page size.
-  /// \return The page size of the system.
+  /// \return The page size of the system, or the huge page size if
+  /// METALL_SEGMENT_HUGE_PAGE_SIZE is defined.
   std::size_t page_size() const { return m_system_page_size; }
 
   /// \brief Checks if the segment is read only.
@@ -218,6 +874,30 @@ class segment_storage {
   /// false.
   bool read_only() const { return m_read_only; }
 
+  /// \brief Checks if the segment is opened with the copy-on-write mode.
+  /// \return Returns true if the segment is copy-on-write; otherwise, returns
+  /// false.
+  bool copy_on_write() const { return m_copy_on_write; }
+
+  /// \brief Checks if the segment is created by create_volatile().
+  bool volatile_segment() const { return m_volatile; }
+
+  /// \brief Writes the blocks of a volatile segment kept in anonymous memory
+  /// to their files and maps the files instead, from the oldest block, until
+  /// the anonymous memory resident is at most 'memory_budget' bytes.
+  /// The kernel can then write back and evict the pages of the spilled blocks
+  /// under memory pressure as it does for a normal segment.
+  /// Must not be called while the segment is being written.
+  /// \param memory_budget The max number of bytes of the resident anonymous
+  /// memory to keep.
+  /// \param num_spilled_bytes If not nullptr, set to the number of the bytes
+  /// of the spilled blocks.
+  /// \return Returns false if the segment is not volatile or on error.
+  bool spill(const std::size_t memory_budget,
+             std::size_t *const num_spilled_bytes = nullptr) {
+    return priv_spill(memory_budget, num_spilled_bytes);
+  }
+
   /// \brief Checks if there is a segment already open.
   /// \return Returns true if there is a segment already open.
   bool is_open() const { return priv_is_open(); }
@@ -241,7 +921,8 @@ class segment_storage {
 
   static bool priv_openable(const path_type &top_path) {
     const auto file_name = priv_block_file_path(top_path, 0);
-    return mdtl::file_exist(file_name);
+    return mdtl::file_exist(file_name) ||
+           mdtl::file_exist(file_name.string() + k_compressed_file_extension);
   }
 
   static std::size_t priv_get_size(const path_type &top_path) {
@@ -260,16 +941,29 @@ class segment_storage {
 
   std::size_t priv_round_up_to_block_size(const std::size_t nbytes) const {
     const auto alignment =
-        std::max((size_t)m_system_page_size, (size_t)k_block_size);
+        std::max((size_t)m_system_page_size, (size_t)m_block_size);
     return mdtl::round_up(nbytes, alignment);
   }
 
   std::size_t priv_round_down_to_block_size(const std::size_t nbytes) const {
     const auto alignment =
-        std::max((size_t)m_system_page_size, (size_t)k_block_size);
+        std::max((size_t)m_system_page_size, (size_t)m_block_size);
     return mdtl::round_down(nbytes, alignment);
   }
 
+  bool priv_valid_block_size(const std::size_t block_size) const {
+    if (block_size == 0 || m_system_page_size <= 0 ||
+        block_size % m_system_page_size != 0) {
+      return false;
+    }
+#ifdef METALL_USE_GEOMETRIC_BLOCK_GROWTH
+    if (block_size > k_max_block_size || k_max_block_size % block_size != 0) {
+      return false;
+    }
+#endif
+    return true;
+  }
+
   void priv_clear_status() {
     m_system_page_size = 0;
     m_num_blocks = 0;
@@ -279,7 +973,8 @@ class segment_storage {
     m_vm_region = nullptr;
     m_segment = nullptr;
     m_segment_header = nullptr;
-    // m_read_only must not be modified here.
+    m_dax_mapped = false;
+    // m_read_only, m_copy_on_write, and m_volatile must not be modified here.
   }
 
   void priv_set_broken_status() {
@@ -322,89 +1017,1125 @@ class segment_storage {
     return false;
   }
 
-  bool priv_prepare_header_and_segment(
-      const std::size_t segment_capacity_request) {
-    const auto header_size = mdtl::round_up(sizeof(segment_header_type),
-                                            int64_t(m_system_page_size));
-    const auto vm_region_size =
-        header_size + priv_round_up_to_block_size(segment_capacity_request);
-    if (!priv_reserve_vm(vm_region_size)) {
-      priv_set_broken_status();
+  bool priv_copy_direct(const path_type &destination_path,
+                        const int max_num_threads) const {
+    if (!mdtl::directory_exist(destination_path) &&
+        !mdtl::create_directory(destination_path)) {
+      std::string s("Cannot create a directory: " + destination_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       return false;
     }
-    m_segment = reinterpret_cast<char *>(m_vm_region) + header_size;
-    m_segment_capacity =
-        priv_round_down_to_block_size(m_vm_region_size - header_size);
-    assert(m_segment_capacity >= segment_capacity_request);
-    assert(m_segment_capacity + header_size <= m_vm_region_size);
-    priv_construct_segment_header(m_vm_region);
-
-    return true;
-  }
 
-  bool priv_reserve_vm(const std::size_t nbytes) {
-    m_vm_region_size =
-        mdtl::round_up((int64_t)nbytes, (int64_t)m_system_page_size);
-    m_vm_region =
-        mdtl::reserve_aligned_vm_region(m_system_page_size, m_vm_region_size);
-
-    if (!m_vm_region) {
-      std::stringstream ss;
-      ss << "Cannot reserve a VM region " << m_vm_region_size << " bytes";
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
-      m_vm_region_size = 0;
+    std::vector<path_type> file_names;
+    if (!mdtl::get_regular_file_names(m_top_path, &file_names)) {
+      std::string s("Cannot list the files in " + m_top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       return false;
-    } else {
-      std::stringstream ss;
-      ss << "Reserved a VM region: " << m_vm_region_size << " bytes at "
-         << (uint64_t)m_vm_region;
-      logger::out(logger::level::verbose, __FILE__, __LINE__, ss.str().c_str());
+    }
+    // The files other than the mapped blocks are small
+    std::map<path_type, std::size_t> block_numbers;
+    for (std::size_t n = 0; n < m_num_blocks; ++n) {
+      block_numbers.emplace(priv_block_file_path(m_top_path, n).filename(), n);
     }
 
-    return true;
+    return mdtl::io_executor::instance().parallel_for(
+        file_names.size(), max_num_threads,
+        [&](const std::size_t i) {
+          const auto src = m_top_path / file_names[i];
+          const auto dst = destination_path / file_names[i];
+          const auto itr = block_numbers.find(file_names[i]);
+          if (itr != block_numbers.end()) {
+            bool supported = false;
+            const bool ret = mdtl::copy_file_direct(
+                src, dst,
+                static_cast<char *>(m_segment) + priv_block_offset(itr->second),
+                &supported);
+            if (supported) return ret;
+          }
+          return mdtl::copy_file(src, dst);
+        },
+        mdtl::io_executor::get_device_id(destination_path.c_str()));
   }
 
-  bool priv_release_vm_region() {
-    // Overwrite the region with PROT_NONE to destroy the map. Because munmap(2)
-    // synchronizes the map region with the file system, overwriting with
-    // PROT_NONE beforehand makes munmap(2) fast. Ignore the success/failure of
-    // this operation as this operation is just a performance optimization.
-    mdtl::map_with_prot_none(m_segment, m_current_segment_size);
-
-    if (!mdtl::munmap(m_vm_region, m_vm_region_size, false)) {
-      std::stringstream ss;
-      ss << "Cannot release a VM region " << (uint64_t)m_vm_region << ", "
-         << m_vm_region_size << " bytes.";
-      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+  bool priv_track_snapshot_delta() {
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    if (!is_open() || m_copy_on_write || !mdtl::soft_dirty_bit_supported()) {
       return false;
     }
-    m_vm_region = nullptr;
-    m_vm_region_size = 0;
-
+    if (!m_snapshot_page_tracker) {
+      m_snapshot_page_tracker =
+          std::make_unique<mdtl::soft_dirty_page_tracker>();
+    }
+    m_snapshot_page_tracker->untrack();
+    m_snapshot_page_tracker->track(m_segment, m_current_segment_size,
+                                   m_system_page_size);
+    // Reset the soft-dirty bits and forget the pages written so far;
+    // the other trackers keep their dirty pages
+    if (!m_snapshot_page_tracker->collect()) {
+      m_snapshot_page_tracker.reset();
+      return false;
+    }
+    m_snapshot_page_tracker->take_dirty_ranges(
+        [](const std::size_t, const std::size_t) {});
     return true;
+#else
+    return false;
+#endif
   }
 
-  bool priv_construct_segment_header(void *const addr) {
-    if (!addr) {
+  bool priv_replicate(std::ostream &stream, const bool full) {
+    if (!is_open()) return false;
+    priv_wait_async_sync();
+
+    std::vector<sync_range_type> ranges;
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    if (full) {
+      // Start tracking before reading the segment not to miss any write
+      priv_track_replication();
+      ranges.emplace_back(0, m_current_segment_size);
+    } else {
+      if (!m_replication_page_tracker) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "The pages written since the last replication are not "
+                    "tracked");
+        return false;
+      }
+      if (!m_replication_page_tracker->collect()) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to collect the written pages");
+        m_replication_page_tracker.reset();
+        return false;
+      }
+      m_replication_page_tracker->take_dirty_ranges(
+          [&ranges](const std::size_t offset, const std::size_t length) {
+            ranges.emplace_back(offset, length);
+          });
+    }
+#else
+    if (!full) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The pages written since the last replication are not "
+                  "tracked");
       return false;
     }
+    ranges.emplace_back(0, m_current_segment_size);
+#endif
 
-    const auto size = mdtl::round_up(sizeof(segment_header_type),
-                                     int64_t(m_system_page_size));
-    if (mdtl::map_anonymous_write_mode(addr, size, MAP_FIXED) != addr) {
+    priv_write_delta_index(stream, ranges);
+    priv_write_delta_data(stream, ranges);
+    if (!stream) {
       logger::out(logger::level::error, __FILE__, __LINE__,
-                  "Cannot allocate segment header");
+                  "Failed to write the segment to the replication stream");
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+      // The written pages are lost
+      m_replication_page_tracker.reset();
+#endif
       return false;
     }
-    m_segment_header = reinterpret_cast<segment_header_type *>(addr);
-
-    new (m_segment_header) segment_header_type();
-
     return true;
   }
 
-  bool priv_deallocate_segment_header() {
-    std::destroy_at(&m_segment_header);
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+  /// \brief Starts tracking the pages written from now on for replicate().
+  /// Leaves no tracker if the tracking is not available.
+  void priv_track_replication() {
+    m_replication_page_tracker.reset();
+    if (m_copy_on_write || !mdtl::soft_dirty_bit_supported()) return;
+    auto tracker = std::make_unique<mdtl::soft_dirty_page_tracker>();
+    tracker->track(m_segment, m_current_segment_size, m_system_page_size);
+    // Reset the soft-dirty bits; the other trackers keep their dirty pages
+    if (!tracker->collect()) return;
+    tracker->take_dirty_ranges([](const std::size_t, const std::size_t) {});
+    m_replication_page_tracker = std::move(tracker);
+  }
+#endif
+
+  static bool priv_apply_replication(const path_type &top_path,
+                                     std::istream &stream, const bool full) {
+    if (!mdtl::directory_exist(top_path) &&
+        !mdtl::create_directory(top_path)) {
+      std::string s("Cannot create a directory: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (full) {
+      // The segment of the replica might be larger than the new one
+      std::vector<path_type> names;
+      if (!priv_list_block_files(top_path, false, &names)) return false;
+      for (const auto &name : names) {
+        if (!mdtl::remove_file(top_path / name)) return false;
+      }
+    }
+    if (!priv_apply_delta(stream, stream, top_path)) {
+      std::string s("Failed to apply a replication stream to " +
+                    top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return mdtl::fsync(top_path);
+  }
+
+  bool priv_snapshot_delta(const path_type &top_path) {
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    if (!is_open() || !m_snapshot_page_tracker) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The pages written since the last snapshot are not tracked");
+      return false;
+    }
+    priv_wait_async_sync();
+
+    if (!m_snapshot_page_tracker->collect()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to collect the written pages");
+      m_snapshot_page_tracker.reset();
+      return false;
+    }
+    std::vector<sync_range_type> ranges;
+    m_snapshot_page_tracker->take_dirty_ranges(
+        [&ranges](const std::size_t offset, const std::size_t length) {
+          ranges.emplace_back(offset, length);
+        });
+
+    if (!priv_write_snapshot_delta(top_path, ranges)) {
+      // The written pages are lost; the next snapshot has to be a full one
+      m_snapshot_page_tracker.reset();
+      return false;
+    }
+    return true;
+#else
+    (void)top_path;
+    return false;
+#endif
+  }
+
+  /// \brief Writes the number of blocks, the size of each block,
+  /// the number of ranges, and (offset, length) of each range, each of
+  /// which is a 64-bit value.
+  void priv_write_delta_index(
+      std::ostream &os, const std::vector<sync_range_type> &ranges) const {
+    const auto write = [&os](const uint64_t value) {
+      os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    write(m_num_blocks);
+    for (std::size_t b = 0; b < m_num_blocks; ++b) {
+      write(priv_block_size(b));
+    }
+    write(ranges.size());
+    for (const auto &range : ranges) {
+      write(range.first);
+      write(range.second);
+    }
+  }
+
+  /// \brief Writes the given ranges of the segment back to back.
+  void priv_write_delta_data(
+      std::ostream &os, const std::vector<sync_range_type> &ranges) const {
+    for (const auto &range : ranges) {
+      os.write(static_cast<const char *>(m_segment) + range.first,
+               range.second);
+    }
+  }
+
+  /// \brief Writes the given ranges of the segment and the block sizes
+  /// into an index file and a data file.
+  bool priv_write_snapshot_delta(
+      const path_type &top_path,
+      const std::vector<sync_range_type> &ranges) const {
+    if (!mdtl::directory_exist(top_path) &&
+        !mdtl::create_directory(top_path)) {
+      std::string s("Cannot create a directory: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+
+    const auto data_path = top_path / k_delta_data_file_name;
+    {
+      std::ofstream ofs(data_path, std::ios::binary | std::ios::trunc);
+      priv_write_delta_data(ofs, ranges);
+      if (!ofs) {
+        std::string s("Failed to write " + data_path.string());
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+    }
+
+    const auto index_path = top_path / k_delta_index_file_name;
+    {
+      std::ofstream ofs(index_path, std::ios::binary | std::ios::trunc);
+      priv_write_delta_index(ofs, ranges);
+      if (!ofs) {
+        std::string s("Failed to write " + index_path.string());
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+    }
+
+    return mdtl::fsync(data_path) && mdtl::fsync(index_path) &&
+           mdtl::fsync(top_path);
+  }
+
+  static bool priv_resolve_snapshot_delta(
+      const path_type &top_path, const std::vector<path_type> &ancestor_paths,
+      const int max_num_threads) {
+    const auto mark_path = top_path / k_delta_resolving_mark_file_name;
+    if (priv_openable(top_path) && !mdtl::file_exist(mark_path)) {
+      return true;  // Already resolved
+    }
+    if (ancestor_paths.empty() ||
+        !mdtl::file_exist(top_path / k_delta_index_file_name)) {
+      std::string s("Not an incremental snapshot: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    {
+      std::string s("Resolve an incremental snapshot: " + top_path.string());
+      logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
+    }
+
+    // The mark is removed at the end so that a failed resolution is redone
+    if (!mdtl::create_file(mark_path)) return false;
+    if (!priv_copy_block_files(ancestor_paths.front(), top_path,
+                               max_num_threads)) {
+      return false;
+    }
+    for (std::size_t i = 1; i < ancestor_paths.size(); ++i) {
+      if (!priv_apply_snapshot_delta(ancestor_paths[i], top_path)) {
+        return false;
+      }
+    }
+    if (!priv_apply_snapshot_delta(top_path, top_path)) return false;
+
+    return mdtl::remove_file(mark_path) && mdtl::fsync(top_path);
+  }
+
+  /// \brief Replaces the block files in 'destination_path' with the ones in
+  /// 'source_path'. Other files are not copied.
+  static bool priv_copy_block_files(const path_type &source_path,
+                                    const path_type &destination_path,
+                                    const int max_num_threads) {
+    std::vector<path_type> destination_files;
+    if (!mdtl::get_regular_file_names(destination_path, &destination_files)) {
+      return false;
+    }
+    for (const auto &name : destination_files) {
+      if (name.string().rfind("block-", 0) != 0) continue;
+      if (!mdtl::remove_file(destination_path / name)) return false;
+    }
+
+    std::vector<path_type> source_files;
+    if (!mdtl::get_regular_file_names(source_path, &source_files)) {
+      std::string s("Cannot list the files in " + source_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    source_files.erase(
+        std::remove_if(source_files.begin(), source_files.end(),
+                       [](const path_type &name) {
+                         return name.string().rfind("block-", 0) != 0;
+                       }),
+        source_files.end());
+
+    return mdtl::io_executor::instance().parallel_for(
+        source_files.size(), max_num_threads,
+        [&](const std::size_t i) {
+          // Falls back to a normal copy if reflink is not available
+          return mdtl::clone_file(source_path / source_files[i],
+                                  destination_path / source_files[i]);
+        },
+        mdtl::io_executor::get_device_id(destination_path.c_str()));
+  }
+
+  /// \brief Lists the block files in 'top_path'.
+  /// \param compressed If true, lists the compressed block files instead.
+  static bool priv_list_block_files(const path_type &top_path,
+                                    const bool compressed,
+                                    std::vector<path_type> *const names) {
+    std::vector<path_type> file_names;
+    if (!mdtl::get_regular_file_names(top_path, &file_names)) {
+      std::string s("Failed to list block files under: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    const std::string extension = compressed ? k_compressed_file_extension : "";
+    for (const auto &name : file_names) {
+      const auto str = name.string();
+      if (str.rfind("block-", 0) != 0) continue;
+      const auto end = std::min(str.find_first_not_of("0123456789", 6),
+                                str.size());
+      if (end > 6 && str.substr(end) == extension) names->push_back(name);
+    }
+    return true;
+  }
+
+  static bool priv_check(const path_type &top_path, const std::size_t min_size,
+                         std::vector<std::string> *const problems) {
+    std::vector<path_type> names;
+    std::vector<path_type> compressed_names;
+    if (!priv_list_block_files(top_path, false, &names) ||
+        !priv_list_block_files(top_path, true, &compressed_names)) {
+      problems->push_back("Cannot list the block files in " +
+                          top_path.string());
+      return false;
+    }
+
+    // Block number -> compressed or not
+    std::map<std::size_t, bool> blocks;
+    for (const auto &name : names) {
+      blocks.emplace(std::stoull(name.string().substr(6)), false);
+    }
+    for (const auto &name : compressed_names) {
+      if (!blocks.emplace(std::stoull(name.string().substr(6)), true).second) {
+        problems->push_back("Block " + name.string().substr(6) +
+                            " has both a plain and a compressed file");
+      }
+    }
+    if (blocks.empty()) {
+      problems->push_back("No block file in " + top_path.string());
+      return false;
+    }
+
+    bool ok = true;
+    std::size_t num_blocks = 0;
+    for (const auto &entry : blocks) {
+      if (entry.first != num_blocks) {
+        problems->push_back("Block file " + std::to_string(num_blocks) +
+                            " is missing");
+        ok = false;
+        break;  // The blocks after a missing one are not used
+      }
+      ++num_blocks;
+    }
+    // The sizes of compressed files are not the block sizes
+    if (std::any_of(blocks.begin(), blocks.end(),
+                    [](const auto &entry) { return entry.second; })) {
+      return ok;
+    }
+
+    std::vector<ssize_t> sizes(num_blocks, -1);
+    mdtl::io_executor::instance().parallel_for(
+        num_blocks, 0,
+        [&top_path, &sizes](const std::size_t block_no) {
+          sizes[block_no] =
+              mdtl::get_file_size(priv_block_file_path(top_path, block_no));
+          return true;
+        },
+        mdtl::io_executor::get_device_id(top_path.c_str()));
+
+    const ssize_t page_size = mdtl::get_page_size();
+    std::size_t total_size = 0;
+    for (std::size_t block_no = 0; block_no < num_blocks; ++block_no) {
+      const ssize_t size = sizes[block_no];
+      if (size <= 0 || size % page_size != 0 ||
+          (sizes[0] > 0 && size % sizes[0] != 0)) {
+        problems->push_back("Block file " + std::to_string(block_no) +
+                            " has an invalid size " + std::to_string(size) +
+                            " (truncated?)");
+        ok = false;
+      }
+      if (size > 0) total_size += size;
+    }
+    if (total_size < min_size) {
+      problems->push_back("The block files have " +
+                          std::to_string(total_size) +
+                          " bytes, but the used chunks need " +
+                          std::to_string(min_size) + " bytes");
+      ok = false;
+    }
+    return ok;
+  }
+
+  static bool priv_rename(const path_type &source, const path_type &target) {
+    std::error_code ec;
+    std::filesystem::rename(source, target, ec);
+    if (ec) {
+      std::string s("Failed to rename " + source.string() + ": " +
+                    ec.message());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  static bool priv_compress_block_files(const path_type &top_path,
+                                        const int level,
+                                        const int max_num_threads) {
+    if (!mdtl::zstd::enabled()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Compression is not enabled (define METALL_USE_ZSTD)");
+      return false;
+    }
+    std::vector<path_type> names;
+    if (!priv_list_block_files(top_path, false, &names)) return false;
+
+    // A block file is removed only after its compressed file is complete,
+    // so that either of them is always available
+    const bool ret = mdtl::io_executor::instance().parallel_for(
+        names.size(), max_num_threads,
+        [&](const std::size_t i) {
+          const auto source = top_path / names[i];
+          const path_type target =
+              source.string() + k_compressed_file_extension;
+          const path_type tmp = target.string() + ".tmp";
+          return mdtl::zstd::compress_file(source, tmp, level) &&
+                 priv_rename(tmp, target) && mdtl::remove_file(source);
+        },
+        mdtl::io_executor::get_device_id(top_path.c_str()));
+    return ret && mdtl::fsync(top_path);
+  }
+
+  static bool priv_decompress_block_files(const path_type &top_path,
+                                          const int max_num_threads) {
+    std::vector<path_type> names;
+    if (!priv_list_block_files(top_path, true, &names)) return false;
+    if (names.empty()) return true;
+    {
+      std::string s("Decompress block files under: " + top_path.string());
+      logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
+    }
+
+    const bool ret = mdtl::io_executor::instance().parallel_for(
+        names.size(), max_num_threads,
+        [&](const std::size_t i) {
+          const auto source = top_path / names[i];
+          auto target = source;
+          target.replace_extension();
+          // The compression stopped before removing the block file
+          if (mdtl::file_exist(target)) return mdtl::remove_file(source);
+          const path_type tmp = target.string() + ".tmp";
+          return mdtl::zstd::decompress_file(source, tmp) &&
+                 priv_rename(tmp, target) && mdtl::remove_file(source);
+        },
+        mdtl::io_executor::get_device_id(top_path.c_str()));
+    return ret && mdtl::fsync(top_path);
+  }
+
+  /// \brief The block files of a segment opened by priv_diff().
+  struct diff_segment {
+    diff_segment() = default;
+    diff_segment(const diff_segment &) = delete;
+    diff_segment &operator=(const diff_segment &) = delete;
+    ~diff_segment() noexcept {
+      for (const auto fd : fd_list) mdtl::os_close(fd);
+    }
+
+    std::vector<int> fd_list;
+    std::vector<std::size_t> offset_list;
+    // The locations of the data on the device; empty if not available
+    std::vector<std::vector<mdtl::physical_extent>> extent_list;
+    std::size_t size{0};
+    dev_t device{0};
+  };
+
+  static bool priv_open_diff_segment(const path_type &top_path,
+                                     diff_segment *const segment) {
+    std::vector<path_type> compressed_names;
+    if (!priv_openable(top_path) ||
+        !priv_list_block_files(top_path, true, &compressed_names)) {
+      std::string s("No segment in " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (!compressed_names.empty()) {
+      std::string s("Decompress the segment to compare: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+
+    for (std::size_t b = 0;; ++b) {
+      const auto file_path = priv_block_file_path(top_path, b);
+      if (!mdtl::file_exist(file_path)) break;
+      const int fd = ::open(file_path.c_str(), O_RDONLY);
+      struct stat st;
+      if (fd == -1 || ::fstat(fd, &st) == -1) {
+        logger::perror(logger::level::error, __FILE__, __LINE__,
+                       file_path.c_str());
+        if (fd != -1) mdtl::os_close(fd);
+        return false;
+      }
+      segment->fd_list.push_back(fd);
+      segment->offset_list.push_back(segment->size);
+      segment->size += st.st_size;
+      segment->device = st.st_dev;
+
+      std::vector<mdtl::physical_extent> extents;
+#ifdef __linux__
+      // Without the locations, the data are read and compared
+      if (!mdtl::get_physical_extents_linux(fd, &extents)) extents.clear();
+#endif
+      segment->extent_list.push_back(std::move(extents));
+    }
+    return true;
+  }
+
+  /// \brief Returns the location on the device of [pos, pos + n) of a block
+  /// file; returns -1 if it is unknown or not contiguous.
+  static off_t priv_physical_location(
+      const std::vector<mdtl::physical_extent> &extents, const off_t pos,
+      const off_t n) {
+    auto itr = std::upper_bound(
+        extents.begin(), extents.end(), pos,
+        [](const off_t p, const mdtl::physical_extent &extent) {
+          return p < extent.offset;
+        });
+    if (itr == extents.begin()) return -1;
+    --itr;
+    if (pos + n > itr->offset + itr->length) return -1;
+    return itr->physical + (pos - itr->offset);
+  }
+
+  /// \brief Checks if two segments have the same data in [offset, offset +
+  /// length), which must be within both segments.
+  /// \return Returns false on an I/O error.
+  static bool priv_same_data(const diff_segment &segment0,
+                             const diff_segment &segment1, std::size_t offset,
+                             std::size_t length, std::vector<char> *const buf0,
+                             std::vector<char> *const buf1,
+                             bool *const same) {
+    const auto find_block = [](const diff_segment &segment,
+                               const std::size_t pos) {
+      const std::size_t block_no =
+          std::upper_bound(segment.offset_list.begin(),
+                           segment.offset_list.end(), pos) -
+          segment.offset_list.begin() - 1;
+      const std::size_t block_end = (block_no + 1 < segment.offset_list.size())
+                                        ? segment.offset_list[block_no + 1]
+                                        : segment.size;
+      return std::make_pair(block_no, block_end);
+    };
+
+    while (length > 0) {
+      const auto [block_no0, block_end0] = find_block(segment0, offset);
+      const auto [block_no1, block_end1] = find_block(segment1, offset);
+      const std::size_t n = std::min({length, block_end0 - offset,
+                                      block_end1 - offset, buf0->size()});
+      const off_t pos0 = offset - segment0.offset_list[block_no0];
+      const off_t pos1 = offset - segment1.offset_list[block_no1];
+
+      // The data shared by the block files are the same
+      const bool shared =
+          segment0.device == segment1.device &&
+          priv_physical_location(segment0.extent_list[block_no0], pos0, n) !=
+              -1 &&
+          priv_physical_location(segment0.extent_list[block_no0], pos0, n) ==
+              priv_physical_location(segment1.extent_list[block_no1], pos1, n);
+      if (!shared) {
+        if (!priv_pread_all(segment0.fd_list[block_no0], buf0->data(), n,
+                            pos0) ||
+            !priv_pread_all(segment1.fd_list[block_no1], buf1->data(), n,
+                            pos1)) {
+          return false;
+        }
+        if (std::memcmp(buf0->data(), buf1->data(), n) != 0) {
+          *same = false;
+          return true;
+        }
+      }
+      offset += n;
+      length -= n;
+    }
+    *same = true;
+    return true;
+  }
+
+  /// \brief Appends a range to a sorted list, merging it with the last one if
+  /// they are adjacent.
+  static void priv_append_range(std::vector<sync_range_type> *const ranges,
+                                const std::size_t offset,
+                                const std::size_t length) {
+    if (!ranges->empty() &&
+        ranges->back().first + ranges->back().second == offset) {
+      ranges->back().second += length;
+    } else {
+      ranges->emplace_back(offset, length);
+    }
+  }
+
+  static bool priv_diff(const path_type &top_path0, const path_type &top_path1,
+                        const std::vector<sync_range_type> &regions,
+                        const std::size_t granularity,
+                        const int max_num_threads,
+                        std::vector<sync_range_type> *const changed) {
+    if (granularity == 0) return false;
+    diff_segment segment0;
+    diff_segment segment1;
+    if (!priv_open_diff_segment(top_path0, &segment0) ||
+        !priv_open_diff_segment(top_path1, &segment1)) {
+      return false;
+    }
+    const auto common_size = std::min(segment0.size, segment1.size);
+    const auto max_size = std::max(segment0.size, segment1.size);
+
+    std::vector<sync_range_type> tasks;
+    const auto task_size = mdtl::round_up(k_diff_task_size, granularity);
+    for (const auto &[offset, length] : regions) {
+      const auto end = std::min(offset + length, max_size);
+      for (auto pos = offset; pos < end;) {
+        const auto n = std::min(end - pos, task_size - pos % task_size);
+        tasks.emplace_back(pos, n);
+        pos += n;
+      }
+    }
+
+    std::vector<std::vector<sync_range_type>> results(tasks.size());
+    const bool ret = mdtl::io_executor::instance().parallel_for(
+        tasks.size(), max_num_threads,
+        [&](const std::size_t i) {
+          const auto buf_size = std::min(granularity, k_delta_buffer_size);
+          std::vector<char> buf0(buf_size);
+          std::vector<char> buf1(buf_size);
+          const auto end = tasks[i].first + tasks[i].second;
+          for (auto pos = tasks[i].first; pos < end;) {
+            const auto n =
+                std::min(end - pos, granularity - pos % granularity);
+            // The parts only one segment has are changed
+            bool same = false;
+            if (pos + n <= common_size &&
+                !priv_same_data(segment0, segment1, pos, n, &buf0, &buf1,
+                                &same)) {
+              return false;
+            }
+            if (!same) priv_append_range(&results[i], pos, n);
+            pos += n;
+          }
+          return true;
+        },
+        mdtl::io_executor::get_device_id(top_path1.c_str()));
+    if (!ret) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to compare the segments");
+      return false;
+    }
+
+    changed->clear();
+    for (const auto &result : results) {
+      for (const auto &[offset, length] : result) {
+        priv_append_range(changed, offset, length);
+      }
+    }
+    return true;
+  }
+
+  static bool priv_copy_regions(const path_type &source_top_path,
+                                const path_type &destination_top_path,
+                                const std::vector<sync_range_type> &regions,
+                                const int max_num_threads) {
+    diff_segment source;
+    if (!priv_open_diff_segment(source_top_path, &source)) return false;
+    if (!mdtl::directory_exist(destination_top_path) &&
+        !mdtl::create_directory(destination_top_path)) {
+      std::string s("Cannot create a directory: " +
+                    destination_top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+
+    std::size_t used_size = 0;
+    for (const auto &[offset, length] : regions) {
+      used_size = std::max(used_size, std::min(offset + length, source.size));
+    }
+    // The first block is kept so that the segment is openable
+    std::size_t num_blocks = 0;
+    while (num_blocks < source.offset_list.size() &&
+           (num_blocks == 0 || source.offset_list[num_blocks] < used_size)) {
+      ++num_blocks;
+    }
+
+    diff_segment destination;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+      const auto block_end = (b + 1 < source.offset_list.size())
+                                 ? source.offset_list[b + 1]
+                                 : source.size;
+      const auto block_size = block_end - source.offset_list[b];
+      const auto file_path = priv_block_file_path(destination_top_path, b);
+      const int fd = (mdtl::file_exist(file_path) ||
+                      !priv_create_block_file(file_path, block_size))
+                         ? -1
+                         : ::open(file_path.c_str(), O_WRONLY);
+      if (fd == -1) {
+        std::string s("Failed to create a block file: " + file_path.string());
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+      destination.fd_list.push_back(fd);
+    }
+
+    // Splits the regions at the block boundaries
+    std::vector<std::pair<std::size_t, sync_range_type>> tasks;
+    for (const auto &[offset, length] : regions) {
+      const auto end = std::min(offset + length, used_size);
+      for (auto pos = offset; pos < end;) {
+        const std::size_t block_no =
+            std::upper_bound(source.offset_list.begin(),
+                             source.offset_list.end(), pos) -
+            source.offset_list.begin() - 1;
+        const std::size_t block_end =
+            (block_no + 1 < source.offset_list.size())
+                ? source.offset_list[block_no + 1]
+                : source.size;
+        const auto n = std::min({end - pos, block_end - pos,
+                                 k_diff_task_size - pos % k_diff_task_size});
+        tasks.emplace_back(block_no,
+                           sync_range_type(pos - source.offset_list[block_no],
+                                           n));
+        pos += n;
+      }
+    }
+
+    const bool ret = mdtl::io_executor::instance().parallel_for(
+        tasks.size(), max_num_threads,
+        [&](const std::size_t i) {
+          const auto [block_no, range] = tasks[i];
+          const auto page_size = k_zero_check_unit;
+          std::vector<char> buf(std::min(range.second, k_delta_buffer_size));
+          for (std::size_t done = 0; done < range.second;) {
+            const auto n = std::min(range.second - done, buf.size());
+            const off_t pos = range.first + done;
+            if (!priv_pread_all(source.fd_list[block_no], buf.data(), n,
+                                pos)) {
+              return false;
+            }
+            // The pages of zeros are left as holes
+            for (std::size_t p = 0; p < n;) {
+              const auto is_zero = [&](const std::size_t q) {
+                const auto len = std::min(page_size, n - q);
+                return std::all_of(buf.data() + q, buf.data() + q + len,
+                                   [](const char c) { return c == 0; });
+              };
+              if (is_zero(p)) {
+                p += page_size;
+                continue;
+              }
+              auto q = p + page_size;
+              while (q < n && !is_zero(q)) q += page_size;
+              q = std::min(q, n);
+              if (!priv_pwrite_all(destination.fd_list[block_no],
+                                   buf.data() + p, q - p, pos + p)) {
+                return false;
+              }
+              p = q;
+            }
+            done += n;
+          }
+          return true;
+        },
+        mdtl::io_executor::get_device_id(destination_top_path.c_str()));
+    if (!ret) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to copy the regions of a segment");
+      return false;
+    }
+
+    bool synced = true;
+    for (const auto fd : destination.fd_list) synced &= mdtl::os_fsync(fd);
+    return synced && mdtl::fsync(destination_top_path);
+  }
+
+  /// \brief Writes the delta in 'delta_path' into the block files in
+  /// 'top_path', creating or extending the block files as needed.
+  static bool priv_apply_snapshot_delta(const path_type &delta_path,
+                                        const path_type &top_path) {
+    std::ifstream index(delta_path / k_delta_index_file_name,
+                        std::ios::binary);
+    std::ifstream data(delta_path / k_delta_data_file_name, std::ios::binary);
+    if (!priv_apply_delta(index, data, top_path)) {
+      std::string s("Failed to apply the delta in " + delta_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Writes a delta written by priv_write_delta_index() and
+  /// priv_write_delta_data() into the block files in 'top_path'.
+  /// The index is read entirely before the data; thus, 'index' and 'data'
+  /// can be the same stream.
+  static bool priv_apply_delta(std::istream &index, std::istream &data,
+                               const path_type &top_path) {
+    const auto read = [&index]() {
+      uint64_t value = 0;
+      index.read(reinterpret_cast<char *>(&value), sizeof(value));
+      return value;
+    };
+
+    bool succeeded = !!index && !!data;
+    std::vector<int> fd_list;
+    std::vector<std::size_t> offset_list;
+    std::size_t segment_size = 0;
+    const auto num_blocks = read();
+    for (std::size_t b = 0; succeeded && index && b < num_blocks; ++b) {
+      const std::size_t block_size = read();
+      const auto file_path = priv_block_file_path(top_path, b);
+      if (!mdtl::create_file(file_path) ||
+          (mdtl::get_file_size(file_path) < (ssize_t)block_size &&
+           !mdtl::extend_file_size(file_path, block_size))) {
+        succeeded = false;
+        break;
+      }
+      const int fd = ::open(file_path.c_str(), O_RDWR);
+      if (fd == -1) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+        succeeded = false;
+        break;
+      }
+      fd_list.push_back(fd);
+      offset_list.push_back(segment_size);
+      segment_size += block_size;
+    }
+
+    std::vector<sync_range_type> ranges;
+    const auto num_ranges = succeeded ? read() : 0;
+    for (std::size_t r = 0; succeeded && index && r < num_ranges; ++r) {
+      const std::size_t offset = read();
+      const std::size_t length = read();
+      ranges.emplace_back(offset, length);
+    }
+    if (!index) succeeded = false;
+
+    std::vector<char> buf(k_delta_buffer_size);
+    for (const auto &[offset, length] : ranges) {
+      for (std::size_t pos = offset; succeeded && pos < offset + length;) {
+        const auto block_no =
+            std::upper_bound(offset_list.begin(), offset_list.end(), pos) -
+            offset_list.begin() - 1;
+        if (block_no < 0 || pos >= segment_size) {
+          succeeded = false;
+          break;
+        }
+        const auto block_end = (std::size_t(block_no) + 1 < offset_list.size())
+                                   ? offset_list[block_no + 1]
+                                   : segment_size;
+        const auto n =
+            std::min({offset + length - pos, block_end - pos, buf.size()});
+        succeeded &= !!data.read(buf.data(), n);
+        succeeded &= priv_pwrite_all(fd_list[block_no], buf.data(), n,
+                                     pos - offset_list[block_no]);
+        pos += n;
+      }
+      if (!succeeded) break;
+    }
+
+    for (const auto fd : fd_list) {
+      succeeded &= mdtl::os_fsync(fd);
+      succeeded &= mdtl::os_close(fd);
+    }
+    return succeeded;
+  }
+
+  static bool priv_pread_all(const int fd, char *buf, std::size_t n,
+                             off_t offset) {
+    while (n > 0) {
+      const auto num_read = ::pread(fd, buf, n, offset);
+      if (num_read == -1) {
+        if (errno == EINTR) continue;
+        logger::perror(logger::level::error, __FILE__, __LINE__, "pread");
+        return false;
+      }
+      if (num_read == 0) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Unexpected end of file");
+        return false;
+      }
+      buf += num_read;
+      n -= num_read;
+      offset += num_read;
+    }
+    return true;
+  }
+
+  static bool priv_pwrite_all(const int fd, const char *buf, std::size_t n,
+                              off_t offset) {
+    while (n > 0) {
+      const auto written = ::pwrite(fd, buf, n, offset);
+      if (written == -1) {
+        if (errno == EINTR) continue;
+        logger::perror(logger::level::error, __FILE__, __LINE__, "pwrite");
+        return false;
+      }
+      buf += written;
+      n -= written;
+      offset += written;
+    }
+    return true;
+  }
+
+  /// \brief Returns the size of the block to add next.
+  /// By default, all blocks have the same size, METALL_SEGMENT_BLOCK_SIZE.
+  /// If METALL_USE_GEOMETRIC_BLOCK_GROWTH is defined, a new block has the
+  /// same size as the current segment, i.e., the segment doubles, up to
+  /// METALL_SEGMENT_MAX_BLOCK_SIZE. The number of blocks grows
+  /// logarithmically with the segment size.
+  std::size_t priv_next_block_size() const {
+    return priv_block_size_at(m_current_segment_size);
+  }
+
+  /// \brief Returns the size of the block added to a segment of
+  /// 'segment_size' bytes.
+  std::size_t priv_block_size_at(
+      [[maybe_unused]] const std::size_t segment_size) const {
+#ifdef METALL_USE_GEOMETRIC_BLOCK_GROWTH
+    const auto block_size =
+        std::clamp(priv_round_up_to_block_size(segment_size), m_block_size,
+                   (std::size_t)k_max_block_size);
+    // Fit in the VM region; the capacity is a multiple of the minimum size
+    return std::max(
+        std::min(block_size,
+                 m_segment_capacity - std::min(segment_size,
+                                               m_segment_capacity)),
+        m_block_size);
+#else
+    return m_block_size;
+#endif
+  }
+
+  /// \brief Returns the offset of a block from the beginning of the segment.
+  std::size_t priv_block_offset(const std::size_t block_no) const {
+    assert(block_no < m_block_offset_list.size());
+    return m_block_offset_list[block_no];
+  }
+
+  /// \brief Returns the size of a block.
+  std::size_t priv_block_size(const std::size_t block_no) const {
+    assert(block_no < m_block_offset_list.size());
+    const auto end = (block_no + 1 < m_block_offset_list.size())
+                         ? m_block_offset_list[block_no + 1]
+                         : m_current_segment_size.load();
+    return end - m_block_offset_list[block_no];
+  }
+
+  /// \brief Returns the number of the block that contains an offset.
+  std::size_t priv_block_no(const std::size_t offset) const {
+    assert(!m_block_offset_list.empty());
+    const auto itr = std::upper_bound(m_block_offset_list.begin(),
+                                      m_block_offset_list.end(), offset);
+    return std::distance(m_block_offset_list.begin(), itr) - 1;
+  }
+
+  bool priv_prepare_header_and_segment(
+      const std::size_t segment_capacity_request) {
+    const auto header_size = mdtl::round_up(sizeof(segment_header_type),
+                                            int64_t(m_system_page_size));
+    const auto vm_region_size =
+        header_size + priv_round_up_to_block_size(segment_capacity_request);
+    if (!priv_reserve_vm(vm_region_size, header_size)) {
+      priv_set_broken_status();
+      return false;
+    }
+    m_segment = reinterpret_cast<char *>(m_vm_region) + header_size;
+    m_segment_capacity =
+        priv_round_down_to_block_size(m_vm_region_size - header_size);
+    assert(m_segment_capacity >= segment_capacity_request);
+    assert(m_segment_capacity + header_size <= m_vm_region_size);
+    priv_construct_segment_header(m_vm_region);
+
+    return true;
+  }
+
+  /// \brief Reserves a VM region of 'nbytes' bytes so that the address
+  /// 'segment_offset' bytes after its beginning is aligned to
+  /// k_segment_alignment.
+  bool priv_reserve_vm(const std::size_t nbytes,
+                       const std::size_t segment_offset) {
+    assert(segment_offset % m_system_page_size == 0);
+    m_vm_region_size =
+        mdtl::round_up((int64_t)nbytes, (int64_t)m_system_page_size);
+    m_vm_region = nullptr;
+
+    const std::size_t reserved_size = m_vm_region_size + k_segment_alignment;
+    auto *const reserved = static_cast<char *>(
+        mdtl::reserve_aligned_vm_region(m_system_page_size, reserved_size));
+    if (reserved) {
+      const auto segment = mdtl::round_up(
+          int64_t(reinterpret_cast<uint64_t>(reserved) + segment_offset),
+          int64_t(k_segment_alignment));
+      auto *const region = reinterpret_cast<char *>(segment - segment_offset);
+      const std::size_t head_size = region - reserved;
+      const std::size_t tail_size =
+          reserved_size - head_size - m_vm_region_size;
+      if ((head_size == 0 || mdtl::os_munmap(reserved, head_size)) &&
+          (tail_size == 0 ||
+           mdtl::os_munmap(region + m_vm_region_size, tail_size))) {
+        m_vm_region = region;
+      }
+    }
+
+    if (!m_vm_region) {
+      METALL_LOG(logger::level::error, "Cannot reserve a VM region "
+                 << m_vm_region_size << " bytes");
+      m_vm_region_size = 0;
+      return false;
+    } else {
+      METALL_LOG(logger::level::verbose, "Reserved a VM region: "
+                 << m_vm_region_size << " bytes at " << (uint64_t)m_vm_region);
+    }
+
+    return true;
+  }
+
+  /// \brief Grows the reserved VM region in place so that the segment can
+  /// hold 'segment_size' bytes, which lets a datastore created with a small
+  /// capacity, e.g., to start many processes quickly, grow beyond it.
+  /// Tries to double the capacity first so that the reservation grows only a
+  /// few times.
+  /// \return Returns false if the address space right after the region is in
+  /// use; the capacity is not changed then.
+  bool priv_grow_vm_reservation(const std::size_t segment_size) {
+    const auto overhead = m_vm_region_size - m_segment_capacity;
+    const auto needed = priv_round_up_to_block_size(segment_size);
+    for (const auto capacity : {std::max(needed, m_segment_capacity * 2),
+                                needed}) {
+      const auto extra = overhead + capacity - m_vm_region_size;
+      if (mdtl::extend_reserved_vm_region(
+              static_cast<char *>(m_vm_region) + m_vm_region_size, extra)) {
+        m_vm_region_size += extra;
+        m_segment_capacity = capacity;
+        METALL_LOG(logger::level::verbose,
+                   "Grew the VM region to " << m_vm_region_size << " bytes");
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool priv_release_vm_region() {
+    // Overwrite the region with PROT_NONE to destroy the map. Because munmap(2)
+    // synchronizes the map region with the file system, overwriting with
+    // PROT_NONE beforehand makes munmap(2) fast. Ignore the success/failure of
+    // this operation as this operation is just a performance optimization.
+    mdtl::map_with_prot_none(m_segment, m_current_segment_size);
+
+    if (!mdtl::munmap(m_vm_region, m_vm_region_size, false)) {
+      METALL_LOG(logger::level::error, "Cannot release a VM region "
+                 << (uint64_t)m_vm_region << ", " << m_vm_region_size
+                 << " bytes.");
+      return false;
+    }
+    m_vm_region = nullptr;
+    m_vm_region_size = 0;
+
+    return true;
+  }
+
+  bool priv_construct_segment_header(void *const addr) {
+    if (!addr) {
+      return false;
+    }
+
+    const auto size = mdtl::round_up(sizeof(segment_header_type),
+                                     int64_t(m_system_page_size));
+    if (mdtl::map_anonymous_write_mode(addr, size, MAP_FIXED) != addr) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot allocate segment header");
+      return false;
+    }
+    m_segment_header = reinterpret_cast<segment_header_type *>(addr);
+
+    new (m_segment_header) segment_header_type();
+
+    return true;
+  }
+
+  bool priv_deallocate_segment_header() {
+    std::destroy_at(&m_segment_header);
     const auto size = mdtl::round_up(sizeof(segment_header_type),
                                      int64_t(m_system_page_size));
     const auto ret = mdtl::munmap(m_segment_header, size, false);
@@ -417,7 +2148,8 @@ class segment_storage {
   }
 
   bool priv_create(const path_type &top_path,
-                   const std::size_t segment_capacity_request) {
+                   const std::size_t segment_capacity_request,
+                   const bool volatile_segment = false) {
     if (!check_sanity()) return false;
     if (is_open())
       return false;  // Cannot open multiple segments simultaneously.
@@ -443,14 +2175,19 @@ class segment_storage {
 
     m_top_path = top_path;
     m_read_only = false;
+    m_copy_on_write = false;
+    m_volatile = volatile_segment;
+    // Cleared if a block file is not mapped with MAP_SYNC
+    m_dax_mapped = !m_volatile;
 
     // Create the first block so that we can assume that there is a block always
     // in a segment.
-    if (!priv_create_new_map(m_top_path, 0, k_block_size, 0)) {
+    if (m_volatile ? !priv_map_scratch_block(0, m_block_size, 0)
+                   : !priv_create_new_map(m_top_path, 0, m_block_size, 0)) {
       priv_set_broken_status();
       return false;
     }
-    m_current_segment_size = k_block_size;
+    m_current_segment_size = m_block_size;
     m_num_blocks = 1;
 
     if (!priv_test_file_space_free(top_path)) {
@@ -460,13 +2197,20 @@ class segment_storage {
       priv_set_broken_status();
       return false;
     }
+    priv_track_dirty_pages();
+    priv_preextend();
 
     return true;
   }
 
+  /// \param live_segment_size If not 0, opens the segment with the live
+  /// read-only mode; see open_live_read_only().
   bool priv_open(const path_type &top_path,
                  const std::size_t segment_capacity_request,
-                 const bool read_only) {
+                 const bool read_only, const bool copy_on_write,
+                 const std::size_t live_segment_size = 0) {
+    assert(!read_only || !copy_on_write);
+    assert(live_segment_size == 0 || read_only);
     if (!check_sanity()) return false;
     if (is_open())
       return false;  // Cannot open multiple segments simultaneously.
@@ -476,53 +2220,92 @@ class segment_storage {
       logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
     }
 
+    // Block files compressed by compress() are decompressed on open; the
+    // writer has decompressed them in the live mode
+    if (live_segment_size == 0 && !priv_decompress_block_files(top_path, 0)) {
+      priv_set_broken_status();
+      return false;
+    }
+
+    std::vector<std::size_t> file_sizes;
+    if (live_segment_size == 0
+            ? !priv_find_block_files(top_path, &file_sizes)
+            : !priv_find_published_block_files(top_path, 0, live_segment_size,
+                                               &file_sizes)) {
+      priv_set_broken_status();
+      return false;
+    }
+    std::size_t total_file_size = 0;
+    for (const auto size : file_sizes) total_file_size += size;
+    // The first block has the block size the segment was created with
+    if (!file_sizes.empty() && priv_valid_block_size(file_sizes[0])) {
+      m_block_size = file_sizes[0];
+    }
+
     if (!priv_prepare_header_and_segment(
-            read_only ? priv_get_size(top_path) : segment_capacity_request)) {
+            !read_only ? segment_capacity_request
+            : live_segment_size == 0
+                ? total_file_size
+                : std::max(segment_capacity_request, total_file_size))) {
       priv_set_broken_status();
       return false;
     }
 
     m_top_path = top_path;
     m_read_only = read_only;
+    m_copy_on_write = copy_on_write;
+    m_volatile = false;
+
+    // The block sizes are taken from the files so that datastores
+    // created with a different block growth policy can be opened
+    m_num_blocks = file_sizes.size();
+    m_block_fd_list.assign(m_num_blocks, -1);
+    m_block_offset_list.resize(m_num_blocks);
+    for (std::size_t block_no = 0; block_no < m_num_blocks; ++block_no) {
+      m_block_offset_list[block_no] = m_current_segment_size;
+      m_current_segment_size += file_sizes[block_no];
+    }
+    m_anonymous_map_flag_list.assign(m_num_blocks, false);
+    if (m_current_segment_size > m_segment_capacity) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The block files are larger than the reserved VM region");
+      priv_release_block_files_on_open_failure();
+      return false;
+    }
 
-    // Maps block files one by one
-    m_num_blocks = 0;
-    while (true) {
-      const auto file_name = priv_block_file_path(m_top_path, m_num_blocks);
-      if (!mdtl::file_exist(file_name)) {
-        break;  // Mapped all files
-      }
-
-      const auto file_size = mdtl::get_file_size(file_name);
-      assert(file_size % page_size() == 0);
-      if (k_block_size != (std::size_t)file_size) {
-        logger::out(logger::level::error, __FILE__, __LINE__,
-                    "File sizes are not the same");
-        priv_release_segment();
-        priv_set_broken_status();
-        return false;
-      }
-
-      const auto fd =
-          priv_map_file(file_name, k_block_size,
-                        std::ptrdiff_t(m_current_segment_size), read_only);
-      if (fd == -1) {
-        std::stringstream ss;
-        ss << "Failed to map a file " << file_name;
-        logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
-        priv_release_segment();
-        priv_set_broken_status();
-        return false;
-      }
-      m_block_fd_list.emplace_back(fd);
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
-      m_anonymous_map_flag_list.push_back(false);
-#endif
-      m_current_segment_size += k_block_size;
-      ++m_num_blocks;
+    // Maps block files in parallel as opening a file can take a long time on
+    // parallel file systems
+    std::vector<unsigned char> sync_mapped_list(m_num_blocks, false);
+    const auto mapped = mdtl::io_executor::instance().parallel_for(
+        m_num_blocks, 0,
+        [this, read_only, &sync_mapped_list](const std::size_t block_no) {
+          const auto file_name = priv_block_file_path(m_top_path, block_no);
+          bool sync_mapped = false;
+          const auto fd = priv_map_file(
+              file_name, priv_block_size(block_no),
+              std::ptrdiff_t(priv_block_offset(block_no)), read_only,
+              &sync_mapped);
+          if (fd == -1) {
+            METALL_LOG(logger::level::error, "Failed to map a file "
+                       << file_name);
+            return false;
+          }
+          m_block_fd_list[block_no] = fd;
+          sync_mapped_list[block_no] = sync_mapped;
+          return true;
+        },
+        mdtl::io_executor::get_device_id(top_path.c_str()));
+    if (!mapped) {
+      priv_release_block_files_on_open_failure();
+      return false;
     }
+    m_dax_mapped = std::all_of(sync_mapped_list.begin(),
+                               sync_mapped_list.end(),
+                               [](const auto mapped) { return mapped; });
 
-    if (!read_only && !priv_test_file_space_free(m_top_path)) {
+    if (copy_on_write) {
+      m_free_file_space = false;  // Must not modify the files
+    } else if (!read_only && !priv_test_file_space_free(m_top_path)) {
       std::string s("Failed to test file space free: " + m_top_path.string());
       logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       priv_release_segment();
@@ -530,14 +2313,141 @@ class segment_storage {
       return false;
     }
 
-    if (m_num_blocks == 0) {
-      priv_set_broken_status();
+    if (!read_only && !copy_on_write) {
+      priv_track_dirty_pages();
+      priv_preextend();
+    }
+
+#ifdef METALL_PREFETCH_ON_OPEN
+    if (!priv_prefetch(0, m_current_segment_size)) {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "Failed to prefetch the segment");
+    }
+#endif
+
+    return true;
+  }
+
+  /// \brief Finds the block files of a segment and gets their sizes.
+  /// The sizes are got in parallel.
+  /// \param top_path The top directory of the segment.
+  /// \param file_sizes A buffer to store the size of each block file.
+  /// \return Returns true if there is at least one valid block file;
+  /// otherwise, returns false.
+  bool priv_find_block_files(const path_type &top_path,
+                             std::vector<std::size_t> *file_sizes) const {
+    // Lists the directory once instead of testing the block files one by
+    // one, which costs a metadata operation per file
+    std::vector<path_type> file_names;
+    if (!mdtl::get_regular_file_names(top_path, &file_names)) {
+      std::string s("Failed to list block files under: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    std::vector<bool> found(file_names.size(), false);
+    for (const auto &name : file_names) {
+      const auto str = name.string();
+      if (str.rfind("block-", 0) != 0 ||
+          str.find_first_not_of("0123456789", 6) != std::string::npos ||
+          str.size() == 6) {
+        continue;
+      }
+      const auto block_no = std::stoull(str.substr(6));
+      if (block_no < found.size()) found[block_no] = true;
+    }
+    // Block files are numbered consecutively from 0
+    const auto num_blocks = std::distance(
+        found.begin(), std::find(found.begin(), found.end(), false));
+    if (num_blocks == 0) {
+      std::string s("No block file under: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       return false;
     }
 
+    file_sizes->assign(num_blocks, 0);
+    return mdtl::io_executor::instance().parallel_for(
+        num_blocks, 0,
+        [this, &top_path, file_sizes](const std::size_t block_no) {
+          const auto file_name = priv_block_file_path(top_path, block_no);
+          const auto ret_size = mdtl::get_file_size(file_name);
+          if (ret_size <= 0 ||
+              static_cast<std::size_t>(ret_size) % page_size() != 0) {
+            METALL_LOG(logger::level::error, "Invalid block file size "
+                       << ret_size << ": " << file_name);
+            return false;
+          }
+          (*file_sizes)[block_no] = ret_size;
+          return true;
+        },
+        mdtl::io_executor::get_device_id(top_path.c_str()));
+  }
+
+  /// \brief Gets the sizes of the block files from 'first_block_no' until
+  /// the blocks cover 'segment_size' bytes of the segment. Used by the live
+  /// read-only mode, in which the writer can be creating the following
+  /// blocks.
+  /// \return Returns false if a block file is missing or invalid.
+  bool priv_find_published_block_files(
+      const path_type &top_path, const std::size_t first_block_no,
+      const std::size_t segment_size,
+      std::vector<std::size_t> *file_sizes) const {
+    file_sizes->clear();
+    std::size_t total_size =
+        (first_block_no == 0) ? 0 : m_current_segment_size.load();
+    for (auto block_no = first_block_no; total_size < segment_size;
+         ++block_no) {
+      const auto file_name = priv_block_file_path(top_path, block_no);
+      const auto ret_size = mdtl::get_file_size(file_name);
+      if (ret_size <= 0 ||
+          static_cast<std::size_t>(ret_size) % page_size() != 0) {
+        METALL_LOG(logger::level::error, "Invalid block file size " << ret_size
+                   << ": " << file_name);
+        return false;
+      }
+      file_sizes->push_back(ret_size);
+      total_size += ret_size;
+    }
     return true;
   }
 
+  bool priv_map_new_blocks(const std::size_t segment_size) {
+    if (!is_open() || !m_read_only) return false;
+    if (m_current_segment_size >= segment_size) return true;
+
+    std::vector<std::size_t> file_sizes;
+    if (!priv_find_published_block_files(m_top_path, m_num_blocks,
+                                         segment_size, &file_sizes)) {
+      return false;
+    }
+    for (const auto file_size : file_sizes) {
+      if (m_current_segment_size + file_size > m_segment_capacity) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "The block files are larger than the reserved VM region");
+        return false;
+      }
+      const auto fd = priv_map_file(priv_block_file_path(m_top_path,
+                                                         m_num_blocks),
+                                    file_size, m_current_segment_size, true);
+      if (fd == -1) return false;
+      m_block_fd_list.push_back(fd);
+      m_block_offset_list.push_back(m_current_segment_size);
+      m_anonymous_map_flag_list.push_back(false);
+      ++m_num_blocks;
+      m_current_segment_size += file_size;
+    }
+    return true;
+  }
+
+  /// \brief Releases the segment after failing to map the block files.
+  void priv_release_block_files_on_open_failure() {
+    // Do not close the files that have not been opened
+    m_block_fd_list.erase(
+        std::remove(m_block_fd_list.begin(), m_block_fd_list.end(), -1),
+        m_block_fd_list.end());
+    priv_release_segment();
+    priv_set_broken_status();
+  }
+
   bool priv_extend(const std::size_t request_size) {
     if (!is_open()) return false;
 
@@ -545,7 +2455,8 @@ class segment_storage {
       return false;
     }
 
-    if (request_size > m_segment_capacity) {
+    if (request_size > m_segment_capacity &&
+        !priv_grow_vm_reservation(request_size)) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Requested segment size is bigger than the reserved VM size");
       return false;
@@ -555,18 +2466,46 @@ class segment_storage {
       return true;  // Already has enough segment size
     }
 
+    // persist() can read the block table concurrently
+    std::unique_lock<std::mutex> lock(m_block_table_mutex);
     while (m_current_segment_size < request_size) {
-      if (!priv_create_new_map(m_top_path, m_num_blocks, k_block_size,
-                               std::ptrdiff_t(m_current_segment_size))) {
+      const auto block_size = priv_next_block_size();
+      const auto block_path = priv_block_file_path(m_top_path, m_num_blocks);
+      // Nothing is mapped if the file cannot be created, e.g., the disk is
+      // full; thus, the segment stays usable
+      const bool scratch = m_copy_on_write || m_volatile;
+      if (!scratch &&
+          !priv_prepare_block_file(block_path, m_num_blocks, block_size,
+                                   std::ptrdiff_t(m_current_segment_size))) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to create a block file to extend the segment");
+        return false;
+      }
+      const bool extended =
+          scratch
+              ? priv_map_scratch_block(m_num_blocks, block_size,
+                                       std::ptrdiff_t(m_current_segment_size))
+              : priv_map_block_file(block_path, m_num_blocks, block_size,
+                                    std::ptrdiff_t(m_current_segment_size));
+      if (!extended) {
         logger::out(logger::level::error, __FILE__, __LINE__,
                     "Failed to extend the segment");
         priv_release_segment();
         priv_set_broken_status();
         return false;
       }
+      if (k_prefault_new_blocks && !scratch &&
+          !m_anonymous_map_flag_list[m_num_blocks]) {
+        priv_prefault(m_current_segment_size, block_size);
+      }
+      METALL_TRACE(segment_extend, m_current_segment_size,
+                   m_current_segment_size + block_size);
       ++m_num_blocks;
-      m_current_segment_size += k_block_size;
+      m_current_segment_size += block_size;
     }
+    lock.unlock();
+    priv_track_dirty_pages();
+    priv_preextend();
 
     return true;
   }
@@ -576,43 +2515,323 @@ class segment_storage {
                            const std::size_t file_size,
                            const std::ptrdiff_t segment_offset) {
     const path_type file_name = priv_block_file_path(top_path, block_number);
+    return priv_prepare_block_file(file_name, block_number, file_size,
+                                   segment_offset) &&
+           priv_map_block_file(file_name, block_number, file_size,
+                               segment_offset);
+  }
+
+  /// \brief Creates the file of a new block or takes its pre-extended file.
+  /// A partially created file is removed on failure.
+  bool priv_prepare_block_file(const path_type &file_name,
+                               const std::size_t block_number,
+                               const std::size_t file_size,
+                               const std::ptrdiff_t segment_offset) {
+    {
+      std::string s("Create and extend a file " + file_name.string() +
+                    " with " + std::to_string(file_size) + " bytes");
+      logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
+    }
+
+    if (priv_take_preextended_block(block_number, segment_offset, file_size,
+                                    file_name)) {
+      return true;
+    }
+    if (!priv_create_block_file(file_name, file_size)) {
+      if (mdtl::file_exist(file_name)) mdtl::remove_file(file_name);
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Maps the file of a new block into the segment.
+  bool priv_map_block_file(const path_type &file_name,
+                           const std::size_t block_number,
+                           const std::size_t file_size,
+                           const std::ptrdiff_t segment_offset) {
+    const bool anonymous = priv_cache_new_block(file_size);
+    int fd = -1;
+    if (anonymous) {
+      fd = priv_map_anonymous(file_name, file_size, segment_offset);
+      m_dax_mapped = false;
+    } else {
+      bool sync_mapped = false;
+      fd = priv_map_file(file_name, file_size, segment_offset, false,
+                         &sync_mapped);
+      m_dax_mapped &= sync_mapped;
+    }
+    if (fd == -1) {
+      return false;
+    }
+    if (m_anonymous_map_flag_list.size() < block_number + 1) {
+      m_anonymous_map_flag_list.resize(block_number + 1, false);
+    }
+    m_anonymous_map_flag_list[block_number] = anonymous;
+    if (m_block_fd_list.size() < block_number + 1) {
+      m_block_fd_list.resize(block_number + 1, -1);
+      m_block_offset_list.resize(block_number + 1, 0);
+    }
+    m_block_fd_list[block_number] = fd;
+    m_block_offset_list[block_number] = segment_offset;
+
+    return true;
+  }
+
+  static bool priv_create_block_file(const path_type &file_name,
+                                     const std::size_t file_size) {
+    if (!mdtl::create_file(file_name)) return false;
+    // Allocates the disk space if the pages are prefaulted
+    if (!mdtl::extend_file_size(file_name, file_size, k_prefault_new_blocks)) {
+      return false;
+    }
+    if (static_cast<std::size_t>(mdtl::get_file_size(file_name)) < file_size) {
+      std::string s("Failed to create and extend file: " + file_name.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // ---------- Pre-extension ---------- //
+  static path_type priv_preextended_block_file_path(const path_type &top_path,
+                                                    const std::size_t n) {
+    // Not to be taken as a block file if left, e.g., by a crash
+    return top_path / ("preextended-block-" + std::to_string(n));
+  }
+
+  /// \brief Creates the files of the next k_num_preextended_blocks blocks
+  /// in background so that extending the segment does not wait on creating
+  /// files. The files are created with temporary names and renamed when the
+  /// segment is extended.
+  void priv_preextend() {
+    if (k_num_preextended_blocks == 0 || !is_open() || m_read_only ||
+        m_copy_on_write || m_volatile) {
+      return;
+    }
+
+    std::size_t block_no = m_num_blocks + m_preextended_blocks.size();
+    std::size_t offset =
+        m_preextended_blocks.empty()
+            ? m_current_segment_size.load()
+            : m_preextended_blocks.back().offset +
+                  m_preextended_blocks.back().size;
+    while (m_preextended_blocks.size() < k_num_preextended_blocks) {
+      const auto size = priv_block_size_at(offset);
+      if (offset + size > m_segment_capacity) break;
+
+      auto promise = std::make_shared<std::promise<bool>>();
+      m_preextended_blocks.push_back(
+          preextended_block{block_no, offset, size, promise->get_future()});
+      // Does not capture 'this' as this object can be moved
+      mdtl::io_executor::instance().submit(
+          [file_name = priv_preextended_block_file_path(m_top_path, block_no),
+           size, promise]() {
+            // Remove a file left by a previous run, which can be larger
+            bool ret = mdtl::remove_file(file_name);
+            ret = ret && priv_create_block_file(file_name, size);
+            promise->set_value(ret);
+          });
+      ++block_no;
+      offset += size;
+    }
+  }
+
+  /// \brief Takes the pre-extended file of a block, if any, and renames it
+  /// to 'file_name'. Discards all pre-extended files if they do not match
+  /// the block, e.g., the block size has changed.
+  /// \return Returns true if the file is taken; otherwise, false.
+  bool priv_take_preextended_block(const std::size_t block_no,
+                                   const std::ptrdiff_t offset,
+                                   const std::size_t size,
+                                   const path_type &file_name) {
+    if (m_preextended_blocks.empty()) return false;
+    auto &front = m_preextended_blocks.front();
+    if (front.block_no != block_no ||
+        front.offset != static_cast<std::size_t>(offset) ||
+        front.size != size) {
+      priv_discard_preextended_blocks();
+      return false;
+    }
+
+    const bool created = front.created.get();
+    m_preextended_blocks.pop_front();
+    const auto preextended_file_name =
+        priv_preextended_block_file_path(m_top_path, block_no);
+    if (!created) {
+      mdtl::remove_file(preextended_file_name);
+      return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(preextended_file_name, file_name, ec);
+    if (ec) {
+      std::string s("Failed to rename " + preextended_file_name.string() +
+                    ": " + ec.message());
+      logger::out(logger::level::warning, __FILE__, __LINE__, s.c_str());
+      mdtl::remove_file(preextended_file_name);
+      return false;
+    }
+    // The directory is synced at the next sync
+    m_directory_sync_pending = true;
+    return true;
+  }
+
+  /// \brief Waits for the pre-extended files being created.
+  void priv_wait_preextended_blocks() {
+    for (auto &block : m_preextended_blocks) block.created.wait();
+  }
+
+  /// \brief Waits for the pre-extended files and removes them.
+  void priv_discard_preextended_blocks() {
+    for (auto &block : m_preextended_blocks) {
+      block.created.wait();
+      mdtl::remove_file(
+          priv_preextended_block_file_path(m_top_path, block.block_no));
+    }
+    m_preextended_blocks.clear();
+  }
+
+  /// \brief Faults in the pages of a new block by the I/O threads in
+  /// background (see METALL_PREFAULT_NEW_BLOCKS).
+  void priv_prefault(const std::size_t offset, const std::size_t size) {
+    // Forget the finished ones
+    m_prefaults.erase(
+        std::remove_if(m_prefaults.begin(), m_prefaults.end(),
+                       [](const std::future<void> &f) {
+                         return f.wait_for(std::chrono::seconds(0)) ==
+                                std::future_status::ready;
+                       }),
+        m_prefaults.end());
+
+    // Each task faults in a piece so that the file system allocates the
+    // pages in parallel
+    static constexpr std::size_t k_piece_size = 1ULL << 25ULL;
+    auto *const begin = static_cast<char *>(m_segment) + offset;
+    for (std::size_t piece = 0; piece < size; piece += k_piece_size) {
+      // Does not capture 'this' as this object can be moved
+      m_prefaults.push_back(mdtl::io_executor::instance().submit(
+          [addr = begin + piece,
+           length = std::min(k_piece_size, size - piece)]() {
+            // Nothing to do on failure; the pages are faulted in on access
+            mdtl::populate_write(addr, length);
+          }));
+    }
+  }
+
+  /// \brief Waits for the running prefaults, e.g., before unmapping the
+  /// segment.
+  void priv_wait_prefaults() {
+    for (auto &prefault : m_prefaults) prefault.wait();
+    m_prefaults.clear();
+  }
+
+  /// \brief Extends the segment with anonymous memory without creating a
+  /// block file. Used by the copy-on-write and volatile modes.
+  bool priv_map_scratch_block(const std::size_t block_number,
+                              const std::size_t block_size,
+                              const std::ptrdiff_t segment_offset) {
+    assert(m_copy_on_write || m_volatile);
+    const auto map_addr = static_cast<char *>(m_segment) + segment_offset;
+    if (!priv_map_anonymous_region(map_addr, block_size)) {
+      std::string s("Failed to map an anonymous region at " +
+                    std::to_string(segment_offset));
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+
+    // No file backs the block
+    m_block_fd_list.resize(block_number + 1, -1);
+    m_block_offset_list.resize(block_number + 1, 0);
+    m_block_offset_list[block_number] = segment_offset;
+    m_anonymous_map_flag_list.resize(block_number + 1, false);
+    return true;
+  }
+
+  bool priv_spill(const std::size_t memory_budget,
+                  std::size_t *const num_spilled_bytes) {
+    if (num_spilled_bytes) *num_spilled_bytes = 0;
+    if (!is_open() || !m_volatile) return false;
+
+    // The blocks kept in anonymous memory have no file descriptor
+    std::vector<std::size_t> resident_bytes(m_num_blocks, 0);
+    std::size_t total_resident_bytes = 0;
+    for (std::size_t block_no = 0; block_no < m_num_blocks; ++block_no) {
+      if (m_block_fd_list[block_no] != -1) continue;
+      const auto size = priv_block_size(block_no);
+      const auto resident = mdtl::get_num_resident_bytes(
+          static_cast<char *>(m_segment) + priv_block_offset(block_no), size);
+      resident_bytes[block_no] = (resident < 0) ? size : resident;
+      total_resident_bytes += resident_bytes[block_no];
+    }
+
+    for (std::size_t block_no = 0;
+         block_no < m_num_blocks && total_resident_bytes > memory_budget;
+         ++block_no) {
+      if (m_block_fd_list[block_no] != -1 || resident_bytes[block_no] == 0) {
+        continue;
+      }
+      if (!priv_spill_block(block_no)) return false;
+      total_resident_bytes -= resident_bytes[block_no];
+      if (num_spilled_bytes) *num_spilled_bytes += priv_block_size(block_no);
+    }
+    return true;
+  }
+
+  /// \brief Writes a block kept in anonymous memory to its file and maps the
+  /// file at the same address.
+  bool priv_spill_block(const std::size_t block_no) {
+    const auto path = priv_block_file_path(m_top_path, block_no);
+    const auto offset = priv_block_offset(block_no);
+    const auto size = priv_block_size(block_no);
     {
-      std::string s("Create and extend a file " + file_name.string() +
-                    " with " + std::to_string(file_size) + " bytes");
+      std::string s("Spill block " + std::to_string(block_no) + " to " +
+                    path.string());
       logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
     }
+    if (!priv_create_block_file(path, size)) return false;
 
-    if (!mdtl::create_file(file_name)) return false;
-    if (!mdtl::extend_file_size(file_name, file_size)) return false;
-    if (static_cast<std::size_t>(mdtl::get_file_size(file_name)) < file_size) {
-      std::string s("Failed to create and extend file: " + file_name.string());
-      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd == -1) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "open");
       return false;
     }
-
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
-    const auto fd = priv_map_anonymous(file_name, file_size, segment_offset);
-    if (m_anonymous_map_flag_list.size() < block_number + 1) {
-      m_anonymous_map_flag_list.resize(block_number + 1, false);
+    bool written = priv_write_nonzero_pages(fd, block_no);
+    written &= mdtl::os_close(fd);
+    if (!written) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to write a block to spill");
+      mdtl::remove_file(path);
+      return false;
     }
-    m_anonymous_map_flag_list[block_number] = true;
-#else
-    const auto fd = priv_map_file(file_name, file_size, segment_offset, false);
-#endif
-    if (fd == -1) {
+
+    // The anonymous pages are freed by mapping the file over them
+    const auto mapped_fd = priv_map_file(path, size, offset, false);
+    if (mapped_fd == -1) {
+      // The anonymous map may have been unmapped
+      priv_release_segment();
+      priv_set_broken_status();
       return false;
     }
-    if (m_block_fd_list.size() < block_number + 1) {
-      m_block_fd_list.resize(block_number + 1, -1);
+    m_block_fd_list[block_no] = mapped_fd;
+    if (!priv_repin(offset, offset + size)) {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "Failed to pin the pages of a spilled block again");
     }
-    m_block_fd_list[block_number] = fd;
+    return true;
+  }
 
+  bool priv_zero_page(const char *const page) const {
+    const auto *const words = reinterpret_cast<const uint64_t *>(page);
+    for (std::size_t i = 0; i < m_system_page_size / sizeof(uint64_t); ++i) {
+      if (words[i] != 0) return false;
+    }
     return true;
   }
 
+  /// \param sync_mapped If not nullptr, set to true if the file is mapped
+  /// with MAP_SYNC.
   int priv_map_file(const path_type &path, const std::size_t file_size,
-                    const std::ptrdiff_t segment_offset,
-                    const bool read_only) const {
+                    const std::ptrdiff_t segment_offset, const bool read_only,
+                    [[maybe_unused]] bool *const sync_mapped = nullptr) const {
     assert(!path.empty());
     assert(file_size > 0);
     assert(segment_offset >= 0);
@@ -627,19 +2846,31 @@ class segment_storage {
 
     const auto map_addr = static_cast<char *>(m_segment) + segment_offset;
 
-    {
-      std::stringstream ss;
-      ss << "Map a file " << path << " at " << segment_offset << " with "
-         << file_size << " bytes; read-only mode is "
-         << std::to_string(read_only);
-      logger::out(logger::level::verbose, __FILE__, __LINE__, ss.str().c_str());
-    }
+    METALL_LOG(logger::level::verbose, "Map a file " << path << " at "
+               << segment_offset << " with " << file_size
+               << " bytes; read-only mode is " << std::to_string(read_only));
 
-    const auto ret =
-        (read_only)
-            ? mdtl::map_file_read_mode(path, map_addr, file_size, 0, MAP_FIXED)
-            : mdtl::map_file_write_mode(path, map_addr, file_size, 0,
+    std::pair<int, void *> ret;
+    if (read_only) {
+      ret = mdtl::map_file_read_mode(path, map_addr, file_size, 0, MAP_FIXED);
+    } else if (m_copy_on_write) {
+      ret = mdtl::map_file_write_private_mode(path, map_addr, file_size, 0,
+                                              MAP_FIXED);
+    } else {
+#ifdef METALL_USE_DAX
+      if (mdtl::k_cache_line_write_back_supported) {
+        bool mapped_with_sync = false;
+        ret = mdtl::map_file_write_sync_mode(path, map_addr, file_size, 0,
+                                             MAP_FIXED | map_nosync,
+                                             &mapped_with_sync);
+        if (sync_mapped) *sync_mapped = mapped_with_sync;
+      } else
+#endif
+      {
+        ret = mdtl::map_file_write_mode(path, map_addr, file_size, 0,
                                         MAP_FIXED | map_nosync);
+      }
+    }
     if (ret.first == -1 || !ret.second) {
       std::string s("Failed to map a file: " + path.string());
       logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
@@ -648,6 +2879,8 @@ class segment_storage {
       }
       return -1;
     }
+    priv_advise_huge_page(map_addr, file_size);
+    priv_apply_numa_policy(map_addr, file_size);
 
     return ret.first;
   }
@@ -667,8 +2900,7 @@ class segment_storage {
       logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
     }
 
-    const auto *addr =
-        mdtl::map_anonymous_write_mode(map_addr, region_size, MAP_FIXED);
+    const auto *addr = priv_map_anonymous_region(map_addr, region_size);
     if (!addr) {
       std::string s("Failed to map an anonymous region at " +
                     std::to_string(segment_offset));
@@ -694,15 +2926,38 @@ class segment_storage {
   }
 
   bool priv_release_segment() {
+    priv_wait_async_sync();
+    priv_discard_preextended_blocks();
+    priv_wait_prefaults();
     if (!is_open()) return false;
 
+    // Must be done before unmapping the segment
+    for (const auto &range : m_gpu_registered_ranges) {
+      mdtl::cuda::host_unregister(static_cast<char *>(m_segment) +
+                                  range.first);
+    }
+    m_gpu_registered_ranges.clear();
+
     int succeeded = true;
     for (const auto &fd : m_block_fd_list) {
-      succeeded &= mdtl::os_close(fd);
+      if (fd != -1) succeeded &= mdtl::os_close(fd);
     }
+    m_block_fd_list.clear();
+    m_block_offset_list.clear();
+    m_pinned_ranges.clear();
+    m_pinned_size = 0;
+    m_anonymous_map_flag_list.clear();
 
     succeeded &= priv_deallocate_segment_header();
 
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    if (m_dirty_page_tracker) m_dirty_page_tracker->untrack();
+#endif
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    m_snapshot_page_tracker.reset();
+    m_replication_page_tracker.reset();
+#endif
+
     succeeded &= priv_release_vm_region();
 
     if (!succeeded) {
@@ -717,8 +2972,11 @@ class segment_storage {
   }
 
   bool priv_sync(const bool sync) {
-    if (!priv_sync_segment(
-            sync)) {  // Failing this operation is not a critical error
+    METALL_TRACE(sync_begin, m_current_segment_size, sync);
+    // Failing this operation is not a critical error
+    const bool synced = priv_sync_segment(sync);
+    METALL_TRACE(sync_end, m_current_segment_size, synced);
+    if (!synced) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Failed to synchronize the segment");
       return false;
@@ -729,7 +2987,8 @@ class segment_storage {
   bool priv_sync_segment(const bool sync) {
     if (!is_open()) return false;
 
-    if (m_read_only) return true;
+    // Nothing is written back in the copy-on-write and volatile modes
+    if (m_read_only || m_copy_on_write || m_volatile) return true;
 
     // Protect the region to detect unexpected write by application during msync
     if (!mdtl::mprotect_read_only(m_segment, m_current_segment_size)) {
@@ -740,7 +2999,17 @@ class segment_storage {
 
     logger::out(logger::level::verbose, __FILE__, __LINE__,
                 "msync() for the application data segment");
-    if (!priv_parallel_msync(sync)) {
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    // The segment is read-only here, i.e., no page gets dirty between
+    // collecting the dirty pages and resetting the soft-dirty bits.
+    const bool synced = (m_dirty_page_tracker &&
+                         m_dirty_page_tracker->collect())
+                            ? priv_parallel_msync_dirty_pages(sync)
+                            : priv_parallel_msync(sync);
+#else
+    const bool synced = priv_parallel_msync(sync);
+#endif
+    if (!synced) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Failed to msync the segment");
       return false;
@@ -751,77 +3020,577 @@ class segment_storage {
       return false;
     }
 
+    // Persist the names of the block files taken from the pre-extended ones
+    if (m_directory_sync_pending && sync) {
+      if (!mdtl::fsync(m_top_path)) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Failed to fsync the segment directory");
+        return false;
+      }
+      m_directory_sync_pending = false;
+    }
+
     return true;
   }
 
   bool priv_parallel_msync(const bool sync) {
-    std::atomic_uint_fast64_t block_no_count = 0;
-    std::atomic_uint_fast64_t num_successes = 0;
-    auto diff_sync = [&sync, &block_no_count, &num_successes, this]() {
-      while (true) {
-        const auto block_no = block_no_count.fetch_add(1);
-        if (block_no < m_block_fd_list.size()) {
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
+    METALL_LOG(logger::level::verbose,
+               "Sync " << m_block_fd_list.size() << " files");
+#ifdef METALL_ENABLE_IO_URING
+    if (sync && mdtl::get_thread_local_io_uring()) {
+      return priv_fsync_block_files_io_uring();
+    }
+#endif
+    return mdtl::io_executor::instance().parallel_for(
+        m_block_fd_list.size(), 0,
+        [&sync, this](const std::size_t block_no) {
           assert(m_anonymous_map_flag_list.size() > block_no);
           if (m_anonymous_map_flag_list[block_no]) {
-            num_successes.fetch_add(priv_sync_anonymous_map(block_no) ? 1 : 0);
-            continue;
+            return priv_sync_anonymous_map(block_no);
           }
-#endif
           const auto map =
-              static_cast<char *>(m_segment) + block_no * k_block_size;
-          num_successes.fetch_add(mdtl::os_msync(map, k_block_size, sync) ? 1
-                                                                          : 0);
-        } else {
-          break;
-        }
+              static_cast<char *>(m_segment) + priv_block_offset(block_no);
+          return mdtl::os_msync(map, priv_block_size(block_no), sync);
+        },
+        priv_io_device_id());
+  }
+
+#ifdef METALL_ENABLE_IO_URING
+  /// \brief Syncs the block files by batching fsync requests with io_uring,
+  /// which also writes back the pages written through the shared file
+  /// mappings.
+  bool priv_fsync_block_files_io_uring() {
+    for (std::size_t block_no = 0; block_no < m_block_fd_list.size();
+         ++block_no) {
+      if (m_anonymous_map_flag_list[block_no] &&
+          !priv_sync_anonymous_map(block_no)) {
+        return false;  // The segment has been released
       }
-    };
+    }
+    return mdtl::fsync_files_io_uring(m_block_fd_list, true);
+  }
+#endif
+
+  /// \brief Returns the ID of the device the segment is stored in.
+  mdtl::io_executor::device_id_type priv_io_device_id() const {
+    if (m_block_fd_list.empty()) return mdtl::io_executor::k_no_device;
+    return mdtl::io_executor::get_device_id(m_block_fd_list.front());
+  }
 
-    const auto num_threads =
-        (int)std::min(m_block_fd_list.size(),
-                      (std::size_t)std::thread::hardware_concurrency());
+  /// \brief Starts or updates tracking the written pages in the segment.
+  /// Does nothing if no tracker is enabled.
+  void priv_track_dirty_pages() {
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    if (m_dirty_page_tracker) {
+      m_dirty_page_tracker->track(m_segment, m_current_segment_size,
+                                  m_system_page_size);
+    }
+#endif
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+    // The new pages are reported as dirty by the kernel until the soft-dirty
+    // bits are reset next time; thus, new blocks are saved by the next delta
+    if (m_snapshot_page_tracker) {
+      m_snapshot_page_tracker->track(m_segment, m_current_segment_size,
+                                     m_system_page_size);
+    }
+    if (m_replication_page_tracker) {
+      m_replication_page_tracker->track(m_segment, m_current_segment_size,
+                                        m_system_page_size);
+    }
+#endif
+  }
+
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+
+  /// \brief Takes the runs of the dirty pages found by the dirty page
+  /// tracker. A range does not span blocks.
+  /// The ranges in the blocks mapped anonymously are not included.
+  std::vector<sync_range_type> priv_take_dirty_ranges() {
+    std::vector<sync_range_type> ranges;
+    m_dirty_page_tracker->take_dirty_ranges(
+        [&ranges, this](const std::size_t offset, const std::size_t length) {
+          for (std::size_t pos = offset; pos < offset + length;) {
+            const auto block_no = priv_block_no(pos);
+            const auto block_end =
+                priv_block_offset(block_no) + priv_block_size(block_no);
+            const auto end = std::min(offset + length, block_end);
+            ranges.emplace_back(pos, end - pos);
+            pos = end;
+          }
+        });
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+                                [this](const auto &range) {
+                                  return m_anonymous_map_flag_list
+                                      [priv_block_no(range.first)];
+                                }),
+                 ranges.end());
+    return ranges;
+  }
+
+  /// \brief Syncs only the dirty pages found by the dirty page tracker.
+  /// Blocks mapped anonymously are written back entirely.
+  bool priv_parallel_msync_dirty_pages(const bool sync) {
+    const auto ranges = priv_take_dirty_ranges();
+    bool succeeded = true;
+    for (std::size_t block_no = 0; block_no < m_block_fd_list.size();
+         ++block_no) {
+      if (m_anonymous_map_flag_list[block_no]) {
+        succeeded &= priv_sync_anonymous_map(block_no);
+      }
+    }
+    METALL_LOG(logger::level::verbose,
+               "Sync " << ranges.size() << " dirty page ranges");
+    succeeded &= priv_parallel_msync_ranges(m_segment, ranges, sync, 0,
+                                            priv_io_device_id());
+    return succeeded;
+  }
+#endif
+
+  /// \brief msyncs the given ranges of a segment in parallel.
+  /// This function does not touch the other members so that it can run in
+  /// background.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \param device_id The ID of the device the segment is stored in.
+  static bool priv_parallel_msync_ranges(
+      void *const segment, const std::vector<sync_range_type> &ranges,
+      const bool sync, const int max_num_threads,
+      const mdtl::io_executor::device_id_type device_id) {
+    return mdtl::io_executor::instance().parallel_for(
+        ranges.size(), max_num_threads,
+        [segment, &ranges, sync](const std::size_t task_no) {
+          const auto &range = ranges[task_no];
+          const auto map = static_cast<char *>(segment) + range.first;
+          return mdtl::os_msync(map, range.second, sync);
+        },
+        device_id);
+  }
+
+  // ---------- Asynchronous sync ---------- //
+  std::future<bool> priv_sync_async(const int max_num_threads) {
+    priv_wait_async_sync();
+
+    std::promise<bool> promise;
+    auto future = promise.get_future();
+    if (!is_open() || m_read_only || m_copy_on_write || m_volatile) {
+      promise.set_value(is_open());
+      return future;
+    }
+
+    std::vector<sync_range_type> ranges;
+    if (!priv_prepare_async_sync(&ranges)) {
+      promise.set_value(false);
+      return future;
+    }
+
+    logger::out(logger::level::verbose, __FILE__, __LINE__,
+                "msync() for the application data segment in background");
+    // Does not capture 'this' as this object can be moved
+    m_async_sync = mdtl::io_executor::instance().submit(
+        [segment = m_segment, ranges = std::move(ranges), max_num_threads,
+         device_id = priv_io_device_id(),
+         promise = std::make_shared<std::promise<bool>>(
+             std::move(promise))]() {
+          const bool ret = priv_parallel_msync_ranges(
+              segment, ranges, true, max_num_threads, device_id);
+          if (!ret) {
+            logger::out(logger::level::error, __FILE__, __LINE__,
+                        "Failed to msync the segment");
+          }
+          promise->set_value(ret);
+        });
+    return future;
+  }
+
+  /// \brief Determines the ranges to sync in background.
+  /// Blocks mapped anonymously are written back here and dirty pages are
+  /// collected here, protecting the segment only during these steps.
+  bool priv_prepare_async_sync(std::vector<sync_range_type> *const ranges) {
+    bool protect = priv_has_anonymous_blocks();
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    protect = true;
+#endif
+    if (protect &&
+        !mdtl::mprotect_read_only(m_segment, m_current_segment_size)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to protect the segment with the read only mode");
+      return false;
+    }
+
+    bool succeeded = true;
+    for (std::size_t block_no = 0; block_no < m_block_fd_list.size();
+         ++block_no) {
+      if (m_anonymous_map_flag_list[block_no]) {
+        succeeded &= priv_sync_anonymous_map(block_no);
+      }
+    }
+
+    bool collected = false;
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+    if (succeeded && m_dirty_page_tracker &&
+        m_dirty_page_tracker->collect()) {
+      *ranges = priv_take_dirty_ranges();
+      collected = true;
+    }
+#endif
+    if (!collected) {
+      for (std::size_t block_no = 0; block_no < m_block_fd_list.size();
+           ++block_no) {
+        ranges->emplace_back(priv_block_offset(block_no),
+                             priv_block_size(block_no));
+      }
+    }
+
+    if (protect &&
+        !mdtl::mprotect_read_write(m_segment, m_current_segment_size)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to set the segment to readable and writable");
+      return false;
+    }
+
+    return succeeded;
+  }
+
+  /// \brief Waits for the running asynchronous sync, if any.
+  void priv_wait_async_sync() {
+    if (m_async_sync.valid()) m_async_sync.get();
+  }
+
+  bool priv_prefetch(
+      const std::ptrdiff_t offset, const std::size_t nbytes,
+      const int max_num_threads = 0,
+      const std::function<void(std::size_t)> &on_loaded = {}) {
+    if (!is_open() || offset < 0) return false;
+    if ((std::size_t)offset >= m_current_segment_size) return true;
+
+    const std::size_t begin = mdtl::round_down(offset, page_size());
+    const std::size_t end = std::min(
+        (std::size_t)mdtl::round_up(offset + nbytes, page_size()),
+        m_current_segment_size.load());
+    // Each task loads a piece so that the pieces are read in parallel
+    static constexpr std::size_t k_piece_size = 1ULL << 25ULL;
+    const std::size_t num_pieces =
+        (end - begin + k_piece_size - 1) / k_piece_size;
+    return mdtl::io_executor::instance().parallel_for(
+        num_pieces, max_num_threads,
+        [begin, end, this, &on_loaded](const std::size_t piece_no) {
+          const std::size_t piece_begin = begin + piece_no * k_piece_size;
+          const std::size_t length =
+              std::min(k_piece_size, end - piece_begin);
+          if (!mdtl::populate_read(
+                  static_cast<char *>(m_segment) + piece_begin, length)) {
+            return false;
+          }
+          if (on_loaded) on_loaded(length);
+          return true;
+        },
+        priv_io_device_id());
+  }
+
+  // ---------- Pinning ---------- //
+  /// \brief Rounds a region to the page boundaries and clips it to the
+  /// current segment.
+  bool priv_persist(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    if (!is_open() || offset < 0) return false;
+    // Nothing is written back in these modes
+    if (m_read_only || m_copy_on_write || m_volatile) return true;
+
+    // Can be called while another thread extends the segment, e.g., by the
+    // checkpointing; thus, reads the block table under the lock
+    const auto begin = std::size_t(offset);
+    std::size_t end = 0;
+    bool dax_mapped = false;
     {
-      std::stringstream ss;
-      ss << "Sync files with " << num_threads << " threads";
-      logger::out(logger::level::verbose, __FILE__, __LINE__, ss.str().c_str());
+      std::lock_guard<std::mutex> guard(m_block_table_mutex);
+      end = std::min(begin + nbytes, m_current_segment_size.load());
+      if (begin >= end) return true;
+      dax_mapped = m_dax_mapped;
+      // msync does not write anonymous maps to the files
+      for (auto block_no = priv_block_no(begin);
+           !dax_mapped && block_no < m_anonymous_map_flag_list.size() &&
+           priv_block_offset(block_no) < end;
+           ++block_no) {
+        if (m_anonymous_map_flag_list[block_no] &&
+            !priv_sync_anonymous_map(block_no)) {
+          return false;
+        }
+      }
+    }
+
+    // The blocks are not unmapped while the segment is open
+    auto *const segment = static_cast<char *>(m_segment);
+    if (dax_mapped) {
+      mdtl::persist_cache_lines(segment + begin, end - begin);
+      return true;
+    }
+    std::size_t page_begin = 0;
+    std::size_t page_end = 0;
+    if (!priv_to_page_range(offset, end - begin, &page_begin, &page_end)) {
+      return false;
+    }
+    return mdtl::os_msync(segment + page_begin, page_end - page_begin, true);
+  }
+
+  /// \brief Returns true if [begin, end) is in the blocks mapped from their
+  /// files with shared maps, whose pages can be dropped without losing data.
+  bool priv_file_mapped(const std::size_t begin, const std::size_t end) const {
+    if (m_copy_on_write) return false;
+    for (auto block_no = priv_block_no(begin);
+         block_no < m_num_blocks && priv_block_offset(block_no) < end;
+         ++block_no) {
+      if (m_block_fd_list[block_no] == -1 ||
+          (block_no < m_anonymous_map_flag_list.size() &&
+           m_anonymous_map_flag_list[block_no])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool priv_to_page_range(const std::ptrdiff_t offset, const std::size_t nbytes,
+                          std::size_t *const begin,
+                          std::size_t *const end) const {
+    if (!is_open() || offset < 0) return false;
+    const std::size_t size = m_current_segment_size;
+    *begin =
+        std::min((std::size_t)mdtl::round_down(offset, page_size()), size);
+    *end = std::min((std::size_t)mdtl::round_up(offset + nbytes, page_size()),
+                    size);
+    return true;
+  }
+
+  /// \brief Returns the number of the bytes in [begin, end) that are pinned.
+  std::size_t priv_pinned_size_in(const std::size_t begin,
+                                  const std::size_t end) const {
+    std::size_t size = 0;
+    auto itr = m_pinned_ranges.upper_bound(begin);
+    if (itr != m_pinned_ranges.begin()) --itr;
+    for (; itr != m_pinned_ranges.end() && itr->first < end; ++itr) {
+      const auto b = std::max(itr->first, begin);
+      const auto e = std::min(itr->second, end);
+      if (b < e) size += e - b;
+    }
+    return size;
+  }
+
+  /// \brief Removes [begin, end) from the pinned ranges.
+  void priv_erase_pinned_range(const std::size_t begin, const std::size_t end) {
+    auto itr = m_pinned_ranges.upper_bound(begin);
+    if (itr != m_pinned_ranges.begin()) --itr;
+    while (itr != m_pinned_ranges.end() && itr->first < end) {
+      const auto range = *itr;
+      if (range.second <= begin) {
+        ++itr;
+        continue;
+      }
+      itr = m_pinned_ranges.erase(itr);
+      m_pinned_size -= range.second - range.first;
+      if (range.first < begin) {
+        m_pinned_ranges.emplace(range.first, begin);
+        m_pinned_size += begin - range.first;
+      }
+      if (end < range.second) {
+        m_pinned_ranges.emplace(end, range.second);
+        m_pinned_size += range.second - end;
+      }
+    }
+  }
+
+  bool priv_pin(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+
+    const auto new_size =
+        m_pinned_size + (end - begin) - priv_pinned_size_in(begin, end);
+    if (METALL_SEGMENT_MAX_PINNED_SIZE > 0 &&
+        new_size > METALL_SEGMENT_MAX_PINNED_SIZE) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot pin more than METALL_SEGMENT_MAX_PINNED_SIZE bytes");
+      return false;
+    }
+    if (!mdtl::os_mlock(static_cast<char *>(m_segment) + begin, end - begin)) {
+      return false;
+    }
+
+    // Merge with the adjacent and overlapping ranges
+    auto new_begin = begin;
+    auto new_end = end;
+    auto itr = m_pinned_ranges.upper_bound(begin);
+    if (itr != m_pinned_ranges.begin() && std::prev(itr)->second >= begin) {
+      --itr;
+    }
+    while (itr != m_pinned_ranges.end() && itr->first <= end) {
+      new_begin = std::min(new_begin, itr->first);
+      new_end = std::max(new_end, itr->second);
+      itr = m_pinned_ranges.erase(itr);
+    }
+    m_pinned_ranges.emplace(new_begin, new_end);
+    m_pinned_size = new_size;
+    return true;
+  }
+
+  bool priv_unpin(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+    if (!mdtl::os_munlock(static_cast<char *>(m_segment) + begin,
+                          end - begin)) {
+      return false;
     }
-    std::vector<std::unique_ptr<std::thread>> threads(num_threads);
-    for (auto &th : threads) {
-      th = std::make_unique<std::thread>(diff_sync);
+    priv_erase_pinned_range(begin, end);
+    return true;
+  }
+
+  bool priv_gpu_register(const std::ptrdiff_t offset,
+                         const std::size_t nbytes) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+
+    const auto next = m_gpu_registered_ranges.lower_bound(begin);
+    if ((next != m_gpu_registered_ranges.end() && next->first < end) ||
+        (next != m_gpu_registered_ranges.begin() &&
+         std::prev(next)->second > begin)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The region overlaps a region registered to CUDA");
+      return false;
+    }
+    if (!mdtl::cuda::host_register(static_cast<char *>(m_segment) + begin,
+                                   end - begin)) {
+      return false;
+    }
+    m_gpu_registered_ranges.emplace(begin, end);
+    return true;
+  }
+
+  bool priv_gpu_unregister(const std::ptrdiff_t offset,
+                           const std::size_t nbytes) {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (!priv_to_page_range(offset, nbytes, &begin, &end)) return false;
+    if (begin == end) return true;
+
+    const auto itr = m_gpu_registered_ranges.find(begin);
+    if (itr == m_gpu_registered_ranges.end()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The region is not registered to CUDA");
+      return false;
     }
+    m_gpu_registered_ranges.erase(itr);
+    return mdtl::cuda::host_unregister(static_cast<char *>(m_segment) +
+                                       begin);
+  }
 
-    for (auto &th : threads) {
-      th->join();
+  bool priv_load_to_device(const std::ptrdiff_t offset,
+                           const std::size_t nbytes,
+                           void *const device_buffer) {
+    if (!is_open() || offset < 0 ||
+        std::size_t(offset) + nbytes > m_current_segment_size) {
+      return false;
     }
+    if (!mdtl::cuda::enabled()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Metall is built without CUDA (METALL_USE_CUDA)");
+      return false;
+    }
+    if (nbytes == 0) return true;
+
+    const auto end = std::size_t(offset) + nbytes;
+    for (auto block_no = priv_block_no(offset);
+         block_no < m_num_blocks && priv_block_offset(block_no) < end;
+         ++block_no) {
+      const auto block_begin = priv_block_offset(block_no);
+      const auto begin = std::max(std::size_t(offset), block_begin);
+      const auto piece_end =
+          std::min(end, block_begin + priv_block_size(block_no));
+      auto *const destination =
+          static_cast<char *>(device_buffer) + (begin - offset);
+
+      // The block file is up to date after writing back the dirty pages
+      if (mdtl::cuda::cufile_enabled() && !m_volatile &&
+          priv_file_mapped(begin, piece_end) &&
+          priv_persist(begin, piece_end - begin) &&
+          mdtl::cuda::read_file_to_device(
+              priv_block_file_path(m_top_path, block_no).string(),
+              begin - block_begin, piece_end - begin, destination)) {
+        continue;
+      }
+      if (!mdtl::cuda::copy_to_device(
+              destination, static_cast<char *>(m_segment) + begin,
+              piece_end - begin)) {
+        return false;
+      }
+    }
+    return true;
+  }
 
-    return num_successes == m_block_fd_list.size();
+  /// \brief Pins the pinned pages in [begin, end) again.
+  /// Must be called after remapping a region as a new map is not locked.
+  bool priv_repin(const std::size_t begin, const std::size_t end) {
+    bool succeeded = true;
+    auto itr = m_pinned_ranges.upper_bound(begin);
+    if (itr != m_pinned_ranges.begin()) --itr;
+    for (; itr != m_pinned_ranges.end() && itr->first < end; ++itr) {
+      const auto b = std::max(itr->first, begin);
+      const auto e = std::min(itr->second, end);
+      if (b < e) {
+        succeeded &=
+            mdtl::os_mlock(static_cast<char *>(m_segment) + b, e - b);
+      }
+    }
+    return succeeded;
   }
 
-  bool priv_free_region(const std::ptrdiff_t offset,
-                        const std::size_t nbytes) const {
+  bool priv_free_region(std::ptrdiff_t offset, std::size_t nbytes,
+                        bool *zero_filled = nullptr) const {
+    if (zero_filled) *zero_filled = false;
     if (!is_open() || m_read_only) return false;
 
     if (offset + nbytes > m_current_segment_size) return false;
 
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
-    const auto block_no = offset / k_block_size;
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+    // Do not split huge pages; free only the huge pages fully covered
+    const std::ptrdiff_t end =
+        mdtl::round_down(offset + std::ptrdiff_t(nbytes), m_system_page_size);
+    offset = mdtl::round_up(offset, m_system_page_size);
+    if (offset >= end) return true;
+    // The pages at the ends are left as they are
+    if (std::size_t(end - offset) != nbytes) zero_filled = nullptr;
+    nbytes = end - offset;
+#endif
+
+    const auto block_no = priv_block_no(offset);
     assert(m_anonymous_map_flag_list.size() > block_no);
     if (m_anonymous_map_flag_list[block_no]) {
       return priv_uncommit_private_anonymous_pages(offset, nbytes);
     }
-#endif
+
+    if (m_volatile) {
+      const auto block_no = priv_block_no(offset);
+      if (m_block_fd_list[block_no] == -1 &&
+          std::size_t(offset) + nbytes <=
+              priv_block_offset(block_no) + priv_block_size(block_no)) {
+        // MADV_FREE does not zero the pages until they are reclaimed
+        return priv_uncommit_private_anonymous_pages(offset, nbytes);
+      }
+    }
 
     if (m_free_file_space)
-      return priv_uncommit_pages_and_free_file_space(offset, nbytes);
+      return priv_uncommit_pages_and_free_file_space(offset, nbytes,
+                                                     zero_filled);
     else
       return priv_uncommit_pages(offset, nbytes);
   }
 
-  bool priv_uncommit_pages_and_free_file_space(const std::ptrdiff_t offset,
-                                               const std::size_t nbytes) const {
+  bool priv_uncommit_pages_and_free_file_space(
+      const std::ptrdiff_t offset, const std::size_t nbytes,
+      bool *const zero_filled = nullptr) const {
     return mdtl::uncommit_shared_pages_and_free_file_space(
-        static_cast<char *>(m_segment) + offset, nbytes);
+        static_cast<char *>(m_segment) + offset, nbytes, zero_filled);
   }
 
   bool priv_uncommit_pages(const std::ptrdiff_t offset,
@@ -836,7 +3605,63 @@ class segment_storage {
         static_cast<char *>(m_segment) + offset, nbytes);
   }
 
-#ifdef METALL_USE_ANONYMOUS_NEW_MAP
+  // ---------- Write-back cache ---------- //
+  /// \brief Returns true if a new block is mapped anonymously.
+  bool priv_cache_new_block(const std::size_t block_size) const {
+    if (!m_write_back_cache) return false;
+    if (m_write_back_cache_budget == 0) return true;
+    return priv_anonymous_mapped_size() + block_size <=
+           m_write_back_cache_budget;
+  }
+
+  std::size_t priv_anonymous_mapped_size() const {
+    std::size_t size = 0;
+    for (std::size_t block_no = 0; block_no < m_anonymous_map_flag_list.size();
+         ++block_no) {
+      if (m_anonymous_map_flag_list[block_no]) {
+        size += priv_block_size(block_no);
+      }
+    }
+    return size;
+  }
+
+  bool priv_has_anonymous_blocks() const {
+    return std::any_of(m_anonymous_map_flag_list.begin(),
+                       m_anonymous_map_flag_list.end(),
+                       [](const int flag) { return flag; });
+  }
+
+  /// \brief Writes the pages of a block that are not zero to a new block
+  /// file, whose content is zero, so that the file stays sparse and the
+  /// pages never written are not written.
+  bool priv_write_nonzero_pages(const int fd, const std::size_t block_no) {
+    const auto *const block =
+        static_cast<const char *>(m_segment) + priv_block_offset(block_no);
+    const auto size = priv_block_size(block_no);
+    for (std::size_t pos = 0; pos < size;) {
+      if (priv_zero_page(block + pos)) {
+        pos += m_system_page_size;
+        continue;
+      }
+      auto end = pos + m_system_page_size;
+      while (end < size && !priv_zero_page(block + end)) {
+        end += m_system_page_size;
+      }
+      for (auto off = pos; off < end;) {
+        const auto written = ::pwrite(fd, block + off, end - off, off_t(off));
+        if (written <= 0) {
+          logger::perror(logger::level::error, __FILE__, __LINE__, "pwrite");
+          return false;
+        }
+        off += written;
+      }
+      pos = end;
+    }
+    return true;
+  }
+
+  /// \brief Writes a block mapped anonymously to its file and maps the file
+  /// at the same address instead.
   bool priv_sync_anonymous_map(const std::size_t block_no) {
     assert(m_anonymous_map_flag_list[block_no]);
     {
@@ -844,11 +3669,12 @@ class segment_storage {
       logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
     }
 
-    auto *const addr = static_cast<char *>(m_segment) + block_no * k_block_size;
-    if (::write(m_block_fd_list[block_no], addr, k_block_size) !=
-        (ssize_t)k_block_size) {
+    auto *const addr =
+        static_cast<char *>(m_segment) + priv_block_offset(block_no);
+    const auto block_size = priv_block_size(block_no);
+    if (!priv_write_nonzero_pages(m_block_fd_list[block_no], block_no)) {
       std::string s("Failed to write back a block");
-      logger::perror(logger::level::error, __FILE__, __LINE__, s.c_str());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
       priv_release_segment();
       priv_set_broken_status();
       return false;
@@ -867,7 +3693,7 @@ class segment_storage {
         0;
 #endif
     const auto mapped_addr =
-        mdtl::map_file_write_mode(m_block_fd_list[block_no], addr, k_block_size,
+        mdtl::map_file_write_mode(m_block_fd_list[block_no], addr, block_size,
                                   0, MAP_FIXED | map_nosync);
     if (!mapped_addr || mapped_addr != addr) {
       std::string s("Failed to map a block");
@@ -876,9 +3702,15 @@ class segment_storage {
       priv_set_broken_status();
       return false;
     }
+    priv_advise_huge_page(addr, block_size);
+    priv_apply_numa_policy(addr, block_size);
+    const auto block_offset = priv_block_offset(block_no);
+    if (!priv_repin(block_offset, block_offset + block_size)) {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "Failed to pin the pages of a remapped block again");
+    }
     return true;
   }
-#endif
 
   bool priv_set_system_page_size() {
     m_system_page_size = mdtl::get_page_size();
@@ -887,15 +3719,157 @@ class segment_storage {
                   "Failed to get system pagesize");
       return false;
     }
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+    if (k_huge_page_size % m_system_page_size != 0) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The huge page size must be a multiple of the system page "
+                  "size");
+      return false;
+    }
+    // Align the segment, blocks, and regions to free to the huge page size
+    m_system_page_size = k_huge_page_size;
+#endif
     return true;
   }
 
+  /// \brief Maps an anonymous region at 'addr'.
+  /// Tries to use huge pages first if METALL_SEGMENT_HUGE_PAGE_SIZE is
+  /// defined.
+  void *priv_map_anonymous_region(void *const addr,
+                                  const std::size_t length) const {
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+    if (auto *const huge_addr = mdtl::map_anonymous_huge_page_write_mode(
+            addr, length, k_huge_page_size, MAP_FIXED)) {
+      priv_apply_numa_policy(huge_addr, length);
+      return huge_addr;
+    }
+    logger::out(logger::level::verbose, __FILE__, __LINE__,
+                "Failed to map huge pages (MAP_HUGETLB); use transparent huge "
+                "pages instead");
+    auto *const mapped_addr =
+        mdtl::map_anonymous_write_mode(addr, length, MAP_FIXED);
+    if (mapped_addr) priv_advise_huge_page(mapped_addr, length);
+#else
+    auto *const mapped_addr =
+        mdtl::map_anonymous_write_mode(addr, length, MAP_FIXED);
+#endif
+    if (mapped_addr) priv_apply_numa_policy(mapped_addr, length);
+    return mapped_addr;
+  }
+
+  void priv_advise_huge_page([[maybe_unused]] void *const addr,
+                             [[maybe_unused]] const std::size_t length) const {
+#ifdef METALL_SEGMENT_HUGE_PAGE_SIZE
+    if (!mdtl::advise_huge_page(addr, length)) {
+      logger::out(logger::level::verbose, __FILE__, __LINE__,
+                  "Failed to advise transparent huge pages");
+    }
+#endif
+  }
+
+  /// \brief Sets the NUMA memory policy of a newly mapped region.
+  /// Must be called every time a region is mapped as a new map does not
+  /// inherit the policy of the old one.
+  /// Does nothing by default, i.e., first-touch.
+  void priv_apply_numa_policy([[maybe_unused]] void *const addr,
+                              [[maybe_unused]] const std::size_t length) const {
+#if defined(METALL_SEGMENT_NUMA_INTERLEAVE)
+    if (!mdtl::numa::interleave(addr, length)) {
+      logger::out(logger::level::warning, __FILE__, __LINE__,
+                  "Failed to interleave the segment over NUMA nodes");
+    }
+#elif defined(METALL_SEGMENT_NUMA_BIND_RANGE_SIZE)
+    const auto &nodes = mdtl::numa::allowed_nodes();
+    const auto begin =
+        static_cast<char *>(addr) - static_cast<char *>(m_segment);
+    const auto end = begin + std::ptrdiff_t(length);
+    for (auto pos = begin; pos < end;) {
+      const auto range_no = std::size_t(pos) / k_numa_bind_range_size;
+      const auto range_end = std::min(
+          end, std::ptrdiff_t((range_no + 1) * k_numa_bind_range_size));
+      const auto node = nodes[range_no % nodes.size()];
+      if (!mdtl::numa::bind(static_cast<char *>(m_segment) + pos,
+                            range_end - pos, node)) {
+        logger::out(logger::level::warning, __FILE__, __LINE__,
+                    "Failed to bind the segment to a NUMA node");
+        return;
+      }
+      pos = range_end;
+    }
+#endif
+  }
+
+  /// \brief The results of priv_test_file_space_free() per device, shared by
+  /// the segments in the process.
+  /// A result is a future so that the segments opened at the same time, e.g.,
+  /// by basic_manager::open_many(), wait for one test per device instead of
+  /// running their own: 1 or 0 is the result; -1 means the test failed.
+  struct file_space_free_cache {
+    std::mutex mutex;
+    std::map<mdtl::io_executor::device_id_type, std::shared_future<int>>
+        results;
+  };
+
+  static file_space_free_cache &priv_file_space_free_cache() {
+    static file_space_free_cache cache;
+    return cache;
+  }
+
+  /// \brief Tests if the file space can be freed, once per file system, as
+  /// the test creates, writes, and removes a file, which takes long on a file
+  /// system with slow metadata operations, e.g., when many processes create
+  /// datastores at once.
   bool priv_test_file_space_free(const path_type &top_path) {
 #ifdef METALL_DISABLE_FREE_FILE_SPACE
     m_free_file_space = false;
     return true;
 #endif
 
+    const auto device = mdtl::io_executor::get_device_id(top_path.c_str());
+    if (device == mdtl::io_executor::k_no_device) {
+      return priv_probe_file_space_free(top_path);
+    }
+
+    auto &cache = priv_file_space_free_cache();
+    std::promise<int> promise;
+    std::shared_future<int> result;
+    bool probe = false;
+    {
+      std::lock_guard<std::mutex> guard(cache.mutex);
+      auto itr = cache.results.find(device);
+      if (itr == cache.results.end()) {
+        itr = cache.results.emplace(device, promise.get_future().share()).first;
+        probe = true;
+      }
+      result = itr->second;
+    }
+
+    if (!probe) {
+      if (result.get() != -1) {
+        m_free_file_space = (result.get() == 1);
+        return true;
+      }
+      // The test by another segment failed; tries this top path
+      return priv_probe_file_space_free(top_path);
+    }
+
+    bool ret = false;
+    try {
+      ret = priv_probe_file_space_free(top_path);
+    } catch (...) {
+      promise.set_value(-1);
+      throw;
+    }
+    promise.set_value(ret ? int(m_free_file_space) : -1);
+    if (!ret) {
+      // Lets a later segment test again
+      std::lock_guard<std::mutex> guard(cache.mutex);
+      cache.results.erase(device);
+    }
+    return ret;
+  }
+
+  bool priv_probe_file_space_free(const path_type &top_path) {
     assert(m_system_page_size > 0);
     const path_type file_path(top_path.string() + "/test");
     const std::size_t file_size = m_system_page_size * 2;
@@ -951,21 +3925,69 @@ class segment_storage {
   // Private fields
   // -------------------- //
   ssize_t m_system_page_size{0};
+  std::size_t m_block_size{k_block_size};
   std::size_t m_num_blocks{0};
   std::size_t m_vm_region_size{0};
   std::size_t m_segment_capacity{0};
-  std::size_t m_current_segment_size{0};
+  // Atomic as size() can be called while another thread extends the segment
+  std::atomic<std::size_t> m_current_segment_size{0};
   void *m_vm_region{nullptr};
   void *m_segment{nullptr};
   segment_header_type *m_segment_header{nullptr};
   path_type m_top_path;
   bool m_read_only{false};
+  bool m_copy_on_write{false};
+  bool m_volatile{false};
   bool m_free_file_space{true};
   std::vector<int> m_block_fd_list;
+  // The offset of each block from the beginning of the segment
+  std::vector<std::size_t> m_block_offset_list;
+  // The pinned regions; [key, value) in offsets, not overlapping
+  std::map<std::size_t, std::size_t> m_pinned_ranges;
+  std::size_t m_pinned_size{0};
+  // The regions registered to CUDA; [key, value) in offsets, not overlapping
+  std::map<std::size_t, std::size_t> m_gpu_registered_ranges;
+  // True if all block files are mapped with MAP_SYNC
+  bool m_dax_mapped{false};
   bool m_broken{false};
 #ifdef METALL_USE_ANONYMOUS_NEW_MAP
+  bool m_write_back_cache{true};
+#else
+  bool m_write_back_cache{false};
+#endif
+  // If not 0, the max bytes of the blocks mapped anonymously at a time
+  std::size_t m_write_back_cache_budget{0};
+  // True if a block is mapped anonymously and written to its file at sync
   std::vector<int> m_anonymous_map_flag_list;
+  // Serializes extending the segment against persist(), which another thread
+  // can call concurrently, e.g., the checkpointing
+  std::mutex m_block_table_mutex;
+#ifdef METALL_ENABLE_INCREMENTAL_SYNC_IN_SEGMENT_STORAGE
+  std::unique_ptr<mdtl::soft_dirty_page_tracker> m_dirty_page_tracker{nullptr};
+#endif
+#ifdef METALL_ENABLE_SNAPSHOT_DELTA_IN_SEGMENT_STORAGE
+  // Tracks the pages written since the last snapshot; see snapshot_delta()
+  std::unique_ptr<mdtl::soft_dirty_page_tracker> m_snapshot_page_tracker{
+      nullptr};
+  // Tracks the pages written since the last replicate()
+  std::unique_ptr<mdtl::soft_dirty_page_tracker> m_replication_page_tracker{
+      nullptr};
 #endif
+  // The running asynchronous sync
+  std::future<void> m_async_sync;
+
+  struct preextended_block {
+    std::size_t block_no;
+    std::size_t offset;
+    std::size_t size;
+    std::future<bool> created;
+  };
+  // The blocks whose files are created ahead, in the block number order
+  std::deque<preextended_block> m_preextended_blocks;
+  // True if a block file has been renamed since the last sync
+  bool m_directory_sync_pending{false};
+  // The running prefaults of new blocks
+  std::vector<std::future<void>> m_prefaults;
 };
 
 }  // namespace metall::kernel
@@ -3,439 +3,457 @@
 //
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
-#ifndef METALL_DETAILL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
-#define METALL_DETAILL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
+#ifndef METALL_KERNEL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
+#define METALL_KERNEL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
 
-#ifndef _GNU_SOURCE
-#define _GNU_SOURCE
-#endif
+#include <sys/mman.h>
 
-// UMap SparseStore file granularity
-const size_t SPARSE_STORE_FILE_GRANULARITY_DEFAULT = 1073741824;
-
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <dirent.h>
+#include <cassert>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <umap/umap.h>
 #include <umap/store/SparseStore.h>
 
-#include <string>
-#include <iostream>
-#include <cassert>
 #include <metall/detail/file.hpp>
+#include <metall/detail/file_clone.hpp>
 #include <metall/detail/mmap.hpp>
 #include <metall/detail/utilities.hpp>
+#include <metall/logger.hpp>
+#include <metall/kernel/storage.hpp>
+#include <metall/kernel/segment_header.hpp>
 
-// #include "umap_sparse_store.hpp"
-
-namespace metall {
-namespace kernel {
+namespace metall::kernel {
 
 namespace {
 namespace mdtl = metall::mtlldetail;
 }
 
-template <typename different_type, typename size_type>
+/// \brief Segment storage that uses UMap's user-level paging and its
+/// SparseStore as the backing store.
+/// UMap is configured via its environment variables, e.g., UMAP_PAGESIZE
+/// (the UMap page size) and UMAP_PAGE_FILLERS (the number of the fill
+/// workers). The size of the SparseStore files can be changed via
+/// SPARSE_STORE_FILE_GRANULARITY.
+/// The segment is mapped when it is created or opened and is not extended.
 class umap_sparse_segment_storage {
+ private:
+  static constexpr const char *k_dir_name = "umap_sparse_segment";
+  static constexpr std::size_t k_default_file_granularity = 1ULL << 30ULL;
+
  public:
-  // -------------------- //
-  // Constructor & assign operator
-  // -------------------- //
-  umap_sparse_segment_storage()
-      : m_umap_page_size(0),
-        m_vm_region_size(0),
-        m_segment_size(0),
-        m_segment(nullptr),
-        m_base_path(),
-        m_read_only(),
-        m_free_file_space(true) {
-    if (!priv_load_umap_page_size()) {
-      std::abort();
+  using path_type = storage::path_type;
+  using segment_header_type = segment_header;
+
+  umap_sparse_segment_storage() {
+    if (!priv_load_page_sizes()) {
+      m_broken = true;
     }
   }
 
   ~umap_sparse_segment_storage() {
-    priv_sync_segment(true);
-    destroy();
+    if (is_open()) {
+      sync(true);
+      release();
+    }
   }
 
   umap_sparse_segment_storage(const umap_sparse_segment_storage &) = delete;
   umap_sparse_segment_storage &operator=(const umap_sparse_segment_storage &) =
       delete;
+  umap_sparse_segment_storage(umap_sparse_segment_storage &&) = delete;
+  umap_sparse_segment_storage &operator=(umap_sparse_segment_storage &&) =
+      delete;
 
-  umap_sparse_segment_storage(umap_sparse_segment_storage &&other) noexcept
-      : m_umap_page_size(other.m_umap_page_size),
-        m_vm_region_size(other.m_vm_region_size),
-        m_segment_size(other.m_segment_size),
-        m_segment(other.m_segment),
-        m_base_path(other.m_base_path),
-        m_read_only(other.m_read_only),
-        m_free_file_space(other.m_free_file_space) {
-    other.priv_reset();
-  }
-
-  umap_sparse_segment_storage &operator=(
-      umap_sparse_segment_storage &&other) noexcept {
-    m_umap_page_size = other.m_umap_page_size;
-    m_vm_region_size = other.m_vm_region_size;
-    m_segment_size = other.m_segment_size;
-    m_segment = other.m_segment;
-    m_base_path = other.m_base_path;
-    m_read_only = other.m_read_only;
-    m_free_file_space = other.m_free_file_space;
-
-    other.priv_reset();
-
-    return (*this);
+  /// \brief Copies segment to another location.
+  /// \param source_path A path to a source segment.
+  /// \param destination_path A destination path.
+  /// \param clone If true, uses clone (reflink) for copying files.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  static bool copy(const path_type &source_path,
+                   const path_type &destination_path, const bool clone,
+                   const int max_num_threads) {
+    return priv_copy(priv_top_dir_path(source_path),
+                     priv_top_dir_path(destination_path), clone,
+                     max_num_threads);
   }
 
-  // -------------------- //
-  // Public methods
-  // -------------------- //
-  /// \brief Check if there is a file that can be opened
-  static bool openable(const std::string &base_path) {
-    return mdtl::file_exist(priv_make_file_name(base_path));
+  /// \brief Creates a new segment.
+  /// Calling this function fails if this class already manages an opened
+  /// segment.
+  /// \base_path A base directory path to create a segment.
+  /// \param capacity A segment capacity to reserve.
+  /// The whole capacity is mapped at once.
+  /// Return true if success; otherwise, false.
+  bool create(const path_type &base_path, const std::size_t capacity) {
+    return priv_create(priv_top_dir_path(base_path), capacity);
   }
 
-  /// \brief Gets the size of an existing segment.
-  /// This is a static version of size() method.
-  static size_type get_size(const std::string &base_path) {
-    const auto directory_name = priv_make_file_name(base_path);
-    return Umap::SparseStore::get_capacity(directory_name);
+  /// \brief Opens an existing segment.
+  /// Calling this function fails if this class already manages an opened
+  /// segment.
+  /// \param base_path A base directory path to open a segment.
+  /// \param capacity Not used; the segment cannot be extended.
+  /// \param read_only If true, this segment is read only.
+  /// \return Return true if success; otherwise, false.
+  bool open(const path_type &base_path,
+            [[maybe_unused]] const std::size_t capacity,
+            const bool read_only) {
+    return priv_open(priv_top_dir_path(base_path), read_only);
   }
 
-  /// \brief Copies segment to another location.
-  static bool copy(const std::string &source_path,
-                   const std::string &destination_path, const bool clone,
-                   [[maybe_unused]] const int max_num_threads) {
-    // TODO: implement parallel copy version
-
-    if (clone) {
-      std::string s("Clone: " + source_path);
-      logger::out(logger::level::info, __FILE__, __LINE__, s.c_str());
-      return mdtl::clone_file(source_path, destination_path);
-    } else {
-      std::string s("Copy: " + source_path);
-      logger::out(logger::level::info, __FILE__, __LINE__, s.c_str());
-      return mdtl::copy_file(source_path, destination_path);
-    }
-    assert(false);
+  /// \brief The copy-on-write mode is not supported.
+  /// \return Always returns false.
+  bool open_copy_on_write(const path_type &, const std::size_t) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "The copy-on-write mode is not supported");
     return false;
   }
 
-  /// \brief Creates a new segment by mapping file(s) to the given VM address.
-  /// \param base_path A path to create a datastore.
-  /// \param vm_region_size The size of the VM region.
-  /// \param vm_region The address of the VM region.
-  /// \param initial_segment_size_hint Not used.
-  /// \return Returns true on success; otherwise, false.
-  bool create(const std::string &base_path, const size_type vm_region_size,
-              void *const vm_region,
-              [[maybe_unused]] const size_type initial_segment_size_hint) {
-    assert(!priv_inited());
-
-    // TODO: align those values to the page size instead of aborting
-    if (vm_region_size % page_size() != 0 ||
-        (uint64_t)vm_region % page_size() != 0) {
-      std::cerr << "Invalid argument to crete application data segment"
-                << std::endl;
-      std::abort();
-    }
-
-    m_base_path = base_path;
-    m_vm_region_size = vm_region_size;
-    m_segment = vm_region;
-    m_read_only = false;
-
-    const auto segment_size = vm_region_size;
-    if (!priv_create_and_map_file(m_base_path, segment_size, m_segment)) {
-      priv_reset();
+  /// \brief Checks if the segment is large enough.
+  /// The segment is never extended as the whole capacity is mapped when it is
+  /// created.
+  /// \param request_size A segment size to extend to.
+  /// \return Returns true if the segment is already larger than the requested
+  /// size. Returns false on failure.
+  bool extend(const std::size_t request_size) {
+    if (!is_open() || m_read_only) return false;
+    if (request_size > m_current_segment_size) {
+      std::stringstream ss;
+      ss << "Cannot extend a UMap segment to " << request_size << " bytes";
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
       return false;
     }
-    m_segment_size += segment_size;
-
-    priv_test_file_space_free(base_path);
-
     return true;
   }
 
-  /// \brief Opens an existing Metall datastore.
-  /// \param base_path The path to datastore.
-  /// \param vm_region_size The size of the VM region.
-  /// \param vm_region The address of the VM region.
-  /// \param read_only If this option is true, opens the datastore with read
-  /// only mode. \return Returns true on success; otherwise, false.
-  bool open(const std::string &base_path, const size_type vm_region_size,
-            void *const vm_region, const bool read_only) {
-    assert(!priv_inited());
-    // TODO: align those values to pge size
-    if (vm_region_size % page_size() != 0 ||
-        (uint64_t)vm_region % page_size() != 0) {
-      std::cerr << "Invalid argument to open segment" << std::endl;
-      std::abort();  // Fatal error
-    }
-
-    m_base_path = base_path;
-    m_vm_region_size = vm_region_size;
-    m_segment = vm_region;
-    m_read_only = read_only;
+  /// \brief Releases the segment --- the data will be lost.
+  /// To save data to files, sync() must be called beforehand.
+  bool release() { return priv_release(); }
 
-    const auto file_name = priv_make_file_name(m_base_path);
-    if (!mdtl::file_exist(file_name)) {
-      std::cerr << "Segment file does not exist" << std::endl;
-      return false;
-    }
-
-    // store = new Umap::SparseStore(file_name,read_only);
-    m_segment_size = get_size(base_path);  // store->get_current_capacity();
-    assert(m_segment_size % page_size() == 0);
-    if (!priv_map_file_open(file_name, m_segment_size,
-                            static_cast<char *>(m_segment),
-                            read_only)) {  // , store)) {
-      std::abort();                        // Fatal error
-    }
+  /// \brief Flushes the dirty UMap pages to the SparseStore files.
+  /// \param sync Not used; this function always waits for the flush.
+  bool sync([[maybe_unused]] const bool sync) { return priv_sync(); }
 
-    if (!read_only) {
-      priv_test_file_space_free(base_path);
-    }
+  /// \brief Flushes the dirty UMap pages in the background.
+  /// \param max_num_threads Not used; UMap uses its own evictors.
+  /// \return Returns an object of std::future.
+  /// If succeeded, its get() returns true; otherwise, false.
+  std::future<bool> sync_async([[maybe_unused]] const int max_num_threads) {
+    return std::async(std::launch::async, [this]() { return priv_sync(); });
+  }
 
-    return true;
+  /// \brief UMap cannot free a region of the SparseStore files.
+  /// \param offset An offset to the region from the beginning of the segment.
+  /// \param nbytes The size of the region.
+  /// \return Returns true if the region is in the segment; otherwise, false.
+  bool free_region(const std::ptrdiff_t offset, const std::size_t nbytes) {
+    if (!is_open() || m_read_only) return false;
+    return offset >= 0 &&
+           static_cast<std::size_t>(offset) + nbytes <= m_current_segment_size;
   }
 
-  /// \brief This function does nothing in this implementation.
-  /// \param new_segment_size Not used.
-  /// \return Always returns true.
-  bool extend(const size_type new_segment_size) {
-    assert(priv_inited());
+  /// \brief Takes a snapshot of the segment.
+  /// \param snapshot_path A path to a snapshot.
+  /// \param clone If true, uses clone (reflink) for copying files.
+  /// \param max_num_threads The maximum number of threads to use.
+  /// If <= 0 is given, the value is automatically determined.
+  /// \return Return true if success; otherwise, false.
+  bool snapshot(const path_type &snapshot_path, const bool clone,
+                const int max_num_threads) {
+    if (!sync(true)) return false;
+    return priv_copy(m_top_path, priv_top_dir_path(snapshot_path), clone,
+                     max_num_threads);
+  }
 
-    if (m_read_only) {
-      return false;
-    }
+  /// \brief Returns the address of the segment.
+  void *get_segment() const { return m_segment; }
 
-    if (new_segment_size > m_vm_region_size) {
-      std::cerr << "Requested segment size is bigger than the reserved VM size"
-                << std::endl;
-      return false;
-    }
-    if (new_segment_size > m_segment_size) {
-      std::cerr << "Requested segment size is too big" << std::endl;
-      return false;
-    }
+  /// \brief Returns a reference to the segment header.
+  segment_header_type &get_segment_header() {
+    return *reinterpret_cast<segment_header_type *>(m_vm_region);
+  }
 
-    return true;
+  /// \brief Returns a reference to the segment header.
+  const segment_header_type &get_segment_header() const {
+    return *reinterpret_cast<const segment_header_type *>(m_vm_region);
   }
 
-  /// \brief Destroy (unmap) the segment.
-  void destroy() { priv_destroy_segment(); }
+  /// \brief Returns the current segment size.
+  std::size_t size() const { return m_current_segment_size; }
 
-  /// \brief Syncs the segment (files) with the storage.
-  /// \param sync Not used.
-  void sync(const bool sync) { priv_sync_segment(sync); }
+  /// \brief Returns the system page size.
+  /// The UMap page size is returned by umap_page_size().
+  std::size_t page_size() const { return m_system_page_size; }
 
-  /// \brief This function does nothing.
-  /// \param offset Not used.
-  /// \param nbytes Not used.
-  void free_region(const different_type offset, const size_type nbytes) {
-    priv_free_region(offset, nbytes);
-  }
+  /// \brief Returns the UMap page size.
+  std::size_t umap_page_size() const { return m_umap_page_size; }
 
-  /// \brief Returns the address of the segment.
-  /// \return The address of the segment.
-  void *get_segment() const { return m_segment; }
+  /// \brief Checks if the segment is read only.
+  bool read_only() const { return m_read_only; }
 
-  /// \brief Returns the size of the segment.
-  /// \return The size of the segment.
-  size_type size() const { return m_segment_size; }
+  /// \brief Always returns false as the copy-on-write mode is not supported.
+  bool copy_on_write() const { return false; }
 
-  /// \brief Returns the Umap page size.
-  /// \return The current Umap page size.
-  size_type page_size() const { return m_umap_page_size; }
+  /// \brief Incremental snapshots are not supported.
+  /// \return Always returns false.
+  static bool resolve_snapshot_delta(const path_type &,
+                                     const std::vector<path_type> &,
+                                     const int) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Incremental snapshots are not supported");
+    return false;
+  }
 
-  /// \brief Returns whether the segment is read only or not.
-  /// \return Returns true if it is read only; otherwise, false.
-  bool read_only() const { return m_read_only; }
+  /// \brief Checks if there is a segment already open.
+  bool is_open() const { return !m_broken && !!m_store && m_segment; }
+
+  /// \brief Checks the sanity of the instance.
+  /// \return Returns true if there is no issue; otherwise, returns false.
+  bool check_sanity() const { return !m_broken; }
 
  private:
-  // -------------------- //
-  // Private types and static values
-  // -------------------- //
-
-  // -------------------- //
-  // Private methods (not designed to be used by the base class)
-  // -------------------- //
-  static std::string priv_make_file_name(const std::string &base_path) {
-    return base_path + "_umap_sparse_segment_file";
+  static path_type priv_top_dir_path(const path_type &base_path) {
+    return storage::get_path(base_path, k_dir_name);
   }
 
-  void priv_reset() {
-    m_umap_page_size = 0;
-    m_vm_region_size = 0;
-    m_segment_size = 0;
-    m_segment = nullptr;
-    // m_read_only = false;
+  static std::size_t priv_file_granularity() {
+    const char *const str = std::getenv("SPARSE_STORE_FILE_GRANULARITY");
+    if (!str) return k_default_file_granularity;
+    const auto granularity = std::strtoull(str, nullptr, 10);
+    return (granularity > 0) ? granularity : k_default_file_granularity;
   }
 
-  bool priv_inited() const {
-    return (m_umap_page_size > 0 && m_vm_region_size > 0 &&
-            m_segment_size > 0 && m_segment && !m_base_path.empty());
+  static bool priv_copy(const path_type &source_path,
+                        const path_type &destination_path, const bool clone,
+                        const int max_num_threads) {
+    if (!mdtl::directory_exist(destination_path)) {
+      if (!mdtl::create_directory(destination_path)) {
+        std::string s("Cannot create a directory: " +
+                      destination_path.string());
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
+      }
+    }
+
+    if (clone) {
+      std::string s("Clone: " + source_path.string());
+      logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
+      return mdtl::clone_files_in_directory_in_parallel(
+          source_path, destination_path, max_num_threads);
+    }
+    std::string s("Copy: " + source_path.string());
+    logger::out(logger::level::verbose, __FILE__, __LINE__, s.c_str());
+    return mdtl::copy_files_in_directory_in_parallel(
+        source_path, destination_path, max_num_threads);
   }
 
-  bool priv_create_and_map_file(const std::string &base_path,
-                                const size_type file_size,
-                                void *const addr) const {
-    assert(!m_segment ||
-           static_cast<char *>(m_segment) + m_segment_size <= addr);
+  bool priv_load_page_sizes() {
+    const auto system_page_size = mdtl::get_page_size();
+    if (system_page_size <= 0) {
+      logger::out(logger::level::critical, __FILE__, __LINE__,
+                  "Failed to get the system page size");
+      return false;
+    }
+    m_system_page_size = system_page_size;
 
-    const std::string file_name = priv_make_file_name(base_path);
-    if (!priv_map_file_create(file_name, file_size, addr)) {
+    m_umap_page_size = ::umapcfg_get_umap_page_size();
+    if (m_umap_page_size == 0 || m_umap_page_size % m_system_page_size != 0) {
+      logger::out(logger::level::critical, __FILE__, __LINE__,
+                  "Invalid UMap page size");
       return false;
     }
+
+    std::stringstream ss;
+    ss << "UMap page size " << m_umap_page_size << ", fill workers "
+       << ::umapcfg_get_num_fillers();
+    logger::out(logger::level::verbose, __FILE__, __LINE__, ss.str().c_str());
     return true;
   }
 
-  size_t priv_get_sparsestore_file_granularity() const {
-    char *file_granularity_str = getenv("SPARSE_STORE_FILE_GRANULARITY");
-    size_t file_granularity;
-    if (file_granularity_str == NULL) {
-      file_granularity = SPARSE_STORE_FILE_GRANULARITY_DEFAULT;
-    } else {
-      file_granularity = (size_t)std::stol(file_granularity_str);
-    }
-    return file_granularity;
+  std::size_t priv_header_size() const {
+    return mdtl::round_up(sizeof(segment_header_type),
+                          int64_t(m_umap_page_size));
   }
 
-  bool priv_map_file_create(const std::string &path, const size_type file_size,
-                            void *const addr) const {
-    assert(!path.empty());
-    assert(file_size > 0);
-    assert(addr);
-
-    size_t sparse_file_granularity = priv_get_sparsestore_file_granularity();
-    size_t page_size = umapcfg_get_umap_page_size();
-    if (page_size == -1) {
-      ::perror("umapcfg_get_umap_page_size failed");
-      std::cerr << "errno: " << errno << std::endl;
+  /// \brief Reserves a VM region and constructs the segment header at the
+  /// beginning of it. The segment follows the header.
+  bool priv_prepare_header_and_segment(const std::size_t segment_size) {
+    const auto header_size = priv_header_size();
+    m_vm_region_size = header_size + segment_size;
+    m_vm_region =
+        mdtl::reserve_aligned_vm_region(m_umap_page_size, m_vm_region_size);
+    if (!m_vm_region) {
+      std::stringstream ss;
+      ss << "Cannot reserve a VM region " << m_vm_region_size << " bytes";
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      m_vm_region_size = 0;
+      return false;
     }
 
-    store = new Umap::SparseStore(file_size, page_size, path,
-                                  sparse_file_granularity);
-
-    const int prot = PROT_READ | PROT_WRITE;
-    const int flags = UMAP_PRIVATE | MAP_FIXED;
-    void *const region =
-        Umap::umap_ex(addr, file_size, prot, flags, -1, 0, store);
-    if (region == UMAP_FAILED) {
-      std::ostringstream ss;
-      ss << "umap_mf of " << file_size << " bytes failed for " << path;
-      perror(ss.str().c_str());
+    if (mdtl::map_anonymous_write_mode(m_vm_region, header_size, MAP_FIXED) !=
+        m_vm_region) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot allocate segment header");
+      priv_release_vm_region();
       return false;
     }
+    new (m_vm_region) segment_header_type();
+    m_segment = static_cast<char *>(m_vm_region) + header_size;
 
     return true;
   }
 
-  bool priv_map_file_open(const std::string &path, const size_type file_size,
-                          void *const addr, const bool read_only) {
-    assert(!path.empty());
-    assert(addr);
-
-    // MEMO: one of the following options does not work on /tmp?
-
-    size_t page_size = umapcfg_get_umap_page_size();
-    if (page_size == -1) {
-      ::perror("umapcfg_get_umap_page_size failed");
-      std::cerr << "errno: " << errno << std::endl;
+  bool priv_release_vm_region() {
+    if (!m_vm_region) return true;
+    std::destroy_at(reinterpret_cast<segment_header_type *>(m_vm_region));
+    const bool ret = mdtl::munmap(m_vm_region, m_vm_region_size, false);
+    if (!ret) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to release the VM region");
     }
+    m_vm_region = nullptr;
+    m_vm_region_size = 0;
+    m_segment = nullptr;
+    return ret;
+  }
 
-    store = new Umap::SparseStore(path, read_only);
-    uint64_t region_size = file_size;
-
+  bool priv_map_store(const bool read_only) {
     const int prot = PROT_READ | (read_only ? 0 : PROT_WRITE);
-    const int flags = UMAP_PRIVATE | MAP_FIXED;
-    void *const region =
-        Umap::umap_ex(addr, region_size, prot, flags, -1, 0, store);
-    if (region == UMAP_FAILED) {
-      std::ostringstream ss;
-      ss << "umap_mf of " << region_size << " bytes failed for " << path;
-      perror(ss.str().c_str());
+    const int flags = UMAP_PRIVATE | UMAP_FIXED;
+    if (Umap::umap_ex(m_segment, m_current_segment_size, prot, flags, -1, 0,
+                      m_store.get()) == UMAP_FAILED) {
+      std::stringstream ss;
+      ss << "Failed to map " << m_current_segment_size << " bytes with UMap "
+         << m_top_path;
+      logger::perror(logger::level::error, __FILE__, __LINE__,
+                     ss.str().c_str());
       return false;
     }
-
     return true;
   }
 
-  void priv_unmap_file() {
-    const auto file_name = priv_make_file_name(m_base_path);
-    assert(mdtl::file_exist(file_name));
+  bool priv_create(const path_type &top_path, const std::size_t capacity) {
+    if (!check_sanity()) return false;
+    if (is_open()) return false;
 
-    if (::uunmap(static_cast<char *>(m_segment), m_segment_size) != 0) {
-      std::cerr << "Failed to unmap a Umap region" << std::endl;
-      std::abort();
+    const auto segment_size = mdtl::round_up(
+        static_cast<int64_t>(capacity), static_cast<int64_t>(m_umap_page_size));
+    if (!priv_prepare_header_and_segment(segment_size)) {
+      return false;
     }
-
-    m_segment_size = 0;
-    int sparse_store_close_files = store->close_files();
-    if (sparse_store_close_files != 0) {
-      std::cerr << "Error closing SparseStore files" << std::endl;
-      delete store;
-      std::abort();
+    m_top_path = top_path;
+    m_read_only = false;
+    m_current_segment_size = segment_size;
+
+    m_store = std::make_unique<Umap::SparseStore>(
+        segment_size, m_umap_page_size, m_top_path.string(),
+        priv_file_granularity());
+    if (!priv_map_store(false)) {
+      m_store.reset();
+      priv_release_vm_region();
+      priv_clear_status();
+      return false;
     }
-    delete store;
-  }
-
-  void priv_destroy_segment() {
-    if (!priv_inited()) return;
 
-    priv_unmap_file();
-
-    priv_reset();
+    return true;
   }
 
-  void priv_sync_segment([[maybe_unused]] const bool sync) {
-    if (!priv_inited() || m_read_only) return;
+  bool priv_open(const path_type &top_path, const bool read_only) {
+    if (!check_sanity()) return false;
+    if (is_open()) return false;
 
-    if (::umap_flush() != 0) {
-      std::cerr << "Failed umap_flush()" << std::endl;
+    if (!mdtl::directory_exist(top_path)) {
+      std::string s("Segment directory does not exist: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
     }
-  }
 
-  // MEMO: Umap cannot free file region
-  bool priv_free_region(const different_type offset, const size_type nbytes) {
-    if (!priv_inited() || m_read_only) return false;
-
-    if (offset + nbytes > m_segment_size) return false;
+    const std::size_t segment_size =
+        Umap::SparseStore::get_capacity(top_path.string());
+    if (segment_size == 0 || segment_size % m_umap_page_size != 0) {
+      std::string s("Invalid segment size: " + top_path.string());
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    if (!priv_prepare_header_and_segment(segment_size)) {
+      return false;
+    }
+    m_top_path = top_path;
+    m_read_only = read_only;
+    m_current_segment_size = segment_size;
+
+    m_store =
+        std::make_unique<Umap::SparseStore>(m_top_path.string(), read_only);
+    if (!priv_map_store(read_only)) {
+      m_store.reset();
+      priv_release_vm_region();
+      priv_clear_status();
+      return false;
+    }
 
     return true;
   }
 
-  bool priv_load_umap_page_size() {
-    m_umap_page_size = ::umapcfg_get_umap_page_size();
-    if (m_umap_page_size == -1) {
-      std::cerr << "Failed to get system pagesize" << std::endl;
+  bool priv_sync() {
+    if (!is_open() || m_read_only) return true;
+    if (::umap_flush() != 0) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to flush the UMap pages");
       return false;
     }
     return true;
   }
 
-  void priv_test_file_space_free(const std::string &) {
-    m_free_file_space = false;
+  bool priv_release() {
+    if (!is_open()) return true;
+
+    bool ret = true;
+    if (::uunmap(m_segment, m_current_segment_size) != 0) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to unmap the UMap region");
+      ret = false;
+    }
+    if (m_store->close_files() != 0) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to close the SparseStore files");
+      ret = false;
+    }
+    m_store.reset();
+    ret &= priv_release_vm_region();
+    priv_clear_status();
+    if (!ret) m_broken = true;
+
+    return ret;
+  }
+
+  void priv_clear_status() {
+    m_vm_region = nullptr;
+    m_vm_region_size = 0;
+    m_segment = nullptr;
+    m_current_segment_size = 0;
+    m_top_path.clear();
+    // m_read_only must not be modified here.
   }
 
-  // -------------------- //
-  // Private fields
-  // -------------------- //
-  ssize_t m_umap_page_size{0};
-  size_type m_vm_region_size{0};
-  size_type m_segment_size{0};
+  std::size_t m_system_page_size{0};
+  std::size_t m_umap_page_size{0};
+  void *m_vm_region{nullptr};
+  std::size_t m_vm_region_size{0};
   void *m_segment{nullptr};
-  std::string m_base_path;
-  bool m_read_only;
-  bool m_free_file_space{true};
-  mutable Umap::SparseStore *store;
+  std::size_t m_current_segment_size{0};
+  path_type m_top_path{};
+  bool m_read_only{false};
+  bool m_broken{false};
+  std::unique_ptr<Umap::SparseStore> m_store{nullptr};
 };
 
-}  // namespace kernel
-}  // namespace metall
+}  // namespace metall::kernel
 
-#endif  // METALL_DETAILL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
+#endif  // METALL_KERNEL_SEGMENT_STORAGE_UMAP_SPARSE_SEGMENT_STORAGE_HPP
@@ -0,0 +1,236 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_SEGMENT_STORAGE_CONCEPT_HPP
+#define METALL_KERNEL_SEGMENT_STORAGE_CONCEPT_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace metall::kernel {
+
+namespace sscdtl {
+
+template <typename T, typename = void>
+struct has_types : std::false_type {};
+
+template <typename T>
+struct has_types<T, std::void_t<typename T::path_type,
+                                typename T::segment_header_type>>
+    : std::true_type {};
+
+// Functions that manager_kernel and segment_allocator always use.
+// The functions used only by optional features (e.g., sync_async(), pin())
+// are checked when they are called.
+template <typename T, typename = void>
+struct has_functions : std::false_type {};
+
+template <typename T>
+struct has_functions<
+    T,
+    std::void_t<
+        decltype(T::copy(std::declval<const typename T::path_type &>(),
+                         std::declval<const typename T::path_type &>(),
+                         std::declval<bool>(), std::declval<int>())),
+        decltype(T::resolve_snapshot_delta(
+            std::declval<const typename T::path_type &>(),
+            std::declval<const std::vector<typename T::path_type> &>(),
+            std::declval<int>())),
+        decltype(std::declval<T &>().create(
+            std::declval<const typename T::path_type &>(),
+            std::declval<std::size_t>())),
+        decltype(std::declval<T &>().open(
+            std::declval<const typename T::path_type &>(),
+            std::declval<std::size_t>(), std::declval<bool>())),
+        decltype(std::declval<T &>().open_copy_on_write(
+            std::declval<const typename T::path_type &>(),
+            std::declval<std::size_t>())),
+        decltype(std::declval<T &>().extend(std::declval<std::size_t>())),
+        decltype(std::declval<T &>().release()),
+        decltype(std::declval<T &>().sync(std::declval<bool>())),
+        decltype(std::declval<T &>().free_region(
+            std::declval<std::ptrdiff_t>(), std::declval<std::size_t>())),
+        decltype(std::declval<T &>().snapshot(
+            std::declval<const typename T::path_type &>(),
+            std::declval<bool>(), std::declval<int>())),
+        decltype(std::declval<const T &>().get_segment()),
+        decltype(std::declval<const T &>().get_segment_header()),
+        decltype(std::declval<const T &>().size()),
+        decltype(std::declval<const T &>().page_size()),
+        decltype(std::declval<const T &>().read_only()),
+        decltype(std::declval<const T &>().copy_on_write()),
+        decltype(std::declval<const T &>().is_open()),
+        decltype(std::declval<const T &>().check_sanity())>>
+    : std::bool_constant<
+          std::is_convertible_v<
+              decltype(std::declval<T &>().create(
+                  std::declval<const typename T::path_type &>(),
+                  std::declval<std::size_t>())),
+              bool> &&
+          std::is_convertible_v<
+              decltype(std::declval<T &>().open(
+                  std::declval<const typename T::path_type &>(),
+                  std::declval<std::size_t>(), std::declval<bool>())),
+              bool> &&
+          std::is_convertible_v<decltype(std::declval<T &>().extend(
+                                    std::declval<std::size_t>())),
+                                bool> &&
+          std::is_convertible_v<
+              decltype(std::declval<const T &>().get_segment()), void *> &&
+          std::is_convertible_v<
+              decltype(std::declval<const T &>().get_segment_header()),
+              const typename T::segment_header_type &> &&
+          std::is_convertible_v<decltype(std::declval<const T &>().size()),
+                                std::size_t>> {};
+
+template <typename T, typename = void>
+struct has_block_size_option : std::false_type {};
+
+template <typename T>
+struct has_block_size_option<
+    T, std::void_t<decltype(std::declval<T &>().set_block_size(
+           std::declval<std::size_t>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_live_read_only_mode : std::false_type {};
+
+template <typename T>
+struct has_live_read_only_mode<
+    T, std::void_t<decltype(std::declval<T &>().open_live_read_only(
+                       std::declval<const typename T::path_type &>(),
+                       std::declval<std::size_t>(),
+                       std::declval<std::size_t>())),
+                   decltype(std::declval<T &>().map_new_blocks(
+                       std::declval<std::size_t>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_replication : std::false_type {};
+
+template <typename T>
+struct has_replication<
+    T, std::void_t<decltype(std::declval<T &>().replicate(
+                       std::declval<std::ostream &>(), std::declval<bool>())),
+                   decltype(std::declval<const T &>().replication_tracked()),
+                   decltype(T::apply_replication(
+                       std::declval<const typename T::path_type &>(),
+                       std::declval<std::istream &>(),
+                       std::declval<bool>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_zero_filled_free_region : std::false_type {};
+
+template <typename T>
+struct has_zero_filled_free_region<
+    T, std::void_t<decltype(std::declval<T &>().free_region(
+           std::declval<std::ptrdiff_t>(), std::declval<std::size_t>(),
+           std::declval<bool *>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_direct_io_snapshot : std::false_type {};
+
+template <typename T>
+struct has_direct_io_snapshot<
+    T, std::void_t<decltype(std::declval<T &>().snapshot_direct(
+           std::declval<const typename T::path_type &>(),
+           std::declval<int>()))>> : std::true_type {};
+
+template <typename T, typename = void>
+struct has_write_back_cache : std::false_type {};
+
+template <typename T>
+struct has_write_back_cache<
+    T, std::void_t<decltype(std::declval<T &>().set_write_back_cache(
+                       std::declval<bool>(), std::declval<std::size_t>())),
+                   decltype(std::declval<const T &>().write_back_cache())>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct has_volatile_mode : std::false_type {};
+
+template <typename T>
+struct has_volatile_mode<
+    T, std::void_t<decltype(std::declval<T &>().create_volatile(
+                       std::declval<const typename T::path_type &>(),
+                       std::declval<std::size_t>())),
+                   decltype(std::declval<const T &>().volatile_segment()),
+                   decltype(std::declval<T &>().spill(
+                       std::declval<std::size_t>(),
+                       std::declval<std::size_t *>()))>> : std::true_type {};
+
+template <typename T, bool = has_types<T>::value>
+struct is_segment_storage_impl : std::false_type {};
+
+template <typename T>
+struct is_segment_storage_impl<T, true> : has_functions<T> {};
+
+}  // namespace sscdtl
+
+/// \brief Checks if a type meets the requirements of segment storage, i.e.,
+/// the interface of metall::kernel::segment_storage that Metall's manager
+/// uses.
+/// A segment storage must have the following members:
+/// path_type, segment_header_type, copy(), resolve_snapshot_delta(),
+/// create(), open(), open_copy_on_write(), extend(), release(), sync(),
+/// free_region(), snapshot(), get_segment(), get_segment_header(), size(),
+/// page_size(), read_only(), copy_on_write(), is_open(), and check_sanity().
+/// \tparam T A type to check.
+template <typename T>
+struct is_segment_storage : sscdtl::is_segment_storage_impl<T> {};
+
+/// \brief Helper variable template of is_segment_storage.
+template <typename T>
+inline constexpr bool is_segment_storage_v = is_segment_storage<T>::value;
+
+/// \brief True if a segment storage has the optional set_block_size(), which
+/// takes manager_options::segment_block_size.
+template <typename T>
+inline constexpr bool has_block_size_option_v =
+    sscdtl::has_block_size_option<T>::value;
+
+/// \brief True if a segment storage has the optional open_live_read_only()
+/// and map_new_blocks(), which the live read-only mode of the manager uses.
+template <typename T>
+inline constexpr bool has_live_read_only_mode_v =
+    sscdtl::has_live_read_only_mode<T>::value;
+
+/// \brief True if a segment storage has the optional replicate(),
+/// replication_tracked(), and apply_replication(), which the replication of
+/// the manager uses.
+template <typename T>
+inline constexpr bool has_replication_v = sscdtl::has_replication<T>::value;
+
+/// \brief True if a segment storage has the optional free_region() overload
+/// that tells whether the freed region reads as zeros, which the allocator
+/// uses to skip zero-filling reused memory.
+template <typename T>
+inline constexpr bool has_zero_filled_free_region_v =
+    sscdtl::has_zero_filled_free_region<T>::value;
+
+/// \brief True if a segment storage has the optional snapshot_direct(),
+/// which manager_options::direct_io_snapshot uses.
+template <typename T>
+inline constexpr bool has_direct_io_snapshot_v =
+    sscdtl::has_direct_io_snapshot<T>::value;
+
+/// \brief True if a segment storage has the optional set_write_back_cache()
+/// and write_back_cache(), which manager_options::write_back_cache uses.
+template <typename T>
+inline constexpr bool has_write_back_cache_v =
+    sscdtl::has_write_back_cache<T>::value;
+
+/// \brief True if a segment storage has the optional create_volatile(),
+/// volatile_segment(), and spill(), which manager_options::volatile_segment
+/// uses.
+template <typename T>
+inline constexpr bool has_volatile_mode_v =
+    sscdtl::has_volatile_mode<T>::value;
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_SEGMENT_STORAGE_CONCEPT_HPP
@@ -0,0 +1,162 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_SLOT_BITMAP_POOL_HPP
+#define METALL_KERNEL_SLOT_BITMAP_POOL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <metall/detail/memory.hpp>
+#include <metall/detail/mmap.hpp>
+#include <metall/detail/mutex.hpp>
+#include <metall/detail/utilities.hpp>
+#include <metall/logger.hpp>
+
+namespace metall {
+namespace kernel {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}
+
+/// \brief A pool of the blocks of the multi-layer bitsets of small chunks.
+/// The bitsets of a size class (bin) are cut from large contiguous slabs of
+/// the class instead of being allocated one by one with malloc, so that the
+/// bitsets of the chunks of a bin are next to each other in memory and
+/// opening a data store does not call malloc for each small chunk.
+/// A freed bitset is kept in the free list of its class and reused.
+/// Each class has its own lock; classes can be used concurrently.
+class slot_bitmap_pool {
+ public:
+  using block_type = uint64_t;
+
+  /// \brief Constructor.
+  /// \param num_classes The number of size classes.
+  explicit slot_bitmap_pool(const std::size_t num_classes)
+      : m_num_classes(num_classes),
+        m_classes(std::make_unique<class_type[]>(num_classes)) {}
+
+  ~slot_bitmap_pool() noexcept { clear(); }
+
+  slot_bitmap_pool(const slot_bitmap_pool &) = delete;
+  slot_bitmap_pool &operator=(const slot_bitmap_pool &) = delete;
+
+  slot_bitmap_pool(slot_bitmap_pool &&) noexcept = default;
+  slot_bitmap_pool &operator=(slot_bitmap_pool &&other) noexcept {
+    if (this != &other) {
+      clear();
+      m_num_classes = other.m_num_classes;
+      m_classes = std::move(other.m_classes);
+    }
+    return *this;
+  }
+
+  /// \brief Takes zero-filled blocks for a bitset.
+  /// \param class_no A size class number.
+  /// \param num_blocks The number of blocks. Must be the same in all calls
+  /// for the class.
+  /// \return The blocks on success; otherwise, nullptr.
+  block_type *allocate(const std::size_t class_no,
+                       const std::size_t num_blocks) {
+    assert(class_no < m_num_classes);
+    auto &cls = m_classes[class_no];
+    mdtl::mutex_lock_guard guard(cls.mutex);
+    assert(cls.num_blocks == 0 || cls.num_blocks == num_blocks);
+    cls.num_blocks = num_blocks;
+
+    if (!cls.free_list.empty()) {
+      block_type *const blocks = cls.free_list.back();
+      cls.free_list.pop_back();
+      std::fill(blocks, blocks + num_blocks, block_type(0));
+      return blocks;
+    }
+
+    if (cls.num_remaining == 0 && !priv_add_slab(&cls)) return nullptr;
+    block_type *const blocks = cls.next;
+    cls.next += num_blocks;
+    --cls.num_remaining;
+    return blocks;  // Not used yet; the slab is zero-filled
+  }
+
+  /// \brief Gives back blocks taken by allocate().
+  /// \param class_no The size class number given to allocate().
+  /// \param blocks The blocks to give back.
+  void deallocate(const std::size_t class_no, block_type *const blocks) {
+    assert(class_no < m_num_classes);
+    if (!blocks) return;
+    auto &cls = m_classes[class_no];
+    mdtl::mutex_lock_guard guard(cls.mutex);
+    cls.free_list.push_back(blocks);
+  }
+
+  /// \brief Unmaps all slabs. All blocks taken from the pool become invalid.
+  void clear() noexcept {
+    if (!m_classes) return;
+    for (std::size_t i = 0; i < m_num_classes; ++i) {
+      auto &cls = m_classes[i];
+      for (const auto &[addr, size] : cls.slabs) mdtl::os_munmap(addr, size);
+      cls.slabs.clear();
+      cls.free_list.clear();
+      cls.next = nullptr;
+      cls.num_remaining = 0;
+    }
+  }
+
+  /// \brief Returns the number of slabs, i.e., contiguous regions.
+  std::size_t num_slabs() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < m_num_classes; ++i) {
+      mdtl::mutex_lock_guard guard(m_classes[i].mutex);
+      count += m_classes[i].slabs.size();
+    }
+    return count;
+  }
+
+ private:
+  // The minimum slab size; pages are not used until they are touched
+  static constexpr std::size_t k_min_slab_size = 1ULL << 20ULL;
+
+  struct class_type {
+    mutable mdtl::mutex mutex;
+    std::size_t num_blocks{0};
+    std::vector<std::pair<void *, std::size_t>> slabs;
+    std::vector<block_type *> free_list;
+    // The first unused bitset in the last slab
+    block_type *next{nullptr};
+    std::size_t num_remaining{0};
+  };
+
+  static bool priv_add_slab(class_type *const cls) {
+    const std::size_t bitmap_size = cls->num_blocks * sizeof(block_type);
+    const std::size_t page_size =
+        mdtl::get_page_size() > 0 ? mdtl::get_page_size() : 4096;
+    const auto slab_size = static_cast<std::size_t>(
+        mdtl::round_up(std::max(k_min_slab_size, bitmap_size), page_size));
+    void *const addr = mdtl::map_anonymous_write_mode(nullptr, slab_size);
+    if (!addr) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Cannot allocate a slot bitmap slab");
+      return false;
+    }
+    cls->slabs.emplace_back(addr, slab_size);
+    cls->next = static_cast<block_type *>(addr);
+    cls->num_remaining = slab_size / bitmap_size;
+    return true;
+  }
+
+  std::size_t m_num_classes;
+  std::unique_ptr<class_type[]> m_classes;
+};
+
+}  // namespace kernel
+}  // namespace metall
+
+#endif  // METALL_KERNEL_SLOT_BITMAP_POOL_HPP
@@ -0,0 +1,391 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_KERNEL_UNDO_LOG_HPP
+#define METALL_KERNEL_UNDO_LOG_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/detail/file.hpp>
+#include <metall/detail/hash.hpp>
+
+namespace metall::kernel {
+
+namespace {
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+/// \brief Undo log of a transaction on the application data segment.
+/// Before a region is modified in a transaction, its old contents are
+/// appended to the log and the log is synced to the storage. Committing the
+/// transaction persists the modified regions and then empties the log;
+/// aborting it, or opening the data store after a crash during it, writes the
+/// old contents back.
+/// Regions are logged at the granularity of cache lines, and each line is
+/// logged only once in a transaction, i.e., the first contents in the
+/// transaction are kept.
+class undo_log {
+ public:
+  /// \brief The granularity of the logged regions.
+  static constexpr uint64_t k_line_size = 64;
+
+  /// \brief A function that persists a region of the segment.
+  /// Takes an offset and a size.
+  using persist_function_type = std::function<bool(uint64_t, uint64_t)>;
+
+  /// \brief A function that writes old contents back to the segment.
+  /// Takes an offset, the contents, and the size.
+  using restore_function_type =
+      std::function<bool(uint64_t, const char *, uint64_t)>;
+
+  undo_log() noexcept = default;
+  ~undo_log() noexcept { priv_close(); }
+
+  undo_log(const undo_log &) = delete;
+  undo_log &operator=(const undo_log &) = delete;
+
+  undo_log(undo_log &&other) noexcept
+      : m_fd(std::exchange(other.m_fd, -1)),
+        m_path(std::move(other.m_path)),
+        m_size(other.m_size),
+        m_synced_size(other.m_synced_size),
+        m_logged(std::move(other.m_logged)) {}
+
+  undo_log &operator=(undo_log &&other) noexcept {
+    if (this != &other) {
+      priv_close();
+      m_fd = std::exchange(other.m_fd, -1);
+      m_path = std::move(other.m_path);
+      m_size = other.m_size;
+      m_synced_size = other.m_synced_size;
+      m_logged = std::move(other.m_logged);
+    }
+    return *this;
+  }
+
+  /// \brief Starts a transaction, creating an empty log file.
+  /// \param path A file path.
+  /// \return Returns true on success; false on error or if a transaction is
+  /// already active.
+  bool begin(const fs::path &path) {
+    if (active()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "A transaction is already active");
+      return false;
+    }
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (m_fd == -1) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "open");
+      return false;
+    }
+    m_path = path;
+    m_logged.clear();
+
+    file_header header;
+    std::copy_n(k_magic, sizeof(header.magic), header.magic);
+    header.format_version = k_format_version;
+    // The file must exist before any record counts
+    if (!priv_write(&header, sizeof(header)) || !mdtl::os_fsync(m_fd) ||
+        !mdtl::fsync(m_path.parent_path())) {
+      priv_remove();
+      return false;
+    }
+    m_size = m_synced_size = sizeof(header);
+    return true;
+  }
+
+  /// \brief Returns true if a transaction is active.
+  bool active() const noexcept { return m_fd != -1; }
+
+  /// \brief Logs the old contents of a region that is about to be modified.
+  /// Returns after the log is synced; the region must not be modified before
+  /// this function returns.
+  /// \param segment The address of the segment.
+  /// \param offset The offset of the region from the segment.
+  /// \param size The size of the region.
+  /// \param segment_size The size of the segment; the region is extended to
+  /// cache lines within it.
+  /// \return Returns true on success; otherwise, false.
+  bool add(const void *const segment, const uint64_t offset,
+           const uint64_t size, const uint64_t segment_size) {
+    if (!active()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No transaction is active");
+      return false;
+    }
+    if (size == 0) return true;
+    const uint64_t begin = offset / k_line_size * k_line_size;
+    const uint64_t end = std::min(
+        (offset + size + k_line_size - 1) / k_line_size * k_line_size,
+        segment_size);
+
+    const auto ranges = priv_unlogged_ranges(begin, end);
+    if (ranges.empty()) return true;
+    for (const auto &[b, e] : ranges) {
+      if (!priv_append(static_cast<const char *>(segment) + b, b, e - b)) {
+        return false;
+      }
+    }
+    if (::fdatasync(m_fd) != 0) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "fdatasync");
+      return false;
+    }
+    for (const auto &[b, e] : ranges) priv_mark_logged(b, e);
+    m_synced_size = m_size;
+    return true;
+  }
+
+  /// \brief Commits the transaction: persists the logged regions and
+  /// empties the log.
+  /// \param persist A function that persists a region of the segment.
+  /// \return Returns true on success; otherwise, false, in which case the
+  /// transaction stays active.
+  bool commit(const persist_function_type &persist) {
+    if (!active()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No transaction is active");
+      return false;
+    }
+    for (const auto &[begin, end] : m_logged) {
+      if (!persist(begin, end - begin)) return false;
+    }
+    return priv_end();
+  }
+
+  /// \brief Aborts the transaction: writes the old contents back, persists
+  /// them, and empties the log.
+  /// \param restore A function that writes old contents back.
+  /// \param persist A function that persists a region of the segment.
+  /// \return Returns true on success; otherwise, false.
+  bool abort(const restore_function_type &restore,
+             const persist_function_type &persist) {
+    if (!active()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "No transaction is active");
+      return false;
+    }
+    if (!roll_back(m_path, restore)) return false;
+    for (const auto &[begin, end] : m_logged) {
+      if (!persist(begin, end - begin)) return false;
+    }
+    return priv_end();
+  }
+
+  /// \brief Writes the old contents in a log file back, from the last
+  /// record. The records that are not completely written, i.e., whose regions
+  /// have not been modified, and the ones after them are ignored.
+  /// \param path A path to a log file.
+  /// \param restore A function that writes old contents back.
+  /// \return Returns true on success; otherwise, false.
+  static bool roll_back(const fs::path &path,
+                        const restore_function_type &restore) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+      std::stringstream ss;
+      ss << "Cannot open: " << path;
+      logger::out(logger::level::error, __FILE__, __LINE__, ss.str().c_str());
+      return false;
+    }
+    const std::string image((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+
+    file_header header{};
+    if (image.size() >= sizeof(header)) {
+      std::memcpy(&header, image.data(), sizeof(header));
+    }
+    if (image.size() < sizeof(header) ||
+        !std::equal(header.magic, header.magic + sizeof(header.magic),
+                    k_magic) ||
+        (header.format_version != k_format_version &&
+         header.format_version != k_murmur_format_version)) {
+      // The header is synced before any record; thus, no region has been
+      // modified
+      return true;
+    }
+
+    std::vector<std::pair<std::size_t, record_header>> records;
+    for (std::size_t pos = sizeof(header);
+         pos + sizeof(record_header) <= image.size();) {
+      record_header record;
+      std::memcpy(&record, image.data() + pos, sizeof(record));
+      const std::size_t data_pos = pos + sizeof(record);
+      // The old format could not hash a record of 2 GiB or more
+      if (record.size > image.size() - data_pos ||
+          (header.format_version == k_murmur_format_version &&
+           record.size > uint64_t(std::numeric_limits<int>::max())) ||
+          record.checksum != priv_checksum(record.offset, record.size,
+                                           image.data() + data_pos,
+                                           header.format_version)) {
+        break;
+      }
+      records.emplace_back(data_pos, record);
+      pos = data_pos + record.size;
+    }
+    for (auto itr = records.rbegin(); itr != records.rend(); ++itr) {
+      if (!restore(itr->second.offset, image.data() + itr->first,
+                   itr->second.size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  static constexpr char k_magic[8] = {'M', 'T', 'L', 'L', 'U', 'N', 'D', 'O'};
+  static constexpr uint64_t k_format_version = 2;
+  // Hashed records with murmur_hash_64a, which takes the length as int
+  static constexpr uint64_t k_murmur_format_version = 1;
+
+  struct file_header {
+    char magic[8];
+    uint64_t format_version;
+  };
+
+  struct record_header {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+  };
+
+  static uint64_t priv_checksum(
+      const uint64_t offset, const uint64_t size, const char *const data,
+      const uint64_t format_version = k_format_version) {
+    const uint64_t seed = offset ^ (size << 32ULL);
+    if (format_version == k_murmur_format_version) {
+      return mdtl::murmur_hash_64a(data, static_cast<int>(size), seed);
+    }
+    return mdtl::wyhash_64(data, size, seed);
+  }
+
+  /// \brief Returns the parts of [begin, end) that are not logged yet.
+  std::vector<std::pair<uint64_t, uint64_t>> priv_unlogged_ranges(
+      uint64_t begin, const uint64_t end) const {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    auto itr = m_logged.upper_bound(begin);
+    if (itr != m_logged.begin()) {
+      const auto prev = std::prev(itr);
+      begin = std::max(begin, prev->second);
+    }
+    for (; begin < end; ++itr) {
+      const uint64_t next = (itr == m_logged.end()) ? end
+                                                    : std::min(itr->first, end);
+      if (begin < next) ranges.emplace_back(begin, next);
+      if (itr == m_logged.end()) break;
+      begin = std::max(begin, itr->second);
+    }
+    return ranges;
+  }
+
+  /// \brief Adds [begin, end), which does not overlap with the logged ranges,
+  /// merging it with the adjacent ones.
+  void priv_mark_logged(uint64_t begin, uint64_t end) {
+    auto next = m_logged.find(end);
+    if (next != m_logged.end()) {
+      end = next->second;
+      m_logged.erase(next);
+    }
+    auto itr = m_logged.lower_bound(begin);
+    if (itr != m_logged.begin()) {
+      const auto prev = std::prev(itr);
+      if (prev->second == begin) {
+        prev->second = end;
+        return;
+      }
+    }
+    m_logged.emplace(begin, end);
+  }
+
+  /// \brief Appends a record. On error, drops the records appended since
+  /// the last sync so that a later record does not follow a broken one.
+  bool priv_append(const char *const data, const uint64_t offset,
+                   const uint64_t size) {
+    const record_header record{offset, size,
+                               priv_checksum(offset, size, data)};
+    // Written directly from the segment not to copy a large region
+    if (!priv_write(&record, sizeof(record)) || !priv_write(data, size)) {
+      if (::ftruncate(m_fd, m_synced_size) != 0) {
+        logger::perror(logger::level::error, __FILE__, __LINE__, "ftruncate");
+      }
+      m_size = m_synced_size;
+      return false;
+    }
+    m_size += sizeof(record) + size;
+    return true;
+  }
+
+  /// \brief Empties the log and closes it.
+  bool priv_end() {
+    if (::ftruncate(m_fd, sizeof(file_header)) != 0) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "ftruncate");
+      return false;
+    }
+    if (::fdatasync(m_fd) != 0) {
+      logger::perror(logger::level::error, __FILE__, __LINE__, "fdatasync");
+      return false;
+    }
+    priv_remove();
+    return true;
+  }
+
+  bool priv_write(const void *const buf, const std::size_t size) noexcept {
+    const auto *ptr = static_cast<const char *>(buf);
+    std::size_t written = 0;
+    while (written < size) {
+      const auto ret = ::write(m_fd, ptr + written, size - written);
+      if (ret == -1) {
+        if (errno == EINTR) continue;
+        logger::perror(logger::level::error, __FILE__, __LINE__, "write");
+        return false;
+      }
+      written += ret;
+    }
+    return true;
+  }
+
+  void priv_close() noexcept {
+    if (m_fd != -1) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  void priv_remove() noexcept {
+    priv_close();
+    std::error_code ec;
+    fs::remove(m_path, ec);
+    m_logged.clear();
+  }
+
+  int m_fd{-1};
+  fs::path m_path;
+  uint64_t m_size{0};
+  // The size of the log file when it was synced last
+  uint64_t m_synced_size{0};
+  // The logged ranges, [begin, end), in the current transaction
+  std::map<uint64_t, uint64_t> m_logged;
+};
+
+}  // namespace metall::kernel
+
+#endif  // METALL_KERNEL_UNDO_LOG_HPP
@@ -11,6 +11,14 @@
 #include <sstream>
 #include <metall/logger_interface.h>
 
+/// \def METALL_LOG_MIN_LEVEL
+/// The minimum level of the messages compiled in, one of the metall_log_level
+/// values, e.g., metall_warning. The messages logged by METALL_LOG() below
+/// this level are removed at compile time, including their formatting.
+#ifndef METALL_LOG_MIN_LEVEL
+#define METALL_LOG_MIN_LEVEL metall_verbose
+#endif
+
 namespace metall {
 
 class logger {
@@ -31,15 +39,35 @@ class logger {
     verbose = metall_verbose,
   };
 
+  /// \brief Returns true if the messages of level lvl are compiled in, i.e.,
+  /// lvl is not below METALL_LOG_MIN_LEVEL.
+  static constexpr bool compiled(const level lvl) noexcept {
+    return static_cast<int>(lvl) >= static_cast<int>(METALL_LOG_MIN_LEVEL);
+  }
+
+  /// \brief Returns true if a message of level lvl would be logged; checked
+  /// before formatting a message.
+  /// If METALL_LOGGER_EXTERN_C is defined, the level is filtered only by
+  /// METALL_LOG_MIN_LEVEL here and the rest is up to metall_log().
+  static bool should_log(const level lvl) noexcept {
+#ifdef METALL_LOGGER_EXTERN_C
+    return compiled(lvl);
+#else
+    return compiled(lvl) && log_level().should_log(lvl);
+#endif
+  }
+
   /// \brief Log a message
   static void out(const level lvl, const char* const file_name,
                   const int line_no, const char* const message) noexcept {
+    if (!compiled(lvl)) return;
     metall_log(static_cast<metall_log_level>(lvl), file_name, line_no, message);
   }
 
   /// \brief Log a message about errno
   static void perror(const level lvl, const char* const file_name,
                      const int line_no, const char* const message) noexcept {
+    if (!should_log(lvl)) return;
     std::stringstream ss;
     ss << message << ": " << strerror(errno);
 
@@ -126,6 +154,22 @@ inline bool logger::abort_on_critical = true;
 
 }  // namespace metall
 
+/// \def METALL_LOG(lvl, message)
+/// Logs a message built by a stream expression only if it would be logged,
+/// e.g., METALL_LOG(metall::logger::level::error, "Cannot open " << path).
+/// The message is not formatted if the level is filtered out at runtime and
+/// the whole statement is removed if the level is below METALL_LOG_MIN_LEVEL.
+#define METALL_LOG(lvl, message)                                       \
+  do {                                                                 \
+    if constexpr (::metall::logger::compiled(lvl)) {                   \
+      if (::metall::logger::should_log(lvl)) {                         \
+        std::stringstream metall_log_ss_;                              \
+        metall_log_ss_ << message;                                     \
+        ::metall::logger::out(lvl, __FILE__, __LINE__,                 \
+                              metall_log_ss_.str().c_str());           \
+      }                                                                \
+    }                                                                  \
+  } while (0)
 
 #ifndef METALL_LOGGER_EXTERN_C
 #include <iostream>
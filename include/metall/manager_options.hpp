@@ -0,0 +1,163 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_MANAGER_OPTIONS_HPP
+#define METALL_MANAGER_OPTIONS_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <metall/defs.hpp>
+
+namespace metall {
+
+/// \brief The segment size limit given to a segment limit handler.
+enum class segment_limit {
+  /// \brief The segment has grown beyond the soft limit.
+  soft,
+  /// \brief An allocation has failed as it needed the segment to grow beyond
+  /// the hard limit.
+  hard
+};
+
+/// \brief A function called when the segment reaches a size limit, e.g., to
+/// trigger eviction, flush, or compaction. Takes the limit and the segment
+/// size the allocation needed.
+/// Called by the allocating thread outside the allocator locks; thus, it can
+/// call the manager, e.g., compact() or deallocate().
+using segment_limit_handler = std::function<void(segment_limit, std::size_t)>;
+
+/// \brief A function called while the pages are loaded on open (see
+/// manager_options::prefault_on_open). Takes the number of bytes loaded so
+/// far and the total number of bytes to load.
+/// Called by the loading threads one at a time.
+using prefault_progress_handler =
+    std::function<void(std::size_t, std::size_t)>;
+
+/// \brief Runtime options of a manager, given to the constructors of
+/// basic_manager that create or open a datastore.
+/// The default values are taken from the corresponding macros; thus, the
+/// macros still work as the defaults of the applications compiled with them.
+/// The options that determine data structures, e.g., the chunk size and the
+/// bin directory type (METALL_USE_SORTED_BIN), are not included.
+struct manager_options {
+  /// \brief The size of the segment blocks (files) of a datastore created
+  /// with these options. Must be a multiple of the chunk size.
+  /// When a datastore is opened, the block size it was created with is used
+  /// and this value is ignored.
+  std::size_t segment_block_size{METALL_SEGMENT_BLOCK_SIZE};
+
+  /// \brief The maximum size of the per-CPU object cache in bytes.
+  /// Capped at METALL_MAX_PER_CPU_CACHE_SIZE, which determines the
+  /// structure of the cache.
+  std::size_t max_per_cpu_cache_size{METALL_MAX_PER_CPU_CACHE_SIZE};
+
+  /// \brief The number of object caches per CPU.
+  /// Ignored by a single-threaded manager or if METALL_DISABLE_CONCURRENCY is
+  /// defined.
+  unsigned int num_caches_per_cpu{METALL_NUM_CACHES_PER_CPU};
+
+  /// \brief If not 0, Metall tries to free space when a small object equal to
+  /// or larger than this number of bytes is deallocated.
+  /// See METALL_FREE_SMALL_OBJECT_SIZE_HINT.
+  std::size_t free_small_object_size_hint{
+#ifdef METALL_FREE_SMALL_OBJECT_SIZE_HINT
+      METALL_FREE_SMALL_OBJECT_SIZE_HINT
+#else
+      0
+#endif
+  };
+
+  /// \brief If not 0, the segment limit handler is called with
+  /// segment_limit::soft when the segment grows beyond this size in bytes.
+  std::size_t segment_size_soft_limit{0};
+
+  /// \brief If not 0, an allocation that needs the segment to grow beyond this
+  /// size in bytes fails, returning nullptr, and the manager stays usable.
+  /// Because the segment grows by blocks, the segment can be larger than this
+  /// size by less than a block (segment_block_size).
+  std::size_t segment_size_hard_limit{0};
+
+  /// \brief If true, the pages of the segment are loaded into memory when a
+  /// datastore is opened, in parallel, so that the accesses after the open
+  /// do not take page faults, e.g., for a server that serves requests at a
+  /// low tail latency once it reports ready.
+  /// Not applied to open_live_read_only, whose segment grows.
+  bool prefault_on_open{false};
+
+  /// \brief If not empty, only the memory of these named objects is loaded
+  /// instead of the whole segment. The open fails if any object is not
+  /// found.
+  std::vector<std::string> prefault_object_names{};
+
+  /// \brief If true, the loaded pages are also pinned in memory (mlock) so
+  /// that they are not evicted under memory pressure. The open fails if
+  /// they cannot be pinned, e.g., exceeding RLIMIT_MEMLOCK.
+  /// See basic_manager::pin().
+  bool lock_prefaulted_pages{false};
+
+  /// \brief The maximum number of threads to load the pages.
+  /// If <= 0, it is automatically determined.
+  int prefault_num_threads{0};
+
+  /// \brief If not empty, called while the pages are loaded.
+  prefault_progress_handler prefault_progress{};
+
+  /// \brief If true, snapshot() with clone = false writes the segment files
+  /// with direct I/O (O_DIRECT), which does not fill the page cache with the
+  /// snapshot and evict the pages of the application, e.g., to checkpoint a
+  /// large datastore periodically. Falls back to a normal copy on file
+  /// systems that do not support direct I/O. Clone does not copy data.
+  bool direct_io_snapshot{false};
+
+  /// \brief If true, a datastore created with these options is volatile:
+  /// the segment is kept in anonymous memory, nothing is written back, and
+  /// the datastore is removed when the manager is destroyed, e.g., for
+  /// intermediate data at DRAM speed. Snapshots are not supported.
+  /// See basic_manager::spill() for moving the segment to the datastore
+  /// directory when the memory runs short.
+  bool volatile_segment{false};
+
+  /// \brief If true, the new segment blocks are mapped anonymously and
+  /// written to their files at the next flush, e.g., to ingest data onto a
+  /// slow file system at memory speed. The data written since the last flush
+  /// is lost on a crash, as without this option, but the blocks are not
+  /// shared with the readers; thus, basic_manager::publish() is refused.
+  /// See METALL_USE_ANONYMOUS_NEW_MAP.
+  bool write_back_cache{
+#ifdef METALL_USE_ANONYMOUS_NEW_MAP
+      true
+#else
+      false
+#endif
+  };
+
+  /// \brief If not 0, the max bytes of the blocks write_back_cache keeps in
+  /// memory at a time; the blocks added beyond it are mapped from their files
+  /// until the next flush.
+  std::size_t write_back_cache_budget{0};
+
+  /// \brief If not empty, a datastore created with these options stores its
+  /// segment blocks under this directory instead of the datastore directory,
+  /// which keeps the management data, e.g., to keep the small and
+  /// latency-sensitive management data on a fast local device and the large
+  /// segment on a slower volume. The directory must not be shared with other
+  /// datastores. The location is recorded in the management data; thus,
+  /// opening the datastore does not need this option, and removing the
+  /// datastore removes the segment as well. Snapshots and copies store their
+  /// segments with their management data.
+  std::string segment_path{};
+
+  /// \brief If not 0, flush() of a volatile datastore spills its segment to
+  /// the datastore directory until the resident anonymous memory is at most
+  /// this number of bytes (see basic_manager::spill()).
+  std::size_t volatile_memory_budget{0};
+};
+
+}  // namespace metall
+
+#endif  // METALL_MANAGER_OPTIONS_HPP
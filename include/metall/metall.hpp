@@ -32,6 +32,14 @@ namespace metall {
 /// \brief Default Metall manager class which is an alias of basic_manager with
 /// the default template parameters.
 using manager = basic_manager<>;
+
+/// \brief Metall manager class for a single thread, which is an alias of
+/// basic_manager with kernel::single_threaded. Can be used together with
+/// manager, e.g., by a single-threaded loader in a concurrent program.
+using single_threaded_manager =
+    basic_manager<kernel::storage, kernel::segment_storage, uint32_t,
+                  (1ULL << 21ULL), kernel::default_size_class_table,
+                  kernel::single_threaded>;
 #endif
 
 }  // namespace metall
@@ -143,7 +143,7 @@ class general_named_object_attr_accessor {
     if (position == end()) return false;
 
     if (!m_core_data->object_directory.set_description(position, description) ||
-        !m_core_data->object_directory.serialize(
+        !m_core_data->object_directory.flush(
             m_core_data->object_attribute_file_path.c_str())) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Filed to set description");
@@ -417,7 +417,7 @@ class anonymous_object_attr_accessor {
     if (position == end()) return false;
 
     if (!m_core_data->object_directory.set_description(position, description) ||
-        !m_core_data->object_directory.serialize(
+        !m_core_data->object_directory.flush(
             m_core_data->object_attribute_file_path.c_str())) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "Filed to set description");
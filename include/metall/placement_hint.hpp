@@ -0,0 +1,25 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_PLACEMENT_HINT_HPP
+#define METALL_PLACEMENT_HINT_HPP
+
+#include <cstddef>
+
+namespace metall {
+
+/// \brief A hint to group small objects, e.g., hot index nodes and cold
+/// payloads, into separate chunks (see basic_manager::placement_hint_scope).
+/// The meaning of each hint is up to the application; the chunks of a hint
+/// can then be placed, e.g., by advise_cold() or a NUMA policy, as a group.
+/// The number of hints is given by METALL_NUM_PLACEMENT_HINTS.
+struct placement_hint {
+  /// \brief A number in [0, METALL_NUM_PLACEMENT_HINTS).
+  std::size_t id{0};
+};
+
+}  // namespace metall
+
+#endif  // METALL_PLACEMENT_HINT_HPP
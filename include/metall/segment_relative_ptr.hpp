@@ -0,0 +1,204 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_SEGMENT_RELATIVE_PTR_HPP
+#define METALL_SEGMENT_RELATIVE_PTR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+namespace metall {
+
+namespace srpdtl {
+/// \brief The base address segment_relative_ptr is relative to.
+inline const std::byte *g_base = nullptr;
+}  // namespace srpdtl
+
+/// \brief Sets the base address of all segment_relative_ptr objects,
+/// i.e., the address of the application data segment
+/// (metall::manager::get_address()).
+/// Must be called after opening a datastore and before dereferencing
+/// segment_relative_ptr objects in it.
+/// \param base The base address.
+inline void set_segment_relative_ptr_base(const void *const base) noexcept {
+  srpdtl::g_base = static_cast<const std::byte *>(base);
+}
+
+/// \brief Returns the address set by set_segment_relative_ptr_base().
+inline const void *get_segment_relative_ptr_base() noexcept {
+  return srpdtl::g_base;
+}
+
+/// \brief A fancy pointer that holds the offset from the beginning of the
+/// application data segment instead of from itself as offset_ptr does.
+/// Thus, as offset_ptr, the stored values stay valid when the datastore is
+/// mapped at a different address. Because the base address is shared by all
+/// pointers, dereferencing is just an add to a raw pointer without a null
+/// check, and copying is trivial; e.g., an array of segment_relative_ptr can
+/// be copied by memcpy.
+/// All segment_relative_ptr objects in a process share the base address set
+/// by set_segment_relative_ptr_base(); use offset_ptr for the data of
+/// multiple datastores open at the same time.
+/// \tparam T The type of the object pointed to.
+template <typename T>
+class segment_relative_ptr {
+ public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using pointer = T *;
+  using reference = std::add_lvalue_reference_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::random_access_iterator_tag;
+  using offset_type = std::ptrdiff_t;
+
+  template <typename U>
+  using rebind = segment_relative_ptr<U>;
+
+  segment_relative_ptr() noexcept = default;
+
+  segment_relative_ptr(T *const ptr) noexcept
+      : m_offset(ptr ? reinterpret_cast<const std::byte *>(ptr) - srpdtl::g_base
+                     : k_null_offset) {}
+
+  template <typename U,
+            std::enable_if_t<std::is_convertible_v<U *, T *>, int> = 0>
+  segment_relative_ptr(const segment_relative_ptr<U> &other) noexcept
+      : segment_relative_ptr(static_cast<T *>(other.get())) {}
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  static segment_relative_ptr pointer_to(U &ref) noexcept {
+    return segment_relative_ptr(&ref);
+  }
+
+  /// \brief Returns the raw pointer. Returns nullptr if this is null.
+  T *get() const noexcept {
+    return (m_offset == k_null_offset) ? nullptr : priv_address();
+  }
+
+  /// \brief Returns the offset from the base address.
+  offset_type offset() const noexcept { return m_offset; }
+
+  /// \brief Dereferences without checking if this is null.
+  T *operator->() const noexcept { return priv_address(); }
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  U &operator*() const noexcept {
+    return *priv_address();
+  }
+
+  template <typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+  U &operator[](const difference_type n) const noexcept {
+    return priv_address()[n];
+  }
+
+  explicit operator bool() const noexcept { return m_offset != k_null_offset; }
+
+  bool operator!() const noexcept { return m_offset == k_null_offset; }
+
+  segment_relative_ptr &operator+=(const difference_type n) noexcept {
+    m_offset += n * difference_type(sizeof(T));
+    return *this;
+  }
+
+  segment_relative_ptr &operator-=(const difference_type n) noexcept {
+    m_offset -= n * difference_type(sizeof(T));
+    return *this;
+  }
+
+  segment_relative_ptr &operator++() noexcept { return *this += 1; }
+
+  segment_relative_ptr operator++(int) noexcept {
+    auto tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  segment_relative_ptr &operator--() noexcept { return *this -= 1; }
+
+  segment_relative_ptr operator--(int) noexcept {
+    auto tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  friend segment_relative_ptr operator+(segment_relative_ptr ptr,
+                                        const difference_type n) noexcept {
+    return ptr += n;
+  }
+
+  friend segment_relative_ptr operator+(const difference_type n,
+                                        segment_relative_ptr ptr) noexcept {
+    return ptr += n;
+  }
+
+  friend segment_relative_ptr operator-(segment_relative_ptr ptr,
+                                        const difference_type n) noexcept {
+    return ptr -= n;
+  }
+
+  friend difference_type operator-(const segment_relative_ptr &lhs,
+                                   const segment_relative_ptr &rhs) noexcept {
+    return (lhs.m_offset - rhs.m_offset) / difference_type(sizeof(T));
+  }
+
+  friend bool operator==(const segment_relative_ptr &lhs,
+                         const segment_relative_ptr &rhs) noexcept {
+    return lhs.m_offset == rhs.m_offset;
+  }
+
+  friend bool operator!=(const segment_relative_ptr &lhs,
+                         const segment_relative_ptr &rhs) noexcept {
+    return lhs.m_offset != rhs.m_offset;
+  }
+
+  friend bool operator<(const segment_relative_ptr &lhs,
+                        const segment_relative_ptr &rhs) noexcept {
+    return lhs.get() < rhs.get();
+  }
+
+  friend bool operator>(const segment_relative_ptr &lhs,
+                        const segment_relative_ptr &rhs) noexcept {
+    return rhs < lhs;
+  }
+
+  friend bool operator<=(const segment_relative_ptr &lhs,
+                         const segment_relative_ptr &rhs) noexcept {
+    return !(rhs < lhs);
+  }
+
+  friend bool operator>=(const segment_relative_ptr &lhs,
+                         const segment_relative_ptr &rhs) noexcept {
+    return !(lhs < rhs);
+  }
+
+ private:
+  template <typename U>
+  friend class segment_relative_ptr;
+
+  static constexpr offset_type k_null_offset =
+      std::numeric_limits<offset_type>::min();
+
+  T *priv_address() const noexcept {
+    return reinterpret_cast<T *>(
+        const_cast<std::byte *>(srpdtl::g_base + m_offset));
+  }
+
+  offset_type m_offset{k_null_offset};
+};
+
+static_assert(std::is_trivially_copyable_v<segment_relative_ptr<int>>);
+
+/// \brief Converts a segment_relative_ptr to the corresponding raw pointer.
+template <typename T>
+inline T *to_raw_pointer(const segment_relative_ptr<T> &ptr) noexcept {
+  return ptr.get();
+}
+
+}  // namespace metall
+
+#endif  // METALL_SEGMENT_RELATIVE_PTR_HPP
@@ -11,8 +11,10 @@
 #include <cassert>
 #include <limits>
 #include <new>
+#include <vector>
 
 #include <metall/offset_ptr.hpp>
+#include <metall/compact_ptr.hpp>
 #include <metall/logger.hpp>
 
 namespace metall {
@@ -20,6 +22,8 @@ namespace metall {
 /// \brief A STL compatible allocator.
 /// \tparam T A object type.
 /// \tparam metall_manager_kernel_type A manager kernel type.
+/// \tparam void_pointer_type The void pointer type to derive the pointer type
+/// from, e.g., compact_ptr<void> to make node-based containers smaller.
 /// \warning
 /// This allocator does not define propagate_on_* types, as same as
 /// Boost.Interprocess. Those types are going to be std::false_type in
@@ -30,7 +34,9 @@ namespace metall {
 /// allocated by different Metall managers invokes copy operations instead of
 /// move operations. Also, swapping containers allocated by different Metall
 /// managers will result in undefined behavior.
-template <typename T, typename metall_manager_kernel_type>
+template <typename T, typename metall_manager_kernel_type,
+          typename void_pointer_type =
+              typename metall_manager_kernel_type::void_pointer>
 class stl_allocator {
  public:
   // -------------------- //
@@ -38,8 +44,7 @@ class stl_allocator {
   // -------------------- //
   using value_type = T;
   using pointer = typename std::pointer_traits<
-      typename metall_manager_kernel_type::void_pointer>::
-      template rebind<value_type>;
+      void_pointer_type>::template rebind<value_type>;
   using const_pointer =
       typename std::pointer_traits<pointer>::template rebind<const value_type>;
   using void_pointer =
@@ -55,7 +60,7 @@ class stl_allocator {
   /// \tparam T2 The type of the object
   template <typename T2>
   struct rebind {
-    using other = stl_allocator<T2, manager_kernel_type>;
+    using other = stl_allocator<T2, manager_kernel_type, void_pointer_type>;
   };
 
  public:
@@ -77,9 +82,10 @@ class stl_allocator {
       : m_ptr_manager_kernel_address(pointer_manager_kernel_address) {}
 
   /// \brief Construct a new instance using an instance that has a different T
-  template <typename T2>
-  stl_allocator(
-      stl_allocator<T2, manager_kernel_type> allocator_instance) noexcept
+  /// or pointer type
+  template <typename T2, typename void_pointer_type2>
+  stl_allocator(stl_allocator<T2, manager_kernel_type, void_pointer_type2>
+                    allocator_instance) noexcept
       : m_ptr_manager_kernel_address(
             allocator_instance.get_pointer_to_manager_kernel()) {}
 
@@ -98,7 +104,8 @@ class stl_allocator {
   /// \brief Copy assign operator for another T
   template <typename T2>
   stl_allocator &operator=(
-      const stl_allocator<T2, manager_kernel_type> &other) noexcept {
+      const stl_allocator<T2, manager_kernel_type, void_pointer_type>
+          &other) noexcept {
     m_ptr_manager_kernel_address = other.m_ptr_manager_kernel_address;
     return *this;
   }
@@ -109,7 +116,8 @@ class stl_allocator {
   /// \brief Move assign operator for another T
   template <typename T2>
   stl_allocator &operator=(
-      stl_allocator<T2, manager_kernel_type> &&other) noexcept {
+      stl_allocator<T2, manager_kernel_type, void_pointer_type>
+          &&other) noexcept {
     m_ptr_manager_kernel_address = other.m_ptr_manager_kernel_address;
     return *this;
   }
@@ -119,13 +127,42 @@ class stl_allocator {
   /// \return Returns a pointer
   pointer allocate(const size_type n) const { return priv_allocate(n); }
 
+  /// \brief Allocates n * sizeof(T) bytes of storage filled with zeros.
+  /// See basic_manager::allocate_zeroed().
+  /// The objects are not constructed; the storage holds value-initialized
+  /// objects of a trivially default constructible T on common platforms.
+  /// \param n The size to allocation
+  /// \return Returns a pointer
+  pointer allocate_zeroed(const size_type n) const {
+    return priv_allocate(n, true);
+  }
+
   /// \brief Deallocates the storage reference by the pointer ptr
   /// \param ptr A pointer to the storage
-  /// \param size The size of the storage
+  /// \param size The size of the storage, i.e., the number of elements given
+  /// to allocate()
   void deallocate(pointer ptr, const size_type size) const {
     return priv_deallocate(ptr, size);
   }
 
+  /// \brief Allocates storage for 'n' objects of T at once, each of which is
+  /// allocated separately, e.g., to allocate nodes of a node-based container.
+  /// \param n The number of objects to allocate.
+  /// \param ptrs A buffer to store the pointers to the allocated storage.
+  /// Must be able to hold 'n' elements.
+  /// Throws std::bad_alloc if it fails to allocate all objects; in that case,
+  /// no storage remains allocated.
+  void allocate_many(const size_type n, pointer *const ptrs) const {
+    priv_allocate_many(n, ptrs);
+  }
+
+  /// \brief Deallocates storage allocated by allocate_many() or allocate(1).
+  /// \param ptrs Pointers to the storage.
+  /// \param n The number of elements in 'ptrs'.
+  void deallocate_many(const pointer *const ptrs, const size_type n) const {
+    priv_deallocate_many(ptrs, n);
+  }
+
   /// \brief The size of the theoretical maximum allocation size
   /// \return The size of the theoretical maximum allocation size
   size_type max_size() const noexcept { return priv_max_size(); }
@@ -155,7 +192,7 @@ class stl_allocator {
   // Private methods
   // -------------------- //
 
-  pointer priv_allocate(const size_type n) const {
+  pointer priv_allocate(const size_type n, const bool zeroed = false) const {
     if (priv_max_size() < n) {
       throw std::bad_array_new_length();
     }
@@ -172,8 +209,9 @@ class stl_allocator {
       throw std::bad_alloc();
     }
 
-    auto addr = pointer(
-        static_cast<value_type *>(manager_kernel->allocate(n * sizeof(T))));
+    auto addr = pointer(static_cast<value_type *>(
+        zeroed ? manager_kernel->allocate_zeroed(n * sizeof(T))
+               : manager_kernel->allocate(n * sizeof(T))));
     if (!addr) {
       throw std::bad_alloc();
     }
@@ -181,8 +219,7 @@ class stl_allocator {
     return addr;
   }
 
-  void priv_deallocate(pointer ptr,
-                       [[maybe_unused]] const size_type size) const noexcept {
+  void priv_deallocate(pointer ptr, const size_type size) const noexcept {
     if (!get_pointer_to_manager_kernel()) {
       logger::out(logger::level::error, __FILE__, __LINE__,
                   "nullptr: cannot access to manager kernel");
@@ -194,7 +231,54 @@ class stl_allocator {
                   "nullptr: cannot access to manager kernel");
       return;
     }
-    manager_kernel->deallocate(to_raw_pointer(ptr));
+    manager_kernel->deallocate(to_raw_pointer(ptr), size * sizeof(T));
+  }
+
+  void priv_allocate_many(const size_type n, pointer *const ptrs) const {
+    if (n == 0) return;
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) {
+      throw std::bad_alloc();
+    }
+
+    std::vector<void *> addrs(n);
+    const auto num_allocated =
+        manager_kernel->allocate_many(sizeof(T), n, addrs.data());
+    if (num_allocated != n) {
+      manager_kernel->deallocate_many(addrs.data(), num_allocated);
+      throw std::bad_alloc();
+    }
+    for (size_type i = 0; i < n; ++i) {
+      ptrs[i] = pointer(static_cast<value_type *>(addrs[i]));
+    }
+  }
+
+  void priv_deallocate_many(const pointer *const ptrs,
+                            const size_type n) const {
+    if (n == 0) return;
+    auto *const manager_kernel = priv_manager_kernel();
+    if (!manager_kernel) return;
+
+    std::vector<void *> addrs(n);
+    for (size_type i = 0; i < n; ++i) {
+      addrs[i] = to_raw_pointer(ptrs[i]);
+    }
+    manager_kernel->deallocate_many(addrs.data(), n);
+  }
+
+  /// \brief Returns the manager kernel. Returns nullptr on error.
+  manager_kernel_type *priv_manager_kernel() const noexcept {
+    if (!get_pointer_to_manager_kernel()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "nullptr: cannot access to manager kernel");
+      return nullptr;
+    }
+    auto *const manager_kernel = *get_pointer_to_manager_kernel();
+    if (!manager_kernel) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "nullptr: cannot access to manager kernel");
+    }
+    return manager_kernel;
   }
 
   size_type priv_max_size() const noexcept {
@@ -226,17 +310,17 @@ class stl_allocator {
           m_ptr_manager_kernel_address;
 };
 
-template <typename T, typename kernel>
-inline bool operator==(const stl_allocator<T, kernel> &rhd,
-                       const stl_allocator<T, kernel> &lhd) {
+template <typename T, typename kernel, typename void_pointer>
+inline bool operator==(const stl_allocator<T, kernel, void_pointer> &rhd,
+                       const stl_allocator<T, kernel, void_pointer> &lhd) {
   // Return true if they point to the same manager kernel
   return rhd.get_pointer_to_manager_kernel() ==
          lhd.get_pointer_to_manager_kernel();
 }
 
-template <typename T, typename kernel>
-inline bool operator!=(const stl_allocator<T, kernel> &rhd,
-                       const stl_allocator<T, kernel> &lhd) {
+template <typename T, typename kernel, typename void_pointer>
+inline bool operator!=(const stl_allocator<T, kernel, void_pointer> &rhd,
+                       const stl_allocator<T, kernel, void_pointer> &lhd) {
   return !(rhd == lhd);
 }
 
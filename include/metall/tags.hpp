@@ -30,6 +30,22 @@ struct open_read_only_t {};
 /// \brief Tag to open an already created segment as read only.
 [[maybe_unused]] static const open_read_only_t open_read_only{};
 
+/// \brief Tag type to open a segment as read only while another process keeps
+/// it open to write.
+struct open_live_read_only_t {};
+
+/// \brief Tag to open a segment as read only while another process keeps it
+/// open to write. The readers see the versions the writer publishes.
+[[maybe_unused]] static const open_live_read_only_t open_live_read_only{};
+
+/// \brief Tag type to open an already created segment with the copy-on-write
+/// mode.
+struct open_copy_on_write_t {};
+
+/// \brief Tag to open an already created segment with the copy-on-write mode.
+/// The segment can be modified, but nothing is written back to it.
+[[maybe_unused]] static const open_copy_on_write_t open_copy_on_write{};
+
 /// \brief Tag to construct anonymous instances.
 [[maybe_unused]] static const mtlldetail::anonymous_instance_t
     *anonymous_instance = nullptr;
@@ -0,0 +1,121 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_TRACING_HPP
+#define METALL_TRACING_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef METALL_USE_TRACEPOINTS
+#define METALL_ENABLE_TRACEPOINTS
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define METALL_ENABLE_USDT_PROBES
+#endif
+#endif
+
+namespace metall {
+
+/// \brief Tracepoints at the internal events of Metall.
+/// Available only if METALL_USE_TRACEPOINTS is defined.
+/// If <sys/sdt.h> is available, each event is also a USDT probe of the
+/// provider 'metall', e.g., 'usdt:./a.out:metall:segment_extend' for
+/// bpftrace; each probe takes two 64-bit arguments (see event).
+class tracing {
+ public:
+  /// \brief Traced events and their arguments.
+  enum struct event : uint32_t {
+    /// \brief A chunk was inserted. (chunk number, bin number)
+    chunk_insert,
+    /// \brief A chunk was erased. (chunk number, bin number)
+    chunk_erase,
+    /// \brief A large object chunk was resized. (chunk number, new bin number)
+    chunk_resize,
+    /// \brief Objects were moved from a bin to the object cache.
+    /// (bin number, number of objects)
+    cache_refill,
+    /// \brief Objects were returned from the object cache to a bin.
+    /// (bin number, number of objects)
+    cache_flush,
+    /// \brief Pages of a free slot were released. (offset, size)
+    free_slot_pages,
+    /// \brief The segment was extended. (old size, new size)
+    segment_extend,
+    /// \brief Syncing the segment started. (segment size, synchronous)
+    sync_begin,
+    /// \brief Syncing the segment finished. (segment size, succeeded)
+    sync_end,
+    /// \brief Writing the management data to files started. (compact, 0)
+    management_data_serialize_begin,
+    /// \brief Writing the management data finished. (compact, succeeded)
+    management_data_serialize_end,
+    /// \brief Reading the management data from files started. (0, 0)
+    management_data_deserialize_begin,
+    /// \brief Reading the management data finished. (0, succeeded)
+    management_data_deserialize_end,
+    /// \brief Mapping the segment files started. (read only, copy-on-write)
+    segment_map_begin,
+    /// \brief Mapping the segment files finished. (segment size, succeeded)
+    segment_map_end,
+    /// \brief Copying the segment files, e.g., for a snapshot, started.
+    /// (clone, 0)
+    segment_copy_begin,
+    /// \brief Copying the segment files finished. (clone, succeeded)
+    segment_copy_end
+  };
+
+  /// \brief A function called at each event.
+  /// Must be thread-safe and must not call Metall.
+  using callback_type = void (*)(event, uint64_t, uint64_t);
+
+  /// \brief Sets a function called at each event, replacing the previous one.
+  /// The events are traced only if METALL_USE_TRACEPOINTS is defined.
+  /// \param callback A function to call. If nullptr, unsets the function.
+  static void set_callback(const callback_type callback) noexcept {
+    priv_callback().store(callback, std::memory_order_release);
+  }
+
+  /// \brief Calls the callback function if it is set.
+  static void notify(const event e, const uint64_t arg0,
+                     const uint64_t arg1) {
+    const auto callback = priv_callback().load(std::memory_order_acquire);
+    if (callback) callback(e, arg0, arg1);
+  }
+
+  tracing() = delete;
+  ~tracing() = delete;
+
+ private:
+  static std::atomic<callback_type> &priv_callback() noexcept {
+    static std::atomic<callback_type> callback{nullptr};
+    return callback;
+  }
+};
+
+}  // namespace metall
+
+/// \brief Traces an event, e.g., METALL_TRACE(segment_extend, old, new).
+/// Expands to nothing unless METALL_USE_TRACEPOINTS is defined.
+#ifdef METALL_ENABLE_TRACEPOINTS
+#ifdef METALL_ENABLE_USDT_PROBES
+#define METALL_TRACE(name, arg0, arg1)                               \
+  do {                                                               \
+    DTRACE_PROBE2(metall, name, (uint64_t)(arg0), (uint64_t)(arg1)); \
+    metall::tracing::notify(metall::tracing::event::name,            \
+                            (uint64_t)(arg0), (uint64_t)(arg1));     \
+  } while (0)
+#else
+#define METALL_TRACE(name, arg0, arg1)                            \
+  metall::tracing::notify(metall::tracing::event::name,           \
+                          (uint64_t)(arg0), (uint64_t)(arg1))
+#endif
+#else
+#define METALL_TRACE(name, arg0, arg1) \
+  do {                                 \
+  } while (0)
+#endif
+
+#endif  // METALL_TRACING_HPP
@@ -0,0 +1,604 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_ARCHIVE_HPP
+#define METALL_UTILITY_ARCHIVE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/logger.hpp>
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/io_executor.hpp>
+#include <metall/detail/zstd_file.hpp>
+
+namespace metall::json {
+template <typename allocator_type>
+class value;
+}  // namespace metall::json
+
+/// \namespace metall::utility
+/// \brief Writes named objects to a portable, streaming binary archive and
+/// reads them back into another datastore.
+/// An archive stores the values of the objects, not the chunks they are in;
+/// thus, it can be read by a Metall built with a different chunk size or
+/// max capacity, and the objects get new offsets in the destination
+/// datastore.
+/// Supported types:
+/// - Trivially copyable types and arrays of them.
+/// - Containers of trivially copyable items with data(), size(), and
+/// resize(), e.g., metall::container::vector<int> and metall::container::
+/// string.
+/// - Segmented containers of trivially copyable items, e.g.,
+/// metall::container::segmented_vector<double>.
+/// - metall::json::value, which is stored as JSON text; include
+/// metall/json/json.hpp to archive it.
+///
+/// An archive consists of a header followed by the records of the objects
+/// and an end mark. The payload of a record is split into blocks, which are
+/// compressed with Zstandard in parallel if METALL_USE_ZSTD is defined and a
+/// compression level is given.
+/// The archive is not portable across byte orders.
+namespace metall::utility {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}  // namespace
+
+namespace arcdtl {
+
+constexpr uint64_t k_magic = 0x3143524c4c544dULL;  // "MTLLRC1"
+constexpr uint64_t k_version = 1;
+constexpr uint64_t k_record_mark = 1;
+constexpr uint64_t k_end_mark = 0;
+constexpr std::size_t k_block_size = std::size_t(1) << 22;
+constexpr std::size_t k_max_name_length = std::size_t(1) << 16;
+
+enum class encoding : uint8_t { bytes = 0, json = 1 };
+
+using const_span = std::pair<const char *, std::size_t>;
+using span = std::pair<char *, std::size_t>;
+
+template <typename T>
+struct is_json_value : std::false_type {};
+
+template <typename allocator_type>
+struct is_json_value<metall::json::value<allocator_type>> : std::true_type {};
+
+template <typename T, typename = void>
+struct is_segmented : std::false_type {};
+
+template <typename T>
+struct is_segmented<
+    T, std::void_t<decltype(std::declval<const T &>().num_segments()),
+                   decltype(std::declval<T &>().segment_data(0)),
+                   decltype(std::declval<T &>().resize(0))>>
+    : std::is_trivially_copyable<typename T::value_type> {};
+
+template <typename T, typename = void>
+struct is_contiguous : std::false_type {};
+
+template <typename T>
+struct is_contiguous<T, std::void_t<decltype(std::declval<T &>().data()),
+                                    decltype(std::declval<T &>().size()),
+                                    decltype(std::declval<T &>().resize(0))>>
+    : std::is_trivially_copyable<typename T::value_type> {};
+
+template <typename T>
+constexpr bool is_supported() {
+  return std::is_trivially_copyable_v<T> || is_json_value<T>::value ||
+         is_segmented<T>::value || is_contiguous<T>::value;
+}
+
+/// \brief Returns the size of the items stored in the records of T.
+template <typename T>
+constexpr std::size_t item_size() {
+  if constexpr (is_segmented<T>::value || is_contiguous<T>::value) {
+    return sizeof(typename T::value_type);
+  } else {
+    return sizeof(T);
+  }
+}
+
+inline bool write_u64(std::ostream &out, const uint64_t value) {
+  return bool(out.write(reinterpret_cast<const char *>(&value), sizeof(value)));
+}
+
+inline bool read_u64(std::istream &in, uint64_t *const value) {
+  return bool(in.read(reinterpret_cast<char *>(value), sizeof(*value)));
+}
+
+inline void log_error(const char *const message) {
+  logger::out(logger::level::error, __FILE__, __LINE__, message);
+}
+
+/// \brief Returns the segments of a segmented container as byte spans.
+template <typename span_type, typename container_type>
+inline std::vector<span_type> segment_spans(container_type &container) {
+  using value_type = typename container_type::value_type;
+  std::vector<span_type> spans;
+  for (std::size_t s = 0; s < container.num_segments(); ++s) {
+    spans.emplace_back(
+        reinterpret_cast<typename span_type::first_type>(
+            container.segment_data(s)),
+        container.segment_size(s) * sizeof(value_type));
+  }
+  return spans;
+}
+
+/// \brief Copies 'size' bytes to the byte stream made of 'spans' from its
+/// offset 'offset'.
+inline void scatter(const std::vector<span> &spans, std::size_t offset,
+                    const char *data, std::size_t size) {
+  for (const auto &s : spans) {
+    if (size == 0) break;
+    if (offset >= s.second) {
+      offset -= s.second;
+      continue;
+    }
+    const auto n = std::min(size, s.second - offset);
+    std::memcpy(s.first + offset, data, n);
+    data += n;
+    size -= n;
+    offset = 0;
+  }
+}
+
+}  // namespace arcdtl
+
+/// \brief Options of archive_writer.
+struct archive_options {
+  /// \brief The Zstandard compression level. If 0 is given or Metall is
+  /// built without METALL_USE_ZSTD, the blocks are stored uncompressed.
+  int compression_level{3};
+
+  /// \brief The maximum number of threads to compress the blocks.
+  /// If <= 0 is given, the value is automatically determined.
+  int num_threads{0};
+};
+
+/// \brief Writes objects to an archive.
+/// Call close() after writing all objects to write the end mark.
+/// This class is not thread-safe.
+class archive_writer {
+ public:
+  /// \brief Writes the archive header.
+  /// \param out An output stream opened in the binary mode.
+  /// \param options Options.
+  explicit archive_writer(std::ostream &out,
+                          const archive_options &options = archive_options())
+      : m_out(out), m_options(options) {
+    m_good = arcdtl::write_u64(m_out, arcdtl::k_magic) &&
+             arcdtl::write_u64(m_out, arcdtl::k_version);
+  }
+
+  archive_writer(const archive_writer &) = delete;
+  archive_writer &operator=(const archive_writer &) = delete;
+
+  /// \brief Returns false if an error has occurred.
+  bool good() const { return m_good; }
+
+  /// \brief Writes an object.
+  /// \tparam T The type of the object. See the supported types above.
+  /// \param name The name of the object in the archive, which is the name
+  /// the object is constructed with in the destination datastore.
+  /// \param object The object to write.
+  /// \return Returns true on success; otherwise, false.
+  template <typename T>
+  bool write(std::string_view name, const T &object) {
+    static_assert(arcdtl::is_supported<T>(), "Unsupported type");
+    if constexpr (arcdtl::is_json_value<T>::value) {
+      const auto text = serialize(object);  // Found by ADL
+      return priv_write_record(name, arcdtl::encoding::json, 1, 1,
+                               {{text.data(), text.size()}});
+    } else if constexpr (arcdtl::is_segmented<T>::value) {
+      return priv_write_record(
+          name, arcdtl::encoding::bytes, sizeof(typename T::value_type),
+          object.size(), arcdtl::segment_spans<arcdtl::const_span>(object));
+    } else if constexpr (arcdtl::is_contiguous<T>::value) {
+      using value_type = typename T::value_type;
+      const auto *const data = metall::to_raw_pointer(object.data());
+      return priv_write_record(
+          name, arcdtl::encoding::bytes, sizeof(value_type), object.size(),
+          {{reinterpret_cast<const char *>(data),
+            object.size() * sizeof(value_type)}});
+    } else {
+      return write(name, &object, 1);
+    }
+  }
+
+  /// \brief Writes an array of a trivially copyable type.
+  /// \param name The name of the array in the archive.
+  /// \param objects The beginning of the array.
+  /// \param length The number of the objects.
+  /// \return Returns true on success; otherwise, false.
+  template <typename T>
+  bool write(std::string_view name, const T *const objects,
+             const std::size_t length) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only arrays of trivially copyable types are supported");
+    return priv_write_record(name, arcdtl::encoding::bytes, sizeof(T), length,
+                             {{reinterpret_cast<const char *>(objects),
+                               sizeof(T) * length}});
+  }
+
+  /// \brief Writes a named object of a manager.
+  /// An array is written only if T is trivially copyable.
+  /// \param manager A manager.
+  /// \param name The name of the object.
+  /// \return Returns true on success; false if the object is not found or on
+  /// error.
+  template <typename T, typename manager_type>
+  bool write_named(const manager_type &manager, const char *const name) {
+    const auto [ptr, length] = manager.template find<T>(name);
+    if (!ptr) {
+      arcdtl::log_error("Object not found");
+      return false;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      return write(name, ptr, length);
+    } else {
+      if (length != 1) {
+        arcdtl::log_error("Arrays of this type are not supported");
+        return false;
+      }
+      return write(name, *ptr);
+    }
+  }
+
+  /// \brief Writes the end mark and flushes the stream.
+  /// \return Returns true if all writes succeeded; otherwise, false.
+  bool close() {
+    if (m_good) {
+      m_good = arcdtl::write_u64(m_out, arcdtl::k_end_mark) &&
+               bool(m_out.flush());
+    }
+    return m_good;
+  }
+
+ private:
+  bool priv_write_record(std::string_view name,
+                         const arcdtl::encoding encoding,
+                         const std::size_t item_size, const std::size_t length,
+                         const std::vector<arcdtl::const_span> &spans) {
+    if (!m_good) return false;
+    if (name.empty() || name.size() > arcdtl::k_max_name_length) {
+      arcdtl::log_error("Invalid object name");
+      return false;
+    }
+
+    // Each block is in a span so that it can be compressed without copying
+    std::vector<arcdtl::const_span> blocks;
+    std::size_t total_size = 0;
+    for (const auto &s : spans) {
+      for (std::size_t off = 0; off < s.second; off += arcdtl::k_block_size) {
+        blocks.emplace_back(s.first + off,
+                            std::min(arcdtl::k_block_size, s.second - off));
+      }
+      total_size += s.second;
+    }
+
+    const bool compress = mdtl::zstd::enabled() &&
+                          m_options.compression_level != 0;
+    m_good = arcdtl::write_u64(m_out, arcdtl::k_record_mark) &&
+             arcdtl::write_u64(m_out, name.size()) &&
+             m_out.write(name.data(), name.size()) &&
+             arcdtl::write_u64(m_out, uint64_t(encoding)) &&
+             arcdtl::write_u64(m_out, item_size) &&
+             arcdtl::write_u64(m_out, length) &&
+             arcdtl::write_u64(m_out, total_size) &&
+             arcdtl::write_u64(m_out, compress) &&
+             arcdtl::write_u64(m_out, blocks.size());
+    if (!m_good) {
+      arcdtl::log_error("Failed to write a record header");
+      return false;
+    }
+
+    auto &executor = mdtl::io_executor::instance();
+    const auto batch_size =
+        2 * ((m_options.num_threads > 0) ? std::size_t(m_options.num_threads)
+                                         : executor.num_threads());
+    std::vector<std::vector<char>> compressed(batch_size);
+    for (std::size_t b = 0; b < blocks.size(); b += batch_size) {
+      const auto n = std::min(batch_size, blocks.size() - b);
+      if (compress &&
+          !executor.parallel_for(n, m_options.num_threads, [&](std::size_t i) {
+            return priv_compress(blocks[b + i], &compressed[i]);
+          })) {
+        m_good = false;
+        return false;
+      }
+      for (std::size_t i = 0; i < n && m_good; ++i) {
+        const auto &block = blocks[b + i];
+        const char *const data =
+            compress ? compressed[i].data() : block.first;
+        const auto size = compress ? compressed[i].size() : block.second;
+        m_good = arcdtl::write_u64(m_out, block.second) &&
+                 arcdtl::write_u64(m_out, size) && m_out.write(data, size);
+      }
+      if (!m_good) {
+        arcdtl::log_error("Failed to write a block");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool priv_compress([[maybe_unused]] const arcdtl::const_span &block,
+                     [[maybe_unused]] std::vector<char> *const out) const {
+#ifdef METALL_ENABLE_ZSTD
+    out->resize(ZSTD_compressBound(block.second));
+    const auto ret = ZSTD_compress(out->data(), out->size(), block.first,
+                                   block.second, m_options.compression_level);
+    if (ZSTD_isError(ret)) {
+      arcdtl::log_error(ZSTD_getErrorName(ret));
+      return false;
+    }
+    out->resize(ret);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  std::ostream &m_out;
+  archive_options m_options;
+  bool m_good{false};
+};
+
+/// \brief Reads objects from an archive written by archive_writer.
+/// Call next() to move to each record, then load() or skip() it.
+/// This class is not thread-safe.
+class archive_reader {
+ public:
+  /// \brief Reads the archive header.
+  /// \param in An input stream opened in the binary mode.
+  /// \param num_threads The maximum number of threads to decompress the
+  /// blocks. If <= 0 is given, the value is automatically determined.
+  explicit archive_reader(std::istream &in, const int num_threads = 0)
+      : m_in(in), m_num_threads(num_threads) {
+    uint64_t magic = 0;
+    uint64_t version = 0;
+    m_good = arcdtl::read_u64(m_in, &magic) && magic == arcdtl::k_magic &&
+             arcdtl::read_u64(m_in, &version) &&
+             version == arcdtl::k_version;
+    if (!m_good) arcdtl::log_error("Not a Metall archive");
+  }
+
+  archive_reader(const archive_reader &) = delete;
+  archive_reader &operator=(const archive_reader &) = delete;
+
+  /// \brief Returns false if an error has occurred.
+  bool good() const { return m_good; }
+
+  /// \brief Moves to the next record, skipping the current one if it has not
+  /// been loaded.
+  /// \return Returns true if there is a record; false at the end of the
+  /// archive or on error (see good()).
+  bool next() {
+    if (m_in_record && !skip()) return false;
+    if (!m_good) return false;
+
+    uint64_t mark = 0;
+    uint64_t name_size = 0;
+    uint64_t encoding = 0;
+    uint64_t compressed = 0;
+    m_good = arcdtl::read_u64(m_in, &mark) &&
+             (mark == arcdtl::k_end_mark || mark == arcdtl::k_record_mark);
+    if (m_good && mark == arcdtl::k_end_mark) return false;
+    m_good = m_good && arcdtl::read_u64(m_in, &name_size) &&
+             name_size <= arcdtl::k_max_name_length;
+    if (m_good) {
+      m_name.resize(name_size);
+      m_good = bool(m_in.read(m_name.data(), name_size));
+    }
+    m_good = m_good && arcdtl::read_u64(m_in, &encoding) &&
+             arcdtl::read_u64(m_in, &m_item_size) &&
+             arcdtl::read_u64(m_in, &m_length) &&
+             arcdtl::read_u64(m_in, &m_total_size) &&
+             arcdtl::read_u64(m_in, &compressed) &&
+             arcdtl::read_u64(m_in, &m_num_blocks) && encoding <= 1 &&
+             (m_item_size == 0 ||
+              m_length <= std::numeric_limits<uint64_t>::max() / m_item_size);
+    if (!m_good) {
+      arcdtl::log_error("Broken archive record");
+      return false;
+    }
+    m_encoding = arcdtl::encoding(encoding);
+    m_compressed = compressed;
+    m_in_record = true;
+    return true;
+  }
+
+  /// \brief Returns the name of the current record.
+  const std::string &name() const { return m_name; }
+
+  /// \brief Returns the number of the items of the current record, e.g., the
+  /// length of an array or the size of a container.
+  std::size_t length() const { return m_length; }
+
+  /// \brief Constructs the object of the current record in a manager with
+  /// the record name.
+  /// \tparam T The type of the object, which must have the same layout
+  /// (the item type) as the written one.
+  /// \param manager A manager.
+  /// \return Returns a pointer to the constructed object (the first one if
+  /// it is an array) on success. On error, returns nullptr.
+  template <typename T, typename manager_type>
+  T *load(manager_type &manager) {
+    static_assert(arcdtl::is_supported<T>(), "Unsupported type");
+    if (!m_in_record || !m_good) return nullptr;
+
+    T *object = nullptr;
+    if constexpr (arcdtl::is_json_value<T>::value) {
+      if (m_encoding != arcdtl::encoding::json) return priv_type_mismatch();
+      std::string text(m_total_size, '\0');
+      if (!priv_read_payload({{text.data(), text.size()}})) return nullptr;
+      object = manager.template construct<T>(m_name.c_str())(
+          manager.get_allocator());
+      if (object && !parse_into(text, *object)) {
+        manager.destroy_ptr(object);
+        return nullptr;
+      }
+      return object;
+    } else {
+      constexpr auto item_size = arcdtl::item_size<T>();
+      if (m_encoding != arcdtl::encoding::bytes ||
+          m_item_size != item_size || m_total_size != m_length * item_size) {
+        return priv_type_mismatch();
+      }
+
+      std::vector<arcdtl::span> spans;
+      if constexpr (arcdtl::is_segmented<T>::value ||
+                    arcdtl::is_contiguous<T>::value) {
+        object = manager.template construct<T>(m_name.c_str())(
+            manager.get_allocator());
+        if (!object) return nullptr;
+        object->resize(m_length);
+        if constexpr (arcdtl::is_segmented<T>::value) {
+          spans = arcdtl::segment_spans<arcdtl::span>(*object);
+        } else {
+          spans.emplace_back(
+              reinterpret_cast<char *>(metall::to_raw_pointer(object->data())),
+              m_total_size);
+        }
+      } else {
+        object = manager.template construct<T>(m_name.c_str())[m_length]();
+        if (!object) return nullptr;
+        spans.emplace_back(reinterpret_cast<char *>(object), m_total_size);
+      }
+      if (!priv_read_payload(spans)) {
+        manager.destroy_ptr(object);
+        return nullptr;
+      }
+      return object;
+    }
+  }
+
+  /// \brief Skips the current record.
+  /// \return Returns false on error.
+  bool skip() {
+    if (!m_in_record) return m_good;
+    for (uint64_t b = 0; b < m_num_blocks && m_good; ++b) {
+      uint64_t raw_size = 0;
+      uint64_t stored_size = 0;
+      m_good = arcdtl::read_u64(m_in, &raw_size) &&
+               arcdtl::read_u64(m_in, &stored_size) &&
+               bool(m_in.ignore(stored_size));
+    }
+    m_in_record = false;
+    if (!m_good) arcdtl::log_error("Truncated archive");
+    return m_good;
+  }
+
+ private:
+  std::nullptr_t priv_type_mismatch() {
+    arcdtl::log_error("The type does not match the archived object");
+    return nullptr;
+  }
+
+  /// \brief Reads the blocks of the current record into 'spans'.
+  bool priv_read_payload(const std::vector<arcdtl::span> &spans) {
+    m_in_record = false;
+    if (m_compressed && !mdtl::zstd::enabled()) {
+      arcdtl::log_error("Decompression is not enabled (METALL_USE_ZSTD)");
+      m_good = false;
+      return false;
+    }
+
+    auto &executor = mdtl::io_executor::instance();
+    const auto batch_size =
+        2 * ((m_num_threads > 0) ? std::size_t(m_num_threads)
+                                 : executor.num_threads());
+    std::vector<std::vector<char>> stored(batch_size);
+    std::vector<std::size_t> raw_sizes(batch_size);
+    std::vector<std::size_t> offsets(batch_size);
+    std::size_t offset = 0;
+    for (uint64_t b = 0; b < m_num_blocks; b += batch_size) {
+      const auto n = std::min<std::size_t>(batch_size, m_num_blocks - b);
+      for (std::size_t i = 0; i < n && m_good; ++i) {
+        uint64_t raw_size = 0;
+        uint64_t stored_size = 0;
+        m_good = arcdtl::read_u64(m_in, &raw_size) &&
+                 arcdtl::read_u64(m_in, &stored_size) &&
+                 raw_size <= arcdtl::k_block_size &&
+                 offset + raw_size <= m_total_size &&
+                 (m_compressed || stored_size == raw_size) &&
+                 stored_size <= 2 * arcdtl::k_block_size;
+        if (m_good) {
+          stored[i].resize(stored_size);
+          m_good = bool(m_in.read(stored[i].data(), stored_size));
+        }
+        raw_sizes[i] = raw_size;
+        offsets[i] = offset;
+        offset += raw_size;
+      }
+      if (!m_good) {
+        arcdtl::log_error("Broken archive block");
+        return false;
+      }
+
+      m_good = executor.parallel_for(n, m_num_threads, [&](std::size_t i) {
+        if (!m_compressed) {
+          arcdtl::scatter(spans, offsets[i], stored[i].data(), raw_sizes[i]);
+          return true;
+        }
+        return priv_decompress(stored[i], raw_sizes[i], spans, offsets[i]);
+      });
+      if (!m_good) return false;
+    }
+
+    if (offset != m_total_size) {
+      arcdtl::log_error("Truncated archive record");
+      m_good = false;
+    }
+    return m_good;
+  }
+
+  static bool priv_decompress(
+      [[maybe_unused]] const std::vector<char> &stored,
+      [[maybe_unused]] const std::size_t raw_size,
+      [[maybe_unused]] const std::vector<arcdtl::span> &spans,
+      [[maybe_unused]] const std::size_t offset) {
+#ifdef METALL_ENABLE_ZSTD
+    std::vector<char> raw(raw_size);
+    const auto ret =
+        ZSTD_decompress(raw.data(), raw.size(), stored.data(), stored.size());
+    if (ZSTD_isError(ret) || ret != raw_size) {
+      arcdtl::log_error("Failed to decompress a block");
+      return false;
+    }
+    arcdtl::scatter(spans, offset, raw.data(), raw_size);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  std::istream &m_in;
+  int m_num_threads;
+  bool m_good{false};
+  bool m_in_record{false};
+  std::string m_name;
+  arcdtl::encoding m_encoding{arcdtl::encoding::bytes};
+  uint64_t m_item_size{0};
+  uint64_t m_length{0};
+  uint64_t m_total_size{0};
+  bool m_compressed{false};
+  uint64_t m_num_blocks{0};
+};
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_ARCHIVE_HPP
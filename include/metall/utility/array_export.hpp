@@ -0,0 +1,388 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_ARRAY_EXPORT_HPP
+#define METALL_UTILITY_ARRAY_EXPORT_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/c_api/arrow_c_data_interface.h>
+
+/// \namespace metall::utility
+/// \brief Exports arrays in a Metall datastore to other libraries without
+/// copying them.
+/// The functions in this file describe an array of arithmetic values, e.g.,
+/// the items of metall::container::vector<double>, as a NumPy
+/// __array_interface__ or as an Apache Arrow array (C data interface) whose
+/// buffer points straight into the mapped segment.
+/// The exported arrays do not own the items: they are valid while the
+/// manager is open and the container is not resized or destroyed.
+/// Releasing an exported Arrow array frees only the small descriptor
+/// allocated by the export.
+namespace metall::utility {
+
+namespace aedtl {
+
+inline constexpr char k_native_byte_order =
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    '>';
+#else
+    '<';
+#endif
+
+template <typename T>
+constexpr bool is_exportable() {
+  return (std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+          (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+           sizeof(T) == 8)) ||
+         (std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+}
+
+/// \brief Descriptors of an exported Arrow array and schema, which are freed
+/// by their release callbacks.
+struct arrow_array_private {
+  const void *buffers[2]{nullptr, nullptr};
+};
+
+struct arrow_schema_private {
+  std::string format;
+};
+
+struct arrow_stream_private {
+  std::string format;
+  std::vector<std::pair<const void *, std::size_t>> chunks;
+  std::size_t next_chunk{0};
+  std::string last_error;
+};
+
+inline arrow_stream_private *get_stream_private(
+    ArrowArrayStream *const stream) {
+  return static_cast<arrow_stream_private *>(stream->private_data);
+}
+
+inline void release_arrow_array(ArrowArray *const array) {
+  delete static_cast<arrow_array_private *>(array->private_data);
+  array->private_data = nullptr;
+  array->release = nullptr;
+}
+
+inline void release_arrow_schema(ArrowSchema *const schema) {
+  delete static_cast<arrow_schema_private *>(schema->private_data);
+  schema->private_data = nullptr;
+  schema->release = nullptr;
+}
+
+}  // namespace aedtl
+
+/// \brief Returns the Arrow format string of T, e.g., "g" for double.
+/// T must be a (non-bool) integral type or float or double.
+template <typename T>
+constexpr const char *arrow_format() {
+  static_assert(aedtl::is_exportable<T>(), "Unsupported element type");
+  if constexpr (std::is_floating_point_v<T>) {
+    return (sizeof(T) == 4) ? "f" : "g";
+  } else if constexpr (std::is_signed_v<T>) {
+    return (sizeof(T) == 1)   ? "c"
+           : (sizeof(T) == 2) ? "s"
+           : (sizeof(T) == 4) ? "i"
+                              : "l";
+  } else {
+    return (sizeof(T) == 1)   ? "C"
+           : (sizeof(T) == 2) ? "S"
+           : (sizeof(T) == 4) ? "I"
+                              : "L";
+  }
+}
+
+/// \brief Returns the NumPy typestr of T, e.g., "<f8" for double on
+/// little-endian machines.
+template <typename T>
+inline std::string array_typestr() {
+  static_assert(aedtl::is_exportable<T>(), "Unsupported element type");
+  const char kind = std::is_floating_point_v<T> ? 'f'
+                    : std::is_signed_v<T>       ? 'i'
+                                                : 'u';
+  const char order = (sizeof(T) == 1) ? '|' : aedtl::k_native_byte_order;
+  return std::string{order, kind} + std::to_string(sizeof(T));
+}
+
+/// \brief Returns the number of bytes of an element of an Arrow format
+/// string of a fixed-width primitive type.
+/// \return The element size, or 0 if the format is not supported.
+inline std::size_t arrow_format_item_size(const char *const format) {
+  if (!format || format[0] == '\0' || format[1] != '\0') return 0;
+  switch (format[0]) {
+    case 'c':
+    case 'C':
+      return 1;
+    case 's':
+    case 'S':
+    case 'e':
+      return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+      return 4;
+    case 'l':
+    case 'L':
+    case 'g':
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+/// \brief Returns the number of bytes of an element of a NumPy typestr,
+/// e.g., 8 for "<f8".
+/// Only integer and floating-point types in the native byte order are
+/// supported.
+/// \return The element size, or 0 if the typestr is not supported.
+inline std::size_t typestr_item_size(const char *const typestr) {
+  if (!typestr || std::strlen(typestr) != 3) return 0;
+  const char order = typestr[0];
+  const char kind = typestr[1];
+  const std::size_t size = typestr[2] - '0';
+  if (size != 1 && size != 2 && size != 4 && size != 8) return 0;
+  if (kind != 'i' && kind != 'u' && !(kind == 'f' && size >= 2)) return 0;
+  if (order != '|' && order != '=' && order != aedtl::k_native_byte_order) {
+    return 0;
+  }
+  if (order == '|' && size != 1) return 0;
+  return size;
+}
+
+/// \brief A NumPy __array_interface__ (version 3) of a one-dimensional
+/// array.
+struct array_interface {
+  const void *data{nullptr};
+  std::size_t length{0};
+  std::string typestr;
+  bool read_only{false};
+
+  /// \brief Returns the __array_interface__ dictionary as a Python literal,
+  /// which can be evaluated by ast.literal_eval(), e.g.,
+  /// {'version': 3, 'shape': (10,), 'typestr': '<f8',
+  /// 'data': (140737488355328, False)}.
+  std::string to_string() const {
+    std::ostringstream ss;
+    ss << "{'version': 3, 'shape': (" << length << ",), 'typestr': '"
+       << typestr << "', 'data': ("
+       << reinterpret_cast<std::uintptr_t>(data) << ", "
+       << (read_only ? "True" : "False") << ")}";
+    return ss.str();
+  }
+};
+
+/// \brief Makes the __array_interface__ of an array.
+/// \param data The address of the first element.
+/// \param length The number of elements.
+/// \param read_only Whether the array must not be written.
+template <typename T>
+inline array_interface make_array_interface(const T *const data,
+                                            const std::size_t length,
+                                            const bool read_only = false) {
+  return array_interface{data, length, array_typestr<T>(), read_only};
+}
+
+/// \brief Makes the __array_interface__ of the items of a contiguous
+/// container, e.g., metall::container::vector<T>.
+template <typename container_type,
+          typename = decltype(std::declval<const container_type &>().data())>
+inline array_interface make_array_interface(const container_type &container,
+                                            const bool read_only = false) {
+  return make_array_interface(metall::to_raw_pointer(container.data()),
+                              container.size(), read_only);
+}
+
+/// \brief Makes the __array_interface__ of each segment of a segmented
+/// container, e.g., metall::container::segmented_vector<T>, whose items are
+/// contiguous only within a segment.
+template <typename segmented_container_type>
+inline std::vector<array_interface> make_segment_array_interfaces(
+    const segmented_container_type &container, const bool read_only = false) {
+  std::vector<array_interface> interfaces;
+  interfaces.reserve(container.num_segments());
+  for (std::size_t s = 0; s < container.num_segments(); ++s) {
+    interfaces.push_back(make_array_interface(container.segment_data(s),
+                                              container.segment_size(s),
+                                              read_only));
+  }
+  return interfaces;
+}
+
+/// \brief Exports an array as an Arrow array whose only data buffer points
+/// to the given memory. The array has no validity buffer, i.e., no nulls.
+/// \param data The address of the first element.
+/// \param length The number of elements.
+/// \param format The Arrow format string of the elements, which must be a
+/// fixed-width primitive type (see arrow_format_item_size()).
+/// \param out_array The array to fill.
+/// \param out_schema The schema to fill. Can be nullptr.
+/// \return Returns true on success. On error, returns false and does not
+/// touch out_array and out_schema.
+inline bool export_arrow_array(const void *const data,
+                               const std::size_t length,
+                               const char *const format,
+                               ArrowArray *const out_array,
+                               ArrowSchema *const out_schema = nullptr) {
+  if (!out_array || arrow_format_item_size(format) == 0) return false;
+
+  auto *const array_private = new (std::nothrow) aedtl::arrow_array_private;
+  if (!array_private) return false;
+  aedtl::arrow_schema_private *schema_private = nullptr;
+  if (out_schema) {
+    try {
+      schema_private = new aedtl::arrow_schema_private{format};
+    } catch (...) {
+      delete array_private;
+      return false;
+    }
+  }
+
+  array_private->buffers[1] = data;
+  *out_array = ArrowArray{static_cast<int64_t>(length),
+                          0,
+                          0,
+                          2,
+                          0,
+                          array_private->buffers,
+                          nullptr,
+                          nullptr,
+                          aedtl::release_arrow_array,
+                          array_private};
+
+  if (out_schema) {
+    *out_schema = ArrowSchema{schema_private->format.c_str(),
+                              "",
+                              nullptr,
+                              0,
+                              0,
+                              nullptr,
+                              nullptr,
+                              aedtl::release_arrow_schema,
+                              schema_private};
+  }
+  return true;
+}
+
+/// \brief Exports an array as an Arrow array.
+/// See the untyped export_arrow_array().
+template <typename T>
+inline bool export_arrow_array(const T *const data, const std::size_t length,
+                               ArrowArray *const out_array,
+                               ArrowSchema *const out_schema = nullptr) {
+  return export_arrow_array(static_cast<const void *>(data), length,
+                            arrow_format<T>(), out_array, out_schema);
+}
+
+/// \brief Exports the items of a contiguous container, e.g.,
+/// metall::container::vector<T>, as an Arrow array.
+/// See the untyped export_arrow_array().
+template <typename container_type,
+          typename = decltype(std::declval<const container_type &>().data())>
+inline bool export_arrow_array(const container_type &container,
+                               ArrowArray *const out_array,
+                               ArrowSchema *const out_schema = nullptr) {
+  return export_arrow_array(metall::to_raw_pointer(container.data()),
+                            container.size(), out_array, out_schema);
+}
+
+/// \brief Exports chunks of memory as an Arrow array stream, which yields
+/// one Arrow array per chunk, i.e., the chunks of an Arrow ChunkedArray.
+/// \param chunks The address and number of elements of each chunk.
+/// \param format The Arrow format string of the elements.
+/// \param out_stream The stream to fill.
+/// \return Returns true on success. On error, returns false and does not
+/// touch out_stream.
+inline bool export_arrow_array_stream(
+    std::vector<std::pair<const void *, std::size_t>> chunks,
+    const char *const format, ArrowArrayStream *const out_stream) {
+  if (!out_stream || arrow_format_item_size(format) == 0) return false;
+
+  aedtl::arrow_stream_private *stream_private = nullptr;
+  try {
+    stream_private =
+        new aedtl::arrow_stream_private{format, std::move(chunks), 0, {}};
+  } catch (...) {
+    return false;
+  }
+
+  out_stream->get_schema = [](ArrowArrayStream *const stream,
+                              ArrowSchema *const out) -> int {
+    auto *const priv = aedtl::get_stream_private(stream);
+    ArrowArray dummy;
+    if (!export_arrow_array(nullptr, 0, priv->format.c_str(), &dummy, out)) {
+      priv->last_error = "Failed to export the schema";
+      return ENOMEM;
+    }
+    dummy.release(&dummy);
+    return 0;
+  };
+  out_stream->get_next = [](ArrowArrayStream *const stream,
+                            ArrowArray *const out) -> int {
+    auto *const priv = aedtl::get_stream_private(stream);
+    if (priv->next_chunk == priv->chunks.size()) {
+      out->release = nullptr;  // The end of the stream
+      return 0;
+    }
+    const auto &chunk = priv->chunks[priv->next_chunk];
+    if (!export_arrow_array(chunk.first, chunk.second, priv->format.c_str(),
+                            out)) {
+      priv->last_error = "Failed to export a chunk";
+      return ENOMEM;
+    }
+    ++priv->next_chunk;
+    return 0;
+  };
+  out_stream->get_last_error = [](ArrowArrayStream *const stream) {
+    auto *const priv = aedtl::get_stream_private(stream);
+    return priv->last_error.empty() ? nullptr : priv->last_error.c_str();
+  };
+  out_stream->release = [](ArrowArrayStream *const stream) {
+    delete aedtl::get_stream_private(stream);
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+  };
+  out_stream->private_data = stream_private;
+  return true;
+}
+
+/// \brief Exports the items of a segmented container, e.g.,
+/// metall::container::segmented_vector<T>, as an Arrow array stream that
+/// yields one array per segment.
+/// The segments are captured at the time of the call.
+/// See the untyped export_arrow_array_stream().
+template <typename segmented_container_type>
+inline bool export_arrow_array_stream(
+    const segmented_container_type &container,
+    ArrowArrayStream *const out_stream) {
+  using value_type = typename segmented_container_type::value_type;
+  std::vector<std::pair<const void *, std::size_t>> chunks;
+  try {
+    chunks.reserve(container.num_segments());
+    for (std::size_t s = 0; s < container.num_segments(); ++s) {
+      chunks.emplace_back(container.segment_data(s),
+                          container.segment_size(s));
+    }
+  } catch (...) {
+    return false;
+  }
+  return export_arrow_array_stream(std::move(chunks),
+                                   arrow_format<value_type>(), out_stream);
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_ARRAY_EXPORT_HPP
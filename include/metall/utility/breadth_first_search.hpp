@@ -0,0 +1,339 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_BREADTH_FIRST_SEARCH_HPP
+#define METALL_UTILITY_BREADTH_FIRST_SEARCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <metall/detail/builtin_functions.hpp>
+#include <metall/utility/open_mp.hpp>
+#include <metall/utility/work_stealing.hpp>
+
+/// \file breadth_first_search.hpp
+/// \brief A parallel direction-optimizing breadth-first search (Beamer et
+/// al., SC'12) over any graph that has the adjacency list interface, i.e.,
+/// key_type, num_values(), values_begin(), and values_end(), such as
+/// metall::container::csr_graph and the adjacency lists in the benchmarks,
+/// including the ones in a datastore.
+/// A level is expanded either top-down, from the frontier vertices to
+/// their neighbors, or bottom-up, from the unvisited vertices to a parent
+/// in the frontier, whichever checks fewer edges. The bottom-up steps keep
+/// the frontier in bitmaps.
+/// Levels run in parallel with work stealing (work_stealing.hpp), which
+/// balances skewed degrees; the output arrays are first touched in
+/// parallel, so that each NUMA node holds the part its threads work on.
+
+namespace metall::utility {
+
+namespace bfsdtl {
+
+namespace mdtl = metall::mtlldetail;
+
+using bitmap_type = std::vector<uint64_t>;
+
+// The number of frontier vertices a thread takes at a time
+constexpr std::size_t k_top_down_grain = 64;
+
+inline bool test_bit(const bitmap_type &bitmap, const std::size_t i) {
+  return (bitmap[i / 64] >> (i % 64)) & 1ULL;
+}
+
+inline void set_bit_atomic(bitmap_type &bitmap, const std::size_t i) {
+  mdtl::atomic_fetch_or(&bitmap[i / 64], uint64_t(1) << (i % 64));
+}
+
+/// \brief A queue of vertices that threads append to in blocks.
+template <typename vertex_id_type>
+class frontier_queue {
+ public:
+  explicit frontier_queue(const std::size_t capacity) : m_vertices(capacity) {}
+
+  /// \brief Appends the vertices in a thread-local buffer.
+  void append(const std::vector<vertex_id_type> &buffer) {
+    if (buffer.empty()) return;
+    const auto offset =
+        mdtl::atomic_fetch_add_relaxed(&m_size, buffer.size());
+    std::copy(buffer.begin(), buffer.end(), m_vertices.begin() + offset);
+  }
+
+  void push_back(const vertex_id_type vertex) {
+    m_vertices[m_size++] = vertex;
+  }
+
+  void clear() { m_size = 0; }
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  vertex_id_type operator[](const std::size_t i) const {
+    return m_vertices[i];
+  }
+  void swap(frontier_queue &other) {
+    m_vertices.swap(other.m_vertices);
+    std::swap(m_size, other.m_size);
+  }
+
+ private:
+  std::vector<vertex_id_type> m_vertices;
+  std::size_t m_size{0};
+};
+
+}  // namespace bfsdtl
+
+/// \brief Parameters of the direction-optimizing BFS.
+struct bfs_options {
+  /// \brief Goes bottom-up when the frontier has more than 1/alpha of the
+  /// edges of the unvisited vertices.
+  double alpha{15.0};
+  /// \brief Goes back top-down when the frontier shrinks and has fewer than
+  /// 1/beta of the vertices.
+  double beta{18.0};
+};
+
+/// \brief The result of a BFS.
+template <typename _vertex_id_type>
+struct bfs_result {
+  using vertex_id_type = _vertex_id_type;
+  using level_type = uint32_t;
+
+  /// \brief The parent of a vertex not reached.
+  static constexpr vertex_id_type k_unreached =
+      std::numeric_limits<vertex_id_type>::max();
+  /// \brief The level of a vertex not reached.
+  static constexpr level_type k_infinite_level =
+      std::numeric_limits<level_type>::max();
+
+  /// \brief The parent of each vertex in a BFS tree. The source is its own
+  /// parent.
+  std::vector<vertex_id_type> parent;
+  /// \brief The distance of each vertex from the source.
+  std::vector<level_type> level;
+  /// \brief The number of levels, i.e., the max level + 1.
+  level_type num_levels{0};
+  /// \brief The number of vertices reached, including the source.
+  std::size_t num_reached{0};
+};
+
+namespace bfsdtl {
+
+template <typename graph_type, typename function_type>
+inline void for_each_neighbor(const graph_type &graph,
+                              const typename graph_type::key_type vertex,
+                              const function_type &func) {
+  if (graph.num_values(vertex) == 0) return;
+  for (auto itr = graph.values_begin(vertex), end = graph.values_end(vertex);
+       itr != end; ++itr) {
+    if (!func(*itr)) return;
+  }
+}
+
+/// \brief Visits the unvisited neighbors of the frontier.
+/// \return The sum of the degrees of the vertices visited.
+template <typename graph_type, typename vertex_id_type>
+std::size_t top_down_step(const graph_type &graph,
+                          const frontier_queue<vertex_id_type> &frontier,
+                          const uint32_t next_level,
+                          bfs_result<vertex_id_type> *const result,
+                          frontier_queue<vertex_id_type> *const next) {
+  using result_type = bfs_result<vertex_id_type>;
+  auto *const parent = result->parent.data();
+  auto *const level = result->level.data();
+  std::size_t scout_count = 0;
+  std::vector<std::vector<vertex_id_type>> buffers(omp::get_max_threads());
+  work_stealing_for(
+      frontier.size(),
+      [&](const std::size_t begin, const std::size_t end) {
+        auto &buffer = buffers[omp::get_thread_num()];
+        std::size_t count = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          const auto u = frontier[i];
+          for_each_neighbor(graph, u, [&](const vertex_id_type v) {
+            auto expected = result_type::k_unreached;
+            if (mdtl::atomic_load(&parent[v]) == expected &&
+                mdtl::atomic_compare_exchange(&parent[v], &expected, u)) {
+              level[v] = next_level;
+              buffer.push_back(v);
+              count += graph.num_values(v);
+            }
+            return true;
+          });
+        }
+        mdtl::atomic_fetch_add_relaxed(&scout_count, count);
+      },
+      k_top_down_grain);
+
+  OMP_DIRECTIVE(parallel for schedule(static))
+  for (std::size_t t = 0; t < buffers.size(); ++t) next->append(buffers[t]);
+  return scout_count;
+}
+
+/// \brief Finds a parent in the frontier for each unvisited vertex.
+/// \return The number of vertices visited.
+template <typename graph_type, typename vertex_id_type>
+std::size_t bottom_up_step(const graph_type &reverse_graph,
+                           const std::size_t num_vertices,
+                           const bitmap_type &frontier,
+                           const uint32_t next_level,
+                           bfs_result<vertex_id_type> *const result,
+                           bitmap_type *const next) {
+  using result_type = bfs_result<vertex_id_type>;
+  auto *const parent = result->parent.data();
+  auto *const level = result->level.data();
+  std::fill(next->begin(), next->end(), 0);
+  std::size_t awake_count = 0;
+  // Blocks are cut at page boundaries of the parent array
+  work_stealing_for(
+      num_vertices,
+      [&](const std::size_t begin, const std::size_t end) {
+        std::size_t count = 0;
+        for (std::size_t u = begin; u < end; ++u) {
+          if (parent[u] != result_type::k_unreached) continue;
+          for_each_neighbor(reverse_graph, vertex_id_type(u),
+                            [&](const vertex_id_type v) {
+                              if (!test_bit(frontier, v)) return true;
+                              parent[u] = v;
+                              level[u] = next_level;
+                              set_bit_atomic(*next, u);
+                              ++count;
+                              return false;
+                            });
+        }
+        mdtl::atomic_fetch_add_relaxed(&awake_count, count);
+      },
+      0, parent, sizeof(vertex_id_type));
+  return awake_count;
+}
+
+template <typename vertex_id_type>
+void queue_to_bitmap(const frontier_queue<vertex_id_type> &queue,
+                     bitmap_type *const bitmap) {
+  std::fill(bitmap->begin(), bitmap->end(), 0);
+  OMP_DIRECTIVE(parallel for schedule(static))
+  for (std::size_t i = 0; i < queue.size(); ++i) {
+    set_bit_atomic(*bitmap, queue[i]);
+  }
+}
+
+template <typename vertex_id_type>
+void bitmap_to_queue(const bitmap_type &bitmap,
+                     frontier_queue<vertex_id_type> *const queue) {
+  queue->clear();
+  OMP_DIRECTIVE(parallel) {
+    std::vector<vertex_id_type> buffer;
+    OMP_DIRECTIVE(for schedule(static) nowait)
+    for (std::size_t w = 0; w < bitmap.size(); ++w) {
+      for (uint64_t word = bitmap[w]; word; word &= word - 1) {
+        buffer.push_back(vertex_id_type(w * 64 + mdtl::ctzll(word)));
+      }
+    }
+    queue->append(buffer);
+  }
+}
+
+}  // namespace bfsdtl
+
+/// \brief Runs a direction-optimizing BFS on a directed graph.
+/// \param graph A graph whose neighbors are the out-neighbors.
+/// \param reverse_graph The transpose of 'graph', whose neighbors are the
+/// in-neighbors, used by the bottom-up steps. Can be 'graph' itself if the
+/// graph is undirected, i.e., each edge is stored in both directions.
+/// \param num_vertices The number of vertices. The vertex IDs must be
+/// smaller than this value.
+/// \param source The vertex to start from.
+/// \param options Parameters to choose the direction.
+/// \return The BFS tree and the levels.
+template <typename graph_type, typename reverse_graph_type>
+bfs_result<typename graph_type::key_type> breadth_first_search(
+    const graph_type &graph, const reverse_graph_type &reverse_graph,
+    const std::size_t num_vertices, const typename graph_type::key_type source,
+    const bfs_options &options = bfs_options()) {
+  using vertex_id_type = typename graph_type::key_type;
+  using result_type = bfs_result<vertex_id_type>;
+
+  result_type result;
+  if (num_vertices == 0) return result;
+  result.parent.resize(num_vertices);
+  result.level.resize(num_vertices);
+  std::size_t num_edges = 0;
+  // Touches the arrays first in the order the bottom-up steps do
+  OMP_DIRECTIVE(parallel for schedule(static) reduction(+ : num_edges))
+  for (std::size_t v = 0; v < num_vertices; ++v) {
+    result.parent[v] = result_type::k_unreached;
+    result.level[v] = result_type::k_infinite_level;
+    num_edges += graph.num_values(vertex_id_type(v));
+  }
+  result.parent[source] = source;
+  result.level[source] = 0;
+
+  bfsdtl::frontier_queue<vertex_id_type> frontier(num_vertices);
+  bfsdtl::frontier_queue<vertex_id_type> next(num_vertices);
+  frontier.push_back(source);
+  bfsdtl::bitmap_type front_bits((num_vertices + 63) / 64);
+  bfsdtl::bitmap_type next_bits(front_bits.size());
+
+  // The number of edges from the frontier and from the unvisited vertices
+  std::size_t scout_count = graph.num_values(source);
+  std::size_t edges_to_check = num_edges;
+  typename result_type::level_type depth = 0;
+  while (!frontier.empty()) {
+    if (double(scout_count) > double(edges_to_check) / options.alpha) {
+      bfsdtl::queue_to_bitmap(frontier, &front_bits);
+      std::size_t awake_count = frontier.size();
+      std::size_t old_awake_count = 0;
+      do {
+        old_awake_count = awake_count;
+        awake_count = bfsdtl::bottom_up_step(reverse_graph, num_vertices,
+                                             front_bits, depth + 1, &result,
+                                             &next_bits);
+        front_bits.swap(next_bits);
+        if (awake_count > 0) ++depth;
+      } while (awake_count > 0 &&
+               (awake_count >= old_awake_count ||
+                double(awake_count) > double(num_vertices) / options.beta));
+      bfsdtl::bitmap_to_queue(front_bits, &frontier);
+      scout_count = 1;
+    } else {
+      edges_to_check -= std::min(edges_to_check, scout_count);
+      next.clear();
+      scout_count =
+          bfsdtl::top_down_step(graph, frontier, depth + 1, &result, &next);
+      frontier.swap(next);
+      if (!frontier.empty()) ++depth;
+    }
+  }
+
+  result.num_levels = depth + 1;
+  std::size_t num_reached = 0;
+  OMP_DIRECTIVE(parallel for schedule(static) reduction(+ : num_reached))
+  for (std::size_t v = 0; v < num_vertices; ++v) {
+    num_reached += (result.parent[v] != result_type::k_unreached);
+  }
+  result.num_reached = num_reached;
+  return result;
+}
+
+/// \brief Runs a direction-optimizing BFS on an undirected graph, i.e.,
+/// each edge is stored in both directions.
+/// \param graph A graph.
+/// \param num_vertices The number of vertices. The vertex IDs must be
+/// smaller than this value.
+/// \param source The vertex to start from.
+/// \param options Parameters to choose the direction.
+/// \return The BFS tree and the levels.
+template <typename graph_type>
+bfs_result<typename graph_type::key_type> breadth_first_search(
+    const graph_type &graph, const std::size_t num_vertices,
+    const typename graph_type::key_type source,
+    const bfs_options &options = bfs_options()) {
+  return breadth_first_search(graph, graph, num_vertices, source, options);
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_BREADTH_FIRST_SEARCH_HPP
@@ -8,10 +8,15 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <iomanip>
 #include <numeric>
+#include <algorithm>
+#include <optional>
+#include <limits>
+#include <unordered_set>
 
 #include <metall/metall.hpp>
 
@@ -19,7 +24,8 @@ namespace metall::utility {
 
 #ifndef DOXYGEN_SKIP
 namespace datastore_ls_detail {
-inline void aligned_show(const std::vector<std::vector<std::string>> &buf) {
+inline void aligned_show(const std::vector<std::vector<std::string>> &buf,
+                         std::ostream &os = std::cout) {
   if (buf.empty()) return;
 
   // Calculate each column size
@@ -33,35 +39,227 @@ inline void aligned_show(const std::vector<std::vector<std::string>> &buf) {
 
   // Show column title
   {
-    std::cout << "|";
+    os << "|";
     for (std::size_t c = 0; c < col_size.size(); ++c) {
-      std::cout << std::setw(col_size[c] + 2) << buf[0][c] << " |";
+      os << std::setw(col_size[c] + 2) << buf[0][c] << " |";
     }
-    std::cout << std::endl;
+    os << std::endl;
 
     // Show horizontal rule
     for (std::size_t c = 0; c < col_size.size(); ++c) {
       for (std::size_t i = 0; i < col_size[c] + 4; ++i) {
-        std::cout << "-";
+        os << "-";
       }
     }
-    std::cout << std::endl;
+    os << std::endl;
   }
 
   // Show items
   for (std::size_t l = 1; l < buf.size(); ++l) {
     const auto &row = buf[l];
 
-    std::cout << "|";
+    os << "|";
     for (std::size_t c = 0; c < col_size.size(); ++c) {
-      std::cout << std::setw(col_size[c] + 2) << std::right << row[c] << " |";
+      os << std::setw(col_size[c] + 2) << std::right << row[c] << " |";
     }
-    std::cout << std::endl;
+    os << std::endl;
   }
 }
+
+inline std::string json_escape(const std::string &str) {
+  std::string escaped;
+  escaped.reserve(str.size() + 2);
+  escaped += '"';
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          escaped += buf;
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  escaped += '"';
+  return escaped;
+}
 }  // namespace datastore_ls_detail
 #endif  // DOXYGEN_SKIP
 
+/// \brief Options of ls().
+struct ls_options {
+  /// \brief The key to sort the objects by.
+  enum class sort_key { none, name, offset, length };
+
+  /// \brief Lists only the objects whose names start with this string.
+  std::string name_prefix{};
+  /// \brief If given, lists only the objects of this type ID.
+  std::optional<std::size_t> type_id{};
+  /// \brief Lists only the objects whose lengths are in [min, max].
+  std::size_t min_length{0};
+  std::size_t max_length{std::numeric_limits<std::size_t>::max()};
+  /// \brief The objects are listed in the construction order if none.
+  sort_key sort{sort_key::none};
+  bool reverse{false};
+  /// \brief Shows the objects in JSON instead of tables.
+  bool json{false};
+  /// \brief Shows only the summary statistics of the objects.
+  bool summary_only{false};
+  /// \brief The maximum number of threads to read the directories.
+  /// If <= 0 is given, it is automatically determined.
+  int num_threads{0};
+  /// \brief The kinds of the objects to list.
+  std::vector<metall::manager::instance_kind> kinds{
+      metall::manager::instance_kind::named_kind,
+      metall::manager::instance_kind::unique_kind,
+      metall::manager::instance_kind::anonymous_kind};
+};
+
+/// \brief Lists the objects in a data store, reading the directories without
+/// opening the data store. Unlike the ls_*_object() functions, which show
+/// every object, the objects can be filtered, sorted, summarized, and shown
+/// in JSON, e.g., for a data store with millions of objects.
+/// The summary statistics are the number of the objects, the total, minimum,
+/// and maximum lengths, and the number of the type IDs.
+/// \param datastore_path Path to a data store.
+/// \param options Options.
+/// \param os An output stream.
+/// \return Returns true on success; otherwise, false.
+inline bool ls(const std::string &datastore_path, const ls_options &options,
+               std::ostream &os = std::cout) {
+  using kind_type = metall::manager::instance_kind;
+  using attribute_type = metall::manager::object_attribute_type;
+
+  if (options.json) os << "{";
+  bool first_kind = true;
+  for (const auto kind : options.kinds) {
+    std::vector<attribute_type> objects;
+    if (!metall::manager::read_object_attributes(
+            datastore_path, kind, &objects, options.num_threads)) {
+      std::cerr << "Failed to read the objects in " << datastore_path
+                << std::endl;
+      return false;
+    }
+
+    objects.erase(
+        std::remove_if(
+            objects.begin(), objects.end(),
+            [&options](const attribute_type &object) {
+              return object.name().compare(0, options.name_prefix.size(),
+                                           options.name_prefix) != 0 ||
+                     (options.type_id &&
+                      *options.type_id != object.type_id()) ||
+                     object.length() < options.min_length ||
+                     object.length() > options.max_length;
+            }),
+        objects.end());
+
+    const auto less = [&options](const attribute_type &lhs,
+                                 const attribute_type &rhs) {
+      switch (options.sort) {
+        case ls_options::sort_key::name:
+          return lhs.name() < rhs.name();
+        case ls_options::sort_key::offset:
+          return lhs.offset() < rhs.offset();
+        case ls_options::sort_key::length:
+          return lhs.length() < rhs.length();
+        default:
+          return false;
+      }
+    };
+    if (options.sort != ls_options::sort_key::none) {
+      std::stable_sort(objects.begin(), objects.end(), less);
+    }
+    if (options.reverse) std::reverse(objects.begin(), objects.end());
+
+    std::size_t total_length = 0;
+    std::size_t min_length = objects.empty() ? 0 : objects.front().length();
+    std::size_t max_length = 0;
+    std::unordered_set<std::size_t> type_ids;
+    for (const auto &object : objects) {
+      total_length += object.length();
+      min_length = std::min<std::size_t>(min_length, object.length());
+      max_length = std::max<std::size_t>(max_length, object.length());
+      type_ids.insert(object.type_id());
+    }
+
+    const char *kind_name = "anonymous";
+    if (kind == kind_type::named_kind) {
+      kind_name = "named";
+    } else if (kind == kind_type::unique_kind) {
+      kind_name = "unique";
+    }
+    if (options.json) {
+      os << (first_kind ? "" : ",") << "\"" << kind_name << "\":{"
+         << "\"count\":" << objects.size()
+         << ",\"total_length\":" << total_length
+         << ",\"min_length\":" << min_length
+         << ",\"max_length\":" << max_length
+         << ",\"num_type_ids\":" << type_ids.size();
+      if (!options.summary_only) {
+        os << ",\"objects\":[";
+        for (std::size_t i = 0; i < objects.size(); ++i) {
+          const auto &object = objects[i];
+          os << (i == 0 ? "" : ",") << "{";
+          if (kind != kind_type::anonymous_kind) {
+            os << "\"name\":" << datastore_ls_detail::json_escape(object.name())
+               << ",";
+          }
+          os << "\"length\":" << object.length()
+             << ",\"offset\":" << object.offset()
+             << ",\"type_id\":" << object.type_id() << ",\"description\":"
+             << datastore_ls_detail::json_escape(object.description()) << "}";
+        }
+        os << "]";
+      }
+      os << "}";
+    } else {
+      os << "[" << kind_name << " objects] Count: " << objects.size()
+         << ", Total length: " << total_length
+         << ", Min length: " << min_length << ", Max length: " << max_length
+         << ", #of type IDs: " << type_ids.size() << std::endl;
+      if (!options.summary_only && !objects.empty()) {
+        std::vector<std::vector<std::string>> buf;
+        if (kind == kind_type::anonymous_kind) {
+          buf.emplace_back(std::vector<std::string>{"Length", "Offset",
+                                                    "Type-ID", "Description"});
+        } else {
+          buf.emplace_back(std::vector<std::string>{
+              "Name", "Length", "Offset", "Type-ID", "Description"});
+        }
+        for (const auto &object : objects) {
+          std::vector<std::string> row;
+          if (kind != kind_type::anonymous_kind) row.push_back(object.name());
+          row.push_back(std::to_string(object.length()));
+          row.push_back(std::to_string(object.offset()));
+          row.push_back(std::to_string(object.type_id()));
+          row.push_back(object.description());
+          buf.emplace_back(std::move(row));
+        }
+        datastore_ls_detail::aligned_show(buf, os);
+      }
+      os << std::endl;
+    }
+    first_kind = false;
+  }
+  if (options.json) os << "}" << std::endl;
+  return true;
+}
+
 inline void ls_named_object(const std::string &datastore_path) {
   std::cout << "[Named Object]" << std::endl;
   auto accessor =
@@ -0,0 +1,277 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_EXTERNAL_SORT_HPP
+#define METALL_UTILITY_EXTERNAL_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/logger.hpp>
+#include <metall/utility/parallel_algorithm.hpp>
+
+namespace metall::utility {
+
+/// \brief Options of external_sort().
+struct external_sort_options {
+  /// \brief A path to create a scratch datastore to store the sorted runs
+  /// in. The datastore is removed at the end.
+  std::filesystem::path scratch_path;
+  /// \brief The size of the main memory to use. A run is as large as this,
+  /// and the runs merged at once have two blocks each in this size.
+  std::size_t memory_bytes{1ULL << 30ULL};
+  /// \brief The size of the blocks the runs are read and the output is
+  /// written in.
+  std::size_t block_bytes{1ULL << 23ULL};
+};
+
+namespace exsdtl {
+
+/// \brief Reads a run by blocks, reading the next block in another thread
+/// while the current one is merged.
+template <typename value_type>
+class run_reader {
+ public:
+  run_reader(const value_type *const data, const std::size_t size,
+             const std::size_t block_size)
+      : m_data(data), m_size(size), m_block_size(block_size) {
+    priv_prefetch();
+    priv_next_block();
+  }
+
+  ~run_reader() noexcept {
+    if (m_prefetch.valid()) m_prefetch.wait();
+  }
+
+  run_reader(const run_reader &) = delete;
+  run_reader &operator=(const run_reader &) = delete;
+
+  bool empty() const { return m_pos == m_current.size(); }
+
+  const value_type &front() const { return m_current[m_pos]; }
+
+  void pop() {
+    if (++m_pos == m_current.size()) priv_next_block();
+  }
+
+ private:
+  void priv_prefetch() {
+    const auto begin = m_fetched;
+    const auto end = std::min(m_size, begin + m_block_size);
+    m_fetched = end;
+    // Copying the block reads its pages in sequentially
+    m_prefetch = std::async(std::launch::async, [this, begin, end]() {
+      m_next.assign(m_data + begin, m_data + end);
+    });
+  }
+
+  void priv_next_block() {
+    if (m_prefetch.valid()) {
+      m_prefetch.get();
+    } else {
+      m_next.clear();  // No block is left
+    }
+    m_current.swap(m_next);
+    m_pos = 0;
+    if (m_fetched < m_size) priv_prefetch();
+  }
+
+  const value_type *m_data;
+  std::size_t m_size;
+  std::size_t m_block_size;
+  std::size_t m_fetched{0};
+  std::size_t m_pos{0};
+  std::vector<value_type> m_current;
+  std::vector<value_type> m_next;
+  std::future<void> m_prefetch;
+};
+
+/// \brief Merges the runs [first_run, last_run) and gives the output to
+/// 'sink' by blocks. The sink runs in another thread while the next block
+/// is merged.
+/// \param bounds The boundaries of the runs in 'runs'.
+/// \param sink A function called as sink(data, n) with a block.
+template <typename value_type, typename compare, typename sink_type>
+inline void merge_runs(const value_type *const runs,
+                       const std::vector<std::size_t> &bounds,
+                       const std::size_t first_run, const std::size_t last_run,
+                       const std::size_t block_size, compare &comp,
+                       sink_type &&sink) {
+  std::vector<std::unique_ptr<run_reader<value_type>>> readers;
+  for (auto r = first_run; r < last_run; ++r) {
+    if (bounds[r] == bounds[r + 1]) continue;
+    readers.push_back(std::make_unique<run_reader<value_type>>(
+        runs + bounds[r], bounds[r + 1] - bounds[r], block_size));
+  }
+
+  // The top of the heap is the reader with the smallest item
+  std::vector<std::size_t> heap(readers.size());
+  for (std::size_t i = 0; i < heap.size(); ++i) heap[i] = i;
+  const auto heap_comp = [&](const std::size_t a, const std::size_t b) {
+    return comp(readers[b]->front(), readers[a]->front());
+  };
+  std::make_heap(heap.begin(), heap.end(), heap_comp);
+
+  std::vector<value_type> out;
+  std::vector<value_type> writing;
+  out.reserve(block_size);
+  std::future<void> write;
+  const auto flush = [&]() {
+    if (write.valid()) write.get();
+    out.swap(writing);
+    out.clear();
+    write = std::async(std::launch::async, [&sink, &writing]() {
+      sink(writing.data(), writing.size());
+    });
+  };
+
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), heap_comp);
+    auto &reader = *readers[heap.back()];
+    out.push_back(reader.front());
+    reader.pop();
+    if (reader.empty()) {
+      heap.pop_back();
+    } else {
+      std::push_heap(heap.begin(), heap.end(), heap_comp);
+    }
+    if (out.size() == block_size) flush();
+  }
+  if (!out.empty()) flush();
+  if (write.valid()) write.get();
+}
+}  // namespace exsdtl
+
+/// \brief Sorts a container larger than the main memory, e.g., a vector in
+/// a datastore, into another container.
+/// First, the input is read sequentially by runs as large as the memory
+/// given, and each run is sorted in memory (parallel_sort()) and written to
+/// a scratch datastore. Then, the runs are merged by blocks, reading the
+/// next block of each run in another thread; if there are more runs than
+/// the memory can merge at once, they are merged into longer runs in the
+/// scratch datastore first. The order of equal items is not kept.
+/// \tparam input_container A container type with random access iterators.
+/// Its items must be plain data, e.g., must not hold pointers.
+/// \tparam output_container A container type with clear(), reserve(), and
+/// insert(end(), first, last), e.g., metall::container::vector.
+/// \param input A container to sort. Can be the object 'output' points to;
+/// the input is not read after the runs are written.
+/// \param output A pointer to a container to store the sorted items.
+/// \param options Options.
+/// \param comp A comparison function.
+/// \return Returns true on success; otherwise, false.
+template <typename input_container, typename output_container,
+          typename compare = std::less<>>
+inline bool external_sort(const input_container &input,
+                          output_container *const output,
+                          const external_sort_options &options,
+                          compare comp = compare()) {
+  using value_type = typename input_container::value_type;
+  // E.g., integers and pairs of them, which can be stored in a datastore
+  static_assert(std::is_trivially_copy_constructible_v<value_type> &&
+                    std::is_trivially_destructible_v<value_type>,
+                "The items must be plain data to store the runs in a "
+                "datastore");
+  using scratch_vector_type =
+      metall::container::vector<value_type,
+                                manager::allocator_type<value_type>>;
+
+  if (options.scratch_path.empty()) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "No scratch datastore path is given");
+    return false;
+  }
+
+  bool succeeded = false;
+  try {
+    const std::size_t n = std::distance(input.begin(), input.end());
+    const std::size_t run_size =
+        std::max(options.memory_bytes / sizeof(value_type), std::size_t(1));
+    const std::size_t block_size =
+        std::max(options.block_bytes / sizeof(value_type), std::size_t(1));
+    // Each run being merged has a block and the block read ahead
+    const std::size_t max_num_merging_runs =
+        std::max(options.memory_bytes / (block_size * sizeof(value_type) * 2),
+                 std::size_t(2));
+
+    manager::remove(options.scratch_path);
+    manager scratch(create_only, options.scratch_path);
+    auto *runs = scratch.construct<scratch_vector_type>(anonymous_instance)(
+        scratch.get_allocator());
+    runs->reserve(n);
+
+    // Generates sorted runs
+    std::vector<std::size_t> bounds{0};
+    {
+      std::vector<value_type> buffer;
+      for (std::size_t begin = 0; begin < n; begin += run_size) {
+        const auto end = std::min(n, begin + run_size);
+        buffer.assign(std::next(input.begin(), begin),
+                      std::next(input.begin(), end));
+        parallel_sort(buffer.begin(), buffer.end(), comp);
+        runs->insert(runs->end(), buffer.begin(), buffer.end());
+        bounds.push_back(end);
+      }
+    }
+
+    // Merges the runs until they can be merged at once
+    scratch_vector_type *merged = nullptr;
+    while (bounds.size() - 1 > max_num_merging_runs) {
+      if (!merged) {
+        merged = scratch.construct<scratch_vector_type>(anonymous_instance)(
+            scratch.get_allocator());
+        merged->reserve(n);
+      }
+      merged->clear();
+      std::vector<std::size_t> merged_bounds{0};
+      const auto num_runs = bounds.size() - 1;
+      const auto append = [merged](const value_type *data, std::size_t k) {
+        merged->insert(merged->end(), data, data + k);
+      };
+      for (std::size_t r = 0; r < num_runs; r += max_num_merging_runs) {
+        const auto last_run = std::min(r + max_num_merging_runs, num_runs);
+        exsdtl::merge_runs(metall::to_raw_pointer(runs->data()), bounds, r,
+                           last_run, block_size, comp, append);
+        merged_bounds.push_back(merged->size());
+      }
+      std::swap(runs, merged);
+      bounds = std::move(merged_bounds);
+    }
+
+    output->clear();
+    output->reserve(n);
+    const auto append = [output](const value_type *data, std::size_t k) {
+      output->insert(output->end(), data, data + k);
+    };
+    exsdtl::merge_runs(metall::to_raw_pointer(runs->data()), bounds, 0,
+                       bounds.size() - 1, block_size, comp, append);
+    succeeded = true;
+  } catch (...) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "An exception has been thrown");
+  }
+
+  // The scratch datastore is closed by here
+  if (!manager::remove(options.scratch_path)) {
+    logger::out(logger::level::warning, __FILE__, __LINE__,
+                "Failed to remove the scratch datastore");
+  }
+  return succeeded;
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_EXTERNAL_SORT_HPP
@@ -0,0 +1,120 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_FAULT_AWARE_SCHEDULER_HPP
+#define METALL_UTILITY_FAULT_AWARE_SCHEDULER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+
+#include <metall/detail/mmap.hpp>
+
+namespace metall::utility {
+
+/// \brief An experimental scheduler that runs many lookups in one thread,
+/// switching to another lookup instead of blocking on a page fault, e.g., to
+/// traverse a datastore larger than memory while keeping the storage busy.
+/// A lookup is a task that runs in steps. Each step returns the address the
+/// next step accesses; if its page is not resident in memory (mincore(2)),
+/// the scheduler asks the OS to read it in the background
+/// (madvise(MADV_WILLNEED)) and runs other tasks until the page arrives.
+/// The checks cost a system call per step; thus, this is for data that are
+/// mostly not in memory.
+/// \warning This is an experimental API in C++17; a step is a function
+/// called again instead of a coroutine resumed.
+class fault_aware_scheduler {
+ public:
+  /// \brief A task. Does a step at each call and returns the address the next
+  /// step accesses, or nullptr if the task is done.
+  using task_type = std::function<const void *()>;
+
+  /// \brief Constructor.
+  /// \param max_num_tasks_in_flight The maximum number of tasks started and
+  /// not done, which bounds the number of reads in flight.
+  explicit fault_aware_scheduler(
+      const std::size_t max_num_tasks_in_flight = 64)
+      : m_max_num_tasks_in_flight(
+            std::max(max_num_tasks_in_flight, std::size_t(1))) {}
+
+  /// \brief Adds a task. The task starts in run().
+  void submit(task_type task) { m_new_tasks.push_back(std::move(task)); }
+
+  /// \brief Runs all tasks submitted, including the ones submitted by the
+  /// tasks, until they are done.
+  void run() {
+    while (!m_new_tasks.empty() || !m_ready_tasks.empty() ||
+           !m_waiting_tasks.empty()) {
+      while (!m_new_tasks.empty() &&
+             m_ready_tasks.size() + m_waiting_tasks.size() <
+                 m_max_num_tasks_in_flight) {
+        m_ready_tasks.push_back(std::move(m_new_tasks.front()));
+        m_new_tasks.pop_front();
+      }
+
+      if (!m_ready_tasks.empty()) {
+        auto task = std::move(m_ready_tasks.front());
+        m_ready_tasks.pop_front();
+        priv_run_until_fault(std::move(task));
+      } else {
+        priv_wake_waiting_tasks();
+      }
+    }
+  }
+
+  /// \brief Returns the number of steps deferred because their pages were not
+  /// resident.
+  std::size_t num_deferred_steps() const { return m_num_deferred_steps; }
+
+ private:
+  struct waiting_task {
+    task_type task;
+    const void *addr;
+  };
+
+  /// \brief Runs the steps of a task while their pages are resident.
+  void priv_run_until_fault(task_type task) {
+    while (const void *const addr = task()) {
+      if (!mtlldetail::is_page_resident(addr)) {
+        mtlldetail::advise_will_need(addr, 1);
+        ++m_num_deferred_steps;
+        m_waiting_tasks.push_back(waiting_task{std::move(task), addr});
+        return;
+      }
+    }
+  }
+
+  /// \brief Moves the waiting tasks whose pages have arrived to the ready
+  /// queue. If none has arrived, the oldest one is moved so that no time is
+  /// spent on polling; it takes the page fault, after its read was issued.
+  void priv_wake_waiting_tasks() {
+    const auto num_waiting = m_waiting_tasks.size();
+    for (std::size_t i = 0; i < num_waiting; ++i) {
+      auto waiting = std::move(m_waiting_tasks.front());
+      m_waiting_tasks.pop_front();
+      if (mtlldetail::is_page_resident(waiting.addr)) {
+        m_ready_tasks.push_back(std::move(waiting.task));
+      } else {
+        m_waiting_tasks.push_back(std::move(waiting));
+      }
+    }
+    if (m_ready_tasks.empty() && !m_waiting_tasks.empty()) {
+      m_ready_tasks.push_back(std::move(m_waiting_tasks.front().task));
+      m_waiting_tasks.pop_front();
+    }
+  }
+
+  std::size_t m_max_num_tasks_in_flight;
+  std::size_t m_num_deferred_steps{0};
+  std::deque<task_type> m_new_tasks;
+  std::deque<task_type> m_ready_tasks;
+  std::deque<waiting_task> m_waiting_tasks;
+};
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_FAULT_AWARE_SCHEDULER_HPP
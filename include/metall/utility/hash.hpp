@@ -22,6 +22,24 @@ using hash = metall::mtlldetail::hash<seed>;
 template <unsigned int seed = 123>
 using str_hash = metall::mtlldetail::str_hash<seed>;
 
+/// \brief Same as hash but uses wyhash, which is faster than the default
+/// (MurmurHash2), especially for short keys.
+/// The hash values differ from the ones of hash.
+/// \tparam T Data type to hash.
+/// If void is specified, the hash data type is determined by () operator.
+/// \tparam seed A seed value used for hashing.
+template <typename T = void, unsigned int seed = 123>
+using wy_hash = metall::mtlldetail::wy_hash<seed>;
+
+/// \brief Same as str_hash but uses wyhash.
+/// \tparam seed A seed value used for hashing.
+template <unsigned int seed = 123>
+using wy_str_hash = metall::mtlldetail::wy_str_hash<seed>;
+
+/// \brief Hashes keys in a batch, e.g., to compute the hashes of bulk
+/// lookups ahead of probing. See metall::mtlldetail::hash_batch.
+using metall::mtlldetail::hash_batch;
+
 }  // namespace metall::utility
 
 #endif  // METALL_UTILITY_HASH_HPP
@@ -6,12 +6,18 @@
 #ifndef METALL_UTILITY_METALL_MPI_ADAPTOR_HPP
 #define METALL_UTILITY_METALL_MPI_ADAPTOR_HPP
 
+#include <algorithm>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include <metall/metall.hpp>
 #include <metall/detail/file.hpp>
+#include <metall/detail/file_clone.hpp>
+#include <metall/detail/directory_sync.hpp>
 #include <metall/utility/mpi.hpp>
 #include <metall/utility/metall_mpi_datastore.hpp>
+#include <metall/utility/mpi_memory_statistics.hpp>
 
 namespace metall::utility {
 
@@ -29,6 +35,14 @@ class metall_mpi_adaptor {
   /// \brief Metall manager type
   using manager_type = metall::manager;
 
+  /// \brief Memory usage statistics of all processes
+  /// (see get_memory_statistics()).
+  using memory_statistics_type = mpi_memory_statistics;
+
+  /// \brief The default max number of processes on a node that copy their
+  /// local datastores at the same time in copy() and snapshot().
+  static constexpr int default_max_copies_per_node = 1;
+
   // -------------------- //
   // Constructor & assign operator
   // -------------------- //
@@ -110,10 +124,84 @@ class metall_mpi_adaptor {
         capacity);
   }
 
+  /// \brief Opens an existing Metall datastore, staging it to a faster
+  /// storage, e.g., node-local NVMe or tmpfs.
+  /// Each process copies its sub-datastore under 'staging_dir_prefix' and
+  /// opens the copy; the datastore at 'root_dir_prefix' is not modified
+  /// until drain() is called or this object is destructed, which write back
+  /// only the blocks changed since the last drain.
+  /// \param root_dir_prefix A root directory path of a Metall datastore.
+  /// \param staging_dir_prefix A root directory path to stage the datastore.
+  /// Each process must have its own or node-local one.
+  /// \param comm A MPI communicator.
+  metall_mpi_adaptor(metall::open_only_t, const std::string &root_dir_prefix,
+                     const std::string &staging_dir_prefix,
+                     const MPI_Comm &comm = MPI_COMM_WORLD)
+      : m_mpi_comm(comm),
+        m_root_dir_prefix(root_dir_prefix),
+        m_local_metall_manager(nullptr),
+        m_staging_dir_prefix(staging_dir_prefix) {
+    if (!priv_verify_num_partitions(root_dir_prefix, comm)) {
+      ::MPI_Abort(comm, -1);
+    }
+    priv_stage(true);
+    m_local_metall_manager = std::make_unique<manager_type>(
+        metall::open_only, priv_staged_local_dir_path().c_str());
+  }
+
+  /// \brief Opens an existing Metall datastore with the read-only mode,
+  /// staging it to a faster storage as the constructor above does.
+  /// \param root_dir_prefix A root directory path of a Metall datastore.
+  /// \param staging_dir_prefix A root directory path to stage the datastore.
+  /// \param comm A MPI communicator.
+  metall_mpi_adaptor(metall::open_read_only_t,
+                     const std::string &root_dir_prefix,
+                     const std::string &staging_dir_prefix,
+                     const MPI_Comm &comm = MPI_COMM_WORLD)
+      : m_mpi_comm(comm),
+        m_root_dir_prefix(root_dir_prefix),
+        m_local_metall_manager(nullptr),
+        m_staging_dir_prefix(staging_dir_prefix),
+        m_read_only(true) {
+    if (!priv_verify_num_partitions(root_dir_prefix, comm)) {
+      ::MPI_Abort(comm, -1);
+    }
+    priv_stage(true);
+    m_local_metall_manager = std::make_unique<manager_type>(
+        metall::open_read_only, priv_staged_local_dir_path().c_str());
+  }
+
+  /// \brief Creates a new Metall datastore in a faster storage.
+  /// The datastore is written to 'root_dir_prefix' when drain() is called
+  /// or this object is destructed.
+  /// \param root_dir_prefix A root directory path of a Metall datastore.
+  /// \param staging_dir_prefix A root directory path to stage the datastore.
+  /// \param comm A MPI communicator.
+  /// \param overwrite If true, overwrite an existing datastore.
+  metall_mpi_adaptor(metall::create_only_t, const std::string &root_dir_prefix,
+                     const std::string &staging_dir_prefix,
+                     const MPI_Comm &comm = MPI_COMM_WORLD,
+                     bool overwrite = false)
+      : m_mpi_comm(comm),
+        m_root_dir_prefix(root_dir_prefix),
+        m_local_metall_manager(nullptr),
+        m_staging_dir_prefix(staging_dir_prefix) {
+    priv_setup_root_dir(root_dir_prefix, overwrite, comm);
+    priv_stage(false);
+    m_local_metall_manager = std::make_unique<manager_type>(
+        metall::create_only, priv_staged_local_dir_path().c_str());
+  }
+
   /// \brief Destructor that globally synchronizes the close operations of all
   /// sub-Metall datastores.
+  /// If the datastore is staged, writes back the changes and removes the
+  /// staged one.
   ~metall_mpi_adaptor() {
-    m_local_metall_manager.reset(nullptr);
+    if (staged()) {
+      priv_close_staged();
+    } else {
+      m_local_metall_manager.reset(nullptr);
+    }
     priv_mpi_barrier(m_mpi_comm);
   }
 
@@ -125,6 +213,100 @@ class metall_mpi_adaptor {
   /// \return A reference to a Metall manager object.
   manager_type &get_local_manager() { return *m_local_metall_manager; }
 
+  /// \brief Collects the memory usage of the local datastores of all
+  /// processes and computes the distribution of each value, e.g., the max,
+  /// the mean, and the rank that has the max, to find the processes that use
+  /// much more memory than the others.
+  /// This is a collective operation; every process gets the same result.
+  /// This function is not thread-safe with allocations and deallocations.
+  /// \param stats A pointer to an object to store the statistics.
+  /// \param include_resident_bytes If true, also collects the number of bytes
+  /// of the segments resident in memory (see
+  /// metall::manager::get_memory_statistics()).
+  /// \return Returns true if all processes success;
+  /// otherwise, returns false.
+  bool get_memory_statistics(memory_statistics_type *stats,
+                             const bool include_resident_bytes = false) {
+    manager_type::memory_statistics_type local;
+    const bool ret = m_local_metall_manager->get_memory_statistics(
+        &local, false, include_resident_bytes);
+    if (!priv_global_and(ret, m_mpi_comm)) return false;
+
+    std::size_t local_num_bins = 0;
+    for (const auto &bin : local.bins) {
+      local_num_bins = std::max(local_num_bins, bin.bin_no + 1);
+    }
+    unsigned long long num_bins = local_num_bins;
+    priv_allreduce(&num_bins, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX);
+
+    // The values to reduce: the scalar values followed by the allocated
+    // bytes of each bin
+    double free_bytes = 0;
+    for (const auto &bin : local.bins) free_bytes += bin.free_bytes;
+    const double chunk_bytes = free_bytes + local.allocated_bytes;
+    std::vector<memory_statistics_type::bin_type> bins(num_bins);
+    std::vector<double> values{
+        double(local.segment_size),
+        double(local.resident_bytes),
+        double(local.num_used_chunks),
+        double(local.allocated_bytes),
+        double(local.cached_bytes),
+        free_bytes,
+        (chunk_bytes == 0) ? 0.0 : free_bytes / chunk_bytes,
+        double(m_local_metall_manager->get_num_named_objects()),
+        double(m_local_metall_manager->get_num_unique_objects()),
+        double(m_local_metall_manager->get_num_anonymous_objects())};
+    const std::size_t num_scalars = values.size();
+    values.resize(num_scalars + num_bins, 0.0);
+    std::vector<unsigned long long> object_sizes(num_bins, 0);
+    for (const auto &bin : local.bins) {
+      values[num_scalars + bin.bin_no] = double(bin.allocated_bytes);
+      object_sizes[bin.bin_no] = bin.object_size;
+    }
+
+    const auto dists = priv_distributions(values);
+    priv_allreduce(object_sizes.data(), int(num_bins), MPI_UNSIGNED_LONG_LONG,
+                   MPI_MAX);
+
+    std::size_t i = 0;
+    stats->num_processes = priv_mpi_comm_size(m_mpi_comm);
+    for (auto *dist :
+         {&stats->segment_size, &stats->resident_bytes,
+          &stats->num_used_chunks, &stats->allocated_bytes,
+          &stats->cached_bytes, &stats->free_bytes, &stats->fragmentation,
+          &stats->num_named_objects, &stats->num_unique_objects,
+          &stats->num_anonymous_objects}) {
+      *dist = dists[i++];
+    }
+    stats->bins.clear();
+    for (std::size_t b = 0; b < num_bins; ++b) {
+      const auto &dist = dists[num_scalars + b];
+      if (dist.max == 0) continue;
+      stats->bins.push_back({b, std::size_t(object_sizes[b]), dist});
+    }
+    return true;
+  }
+
+  /// \brief Checks if the datastore is staged to another location.
+  /// \return Returns true if the datastore is staged.
+  bool staged() const { return !m_staging_dir_prefix.empty(); }
+
+  /// \brief Writes back the blocks of the staged datastore changed since the
+  /// last time to the original location.
+  /// Until the datastore is closed, the original one is marked as not
+  /// properly closed as the staged one is.
+  /// Does nothing if the datastore is not staged or is read-only.
+  /// \return Returns true if all processes success;
+  /// otherwise, returns false.
+  bool drain() {
+    bool ret = true;
+    if (staged() && !m_read_only) {
+      m_local_metall_manager->flush();
+      ret = priv_drain();
+    }
+    return priv_global_and(ret, m_mpi_comm);
+  }
+
   /// \brief Returns the Metall manager object of the process.
   /// \return A reference to a Metall manager object.
   const manager_type &get_local_manager() const {
@@ -155,18 +337,34 @@ class metall_mpi_adaptor {
 
   /// \brief Copies a Metall datastore to another location.
   /// The behavior of copying a data store that is open without the read-only
-  /// mode is undefined. \param source_dir_path A path to a source datastore.
+  /// mode is undefined.
+  /// To avoid flooding a parallel file system with file creations, the
+  /// processes on a node copy their local datastores in turn, at most
+  /// 'max_copies_per_node' processes at a time; each copy uses multiple
+  /// threads.
+  /// \param source_dir_path A path to a source datastore.
   /// \param destination_dir_path A path to a destination datastore.
   /// \param comm A MPI communicator.
   /// \param overwrite If true, overwrite an existing datastore.
   /// This mode does not overwrite an existing datastore if it is not Metall
   /// datastore created by the same number of MPI processes.
+  /// \param max_copies_per_node The max number of processes on a node that
+  /// copy at the same time. If 0 or less, all processes copy at once.
+  /// \param clone If true, clones (reflink) the files if the file system
+  /// supports it. One process per node checks it; if cloning is supported,
+  /// all processes on the node clone at once as cloning does not copy data.
+  /// \param max_threads_per_node The max number of threads that the
+  /// processes on a node use in total, divided by the processes copying at
+  /// the same time. If 0 or less, the number of hardware threads is used.
   /// \return Returns true if all processes success;
   /// otherwise, returns false.
   static bool copy(const std::string &source_dir_path,
                    const std::string &destination_dir_path,
                    const MPI_Comm &comm = MPI_COMM_WORLD,
-                   bool overwrite = false) {
+                   bool overwrite = false,
+                   const int max_copies_per_node = default_max_copies_per_node,
+                   const bool clone = true,
+                   const int max_threads_per_node = 0) {
     if (!consistent(source_dir_path, comm)) {
       if (priv_mpi_comm_rank(comm) == 0) {
         std::stringstream ss;
@@ -179,28 +377,60 @@ class metall_mpi_adaptor {
     }
     priv_setup_root_dir(destination_dir_path, overwrite, comm);
     const int rank = priv_mpi_comm_rank(comm);
-    return priv_global_and(
-        manager_type::copy(
-            ds::make_local_dir_path(source_dir_path, rank).c_str(),
-            ds::make_local_dir_path(destination_dir_path, rank).c_str()),
-        comm);
+    const auto local_source_path =
+        ds::make_local_dir_path(source_dir_path, rank);
+    const auto schedule =
+        priv_schedule_copy(local_source_path, destination_dir_path, clone,
+                           max_copies_per_node, max_threads_per_node, comm);
+    const bool ret =
+        priv_run_staggered(comm, schedule.max_copies_per_node, [&]() {
+          return manager_type::copy(
+              local_source_path.c_str(),
+              ds::make_local_dir_path(destination_dir_path, rank).c_str(),
+              schedule.clone, schedule.num_threads);
+        });
+    return priv_global_and(ret, comm);
   }
 
   /// \brief Take a snapshot of the current Metall datastore to another
-  /// location. \param destination_dir_path A path to a destination datastore.
+  /// location.
+  /// The processes on a node take snapshots in turn and share the threads as
+  /// copy() does.
+  /// If the datastore is staged, also drains it (see drain()).
+  /// \param destination_dir_path A path to a destination datastore.
   /// \param overwrite If true, overwrite an existing datastore.
   /// This mode does not overwrite an existing datastore if it is not Metall
   /// datastore created by the same number of MPI processes.
+  /// \param max_copies_per_node The max number of processes on a node that
+  /// take snapshots at the same time. If 0 or less, all processes take
+  /// snapshots at once.
+  /// \param clone If true, clones (reflink) the files if the file system
+  /// supports it (see copy()).
+  /// \param max_threads_per_node The max number of threads that the
+  /// processes on a node use in total. If 0 or less, the number of hardware
+  /// threads is used.
   /// \return Returns true if all processes success;
   /// otherwise, returns false.
   bool snapshot(const std::string &destination_dir_path,
-                bool overwrite = false) {
+                bool overwrite = false,
+                const int max_copies_per_node = default_max_copies_per_node,
+                const bool clone = true, const int max_threads_per_node = 0) {
+    if (!drain()) return false;
     priv_setup_root_dir(destination_dir_path, overwrite, m_mpi_comm);
     const int rank = priv_mpi_comm_rank(m_mpi_comm);
-    return priv_global_and(
-        m_local_metall_manager->snapshot(
-            ds::make_local_dir_path(destination_dir_path, rank).c_str()),
-        m_mpi_comm);
+    const auto local_source_path =
+        staged() ? priv_staged_local_dir_path()
+                 : ds::make_local_dir_path(m_root_dir_prefix, rank);
+    const auto schedule = priv_schedule_copy(
+        local_source_path, destination_dir_path, clone, max_copies_per_node,
+        max_threads_per_node, m_mpi_comm);
+    const bool ret =
+        priv_run_staggered(m_mpi_comm, schedule.max_copies_per_node, [&]() {
+          return m_local_metall_manager->snapshot(
+              ds::make_local_dir_path(destination_dir_path, rank).c_str(),
+              schedule.clone, schedule.num_threads);
+        });
+    return priv_global_and(ret, m_mpi_comm);
   }
 
   /// \brief Removes Metall datastore.
@@ -212,7 +442,6 @@ class metall_mpi_adaptor {
   static bool remove(const std::string &root_dir_prefix,
                      const MPI_Comm &comm = MPI_COMM_WORLD) {
     const int rank = priv_mpi_comm_rank(comm);
-    const int size = priv_mpi_comm_size(comm);
 
     if (!metall::mtlldetail::file_exist(
             ds::make_root_dir_path(root_dir_prefix))) {
@@ -241,21 +470,16 @@ class metall_mpi_adaptor {
     }
 
     // ----- Remove directories ----- //
-    bool ret = true;
-    for (int i = 0; i < size; ++i) {
-      if (i == rank) {
-        if (metall::mtlldetail::file_exist(
-                ds::make_root_dir_path(root_dir_prefix)) &&
-            !metall::mtlldetail::remove_file(
-                ds::make_root_dir_path(root_dir_prefix))) {
-          std::string s("Failed to remove directory: " +
-                        ds::make_root_dir_path(root_dir_prefix));
-          logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
-          ret = false;
-        }
+    const bool ret = priv_run_once_per_storage(comm, [&root_dir_prefix]() {
+      const auto root_dir_path = ds::make_root_dir_path(root_dir_prefix);
+      if (metall::mtlldetail::file_exist(root_dir_path) &&
+          !metall::mtlldetail::remove_file(root_dir_path)) {
+        std::string s("Failed to remove directory: " + root_dir_path);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        return false;
       }
-      priv_mpi_barrier(comm);
-    }
+      return true;
+    });
 
     return priv_global_and(ret, comm);
   }
@@ -282,15 +506,166 @@ class metall_mpi_adaptor {
     return priv_global_and(ret, comm);
   }
 
+  /// \brief Opens existing Metall datastores, e.g., per-shard ones.
+  /// Each process opens its local datastores in parallel (see
+  /// metall::manager::open_many()).
+  /// \param root_dir_prefixes Root directory paths of Metall datastores.
+  /// \param comm A MPI communicator.
+  /// \return Returns the adaptors in the order of 'root_dir_prefixes'.
+  /// Returns an empty vector if any process failed to open any local
+  /// datastore.
+  static std::vector<std::unique_ptr<metall_mpi_adaptor>> open_many(
+      metall::open_only_t, const std::vector<std::string> &root_dir_prefixes,
+      const MPI_Comm &comm = MPI_COMM_WORLD) {
+    return priv_open_many(root_dir_prefixes, false, comm);
+  }
+
+  /// \brief Opens existing Metall datastores with the read-only mode.
+  /// See open_many() above.
+  /// \param root_dir_prefixes Root directory paths of Metall datastores.
+  /// \param comm A MPI communicator.
+  /// \return Returns the adaptors in the order of 'root_dir_prefixes'.
+  /// Returns an empty vector if any process failed to open any local
+  /// datastore.
+  static std::vector<std::unique_ptr<metall_mpi_adaptor>> open_many(
+      metall::open_read_only_t,
+      const std::vector<std::string> &root_dir_prefixes,
+      const MPI_Comm &comm = MPI_COMM_WORLD) {
+    return priv_open_many(root_dir_prefixes, true, comm);
+  }
+
  private:
   static constexpr const char *k_datastore_mark_file_name =
       "metall_mpi_datastore";
   static constexpr const char *k_partition_size_file_name =
       "metall_mpi_adaptor_partition_size";
 
+  /// \brief How the processes on a node copy their local datastores.
+  struct copy_schedule {
+    bool clone;
+    int max_copies_per_node;
+    int num_threads;
+  };
+
+  // -------------------- //
+  // Private constructor
+  // -------------------- //
+  /// \brief Takes a local manager opened by open_many().
+  metall_mpi_adaptor(const std::string &root_dir_prefix,
+                     std::unique_ptr<manager_type> local_manager,
+                     const bool read_only, const MPI_Comm &comm)
+      : m_mpi_comm(comm),
+        m_root_dir_prefix(root_dir_prefix),
+        m_local_metall_manager(std::move(local_manager)),
+        m_read_only(read_only) {}
+
   // -------------------- //
   // Private methods
   // -------------------- //
+  static std::vector<std::unique_ptr<metall_mpi_adaptor>> priv_open_many(
+      const std::vector<std::string> &root_dir_prefixes, const bool read_only,
+      const MPI_Comm &comm) {
+    const int rank = priv_mpi_comm_rank(comm);
+    std::vector<manager_type::path_type> local_paths;
+    for (const auto &root_dir_prefix : root_dir_prefixes) {
+      if (!priv_verify_num_partitions(root_dir_prefix, comm)) {
+        ::MPI_Abort(comm, -1);
+      }
+      local_paths.emplace_back(
+          ds::make_local_dir_path(root_dir_prefix, rank));
+    }
+
+    auto managers =
+        read_only ? manager_type::open_many(metall::open_read_only, local_paths)
+                  : manager_type::open_many(metall::open_only, local_paths);
+    const bool ret = std::all_of(managers.begin(), managers.end(),
+                                 [](const auto &m) { return bool(m); });
+    if (!priv_global_and(ret, comm)) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to open the datastores");
+      return {};
+    }
+
+    std::vector<std::unique_ptr<metall_mpi_adaptor>> adaptors;
+    for (std::size_t i = 0; i < managers.size(); ++i) {
+      adaptors.emplace_back(new metall_mpi_adaptor(
+          root_dir_prefixes[i], std::move(managers[i]), read_only, comm));
+    }
+    return adaptors;
+  }
+
+  std::string priv_staged_local_dir_path() const {
+    return ds::make_local_dir_path(m_staging_dir_prefix,
+                                   priv_mpi_comm_rank(m_mpi_comm));
+  }
+
+  /// \brief Prepares the local staging directory.
+  /// \param copy If true, copies the local datastore to the staging
+  /// directory.
+  void priv_stage(const bool copy) {
+    const auto origin = ds::make_local_dir_path(
+        m_root_dir_prefix, priv_mpi_comm_rank(m_mpi_comm));
+    const auto staged_path = priv_staged_local_dir_path();
+
+    // Leftovers of a job that did not finish properly
+    bool ret = metall::mtlldetail::remove_file(staged_path) &&
+               metall::mtlldetail::create_directory(
+                   ds::make_root_dir_path(m_staging_dir_prefix));
+    if (ret && copy) {
+      ret = manager_type::copy(origin.c_str(), staged_path.c_str());
+    }
+    if (ret && copy && !m_read_only) {
+      ret = metall::mtlldetail::compute_block_checksums(staged_path, 0,
+                                                        &m_staged_checksums);
+    }
+    if (!ret) {
+      std::string s("Failed to stage " + origin + " to " + staged_path);
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+    }
+    if (!priv_global_and(ret, m_mpi_comm)) {
+      ::MPI_Abort(m_mpi_comm, -1);
+    }
+  }
+
+  bool priv_drain() {
+    const auto origin = ds::make_local_dir_path(
+        m_root_dir_prefix, priv_mpi_comm_rank(m_mpi_comm));
+    if (!metall::mtlldetail::sync_changed_blocks(priv_staged_local_dir_path(),
+                                                 origin, m_staged_checksums, 0,
+                                                 &m_staged_checksums)) {
+      std::string s("Failed to write back the staged datastore to " + origin);
+      logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  void priv_close_staged() {
+    bool ret = true;
+    if (!m_read_only) {
+      // Drains the data first, which also removes the properly closed mark
+      // from the original datastore, and then the management data written
+      // at close with the mark. Thus, the original datastore never looks
+      // properly closed while being partially written.
+      m_local_metall_manager->flush();
+      ret = priv_drain();
+      m_local_metall_manager.reset(nullptr);
+      ret = ret && priv_drain();
+    } else {
+      m_local_metall_manager.reset(nullptr);
+    }
+    if (!ret) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to write back the staged datastore; the staged one "
+                  "is left as is");
+      return;
+    }
+    if (!metall::mtlldetail::remove_file(priv_staged_local_dir_path())) {
+      std::string s("Failed to remove " + priv_staged_local_dir_path());
+      logger::out(logger::level::warning, __FILE__, __LINE__, s.c_str());
+    }
+  }
+
   static void priv_remove_for_overwrite(const std::string &root_dir_prefix,
                                         const MPI_Comm &comm) {
     if (!remove(root_dir_prefix, comm)) {
@@ -306,7 +681,6 @@ class metall_mpi_adaptor {
   static void priv_setup_root_dir(const std::string &root_dir_prefix,
                                   bool overwrite, const MPI_Comm &comm) {
     const int rank = priv_mpi_comm_rank(comm);
-    const int size = priv_mpi_comm_size(comm);
     const std::string root_dir_path = ds::make_root_dir_path(root_dir_prefix);
 
     if (overwrite) {
@@ -326,26 +700,118 @@ class metall_mpi_adaptor {
     }
     priv_mpi_barrier(comm);
 
-    for (int i = 0; i < size; ++i) {
-      if (i == rank && !metall::mtlldetail::directory_exist(root_dir_path)) {
-        if (!metall::mtlldetail::create_directory(root_dir_path)) {
-          std::string s("Failed to create directory: " + root_dir_path);
-          logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
-          ::MPI_Abort(comm, -1);
-        }
-
-        const std::string mark_file =
-            root_dir_path + "/" + k_datastore_mark_file_name;
-        if (!metall::mtlldetail::create_file(mark_file)) {
-          std::string s("Failed to create file: " + mark_file);
-          logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
-          ::MPI_Abort(comm, -1);
-        }
-
-        priv_store_partition_size(root_dir_prefix, comm);
+    priv_run_once_per_storage(comm, [&root_dir_prefix, &root_dir_path,
+                                     &comm]() {
+      if (metall::mtlldetail::directory_exist(root_dir_path)) return true;
+
+      if (!metall::mtlldetail::create_directory(root_dir_path)) {
+        std::string s("Failed to create directory: " + root_dir_path);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        ::MPI_Abort(comm, -1);
       }
-      priv_mpi_barrier(comm);
+
+      const std::string mark_file =
+          root_dir_path + "/" + k_datastore_mark_file_name;
+      if (!metall::mtlldetail::create_file(mark_file)) {
+        std::string s("Failed to create file: " + mark_file);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        ::MPI_Abort(comm, -1);
+      }
+
+      priv_store_partition_size(root_dir_prefix, comm);
+      return true;
+    });
+  }
+
+  /// \brief Calls 'func' on rank 0 first, then on the lowest rank of each
+  /// node, and finally on the other ranks, with a barrier between them.
+  /// 'func' is supposed to do something to the root directory only if it
+  /// has not been done yet, e.g., create the root directory if it does not
+  /// exist. Thus, on a shared file system, only rank 0 modifies the file
+  /// system while the other ranks just see the result; on node-local
+  /// storage, one rank per node does.
+  /// \return Returns the logical 'and' of the local results of 'func'.
+  template <typename function_type>
+  static bool priv_run_once_per_storage(const MPI_Comm &comm,
+                                        const function_type &func) {
+    const int rank = priv_mpi_comm_rank(comm);
+    auto node_comm = priv_split_node_comm(comm);
+    const int node_rank = priv_mpi_comm_rank(node_comm);
+
+    bool ret = true;
+    if (rank == 0) ret = func();
+    priv_mpi_barrier(comm);
+    if (rank != 0 && node_rank == 0) ret = func();
+    priv_mpi_barrier(comm);
+    if (rank != 0 && node_rank != 0) ret = func();
+    priv_mpi_barrier(comm);
+
+    priv_mpi_comm_free(node_comm);
+    return ret;
+  }
+
+  /// \brief Calls 'func' on all ranks, letting at most 'max_per_node' ranks
+  /// on a node call it at the same time.
+  /// Only the ranks on the same node synchronize with each other.
+  /// \return Returns the local result of 'func'.
+  template <typename function_type>
+  static bool priv_run_staggered(const MPI_Comm &comm, const int max_per_node,
+                                 const function_type &func) {
+    if (max_per_node <= 0) return func();
+
+    auto node_comm = priv_split_node_comm(comm);
+    const int node_rank = priv_mpi_comm_rank(node_comm);
+    const int node_size = priv_mpi_comm_size(node_comm);
+
+    bool ret = true;
+    for (int turn = 0; turn * max_per_node < node_size; ++turn) {
+      if (node_rank / max_per_node == turn) ret = func();
+      priv_mpi_barrier(node_comm);
+    }
+
+    priv_mpi_comm_free(node_comm);
+    return ret;
+  }
+
+  /// \brief Lets the lowest rank of each node choose between cloning and
+  /// copying for the processes on the node, checking if the file system
+  /// supports cloning, and divide the threads among the processes copying at
+  /// the same time so that they do not oversubscribe the local storage.
+  /// The root directory of the destination must exist.
+  static copy_schedule priv_schedule_copy(const std::string &local_source_path,
+                                          const std::string &destination_prefix,
+                                          const bool clone,
+                                          const int max_copies_per_node,
+                                          const int max_threads_per_node,
+                                          const MPI_Comm &comm) {
+    auto node_comm = priv_split_node_comm(comm);
+    const int node_size = priv_mpi_comm_size(node_comm);
+
+    int schedule[3] = {0, 0, 1};
+    if (priv_mpi_comm_rank(node_comm) == 0) {
+      const bool cloned =
+          clone && metall::mtlldetail::clone_supported(
+                       local_source_path,
+                       ds::make_root_dir_path(destination_prefix));
+      // Cloning copies only metadata, so all processes can clone at once
+      const int num_copies = (cloned || max_copies_per_node <= 0)
+                                 ? node_size
+                                 : std::min(max_copies_per_node, node_size);
+      const int num_threads = (max_threads_per_node > 0)
+                                  ? max_threads_per_node
+                                  : int(std::thread::hardware_concurrency());
+      schedule[0] = cloned;
+      schedule[1] = cloned ? 0 : max_copies_per_node;
+      schedule[2] = std::max(1, num_threads / num_copies);
     }
+    if (::MPI_Bcast(schedule, 3, MPI_INT, 0, node_comm) != MPI_SUCCESS) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed MPI_Bcast");
+      ::MPI_Abort(comm, -1);
+    }
+
+    priv_mpi_comm_free(node_comm);
+    return copy_schedule{schedule[0] != 0, schedule[1], schedule[2]};
   }
 
   static void priv_store_partition_size(const std::string &root_dir_prefix,
@@ -424,6 +890,59 @@ class metall_mpi_adaptor {
     return size;
   }
 
+  static MPI_Comm priv_split_node_comm(const MPI_Comm &comm) {
+    const auto node_comm = mpi::comm_split_shared(comm);
+    if (node_comm == MPI_COMM_NULL) {
+      ::MPI_Abort(comm, -1);
+    }
+    return node_comm;
+  }
+
+  static void priv_mpi_comm_free(MPI_Comm &comm) {
+    if (!mpi::comm_free(comm)) {
+      ::MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+  }
+
+  void priv_allreduce(void *const buf, const int count,
+                      const MPI_Datatype datatype, const MPI_Op op) const {
+    if (::MPI_Allreduce(MPI_IN_PLACE, buf, count, datatype, op, m_mpi_comm) !=
+        MPI_SUCCESS) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed MPI_Allreduce");
+      ::MPI_Abort(m_mpi_comm, -1);
+    }
+  }
+
+  /// \brief Computes the distribution of each value over the processes.
+  std::vector<mpi_value_distribution> priv_distributions(
+      const std::vector<double> &values) const {
+    const int count = int(values.size());
+    std::vector<double> min(values), total(values);
+    priv_allreduce(min.data(), count, MPI_DOUBLE, MPI_MIN);
+    priv_allreduce(total.data(), count, MPI_DOUBLE, MPI_SUM);
+
+    struct value_rank {
+      double value;
+      int rank;
+    };
+    const int rank = priv_mpi_comm_rank(m_mpi_comm);
+    std::vector<value_rank> max(count);
+    for (int i = 0; i < count; ++i) max[i] = {values[i], rank};
+    priv_allreduce(max.data(), count, MPI_DOUBLE_INT, MPI_MAXLOC);
+
+    const double size = priv_mpi_comm_size(m_mpi_comm);
+    std::vector<mpi_value_distribution> dists(count);
+    for (int i = 0; i < count; ++i) {
+      dists[i].min = min[i];
+      dists[i].max = max[i].value;
+      dists[i].mean = total[i] / size;
+      dists[i].total = total[i];
+      dists[i].max_rank = max[i].rank;
+    }
+    return dists;
+  }
+
   static void priv_mpi_barrier(const MPI_Comm &comm) {
     if (!mpi::barrier(comm)) {
       ::MPI_Abort(comm, -1);
@@ -459,6 +978,9 @@ class metall_mpi_adaptor {
   MPI_Comm m_mpi_comm;
   std::string m_root_dir_prefix;
   std::unique_ptr<manager_type> m_local_metall_manager;
+  std::string m_staging_dir_prefix{};
+  bool m_read_only{false};
+  metall::mtlldetail::block_checksum_table m_staged_checksums{};
 };
 
 }  // namespace metall::utility
@@ -0,0 +1,221 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_METALL_MPI_REPARTITION_HPP
+#define METALL_UTILITY_METALL_MPI_REPARTITION_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/utility/mpi.hpp>
+#include <metall/utility/metall_mpi_adaptor.hpp>
+
+namespace metall::utility {
+
+namespace mpi_repartition_detail {
+
+/// \brief The max number of bytes a rank sends to another rank in a single
+/// MPI_Alltoallv call.
+constexpr std::size_t k_max_chunk_size = std::size_t(1) << 28;
+
+/// \brief Returns the chunk size that keeps the total number of bytes a rank
+/// receives in a MPI_Alltoallv call within int.
+inline std::size_t chunk_size(const int comm_size) {
+  return std::max(std::size_t(1),
+                  std::min(k_max_chunk_size, std::size_t(INT_MAX) / comm_size));
+}
+
+inline bool abort_on_error(const bool ok, const MPI_Comm &comm,
+                           const char *const msg) {
+  if (!ok) {
+    logger::out(logger::level::error, __FILE__, __LINE__, msg);
+    ::MPI_Abort(comm, -1);
+  }
+  return ok;
+}
+
+/// \brief Sends every send_buf[i] to rank i and appends the data received
+/// from rank i to recv_buf[i].
+/// The data is sent in chunks so that the counts and displacements fit into
+/// int.
+inline void all_to_all(const std::vector<std::vector<char>> &send_buf,
+                       std::vector<std::vector<char>> &recv_buf,
+                       const MPI_Comm &comm) {
+  const int size = mpi::comm_size(comm);
+  const std::size_t chunk = chunk_size(size);
+
+  std::size_t local_max = 0;
+  for (const auto &buf : send_buf) local_max = std::max(local_max, buf.size());
+  unsigned long long num_steps = (local_max + chunk - 1) / chunk;
+  abort_on_error(::MPI_Allreduce(MPI_IN_PLACE, &num_steps, 1,
+                                 MPI_UNSIGNED_LONG_LONG, MPI_MAX,
+                                 comm) == MPI_SUCCESS,
+                 comm, "Failed MPI_Allreduce");
+
+  std::vector<int> send_counts(size), send_displs(size);
+  std::vector<int> recv_counts(size), recv_displs(size);
+  std::vector<char> send_chunk, recv_chunk;
+  for (unsigned long long step = 0; step < num_steps; ++step) {
+    const std::size_t offset = step * chunk;
+    send_chunk.clear();
+    for (int i = 0; i < size; ++i) {
+      const auto &buf = send_buf[i];
+      const std::size_t begin = std::min(offset, buf.size());
+      const std::size_t end = std::min(offset + chunk, buf.size());
+      send_displs[i] = static_cast<int>(send_chunk.size());
+      send_counts[i] = static_cast<int>(end - begin);
+      send_chunk.insert(send_chunk.end(), buf.begin() + begin,
+                        buf.begin() + end);
+    }
+
+    abort_on_error(::MPI_Alltoall(send_counts.data(), 1, MPI_INT,
+                                  recv_counts.data(), 1, MPI_INT,
+                                  comm) == MPI_SUCCESS,
+                   comm, "Failed MPI_Alltoall");
+
+    std::size_t total = 0;
+    for (int i = 0; i < size; ++i) total += recv_counts[i];
+    recv_chunk.resize(total);
+    for (int i = 0, displ = 0; i < size; ++i) {
+      recv_displs[i] = displ;
+      displ += recv_counts[i];
+    }
+
+    abort_on_error(
+        ::MPI_Alltoallv(send_chunk.data(), send_counts.data(),
+                        send_displs.data(), MPI_CHAR, recv_chunk.data(),
+                        recv_counts.data(), recv_displs.data(), MPI_CHAR,
+                        comm) == MPI_SUCCESS,
+        comm, "Failed MPI_Alltoallv");
+
+    for (int i = 0; i < size; ++i) {
+      recv_buf[i].insert(recv_buf[i].end(),
+                         recv_chunk.begin() + recv_displs[i],
+                         recv_chunk.begin() + recv_displs[i] + recv_counts[i]);
+    }
+  }
+}
+
+}  // namespace mpi_repartition_detail
+
+/// \brief The function type given to a reader of repartition() to emit an
+/// item. The first argument is the hash value of the item, which determines
+/// the destination partition. The second one is the serialized item.
+using repartition_emit_type =
+    std::function<void(std::size_t, std::string_view)>;
+
+/// \brief Redistributes the data in a Metall MPI datastore created by N
+/// processes into a new datastore of M processes,
+/// where M is the size of 'comm'.
+/// Thus, data ingested by one job can be opened by a job of a different
+/// scale without the ingest again.
+/// Each process opens a subset of the source partitions, partition i is
+/// opened by rank (i % M), with the read-only mode one by one and calls
+/// 'reader' with the manager of the partition.
+/// 'reader' emits items as pairs of a hash value and serialized bytes;
+/// each item is sent to rank (hash % M) and 'writer' is called with the
+/// local manager of the destination datastore and the serialized bytes.
+/// Items emitted from the same partition with the same hash value are
+/// passed to 'writer' in the emitted order.
+/// As every process opens partitions other than its own, the source
+/// datastore must be on a file system every process can see.
+/// \tparam reader_type The type of the reader, which must be callable as
+/// reader(const metall::manager &source, const repartition_emit_type &emit).
+/// \tparam writer_type The type of the writer, which must be callable as
+/// writer(metall::manager &destination, std::string_view item).
+/// \param source_root_dir_prefix A root directory path of the source
+/// datastore.
+/// \param destination_root_dir_prefix A root directory path of the new
+/// datastore.
+/// \param reader The reader.
+/// \param writer The writer.
+/// \param comm A MPI communicator.
+/// \param overwrite If true, overwrite an existing datastore at
+/// 'destination_root_dir_prefix'.
+/// \return Returns true if all processes success; otherwise, returns false.
+template <typename reader_type, typename writer_type>
+inline bool repartition(const std::string &source_root_dir_prefix,
+                        const std::string &destination_root_dir_prefix,
+                        reader_type reader, writer_type writer,
+                        const MPI_Comm &comm = MPI_COMM_WORLD,
+                        const bool overwrite = false) {
+  namespace rdtl = mpi_repartition_detail;
+
+  const int rank = mpi::comm_rank(comm);
+  const int size = mpi::comm_size(comm);
+  rdtl::abort_on_error(rank >= 0 && size > 0, comm,
+                       "Failed to get the rank or size");
+
+  const int num_source_partitions =
+      metall_mpi_adaptor::partitions(source_root_dir_prefix, comm);
+  const int num_rounds = (num_source_partitions + size - 1) / size;
+
+  metall_mpi_adaptor destination(metall::create_only,
+                                 destination_root_dir_prefix, comm, overwrite);
+  auto &destination_manager = destination.get_local_manager();
+
+  bool ok = true;
+  std::vector<std::vector<char>> send_buf(size);
+  std::vector<std::vector<char>> recv_buf(size);
+  for (int round = 0; round < num_rounds; ++round) {
+    for (auto &buf : send_buf) buf.clear();
+    for (auto &buf : recv_buf) buf.clear();
+
+    const int partition = round * size + rank;
+    if (partition < num_source_partitions) {
+      const auto path = metall_mpi_adaptor::local_dir_path(
+          source_root_dir_prefix, partition);
+      if (!metall::manager::consistent(path.c_str())) {
+        std::string s("Source datastore is not consistent: " + path);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        ok = false;
+      } else if (metall::manager source(metall::open_read_only, path.c_str());
+                 !source.check_sanity()) {
+        std::string s("Failed to open " + path);
+        logger::out(logger::level::error, __FILE__, __LINE__, s.c_str());
+        ok = false;
+      } else {
+        // Each record is the size of an item followed by the item
+        const repartition_emit_type emit =
+            [&send_buf, size](const std::size_t hash,
+                              const std::string_view item) {
+              auto &buf = send_buf[hash % size];
+              const std::size_t item_size = item.size();
+              const auto *const p = reinterpret_cast<const char *>(&item_size);
+              buf.insert(buf.end(), p, p + sizeof(item_size));
+              buf.insert(buf.end(), item.begin(), item.end());
+            };
+        reader(std::as_const(source), emit);
+      }
+    }
+
+    rdtl::all_to_all(send_buf, recv_buf, comm);
+
+    for (const auto &buf : recv_buf) {
+      for (std::size_t pos = 0; pos < buf.size();) {
+        std::size_t item_size;
+        std::memcpy(&item_size, buf.data() + pos, sizeof(item_size));
+        pos += sizeof(item_size);
+        writer(destination_manager,
+               std::string_view(buf.data() + pos, item_size));
+        pos += item_size;
+      }
+    }
+  }
+
+  const auto ret = mpi::global_logical_and(ok, comm);
+  return ret.first && ret.second;
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_METALL_MPI_REPARTITION_HPP
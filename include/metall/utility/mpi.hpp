@@ -48,6 +48,31 @@ inline bool barrier(const MPI_Comm &comm) {
   return true;
 }
 
+/// \brief Splits a communicator into communicators of the processes that
+/// can create shared memory, i.e., the processes on the same node.
+/// \param comm MPI communicator.
+/// \return Returns the new communicator, which must be freed with
+/// comm_free(). On error, returns MPI_COMM_NULL.
+inline MPI_Comm comm_split_shared(const MPI_Comm &comm) {
+  MPI_Comm node_comm = MPI_COMM_NULL;
+  if (::MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, comm_rank(comm),
+                            MPI_INFO_NULL, &node_comm) != MPI_SUCCESS) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed MPI_Comm_split_type");
+    return MPI_COMM_NULL;
+  }
+  return node_comm;
+}
+
+inline bool comm_free(MPI_Comm &comm) {
+  if (::MPI_Comm_free(&comm) != MPI_SUCCESS) {
+    logger::out(logger::level::error, __FILE__, __LINE__,
+                "Failed MPI_Comm_free");
+    return false;
+  }
+  return true;
+}
+
 /// \brief Performs the logical 'and' operation.
 /// \param local_value Local bool value.
 /// \param comm MPI communicator.
@@ -0,0 +1,96 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_MPI_MEMORY_STATISTICS_HPP
+#define METALL_UTILITY_MPI_MEMORY_STATISTICS_HPP
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace metall::utility {
+
+/// \brief Distribution of a value over the MPI processes.
+struct mpi_value_distribution {
+  double min{0};
+  double max{0};
+  double mean{0};
+  double total{0};
+  /// \brief The lowest rank that has the max value.
+  int max_rank{0};
+
+  /// \brief Returns the max divided by the mean, i.e., 1 if the value is
+  /// perfectly balanced. Returns 0 if the mean is 0.
+  double imbalance() const noexcept { return (mean == 0) ? 0.0 : max / mean; }
+
+  std::string to_json() const {
+    std::stringstream ss;
+    ss.precision(15);
+    ss << "{\"min\":" << min << ",\"max\":" << max << ",\"mean\":" << mean
+       << ",\"total\":" << total << ",\"max_rank\":" << max_rank
+       << ",\"imbalance\":" << imbalance() << "}";
+    return ss.str();
+  }
+};
+
+/// \brief Memory usage of a Metall MPI datastore, i.e., the distributions of
+/// the values in metall::manager::memory_statistics_type of the processes.
+struct mpi_memory_statistics {
+  /// \brief The distribution of the allocated bytes of a bin.
+  struct bin_type {
+    std::size_t bin_no{0};
+    std::size_t object_size{0};
+    mpi_value_distribution allocated_bytes;
+  };
+
+  /// \brief The number of processes.
+  int num_processes{0};
+  mpi_value_distribution segment_size;
+  /// \brief 0 if it was not requested.
+  mpi_value_distribution resident_bytes;
+  mpi_value_distribution num_used_chunks;
+  mpi_value_distribution allocated_bytes;
+  mpi_value_distribution cached_bytes;
+  /// \brief The number of bytes in the used chunks not allocated to objects.
+  mpi_value_distribution free_bytes;
+  /// \brief The ratio of the free bytes to the bytes of the used chunks.
+  mpi_value_distribution fragmentation;
+  mpi_value_distribution num_named_objects;
+  mpi_value_distribution num_unique_objects;
+  mpi_value_distribution num_anonymous_objects;
+  /// \brief The bins at least one process has allocated bytes in.
+  std::vector<bin_type> bins;
+
+  /// \brief Returns the statistics as a JSON string.
+  std::string to_json() const {
+    std::stringstream ss;
+    ss << "{\"num_processes\":" << num_processes
+       << ",\"segment_size\":" << segment_size.to_json()
+       << ",\"resident_bytes\":" << resident_bytes.to_json()
+       << ",\"num_used_chunks\":" << num_used_chunks.to_json()
+       << ",\"allocated_bytes\":" << allocated_bytes.to_json()
+       << ",\"cached_bytes\":" << cached_bytes.to_json()
+       << ",\"free_bytes\":" << free_bytes.to_json()
+       << ",\"fragmentation\":" << fragmentation.to_json()
+       << ",\"num_named_objects\":" << num_named_objects.to_json()
+       << ",\"num_unique_objects\":" << num_unique_objects.to_json()
+       << ",\"num_anonymous_objects\":" << num_anonymous_objects.to_json()
+       << ",\"bins\":[";
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+      if (i > 0) ss << ",";
+      ss << "{\"bin_no\":" << bins[i].bin_no
+         << ",\"object_size\":" << bins[i].object_size
+         << ",\"allocated_bytes\":" << bins[i].allocated_bytes.to_json()
+         << "}";
+    }
+    ss << "]}";
+    return ss.str();
+  }
+};
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_MPI_MEMORY_STATISTICS_HPP
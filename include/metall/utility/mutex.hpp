@@ -6,8 +6,20 @@
 #ifndef METALL_UTILITY_MUTEX_HPP
 #define METALL_UTILITY_MUTEX_HPP
 
-#include <mutex>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace metall::utility {
 
@@ -15,17 +27,162 @@ namespace metall::utility {
 /// \brief Namespace for mutex
 namespace mutex {
 
+/// \brief The size of a cache line assumed to pad the mutex banks.
+inline constexpr std::size_t k_cache_line_size = 64;
+
+/// \brief A mutex that spins for a while and then sleeps until it is
+/// unlocked, for critical sections that are mostly short, e.g., an insertion
+/// into a map. Meets the Lockable requirements.
+/// On Linux, a waiting thread sleeps on a futex; on the other systems, it
+/// yields the CPU repeatedly.
+class spin_mutex {
+ public:
+  spin_mutex() noexcept = default;
+  spin_mutex(const spin_mutex &) = delete;
+  spin_mutex &operator=(const spin_mutex &) = delete;
+
+  void lock() noexcept {
+    if (try_lock()) return;
+    for (int i = 0; i < k_num_spins; ++i) {
+      priv_cpu_relax();
+      if (m_state.load(std::memory_order_relaxed) == k_unlocked &&
+          try_lock()) {
+        return;
+      }
+    }
+    // Marks that there may be waiters so that unlock() wakes one up
+    while (m_state.exchange(k_contended, std::memory_order_acquire) !=
+           k_unlocked) {
+      priv_wait();
+    }
+  }
+
+  bool try_lock() noexcept {
+    int expected = k_unlocked;
+    return m_state.compare_exchange_strong(expected, k_locked,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed);
+  }
+
+  void unlock() noexcept {
+    if (m_state.exchange(k_unlocked, std::memory_order_release) ==
+        k_contended) {
+      priv_wake_one();
+    }
+  }
+
+ private:
+  static constexpr int k_unlocked = 0;
+  static constexpr int k_locked = 1;
+  static constexpr int k_contended = 2;
+  static constexpr int k_num_spins = 128;
+
+  static void priv_cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  void priv_wait() noexcept {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<int *>(&m_state), FUTEX_WAIT_PRIVATE,
+              k_contended, nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  void priv_wake_one() noexcept {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<int *>(&m_state), FUTEX_WAKE_PRIVATE,
+              1, nullptr, nullptr, 0);
+#endif
+  }
+
+  static_assert(sizeof(std::atomic<int>) == sizeof(int),
+                "A futex is a 32-bit integer");
+  std::atomic<int> m_state{k_unlocked};
+};
+
+namespace mtxdtl {
+template <typename T, typename = void>
+struct is_shared_lockable : std::false_type {};
+
+template <typename T>
+struct is_shared_lockable<
+    T, std::void_t<decltype(std::declval<T &>().lock_shared()),
+                   decltype(std::declval<T &>().unlock_shared())>>
+    : std::true_type {};
+
+/// \brief A mutex on its own cache line so that the banks next to it do not
+/// false-share it.
+template <typename mutex_type>
+struct alignas(k_cache_line_size) padded_mutex {
+  mutex_type mutex;
+};
+
+/// \brief Returns the static mutexes shared by all callers with the same
+/// template arguments.
+template <int num_banks, typename mutex_type>
+inline padded_mutex<mutex_type> *mutex_bank() {
+  static padded_mutex<mutex_type> mutexes[num_banks];
+  return mutexes;
+}
+}  // namespace mtxdtl
+
+/// \brief True if a mutex type can be locked in the shared mode, e.g.,
+/// std::shared_mutex.
+template <typename mutex_type>
+inline constexpr bool is_shared_lockable_v =
+    mtxdtl::is_shared_lockable<mutex_type>::value;
+
 /// \brief A utility function that returns a mutex lock allocated as a static
 /// object. This is an experimental implementation. Example: { // Mutex region
 ///   const int bank_index = hash(key) % num_banks;
 ///   auto guard = metall::utility::mutex::mutex_lock<num_banks>(bank_index);
 ///   // do some mutex work
 /// }
-template <int num_banks>
-inline std::unique_lock<std::mutex> mutex_lock(const std::size_t index) {
-  static std::mutex mutexes[num_banks];
+/// Each mutex is on its own cache line. The mutex type can be chosen per
+/// use-site, e.g., spin_mutex for short critical sections or
+/// std::shared_mutex to also take shared locks by shared_mutex_lock(); the
+/// callers with the same template arguments share the mutexes.
+/// \tparam num_banks The number of mutexes.
+/// \tparam mutex_type The type of the mutexes.
+template <int num_banks, typename mutex_type = std::mutex>
+inline std::unique_lock<mutex_type> mutex_lock(const std::size_t index) {
+  assert(index < num_banks);
+  return std::unique_lock<mutex_type>(
+      mtxdtl::mutex_bank<num_banks, mutex_type>()[index].mutex);
+}
+
+/// \brief Same as mutex_lock() but does not block; the lock returned does not
+/// own the mutex if another thread holds it, e.g., to pick another mutex.
+/// The calling thread must not hold the mutex.
+/// \tparam num_banks The number of mutexes.
+/// \tparam mutex_type The type of the mutexes.
+template <int num_banks, typename mutex_type = std::mutex>
+inline std::unique_lock<mutex_type> mutex_try_lock(const std::size_t index) {
+  assert(index < num_banks);
+  return std::unique_lock<mutex_type>(
+      mtxdtl::mutex_bank<num_banks, mutex_type>()[index].mutex,
+      std::try_to_lock);
+}
+
+/// \brief Same as mutex_lock() but locks a mutex in the shared mode, e.g.,
+/// for lookups. Excludes the holders of the lock returned by
+/// mutex_lock<num_banks, mutex_type>() with the same index.
+/// \tparam num_banks The number of mutexes.
+/// \tparam mutex_type The type of the mutexes, e.g., std::shared_mutex.
+template <int num_banks, typename mutex_type = std::shared_mutex>
+inline std::shared_lock<mutex_type> shared_mutex_lock(
+    const std::size_t index) {
+  static_assert(is_shared_lockable_v<mutex_type>,
+                "The mutex type cannot be locked in the shared mode");
   assert(index < num_banks);
-  return std::unique_lock<std::mutex>(mutexes[index]);
+  return std::shared_lock<mutex_type>(
+      mtxdtl::mutex_bank<num_banks, mutex_type>()[index].mutex);
 }
 
 }  // namespace mutex
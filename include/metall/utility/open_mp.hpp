@@ -105,6 +105,16 @@ inline int get_num_threads() noexcept {
 #endif
 }
 
+/// \brief Returns the number of threads a parallel region started now would
+/// have at most.
+inline int get_max_threads() noexcept {
+#ifdef _OPENMP
+  return ::omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 inline int get_thread_num() noexcept {
 #ifdef _OPENMP
   return ::omp_get_thread_num();
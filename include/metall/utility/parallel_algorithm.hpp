@@ -0,0 +1,427 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_PARALLEL_ALGORITHM_HPP
+#define METALL_UTILITY_PARALLEL_ALGORITHM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <metall/offset_ptr.hpp>
+#include <metall/detail/memory.hpp>
+#include <metall/utility/open_mp.hpp>
+
+/// \file parallel_algorithm.hpp
+/// \brief Parallel sort, scan, and reduce over random access ranges, e.g.,
+/// the vectors in a datastore, using OpenMP.
+/// Each thread works on a contiguous part of a range whose boundaries are
+/// moved to page boundaries if possible, and a thread works on the same part
+/// in every phase of an algorithm; thus, with a thread affinity (e.g.,
+/// OMP_PROC_BIND=true), the pages a thread touches first stay on its NUMA
+/// node, and threads do not share pages at the boundaries.
+/// The algorithms run sequentially if OpenMP is not enabled or the range is
+/// small. The functions given must not throw.
+
+namespace metall::utility {
+
+namespace pardtl {
+
+namespace mdtl = metall::mtlldetail;
+
+/// \brief Ranges shorter than this are processed sequentially.
+constexpr std::size_t k_min_parallel_size = 1ULL << 14ULL;
+
+/// \brief Returns the beginning of the i-th of 'p' parts of 'n' items of
+/// 'item_size' bytes starting at 'base', moved down to a page boundary if the
+/// parts are large enough.
+inline std::size_t part_begin(const void *const base,
+                              const std::size_t item_size, const std::size_t n,
+                              const std::size_t p, const std::size_t i) {
+  if (i == 0) return 0;
+  if (i >= p) return n;
+  const std::size_t begin = n / p * i + n % p * i / p;
+  static const std::size_t page_size =
+      mdtl::get_page_size() > 0 ? mdtl::get_page_size() : 4096;
+  if (page_size % item_size != 0) return begin;
+  const auto items_per_page = page_size / item_size;
+  // Parts of a few pages are not aligned not to unbalance them
+  if (n / p < items_per_page * 4) return begin;
+  const auto addr = reinterpret_cast<uintptr_t>(base);
+  const auto gap = (page_size - addr % page_size) % page_size;
+  if (gap % item_size != 0) return begin;
+  const auto first_page = gap / item_size;
+  if (begin < first_page + items_per_page) return begin;
+  return first_page +
+         (begin - first_page) / items_per_page * items_per_page;
+}
+
+/// \brief Returns the number of the items taken from 'a' in the first 'k'
+/// items of the stable merge of sorted ranges 'a' and 'b' (merge path).
+template <typename iterator, typename compare>
+inline std::size_t co_rank(const std::size_t k, const iterator a,
+                           const std::size_t na, const iterator b,
+                           const std::size_t nb, compare &comp) {
+  std::size_t lo = (k > nb) ? k - nb : 0;
+  std::size_t hi = std::min(k, na);
+  while (lo < hi) {
+    const auto i = lo + (hi - lo) / 2;
+    const auto j = k - i;
+    // a[i] comes before b[j - 1]. The items of 'a' come first if equal
+    if (j > 0 && !comp(b[j - 1], a[i])) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+/// \brief A part of the merge of two runs: [a_begin, a_end) of the first run
+/// and [b_begin, b_end) of the second one are merged into 'out'.
+struct merge_part {
+  std::size_t a_begin;
+  std::size_t a_end;
+  std::size_t b_begin;
+  std::size_t b_end;
+  std::size_t out;
+};
+
+/// \brief Finds the parts of the merges of the pairs of adjacent runs in
+/// 'src' that write the items whose positions are in [lo, hi).
+/// \param bounds The boundaries of the runs.
+template <typename src_iterator, typename compare>
+inline std::vector<merge_part> split_merges(
+    const src_iterator src, const std::vector<std::size_t> &bounds,
+    const std::size_t lo, const std::size_t hi, compare &comp) {
+  std::vector<merge_part> parts;
+  const auto num_runs = bounds.size() - 1;
+  for (std::size_t r = 0; r < num_runs; r += 2) {
+    const auto begin = bounds[r];
+    const auto mid = bounds[r + 1];
+    const auto end = bounds[std::min(r + 2, num_runs)];
+    if (end <= lo || hi <= begin) continue;
+    const auto k0 = std::max(lo, begin) - begin;
+    const auto k1 = std::min(hi, end) - begin;
+    const auto a = src + begin;
+    const auto b = src + mid;
+    const auto i0 = co_rank(k0, a, mid - begin, b, end - mid, comp);
+    const auto i1 = co_rank(k1, a, mid - begin, b, end - mid, comp);
+    parts.push_back({begin + i0, begin + i1, mid + (k0 - i0), mid + (k1 - i1),
+                     begin + k0});
+  }
+  return parts;
+}
+
+template <typename src_iterator, typename dst_iterator, typename compare>
+inline void merge_parts(const src_iterator src, const dst_iterator dst,
+                        const std::vector<merge_part> &parts,
+                        compare &comp) {
+  for (const auto &part : parts) {
+    std::merge(std::make_move_iterator(src + part.a_begin),
+               std::make_move_iterator(src + part.a_end),
+               std::make_move_iterator(src + part.b_begin),
+               std::make_move_iterator(src + part.b_end), dst + part.out,
+               comp);
+  }
+}
+
+/// \brief A merge sort. Each thread sorts runs, and then the threads merge
+/// the pairs of runs, splitting the merges evenly, until one run is left.
+template <bool stable, typename iterator, typename compare,
+          typename allocator_type>
+inline void merge_sort(const iterator first, const iterator last,
+                       compare comp, const allocator_type &allocator,
+                       const std::size_t max_run_bytes) {
+  using value_type = typename std::iterator_traits<iterator>::value_type;
+  using buffer_allocator_type = typename std::allocator_traits<
+      allocator_type>::template rebind_alloc<value_type>;
+  using buffer_traits = std::allocator_traits<buffer_allocator_type>;
+
+  const auto sequential_sort = [&comp](auto begin, auto end) {
+    if constexpr (stable) {
+      std::stable_sort(begin, end, comp);
+    } else {
+      std::sort(begin, end, comp);
+    }
+  };
+
+  const std::size_t n = std::distance(first, last);
+  const std::size_t max_run_size =
+      (max_run_bytes == 0) ? n
+                           : std::max(max_run_bytes / sizeof(value_type),
+                                      std::size_t(1));
+  if (n < k_min_parallel_size ||
+      (omp::get_max_threads() <= 1 && max_run_size >= n)) {
+    sequential_sort(first, last);
+    return;
+  }
+
+  buffer_allocator_type buffer_allocator(allocator);
+  auto buffer_ptr = buffer_traits::allocate(buffer_allocator, n);
+  value_type *const buffer = metall::to_raw_pointer(buffer_ptr);
+  const void *const base = std::addressof(*first);
+  // The items of a trivially copyable type need not be constructed in the
+  // buffer
+  constexpr bool trivial = std::is_trivially_copyable_v<value_type>;
+
+  OMP_DIRECTIVE(parallel) {
+    const std::size_t t = omp::get_thread_num();
+    const std::size_t p = omp::get_num_threads();
+    const auto part = [&](const std::size_t i) {
+      return part_begin(base, sizeof(value_type), n, p, i);
+    };
+    const std::size_t lo = part(t);
+    const std::size_t hi = part(t + 1);
+
+    // At least one run per thread; a thread sorts its runs one by one
+    const std::size_t num_runs =
+        std::max(p, (n + max_run_size - 1) / max_run_size);
+    std::vector<std::size_t> bounds(num_runs + 1);
+    for (std::size_t r = 0; r <= num_runs; ++r) {
+      bounds[r] = part_begin(base, sizeof(value_type), n, num_runs, r);
+    }
+    std::size_t num_rounds = 0;
+    while ((std::size_t(1) << num_rounds) < num_runs) ++num_rounds;
+
+    // Sorts the runs where the last round writes into the range, if
+    // possible
+    bool in_buffer = !trivial || num_rounds % 2 == 1;
+    for (std::size_t r = t * num_runs / p; r < (t + 1) * num_runs / p; ++r) {
+      const auto begin = bounds[r];
+      const auto end = bounds[r + 1];
+      if (in_buffer) {
+        std::uninitialized_move(first + begin, first + end, buffer + begin);
+        sequential_sort(buffer + begin, buffer + end);
+      } else {
+        sequential_sort(first + begin, first + end);
+      }
+    }
+    OMP_DIRECTIVE(barrier)
+
+    while (bounds.size() > 2) {
+      // The parts are found before any item is moved from the runs
+      const auto parts =
+          in_buffer ? split_merges(buffer, bounds, lo, hi, comp)
+                    : split_merges(first, bounds, lo, hi, comp);
+      OMP_DIRECTIVE(barrier)
+      if (in_buffer) {
+        merge_parts(buffer, first, parts, comp);
+      } else {
+        merge_parts(first, buffer, parts, comp);
+      }
+      in_buffer = !in_buffer;
+      std::vector<std::size_t> next_bounds;
+      for (std::size_t r = 0; r < bounds.size(); r += 2) {
+        next_bounds.push_back(bounds[r]);
+      }
+      if (next_bounds.back() != n) next_bounds.push_back(n);
+      bounds = std::move(next_bounds);
+      OMP_DIRECTIVE(barrier)
+    }
+
+    if (in_buffer) std::move(buffer + lo, buffer + hi, first + lo);
+    if constexpr (!trivial) std::destroy(buffer + lo, buffer + hi);
+  }
+
+  buffer_traits::deallocate(buffer_allocator, buffer_ptr, n);
+}
+}  // namespace pardtl
+
+/// \brief Sorts a range in parallel. The order of equal items is not kept.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param comp A comparison function.
+template <typename random_iterator, typename compare = std::less<>>
+inline void parallel_sort(const random_iterator first,
+                          const random_iterator last,
+                          compare comp = compare()) {
+  using value_type = typename std::iterator_traits<random_iterator>::value_type;
+  pardtl::merge_sort<false>(first, last, comp, std::allocator<value_type>(),
+                            0);
+}
+
+/// \brief Sorts a range in parallel, keeping the order of equal items.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param comp A comparison function.
+template <typename random_iterator, typename compare = std::less<>>
+inline void parallel_stable_sort(const random_iterator first,
+                                 const random_iterator last,
+                                 compare comp = compare()) {
+  using value_type = typename std::iterator_traits<random_iterator>::value_type;
+  pardtl::merge_sort<true>(first, last, comp, std::allocator<value_type>(),
+                           0);
+}
+
+/// \brief Sorts a range in parallel with a merge buffer taken from an
+/// allocator, e.g., sorts a range larger than the main memory in a datastore
+/// out of core: given the allocator of the manager and 'max_run_bytes' that
+/// fits in the main memory, the runs are sorted in memory one by one, and then
+/// merged into the buffer in the datastore with sequential accesses.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param comp A comparison function.
+/// \param allocator An allocator to allocate a buffer as large as the range.
+/// \param max_run_bytes The maximum size of the runs sorted before the
+/// merges. If 0, a run per thread.
+/// \param stable If true, the order of equal items is kept.
+template <typename random_iterator, typename compare, typename allocator_type>
+inline void parallel_sort(const random_iterator first,
+                          const random_iterator last, compare comp,
+                          const allocator_type &allocator,
+                          const std::size_t max_run_bytes,
+                          const bool stable = false) {
+  if (stable) {
+    pardtl::merge_sort<true>(first, last, comp, allocator, max_run_bytes);
+  } else {
+    pardtl::merge_sort<false>(first, last, comp, allocator, max_run_bytes);
+  }
+}
+
+/// \brief Reduces a range in parallel. The operation must be associative
+/// and commutative.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param init The initial value.
+/// \param op A binary operation.
+/// \return Returns the reduced value.
+template <typename random_iterator, typename value_type,
+          typename binary_operation = std::plus<>>
+inline value_type parallel_reduce(const random_iterator first,
+                                  const random_iterator last,
+                                  value_type init,
+                                  binary_operation op = binary_operation()) {
+  const std::size_t n = std::distance(first, last);
+  if (n < pardtl::k_min_parallel_size || omp::get_max_threads() <= 1) {
+    return std::reduce(first, last, std::move(init), op);
+  }
+
+  using item_type = typename std::iterator_traits<random_iterator>::value_type;
+  const void *const base = std::addressof(*first);
+  std::vector<std::optional<value_type>> partials(omp::get_max_threads());
+  OMP_DIRECTIVE(parallel) {
+    const std::size_t t = omp::get_thread_num();
+    const std::size_t p = omp::get_num_threads();
+    const auto lo = pardtl::part_begin(base, sizeof(item_type), n, p, t);
+    const auto hi = pardtl::part_begin(base, sizeof(item_type), n, p, t + 1);
+    if (lo < hi) {
+      value_type sum(first[lo]);
+      for (auto i = lo + 1; i < hi; ++i) sum = op(std::move(sum), first[i]);
+      partials[t] = std::move(sum);
+    }
+  }
+
+  for (auto &partial : partials) {
+    if (partial) init = op(std::move(init), std::move(*partial));
+  }
+  return init;
+}
+
+/// \brief Computes the inclusive prefix sums of a range in parallel.
+/// The operation must be associative. The output range can be the input.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param d_first The beginning of a random access output range.
+/// \param op A binary operation.
+/// \return Returns the end of the output range.
+template <typename random_iterator, typename output_iterator,
+          typename binary_operation = std::plus<>>
+inline output_iterator parallel_inclusive_scan(
+    const random_iterator first, const random_iterator last,
+    const output_iterator d_first, binary_operation op = binary_operation()) {
+  using value_type = typename std::iterator_traits<random_iterator>::value_type;
+  const std::size_t n = std::distance(first, last);
+  if (n < pardtl::k_min_parallel_size || omp::get_max_threads() <= 1) {
+    return std::inclusive_scan(first, last, d_first, op);
+  }
+
+  const void *const base = std::addressof(*first);
+  std::vector<std::optional<value_type>> partials(omp::get_max_threads());
+  OMP_DIRECTIVE(parallel) {
+    const std::size_t t = omp::get_thread_num();
+    const std::size_t p = omp::get_num_threads();
+    const auto lo = pardtl::part_begin(base, sizeof(value_type), n, p, t);
+    const auto hi = pardtl::part_begin(base, sizeof(value_type), n, p, t + 1);
+    if (lo < hi) {
+      value_type sum(first[lo]);
+      for (auto i = lo + 1; i < hi; ++i) sum = op(std::move(sum), first[i]);
+      partials[t] = std::move(sum);
+    }
+    OMP_DIRECTIVE(barrier)
+
+    // The sum of the items before this part
+    std::optional<value_type> carry;
+    for (std::size_t i = 0; i < t; ++i) {
+      if (!partials[i]) continue;
+      carry = carry ? op(std::move(*carry), *partials[i]) : *partials[i];
+    }
+    for (auto i = lo; i < hi; ++i) {
+      carry = carry ? op(std::move(*carry), first[i]) : value_type(first[i]);
+      d_first[i] = *carry;
+    }
+  }
+  return d_first + n;
+}
+
+/// \brief Computes the exclusive prefix sums of a range in parallel.
+/// The operation must be associative. The output range can be the input.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param d_first The beginning of a random access output range.
+/// \param init The initial value.
+/// \param op A binary operation.
+/// \return Returns the end of the output range.
+template <typename random_iterator, typename output_iterator,
+          typename value_type, typename binary_operation = std::plus<>>
+inline output_iterator parallel_exclusive_scan(
+    const random_iterator first, const random_iterator last,
+    const output_iterator d_first, value_type init,
+    binary_operation op = binary_operation()) {
+  const std::size_t n = std::distance(first, last);
+  if (n < pardtl::k_min_parallel_size || omp::get_max_threads() <= 1) {
+    return std::exclusive_scan(first, last, d_first, std::move(init), op);
+  }
+
+  using item_type = typename std::iterator_traits<random_iterator>::value_type;
+  const void *const base = std::addressof(*first);
+  std::vector<std::optional<value_type>> partials(omp::get_max_threads());
+  OMP_DIRECTIVE(parallel) {
+    const std::size_t t = omp::get_thread_num();
+    const std::size_t p = omp::get_num_threads();
+    const auto lo = pardtl::part_begin(base, sizeof(item_type), n, p, t);
+    const auto hi = pardtl::part_begin(base, sizeof(item_type), n, p, t + 1);
+    if (lo < hi) {
+      value_type sum(first[lo]);
+      for (auto i = lo + 1; i < hi; ++i) sum = op(std::move(sum), first[i]);
+      partials[t] = std::move(sum);
+    }
+    OMP_DIRECTIVE(barrier)
+
+    value_type carry(init);
+    for (std::size_t i = 0; i < t; ++i) {
+      if (partials[i]) carry = op(std::move(carry), *partials[i]);
+    }
+    for (auto i = lo; i < hi; ++i) {
+      // Reads the item first as the output range can be the input
+      item_type item(first[i]);
+      d_first[i] = carry;
+      carry = op(std::move(carry), std::move(item));
+    }
+  }
+  return d_first + n;
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_PARALLEL_ALGORITHM_HPP
@@ -7,8 +7,14 @@
 #define METALL_UTILITY_RANDOM_HPP
 
 #include <cstdint>
+#include <cstddef>
 #include <cstring>
 #include <cassert>
+#include <algorithm>
+#include <limits>
+
+#include <metall/detail/utilities.hpp>
+#include <metall/utility/open_mp.hpp>
 
 namespace metall::utility {
 
@@ -89,35 +95,23 @@ class xoshiro512pp {
     return true;
   }
 
-  result_type next() {
-    const uint64_t result = rotl(m_s[0] + m_s[2], 17) + m_s[2];
-
-    const uint64_t t = m_s[1] << 11;
-
-    m_s[2] ^= m_s[0];
-    m_s[5] ^= m_s[1];
-    m_s[1] ^= m_s[2];
-    m_s[7] ^= m_s[3];
-    m_s[3] ^= m_s[4];
-    m_s[4] ^= m_s[5];
-    m_s[0] ^= m_s[6];
-    m_s[6] ^= m_s[7];
-
-    m_s[6] ^= t;
-
-    m_s[7] = rotl(m_s[7], 21);
+  result_type next() { return step(m_s); }
 
-    return result;
+  // Same as calling next() n times, keeping the state in registers.
+  void fill(result_type *const buf, const std::size_t n) {
+    uint64_t s[8];
+    memcpy(s, m_s, sizeof s);
+    for (std::size_t i = 0; i < n; ++i) {
+      buf[i] = step(s);
+    }
+    memcpy(m_s, s, sizeof s);
   }
 
   // This is the jump function for the generator. It is equivalent
   // to 2^256 calls to next(); it can be used to generate 2^256
   // non-overlapping subsequences for parallel computations.
   void jump() {
-    static const uint64_t JUMP[] = {0x33ed89b6e7a353f9, 0x760083d7955323be,
-                                    0x2837f2fbb5f22fae, 0x4b8c5674d309511c,
-                                    0xb11ac47a7ba28c25, 0xf1be7667092bcc1c,
-                                    0x53851efdb6df0aaf, 0x1ebbc8b23eaf25db};
+    const auto &JUMP = k_jump;
 
     uint64_t t[sizeof m_s / sizeof *m_s];
     memset(t, 0, sizeof t);
@@ -137,10 +131,7 @@ class xoshiro512pp {
   // from each of which jump() will generate 2^128 non-overlapping
   //  subsequences for parallel distributed computations.
   void long_jump() {
-    static const uint64_t LONG_JUMP[] = {
-        0x11467fef8f921d28, 0xa2a819f2e79c8ea8, 0xa8299fc284b3959a,
-        0xb4d347340ca63ee1, 0x1cb0940bedbff6ce, 0xd956c5c4fa1f8e17,
-        0x915e38fd4eda93bc, 0x5b3ccdfa5d7daca5};
+    const auto &LONG_JUMP = k_long_jump;
 
     uint64_t t[sizeof m_s / sizeof *m_s];
     memset(t, 0, sizeof t);
@@ -156,13 +147,207 @@ class xoshiro512pp {
   }
 
  private:
+  template <int>
+  friend class xoshiro512pp_lanes;
+
+  static constexpr uint64_t k_jump[] = {
+      0x33ed89b6e7a353f9, 0x760083d7955323be, 0x2837f2fbb5f22fae,
+      0x4b8c5674d309511c, 0xb11ac47a7ba28c25, 0xf1be7667092bcc1c,
+      0x53851efdb6df0aaf, 0x1ebbc8b23eaf25db};
+
+  static constexpr uint64_t k_long_jump[] = {
+      0x11467fef8f921d28, 0xa2a819f2e79c8ea8, 0xa8299fc284b3959a,
+      0xb4d347340ca63ee1, 0x1cb0940bedbff6ce, 0xd956c5c4fa1f8e17,
+      0x915e38fd4eda93bc, 0x5b3ccdfa5d7daca5};
+
   static constexpr uint64_t rotl(const uint64_t x, int k) {
     return (x << k) | (x >> (64 - k));
   }
 
+  static uint64_t step(uint64_t (&s)[8]) {
+    const uint64_t result = rotl(s[0] + s[2], 17) + s[2];
+
+    const uint64_t t = s[1] << 11;
+
+    s[2] ^= s[0];
+    s[5] ^= s[1];
+    s[1] ^= s[2];
+    s[7] ^= s[3];
+    s[3] ^= s[4];
+    s[4] ^= s[5];
+    s[0] ^= s[6];
+    s[6] ^= s[7];
+
+    s[6] ^= t;
+
+    s[7] = rotl(s[7], 21);
+
+    return result;
+  }
+
   uint64_t m_s[8];
 };
 
+// A vector of 'num_lanes' 64-bit values, one per lane.
+// Uses the vector extension of GCC and Clang so that the operations are
+// compiled to SIMD instructions, e.g., 4 lanes to AVX2 and 8 lanes to
+// AVX-512, without depending on the intrinsics of an instruction set.
+#if defined(__GNUG__) || defined(__clang__)
+template <int num_lanes>
+struct lane_vector {
+  typedef uint64_t type __attribute__((vector_size(8 * num_lanes)));
+};
+#else
+template <int num_lanes>
+struct lane_vector {
+  struct type {
+    uint64_t v[num_lanes];
+
+    uint64_t &operator[](const int l) { return v[l]; }
+    const uint64_t &operator[](const int l) const { return v[l]; }
+
+    type operator+(const type &other) const {
+      type r;
+      for (int l = 0; l < num_lanes; ++l) r.v[l] = v[l] + other.v[l];
+      return r;
+    }
+    type operator|(const type &other) const {
+      type r;
+      for (int l = 0; l < num_lanes; ++l) r.v[l] = v[l] | other.v[l];
+      return r;
+    }
+    type operator<<(const int k) const {
+      type r;
+      for (int l = 0; l < num_lanes; ++l) r.v[l] = v[l] << k;
+      return r;
+    }
+    type operator>>(const int k) const {
+      type r;
+      for (int l = 0; l < num_lanes; ++l) r.v[l] = v[l] >> k;
+      return r;
+    }
+    type &operator^=(const type &other) {
+      for (int l = 0; l < num_lanes; ++l) v[l] ^= other.v[l];
+      return *this;
+    }
+  };
+};
+#endif
+
+// Runs 'num_lanes' xoshiro512++ generators side by side in SIMD lanes.
+// Lane l starts from xoshiro512pp(seed) jumped l times, and the outputs are
+// interleaved: the i-th value is from lane (i % num_lanes).
+template <int num_lanes>
+class xoshiro512pp_lanes {
+ public:
+  using result_type = uint64_t;
+
+  static_assert(num_lanes > 0, "num_lanes must be positive");
+
+  explicit xoshiro512pp_lanes(const uint64_t seed) {
+    xoshiro512pp lane(seed);
+    for (int l = 0; l < num_lanes; ++l) {
+      for (int w = 0; w < 8; ++w) m_s[w][l] = lane.m_s[w];
+      lane.jump();
+    }
+  }
+
+  bool equal(const xoshiro512pp_lanes &other) const {
+    if (m_pos != other.m_pos) return false;
+    for (int w = 0; w < 8; ++w) {
+      for (int l = 0; l < num_lanes; ++l) {
+        if (m_s[w][l] != other.m_s[w][l]) return false;
+      }
+    }
+    return true;
+  }
+
+  result_type next() {
+    if (m_pos == num_lanes) {
+      step(m_s, m_buf);
+      m_pos = 0;
+    }
+    return m_buf[m_pos++];
+  }
+
+  // Same as calling next() n times.
+  void fill(result_type *buf, std::size_t n) {
+    for (; n > 0 && m_pos < num_lanes; --n) *buf++ = m_buf[m_pos++];
+
+    vector_type s[8];
+    memcpy(s, m_s, sizeof s);
+    for (; n >= std::size_t(num_lanes); n -= num_lanes, buf += num_lanes) {
+      step(s, buf);
+    }
+    memcpy(m_s, s, sizeof s);
+
+    if (n > 0) {  // n < num_lanes
+      step(m_s, m_buf);
+      memcpy(buf, m_buf, n * sizeof(result_type));
+      m_pos = static_cast<int>(n);
+    }
+  }
+
+  // Jumps every lane num_lanes times, i.e., 2^256 * num_lanes calls to
+  // next() of xoshiro512++, so that the lanes after a jump do not overlap
+  // the lanes before.
+  void jump() {
+    for (int i = 0; i < num_lanes; ++i) {
+      jump_lanes(xoshiro512pp::k_jump);
+    }
+  }
+
+  // Long-jumps every lane once.
+  void long_jump() { jump_lanes(xoshiro512pp::k_long_jump); }
+
+ private:
+  using vector_type = typename lane_vector<num_lanes>::type;
+
+  // Steps all lanes at once and stores the value of each lane to out.
+  static void step(vector_type (&s)[8], result_type *const out) {
+    vector_type result = s[0] + s[2];
+    result = ((result << 17) | (result >> 47)) + s[2];
+
+    const vector_type t = s[1] << 11;
+
+    s[2] ^= s[0];
+    s[5] ^= s[1];
+    s[1] ^= s[2];
+    s[7] ^= s[3];
+    s[3] ^= s[4];
+    s[4] ^= s[5];
+    s[0] ^= s[6];
+    s[6] ^= s[7];
+
+    s[6] ^= t;
+
+    s[7] = (s[7] << 21) | (s[7] >> 43);
+
+    memcpy(out, &result, sizeof result);
+  }
+
+  // The jump of xoshiro512pp applied to all lanes at once.
+  // The buffered values are discarded.
+  void jump_lanes(const uint64_t (&poly)[8]) {
+    vector_type t[8];
+    memset(t, 0, sizeof t);
+    result_type discard[num_lanes];
+    for (int i = 0; i < 8; i++)
+      for (int b = 0; b < 64; b++) {
+        if (poly[i] & UINT64_C(1) << b)
+          for (int w = 0; w < 8; w++) t[w] ^= m_s[w];
+        step(m_s, discard);
+      }
+
+    memcpy(m_s, t, sizeof m_s);
+    m_pos = num_lanes;
+  }
+
+  vector_type m_s[8];
+  result_type m_buf[num_lanes]{};
+  int m_pos{num_lanes};
+};
+
 // -----------------------------------------------------------------------------
 // This also contains public domain code from <http://prng.di.unimi.it/>.
 // From xoshiro1024plusplus.c:
@@ -218,6 +403,13 @@ class xoshiro1024pp {
     return result;
   }
 
+  // Same as calling next() n times.
+  void fill(result_type *const buf, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      buf[i] = next();
+    }
+  }
+
   // This is the jump function for the generator. It is equivalent
   // to 2^512 calls to next(); it can be used to generate 2^512
   // non-overlapping subsequences for parallel computations.
@@ -298,10 +490,28 @@ class base_rand_xoshiro {
     return n;
   }
 
+  /// \brief Generates n values at once, which is faster than calling
+  /// operator() n times and generates the same values.
+  /// \param buf A pointer to the buffer to store the values.
+  /// \param n The number of values to generate.
+  void fill(result_type *const buf, const std::size_t n) {
+    m_rand_generator.fill(buf, n);
+  }
+
+  /// \brief Advances the engine's state by a large number of values, e.g.,
+  /// 2^256 values for rand_512, to make a stream that does not overlap the
+  /// values generated from the current state, e.g., for another thread.
+  void jump() { m_rand_generator.jump(); }
+
+  /// \brief Same as jump() but advances the state further. Can be used to
+  /// make a starting point from which jump() makes streams, e.g., for
+  /// another process.
+  void long_jump() { m_rand_generator.long_jump(); }
+
   /// \brief Compares two pseudo-random number engines.
   /// Two engines are equal, if their internal states are equivalent.
   /// \return Returns true if two engines are equal; otherwise, returns false.
-  bool equal(const base_rand_xoshiro &other) {
+  bool equal(const base_rand_xoshiro &other) const {
     return m_rand_generator.equal(other.m_rand_generator);
   }
 
@@ -349,6 +559,47 @@ using rand_512 = detail::base_rand_xoshiro<detail::xoshiro512pp>;
 /// ones in STL The actual algorithm is uses xoshiro1024++ whose period is
 /// 2^(1024-1)
 using rand_1024 = detail::base_rand_xoshiro<detail::xoshiro1024pp>;
+
+/// \brief pseudo-random number generator that runs 4 xoshiro512++ streams
+/// side by side in SIMD lanes and interleaves their values. fill() generates
+/// values faster than rand_512 if AVX2 is enabled, e.g., -mavx2 or
+/// -march=native. The values differ from the ones of rand_512.
+using rand_512x4 = detail::base_rand_xoshiro<detail::xoshiro512pp_lanes<4>>;
+
+/// \brief Same as rand_512x4 but runs 8 streams, for AVX-512.
+using rand_512x8 = detail::base_rand_xoshiro<detail::xoshiro512pp_lanes<8>>;
+
+/// \brief The number of values generated by a stream of fill_parallel().
+inline constexpr std::size_t k_fill_parallel_block_size = 1ULL << 20ULL;
+
+/// \brief Generates n values using the OpenMP threads.
+/// The values are generated in blocks of k_fill_parallel_block_size values;
+/// the b-th block is generated by a copy of 'engine' jumped b times. Thus,
+/// the values do not depend on the number of threads.
+/// \tparam rand_type A pseudo-random number generator type, e.g., rand_512x4.
+/// \param engine The generator the streams start from; not changed.
+/// \param buf A pointer to the buffer to store the values.
+/// \param n The number of values to generate.
+template <typename rand_type>
+inline void fill_parallel(const rand_type &engine,
+                          typename rand_type::result_type *const buf,
+                          const std::size_t n) {
+  const std::size_t num_blocks =
+      (n + k_fill_parallel_block_size - 1) / k_fill_parallel_block_size;
+  OMP_DIRECTIVE(parallel) {
+    const auto range = metall::mtlldetail::partial_range(
+        num_blocks, omp::get_thread_num(), omp::get_num_threads());
+    rand_type block_engine(engine);
+    for (std::size_t b = 0; b < range.first; ++b) block_engine.jump();
+    for (std::size_t b = range.first; b < range.second; ++b) {
+      const std::size_t offset = b * k_fill_parallel_block_size;
+      rand_type stream(block_engine);
+      stream.fill(buf + offset,
+                  std::min(k_fill_parallel_block_size, n - offset));
+      block_engine.jump();
+    }
+  }
+}
 }  // namespace metall::utility
 
 #endif  // METALL_UTILITY_RANDOM_HPP
@@ -0,0 +1,381 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_SHARDED_MANAGER_HPP
+#define METALL_UTILITY_SHARDED_MANAGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/logger.hpp>
+#include <metall/detail/hash.hpp>
+#include <metall/detail/io_executor.hpp>
+
+namespace metall::utility {
+
+namespace {
+namespace mdtl = metall::mtlldetail;
+}
+
+/// \brief A manager that stripes a data store across multiple Metall
+/// datastores (shards), e.g., placed on different devices or mount points,
+/// so that the bandwidth of allocations, flushes, and snapshots scales with
+/// the number of devices.
+/// Each thread allocates from its own shard; the threads are assigned to the
+/// shards in a round-robin manner. Named objects share a global namespace: a
+/// named object is placed in the shard chosen by the hash of its name. Flush,
+/// snapshot, open, and close run on the shards in parallel.
+/// \warning The shards are mapped at independent addresses; thus, an object
+/// must not hold an offset pointer to an object in another shard. Refer to
+/// such an object by its name or by its shard number and offset.
+/// \tparam manager_t A Metall manager type.
+template <typename manager_t = metall::manager>
+class sharded_manager {
+ public:
+  /// \brief The manager type of a shard.
+  using manager_type = manager_t;
+  using path_type = typename manager_type::path_type;
+  using char_type = typename manager_type::char_type;
+  using size_type = typename manager_type::size_type;
+
+  /// \brief Creates a new sharded data store.
+  /// \param shard_paths The paths of the shards. The number of paths is the
+  /// number of shards. Must not be empty.
+  /// \param capacity The max capacity of each shard. 0 uses the default.
+  /// \param options Options given to the manager of each shard.
+  sharded_manager(metall::create_only_t,
+                  const std::vector<path_type> &shard_paths,
+                  const size_type capacity = 0,
+                  const manager_options &options = manager_options())
+      : m_shards(shard_paths.size()) {
+    const bool ok = priv_for_each_shard([&](const std::size_t i) {
+      m_shards[i] =
+          (capacity == 0)
+              ? std::make_unique<manager_type>(metall::create_only,
+                                               shard_paths[i], options)
+              : std::make_unique<manager_type>(
+                    metall::create_only, shard_paths[i], capacity, options);
+      return m_shards[i] && m_shards[i]->check_sanity();
+    });
+    if (!ok || !priv_write_shard_info()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to create the shards");
+      priv_close();
+      return;
+    }
+    priv_init_address_map();
+  }
+
+  /// \brief Opens an existing sharded data store.
+  /// \param shard_paths The paths of the shards in the same order as they
+  /// were created.
+  /// \param options Options given to the manager of each shard.
+  sharded_manager(metall::open_only_t,
+                  const std::vector<path_type> &shard_paths,
+                  const manager_options &options = manager_options())
+      : m_shards(shard_paths.size()) {
+    priv_open(shard_paths, [&options](const path_type &path) {
+      return std::make_unique<manager_type>(metall::open_only, path, options);
+    });
+  }
+
+  /// \brief Opens an existing sharded data store with the read-only mode.
+  /// \param shard_paths The paths of the shards in the same order as they
+  /// were created.
+  /// \param options Options given to the manager of each shard.
+  sharded_manager(metall::open_read_only_t,
+                  const std::vector<path_type> &shard_paths,
+                  const manager_options &options = manager_options())
+      : m_shards(shard_paths.size()) {
+    priv_open(shard_paths, [&options](const path_type &path) {
+      return std::make_unique<manager_type>(metall::open_read_only, path,
+                                            options);
+    });
+  }
+
+  /// \brief Closes the shards in parallel.
+  ~sharded_manager() noexcept { priv_close(); }
+
+  sharded_manager(const sharded_manager &) = delete;
+  sharded_manager &operator=(const sharded_manager &) = delete;
+  sharded_manager(sharded_manager &&) noexcept = default;
+  sharded_manager &operator=(sharded_manager &&) noexcept = default;
+
+  /// \brief Returns true if all shards are opened.
+  bool check_sanity() const noexcept {
+    if (m_shards.empty()) return false;
+    for (const auto &shard : m_shards) {
+      if (!shard || !shard->check_sanity()) return false;
+    }
+    return true;
+  }
+
+  /// \brief Returns the number of shards.
+  std::size_t num_shards() const noexcept { return m_shards.size(); }
+
+  /// \brief Returns the manager of a shard.
+  manager_type &shard(const std::size_t shard_no) {
+    return *m_shards.at(shard_no);
+  }
+
+  /// \brief Returns the manager of a shard.
+  const manager_type &shard(const std::size_t shard_no) const {
+    return *m_shards.at(shard_no);
+  }
+
+  /// \brief Returns the shard the calling thread allocates from.
+  std::size_t thread_shard_no() const noexcept {
+    return priv_thread_slot() % std::max(m_shards.size(), std::size_t(1));
+  }
+
+  /// \brief Returns the shard a named object is placed in.
+  std::size_t shard_of_name(const char_type *const name) const noexcept {
+    const auto len = std::char_traits<char_type>::length(name);
+    return mdtl::murmur_hash_64a(name, int(len * sizeof(char_type)),
+                                 k_name_hash_seed) %
+           std::max(m_shards.size(), std::size_t(1));
+  }
+
+  /// \brief Returns the shard an address belongs to.
+  /// \return num_shards() if the address does not belong to any shard.
+  std::size_t shard_of_address(const void *const addr) const noexcept {
+    const auto *const p = static_cast<const char *>(addr);
+    auto itr = std::upper_bound(
+        m_address_map.begin(), m_address_map.end(), p,
+        [](const char *const a, const auto &e) { return a < e.first; });
+    if (itr == m_address_map.begin()) return num_shards();
+    --itr;
+    const auto &shard = *m_shards[itr->second];
+    if (p >= itr->first + shard.get_size()) return num_shards();
+    return itr->second;
+  }
+
+  /// \brief Allocates memory space from the shard of the calling thread.
+  /// \return The address of the allocated space; nullptr on error.
+  void *allocate(const size_type nbytes) noexcept {
+    return allocate(thread_shard_no(), nbytes);
+  }
+
+  /// \brief Allocates memory space from a shard.
+  void *allocate(const std::size_t shard_no, const size_type nbytes) noexcept {
+    if (shard_no >= num_shards() || !m_shards[shard_no]) return nullptr;
+    return m_shards[shard_no]->allocate(nbytes);
+  }
+
+  /// \brief Deallocates memory space allocated by any shard.
+  void deallocate(void *const addr) noexcept {
+    if (!addr) return;
+    const auto no = shard_of_address(addr);
+    if (no == num_shards()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "The address does not belong to any shard");
+      return;
+    }
+    m_shards[no]->deallocate(addr);
+  }
+
+  /// \brief Constructs a named object in the shard chosen by its name.
+  /// Returns the construct proxy of the shard, as
+  /// manager_type::construct() does.
+  template <typename T>
+  auto construct(const char_type *const name) {
+    return shard(shard_of_name(name)).template construct<T>(name);
+  }
+
+  /// \brief Finds or constructs a named object in the shard chosen by its
+  /// name.
+  template <typename T>
+  auto find_or_construct(const char_type *const name) {
+    return shard(shard_of_name(name)).template find_or_construct<T>(name);
+  }
+
+  /// \brief Finds a named object.
+  /// \return A pair of the address and the number of the objects; nullptr if
+  /// not found.
+  template <typename T>
+  std::pair<T *, size_type> find(const char_type *const name) const {
+    return shard(shard_of_name(name)).template find<T>(name);
+  }
+
+  /// \brief Destroys a named object.
+  template <typename T>
+  bool destroy(const char_type *const name) {
+    return shard(shard_of_name(name)).template destroy<T>(name);
+  }
+
+  /// \brief Returns the number of named objects of all shards.
+  size_type get_num_named_objects() const noexcept {
+    size_type num = 0;
+    for (const auto &shard : m_shards) {
+      if (shard) num += shard->get_num_named_objects();
+    }
+    return num;
+  }
+
+  /// \brief Flushes the shards in parallel.
+  /// \return Returns true on success; otherwise, false.
+  bool flush(const bool synchronous = true) noexcept {
+    if (!check_sanity()) return false;
+    return priv_for_each_shard([&](const std::size_t i) {
+      m_shards[i]->flush(synchronous);
+      return m_shards[i]->check_sanity();
+    });
+  }
+
+  /// \brief Takes a snapshot of each shard in parallel.
+  /// \param destination_paths The paths to store the snapshots of the
+  /// shards, in the order of the shards.
+  /// \param clone Use the file clone mechanism (reflink) if available.
+  /// \return Returns true on success; otherwise, false.
+  bool snapshot(const std::vector<path_type> &destination_paths,
+                const bool clone = true) noexcept {
+    if (!check_sanity() || destination_paths.size() != num_shards()) {
+      return false;
+    }
+    return priv_for_each_shard([&](const std::size_t i) {
+      return m_shards[i]->snapshot(destination_paths[i], clone);
+    });
+  }
+
+  /// \brief Removes the shards of a sharded data store in parallel.
+  static bool remove(const std::vector<path_type> &shard_paths) noexcept {
+    return priv_parallel_for(shard_paths.size(), [&](const std::size_t i) {
+      return manager_type::remove(shard_paths[i]);
+    });
+  }
+
+  /// \brief Returns true if all shards were closed properly.
+  static bool consistent(const std::vector<path_type> &shard_paths) noexcept {
+    if (shard_paths.empty()) return false;
+    return priv_parallel_for(shard_paths.size(), [&](const std::size_t i) {
+      return manager_type::consistent(shard_paths[i]);
+    });
+  }
+
+ private:
+  static constexpr uint64_t k_name_hash_seed = 0x5ba5ed;
+
+  /// \brief Stored in each shard as a unique object to check that the shards
+  /// are opened together in the same order.
+  struct shard_info {
+    uint64_t group_id;
+    uint64_t shard_no;
+    uint64_t num_shards;
+  };
+
+  static std::size_t priv_thread_slot() {
+    static std::atomic<std::size_t> next_slot{0};
+    thread_local const std::size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+  }
+
+  static bool priv_parallel_for(
+      const std::size_t n, const std::function<bool(std::size_t)> &task) {
+    try {
+      return mdtl::io_executor::instance().parallel_for(n, 0, task);
+    } catch (...) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "An exception has been thrown");
+    }
+    return false;
+  }
+
+  bool priv_for_each_shard(const std::function<bool(std::size_t)> &task) {
+    if (m_shards.empty()) {
+      logger::out(logger::level::error, __FILE__, __LINE__, "No shard");
+      return false;
+    }
+    return priv_parallel_for(m_shards.size(), task);
+  }
+
+  template <typename open_function>
+  void priv_open(const std::vector<path_type> &shard_paths,
+                 open_function open) {
+    const bool ok = priv_for_each_shard([&](const std::size_t i) {
+      m_shards[i] = open(shard_paths[i]);
+      return m_shards[i] && m_shards[i]->check_sanity();
+    });
+    if (!ok || !priv_check_shard_info()) {
+      logger::out(logger::level::error, __FILE__, __LINE__,
+                  "Failed to open the shards");
+      priv_close();
+      return;
+    }
+    priv_init_address_map();
+  }
+
+  bool priv_write_shard_info() {
+    std::random_device rd;
+    const uint64_t group_id = (uint64_t(rd()) << 32ULL) | rd();
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+      if (!m_shards[i]->template construct<shard_info>(metall::unique_instance)(
+              shard_info{group_id, i, m_shards.size()})) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool priv_check_shard_info() const {
+    uint64_t group_id = 0;
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+      const auto *const info =
+          m_shards[i]
+              ->template find<shard_info>(metall::unique_instance)
+              .first;
+      if (!info) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "Not a shard of a sharded data store");
+        return false;
+      }
+      if (i == 0) group_id = info->group_id;
+      if (info->group_id != group_id || info->shard_no != i ||
+          info->num_shards != m_shards.size()) {
+        logger::out(logger::level::error, __FILE__, __LINE__,
+                    "The shards do not match");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void priv_init_address_map() {
+    m_address_map.clear();
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+      m_address_map.emplace_back(
+          static_cast<const char *>(m_shards[i]->get_address()), i);
+    }
+    std::sort(m_address_map.begin(), m_address_map.end());
+  }
+
+  void priv_close() noexcept {
+    if (m_shards.empty()) return;
+    priv_parallel_for(m_shards.size(), [this](const std::size_t i) {
+      m_shards[i].reset();
+      return true;
+    });
+    m_shards.clear();
+    m_address_map.clear();
+  }
+
+  std::vector<std::unique_ptr<manager_type>> m_shards;
+  // The base address of each shard, sorted by address
+  std::vector<std::pair<const char *, std::size_t>> m_address_map;
+};
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_SHARDED_MANAGER_HPP
@@ -0,0 +1,248 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#ifndef METALL_UTILITY_WORK_STEALING_HPP
+#define METALL_UTILITY_WORK_STEALING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <metall/detail/memory.hpp>
+#include <metall/utility/open_mp.hpp>
+#include <metall/utility/parallel_algorithm.hpp>
+
+/// \file work_stealing.hpp
+/// \brief A parallel loop over index ranges with work stealing, for loops
+/// whose items cost very different times, e.g., the vertices of a graph
+/// with power-law degrees.
+/// Each OpenMP thread starts with a contiguous part of the range, whose
+/// boundaries are on page boundaries like the parts of
+/// parallel_algorithm.hpp, and takes blocks from its front. A thread that
+/// runs out steals the back half of the rest of another thread's part,
+/// trying the threads with the closest numbers first; with a thread affinity
+/// (e.g., OMP_PROC_BIND=close), they run on the same NUMA node. Blocks and
+/// stolen halves are cut at page boundaries too, so that threads do not
+/// share pages.
+/// The loop runs sequentially if OpenMP is not enabled. The functions given
+/// must not throw.
+
+namespace metall::utility {
+
+namespace wsdtl {
+
+namespace mdtl = metall::mtlldetail;
+
+/// \brief Moves indices to page boundaries of the items at 'base'.
+class page_aligner {
+ public:
+  page_aligner(const void *const base, const std::size_t item_size) {
+    static const std::size_t page_size =
+        mdtl::get_page_size() > 0 ? mdtl::get_page_size() : 4096;
+    if (!base || item_size == 0 || page_size % item_size != 0) return;
+    m_items_per_page = page_size / item_size;
+    const auto addr = reinterpret_cast<uintptr_t>(base);
+    const auto gap = (page_size - addr % page_size) % page_size;
+    if (gap % item_size != 0) {
+      m_items_per_page = 0;
+      return;
+    }
+    m_first_page = gap / item_size;
+  }
+
+  std::size_t items_per_page() const { return m_items_per_page; }
+
+  /// \brief Returns the page boundary at or before 'index' if it is after
+  /// 'lower'; otherwise, 'index'.
+  std::size_t align_down(const std::size_t index,
+                         const std::size_t lower) const {
+    if (m_items_per_page == 0 || index < m_first_page) return index;
+    const auto aligned = m_first_page + (index - m_first_page) /
+                                            m_items_per_page *
+                                            m_items_per_page;
+    return aligned > lower ? aligned : index;
+  }
+
+ private:
+  std::size_t m_items_per_page{0};
+  std::size_t m_first_page{0};
+};
+
+/// \brief The items of a thread not started yet.
+/// The owner takes blocks from the front and thieves take the back half.
+class alignas(64) work_range {
+ public:
+  void reset(const std::size_t begin, const std::size_t end) {
+    lock_guard guard(m_lock);
+    m_begin.store(begin, std::memory_order_relaxed);
+    m_end.store(end, std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return m_begin.load(std::memory_order_relaxed) >=
+           m_end.load(std::memory_order_relaxed);
+  }
+
+  /// \brief Takes a block of about 'grain' items from the front.
+  bool pop_front(const std::size_t grain, const page_aligner &aligner,
+                 std::size_t *const begin, std::size_t *const end) {
+    if (empty()) return false;
+    lock_guard guard(m_lock);
+    const auto b = m_begin.load(std::memory_order_relaxed);
+    const auto e = m_end.load(std::memory_order_relaxed);
+    if (b >= e) return false;
+    const auto block_end =
+        std::min(aligner.align_down(b + grain, b), e);
+    m_begin.store(block_end, std::memory_order_relaxed);
+    *begin = b;
+    *end = block_end;
+    return true;
+  }
+
+  /// \brief Takes the back half, or everything if it is not larger than
+  /// 'grain'.
+  bool steal_back(const std::size_t grain, const page_aligner &aligner,
+                  std::size_t *const begin, std::size_t *const end) {
+    if (empty()) return false;
+    lock_guard guard(m_lock);
+    const auto b = m_begin.load(std::memory_order_relaxed);
+    const auto e = m_end.load(std::memory_order_relaxed);
+    if (b >= e) return false;
+    const auto middle =
+        (e - b <= grain) ? b : aligner.align_down(b + (e - b) / 2, b);
+    m_end.store(middle, std::memory_order_relaxed);
+    *begin = middle;
+    *end = e;
+    return true;
+  }
+
+ private:
+  class lock_guard {
+   public:
+    explicit lock_guard(std::atomic<uint32_t> &lock) noexcept : m_lock(lock) {
+      while (true) {
+        if (m_lock.exchange(1, std::memory_order_acquire) == 0) return;
+        for (int i = 0; m_lock.load(std::memory_order_relaxed) != 0; ++i) {
+          if (i >= k_num_spins) std::this_thread::yield();
+        }
+      }
+    }
+    ~lock_guard() noexcept { m_lock.store(0, std::memory_order_release); }
+    lock_guard(const lock_guard &) = delete;
+    lock_guard &operator=(const lock_guard &) = delete;
+
+   private:
+    static constexpr int k_num_spins = 64;
+    std::atomic<uint32_t> &m_lock;
+  };
+
+  std::atomic<uint32_t> m_lock{0};
+  std::atomic<std::size_t> m_begin{0};
+  std::atomic<std::size_t> m_end{0};
+};
+
+/// \brief Returns the thread to steal from at the 'd'-th try (d >= 1) of
+/// thread 't' of 'p': t + 1, t - 1, t + 2, t - 2, and so on.
+inline std::size_t victim(const std::size_t t, const std::size_t p,
+                          const std::size_t d) {
+  const auto k = (d + 1) / 2;
+  return (d % 2 == 1) ? (t + k) % p : (t + p - k % p) % p;
+}
+
+}  // namespace wsdtl
+
+/// \brief Calls 'func(begin, end)' for blocks of [0, n) in parallel with work
+/// stealing. Every index is in exactly one block.
+/// In 'func', omp::get_thread_num() tells the thread, e.g., to use
+/// per-thread buffers.
+/// \param n The number of items.
+/// \param func A function object that takes the beginning and the end of a
+/// block.
+/// \param grain The number of items in a block taken at a time. If 0, it is
+/// chosen from n and the number of threads.
+/// \param base The address of the first item if the items are in an array,
+/// to cut blocks at page boundaries; otherwise, nullptr.
+/// \param item_size The size of an item in the array at 'base'.
+template <typename function_type>
+inline void work_stealing_for(const std::size_t n, function_type &&func,
+                              std::size_t grain = 0,
+                              const void *const base = nullptr,
+                              const std::size_t item_size = 0) {
+  if (n == 0) return;
+  const std::size_t max_threads = omp::get_max_threads();
+  if (grain == 0) grain = std::max(n / (max_threads * 32), std::size_t(1));
+  if (max_threads <= 1 || n <= grain) {
+    func(std::size_t(0), n);
+    return;
+  }
+
+  const wsdtl::page_aligner aligner(base, item_size);
+  if (aligner.items_per_page() > 0 && grain > aligner.items_per_page()) {
+    grain = grain / aligner.items_per_page() * aligner.items_per_page();
+  }
+  std::vector<wsdtl::work_range> ranges(max_threads);
+  OMP_DIRECTIVE(parallel) {
+    const std::size_t t = omp::get_thread_num();
+    const std::size_t p = omp::get_num_threads();
+    const auto part_begin = [&](const std::size_t i) {
+      if (aligner.items_per_page() == 0) return n / p * i + n % p * i / p;
+      return pardtl::part_begin(base, item_size, n, p, i);
+    };
+    ranges[t].reset(part_begin(t), part_begin(t + 1));
+    OMP_DIRECTIVE(barrier)
+
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    while (true) {
+      if (ranges[t].pop_front(grain, aligner, &begin, &end)) {
+        func(begin, end);
+        continue;
+      }
+      // The part is done; steals from the other threads
+      bool stolen = false;
+      for (std::size_t d = 1; d < p && !stolen; ++d) {
+        stolen = ranges[wsdtl::victim(t, p, d)].steal_back(grain, aligner,
+                                                           &begin, &end);
+      }
+      if (!stolen) break;
+      ranges[t].reset(begin, end);
+    }
+  }
+}
+
+/// \brief Calls 'func(first + begin, first + end)' for blocks of a random
+/// access range in parallel with work stealing, e.g., the rows of a CSR
+/// graph or a vector in a datastore.
+/// If the range is contiguous in memory, blocks are cut at page boundaries.
+/// \param first The beginning of a random access range.
+/// \param last The end of the range.
+/// \param func A function object that takes the beginning and the end of a
+/// block (iterators).
+/// \param grain The number of items in a block taken at a time. If 0, it is
+/// chosen from the size and the number of threads.
+template <typename random_iterator, typename function_type>
+inline void work_stealing_for_each(const random_iterator first,
+                                   const random_iterator last,
+                                   function_type &&func,
+                                   const std::size_t grain = 0) {
+  using item_type = typename std::iterator_traits<random_iterator>::value_type;
+  const std::size_t n = std::distance(first, last);
+  if (n == 0) return;
+  work_stealing_for(
+      n,
+      [&first, &func](const std::size_t begin, const std::size_t end) {
+        func(first + begin, first + end);
+      },
+      grain, std::addressof(*first), sizeof(item_type));
+}
+
+}  // namespace metall::utility
+
+#endif  // METALL_UTILITY_WORK_STEALING_HPP
@@ -20,6 +20,7 @@
 # export METALL_TEST_DIR=/tmp
 # export METALL_LIMIT_MAKE_PARALLELS=n
 # export METALL_BUILD_TYPE="Debug;Release;RelWithDebInfo"
+# export METALL_EXTRA_CMAKE_OPTIONS="-DSIMDJSON_ROOT=/usr"
 #
 # 3. Run this script from the root directory of Metall
 # sh ./scripts/CI/build_and_test.sh
@@ -32,6 +33,7 @@
 #   METALL_TEST_DIR (option, defined if not given)
 #   METALL_ROOT_DIR (defined in this function, readonly)
 #   METALL_BUILD_TYPE (option)
+#   METALL_EXTRA_CMAKE_OPTIONS (option)
 # Outputs: STDOUT and STDERR
 #######################################
 main() {
@@ -65,7 +67,8 @@ main() {
         -DBUILD_UTILITY=ON \
         -DBUILD_EXAMPLE=ON \
         -DRUN_BUILD_AND_TEST_WITH_CI=ON \
-        -DBUILD_VERIFICATION=OFF
+        -DBUILD_VERIFICATION=OFF \
+        ${METALL_EXTRA_CMAKE_OPTIONS}
   done
 }
 
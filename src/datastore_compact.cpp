@@ -0,0 +1,24 @@
+// Copyright 2020 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include <iostream>
+#include <cstdlib>
+
+#include <metall/metall.hpp>
+
+int main(int argc, char *argv[]) {
+  if (argc == 1) {
+    std::cerr << "Empty datastore path" << std::endl;
+    std::abort();
+  }
+
+  metall::manager manager(metall::open_only, argv[1]);
+  if (!manager.compact()) {
+    std::cerr << "Failed to compact the datastore" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+#include <metall/metall.hpp>
+
+int main(int argc, char *argv[]) {
+  if (argc == 1) {
+    std::cerr << "Usage: " << argv[0] << " [-d] [-l level] datastore_path"
+              << std::endl;
+    std::abort();
+  }
+
+  bool decompress = false;
+  int level = 3;
+  std::string path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-d") {
+      decompress = true;
+    } else if (arg == "-l" && i + 1 < argc) {
+      level = std::stoi(argv[++i]);
+    } else {
+      path = arg;
+    }
+  }
+
+  if (decompress) {
+    if (!metall::manager::decompress(path)) {
+      std::cerr << "Failed to decompress the datastore" << std::endl;
+      return EXIT_FAILURE;
+    }
+  } else if (!metall::manager::compress(path, level)) {
+    std::cerr << "Failed to compress the datastore" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
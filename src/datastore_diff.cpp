@@ -0,0 +1,57 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Compares two datastores, e.g., snapshots, and prints the ranges of
+/// the segment whose data differ, one "offset length" pair per line.
+/// Usage:
+/// ./datastore_diff [-t #of threads] [-s] datastore_path0 datastore_path1
+/// -t: the maximum number of threads to use (default: automatic).
+/// -s: prints only the summary.
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+
+int main(int argc, char *argv[]) {
+  int num_threads = 0;
+  bool summary_only = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-t" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "-s") {
+      summary_only = true;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.size() != 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-t #of threads] [-s] datastore_path0 datastore_path1"
+              << std::endl;
+    std::abort();
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  if (!metall::manager::diff(paths[0], paths[1], &ranges, num_threads)) {
+    std::cerr << "Failed to compare the datastores" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::size_t total = 0;
+  for (const auto &[offset, length] : ranges) {
+    if (!summary_only) std::cout << offset << " " << length << "\n";
+    total += length;
+  }
+  std::cerr << "#of changed ranges: " << ranges.size()
+            << ", changed bytes: " << total << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+/// \brief Checks the integrity of a datastore without opening it and prints
+/// the problems found, e.g., when a datastore was not closed properly or
+/// could be corrupted. Nothing is repaired.
+/// Usage:
+/// ./datastore_fsck [-t #of threads] [-m max #of problems] datastore_path
+/// -t: the maximum number of threads to use (default: automatic).
+/// -m: the maximum number of problems to print (default: 100).
+/// Exits with 0 if no problem is found; otherwise, 1.
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <metall/metall.hpp>
+
+int main(int argc, char *argv[]) {
+  int num_threads = 0;
+  std::size_t max_num_problems = 100;
+  std::string datastore_path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-t" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "-m" && i + 1 < argc) {
+      max_num_problems = std::stoull(argv[++i]);
+    } else {
+      datastore_path = arg;
+    }
+  }
+  if (datastore_path.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-t #of threads] [-m max #of problems] datastore_path"
+              << std::endl;
+    std::abort();
+  }
+
+  std::vector<std::string> problems;
+  if (metall::manager::check_integrity(datastore_path, &problems,
+                                       num_threads)) {
+    std::cout << "No problem is found" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  for (std::size_t i = 0; i < problems.size() && i < max_num_problems; ++i) {
+    std::cout << problems[i] << "\n";
+  }
+  if (problems.size() > max_num_problems) {
+    std::cout << "... (" << problems.size() - max_num_problems << " more)\n";
+  }
+  std::cout << "#of problems: " << problems.size() << std::endl;
+  return EXIT_FAILURE;
+}
@@ -3,27 +3,89 @@
 //
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
+/// \brief Lists the objects in a datastore.
+/// Usage:
+/// ./datastore_ls [-p name prefix] [-i type ID] [-l min length]
+///   [-L max length] [-s name|offset|length] [-r] [-j] [-S] [-t #of threads]
+///   [-k named|unique|anonymous] datastore_path
+/// -p: lists only the objects whose names start with the prefix.
+/// -i: lists only the objects of the type ID.
+/// -l, -L: lists only the objects whose lengths are in [min, max].
+/// -s: sorts the objects by the key (default: the construction order).
+/// -r: reverses the order.
+/// -j: prints the objects in JSON.
+/// -S: prints only the summary statistics.
+/// -t: the maximum number of threads to read the directories (default:
+///   automatic).
+/// -k: lists only the kind of objects; can be given multiple times.
+
 #include <iostream>
-#include <filesystem>
+#include <cstdlib>
+#include <string>
 
 #include <metall/utility/datastore_ls.hpp>
 
 int main(int argc, char *argv[]) {
-  if (argc == 1) {
+  using metall::utility::ls_options;
+  using kind_type = metall::manager::instance_kind;
+
+  ls_options options;
+  bool kind_given = false;
+  std::string datastore_path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const bool has_value = (i + 1 < argc);
+    if (arg == "-p" && has_value) {
+      options.name_prefix = argv[++i];
+    } else if (arg == "-i" && has_value) {
+      options.type_id = std::stoull(argv[++i]);
+    } else if (arg == "-l" && has_value) {
+      options.min_length = std::stoull(argv[++i]);
+    } else if (arg == "-L" && has_value) {
+      options.max_length = std::stoull(argv[++i]);
+    } else if (arg == "-s" && has_value) {
+      const std::string key(argv[++i]);
+      if (key == "name") {
+        options.sort = ls_options::sort_key::name;
+      } else if (key == "offset") {
+        options.sort = ls_options::sort_key::offset;
+      } else if (key == "length") {
+        options.sort = ls_options::sort_key::length;
+      } else {
+        std::cerr << "Invalid sort key: " << key << std::endl;
+        std::abort();
+      }
+    } else if (arg == "-r") {
+      options.reverse = true;
+    } else if (arg == "-j") {
+      options.json = true;
+    } else if (arg == "-S") {
+      options.summary_only = true;
+    } else if (arg == "-t" && has_value) {
+      options.num_threads = std::stoi(argv[++i]);
+    } else if (arg == "-k" && has_value) {
+      if (!kind_given) options.kinds.clear();
+      kind_given = true;
+      const std::string kind(argv[++i]);
+      if (kind == "named") {
+        options.kinds.push_back(kind_type::named_kind);
+      } else if (kind == "unique") {
+        options.kinds.push_back(kind_type::unique_kind);
+      } else if (kind == "anonymous") {
+        options.kinds.push_back(kind_type::anonymous_kind);
+      } else {
+        std::cerr << "Invalid kind: " << kind << std::endl;
+        std::abort();
+      }
+    } else {
+      datastore_path = arg;
+    }
+  }
+  if (datastore_path.empty()) {
     std::cerr << "Empty datastore path" << std::endl;
     std::abort();
   }
 
-  const std::filesystem::path datastore_path = argv[1];
-
-  metall::utility::ls_named_object(datastore_path);
-  std::cout << std::endl;
-
-  metall::utility::ls_unique_object(datastore_path);
-  std::cout << std::endl;
-
-  metall::utility::ls_anonymous_object(datastore_path);
-  std::cout << std::endl;
-
-  return 0;
-}
\ No newline at end of file
+  return metall::utility::ls(datastore_path, options) ? EXIT_SUCCESS
+                                                       : EXIT_FAILURE;
+}
@@ -3,8 +3,13 @@
 //
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
+#include <cstdlib>
+#include <cstring>
+#include <future>
+
 #include <metall/c_api/metall.h>
 #include <metall/metall.hpp>
+#include <metall/utility/array_export.hpp>
 
 template <typename open_mode>
 metall_manager* open_impl(const char* path) {
@@ -33,14 +38,15 @@ metall_manager* metall_open_read_only(const char* path) {
   return open_impl<metall::open_read_only_t>(path);
 }
 
-metall_manager* metall_create(const char* path) {
+template <typename... args_type>
+metall_manager* create_impl(const char* path, const args_type... args) {
   if (std::filesystem::exists(path)) {
     // prevent accidental overwrite
     errno = EEXIST;
     return nullptr;
   }
 
-  auto* manager = new metall::manager{metall::create_only, path};
+  auto* manager = new metall::manager{metall::create_only, path, args...};
   if (!manager->check_sanity()) {
     delete manager;
     errno = ENOTRECOVERABLE;
@@ -50,14 +56,73 @@ metall_manager* metall_create(const char* path) {
   return reinterpret_cast<metall_manager*>(manager);
 }
 
+metall_async_handle* to_async_handle(std::future<bool> future) {
+  if (!future.valid()) {
+    errno = ENOTRECOVERABLE;
+    return nullptr;
+  }
+
+  return reinterpret_cast<metall_async_handle*>(
+      new std::future<bool>(std::move(future)));
+}
+
+metall_manager* metall_create(const char* path) { return create_impl(path); }
+
+metall_manager* metall_create_with_capacity(const char* path,
+                                            size_t capacity) {
+  return create_impl(path, capacity);
+}
+
 bool metall_snapshot(metall_manager* manager, const char* dst_path) {
   return reinterpret_cast<metall::manager*>(manager)->snapshot(dst_path);
 }
 
+bool metall_snapshot_with_options(metall_manager* manager,
+                                  const char* dst_path, bool clone,
+                                  int num_max_copy_threads, bool incremental) {
+  auto* mgr = reinterpret_cast<metall::manager*>(manager);
+  if (incremental) {
+    return mgr->snapshot_incremental(dst_path, num_max_copy_threads);
+  }
+  return mgr->snapshot(dst_path, clone, num_max_copy_threads);
+}
+
+bool metall_copy(const char* src_path, const char* dst_path) {
+  return metall::manager::copy(src_path, dst_path);
+}
+
+metall_async_handle* metall_copy_async(const char* src_path,
+                                       const char* dst_path) {
+  return to_async_handle(metall::manager::copy_async(src_path, dst_path));
+}
+
 void metall_flush(metall_manager* manager) {
   reinterpret_cast<metall::manager*>(manager)->flush();
 }
 
+metall_async_handle* metall_flush_async(metall_manager* manager) {
+  return to_async_handle(
+      reinterpret_cast<metall::manager*>(manager)->flush_async());
+}
+
+bool metall_wait(metall_async_handle* handle) {
+  auto* future = reinterpret_cast<std::future<bool>*>(handle);
+  const bool res = future->get();
+  delete future;
+  return res;
+}
+
+bool metall_prefetch(metall_manager* manager, const void* addr, size_t size) {
+  auto* mgr = reinterpret_cast<metall::manager*>(manager);
+  const bool res = (addr == nullptr) ? mgr->prefetch()
+                                     : mgr->prefetch(addr, size);
+  if (!res) {
+    errno = EINVAL;
+  }
+
+  return res;
+}
+
 void metall_close(metall_manager* manager) {
   delete reinterpret_cast<metall::manager*>(manager);
 }
@@ -75,10 +140,36 @@ void* metall_malloc(metall_manager* manager, size_t size) {
   return ptr;
 }
 
+void* metall_malloc_aligned(metall_manager* manager, size_t size,
+                            size_t alignment) {
+  auto* ptr = reinterpret_cast<metall::manager*>(manager)->allocate_aligned(
+      size, alignment);
+  if (ptr == nullptr) {
+    errno = ENOMEM;
+  }
+
+  return ptr;
+}
+
 void metall_free(metall_manager* manager, void* ptr) {
   reinterpret_cast<metall::manager*>(manager)->deallocate(ptr);
 }
 
+size_t metall_malloc_many(metall_manager* manager, size_t size, size_t n,
+                          void** ptrs) {
+  const auto num_allocated =
+      reinterpret_cast<metall::manager*>(manager)->allocate_many(size, n, ptrs);
+  if (num_allocated < n) {
+    errno = ENOMEM;
+  }
+
+  return num_allocated;
+}
+
+void metall_free_many(metall_manager* manager, void* const* ptrs, size_t n) {
+  reinterpret_cast<metall::manager*>(manager)->deallocate_many(ptrs, n);
+}
+
 void* metall_named_malloc(metall_manager* manager, const char* name,
                           size_t size) {
   auto* ptr = reinterpret_cast<metall::manager*>(manager)->construct<unsigned
@@ -100,6 +191,21 @@ void* metall_find(metall_manager* manager, const char* name) {
   return ptr;
 }
 
+size_t metall_find_many(metall_manager* manager, const char* const* names,
+                        size_t n, void** ptrs) {
+  auto* mgr = reinterpret_cast<metall::manager*>(manager);
+  size_t num_found = 0;
+  for (size_t i = 0; i < n; ++i) {
+    ptrs[i] = mgr->find<unsigned char>(names[i]).first;
+    num_found += (ptrs[i] != nullptr);
+  }
+  if (num_found < n) {
+    errno = ENOENT;
+  }
+
+  return num_found;
+}
+
 bool metall_named_free(metall_manager* manager, const char* name) {
   auto const res = reinterpret_cast<metall::manager*>(manager)->destroy<unsigned
     char>(name);
@@ -108,4 +214,104 @@ bool metall_named_free(metall_manager* manager, const char* name) {
   }
 
   return res;
-}
\ No newline at end of file
+}
+
+bool metall_get_memory_statistics(metall_manager* manager,
+                                  metall_memory_statistics* stats,
+                                  bool include_resident_bytes) {
+  auto* mgr = reinterpret_cast<metall::manager*>(manager);
+  metall::manager::memory_statistics_type mstats;
+  if (!mgr->get_memory_statistics(&mstats, false, include_resident_bytes)) {
+    errno = EINVAL;
+    return false;
+  }
+
+  stats->chunk_size = mstats.chunk_size;
+  stats->num_used_chunks = mstats.num_used_chunks;
+  stats->allocated_bytes = mstats.allocated_bytes;
+  stats->cached_bytes = mstats.cached_bytes;
+  stats->free_bytes = 0;
+  for (const auto& bin : mstats.bins) {
+    stats->free_bytes += bin.free_bytes;
+  }
+  stats->segment_size = mstats.segment_size;
+  stats->resident_bytes = mstats.resident_bytes;
+  stats->capacity = mgr->get_size();
+  stats->num_named_objects = mgr->get_num_named_objects();
+  stats->num_unique_objects = mgr->get_num_unique_objects();
+  stats->num_anonymous_objects = mgr->get_num_anonymous_objects();
+  return true;
+}
+
+char* metall_memory_statistics_json(metall_manager* manager) {
+  metall::manager::memory_statistics_type mstats;
+  if (!reinterpret_cast<metall::manager*>(manager)->get_memory_statistics(
+          &mstats, true)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  const auto json = mstats.to_json();
+  auto* str = static_cast<char*>(std::malloc(json.size() + 1));
+  if (str == nullptr) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  std::memcpy(str, json.c_str(), json.size() + 1);
+  return str;
+}
+
+/// \brief Finds the named memory holding elements of item_size bytes.
+/// Sets errno on error.
+std::pair<unsigned char*, size_t> find_array_impl(
+    metall_manager* manager, const char* name, const size_t item_size) {
+  if (item_size == 0) {
+    errno = EINVAL;
+    return {nullptr, 0};
+  }
+  const auto found =
+      reinterpret_cast<metall::manager*>(manager)->find<unsigned char>(name);
+  if (found.first == nullptr) {
+    errno = ENOENT;
+    return {nullptr, 0};
+  }
+  if (found.second % item_size != 0) {
+    errno = EINVAL;
+    return {nullptr, 0};
+  }
+
+  return {found.first, found.second / item_size};
+}
+
+bool metall_find_array(metall_manager* manager, const char* name,
+                       const char* typestr, metall_array_interface* array) {
+  const auto item_size = metall::utility::typestr_item_size(typestr);
+  const auto found = find_array_impl(manager, name, item_size);
+  if (found.first == nullptr) {
+    return false;
+  }
+
+  array->data = found.first;
+  array->length = found.second;
+  array->item_size = item_size;
+  std::memcpy(array->typestr, typestr, sizeof(array->typestr));
+  array->read_only = reinterpret_cast<metall::manager*>(manager)->read_only();
+  return true;
+}
+
+bool metall_export_arrow_array(metall_manager* manager, const char* name,
+                               const char* format, struct ArrowArray* out_array,
+                               struct ArrowSchema* out_schema) {
+  const auto found = find_array_impl(
+      manager, name, metall::utility::arrow_format_item_size(format));
+  if (found.first == nullptr) {
+    return false;
+  }
+
+  if (!metall::utility::export_arrow_array(found.first, found.second, format,
+                                           out_array, out_schema)) {
+    errno = ENOMEM;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,50 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+// Shows the memory usage of a Metall MPI datastore and how much it is
+// imbalanced among the processes.
+// Must be run with the same number of processes that created the datastore.
+// Usage: mpirun -n <#processes> mpi_datastore_stats <datastore path>
+// [--resident]
+
+#include <iostream>
+#include <string>
+
+#include <metall/utility/metall_mpi_adaptor.hpp>
+
+int main(int argc, char *argv[]) {
+  ::MPI_Init(&argc, &argv);
+  int rank;
+  ::MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (argc <= 1) {
+    if (rank == 0) std::cerr << "Empty datastore path" << std::endl;
+    ::MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+  const std::string datastore_path = argv[1];
+  const bool resident = (argc > 2 && std::string(argv[2]) == "--resident");
+
+  if (!metall::utility::metall_mpi_adaptor::consistent(datastore_path)) {
+    if (rank == 0) {
+      std::cerr << "Inconsistent datastore or invalid datastore path"
+                << std::endl;
+    }
+    ::MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  {
+    metall::utility::metall_mpi_adaptor mpi_adaptor(metall::open_read_only,
+                                                    datastore_path);
+    metall::utility::metall_mpi_adaptor::memory_statistics_type stats;
+    if (!mpi_adaptor.get_memory_statistics(&stats, resident)) {
+      if (rank == 0) std::cerr << "Failed to get statistics" << std::endl;
+      ::MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    if (rank == 0) std::cout << stats.to_json() << std::endl;
+  }
+  ::MPI_Finalize();
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/append_log.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+struct event {
+  uint64_t timestamp;
+  uint64_t value;
+};
+
+// Small segments to test the records across segments
+using log_type = metall::container::append_log<
+    event, metall::container::append_log_timestamp, std::allocator<event>,
+    sizeof(event) * 100>;
+
+TEST(AppendLogTest, Append) {
+  log_type log(16);
+  ASSERT_TRUE(log.empty());
+  ASSERT_EQ(log.capacity(), 1600);
+
+  for (uint64_t i = 0; i < 250; ++i) {
+    ASSERT_EQ(log.append(event{i, i * 2}), i);
+  }
+  std::vector<event> batch;
+  for (uint64_t i = 250; i < 500; ++i) batch.push_back(event{i, i * 2});
+  ASSERT_EQ(log.append(batch.data(), batch.size()), 250);
+
+  ASSERT_EQ(log.size(), 500);
+  for (uint64_t i = 0; i < 500; ++i) {
+    ASSERT_EQ(log[i].timestamp, i);
+    ASSERT_EQ(log[i].value, i * 2);
+  }
+
+  uint64_t expected = 120;
+  log.for_each(120, 330, [&expected](const event &e) {
+    ASSERT_EQ(e.timestamp, expected);
+    ++expected;
+  });
+  ASSERT_EQ(expected, 330);
+}
+
+TEST(AppendLogTest, Full) {
+  log_type log(2);
+  std::vector<event> batch(150, event{0, 0});
+  ASSERT_EQ(log.append(batch.data(), batch.size()), 0);
+  ASSERT_THROW(log.append(batch.data(), batch.size()), std::length_error);
+  ASSERT_EQ(log.size(), 150);
+}
+
+TEST(AppendLogTest, TimeRange) {
+  log_type log(16);
+  // Roughly in the time order, as events from many sources are
+  for (uint64_t i = 0; i < 1000; ++i) {
+    log.append(event{i + (i % 7) * 3, i});
+  }
+
+  std::size_t count = 0;
+  log.for_each_in_time_range(400, 500, [&count](const event &e) {
+    ASSERT_GE(e.timestamp, 400);
+    ASSERT_LT(e.timestamp, 500);
+    ++count;
+  });
+  std::size_t expected = 0;
+  log.for_each([&expected](const event &e) {
+    expected += (400 <= e.timestamp && e.timestamp < 500);
+  });
+  ASSERT_EQ(count, expected);
+}
+
+TEST(AppendLogTest, ConcurrentAppend) {
+  log_type log(1024);
+  constexpr int k_num_threads = 8;
+  constexpr uint64_t k_num_records = 10000;
+
+  // Scans the readable records while they are appended
+  std::atomic<bool> done{false};
+  std::thread reader([&]() {
+    while (!done) {
+      std::vector<uint64_t> last(k_num_threads, 0);
+      log.for_each([&](const event &e) {
+        // The records of a thread are in its order
+        ASSERT_LE(last[e.value], e.timestamp);
+        last[e.value] = e.timestamp;
+      });
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (uint64_t i = 0; i < k_num_records; ++i) {
+        if (i % 10 == 0) {
+          const event e{i, uint64_t(t)};
+          event batch[3] = {e, e, e};
+          log.append(batch, 3);
+        } else {
+          log.append(event{i, uint64_t(t)});
+        }
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  done = true;
+  reader.join();
+
+  ASSERT_EQ(log.size(), k_num_threads * (k_num_records + 2000));
+  std::vector<std::size_t> counts(k_num_threads, 0);
+  log.for_each([&counts](const event &e) { ++counts[e.value]; });
+  for (const auto count : counts) ASSERT_EQ(count, k_num_records + 2000);
+}
+
+TEST(AppendLogTest, Persistence) {
+  using persistent_log_type = metall::container::append_log<
+      event, metall::container::append_log_timestamp,
+      metall::manager::allocator_type<event>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *log = manager.construct<persistent_log_type>("log")(
+        manager.get_allocator());
+    for (uint64_t i = 0; i < 100000; ++i) {
+      log->append(event{i, i});
+      if (i % 10000 == 0) {
+        ASSERT_TRUE(log->persist_tail(manager));
+      }
+    }
+    ASSERT_TRUE(log->persist_tail(manager));
+    ASSERT_TRUE(log->persist_tail(manager));
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *log = manager.find<persistent_log_type>("log").first;
+    ASSERT_NE(log, nullptr);
+    ASSERT_EQ(log->size(), 100000);
+    uint64_t sum = 0;
+    log->for_each_in_time_range(
+        50000, 50010, [&sum](const event &e) { sum += e.value; });
+    ASSERT_EQ(sum, 500045);
+    log->append(event{100000, 100000});
+    ASSERT_EQ((*log)[100000].value, 100000);
+    ASSERT_TRUE(manager.destroy<persistent_log_type>("log"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,114 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include <boost/container/list.hpp>
+#include <boost/container/map.hpp>
+#include <boost/container/scoped_allocator.hpp>
+#include <boost/container/vector.hpp>
+
+#include <metall/metall.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using resource_type = metall::manager::arena_resource_type;
+
+template <typename T>
+using alloc_type = metall::manager::arena_allocator<T>;
+
+TEST(ArenaAllocatorTest, Allocate) {
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager manager(metall::create_only, dir_path.c_str());
+
+  resource_type resource(manager.get_allocator(), 1 << 16);
+  ASSERT_EQ(resource.num_chunks(), 0);
+
+  alloc_type<uint64_t> alloc(&resource);
+  auto p1 = alloc.allocate(10);
+  auto p2 = alloc.allocate(10);
+  ASSERT_EQ(to_raw_pointer(p1) + 10, to_raw_pointer(p2));
+  ASSERT_EQ(resource.num_chunks(), 1);
+  ASSERT_EQ(resource.allocated_size(), sizeof(uint64_t) * 20);
+
+  // Rebound allocators share the resource
+  alloc_type<char> char_alloc(alloc);
+  ASSERT_EQ(char_alloc.get_resource(), &resource);
+  ASSERT_TRUE(alloc_type<uint64_t>(char_alloc) == alloc);
+
+  // A large allocation takes its own chunk
+  auto large = alloc.allocate(1 << 14);
+  ASSERT_EQ(resource.num_chunks(), 2);
+  auto p3 = alloc.allocate(1);
+  ASSERT_EQ(to_raw_pointer(p2) + 10, to_raw_pointer(p3));
+  alloc.deallocate(large, 1 << 14);
+
+  // Alignment
+  auto *const aligned = resource.allocate(1, 256);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 256, 0);
+
+  resource.release();
+  ASSERT_EQ(resource.num_chunks(), 0);
+  ASSERT_EQ(resource.allocated_size(), 0);
+}
+
+TEST(ArenaAllocatorTest, Containers) {
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager manager(metall::create_only, dir_path.c_str());
+
+  using map_type =
+      boost::container::map<uint64_t, uint64_t, std::less<uint64_t>,
+                            alloc_type<std::pair<const uint64_t, uint64_t>>>;
+  using vector_type = boost::container::vector<
+      map_type, boost::container::scoped_allocator_adaptor<
+                    alloc_type<map_type>>>;
+
+  resource_type resource(manager.get_allocator());
+  {
+    vector_type vec(&resource);
+    vec.resize(16);
+    for (uint64_t i = 0; i < 10000; ++i) vec[i % 16][i] = i;
+    for (uint64_t i = 0; i < 10000; ++i) ASSERT_EQ(vec[i % 16].at(i), i);
+
+    boost::container::list<int, alloc_type<int>> list(&resource);
+    for (int i = 0; i < 1000; ++i) list.push_back(i);
+    ASSERT_EQ(list.size(), 1000);
+  }
+  ASSERT_GT(resource.num_chunks(), 0);
+  resource.release();
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
+TEST(ArenaAllocatorTest, Persistence) {
+  using vector_type = boost::container::vector<int, alloc_type<int>>;
+  const auto dir_path(test_utility::make_test_path());
+
+  {
+    metall::manager manager(metall::create_only, dir_path.c_str());
+    auto *resource = manager.construct<resource_type>("arena")(
+        manager.get_allocator(), 1 << 16);
+    auto *vec = manager.construct<vector_type>("vec")(resource);
+    for (int i = 0; i < 10000; ++i) vec->push_back(i);
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path.c_str());
+    auto *resource = manager.find<resource_type>("arena").first;
+    auto *vec = manager.find<vector_type>("vec").first;
+    ASSERT_NE(resource, nullptr);
+    ASSERT_NE(vec, nullptr);
+    ASSERT_EQ(vec->get_allocator().get_resource(), resource);
+    for (int i = 0; i < 10000; ++i) ASSERT_EQ((*vec)[i], i);
+    vec->push_back(10000);
+
+    ASSERT_TRUE(manager.destroy<vector_type>("vec"));
+    ASSERT_TRUE(manager.destroy<resource_type>("arena"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,115 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/bloom_filter.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mc = metall::container;
+
+template <typename key_type>
+using filter_type =
+    mc::blocked_bloom_filter<key_type, metall::container::bfdtl::default_hash<
+                                           key_type>,
+                             std::allocator<std::byte>>;
+
+TEST(BloomFilterTest, Basic) {
+  filter_type<uint64_t> filter(10000);
+  ASSERT_GE(filter.num_bits(), 100000);
+  ASSERT_EQ(filter.fill_ratio(), 0.0);
+  for (uint64_t i = 0; i < 10000; ++i) ASSERT_FALSE(filter.contains(i));
+
+  for (uint64_t i = 0; i < 10000; ++i) filter.insert(i);
+  for (uint64_t i = 0; i < 10000; ++i) ASSERT_TRUE(filter.contains(i));
+  ASSERT_GT(filter.fill_ratio(), 0.4);
+  ASSERT_LT(filter.fill_ratio(), 0.7);
+
+  // About 1% with 10 bits per key
+  std::size_t num_false_positives = 0;
+  for (uint64_t i = 10000; i < 110000; ++i) {
+    num_false_positives += filter.contains(i);
+  }
+  ASSERT_LT(num_false_positives, 2000);
+
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; ++i) keys.push_back(i * 7919);
+  std::vector<bool> results;
+  filter.contains_batch(keys.begin(), keys.size(),
+                        std::back_inserter(results));
+  ASSERT_EQ(results.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(results[i], filter.contains(keys[i]));
+  }
+
+  filter.clear();
+  ASSERT_EQ(filter.fill_ratio(), 0.0);
+  ASSERT_FALSE(filter.contains(uint64_t(0)));
+}
+
+TEST(BloomFilterTest, StringKeys) {
+  filter_type<std::string> filter(1000, 16);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i) keys.push_back("key-" + std::to_string(i));
+  filter.insert(keys.begin(), keys.end());
+  for (const auto &k : keys) {
+    ASSERT_TRUE(filter.contains(k));
+    // Heterogeneous lookups hash the same bytes
+    ASSERT_TRUE(filter.contains(std::string_view(k)));
+    ASSERT_TRUE(filter.contains(k.c_str()));
+  }
+  std::size_t num_false_positives = 0;
+  for (int i = 1000; i < 11000; ++i) {
+    num_false_positives += filter.contains("key-" + std::to_string(i));
+  }
+  ASSERT_LT(num_false_positives, 100);
+}
+
+TEST(BloomFilterTest, ConcurrentInsert) {
+  filter_type<uint64_t> filter(100000);
+  constexpr int k_num_threads = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&filter, t]() {
+      for (uint64_t i = t; i < 100000; i += k_num_threads) filter.insert(i);
+    });
+  }
+  for (auto &th : threads) th.join();
+  for (uint64_t i = 0; i < 100000; ++i) ASSERT_TRUE(filter.contains(i));
+}
+
+TEST(BloomFilterTest, Persistence) {
+  using persistent_filter_type = mc::blocked_bloom_filter<uint64_t>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *filter = manager.construct<persistent_filter_type>("filter")(
+        1000, manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) filter->insert(i);
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    auto *filter = manager.find<persistent_filter_type>("filter").first;
+    ASSERT_NE(filter, nullptr);
+    for (uint64_t i = 0; i < 1000; ++i) ASSERT_TRUE(filter->contains(i));
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    ASSERT_TRUE(manager.destroy<persistent_filter_type>("filter"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,185 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+
+#include <metall/metall.hpp>
+#include <metall/container/btree_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+// Small nodes make deep trees
+using small_btree_type =
+    metall::container::btree_map<uint64_t, uint64_t, std::less<uint64_t>,
+                                 std::allocator<std::pair<const uint64_t,
+                                                          uint64_t>>,
+                                 128>;
+using btree_type = metall::container::btree_map<uint64_t, uint64_t>;
+
+template <typename btree_t, typename ref_t>
+void check(const btree_t &btree, const ref_t &ref) {
+  ASSERT_EQ(btree.size(), ref.size());
+  ASSERT_EQ(std::distance(btree.begin(), btree.end()), ref.size());
+  auto ref_itr = ref.begin();
+  for (const auto &[key, value] : btree) {
+    ASSERT_EQ(key, ref_itr->first);
+    ASSERT_EQ(value, ref_itr->second);
+    ++ref_itr;
+  }
+  // Backward
+  auto itr = btree.end();
+  for (auto ritr = ref.rbegin(); ritr != ref.rend(); ++ritr) {
+    --itr;
+    ASSERT_EQ(itr->first, ritr->first);
+  }
+  ASSERT_TRUE(itr == btree.begin());
+}
+
+TEST(BtreeMapTest, Basic) {
+  btree_type btree;
+  ASSERT_TRUE(btree.empty());
+  ASSERT_TRUE(btree.begin() == btree.end());
+  ASSERT_TRUE(btree.find(1) == btree.end());
+  ASSERT_EQ(btree.erase(1), 0);
+
+  ASSERT_TRUE(btree.insert(std::make_pair(1, 10)).second);
+  ASSERT_FALSE(btree.insert(std::make_pair(1, 20)).second);
+  ASSERT_TRUE(btree.emplace(3, 30).second);
+  ASSERT_TRUE(btree.try_emplace(2, 20).second);
+  btree[4] = 40;
+  ASSERT_FALSE(btree.insert_or_assign(4, 41).second);
+  ASSERT_EQ(btree.size(), 4);
+  ASSERT_EQ(btree.at(4), 41);
+  ASSERT_THROW(btree.at(5), std::out_of_range);
+  ASSERT_EQ(btree.count(2), 1);
+  ASSERT_TRUE(btree.contains(3));
+  ASSERT_FALSE(btree.contains(5));
+  ASSERT_EQ(btree.find(2)->second, 20);
+
+  ASSERT_EQ(btree.lower_bound(2)->first, 2);
+  ASSERT_EQ(btree.upper_bound(2)->first, 3);
+  ASSERT_TRUE(btree.lower_bound(5) == btree.end());
+  const auto range = btree.equal_range(3);
+  ASSERT_EQ(std::distance(range.first, range.second), 1);
+
+  auto itr = btree.erase(btree.find(2));
+  ASSERT_EQ(itr->first, 3);
+  ASSERT_EQ(btree.size(), 3);
+
+  btree_type copy(btree);
+  btree.clear();
+  ASSERT_TRUE(btree.empty());
+  ASSERT_EQ(copy.size(), 3);
+  btree = std::move(copy);
+  ASSERT_EQ(btree.size(), 3);
+  ASSERT_TRUE(copy.empty());
+}
+
+TEST(BtreeMapTest, RandomOperations) {
+  small_btree_type btree;
+  std::map<uint64_t, uint64_t> ref;
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 300000; ++i) {
+    const uint64_t key = rnd() % 20000;
+    switch (rnd() % 4) {
+      case 0:
+        ASSERT_EQ(btree.erase(key), ref.erase(key));
+        break;
+      case 1: {
+        const auto b = btree.lower_bound(key);
+        const auto r = ref.lower_bound(key);
+        ASSERT_EQ(b == btree.end(), r == ref.end());
+        if (r != ref.end()) {
+          ASSERT_EQ(b->first, r->first);
+        }
+        break;
+      }
+      default:
+        ASSERT_EQ(btree.insert_or_assign(key, i).second,
+                  ref.insert_or_assign(key, i).second);
+    }
+  }
+  check(btree, ref);
+
+  // Erase ranges and everything
+  btree.erase(btree.lower_bound(5000), btree.lower_bound(15000));
+  ref.erase(ref.lower_bound(5000), ref.lower_bound(15000));
+  check(btree, ref);
+  for (auto itr = ref.begin(); itr != ref.end();) {
+    ASSERT_EQ(btree.erase(itr->first), 1);
+    itr = ref.erase(itr);
+  }
+  ASSERT_TRUE(btree.empty());
+  ASSERT_TRUE(btree.begin() == btree.end());
+}
+
+TEST(BtreeMapTest, SortedInsertion) {
+  small_btree_type btree;
+  std::map<uint64_t, uint64_t> ref;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    btree.emplace_hint(btree.end(), i, i * 2);
+    ref.emplace(i, i * 2);
+  }
+  // Reverse order
+  for (uint64_t i = 20000; i >= 10000; --i) {
+    btree.emplace(i, i * 2);
+    ref.emplace(i, i * 2);
+  }
+  check(btree, ref);
+}
+
+TEST(BtreeMapTest, StringKey) {
+  metall::container::btree_map<std::string, std::string> btree;
+  std::map<std::string, std::string> ref;
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 20000; ++i) {
+    // Long strings to use heap allocations
+    const auto key = std::to_string(rnd() % 5000) + std::string(20, 'k');
+    if (rnd() % 3 == 0) {
+      ASSERT_EQ(btree.erase(key), ref.erase(key));
+    } else {
+      btree[key] = key + std::to_string(i);
+      ref[key] = key + std::to_string(i);
+    }
+  }
+  check(btree, ref);
+}
+
+TEST(BtreeMapTest, Persistence) {
+  using persistent_type = metall::container::btree_map<
+      uint64_t, uint64_t, std::less<uint64_t>,
+      metall::manager::allocator_type<std::pair<const uint64_t, uint64_t>>>;
+
+  std::map<uint64_t, uint64_t> ref;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *btree =
+        manager.construct<persistent_type>("btree")(manager.get_allocator());
+    std::mt19937_64 rnd(123);
+    for (int i = 0; i < 50000; ++i) {
+      const auto key = rnd() % 100000;
+      (*btree)[key] = i;
+      ref[key] = i;
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *btree = manager.find<persistent_type>("btree").first;
+    ASSERT_NE(btree, nullptr);
+    check(*btree, ref);
+    ASSERT_TRUE(manager.destroy<persistent_type>("btree"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,100 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <list>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/bulk_insert.hpp>
+#include <metall/container/map.hpp>
+#include <metall/container/unordered_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mc = metall::container;
+
+std::vector<std::pair<int, int>> make_inputs(const int n) {
+  std::vector<std::pair<int, int>> inputs;
+  for (int i = 0; i < n; ++i) inputs.emplace_back(i, i * 2);
+  std::shuffle(inputs.begin(), inputs.end(), std::mt19937(123));
+  return inputs;
+}
+
+TEST(BulkInsertTest, SortedMap) {
+  auto inputs = make_inputs(1000);
+  std::sort(inputs.begin(), inputs.end());
+
+  mc::map<int, int, std::less<int>, std::allocator<std::pair<const int, int>>>
+      map;
+  map.emplace(500, -1);  // Existing elements are kept
+  ASSERT_EQ(
+      mc::bulk_insert(map, mc::ordered_unique_range, inputs.begin(),
+                      inputs.end()),
+      999);
+  ASSERT_EQ(map.size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(map.at(i), (i == 500) ? -1 : i * 2);
+  }
+}
+
+TEST(BulkInsertTest, UnsortedMap) {
+  auto inputs = make_inputs(1000);
+  inputs.emplace_back(10, -1);  // Duplicate key; the first one is inserted
+
+  mc::map<int, int, std::less<int>, std::allocator<std::pair<const int, int>>>
+      map;
+  ASSERT_EQ(mc::bulk_insert(map, inputs.begin(), inputs.end()), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(map.at(i), i * 2);
+  }
+}
+
+TEST(BulkInsertTest, UnorderedMap) {
+  const auto inputs = make_inputs(1000);
+
+  mc::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                    std::allocator<std::pair<const int, int>>>
+      map;
+  ASSERT_EQ(mc::bulk_insert(map, inputs.begin(), inputs.end()), 1000);
+  ASSERT_GE(map.bucket_count() * map.max_load_factor(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(map.at(i), i * 2);
+  }
+
+  // Input iterator with a size hint
+  const std::list<std::pair<int, int>> more_inputs{{1000, 0}, {1, 0}};
+  ASSERT_EQ(
+      mc::bulk_insert(map, more_inputs.begin(), more_inputs.end(), 2), 1);
+  ASSERT_EQ(map.size(), 1001);
+}
+
+TEST(BulkInsertTest, Persistence) {
+  using map_type = mc::map<int, int>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<map_type>("map")(manager.get_allocator());
+    const auto inputs = make_inputs(1000);
+    ASSERT_EQ(mc::bulk_insert(*map, inputs.begin(), inputs.end()), 1000);
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *map = manager.find<map_type>("map").first;
+    ASSERT_NE(map, nullptr);
+    ASSERT_EQ(map->size(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_EQ(map->at(i), i * 2);
+    }
+  }
+}
+
+}  // namespace
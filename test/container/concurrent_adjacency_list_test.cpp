@@ -0,0 +1,145 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/concurrent_adjacency_list.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using adj_list_type =
+    metall::container::concurrent_adjacency_list<uint64_t, uint64_t>;
+using edge_list_type = std::vector<std::pair<uint64_t, uint64_t>>;
+
+edge_list_type make_edges() {
+  edge_list_type edges;
+  std::mt19937_64 rnd(123);
+  for (std::size_t i = 0; i < 20000; ++i) {
+    edges.emplace_back(rnd() % 1000, rnd() % 1000);
+  }
+  return edges;
+}
+
+template <typename adj_list_t>
+void check(const adj_list_t &adj_list, const edge_list_type &edges) {
+  std::map<uint64_t, std::vector<uint64_t>> ref;
+  for (const auto &edge : edges) ref[edge.first].push_back(edge.second);
+
+  ASSERT_EQ(adj_list.num_keys(), ref.size());
+  ASSERT_EQ(adj_list.num_edges(), edges.size());
+  for (auto &[key, values] : ref) {
+    ASSERT_EQ(adj_list.num_values(key), values.size());
+    std::vector<uint64_t> list(adj_list.values_begin(key),
+                               adj_list.values_end(key));
+    std::sort(list.begin(), list.end());
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(list, values);
+  }
+
+  std::size_t num_keys = 0;
+  for (auto itr = adj_list.keys_begin(); itr != adj_list.keys_end(); ++itr) {
+    ASSERT_EQ(itr->second.size(), ref.at(itr->first).size());
+    ++num_keys;
+  }
+  ASSERT_EQ(num_keys, ref.size());
+
+  num_keys = 0;
+  for (std::size_t p = 0; p < adj_list.num_partitions(); ++p) {
+    for (auto itr = adj_list.keys_begin(p); itr != adj_list.keys_end(p);
+         ++itr) {
+      ASSERT_EQ(adj_list.partition_index(itr->first), p);
+      ++num_keys;
+    }
+  }
+  ASSERT_EQ(num_keys, ref.size());
+}
+
+TEST(ConcurrentAdjacencyListTest, AddEdge) {
+  adj_list_type adj_list(16);
+  ASSERT_EQ(adj_list.num_partitions(), 16);
+  ASSERT_EQ(adj_list.num_keys(), 0);
+  ASSERT_EQ(adj_list.num_values(1), 0);
+
+  const auto edges = make_edges();
+  for (const auto &edge : edges) {
+    ASSERT_TRUE(adj_list.add_edge(edge.first, edge.second));
+  }
+  check(adj_list, edges);
+
+  adj_list.clear();
+  ASSERT_EQ(adj_list.num_keys(), 0);
+  ASSERT_EQ(adj_list.num_edges(), 0);
+}
+
+TEST(ConcurrentAdjacencyListTest, ConcurrentAddEdge) {
+  adj_list_type adj_list(64);
+  const auto edges = make_edges();
+  constexpr std::size_t k_num_threads = 8;
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&adj_list, &edges, t]() {
+      for (std::size_t i = t; i < edges.size(); i += k_num_threads) {
+        adj_list.add_edge(edges[i].first, edges[i].second);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  check(adj_list, edges);
+}
+
+TEST(ConcurrentAdjacencyListTest, AddEdges) {
+  const auto edges = make_edges();
+  for (const int num_threads : {1, 4, 100}) {
+    for (const bool numa_local : {false, true}) {
+      adj_list_type adj_list(32);
+      // Mixes with the single edge insertion
+      adj_list.add_edge(edges[0].first, edges[0].second);
+      ASSERT_EQ(adj_list.add_edges(edges.begin() + 1, edges.end(),
+                                   num_threads, numa_local),
+                edges.size() - 1);
+      check(adj_list, edges);
+    }
+  }
+
+  adj_list_type adj_list(1);
+  ASSERT_EQ(adj_list.add_edges(edges.begin(), edges.end()), edges.size());
+  check(adj_list, edges);
+  ASSERT_GE(adj_list_type::numa_node_of(0), 0);
+}
+
+TEST(ConcurrentAdjacencyListTest, Persistence) {
+  using persistent_adj_list_type =
+      metall::container::concurrent_adjacency_list<
+          uint64_t, uint64_t, metall::manager::allocator_type<std::byte>>;
+
+  const auto edges = make_edges();
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *adj_list = manager.construct<persistent_adj_list_type>("adj")(
+        8, manager.get_allocator());
+    adj_list->add_edges(edges.begin(), edges.end(), 2);
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *adj_list = manager.find<persistent_adj_list_type>("adj").first;
+    ASSERT_NE(adj_list, nullptr);
+    check(*adj_list, edges);
+    ASSERT_TRUE(manager.destroy<persistent_adj_list_type>("adj"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -5,7 +5,13 @@
 
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include <boost/interprocess/managed_mapped_file.hpp>
 #include <boost/interprocess/allocators/allocator.hpp>
@@ -124,6 +130,131 @@ TEST(ConcurrentMapTest, Iterator) {
   GTEST_ASSERT_EQ(num_elems, 2);
 }
 
+TEST(ConcurrentMapTest, EraseAndUpdate) {
+  using map_type = metall::container::concurrent_map<char, int>;
+  map_type map;
+
+  GTEST_ASSERT_TRUE(map.emplace('a', 1));
+  GTEST_ASSERT_FALSE(map.emplace('a', 2));
+  GTEST_ASSERT_TRUE(map.insert_or_assign('b', 3));
+  GTEST_ASSERT_FALSE(map.insert_or_assign('b', 4));
+  GTEST_ASSERT_EQ(map.size(), 2);
+
+  GTEST_ASSERT_TRUE(map.update('a', [](int &v) { v += 10; }));
+  GTEST_ASSERT_FALSE(map.update('c', [](int &v) { v = 0; }));
+  GTEST_ASSERT_EQ(map.count('c'), 0);
+
+  int value = 0;
+  GTEST_ASSERT_TRUE(map.visit('a', [&value](const int &v) { value = v; }));
+  GTEST_ASSERT_EQ(value, 11);
+  GTEST_ASSERT_TRUE(map.visit('b', [&value](const int &v) { value = v; }));
+  GTEST_ASSERT_EQ(value, 4);
+  GTEST_ASSERT_FALSE(map.visit('c', [](const int &) {}));
+
+  GTEST_ASSERT_EQ(map.erase('a'), 1);
+  GTEST_ASSERT_EQ(map.erase('a'), 0);
+  GTEST_ASSERT_EQ(map.count('a'), 0);
+  GTEST_ASSERT_EQ(map.size(), 1);
+}
+
+TEST(ConcurrentMapTest, ForEach) {
+  using map_type = metall::container::concurrent_map<int, int>;
+  map_type map;
+  for (int i = 0; i < 1000; ++i) map.insert(std::make_pair(i, i));
+
+  for (const int num_threads : {1, 4, 0}) {
+    std::atomic<long> sum{0};
+    std::atomic<int> num_elems{0};
+    map.for_each(
+        [&sum, &num_elems](const int &key, int &value) {
+          sum += key;
+          ++value;
+          ++num_elems;
+        },
+        num_threads);
+    GTEST_ASSERT_EQ(num_elems.load(), 1000);
+    GTEST_ASSERT_EQ(sum.load(), 999 * 1000 / 2);
+  }
+  // Each value was incremented by 3 for_each() calls
+  for (int i = 0; i < 1000; ++i) {
+    GTEST_ASSERT_EQ(map.find(i)->second, i + 3);
+  }
+}
+
+TEST(ConcurrentMapTest, ConcurrentEraseAndInsert) {
+  using map_type = metall::container::concurrent_map<int, int>;
+  map_type map;
+  constexpr int k_num_threads = 4;
+  constexpr int k_num_keys = 1 << 14;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&map, t]() {
+      for (int key = t; key < k_num_keys; key += k_num_threads) {
+        map.emplace(key, key);
+        if (key % 2 == 0) map.erase(key);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  GTEST_ASSERT_EQ(map.size(), k_num_keys / 2);
+}
+
+template <typename mutex_type>
+void concurrent_insert_and_visit() {
+  using map_type = metall::container::concurrent_map<
+      int, int, std::less<int>, std::hash<int>,
+      std::allocator<std::pair<const int, int>>, 64, mutex_type>;
+  map_type map;
+  constexpr int k_num_threads = 4;
+  constexpr int k_num_keys = 1 << 14;
+
+  std::vector<std::thread> threads;
+  std::atomic<int> num_found{0};
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&map, &num_found, t]() {
+      for (int key = t; key < k_num_keys; key += k_num_threads) {
+        map.emplace(key, key);
+        map.update(key, [](int &value) { ++value; });
+        num_found += map.visit(key, [key](const int &value) {
+          EXPECT_EQ(value, key + 1);
+        });
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  GTEST_ASSERT_EQ(map.size(), k_num_keys);
+  GTEST_ASSERT_EQ(num_found.load(), k_num_keys);
+
+  auto edited = map.scoped_edit(0);
+  static_assert(
+      std::is_same_v<decltype(edited.second), std::unique_lock<mutex_type>>);
+  GTEST_ASSERT_EQ(edited.first, 1);
+}
+
+TEST(ConcurrentMapTest, MutexType) {
+  concurrent_insert_and_visit<metall::utility::mutex::spin_mutex>();
+  concurrent_insert_and_visit<std::shared_mutex>();
+}
+
+TEST(ConcurrentMapTest, BulkInsert) {
+  using map_type = metall::container::concurrent_map<int, int>;
+  map_type map;
+  map.insert(std::make_pair(5, -1));
+
+  std::vector<std::pair<int, int>> inputs;
+  for (int i = 0; i < 10000; ++i) inputs.emplace_back(i, i);
+  inputs.emplace_back(0, -1);  // Duplicate key
+  for (const int num_threads : {1, 4}) {
+    GTEST_ASSERT_EQ(map.bulk_insert(inputs.begin(), inputs.end(), num_threads),
+                    (num_threads == 1) ? 9999 : 0);
+  }
+  GTEST_ASSERT_EQ(map.size(), 10000);
+  for (int i = 0; i < 10000; ++i) {
+    GTEST_ASSERT_EQ(map.find(i)->second, (i == 5) ? -1 : i);
+  }
+}
+
 TEST(ConcurrentMapTest, Persistence) {
   using allocator_type =
       bip::allocator<std::pair<const char, int>,
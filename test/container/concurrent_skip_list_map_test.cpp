@@ -0,0 +1,184 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/concurrent_skip_list_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using map_type = metall::container::concurrent_skip_list_map<uint64_t, int>;
+
+TEST(ConcurrentSkipListMapTest, Insert) {
+  map_type map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(uint64_t(1), 10)));
+  ASSERT_FALSE(map.insert(std::make_pair(uint64_t(1), 20)));
+  ASSERT_TRUE(map.try_emplace(2, 20));
+  ASSERT_EQ(map.size(), 2);
+  ASSERT_EQ(map.count(1), 1);
+  ASSERT_EQ(map.count(3), 0);
+
+  int value = 0;
+  ASSERT_TRUE(map.find(1, &value));
+  ASSERT_EQ(value, 10);
+  ASSERT_FALSE(map.find(3, &value));
+}
+
+TEST(ConcurrentSkipListMapTest, Update) {
+  map_type map;
+  ASSERT_TRUE(map.insert_or_assign(1, 10));
+  ASSERT_FALSE(map.insert_or_assign(1, 20));
+  map.edit(1, [](int &value) { ++value; });
+  map.edit(2, [](int &value) { value = 5; });
+  ASSERT_TRUE(map.update(2, [](int &value) { value *= 2; }));
+  ASSERT_FALSE(map.update(3, [](int &) {}));
+
+  int value = 0;
+  ASSERT_TRUE(map.find(1, &value));
+  ASSERT_EQ(value, 21);
+  ASSERT_TRUE(map.visit(2, [](const int &v) { ASSERT_EQ(v, 10); }));
+}
+
+TEST(ConcurrentSkipListMapTest, Erase) {
+  map_type map;
+  for (uint64_t i = 0; i < 1000; ++i) map.insert(std::make_pair(i, int(i)));
+  for (uint64_t i = 0; i < 1000; i += 2) ASSERT_EQ(map.erase(i), 1);
+  ASSERT_EQ(map.erase(0), 0);
+  ASSERT_EQ(map.size(), 500);
+  for (uint64_t i = 0; i < 1000; ++i) ASSERT_EQ(map.contains(i), i % 2 == 1);
+
+  map.clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_FALSE(map.contains(1));
+  ASSERT_TRUE(map.insert(std::make_pair(uint64_t(1), 1)));
+}
+
+TEST(ConcurrentSkipListMapTest, OrderedScan) {
+  metall::container::concurrent_skip_list_map<int, int, std::greater<int>>
+      map;
+  std::map<int, int, std::greater<int>> reference;
+  std::mt19937 rng(123);
+  for (int i = 0; i < 10000; ++i) {
+    const int key = int(rng() % 5000);
+    if (rng() % 4 == 0) {
+      ASSERT_EQ(map.erase(key), reference.erase(key));
+    } else {
+      ASSERT_EQ(map.try_emplace(key, i), reference.emplace(key, i).second);
+    }
+  }
+  ASSERT_EQ(map.size(), reference.size());
+
+  std::vector<std::pair<int, int>> items;
+  map.for_each([&items](const auto &item) { items.push_back(item); });
+  ASSERT_EQ(items, decltype(items)(reference.begin(), reference.end()));
+
+  // [3000, 1000) in the descending order
+  items.clear();
+  map.for_each(3000, 1000,
+               [&items](const auto &item) { items.push_back(item); });
+  ASSERT_EQ(items, decltype(items)(reference.lower_bound(3000),
+                                   reference.lower_bound(1000)));
+}
+
+TEST(ConcurrentSkipListMapTest, ConcurrentOperations) {
+  map_type map;
+  constexpr int k_num_threads = 8;
+  constexpr uint64_t k_num_keys = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&]() {
+      for (uint64_t key = 0; key < k_num_keys; ++key) {
+        map.edit(key, [](int &value) { ++value; });
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_EQ(map.size(), k_num_keys);
+  map.for_each(
+      [&](const auto &item) { ASSERT_EQ(item.second, k_num_threads); });
+
+  // Erases, inserts, and scans at once
+  threads.clear();
+  std::atomic<bool> done{false};
+  std::thread scanner([&]() {
+    while (!done) {
+      uint64_t previous = 0;
+      bool first = true;
+      map.for_each(0, k_num_keys, [&](const auto &item) {
+        ASSERT_TRUE(first || previous < item.first);
+        previous = item.first;
+        first = false;
+      });
+    }
+  });
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (uint64_t key = t; key < k_num_keys; key += k_num_threads) {
+        ASSERT_EQ(map.erase(key), 1);
+        ASSERT_TRUE(map.try_emplace(key + k_num_keys, 1));
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  done = true;
+  scanner.join();
+
+  ASSERT_EQ(map.size(), k_num_keys);
+  for (uint64_t key = 0; key < k_num_keys; ++key) {
+    ASSERT_FALSE(map.contains(key));
+    ASSERT_TRUE(map.contains(key + k_num_keys));
+  }
+}
+
+TEST(ConcurrentSkipListMapTest, Persistence) {
+  using persistent_map_type = metall::container::concurrent_skip_list_map<
+      uint64_t, int, std::less<uint64_t>,
+      metall::manager::allocator_type<std::pair<const uint64_t, int>>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<persistent_map_type>("map")(
+        manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map->insert(std::make_pair(i, int(i * 2)));
+    }
+    // Some removed nodes are freed after the datastore is reopened
+    for (uint64_t i = 1000; i < 2000; ++i) {
+      map->insert(std::make_pair(i, 0));
+      map->erase(i);
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *map = manager.find<persistent_map_type>("map").first;
+    ASSERT_NE(map, nullptr);
+    ASSERT_EQ(map->size(), 1000);
+    uint64_t expected = 0;
+    map->for_each([&expected](const auto &item) {
+      ASSERT_EQ(item.first, expected);
+      ASSERT_EQ(item.second, int(expected * 2));
+      ++expected;
+    });
+    ASSERT_EQ(expected, 1000);
+    ASSERT_TRUE(manager.destroy<persistent_map_type>("map"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
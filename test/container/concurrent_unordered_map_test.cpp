@@ -0,0 +1,187 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/concurrent_unordered_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using map_type = metall::container::concurrent_unordered_map<uint64_t, int>;
+
+TEST(ConcurrentUnorderedMapTest, Insert) {
+  map_type map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(1, 10)));
+  ASSERT_FALSE(map.insert(std::make_pair(1, 20)));  // Duplicate key
+  ASSERT_TRUE(map.try_emplace(2, 30));
+  ASSERT_EQ(map.size(), 2);
+
+  int value = 0;
+  ASSERT_TRUE(map.find(1, &value));
+  ASSERT_EQ(value, 10);
+  ASSERT_TRUE(map.find(2, &value));
+  ASSERT_EQ(value, 30);
+  ASSERT_FALSE(map.find(3, &value));
+  ASSERT_EQ(map.count(1), 1);
+  ASSERT_EQ(map.count(3), 0);
+}
+
+TEST(ConcurrentUnorderedMapTest, Update) {
+  map_type map;
+  ASSERT_TRUE(map.insert_or_assign(1, 10));
+  ASSERT_FALSE(map.insert_or_assign(1, 20));
+  map.edit(1, [](int &v) { ++v; });
+  map.edit(2, [](int &v) { v += 5; });  // Inserts a new element
+  ASSERT_FALSE(map.update(3, [](int &v) { v = 1; }));
+  ASSERT_TRUE(map.update(2, [](int &v) { v *= 2; }));
+
+  int value = 0;
+  ASSERT_TRUE(map.visit(1, [&value](const int &v) { value = v; }));
+  ASSERT_EQ(value, 21);
+  ASSERT_TRUE(map.find(2, &value));
+  ASSERT_EQ(value, 10);
+  ASSERT_FALSE(map.contains(3));
+}
+
+TEST(ConcurrentUnorderedMapTest, Erase) {
+  map_type map;
+  ASSERT_EQ(map.erase(1), 0);
+  map.insert(std::make_pair(1, 10));
+  map.insert(std::make_pair(2, 20));
+  ASSERT_EQ(map.erase(1), 1);
+  ASSERT_EQ(map.erase(1), 0);
+  ASSERT_FALSE(map.contains(1));
+  ASSERT_TRUE(map.contains(2));
+  ASSERT_EQ(map.size(), 1);
+
+  map.clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(2, 30)));
+}
+
+TEST(ConcurrentUnorderedMapTest, RandomOperations) {
+  // Many insertions and erasures to grow the tables and reuse deleted slots
+  std::unordered_map<uint64_t, int> ref_map;
+  map_type map;
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 200000; ++i) {
+    const uint64_t key = rnd() % 20000;
+    if (rnd() % 3 == 0) {
+      ASSERT_EQ(map.erase(key), ref_map.erase(key));
+    } else {
+      ASSERT_EQ(map.insert_or_assign(key, i),
+                ref_map.insert_or_assign(key, i).second);
+    }
+  }
+  ASSERT_EQ(map.size(), ref_map.size());
+
+  std::size_t num_elements = 0;
+  map.for_each([&ref_map, &num_elements](const map_type::value_type &v) {
+    ASSERT_EQ(ref_map.at(v.first), v.second);
+    ++num_elements;
+  });
+  ASSERT_EQ(num_elements, ref_map.size());
+}
+
+TEST(ConcurrentUnorderedMapTest, Reserve) {
+  map_type map;
+  map.reserve(10000);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(map.insert(std::make_pair(i, int(i))));
+  }
+  ASSERT_EQ(map.size(), 10000);
+}
+
+TEST(ConcurrentUnorderedMapTest, ConcurrentOperations) {
+  map_type map;
+  constexpr int k_num_threads = 8;
+  constexpr uint64_t k_num_keys = 1 << 15;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&map]() {
+      for (uint64_t key = 0; key < k_num_keys; ++key) {
+        map.edit(key, [](int &v) { ++v; });
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_EQ(map.size(), k_num_keys);
+  for (uint64_t key = 0; key < k_num_keys; ++key) {
+    int value = 0;
+    ASSERT_TRUE(map.find(key, &value));
+    ASSERT_EQ(value, k_num_threads);
+  }
+
+  // Each thread erases its own keys
+  threads.clear();
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&map, t]() {
+      for (uint64_t key = t; key < k_num_keys; key += k_num_threads) {
+        map.erase(key);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(ConcurrentUnorderedMapTest, BulkInsert) {
+  map_type map;
+  map.insert(std::make_pair(5, -1));
+
+  std::vector<std::pair<uint64_t, int>> inputs;
+  for (uint64_t i = 0; i < 10000; ++i) inputs.emplace_back(i, int(i));
+  for (const std::size_t num_threads : {1, 4}) {
+    ASSERT_EQ(map.bulk_insert(inputs.begin(), inputs.end(), num_threads),
+              (num_threads == 1) ? 9999 : 0);
+  }
+  ASSERT_EQ(map.size(), 10000);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    int value = 0;
+    ASSERT_TRUE(map.find(i, &value));
+    ASSERT_EQ(value, (i == 5) ? -1 : int(i));
+  }
+}
+
+TEST(ConcurrentUnorderedMapTest, Persistence) {
+  using persistent_map_type = metall::container::concurrent_unordered_map<
+      uint64_t, int, std::hash<uint64_t>, std::equal_to<uint64_t>,
+      metall::manager::allocator_type<std::pair<const uint64_t, int>>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<persistent_map_type>("map")(
+        manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map->insert(std::make_pair(i, int(i * 2)));
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *map = manager.find<persistent_map_type>("map").first;
+    ASSERT_NE(map, nullptr);
+    ASSERT_EQ(map->size(), 1000);
+    for (uint64_t i = 0; i < 1000; ++i) {
+      int value = 0;
+      ASSERT_TRUE(map->find(i, &value));
+      ASSERT_EQ(value, int(i * 2));
+    }
+    ASSERT_TRUE(manager.destroy<persistent_map_type>("map"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,106 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/csr_graph.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using edge_list_type = std::vector<std::pair<uint64_t, uint64_t>>;
+
+std::vector<edge_list_type> make_edge_lists(const std::size_t num_lists) {
+  std::vector<edge_list_type> edge_lists(num_lists);
+  std::mt19937_64 rnd(123);
+  for (std::size_t i = 0; i < 10000; ++i) {
+    // Vertex 1500 is only a destination
+    const uint64_t src = rnd() % 1000;
+    const uint64_t dst = (i % 100 == 0) ? 1500 : rnd() % 1000;
+    edge_lists[i % num_lists].emplace_back(src, dst);
+  }
+  return edge_lists;
+}
+
+template <typename graph_type>
+void check_graph(const graph_type &graph,
+                 const std::vector<edge_list_type> &edge_lists) {
+  std::vector<std::vector<uint64_t>> ref(1501);
+  std::size_t num_edges = 0;
+  for (const auto &list : edge_lists) {
+    for (const auto &edge : list) {
+      ref[edge.first].push_back(edge.second);
+      ++num_edges;
+    }
+  }
+  for (auto &neighbors : ref) std::sort(neighbors.begin(), neighbors.end());
+
+  ASSERT_EQ(graph.num_vertices(), 1501);
+  ASSERT_EQ(graph.num_edges(), num_edges);
+  for (uint64_t v = 0; v < ref.size(); ++v) {
+    ASSERT_EQ(graph.num_values(v), ref[v].size());
+    const std::vector<uint64_t> neighbors(graph.values_begin(v),
+                                          graph.values_end(v));
+    ASSERT_EQ(neighbors, ref[v]);
+  }
+  ASSERT_EQ(graph.num_values(1501), 0);
+  ASSERT_EQ(graph.values_begin(1501), graph.values_end(1501));
+
+  std::size_t num_keys = 0;
+  for (auto itr = graph.keys_begin(); itr != graph.keys_end(); ++itr) {
+    ASSERT_EQ(itr->second, ref[itr->first].size());
+    ++num_keys;
+  }
+  ASSERT_EQ(num_keys, 1501);
+}
+
+TEST(CsrGraphTest, Build) {
+  metall::container::csr_graph<uint64_t, uint64_t, false,
+                               std::allocator<std::byte>>
+      graph;
+  for (const std::size_t num_lists : {1, 4}) {
+    auto edge_lists = make_edge_lists(num_lists);
+    graph.build(edge_lists);
+    check_graph(graph, edge_lists);
+  }
+}
+
+TEST(CsrGraphTest, BuildCompressed) {
+  metall::container::csr_graph<uint64_t, uint64_t, true,
+                               std::allocator<std::byte>>
+      graph;
+  for (const std::size_t num_lists : {1, 4}) {
+    auto edge_lists = make_edge_lists(num_lists);
+    graph.build(edge_lists, 1501);
+    check_graph(graph, edge_lists);
+  }
+}
+
+TEST(CsrGraphTest, Persistence) {
+  using graph_type = metall::container::csr_graph<uint64_t, uint64_t, true>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  auto edge_lists = make_edge_lists(2);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *graph =
+        manager.construct<graph_type>("graph")(manager.get_allocator());
+    graph->build(edge_lists);
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *graph = manager.find<graph_type>("graph").first;
+    ASSERT_NE(graph, nullptr);
+    check_graph(*graph, edge_lists);
+  }
+}
+
+}  // namespace
@@ -307,4 +307,54 @@ TEST(FallbackAllocatorAdaptorTest, PersistentNestedContainer) {
     ASSERT_EQ(map->at(0)[1], 2);
     ASSERT_EQ(map->at(1)[0], 3);
   }
-}
\ No newline at end of file
+}
+template <typename T, bool persistent>
+using static_fb_alloc_type =
+    metall::container::static_fallback_allocator_adaptor<
+        metall::manager::allocator_type<T>, persistent>;
+
+TEST(FallbackAllocatorAdaptorTest, StaticPolicies) {
+  using heap_alloc_type = static_fb_alloc_type<uint64_t, false>;
+  using stateful_alloc_type = static_fb_alloc_type<uint64_t, true>;
+  static_assert(std::is_empty_v<heap_alloc_type>);
+  static_assert(!std::is_default_constructible_v<stateful_alloc_type>);
+  static_assert(!std::is_constructible_v<heap_alloc_type,
+                                         metall::manager::allocator_type<int>>);
+  static_assert(std::is_same_v<std::allocator_traits<heap_alloc_type>::
+                                   rebind_alloc<int>::policy_type,
+                               metall::container::fallback_policy::heap>);
+
+  {
+    heap_alloc_type allocator;
+    ASSERT_FALSE(allocator.stateful_allocator_available());
+    ASSERT_EQ(allocator, heap_alloc_type());
+    ASSERT_NO_THROW({ allocator.deallocate(allocator.allocate(1), 1); });
+    ASSERT_THROW({ allocator.allocate(allocator.max_size() + 1); },
+                 std::bad_array_new_length);
+
+    boost::interprocess::vector<uint64_t, heap_alloc_type> vector;
+    for (uint64_t i = 0; i < 1024; ++i) vector.push_back(i);
+    for (uint64_t i = 0; i < 1024; ++i) ASSERT_EQ(vector[i], i);
+  }
+
+  using vector_type =
+      boost::interprocess::vector<uint64_t, stateful_alloc_type>;
+  {
+    metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+    stateful_alloc_type allocator(manager.get_allocator<uint64_t>());
+    ASSERT_TRUE(allocator.stateful_allocator_available());
+    ASSERT_EQ(allocator.get_stateful_allocator(),
+              manager.get_allocator<uint64_t>());
+
+    auto *vec = manager.construct<vector_type>("vector")(
+        manager.get_allocator<>());
+    for (uint64_t i = 0; i < 1024; ++i) vec->push_back(i);
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path());
+    auto *vec = manager.find<vector_type>("vector").first;
+    ASSERT_NE(vec, nullptr);
+    for (uint64_t i = 0; i < 1024; ++i) ASSERT_EQ(vec->at(i), i);
+    ASSERT_TRUE(manager.destroy<vector_type>("vector"));
+  }
+}
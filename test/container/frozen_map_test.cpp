@@ -0,0 +1,182 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/frozen_map.hpp>
+#include <metall/container/string_key_store.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mc = metall::container;
+
+TEST(FrozenMapTest, Empty) {
+  mc::frozen_map<uint64_t, int> map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(map.find(1), nullptr);
+
+  std::unordered_map<uint64_t, int> src;
+  ASSERT_TRUE(map.freeze(src.begin(), src.end()));
+  ASSERT_EQ(map.size(), 0);
+  ASSERT_EQ(map.count(1), 0);
+}
+
+TEST(FrozenMapTest, Find) {
+  std::unordered_map<uint64_t, uint64_t> src;
+  std::mt19937_64 rng(123);
+  while (src.size() < 100000) {
+    const auto key = rng();
+    src[key] = key / 2;
+  }
+
+  mc::frozen_map<uint64_t, uint64_t> map;
+  ASSERT_TRUE(map.freeze(src.begin(), src.end()));
+  ASSERT_EQ(map.size(), src.size());
+  for (const auto &[key, value] : src) {
+    const auto *const item = map.find(key);
+    ASSERT_NE(item, nullptr);
+    ASSERT_EQ(item->first, key);
+    ASSERT_EQ(item->second, value);
+  }
+  for (int i = 0; i < 10000; ++i) {
+    const auto key = rng();
+    ASSERT_EQ(map.contains(key), src.count(key) > 0);
+  }
+  ASSERT_THROW(map.at(rng()), std::out_of_range);
+
+  std::size_t num_items = 0;
+  for (const auto &item : map) {
+    ASSERT_EQ(src.at(item.first), item.second);
+    ++num_items;
+  }
+  ASSERT_EQ(num_items, src.size());
+  // The hash function takes a few bytes per key
+  ASSERT_LT(map.memory_bytes(), src.size() * (sizeof(uint64_t) * 2 + 4));
+}
+
+TEST(FrozenMapTest, DuplicateKeys) {
+  std::vector<std::pair<int, int>> src{{1, 1}, {2, 2}, {3, 3}, {2, 4}};
+  mc::frozen_map<int, int> map;
+  ASSERT_FALSE(map.freeze(src.begin(), src.end()));
+  ASSERT_TRUE(map.empty());
+  ASSERT_THROW((mc::frozen_map<int, int>(src.begin(), src.end())),
+               std::invalid_argument);
+
+  src.pop_back();
+  ASSERT_TRUE(map.freeze(src.begin(), src.end()));
+  ASSERT_EQ(map.at(2), 2);
+}
+
+TEST(FrozenMapTest, Persistence) {
+  using map_type = mc::frozen_map<uint64_t, uint64_t,
+                                  metall::manager::allocator_type<std::byte>>;
+
+  std::unordered_map<uint64_t, uint64_t> src;
+  for (uint64_t i = 0; i < 1000; ++i) src[i * 3] = i;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<map_type>("map")(manager.get_allocator());
+    ASSERT_TRUE(map->freeze(src.begin(), src.end()));
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *map = manager.find<map_type>("map").first;
+    ASSERT_EQ(map->size(), src.size());
+    for (const auto &[key, value] : src) {
+      ASSERT_EQ(map->at(key), value);
+      ASSERT_FALSE(map->contains(key + 1));
+    }
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    ASSERT_TRUE(manager.destroy<map_type>("map"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(FrozenStringMapTest, FreezeMap) {
+  std::map<std::string, int> src;
+  for (int i = 0; i < 10000; ++i) {
+    // Both keys in the items and in the key arena
+    src[std::to_string(i)] = i;
+    src["a long key to store apart " + std::to_string(i)] = -i;
+  }
+
+  mc::frozen_string_map<int> map;
+  ASSERT_TRUE(map.freeze(src.begin(), src.end()));
+  ASSERT_EQ(map.size(), src.size());
+  for (const auto &[key, value] : src) {
+    ASSERT_EQ(map.at(key), value);
+  }
+  ASSERT_EQ(map.find("not a key"), nullptr);
+  ASSERT_EQ(map.find("a long key to store apart x"), nullptr);
+
+  std::size_t num_items = 0;
+  map.for_each([&src, &num_items](const std::string_view key, const int v) {
+    ASSERT_EQ(src.at(std::string(key)), v);
+    ++num_items;
+  });
+  ASSERT_EQ(num_items, src.size());
+}
+
+TEST(FrozenStringMapTest, FreezeStringKeyStore) {
+  using store_type = mc::string_key_store<int, std::allocator<std::byte>>;
+  store_type store(true, 111);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(store.insert("key-" + std::to_string(i), i));
+  }
+
+  mc::frozen_string_map<int> map;
+  ASSERT_TRUE(map.freeze(store));
+  ASSERT_EQ(map.size(), store.size());
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(map.at("key-" + std::to_string(i)), i);
+  }
+
+  // A store that allows duplicate keys
+  store_type duplicates(false, 111);
+  ASSERT_TRUE(duplicates.insert("a", 1));
+  ASSERT_TRUE(duplicates.insert("a", 2));
+  ASSERT_FALSE(map.freeze(duplicates));
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(FrozenStringMapTest, Persistence) {
+  using map_type =
+      mc::frozen_string_map<int, metall::manager::allocator_type<std::byte>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    std::map<std::string, int> src{
+        {"short", 1}, {"a key longer than twelve bytes", 2}};
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<map_type>("map")(manager.get_allocator());
+    ASSERT_TRUE(map->freeze(src.begin(), src.end()));
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *map = manager.find<map_type>("map").first;
+    ASSERT_EQ(map->at("short"), 1);
+    ASSERT_EQ(map->at("a key longer than twelve bytes"), 2);
+    ASSERT_FALSE(map->contains("long"));
+  }
+}
+
+}  // namespace
@@ -0,0 +1,122 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <filesystem>
+
+#include <boost/container/vector.hpp>
+#include <metall/metall.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+namespace fs = std::filesystem;
+
+template <typename T>
+using alloc_type = metall::manager::global_allocator_type<T>;
+
+const fs::path &dir_path() {
+  const static fs::path path(test_utility::make_test_path());
+  return path;
+}
+
+TEST(GlobalStlAllocatorTest, Types) {
+  using alloc_t = alloc_type<int>;
+  static_assert(std::is_empty_v<alloc_t>);
+  static_assert(std::allocator_traits<alloc_t>::is_always_equal::value);
+  GTEST_ASSERT_EQ(typeid(std::allocator_traits<alloc_t>::pointer),
+                  typeid(metall::offset_ptr<int>));
+  GTEST_ASSERT_EQ(
+      typeid(std::allocator_traits<alloc_t>::rebind_alloc<double>),
+      typeid(alloc_type<double>));
+
+  // Smaller than the containers using the normal allocator
+  using vector_type = boost::container::vector<int, alloc_t>;
+  using stateful_vector_type =
+      boost::container::vector<int, metall::manager::allocator_type<int>>;
+  ASSERT_LT(sizeof(vector_type), sizeof(stateful_vector_type));
+}
+
+TEST(GlobalStlAllocatorTest, Unbound) {
+  metall::logger::set_log_level(metall::logger::level_filter::critical);
+  ASSERT_THROW({ alloc_type<int>().allocate(1); }, std::bad_alloc);
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+}
+
+TEST(GlobalStlAllocatorTest, AllocateMany) {
+  metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+  ASSERT_TRUE(manager.bind_global_allocator());
+  alloc_type<uint64_t> allocator;
+
+  std::vector<alloc_type<uint64_t>::pointer> ptrs(1024);
+  ASSERT_NO_THROW({ allocator.allocate_many(ptrs.size(), ptrs.data()); });
+  for (std::size_t i = 0; i < ptrs.size(); ++i) {
+    allocator.construct(ptrs[i], i);
+  }
+  for (std::size_t i = 0; i < ptrs.size(); ++i) ASSERT_EQ(*ptrs[i], i);
+  allocator.deallocate_many(ptrs.data(), ptrs.size());
+  allocator.deallocate(allocator.allocate(10), 10);
+  ASSERT_TRUE(manager.all_memory_deallocated());
+  manager.unbind_global_allocator();
+}
+
+TEST(GlobalStlAllocatorTest, PersistentNestedContainer) {
+  using inner_type = boost::container::vector<uint64_t, alloc_type<uint64_t>>;
+  using outer_type =
+      boost::container::vector<inner_type, alloc_type<inner_type>>;
+
+  {
+    metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+    ASSERT_TRUE(manager.bind_global_allocator());
+    auto *const vec = manager.construct<outer_type>("vec")();
+    vec->resize(8);
+    for (uint64_t i = 0; i < 1024; ++i) (*vec)[i % 8].push_back(i);
+    manager.unbind_global_allocator();
+    ASSERT_EQ(metall::get_global_stl_allocator_kernel<
+                  metall::manager::manager_kernel_type>(),
+              nullptr);
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.bind_global_allocator());
+    auto *const vec = manager.find<outer_type>("vec").first;
+    ASSERT_NE(vec, nullptr);
+    for (uint64_t i = 0; i < 1024; ++i) ASSERT_EQ((*vec)[i % 8][i / 8], i);
+
+    // Moved without copying as the allocators are always equal
+    inner_type moved(std::move((*vec)[0]));
+    ASSERT_TRUE((*vec)[0].empty());
+    (*vec)[0] = std::move(moved);
+
+    manager.destroy<outer_type>("vec");
+    ASSERT_TRUE(manager.all_memory_deallocated());
+    manager.unbind_global_allocator();
+  }
+}
+
+TEST(GlobalStlAllocatorTest, UnboundOnDestruction) {
+  using kernel_type = metall::manager::manager_kernel_type;
+  {
+    metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+    ASSERT_TRUE(manager.bind_global_allocator());
+    ASSERT_NE(metall::get_global_stl_allocator_kernel<kernel_type>(), nullptr);
+  }
+  ASSERT_EQ(metall::get_global_stl_allocator_kernel<kernel_type>(), nullptr);
+
+  {
+    metall::manager manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.bind_global_allocator());
+    manager = metall::manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(metall::get_global_stl_allocator_kernel<kernel_type>(), nullptr);
+  }
+
+  // Not deallocated, but logged
+  metall::logger::set_log_level(metall::logger::level_filter::critical);
+  alloc_type<int>().deallocate(nullptr, 1);
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+}
+}  // namespace
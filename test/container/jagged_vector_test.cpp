@@ -0,0 +1,128 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/jagged_vector.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using jagged_vector_type = metall::container::jagged_vector<int>;
+
+template <typename jagged_t>
+void check(const jagged_t &jagged, const std::vector<std::vector<int>> &ref) {
+  ASSERT_EQ(jagged.size(), ref.size());
+  std::size_t num_elements = 0;
+  for (std::size_t i = 0; i < ref.size(); ++i) {
+    ASSERT_EQ(jagged.row_size(i), ref[i].size());
+    ASSERT_EQ(std::vector<int>(jagged[i].begin(), jagged[i].end()), ref[i]);
+    num_elements += ref[i].size();
+  }
+  ASSERT_EQ(jagged.num_elements(), num_elements);
+
+  std::vector<int> flat;
+  for (auto itr = jagged.flat_begin(); itr != jagged.flat_end(); ++itr) {
+    flat.push_back(*itr);
+  }
+  std::vector<int> ref_flat;
+  for (const auto &row : ref) {
+    ref_flat.insert(ref_flat.end(), row.begin(), row.end());
+  }
+  ASSERT_EQ(flat, ref_flat);
+}
+
+TEST(JaggedVectorTest, Basic) {
+  jagged_vector_type jagged;
+  ASSERT_TRUE(jagged.empty());
+  ASSERT_EQ(jagged.add_row(), 0);
+  const std::vector<int> row{1, 2, 3};
+  ASSERT_EQ(jagged.add_row(row.begin(), row.end()), 1);
+  jagged.push_back(0, 10);
+  jagged.emplace_back(1, 4);
+  jagged.push_back(0, 11);
+  check(jagged, {{10, 11}, {1, 2, 3, 4}});
+
+  jagged[1][0] = 5;
+  ASSERT_EQ(jagged[1][0], 5);
+  jagged.pop_back(1);
+  check(jagged, {{10, 11}, {5, 2, 3}});
+
+  jagged.clear_row(0);
+  jagged.resize(3);
+  check(jagged, {{}, {5, 2, 3}, {}});
+
+  std::size_t num_rows = 0;
+  for (const auto &view : jagged) {
+    ASSERT_EQ(view.size(), jagged.row_size(num_rows));
+    ++num_rows;
+  }
+  ASSERT_EQ(num_rows, 3);
+  ASSERT_EQ(jagged.end() - jagged.begin(), 3);
+
+  jagged.clear();
+  ASSERT_TRUE(jagged.empty());
+  ASSERT_EQ(jagged.pool_size(), 0);
+}
+
+TEST(JaggedVectorTest, InterleavedAppends) {
+  // Appending to rows in turn relocates rows; compaction must keep them
+  std::vector<std::vector<int>> ref(100);
+  jagged_vector_type jagged(ref.size());
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 100000; ++i) {
+    const auto row_no = rnd() % ref.size();
+    ref[row_no].push_back(i);
+    jagged.push_back(row_no, i);
+  }
+  check(jagged, ref);
+  // The relocated rows do not bloat the pool without bound
+  ASSERT_LE(jagged.pool_size(), jagged.num_elements() * 4);
+
+  jagged.compact();
+  check(jagged, ref);
+  jagged.shrink_to_fit();
+  check(jagged, ref);
+  ASSERT_EQ(jagged.pool_size(), jagged.num_elements());
+
+  jagged.reserve_row(0, ref[0].size() + 100);
+  for (int i = 0; i < 100; ++i) {
+    ref[0].push_back(i);
+    jagged.push_back(0, i);
+  }
+  check(jagged, ref);
+}
+
+TEST(JaggedVectorTest, Persistence) {
+  using persistent_type = metall::container::jagged_vector<
+      int, metall::manager::allocator_type<int>>;
+
+  std::vector<std::vector<int>> ref(50);
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *jagged = manager.construct<persistent_type>("jagged")(
+        ref.size(), manager.get_allocator());
+    for (int i = 0; i < 5000; ++i) {
+      ref[i % 7 * 7 % ref.size()].push_back(i);
+      jagged->push_back(i % 7 * 7 % ref.size(), i);
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *jagged = manager.find<persistent_type>("jagged").first;
+    ASSERT_NE(jagged, nullptr);
+    check(*jagged, ref);
+    ASSERT_TRUE(manager.destroy<persistent_type>("jagged"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
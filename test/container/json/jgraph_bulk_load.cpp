@@ -0,0 +1,175 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <metall/metall.hpp>
+#include <metall/container/experimental/jgraph/bulk_load.hpp>
+#include "../../test_utility.hpp"
+
+namespace mj = metall::json;
+namespace jg = metall::container::experimental::jgraph;
+
+namespace {
+
+constexpr std::size_t k_num_vertices = 300;
+constexpr std::size_t k_num_edges = 2000;
+
+std::string vertex_id(const std::size_t i) { return "v" + std::to_string(i); }
+
+std::pair<std::size_t, std::size_t> edge(const std::size_t i) {
+  // Includes vertices that are not in the vertex file
+  return std::make_pair((i * 7) % (k_num_vertices + 20),
+                        (i * 13 + i / 3) % (k_num_vertices + 20));
+}
+
+std::string vertex_line(const std::size_t i, const std::size_t version) {
+  return R"({"id":")" + vertex_id(i) + R"(","name":"n)" +
+         std::to_string(i * 10 + version) + R"("})";
+}
+
+std::string edge_line(const std::size_t i) {
+  const auto [src, dst] = edge(i);
+  return R"({"start":")" + vertex_id(src) + R"(","end":")" + vertex_id(dst) +
+         R"(","id":")" + std::to_string(i) + R"("})";
+}
+
+// Writes the vertex and edge files; the second vertex file overwrites some
+// vertices and both files have broken lines.
+std::pair<std::vector<std::string>, std::vector<std::string>> write_files() {
+  const auto dir = test_utility::make_test_path();
+  std::filesystem::create_directories(dir);
+  std::vector<std::string> vertex_files{dir / "v0.jsonl", dir / "v1.jsonl"};
+  std::vector<std::string> edge_files{dir / "e0.jsonl"};
+  {
+    std::ofstream ofs(vertex_files[0]);
+    for (std::size_t i = 0; i < k_num_vertices; ++i) {
+      ofs << vertex_line(i, 0) << "\n";
+      if (i == 10) ofs << R"({"id":"broken")" << "\n\n";
+    }
+  }
+  {
+    std::ofstream ofs(vertex_files[1]);
+    for (std::size_t i = 0; i < k_num_vertices; i += 3) {
+      ofs << vertex_line(i, 1) << "\n";
+    }
+    ofs << R"({"name":"no ID"})" << "\n";
+  }
+  {
+    std::ofstream ofs(edge_files[0]);
+    for (std::size_t i = 0; i < k_num_edges; ++i) {
+      ofs << edge_line(i) << "\n";
+      if (i == 100) ofs << R"({"start":"v0"})" << "\n";
+    }
+  }
+  return std::make_pair(vertex_files, edge_files);
+}
+
+template <typename graph_type>
+void build_serially(graph_type &graph, const bool undirected) {
+  const auto alloc = graph.get_allocator();
+  for (std::size_t i = 0; i < k_num_vertices; ++i) {
+    graph.register_vertex(vertex_id(i))->value() =
+        mj::parse(vertex_line(i, 0), alloc);
+  }
+  for (std::size_t i = 0; i < k_num_vertices; i += 3) {
+    graph.register_vertex(vertex_id(i))->value() =
+        mj::parse(vertex_line(i, 1), alloc);
+  }
+  for (std::size_t i = 0; i < k_num_edges; ++i) {
+    const auto [src, dst] = edge(i);
+    graph.register_edge(vertex_id(src), vertex_id(dst), undirected)->value() =
+        mj::parse(edge_line(i), alloc);
+  }
+}
+
+template <typename graph_type, typename ref_graph_type>
+void check_graph(const graph_type &graph, const ref_graph_type &ref) {
+  ASSERT_EQ(graph.num_vertices(), ref.num_vertices());
+  ASSERT_EQ(graph.num_edges(), ref.num_edges());
+  for (auto itr = ref.vertices_begin(); itr != ref.vertices_end(); ++itr) {
+    const auto id = itr->id();
+    ASSERT_TRUE(graph.has_vertex(id));
+    ASSERT_EQ(mj::serialize(graph.find_vertex(id)->value()),
+              mj::serialize(itr->value()));
+    ASSERT_EQ(graph.degree(id), ref.degree(id));
+
+    std::vector<std::string> edges;
+    for (auto eitr = graph.edges_begin(id); eitr != graph.edges_end(id);
+         ++eitr) {
+      edges.push_back(mj::serialize(eitr->value()));
+    }
+    std::vector<std::string> ref_edges;
+    for (auto eitr = ref.edges_begin(id); eitr != ref.edges_end(id); ++eitr) {
+      ref_edges.push_back(mj::serialize(eitr->value()));
+    }
+    std::sort(edges.begin(), edges.end());
+    std::sort(ref_edges.begin(), ref_edges.end());
+    ASSERT_EQ(edges, ref_edges);
+  }
+}
+
+TEST(JGraphBulkLoadTest, Load) {
+  const auto [vertex_files, edge_files] = write_files();
+  for (const bool undirected : {false, true}) {
+    for (const std::size_t num_threads : {1, 4}) {
+      jg::jgraph<> ref;
+      build_serially(ref, undirected);
+
+      jg::jgraph<> graph;
+      jg::bulk_load_options options;
+      options.undirected = undirected;
+      options.num_threads = num_threads;
+      options.batch_size = 97;
+      const auto [num_vertex_lines, num_edge_lines] =
+          jg::bulk_load(graph, vertex_files, edge_files, options);
+      ASSERT_EQ(num_vertex_lines, k_num_vertices + (k_num_vertices + 2) / 3);
+      ASSERT_EQ(num_edge_lines, k_num_edges);
+      check_graph(graph, ref);
+    }
+  }
+}
+
+TEST(JGraphBulkLoadTest, LoadTwice) {
+  const auto [vertex_files, edge_files] = write_files();
+  jg::jgraph<> ref;
+  build_serially(ref, false);
+  build_serially(ref, false);
+
+  jg::jgraph<> graph;
+  jg::bulk_load_options options;
+  options.num_threads = 3;
+  jg::bulk_load(graph, vertex_files, edge_files, options);
+  jg::bulk_load(graph, vertex_files, edge_files, options);
+  check_graph(graph, ref);
+}
+
+TEST(JGraphBulkLoadTest, Persistence) {
+  using graph_type = jg::jgraph<metall::manager::allocator_type<std::byte>>;
+  const auto [vertex_files, edge_files] = write_files();
+  const auto dir = test_utility::make_test_path("datastore");
+  {
+    metall::manager manager(metall::create_only, dir.c_str());
+    auto *graph = manager.construct<graph_type>(metall::unique_instance)(
+        manager.get_allocator());
+    jg::bulk_load_options options;
+    options.num_threads = 4;
+    jg::bulk_load(*graph, vertex_files, edge_files, options);
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir.c_str());
+    const auto *graph = manager.find<graph_type>(metall::unique_instance).first;
+    jg::jgraph<> ref;
+    build_serially(ref, false);
+    check_graph(*graph, ref);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,167 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <metall/metall.hpp>
+#include <metall/container/experimental/jgraph/jgraph.hpp>
+#include "../../test_utility.hpp"
+
+namespace jg = metall::container::experimental::jgraph;
+
+namespace {
+
+constexpr std::size_t k_num_vertices = 100;
+constexpr std::size_t k_num_edges = 1000;
+
+std::string vertex_id(const std::size_t i) { return "v" + std::to_string(i); }
+
+template <typename graph_type>
+void build(graph_type &graph, const bool undirected) {
+  for (std::size_t i = 0; i < k_num_vertices; ++i) {
+    graph.register_vertex(vertex_id(i))->value().emplace_string() =
+        vertex_id(i).c_str();
+  }
+  for (std::size_t i = 0; i < k_num_edges; ++i) {
+    // Includes self-loops and parallel edges
+    const auto src = vertex_id((i * 7) % k_num_vertices);
+    const auto dst = vertex_id((i * 13 + i / 5) % k_num_vertices);
+    graph.register_edge(src, dst, undirected)->value().emplace_int64() = i;
+  }
+}
+
+template <typename graph_type>
+std::vector<int64_t> edge_values(const graph_type &graph,
+                                 const std::string &vid) {
+  std::vector<int64_t> values;
+  for (auto itr = graph.edges_begin(vid); itr != graph.edges_end(vid); ++itr) {
+    values.push_back(itr->value().as_int64());
+  }
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+template <typename graph_type, typename ref_graph_type>
+void check_graph(const graph_type &graph, const ref_graph_type &ref) {
+  ASSERT_EQ(graph.num_vertices(), ref.num_vertices());
+  ASSERT_EQ(graph.num_edges(), ref.num_edges());
+  for (std::size_t i = 0; i < k_num_vertices; ++i) {
+    const auto vid = vertex_id(i);
+    ASSERT_EQ(graph.degree(vid), ref.degree(vid));
+    ASSERT_EQ(edge_values(graph, vid), edge_values(ref, vid));
+    for (std::size_t j = 0; j < k_num_vertices; j += 7) {
+      ASSERT_EQ(graph.has_edges(vid, vertex_id(j)),
+                ref.has_edges(vid, vertex_id(j)));
+    }
+  }
+}
+
+TEST(JGraphFreezeTest, Freeze) {
+  for (const bool undirected : {false, true}) {
+    jg::jgraph<> ref;
+    build(ref, undirected);
+
+    jg::jgraph<> graph;
+    build(graph, undirected);
+    ASSERT_FALSE(graph.frozen());
+    graph.freeze();
+    ASSERT_TRUE(graph.frozen());
+    check_graph(graph, ref);
+
+    // Every edge leads to a registered vertex
+    for (std::size_t i = 0; i < k_num_vertices; ++i) {
+      const auto vid = vertex_id(i);
+      for (auto itr = graph.edges_begin(vid); itr != graph.edges_end(vid);
+           ++itr) {
+        const auto neighbor = (itr->source_id() == vid)
+                                  ? itr->destination_id()
+                                  : itr->source_id();
+        ASSERT_TRUE(graph.has_vertex(neighbor));
+      }
+    }
+
+    graph.thaw();
+    ASSERT_FALSE(graph.frozen());
+    check_graph(graph, ref);
+  }
+}
+
+TEST(JGraphFreezeTest, FindEdges) {
+  jg::jgraph<> graph;
+  build(graph, false);
+  graph.freeze();
+  for (std::size_t i = 0; i < k_num_vertices; ++i) {
+    for (std::size_t j = 0; j < k_num_vertices; ++j) {
+      const auto src = vertex_id(i);
+      const auto dst = vertex_id(j);
+      const auto range = graph.find_edges(src, dst);
+      std::size_t count = 0;
+      for (auto itr = range.first; itr != range.second; ++itr) {
+        ASSERT_EQ(itr->source_id(), src);
+        ASSERT_EQ(itr->destination_id(), dst);
+        ++count;
+      }
+      ASSERT_EQ(count, graph.has_edges(src, dst));
+    }
+  }
+  const auto range = graph.find_edges("v0", "none");
+  ASSERT_EQ(range.first, range.second);
+}
+
+TEST(JGraphFreezeTest, Modify) {
+  jg::jgraph<> ref;
+  build(ref, true);
+
+  jg::jgraph<> graph;
+  build(graph, true);
+  graph.freeze();
+
+  // Values can be modified while frozen
+  for (auto itr = graph.edges_begin("v1"); itr != graph.edges_end("v1");
+       ++itr) {
+    itr->value().as_int64() += 1;
+  }
+  for (auto itr = ref.edges_begin("v1"); itr != ref.edges_end("v1"); ++itr) {
+    itr->value().as_int64() += 1;
+  }
+  check_graph(graph, ref);
+
+  // Registering an existing vertex keeps the graph frozen
+  graph.register_vertex("v1");
+  ASSERT_TRUE(graph.frozen());
+
+  // Registering an edge thaws the graph
+  graph.register_edge("v1", "v2", true)->value().emplace_int64() = -1;
+  ref.register_edge("v1", "v2", true)->value().emplace_int64() = -1;
+  ASSERT_FALSE(graph.frozen());
+  check_graph(graph, ref);
+
+  graph.freeze();
+  check_graph(graph, ref);
+}
+
+TEST(JGraphFreezeTest, Persistence) {
+  using graph_type = jg::jgraph<metall::manager::allocator_type<std::byte>>;
+  const auto dir = test_utility::make_test_path();
+  {
+    metall::manager manager(metall::create_only, dir.c_str());
+    auto *graph = manager.construct<graph_type>(metall::unique_instance)(
+        manager.get_allocator());
+    build(*graph, true);
+    graph->freeze();
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir.c_str());
+    const auto *graph = manager.find<graph_type>(metall::unique_instance).first;
+    ASSERT_TRUE(graph->frozen());
+    jg::jgraph<> ref;
+    build(ref, true);
+    check_graph(*graph, ref);
+  }
+}
+
+}  // namespace
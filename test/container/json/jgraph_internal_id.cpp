@@ -0,0 +1,95 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <metall/container/experimental/jgraph/jgraph.hpp>
+
+namespace jg = metall::container::experimental::jgraph;
+
+namespace {
+
+using graph_type = jg::jgraph<>;
+
+constexpr std::size_t k_num_vertices = 50;
+
+std::string vertex_id(const std::size_t i) { return "v" + std::to_string(i); }
+
+void build(graph_type &graph) {
+  for (std::size_t i = 0; i < k_num_vertices; ++i) {
+    graph.register_vertex(vertex_id(i))->value().emplace_int64() = i;
+  }
+  for (std::size_t i = 0; i < k_num_vertices * 5; ++i) {
+    graph
+        .register_edge(vertex_id(i % k_num_vertices),
+                       vertex_id((i * 3 + 1) % k_num_vertices), true)
+        ->value()
+        .emplace_int64() = i;
+  }
+}
+
+// Traverses the graph only with internal IDs and checks the results with
+// the string ID API
+void check(const graph_type &graph) {
+  ASSERT_FALSE(graph.has_vertex(graph_type::invalid_internal_id()));
+  ASSERT_EQ(graph.internal_id("none"), graph_type::invalid_internal_id());
+  ASSERT_EQ(graph.degree(graph_type::invalid_internal_id()), 0);
+  ASSERT_EQ(graph.edges_begin(graph_type::invalid_internal_id()),
+            graph.edges_end(graph_type::invalid_internal_id()));
+
+  for (auto vitr = graph.vertices_begin(); vitr != graph.vertices_end();
+       ++vitr) {
+    const auto vid = vitr->id();
+    const auto internal_id = vitr.internal_id();
+    ASSERT_EQ(graph.internal_id(vid), internal_id);
+    ASSERT_TRUE(graph.has_vertex(internal_id));
+    ASSERT_EQ(graph.find_vertex(internal_id)->id(), vid);
+    ASSERT_EQ(graph.degree(internal_id), graph.degree(vid));
+
+    std::vector<int64_t> values;
+    for (auto eitr = graph.edges_begin(internal_id),
+              eend = graph.edges_end(internal_id);
+         eitr != eend; ++eitr) {
+      values.push_back(eitr->value().as_int64());
+      const auto neighbor = eitr.neighbor_internal_id();
+      const auto neighbor_vid = graph.find_vertex(neighbor)->id();
+      ASSERT_TRUE(neighbor_vid == eitr->destination_id() ||
+                  neighbor_vid == eitr->source_id());
+      ASSERT_EQ(graph.has_edges(internal_id, neighbor),
+                graph.has_edges(vid, neighbor_vid));
+      const auto range = graph.find_edges(internal_id, neighbor);
+      ASSERT_EQ(std::distance(range.first, range.second),
+                graph.has_edges(internal_id, neighbor));
+    }
+
+    std::vector<int64_t> ref_values;
+    for (auto eitr = graph.edges_begin(vid), eend = graph.edges_end(vid);
+         eitr != eend; ++eitr) {
+      ref_values.push_back(eitr->value().as_int64());
+    }
+    std::sort(values.begin(), values.end());
+    std::sort(ref_values.begin(), ref_values.end());
+    ASSERT_EQ(values, ref_values);
+  }
+}
+
+TEST(JGraphInternalIdTest, Traverse) {
+  graph_type graph;
+  build(graph);
+  check(graph);
+}
+
+TEST(JGraphInternalIdTest, TraverseFrozen) {
+  graph_type graph;
+  build(graph);
+  const auto internal_id = graph.internal_id("v1");
+  graph.freeze();
+  ASSERT_EQ(graph.internal_id("v1"), internal_id);
+  check(graph);
+}
+
+}  // namespace
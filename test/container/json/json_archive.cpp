@@ -0,0 +1,49 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <sstream>
+#include <string>
+#include <metall/metall.hpp>
+#include <metall/json/json.hpp>
+#include <metall/utility/archive.hpp>
+#include "../../test_utility.hpp"
+
+namespace mj = metall::json;
+
+namespace {
+
+TEST(JSONArchiveTest, WriteAndRead) {
+  using json_value_type = mj::value<metall::manager::allocator_type<std::byte>>;
+  const std::string text = R"({"a": [1, 2.5, "three"], "b": {"c": null}})";
+
+  std::stringstream stream;
+  {
+    const auto dir = test_utility::make_test_path("source");
+    metall::manager manager(metall::create_only, dir.c_str());
+    manager.construct<json_value_type>("json")(
+        mj::parse(text, manager.get_allocator()));
+
+    metall::utility::archive_writer writer(stream);
+    GTEST_ASSERT_TRUE(writer.write_named<json_value_type>(manager, "json"));
+    GTEST_ASSERT_TRUE(writer.close());
+  }
+
+  {
+    const auto dir = test_utility::make_test_path("destination");
+    metall::manager manager(metall::create_only, dir.c_str());
+    metall::utility::archive_reader reader(stream);
+    GTEST_ASSERT_TRUE(reader.next());
+    GTEST_ASSERT_EQ(reader.name(), "json");
+    const auto *const value = reader.load<json_value_type>(manager);
+    GTEST_ASSERT_NE(value, nullptr);
+    GTEST_ASSERT_EQ(*value, mj::parse(text, manager.get_allocator()));
+    GTEST_ASSERT_TRUE(value->is_object());
+    GTEST_ASSERT_FALSE(reader.next());
+    GTEST_ASSERT_TRUE(reader.good());
+  }
+}
+
+}  // namespace
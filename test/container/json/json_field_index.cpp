@@ -0,0 +1,201 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/json/json.hpp>
+#include "../../test_utility.hpp"
+
+namespace mc = metall::container;
+namespace mj = metall::json;
+
+namespace {
+
+// {"user": {"name": "u<i % 10>", "age": i % 50}, "score": i * 0.5};
+// every 7th document has no "score"
+template <typename value_type, typename allocator_type>
+value_type make_document(const std::size_t i, const allocator_type &alloc) {
+  value_type doc(alloc);
+  auto &obj = doc.emplace_object();
+  auto &user = obj["user"].emplace_object();
+  user["name"].emplace_string() = "u" + std::to_string(i % 10);
+  user["age"].emplace_int64() = i % 50;
+  if (i % 7 != 0) obj["score"].emplace_double() = i * 0.5;
+  return doc;
+}
+
+using value_type = mj::value<std::allocator<std::byte>>;
+
+std::vector<value_type> make_documents(const std::size_t n) {
+  std::vector<value_type> docs;
+  for (std::size_t i = 0; i < n; ++i) {
+    docs.push_back(
+        make_document<value_type>(i, std::allocator<std::byte>{}));
+  }
+  return docs;
+}
+
+TEST(JSONFieldIndexTest, SortedIndex) {
+  const auto docs = make_documents(1000);
+  mj::sorted_field_index<int64_t> index("/user/age");
+  index.build(docs.begin(), docs.end());
+  GTEST_ASSERT_EQ(index.size(), docs.size());
+  GTEST_ASSERT_EQ(index.field_pointer(), "/user/age");
+
+  std::vector<mj::document_id_type> ids;
+  index.find(7, [&ids](mj::document_id_type id) { ids.push_back(id); });
+  GTEST_ASSERT_EQ(ids.size(), 20);
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    GTEST_ASSERT_EQ(ids[i], 7 + i * 50);
+  }
+
+  std::size_t num_in_range = 0;
+  int64_t previous = 10;
+  index.find_range(10, 19, [&](const int64_t age, mj::document_id_type id) {
+    EXPECT_LE(previous, age);
+    EXPECT_EQ(int64_t(id % 50), age);
+    previous = age;
+    ++num_in_range;
+  });
+  GTEST_ASSERT_EQ(num_in_range, 10 * 20);
+
+  GTEST_ASSERT_TRUE(index.erase(7, docs[7]));
+  GTEST_ASSERT_FALSE(index.erase(7, docs[7]));
+  GTEST_ASSERT_EQ(index.count(7), 19);
+  GTEST_ASSERT_TRUE(index.insert(7, docs[7]));
+  GTEST_ASSERT_EQ(index.count(7), 20);
+
+  // Missing fields are not indexed
+  mj::sorted_field_index<double> score_index("/score");
+  score_index.build(docs.begin(), docs.end());
+  GTEST_ASSERT_EQ(score_index.size(), docs.size() - (docs.size() + 6) / 7);
+}
+
+TEST(JSONFieldIndexTest, HashIndex) {
+  const auto docs = make_documents(1000);
+  mj::hash_field_index<std::string_view> index("/user/name");
+  index.build(docs.begin(), docs.end());
+  GTEST_ASSERT_EQ(index.size(), docs.size());
+
+  const auto get_document = [&docs](mj::document_id_type id)
+      -> const value_type & { return docs[id]; };
+  std::size_t n = 0;
+  index.find("u3", get_document, [&n](mj::document_id_type id) {
+    EXPECT_EQ(id % 10, 3);
+    ++n;
+  });
+  GTEST_ASSERT_EQ(n, 100);
+
+  n = 0;
+  index.find("none", get_document, [&n](mj::document_id_type) { ++n; });
+  GTEST_ASSERT_EQ(n, 0);
+
+  GTEST_ASSERT_TRUE(index.erase(3, docs[3]));
+  n = 0;
+  index.find("u3", get_document, [&n](mj::document_id_type) { ++n; });
+  GTEST_ASSERT_EQ(n, 99);
+
+  mj::hash_field_index<int64_t> age_index("/user/age");
+  age_index.build(docs.begin(), docs.end());
+  n = 0;
+  age_index.find(49, get_document, [&n](mj::document_id_type) { ++n; });
+  GTEST_ASSERT_EQ(n, 20);
+}
+
+TEST(JSONFieldIndexTest, NumericColumn) {
+  const auto docs = make_documents(1000);
+  mj::numeric_column<double> column("/score");
+  column.build(docs.begin(), docs.end());
+  GTEST_ASSERT_EQ(column.size(), docs.size());
+
+  double expected_sum = 0;
+  std::size_t expected_count = 0;
+  for (std::size_t i = 0; i < docs.size(); ++i) {
+    GTEST_ASSERT_EQ(column.has_value(i), i % 7 != 0);
+    if (i % 7 == 0) continue;
+    GTEST_ASSERT_EQ(column[i], i * 0.5);
+    expected_sum += i * 0.5;
+    ++expected_count;
+  }
+  GTEST_ASSERT_EQ(column.count(), expected_count);
+  ASSERT_DOUBLE_EQ(column.sum(), expected_sum);
+  GTEST_ASSERT_EQ(column.min(), 0.5);
+  GTEST_ASSERT_EQ(column.max(), 999 * 0.5);
+  GTEST_ASSERT_EQ(column.data()[2], 1.0);
+
+  // Filter
+  std::size_t n = 0;
+  column.for_each([&n](mj::document_id_type, const double score) {
+    if (score >= 400) ++n;
+  });
+  std::size_t expected_n = 0;
+  for (std::size_t i = 800; i < docs.size(); ++i) expected_n += (i % 7 != 0);
+  GTEST_ASSERT_EQ(n, expected_n);
+
+  // Update
+  GTEST_ASSERT_FALSE(column.set(1, docs[0]));
+  GTEST_ASSERT_FALSE(column.has_value(1));
+  GTEST_ASSERT_TRUE(column.set(2000, docs[1]));
+  GTEST_ASSERT_EQ(column.size(), 2001);
+  GTEST_ASSERT_EQ(column[2000], 0.5);
+}
+
+TEST(JSONFieldIndexTest, Persistence) {
+  using alloc_type = metall::manager::allocator_type<std::byte>;
+  using json_value_type = mj::value<alloc_type>;
+  using vector_type =
+      mc::vector<json_value_type,
+                 metall::manager::scoped_allocator_type<json_value_type>>;
+  using index_type = mj::sorted_field_index<int64_t, alloc_type>;
+  using column_type = mj::numeric_column<double, alloc_type>;
+
+  const auto dir = test_utility::make_test_path();
+  {
+    metall::manager manager(metall::create_only, dir.c_str());
+    auto *docs = manager.construct<vector_type>("docs")(
+        manager.get_allocator());
+    for (std::size_t i = 0; i < 100; ++i) {
+      docs->push_back(
+          make_document<json_value_type>(i, manager.get_allocator()));
+    }
+    auto *index =
+        manager.construct<index_type>("age")("/user/age",
+                                             manager.get_allocator());
+    index->build(docs->begin(), docs->end());
+    auto *column =
+        manager.construct<column_type>("score")("/score",
+                                                manager.get_allocator());
+    column->build(docs->begin(), docs->end());
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir.c_str());
+    auto *docs = manager.find<vector_type>("docs").first;
+    auto *index = manager.find<index_type>("age").first;
+    auto *column = manager.find<column_type>("score").first;
+    GTEST_ASSERT_EQ(index->field_pointer(), "/user/age");
+    GTEST_ASSERT_EQ(index->count(3), 2);
+
+    // Maintain them alongside the documents
+    const auto id = docs->size();
+    docs->push_back(
+        make_document<json_value_type>(103, manager.get_allocator()));
+    GTEST_ASSERT_TRUE(index->insert(id, (*docs)[id]));
+    GTEST_ASSERT_TRUE(column->set(id, (*docs)[id]));
+    GTEST_ASSERT_EQ(index->count(3), 3);
+    GTEST_ASSERT_EQ((*column)[id], 103 * 0.5);
+
+    manager.destroy<column_type>("score");
+    manager.destroy<index_type>("age");
+    manager.destroy<vector_type>("docs");
+    GTEST_ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,145 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <string>
+#include <unordered_set>
+#include <metall/json/json.hpp>
+
+namespace mj = metall::json;
+namespace bj = boost::json;
+
+namespace {
+
+const char *const json_string = R"(
+{
+  "pi": 3.141,
+  "happy": true,
+  "name": "Niels",
+  "nothing": null,
+  "answer": {
+    "everything": 42
+  },
+  "list": [1, 0, 2],
+  "object": {
+    "currency": "USD",
+    "value": -42.99
+  }
+}
+)";
+
+const char *const reordered_json_string = R"(
+{
+  "object": {
+    "value": -42.99,
+    "currency": "USD"
+  },
+  "list": [1, 0, 2],
+  "answer": {
+    "everything": 42
+  },
+  "nothing": null,
+  "name": "Niels",
+  "happy": true,
+  "pi": 3.141
+}
+)";
+
+TEST(JSONHashTest, Equal) {
+  const auto jv1 = mj::parse(json_string);
+  const auto jv2 = mj::parse(reordered_json_string);
+  GTEST_ASSERT_EQ(jv1, jv2);
+  GTEST_ASSERT_EQ(mj::hash_value(jv1), mj::hash_value(jv2));
+  GTEST_ASSERT_EQ(mj::hash_value(jv1), mj::hash_value(jv1.as_object()));
+  GTEST_ASSERT_EQ(mj::hash_value(jv1.as_object().at("list")),
+                  mj::hash_value(jv1.as_object().at("list").as_array()));
+
+  // Same as the Boost.JSON values equal to them
+  const auto bj_value = bj::parse(json_string);
+  GTEST_ASSERT_EQ(jv1, bj_value);
+  GTEST_ASSERT_EQ(mj::hash_value(jv1), mj::hash_value(bj_value));
+}
+
+TEST(JSONHashTest, NotEqual) {
+  const auto jv1 = mj::parse(json_string);
+  auto jv2 = mj::parse(json_string);
+  jv2.as_object()["object"].as_object()["currency"].as_string() = "JPY";
+  GTEST_ASSERT_NE(jv1, jv2);
+  GTEST_ASSERT_NE(mj::hash_value(jv1), mj::hash_value(jv2));
+
+  // Arrays are ordered
+  GTEST_ASSERT_NE(mj::hash_value(mj::parse("[1, 2]")),
+                  mj::hash_value(mj::parse("[2, 1]")));
+  GTEST_ASSERT_NE(mj::hash_value(mj::parse("[]")),
+                  mj::hash_value(mj::parse("{}")));
+  GTEST_ASSERT_NE(mj::hash_value(mj::parse(R"({"a": 1})")),
+                  mj::hash_value(mj::parse(R"({"b": 1})")));
+}
+
+TEST(JSONHashTest, Numbers) {
+  mj::value<> int_value;
+  mj::value<> uint_value;
+  int_value.emplace_int64() = 10;
+  uint_value.emplace_uint64() = 10;
+  GTEST_ASSERT_EQ(int_value, uint_value);
+  GTEST_ASSERT_EQ(mj::hash_value(int_value), mj::hash_value(uint_value));
+
+  int_value.emplace_int64() = -1;
+  uint_value.emplace_uint64() = static_cast<std::uint64_t>(-1);
+  GTEST_ASSERT_NE(int_value, uint_value);
+  GTEST_ASSERT_NE(mj::hash_value(int_value), mj::hash_value(uint_value));
+
+  mj::value<> zero;
+  mj::value<> negative_zero;
+  zero.emplace_double() = 0.0;
+  negative_zero.emplace_double() = -0.0;
+  GTEST_ASSERT_EQ(zero, negative_zero);
+  GTEST_ASSERT_EQ(mj::hash_value(zero), mj::hash_value(negative_zero));
+}
+
+TEST(JSONHashTest, EmbeddedNull) {
+  mj::value<> jv1;
+  mj::value<> jv2;
+  jv1.emplace_string() = std::string("a\0b", 3);
+  jv2.emplace_string() = std::string("a\0c", 3);
+  GTEST_ASSERT_NE(jv1, jv2);
+  GTEST_ASSERT_NE(mj::hash_value(jv1), mj::hash_value(jv2));
+
+  jv2.as_string() = std::string("a\0b", 3);
+  GTEST_ASSERT_EQ(jv1, jv2);
+  GTEST_ASSERT_EQ(mj::hash_value(jv1), mj::hash_value(jv2));
+}
+
+TEST(JSONHashTest, Hasher) {
+  auto jv = mj::parse(json_string);
+  mj::value_hasher<> hasher;
+  GTEST_ASSERT_EQ(hasher(jv), mj::hash_value(jv));
+  GTEST_ASSERT_EQ(hasher.size(), 4);  // 3 objects and 1 array
+  GTEST_ASSERT_EQ(hasher(jv.as_object()), mj::hash_value(jv));
+  GTEST_ASSERT_EQ(hasher.size(), 4);
+
+  // The memoized hashes are used until forgotten
+  const auto old_hash = hasher(jv);
+  auto &answer = jv.as_object()["answer"];
+  answer.as_object()["everything"] = 43;
+  GTEST_ASSERT_EQ(hasher(jv), old_hash);
+  hasher.forget(answer);
+  hasher.forget(jv);
+  GTEST_ASSERT_EQ(hasher(jv), mj::hash_value(jv));
+  GTEST_ASSERT_NE(hasher(jv), old_hash);
+
+  hasher.clear();
+  GTEST_ASSERT_EQ(hasher.size(), 0);
+}
+
+TEST(JSONHashTest, Deduplicate) {
+  std::unordered_set<mj::value<>> documents;
+  documents.insert(mj::parse(json_string));
+  documents.insert(mj::parse(reordered_json_string));
+  documents.insert(mj::parse(R"({"name": "Niels"})"));
+  GTEST_ASSERT_EQ(documents.size(), 2);
+}
+
+}  // namespace
@@ -4,7 +4,9 @@
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
 #include "gtest/gtest.h"
+#include <cstring>
 #include <memory>
+#include <string>
 #include <metall/json/json.hpp>
 
 namespace mj = metall::json;
@@ -173,4 +175,83 @@ TEST(JSONObjectTest, Equal) {
   GTEST_ASSERT_FALSE(obj == obj_cpy);
   GTEST_ASSERT_TRUE(obj != obj_cpy);
 }
+
+TEST(JSONObjectTest, LargeObject) {
+  // Crosses the threshold at which a hash index is used
+  const std::size_t n = object_type::k_index_threshold * 8;
+  object_type obj;
+  for (std::size_t i = 0; i < n; ++i) {
+    obj[std::to_string(i)].emplace_uint64() = i;
+  }
+  GTEST_ASSERT_EQ(obj.size(), n);
+  for (std::size_t i = 0; i < n; ++i) {
+    GTEST_ASSERT_EQ(obj.at(std::to_string(i)).as_uint64(), i);
+  }
+  GTEST_ASSERT_FALSE(obj.contains("-1"));
+
+  // Keeps the insertion order
+  std::size_t pos = 0;
+  for (const auto &kv : obj) {
+    GTEST_ASSERT_EQ(kv.key(), std::to_string(pos));
+    ++pos;
+  }
+
+  for (std::size_t i = 0; i < n; i += 2) obj.erase(std::to_string(i));
+  GTEST_ASSERT_EQ(obj.size(), n / 2);
+  for (std::size_t i = 0; i < n; ++i) {
+    GTEST_ASSERT_EQ(obj.count(std::to_string(i)), i % 2);
+  }
+
+  auto cp(obj);
+  GTEST_ASSERT_TRUE(cp == obj);
+  object_type mv(std::move(cp));
+  GTEST_ASSERT_TRUE(mv == obj);
+  object_type assigned;
+  assigned = obj;
+  GTEST_ASSERT_TRUE(assigned == obj);
+
+  // Becomes small again
+  for (std::size_t i = 1; i < n; i += 2) mv.erase(std::to_string(i));
+  GTEST_ASSERT_EQ(mv.size(), 0);
+  mv["0"].emplace_bool() = true;
+  GTEST_ASSERT_TRUE(mv.at("0").as_bool());
+}
+
+TEST(JSONObjectTest, KeyLength) {
+  // Short keys are stored inline; long ones are allocated
+  object_type obj;
+  for (std::size_t len = 0; len < 40; ++len) {
+    obj[std::string(len, 'k')].emplace_uint64() = len;
+  }
+  for (std::size_t len = 0; len < 40; ++len) {
+    const std::string key(len, 'k');
+    auto itr = obj.find(key);
+    GTEST_ASSERT_NE(itr, obj.end());
+    GTEST_ASSERT_EQ(itr->key(), key);
+    GTEST_ASSERT_EQ(std::strlen(itr->key_c_str()), len);
+    GTEST_ASSERT_EQ(itr->value().as_uint64(), len);
+  }
+
+  // Swap short and long keys
+  using key_value_type = object_type::value_type;
+  for (std::size_t len0 = 0; len0 < 40; len0 += 3) {
+    for (std::size_t len1 = 0; len1 < 40; len1 += 5) {
+      const std::string key0(len0, 'a');
+      const std::string key1(len1, 'b');
+      key_value_type kv0(key0, mj::value<std::allocator<std::byte>>{});
+      key_value_type kv1(key1, mj::value<std::allocator<std::byte>>{});
+      kv0.swap(kv1);
+      GTEST_ASSERT_EQ(kv0.key(), key1);
+      GTEST_ASSERT_EQ(kv1.key(), key0);
+
+      key_value_type mv(std::move(kv0));
+      GTEST_ASSERT_EQ(mv.key(), key1);
+      GTEST_ASSERT_EQ(kv0.key().length(), 0);
+      kv0 = mv;
+      GTEST_ASSERT_EQ(kv0.key(), key1);
+      kv0 = std::move(kv1);
+      GTEST_ASSERT_EQ(kv0.key(), key0);
+    }
+  }
+}
 }  // namespace
\ No newline at end of file
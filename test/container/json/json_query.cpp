@@ -0,0 +1,146 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <metall/json/json.hpp>
+
+namespace mj = metall::json;
+
+namespace {
+
+using value_type = mj::value<std::allocator<std::byte>>;
+
+// {"store": {"book": [{"title": "A", "price": 8},
+//                     {"title": "B", "price": 12, "tags": ["x"]}],
+//            "bicycle": {"price": 20}},
+//  "a/b": 1, "m~n": 2}
+value_type make_store() {
+  value_type root;
+  auto &store = root.emplace_object()["store"].emplace_object();
+  auto &books = store["book"].emplace_array();
+  books.resize(2);
+  auto &book0 = books[0].emplace_object();
+  book0["title"].emplace_string() = "A";
+  book0["price"].emplace_int64() = 8;
+  auto &book1 = books[1].emplace_object();
+  book1["title"].emplace_string() = "B";
+  book1["price"].emplace_int64() = 12;
+  auto &tags = book1["tags"].emplace_array();
+  tags.resize(1);
+  tags[0].emplace_string() = "x";
+  store["bicycle"].emplace_object()["price"].emplace_int64() = 20;
+  root.as_object()["a/b"].emplace_int64() = 1;
+  root.as_object()["m~n"].emplace_int64() = 2;
+  return root;
+}
+
+TEST(JSONQueryTest, Pointer) {
+  const auto root = make_store();
+
+  GTEST_ASSERT_EQ(mj::json_pointer("").find(root), &root);
+  GTEST_ASSERT_EQ(mj::json_pointer("/store/book/1/title").find(root)
+                      ->as_string(),
+                  "B");
+  GTEST_ASSERT_EQ(mj::json_pointer("/store/bicycle/price").find(root)
+                      ->as_int64(),
+                  20);
+  GTEST_ASSERT_EQ(mj::json_pointer("/a~1b").find(root)->as_int64(), 1);
+  GTEST_ASSERT_EQ(mj::json_pointer("/m~0n").find(root)->as_int64(), 2);
+
+  GTEST_ASSERT_EQ(mj::json_pointer("/store/book/2").find(root), nullptr);
+  GTEST_ASSERT_EQ(mj::json_pointer("/store/book/01").find(root), nullptr);
+  GTEST_ASSERT_EQ(mj::json_pointer("/store/none").find(root), nullptr);
+  GTEST_ASSERT_EQ(mj::json_pointer("/a~1b/c").find(root), nullptr);
+
+  GTEST_ASSERT_FALSE(mj::json_pointer("store").good());
+  GTEST_ASSERT_FALSE(mj::json_pointer("/a~2").good());
+
+  // Modify through a pointer
+  auto copy = root;
+  mj::json_pointer("/store/book/0/price").find(copy)->emplace_int64() = 9;
+  GTEST_ASSERT_EQ(copy.as_object()["store"].as_object()["book"]
+                      .as_array()[0].as_object()["price"].as_int64(),
+                  9);
+}
+
+TEST(JSONQueryTest, Path) {
+  const auto root = make_store();
+
+  {
+    const auto matches = mj::json_path("$.store.book[*].title").find_all(root);
+    GTEST_ASSERT_EQ(matches.size(), 2);
+    GTEST_ASSERT_EQ(matches[0]->as_string(), "A");
+    GTEST_ASSERT_EQ(matches[1]->as_string(), "B");
+  }
+
+  {
+    const auto matches =
+        mj::json_path("$['store'][\"book\"][-1]").find_all(root);
+    GTEST_ASSERT_EQ(matches.size(), 1);
+    GTEST_ASSERT_EQ(matches[0]->as_object().at("title").as_string(), "B");
+  }
+
+  {
+    // Recursive descent
+    const auto matches = mj::json_path("$..price").find_all(root);
+    GTEST_ASSERT_EQ(matches.size(), 3);
+    int64_t sum = 0;
+    for (const auto *m : matches) sum += m->as_int64();
+    GTEST_ASSERT_EQ(sum, 8 + 12 + 20);
+  }
+
+  GTEST_ASSERT_EQ(mj::json_path("$..tags[0]").find_all(root).size(), 1);
+  GTEST_ASSERT_EQ(mj::json_path("$.store.*").find_all(root).size(), 2);
+  GTEST_ASSERT_EQ(mj::json_path("$").find_all(root).size(), 1);
+  GTEST_ASSERT_EQ(mj::json_path("$.store.book[2]").find_all(root).size(), 0);
+  GTEST_ASSERT_EQ(mj::json_path("$.none..price").find_all(root).size(), 0);
+
+  GTEST_ASSERT_FALSE(mj::json_path("store").good());
+  GTEST_ASSERT_FALSE(mj::json_path("$.store[").good());
+  GTEST_ASSERT_FALSE(mj::json_path("$[?(@.price)]").good());
+  GTEST_ASSERT_FALSE(mj::json_path("$.").good());
+}
+
+TEST(JSONQueryTest, Batch) {
+  std::vector<value_type> values(1000);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    auto &obj = values[i].emplace_object();
+    if (i % 3 == 0) continue;  // No match
+    obj["id"].emplace_uint64() = i;
+  }
+
+  const mj::json_path path("$.id");
+  std::atomic<std::size_t> num_matches{0};
+  std::atomic<std::size_t> sum{0};
+  mj::evaluate_batch(
+      values.begin(), values.end(), path,
+      [&](const std::size_t index, const value_type &match) {
+        EXPECT_EQ(index, match.as_uint64());
+        ++num_matches;
+        sum += match.as_uint64();
+      },
+      4);
+
+  std::size_t expected_matches = 0;
+  std::size_t expected_sum = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i % 3 == 0) continue;
+    ++expected_matches;
+    expected_sum += i;
+  }
+  GTEST_ASSERT_EQ(num_matches.load(), expected_matches);
+  GTEST_ASSERT_EQ(sum.load(), expected_sum);
+
+  // A pointer can be used as well
+  num_matches = 0;
+  mj::evaluate_batch(values.begin(), values.end(), mj::json_pointer("/id"),
+                     [&](std::size_t, const value_type &) { ++num_matches; });
+  GTEST_ASSERT_EQ(num_matches.load(), expected_matches);
+}
+}  // namespace
@@ -4,7 +4,11 @@
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
 #include "gtest/gtest.h"
+#include <cstdio>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <metall/json/json.hpp>
 #include <metall/metall.hpp>
 #include "../../test_utility.hpp"
@@ -258,6 +262,14 @@ std::string json_string = R"(
       }
     )";
 
+std::string json_string_one_line() {
+  auto str = json_string;
+  for (auto &c : str) {
+    if (c == '\n') c = ' ';
+  }
+  return str;
+}
+
 template <typename T>
 void check_json_string(T &jv) {
   GTEST_ASSERT_EQ(jv.as_object()["pi"].as_double(), 3.141);
@@ -281,6 +293,107 @@ TEST(JSONValueTest, Parse) {
   check_json_string(jv);
 }
 
+TEST(JSONValueTest, ParseInto) {
+  mj::value jv;
+  GTEST_ASSERT_TRUE(mj::parse_into(json_string, jv));
+  check_json_string(jv);
+
+  // Long strings and deep nesting
+  const std::string long_string(10000, 'a');
+  GTEST_ASSERT_TRUE(mj::parse_into(
+      "[[[{\"k\": \"" + long_string + "\", \"n\": [-1, 2, 0.5, null]}]]]",
+      jv));
+  const auto &obj = jv.as_array()[0].as_array()[0].as_array()[0].as_object();
+  GTEST_ASSERT_EQ(obj["k"].as_string(), long_string);
+  GTEST_ASSERT_EQ(obj["n"].as_array()[0].as_int64(), -1);
+  GTEST_ASSERT_EQ(obj["n"].as_array()[1].as_int64(), 2);
+  GTEST_ASSERT_EQ(obj["n"].as_array()[2].as_double(), 0.5);
+  GTEST_ASSERT_TRUE(obj["n"].as_array()[3].is_null());
+
+  GTEST_ASSERT_FALSE(mj::parse_into("{\"a\": ", jv));
+  GTEST_ASSERT_TRUE(jv.is_null());
+  GTEST_ASSERT_FALSE(mj::parse_into("[1] [2]", jv));
+}
+
+TEST(JSONValueTest, ParseLines) {
+  std::stringstream input;
+  input << json_string_one_line() << "\n"
+        << "\n"  // Empty line
+        << "{\"broken\": \n"
+        << "[1, 2, 3]\n"
+        << json_string_one_line();
+
+  std::vector<mj::value<>> values;
+  const auto num_parsed =
+      mj::parse_lines(input, std::allocator<std::byte>{},
+                      [&values](mj::value<> &&jv) {
+                        values.push_back(std::move(jv));
+                      });
+  GTEST_ASSERT_EQ(num_parsed, 3);
+  GTEST_ASSERT_EQ(values.size(), 3);
+  check_json_string(values[0]);
+  GTEST_ASSERT_EQ(values[1].as_array().size(), 3);
+  check_json_string(values[2]);
+}
+
+TEST(JSONValueTest, Serialize) {
+  mj::value jv;
+  auto &obj = jv.emplace_object();
+  obj["null"].emplace_null();
+  obj["bool"].emplace_bool() = true;
+  obj["int"].emplace_int64() = -12;
+  obj["uint"].emplace_uint64() = 34;
+  obj["double"].emplace_double() = 150.5;
+  obj["string"].emplace_string() = "a\"b\\c\nd\x01";
+  auto &arr = obj["array"].emplace_array();
+  arr.resize(2);
+  arr[0].emplace_double() = 0.25;
+  arr[1].emplace_object();
+  obj["empty"].emplace_array();
+
+  const std::string compact =
+      "{\"null\":null,\"bool\":true,\"int\":-12,\"uint\":34,"
+      "\"double\":1.505E2,\"string\":\"a\\\"b\\\\c\\nd\\u0001\","
+      "\"array\":[2.5E-1,{}],\"empty\":[]}";
+  GTEST_ASSERT_EQ(mj::serialize(jv), compact);
+  GTEST_ASSERT_EQ(mj::serialize(obj), compact);
+  GTEST_ASSERT_EQ(mj::serialize(arr), "[2.5E-1,{}]");
+
+  std::stringstream ss;
+  ss << jv;
+  GTEST_ASSERT_EQ(ss.str(), compact);
+
+  // Pretty print
+  std::stringstream pretty;
+  mj::serialize_to(pretty, arr, 2);
+  GTEST_ASSERT_EQ(pretty.str(), "[\n  2.5E-1,\n  {}\n]");
+
+  // Buffer; truncated if it is too small
+  std::vector<char> buf(compact.size());
+  GTEST_ASSERT_EQ(mj::serialize_to(buf.data(), buf.size(), jv),
+                  compact.size());
+  GTEST_ASSERT_EQ(std::string(buf.begin(), buf.end()), compact);
+  GTEST_ASSERT_EQ(mj::serialize_to(buf.data(), 4, jv), compact.size());
+  GTEST_ASSERT_EQ(std::string(buf.data(), 4), compact.substr(0, 4));
+
+  // File descriptor; longer than the internal buffer
+  mj::value large;
+  auto &large_arr = large.emplace_array();
+  large_arr.resize(10000);
+  for (std::size_t i = 0; i < large_arr.size(); ++i) {
+    large_arr[i].emplace_uint64() = i;
+  }
+  std::FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  GTEST_ASSERT_TRUE(mj::serialize_to_fd(::fileno(file), large));
+  std::rewind(file);
+  std::string read;
+  for (int c; (c = std::fgetc(file)) != EOF;) read.push_back(char(c));
+  std::fclose(file);
+  GTEST_ASSERT_EQ(read, mj::serialize(large));
+  GTEST_ASSERT_EQ(read.substr(0, 7), "[0,1,2,");
+}
+
 TEST(JSONValueTest, Equal) {
   auto jv1 = mj::parse(json_string);
   auto jv2 = mj::parse(json_string);
@@ -0,0 +1,144 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/linear_hash_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using map_type = metall::container::linear_hash_map<uint64_t, int>;
+
+TEST(LinearHashMapTest, Insert) {
+  map_type map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(1, 10)).second);
+  ASSERT_FALSE(map.insert(std::make_pair(1, 20)).second);  // Duplicate key
+  ASSERT_TRUE(map.try_emplace(2, 30).second);
+  ASSERT_EQ(map.size(), 2);
+
+  ASSERT_EQ(map.find(1)->second, 10);
+  ASSERT_EQ(map.at(2), 30);
+  ASSERT_EQ(map.find(3), map.end());
+  ASSERT_THROW(map.at(3), std::out_of_range);
+  ASSERT_EQ(map.count(1), 1);
+  ASSERT_EQ(map.count(3), 0);
+
+  map[3] += 5;
+  ASSERT_EQ(map[3], 5);
+  ASSERT_FALSE(map.insert_or_assign(3, 7).second);
+  ASSERT_EQ(map.at(3), 7);
+}
+
+TEST(LinearHashMapTest, Erase) {
+  map_type map;
+  ASSERT_EQ(map.erase(1), 0);
+  map.insert(std::make_pair(1, 10));
+  map.insert(std::make_pair(2, 20));
+  ASSERT_EQ(map.erase(1), 1);
+  ASSERT_EQ(map.erase(1), 0);
+  ASSERT_FALSE(map.contains(1));
+  ASSERT_TRUE(map.contains(2));
+  ASSERT_EQ(map.size(), 1);
+
+  auto itr = map.erase(map.find(2));
+  ASSERT_EQ(itr, map.end());
+  ASSERT_TRUE(map.empty());
+
+  map.insert(std::make_pair(3, 30));
+  map.clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(3, 40)).second);
+}
+
+TEST(LinearHashMapTest, IncrementalGrowth) {
+  map_type map;
+  const auto initial_bucket_count = map.bucket_count();
+  std::vector<const map_type::value_type *> addresses;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    const auto num_buckets = map.bucket_count();
+    addresses.push_back(&*map.try_emplace(i, int(i)).first);
+    // An insertion splits only a few buckets
+    ASSERT_LE(map.bucket_count(), num_buckets + 2);
+    ASSERT_LE(map.load_factor(), map.max_load_factor());
+  }
+  ASSERT_GT(map.bucket_count(), initial_bucket_count);
+
+  // The elements are not moved by splits
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(&*map.find(i), addresses[i]);
+    ASSERT_EQ(map.find(i)->second, int(i));
+  }
+
+  map.max_load_factor(0.5f);
+  map.reserve(20000);
+  ASSERT_GE(map.bucket_count() * 0.5f, 20000.0f);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(&*map.find(i), addresses[i]);
+  }
+}
+
+TEST(LinearHashMapTest, RandomOperations) {
+  std::unordered_map<uint64_t, int> ref_map;
+  map_type map;
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 200000; ++i) {
+    const uint64_t key = rnd() % 20000;
+    if (rnd() % 3 == 0) {
+      ASSERT_EQ(map.erase(key), ref_map.erase(key));
+    } else {
+      ASSERT_EQ(map.insert_or_assign(key, i).second,
+                ref_map.insert_or_assign(key, i).second);
+    }
+  }
+  ASSERT_EQ(map.size(), ref_map.size());
+
+  std::size_t num_elements = 0;
+  for (const auto &v : map) {
+    ASSERT_EQ(ref_map.at(v.first), v.second);
+    ++num_elements;
+  }
+  ASSERT_EQ(num_elements, ref_map.size());
+}
+
+TEST(LinearHashMapTest, Persistence) {
+  using persistent_map_type = metall::container::linear_hash_map<
+      uint64_t, int, std::hash<uint64_t>, std::equal_to<uint64_t>,
+      metall::manager::allocator_type<std::pair<const uint64_t, int>>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<persistent_map_type>("map")(
+        manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map->insert(std::make_pair(i, int(i * 2)));
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *map = manager.find<persistent_map_type>("map").first;
+    ASSERT_NE(map, nullptr);
+    ASSERT_EQ(map->size(), 1000);
+    // Keeps growing from where it was
+    for (uint64_t i = 1000; i < 2000; ++i) {
+      map->insert(std::make_pair(i, int(i * 2)));
+    }
+    for (uint64_t i = 0; i < 2000; ++i) {
+      ASSERT_EQ(map->at(i), int(i * 2));
+    }
+    ASSERT_TRUE(manager.destroy<persistent_map_type>("map"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,106 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/mpmc_ring_buffer.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+TEST(MpmcRingBufferTest, PushPop) {
+  metall::container::mpmc_ring_buffer<std::string> buffer(5);
+  ASSERT_EQ(buffer.capacity(), 8);
+  ASSERT_TRUE(buffer.empty());
+
+  std::string value;
+  ASSERT_FALSE(buffer.pop(value));
+  // Go around the buffer several times
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(buffer.push(std::to_string(i) + std::string(30, 'x')));
+    }
+    ASSERT_FALSE(buffer.push("full"));
+    ASSERT_EQ(buffer.size(), 8);
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(buffer.pop(value));
+      ASSERT_EQ(value, std::to_string(i) + std::string(30, 'x'));
+    }
+    ASSERT_FALSE(buffer.pop(value));
+  }
+
+  // Remaining items are destroyed by the destructor
+  ASSERT_TRUE(buffer.emplace(10, 'y'));
+}
+
+TEST(MpmcRingBufferTest, MultipleProducersConsumers) {
+  metall::container::mpmc_ring_buffer<uint64_t> buffer(64);
+  constexpr int k_num_threads = 4;
+  constexpr uint64_t k_num_items = 100000;
+
+  std::atomic<uint64_t> sum{0};
+  std::atomic<uint64_t> num_popped{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&buffer, t]() {
+      for (uint64_t i = t; i < k_num_items; i += k_num_threads) {
+        while (!buffer.push(i)) std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&buffer, &sum, &num_popped]() {
+      uint64_t value;
+      while (num_popped.load() < k_num_items) {
+        if (buffer.pop(value)) {
+          sum += value;
+          ++num_popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_EQ(num_popped.load(), k_num_items);
+  ASSERT_EQ(sum.load(), k_num_items * (k_num_items - 1) / 2);
+  ASSERT_TRUE(buffer.empty());
+}
+
+TEST(MpmcRingBufferTest, Persistence) {
+  using buffer_type = metall::container::mpmc_ring_buffer<
+      uint64_t, metall::manager::allocator_type<uint64_t>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *buffer = manager.construct<buffer_type>("buffer")(
+        16, manager.get_allocator());
+    for (uint64_t i = 0; i < 10; ++i) buffer->push(i);
+    uint64_t value;
+    ASSERT_TRUE(buffer->pop(value));
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *buffer = manager.find<buffer_type>("buffer").first;
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(buffer->size(), 9);
+    uint64_t value;
+    for (uint64_t i = 1; i < 10; ++i) {
+      ASSERT_TRUE(buffer->pop(value));
+      ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(buffer->pop(value));
+    ASSERT_TRUE(manager.destroy<buffer_type>("buffer"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,96 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+
+#include <boost/container/list.hpp>
+#include <boost/container/map.hpp>
+
+#include <metall/metall.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using resource_type = metall::manager::node_pool_resource_type;
+
+template <typename T>
+using alloc_type = metall::manager::node_pool_allocator<T>;
+
+TEST(NodePoolAllocatorTest, Allocate) {
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager manager(metall::create_only, dir_path.c_str());
+
+  resource_type resource(manager.get_allocator());
+  ASSERT_EQ(resource.num_pooled_objects(), 0);
+
+  alloc_type<uint64_t> alloc(&resource);
+  auto p1 = alloc.allocate(1);
+  const auto num_pooled = resource.num_pooled_objects();
+  ASSERT_GT(num_pooled, 0);
+
+  // A freed object is reused first
+  alloc.deallocate(p1, 1);
+  ASSERT_EQ(resource.num_pooled_objects(), num_pooled + 1);
+  ASSERT_EQ(alloc.allocate(1), p1);
+
+  // Arrays are not pooled
+  auto array = alloc.allocate(10);
+  ASSERT_EQ(resource.num_pooled_objects(), num_pooled);
+  alloc.deallocate(array, 10);
+
+  // Rebound allocators share the resource
+  alloc_type<char> char_alloc(alloc);
+  ASSERT_EQ(char_alloc.get_resource(), &resource);
+  ASSERT_TRUE(alloc_type<uint64_t>(char_alloc) == alloc);
+
+  alloc.deallocate(p1, 1);
+  resource.release();
+  ASSERT_EQ(resource.num_pooled_objects(), 0);
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
+TEST(NodePoolAllocatorTest, Persistence) {
+  using list_type = boost::container::list<uint64_t, alloc_type<uint64_t>>;
+  using map_type =
+      boost::container::map<uint64_t, uint64_t, std::less<uint64_t>,
+                            alloc_type<std::pair<const uint64_t, uint64_t>>>;
+  const auto dir_path(test_utility::make_test_path());
+
+  {
+    metall::manager manager(metall::create_only, dir_path.c_str());
+    auto *resource =
+        manager.construct<resource_type>("pool")(manager.get_allocator());
+    auto *list = manager.construct<list_type>("list")(resource);
+    auto *map = manager.construct<map_type>("map")(resource);
+    for (uint64_t i = 0; i < 10000; ++i) {
+      list->push_back(i);
+      (*map)[i] = i * 2;
+    }
+    for (uint64_t i = 0; i < 10000; i += 2) map->erase(i);
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path.c_str());
+    auto *resource = manager.find<resource_type>("pool").first;
+    auto *list = manager.find<list_type>("list").first;
+    auto *map = manager.find<map_type>("map").first;
+    ASSERT_EQ(list->size(), 10000);
+    ASSERT_EQ(map->size(), 5000);
+    for (const auto &[k, v] : *map) ASSERT_EQ(v, k * 2);
+
+    // Reuses the freed nodes
+    const auto num_pooled = resource->num_pooled_objects();
+    for (uint64_t i = 0; i < 10000; i += 2) (*map)[i] = i * 2;
+    ASSERT_EQ(resource->num_pooled_objects(), num_pooled - 5000);
+
+    ASSERT_TRUE(manager.destroy<list_type>("list"));
+    ASSERT_TRUE(manager.destroy<map_type>("map"));
+    ASSERT_TRUE(manager.destroy<resource_type>("pool"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,96 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/packed_int_vector.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using vector_type =
+    metall::container::packed_int_vector<std::allocator<std::byte>>;
+
+TEST(PackedIntVectorTest, BitsNeeded) {
+  ASSERT_EQ(vector_type::bits_needed(0), 1);
+  ASSERT_EQ(vector_type::bits_needed(1), 1);
+  ASSERT_EQ(vector_type::bits_needed(2), 2);
+  ASSERT_EQ(vector_type::bits_needed(255), 8);
+  ASSERT_EQ(vector_type::bits_needed(256), 9);
+  ASSERT_EQ(vector_type::bits_needed(~uint64_t(0)), 64);
+}
+
+TEST(PackedIntVectorTest, GetSetDecode) {
+  std::mt19937_64 rnd(123);
+  for (const unsigned int width : {1U, 3U, 7U, 20U, 33U, 56U, 57U, 63U, 64U}) {
+    const uint64_t mask =
+        width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    vector_type vec(width);
+    ASSERT_EQ(vec.width(), width);
+    std::vector<uint64_t> ref;
+    for (int i = 0; i < 1000; ++i) {
+      const auto v = rnd();
+      vec.push_back(v);
+      ref.push_back(v & mask);
+    }
+    // Overwrites values next to each other
+    for (int i = 0; i < 1000; ++i) {
+      const auto index = rnd() % ref.size();
+      const auto v = rnd();
+      vec.set(index, v);
+      ref[index] = v & mask;
+    }
+    ASSERT_EQ(vec.size(), ref.size());
+    for (std::size_t i = 0; i < ref.size(); ++i) ASSERT_EQ(vec[i], ref[i]);
+
+    for (const std::size_t first : {0, 1, 5, 999}) {
+      const auto n = ref.size() - first;
+      std::vector<uint64_t> out(n);
+      vec.decode(first, n, out.data());
+      for (std::size_t i = 0; i < n; ++i) ASSERT_EQ(out[i], ref[first + i]);
+    }
+
+    // The values beyond a new size are 0 when it grows again
+    vec.resize(100);
+    vec.resize(200);
+    for (std::size_t i = 0; i < 100; ++i) ASSERT_EQ(vec[i], ref[i]);
+    for (std::size_t i = 100; i < 200; ++i) ASSERT_EQ(vec[i], 0);
+  }
+}
+
+TEST(PackedIntVectorTest, Memory) {
+  vector_type vec(20, 1ULL << 16ULL);
+  ASSERT_LT(vec.memory_bytes(), (1ULL << 16ULL) * sizeof(uint64_t) / 3);
+}
+
+TEST(PackedIntVectorTest, Persistence) {
+  using persistent_vector_type = metall::container::packed_int_vector<>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *vec = manager.construct<persistent_vector_type>("vec")(
+        17, manager.get_allocator());
+    for (uint64_t i = 0; i < 10000; ++i) vec->push_back(i * 13);
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *vec = manager.find<persistent_vector_type>("vec").first;
+    ASSERT_NE(vec, nullptr);
+    for (uint64_t i = 0; i < 10000; ++i) {
+      ASSERT_EQ((*vec)[i], (i * 13) & ((1ULL << 17ULL) - 1));
+    }
+    ASSERT_TRUE(manager.destroy<persistent_vector_type>("vec"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
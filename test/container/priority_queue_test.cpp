@@ -0,0 +1,217 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/priority_queue.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mc = metall::container;
+
+TEST(PriorityQueueTest, DAryHeap) {
+  mc::d_ary_heap<std::string, std::less<std::string>, 4,
+                 std::allocator<std::string>>
+      heap;
+  std::priority_queue<std::string> ref;
+  ASSERT_TRUE(heap.empty());
+
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 10000; ++i) {
+    if (rnd() % 3 != 0 || ref.empty()) {
+      const auto value = std::to_string(rnd() % 1000);
+      heap.push(value);
+      ref.push(value);
+    } else {
+      ASSERT_EQ(heap.top(), ref.top());
+      heap.pop();
+      ref.pop();
+    }
+    ASSERT_EQ(heap.size(), ref.size());
+  }
+  while (!ref.empty()) {
+    ASSERT_EQ(heap.top(), ref.top());
+    heap.pop();
+    ref.pop();
+  }
+  ASSERT_TRUE(heap.empty());
+}
+
+TEST(PriorityQueueTest, DAryHeapBulk) {
+  // A min-heap with 8 children per node
+  mc::d_ary_heap<int, std::greater<int>, 8, std::allocator<int>> heap;
+  std::mt19937_64 rnd(123);
+  std::vector<int> all;
+  // Rebuilds the heap and adds items one by one
+  for (const std::size_t n : {100, 1000, 10}) {
+    std::vector<int> values(n);
+    for (auto &v : values) v = rnd() % 10000;
+    heap.push_bulk(values.begin(), values.end());
+    all.insert(all.end(), values.begin(), values.end());
+  }
+  ASSERT_EQ(heap.size(), all.size());
+  std::sort(all.begin(), all.end());
+
+  std::vector<int> popped;
+  ASSERT_EQ(heap.pop_bulk(std::back_inserter(popped), 500), 500);
+  ASSERT_EQ(heap.pop_bulk(std::back_inserter(popped), 1000),
+            all.size() - 500);
+  ASSERT_EQ(heap.pop_bulk(std::back_inserter(popped), 1), 0);
+  ASSERT_EQ(popped, all);
+}
+
+TEST(PriorityQueueTest, IndexedDAryHeap) {
+  // Dijkstra-like usage: the smallest distance first
+  mc::indexed_d_ary_heap<int, std::greater<int>, 4, std::allocator<int>> heap;
+  std::map<std::size_t, int> ref;
+  std::mt19937_64 rnd(123);
+  for (int i = 0; i < 20000; ++i) {
+    const std::size_t id = rnd() % 500;
+    const int priority = rnd() % 1000;
+    switch (rnd() % 4) {
+      case 0:
+        ASSERT_EQ(heap.push(id, priority), ref.count(id) == 0);
+        ref.emplace(id, priority);
+        break;
+      case 1:
+        heap.update(id, priority);
+        ref[id] = priority;
+        break;
+      case 2:
+        ASSERT_EQ(heap.erase(id), ref.erase(id) == 1);
+        break;
+      default:
+        if (ref.empty()) break;
+        const auto min = std::min_element(
+            ref.begin(), ref.end(),
+            [](const auto &a, const auto &b) { return a.second < b.second; });
+        ASSERT_EQ(heap.top_priority(), min->second);
+        ASSERT_EQ(ref.at(heap.top()), min->second);
+        ref.erase(heap.top());
+        heap.pop();
+    }
+    ASSERT_EQ(heap.size(), ref.size());
+    ASSERT_EQ(heap.contains(id), ref.count(id) == 1);
+    if (heap.contains(id)) {
+      ASSERT_EQ(heap.priority(id), ref.at(id));
+    }
+  }
+
+  heap.clear();
+  ASSERT_TRUE(heap.empty());
+  for (std::size_t id = 0; id < 500; ++id) ASSERT_FALSE(heap.contains(id));
+}
+
+TEST(PriorityQueueTest, MultiQueue) {
+  mc::multi_queue<uint64_t, std::less<uint64_t>, 4, std::allocator<uint64_t>>
+      queue(8);
+  uint64_t value;
+  ASSERT_FALSE(queue.pop(value));
+  ASSERT_EQ(queue.num_heaps(), 8);
+
+  constexpr int k_num_threads = 4;
+  constexpr uint64_t k_num_items = 100000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&queue, t]() {
+      std::vector<uint64_t> batch;
+      for (uint64_t i = t; i < k_num_items; i += k_num_threads) {
+        if (i % 3 == 0) {
+          batch.push_back(i);
+        } else {
+          queue.push(i);
+        }
+      }
+      queue.push_bulk(batch.begin(), batch.end());
+    });
+  }
+  for (auto &th : threads) th.join();
+  threads.clear();
+  ASSERT_EQ(queue.size(), k_num_items);
+
+  // Each item is taken exactly once
+  std::vector<std::atomic<int>> counts(k_num_items);
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&queue, &counts, t]() {
+      uint64_t value;
+      std::vector<uint64_t> batch;
+      while (true) {
+        if (t % 2 == 0) {
+          if (!queue.pop(value)) break;
+          ++counts[value];
+        } else {
+          batch.clear();
+          if (!queue.pop_bulk(std::back_inserter(batch), 16)) break;
+          for (const auto v : batch) ++counts[v];
+        }
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  for (const auto &c : counts) ASSERT_EQ(c.load(), 1);
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(PriorityQueueTest, Persistence) {
+  using heap_type = mc::d_ary_heap<uint64_t>;
+  using indexed_heap_type = mc::indexed_d_ary_heap<uint64_t>;
+  using multi_queue_type = mc::multi_queue<uint64_t>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *heap = manager.construct<heap_type>("heap")(manager.get_allocator());
+    auto *indexed_heap = manager.construct<indexed_heap_type>("indexed_heap")(
+        manager.get_allocator());
+    auto *queue = manager.construct<multi_queue_type>("queue")(
+        4, manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) {
+      heap->push(i);
+      indexed_heap->push(i, i);
+      queue->push(i);
+    }
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *heap = manager.find<heap_type>("heap").first;
+    auto *indexed_heap = manager.find<indexed_heap_type>("indexed_heap").first;
+    auto *queue = manager.find<multi_queue_type>("queue").first;
+    ASSERT_EQ(queue->num_heaps(), 4);
+    ASSERT_EQ(queue->size(), 1000);
+    indexed_heap->update(0, 2000);
+    ASSERT_EQ(indexed_heap->top(), 0);
+    indexed_heap->pop();
+    for (uint64_t i = 999; i > 0; --i) {
+      ASSERT_EQ(heap->top(), i);
+      heap->pop();
+      ASSERT_EQ(indexed_heap->top(), i);
+      indexed_heap->pop();
+    }
+    uint64_t sum = 0;
+    uint64_t value;
+    while (queue->pop(value)) sum += value;
+    ASSERT_EQ(sum, 999 * 1000 / 2);
+
+    ASSERT_TRUE(manager.destroy<heap_type>("heap"));
+    ASSERT_TRUE(manager.destroy<indexed_heap_type>("indexed_heap"));
+    ASSERT_TRUE(manager.destroy<multi_queue_type>("queue"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,103 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/rank_select_bitvector.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using bitvector_type =
+    metall::container::rank_select_bitvector<std::allocator<std::byte>>;
+
+void check(const bitvector_type &bv, const std::vector<bool> &ref) {
+  ASSERT_EQ(bv.size(), ref.size());
+  std::size_t num_ones = 0;
+  std::size_t num_zeros = 0;
+  for (std::size_t i = 0; i < ref.size(); ++i) {
+    ASSERT_EQ(bv[i], ref[i]);
+    ASSERT_EQ(bv.rank1(i), num_ones);
+    ASSERT_EQ(bv.rank0(i), num_zeros);
+    if (ref[i]) {
+      ASSERT_EQ(bv.select1(num_ones), i);
+      ++num_ones;
+    } else {
+      ASSERT_EQ(bv.select0(num_zeros), i);
+      ++num_zeros;
+    }
+  }
+  ASSERT_EQ(bv.rank1(ref.size()), num_ones);
+  ASSERT_EQ(bv.num_ones(), num_ones);
+  ASSERT_EQ(bv.num_zeros(), num_zeros);
+}
+
+TEST(RankSelectBitvectorTest, RankSelect) {
+  std::mt19937_64 rnd(123);
+  // Dense, sparse, and sizes not multiples of the words or superblocks
+  for (const int density : {2, 50}) {
+    for (const std::size_t n : {0, 1, 63, 64, 513, 5000}) {
+      bitvector_type bv(n);
+      std::vector<bool> ref(n, false);
+      for (std::size_t i = 0; i < n; ++i) {
+        if (rnd() % density == 0) {
+          bv.set(i);
+          ref[i] = true;
+        }
+      }
+      bv.build();
+      check(bv, ref);
+    }
+  }
+
+  bitvector_type bv;
+  std::vector<bool> ref;
+  for (int i = 0; i < 2000; ++i) {
+    const bool bit = rnd() % 3 == 0;
+    bv.push_back(bit);
+    ref.push_back(bit);
+  }
+  bv.set(7, false);
+  ref[7] = false;
+  bv.resize(1000);
+  bv.resize(1500);
+  ref.resize(1000);
+  ref.resize(1500, false);
+  bv.build();
+  check(bv, ref);
+}
+
+TEST(RankSelectBitvectorTest, Persistence) {
+  using persistent_bitvector_type = metall::container::rank_select_bitvector<>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *bv = manager.construct<persistent_bitvector_type>("bv")(
+        10000, manager.get_allocator());
+    for (std::size_t i = 0; i < 10000; i += 3) bv->set(i);
+    bv->build();
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *bv = manager.find<persistent_bitvector_type>("bv").first;
+    ASSERT_NE(bv, nullptr);
+    ASSERT_EQ(bv->num_ones(), 3334);
+    for (std::size_t k = 0; k < 3334; ++k) {
+      ASSERT_EQ(bv->select1(k), k * 3);
+      ASSERT_EQ(bv->rank1(k * 3), k);
+    }
+    ASSERT_TRUE(manager.destroy<persistent_bitvector_type>("bv"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,164 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/roaring_bitmap.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using bitmap_type =
+    metall::container::roaring_bitmap<std::allocator<std::byte>>;
+
+std::vector<uint32_t> to_vector(const bitmap_type &bitmap) {
+  std::vector<uint32_t> values;
+  bitmap.copy_to(std::back_inserter(values));
+  return values;
+}
+
+// Sparse values and dense ranges so that there are both kinds of containers
+std::set<uint32_t> random_values(const unsigned seed) {
+  std::mt19937 rng(seed);
+  std::set<uint32_t> values;
+  for (int i = 0; i < 20000; ++i) values.insert(rng() % (1U << 22U));
+  const uint32_t base = (rng() % 64) << 16U;
+  for (uint32_t v = 0; v < 30000; ++v) {
+    if (rng() % 3 != 0) values.insert(base + v);
+  }
+  values.insert(0);
+  values.insert(UINT32_MAX);
+  return values;
+}
+
+TEST(RoaringBitmapTest, AddRemove) {
+  bitmap_type bitmap;
+  ASSERT_TRUE(bitmap.empty());
+  ASSERT_TRUE(bitmap.add(10));
+  ASSERT_FALSE(bitmap.add(10));
+  ASSERT_TRUE(bitmap.add(1U << 20U));
+  ASSERT_TRUE(bitmap.contains(10));
+  ASSERT_FALSE(bitmap.contains(11));
+  ASSERT_EQ(bitmap.size(), 2);
+  ASSERT_TRUE(bitmap.remove(10));
+  ASSERT_FALSE(bitmap.remove(10));
+  ASSERT_FALSE(bitmap.contains(10));
+  ASSERT_EQ(bitmap.size(), 1);
+
+  // An array container becomes a bitmap and back
+  for (uint32_t v = 0; v < 10000; ++v) ASSERT_TRUE(bitmap.add(v * 2));
+  ASSERT_EQ(bitmap.size(), 10001);
+  for (uint32_t v = 0; v < 10000; ++v) {
+    ASSERT_TRUE(bitmap.contains(v * 2));
+    ASSERT_FALSE(bitmap.contains(v * 2 + 1));
+  }
+  for (uint32_t v = 0; v < 9000; ++v) ASSERT_TRUE(bitmap.remove(v * 2));
+  ASSERT_EQ(bitmap.size(), 1001);
+  ASSERT_TRUE(bitmap.contains(18000));
+  ASSERT_FALSE(bitmap.contains(17998));
+}
+
+TEST(RoaringBitmapTest, Iterate) {
+  const auto values = random_values(1);
+  bitmap_type bitmap;
+  bitmap.add(values.begin(), values.end());
+  ASSERT_EQ(bitmap.size(), values.size());
+  ASSERT_EQ(to_vector(bitmap),
+            std::vector<uint32_t>(values.begin(), values.end()));
+
+  // Unsorted input
+  std::vector<uint32_t> shuffled(values.begin(), values.end());
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(2));
+  bitmap_type other;
+  for (const auto v : shuffled) other.add(v);
+  ASSERT_EQ(to_vector(other), to_vector(bitmap));
+
+  // Far smaller than a sorted vector of the integers
+  ASSERT_LT(bitmap.memory_bytes(), values.size() * sizeof(uint32_t));
+}
+
+TEST(RoaringBitmapTest, SetOperations) {
+  for (const unsigned seed : {1U, 2U, 3U}) {
+    const auto x = random_values(seed);
+    const auto y = random_values(seed + 10);
+    bitmap_type a;
+    bitmap_type b;
+    a.add(x.begin(), x.end());
+    b.add(y.begin(), y.end());
+
+    std::vector<uint32_t> expected;
+    std::set_union(x.begin(), x.end(), y.begin(), y.end(),
+                   std::back_inserter(expected));
+    auto c = a;
+    c |= b;
+    ASSERT_EQ(to_vector(c), expected);
+    ASSERT_EQ(c.size(), expected.size());
+
+    expected.clear();
+    std::set_intersection(x.begin(), x.end(), y.begin(), y.end(),
+                          std::back_inserter(expected));
+    c = a;
+    c &= b;
+    ASSERT_EQ(to_vector(c), expected);
+    ASSERT_EQ(a.intersection_size(b), expected.size());
+
+    expected.clear();
+    std::set_difference(x.begin(), x.end(), y.begin(), y.end(),
+                        std::back_inserter(expected));
+    c = a;
+    c -= b;
+    ASSERT_EQ(to_vector(c), expected);
+    ASSERT_EQ(c.size(), expected.size());
+  }
+
+  bitmap_type a;
+  a.add(1);
+  a &= a;
+  ASSERT_EQ(a.size(), 1);
+  a -= a;
+  ASSERT_TRUE(a.empty());
+}
+
+TEST(RoaringBitmapTest, Persistence) {
+  using persistent_bitmap_type = metall::container::roaring_bitmap<>;
+  const auto values = random_values(5);
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *bitmap = manager.construct<persistent_bitmap_type>("bitmap")(
+        manager.get_allocator());
+    bitmap->add(values.begin(), values.end());
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *bitmap = manager.find<persistent_bitmap_type>("bitmap").first;
+    ASSERT_NE(bitmap, nullptr);
+    ASSERT_EQ(bitmap->size(), values.size());
+    std::vector<uint32_t> stored;
+    bitmap->copy_to(std::back_inserter(stored));
+    ASSERT_EQ(stored, std::vector<uint32_t>(values.begin(), values.end()));
+
+    {
+      persistent_bitmap_type other(manager.get_allocator());
+      other.add(values.begin(), values.end());
+      *bitmap -= other;
+      ASSERT_TRUE(bitmap->empty());
+    }
+    ASSERT_TRUE(manager.destroy<persistent_bitmap_type>("bitmap"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
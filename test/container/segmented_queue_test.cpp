@@ -0,0 +1,110 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/segmented_queue.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+TEST(SegmentedQueueTest, PushPop) {
+  // Small segments to cross segment boundaries
+  metall::container::segmented_queue<std::string, std::allocator<std::string>,
+                                     4>
+      queue;
+  ASSERT_TRUE(queue.empty());
+  std::string value;
+  ASSERT_FALSE(queue.pop(value));
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 50; ++i) {
+      queue.push(std::to_string(i) + std::string(30, 'x'));
+    }
+    ASSERT_EQ(queue.size(), 50);
+    for (int i = 0; i < 50; ++i) {
+      ASSERT_TRUE(queue.pop(value));
+      ASSERT_EQ(value, std::to_string(i) + std::string(30, 'x'));
+    }
+    ASSERT_FALSE(queue.pop(value));
+    ASSERT_TRUE(queue.empty());
+  }
+
+  // Remaining items are destroyed by the destructor
+  for (int i = 0; i < 10; ++i) queue.emplace(10, 'y');
+}
+
+TEST(SegmentedQueueTest, MultipleProducersConsumers) {
+  metall::container::segmented_queue<uint64_t, std::allocator<uint64_t>, 64>
+      queue;
+  constexpr int k_num_threads = 4;
+  constexpr uint64_t k_num_items = 100000;
+
+  std::atomic<uint64_t> sum{0};
+  std::atomic<uint64_t> num_popped{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&queue, t]() {
+      for (uint64_t i = t; i < k_num_items; i += k_num_threads) queue.push(i);
+    });
+    threads.emplace_back([&queue, &sum, &num_popped]() {
+      uint64_t value;
+      // Items from one producer must come out in order
+      std::vector<int64_t> last(k_num_threads, -1);
+      while (num_popped.load() < k_num_items) {
+        if (queue.pop(value)) {
+          ASSERT_GT(int64_t(value), last[value % k_num_threads]);
+          last[value % k_num_threads] = value;
+          sum += value;
+          ++num_popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_EQ(num_popped.load(), k_num_items);
+  ASSERT_EQ(sum.load(), k_num_items * (k_num_items - 1) / 2);
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(SegmentedQueueTest, Persistence) {
+  using queue_type = metall::container::segmented_queue<
+      uint64_t, metall::manager::allocator_type<uint64_t>, 16>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *queue =
+        manager.construct<queue_type>("queue")(manager.get_allocator());
+    for (uint64_t i = 0; i < 100; ++i) queue->push(i);
+    uint64_t value;
+    for (uint64_t i = 0; i < 40; ++i) ASSERT_TRUE(queue->pop(value));
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *queue = manager.find<queue_type>("queue").first;
+    ASSERT_NE(queue, nullptr);
+    ASSERT_EQ(queue->size(), 60);
+    uint64_t value;
+    for (uint64_t i = 40; i < 100; ++i) {
+      ASSERT_TRUE(queue->pop(value));
+      ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue->pop(value));
+    ASSERT_TRUE(manager.destroy<queue_type>("queue"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,187 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+#include <metall/metall.hpp>
+#include <metall/container/segmented_vector.hpp>
+#include <metall/container/scoped_allocator.hpp>
+#include <metall/container/string.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+// Small segments to cross segment boundaries
+template <typename T>
+using vector_type =
+    metall::container::segmented_vector<T, std::allocator<T>, 4>;
+
+TEST(SegmentedVectorTest, PushBack) {
+  vector_type<int> vector;
+  ASSERT_TRUE(vector.empty());
+  ASSERT_EQ(vector.num_segments(), 0);
+
+  for (int i = 0; i < 100; ++i) vector.push_back(i);
+  ASSERT_EQ(vector.size(), 100);
+  for (int i = 0; i < 100; ++i) ASSERT_EQ(vector[i], i);
+  ASSERT_EQ(vector.front(), 0);
+  ASSERT_EQ(vector.back(), 99);
+  ASSERT_THROW(vector.at(100), std::out_of_range);
+
+  // 4, 4, 8, 16, 32, 64
+  ASSERT_EQ(vector.num_segments(), 6);
+  ASSERT_EQ(vector.capacity(), 128);
+  ASSERT_EQ(vector.segment_size(0), 4);
+  ASSERT_EQ(vector.segment_size(4), 32);
+  ASSERT_EQ(vector.segment_size(5), 36);
+  ASSERT_EQ(vector.segment_data(2)[0], 8);
+
+  vector.pop_back();
+  ASSERT_EQ(vector.size(), 99);
+  ASSERT_EQ(vector.back(), 98);
+}
+
+TEST(SegmentedVectorTest, StableReferences) {
+  vector_type<std::string> vector;
+  vector.emplace_back(40, 'a');
+  const auto *const first = &vector[0];
+  for (int i = 0; i < 1000; ++i) vector.emplace_back(std::to_string(i));
+  // Growing does not move items
+  ASSERT_EQ(first, &vector[0]);
+  ASSERT_EQ(vector[0], std::string(40, 'a'));
+  ASSERT_EQ(vector[1000], "999");
+}
+
+TEST(SegmentedVectorTest, Resize) {
+  vector_type<int> vector(10, 7);
+  ASSERT_EQ(vector.size(), 10);
+  ASSERT_TRUE(std::all_of(vector.begin(), vector.end(),
+                          [](const int v) { return v == 7; }));
+
+  vector.resize(3);
+  ASSERT_EQ(vector.size(), 3);
+  vector.resize(20, 1);
+  ASSERT_EQ(vector.size(), 20);
+  ASSERT_EQ(vector[2], 7);
+  ASSERT_EQ(vector[3], 1);
+
+  vector.clear();
+  ASSERT_TRUE(vector.empty());
+  ASSERT_GE(vector.capacity(), 20);
+  vector.shrink_to_fit();
+  ASSERT_EQ(vector.capacity(), 0);
+
+  vector.reserve(100);
+  ASSERT_GE(vector.capacity(), 100);
+  ASSERT_TRUE(vector.empty());
+}
+
+TEST(SegmentedVectorTest, Iterator) {
+  vector_type<int> vector;
+  for (int i = 0; i < 50; ++i) vector.push_back(50 - i);
+  std::sort(vector.begin(), vector.end());
+  for (int i = 0; i < 50; ++i) ASSERT_EQ(vector[i], i + 1);
+  ASSERT_EQ(std::accumulate(vector.cbegin(), vector.cend(), 0), 50 * 51 / 2);
+  ASSERT_EQ(vector.end() - vector.begin(), 50);
+  ASSERT_EQ(*vector.rbegin(), 50);
+  vector_type<int>::const_iterator itr = vector.begin() + 10;
+  ASSERT_EQ(*itr, 11);
+}
+
+TEST(SegmentedVectorTest, ForEachSegment) {
+  vector_type<int> vector;
+  for (int i = 0; i < 30; ++i) vector.push_back(i);
+  int expected = 0;
+  std::size_t num_segments = 0;
+  vector.for_each_segment([&](const int *const data, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) ASSERT_EQ(data[i], expected++);
+    ++num_segments;
+  });
+  ASSERT_EQ(expected, 30);
+  ASSERT_EQ(num_segments, vector.num_segments());
+}
+
+TEST(SegmentedVectorTest, CopyMove) {
+  vector_type<std::string> vector;
+  for (int i = 0; i < 20; ++i) vector.push_back(std::to_string(i));
+
+  auto copy(vector);
+  ASSERT_EQ(copy, vector);
+  auto moved(std::move(copy));
+  ASSERT_EQ(moved, vector);
+  ASSERT_TRUE(copy.empty());
+
+  vector_type<std::string> other;
+  other.push_back("x");
+  other = vector;
+  ASSERT_EQ(other, vector);
+  other.push_back("y");
+  ASSERT_NE(other, vector);
+  swap(other, moved);
+  ASSERT_EQ(other.size(), 20);
+  ASSERT_EQ(moved.back(), "y");
+}
+
+TEST(SegmentedVectorTest, Persistence) {
+  using vector_type = metall::container::segmented_vector<
+      uint64_t, metall::manager::allocator_type<uint64_t>, 16>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *vector =
+        manager.construct<vector_type>("vector")(manager.get_allocator());
+    for (uint64_t i = 0; i < 10000; ++i) vector->push_back(i);
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *vector = manager.find<vector_type>("vector").first;
+    ASSERT_NE(vector, nullptr);
+    ASSERT_EQ(vector->size(), 10000);
+    for (uint64_t i = 0; i < 10000; ++i) ASSERT_EQ((*vector)[i], i);
+    vector->push_back(10000);
+    ASSERT_EQ(vector->back(), 10000);
+    ASSERT_TRUE(manager.destroy<vector_type>("vector"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(SegmentedVectorTest, NestedContainers) {
+  using string_type = metall::container::string;
+  using vector_type = metall::container::segmented_vector<
+      string_type, metall::container::scoped_allocator_adaptor<
+                       metall::manager::allocator_type<string_type>>,
+      4>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *vector =
+        manager.construct<vector_type>("vector")(manager.get_allocator());
+    for (int i = 0; i < 100; ++i) {
+      vector->emplace_back(std::string(30, 'a' + i % 26).c_str());
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *vector = manager.find<vector_type>("vector").first;
+    ASSERT_NE(vector, nullptr);
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_STREQ((*vector)[i].c_str(),
+                   std::string(30, 'a' + i % 26).c_str());
+    }
+    ASSERT_TRUE(manager.destroy<vector_type>("vector"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
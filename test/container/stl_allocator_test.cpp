@@ -9,7 +9,10 @@
 #include <unordered_set>
 #include <filesystem>
 
+#include <boost/container/list.hpp>
+#include <boost/container/map.hpp>
 #include <boost/container/scoped_allocator.hpp>
+#include <boost/container/string.hpp>
 #include <boost/interprocess/containers/vector.hpp>
 #include <boost/unordered_map.hpp>
 #include <metall/metall.hpp>
@@ -152,6 +155,26 @@ TEST(StlAllocatorTest, Exception) {
   metall::logger::set_log_level(metall::logger::level_filter::error);
 }
 
+TEST(StlAllocatorTest, AllocateMany) {
+  metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+  using element_type = std::pair<uint64_t, uint64_t>;
+  alloc_type<element_type> allocator =
+      manager.get_allocator<element_type>();
+
+  std::vector<alloc_type<element_type>::pointer> ptrs(1024);
+  ASSERT_NO_THROW({ allocator.allocate_many(ptrs.size(), ptrs.data()); });
+  for (std::size_t i = 0; i < ptrs.size(); ++i) {
+    ASSERT_TRUE(ptrs[i]);
+    allocator.construct(ptrs[i], i, i * 2);
+  }
+  for (std::size_t i = 0; i < ptrs.size(); ++i) {
+    ASSERT_EQ(*ptrs[i], element_type(i, i * 2));
+  }
+
+  allocator.deallocate_many(ptrs.data(), ptrs.size());
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
 TEST(StlAllocatorTest, Container) {
   {
     metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
@@ -318,4 +341,54 @@ TEST(StlAllocatorTest, PersistentNestedContainer) {
     ASSERT_EQ(map->at(1)[0], 3);
   }
 }
+
+TEST(StlAllocatorTest, CompactPointer) {
+  using element_type = uint64_t;
+  using list_type = boost::container::list<
+      element_type, metall::manager::compact_allocator_type<element_type>>;
+  using map_type = boost::container::map<
+      element_type, element_type, std::less<element_type>,
+      metall::manager::compact_allocator_type<
+          std::pair<const element_type, element_type>>>;
+  using string_type = boost::container::basic_string<
+      char, std::char_traits<char>,
+      metall::manager::compact_allocator_type<char>>;
+
+  GTEST_ASSERT_EQ(
+      typeid(std::allocator_traits<
+             metall::manager::compact_allocator_type<char>>::pointer),
+      typeid(metall::compact_ptr<char>));
+
+  {
+    metall::manager manager(metall::create_only, dir_path(), 1UL << 27UL);
+    metall::set_segment_relative_ptr_base(manager.get_address());
+    auto *list = manager.construct<list_type>("list")(manager.get_allocator());
+    auto *map = manager.construct<map_type>("map")(manager.get_allocator());
+    auto *str = manager.construct<string_type>("string")(
+        "a string longer than the short string buffer",
+        manager.get_allocator());
+    for (element_type i = 0; i < 1024; ++i) {
+      list->push_back(i);
+      (*map)[i] = i * 2;
+    }
+    str->append(" and more");
+  }
+
+  {
+    metall::manager manager(metall::open_read_only, dir_path());
+    metall::set_segment_relative_ptr_base(manager.get_address());
+    const auto *list = manager.find<list_type>("list").first;
+    const auto *map = manager.find<map_type>("map").first;
+    const auto *str = manager.find<string_type>("string").first;
+
+    ASSERT_EQ(list->size(), 1024);
+    element_type i = 0;
+    for (const auto &e : *list) ASSERT_EQ(e, i++);
+    ASSERT_EQ(map->size(), 1024);
+    for (const auto &[k, v] : *map) ASSERT_EQ(v, k * 2);
+    ASSERT_EQ(*str,
+              "a string longer than the short string buffer and more");
+  }
+  metall::set_segment_relative_ptr_base(nullptr);
+}
 }  // namespace
\ No newline at end of file
@@ -4,7 +4,11 @@
 // SPDX-License-Identifier: (Apache-2.0 OR MIT)
 
 #include "gtest/gtest.h"
+#include <random>
 #include <scoped_allocator>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <boost/interprocess/managed_mapped_file.hpp>
 #include <boost/interprocess/allocators/allocator.hpp>
 #include <boost/container/vector.hpp>
@@ -456,6 +460,130 @@ TEST(StringKeyStoreTest, Rehash) {
   ASSERT_EQ(store.value(store.find("c")), "2");
 }
 
+TEST(StringKeyStoreTest, FindBatch) {
+  metall::container::string_key_store<int, std::allocator<std::byte>> store(
+      false, 111);
+  std::vector<std::string> keys;
+  std::vector<decltype(store)::locator_type> no_locators;
+  store.find_batch(keys.begin(), 0, no_locators.begin());
+
+  // Covers short and long keys, duplicates, and keys not found
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(std::to_string(i) + (i % 3 ? "" : "-long-key-in-arena"));
+  }
+  {
+    std::vector<decltype(store)::locator_type> locators(keys.size(),
+                                                        store.end());
+    store.find_batch(keys.begin(), keys.size(), locators.begin());
+    for (const auto &l : locators) ASSERT_EQ(l, store.end());
+  }
+  for (std::size_t i = 0; i < keys.size(); i += 2) {
+    store.insert(keys[i], (int)i);
+    if (i % 4 == 0) store.insert(keys[i], -(int)i);
+  }
+
+  for (const bool advise_pages : {false, true}) {
+    std::vector<decltype(store)::locator_type> locators;
+    store.find_batch(keys.cbegin(), keys.size(), std::back_inserter(locators),
+                     advise_pages);
+    ASSERT_EQ(locators.size(), keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_EQ(locators[i], store.find(keys[i]));
+    }
+  }
+}
+
+TEST(StringKeyStoreTest, FindAsync) {
+  metall::container::string_key_store<int, std::allocator<std::byte>> store(
+      false, 111);
+  metall::utility::fault_aware_scheduler scheduler(8);
+  bool called = false;
+  store.find_async(scheduler, "0", [&](const auto &l) {
+    ASSERT_EQ(l, store.end());
+    called = true;
+  });
+  ASSERT_TRUE(called);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(std::to_string(i) + (i % 3 ? "" : "-long-key-in-arena"));
+  }
+  for (std::size_t i = 0; i < keys.size(); i += 2) {
+    store.insert(keys[i], (int)i);
+    if (i % 4 == 0) store.insert(keys[i], -(int)i);
+  }
+
+  std::vector<decltype(store)::locator_type> locators(keys.size(),
+                                                      store.end());
+  std::vector<bool> done(keys.size(), false);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    store.find_async(scheduler, keys[i], [&, i](const auto &l) {
+      locators[i] = l;
+      done[i] = true;
+    });
+  }
+  scheduler.run();
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_TRUE(done[i]);
+    ASSERT_EQ(locators[i], store.find(keys[i]));
+  }
+}
+
+TEST(StringKeyStoreTest, RandomOperations) {
+  // Mixes short (inline) and long (arena) keys, duplicates, and erasures
+  // to exercise table growth, slot reuse, and key arena compaction
+  for (const bool unique : {true, false}) {
+    metall::container::string_key_store<int, std::allocator<std::byte>> store(
+        unique, 111);
+    std::unordered_multimap<std::string, int> ref_map;
+    std::mt19937_64 rnd(123);
+    for (int i = 0; i < 20000; ++i) {
+      const auto n = rnd() % 500;
+      const std::string key =
+          (n % 2 == 0) ? std::to_string(n)
+                       : std::string("long-key-") + std::string(n % 32, 'x') +
+                             std::to_string(n);
+      const auto op = rnd() % 4;
+      if (op == 0) {
+        ASSERT_EQ(store.erase(key), ref_map.erase(key));
+      } else if (op == 1) {
+        const auto loc = store.find(key);
+        ASSERT_EQ(loc == store.end(), ref_map.count(key) == 0);
+        if (loc == store.end()) continue;
+        const auto value = store.value(loc);
+        store.erase(loc);
+        auto range = ref_map.equal_range(key);
+        while (range.first->second != value) ++range.first;
+        ref_map.erase(range.first);
+      } else {
+        if (unique && ref_map.count(key) > 0) {
+          ref_map.find(key)->second = i;
+        } else {
+          ref_map.emplace(key, i);
+        }
+        store.insert(key, i);
+      }
+    }
+    if (unique) store.rehash();
+
+    ASSERT_EQ(store.size(), ref_map.size());
+    std::size_t num_elements = 0;
+    for (auto loc = store.begin(); loc != store.end(); ++loc) {
+      const std::string key(store.key(loc));
+      ASSERT_EQ(store.count(key), ref_map.count(key));
+      std::size_t num_duplicates = 0;
+      const auto range = store.equal_range(key);
+      for (auto itr = range.first; itr != range.second; ++itr) {
+        ASSERT_EQ(store.key(itr), key);
+        ++num_duplicates;
+      }
+      ASSERT_EQ(num_duplicates, ref_map.count(key));
+      ++num_elements;
+    }
+    ASSERT_EQ(num_elements, ref_map.size());
+  }
+}
+
 TEST(StringKeyStoreTest, Persistence) {
   using value_type = boost::container::vector<
       int, bip::allocator<int, bip::managed_mapped_file::segment_manager>>;
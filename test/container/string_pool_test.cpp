@@ -0,0 +1,107 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/string_pool.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using pool_type =
+    metall::container::string_pool<uint32_t, std::allocator<std::byte>>;
+
+TEST(StringPoolTest, Intern) {
+  pool_type pool;
+  ASSERT_TRUE(pool.empty());
+  ASSERT_EQ(pool.find("a"), pool_type::npos);
+
+  ASSERT_EQ(pool.intern("a"), 0);
+  ASSERT_EQ(pool.intern("bb"), 1);
+  ASSERT_EQ(pool.intern("a"), 0);
+  ASSERT_EQ(pool.intern(""), 2);
+  ASSERT_EQ(pool.size(), 3);
+
+  ASSERT_EQ(pool.find("bb"), 1);
+  ASSERT_EQ(pool.find(""), 2);
+  ASSERT_EQ(pool.find("c"), pool_type::npos);
+  ASSERT_EQ(pool[0], "a");
+  ASSERT_EQ(pool[1], "bb");
+  ASSERT_EQ(pool[2], "");
+}
+
+TEST(StringPoolTest, ManyStrings) {
+  // Grows the ID table over multiple blocks and rehashes the shards
+  pool_type pool;
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_EQ(pool.intern("key-" + std::to_string(i)), i);
+  }
+  for (int i = 0; i < 100000; ++i) {
+    const auto key = "key-" + std::to_string(i);
+    ASSERT_EQ(pool.find(key), i);
+    ASSERT_EQ(pool[i], key);
+  }
+}
+
+TEST(StringPoolTest, ConcurrentIntern) {
+  pool_type pool;
+  constexpr int k_num_threads = 4;
+  constexpr int k_num_keys = 20000;
+
+  std::vector<std::vector<uint32_t>> ids(k_num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&pool, &ids, t]() {
+      for (int i = 0; i < k_num_keys; ++i) {
+        const auto key = std::to_string(i);
+        ids[t].push_back(pool.intern(key));
+        if (pool[ids[t].back()] != key) ids[t].back() = pool_type::npos;
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+
+  ASSERT_EQ(pool.size(), k_num_keys);
+  for (int t = 1; t < k_num_threads; ++t) {
+    ASSERT_EQ(ids[t], ids[0]);
+  }
+  for (int i = 0; i < k_num_keys; ++i) {
+    ASSERT_EQ(pool[ids[0][i]], std::to_string(i));
+  }
+}
+
+TEST(StringPoolTest, Persistence) {
+  using persistent_pool_type = metall::container::string_pool<>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *pool = manager.construct<persistent_pool_type>("pool")(
+        manager.get_allocator());
+    for (int i = 0; i < 5000; ++i) {
+      pool->intern(std::string(i % 50, 'x') + std::to_string(i));
+    }
+  }
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *pool = manager.find<persistent_pool_type>("pool").first;
+    ASSERT_NE(pool, nullptr);
+    ASSERT_EQ(pool->size(), 5000);
+    for (int i = 0; i < 5000; ++i) {
+      const auto key = std::string(i % 50, 'x') + std::to_string(i);
+      ASSERT_EQ(pool->find(key), i);
+      ASSERT_EQ((*pool)[i], key);
+    }
+    ASSERT_TRUE(manager.destroy<persistent_pool_type>("pool"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,211 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/versioned_map.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using map_type = metall::container::versioned_map<uint64_t, int>;
+// Small nodes make deep trees
+using small_map_type =
+    metall::container::versioned_map<int, std::string, std::less<int>,
+                                     std::allocator<std::pair<const int,
+                                                              std::string>>,
+                                     128>;
+
+TEST(VersionedMapTest, Insert) {
+  map_type map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(std::make_pair(uint64_t(1), 10)));
+  ASSERT_FALSE(map.insert(std::make_pair(uint64_t(1), 20)));
+  ASSERT_TRUE(map.try_emplace(2, 20));
+  ASSERT_EQ(map.size(), 2);
+  ASSERT_EQ(map.count(1), 1);
+  ASSERT_EQ(map.count(3), 0);
+
+  int value = 0;
+  ASSERT_TRUE(map.find(1, &value));
+  ASSERT_EQ(value, 10);
+  ASSERT_FALSE(map.find(3, &value));
+}
+
+TEST(VersionedMapTest, Update) {
+  map_type map;
+  ASSERT_TRUE(map.insert_or_assign(1, 10));
+  ASSERT_FALSE(map.insert_or_assign(1, 20));
+  ASSERT_TRUE(map.update(1, [](int &value) { ++value; }));
+  ASSERT_FALSE(map.update(2, [](int &) {}));
+  ASSERT_EQ(map.size(), 1);
+
+  int value = 0;
+  ASSERT_TRUE(map.find(1, &value));
+  ASSERT_EQ(value, 21);
+}
+
+TEST(VersionedMapTest, RandomOperations) {
+  small_map_type map;
+  std::map<int, std::string> reference;
+  std::mt19937 rng(123);
+  for (int i = 0; i < 20000; ++i) {
+    const int key = int(rng() % 3000);
+    const auto op = rng() % 4;
+    if (op == 0) {
+      ASSERT_EQ(map.erase(key), reference.erase(key));
+    } else if (op == 1) {
+      ASSERT_EQ(map.insert_or_assign(key, std::to_string(i)),
+                reference.count(key) == 0);
+      reference[key] = std::to_string(i);
+    } else {
+      ASSERT_EQ(map.try_emplace(key, std::to_string(i)),
+                reference.emplace(key, std::to_string(i)).second);
+    }
+  }
+  ASSERT_EQ(map.size(), reference.size());
+
+  const auto snapshot = map.snapshot();
+  std::vector<std::pair<int, std::string>> items;
+  snapshot.for_each([&items](const auto &item) { items.push_back(item); });
+  ASSERT_EQ(items, decltype(items)(reference.begin(), reference.end()));
+
+  items.clear();
+  snapshot.for_each(1000, 2000,
+                    [&items](const auto &item) { items.push_back(item); });
+  ASSERT_EQ(items, decltype(items)(reference.lower_bound(1000),
+                                   reference.lower_bound(2000)));
+
+  // Erases everything to shrink the tree to nothing
+  for (const auto &item : reference) ASSERT_EQ(map.erase(item.first), 1);
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.try_emplace(1, "1"));
+}
+
+TEST(VersionedMapTest, Snapshot) {
+  small_map_type map;
+  for (int i = 0; i < 1000; ++i) map.try_emplace(i, std::to_string(i));
+
+  const auto old_snapshot = map.snapshot();
+  for (int i = 0; i < 1000; i += 2) map.erase(i);
+  map.update(1, [](std::string &value) { value = "updated"; });
+  map.try_emplace(2000, "new");
+
+  // The old snapshot does not see the modifications
+  ASSERT_EQ(old_snapshot.size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    const auto *const item = old_snapshot.find(i);
+    ASSERT_NE(item, nullptr);
+    ASSERT_EQ(item->second, std::to_string(i));
+  }
+  ASSERT_FALSE(old_snapshot.contains(2000));
+
+  const auto new_snapshot = map.snapshot();
+  ASSERT_EQ(new_snapshot.size(), 501);
+  ASSERT_FALSE(new_snapshot.contains(0));
+  ASSERT_EQ(new_snapshot.find(1)->second, "updated");
+  ASSERT_EQ(new_snapshot.find(2000)->second, "new");
+
+  map.clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(new_snapshot.size(), 501);
+}
+
+TEST(VersionedMapTest, ConcurrentReadersAndWriters) {
+  map_type map;
+  constexpr uint64_t k_num_keys = 2000;
+  for (uint64_t key = 0; key < k_num_keys; ++key) map.try_emplace(key, 0);
+
+  // Every version has k_num_keys elements whose values sum to a multiple of
+  // k_num_keys, as a writer adds 1 to all elements one by one and readers
+  // may see the middle of it; thus, only the size and the order are checked
+  // here, and a snapshot must not change while it is alive
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        const auto snapshot = map.snapshot();
+        std::vector<int> first;
+        snapshot.for_each(
+            [&first](const auto &item) { first.push_back(item.second); });
+        ASSERT_EQ(first.size(), k_num_keys);
+        std::vector<int> second;
+        snapshot.for_each(
+            [&second](const auto &item) { second.push_back(item.second); });
+        ASSERT_EQ(first, second);
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+    writers.emplace_back([&]() {
+      for (int round = 0; round < 5; ++round) {
+        for (uint64_t key = 0; key < k_num_keys; ++key) {
+          ASSERT_TRUE(map.update(key, [](int &value) { ++value; }));
+        }
+      }
+    });
+  }
+  for (auto &th : writers) th.join();
+  done = true;
+  for (auto &th : readers) th.join();
+
+  const auto snapshot = map.snapshot();
+  snapshot.for_each([](const auto &item) { ASSERT_EQ(item.second, 20); });
+}
+
+TEST(VersionedMapTest, Persistence) {
+  using persistent_map_type = metall::container::versioned_map<
+      uint64_t, int, std::less<uint64_t>,
+      metall::manager::allocator_type<std::pair<const uint64_t, int>>>;
+
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *map = manager.construct<persistent_map_type>("map")(
+        manager.get_allocator());
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map->insert(std::make_pair(i, int(i * 2)));
+    }
+    // Some replaced nodes are freed after the datastore is reopened
+    for (uint64_t i = 1000; i < 2000; ++i) {
+      map->insert(std::make_pair(i, 0));
+      map->erase(i);
+    }
+  }
+
+  {
+    metall::manager manager(metall::open_only, dir_path);
+    auto *map = manager.find<persistent_map_type>("map").first;
+    ASSERT_NE(map, nullptr);
+    ASSERT_EQ(map->size(), 1000);
+    {
+      const auto snapshot = map->snapshot();
+      uint64_t expected = 0;
+      snapshot.for_each([&expected](const auto &item) {
+        ASSERT_EQ(item.first, expected);
+        ASSERT_EQ(item.second, int(expected * 2));
+        ++expected;
+      });
+      ASSERT_EQ(expected, 1000);
+    }
+    ASSERT_TRUE(manager.destroy<persistent_map_type>("map"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+}  // namespace
@@ -0,0 +1,69 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <metall/kernel/allocation_counters.hpp>
+
+namespace {
+using metall::kernel::allocation_counters;
+
+TEST(AllocationCountersTest, AddAndRead) {
+  allocation_counters counters(20);
+  ASSERT_EQ(counters.num_bins(), std::size_t(20));
+  ASSERT_EQ(counters.total_objects(), 0);
+
+  counters.add_objects(0, 3);
+  counters.add_objects(19, 2);
+  counters.add_objects(0, -1);
+  counters.add_chunks(19, 8);
+  counters.add_medium_objects(2, 4096);
+  counters.add_freed_bytes(1 << 20);
+
+  ASSERT_EQ(counters.objects(0), 2);
+  ASSERT_EQ(counters.objects(19), 2);
+  ASSERT_EQ(counters.objects(1), 0);
+  ASSERT_EQ(counters.chunks(19), 8);
+  ASSERT_EQ(counters.chunks(0), 0);
+  ASSERT_EQ(counters.medium_objects(), 2);
+  ASSERT_EQ(counters.medium_bytes(), 4096);
+  ASSERT_EQ(counters.freed_bytes(), 1 << 20);
+  ASSERT_EQ(counters.total_objects(), 6);
+
+  counters.clear();
+  ASSERT_EQ(counters.objects(0), 0);
+  ASSERT_EQ(counters.total_objects(), 0);
+  ASSERT_EQ(counters.freed_bytes(), 0);
+}
+
+TEST(AllocationCountersTest, Concurrent) {
+  constexpr std::size_t k_num_threads = 4;
+  constexpr int64_t k_num_adds = 10000;
+  allocation_counters counters(4);
+
+  // An object allocated by one thread can be freed by another
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&counters, t]() {
+      for (int64_t i = 0; i < k_num_adds; ++i) {
+        counters.add_objects(t % 4, 1);
+        counters.add_objects((t + 1) % 4, -1);
+        counters.add_chunks(t % 4, 1);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+
+  ASSERT_EQ(counters.total_objects(), 0);
+  for (std::size_t b = 0; b < 4; ++b) {
+    ASSERT_EQ(counters.objects(b), 0);
+    ASSERT_EQ(counters.chunks(b), k_num_adds);
+  }
+}
+}  // namespace
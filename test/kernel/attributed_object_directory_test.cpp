@@ -210,6 +210,118 @@ TEST(AttributedObjectDirectoryTest, Deserialize) {
   }
 }
 
+TEST(AttributedObjectDirectoryTest, DeserializeJson) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+
+  {
+    directory_type obj;
+    obj.insert("item1", 1, 2, 5);
+    obj.insert("", 3, 4, 6, "description2");
+    ASSERT_TRUE(obj.serialize_json(file));
+  }
+
+  {
+    directory_type obj;
+    ASSERT_TRUE(obj.deserialize(file));
+    ASSERT_EQ(obj.size(), 2);
+    ASSERT_EQ(obj.find("item1")->offset(), 1);
+    const auto itr = obj.find(ssize_t(3));
+    ASSERT_TRUE(itr->name().empty());
+    ASSERT_EQ(itr->type_id(), 6);
+    ASSERT_EQ(itr->description(), "description2");
+  }
+}
+
+TEST(AttributedObjectDirectoryTest, DeserializeManyAnonymous) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+  constexpr ssize_t k_num_entries = 100000;
+
+  {
+    directory_type obj;
+    for (ssize_t i = 0; i < k_num_entries; ++i) {
+      ASSERT_TRUE(obj.insert("", i * 8, 8, 1));
+    }
+    ASSERT_TRUE(obj.insert("named", -8, 8, 2, "d"));
+    ASSERT_TRUE(obj.serialize(file));
+  }
+
+  {
+    directory_type obj;
+    ASSERT_TRUE(obj.deserialize(file));
+    ASSERT_EQ(obj.size(), k_num_entries + 1);
+    for (ssize_t i = 0; i < k_num_entries; i += 997) {
+      ASSERT_EQ(obj.find(i * 8)->length(), 8);
+    }
+    ASSERT_EQ(obj.find("named")->offset(), -8);
+    ASSERT_EQ(obj.find("named")->description(), "d");
+  }
+
+  // A truncated file is rejected
+  std::filesystem::resize_file(file, std::filesystem::file_size(file) - 1);
+  directory_type obj;
+  ASSERT_FALSE(obj.deserialize(file));
+}
+
+TEST(AttributedObjectDirectoryTest, Journal) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+  const auto journal = directory_type::journal_path(file);
+
+  {
+    directory_type obj;
+    obj.insert("item1", 1, 2, 5);
+    obj.insert("item2", 3, 4, 6);
+    ASSERT_TRUE(obj.serialize(file));
+    ASSERT_FALSE(std::filesystem::exists(journal));
+    const auto file_size = std::filesystem::file_size(file);
+
+    // Only the changes are appended to the journal
+    ASSERT_TRUE(obj.insert("item3", 7, 8, 9, "description3"));
+    ASSERT_EQ(obj.erase("item1"), 1);
+    ASSERT_TRUE(obj.set_description(obj.find("item2"), "description2"));
+    ASSERT_TRUE(obj.flush(file));
+    ASSERT_TRUE(obj.flush(file));
+    ASSERT_EQ(std::filesystem::file_size(file), file_size);
+    ASSERT_TRUE(std::filesystem::exists(journal));
+  }
+
+  {
+    directory_type obj;
+    ASSERT_TRUE(obj.deserialize(file));
+    ASSERT_EQ(obj.size(), 2);
+    ASSERT_EQ(obj.count("item1"), 0);
+    ASSERT_EQ(obj.find("item2")->description(), "description2");
+    ASSERT_EQ(obj.find("item3")->offset(), 7);
+    ASSERT_EQ(obj.find("item3")->description(), "description3");
+
+    // Appends to the replayed journal
+    ASSERT_EQ(obj.erase("item2"), 1);
+    ASSERT_TRUE(obj.flush(file));
+  }
+
+  // A partially written record is ignored
+  std::filesystem::resize_file(journal,
+                               std::filesystem::file_size(journal) - 1);
+  {
+    directory_type obj;
+    ASSERT_TRUE(obj.deserialize(file));
+    ASSERT_EQ(obj.size(), 2);
+    ASSERT_EQ(obj.count("item2"), 1);
+
+    // Compacts the journal
+    ASSERT_TRUE(obj.serialize(file));
+    ASSERT_FALSE(std::filesystem::exists(journal));
+  }
+
+  {
+    directory_type obj;
+    ASSERT_TRUE(obj.deserialize(file));
+    ASSERT_EQ(obj.size(), 2);
+  }
+}
+
 TEST(AttributedObjectDirectoryTest, Clear) {
   test_utility::create_test_dir();
   const auto file(test_utility::make_test_path());
@@ -67,7 +67,19 @@ TEST(BinManagerTest, ToLargeBinNo) {
   ASSERT_EQ(bin_no_mngr::to_bin_no(k_chunk_size * 3),
             bin_no_mngr::num_small_bins() + 2);
   ASSERT_EQ(bin_no_mngr::to_bin_no(k_chunk_size * 3 + 1),
-            bin_no_mngr::num_small_bins() + 2);
+            bin_no_mngr::num_small_bins() + 3);
+
+  // Four sizes per power of two
+  ASSERT_EQ(bin_no_mngr::to_object_size(bin_no_mngr::to_bin_no(
+                k_chunk_size * 8 + 1)),
+            k_chunk_size * 10);
+  ASSERT_EQ(bin_no_mngr::to_object_size(bin_no_mngr::to_bin_no(
+                k_chunk_size * 65)),
+            k_chunk_size * 80);
+  for (std::size_t size = k_chunk_size; size < k_max_size / 2; size *= 2) {
+    ASSERT_EQ(bin_no_mngr::to_object_size(bin_no_mngr::to_bin_no(size)),
+              size);
+  }
 
   ASSERT_EQ(bin_no_mngr::to_bin_no(k_max_size - 1),
             bin_no_mngr::num_small_bins() + bin_no_mngr::num_large_bins() - 1);
@@ -75,4 +87,41 @@ TEST(BinManagerTest, ToLargeBinNo) {
             bin_no_mngr::num_small_bins() + bin_no_mngr::num_large_bins() - 1);
 }
 
+TEST(BinManagerTest, CustomSizeClassTable) {
+  using table_type =
+      metall::kernel::size_class_table<8, 16, 24, 32, 40, 64, 72, 128>;
+  using custom_bin_no_mngr =
+      metall::kernel::bin_number_manager<k_chunk_size, k_max_size, table_type>;
+
+  for (std::size_t i = 0; i < table_type::k_num_sizes; ++i) {
+    const std::size_t size = table_type::k_sizes[i];
+    ASSERT_EQ(custom_bin_no_mngr::to_object_size(i), size);
+    ASSERT_EQ(custom_bin_no_mngr::to_bin_no(size), i);
+    ASSERT_EQ(custom_bin_no_mngr::to_bin_no(size + 1), i + 1);
+    if (i > 0) {
+      ASSERT_EQ(custom_bin_no_mngr::to_bin_no(size - 1), i);
+    }
+  }
+  ASSERT_EQ(custom_bin_no_mngr::to_bin_no(1), 0);
+  ASSERT_EQ(custom_bin_no_mngr::to_bin_no(41), 5);
+  ASSERT_EQ(custom_bin_no_mngr::to_bin_no(65), 6);
+
+  // The sizes after the table are spaced as in the default table
+  ASSERT_EQ(custom_bin_no_mngr::to_object_size(table_type::k_num_sizes), 160);
+  ASSERT_EQ(custom_bin_no_mngr::to_object_size(table_type::k_num_sizes + 4),
+            320);
+  for (std::size_t b = table_type::k_num_sizes;
+       b < custom_bin_no_mngr::num_bins(); ++b) {
+    const auto size = custom_bin_no_mngr::to_object_size(b);
+    ASSERT_GT(size, custom_bin_no_mngr::to_object_size(b - 1));
+    ASSERT_EQ(custom_bin_no_mngr::to_bin_no(size), b);
+    ASSERT_EQ(custom_bin_no_mngr::to_bin_no(size - 1), b);
+  }
+  ASSERT_EQ(custom_bin_no_mngr::num_large_bins(),
+            bin_no_mngr::num_large_bins());
+  ASSERT_EQ(custom_bin_no_mngr::to_object_size(
+                custom_bin_no_mngr::num_small_bins()),
+            k_chunk_size);
+}
+
 }  // namespace
\ No newline at end of file
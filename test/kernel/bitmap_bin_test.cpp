@@ -0,0 +1,96 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <metall/kernel/bitmap_bin.hpp>
+
+namespace {
+using bin_type = metall::kernel::bitmap_bin<uint32_t>;
+
+TEST(BitmapBinTest, Front) {
+  bin_type bin;
+  ASSERT_TRUE(bin.empty());
+
+  ASSERT_TRUE(bin.insert(100));
+  ASSERT_EQ(bin.front(), 100);
+  ASSERT_TRUE(bin.insert(5000));
+  ASSERT_EQ(bin.front(), 100);
+  ASSERT_TRUE(bin.insert(3));
+  ASSERT_EQ(bin.front(), 3);
+  ASSERT_FALSE(bin.insert(3));  // Already in the bin
+  ASSERT_EQ(bin.size(), 3);
+
+  bin.pop_front();
+  ASSERT_EQ(bin.front(), 100);
+  bin.pop_front();
+  ASSERT_EQ(bin.front(), 5000);
+  bin.pop_front();
+  ASSERT_TRUE(bin.empty());
+}
+
+TEST(BitmapBinTest, Erase) {
+  bin_type bin;
+  ASSERT_FALSE(bin.erase(0));
+
+  bin.insert(0);
+  bin.insert(64);
+  bin.insert(1ULL << 20ULL);
+  ASSERT_TRUE(bin.erase(64));
+  ASSERT_FALSE(bin.erase(64));
+  ASSERT_FALSE(bin.erase(65));
+  ASSERT_FALSE(bin.erase(1ULL << 30ULL));  // Beyond the bitmap
+  ASSERT_TRUE(bin.erase(0));
+  ASSERT_EQ(bin.front(), 1ULL << 20ULL);
+  ASSERT_EQ(bin.size(), 1);
+  ASSERT_FALSE(bin.contains(0));
+  ASSERT_TRUE(bin.contains(1ULL << 20ULL));
+
+  bin.clear();
+  ASSERT_TRUE(bin.empty());
+  ASSERT_FALSE(bin.contains(1ULL << 20ULL));
+  ASSERT_EQ(bin.begin(), bin.end());
+}
+
+TEST(BitmapBinTest, Iterate) {
+  bin_type bin;
+  const std::vector<uint32_t> values = {1, 2, 63, 64, 4095, 4096, 300000};
+  for (auto itr = values.rbegin(); itr != values.rend(); ++itr) {
+    bin.insert(*itr);
+  }
+  ASSERT_EQ(std::vector<uint32_t>(bin.begin(), bin.end()), values);
+}
+
+TEST(BitmapBinTest, CompareWithSet) {
+  bin_type bin;
+  std::set<uint32_t> reference;
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<uint32_t> dist(0, 1 << 18);
+
+  for (int i = 0; i < 100000; ++i) {
+    const auto value = dist(rng);
+    if (rng() % 3 == 0) {
+      ASSERT_EQ(bin.erase(value), reference.erase(value) == 1);
+    } else if (rng() % 5 == 0 && !reference.empty()) {
+      ASSERT_EQ(bin.front(), *reference.begin());
+      bin.pop_front();
+      reference.erase(reference.begin());
+    } else {
+      ASSERT_EQ(bin.insert(value), reference.insert(value).second);
+    }
+    ASSERT_EQ(bin.size(), reference.size());
+    if (!reference.empty()) {
+      ASSERT_EQ(bin.front(), *reference.begin());
+    }
+  }
+  ASSERT_TRUE(std::equal(bin.begin(), bin.end(), reference.begin(),
+                         reference.end()));
+}
+}  // namespace
@@ -6,6 +6,10 @@
 #include "gtest/gtest.h"
 #include <cstdint>
 #include <memory>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
 #include <metall/kernel/chunk_directory.hpp>
 #include <metall/kernel/bin_number_manager.hpp>
 #include <metall/metall.hpp>
@@ -66,6 +70,224 @@ TEST(ChunkDirectoryTest, EraseChunk) {
   ASSERT_EQ(directory.size(), 0);
 }
 
+TEST(ChunkDirectoryTest, ReuseFreeExtent) {
+  chunk_directory_type directory(1 << 10);
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+  const auto bin_2chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 1);
+  const auto bin_4chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 3);
+
+  // [0-3][4][5-6][7][8-11]
+  ASSERT_EQ(directory.insert(bin_4chunks), 0);
+  ASSERT_EQ(directory.insert(bin_1chunk), 4);
+  ASSERT_EQ(directory.insert(bin_2chunks), 5);
+  ASSERT_EQ(directory.insert(bin_1chunk), 7);
+  ASSERT_EQ(directory.insert(bin_4chunks), 8);
+  ASSERT_EQ(directory.num_free_extents(), 0);
+
+  directory.erase(0);
+  directory.erase(5);
+  ASSERT_EQ(directory.num_free_extents(), 2);
+
+  // The shortest extent that is long enough is used
+  ASSERT_EQ(directory.insert(bin_2chunks), 5);
+  ASSERT_EQ(directory.num_free_extents(), 1);
+  ASSERT_EQ(directory.insert(bin_1chunk), 0);
+  ASSERT_EQ(directory.insert(bin_2chunks), 1);
+  ASSERT_EQ(directory.insert(0), 3);
+  ASSERT_EQ(directory.num_free_extents(), 0);
+
+  // No extent is long enough, use the end of the directory
+  ASSERT_EQ(directory.insert(bin_4chunks), 12);
+}
+
+TEST(ChunkDirectoryTest, MergeFreeExtents) {
+  chunk_directory_type directory(1 << 10);
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+  const auto bin_4chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 3);
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(directory.insert(bin_1chunk), i);
+  }
+
+  directory.erase(1);
+  directory.erase(3);
+  ASSERT_EQ(directory.num_free_extents(), 2);
+  directory.erase(2);
+  ASSERT_EQ(directory.num_free_extents(), 1);  // [1-3] are merged
+  ASSERT_EQ(directory.size(), 5);
+
+  // Freeing the last chunk shrinks the directory, absorbing [1-3]
+  directory.erase(4);
+  ASSERT_EQ(directory.num_free_extents(), 0);
+  ASSERT_EQ(directory.size(), 1);
+
+  ASSERT_EQ(directory.insert(bin_4chunks), 1);
+  ASSERT_EQ(directory.size(), 5);
+}
+
+TEST(ChunkDirectoryTest, InsertAligned) {
+  chunk_directory_type directory(1 << 10);
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+  const auto bin_2chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 1);
+
+  // The chunks before the aligned chunk become a free extent
+  ASSERT_EQ(directory.insert(bin_1chunk), 0);
+  ASSERT_EQ(directory.insert_aligned(bin_2chunks, 8), 8);
+  ASSERT_EQ(directory.size(), 10);
+  ASSERT_EQ(directory.num_free_extents(), 1);
+  ASSERT_EQ(directory.bin_no(8), bin_2chunks);
+
+  // An aligned run in the middle of a free extent splits it: [1-3][6-7]
+  ASSERT_EQ(directory.insert_aligned(bin_2chunks, 4), 4);
+  ASSERT_EQ(directory.num_free_extents(), 2);
+  ASSERT_EQ(directory.size(), 10);
+
+  // No free extent contains an aligned run
+  ASSERT_EQ(directory.insert_aligned(bin_2chunks, 16), 16);
+  ASSERT_EQ(directory.num_free_extents(), 3);
+
+  // The free extents are still used by the normal insertion
+  ASSERT_EQ(directory.insert(bin_2chunks), 6);
+  ASSERT_EQ(directory.insert(bin_1chunk), 1);
+
+  directory.erase(8);
+  directory.erase(16);
+  ASSERT_EQ(directory.size(), 8);
+}
+
+TEST(ChunkDirectoryTest, InsertAt) {
+  chunk_directory_type directory(1 << 10);
+  const auto bin_2chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 1);
+
+  ASSERT_TRUE(directory.insert_at(4, bin_2chunks));
+  ASSERT_EQ(directory.size(), 6);
+  ASSERT_EQ(directory.num_free_extents(), 1);
+
+  ASSERT_FALSE(directory.insert_at(5, bin_2chunks));  // Used
+  ASSERT_FALSE(directory.insert_at(3, bin_2chunks));  // Partially used
+  ASSERT_TRUE(directory.insert_at(1, bin_2chunks));
+  ASSERT_EQ(directory.num_free_extents(), 2);  // [0] and [3]
+  ASSERT_EQ(directory.insert(0), 0);
+}
+
+TEST(ChunkDirectoryTest, ArenaNo) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+
+  {
+    chunk_directory_type directory(4);
+    ASSERT_EQ(directory.insert(0), 0);
+    ASSERT_EQ(directory.insert(0, 3), 1);
+    ASSERT_EQ(directory.arena_no(0), 0);
+    ASSERT_EQ(directory.arena_no(1), 3);
+
+    // A reused chunk does not keep the previous owner
+    directory.erase(1);
+    ASSERT_EQ(directory.insert(1, 2), 1);
+    ASSERT_EQ(directory.arena_no(1), 2);
+    ASSERT_TRUE(directory.serialize(file));
+  }
+
+  {
+    // The ownership is not stored
+    chunk_directory_type directory(4);
+    ASSERT_TRUE(directory.deserialize(file));
+    ASSERT_EQ(directory.arena_no(0), 0);
+    ASSERT_EQ(directory.arena_no(1), 0);
+  }
+}
+
+TEST(ChunkDirectoryTest, Heat) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+
+  {
+    chunk_directory_type directory(4);
+    ASSERT_EQ(directory.insert(0), 0);
+    ASSERT_EQ(directory.insert(1), 1);
+    ASSERT_EQ(directory.heat(0), 0);
+
+    // The latest sample is the most significant bit
+    directory.record_access(0, true);
+    directory.record_access(1, true);
+    directory.record_access(0, false);
+    ASSERT_EQ(directory.heat(0), 0x40);
+    ASSERT_EQ(directory.heat(1), 0x80);
+
+    // Only the last 8 samples are kept
+    for (int i = 0; i < 7; ++i) directory.record_access(0, false);
+    ASSERT_EQ(directory.heat(0), 0);
+
+    // A reused chunk does not keep the previous heat
+    directory.erase(0);
+    ASSERT_EQ(directory.insert(0), 0);
+    ASSERT_EQ(directory.heat(0), 0);
+    ASSERT_TRUE(directory.serialize(file));
+  }
+
+  {
+    // The heat is stored
+    chunk_directory_type directory(4);
+    ASSERT_TRUE(directory.deserialize(file));
+    ASSERT_EQ(directory.heat(0), 0);
+    ASSERT_EQ(directory.heat(1), 0x80);
+  }
+}
+
+TEST(ChunkDirectoryTest, ResizeLargeChunk) {
+  chunk_directory_type directory(1 << 10);
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+  const auto bin_2chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 1);
+  const auto bin_4chunks =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins + 3);
+
+  // [0-1][2-3][4]
+  ASSERT_EQ(directory.insert(bin_2chunks), 0);
+  ASSERT_EQ(directory.insert(bin_2chunks), 2);
+  ASSERT_EQ(directory.insert(bin_1chunk), 4);
+
+  // The next chunks are used
+  ASSERT_FALSE(directory.resize_large_chunk(0, bin_4chunks));
+  ASSERT_EQ(directory.bin_no(0), bin_2chunks);
+
+  // Grow into the end of the directory
+  ASSERT_TRUE(directory.resize_large_chunk(4, bin_4chunks));
+  ASSERT_EQ(directory.bin_no(4), bin_4chunks);
+  ASSERT_EQ(directory.size(), 8);
+
+  // Grow into a free extent
+  directory.erase(2);
+  ASSERT_EQ(directory.num_free_extents(), 1);
+  ASSERT_TRUE(directory.resize_large_chunk(0, bin_4chunks));
+  ASSERT_EQ(directory.bin_no(0), bin_4chunks);
+  ASSERT_EQ(directory.num_free_extents(), 0);
+  ASSERT_EQ(directory.insert(bin_1chunk), 8);
+
+  // Shrink releases the tail chunks
+  ASSERT_TRUE(directory.resize_large_chunk(0, bin_1chunk));
+  ASSERT_EQ(directory.bin_no(0), bin_1chunk);
+  for (chunk_no_type i = 1; i < 4; ++i) {
+    ASSERT_TRUE(directory.unused_chunk(i));
+  }
+  ASSERT_EQ(directory.insert(bin_2chunks), 1);
+
+  directory.erase(0);
+  directory.erase(1);
+  directory.erase(4);
+  directory.erase(8);
+  ASSERT_EQ(directory.size(), 0);
+}
+
 TEST(ChunkDirectoryTest, MarkSlot) {
   chunk_directory_type directory(bin_no_mngr::num_small_bins() + 1);
 
@@ -176,4 +398,137 @@ TEST(ChunkDirectoryTest, Deserialize) {
               large_chunk2_no + 2);
   }
 }
+
+TEST(ChunkDirectoryTest, DeserializeFreeExtents) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+
+  {
+    chunk_directory_type directory(16);
+    for (int i = 0; i < 6; ++i) {
+      directory.insert(bin_1chunk);
+    }
+    directory.erase(1);
+    directory.erase(3);
+    directory.erase(4);
+    ASSERT_TRUE(directory.serialize(file));
+  }
+
+  {
+    chunk_directory_type directory(16);
+    ASSERT_TRUE(directory.deserialize(file));
+    ASSERT_EQ(directory.size(), 6);
+    ASSERT_EQ(directory.num_free_extents(), 2);
+    ASSERT_EQ(directory.insert(bin_1chunk), 1);
+    ASSERT_EQ(directory.insert(bin_1chunk), 3);
+    ASSERT_EQ(directory.insert(bin_1chunk), 4);
+    ASSERT_EQ(directory.insert(bin_1chunk), 6);
+  }
+}
+
+TEST(ChunkDirectoryTest, DeserializeManyChunks) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+  // Spans multiple ranges parsed in parallel
+  constexpr std::size_t k_num_chunks = 200000;
+  const auto small_bin =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins - 1);
+  const auto bin_1chunk =
+      static_cast<bin_no_mngr::bin_no_type>(k_num_small_bins);
+
+  {
+    chunk_directory_type directory(k_num_chunks);
+    for (std::size_t i = 0; i < k_num_chunks; ++i) {
+      if (i % 4 == 0) {
+        const auto chunk_no = directory.insert(small_bin);
+        directory.find_and_mark_slot(chunk_no);
+      } else {
+        directory.insert(bin_1chunk);
+      }
+    }
+    directory.erase(k_num_chunks / 2 + 1);
+    ASSERT_TRUE(directory.serialize(file));
+  }
+
+  {
+    chunk_directory_type directory(k_num_chunks);
+    ASSERT_TRUE(directory.deserialize(file));
+    ASSERT_EQ(directory.size(), k_num_chunks);
+    for (std::size_t i = 0; i < k_num_chunks; ++i) {
+      const auto chunk_no = static_cast<chunk_no_type>(i);
+      if (i == k_num_chunks / 2 + 1) {
+        ASSERT_TRUE(directory.unused_chunk(chunk_no));
+      } else if (i % 4 == 0) {
+        ASSERT_EQ(directory.bin_no(chunk_no), small_bin);
+        ASSERT_EQ(directory.occupied_slots(chunk_no), 1);
+        ASSERT_TRUE(directory.marked_slot(chunk_no, 0));
+      } else {
+        ASSERT_EQ(directory.bin_no(chunk_no), bin_1chunk);
+      }
+    }
+    ASSERT_EQ(directory.insert(bin_1chunk), k_num_chunks / 2 + 1);
+  }
+}
+
+TEST(ChunkDirectoryTest, DeserializeTextFormat) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+
+  // The text format used by older versions:
+  // [chunk no] [bin no] [type] ([#of occupied slots] [slot bitset])
+  const auto last_small_bin = k_num_small_bins - 1;  // 2 slots per chunk
+  {
+    std::ofstream ofs(file);
+    ofs << 0 << " " << k_num_small_bins << " " << 2 << "\n";
+    ofs << 2 << " " << last_small_bin << " " << 1 << " " << 1 << " "
+        << (1ULL << 63ULL) << "\n";
+    // The large sizes were powers of two; this bin was 4 chunks
+    ofs << 3 << " " << k_num_small_bins + 2 << " " << 2 << "\n";
+    for (int i = 4; i < 7; ++i) {
+      ofs << i << " " << k_num_small_bins + 2 << " " << 3 << "\n";
+    }
+  }
+
+  chunk_directory_type directory(16);
+  ASSERT_TRUE(directory.deserialize(file));
+  ASSERT_EQ(directory.size(), 7);
+  ASSERT_EQ(directory.bin_no(0), k_num_small_bins);
+  ASSERT_TRUE(directory.unused_chunk(1));
+  ASSERT_EQ(directory.bin_no(2), last_small_bin);
+  ASSERT_EQ(directory.occupied_slots(2), 1);
+  ASSERT_TRUE(directory.marked_slot(2, 0));
+  ASSERT_FALSE(directory.marked_slot(2, 1));
+  ASSERT_EQ(directory.num_free_extents(), 1);
+  ASSERT_EQ(directory.bin_no(3), bin_no_mngr::to_bin_no(k_chunk_size * 4));
+  ASSERT_EQ(directory.bin_no(6), bin_no_mngr::to_bin_no(k_chunk_size * 4));
+  std::vector<std::string> problems;
+  ASSERT_TRUE(directory.check(1, &problems));
+
+  // Once it is serialized again, the binary format is used
+  ASSERT_TRUE(directory.serialize(file));
+  chunk_directory_type directory2(16);
+  ASSERT_TRUE(directory2.deserialize(file));
+  ASSERT_EQ(directory2.size(), 7);
+  ASSERT_EQ(directory2.bin_no(3), bin_no_mngr::to_bin_no(k_chunk_size * 4));
+  ASSERT_TRUE(directory2.marked_slot(2, 0));
+  ASSERT_EQ(directory2.find_and_mark_slot(2), 1);
+}
+
+TEST(ChunkDirectoryTest, DeserializeBrokenFile) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto file(test_utility::make_test_path());
+
+  {
+    chunk_directory_type directory(16);
+    directory.insert(0);
+    directory.insert(k_num_small_bins);
+    ASSERT_TRUE(directory.serialize(file));
+  }
+  std::filesystem::resize_file(file, std::filesystem::file_size(file) - 8);
+
+  chunk_directory_type directory(16);
+  ASSERT_FALSE(directory.deserialize(file));
+}
 }  // namespace
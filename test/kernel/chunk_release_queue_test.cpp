@@ -0,0 +1,84 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <utility>
+#include <vector>
+
+#include <metall/kernel/chunk_release_queue.hpp>
+
+namespace {
+using queue_type = metall::kernel::chunk_release_queue;
+using range_list = std::vector<std::pair<uint64_t, std::size_t>>;
+
+range_list release(queue_type &queue) {
+  range_list ranges;
+  queue.release([&ranges](const uint64_t chunk_no, const std::size_t n) {
+    ranges.emplace_back(chunk_no, n);
+  });
+  return ranges;
+}
+
+TEST(ChunkReleaseQueueTest, Push) {
+  queue_type queue;
+  ASSERT_TRUE(queue.empty());
+
+  queue.push(10, 2);
+  queue.push(0, 1);
+  queue.push(20, 4);
+  ASSERT_EQ(queue.num_chunks(), 7);
+  ASSERT_EQ(queue.num_ranges(), 3);
+
+  ASSERT_EQ(release(queue), (range_list{{0, 1}, {10, 2}, {20, 4}}));
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(queue.num_chunks(), 0);
+}
+
+TEST(ChunkReleaseQueueTest, Merge) {
+  queue_type queue;
+  queue.push(10, 2);
+  queue.push(12, 1);  // Merged with the previous
+  queue.push(8, 2);   // Merged with the next
+  ASSERT_EQ(queue.num_ranges(), 1);
+
+  queue.push(16, 4);
+  queue.push(13, 3);  // Merged with both
+  ASSERT_EQ(queue.num_ranges(), 1);
+  ASSERT_EQ(queue.num_chunks(), 12);
+  ASSERT_EQ(release(queue), (range_list{{8, 12}}));
+
+  // Freeing chunks one by one ends up with a single range
+  for (uint64_t i = 0; i < 100; ++i) queue.push((i * 37) % 100, 1);
+  ASSERT_EQ(release(queue), (range_list{{0, 100}}));
+}
+
+TEST(ChunkReleaseQueueTest, Erase) {
+  queue_type queue;
+  queue.push(10, 10);
+
+  queue.erase(0, 5);  // No overlap
+  queue.erase(25, 5);
+  ASSERT_EQ(queue.num_chunks(), 10);
+
+  queue.erase(10, 1);  // Head
+  queue.erase(19, 1);  // Tail
+  queue.erase(14, 2);  // Middle
+  ASSERT_EQ(queue.num_chunks(), 6);
+  ASSERT_EQ(release(queue), (range_list{{11, 3}, {16, 3}}));
+
+  queue.push(0, 4);
+  queue.push(6, 4);
+  queue.push(12, 4);
+  queue.erase(2, 12);  // Covers multiple ranges partially and fully
+  ASSERT_EQ(queue.num_chunks(), 4);
+  ASSERT_EQ(release(queue), (range_list{{0, 2}, {14, 2}}));
+
+  queue.push(0, 4);
+  queue.erase(0, 4);
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(queue.num_chunks(), 0);
+}
+}  // namespace
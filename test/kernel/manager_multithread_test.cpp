@@ -350,4 +350,38 @@ TEST(ManagerMultithreadsTest, ConstructAndFind) {
 
   ::free(num_deallocated);
 }
+
+TEST(ManagerMultithreadsTest, ProducerConsumer) {
+  // Each thread frees the objects the previous thread allocated
+  constexpr std::size_t k_num_objects = 1 << 14;
+  const auto dir(test_utility::make_test_path());
+  manager_type manager(metall::create_only, dir);
+
+  const int num_threads = get_num_threads();
+  std::vector<std::vector<uint64_t *>> objects(num_threads);
+  for (int round = 0; round < 3; ++round) {
+    OMP_DIRECTIVE(parallel) {
+      const int tid = omp::get_thread_num();
+      for (std::size_t i = 0; i < k_num_objects; ++i) {
+        auto *const object =
+            static_cast<uint64_t *>(manager.allocate(8 << (i % 8)));
+        *object = tid;
+        objects[tid].push_back(object);
+      }
+      OMP_DIRECTIVE(barrier)
+
+      const int producer = (tid + 1) % num_threads;
+      for (auto *const object : objects[producer]) {
+        if (*object != static_cast<uint64_t>(producer)) {
+          OMP_DIRECTIVE(critical)
+          ADD_FAILURE() << "An object was overwritten";
+        }
+        manager.deallocate(object);
+      }
+      OMP_DIRECTIVE(barrier)
+      objects[tid].clear();
+    }
+  }
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
 }  // namespace
\ No newline at end of file
@@ -5,10 +5,28 @@
 
 #include "gtest/gtest.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <unordered_set>
+#include <set>
+#include <vector>
+#include <cstring>
+#include <iterator>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
 
 #include <metall/metall.hpp>
+#include <metall/container/map.hpp>
+#include <metall/container/vector.hpp>
 #include <metall/kernel/object_size_manager.hpp>
 #include "../test_utility.hpp"
 
@@ -137,6 +155,468 @@ TEST(ManagerTest, findOrConstruct) {
   }
 }
 
+#ifndef METALL_DISABLE_CONCURRENCY
+TEST(ManagerTest, ConcurrentFind) {
+  constexpr int k_num_objects = 64;
+  constexpr int k_num_threads = 8;
+  const auto name = [](const int i) { return "obj" + std::to_string(i); };
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    for (int i = 0; i < k_num_objects; ++i) {
+      manager.construct<int>(name(i).c_str())(i);
+    }
+
+    // Lookups run concurrently with constructions and destructions
+    std::vector<std::thread> threads;
+    std::atomic<int> num_errors{0};
+    for (int t = 0; t < k_num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (int n = 0; n < 1000; ++n) {
+          const int i = n % k_num_objects;
+          const auto *const p = manager.find<int>(name(i).c_str()).first;
+          if (!p || *p != i) ++num_errors;
+          const auto extra = name(k_num_objects + t);
+          if (*manager.find_or_construct<int>(extra.c_str())(t) != t ||
+              !manager.destroy<int>(extra.c_str())) {
+            ++num_errors;
+          }
+        }
+      });
+    }
+    for (auto &th : threads) th.join();
+    ASSERT_EQ(num_errors.load(), 0);
+    ASSERT_EQ(manager.get_num_named_objects(), k_num_objects);
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    std::vector<std::thread> threads;
+    std::atomic<int> num_errors{0};
+    for (int t = 0; t < k_num_threads; ++t) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i < k_num_objects; ++i) {
+          const auto *const p = manager.find<int>(name(i).c_str()).first;
+          if (!p || *p != i) ++num_errors;
+        }
+      });
+    }
+    for (auto &th : threads) th.join();
+    ASSERT_EQ(num_errors.load(), 0);
+  }
+}
+#endif
+
+TEST(ManagerTest, FindHandle) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+  manager.construct<int>("int")(10);
+  manager.construct<double>(metall::unique_instance)[2](1.5);
+  manager.construct<int>("tmp")(0);
+
+  const auto handle = manager.find_handle<int>("int");
+  ASSERT_TRUE(handle.valid());
+  ASSERT_EQ(*manager.find(handle).first, 10);
+  ASSERT_EQ(manager.find(handle).second, 1);
+
+  const auto uhandle = manager.find_handle<double>(metall::unique_instance);
+  ASSERT_EQ(manager.find(uhandle).first[1], 1.5);
+  ASSERT_EQ(manager.find(uhandle).second, 2);
+
+  ASSERT_FALSE(manager.find_handle<int>("none").valid());
+  ASSERT_EQ(manager.find(manager.find_handle<int>("none")).first, nullptr);
+
+  // Constructing objects keeps handles, destroying any makes them stale
+  manager.construct<int>("another")(20);
+  ASSERT_EQ(*manager.find(handle).first, 10);
+  ASSERT_TRUE(manager.destroy<int>("tmp"));
+  ASSERT_EQ(manager.find(handle).first, nullptr);
+  ASSERT_EQ(*manager.find(manager.find_handle<int>("int")).first, 10);
+}
+
+TEST(ManagerTest, ReadOnlySharing) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    manager.construct<int>("int")(10);
+    manager.construct<double>(metall::unique_instance)[2](1.5);
+    manager.construct<char>(metall::anonymous_instance)('a');
+  }
+
+  {
+    // Read-only managers open the same datastore at the same time
+    manager_type reader0(metall::open_read_only, dir_path());
+    manager_type reader1(metall::open_read_only, dir_path());
+    for (auto *const manager : {&reader0, &reader1}) {
+      ASSERT_EQ(*manager->find<int>("int").first, 10);
+      ASSERT_EQ(manager->find<int>("int").second, 1);
+      ASSERT_EQ(manager->find<double>(metall::unique_instance).first[1], 1.5);
+      ASSERT_EQ(manager->find<double>(metall::unique_instance).second, 2);
+      ASSERT_EQ(manager->find<int>("none").first, nullptr);
+      ASSERT_EQ(manager->find<float>(metall::unique_instance).first, nullptr);
+    }
+
+    // The other functions work after finding objects
+    ASSERT_EQ(reader0.get_num_named_objects(), 1);
+    ASSERT_EQ(reader0.get_num_unique_objects(), 1);
+    ASSERT_EQ(reader0.get_num_anonymous_objects(), 1);
+    ASSERT_STREQ(reader0.named_begin()->name().c_str(), "int");
+    ASSERT_EQ(*reader0.find<int>("int").first, 10);
+    ASSERT_STREQ(reader1.get_instance_name(reader1.find<int>("int").first),
+                 "int");
+  }
+
+  {
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.destroy<int>("int"));
+    manager.construct<int>("int2")(20);
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(manager.find<int>("int").first, nullptr);
+    ASSERT_EQ(*manager.find<int>("int2").first, 20);
+    ASSERT_EQ(manager.get_num_named_objects(), 1);
+  }
+}
+
+TEST(ManagerTest, OpenMany) {
+  std::vector<manager_type::path_type> paths;
+  for (int i = 0; i < 8; ++i) {
+    paths.emplace_back(dir_path().string() + "-" + std::to_string(i));
+    manager_type::remove(paths.back());
+    manager_type manager(metall::create_only, paths.back());
+    manager.construct<int>("shard")(i);
+  }
+
+  {
+    auto managers = manager_type::open_many(metall::open_only, paths);
+    ASSERT_EQ(managers.size(), paths.size());
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(managers[i]);
+      ASSERT_EQ(*managers[i]->find<int>("shard").first, i);
+      managers[i]->construct<int>("value")(i * 10);
+    }
+  }
+
+  {
+    auto managers = manager_type::open_many(metall::open_read_only, paths);
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(managers[i]);
+      ASSERT_EQ(*managers[i]->find<int>("value").first, i * 10);
+    }
+  }
+
+  // A data store that does not exist
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  manager_type::remove(paths[3]);
+  {
+    auto managers = manager_type::open_many(metall::open_read_only, paths);
+    ASSERT_EQ(managers.size(), paths.size());
+    ASSERT_FALSE(managers[3]);
+    ASSERT_TRUE(managers[2]);
+    ASSERT_TRUE(managers[4]);
+  }
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+
+  for (const auto &path : paths) manager_type::remove(path);
+}
+
+#ifndef METALL_USE_ANONYMOUS_NEW_MAP
+TEST(ManagerTest, LiveReadOnly) {
+  manager_type::remove(dir_path());
+  manager_type writer(metall::create_only, dir_path());
+  {
+    // No version has been published
+    manager_type reader(metall::open_live_read_only, dir_path());
+    ASSERT_FALSE(reader.check_sanity());
+  }
+
+  auto *const obj = writer.construct<int>("obj")(1);
+  writer.construct<double>(metall::unique_instance)(1.5);
+  ASSERT_TRUE(writer.publish());
+  ASSERT_EQ(writer.published_version(), 1);
+
+  manager_type reader(metall::open_live_read_only, dir_path());
+  ASSERT_TRUE(reader.check_sanity());
+  ASSERT_TRUE(reader.read_only());
+  ASSERT_EQ(reader.published_version(), 1);
+  ASSERT_EQ(*reader.find<int>("obj").first, 1);
+  ASSERT_EQ(*reader.find<double>(metall::unique_instance).first, 1.5);
+  ASSERT_FALSE(reader.publish());
+  ASSERT_FALSE(writer.refresh());
+
+  // The object data is shared, not versioned
+  *obj = 2;
+  ASSERT_EQ(*reader.find<int>("obj").first, 2);
+
+  // New objects, including the ones in new blocks, are visible in the next
+  // version
+  constexpr std::size_t k_large_size = METALL_SEGMENT_BLOCK_SIZE * 2;
+  auto *const large = static_cast<char *>(writer.allocate(k_large_size));
+  ASSERT_NE(large, nullptr);
+  large[k_large_size - 1] = 'x';
+  writer.construct<metall::offset_ptr<char>>("large")(large);
+  ASSERT_TRUE(reader.refresh());
+  ASSERT_EQ(reader.published_version(), 1);
+  ASSERT_EQ(reader.find<metall::offset_ptr<char>>("large").first, nullptr);
+
+  ASSERT_TRUE(writer.publish());
+  ASSERT_TRUE(reader.refresh());
+  ASSERT_EQ(reader.published_version(), 2);
+  const auto *const found =
+      reader.find<metall::offset_ptr<char>>("large").first;
+  ASSERT_NE(found, nullptr);
+  ASSERT_EQ(found->get()[k_large_size - 1], 'x');
+  ASSERT_EQ(*reader.find<int>("obj").first, 2);
+
+  // A reader can skip versions
+  writer.destroy<int>("obj");
+  ASSERT_TRUE(writer.publish());
+  ASSERT_TRUE(writer.publish());
+  ASSERT_TRUE(reader.refresh());
+  ASSERT_EQ(reader.published_version(), 4);
+  ASSERT_EQ(reader.find<int>("obj").first, nullptr);
+}
+#endif
+
+TEST(ManagerTest, ConstructMany) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) names.push_back("obj" + std::to_string(i));
+    const auto objects = manager.construct_many<int>(names, 7);
+    ASSERT_EQ(objects.size(), names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      ASSERT_EQ(manager.find<int>(names[i].c_str()).first, objects[i]);
+      ASSERT_EQ(*objects[i], 7);
+    }
+
+    // Fails as a whole
+    ASSERT_TRUE(manager.construct_many<int>({"new", "obj10"}, 1).empty());
+    ASSERT_TRUE(manager.construct_many<int>({"dup", "dup"}, 1).empty());
+    ASSERT_TRUE(manager.construct_many<int>({"a", ""}, 1).empty());
+    ASSERT_EQ(manager.find<int>("new").first, nullptr);
+    ASSERT_EQ(manager.get_num_named_objects(), names.size());
+
+    ASSERT_TRUE(manager.destroy<int>("obj0"));
+  }
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(*manager.find<int>("obj999").first, 7);
+    ASSERT_EQ(manager.find<int>("obj0").first, nullptr);
+    ASSERT_TRUE(manager.construct_many<int>({"b"}, 1).empty());
+  }
+}
+
+namespace {
+// Counts the live objects; the constructor throws at a given index
+struct counted_object {
+  inline static std::atomic<int> num_live{0};
+  inline static std::atomic<int> num_constructed{0};
+  inline static int throw_at{-1};
+
+  counted_object() : value(num_constructed.fetch_add(1)) {
+    if (value == throw_at) throw std::runtime_error("throw_at");
+    ++num_live;
+  }
+  ~counted_object() { --num_live; }
+
+  int value;
+};
+}  // namespace
+
+TEST(ManagerTest, ConstructParallel) {
+  manager_type::remove(dir_path());
+  constexpr std::size_t k_length = k_chunk_size * 4 / sizeof(uint64_t);
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    auto *const array =
+        manager.construct_parallel<int>("array", k_length, 4, 3);
+    ASSERT_NE(array, nullptr);
+    ASSERT_EQ(manager.find<int>("array").first, array);
+    ASSERT_EQ(manager.find<int>("array").second, k_length);
+    for (std::size_t i = 0; i < k_length; ++i) ASSERT_EQ(array[i], 3);
+
+    ASSERT_EQ(manager.construct_parallel<int>("array", k_length, 4, 3),
+              nullptr);
+    ASSERT_EQ(manager.find_or_construct_parallel<int>("array", 1, 4), array);
+
+    std::vector<int> values(k_length);
+    for (std::size_t i = 0; i < values.size(); ++i) values[i] = int(i);
+    auto *const copy = manager.construct_it_parallel<int>(
+        "copy", values.size(), 0, values.begin());
+    ASSERT_NE(copy, nullptr);
+    ASSERT_TRUE(std::equal(values.begin(), values.end(), copy));
+
+    // Reused memory is zero-initialized too
+    auto *const used = static_cast<char *>(
+        manager.allocate(k_length * sizeof(uint64_t)));
+    std::memset(used, 0xff, k_length * sizeof(uint64_t));
+    manager.deallocate(used);
+    auto *const zeros =
+        manager.construct_parallel<uint64_t>("zeros", k_length, 4);
+    ASSERT_NE(zeros, nullptr);
+    for (std::size_t i = 0; i < k_length; ++i) ASSERT_EQ(zeros[i], 0);
+    std::memset(zeros, 0xff, k_length * sizeof(uint64_t));
+    ASSERT_TRUE(manager.destroy<uint64_t>("zeros"));
+
+    // Destroys all constructed objects if a constructor throws
+    counted_object::throw_at = int(k_length / 2);
+    ASSERT_THROW(manager.construct_parallel<counted_object>("throw", k_length,
+                                                             4),
+                 std::runtime_error);
+    ASSERT_EQ(counted_object::num_live.load(), 0);
+    ASSERT_EQ(manager.find<counted_object>("throw").first, nullptr);
+  }
+  {
+    // The memory used before the datastore is opened is not zero-filled
+    manager_type manager(metall::open_only, dir_path());
+    auto *const zeros =
+        manager.construct_parallel<uint64_t>("zeros", k_length, 4);
+    ASSERT_NE(zeros, nullptr);
+    for (std::size_t i = 0; i < k_length; ++i) ASSERT_EQ(zeros[i], 0);
+  }
+}
+
+TEST(ManagerTest, AllocateZeroed) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+
+  // Reused memory is filled with zeros too
+  for (const std::size_t size : {std::size_t(8), std::size_t(1000),
+                                 k_chunk_size, k_chunk_size * 3}) {
+    for (int i = 0; i < 2; ++i) {
+      auto *const addr = static_cast<unsigned char *>(
+          manager.allocate_zeroed(size));
+      ASSERT_NE(addr, nullptr);
+      ASSERT_TRUE(std::all_of(addr, addr + size,
+                              [](const unsigned char c) { return c == 0; }));
+      std::memset(addr, 0xff, size);
+      manager.deallocate(addr);
+    }
+  }
+
+  auto allocator = manager.get_allocator<uint64_t>();
+  const std::size_t length = k_chunk_size * 2 / sizeof(uint64_t);
+  for (int i = 0; i < 2; ++i) {
+    auto ptr = allocator.allocate_zeroed(length);
+    auto *const array = metall::to_raw_pointer(ptr);
+    ASSERT_TRUE(std::all_of(array, array + length,
+                            [](const uint64_t v) { return v == 0; }));
+    std::fill(array, array + length, 1);
+    allocator.deallocate(ptr, length);
+  }
+}
+
+TEST(ManagerTest, DestroyParallel) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+
+  using vector_type =
+      metall::container::vector<int, manager_type::allocator_type<int>>;
+  constexpr std::size_t k_length = 1000;
+  auto *const vectors = manager.construct<vector_type>("vectors")[k_length](
+      manager.get_allocator<int>());
+  for (std::size_t i = 0; i < k_length; ++i) vectors[i].resize(i + 1);
+
+  ASSERT_FALSE(manager.destroy_parallel<vector_type>("none", 4));
+  ASSERT_TRUE(manager.destroy_parallel<vector_type>("vectors", 4));
+  ASSERT_EQ(manager.find<vector_type>("vectors").first, nullptr);
+  ASSERT_TRUE(manager.all_memory_deallocated());
+
+  // Trivially destructible objects
+  ASSERT_NE(manager.construct<int>(metall::unique_instance)[10](), nullptr);
+  ASSERT_TRUE(manager.destroy_parallel<int>(metall::unique_instance, 0));
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
+TEST(ManagerTest, Drop) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+
+  // A map whose elements are in an arena
+  using resource_type = manager_type::arena_resource_type;
+  using map_type = metall::container::map<
+      int, int, std::less<int>,
+      manager_type::arena_allocator<std::pair<const int, int>>>;
+  auto *const arena = manager.construct<resource_type>("arena")(
+      manager.get_allocator());
+  auto *const map = manager.construct<map_type>("map")(arena);
+  for (int i = 0; i < 10000; ++i) (*map)[i] = i;
+
+  ASSERT_FALSE(manager.drop<map_type>("none"));
+  ASSERT_TRUE(manager.drop<map_type>("map"));
+  ASSERT_EQ(manager.find<map_type>("map").first, nullptr);
+  ASSERT_TRUE(manager.destroy<resource_type>("arena"));
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
+TEST(ManagerTest, Recover) {
+  // Not dir_path() as the child process has to know the path
+  const auto path = test_utility::make_test_path();
+  manager_type::remove(path);
+  constexpr std::size_t k_large_size = k_chunk_size * 2;
+
+  // A child process crashes without closing the data store.
+  // Runs the child in a new process as forking with threads is not safe.
+  ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  const auto crash = [&path]() {
+    auto *const manager =
+        new manager_type(metall::create_only, path, 1UL << 30UL);
+    auto *const offsets = manager->construct<std::ptrdiff_t>("offsets")[2](0);
+    auto *const value = manager->construct<int>("value")(1);
+    if (!manager->flush_async().get()) std::_Exit(1);
+
+    // After the checkpoint
+    const auto *const base = static_cast<const char *>(manager->get_address());
+    auto *const small = static_cast<char *>(manager->allocate(64));
+    auto *const large = static_cast<char *>(manager->allocate(k_large_size));
+    if (!small || !large) std::_Exit(1);
+    std::memset(small, 's', 64);
+    std::memset(large, 'l', k_large_size);
+    offsets[0] = small - base;
+    offsets[1] = large - base;
+    *value = 2;
+    manager->construct<int>("lost")(3);
+    std::_Exit(0);
+  };
+  ASSERT_EXIT(crash(), ::testing::ExitedWithCode(0), "");
+
+  ASSERT_FALSE(manager_type::consistent(path));
+  ASSERT_TRUE(manager_type::recover(path));
+  ASSERT_TRUE(manager_type::consistent(path));
+
+  {
+    manager_type manager(metall::open_only, path);
+    ASSERT_EQ(*manager.find<int>("value").first, 2);
+    ASSERT_EQ(manager.find<int>("lost").first, nullptr);
+
+    // The memory allocated after the checkpoint is not reused
+    const auto *const offsets = manager.find<std::ptrdiff_t>("offsets").first;
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    std::vector<void *> new_objects;
+    for (int i = 0; i < 1000; ++i) {
+      new_objects.push_back(manager.allocate(64));
+      std::memset(new_objects.back(), 0, 64);
+    }
+    for (int i = 0; i < 4; ++i) {
+      new_objects.push_back(manager.allocate(k_large_size));
+      std::memset(new_objects.back(), 0, k_large_size);
+    }
+    for (std::size_t i = 0; i < 64; ++i) {
+      ASSERT_EQ(base[offsets[0] + i], 's');
+    }
+    for (std::size_t i = 0; i < k_large_size; i += 4096) {
+      ASSERT_EQ(base[offsets[1] + i], 'l');
+    }
+    for (auto *const object : new_objects) manager.deallocate(object);
+  }
+  ASSERT_TRUE(manager_type::consistent(path));
+  ASSERT_TRUE(manager_type::recover(path));
+}
+
 TEST(ManagerTest, findOrConstructArray) {
   {
     {
@@ -1150,130 +1630,1743 @@ TEST(ManagerTest, AllMemoryDeallocated) {
   }
 }
 
-TEST(ManagerTest, AlignedAllocation) {
-  {
-    manager_type::remove(dir_path());
-    manager_type manager(metall::create_only, dir_path());
-    const std::size_t page_size = metall::mtlldetail::get_page_size();
+TEST(ManagerTest, SizedDeallocation) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+
+  for (const std::size_t size :
+       {std::size_t(1), std::size_t(8), std::size_t(100), std::size_t(4096),
+        std::size_t(k_chunk_size / 2), std::size_t(k_chunk_size),
+        std::size_t(k_chunk_size * 3 + 1)}) {
+    std::vector<void *> addrs;
+    for (int i = 0; i < 16; ++i) {
+      addrs.push_back(manager.allocate(size));
+      ASSERT_NE(addrs.back(), nullptr);
+    }
+    for (auto *addr : addrs) {
+      manager.deallocate(addr, size);
+    }
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
 
-    for (std::size_t alignment = k_min_object_size; alignment <= page_size;
-         alignment *= 2) {
-      for (std::size_t sz = alignment; sz <= page_size * 2;
-           sz += alignment) {
-        auto addr1 =
-            static_cast<char *>(manager.allocate_aligned(sz, alignment));
-        ASSERT_EQ(reinterpret_cast<uint64_t>(addr1) % alignment, 0);
+  // Does nothing
+  manager.deallocate(nullptr, 8);
+}
 
-        auto addr2 =
-            static_cast<char *>(manager.allocate_aligned(sz, alignment));
-        ASSERT_EQ(reinterpret_cast<uint64_t>(addr2) % alignment, 0);
+TEST(ManagerTest, Reallocate) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
 
-        auto addr3 =
-            static_cast<char *>(manager.allocate_aligned(sz, alignment));
-        ASSERT_EQ(reinterpret_cast<uint64_t>(addr3) % alignment, 0);
+  const auto fill = [](void *const addr, const std::size_t size) {
+    auto *const p = static_cast<unsigned char *>(addr);
+    for (std::size_t i = 0; i < size; ++i) p[i] = i % 251;
+  };
+  const auto check = [](const void *const addr, const std::size_t size) {
+    const auto *const p = static_cast<const unsigned char *>(addr);
+    for (std::size_t i = 0; i < size; ++i) {
+      if (p[i] != i % 251) return false;
+    }
+    return true;
+  };
 
-        manager.deallocate(addr1);
-        manager.deallocate(addr2);
-        manager.deallocate(addr3);
-      }
+  // Works as allocate()
+  auto *addr = manager.reallocate(nullptr, 8);
+  ASSERT_NE(addr, nullptr);
+  fill(addr, 8);
+
+  // Small to small (moves)
+  addr = manager.reallocate(addr, 1024);
+  ASSERT_NE(addr, nullptr);
+  ASSERT_TRUE(check(addr, 8));
+  fill(addr, 1024);
+
+  // Small to large (moves)
+  addr = manager.reallocate(addr, k_chunk_size * 3);
+  ASSERT_NE(addr, nullptr);
+  ASSERT_TRUE(check(addr, 1024));
+  fill(addr, k_chunk_size * 3);
+
+  // Grows in place as the next chunks are not used
+  ASSERT_TRUE(manager.resize_in_place(addr, k_chunk_size * 4));
+  ASSERT_EQ(manager.reallocate(addr, k_chunk_size * 8), addr);
+  ASSERT_TRUE(check(addr, k_chunk_size * 3));
+  fill(addr, k_chunk_size * 8);
+
+  // Shrinks in place
+  ASSERT_EQ(manager.reallocate(addr, k_chunk_size * 2), addr);
+  ASSERT_TRUE(check(addr, k_chunk_size * 2));
+
+  // Moves as the next chunks are used
+  auto *const blocker = manager.allocate(k_chunk_size * 4);
+  ASSERT_NE(blocker, nullptr);
+  ASSERT_FALSE(manager.resize_in_place(addr, k_chunk_size * 8));
+  addr = manager.reallocate(addr, k_chunk_size * 8);
+  ASSERT_NE(addr, nullptr);
+  ASSERT_TRUE(check(addr, k_chunk_size * 2));
+  manager.deallocate(blocker);
+
+  // Large to small (moves)
+  ASSERT_FALSE(manager.resize_in_place(addr, 64));
+  addr = manager.reallocate(addr, 64);
+  ASSERT_NE(addr, nullptr);
+  ASSERT_TRUE(check(addr, 64));
+
+  // Works as deallocate()
+  ASSERT_EQ(manager.reallocate(addr, 0), nullptr);
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
 
-      {
-        // Invalid argument
-        // Alignment is not a power of 2
-        auto addr1 = static_cast<char *>(
-            manager.allocate_aligned(alignment + 1, alignment + 1));
-        ASSERT_EQ(addr1, nullptr);
+TEST(ManagerTest, MediumObjects) {
+  // From just above 1/32 of a chunk to two chunks
+  const std::vector<std::size_t> sizes = {
+      k_chunk_size / 32 + 1, k_chunk_size / 20, k_chunk_size / 2 + 8,
+      k_chunk_size + 1, k_chunk_size * 2};
+  const auto fill = [](void *const addr, const std::size_t size,
+                       const std::size_t seed) {
+    auto *const p = static_cast<unsigned char *>(addr);
+    for (std::size_t i = 0; i < size; i += 512) p[i] = (i + seed) % 251;
+  };
+  const auto check = [](const void *const addr, const std::size_t size,
+                        const std::size_t seed) {
+    const auto *const p = static_cast<const unsigned char *>(addr);
+    for (std::size_t i = 0; i < size; i += 512) {
+      if (p[i] != (i + seed) % 251) return false;
+    }
+    return true;
+  };
 
-        // Invalid arguments
-        // Size is not a multiple of alignment
-        auto addr2 = static_cast<char *>(
-            manager.allocate_aligned(alignment + 1, alignment));
-        ASSERT_EQ(addr2, nullptr);
-      }
+  std::vector<std::ptrdiff_t> offsets;
+  {
+    manager_type::remove(dir_path());
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    std::vector<void *> addrs;
+    for (std::size_t i = 0; i < 40; ++i) {
+      const auto size = sizes[i % sizes.size()];
+      addrs.push_back(manager.allocate(size));
+      ASSERT_NE(addrs.back(), nullptr);
+      fill(addrs.back(), size, i);
+    }
+    // Free every other object and fill the holes with smaller objects
+    for (std::size_t i = 0; i < addrs.size(); i += 2) {
+      manager.deallocate(addrs[i]);
+      addrs[i] = manager.allocate(sizes[0]);
+      ASSERT_NE(addrs[i], nullptr);
+      fill(addrs[i], sizes[0], i);
+    }
+    for (std::size_t i = 0; i < addrs.size(); ++i) {
+      const auto size = (i % 2 == 0) ? sizes[0] : sizes[i % sizes.size()];
+      ASSERT_TRUE(check(addrs[i], size, i));
+      offsets.push_back(static_cast<const char *>(addrs[i]) -
+                        static_cast<const char *>(manager.get_address()));
     }
 
-    {
-      // Invalid argument
-      // Alignment is smaller than k_min_object_size
-      auto addr1 = static_cast<char *>(manager.allocate_aligned(8, 1));
-      ASSERT_EQ(addr1, nullptr);
+#ifdef METALL_USE_MEDIUM_OBJECT_SLABS
+    manager_type::memory_statistics_type stats;
+    ASSERT_TRUE(manager.get_memory_statistics(&stats));
+    ASSERT_EQ(stats.medium_objects.num_objects, addrs.size());
+    ASSERT_GT(stats.medium_objects.num_slabs, 0);
+
+    // Objects are placed next to each other
+    auto *const first = static_cast<char *>(manager.allocate(sizes[0]));
+    auto *const second = static_cast<char *>(manager.allocate(sizes[0]));
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    ASSERT_LT(std::abs(second - first), k_chunk_size / 16);
+
+    // Grows into the free space right after it
+    manager.deallocate(second);
+    ASSERT_TRUE(manager.resize_in_place(first, k_chunk_size / 16));
+    manager.deallocate(first);
+#endif
+  }
 
-      // Invalid arguments
-      // Alignment is larger than k_chunk_size
-      auto addr2 = static_cast<char *>(
-          manager.allocate_aligned(k_chunk_size * 2, k_chunk_size * 2));
-      ASSERT_EQ(addr2, nullptr);
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+      const auto size = (i % 2 == 0) ? sizes[0] : sizes[i % sizes.size()];
+      ASSERT_TRUE(check(base + offsets[i], size, i));
+    }
+    for (const auto offset : offsets) {
+      manager.deallocate(const_cast<char *>(base + offset));
     }
+    ASSERT_TRUE(manager.all_memory_deallocated());
   }
 }
 
-TEST(ManagerTest, Flush) {
-  manager_type::remove(dir_path());
-  manager_type manager(metall::create_only, dir_path());
-
-  manager.construct<int>("int")(10);
+TEST(ManagerTest, Compact) {
+  constexpr std::size_t k_object_size = 64;
+  constexpr std::size_t k_num_objects = k_chunk_size / k_object_size * 3;
+  {
+    manager_type::remove(dir_path());
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
 
-  manager.flush();
+    std::vector<std::size_t *> addrs;
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      addrs.push_back(
+          static_cast<std::size_t *>(manager.allocate(k_object_size)));
+      ASSERT_NE(addrs.back(), nullptr);
+      *addrs.back() = i;
+    }
 
-  ASSERT_FALSE(manager_type::consistent(dir_path()));
-}
+    // Leave a few objects in each chunk
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      if (i % 1000 == 0) continue;
+      manager.deallocate(addrs[i]);
+    }
+    ASSERT_TRUE(manager.compact());
 
-TEST(ManagerTest, AnonymousConstruct) {
-  manager_type::remove(dir_path());
-  manager_type *manager;
-  manager = new manager_type(metall::create_only, dir_path(), 1UL << 30UL);
+    for (std::size_t i = 0; i < k_num_objects; i += 1000) {
+      ASSERT_EQ(*addrs[i], i);
+    }
+    ASSERT_NE(manager.allocate(k_object_size), nullptr);
+  }
 
-  int *const a = manager->construct<int>(metall::anonymous_instance)();
-  ASSERT_NE(a, nullptr);
+  {
+    // The objects kept in the object cache are freed when the datastore is
+    // closed; compact it offline
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.compact());
+  }
 
-  // They have to be fail (return false values)
-  const auto ret = manager->find<int>(metall::anonymous_instance);
-  ASSERT_EQ(ret.first, nullptr);
-  ASSERT_EQ(ret.second, 0);
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_FALSE(manager.compact());
+  }
+}
 
-  manager->deallocate(a);
+TEST(ManagerTest, MemoryStatistics) {
+  constexpr std::size_t k_object_size = 64;
+  constexpr std::size_t k_num_objects = k_chunk_size / k_object_size * 3;
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
 
-  delete manager;
+  std::vector<void *> addrs;
+  for (std::size_t i = 0; i < k_num_objects; ++i) {
+    addrs.push_back(manager.allocate(k_object_size));
+    ASSERT_NE(addrs.back(), nullptr);
+  }
+  for (std::size_t i = 0; i < k_num_objects; i += 2) {
+    manager.deallocate(addrs[i]);
+  }
+  ASSERT_NE(manager.allocate(k_chunk_size * 4), nullptr);
+  ASSERT_NE(manager.construct<char>("obj")[k_chunk_size](), nullptr);
+
+  manager_type::memory_statistics_type stats;
+  ASSERT_TRUE(manager.get_memory_statistics(&stats, true, true));
+  ASSERT_EQ(stats.chunk_size, k_chunk_size);
+  ASSERT_EQ(stats.segment_size, manager.get_size());
+  ASSERT_GT(stats.resident_bytes, 0);
+  ASSERT_LE(stats.resident_bytes, stats.segment_size);
+
+  std::size_t num_chunks = 0;
+  std::size_t allocated_bytes = 0;
+  bool found_small = false;
+  bool found_large = false;
+  for (const auto &bin : stats.bins) {
+    num_chunks += bin.num_chunks;
+    allocated_bytes += bin.allocated_bytes;
+    ASSERT_EQ(bin.allocated_bytes + bin.free_bytes,
+              bin.num_chunks * k_chunk_size);
+    if (bin.object_size == k_object_size) {
+      found_small = true;
+      ASSERT_EQ(bin.num_chunks, 3);
+      ASSERT_EQ(bin.num_objects, k_num_objects / 2);
+      ASSERT_NEAR(bin.fragmentation(), 0.5, 0.01);
+    } else if (bin.object_size == k_chunk_size * 4) {
+      found_large = true;
+      ASSERT_EQ(bin.num_chunks, 4);
+      ASSERT_EQ(bin.num_objects, 1);
+    }
+  }
+  ASSERT_TRUE(found_small);
+  ASSERT_TRUE(found_large);
+  // Medium objects are counted apart from the bins
+  const auto &medium = stats.medium_objects;
+  ASSERT_EQ(num_chunks + medium.num_chunks, stats.num_used_chunks);
+  ASSERT_EQ(allocated_bytes + medium.allocated_bytes, stats.allocated_bytes);
+  ASSERT_EQ(medium.allocated_bytes + medium.free_bytes,
+            medium.num_chunks * k_chunk_size);
+
+  ASSERT_EQ(stats.named_objects.size(), 1);
+  ASSERT_EQ(stats.named_objects[0].name, "obj");
+  ASSERT_GE(stats.named_objects[0].bytes, k_chunk_size);
+
+  const auto json = stats.to_json();
+  ASSERT_EQ(json.front(), '{');
+  ASSERT_NE(json.find("\"name\":\"obj\""), std::string::npos);
+
+  // The object cache is not drained
+  manager_type::memory_statistics_type stats2;
+  ASSERT_TRUE(manager.get_memory_statistics(&stats2));
+  ASSERT_EQ(stats2.cached_bytes, stats.cached_bytes);
+  ASSERT_TRUE(stats2.named_objects.empty());
+  ASSERT_EQ(stats2.resident_bytes, 0);
 }
 
-TEST(ManagerTest, UniqueConstruct) {
+TEST(ManagerTest, MemoryCounters) {
+  constexpr std::size_t k_object_size = 64;
+  constexpr std::size_t k_num_objects = k_chunk_size / k_object_size * 3;
   manager_type::remove(dir_path());
-  manager_type *manager;
-  manager = new manager_type(metall::create_only, dir_path(), 1UL << 30UL);
 
-  int *const a = manager->construct<int>(metall::unique_instance)();
-  ASSERT_NE(a, nullptr);
+  // The counters must agree with the statistics, which scan the data store
+  const auto check = [](manager_type &manager) {
+    manager_type::memory_counters_type counters;
+    manager_type::memory_statistics_type stats;
+    ASSERT_TRUE(manager.get_memory_counters(&counters));
+    ASSERT_TRUE(manager.get_memory_statistics(&stats));
+    ASSERT_EQ(counters.chunk_size, k_chunk_size);
+    ASSERT_EQ(counters.allocated_bytes, stats.allocated_bytes);
+    ASSERT_EQ(counters.num_used_chunks, stats.num_used_chunks);
+    ASSERT_EQ(counters.num_medium_objects, stats.medium_objects.num_objects);
+    ASSERT_EQ(counters.medium_allocated_bytes,
+              stats.medium_objects.allocated_bytes);
+    std::size_t num_objects = 0;
+    for (const auto &bin : stats.bins) {
+      num_objects += bin.num_objects;
+      const auto itr = std::find_if(
+          counters.bins.begin(), counters.bins.end(),
+          [&bin](const auto &b) { return b.bin_no == bin.bin_no; });
+      ASSERT_NE(itr, counters.bins.end());
+      ASSERT_EQ(itr->num_objects, bin.num_objects);
+    }
+    ASSERT_EQ(counters.num_objects,
+              num_objects + stats.medium_objects.num_objects);
+  };
 
-  double *const b =
-      manager->find_or_construct<double>(metall::unique_instance)();
-  ASSERT_NE(b, nullptr);
+  std::vector<std::ptrdiff_t> offsets;
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    ASSERT_TRUE(manager.all_memory_deallocated());
+    check(manager);
 
-  ASSERT_EQ(manager->find<int>(metall::unique_instance).first, a);
-  ASSERT_EQ(manager->find<int>(metall::unique_instance).second, 1);
+    std::vector<void *> addrs;
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      addrs.push_back(manager.allocate(k_object_size));
+      ASSERT_NE(addrs.back(), nullptr);
+    }
+    for (std::size_t i = 0; i < k_num_objects; i += 2) {
+      manager.deallocate(addrs[i]);
+    }
+    void *const large = manager.allocate(k_chunk_size * 4);
+    void *const medium = manager.allocate(k_chunk_size / 2);
+    ASSERT_NE(large, nullptr);
+    ASSERT_NE(medium, nullptr);
+    ASSERT_NE(manager.construct<char>("obj")[k_chunk_size * 3](), nullptr);
+    ASSERT_FALSE(manager.all_memory_deallocated());
+    check(manager);
 
-  ASSERT_EQ(manager->find<double>(metall::unique_instance).first, b);
-  ASSERT_EQ(manager->find<double>(metall::unique_instance).second, 1);
+    manager_type::memory_counters_type counters;
+    ASSERT_TRUE(manager.get_memory_counters(&counters));
+    const auto json = counters.to_json();
+    ASSERT_EQ(json.front(), '{');
+    ASSERT_NE(json.find("\"freed_bytes\":"), std::string::npos);
 
-  ASSERT_EQ(manager->destroy<int>(metall::unique_instance), true);
-  ASSERT_EQ(manager->destroy<double>(metall::unique_instance), true);
+    manager.deallocate(large);
+    manager.deallocate(medium);
+    check(manager);
 
-  delete manager;
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 1; i < k_num_objects; i += 2) {
+      offsets.push_back(static_cast<const char *>(addrs[i]) - base);
+    }
+  }
+
+  // The counters are rebuilt when the data store is opened
+  {
+    manager_type manager(metall::open_only, dir_path());
+    check(manager);
+    ASSERT_TRUE(manager.destroy<char>("obj"));
+    auto *const base = const_cast<char *>(
+        static_cast<const char *>(manager.get_address()));
+    for (const auto offset : offsets) manager.deallocate(base + offset);
+    check(manager);
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
 }
 
-TEST(ManagerTest, UUID) {
+TEST(ManagerTest, ObjectCachePrefill) {
+  constexpr std::size_t k_object_size = 64;
+  constexpr std::size_t k_num_objects = k_chunk_size / k_object_size * 2;
   manager_type::remove(dir_path());
-  std::string uuid;
+  std::vector<std::ptrdiff_t> offsets;
   {
     manager_type manager(metall::create_only, dir_path());
-
-    uuid = manager_type::get_uuid(dir_path());
-    ASSERT_FALSE(uuid.empty());
+    auto *const base =
+        const_cast<char *>(static_cast<const char *>(manager.get_address()));
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      offsets.push_back(static_cast<char *>(manager.allocate(k_object_size)) -
+                        base);
+    }
+    // Leaves free slots in the chunks and objects in the cache
+    for (std::size_t i = 0; i < k_num_objects; i += 2) {
+      manager.deallocate(base + offsets[i]);
+    }
   }
 
-  {  // Returns the same UUID?
+  const auto num_cached_objects = [](manager_type &manager) {
+    manager_type::memory_statistics_type stats;
+    EXPECT_TRUE(manager.get_memory_statistics(&stats));
+    std::size_t num = 0;
+    for (const auto &bin : stats.bins) num += bin.num_cached_objects;
+    return num;
+  };
+  {
     manager_type manager(metall::open_only, dir_path());
-    ASSERT_EQ(manager_type::get_uuid(dir_path()), uuid);
-  }
+#if defined(METALL_USE_OBJECT_CACHE_PREFILL) && \
+    !defined(METALL_DISABLE_OBJECT_CACHE)
+    ASSERT_GT(num_cached_objects(manager), 0);
+#else
+    ASSERT_EQ(num_cached_objects(manager), 0);
+#endif
+    // The cached objects are free slots
+    auto *const base =
+        const_cast<char *>(static_cast<const char *>(manager.get_address()));
+    std::set<std::ptrdiff_t> allocated;
+    for (std::size_t i = 1; i < k_num_objects; i += 2) {
+      allocated.insert(offsets[i]);
+    }
+    for (std::size_t i = 0; i < k_num_objects / 2; ++i) {
+      const auto offset =
+          static_cast<char *>(manager.allocate(k_object_size)) - base;
+      ASSERT_TRUE(allocated.insert(offset).second);
+    }
+    for (const auto offset : allocated) manager.deallocate(base + offset);
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+  {
+    // Not filled when opened read-only
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(num_cached_objects(manager), 0);
+  }
+}
+
+TEST(ManagerTest, Transaction) {
+  manager_type::remove(dir_path());
+  std::ptrdiff_t offset;
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    auto *const a = manager.construct<std::array<int, 64>>("a")();
+    auto *const b = manager.construct<int>("b")(0);
+    a->fill(1);
+    offset = reinterpret_cast<const char *>(a) -
+             static_cast<const char *>(manager.get_address());
+
+    ASSERT_FALSE(manager.in_transaction());
+    ASSERT_FALSE(manager.add_to_transaction(a, sizeof(*a)));
+    ASSERT_FALSE(manager.commit_transaction());
+
+    // Committed updates remain
+    ASSERT_TRUE(manager.begin_transaction());
+    ASSERT_FALSE(manager.begin_transaction());
+    ASSERT_TRUE(manager.in_transaction());
+    ASSERT_TRUE(manager.add_to_transaction(a, sizeof(*a)));
+    ASSERT_TRUE(manager.add_to_transaction(b, sizeof(*b)));
+    a->fill(2);
+    *b = 2;
+    ASSERT_TRUE(manager.commit_transaction());
+    ASSERT_FALSE(manager.in_transaction());
+    ASSERT_EQ((*a)[63], 2);
+    ASSERT_EQ(*b, 2);
+
+    // Aborted updates are undone
+    ASSERT_TRUE(manager.begin_transaction());
+    ASSERT_TRUE(manager.add_to_transaction(&(*a)[10], sizeof(int)));
+    ASSERT_TRUE(manager.add_to_transaction(b, sizeof(*b)));
+    (*a)[10] = 3;
+    *b = 3;
+    ASSERT_TRUE(manager.abort_transaction());
+    ASSERT_EQ((*a)[10], 2);
+    ASSERT_EQ(*b, 2);
+
+    // Rolled back when the manager is closed
+    ASSERT_TRUE(manager.begin_transaction());
+    ASSERT_TRUE(manager.add_to_transaction(b, sizeof(*b)));
+    *b = 4;
+  }
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(*manager.find<int>("b").first, 2);
+  }
+
+  // Rolled back when the data store is opened after a crash, simulated by
+  // putting back the undo log of a transaction whose updates reached the
+  // data store
+  const auto log_copy = fs::path(dir_path().string() + "_undo_log");
+  fs::path log_path;
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const a = manager.find<std::array<int, 64>>("a").first;
+    ASSERT_TRUE(manager.begin_transaction());
+    ASSERT_TRUE(manager.add_to_transaction(a, sizeof(*a)));
+    a->fill(5);
+    for (const auto &entry : fs::recursive_directory_iterator(dir_path())) {
+      if (entry.path().filename() == "undo_log") log_path = entry.path();
+    }
+    ASSERT_FALSE(log_path.empty());
+    fs::copy_file(log_path, log_copy, fs::copy_options::overwrite_existing);
+    ASSERT_TRUE(manager.commit_transaction());
+  }
+  fs::copy_file(log_copy, log_path);
+  fs::remove(log_copy);
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const a = manager.find<std::array<int, 64>>("a").first;
+    ASSERT_EQ(reinterpret_cast<const char *>(a) -
+                  static_cast<const char *>(manager.get_address()),
+              offset);
+    for (const auto v : *a) ASSERT_EQ(v, 2);
+  }
+  ASSERT_FALSE(fs::exists(log_path));
+}
+
+TEST(ManagerTest, AllocationProfile) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+  const auto profile_path = dir_path().string() + "_profile.heap";
+
+#ifdef METALL_USE_ALLOCATION_SAMPLING
+  for (std::size_t i = 0; i < 1000; ++i) {
+    ASSERT_NE(manager.allocate(1024), nullptr);
+  }
+  ASSERT_TRUE(manager.write_allocation_profile(profile_path));
+
+  std::ifstream ifs(profile_path);
+  std::string line;
+  ASSERT_TRUE(std::getline(ifs, line));
+  ASSERT_EQ(line.find("heap profile: "), 0);
+  ASSERT_NE(line.find("@ heap_v2/"), std::string::npos);
+  ASSERT_TRUE(std::getline(ifs, line));
+  ASSERT_EQ(line.find("0: 0 ["), 0);
+#else
+  ASSERT_FALSE(manager.write_allocation_profile(profile_path));
+#endif
+  fs::remove(profile_path);
+}
+
+TEST(ManagerTest, PhaseTimings) {
+  using metall::kernel::phase;
+  manager_type::remove(dir_path());
+  manager_type::phase_timings_type timings;
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    ASSERT_TRUE(manager.get_phase_timings(&timings));
+    ASSERT_EQ(timings[phase::create].count, 1);
+    ASSERT_EQ(timings[phase::map_segment].count, 1);
+    ASSERT_EQ(timings[phase::open].count, 0);
+    ASSERT_GE(timings[phase::create].total_ns,
+              timings[phase::map_segment].total_ns);
+  }
+
+  manager_type::set_phase_timing_log_level(metall::logger::level::verbose);
+  {
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.get_phase_timings(&timings));
+    ASSERT_EQ(timings[phase::open].count, 1);
+    ASSERT_EQ(timings[phase::map_segment].count, 1);
+    ASSERT_EQ(timings[phase::deserialize_management_data].count, 1);
+    ASSERT_EQ(timings[phase::load_segment_allocator].count, 0);
+
+    manager.reset_phase_timings();
+    ASSERT_NE(manager.allocate(8), nullptr);
+    manager.flush();
+    ASSERT_TRUE(manager.get_phase_timings(&timings));
+    ASSERT_EQ(timings[phase::open].count, 0);
+    ASSERT_EQ(timings[phase::load_segment_allocator].count, 1);
+    ASSERT_EQ(timings[phase::sync_segment].count, 1);
+    ASSERT_EQ(timings[phase::sync_segment].last_ns,
+              timings[phase::sync_segment].total_ns);
+    ASSERT_GE(timings[phase::sync_segment].max_ns,
+              timings[phase::sync_segment].last_ns);
+
+    ASSERT_TRUE(manager.snapshot(dir_path().string() + "_snapshot"));
+    ASSERT_TRUE(manager.get_phase_timings(&timings));
+    ASSERT_EQ(timings[phase::snapshot].count, 1);
+    ASSERT_EQ(timings[phase::copy_segment].count, 1);
+    ASSERT_EQ(timings[phase::copy_management_data].count, 1);
+    ASSERT_EQ(timings[phase::serialize_management_data].count, 1);
+    ASSERT_EQ(timings[phase::serialize_named_object_directory].count, 1);
+    ASSERT_EQ(timings[phase::serialize_segment_allocator].count, 1);
+    ASSERT_GE(timings[phase::snapshot].total_ns,
+              timings[phase::copy_segment].total_ns);
+    ASSERT_NE(timings.to_json().find("\"copy_segment\":{\"count\":1"),
+              std::string::npos);
+  }
+  manager_type::set_phase_timing_log_level(std::nullopt);
+  manager_type::remove(dir_path().string() + "_snapshot");
+}
+
+TEST(ManagerTest, PageStatistics) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+  const std::size_t size = k_chunk_size * 4;
+  auto *const a = manager.construct<char>("a")[size]();
+  std::memset(a, 1, size);
+
+  manager_type::page_statistics_type stats;
+  ASSERT_TRUE(manager.get_page_statistics(&stats, true));
+  ASSERT_GT(stats.page_size, 0);
+  ASSERT_EQ(stats.chunk_size, k_chunk_size);
+  ASSERT_GE(stats.total.resident_bytes, size);
+  ASSERT_GE(stats.total.faulted_bytes, size);
+  ASSERT_EQ(stats.objects.size(), 1);
+  ASSERT_EQ(stats.objects[0].name, "a");
+  ASSERT_EQ(stats.objects[0].bytes, size);
+  ASSERT_EQ(stats.objects[0].pages.resident_bytes, size);
+  ASSERT_EQ(stats.objects[0].pages.faulted_bytes, size);
+  if (stats.dirty_pages_available) {
+    ASSERT_EQ(stats.objects[0].pages.dirty_bytes, size);
+  }
+  std::size_t chunk_resident_bytes = 0;
+  for (const auto &chunk : stats.chunks) {
+    chunk_resident_bytes += chunk.pages.resident_bytes;
+  }
+  std::size_t bin_resident_bytes = 0;
+  for (const auto &bin : stats.bins) {
+    ASSERT_GT(bin.num_chunks, 0);
+    bin_resident_bytes += bin.pages.resident_bytes;
+  }
+  ASSERT_EQ(chunk_resident_bytes, bin_resident_bytes);
+  ASSERT_GE(chunk_resident_bytes, size);
+
+  // The pages are not faulted again
+  ASSERT_TRUE(manager.get_page_statistics(&stats, true));
+  ASSERT_EQ(stats.objects[0].pages.resident_bytes, size);
+  ASSERT_EQ(stats.objects[0].pages.faulted_bytes, 0);
+
+  auto *const b = manager.construct<char>(metall::unique_instance)[size]();
+  std::memset(b, 1, size);
+  ASSERT_TRUE(manager.get_page_statistics(&stats, true));
+  ASSERT_EQ(stats.objects.size(), 2);
+  ASSERT_EQ(stats.objects[0].pages.faulted_bytes, 0);
+  // The pages of 'b' can have been read ahead when 'a' was written
+  ASSERT_EQ(stats.objects[1].pages.resident_bytes, size);
+  ASSERT_NE(stats.to_json().find("\"name\":\"a\""), std::string::npos);
+
+  ASSERT_TRUE(manager.get_page_statistics(&stats));
+  ASSERT_TRUE(stats.objects.empty());
+}
+
+TEST(ManagerTest, AllocationTrace) {
+  using metall::kernel::allocation_trace_op;
+  manager_type::remove(dir_path());
+  const auto trace_path = dir_path().string() + "_allocation.trace";
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    ASSERT_NE(manager.allocate(8), nullptr);  // Not traced
+
+#ifdef METALL_USE_ALLOCATION_TRACE
+    ASSERT_TRUE(manager.start_allocation_trace(trace_path));
+    auto *const a = manager.allocate(16);
+    auto *const b = manager.allocate_aligned(1024, 512);
+    void *many[4];
+    ASSERT_EQ(manager.allocate_many(64, 4, many), 4);
+    std::thread([&manager, a]() { manager.deallocate(a, 16); }).join();
+    manager.deallocate(b);
+    manager.deallocate_many(many, 4);
+    ASSERT_TRUE(manager.stop_allocation_trace());
+    ASSERT_NE(manager.allocate(8), nullptr);  // Not traced
+#else
+    ASSERT_FALSE(manager.start_allocation_trace(trace_path));
+#endif
+  }
+
+#ifdef METALL_USE_ALLOCATION_TRACE
+  metall::kernel::allocation_trace_header header;
+  std::vector<metall::kernel::allocation_trace_record> records;
+  ASSERT_TRUE(
+      metall::kernel::read_allocation_trace(trace_path, &header, &records));
+  ASSERT_EQ(header.chunk_size, manager_type::chunk_size());
+  ASSERT_EQ(records.size(), 12);
+
+  ASSERT_EQ(records[0].op, allocation_trace_op::allocate);
+  ASSERT_EQ(records[0].size, 16);
+  ASSERT_EQ(records[1].op, allocation_trace_op::allocate);
+  ASSERT_EQ(records[1].size, 1024);
+  ASSERT_EQ(records[1].alignment, 512);
+  ASSERT_EQ(records[1].offset % 512, 0);
+  for (int i = 2; i < 6; ++i) {
+    ASSERT_EQ(records[i].op, allocation_trace_op::allocate);
+    ASSERT_EQ(records[i].size, 64);
+  }
+  // Deallocated by another thread
+  ASSERT_EQ(records[6].op, allocation_trace_op::deallocate);
+  ASSERT_EQ(records[6].offset, records[0].offset);
+  ASSERT_EQ(records[6].size, 16);
+  ASSERT_NE(records[6].thread, records[0].thread);
+  ASSERT_EQ(records[7].offset, records[1].offset);
+  ASSERT_EQ(records[7].size, 0);
+  for (int i = 8; i < 12; ++i) {
+    ASSERT_EQ(records[i].op, allocation_trace_op::deallocate);
+    ASSERT_EQ(records[i].offset, records[i - 6].offset);
+  }
+  for (std::size_t i = 1; i < records.size(); ++i) {
+    ASSERT_GE(records[i].time_ns, records[i - 1].time_ns);
+  }
+#endif
+  fs::remove(trace_path);
+}
+
+#ifdef METALL_USE_TRACEPOINTS
+std::atomic<std::size_t> traced_events[32];
+
+TEST(ManagerTest, Tracepoints) {
+  using event = metall::tracing::event;
+  metall::tracing::set_callback([](const event e, uint64_t, uint64_t) {
+    ++traced_events[static_cast<std::size_t>(e)];
+  });
+  const auto count = [](const event e) {
+    return traced_events[static_cast<std::size_t>(e)].load();
+  };
+
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(),
+                         METALL_SEGMENT_BLOCK_SIZE * 4);
+    auto *const large = manager.allocate(METALL_SEGMENT_BLOCK_SIZE * 2);
+    ASSERT_NE(large, nullptr);
+    ASSERT_GT(count(event::segment_extend), 0);
+    ASSERT_GT(count(event::chunk_insert), 0);
+
+    ASSERT_NE(manager.allocate(8), nullptr);
+#ifndef METALL_DISABLE_OBJECT_CACHE
+    ASSERT_GT(count(event::cache_refill), 0);
+#endif
+
+    manager.deallocate(large);
+    ASSERT_GT(count(event::chunk_erase), 0);
+
+    manager.flush();
+    ASSERT_GT(count(event::sync_begin), 0);
+    ASSERT_EQ(count(event::sync_begin), count(event::sync_end));
+    ASSERT_GT(count(event::management_data_serialize_begin), 0);
+    ASSERT_EQ(count(event::management_data_serialize_begin),
+              count(event::management_data_serialize_end));
+
+    ASSERT_TRUE(manager.snapshot(dir_path().string() + "_snapshot"));
+    ASSERT_EQ(count(event::segment_copy_begin), 1);
+    ASSERT_EQ(count(event::segment_copy_end), 1);
+  }
+  manager_type::remove(dir_path().string() + "_snapshot");
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_EQ(count(event::segment_map_begin), 1);
+    ASSERT_EQ(count(event::segment_map_end), 1);
+    ASSERT_EQ(count(event::management_data_deserialize_begin), 1);
+    ASSERT_EQ(count(event::management_data_deserialize_end), 1);
+  }
+  metall::tracing::set_callback(nullptr);
+}
+#endif
+
+TEST(ManagerTest, AllocateMany) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+
+  for (const std::size_t size : {std::size_t(8), std::size_t(4096),
+                                 std::size_t(k_chunk_size)}) {
+    // More than the number of objects a chunk can hold for small sizes
+    const std::size_t num_allocates = (size < k_chunk_size) ? 3000 : 8;
+    std::vector<void *> addrs(num_allocates, nullptr);
+    ASSERT_EQ(manager.allocate_many(size, num_allocates, addrs.data()),
+              num_allocates);
+
+    std::set<char *> unique_addrs;
+    for (auto *addr : addrs) {
+      ASSERT_NE(addr, nullptr);
+      unique_addrs.insert(static_cast<char *>(addr));
+      std::memset(addr, 1, size);
+    }
+    ASSERT_EQ(unique_addrs.size(), num_allocates);
+    for (auto itr = unique_addrs.begin(); std::next(itr) != unique_addrs.end();
+         ++itr) {
+      ASSERT_LE(*itr + size, *std::next(itr));
+    }
+
+    // Mix pointers allocated by allocate()
+    addrs.push_back(manager.allocate(size));
+    addrs.push_back(nullptr);
+    manager.deallocate_many(addrs.data(), addrs.size());
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+
+  ASSERT_EQ(manager.allocate_many(8, 0, nullptr), 0);
+  void *addr = nullptr;
+  ASSERT_EQ(manager.allocate_many(0, 1, &addr), 0);
+  ASSERT_EQ(addr, nullptr);
+}
+
+TEST(ManagerTest, ReopenWithoutAllocation) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), 1UL << 30UL);
+    auto *addr = static_cast<int *>(manager.allocate(sizeof(int)));
+    *addr = 10;
+    manager.construct<metall::offset_ptr<int>>("ptr")(addr);
+    manager.construct<char>("large")[k_chunk_size * 2]();
+  }
+
+  // Open and close without touching the allocator data
+  {
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_NE(manager.find<metall::offset_ptr<int>>("ptr").first, nullptr);
+  }
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    auto *ptr = manager.find<metall::offset_ptr<int>>("ptr").first;
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(**ptr, 10);
+  }
+
+  // The allocator data must be still valid
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *ptr = manager.find<metall::offset_ptr<int>>("ptr").first;
+    ASSERT_NE(ptr, nullptr);
+    manager.deallocate(ptr->get());
+    ASSERT_TRUE(manager.destroy<metall::offset_ptr<int>>("ptr"));
+    ASSERT_FALSE(manager.all_memory_deallocated());
+    ASSERT_TRUE(manager.destroy<char>("large"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(ManagerTest, AlignedAllocation) {
+  {
+    manager_type::remove(dir_path());
+    manager_type manager(metall::create_only, dir_path());
+    const std::size_t page_size = metall::mtlldetail::get_page_size();
+
+    for (std::size_t alignment = k_min_object_size; alignment <= page_size;
+         alignment *= 2) {
+      for (std::size_t sz = alignment; sz <= page_size * 2;
+           sz += alignment) {
+        auto addr1 =
+            static_cast<char *>(manager.allocate_aligned(sz, alignment));
+        ASSERT_EQ(reinterpret_cast<uint64_t>(addr1) % alignment, 0);
+
+        auto addr2 =
+            static_cast<char *>(manager.allocate_aligned(sz, alignment));
+        ASSERT_EQ(reinterpret_cast<uint64_t>(addr2) % alignment, 0);
+
+        auto addr3 =
+            static_cast<char *>(manager.allocate_aligned(sz, alignment));
+        ASSERT_EQ(reinterpret_cast<uint64_t>(addr3) % alignment, 0);
+
+        manager.deallocate(addr1);
+        manager.deallocate(addr2);
+        manager.deallocate(addr3);
+      }
+
+      {
+        // Invalid argument
+        // Alignment is not a power of 2
+        auto addr1 = static_cast<char *>(
+            manager.allocate_aligned(alignment + 1, alignment + 1));
+        ASSERT_EQ(addr1, nullptr);
+
+        // Invalid arguments
+        // Size is not a multiple of alignment
+        auto addr2 = static_cast<char *>(
+            manager.allocate_aligned(alignment + 1, alignment));
+        ASSERT_EQ(addr2, nullptr);
+      }
+    }
+
+    {
+      // Invalid argument
+      // Alignment is smaller than k_min_object_size
+      auto addr1 = static_cast<char *>(manager.allocate_aligned(8, 1));
+      ASSERT_EQ(addr1, nullptr);
+    }
+  }
+}
+
+TEST(ManagerTest, LargeAlignedAllocation) {
+  // The offsets from the segment and the sizes
+  std::vector<std::pair<std::ptrdiff_t, std::size_t>> allocations;
+  {
+    manager_type::remove(dir_path());
+    manager_type manager(metall::create_only, dir_path());
+    const auto *const base = static_cast<const char *>(manager.get_address());
+
+    // Makes the next chunk unaligned
+    manager.allocate(k_chunk_size);
+    for (const std::size_t alignment : {k_chunk_size * 4, k_chunk_size * 64}) {
+      // The size does not have to be a multiple of the alignment
+      for (const std::size_t sz : {std::size_t(8), k_chunk_size * 3}) {
+        auto *const addr =
+            static_cast<char *>(manager.allocate_aligned(sz, alignment));
+        ASSERT_NE(addr, nullptr);
+        ASSERT_EQ(reinterpret_cast<uint64_t>(addr) % alignment, 0);
+        std::memset(addr, int(allocations.size()), sz);
+        allocations.emplace_back(addr - base, sz);
+      }
+    }
+
+    // The chunks skipped for the alignment are reused
+    auto *const addr = static_cast<char *>(manager.allocate(k_chunk_size));
+    ASSERT_LT(addr - base, allocations.front().first);
+    manager.deallocate(addr);
+
+    ASSERT_EQ(manager.allocate_aligned(8, 3 * k_chunk_size), nullptr);
+  }
+
+  {
+    manager_type manager(metall::open_only, dir_path());
+    for (std::size_t i = 0; i < allocations.size(); ++i) {
+      const auto [offset, sz] = allocations[i];
+      const auto *const addr =
+          static_cast<const char *>(manager.get_address()) + offset;
+      ASSERT_EQ(reinterpret_cast<uint64_t>(addr) % (k_chunk_size * 4), 0);
+      for (std::size_t k = 0; k < sz; ++k) ASSERT_EQ(addr[k], char(i));
+      manager.deallocate(const_cast<char *>(addr));
+    }
+  }
+}
+
+TEST(ManagerTest, PlacementHint) {
+  if constexpr (manager_type::num_placement_hints() < 2) {
+    GTEST_SKIP();
+  }
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path());
+  const auto *const base = static_cast<const char *>(manager.get_address());
+  const auto chunk_no = [base](const void *const addr) {
+    return (static_cast<const char *>(addr) - base) / k_chunk_size;
+  };
+
+  // The chunks of each hint and of no hint
+  std::vector<std::set<std::size_t>> chunks(3);
+  std::vector<void *> addrs;
+  for (int i = 0; i < 10000; ++i) {
+    auto *const cold = manager.allocate(64, metall::placement_hint{0});
+    auto *const hot = manager.allocate(64, metall::placement_hint{1});
+    auto *const other = manager.allocate(64);
+    ASSERT_NE(cold, nullptr);
+    ASSERT_NE(hot, nullptr);
+    ASSERT_NE(other, nullptr);
+    chunks[0].insert(chunk_no(cold));
+    chunks[1].insert(chunk_no(hot));
+    chunks[2].insert(chunk_no(other));
+    addrs.insert(addrs.end(), {cold, hot, other});
+  }
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    for (std::size_t k = i + 1; k < chunks.size(); ++k) {
+      for (const auto c : chunks[i]) ASSERT_EQ(chunks[k].count(c), 0);
+    }
+  }
+
+  // The objects freed and allocated again with the same hint stay in the
+  // chunks of the hint
+  for (std::size_t i = 0; i < addrs.size(); i += 6) {
+    manager.deallocate(addrs[i]);
+  }
+  {
+    manager_type::placement_hint_scope scope(metall::placement_hint{0});
+    for (int i = 0; i < 1000; ++i) {
+      auto *const value =
+          manager.construct<std::array<char, 64>>(metall::anonymous_instance)();
+      ASSERT_EQ(chunks[0].count(chunk_no(value)), 1);
+      for (int k = 0; k < 16; ++k) {
+        ASSERT_EQ(chunks[0].count(chunk_no(manager.allocate(64))), 1);
+      }
+    }
+  }
+  ASSERT_EQ(chunks[0].count(chunk_no(manager.allocate(64))), 0);
+
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  const metall::placement_hint invalid_hint{
+      manager_type::num_placement_hints()};
+  ASSERT_EQ(manager.allocate(64, invalid_hint), nullptr);
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+  ASSERT_TRUE(manager.check_sanity());
+}
+
+TEST(ManagerTest, SegmentSizeLimits) {
+  constexpr std::size_t k_block_size = METALL_SEGMENT_BLOCK_SIZE;
+  metall::manager_options options;
+  options.segment_size_soft_limit = k_block_size;
+  options.segment_size_hard_limit = k_block_size * 2;
+
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path(), options);
+  std::vector<std::pair<metall::segment_limit, std::size_t>> events;
+  ASSERT_TRUE(manager.set_segment_limit_handler(
+      [&events](const metall::segment_limit limit, const std::size_t size) {
+        events.emplace_back(limit, size);
+      }));
+
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  std::vector<void *> addrs;
+  while (auto *const addr = manager.allocate(k_chunk_size * 4)) {
+    addrs.push_back(addr);
+    ASSERT_LE(addrs.size(), k_block_size * 2 / (k_chunk_size * 4));
+  }
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+  ASSERT_FALSE(addrs.empty());
+  ASSERT_EQ(events.size(), 2);
+  ASSERT_EQ(events[0].first, metall::segment_limit::soft);
+  ASSERT_GT(events[0].second, k_block_size);
+  ASSERT_EQ(events[1].first, metall::segment_limit::hard);
+  ASSERT_GT(events[1].second, k_block_size * 2);
+
+  // The manager is still usable
+  ASSERT_TRUE(manager.check_sanity());
+  manager.deallocate(addrs.back());
+  addrs.back() = manager.allocate(k_chunk_size * 4);
+  ASSERT_NE(addrs.back(), nullptr);
+
+  ASSERT_TRUE(manager.set_segment_size_limits(0, 0));
+  addrs.push_back(manager.allocate(k_chunk_size * 4));
+  ASSERT_NE(addrs.back(), nullptr);
+  for (auto *const addr : addrs) manager.deallocate(addr);
+  ASSERT_TRUE(manager.all_memory_deallocated());
+}
+
+TEST(ManagerTest, Flush) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path());
+
+  manager.construct<int>("int")(10);
+
+  manager.flush();
+
+  ASSERT_FALSE(manager_type::consistent(dir_path()));
+}
+
+TEST(ManagerTest, FlushAsync) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[1024](0);
+    for (int i = 0; i < 1024; ++i) array[i] = i;
+
+    auto future = manager.flush_async(2);
+    ASSERT_TRUE(future.valid());
+    // Can keep writing data while the flush is running
+    for (int i = 0; i < 1024; ++i) array[i] += 1;
+    ASSERT_TRUE(future.get());
+    ASSERT_FALSE(manager_type::consistent(dir_path()));
+
+    ASSERT_TRUE(manager.flush_async().get());
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    for (int i = 0; i < 1024; ++i) ASSERT_EQ(array[i], i + 1);
+  }
+}
+
+TEST(ManagerTest, Checkpointing) {
+  manager_type::remove(dir_path());
+  const std::size_t num_items = 1 << 21;  // 8 MiB
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[num_items](0);
+    manager.flush();
+
+    std::mutex mutex;
+    std::vector<manager_type::checkpoint_report_type> reports;
+    const auto wait_for_report = [&]() {
+      for (int i = 0; i < 1000; ++i) {
+        {
+          std::lock_guard<std::mutex> guard(mutex);
+          if (!reports.empty()) return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      return false;
+    };
+
+    manager_type::checkpoint_options_type options;
+    options.interval = std::chrono::milliseconds(10);
+    options.num_max_threads = 2;
+    options.on_checkpoint = [&](const auto &report) {
+      std::lock_guard<std::mutex> guard(mutex);
+      reports.push_back(report);
+    };
+    ASSERT_TRUE(manager.start_checkpointing(options));
+    ASSERT_TRUE(manager.checkpointing());
+    for (std::size_t i = 0; i < num_items; ++i) array[i] = int(i);
+    ASSERT_TRUE(wait_for_report());
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      ASSERT_GT(reports.front().num_dirty_bytes, 0);
+      ASSERT_GT(reports.front().num_written_bytes, 0);
+      ASSERT_GT(reports.front().latency.count(), 0);
+      ASSERT_TRUE(reports.front().succeeded);
+      reports.clear();
+    }
+
+    // Capped at 4 MiB/s; the bucket has one second of writes
+    options.max_bytes_per_second = 1 << 22;
+    options.slice_size = 1 << 20;
+    ASSERT_TRUE(manager.start_checkpointing(options));  // Restarts
+    for (std::size_t i = 0; i < num_items; ++i) array[i] += 1;
+    ASSERT_TRUE(wait_for_report());
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (reports.front().num_dirty_bytes > (1 << 22)) {
+        ASSERT_GT(reports.front().throttled_time.count(), 0);
+      }
+      reports.clear();
+    }
+
+    // Not enough dirty bytes
+    options.dirty_bytes_threshold = std::size_t(1) << 40;
+    options.max_bytes_per_second = 0;
+    ASSERT_TRUE(manager.start_checkpointing(options));
+    array[0] = -1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    manager.stop_checkpointing();
+    ASSERT_FALSE(manager.checkpointing());
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      ASSERT_TRUE(reports.empty());
+    }
+
+    // Stopped by closing
+    options.dirty_bytes_threshold = 0;
+    ASSERT_TRUE(manager.start_checkpointing(options));
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    ASSERT_EQ(array[0], -1);
+    for (std::size_t i = 1; i < num_items; ++i) ASSERT_EQ(array[i], int(i) + 1);
+    ASSERT_FALSE(manager.start_checkpointing());
+  }
+}
+
+// New blocks are mapped while the checkpointing reads the block table
+TEST(ManagerTest, CheckpointingWhileExtending) {
+  manager_type::remove(dir_path());
+  constexpr std::size_t k_block_size = METALL_SEGMENT_BLOCK_SIZE;
+  constexpr int k_num_blocks = 8;
+  std::vector<manager_type::difference_type> offsets;
+  {
+    manager_type manager(metall::create_only, dir_path());
+    std::atomic<int> num_checkpoints{0};
+    manager_type::checkpoint_options_type options;
+    options.interval = std::chrono::milliseconds(1);
+    options.on_checkpoint = [&num_checkpoints](const auto &report) {
+      if (report.succeeded) ++num_checkpoints;
+    };
+    ASSERT_TRUE(manager.start_checkpointing(options));
+    for (int i = 0; i < k_num_blocks; ++i) {
+      auto *const buf = static_cast<char *>(manager.allocate(k_block_size));
+      ASSERT_NE(buf, nullptr);
+      for (std::size_t pos = 0; pos < k_block_size; pos += 1 << 20) {
+        buf[pos] = char('a' + i);
+      }
+      offsets.push_back(buf - static_cast<const char *>(manager.get_address()));
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    for (int i = 0; i < 1000 && num_checkpoints < 2; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_GE(num_checkpoints.load(), 2);
+    manager.stop_checkpointing();
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const segment =
+        static_cast<const char *>(manager.get_address());
+    for (int i = 0; i < k_num_blocks; ++i) {
+      for (std::size_t pos = 0; pos < k_block_size; pos += 1 << 20) {
+        ASSERT_EQ(segment[offsets[i] + pos], char('a' + i));
+      }
+    }
+  }
+}
+
+TEST(ManagerTest, Prefetch) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[1 << 20](0);
+    for (int i = 0; i < (1 << 20); ++i) array[i] = i;
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    ASSERT_TRUE(manager.prefetch(array, sizeof(int) * (1 << 20)));
+    ASSERT_TRUE(manager.prefetch());
+    ASSERT_TRUE(manager.warm_up<int>("array"));
+    ASSERT_FALSE(manager.warm_up<int>("not_exist"));
+
+    int dummy = 0;
+    ASSERT_FALSE(manager.prefetch(&dummy, sizeof(dummy)));
+
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i);
+  }
+}
+
+TEST(ManagerTest, OpenCopyOnWrite) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    manager.construct<int>("int")(10);
+  }
+
+  const auto count_files = []() {
+    std::size_t count = 0;
+    for ([[maybe_unused]] const auto &entry :
+         fs::recursive_directory_iterator(dir_path())) {
+      ++count;
+    }
+    return count;
+  };
+  const auto num_files = count_files();
+
+  // Two managers do not see each other's changes
+  {
+    manager_type manager0(metall::open_copy_on_write, dir_path());
+    manager_type manager1(metall::open_copy_on_write, dir_path());
+    ASSERT_TRUE(manager0.check_sanity());
+    ASSERT_TRUE(manager0.copy_on_write());
+    ASSERT_FALSE(manager0.read_only());
+
+    auto *const n0 = manager0.find<int>("int").first;
+    auto *const n1 = manager1.find<int>("int").first;
+    ASSERT_NE(n0, nullptr);
+    ASSERT_NE(n1, nullptr);
+    *n0 = 20;
+    ASSERT_EQ(*n1, 10);
+
+    // Extends the segment beyond the block files
+    const std::size_t large_size = METALL_SEGMENT_BLOCK_SIZE * 2;
+    auto *const buf = static_cast<char *>(manager0.allocate(large_size));
+    ASSERT_NE(buf, nullptr);
+    std::memset(buf, 1, large_size);
+    manager0.deallocate(buf);
+    ASSERT_NE(manager0.construct<int>("new")(30), nullptr);
+    ASSERT_TRUE(manager0.destroy<int>("int"));
+    manager0.flush();
+
+    ASSERT_FALSE(manager0.snapshot(test_utility::make_test_path("snapshot")));
+  }
+
+  // Nothing has been written back
+  ASSERT_TRUE(manager_type::consistent(dir_path()));
+  ASSERT_EQ(count_files(), num_files);
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_FALSE(manager.copy_on_write());
+    ASSERT_EQ(*(manager.find<int>("int").first), 10);
+    ASSERT_EQ(manager.find<int>("new").first, nullptr);
+  }
+}
+
+TEST(ManagerTest, Pin) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[1 << 16](1);
+    ASSERT_TRUE(manager.pin<int>("array"));
+    ASSERT_GE(manager.pinned_size(), sizeof(int) * (1 << 16));
+    ASSERT_FALSE(manager.pin<int>("not_exist"));
+
+    int dummy = 0;
+    ASSERT_FALSE(manager.pin(&dummy, sizeof(dummy)));
+
+    // The pages are still pinned after a flush
+    manager.flush();
+    for (int i = 0; i < (1 << 16); ++i) ASSERT_EQ(array[i], 1);
+    ASSERT_TRUE(manager.unpin<int>("array"));
+    ASSERT_EQ(manager.pinned_size(), 0);
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_TRUE(manager.pin(array, sizeof(int) * (1 << 16)));
+    for (int i = 0; i < (1 << 16); ++i) ASSERT_EQ(array[i], 1);
+  }
+}
+
+TEST(ManagerTest, GPU) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path());
+  const int length = 1 << 20;
+  auto *const array = manager.construct<int>("array")[length]();
+  for (int i = 0; i < length; ++i) array[i] = i;
+  int dummy = 0;
+
+#ifdef METALL_ENABLE_CUDA
+  int num_devices = 0;
+  if (cudaGetDeviceCount(&num_devices) != cudaSuccess || num_devices == 0) {
+    GTEST_SKIP() << "No CUDA device";
+  }
+
+  ASSERT_TRUE(manager.gpu_register<int>("array"));
+  ASSERT_FALSE(manager.gpu_register(array + 1, sizeof(int)));  // Overlaps
+  ASSERT_FALSE(manager.gpu_register(&dummy, sizeof(dummy)));
+
+  void *buf = nullptr;
+  ASSERT_EQ(cudaMalloc(&buf, sizeof(int) * length), cudaSuccess);
+  // Loads the dirty pages and the pages written back to the files alike
+  manager.flush();
+  array[length - 1] = -1;
+  ASSERT_TRUE(manager.load_to_device<int>("array", buf));
+  std::vector<int> copy(length);
+  ASSERT_EQ(cudaMemcpy(copy.data(), buf, sizeof(int) * length,
+                       cudaMemcpyDeviceToHost),
+            cudaSuccess);
+  for (int i = 0; i < length - 1; ++i) ASSERT_EQ(copy[i], i);
+  ASSERT_EQ(copy[length - 1], -1);
+  cudaFree(buf);
+
+  ASSERT_TRUE(manager.gpu_unregister<int>("array"));
+  ASSERT_FALSE(manager.gpu_unregister<int>("array"));
+#else
+  // Metall is built without CUDA
+  ASSERT_FALSE(manager.gpu_register<int>("array"));
+  ASSERT_FALSE(manager.gpu_unregister<int>("array"));
+  ASSERT_FALSE(manager.load_to_device<int>("array", &dummy));
+  ASSERT_TRUE(manager.check_sanity());
+#endif
+  ASSERT_FALSE(manager.gpu_register<int>("not_exist"));
+}
+
+TEST(ManagerTest, Persist) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[1 << 16](1);
+    for (int i = 0; i < (1 << 16); i += 2) array[i] = 2;
+    ASSERT_TRUE(manager.persist(array, sizeof(int) * (1 << 16)));
+    ASSERT_TRUE(manager.persist(array + 1, 1));
+    ASSERT_TRUE(manager.persist(array, 0));
+
+    int dummy = 0;
+    ASSERT_FALSE(manager.persist(&dummy, sizeof(dummy)));
+#ifndef METALL_USE_DAX
+    ASSERT_FALSE(manager.dax_mapped());
+#endif
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    for (int i = 0; i < (1 << 16); ++i) ASSERT_EQ(array[i], 2 - i % 2);
+    // Nothing to persist in the read-only mode
+    ASSERT_TRUE(manager.persist(array, sizeof(int)));
+  }
+}
+
+TEST(ManagerTest, DirectIOSnapshot) {
+  metall::manager_options options;
+  options.direct_io_snapshot = true;
+  const auto snapshot_path = test_utility::make_test_path("snapshot");
+  manager_type::remove(dir_path());
+  manager_type::remove(snapshot_path);
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    auto *const array = manager.construct<int>("array")[1 << 20](1);
+    for (int i = 0; i < (1 << 20); i += 3) array[i] = i;
+    ASSERT_TRUE(manager.snapshot(snapshot_path, false));
+  }
+
+  {
+    manager_type manager(metall::open_read_only, snapshot_path);
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i % 3 ? 1 : i);
+  }
+  ASSERT_TRUE(manager_type::remove(snapshot_path));
+}
+
+bool has_block_file(const std::filesystem::path &dir) {
+  if (!std::filesystem::exists(dir)) return false;
+  for (const auto &entry : std::filesystem::recursive_directory_iterator(dir)) {
+    if (entry.path().filename().string().rfind("block-", 0) == 0) return true;
+  }
+  return false;
+}
+
+TEST(ManagerTest, SeparateSegmentPath) {
+  metall::manager_options options;
+  options.segment_path = test_utility::make_test_path("segment");
+  const auto snapshot_path = test_utility::make_test_path("snapshot");
+  manager_type::remove(dir_path());
+  manager_type::remove(snapshot_path);
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    auto *const array = manager.construct<int>("array")[1 << 20](1);
+    for (int i = 0; i < (1 << 20); i += 3) array[i] = i;
+  }
+  ASSERT_TRUE(has_block_file(options.segment_path));
+  ASSERT_FALSE(has_block_file(dir_path()));
+
+  // The location is recorded in the datastore
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i % 3 ? 1 : i);
+    array[1] = -1;
+    ASSERT_TRUE(manager.snapshot(snapshot_path));
+  }
+  ASSERT_TRUE(manager_type::consistent(dir_path()));
+
+  // The snapshot has its own segment
+  ASSERT_TRUE(has_block_file(snapshot_path));
+  ASSERT_TRUE(manager_type::remove(dir_path()));
+  ASSERT_FALSE(has_block_file(options.segment_path));
+  {
+    manager_type manager(metall::open_read_only, snapshot_path);
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    ASSERT_EQ(array[1], -1);
+    ASSERT_EQ(array[3], 3);
+  }
+  ASSERT_TRUE(manager_type::remove(snapshot_path));
+}
+
+std::size_t allocated_block_bytes(const std::filesystem::path &dir) {
+  std::size_t bytes = 0;
+  for (const auto &entry : std::filesystem::recursive_directory_iterator(dir)) {
+    if (entry.path().filename().string().rfind("block-", 0) != 0) continue;
+    struct stat st;
+    if (::stat(entry.path().c_str(), &st) == 0) bytes += st.st_blocks * 512;
+  }
+  return bytes;
+}
+
+TEST(ManagerTest, RepackCopy) {
+  const auto copy_path = test_utility::make_test_path("repack");
+  manager_type::remove(dir_path());
+  manager_type::remove(copy_path);
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const a = manager.construct<int>("a")[1 << 20](1);
+    auto *const b = manager.construct<int>("b")[1 << 20](2);
+    manager.construct<int>("c")[1 << 20](3);
+    for (int i = 0; i < (1 << 20); i += 3) a[i] = i;
+    b[0] = -1;
+    ASSERT_TRUE(manager.destroy<int>("c"));
+  }
+  ASSERT_TRUE(manager_type::repack_copy(dir_path(), copy_path));
+  ASSERT_TRUE(manager_type::consistent(copy_path));
+  ASSERT_LE(allocated_block_bytes(copy_path),
+            allocated_block_bytes(dir_path()));
+
+  {
+    manager_type manager(metall::open_only, copy_path);
+    ASSERT_EQ(manager.get_uuid(), manager_type::get_uuid(dir_path()));
+    const auto *const a = manager.find<int>("a").first;
+    const auto *const b = manager.find<int>("b").first;
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    ASSERT_EQ(manager.find<int>("c").first, nullptr);
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(a[i], i % 3 ? 1 : i);
+    ASSERT_EQ(b[0], -1);
+    for (int i = 1; i < (1 << 20); ++i) ASSERT_EQ(b[i], 2);
+
+    // The free chunks are usable
+    auto *const c = manager.construct<int>("c")[1 << 20](4);
+    ASSERT_NE(c, nullptr);
+    ASSERT_EQ(c[(1 << 20) - 1], 4);
+  }
+  ASSERT_TRUE(manager_type::remove(copy_path));
+}
+
+TEST(ManagerTest, AccessPattern) {
+  using pattern = manager_type::access_pattern_type;
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const table = manager.construct<int>("table")[1 << 20](1);
+    auto *const array = manager.construct<int>("array")[1 << 20](2);
+    ASSERT_TRUE(manager.set_access_pattern(table, pattern::random));
+    ASSERT_TRUE(manager.set_access_pattern(array, pattern::sequential));
+    ASSERT_EQ(manager.get_access_pattern(table), pattern::random);
+    ASSERT_EQ(manager.get_access_pattern(array), pattern::sequential);
+    ASSERT_FALSE(manager.set_access_pattern(table + 1, pattern::random));
+
+    auto *const buf = manager.allocate(1 << 20);
+    ASSERT_TRUE(
+        manager.advise_access_pattern(buf, 1 << 20, pattern::will_need));
+    ASSERT_TRUE(
+        manager.advise_access_pattern(buf, 1 << 20, pattern::dont_need));
+    ASSERT_EQ(manager.get_access_pattern(buf), pattern::normal);
+    manager.deallocate(buf);
+  }
+
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const table = manager.find<int>("table").first;
+    auto *const array = manager.find<int>("array").first;
+    ASSERT_EQ(manager.get_access_pattern(table), pattern::random);
+    ASSERT_EQ(manager.get_access_pattern(array), pattern::sequential);
+    // The data is not lost by dont_need
+    ASSERT_TRUE(manager.set_access_pattern(table, pattern::dont_need));
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(table[i], 1);
+    ASSERT_TRUE(manager.destroy<int>("table"));
+    ASSERT_TRUE(manager.set_access_pattern(array, pattern::normal));
+  }
+
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_EQ(manager.get_access_pattern(array), pattern::normal);
+    ASSERT_TRUE(manager.set_access_pattern(array, pattern::sequential));
+    ASSERT_EQ(manager.get_access_pattern(array), pattern::normal);
+  }
+}
+
+TEST(ManagerTest, WriteBackCache) {
+  metall::manager_options options;
+  options.write_back_cache = true;
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    auto *const array = manager.construct<int>("array")[1 << 20](1);
+    for (int i = 0; i < (1 << 20); i += 3) array[i] = i;
+    ASSERT_FALSE(manager.publish());
+    manager.flush();
+    for (int i = 0; i < (1 << 20); i += 3) array[i] = -i;
+  }
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    const auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i % 3 ? 1 : -i);
+  }
+}
+
+TEST(ManagerTest, VolatileSegment) {
+  metall::manager_options options;
+  options.volatile_segment = true;
+  options.volatile_memory_budget = 1;
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    ASSERT_TRUE(manager.volatile_segment());
+    auto *const array = manager.construct<int>("array")[1 << 20](1);
+    for (int i = 0; i < (1 << 20); i += 3) array[i] = i;
+    ASSERT_FALSE(manager.snapshot(test_utility::make_test_path("snapshot")));
+    // Spills the segment to the datastore directory
+    manager.flush();
+    std::size_t num_spilled_bytes = 0;
+    ASSERT_TRUE(manager.spill(0, &num_spilled_bytes));
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i % 3 ? 1 : i);
+    ASSERT_EQ(manager.find<int>("array").first, array);
+  }
+  // A volatile datastore is removed when it is closed
+  ASSERT_FALSE(manager_type::consistent(dir_path()));
+  ASSERT_TRUE(std::filesystem::is_empty(dir_path()));
+
+  {
+    manager_type manager(metall::create_only, dir_path());
+    ASSERT_FALSE(manager.volatile_segment());
+    ASSERT_FALSE(manager.spill(0));
+  }
+  ASSERT_TRUE(manager_type::consistent(dir_path()));
+}
+
+TEST(ManagerTest, MemoryTiering) {
+  manager_type::remove(dir_path());
+  manager_type manager(metall::create_only, dir_path());
+  constexpr std::size_t length = manager_type::chunk_size() / sizeof(int) * 4;
+  auto *const array = manager.construct<int>("array")[length](1);
+
+  int dummy = 0;
+  ASSERT_FALSE(manager.bind_to_numa_node(&dummy, sizeof(dummy), 0));
+#if METALL_SUPPORT_NUMA_POLICY
+  ASSERT_TRUE(manager.bind_to_numa_node(array, sizeof(int) * length, 0));
+#endif
+
+  // Take node 0 as the far tier as well as the near tier so that the test
+  // runs on a system without far memory
+  manager_type::memory_tiering_policy_type policy;
+  policy.far_node = 0;
+  policy.num_cold_samples = 1;
+  manager_type::memory_tiering_result_type result;
+  if (!manager.migrate_cold_chunks(policy, &result)) {
+    GTEST_SKIP() << "Accesses cannot be sampled";
+  }
+  ASSERT_EQ(result.num_demoted_chunks, 0);
+  ASSERT_GE(result.num_sampled_chunks, 4);
+
+  // Not accessed since the previous sample
+  ASSERT_TRUE(manager.migrate_cold_chunks(policy, &result));
+  ASSERT_GE(result.num_demoted_chunks, 4);
+  ASSERT_EQ(result.num_far_chunks, result.num_demoted_chunks);
+
+  // Demoted chunks are not demoted again
+  ASSERT_TRUE(manager.migrate_cold_chunks(policy, &result));
+  ASSERT_EQ(result.num_demoted_chunks, 0);
+
+  // Written chunks are promoted
+  for (std::size_t i = 0; i < length; ++i) array[i] = 2;
+  policy.near_node = 0;
+  ASSERT_TRUE(manager.migrate_cold_chunks(policy, &result));
+  ASSERT_GE(result.num_promoted_chunks, 4);
+  for (std::size_t i = 0; i < length; ++i) ASSERT_EQ(array[i], 2);
+}
+
+TEST(ManagerTest, ChunkHeat) {
+  manager_type::remove(dir_path());
+  constexpr std::size_t length = manager_type::chunk_size() / sizeof(int) * 4;
+  {
+    manager_type manager(metall::create_only, dir_path());
+    auto *const array = manager.construct<int>("array")[length](1);
+
+    manager_type::chunk_heat_statistics_type stats;
+    ASSERT_TRUE(manager.get_chunk_heat_statistics(&stats));
+    ASSERT_EQ(stats.num_samples, 0);
+    ASSERT_EQ(stats.num_hot_chunks, 0);
+    ASSERT_EQ(stats.num_cold_chunks, stats.num_used_chunks);
+    if (!manager.sample_chunk_heat(&stats)) {
+      GTEST_SKIP() << "Accesses cannot be sampled";
+    }
+    // The first call only starts sampling
+    ASSERT_EQ(stats.num_samples, 0);
+    ASSERT_EQ(stats.num_hot_chunks, 0);
+
+    for (std::size_t i = 0; i < length; ++i) array[i] = 2;
+    ASSERT_TRUE(manager.sample_chunk_heat(&stats));
+    ASSERT_EQ(stats.num_samples, 1);
+    ASSERT_GE(stats.num_hot_chunks, 4);
+    ASSERT_EQ(stats.num_hot_chunks + stats.num_warm_chunks +
+                  stats.num_cold_chunks,
+              stats.num_used_chunks);
+
+    // Not accessed since the previous sample
+    ASSERT_TRUE(manager.sample_chunk_heat(&stats));
+    ASSERT_EQ(stats.num_hot_chunks, 0);
+    ASSERT_GE(stats.num_warm_chunks, 4);
+    ASSERT_EQ(stats.hot_fraction(), 0.0);
+  }
+
+  {
+    // The heat is kept in the data store
+    manager_type manager(metall::open_only, dir_path());
+    manager_type::chunk_heat_statistics_type stats;
+    ASSERT_TRUE(manager.get_chunk_heat_statistics(&stats));
+    ASSERT_EQ(stats.num_samples, 0);
+    ASSERT_GE(stats.num_warm_chunks, 4);
+  }
+}
+
+TEST(ManagerTest, PrefaultOnOpen) {
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+    manager.construct<int>("array")[1 << 16](1);
+    manager.construct<int>("small")(2);
+  }
+
+  metall::manager_options options;
+  options.prefault_on_open = true;
+  options.prefault_num_threads = 2;
+  std::size_t last_loaded = 0;
+  std::size_t last_total = 0;
+  options.prefault_progress = [&](const std::size_t loaded,
+                                  const std::size_t total) {
+    ASSERT_GE(loaded, last_loaded);
+    last_loaded = loaded;
+    last_total = total;
+  };
+  {
+    manager_type manager(metall::open_read_only, dir_path(), options);
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_GT(last_total, 0);
+    ASSERT_EQ(last_loaded, last_total);
+    ASSERT_EQ(manager.pinned_size(), 0);
+  }
+
+  // Only the named objects, pinning them
+  options.prefault_object_names = {"array", "small"};
+  options.lock_prefaulted_pages = true;
+  last_loaded = last_total = 0;
+  {
+    manager_type manager(metall::open_read_only, dir_path(), options);
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_GE(last_total, sizeof(int) * ((1 << 16) + 1));
+    ASSERT_EQ(last_loaded, last_total);
+    ASSERT_GE(manager.pinned_size(), sizeof(int) * (1 << 16));
+    const auto *const array = manager.find<int>("array").first;
+    for (int i = 0; i < (1 << 16); ++i) ASSERT_EQ(array[i], 1);
+  }
+
+  // The open fails if an object is not found
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  options.prefault_object_names = {"not_exist"};
+  {
+    manager_type manager(metall::open_read_only, dir_path(), options);
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+}
+
+TEST(ManagerTest, AnonymousConstruct) {
+  manager_type::remove(dir_path());
+  manager_type *manager;
+  manager = new manager_type(metall::create_only, dir_path(), 1UL << 30UL);
+
+  int *const a = manager->construct<int>(metall::anonymous_instance)();
+  ASSERT_NE(a, nullptr);
+
+  // They have to be fail (return false values)
+  const auto ret = manager->find<int>(metall::anonymous_instance);
+  ASSERT_EQ(ret.first, nullptr);
+  ASSERT_EQ(ret.second, 0);
+
+  manager->deallocate(a);
+
+  delete manager;
+}
+
+TEST(ManagerTest, UniqueConstruct) {
+  manager_type::remove(dir_path());
+  manager_type *manager;
+  manager = new manager_type(metall::create_only, dir_path(), 1UL << 30UL);
+
+  int *const a = manager->construct<int>(metall::unique_instance)();
+  ASSERT_NE(a, nullptr);
+
+  double *const b =
+      manager->find_or_construct<double>(metall::unique_instance)();
+  ASSERT_NE(b, nullptr);
+
+  ASSERT_EQ(manager->find<int>(metall::unique_instance).first, a);
+  ASSERT_EQ(manager->find<int>(metall::unique_instance).second, 1);
+
+  ASSERT_EQ(manager->find<double>(metall::unique_instance).first, b);
+  ASSERT_EQ(manager->find<double>(metall::unique_instance).second, 1);
+
+  ASSERT_EQ(manager->destroy<int>(metall::unique_instance), true);
+  ASSERT_EQ(manager->destroy<double>(metall::unique_instance), true);
+
+  delete manager;
+}
+
+TEST(ManagerTest, UUID) {
+  manager_type::remove(dir_path());
+  std::string uuid;
+  {
+    manager_type manager(metall::create_only, dir_path());
+
+    uuid = manager_type::get_uuid(dir_path());
+    ASSERT_FALSE(uuid.empty());
+  }
+
+  {  // Returns the same UUID?
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_EQ(manager_type::get_uuid(dir_path()), uuid);
+  }
 
   {  // Returns a new UUID?
     manager_type manager(metall::create_only, dir_path());
@@ -1330,6 +3423,205 @@ TEST(ManagerTest, Description) {
   }
 }
 
+TEST(ManagerTest, Options) {
+  const auto block_file_size = []() -> std::size_t {
+    for (const auto &entry : fs::recursive_directory_iterator(dir_path())) {
+      if (entry.path().filename() == "block-0") return entry.file_size();
+    }
+    return 0;
+  };
+
+  metall::manager_options options;
+  options.segment_block_size = METALL_SEGMENT_BLOCK_SIZE * 2;
+  options.max_per_cpu_cache_size = 1ULL << 16ULL;
+  options.num_caches_per_cpu = 1;
+  options.free_small_object_size_hint = k_chunk_size / 2;
+
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    ASSERT_TRUE(manager.check_sanity());
+    auto *const array = manager.construct<int>("array")[1 << 20](0);
+    for (int i = 0; i < (1 << 20); ++i) array[i] = i;
+    std::vector<void *> addrs;
+    for (int i = 0; i < 1024; ++i) addrs.push_back(manager.allocate(1024));
+    for (auto *addr : addrs) manager.deallocate(addr);
+  }
+  ASSERT_EQ(block_file_size(), options.segment_block_size);
+
+  // The block size the datastore was created with is used
+  {
+    manager_type manager(metall::open_only, dir_path());
+    auto *const array = manager.find<int>("array").first;
+    ASSERT_NE(array, nullptr);
+    for (int i = 0; i < (1 << 20); ++i) ASSERT_EQ(array[i], i);
+    manager.deallocate(manager.allocate(METALL_SEGMENT_BLOCK_SIZE * 3));
+  }
+  ASSERT_EQ(block_file_size(), options.segment_block_size);
+
+  // Not a multiple of the chunk size
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  options.segment_block_size = k_chunk_size + 1;
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path(), options);
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+}
+
+TEST(ManagerTest, CustomSizeClassTable) {
+  using table_type =
+      metall::kernel::size_class_table<8, 16, 24, 32, 40, 48, 64, 72, 128, 256>;
+  using custom_manager_type =
+      metall::basic_manager<metall::kernel::storage,
+                            metall::kernel::segment_storage, uint32_t,
+                            k_chunk_size, table_type>;
+
+  custom_manager_type::remove(dir_path());
+  {
+    custom_manager_type manager(metall::create_only, dir_path());
+    auto *const addr = static_cast<char *>(manager.allocate(72));
+    std::memset(addr, 1, 72);
+    manager.construct<uint64_t>("value")(10);
+
+    // 72-byte objects fill their chunk without internal fragmentation
+    custom_manager_type::memory_statistics_type stats;
+    ASSERT_TRUE(manager.get_memory_statistics(&stats));
+    bool found = false;
+    for (const auto &bin : stats.bins) {
+      if (bin.object_size == 72) {
+        found = true;
+        ASSERT_EQ(bin.num_objects, 1);
+        ASSERT_EQ(bin.allocated_bytes, 72);
+      }
+    }
+    ASSERT_TRUE(found);
+  }
+
+  {
+    custom_manager_type manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_EQ(*manager.find<uint64_t>("value").first, 10);
+  }
+
+  // A data store must be opened with the table it was created with
+  metall::logger::set_log_level(metall::logger::level_filter::silent);
+  {
+    manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  manager_type::remove(dir_path());
+  {
+    manager_type manager(metall::create_only, dir_path());
+  }
+  {
+    custom_manager_type manager(metall::open_read_only, dir_path());
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  metall::logger::set_log_level(metall::logger::level_filter::error);
+}
+
+TEST(ManagerTest, SingleThreadedManager) {
+  using single_manager_type =
+      metall::basic_manager<metall::kernel::storage,
+                            metall::kernel::segment_storage, uint32_t,
+                            k_chunk_size,
+                            metall::kernel::default_size_class_table,
+                            metall::kernel::single_threaded>;
+  static_assert(!single_manager_type::manager_kernel_type::concurrency_policy::
+                    k_thread_safe);
+
+  // Created by the single-threaded manager and opened by the default one
+  single_manager_type::remove(dir_path());
+  std::vector<std::ptrdiff_t> offsets;
+  {
+    single_manager_type manager(metall::create_only, dir_path());
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 0; i < 4096; ++i) {
+      auto *const addr = static_cast<char *>(manager.allocate(8 + i % 512));
+      offsets.push_back(addr - base);
+    }
+    for (std::size_t i = 0; i < offsets.size(); i += 2) {
+      manager.deallocate(const_cast<char *>(base + offsets[i]));
+    }
+    manager.construct<uint64_t>("value")(10);
+    ASSERT_TRUE(manager.check_sanity());
+  }
+  {
+    manager_type manager(metall::open_only, dir_path());
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_EQ(*manager.find<uint64_t>("value").first, 10);
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 1; i < offsets.size(); i += 2) {
+      manager.deallocate(const_cast<char *>(base + offsets[i]));
+    }
+    manager.destroy<uint64_t>("value");
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+
+  // Both kinds of managers are used at the same time
+  {
+    single_manager_type::remove(dir_path());
+    single_manager_type single_manager(metall::create_only, dir_path());
+    const auto other_dir_path = dir_path().string() + "-multi";
+    manager_type::remove(other_dir_path);
+    manager_type manager(metall::create_only, other_dir_path);
+    auto *const single_value = single_manager.construct<int>("value")(1);
+    auto *const value = manager.construct<int>("value")(2);
+    ASSERT_EQ(*single_manager.find<int>("value").first, 1);
+    ASSERT_EQ(*manager.find<int>("value").first, 2);
+    single_manager.destroy_ptr(single_value);
+    manager.destroy_ptr(value);
+    ASSERT_TRUE(single_manager.all_memory_deallocated());
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(ManagerTest, CheckIntegrity) {
+  {
+    manager_type manager(metall::create_only, dir_path());
+    std::vector<int *> objects;
+    for (int i = 0; i < 1024; ++i) {
+      objects.push_back(manager.construct<int>(std::to_string(i).c_str())(i));
+    }
+    // Leaves chunks that have free slots
+    for (int i = 0; i < 1024; i += 2) {
+      manager.destroy_ptr(objects[i]);
+    }
+    manager.construct<char>("large")[1ULL << 22ULL]();
+    manager.construct<double>(metall::unique_instance)();
+    manager.construct<float>(metall::anonymous_instance)[4]();
+  }
+
+  std::vector<std::string> problems;
+  ASSERT_TRUE(manager_type::check_integrity(dir_path(), &problems));
+  ASSERT_TRUE(problems.empty());
+
+  const auto bin_path =
+      dir_path() / "mds" / "management" /
+      "segment_memory_allocator_non_full_chunk_bin";
+  const auto bin_copy_path = fs::path(dir_path().string() + "-bin");
+  fs::copy_file(bin_path, bin_copy_path, fs::copy_options::overwrite_existing);
+  {
+    // A chunk that is not used is listed
+    std::ofstream ofs(bin_path, std::ios::app);
+    ofs << "0 999999" << std::endl;
+  }
+  ASSERT_FALSE(manager_type::check_integrity(dir_path(), &problems, 1));
+  ASSERT_FALSE(problems.empty());
+  fs::copy_file(bin_copy_path, bin_path, fs::copy_options::overwrite_existing);
+  fs::remove(bin_copy_path);
+
+  problems.clear();
+  ASSERT_TRUE(manager_type::check_integrity(dir_path(), &problems));
+
+  // A truncated block file
+  fs::resize_file(dir_path() / "mds" / "segment" / "block-0", 4096);
+  ASSERT_FALSE(manager_type::check_integrity(dir_path(), &problems));
+  ASSERT_FALSE(problems.empty());
+}
+
 TEST(ManagerTest, CheckSanity) {
   // This test should be run at the end of this execution unless reset the
   // values below:
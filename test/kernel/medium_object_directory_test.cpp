@@ -0,0 +1,148 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <metall/kernel/medium_object_directory.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+namespace fs = std::filesystem;
+
+using directory_type =
+    metall::kernel::medium_object_directory<std::ptrdiff_t, std::size_t>;
+constexpr std::ptrdiff_t k_null = std::numeric_limits<std::ptrdiff_t>::max();
+constexpr std::size_t k_granule = 4096;
+constexpr std::size_t k_slab_size = k_granule * 64;
+
+TEST(MediumObjectDirectoryTest, BestFit) {
+  directory_type directory(k_granule, k_null);
+  ASSERT_EQ(directory.allocate(k_granule), k_null);
+  directory.add_slab(0, k_slab_size);
+
+  // Rounded up to the granule
+  const auto a = directory.allocate(k_granule + 1);
+  const auto b = directory.allocate(k_granule * 4);
+  const auto c = directory.allocate(k_granule);
+  const auto d = directory.allocate(k_granule * 2);
+  ASSERT_EQ(a, 0);
+  ASSERT_EQ(b, std::ptrdiff_t(k_granule * 2));
+  ASSERT_EQ(c, std::ptrdiff_t(k_granule * 6));
+  ASSERT_EQ(d, std::ptrdiff_t(k_granule * 7));
+  ASSERT_EQ(directory.object_size(a), k_granule * 2);
+
+  // Makes holes of 2 and 1 granules
+  std::ptrdiff_t empty_slab;
+  ASSERT_TRUE(directory.deallocate(a, &empty_slab));
+  ASSERT_EQ(empty_slab, k_null);
+  ASSERT_TRUE(directory.deallocate(c, &empty_slab));
+  ASSERT_FALSE(directory.deallocate(c, &empty_slab));
+
+  // The smallest hole that fits
+  ASSERT_EQ(directory.allocate(k_granule), c);
+  ASSERT_EQ(directory.allocate(k_granule), a);
+  ASSERT_EQ(directory.allocate(k_granule), std::ptrdiff_t(k_granule));
+}
+
+TEST(MediumObjectDirectoryTest, Merge) {
+  directory_type directory(k_granule, k_null);
+  directory.add_slab(0, k_slab_size);
+  directory.add_slab(k_slab_size, k_slab_size);
+
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < 64; ++i) {
+    offsets.push_back(directory.allocate(k_granule * 2));
+    ASSERT_NE(offsets.back(), k_null);
+  }
+  ASSERT_EQ(directory.free_bytes(), std::size_t(0));
+
+  // Frees the objects in a random order; they are merged back
+  std::mt19937 rng(7);
+  std::shuffle(offsets.begin(), offsets.end() - 1, rng);
+  std::ptrdiff_t empty_slab = k_null;
+  for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+    ASSERT_TRUE(directory.deallocate(offsets[i], &empty_slab));
+    if (empty_slab != k_null) {
+      // The first slab is freed; its extents are not merged with the second
+      ASSERT_EQ(empty_slab, 0);
+      ASSERT_EQ(directory.num_slabs(), std::size_t(1));
+    }
+  }
+  ASSERT_EQ(directory.num_slabs(), std::size_t(1));
+  ASSERT_EQ(directory.num_free_extents(), std::size_t(1));
+  ASSERT_EQ(directory.free_bytes(), k_slab_size - k_granule * 2);
+
+  ASSERT_TRUE(directory.deallocate(offsets.back(), &empty_slab));
+  ASSERT_EQ(empty_slab, std::ptrdiff_t(k_slab_size));
+  ASSERT_TRUE(directory.empty());
+  ASSERT_EQ(directory.num_free_extents(), std::size_t(0));
+}
+
+TEST(MediumObjectDirectoryTest, Resize) {
+  directory_type directory(k_granule, k_null);
+  directory.add_slab(0, k_slab_size);
+  const auto a = directory.allocate(k_granule);
+  const auto b = directory.allocate(k_granule);
+
+  ASSERT_FALSE(directory.resize(a, k_granule * 2));
+  ASSERT_TRUE(directory.resize(b, k_granule * 10));
+  ASSERT_EQ(directory.object_size(b), k_granule * 10);
+  ASSERT_FALSE(directory.resize(b, k_slab_size));
+
+  ASSERT_TRUE(directory.resize(b, k_granule));
+  ASSERT_EQ(directory.num_free_extents(), std::size_t(1));
+  ASSERT_EQ(directory.allocate(k_slab_size - k_granule * 2),
+            std::ptrdiff_t(k_granule * 2));
+}
+
+TEST(MediumObjectDirectoryTest, ReserveFreeSpace) {
+  directory_type directory(k_granule, k_null);
+  directory.add_slab(0, k_slab_size);
+  const auto a = directory.allocate(k_granule);
+  directory.reserve_free_space();
+  ASSERT_EQ(directory.allocate(k_granule), k_null);
+
+  // The slab is not given back as the reserved space is in use
+  std::ptrdiff_t empty_slab;
+  ASSERT_TRUE(directory.in_slab(k_granule * 3));
+  ASSERT_FALSE(directory.deallocate(k_granule * 3, &empty_slab));
+  ASSERT_TRUE(directory.deallocate(a, &empty_slab));
+  ASSERT_EQ(empty_slab, k_null);
+  ASSERT_EQ(directory.num_slabs(), std::size_t(1));
+}
+
+TEST(MediumObjectDirectoryTest, Serialize) {
+  const auto path = test_utility::make_test_path("medium_object_directory");
+  fs::remove_all(path);
+
+  directory_type directory(k_granule, k_null);
+  directory.add_slab(k_slab_size * 2, k_slab_size);
+  const auto a = directory.allocate(k_granule * 3);
+  const auto b = directory.allocate(k_granule);
+  std::ptrdiff_t empty_slab;
+  ASSERT_TRUE(directory.deallocate(a, &empty_slab));
+  ASSERT_TRUE(directory.serialize(path));
+
+  directory_type loaded(k_granule, k_null);
+  ASSERT_TRUE(loaded.deserialize(path));
+  ASSERT_EQ(loaded.num_slabs(), std::size_t(1));
+  ASSERT_EQ(loaded.num_objects(), std::size_t(1));
+  ASSERT_EQ(loaded.object_size(b), k_granule);
+  ASSERT_EQ(loaded.free_bytes(), directory.free_bytes());
+  ASSERT_EQ(loaded.allocate(k_granule * 3), a);
+
+  // Must be read with the same granule
+  directory_type other(k_granule * 2, k_null);
+  ASSERT_FALSE(other.deserialize(path));
+  fs::remove_all(path);
+}
+}  // namespace
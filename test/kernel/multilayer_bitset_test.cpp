@@ -9,6 +9,7 @@
 #include <random>
 #include <unordered_set>
 #include <cstddef>
+#include <thread>
 
 #include <metall/detail/bitset.hpp>
 #include <metall/kernel/multilayer_bitset.hpp>
@@ -184,4 +185,136 @@ TEST(MultilayerBitsetTest, RandomSetAndReset2) {
 
   // 4 layers
   RandomSetAndResetHelper2(64 * 64 * 64 + 1);
-}
\ No newline at end of file
+}
+
+TEST(MultilayerBitsetTest, SerializeBlocks) {
+  for (uint64_t num_bits = 1; num_bits <= (64ULL * 64 * 64 * 32);
+       num_bits *= 64) {  // Test up to 4 layers
+    metall::kernel::multilayer_bitset bitset;
+    bitset.allocate(num_bits);
+    for (uint64_t i = 0; i < num_bits / 2; ++i) {
+      bitset.find_and_set(num_bits);
+    }
+
+    const auto num_blocks =
+        metall::kernel::multilayer_bitset::num_blocks(num_bits);
+    std::vector<uint64_t> buf(num_blocks);
+    bitset.serialize(num_bits, buf.data());
+
+    metall::kernel::multilayer_bitset restored;
+    restored.allocate(num_bits);
+    restored.deserialize(num_bits, buf.data());
+    for (uint64_t i = 0; i < num_bits; ++i) {
+      ASSERT_EQ(bitset.get(num_bits, i), restored.get(num_bits, i));
+    }
+    ASSERT_EQ(bitset.find_and_set(num_bits), restored.find_and_set(num_bits));
+
+    bitset.free(num_bits);
+    restored.free(num_bits);
+  }
+}
+
+TEST(MultilayerBitsetTest, Count) {
+  for (uint64_t num_bits = 1; num_bits <= (64ULL * 64 * 64 * 32);
+       num_bits *= 64) {  // Test up to 4 layers
+    for (const uint64_t size : {num_bits, num_bits + 3}) {
+      metall::kernel::multilayer_bitset bitset;
+      bitset.allocate(size);
+      ASSERT_EQ(bitset.count(size), 0);
+      for (uint64_t i = 0; i < size; ++i) {
+        bitset.find_and_set(size);
+      }
+      ASSERT_EQ(bitset.count(size), size);
+      for (uint64_t i = 0; i < size; i += 3) {
+        bitset.reset(size, i);
+      }
+      ASSERT_EQ(bitset.count(size), size - (size + 2) / 3);
+      bitset.free(size);
+    }
+  }
+}
+
+TEST(MultilayerBitsetTest, FindAndSetConcurrently) {
+  constexpr std::size_t k_num_threads = 8;
+  for (uint64_t num_bits : {63ULL, 64ULL * 64, 64ULL * 64 * 64 + 1}) {
+    metall::kernel::multilayer_bitset bitset;
+    bitset.allocate(num_bits);
+    // Set some bits beforehand
+    for (uint64_t i = 0; i < num_bits / 4; ++i) {
+      bitset.find_and_set(num_bits);
+    }
+
+    const uint64_t num_remains = num_bits - num_bits / 4;
+    std::vector<std::vector<std::size_t>> found(k_num_threads);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < k_num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (uint64_t i = t; i < num_remains; i += k_num_threads) {
+          found[t].push_back(bitset.find_and_set_concurrently(num_bits));
+        }
+      });
+    }
+    for (auto &th : threads) th.join();
+
+    std::vector<bool> seen(num_bits, false);
+    for (const auto &list : found) {
+      for (const auto pos : list) {
+        ASSERT_LT(pos, num_bits);
+        ASSERT_FALSE(seen[pos]);
+        seen[pos] = true;
+      }
+    }
+    for (uint64_t i = 0; i < num_bits; ++i) {
+      ASSERT_TRUE(bitset.get(num_bits, i));
+    }
+
+    // The index blocks must be consistent with the leaf blocks
+    bitset.reset(num_bits, num_bits / 2);
+    ASSERT_EQ(bitset.find_and_set(num_bits), num_bits / 2);
+
+    bitset.free(num_bits);
+  }
+}
+
+TEST(MultilayerBitsetTest, FindAndSetManyTakesFirstFalseBits) {
+  for (uint64_t num_bits : {64ULL, 64ULL * 64, 64ULL * 64 * 64 + 1}) {
+    SCOPED_TRACE("num_bits = " + std::to_string(num_bits));
+    metall::kernel::multilayer_bitset bitset;
+    bitset.allocate(num_bits);
+    std::vector<bool> reference(num_bits, false);
+    for (uint64_t i = 0; i < num_bits; ++i) bitset.find_and_set(num_bits);
+    // Leave every third bit false, including ones in full-block gaps
+    for (uint64_t i = 0; i < num_bits; ++i) {
+      if (i % 3 == 0 || (i >= 128 && i < 256)) {
+        bitset.reset(num_bits, i);
+      } else {
+        reference[i] = true;
+      }
+    }
+
+    std::size_t num_false = 0;
+    for (uint64_t i = 0; i < num_bits; ++i) num_false += !reference[i];
+    while (num_false > 0) {
+      const std::size_t n = std::min<std::size_t>(num_false, 100);
+      std::vector<metall::kernel::multilayer_bitset::bit_position_type> buf(n);
+      bitset.find_and_set_many(num_bits, n, buf.data());
+      // Takes the first n false bits in order
+      uint64_t expected = 0;
+      for (std::size_t i = 0; i < n; ++i, ++expected) {
+        while (reference[expected]) ++expected;
+        ASSERT_EQ(buf[i], expected);
+        reference[expected] = true;
+      }
+      num_false -= n;
+    }
+    for (uint64_t i = 0; i < num_bits; ++i) {
+      ASSERT_TRUE(bitset.get(num_bits, i));
+    }
+
+    // The index blocks must be consistent with the leaf blocks
+    bitset.reset(num_bits, num_bits - 1);
+    ASSERT_EQ(bitset.find_and_set(num_bits), num_bits - 1);
+
+    bitset.free(num_bits);
+  }
+}
@@ -0,0 +1,77 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include <metall/kernel/attributed_object_directory.hpp>
+#include <metall/kernel/named_object_index.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using directory_type =
+    metall::kernel::attributed_object_directory<ssize_t, std::size_t>;
+using index_type = metall::kernel::named_object_index;
+
+TEST(NamedObjectIndexTest, Find) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+
+  directory_type directory;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(directory.insert("item" + std::to_string(i), i * 8, i + 1,
+                                 i % 3, "description"));
+  }
+  ASSERT_TRUE(index_type::write(file, directory));
+
+  index_type index;
+  ASSERT_TRUE(index.open(file));
+  ASSERT_EQ(index.size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    index_type::offset_type offset = 0;
+    std::size_t length = 0;
+    ASSERT_TRUE(index.find("item" + std::to_string(i), &offset, &length));
+    ASSERT_EQ(offset, i * 8);
+    ASSERT_EQ(length, i + 1);
+  }
+  index_type::offset_type offset = 0;
+  std::size_t length = 0;
+  ASSERT_FALSE(index.find("item1000", &offset, &length));
+  ASSERT_FALSE(index.find("", &offset, &length));
+
+  index.close();
+  ASSERT_FALSE(index.is_open());
+  ASSERT_FALSE(index.find("item0", &offset, &length));
+}
+
+TEST(NamedObjectIndexTest, Empty) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+
+  ASSERT_TRUE(index_type::write(file, directory_type()));
+  index_type index;
+  ASSERT_TRUE(index.open(file));
+  ASSERT_EQ(index.size(), 0);
+  index_type::offset_type offset = 0;
+  std::size_t length = 0;
+  ASSERT_FALSE(index.find("item", &offset, &length));
+}
+
+TEST(NamedObjectIndexTest, BrokenFile) {
+  test_utility::create_test_dir();
+  const auto file(test_utility::make_test_path());
+
+  directory_type directory;
+  ASSERT_TRUE(directory.insert("item", 0, 1, 0));
+  ASSERT_TRUE(index_type::write(file, directory));
+  std::filesystem::resize_file(file, std::filesystem::file_size(file) - 1);
+
+  index_type index;
+  ASSERT_FALSE(index.open(file));
+  ASSERT_FALSE(index.open(test_utility::make_test_path("none")));
+}
+}  // namespace
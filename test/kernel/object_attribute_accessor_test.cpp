@@ -248,4 +248,57 @@ TEST(ObjectAttributeAccessorTest, Description) {
     ASSERT_STREQ(buf2.c_str(), "desc2");
   }
 }
-}  // namespace
\ No newline at end of file
+
+TEST(ObjectAttributeAccessorTest, ReadObjectAttributes) {
+  manager::remove(test_utility::make_test_path());
+
+  // More objects than a task of the parallel reader decodes
+  constexpr std::size_t k_num_objects = 100000;
+  {
+    manager mngr(create_only, test_utility::make_test_path(),
+                 1ULL << 30ULL);
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      mngr.construct<int>(("int" + std::to_string(i)).c_str())();
+    }
+    mngr.construct<float>(unique_instance)();
+    mngr.construct<double>(anonymous_instance)[2]();
+  }
+
+  std::vector<manager::object_attribute_type> attributes;
+  ASSERT_TRUE(manager::read_object_attributes(
+      test_utility::make_test_path(), manager::instance_kind::named_kind,
+      &attributes));
+  ASSERT_EQ(attributes.size(), k_num_objects);
+  {
+    auto accessor = attr_accessor_named();
+    std::size_t i = 0;
+    for (const auto &object : accessor) {
+      ASSERT_EQ(attributes[i].name(), object.name());
+      ASSERT_EQ(attributes[i].offset(), object.offset());
+      ASSERT_EQ(attributes[i].length(), object.length());
+      ASSERT_EQ(attributes[i].type_id(), object.type_id());
+      ++i;
+    }
+  }
+
+  ASSERT_TRUE(manager::read_object_attributes(
+      test_utility::make_test_path(), manager::instance_kind::unique_kind,
+      &attributes, 1));
+  ASSERT_EQ(attributes.size(), 1);
+  ASSERT_EQ(attributes[0].name(), typeid(float).name());
+
+  ASSERT_TRUE(manager::read_object_attributes(
+      test_utility::make_test_path(), manager::instance_kind::anonymous_kind,
+      &attributes));
+  ASSERT_EQ(attributes.size(), 1);
+  ASSERT_EQ(attributes[0].length(), 2);
+
+  // Changes made after the directory was written are read
+  ASSERT_TRUE(attr_accessor_named().set_description("int1", "desc1"));
+  ASSERT_TRUE(manager::read_object_attributes(
+      test_utility::make_test_path(), manager::instance_kind::named_kind,
+      &attributes));
+  ASSERT_EQ(attributes.size(), k_num_objects);
+  ASSERT_EQ(attributes[1].description(), "desc1");
+}
+}  // namespace
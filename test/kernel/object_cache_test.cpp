@@ -5,7 +5,10 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <unordered_set>
+#include <set>
+#include <thread>
 #include <vector>
 #include <utility>
 #include <random>
@@ -57,6 +60,294 @@ TEST(ObjectCacheTest, Construct) {
   ASSERT_GT(cache.max_bin_no(), 0);
 }
 
+TEST(ObjectCacheTest, ConstructWithOptions) {
+  const cache_type default_cache;
+  cache_type cache(1ULL << 16ULL, 1);
+  ASSERT_EQ(cache.max_per_cpu_cache_size(), 1ULL << 16ULL);
+  ASSERT_EQ(cache.num_caches_per_cpu(), 1);
+  ASSERT_GT(cache.max_bin_no(), 0);
+  ASSERT_LE(cache.max_bin_no(), default_cache.max_bin_no());
+
+  // Capped at the compile-time maximum
+  cache_type large_cache(default_cache.max_per_cpu_cache_size() * 2);
+  ASSERT_EQ(large_cache.max_per_cpu_cache_size(),
+            default_cache.max_per_cpu_cache_size());
+
+  dummy_allocator alloc(cache.max_bin_no());
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < 1024; ++i) {
+    offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                &dummy_allocator::deallocate));
+  }
+  for (const auto off : offsets) {
+    cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+  }
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  for (const auto &record : alloc.records) {
+    ASSERT_TRUE(record.empty());
+  }
+}
+
+TEST(ObjectCacheTest, BindingPolicy) {
+  for (const auto policy : {cache_type::binding_policy::per_thread,
+                            cache_type::binding_policy::per_cpu,
+                            cache_type::binding_policy::per_numa_node}) {
+    cache_type cache;
+    cache.set_binding_policy(policy);
+    ASSERT_EQ(cache.get_binding_policy(), policy);
+
+    dummy_allocator alloc(cache.max_bin_no());
+    std::vector<std::ptrdiff_t> offsets;
+    for (std::size_t i = 0; i < 1024; ++i) {
+      offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                  &dummy_allocator::deallocate));
+    }
+    for (const auto off : offsets) {
+      cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+    }
+
+    // The first pushes go to the thread-local cache and the lock-free slots,
+    // if they are enabled
+    const auto num_accesses = 2048 - cache.thread_local_cache_depth() -
+                              cache.num_lock_free_slots();
+    const auto counts = cache.get_access_counts();
+    ASSERT_EQ(counts.num_accesses, num_accesses);
+    ASSERT_LE(counts.num_cross_cpu_accesses, counts.num_accesses);
+
+    cache.clear(&alloc, &dummy_allocator::deallocate);
+    for (const auto &record : alloc.records) {
+      ASSERT_TRUE(record.empty());
+    }
+    // The counters are kept
+    ASSERT_EQ(cache.get_access_counts().num_accesses, num_accesses);
+  }
+}
+
+TEST(ObjectCacheTest, AdaptiveBinCapacity) {
+  cache_type cache;
+  cache.set_binding_policy(cache_type::binding_policy::per_thread);
+  dummy_allocator alloc(cache.max_bin_no());
+
+  // Find the cache this thread uses.
+  // Push more objects than the thread-local cache and the lock-free slots keep
+  {
+    std::vector<std::ptrdiff_t> offsets;
+    const auto n =
+        cache.thread_local_cache_depth() + cache.num_lock_free_slots() + 1;
+    for (std::size_t i = 0; i < n; ++i) {
+      offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                  &dummy_allocator::deallocate));
+    }
+    for (const auto off : offsets) {
+      cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+    }
+  }
+  std::size_t cache_no = 0;
+  for (; cache_no < cache.num_caches(); ++cache_no) {
+    if (cache.begin(cache_no, 0) != cache.end(cache_no, 0)) break;
+  }
+  ASSERT_LT(cache_no, cache.num_caches());
+
+  // Use a bin whose capacity can grow within the per-CPU cache size
+  auto bin_no = cache.max_bin_no();
+  while (cache.bin_capacity(cache_no, bin_no) *
+             bin_no_manager::to_object_size(bin_no) * 8 >
+         cache.max_per_cpu_cache_size()) {
+    ASSERT_GT(bin_no, 0);
+    --bin_no;
+  }
+  const auto initial_capacity = cache.bin_capacity(cache_no, bin_no);
+
+  // Misses grow the capacity
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < initial_capacity * 4; ++i) {
+    offsets.push_back(cache.pop(bin_no, &alloc, &dummy_allocator::allocate,
+                                &dummy_allocator::deallocate));
+  }
+  const auto grown_capacity = cache.bin_capacity(cache_no, bin_no);
+  ASSERT_GT(grown_capacity, initial_capacity);
+
+  // The bin does not cache more objects than its capacity
+  offsets.resize(offsets.size() + grown_capacity * 4);
+  alloc.allocate(bin_no, grown_capacity * 4,
+                 &offsets[offsets.size() - grown_capacity * 4]);
+  for (const auto off : offsets) {
+    cache.push(bin_no, off, &alloc, &dummy_allocator::deallocate);
+  }
+  std::size_t num_cached = 0;
+  for (auto itr = cache.begin(cache_no, bin_no),
+            end = cache.end(cache_no, bin_no);
+       itr != end; ++itr) {
+    ++num_cached;
+  }
+  ASSERT_LE(num_cached, cache.bin_capacity(cache_no, bin_no));
+
+  // Overflows shrink the capacity
+  ASSERT_LT(cache.bin_capacity(cache_no, bin_no), grown_capacity);
+
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  for (const auto &record : alloc.records) {
+    ASSERT_TRUE(record.empty());
+  }
+}
+
+TEST(ObjectCacheTest, ThreadLocalCache) {
+  cache_type cache;
+  dummy_allocator alloc(cache.max_bin_no());
+
+  const auto depth = cache.thread_local_cache_depth();
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < depth; ++i) {
+    offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                &dummy_allocator::deallocate));
+  }
+  for (const auto off : offsets) {
+    cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+  }
+
+  // The objects are kept in the thread-local cache
+  std::set<std::ptrdiff_t> cached;
+  cache.for_each_in_thread_local_caches(
+      0, [&cached](const std::ptrdiff_t off) { cached.insert(off); });
+  ASSERT_EQ(cached, std::set<std::ptrdiff_t>(offsets.begin(), offsets.end()));
+
+  // The thread-local cache is used first (LIFO)
+  for (std::size_t i = 0; i < depth; ++i) {
+    ASSERT_EQ(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                        &dummy_allocator::deallocate),
+              offsets[depth - i - 1]);
+  }
+  for (const auto off : offsets) {
+    cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+  }
+
+  // Objects cached by an exited thread are kept until they are deallocated
+  std::thread th([&cache, &alloc]() {
+    for (std::size_t b = 0; b <= cache.max_bin_no(); ++b) {
+      cache.push(b,
+                 cache.pop(b, &alloc, &dummy_allocator::allocate,
+                           &dummy_allocator::deallocate),
+                 &alloc, &dummy_allocator::deallocate);
+    }
+  });
+  th.join();
+  if (depth > 0) {
+    std::size_t num_cached = 0;
+    for (std::size_t b = 0; b <= cache.max_bin_no(); ++b) {
+      cache.for_each_in_thread_local_caches(
+          b, [&num_cached](const std::ptrdiff_t) { ++num_cached; });
+    }
+    ASSERT_EQ(num_cached, depth + cache.max_bin_no() + 1);
+  }
+
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  for (const auto &record : alloc.records) {
+    ASSERT_TRUE(record.empty());
+  }
+  std::size_t num_cached = 0;
+  cache.for_each_in_thread_local_caches(
+      0, [&num_cached](const std::ptrdiff_t) { ++num_cached; });
+  ASSERT_EQ(num_cached, 0);
+}
+
+TEST(ObjectCacheTest, Trim) {
+  cache_type cache;
+  dummy_allocator alloc(cache.max_bin_no());
+
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < 1024; ++i) {
+    offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                &dummy_allocator::deallocate));
+  }
+  for (const auto off : offsets) {
+    cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+  }
+  const auto num_cached = alloc.records[0].size();
+
+  // The caches have been used since the last trim
+  ASSERT_EQ(cache.trim(&alloc, &dummy_allocator::deallocate), 0);
+
+  // Idle caches are trimmed gradually
+  const auto num_trimmed = cache.trim(&alloc, &dummy_allocator::deallocate);
+  ASSERT_GT(num_trimmed, 0);
+  ASSERT_LT(num_trimmed, num_cached);
+  ASSERT_EQ(alloc.records[0].size(), num_cached - num_trimmed);
+  while (cache.trim(&alloc, &dummy_allocator::deallocate) > 0) {
+  }
+
+  // Only the objects in the thread-local cache and lock-free slots remain
+  ASSERT_EQ(alloc.records[0].size(),
+            cache.thread_local_cache_depth() + cache.num_lock_free_slots());
+
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  for (const auto &record : alloc.records) {
+    ASSERT_TRUE(record.empty());
+  }
+}
+
+TEST(ObjectCacheTest, Prefill) {
+  cache_type cache;
+  dummy_allocator alloc(cache.max_bin_no());
+  const auto allocate_up_to = [&alloc](const std::size_t max) {
+    return [&alloc, max](const std::size_t n, std::ptrdiff_t *const offsets) {
+      const auto num = std::min(n, max);
+      alloc.allocate(0, num, offsets);
+      return num;
+    };
+  };
+
+  // No object to cache
+  ASSERT_EQ(cache.prefill(0, 0, allocate_up_to(0)), 0);
+  ASSERT_EQ(cache.num_cached_objects(0), 0);
+
+  // Takes fewer objects than a refill if no more is available
+  ASSERT_GT(cache_type::refill_size(0), 3);
+  ASSERT_EQ(cache.prefill(0, 0, allocate_up_to(3)), 3);
+  ASSERT_EQ(cache.num_cached_objects(0), 3);
+  ASSERT_EQ(alloc.records[0].size(), 3);
+
+  // The bin already has objects
+  ASSERT_EQ(cache.prefill(0, 0, allocate_up_to(100)), 0);
+
+  if (cache.num_caches() > 1) {
+    ASSERT_EQ(cache.prefill(1, 0, allocate_up_to(1 << 20)),
+              cache_type::refill_size(0));
+    ASSERT_EQ(cache.num_cached_objects(0), cache_type::refill_size(0) + 3);
+  }
+
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  ASSERT_EQ(cache.num_cached_objects(0), 0);
+  ASSERT_TRUE(alloc.records[0].empty());
+}
+
+TEST(ObjectCacheTest, SingleThreaded) {
+  using single_cache_type =
+      metall::kernel::object_cache<std::size_t, std::ptrdiff_t, bin_no_manager,
+                                   dummy_allocator,
+                                   metall::kernel::single_threaded>;
+  single_cache_type cache;
+  ASSERT_EQ(cache.num_caches(), 1);
+  ASSERT_EQ(cache.thread_local_cache_depth(), 0);
+  ASSERT_EQ(cache.num_lock_free_slots(), 0);
+
+  dummy_allocator alloc(cache.max_bin_no());
+  std::vector<std::ptrdiff_t> offsets;
+  for (std::size_t i = 0; i < 1024; ++i) {
+    offsets.push_back(cache.pop(0, &alloc, &dummy_allocator::allocate,
+                                &dummy_allocator::deallocate));
+  }
+  for (const auto off : offsets) {
+    cache.push(0, off, &alloc, &dummy_allocator::deallocate);
+  }
+  // All objects go through the only cache
+  ASSERT_EQ(cache.get_access_counts().num_accesses, 2048);
+
+  cache.clear(&alloc, &dummy_allocator::deallocate);
+  for (const auto &record : alloc.records) {
+    ASSERT_TRUE(record.empty());
+  }
+}
+
 TEST(ObjectCacheTest, Sequential) {
   cache_type cache;
   dummy_allocator alloc(cache.max_bin_no());
@@ -0,0 +1,91 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+#include <metall/metall.hpp>
+#include <metall/segment_relative_ptr.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+struct node {
+  int value;
+  metall::segment_relative_ptr<node> next;
+};
+
+TEST(SegmentRelativePtrTest, Null) {
+  metall::segment_relative_ptr<int> ptr;
+  ASSERT_FALSE(ptr);
+  ASSERT_TRUE(!ptr);
+  ASSERT_EQ(ptr.get(), nullptr);
+  ASSERT_EQ(ptr, nullptr);
+  ASSERT_EQ(metall::segment_relative_ptr<int>(nullptr), ptr);
+}
+
+TEST(SegmentRelativePtrTest, Arithmetic) {
+  int array[4] = {0, 1, 2, 3};
+  metall::set_segment_relative_ptr_base(array);
+
+  metall::segment_relative_ptr<int> ptr(array);
+  ASSERT_TRUE(ptr);
+  ASSERT_EQ(ptr.offset(), 0);
+  ASSERT_EQ(ptr.get(), array);
+  ASSERT_EQ(*(ptr + 2), 2);
+  ASSERT_EQ(ptr[3], 3);
+  ASSERT_EQ((ptr + 3) - ptr, 3);
+  ASSERT_LT(ptr, ptr + 1);
+  ASSERT_EQ(*(++ptr), 1);
+  ASSERT_EQ(*(ptr++), 1);
+  ASSERT_EQ(*(--ptr), 1);
+  ASSERT_EQ(metall::to_raw_pointer(ptr), &array[1]);
+
+  metall::segment_relative_ptr<const void> vptr(ptr);
+  ASSERT_EQ(vptr.get(), &array[1]);
+
+  // Trivially copyable
+  metall::segment_relative_ptr<int> copy;
+  std::memcpy(&copy, &ptr, sizeof(ptr));
+  ASSERT_EQ(copy, ptr);
+
+  metall::set_segment_relative_ptr_base(nullptr);
+}
+
+TEST(SegmentRelativePtrTest, Persistence) {
+  constexpr int k_length = 1024;
+  const auto dir_path(test_utility::make_test_path());
+
+  {
+    metall::manager manager(metall::create_only, dir_path.c_str());
+    metall::set_segment_relative_ptr_base(manager.get_address());
+    metall::segment_relative_ptr<node> head;
+    for (int i = 0; i < k_length; ++i) {
+      auto *const n = manager.construct<node>(metall::anonymous_instance)();
+      n->value = i;
+      n->next = head;
+      head = n;
+    }
+    *manager.construct<metall::segment_relative_ptr<node>>("head")() = head;
+  }
+
+  {
+    metall::manager manager(metall::open_read_only, dir_path.c_str());
+    metall::set_segment_relative_ptr_base(manager.get_address());
+    auto *const head =
+        manager.find<metall::segment_relative_ptr<node>>("head").first;
+    ASSERT_NE(head, nullptr);
+    int expected = k_length - 1;
+    for (auto n = *head; n; n = n->next) {
+      ASSERT_EQ(n->value, expected);
+      --expected;
+    }
+    ASSERT_EQ(expected, -1);
+  }
+
+  metall::set_segment_relative_ptr_base(nullptr);
+}
+}  // namespace
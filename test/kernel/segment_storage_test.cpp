@@ -5,7 +5,17 @@
 
 #include "gtest/gtest.h"
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
 #include <metall/kernel/segment_storage.hpp>
+#include <metall/kernel/segment_storage_concept.hpp>
 #include "../test_utility.hpp"
 
 namespace {
@@ -26,6 +36,23 @@ void prepare_test_dir() {
   ASSERT_TRUE(metall::mtlldetail::create_directory(test_dir()));
 }
 
+std::size_t num_files_starting_with(const std::string &prefix) {
+  std::size_t count = 0;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(test_file_prefix())) {
+    if (entry.path().filename().string().rfind(prefix, 0) == 0) ++count;
+  }
+  return count;
+}
+
+std::size_t num_block_files() { return num_files_starting_with("block-"); }
+
+TEST(MultifileSegmentStorageTest, Concept) {
+  static_assert(metall::kernel::is_segment_storage_v<segment_storage_type>);
+  ASSERT_FALSE(metall::kernel::is_segment_storage_v<int>);
+  ASSERT_FALSE(metall::kernel::is_segment_storage_v<metall::kernel::storage>);
+}
+
 TEST(MultifileSegmentStorageTest, PageSize) {
   segment_storage_type data_storage;
   ASSERT_GT(data_storage.page_size(), 0);
@@ -176,4 +203,560 @@ TEST(MultifileSegmentStorageTest, Sync) {
     }
   }
 }
-}  // namespace
\ No newline at end of file
+TEST(MultifileSegmentStorageTest, SyncWrittenPages) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+  const auto prefix0 = test_file_prefix() + "-0";
+  const auto prefix1 = test_file_prefix() + "-1";
+
+  {
+    // Sync two segments alternately;
+    // syncing one must not lose the written pages of the other
+    segment_storage_type storage0;
+    segment_storage_type storage1;
+    ASSERT_TRUE(storage0.create(prefix0, vm_size));
+    ASSERT_TRUE(storage1.create(prefix1, vm_size));
+    ASSERT_TRUE(storage0.extend(vm_size));
+    ASSERT_TRUE(storage1.extend(vm_size));
+    auto buf0 = static_cast<char *>(storage0.get_segment());
+    auto buf1 = static_cast<char *>(storage1.get_segment());
+    const auto page_size = storage0.page_size();
+
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      buf0[i] = '1';
+      buf1[i] = '1';
+    }
+    ASSERT_TRUE(storage0.sync(true));
+    ASSERT_TRUE(storage1.sync(true));
+
+    for (std::size_t k = 0; k < 2; ++k) {
+      // Write every other page
+      for (std::size_t i = k * page_size; i < vm_size; i += page_size * 2) {
+        buf0[i] = '2';
+        buf1[i] = '2';
+      }
+      ASSERT_TRUE(storage0.sync(true));
+    }
+    ASSERT_TRUE(storage1.sync(true));
+  }
+
+  for (const auto &prefix : {prefix0, prefix1}) {
+    segment_storage_type storage;
+    ASSERT_TRUE(storage.open(prefix, vm_size, true));
+    const auto buf = static_cast<const char *>(storage.get_segment());
+    const auto page_size = storage.page_size();
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      ASSERT_EQ(buf[i], (i % page_size == 0) ? '2' : '1');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, SyncAsync) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(vm_size));
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      buf[i] = '1';
+    }
+    auto future = data_storage.sync_async(2);
+
+    // Writing data while the sync is running is allowed
+    for (std::size_t i = 0; i < vm_size / 2; ++i) {
+      buf[i] = '2';
+    }
+    ASSERT_TRUE(future.get());
+    ASSERT_TRUE(data_storage.sync(true));
+  }
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, true));
+    const auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      ASSERT_EQ(buf[i], (i < vm_size / 2) ? '2' : '1');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, Prefetch) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(vm_size));
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      buf[i] = '1';
+    }
+  }
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, true));
+    ASSERT_TRUE(data_storage.prefetch(0, data_storage.size()));
+    // Clipped to the segment
+    ASSERT_TRUE(data_storage.prefetch(1, data_storage.size() * 2));
+    ASSERT_TRUE(data_storage.prefetch(data_storage.size(), 1));
+    ASSERT_FALSE(data_storage.prefetch(-1, 1));
+    const auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      ASSERT_EQ(buf[i], '1');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, BlockGrowth) {
+  constexpr std::size_t block_size = METALL_SEGMENT_BLOCK_SIZE;
+  constexpr std::size_t vm_size = block_size * 16;
+  constexpr std::size_t k_stride = 1ULL << 20ULL;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(block_size * 8));
+    ASSERT_EQ(data_storage.size(), block_size * 8);
+#ifdef METALL_USE_GEOMETRIC_BLOCK_GROWTH
+    // 1 + 1 + 2 + 4 blocks
+    ASSERT_EQ(num_block_files(), 4U);
+#else
+    ASSERT_EQ(num_block_files(), 8U);
+#endif
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < data_storage.size(); i += k_stride) {
+      buf[i] = '1';
+    }
+    ASSERT_TRUE(data_storage.sync(true));
+  }
+
+  // Datastores are opened with the block sizes recorded in the files
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, false));
+    ASSERT_EQ(data_storage.size(), block_size * 8);
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < data_storage.size(); i += k_stride) {
+      ASSERT_EQ(buf[i], '1');
+      buf[i] = '2';
+    }
+    ASSERT_TRUE(data_storage.extend(block_size * 9));
+    ASSERT_GE(data_storage.size(), block_size * 9);
+    ASSERT_LE(data_storage.size(), vm_size);
+  }
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, true));
+    ASSERT_GE(data_storage.size(), block_size * 9);
+    const auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < block_size * 8; i += k_stride) {
+      ASSERT_EQ(buf[i], '2');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, PreextendedBlocks) {
+  constexpr std::size_t block_size = METALL_SEGMENT_BLOCK_SIZE;
+  constexpr std::size_t vm_size = block_size * 8;
+  constexpr std::size_t k_stride = 1ULL << 20ULL;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    // Extend block by block to take the pre-extended files, if any
+    for (std::size_t n = 2; n <= 4; ++n) {
+      ASSERT_TRUE(data_storage.extend(block_size * n));
+      ASSERT_GE(data_storage.size(), block_size * n);
+    }
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < data_storage.size(); i += k_stride) {
+      buf[i] = '1';
+    }
+    ASSERT_TRUE(data_storage.sync(true));
+  }
+  // Pre-extended files are removed on close
+  ASSERT_EQ(num_files_starting_with("preextended-block-"), 0U);
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, false));
+    ASSERT_GE(data_storage.size(), block_size * 4);
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < data_storage.size(); i += k_stride) {
+      ASSERT_EQ(buf[i], '1');
+    }
+    // Up to the capacity
+    ASSERT_TRUE(data_storage.extend(vm_size));
+    ASSERT_EQ(data_storage.size(), vm_size);
+    buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; i += k_stride) buf[i] = '2';
+  }
+  ASSERT_EQ(num_files_starting_with("preextended-block-"), 0U);
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, true));
+    ASSERT_EQ(data_storage.size(), vm_size);
+    const auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; i += k_stride) {
+      ASSERT_EQ(buf[i], '2');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, PrefaultNewBlocks) {
+  constexpr std::size_t block_size = METALL_SEGMENT_BLOCK_SIZE;
+  constexpr std::size_t vm_size = block_size * 4;
+  constexpr std::size_t k_stride = 1ULL << 16ULL;
+  constexpr std::size_t k_num_threads = 4;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    for (std::size_t n = 2; n <= 3; ++n) {
+      ASSERT_TRUE(data_storage.extend(block_size * n));
+      // Write while the new block can be being prefaulted
+      auto buf = static_cast<char *>(data_storage.get_segment());
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t < k_num_threads; ++t) {
+        threads.emplace_back([buf, n, t]() {
+          for (std::size_t i = block_size * (n - 1) + t * k_stride;
+               i < block_size * n; i += k_stride * k_num_threads) {
+            buf[i] = char('0' + n);
+          }
+        });
+      }
+      for (auto &th : threads) th.join();
+    }
+    ASSERT_TRUE(data_storage.sync(true));
+  }
+
+#ifdef METALL_PREFAULT_NEW_BLOCKS
+  // The disk space of the new blocks is allocated
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(test_file_prefix())) {
+    if (entry.path().filename().string().rfind("block-", 0) != 0) continue;
+    struct stat st;
+    ASSERT_EQ(::stat(entry.path().c_str(), &st), 0);
+    ASSERT_GE(std::size_t(st.st_blocks) * 512, std::size_t(st.st_size));
+  }
+#endif
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, true));
+    const auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = block_size; i < block_size * 3; i += k_stride) {
+      ASSERT_EQ(buf[i], char('0' + i / block_size + 1));
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, OpenInvalidBlockFile) {
+  constexpr std::size_t block_size = METALL_SEGMENT_BLOCK_SIZE;
+  constexpr std::size_t vm_size = block_size * 4;
+  prepare_test_dir();
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(block_size * 2));
+  }
+
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(test_file_prefix())) {
+    if (entry.path().filename() == "block-1") {
+      std::filesystem::resize_file(entry.path(), 100);
+    }
+  }
+
+  {
+    segment_storage_type data_storage;
+    ASSERT_FALSE(data_storage.open(test_file_prefix(), vm_size, false));
+    ASSERT_FALSE(data_storage.is_open());
+  }
+}
+
+TEST(MultifileSegmentStorageTest, NumaPolicy) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+
+  segment_storage_type data_storage;
+  ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+  ASSERT_TRUE(data_storage.extend(vm_size));
+  auto buf = static_cast<char *>(data_storage.get_segment());
+  for (std::size_t i = 0; i < vm_size; ++i) {
+    buf[i] = '1';
+  }
+#if METALL_SUPPORT_NUMA_POLICY
+#if defined(METALL_SEGMENT_NUMA_INTERLEAVE)
+  ASSERT_EQ(metall::mtlldetail::numa::get_policy(buf), MPOL_INTERLEAVE);
+#elif defined(METALL_SEGMENT_NUMA_BIND_RANGE_SIZE)
+  ASSERT_EQ(metall::mtlldetail::numa::get_policy(buf), MPOL_BIND);
+#else
+  ASSERT_EQ(metall::mtlldetail::numa::get_policy(buf), MPOL_DEFAULT);
+#endif
+#endif
+  ASSERT_TRUE(data_storage.sync(true));
+}
+
+TEST(MultifileSegmentStorageTest, Persist) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(vm_size));
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      buf[i] = '1';
+    }
+    // Not aligned to the cache lines or pages
+    ASSERT_TRUE(data_storage.persist(3, 100));
+    ASSERT_TRUE(data_storage.persist(0, vm_size));
+
+    // Clipped to the segment
+    ASSERT_TRUE(data_storage.persist(data_storage.size() - 1, vm_size));
+    ASSERT_TRUE(data_storage.persist(data_storage.size(), 1));
+    ASSERT_FALSE(data_storage.persist(-1, 1));
+#ifndef METALL_USE_DAX
+    ASSERT_FALSE(data_storage.dax_mapped());
+#endif
+  }
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), vm_size, false));
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      ASSERT_EQ(buf[i], '1');
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, GrowCapacity) {
+  constexpr std::size_t block_size = METALL_SEGMENT_BLOCK_SIZE;
+  prepare_test_dir();
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), block_size * 2));
+    // The reservation grows if the address space after it is free
+    if (!data_storage.extend(block_size * 8)) {
+      ASSERT_TRUE(data_storage.extend(block_size * 2));
+      GTEST_SKIP() << "The address space after the segment is in use";
+    }
+    ASSERT_EQ(data_storage.size(), block_size * 8);
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < block_size * 8; i += 4096) buf[i] = 1;
+  }
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(test_file_prefix(), block_size * 8, true));
+    auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < block_size * 8; i += 4096) {
+      ASSERT_EQ(buf[i], 1);
+    }
+  }
+}
+
+TEST(MultifileSegmentStorageTest, SnapshotDirect) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+  const std::string snapshot_path(test_file_prefix() + "_snapshot");
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+    ASSERT_TRUE(data_storage.extend(vm_size));
+    auto buf = static_cast<char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      buf[i] = char('0' + i % 10);
+    }
+    // The pages not resident are read from the file
+    ASSERT_TRUE(data_storage.sync(true));
+    ASSERT_TRUE(metall::mtlldetail::uncommit_shared_pages(buf + vm_size / 2,
+                                                          vm_size / 2));
+    ASSERT_TRUE(data_storage.snapshot_direct(snapshot_path, 2));
+  }
+  {
+    segment_storage_type data_storage;
+    ASSERT_TRUE(data_storage.open(snapshot_path, vm_size, true));
+    ASSERT_GE(data_storage.size(), vm_size);
+    auto buf = static_cast<const char *>(data_storage.get_segment());
+    for (std::size_t i = 0; i < vm_size; ++i) {
+      ASSERT_EQ(buf[i], char('0' + i % 10));
+    }
+  }
+}
+
+std::string read_block_file(const std::size_t block_no) {
+  const auto name = "block-" + std::to_string(block_no);
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(test_file_prefix())) {
+    if (entry.path().filename() != name) continue;
+    std::ifstream ifs(entry.path());
+    return std::string(std::istreambuf_iterator<char>(ifs), {});
+  }
+  return std::string();
+}
+
+TEST(MultifileSegmentStorageTest, WriteBackCache) {
+  static_assert(metall::kernel::has_write_back_cache_v<segment_storage_type>);
+  constexpr std::size_t block_size = 1ULL << 20ULL;
+  constexpr std::size_t vm_size = block_size * 4;
+  prepare_test_dir();
+
+  segment_storage_type data_storage;
+  ASSERT_TRUE(data_storage.set_block_size(block_size));
+  // Only the first two blocks are cached
+  data_storage.set_write_back_cache(true, block_size * 2);
+  ASSERT_TRUE(data_storage.write_back_cache());
+  ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+  ASSERT_TRUE(data_storage.extend(vm_size));
+  auto buf = static_cast<char *>(data_storage.get_segment());
+  // Leaves a page zero in every block
+  const auto page_size = data_storage.page_size();
+  for (std::size_t i = 0; i < vm_size; ++i) {
+    buf[i] = (i % block_size < std::size_t(page_size)) ? 0 : char('a' + i % 7);
+  }
+
+  // Takes the block layout from the files as blocks grow geometrically if
+  // METALL_USE_GEOMETRIC_BLOCK_GROWTH is defined
+  std::vector<std::size_t> block_offsets{0};
+  for (std::size_t b = 0; block_offsets.back() < vm_size; ++b) {
+    const auto size = read_block_file(b).size();
+    ASSERT_GT(size, 0);
+    block_offsets.push_back(block_offsets.back() + size);
+  }
+  ASSERT_EQ(block_offsets.back(), vm_size);
+  const auto num_blocks = block_offsets.size() - 1;
+  const auto block_content = [&](const std::size_t b) {
+    return std::string(buf + block_offsets[b],
+                       block_offsets[b + 1] - block_offsets[b]);
+  };
+  // The first block is cached; the last one is not
+  ASSERT_EQ(read_block_file(0), std::string(block_offsets[1], 0));
+  ASSERT_EQ(read_block_file(num_blocks - 1), block_content(num_blocks - 1));
+
+  ASSERT_TRUE(data_storage.sync(true));
+  for (std::size_t b = 0; b < num_blocks; ++b) {
+    ASSERT_EQ(read_block_file(b), block_content(b));
+  }
+  // The blocks are mapped from their files after the sync
+  buf[page_size] = 'x';
+  ASSERT_TRUE(data_storage.sync(true));
+  ASSERT_EQ(read_block_file(0)[page_size], 'x');
+}
+
+TEST(MultifileSegmentStorageTest, Volatile) {
+  static_assert(metall::kernel::has_volatile_mode_v<segment_storage_type>);
+  constexpr std::size_t vm_size = 1ULL << 24ULL;
+  prepare_test_dir();
+
+  segment_storage_type data_storage;
+  ASSERT_TRUE(data_storage.create_volatile(test_file_prefix(), vm_size));
+  ASSERT_TRUE(data_storage.volatile_segment());
+  ASSERT_TRUE(data_storage.extend(vm_size));
+  auto buf = static_cast<char *>(data_storage.get_segment());
+  // Leaves the second half zero so that its pages are not written
+  for (std::size_t i = 0; i < vm_size / 2; ++i) {
+    buf[i] = char('0' + i % 10);
+  }
+  ASSERT_TRUE(data_storage.sync(true));
+  ASSERT_EQ(num_block_files(), 0);
+  ASSERT_FALSE(data_storage.snapshot(test_dir() + "/snapshot", true, 1));
+
+  std::size_t num_spilled_bytes = 0;
+  ASSERT_TRUE(data_storage.spill(vm_size, &num_spilled_bytes));
+  ASSERT_EQ(num_spilled_bytes, 0);
+  ASSERT_TRUE(data_storage.spill(0, &num_spilled_bytes));
+  ASSERT_GT(num_spilled_bytes, 0);
+  ASSERT_GT(num_block_files(), 0);
+  for (std::size_t i = 0; i < vm_size; ++i) {
+    ASSERT_EQ(buf[i], i < vm_size / 2 ? char('0' + i % 10) : 0);
+  }
+  // The spilled blocks can still be written
+  buf[0] = 'x';
+  ASSERT_EQ(buf[0], 'x');
+  data_storage.release();
+  ASSERT_FALSE(data_storage.spill(0, nullptr));
+}
+
+TEST(MultifileSegmentStorageTest, BindToNumaNode) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+
+  segment_storage_type data_storage;
+  ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+  ASSERT_TRUE(data_storage.extend(vm_size));
+  auto buf = static_cast<char *>(data_storage.get_segment());
+  for (std::size_t i = 0; i < vm_size; ++i) {
+    buf[i] = '1';
+  }
+  ASSERT_FALSE(data_storage.bind_to_numa_node(-1, 1, 0));
+#if METALL_SUPPORT_NUMA_POLICY
+  const auto node = metall::mtlldetail::numa::allowed_nodes().back();
+  ASSERT_TRUE(data_storage.bind_to_numa_node(1, vm_size, node));
+  std::vector<int> nodes;
+  const auto page_size = data_storage.page_size();
+  ASSERT_TRUE(metall::mtlldetail::numa::page_nodes(
+      buf, vm_size / page_size, page_size, &nodes));
+  for (const auto n : nodes) ASSERT_EQ(n, node);
+#endif
+  ASSERT_TRUE(data_storage.sync(true));
+}
+
+TEST(MultifileSegmentStorageTest, Pin) {
+  constexpr std::size_t vm_size = 1ULL << 22ULL;
+  prepare_test_dir();
+
+  segment_storage_type data_storage;
+  ASSERT_TRUE(data_storage.create(test_file_prefix(), vm_size));
+  ASSERT_TRUE(data_storage.extend(vm_size));
+  const auto page_size = data_storage.page_size();
+  ASSERT_EQ(data_storage.pinned_size(), 0);
+
+  // Rounded to the page boundaries
+  ASSERT_TRUE(data_storage.pin(1, page_size));
+  ASSERT_EQ(data_storage.pinned_size(), page_size * 2);
+
+  // Overlapping and adjacent regions are merged
+  ASSERT_TRUE(data_storage.pin(page_size, page_size * 2));
+  ASSERT_EQ(data_storage.pinned_size(), page_size * 3);
+  ASSERT_TRUE(data_storage.pin(page_size * 4, page_size));
+  ASSERT_EQ(data_storage.pinned_size(), page_size * 4);
+
+  // Split a range
+  ASSERT_TRUE(data_storage.unpin(page_size, page_size));
+  ASSERT_EQ(data_storage.pinned_size(), page_size * 3);
+  ASSERT_TRUE(data_storage.unpin(0, vm_size));
+  ASSERT_EQ(data_storage.pinned_size(), 0);
+
+  // Clipped to the segment
+  ASSERT_TRUE(data_storage.pin(data_storage.size() - page_size, vm_size));
+  ASSERT_EQ(data_storage.pinned_size(), page_size);
+  ASSERT_FALSE(data_storage.pin(-1, 1));
+
+#if METALL_SEGMENT_MAX_PINNED_SIZE > 0
+  ASSERT_FALSE(data_storage.pin(0, METALL_SEGMENT_MAX_PINNED_SIZE));
+  ASSERT_EQ(data_storage.pinned_size(), page_size);
+#endif
+
+  auto buf = static_cast<char *>(data_storage.get_segment());
+  for (std::size_t i = 0; i < vm_size; ++i) {
+    buf[i] = '1';
+  }
+  ASSERT_TRUE(data_storage.sync(true));
+  ASSERT_EQ(data_storage.pinned_size(), page_size);
+#ifdef MADV_COLD
+  ASSERT_TRUE(data_storage.advise_cold(0, vm_size / 2));
+#endif
+}
+}  // namespace
@@ -0,0 +1,75 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include <metall/kernel/multilayer_bitset.hpp>
+#include <metall/kernel/slot_bitmap_pool.hpp>
+
+namespace {
+using pool_type = metall::kernel::slot_bitmap_pool;
+
+TEST(SlotBitmapPoolTest, Allocate) {
+  pool_type pool(2);
+  constexpr std::size_t k_num_blocks = 3;
+  std::vector<uint64_t *> list;
+  for (int i = 0; i < 100000; ++i) {
+    auto *const blocks = pool.allocate(0, k_num_blocks);
+    ASSERT_NE(blocks, nullptr);
+    ASSERT_TRUE(std::all_of(blocks, blocks + k_num_blocks,
+                            [](const uint64_t b) { return b == 0; }));
+    std::fill(blocks, blocks + k_num_blocks, ~uint64_t(0));
+    list.push_back(blocks);
+  }
+  // Contiguous in a slab
+  ASSERT_EQ(list[1], list[0] + k_num_blocks);
+  ASSERT_LT(pool.num_slabs(), std::size_t(10));
+
+  std::set<uint64_t *> unique(list.begin(), list.end());
+  ASSERT_EQ(unique.size(), list.size());
+
+  // Reused and zero-filled again
+  pool.deallocate(0, list[10]);
+  auto *const blocks = pool.allocate(0, k_num_blocks);
+  ASSERT_EQ(blocks, list[10]);
+  ASSERT_TRUE(std::all_of(blocks, blocks + k_num_blocks,
+                          [](const uint64_t b) { return b == 0; }));
+
+  // The other class has its own slabs
+  const auto num_slabs = pool.num_slabs();
+  ASSERT_NE(pool.allocate(1, 100), nullptr);
+  ASSERT_EQ(pool.num_slabs(), num_slabs + 1);
+
+  pool.clear();
+  ASSERT_EQ(pool.num_slabs(), std::size_t(0));
+}
+
+TEST(SlotBitmapPoolTest, MultilayerBitset) {
+  pool_type pool(1);
+  constexpr std::size_t k_num_bits = 64 * 64 * 4;
+  const auto num_blocks =
+      metall::kernel::multilayer_bitset::num_blocks(k_num_bits);
+  metall::kernel::multilayer_bitset bitset;
+  auto *const blocks = pool.allocate(0, num_blocks);
+  bitset.assign(k_num_bits, blocks);
+  for (std::size_t i = 0; i < k_num_bits; ++i) {
+    ASSERT_EQ(bitset.find_and_set(k_num_bits), i);
+  }
+  bitset.reset(k_num_bits, 100);
+  ASSERT_EQ(bitset.find_and_set(k_num_bits), std::size_t(100));
+  ASSERT_EQ(bitset.release(k_num_bits), blocks);
+  pool.deallocate(0, blocks);
+
+  // A small bitset does not use the blocks
+  bitset.assign(64, nullptr);
+  ASSERT_EQ(bitset.find_and_set(64), std::size_t(0));
+  ASSERT_EQ(bitset.release(64), nullptr);
+}
+}  // namespace
@@ -6,6 +6,9 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <utility>
+#include <vector>
+#include <fstream>
 #include <filesystem>
 
 #include <metall/metall.hpp>
@@ -81,4 +84,328 @@ TEST(SnapshotTest, Snapshot) {
     ASSERT_EQ(*c, 3.5);
   }
 }
-}  // namespace
\ No newline at end of file
+
+TEST(SnapshotTest, DeallocatedObjects) {
+  metall::manager::remove(original_dir_path());
+  const auto snapshot_dir = snapshot_dir_path("-dealloc");
+  constexpr std::size_t k_num_objects = 1 << 14;
+  {
+    metall::manager manager(metall::create_only, original_dir_path());
+    auto *offsets =
+        manager.construct<std::ptrdiff_t>("offsets")[k_num_objects / 2]();
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 0; i < k_num_objects; ++i) {
+      auto *const p = static_cast<char *>(manager.allocate(8 + i % 64));
+      if (i % 2 == 0) {
+        offsets[i / 2] = p - base;
+      } else {
+        manager.deallocate(p);  // Can stay in the object cache
+      }
+    }
+    ASSERT_TRUE(manager.snapshot(snapshot_dir));
+  }
+
+  // The deallocated objects must be free in the snapshot
+  {
+    metall::manager manager(metall::open_only, snapshot_dir);
+    auto *offsets = manager.find<std::ptrdiff_t>("offsets").first;
+    ASSERT_NE(offsets, nullptr);
+    auto *const base = static_cast<const char *>(manager.get_address());
+    for (std::size_t i = 0; i < k_num_objects / 2; ++i) {
+      manager.deallocate(const_cast<char *>(base + offsets[i]));
+    }
+    ASSERT_TRUE(manager.destroy<std::ptrdiff_t>("offsets"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(SnapshotTest, Incremental) {
+  metall::manager::remove(original_dir_path());
+  const auto snapshot_dir0 = snapshot_dir_path("-inc0");
+  const auto snapshot_dir1 = snapshot_dir_path("-inc1");
+  const auto snapshot_dir2 = snapshot_dir_path("-inc2");
+  constexpr std::size_t k_array_size = 1 << 20;
+  constexpr std::size_t k_large_size = METALL_SEGMENT_BLOCK_SIZE;
+
+  const auto file_size = [](const fs::path &dir, const std::string &name) {
+    std::size_t size = 0;
+    for (const auto &entry : fs::recursive_directory_iterator(dir)) {
+      if (entry.path().filename() == name) size += entry.file_size();
+    }
+    return size;
+  };
+
+  {
+    metall::manager manager(metall::create_only, original_dir_path());
+    auto *array = manager.construct<int>("array")[k_array_size](0);
+
+    // The first one is a full snapshot
+    ASSERT_TRUE(manager.snapshot_incremental(snapshot_dir0));
+    ASSERT_TRUE(metall::manager::consistent(snapshot_dir0));
+
+    for (std::size_t i = 0; i < 16; ++i) array[i] = 1;
+    manager.construct<int>("int")(10);
+    ASSERT_TRUE(manager.snapshot_incremental(snapshot_dir1));
+    ASSERT_TRUE(metall::manager::consistent(snapshot_dir1));
+    ASSERT_NE(metall::manager::get_uuid(snapshot_dir0),
+              metall::manager::get_uuid(snapshot_dir1));
+    if (metall::mtlldetail::soft_dirty_bit_supported()) {
+      ASSERT_GT(file_size(snapshot_dir1, "delta-data"), 0);
+      ASSERT_LT(file_size(snapshot_dir1, "delta-data"),
+                k_array_size * sizeof(int));
+    }
+
+    // Extends the segment
+    auto *const large = static_cast<char *>(manager.allocate(k_large_size));
+    ASSERT_NE(large, nullptr);
+    large[0] = 'a';
+    large[k_large_size - 1] = 'z';
+    manager.construct<std::ptrdiff_t>("large")(
+        large - static_cast<const char *>(manager.get_address()));
+    array[k_array_size - 1] = 2;
+    ASSERT_TRUE(manager.snapshot_incremental(snapshot_dir2));
+    ASSERT_TRUE(metall::manager::consistent(snapshot_dir2));
+
+    array[0] = 3;
+  }
+
+  // The base of the snapshots must not be modified
+  {
+    metall::manager manager(metall::open_only, snapshot_dir0);
+    ASSERT_FALSE(manager.check_sanity());
+  }
+
+  // Modifying a snapshot in the middle does not affect its descendants.
+  // Without the soft-dirty bits, every snapshot is a full (base) snapshot.
+  const bool delta = metall::mtlldetail::soft_dirty_bit_supported();
+  {
+    metall::manager manager(
+        delta ? metall::manager(metall::open_only, snapshot_dir1)
+              : metall::manager(metall::open_read_only, snapshot_dir1));
+    ASSERT_TRUE(manager.check_sanity());
+    auto *array = manager.find<int>("array").first;
+    ASSERT_EQ(array[0], 1);
+    ASSERT_EQ(array[16], 0);
+    ASSERT_EQ(array[k_array_size - 1], 0);
+    ASSERT_EQ(*(manager.find<int>("int").first), 10);
+    ASSERT_EQ(manager.find<std::ptrdiff_t>("large").first, nullptr);
+    if (delta) array[16] = 4;
+  }
+
+  {
+    metall::manager manager(metall::open_read_only, snapshot_dir2);
+    ASSERT_TRUE(manager.check_sanity());
+    const auto *array = manager.find<int>("array").first;
+    ASSERT_EQ(array[0], 1);
+    ASSERT_EQ(array[15], 1);
+    ASSERT_EQ(array[16], 0);
+    ASSERT_EQ(array[k_array_size - 1], 2);
+    ASSERT_EQ(*(manager.find<int>("int").first), 10);
+    const auto *const large =
+        static_cast<const char *>(manager.get_address()) +
+        *(manager.find<std::ptrdiff_t>("large").first);
+    ASSERT_EQ(large[0], 'a');
+    ASSERT_EQ(large[k_large_size - 1], 'z');
+  }
+
+  {
+    metall::manager manager(metall::open_read_only, snapshot_dir0);
+    ASSERT_TRUE(manager.check_sanity());
+    const auto *array = manager.find<int>("array").first;
+    ASSERT_EQ(array[0], 0);
+    ASSERT_EQ(manager.find<int>("int").first, nullptr);
+  }
+}
+
+TEST(SnapshotTest, Replication) {
+  metall::manager::remove(original_dir_path());
+  const auto replica_dir = snapshot_dir_path("-replica");
+  metall::manager::remove(replica_dir);
+  constexpr std::size_t k_array_size = 1 << 20;
+  constexpr std::size_t k_large_size = METALL_SEGMENT_BLOCK_SIZE;
+  const bool delta = metall::mtlldetail::soft_dirty_bit_supported();
+
+  // The streams are kept in files as a full one has the whole segment
+  int num_streams = 0;
+  const auto replicate = [&num_streams](metall::manager &manager,
+                                        const bool full = false) {
+    const auto path = snapshot_dir_path("-stream" +
+                                        std::to_string(num_streams++));
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    EXPECT_TRUE(manager.replicate(ofs, full));
+    return path;
+  };
+  const auto apply = [&replica_dir](const fs::path &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return metall::manager::apply_replication(replica_dir, ifs);
+  };
+
+  metall::manager manager(metall::create_only, original_dir_path());
+  auto *array = manager.construct<int>("array")[k_array_size](0);
+
+  // The first stream has the whole data store
+  const auto image0 = replicate(manager);
+  ASSERT_GT(fs::file_size(image0), k_array_size * sizeof(int));
+  ASSERT_TRUE(apply(image0));
+  {
+    metall::manager replica(metall::open_read_only, replica_dir);
+    ASSERT_TRUE(replica.check_sanity());
+    ASSERT_EQ(replica.get_uuid(), manager.get_uuid());
+    ASSERT_EQ(replica.find<int>("array").first[0], 0);
+  }
+
+  for (std::size_t i = 0; i < 16; ++i) array[i] = 1;
+  manager.construct<int>("int")(10);
+  auto *const large = static_cast<char *>(manager.allocate(k_large_size));
+  ASSERT_NE(large, nullptr);
+  large[k_large_size - 1] = 'z';
+  manager.construct<std::ptrdiff_t>("large")(
+      large - static_cast<const char *>(manager.get_address()));
+  const auto image1 = replicate(manager);
+  if (delta) {
+    ASSERT_LT(fs::file_size(image1), k_array_size * sizeof(int));
+  }
+  ASSERT_TRUE(apply(image1));
+  {
+    metall::manager replica(metall::open_read_only, replica_dir);
+    ASSERT_TRUE(replica.check_sanity());
+    const auto *array = replica.find<int>("array").first;
+    ASSERT_EQ(array[15], 1);
+    ASSERT_EQ(array[16], 0);
+    ASSERT_EQ(*(replica.find<int>("int").first), 10);
+    const auto *const replica_large =
+        static_cast<const char *>(replica.get_address()) +
+        *(replica.find<std::ptrdiff_t>("large").first);
+    ASSERT_EQ(replica_large[k_large_size - 1], 'z');
+  }
+
+  // A stream is applied only once and in order
+  array[16] = 2;
+  const auto image2 = replicate(manager);
+  array[17] = 3;
+  const auto image3 = replicate(manager);
+  if (delta) {
+    ASSERT_FALSE(apply(image1));
+    ASSERT_FALSE(apply(image3));
+  }
+  ASSERT_TRUE(apply(image2));
+  ASSERT_TRUE(apply(image3));
+  {
+    metall::manager replica(metall::open_only, replica_dir);
+    const auto *array = replica.find<int>("array").first;
+    ASSERT_EQ(array[16], 2);
+    ASSERT_EQ(array[17], 3);
+  }
+
+  // The replica opened with the write mode needs a full stream
+  array[18] = 4;
+  if (delta) {
+    ASSERT_FALSE(apply(replicate(manager)));
+  }
+  manager.destroy<int>("int");
+  ASSERT_TRUE(apply(replicate(manager, true)));
+  {
+    metall::manager replica(metall::open_read_only, replica_dir);
+    const auto *array = replica.find<int>("array").first;
+    ASSERT_EQ(array[18], 4);
+    ASSERT_EQ(replica.find<int>("int").first, nullptr);
+  }
+
+  for (int i = 0; i < num_streams; ++i) {
+    fs::remove(snapshot_dir_path("-stream" + std::to_string(i)));
+  }
+}
+
+TEST(SnapshotTest, Diff) {
+  metall::manager::remove(original_dir_path());
+  const auto snapshot_dir0 = snapshot_dir_path("-diff0");
+  const auto snapshot_dir1 = snapshot_dir_path("-diff1");
+  // Spans more chunks than the ones changed
+  constexpr std::size_t k_array_size = 1 << 23;
+  constexpr std::size_t k_chunk_size = metall::manager::chunk_size();
+
+  std::size_t first_offset;
+  std::size_t last_offset;
+  {
+    metall::manager manager(metall::create_only, original_dir_path());
+    auto *array = manager.construct<int>("array")[k_array_size](0);
+    ASSERT_TRUE(manager.snapshot(snapshot_dir0));
+
+    array[0] = 1;
+    array[k_array_size - 1] = 2;
+    ASSERT_TRUE(manager.snapshot(snapshot_dir1));
+
+    const auto *const base = static_cast<const char *>(manager.get_address());
+    first_offset = reinterpret_cast<const char *>(&array[0]) - base;
+    last_offset = reinterpret_cast<const char *>(&array[k_array_size - 1]) -
+                  base;
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  ASSERT_TRUE(metall::manager::diff(snapshot_dir0, snapshot_dir0, &ranges));
+  ASSERT_TRUE(ranges.empty());
+
+  ASSERT_TRUE(metall::manager::diff(snapshot_dir0, snapshot_dir1, &ranges));
+  const auto changed = [&ranges](const std::size_t offset) {
+    for (const auto &[first, length] : ranges) {
+      if (first <= offset && offset < first + length) return true;
+    }
+    return false;
+  };
+  ASSERT_TRUE(changed(first_offset));
+  ASSERT_TRUE(changed(last_offset));
+  std::size_t total = 0;
+  for (const auto &[offset, length] : ranges) {
+    ASSERT_EQ(offset % k_chunk_size, 0);
+    ASSERT_EQ(length % k_chunk_size, 0);
+    total += length;
+  }
+  ASSERT_LT(total, k_array_size * sizeof(int));
+}
+
+TEST(SnapshotTest, Compress) {
+  metall::manager::remove(original_dir_path());
+  const auto snapshot_dir = snapshot_dir_path("-compressed");
+  constexpr std::size_t k_array_size = 1 << 20;
+  {
+    metall::manager manager(metall::create_only, original_dir_path());
+    auto *array = manager.construct<int>("array")[k_array_size](0);
+    for (std::size_t i = 0; i < k_array_size; i += 1024) array[i] = int(i);
+    ASSERT_TRUE(manager.snapshot(snapshot_dir));
+  }
+
+  if (!metall::mtlldetail::zstd::enabled()) {
+    ASSERT_FALSE(metall::manager::compress(snapshot_dir));
+    return;
+  }
+
+  ASSERT_TRUE(metall::manager::compress(snapshot_dir));
+  bool found_block = false;
+  for (const auto &entry : fs::recursive_directory_iterator(snapshot_dir)) {
+    const auto name = entry.path().filename().string();
+    if (name.rfind("block-", 0) != 0) continue;
+    ASSERT_EQ(entry.path().extension(), ".zst");
+    found_block = true;
+  }
+  ASSERT_TRUE(found_block);
+  ASSERT_TRUE(metall::manager::consistent(snapshot_dir));
+
+  // Decompressed on open
+  {
+    metall::manager manager(metall::open_read_only, snapshot_dir);
+    ASSERT_TRUE(manager.check_sanity());
+    const auto *array = manager.find<int>("array").first;
+    for (std::size_t i = 0; i < k_array_size; ++i) {
+      ASSERT_EQ(array[i], (i % 1024 == 0) ? int(i) : 0);
+    }
+  }
+
+  ASSERT_TRUE(metall::manager::compress(snapshot_dir));
+  ASSERT_TRUE(metall::manager::decompress(snapshot_dir));
+  {
+    metall::manager manager(metall::open_only, snapshot_dir);
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_EQ(manager.find<int>("array").first[1024], 1024);
+  }
+}
+}  // namespace
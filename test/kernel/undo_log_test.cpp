@@ -0,0 +1,146 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <metall/kernel/undo_log.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+namespace fs = std::filesystem;
+using metall::kernel::undo_log;
+
+constexpr std::size_t k_segment_size = undo_log::k_line_size * 16;
+
+struct segment_type {
+  std::vector<char> data = std::vector<char>(k_segment_size, 0);
+  std::vector<std::pair<uint64_t, uint64_t>> persisted;
+
+  undo_log::restore_function_type restore() {
+    return [this](const uint64_t offset, const char *const src,
+                  const uint64_t size) {
+      std::memcpy(data.data() + offset, src, size);
+      return true;
+    };
+  }
+
+  undo_log::persist_function_type persist() {
+    return [this](const uint64_t offset, const uint64_t size) {
+      persisted.emplace_back(offset, size);
+      return true;
+    };
+  }
+};
+
+fs::path log_path() {
+  return test_utility::make_test_path("undo_log");
+}
+
+TEST(UndoLogTest, Commit) {
+  segment_type segment;
+  undo_log log;
+  ASSERT_FALSE(log.add(segment.data.data(), 0, 1, k_segment_size));
+  ASSERT_FALSE(log.commit(segment.persist()));
+
+  ASSERT_TRUE(log.begin(log_path()));
+  ASSERT_TRUE(log.active());
+  ASSERT_FALSE(log.begin(log_path()));
+  ASSERT_TRUE(fs::exists(log_path()));
+
+  // Extended to cache lines; the adjacent ones are merged
+  ASSERT_TRUE(log.add(segment.data.data(), 10, 4, k_segment_size));
+  ASSERT_TRUE(log.add(segment.data.data(), 64, 64, k_segment_size));
+  ASSERT_TRUE(log.add(segment.data.data(), 300, 1, k_segment_size));
+  ASSERT_TRUE(log.commit(segment.persist()));
+  ASSERT_FALSE(log.active());
+  ASSERT_FALSE(fs::exists(log_path()));
+
+  ASSERT_EQ(segment.persisted.size(), std::size_t(2));
+  ASSERT_EQ(segment.persisted[0], std::make_pair(uint64_t(0), uint64_t(128)));
+  ASSERT_EQ(segment.persisted[1],
+            std::make_pair(uint64_t(256), uint64_t(64)));
+}
+
+TEST(UndoLogTest, Abort) {
+  segment_type segment;
+  undo_log log;
+  ASSERT_TRUE(log.begin(log_path()));
+  ASSERT_TRUE(log.add(segment.data.data(), 0, 128, k_segment_size));
+  segment.data[0] = 1;
+  segment.data[100] = 1;
+
+  // Only the first contents in the transaction are kept
+  ASSERT_TRUE(log.add(segment.data.data(), 0, 256, k_segment_size));
+  segment.data[0] = 2;
+  segment.data[200] = 2;
+
+  ASSERT_TRUE(log.abort(segment.restore(), segment.persist()));
+  ASSERT_FALSE(log.active());
+  ASSERT_FALSE(fs::exists(log_path()));
+  for (const auto c : segment.data) ASSERT_EQ(c, 0);
+}
+
+TEST(UndoLogTest, RollBack) {
+  segment_type segment;
+  {
+    undo_log log;
+    ASSERT_TRUE(log.begin(log_path()));
+    ASSERT_TRUE(log.add(segment.data.data(), 0, 64, k_segment_size));
+    segment.data[0] = 1;
+    ASSERT_TRUE(log.add(segment.data.data(), 64, 64, k_segment_size));
+    segment.data[64] = 1;
+    // Destroyed without committing, as in a crash
+  }
+  ASSERT_TRUE(fs::exists(log_path()));
+
+  // A torn record at the end is ignored
+  const auto size = fs::file_size(log_path());
+  fs::resize_file(log_path(), size - 1);
+  ASSERT_TRUE(undo_log::roll_back(log_path(), segment.restore()));
+  ASSERT_EQ(segment.data[0], 0);
+  ASSERT_EQ(segment.data[64], 1);
+
+  // A log without a header has nothing to roll back
+  fs::resize_file(log_path(), 4);
+  segment.data[0] = 1;
+  ASSERT_TRUE(undo_log::roll_back(log_path(), segment.restore()));
+  ASSERT_EQ(segment.data[0], 1);
+
+  fs::remove(log_path());
+  ASSERT_FALSE(undo_log::roll_back(log_path(), segment.restore()));
+}
+
+// The logs written before the checksum switched to wyhash
+TEST(UndoLogTest, RollBackMurmurFormat) {
+  segment_type segment;
+  segment.data[0] = 1;
+  const std::vector<char> old_contents(64, 7);
+  {
+    std::ofstream ofs(log_path(), std::ios::binary | std::ios::trunc);
+    const uint64_t format_version = 1;
+    ofs.write("MTLLUNDO", 8);
+    ofs.write(reinterpret_cast<const char *>(&format_version),
+              sizeof(format_version));
+    const uint64_t offset = 0;
+    const uint64_t size = old_contents.size();
+    const uint64_t record[3] = {
+        offset, size,
+        metall::mtlldetail::murmur_hash_64a(old_contents.data(), int(size),
+                                            offset ^ (size << 32ULL))};
+    ofs.write(reinterpret_cast<const char *>(record), sizeof(record));
+    ofs.write(old_contents.data(), old_contents.size());
+  }
+  ASSERT_TRUE(undo_log::roll_back(log_path(), segment.restore()));
+  ASSERT_EQ(segment.data[0], 7);
+  ASSERT_EQ(segment.data[63], 7);
+  fs::remove(log_path());
+}
+}  // namespace
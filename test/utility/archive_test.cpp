@@ -0,0 +1,147 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include <metall/metall.hpp>
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/container/segmented_vector.hpp>
+#include <metall/utility/archive.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mu = metall::utility;
+
+struct point {
+  double x;
+  double y;
+};
+
+using vector_type = metall::container::vector<uint64_t>;
+using string_type = metall::container::string;
+using segmented_vector_type = metall::container::segmented_vector<
+    int32_t, metall::manager::allocator_type<int32_t>, 16>;
+
+void write_archive(std::ostream &out, const mu::archive_options &options) {
+  const auto dir_path(test_utility::make_test_path("source"));
+  metall::manager::remove(dir_path);
+  metall::manager manager(metall::create_only, dir_path);
+
+  manager.construct<point>("point")(point{1.5, -2.5});
+  auto *const points = manager.construct<point>("points")[3]();
+  for (int i = 0; i < 3; ++i) points[i] = point{double(i), double(-i)};
+
+  auto *const vec =
+      manager.construct<vector_type>("vec")(manager.get_allocator());
+  // Spans multiple blocks
+  for (uint64_t i = 0; i < (1ULL << 20); ++i) vec->push_back(i * 3);
+
+  manager.construct<string_type>("str")("archived string",
+                                        manager.get_allocator());
+
+  auto *const seg = manager.construct<segmented_vector_type>("seg")(
+      manager.get_allocator());
+  for (int i = 0; i < 1000; ++i) seg->push_back(-i);
+
+  mu::archive_writer writer(out, options);
+  ASSERT_TRUE(writer.good());
+  ASSERT_TRUE(writer.write_named<point>(manager, "point"));
+  ASSERT_TRUE(writer.write_named<point>(manager, "points"));
+  ASSERT_TRUE(writer.write_named<vector_type>(manager, "vec"));
+  ASSERT_TRUE(writer.write_named<string_type>(manager, "str"));
+  ASSERT_TRUE(writer.write_named<segmented_vector_type>(manager, "seg"));
+  ASSERT_FALSE(writer.write_named<point>(manager, "not_exist"));
+  const int raw[4] = {1, 2, 3, 4};
+  ASSERT_TRUE(writer.write("raw", raw, 4));
+  ASSERT_TRUE(writer.close());
+}
+
+void read_archive(std::istream &in) {
+  const auto dir_path(test_utility::make_test_path("destination"));
+  metall::manager::remove(dir_path);
+  metall::manager manager(metall::create_only, dir_path);
+
+  mu::archive_reader reader(in);
+  ASSERT_TRUE(reader.good());
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.name(), "point");
+  const auto *const p = reader.load<point>(manager);
+  ASSERT_NE(p, nullptr);
+  ASSERT_EQ(p->x, 1.5);
+  ASSERT_EQ(p->y, -2.5);
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.name(), "points");
+  ASSERT_EQ(reader.length(), 3);
+  ASSERT_NE(reader.load<point>(manager), nullptr);
+  const auto [points, num_points] = manager.find<point>("points");
+  ASSERT_EQ(num_points, 3);
+  for (int i = 0; i < 3; ++i) ASSERT_EQ(points[i].x, i);
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.load<int>(manager), nullptr);  // Wrong type
+  ASSERT_TRUE(reader.good());
+  ASSERT_NE(reader.load<vector_type>(manager), nullptr);
+  const auto *const vec = manager.find<vector_type>("vec").first;
+  ASSERT_EQ(vec->size(), 1ULL << 20);
+  for (uint64_t i = 0; i < vec->size(); ++i) ASSERT_EQ((*vec)[i], i * 3);
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(*reader.load<string_type>(manager), "archived string");
+
+  ASSERT_TRUE(reader.next());
+  const auto *const seg = reader.load<segmented_vector_type>(manager);
+  ASSERT_EQ(seg->size(), 1000);
+  for (int i = 0; i < 1000; ++i) ASSERT_EQ((*seg)[i], -i);
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.name(), "raw");  // Not loaded
+  ASSERT_FALSE(reader.next());
+  ASSERT_TRUE(reader.good());
+  ASSERT_EQ(manager.find<int>("raw").first, nullptr);
+}
+
+TEST(ArchiveTest, WriteAndRead) {
+  std::stringstream stream;
+  write_archive(stream, mu::archive_options{0, 0});
+  read_archive(stream);
+}
+
+TEST(ArchiveTest, Compressed) {
+  std::stringstream stream;
+  write_archive(stream, mu::archive_options{3, 2});
+  read_archive(stream);
+}
+
+TEST(ArchiveTest, Broken) {
+  std::stringstream stream;
+  write_archive(stream, mu::archive_options{0, 0});
+  const auto data = stream.str();
+
+  {
+    std::stringstream in("not an archive");
+    mu::archive_reader reader(in);
+    ASSERT_FALSE(reader.good());
+    ASSERT_FALSE(reader.next());
+  }
+
+  {
+    // Truncated in the middle of the vector
+    std::stringstream in(data.substr(0, data.size() / 2));
+    mu::archive_reader reader(in);
+    while (reader.next()) {
+    }
+    ASSERT_FALSE(reader.good());
+  }
+}
+
+}  // namespace
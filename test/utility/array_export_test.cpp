@@ -0,0 +1,128 @@
+// Copyright 2024 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/container/segmented_vector.hpp>
+#include <metall/utility/array_export.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mu = metall::utility;
+
+TEST(ArrayExportTest, Format) {
+  ASSERT_STREQ(mu::arrow_format<double>(), "g");
+  ASSERT_STREQ(mu::arrow_format<float>(), "f");
+  ASSERT_STREQ(mu::arrow_format<int8_t>(), "c");
+  ASSERT_STREQ(mu::arrow_format<uint16_t>(), "S");
+  ASSERT_STREQ(mu::arrow_format<int32_t>(), "i");
+  ASSERT_STREQ(mu::arrow_format<uint64_t>(), "L");
+
+  ASSERT_EQ(mu::array_typestr<uint8_t>(), "|u1");
+  ASSERT_EQ(mu::array_typestr<int64_t>().substr(1), "i8");
+  ASSERT_EQ(mu::array_typestr<double>().substr(1), "f8");
+
+  ASSERT_EQ(mu::arrow_format_item_size("g"), 8);
+  ASSERT_EQ(mu::arrow_format_item_size("s"), 2);
+  ASSERT_EQ(mu::arrow_format_item_size("u"), 0);  // utf8 string
+  ASSERT_EQ(mu::arrow_format_item_size("gg"), 0);
+  ASSERT_EQ(mu::arrow_format_item_size(nullptr), 0);
+
+  ASSERT_EQ(mu::typestr_item_size(mu::array_typestr<double>().c_str()), 8);
+  ASSERT_EQ(mu::typestr_item_size("|u1"), 1);
+  ASSERT_EQ(mu::typestr_item_size("=i4"), 4);
+  ASSERT_EQ(mu::typestr_item_size("|i4"), 0);
+  ASSERT_EQ(mu::typestr_item_size("<c8"), 0);
+  ASSERT_EQ(mu::typestr_item_size("<f16"), 0);
+}
+
+TEST(ArrayExportTest, Vector) {
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager manager(metall::create_only, dir_path);
+
+  using vector_type = metall::container::vector<double>;
+  auto *vec = manager.construct<vector_type>("vec")(manager.get_allocator());
+  for (int i = 0; i < 10; ++i) vec->push_back(i);
+
+  const auto interface = mu::make_array_interface(*vec, true);
+  ASSERT_EQ(interface.data, metall::to_raw_pointer(vec->data()));
+  ASSERT_EQ(interface.length, 10);
+  ASSERT_EQ(interface.typestr, mu::array_typestr<double>());
+  ASSERT_TRUE(interface.read_only);
+  ASSERT_NE(interface.to_string().find("'shape': (10,)"), std::string::npos);
+  ASSERT_NE(interface.to_string().find("True)"), std::string::npos);
+
+  ArrowArray array;
+  ArrowSchema schema;
+  ASSERT_TRUE(mu::export_arrow_array(*vec, &array, &schema));
+  ASSERT_EQ(array.length, 10);
+  ASSERT_EQ(array.null_count, 0);
+  ASSERT_EQ(array.n_buffers, 2);
+  ASSERT_EQ(array.buffers[0], nullptr);
+  ASSERT_EQ(array.buffers[1], metall::to_raw_pointer(vec->data()));
+  ASSERT_STREQ(schema.format, "g");
+  ASSERT_EQ(schema.n_children, 0);
+
+  // Zero-copy: writes to the vector are visible through the array
+  (*vec)[3] = 30.0;
+  ASSERT_EQ(static_cast<const double *>(array.buffers[1])[3], 30.0);
+
+  array.release(&array);
+  schema.release(&schema);
+  ASSERT_EQ(array.release, nullptr);
+  ASSERT_EQ(schema.release, nullptr);
+  ASSERT_EQ(vec->size(), 10);  // Releasing does not touch the items
+
+  ASSERT_FALSE(mu::export_arrow_array(vec->data(), 1, "u", &array));
+}
+
+TEST(ArrayExportTest, SegmentedVector) {
+  using vector_type =
+      metall::container::segmented_vector<int32_t, std::allocator<int32_t>,
+                                          4>;
+  vector_type vec;
+  for (int i = 0; i < 20; ++i) vec.push_back(i);
+
+  const auto interfaces = mu::make_segment_array_interfaces(vec);
+  ASSERT_EQ(interfaces.size(), vec.num_segments());
+  std::size_t total = 0;
+  for (std::size_t s = 0; s < interfaces.size(); ++s) {
+    ASSERT_EQ(interfaces[s].data, vec.segment_data(s));
+    ASSERT_EQ(interfaces[s].length, vec.segment_size(s));
+    total += interfaces[s].length;
+  }
+  ASSERT_EQ(total, vec.size());
+
+  ArrowArrayStream stream;
+  ASSERT_TRUE(mu::export_arrow_array_stream(vec, &stream));
+  ArrowSchema schema;
+  ASSERT_EQ(stream.get_schema(&stream, &schema), 0);
+  ASSERT_STREQ(schema.format, "i");
+  schema.release(&schema);
+
+  int32_t expected = 0;
+  while (true) {
+    ArrowArray array;
+    ASSERT_EQ(stream.get_next(&stream, &array), 0);
+    if (!array.release) break;
+    const auto *items = static_cast<const int32_t *>(array.buffers[1]);
+    for (int64_t i = 0; i < array.length; ++i) {
+      ASSERT_EQ(items[i], expected++);
+    }
+    array.release(&array);
+  }
+  ASSERT_EQ(expected, 20);
+  ASSERT_EQ(stream.get_last_error(&stream), nullptr);
+  stream.release(&stream);
+  ASSERT_EQ(stream.release, nullptr);
+}
+
+}  // namespace
@@ -0,0 +1,171 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/csr_graph.hpp>
+#include <metall/utility/breadth_first_search.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace util = metall::utility;
+
+using edge_list_type = std::vector<std::pair<uint64_t, uint64_t>>;
+using graph_type = metall::container::csr_graph<uint64_t, uint64_t, false,
+                                                std::allocator<std::byte>>;
+using result_type = util::bfs_result<uint64_t>;
+
+/// \brief Makes a graph with a few hub vertices, so that the BFS goes
+/// bottom-up in the middle levels.
+edge_list_type make_edges(const uint64_t num_vertices,
+                          const std::size_t num_edges, const bool undirected) {
+  std::mt19937_64 rng(123);
+  edge_list_type edges;
+  for (std::size_t i = 0; i < num_edges; ++i) {
+    const uint64_t src = (rng() % 4 == 0) ? rng() % 16 : rng() % num_vertices;
+    const uint64_t dst = rng() % num_vertices;
+    edges.emplace_back(src, dst);
+    if (undirected) edges.emplace_back(dst, src);
+  }
+  return edges;
+}
+
+edge_list_type reverse_edges(const edge_list_type &edges) {
+  edge_list_type reversed;
+  for (const auto &[src, dst] : edges) reversed.emplace_back(dst, src);
+  return reversed;
+}
+
+std::vector<uint32_t> sequential_levels(const graph_type &graph,
+                                        const uint64_t num_vertices,
+                                        const uint64_t source) {
+  std::vector<uint32_t> level(num_vertices, result_type::k_infinite_level);
+  std::queue<uint64_t> queue;
+  level[source] = 0;
+  queue.push(source);
+  while (!queue.empty()) {
+    const auto u = queue.front();
+    queue.pop();
+    for (auto itr = graph.values_begin(u); itr != graph.values_end(u);
+         ++itr) {
+      if (level[*itr] != result_type::k_infinite_level) continue;
+      level[*itr] = level[u] + 1;
+      queue.push(*itr);
+    }
+  }
+  return level;
+}
+
+/// \brief Checks that the parent of each reached vertex is one level closer
+/// to the source and has an edge to the vertex.
+void validate_tree(const graph_type &graph, const uint64_t source,
+                   const result_type &result) {
+  ASSERT_EQ(result.parent[source], source);
+  std::size_t num_reached = 0;
+  uint32_t max_level = 0;
+  for (uint64_t v = 0; v < result.parent.size(); ++v) {
+    if (result.parent[v] == result_type::k_unreached) continue;
+    ++num_reached;
+    max_level = std::max(max_level, result.level[v]);
+    if (v == source) continue;
+    const auto p = result.parent[v];
+    ASSERT_EQ(result.level[p] + 1, result.level[v]);
+    ASSERT_TRUE(std::binary_search(graph.values_begin(p), graph.values_end(p),
+                                   v));
+  }
+  ASSERT_EQ(result.num_reached, num_reached);
+  ASSERT_EQ(result.num_levels, max_level + 1);
+}
+
+TEST(BreadthFirstSearchTest, Undirected) {
+  constexpr uint64_t k_num_vertices = 1 << 16;
+  std::vector<edge_list_type> edges{make_edges(k_num_vertices, 1 << 18, true)};
+  graph_type graph;
+  graph.build(edges, k_num_vertices);
+
+  for (const uint64_t source : {uint64_t(0), uint64_t(12345)}) {
+    const auto result = util::breadth_first_search(graph, k_num_vertices,
+                                                   source);
+    ASSERT_EQ(result.level, sequential_levels(graph, k_num_vertices, source));
+    validate_tree(graph, source, result);
+
+    // Top-down only
+    util::bfs_options options;
+    options.alpha = 1e-9;
+    const auto top_down = util::breadth_first_search(graph, k_num_vertices,
+                                                     source, options);
+    ASSERT_EQ(top_down.level, result.level);
+  }
+}
+
+TEST(BreadthFirstSearchTest, Directed) {
+  constexpr uint64_t k_num_vertices = 1 << 16;
+  std::vector<edge_list_type> edges{make_edges(k_num_vertices, 1 << 18, false)};
+  std::vector<edge_list_type> reversed{reverse_edges(edges[0])};
+  graph_type graph;
+  graph.build(edges, k_num_vertices);
+  graph_type reverse_graph;
+  reverse_graph.build(reversed, k_num_vertices);
+
+  // Bottom-up as much as possible
+  util::bfs_options options;
+  options.alpha = 1e9;
+  options.beta = 1e-9;
+  const auto result = util::breadth_first_search(
+      graph, reverse_graph, k_num_vertices, uint64_t(1), options);
+  ASSERT_EQ(result.level, sequential_levels(graph, k_num_vertices, 1));
+  validate_tree(graph, 1, result);
+}
+
+TEST(BreadthFirstSearchTest, IsolatedSource) {
+  std::vector<edge_list_type> edges{{{0, 1}, {1, 0}}};
+  graph_type graph;
+  graph.build(edges, 4);
+  const auto result = util::breadth_first_search(graph, 4, uint64_t(3));
+  ASSERT_EQ(result.num_levels, 1);
+  ASSERT_EQ(result.num_reached, 1);
+  ASSERT_EQ(result.parent[0], result_type::k_unreached);
+  ASSERT_EQ(result.level[3], 0);
+}
+
+TEST(BreadthFirstSearchTest, PersistentGraph) {
+  using persistent_graph_type = metall::container::csr_graph<uint32_t>;
+  constexpr uint32_t k_num_vertices = 1 << 12;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *graph = manager.construct<persistent_graph_type>("graph")(
+        manager.get_allocator());
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> edges(1);
+    for (uint32_t v = 0; v + 1 < k_num_vertices; ++v) {
+      edges[0].emplace_back(v, v + 1);
+      edges[0].emplace_back(v + 1, v);
+    }
+    graph->build(edges, k_num_vertices);
+  }
+
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *graph = manager.find<persistent_graph_type>("graph").first;
+    ASSERT_NE(graph, nullptr);
+    const auto result =
+        util::breadth_first_search(*graph, k_num_vertices, uint32_t(0));
+    ASSERT_EQ(result.num_levels, k_num_vertices);
+    ASSERT_EQ(result.num_reached, k_num_vertices);
+    for (uint32_t v = 0; v < k_num_vertices; ++v) {
+      ASSERT_EQ(result.level[v], v);
+    }
+  }
+}
+}  // namespace
@@ -0,0 +1,97 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/directory_sync.hpp>
+
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+namespace mdtl = metall::mtlldetail;
+
+constexpr std::size_t k_block_size = 1ULL << 20ULL;
+
+void write_file(const fs::path &path, const std::size_t size,
+                const char value) {
+  ASSERT_TRUE(mdtl::create_directory(path.parent_path()));
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  const std::string buf(size, value);
+  ofs.write(buf.data(), buf.size());
+  ASSERT_TRUE(bool(ofs));
+}
+
+void overwrite(const fs::path &path, const std::size_t offset,
+               const std::size_t size, const char value) {
+  std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(offset);
+  const std::string buf(size, value);
+  file.write(buf.data(), buf.size());
+  ASSERT_TRUE(bool(file));
+}
+
+std::string read_file(const fs::path &path) {
+  std::ifstream ifs(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(ifs),
+                     std::istreambuf_iterator<char>());
+}
+
+void check_same(const fs::path &a, const fs::path &b) {
+  mdtl::block_checksum_table ta, tb;
+  ASSERT_TRUE(mdtl::compute_block_checksums(a, 0, &ta));
+  ASSERT_TRUE(mdtl::compute_block_checksums(b, 0, &tb));
+  ASSERT_EQ(ta, tb);
+  for (const auto &entry : ta) {
+    ASSERT_EQ(read_file(a / entry.first), read_file(b / entry.first));
+  }
+}
+
+TEST(DirectorySyncTest, SyncChangedBlocks) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto src = test_utility::make_test_path("src");
+  const auto dst = test_utility::make_test_path("dst");
+  ASSERT_TRUE(mdtl::remove_file(src));
+  ASSERT_TRUE(mdtl::remove_file(dst));
+
+  write_file(src / "a", k_block_size * 3 + 10, 'a');
+  write_file(src / "sub" / "b", 100, 'b');
+  write_file(src / "c", 10, 'c');
+
+  // Initial sync to an empty directory
+  mdtl::block_checksum_table table;
+  ASSERT_TRUE(mdtl::create_directory(dst));
+  ASSERT_TRUE(mdtl::sync_changed_blocks(src, dst, table, 0, &table));
+  check_same(src, dst);
+
+  // Modify, grow, shrink, add and remove files
+  overwrite(src / "a", k_block_size + 5, 10, 'x');
+  write_file(src / "c", k_block_size + 1, 'z');
+  write_file(src / "sub" / "b", 50, 'y');
+  write_file(src / "new" / "d", 0, 0);
+  ASSERT_TRUE(mdtl::remove_file(src / "c"));
+  write_file(src / "e", 20, 'e');
+
+  ASSERT_TRUE(mdtl::sync_changed_blocks(src, dst, table, 0, &table));
+  check_same(src, dst);
+  ASSERT_FALSE(mdtl::file_exist(dst / "c"));
+  ASSERT_TRUE(mdtl::file_exist(dst / "new" / "d"));
+
+  // Only the changed blocks are written
+  overwrite(dst / "a", 0, 1, 'q');  // Not tracked by the table
+  overwrite(src / "a", k_block_size * 2, 1, 'w');
+  ASSERT_TRUE(mdtl::sync_changed_blocks(src, dst, table, 0, &table));
+  ASSERT_EQ(read_file(dst / "a")[0], 'q');
+  ASSERT_EQ(read_file(dst / "a")[k_block_size * 2], 'w');
+}
+
+}  // namespace
@@ -0,0 +1,96 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/utility/external_sort.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace util = metall::utility;
+
+std::vector<uint64_t> random_values(const std::size_t n) {
+  std::mt19937_64 rng(123);
+  std::vector<uint64_t> values(n);
+  for (auto &v : values) v = rng() % 100000;
+  return values;
+}
+
+util::external_sort_options small_options() {
+  util::external_sort_options options;
+  options.scratch_path = test_utility::make_test_path("scratch");
+  // 64 KB runs and 8 runs merged at once; thus, merged in two passes
+  options.memory_bytes = 64 * 1024;
+  options.block_bytes = 4096;
+  return options;
+}
+
+TEST(ExternalSortTest, Sort) {
+  for (const std::size_t n : {std::size_t(0), std::size_t(10),
+                              std::size_t(1000), std::size_t(200000)}) {
+    const auto values = random_values(n);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    std::vector<uint64_t> sorted{1, 2, 3};
+    const auto options = small_options();
+    ASSERT_TRUE(util::external_sort(values, &sorted, options));
+    ASSERT_EQ(sorted, expected);
+    ASSERT_FALSE(metall::manager::consistent(options.scratch_path));
+  }
+}
+
+TEST(ExternalSortTest, Compare) {
+  std::vector<std::pair<uint32_t, uint32_t>> edges;
+  for (const auto v : random_values(100000)) edges.emplace_back(v % 100, v);
+  auto expected = edges;
+  std::sort(expected.begin(), expected.end(), std::greater<>());
+  std::vector<std::pair<uint32_t, uint32_t>> sorted;
+  ASSERT_TRUE(util::external_sort(edges, &sorted, small_options(),
+                                  std::greater<>()));
+  ASSERT_EQ(sorted, expected);
+}
+
+TEST(ExternalSortTest, Datastore) {
+  using vector_type =
+      metall::container::vector<uint64_t,
+                                metall::manager::allocator_type<uint64_t>>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  const auto values = random_values(300000);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *const vector =
+        manager.construct<vector_type>("vector")(manager.get_allocator());
+    vector->assign(values.begin(), values.end());
+    // Sorts in place
+    ASSERT_TRUE(util::external_sort(*vector, vector, small_options()));
+  }
+  {
+    metall::manager manager(metall::open_read_only, dir_path);
+    const auto *const vector = manager.find<vector_type>("vector").first;
+    ASSERT_NE(vector, nullptr);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(vector->size(), expected.size());
+    ASSERT_TRUE(std::equal(vector->begin(), vector->end(), expected.begin()));
+  }
+  ASSERT_TRUE(metall::manager::remove(dir_path));
+}
+
+TEST(ExternalSortTest, NoScratchPath) {
+  std::vector<uint64_t> values{3, 1, 2};
+  std::vector<uint64_t> sorted;
+  ASSERT_FALSE(util::external_sort(values, &sorted,
+                                   util::external_sort_options()));
+}
+}  // namespace
@@ -0,0 +1,75 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <metall/detail/mmap.hpp>
+#include <metall/utility/fault_aware_scheduler.hpp>
+
+namespace {
+
+namespace mdtl = metall::mtlldetail;
+using metall::utility::fault_aware_scheduler;
+
+TEST(FaultAwareSchedulerTest, ResidentPages) {
+  fault_aware_scheduler scheduler(4);
+  scheduler.run();
+
+  // Each task walks a linked list in memory that is resident
+  constexpr std::size_t k_num_tasks = 100;
+  constexpr int k_num_steps = 10;
+  std::vector<int> data(k_num_steps, 0);
+  std::vector<int> sums(k_num_tasks, 0);
+  for (std::size_t t = 0; t < k_num_tasks; ++t) {
+    scheduler.submit([&, t, i = 0]() mutable -> const void * {
+      if (i == k_num_steps) return nullptr;
+      sums[t] += data[i] + 1;
+      return &data[i++];
+    });
+  }
+  scheduler.run();
+  for (const auto s : sums) ASSERT_EQ(s, k_num_steps);
+  ASSERT_EQ(scheduler.num_deferred_steps(), 0);
+}
+
+TEST(FaultAwareSchedulerTest, NonResidentPages) {
+  // The pages of a new anonymous map are not resident until touched
+  const auto page_size = mdtl::get_page_size();
+  constexpr std::size_t k_num_pages = 16;
+  auto *const map = static_cast<char *>(
+      mdtl::map_anonymous_write_mode(nullptr, page_size * k_num_pages));
+  ASSERT_NE(map, nullptr);
+
+  fault_aware_scheduler scheduler(4);
+  std::vector<int> num_steps(k_num_pages, 0);
+  for (std::size_t t = 0; t < k_num_pages; ++t) {
+    scheduler.submit([&, t]() mutable -> const void * {
+      // Touches the page the previous step returned
+      if (num_steps[t]++ == 1) {
+        map[t * page_size] = 1;
+        return nullptr;
+      }
+      return map + t * page_size;
+    });
+  }
+  // A task submitted by a task also runs
+  scheduler.submit([&]() -> const void * {
+    scheduler.submit([]() -> const void * { return nullptr; });
+    return nullptr;
+  });
+  scheduler.run();
+
+  for (const auto n : num_steps) ASSERT_EQ(n, 2);
+  for (std::size_t t = 0; t < k_num_pages; ++t) {
+    ASSERT_EQ(map[t * page_size], 1);
+  }
+  ASSERT_GT(scheduler.num_deferred_steps(), 0);
+  mdtl::os_munmap(map, page_size * k_num_pages);
+}
+
+}  // namespace
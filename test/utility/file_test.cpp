@@ -0,0 +1,103 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/file_clone.hpp>
+
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace mdtl = metall::mtlldetail;
+
+// Larger than twice the piece size so that the file is copied in parallel
+constexpr std::size_t k_file_size = 1ULL << 28ULL;
+constexpr std::size_t k_data_size = 1ULL << 27ULL;
+
+void create_source_file(const std::filesystem::path &path) {
+  ASSERT_TRUE(mdtl::create_file(path));
+  ASSERT_TRUE(mdtl::extend_file_size(path, k_file_size, false));
+  std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+  std::vector<uint64_t> buf(k_data_size / sizeof(uint64_t));
+  for (std::size_t i = 0; i < buf.size(); ++i) buf[i] = i;
+  // Data, a hole, and data
+  file.write(reinterpret_cast<const char *>(buf.data()), k_data_size);
+  file.seekp(k_file_size - 4096);
+  file.write(reinterpret_cast<const char *>(buf.data()), 4096);
+  ASSERT_TRUE(bool(file));
+}
+
+void check_copy(const std::filesystem::path &path) {
+  ASSERT_EQ(mdtl::get_file_size(path), ssize_t(k_file_size));
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint64_t> buf(k_file_size / sizeof(uint64_t));
+  ASSERT_TRUE(bool(
+      file.read(reinterpret_cast<char *>(buf.data()), k_file_size)));
+  const std::size_t data_words = k_data_size / sizeof(uint64_t);
+  const std::size_t tail_begin = (k_file_size - 4096) / sizeof(uint64_t);
+  for (std::size_t i = 0; i < buf.size(); ++i) {
+    if (i < data_words) {
+      ASSERT_EQ(buf[i], i);
+    } else if (i >= tail_begin) {
+      ASSERT_EQ(buf[i], i - tail_begin);
+    } else {
+      ASSERT_EQ(buf[i], 0);
+    }
+  }
+}
+
+TEST(FileTest, ParallelCopy) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto src = test_utility::make_test_path("src");
+  const auto dst = test_utility::make_test_path("dst");
+  mdtl::remove_file(src);
+  create_source_file(src);
+
+  for (const bool sparse : {true, false}) {
+    for (const int num_threads : {1, 4, 0}) {
+      mdtl::remove_file(dst);
+      ASSERT_TRUE(mdtl::copy_file(src, dst, sparse, num_threads));
+      check_copy(dst);
+    }
+  }
+
+  mdtl::remove_file(dst);
+  ASSERT_TRUE(mdtl::clone_file(src, dst, 4));
+  check_copy(dst);
+
+  mdtl::remove_file(src);
+  mdtl::remove_file(dst);
+}
+
+TEST(FileTest, CloneSupported) {
+  ASSERT_TRUE(test_utility::create_test_dir());
+  const auto src = test_utility::make_test_path("src");
+  const auto dst = test_utility::make_test_path("dst");
+  mdtl::remove_file(src);
+  mdtl::remove_file(dst);
+  ASSERT_TRUE(mdtl::create_directory(src));
+  ASSERT_TRUE(mdtl::create_directory(dst));
+
+  // No file to clone
+  ASSERT_FALSE(mdtl::clone_supported(src, dst));
+
+  ASSERT_TRUE(mdtl::create_directory(src / "sub"));
+  create_source_file(src / "sub" / "file");
+  // Either is fine depending on the file system; the probe is removed
+  mdtl::clone_supported(src, dst);
+  ASSERT_TRUE(std::filesystem::is_empty(dst));
+  check_copy(src / "sub" / "file");
+
+  mdtl::remove_file(src);
+  mdtl::remove_file(dst);
+}
+
+}  // namespace
@@ -0,0 +1,80 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <metall/utility/hash.hpp>
+
+namespace {
+
+namespace util = metall::utility;
+
+TEST(HashTest, WyhashTestVectors) {
+  // The test vectors of wyhash final version 4.2
+  const char *const inputs[] = {
+      "",
+      "a",
+      "abc",
+      "message digest",
+      "abcdefghijklmnopqrstuvwxyz",
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+      "123456789012345678901234567890123456789012345678901234567890123456789"
+      "01234567890"};
+  const uint64_t expected[] = {0x93228a4de0eec5a2, 0xc5bac3db178713c4,
+                               0xa97f2f7b1d9b3314, 0x786d1f1df3801df4,
+                               0xdca5a8138ad37c87, 0xb9e734f117cfaf70,
+                               0x6cc5eab49a92d617};
+  for (uint64_t i = 0; i < 7; ++i) {
+    ASSERT_EQ(metall::mtlldetail::wyhash_64(inputs[i],
+                                            std::strlen(inputs[i]), i),
+              expected[i]);
+  }
+}
+
+TEST(HashTest, WyStrHash) {
+  const std::string str("metall");
+  const util::wy_str_hash<> hasher;
+  ASSERT_EQ(hasher(str), hasher(str.c_str()));
+  ASSERT_EQ(hasher(str), hasher(std::string_view(str)));
+  ASSERT_NE(hasher(str), hasher(std::string("metal")));
+  ASSERT_NE(hasher(str), util::wy_str_hash<1>()(str));
+}
+
+template <typename hasher_type, typename key_type>
+void check_batch(const hasher_type &hasher, const std::vector<key_type> &keys) {
+  std::vector<std::size_t> hashes(keys.size());
+  util::hash_batch(hasher, keys.data(), keys.size(), hashes.data());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(hashes[i], hasher(keys[i]));
+  }
+}
+
+TEST(HashTest, Batch) {
+  std::vector<uint64_t> ints;
+  std::vector<std::string> strs;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    ints.push_back(i);
+    strs.push_back(std::to_string(i));
+  }
+  check_batch(util::hash<>(), ints);
+  check_batch(util::wy_hash<>(), ints);
+  check_batch(util::str_hash<>(), strs);
+  check_batch(util::wy_str_hash<>(), strs);
+
+  // Iterators
+  std::vector<std::size_t> hashes;
+  util::hash_batch(util::str_hash<>(), strs.begin(), strs.size(),
+                   std::back_inserter(hashes));
+  ASSERT_EQ(hashes.size(), strs.size());
+  ASSERT_EQ(hashes.back(), util::str_hash<>()(strs.back()));
+}
+
+}  // namespace
@@ -0,0 +1,89 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <metall/detail/io_executor.hpp>
+
+namespace {
+
+using metall::mtlldetail::io_executor;
+
+TEST(IOExecutorTest, ParallelFor) {
+  auto &executor = io_executor::instance();
+  for (const int max_parallelism : {0, 1, 4}) {
+    std::vector<int> done(1000, 0);
+    ASSERT_TRUE(executor.parallel_for(done.size(), max_parallelism,
+                                      [&done](const std::size_t i) {
+                                        ++done[i];
+                                        return true;
+                                      }));
+    for (const auto d : done) ASSERT_EQ(d, 1);
+  }
+
+  ASSERT_TRUE(
+      executor.parallel_for(0, 0, [](const std::size_t) { return false; }));
+}
+
+TEST(IOExecutorTest, Failure) {
+  auto &executor = io_executor::instance();
+  std::atomic_int num_runs = 0;
+  ASSERT_FALSE(executor.parallel_for(100, 0, [&num_runs](const std::size_t i) {
+    ++num_runs;
+    return i != 10;
+  }));
+  // The other tasks still run
+  ASSERT_EQ(num_runs.load(), 100);
+}
+
+TEST(IOExecutorTest, QueueDepth) {
+  auto &executor = io_executor::instance();
+  const auto num_threads = executor.num_threads();
+  const auto queue_depth = executor.queue_depth();
+  executor.configure(8, 2);
+  ASSERT_EQ(executor.num_threads(), 8);
+  ASSERT_EQ(executor.queue_depth(), 2);
+
+  std::atomic_int num_running = 0;
+  std::atomic_int max_num_running = 0;
+  const auto task = [&](const std::size_t) {
+    const int n = ++num_running;
+    int max = max_num_running.load();
+    while (max < n && !max_num_running.compare_exchange_weak(max, n)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    --num_running;
+    return true;
+  };
+  ASSERT_TRUE(executor.parallel_for(64, 8, task, 0));
+  ASSERT_LE(max_num_running.load(), 2);
+
+  // Tasks without a device are not bounded by the queue depth
+  ASSERT_TRUE(executor.parallel_for(64, 8, task));
+
+  executor.configure(num_threads, queue_depth);
+}
+
+TEST(IOExecutorTest, Submit) {
+  auto &executor = io_executor::instance();
+  std::atomic_int sum = 0;
+  auto future = executor.submit([&executor, &sum]() {
+    // Can run parallel tasks in a task
+    executor.parallel_for(100, 0, [&sum](const std::size_t i) {
+      sum += static_cast<int>(i);
+      return true;
+    });
+  });
+  future.get();
+  ASSERT_EQ(sum.load(), 4950);
+}
+
+}  // namespace
@@ -0,0 +1,68 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <ostream>
+
+// Removes the debug and verbose messages at compile time
+#define METALL_LOG_MIN_LEVEL metall_info
+#include <metall/logger.hpp>
+
+namespace {
+
+using metall::logger;
+
+// Counts how many times a message is formatted
+struct counted_message {
+  int *count;
+};
+
+std::ostream &operator<<(std::ostream &os, const counted_message &msg) {
+  ++*msg.count;
+  return os << "message";
+}
+
+TEST(LoggerTest, Compiled) {
+  static_assert(logger::compiled(logger::level::critical));
+  static_assert(logger::compiled(logger::level::error));
+  static_assert(logger::compiled(logger::level::info));
+  static_assert(!logger::compiled(logger::level::debug));
+  static_assert(!logger::compiled(logger::level::verbose));
+}
+
+TEST(LoggerTest, LazyFormatting) {
+  int count = 0;
+
+  logger::set_log_level(logger::level_filter::verbose);
+  METALL_LOG(logger::level::verbose, counted_message{&count});
+  ASSERT_EQ(count, 0);  // Not compiled in
+  METALL_LOG(logger::level::info, counted_message{&count});
+  ASSERT_EQ(count, 1);
+
+  logger::set_log_level(logger::level_filter::error);
+  ASSERT_FALSE(logger::should_log(logger::level::warning));
+  ASSERT_TRUE(logger::should_log(logger::level::error));
+  METALL_LOG(logger::level::warning, counted_message{&count});
+  ASSERT_EQ(count, 1);  // Filtered out before formatting
+
+  logger::set_log_level(logger::level_filter::silent);
+  METALL_LOG(logger::level::error, counted_message{&count});
+  ASSERT_EQ(count, 1);
+
+  logger::set_log_level(logger::level_filter::error);
+}
+
+TEST(LoggerTest, StatementMacro) {
+  int count = 0;
+  // Usable as a single statement
+  if (count == 0)
+    METALL_LOG(logger::level::error, "count is " << count);
+  else
+    METALL_LOG(logger::level::error, counted_message{&count});
+  ASSERT_EQ(count, 0);
+}
+
+}  // namespace
@@ -0,0 +1,77 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <metall/utility/mutex.hpp>
+
+namespace {
+
+namespace mutex = metall::utility::mutex;
+
+TEST(MutexTest, SpinMutex) {
+  mutex::spin_mutex mtx;
+  ASSERT_TRUE(mtx.try_lock());
+  ASSERT_FALSE(mtx.try_lock());
+  mtx.unlock();
+
+  // Long critical sections make the waiters sleep
+  constexpr int k_num_threads = 8;
+  constexpr int k_num_iterations = 10000;
+  int counter = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_num_threads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < k_num_iterations; ++i) {
+        std::lock_guard<mutex::spin_mutex> guard(mtx);
+        ++counter;
+        if (i % 1000 == 0) std::this_thread::yield();
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  ASSERT_EQ(counter, k_num_threads * k_num_iterations);
+}
+
+TEST(MutexTest, PaddedBanks) {
+  auto lock0 = mutex::mutex_lock<4>(0);
+  auto lock1 = mutex::mutex_lock<4>(1);
+  const auto addr0 = reinterpret_cast<std::uintptr_t>(lock0.mutex());
+  const auto addr1 = reinterpret_cast<std::uintptr_t>(lock1.mutex());
+  ASSERT_EQ(addr0 % mutex::k_cache_line_size, 0);
+  ASSERT_GE(addr1 - addr0, mutex::k_cache_line_size);
+
+  // The same bank for the same template arguments
+  lock0.unlock();
+  lock1.unlock();
+  ASSERT_EQ(mutex::mutex_lock<4>(0).mutex(), lock0.mutex());
+  ASSERT_NE((mutex::mutex_lock<4, mutex::spin_mutex>(0).mutex()), nullptr);
+}
+
+TEST(MutexTest, SharedMutexLock) {
+  static_assert(mutex::is_shared_lockable_v<std::shared_mutex>);
+  static_assert(!mutex::is_shared_lockable_v<mutex::spin_mutex>);
+
+  // Shared locks do not exclude each other
+  auto shared0 = mutex::shared_mutex_lock<2>(0);
+  std::thread([]() {
+    auto shared1 = mutex::shared_mutex_lock<2>(0);
+    ASSERT_TRUE(shared1.owns_lock());
+  }).join();
+
+  // but exclude the exclusive lock of the same bank
+  auto *const mtx = shared0.mutex();
+  std::thread([mtx]() { ASSERT_FALSE(mtx->try_lock()); }).join();
+  shared0.unlock();
+  ASSERT_EQ((mutex::mutex_lock<2, std::shared_mutex>(0).mutex()), mtx);
+}
+
+}  // namespace
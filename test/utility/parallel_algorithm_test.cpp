@@ -0,0 +1,135 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/utility/parallel_algorithm.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace util = metall::utility;
+
+// Larger than the size processed sequentially
+constexpr std::size_t k_size = 1 << 20;
+
+std::vector<uint64_t> random_values(const std::size_t n, const uint64_t max) {
+  std::mt19937_64 rng(123);
+  std::vector<uint64_t> values(n);
+  for (auto &v : values) v = rng() % max;
+  return values;
+}
+
+TEST(ParallelAlgorithmTest, Sort) {
+  for (const std::size_t n : {std::size_t(0), std::size_t(100), k_size,
+                              k_size + 12345}) {
+    auto values = random_values(n, 1000);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    util::parallel_sort(values.begin(), values.end());
+    ASSERT_EQ(values, expected);
+
+    util::parallel_sort(values.begin(), values.end(), std::greater<>());
+    std::reverse(expected.begin(), expected.end());
+    ASSERT_EQ(values, expected);
+  }
+}
+
+TEST(ParallelAlgorithmTest, StableSort) {
+  // Sorted by the keys only; the values keep the original order
+  std::vector<std::pair<uint64_t, uint64_t>> items;
+  const auto keys = random_values(k_size, 100);
+  for (std::size_t i = 0; i < keys.size(); ++i) items.emplace_back(keys[i], i);
+  auto expected = items;
+  const auto by_key = [](const auto &a, const auto &b) {
+    return a.first < b.first;
+  };
+  std::stable_sort(expected.begin(), expected.end(), by_key);
+  util::parallel_stable_sort(items.begin(), items.end(), by_key);
+  ASSERT_EQ(items, expected);
+}
+
+TEST(ParallelAlgorithmTest, SortNonTrivialType) {
+  std::vector<std::string> values;
+  for (const auto v : random_values(k_size / 8, 100000)) {
+    values.push_back(std::to_string(v));
+  }
+  auto expected = values;
+  std::sort(expected.begin(), expected.end());
+  util::parallel_sort(values.begin(), values.end());
+  ASSERT_EQ(values, expected);
+}
+
+TEST(ParallelAlgorithmTest, OutOfCoreSort) {
+  using vector_type =
+      metall::container::vector<uint64_t,
+                                metall::manager::allocator_type<uint64_t>>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  {
+    metall::manager manager(metall::create_only, dir_path);
+    auto *const vector =
+        manager.construct<vector_type>("vector")(manager.get_allocator());
+    const auto values = random_values(k_size, 1ULL << 40ULL);
+    vector->assign(values.begin(), values.end());
+
+    // Many small runs merged through a buffer in the datastore
+    util::parallel_sort(vector->begin(), vector->end(), std::less<>(),
+                        manager.get_allocator(), 64 * 1024, true);
+    ASSERT_TRUE(std::is_sorted(vector->begin(), vector->end()));
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    ASSERT_TRUE(std::equal(vector->begin(), vector->end(), expected.begin()));
+
+    ASSERT_TRUE(manager.destroy<vector_type>("vector"));
+    ASSERT_TRUE(manager.all_memory_deallocated());
+  }
+}
+
+TEST(ParallelAlgorithmTest, Reduce) {
+  const auto values = random_values(k_size, 1000);
+  ASSERT_EQ(util::parallel_reduce(values.begin(), values.end(), uint64_t(5)),
+            std::accumulate(values.begin(), values.end(), uint64_t(5)));
+  ASSERT_EQ(util::parallel_reduce(values.begin(), values.end(), uint64_t(0),
+                                  [](const uint64_t a, const uint64_t b) {
+                                    return std::max(a, b);
+                                  }),
+            *std::max_element(values.begin(), values.end()));
+}
+
+TEST(ParallelAlgorithmTest, Scan) {
+  for (const std::size_t n : {std::size_t(10), k_size + 7}) {
+    const auto values = random_values(n, 1000);
+    std::vector<uint64_t> expected(n);
+    std::vector<uint64_t> result(n);
+
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    util::parallel_inclusive_scan(values.begin(), values.end(),
+                                  result.begin());
+    ASSERT_EQ(result, expected);
+
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(),
+                        uint64_t(3));
+    util::parallel_exclusive_scan(values.begin(), values.end(),
+                                  result.begin(), uint64_t(3));
+    ASSERT_EQ(result, expected);
+
+    // In place, e.g., the offsets of CSR
+    auto offsets = values;
+    util::parallel_exclusive_scan(offsets.begin(), offsets.end(),
+                                  offsets.begin(), uint64_t(3));
+    ASSERT_EQ(offsets, expected);
+  }
+}
+}  // namespace
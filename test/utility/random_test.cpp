@@ -0,0 +1,94 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <metall/utility/random.hpp>
+#include <metall/utility/open_mp.hpp>
+
+namespace {
+
+namespace util = metall::utility;
+
+template <typename rand_type>
+void check_fill() {
+  rand_type rnd0(123);
+  rand_type rnd1(123);
+
+  // Odd sizes to start and end in the middle of the lanes
+  for (const std::size_t n : {0, 1, 3, 13, 64, 1001}) {
+    std::vector<uint64_t> buf(n);
+    rnd0.fill(buf.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(buf[i], rnd1());
+    }
+    ASSERT_EQ(rnd0, rnd1);
+  }
+}
+
+TEST(RandomTest, Fill) {
+  check_fill<util::rand_512>();
+  check_fill<util::rand_1024>();
+  check_fill<util::rand_512x4>();
+  check_fill<util::rand_512x8>();
+}
+
+TEST(RandomTest, Lanes) {
+  // Lane l generates the values of rand_512 jumped l times
+  util::rand_512x8 lanes(123);
+  std::vector<uint64_t> buf(8 * 10);
+  lanes.fill(buf.data(), buf.size());
+
+  util::rand_512 lane(123);
+  for (std::size_t l = 0; l < 8; ++l) {
+    util::rand_512 rnd(lane);
+    for (std::size_t i = 0; i < 10; ++i) {
+      ASSERT_EQ(buf[i * 8 + l], rnd());
+    }
+    lane.jump();
+  }
+}
+
+TEST(RandomTest, Jump) {
+  util::rand_512x8 rnd0(123);
+  util::rand_512x8 rnd1(123);
+  rnd1.jump();
+  ASSERT_NE(rnd0, rnd1);
+
+  // The first lane after the jump is the 9th jump of rand_512
+  util::rand_512 rnd2(123);
+  for (int i = 0; i < 8; ++i) rnd2.jump();
+  ASSERT_EQ(rnd1(), rnd2());
+}
+
+TEST(RandomTest, FillParallel) {
+  const std::size_t n = util::k_fill_parallel_block_size * 3 + 5;
+  const util::rand_512x8 rnd(123);
+
+  std::vector<uint64_t> expected(n);
+  {
+    util::rand_512x8 block_engine(rnd);
+    for (std::size_t offset = 0; offset < n;
+         offset += util::k_fill_parallel_block_size) {
+      util::rand_512x8 stream(block_engine);
+      stream.fill(expected.data() + offset,
+                  std::min(util::k_fill_parallel_block_size, n - offset));
+      block_engine.jump();
+    }
+  }
+
+  // Does not depend on the number of threads
+  for (const int num_threads : {1, 2, 4}) {
+    util::omp::set_num_threads(num_threads);
+    std::vector<uint64_t> buf(n);
+    util::fill_parallel(rnd, buf.data(), n);
+    ASSERT_EQ(buf, expected);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,152 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <metall/utility/sharded_manager.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+using sharded_manager_type = metall::utility::sharded_manager<>;
+using path_type = sharded_manager_type::path_type;
+
+std::vector<path_type> shard_paths(const std::string &name,
+                                   const std::size_t num_shards) {
+  std::vector<path_type> paths;
+  for (std::size_t i = 0; i < num_shards; ++i) {
+    paths.push_back(
+        test_utility::make_test_path(name + "_shard" + std::to_string(i)));
+  }
+  return paths;
+}
+
+TEST(ShardedManagerTest, AllocateAndName) {
+  const auto paths = shard_paths("sharded", 3);
+  sharded_manager_type::remove(paths);
+
+  {
+    sharded_manager_type manager(metall::create_only, paths);
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_EQ(manager.num_shards(), std::size_t(3));
+
+    // Each shard serves its own allocations
+    for (std::size_t i = 0; i < manager.num_shards(); ++i) {
+      void *const addr = manager.allocate(i, 128);
+      ASSERT_NE(addr, nullptr);
+      ASSERT_EQ(manager.shard_of_address(addr), i);
+      manager.deallocate(addr);
+    }
+    void *const addr = manager.allocate(64);
+    ASSERT_EQ(manager.shard_of_address(addr), manager.thread_shard_no());
+    manager.deallocate(addr);
+    int local = 0;
+    ASSERT_EQ(manager.shard_of_address(&local), manager.num_shards());
+
+    // Named objects are spread over the shards by name
+    std::vector<std::size_t> num_objects(manager.num_shards(), 0);
+    for (int i = 0; i < 30; ++i) {
+      const auto name = "obj" + std::to_string(i);
+      ASSERT_NE(manager.construct<int>(name.c_str())(i), nullptr);
+      ++num_objects[manager.shard_of_name(name.c_str())];
+    }
+    for (std::size_t i = 0; i < manager.num_shards(); ++i) {
+      ASSERT_GT(num_objects[i], std::size_t(0));
+      ASSERT_EQ(manager.shard(i).get_num_named_objects(), num_objects[i]);
+    }
+    ASSERT_EQ(manager.get_num_named_objects(), std::size_t(30));
+    ASSERT_TRUE(manager.flush());
+  }
+  ASSERT_TRUE(sharded_manager_type::consistent(paths));
+
+  {
+    sharded_manager_type manager(metall::open_read_only, paths);
+    ASSERT_TRUE(manager.check_sanity());
+    for (int i = 0; i < 30; ++i) {
+      const auto name = "obj" + std::to_string(i);
+      const auto *const obj = manager.find<int>(name.c_str()).first;
+      ASSERT_NE(obj, nullptr);
+      ASSERT_EQ(*obj, i);
+    }
+  }
+
+  {
+    sharded_manager_type manager(metall::open_only, paths);
+    ASSERT_TRUE(manager.destroy<int>("obj0"));
+    ASSERT_EQ(manager.find<int>("obj0").first, nullptr);
+  }
+  ASSERT_TRUE(sharded_manager_type::remove(paths));
+}
+
+TEST(ShardedManagerTest, Threads) {
+  const auto paths = shard_paths("sharded_threads", 2);
+  sharded_manager_type::remove(paths);
+  sharded_manager_type manager(metall::create_only, paths);
+
+  std::vector<std::size_t> thread_shards(4);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < thread_shards.size(); ++t) {
+    threads.emplace_back([&manager, &thread_shards, t]() {
+      thread_shards[t] = manager.thread_shard_no();
+      std::vector<void *> addrs;
+      for (int i = 0; i < 1000; ++i) addrs.push_back(manager.allocate(32));
+      for (auto *const addr : addrs) {
+        if (manager.shard_of_address(addr) != thread_shards[t]) {
+          thread_shards[t] = manager.num_shards();
+        }
+        manager.deallocate(addr);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+
+  // The threads are assigned round-robin
+  std::vector<std::size_t> num_threads(manager.num_shards(), 0);
+  for (const auto s : thread_shards) {
+    ASSERT_LT(s, manager.num_shards());
+    ++num_threads[s];
+  }
+  ASSERT_EQ(num_threads[0], num_threads[1]);
+}
+
+TEST(ShardedManagerTest, Snapshot) {
+  const auto paths = shard_paths("sharded_src", 2);
+  const auto snapshot_paths = shard_paths("sharded_snapshot", 2);
+  sharded_manager_type::remove(paths);
+  sharded_manager_type::remove(snapshot_paths);
+
+  {
+    sharded_manager_type manager(metall::create_only, paths);
+    ASSERT_NE(manager.construct<int>("a")(1), nullptr);
+    ASSERT_NE(manager.construct<int>("b")(2), nullptr);
+    ASSERT_FALSE(manager.snapshot({snapshot_paths[0]}));
+    ASSERT_TRUE(manager.snapshot(snapshot_paths));
+  }
+
+  {
+    sharded_manager_type manager(metall::open_read_only, snapshot_paths);
+    ASSERT_TRUE(manager.check_sanity());
+    ASSERT_EQ(*manager.find<int>("a").first, 1);
+    ASSERT_EQ(*manager.find<int>("b").first, 2);
+  }
+
+  // The shards must be given in the same order
+  {
+    sharded_manager_type manager(metall::open_read_only,
+                                 {paths[1], paths[0]});
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  {
+    sharded_manager_type manager(metall::open_read_only, {paths[0]});
+    ASSERT_FALSE(manager.check_sanity());
+  }
+  sharded_manager_type::remove(paths);
+  sharded_manager_type::remove(snapshot_paths);
+}
+}  // namespace
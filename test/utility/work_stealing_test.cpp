@@ -0,0 +1,76 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <metall/metall.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/detail/memory.hpp>
+#include <metall/utility/work_stealing.hpp>
+#include "../test_utility.hpp"
+
+namespace {
+
+namespace util = metall::utility;
+
+TEST(WorkStealingTest, EveryIndexOnce) {
+  for (const std::size_t n : {std::size_t(0), std::size_t(1),
+                              std::size_t(1000), std::size_t(1) << 20}) {
+    std::vector<std::atomic<uint32_t>> counts(n);
+    util::work_stealing_for(n, [&](const std::size_t begin,
+                                   const std::size_t end) {
+      ASSERT_LT(begin, end);
+      for (auto i = begin; i < end; ++i) ++counts[i];
+    });
+    for (const auto &count : counts) ASSERT_EQ(count.load(), 1);
+  }
+}
+
+TEST(WorkStealingTest, SkewedCost) {
+  // The items at the front cost much more, as in a graph with hubs
+  constexpr std::size_t k_size = 1 << 16;
+  std::vector<uint64_t> values(k_size);
+  util::work_stealing_for(
+      k_size,
+      [&](const std::size_t begin, const std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+          const uint64_t cost = (i < 64) ? 100000 : 1;
+          uint64_t sum = 0;
+          for (uint64_t j = 0; j < cost; ++j) sum += j ^ i;
+          values[i] = sum;
+        }
+      },
+      1);
+  for (std::size_t i = 64; i < k_size; ++i) ASSERT_EQ(values[i], i);
+}
+
+TEST(WorkStealingTest, PersistentVector) {
+  using vector_type =
+      metall::container::vector<uint64_t,
+                                metall::manager::allocator_type<uint64_t>>;
+  const auto dir_path(test_utility::make_test_path());
+  metall::manager::remove(dir_path);
+  metall::manager manager(metall::create_only, dir_path);
+  auto *vec = manager.construct<vector_type>("vec")(1 << 20, 1,
+                                                    manager.get_allocator());
+
+  const std::size_t page_size = metall::mtlldetail::get_page_size();
+  std::atomic<uint64_t> sum{0};
+  util::work_stealing_for_each(
+      vec->begin(), vec->end(), [&](const auto first, const auto last) {
+        // Blocks start at page boundaries except the first one
+        if (first != vec->begin()) {
+          ASSERT_EQ(reinterpret_cast<uintptr_t>(&*first) % page_size, 0);
+        }
+        sum += std::accumulate(first, last, uint64_t(0));
+      });
+  ASSERT_EQ(sum.load(), vec->size());
+}
+}  // namespace
@@ -247,6 +247,58 @@ void *map_with_multiple_files_round_robin(const std::string &file_prefix,
   return addr;
 }
 
+void *map_with_geometric_files(const std::string &file_prefix,
+                               const std::size_t size,
+                               const std::size_t first_file_size) {
+  assert(size % first_file_size == 0);
+  const auto start = mdtl::elapsed_time_sec();
+
+  char *addr = reinterpret_cast<char *>(mdtl::reserve_vm_region(size));
+  if (!addr) {
+    std::cerr << "Failed to reserve VM region" << std::endl;
+    std::abort();
+  }
+
+  // The same layout as the segment storage makes with
+  // METALL_USE_GEOMETRIC_BLOCK_GROWTH, i.e., b, b, 2b, 4b, ...
+  std::size_t offset = 0;
+  std::size_t num_files = 0;
+  while (offset < size) {
+    const std::size_t file_size =
+        std::min(std::max(offset, first_file_size), size - offset);
+    const std::string file_name(file_prefix + "_3_" +
+                                std::to_string(num_files));
+    if (!mdtl::create_file(file_name) ||
+        !mdtl::extend_file_size(file_name, file_size)) {
+      std::cerr << __LINE__ << " Failed to initialize file: " << file_name
+                << std::endl;
+      std::abort();
+    }
+
+    const auto ret = mdtl::map_file_write_mode(
+        file_name, reinterpret_cast<void *>(addr + offset), file_size, 0,
+        k_map_nosync | MAP_FIXED);
+    if (ret.first == -1 || !ret.second) {
+      std::cerr << __LINE__ << " Failed mapping" << std::endl;
+      std::abort();
+    }
+    if (!mdtl::os_close(ret.first)) {
+      std::cerr << __LINE__ << " Failed to close file: " << file_name
+                << std::endl;
+      std::abort();
+    }
+    offset += file_size;
+    ++num_files;
+  }
+  std::cout << "size: " << size << "\nfirst_file_size: " << first_file_size
+            << "\nnum_files: " << num_files << std::endl;
+
+  const auto elapsed_time = mdtl::elapsed_time_sec(start);
+  std::cout << __FUNCTION__ << " took\t" << elapsed_time << std::endl;
+
+  return addr;
+}
+
 void unmap(void *const addr, const std::size_t size) {
   const auto start = mdtl::elapsed_time_sec();
 
@@ -270,6 +322,7 @@ void run_bench(T *array, const std::size_t size) {
 
 // ./a.out [mode] [file prefix] [total size] [each_file_size]
 // [round_robin_chunk_size]
+// Mode 3 (geometric) takes the size of the first file as [each_file_size]
 int main([[maybe_unused]] int argc, char *argv[]) {
   const int mode = std::stoul(argv[1]);
 
@@ -281,7 +334,7 @@ int main([[maybe_unused]] int argc, char *argv[]) {
   assert(size % sizeof(uint64_t) == 0);
 
   std::size_t each_file_size{0};
-  if (mode == 1 || mode == 2) {
+  if (mode == 1 || mode == 2 || mode == 3) {
     each_file_size = std::stoll(argv[4]);
     assert(size % each_file_size == 0);
   }
@@ -314,6 +367,12 @@ int main([[maybe_unused]] int argc, char *argv[]) {
         reinterpret_cast<uint64_t *>(map_with_multiple_files_round_robin(
             file_prefix, size, each_file_size, round_robin_chunk_size));
     run_bench(array, size);
+  } else if (mode == 3) {
+    std::cout << "\nGeometrically growing files" << std::endl;
+
+    auto array = reinterpret_cast<uint64_t *>(
+        map_with_geometric_files(file_prefix, size, each_file_size));
+    run_bench(array, size);
   }
 
   return 0;
@@ -0,0 +1,69 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other Metall
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (Apache-2.0 OR MIT)
+
+// Measures the time to copy a directory of sparse files, which mimics making
+// a snapshot of a datastore with many block files.
+// Usage: ./bench_sparse_copy [directory] [#files] [file size (MB)]
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <filesystem>
+
+#include <metall/detail/file.hpp>
+#include <metall/detail/time.hpp>
+
+namespace mdtl = metall::mtlldetail;
+namespace fs = std::filesystem;
+
+int main(int argc, char *argv[]) {
+  const fs::path dir = (argc > 1) ? argv[1] : "/tmp/metall_bench_sparse_copy";
+  const std::size_t num_files = (argc > 2) ? std::stoull(argv[2]) : 1024;
+  const std::size_t file_size =
+      ((argc > 3) ? std::stoull(argv[3]) : 4) * 1024 * 1024;
+
+#ifdef METALL_ENABLE_IO_URING
+  std::cout << "io_uring is enabled" << std::endl;
+#endif
+
+  const fs::path src_dir = dir / "src";
+  const fs::path dst_dir = dir / "dst";
+  fs::remove_all(dir);
+  if (!mdtl::create_directory(src_dir) || !mdtl::create_directory(dst_dir)) {
+    std::cerr << "Failed to create directories" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Write one page every 64 pages so that the files have many holes
+  const std::size_t page_size = 4096;
+  const std::string page(page_size, 'a');
+  for (std::size_t i = 0; i < num_files; ++i) {
+    const auto path = src_dir / ("block-" + std::to_string(i));
+    if (!mdtl::create_file(path) || !mdtl::extend_file_size(path, file_size)) {
+      std::cerr << "Failed to create " << path << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::ofstream ofs(path, std::ios::in | std::ios::out | std::ios::binary);
+    for (std::size_t off = 0; off < file_size; off += page_size * 64) {
+      ofs.seekp(off);
+      ofs.write(page.data(), page_size);
+    }
+  }
+
+  for (const bool sparse : {true, false}) {
+    const auto start = mdtl::elapsed_time_sec();
+    if (!mdtl::copy_files_in_directory_in_parallel(src_dir, dst_dir, 0,
+                                                   sparse)) {
+      std::cerr << "Failed to copy files" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << (sparse ? "Sparse" : "Dense") << " copy of " << num_files
+              << " files took\t" << mdtl::elapsed_time_sec(start) << " s"
+              << std::endl;
+  }
+
+  fs::remove_all(dir);
+  return 0;
+}